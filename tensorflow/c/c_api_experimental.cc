@@ -750,3 +750,120 @@ TF_Library* TF_LoadPluggableDeviceLibrary(const char* library_filename,
 void TF_DeletePluggableDeviceLibraryHandle(TF_Library* lib_handle) {
   delete lib_handle;
 }
+
+void TF_SessionRunWithOutputBuffers(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    TF_Tensor* const* input_values, int ninputs, const TF_Output* outputs,
+    TF_Tensor** output_values, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, TF_Status* status) {
+  using tensorflow::Tensor;
+  status->status = Status::OK();
+  if (session->extend_before_run &&
+      !tensorflow::ExtendSessionGraphHelper(session, status)) {
+    return;
+  }
+  if (run_metadata != nullptr && run_metadata->data != nullptr) {
+    status->status =
+        InvalidArgument("Passing non-empty run_metadata is invalid.");
+    return;
+  }
+
+  tensorflow::CallableOptions callable_options;
+  if (run_options != nullptr &&
+      !callable_options.mutable_run_options()->ParseFromArray(
+          run_options->data, run_options->length)) {
+    status->status = InvalidArgument("Unparseable RunOptions proto");
+    return;
+  }
+  std::vector<Tensor> feeds(ninputs);
+  for (int i = 0; i < ninputs; ++i) {
+    callable_options.add_feed(
+        tensorflow::strings::StrCat(inputs[i].oper->node.name(), ":",
+                                    inputs[i].index));
+    status->status = tensorflow::TF_TensorToTensor(input_values[i], &feeds[i]);
+    if (!status->status.ok()) return;
+  }
+  for (int i = 0; i < noutputs; ++i) {
+    callable_options.add_fetch(tensorflow::strings::StrCat(
+        outputs[i].oper->node.name(), ":", outputs[i].index));
+  }
+  for (int i = 0; i < ntargets; ++i) {
+    callable_options.add_target(target_opers[i]->node.name());
+  }
+  callable_options.set_fetch_into_caller_buffers(true);
+
+  tensorflow::Session::CallableHandle handle;
+  {
+    tensorflow::mutex_lock l(session->mu);
+    const tensorflow::string key = callable_options.SerializeAsString();
+    auto it = session->callables.find(key);
+    if (it == session->callables.end()) {
+      status->status =
+          session->session->MakeCallable(callable_options, &handle);
+      if (!status->status.ok()) return;
+      session->callables.emplace(key, handle);
+    } else {
+      handle = it->second;
+    }
+  }
+
+  // Move the values of the output tensors of the caller into the fetches, so
+  // that the session can tell that nothing else shares their buffers.
+  std::vector<Tensor> fetches(noutputs);
+  for (int i = 0; i < noutputs; ++i) {
+    if (output_values[i] == nullptr) continue;
+    fetches[i] =
+        std::move(tensorflow::TensorFromInterface(output_values[i]->tensor));
+  }
+  tensorflow::RunMetadata run_metadata_proto;
+  Status s = session->session->RunCallable(handle, feeds, &fetches,
+                                           &run_metadata_proto);
+  for (int i = 0; i < noutputs; ++i) {
+    if (output_values[i] != nullptr && fetches[i].IsInitialized()) {
+      tensorflow::TensorFromInterface(output_values[i]->tensor) =
+          std::move(fetches[i]);
+    }
+  }
+  if (!s.ok()) {
+    status->status = s;
+    return;
+  }
+  if (run_metadata != nullptr) {
+    status->status =
+        tensorflow::MessageToBuffer(run_metadata_proto, run_metadata);
+    if (!status->status.ok()) return;
+  }
+  for (int i = 0; i < noutputs; ++i) {
+    if (output_values[i] != nullptr) continue;
+    output_values[i] =
+        tensorflow::TF_TensorFromTensor(fetches[i], &status->status);
+    if (!status->status.ok()) return;
+  }
+}
+
+void TFE_ExecuteWithOutputBuffers(TFE_Op* op, TF_Tensor** output_buffers,
+                                  int num_output_buffers,
+                                  TFE_TensorHandle** retvals, int* num_retvals,
+                                  TF_Status* status) {
+  tensorflow::ImmediateExecutionOperation* unwrapped_op =
+      tensorflow::unwrap(op);
+  if (!tensorflow::EagerOperation::classof(unwrapped_op)) {
+    status->status =
+        InvalidArgument("Output buffers are only supported by eager ops.");
+    return;
+  }
+  tensorflow::EagerOperation* eager_op =
+      tensorflow::OperationFromInterface(unwrapped_op);
+  std::vector<tensorflow::Tensor> buffers(num_output_buffers);
+  for (int i = 0; i < num_output_buffers; ++i) {
+    if (output_buffers[i] == nullptr) continue;
+    status->status =
+        tensorflow::TF_TensorToTensor(output_buffers[i], &buffers[i]);
+    if (!status->status.ok()) return;
+  }
+  eager_op->SetOutputBuffers(std::move(buffers));
+  TFE_Execute(op, retvals, num_retvals, status);
+  // Executing the op clears them, unless it failed early.
+  eager_op->SetOutputBuffers({});
+}
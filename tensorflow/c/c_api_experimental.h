@@ -304,6 +304,32 @@ TF_CAPI_EXPORT extern void
 TF_ImportGraphDefOptionsSetValidateColocationConstraints(
     TF_ImportGraphDefOptions* opts, unsigned char enable);
 
+// Like TF_SessionRun, but each non-null `output_values[i]` is a tensor owned
+// by the caller whose buffer the session may write the fetched value into,
+// saving an allocation and a copy per run. This succeeds when the tensor has
+// the type and shape of the fetched value and no other tensor shares its
+// buffer; otherwise the fetched value replaces the value of
+// `output_values[i]`, which remains owned by the caller either way. The null
+// entries of `output_values` are set to new tensors, as in TF_SessionRun.
+//
+// The feeds, fetches, targets and run options of a call are compiled once per
+// session and reused by later calls with the same ones.
+TF_CAPI_EXPORT extern void TF_SessionRunWithOutputBuffers(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    TF_Tensor* const* input_values, int ninputs, const TF_Output* outputs,
+    TF_Tensor** output_values, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, TF_Status* status);
+
+// Like TFE_Execute, but the kernel of `op` writes each output whose type and
+// shape match the non-null `output_buffers[i]` into the buffer of that
+// tensor, which `retvals[i]` then shares. The buffers are only used by
+// primitive ops run synchronously on a CPU device; other ops, and outputs that
+// don't match their buffers, get newly allocated outputs.
+TF_CAPI_EXPORT extern void TFE_ExecuteWithOutputBuffers(
+    TFE_Op* op, TF_Tensor** output_buffers, int num_output_buffers,
+    TFE_TensorHandle** retvals, int* num_retvals, TF_Status* status);
+
 // Load the library specified by library_filename and register the pluggable
 // device and related kernels present in that library. This function is not
 // supported on embedded on mobile and embedded platforms and will fail if
@@ -235,6 +235,89 @@ TEST_F(ShapeInferenceTest, InfersShapesFromInputTensors) {
   TF_DeleteTensor(tensor_1X6);
 }
 
+TEST(CAPI_EXPERIMENTAL, SessionRunWithOutputBuffers) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+  TF_Operation* feed = Placeholder(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* two = ScalarConst(2, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* add = Add(feed, two, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_SessionOptions* opts = TF_NewSessionOptions();
+  TF_Session* session = TF_NewSession(graph, opts, s);
+  TF_DeleteSessionOptions(opts);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  const TF_Output input{feed, 0};
+  const TF_Output output{add, 0};
+  TF_Tensor* buffer = TF_AllocateTensor(TF_INT32, nullptr, 0, sizeof(int32));
+  void* const data = TF_TensorData(buffer);
+  for (int32 value : {1, 5}) {
+    TF_Tensor* input_value = Int32Tensor(value);
+    TF_SessionRunWithOutputBuffers(session, nullptr, &input, &input_value, 1,
+                                   &output, &buffer, 1, nullptr, 0, nullptr,
+                                   s);
+    TF_DeleteTensor(input_value);
+    ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+    EXPECT_EQ(TF_TensorData(buffer), data);
+    EXPECT_EQ(*static_cast<int32*>(TF_TensorData(buffer)), value + 2);
+  }
+  TF_DeleteTensor(buffer);
+
+  // Null outputs are allocated.
+  TF_Tensor* input_value = Int32Tensor(3);
+  TF_Tensor* output_value = nullptr;
+  TF_SessionRunWithOutputBuffers(session, nullptr, &input, &input_value, 1,
+                                 &output, &output_value, 1, nullptr, 0, nullptr,
+                                 s);
+  TF_DeleteTensor(input_value);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  ASSERT_NE(output_value, nullptr);
+  EXPECT_EQ(*static_cast<int32*>(TF_TensorData(output_value)), 5);
+  TF_DeleteTensor(output_value);
+
+  TF_CloseSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteSession(session, s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
+TEST(CAPI_EXPERIMENTAL, ExecuteWithOutputBuffers) {
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  TFE_DeleteContextOptions(opts);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+
+  TFE_TensorHandle* m = TestMatrixTensorHandle(ctx);
+  TFE_Op* matmul = MatMulOp(ctx, m, m);
+  const int64_t dims[] = {2, 2};
+  TF_Tensor* buffer = TF_AllocateTensor(TF_FLOAT, dims, 2, 4 * sizeof(float));
+  TFE_TensorHandle* retval = nullptr;
+  int num_retvals = 1;
+  TFE_ExecuteWithOutputBuffers(matmul, &buffer, 1, &retval, &num_retvals,
+                               status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TF_Tensor* t = TFE_TensorHandleResolve(retval, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  EXPECT_EQ(TF_TensorData(t), TF_TensorData(buffer));
+  const float* product = static_cast<const float*>(TF_TensorData(buffer));
+  EXPECT_EQ(7, product[0]);
+  EXPECT_EQ(10, product[1]);
+  EXPECT_EQ(15, product[2]);
+  EXPECT_EQ(22, product[3]);
+
+  TF_DeleteTensor(t);
+  TF_DeleteTensor(buffer);
+  TFE_DeleteTensorHandle(retval);
+  TFE_DeleteOp(matmul);
+  TFE_DeleteTensorHandle(m);
+  TFE_DeleteContext(ctx);
+  TF_DeleteStatus(status);
+}
+
 TEST(CAPI_EXPERIMENTAL, LibraryPluggableDeviceLoadFunctions) {
   // TODO(penpornk): Enable this test on Windows.
 #if !defined(PLATFORM_WINDOWS)
@@ -131,6 +131,11 @@ struct TF_Session {
   // public behavior). Can be set to false if the caller needs to call
   // ExtendSessionGraphHelper manually.
   std::atomic<bool> extend_before_run;
+
+  // The callables made by TF_SessionRunWithOutputBuffers, by the serialized
+  // CallableOptions of their feeds, fetches, targets and run options.
+  std::unordered_map<tensorflow::string, tensorflow::Session::CallableHandle>
+      callables TF_GUARDED_BY(mu);
 };
 
 struct TF_ImportGraphDefOptions {
@@ -17,22 +17,30 @@ limitations under the License.
 
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/match.h"
 #include "tensorflow/c/c_api.h"
 #include "tensorflow/c/eager/c_api_internal.h"
 #include "tensorflow/c/eager/tfe_context_internal.h"
+#include "tensorflow/c/eager/tfe_op_batch_internal.h"
 #include "tensorflow/c/eager/tfe_op_internal.h"
 #include "tensorflow/c/eager/tfe_tensorhandle_internal.h"
 #include "tensorflow/c/tf_status_helper.h"
 #include "tensorflow/core/common_runtime/composite_device.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/eager/eager_operation.h"
+#include "tensorflow/core/common_runtime/eager/tensor_handle.h"
 #include "tensorflow/core/distributed_runtime/coordination/coordination_service_agent.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/graph_to_functiondef.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/casts.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/strcat.h"
 
@@ -843,3 +851,301 @@ void TFE_ReportErrorToCluster(TFE_Context* ctx, int error_code,
                        error_message);
   status->status = coord_agent->ReportError(s);
 }
+
+TFE_OpBatch* TFE_NewOpBatch(TFE_Context* ctx) {
+  return new TFE_OpBatch(tensorflow::unwrap(ctx));
+}
+
+void TFE_DeleteOpBatch(TFE_OpBatch* batch) { delete batch; }
+
+namespace {
+
+// Checks that output `output_index` of the op at `op_index` in `batch` is one
+// of the outputs of its first `num_ops` ops.
+tensorflow::Status CheckOpOutput(const TFE_OpBatch& batch, int op_index,
+                                 int output_index, int num_ops) {
+  if (op_index < 0 || op_index >= num_ops) {
+    return tensorflow::errors::InvalidArgument(
+        "Op ", op_index, " is not one of the ", num_ops,
+        " ops of the batch that can be used.");
+  }
+  const int num_outputs = batch.ops[op_index].num_outputs;
+  if (output_index < 0 || output_index >= num_outputs) {
+    return tensorflow::errors::InvalidArgument(
+        "Op ", op_index, " of the batch has ", num_outputs,
+        " outputs, but output ", output_index, " was requested.");
+  }
+  return tensorflow::Status::OK();
+}
+
+// Executes the ops of `batch` one by one, and adds its results to `results`.
+tensorflow::Status ExecuteBatchOps(
+    TFE_OpBatch* batch,
+    std::vector<tensorflow::ImmediateTensorHandlePtr>* results) {
+  std::vector<std::vector<tensorflow::ImmediateTensorHandlePtr>> outputs(
+      batch->ops.size());
+  for (int i = 0, end = batch->ops.size(); i < end; ++i) {
+    TFE_OpBatch::Op& op = batch->ops[i];
+    op.op->Clear();
+    for (const TFE_OpBatch::Input& input : op.inputs) {
+      TF_RETURN_IF_ERROR(op.op->AddInput(
+          input.handle != nullptr
+              ? input.handle.get()
+              : outputs[input.op_output.op_index][input.op_output.output_index]
+                    .get()));
+    }
+    std::vector<tensorflow::ImmediateExecutionTensorHandle*> retvals(
+        op.num_outputs);
+    int num_retvals = op.num_outputs;
+    TF_RETURN_IF_ERROR(batch->ctx->GetCustomDeviceOpHandler().Execute(
+        op.op.get(), retvals.data(), &num_retvals));
+    for (int j = 0; j < num_retvals; ++j) outputs[i].emplace_back(retvals[j]);
+    if (num_retvals != op.num_outputs) {
+      return tensorflow::errors::InvalidArgument(
+          "Op ", i, " of the batch was added with ", op.num_outputs,
+          " outputs, but has ", num_retvals, ".");
+    }
+  }
+  for (const TFE_OpBatch::OpOutput& result : batch->results) {
+    tensorflow::ImmediateExecutionTensorHandle* h =
+        outputs[result.op_index][result.output_index].get();
+    h->Ref();
+    results->emplace_back(h);
+  }
+  return tensorflow::Status::OK();
+}
+
+// Traces the ops of `batch` into `fdef`, whose arguments are `args`, the
+// distinct tensor handle inputs of the ops.
+tensorflow::Status TraceBatchOps(
+    TFE_OpBatch* batch,
+    const std::vector<tensorflow::ImmediateExecutionTensorHandle*>& args,
+    tensorflow::FunctionDef* fdef) {
+  using tensorflow::Node;
+  using tensorflow::NodeDef;
+  tensorflow::Graph graph(batch->ctx->FuncLibDef());
+  tensorflow::Status s;
+  absl::flat_hash_map<tensorflow::ImmediateExecutionTensorHandle*, Node*>
+      arg_nodes;
+  for (int i = 0, end = args.size(); i < end; ++i) {
+    NodeDef arg_def;
+    arg_def.set_name(tensorflow::strings::StrCat("input_", i));
+    arg_def.set_op(tensorflow::FunctionLibraryDefinition::kArgOp);
+    tensorflow::AddNodeAttr("T", args[i]->DataType(), &arg_def);
+    tensorflow::AddNodeAttr("index", i, &arg_def);
+    arg_nodes[args[i]] = graph.AddNode(arg_def, &s);
+    TF_RETURN_IF_ERROR(s);
+  }
+
+  std::vector<Node*> op_nodes;
+  Node* last_stateful_node = nullptr;
+  for (int i = 0, end = batch->ops.size(); i < end; ++i) {
+    TFE_OpBatch::Op& op = batch->ops[i];
+    // Adding the inputs to the op infers its type attributes, with stand-ins
+    // of the right types for the outputs of earlier ops.
+    op.op->Clear();
+    std::vector<tensorflow::ImmediateTensorHandlePtr> stand_ins;
+    std::vector<std::pair<Node*, int>> sources;
+    for (const TFE_OpBatch::Input& input : op.inputs) {
+      if (input.handle != nullptr) {
+        sources.emplace_back(arg_nodes[input.handle.get()], 0);
+        TF_RETURN_IF_ERROR(op.op->AddInput(input.handle.get()));
+        continue;
+      }
+      Node* src = op_nodes[input.op_output.op_index];
+      sources.emplace_back(src, input.op_output.output_index);
+      stand_ins.emplace_back(tensorflow::TensorHandle::CreateLocalHandle(
+          tensorflow::Tensor(src->output_type(input.op_output.output_index),
+                             tensorflow::TensorShape({0}))));
+      TF_RETURN_IF_ERROR(op.op->AddInput(stand_ins.back().get()));
+    }
+    NodeDef node_def;
+    node_def.set_name(tensorflow::strings::StrCat("op_", i));
+    node_def.set_op(op.op->Name());
+    node_def.set_device(op.op->DeviceName());
+    tensorflow::OperationFromInterface(op.op.get())
+        ->Attrs()
+        .FillAttrValueMap(node_def.mutable_attr());
+    op.op->Clear();
+
+    Node* node = graph.AddNode(node_def, &s);
+    TF_RETURN_IF_ERROR(s);
+    if (node->num_outputs() != op.num_outputs) {
+      return tensorflow::errors::InvalidArgument(
+          "Op ", i, " of the batch was added with ", op.num_outputs,
+          " outputs, but has ", node->num_outputs(), ".");
+    }
+    for (int j = 0, num_inputs = sources.size(); j < num_inputs; ++j) {
+      graph.AddEdge(sources[j].first, sources[j].second, node, j);
+    }
+    if (node->op_def().is_stateful()) {
+      if (last_stateful_node != nullptr) {
+        graph.AddControlEdge(last_stateful_node, node);
+      }
+      last_stateful_node = node;
+    }
+    op_nodes.push_back(node);
+  }
+
+  for (int i = 0, end = batch->results.size(); i < end; ++i) {
+    const TFE_OpBatch::OpOutput& result = batch->results[i];
+    Node* src = op_nodes[result.op_index];
+    NodeDef retval_def;
+    retval_def.set_name(tensorflow::strings::StrCat("output_", i));
+    retval_def.set_op(tensorflow::FunctionLibraryDefinition::kRetOp);
+    tensorflow::AddNodeAttr("T", src->output_type(result.output_index),
+                            &retval_def);
+    tensorflow::AddNodeAttr("index", i, &retval_def);
+    Node* retval = graph.AddNode(retval_def, &s);
+    TF_RETURN_IF_ERROR(s);
+    graph.AddEdge(src, result.output_index, retval, 0);
+  }
+
+  // The stateful ops are control outputs, so that they run even if no result
+  // depends on them.
+  TF_RETURN_IF_ERROR(tensorflow::GraphToFunctionDef(
+      graph, "",
+      [](const Node* node) -> absl::optional<string> {
+        if (node->IsArg() || node->IsRetval() ||
+            !node->op_def().is_stateful()) {
+          return absl::nullopt;
+        }
+        return node->name();
+      },
+      fdef));
+  fdef->mutable_signature()->set_name(tensorflow::strings::StrCat(
+      "__eager_op_batch_",
+      tensorflow::Fingerprint64(fdef->SerializeAsString())));
+  return tensorflow::Status::OK();
+}
+
+// Executes the function that the ops of `batch` are traced into, and adds its
+// results to `results`.
+tensorflow::Status ExecuteTracedBatch(
+    TFE_OpBatch* batch,
+    std::vector<tensorflow::ImmediateTensorHandlePtr>* results) {
+  for (const TFE_OpBatch::Op& op : batch->ops) {
+    if (!tensorflow::EagerOperation::classof(op.op.get())) {
+      return tensorflow::errors::Unimplemented(
+          "Only batches of eager ops can be traced.");
+    }
+  }
+  std::vector<tensorflow::ImmediateExecutionTensorHandle*> args;
+  absl::flat_hash_map<tensorflow::ImmediateExecutionTensorHandle*, int>
+      arg_indices;
+  for (const TFE_OpBatch::Op& op : batch->ops) {
+    for (const TFE_OpBatch::Input& input : op.inputs) {
+      if (input.handle != nullptr &&
+          arg_indices.emplace(input.handle.get(), args.size()).second) {
+        args.push_back(input.handle.get());
+      }
+    }
+  }
+  if (batch->function_name.empty()) {
+    tensorflow::FunctionDef fdef;
+    TF_RETURN_IF_ERROR(TraceBatchOps(batch, args, &fdef));
+    if (batch->ctx->FindFunctionDef(fdef.signature().name()) == nullptr) {
+      TF_RETURN_IF_ERROR(batch->ctx->AddFunctionDef(fdef));
+    }
+    batch->function_name = fdef.signature().name();
+  }
+
+  tensorflow::ImmediateOpPtr call(batch->ctx->CreateOperation());
+  TF_RETURN_IF_ERROR(call->Reset(batch->function_name.c_str(), nullptr));
+  for (tensorflow::ImmediateExecutionTensorHandle* arg : args) {
+    TF_RETURN_IF_ERROR(call->AddInput(arg));
+  }
+  std::vector<tensorflow::ImmediateExecutionTensorHandle*> retvals(
+      batch->results.size());
+  int num_retvals = retvals.size();
+  TF_RETURN_IF_ERROR(batch->ctx->GetCustomDeviceOpHandler().Execute(
+      call.get(), retvals.data(), &num_retvals));
+  for (int i = 0; i < num_retvals; ++i) results->emplace_back(retvals[i]);
+  return tensorflow::Status::OK();
+}
+
+}  // namespace
+
+int TFE_OpBatchAddOp(TFE_OpBatch* batch, TFE_Op* op, int num_outputs,
+                     TF_Status* status) {
+  tensorflow::ImmediateExecutionOperation* unwrapped_op =
+      tensorflow::unwrap(op);
+  if (!unwrapped_op->GetInputs().empty()) {
+    status->status = tensorflow::errors::InvalidArgument(
+        "The inputs of op ", unwrapped_op->Name(),
+        " must be added to the batch.");
+    return -1;
+  }
+  if (num_outputs < 0) {
+    status->status = tensorflow::errors::InvalidArgument(
+        "Invalid number of outputs: ", num_outputs);
+    return -1;
+  }
+  status->status = tensorflow::Status::OK();
+  batch->ops.push_back(
+      {tensorflow::ImmediateOpPtr(unwrapped_op), num_outputs, {}});
+  batch->function_name.clear();
+  return batch->ops.size() - 1;
+}
+
+void TFE_OpBatchAddInput(TFE_OpBatch* batch, TFE_TensorHandle* h,
+                         TF_Status* status) {
+  if (batch->ops.empty()) {
+    status->status =
+        tensorflow::errors::FailedPrecondition("The batch has no ops.");
+    return;
+  }
+  tensorflow::ImmediateExecutionTensorHandle* handle = tensorflow::unwrap(h);
+  handle->Ref();
+  batch->ops.back().inputs.push_back(
+      {tensorflow::ImmediateTensorHandlePtr(handle), {-1, -1}});
+  batch->function_name.clear();
+  status->status = tensorflow::Status::OK();
+}
+
+void TFE_OpBatchAddOpOutput(TFE_OpBatch* batch, int op_index,
+                            int output_index, TF_Status* status) {
+  if (batch->ops.empty()) {
+    status->status =
+        tensorflow::errors::FailedPrecondition("The batch has no ops.");
+    return;
+  }
+  status->status = CheckOpOutput(*batch, op_index, output_index,
+                                 /*num_ops=*/batch->ops.size() - 1);
+  if (!status->status.ok()) return;
+  batch->ops.back().inputs.push_back({nullptr, {op_index, output_index}});
+  batch->function_name.clear();
+}
+
+void TFE_OpBatchAddResult(TFE_OpBatch* batch, int op_index, int output_index,
+                          TF_Status* status) {
+  status->status =
+      CheckOpOutput(*batch, op_index, output_index, batch->ops.size());
+  if (!status->status.ok()) return;
+  batch->results.push_back({op_index, output_index});
+  batch->function_name.clear();
+}
+
+void TFE_OpBatchSetTraced(TFE_OpBatch* batch, unsigned char traced) {
+  batch->traced = traced;
+}
+
+void TFE_ExecuteBatch(TFE_OpBatch* batch, TFE_TensorHandle** retvals,
+                      int* num_retvals, TF_Status* status) {
+  const int num_results = batch->results.size();
+  if (*num_retvals < num_results) {
+    status->status = tensorflow::errors::InvalidArgument(
+        "The batch has ", num_results, " results, but only ", *num_retvals,
+        " can be returned.");
+    return;
+  }
+  std::vector<tensorflow::ImmediateTensorHandlePtr> results;
+  results.reserve(num_results);
+  status->status = batch->traced ? ExecuteTracedBatch(batch, &results)
+                                 : ExecuteBatchOps(batch, &results);
+  if (!status->status.ok()) return;
+  *num_retvals = results.size();
+  for (int i = 0; i < *num_retvals; ++i) {
+    retvals[i] = tensorflow::wrap(results[i].release());
+  }
+}
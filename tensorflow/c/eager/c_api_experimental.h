@@ -701,6 +701,63 @@ TF_CAPI_EXPORT extern void TFE_ReportErrorToCluster(TFE_Context* ctx,
                                                     const char* error_message,
                                                     TF_Status* status);
 
+// -----------------------------------------------------------------------------
+// Op batch API.
+//
+// A batch is a sequence of ops whose inputs may be outputs of the ops before
+// them in the batch, and which are executed by one call to TFE_ExecuteBatch,
+// saving the calls and the tensor handles of the intermediate results.
+
+typedef struct TFE_OpBatch TFE_OpBatch;
+
+TF_CAPI_EXPORT extern TFE_OpBatch* TFE_NewOpBatch(TFE_Context* ctx);
+
+TF_CAPI_EXPORT extern void TFE_DeleteOpBatch(TFE_OpBatch* batch);
+
+// Appends `op`, which has `num_outputs` outputs and whose attributes and
+// device are set, to `batch`, and returns its index in the batch. The inputs
+// of `op` are added with TFE_OpBatchAddInput and TFE_OpBatchAddOpOutput
+// instead of TFE_OpAddInput. On success, `batch` takes ownership of `op`.
+TF_CAPI_EXPORT extern int TFE_OpBatchAddOp(TFE_OpBatch* batch, TFE_Op* op,
+                                           int num_outputs, TF_Status* status);
+
+// Adds `h` as the next input of the last op appended to `batch`. As with
+// TFE_OpAddInput, the attributes of list inputs aren't inferred, and must be
+// set on the op.
+TF_CAPI_EXPORT extern void TFE_OpBatchAddInput(TFE_OpBatch* batch,
+                                               TFE_TensorHandle* h,
+                                               TF_Status* status);
+
+// Adds output `output_index` of the op at `op_index` in `batch` as the next
+// input of the last op appended to `batch`, which must come after it.
+TF_CAPI_EXPORT extern void TFE_OpBatchAddOpOutput(TFE_OpBatch* batch,
+                                                  int op_index,
+                                                  int output_index,
+                                                  TF_Status* status);
+
+// Adds output `output_index` of the op at `op_index` in `batch` to the
+// results that TFE_ExecuteBatch returns, in the order they were added.
+TF_CAPI_EXPORT extern void TFE_OpBatchAddResult(TFE_OpBatch* batch,
+                                                int op_index, int output_index,
+                                                TF_Status* status);
+
+// If `traced` is true, TFE_ExecuteBatch traces the ops of `batch` into a
+// function, which is executed as a single op. The function is registered in
+// the context and reused until the batch changes. Stateful ops run in the
+// order of the batch. Otherwise, the ops are executed one by one, and in an
+// async executor only enqueued.
+TF_CAPI_EXPORT extern void TFE_OpBatchSetTraced(TFE_OpBatch* batch,
+                                                unsigned char traced);
+
+// Executes the ops of `batch` on the executor of the current thread, and sets
+// `retvals` to its results. `*num_retvals` is the size of `retvals`, which
+// must be at least the number of results, and is set to that number. The
+// batch can be executed again, e.g. if it has stateful ops.
+TF_CAPI_EXPORT extern void TFE_ExecuteBatch(TFE_OpBatch* batch,
+                                            TFE_TensorHandle** retvals,
+                                            int* num_retvals,
+                                            TF_Status* status);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
@@ -514,5 +514,70 @@ TEST(CAPI, TensorHandleDefaults) {
   TFE_DeleteContext(ctx);
 }
 
+void ExecuteBatch(bool async, bool traced) {
+  std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(
+      TF_NewStatus(), TF_DeleteStatus);
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_ContextOptionsSetAsync(opts, static_cast<unsigned char>(async));
+  TFE_Context* ctx = TFE_NewContext(opts, status.get());
+  TFE_DeleteContextOptions(opts);
+  ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+
+  // Computes the cube of `m` with two MatMul ops.
+  TFE_TensorHandle* m = TestMatrixTensorHandle(ctx);
+  TFE_OpBatch* batch = TFE_NewOpBatch(ctx);
+  TFE_OpBatchSetTraced(batch, static_cast<unsigned char>(traced));
+  for (int i = 0; i < 2; ++i) {
+    TFE_Op* matmul = TFE_NewOp(ctx, "MatMul", status.get());
+    ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+    EXPECT_EQ(i, TFE_OpBatchAddOp(batch, matmul, 1, status.get()));
+    ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+    if (i == 0) {
+      TFE_OpBatchAddInput(batch, m, status.get());
+    } else {
+      TFE_OpBatchAddOpOutput(batch, 0, 0, status.get());
+    }
+    ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+    TFE_OpBatchAddInput(batch, m, status.get());
+    ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+  }
+  TFE_OpBatchAddOpOutput(batch, 1, 0, status.get());
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status.get()));
+  TFE_OpBatchAddResult(batch, 1, 0, status.get());
+  ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+
+  // Executing the batch again reuses its function, if traced.
+  for (int run = 0; run < 2; ++run) {
+    TFE_TensorHandle* retval = nullptr;
+    int num_retvals = 1;
+    TFE_ExecuteBatch(batch, &retval, &num_retvals, status.get());
+    ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+    ASSERT_EQ(1, num_retvals);
+    TF_Tensor* t = TFE_TensorHandleResolve(retval, status.get());
+    ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+    float product[4] = {0};
+    EXPECT_EQ(sizeof(product), TF_TensorByteSize(t));
+    memcpy(&product[0], TF_TensorData(t), TF_TensorByteSize(t));
+    EXPECT_EQ(37, product[0]);
+    EXPECT_EQ(54, product[1]);
+    EXPECT_EQ(81, product[2]);
+    EXPECT_EQ(118, product[3]);
+    TF_DeleteTensor(t);
+    TFE_DeleteTensorHandle(retval);
+  }
+
+  TFE_DeleteOpBatch(batch);
+  TFE_DeleteTensorHandle(m);
+  TFE_Executor* executor = TFE_ContextGetExecutorForThread(ctx);
+  TFE_ExecutorWaitForAllPendingNodes(executor, status.get());
+  ASSERT_EQ(TF_OK, TF_GetCode(status.get())) << TF_Message(status.get());
+  TFE_DeleteExecutor(executor);
+  TFE_DeleteContext(ctx);
+}
+TEST(CAPI, ExecuteBatch) { ExecuteBatch(false, false); }
+TEST(CAPI, ExecuteBatchAsync) { ExecuteBatch(true, false); }
+TEST(CAPI, ExecuteBatchTraced) { ExecuteBatch(false, true); }
+TEST(CAPI, ExecuteBatchTracedAsync) { ExecuteBatch(true, true); }
+
 }  // namespace
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/c/eager/c_api.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <string>
@@ -149,6 +150,42 @@ void BM_Execute_Identity(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_Execute_Identity)->Arg(0)->Arg(1);
 
+// Executes a small op in a tight loop, with the dispatch cache disabled (0) or
+// enabled (1), to measure the per-op dispatch overhead.
+void BM_Execute_SmallOp(::testing::benchmark::State& state) {
+  const int dispatch_cache = state.range(0);
+  state.SetLabel(dispatch_cache ? "DispatchCache" : "NoDispatchCache");
+  setenv("TF_EAGER_ENABLE_DISPATCH_CACHE", dispatch_cache ? "1" : "0", 1);
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteContextOptions(opts);
+  unsetenv("TF_EAGER_ENABLE_DISPATCH_CACHE");
+
+  TFE_TensorHandle* x = TestScalarTensorHandle(ctx, 1.0f);
+  TFE_Op* add = TFE_NewOp(ctx, "AddV2", status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_TensorHandle* retvals[1];
+  int num_retvals = 1;
+  for (auto s : state) {
+    TFE_OpReset(add, "AddV2", nullptr, status);
+    CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_OpAddInput(add, x, status);
+    CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_OpAddInput(add, x, status);
+    CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_Execute(add, &retvals[0], &num_retvals, status);
+    CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_DeleteTensorHandle(retvals[0]);
+  }
+  TFE_DeleteOp(add);
+  TFE_DeleteTensorHandle(x);
+  TFE_DeleteContext(ctx);
+  TF_DeleteStatus(status);
+}
+BENCHMARK(BM_Execute_SmallOp)->Arg(0)->Arg(1);
+
 TEST(CAPI, Context) {
   TF_Status* status = TF_NewStatus();
   TFE_ContextOptions* opts = TFE_NewContextOptions();
@@ -774,6 +811,84 @@ void Execute_MatMul_CPU(bool async) {
 TEST(CAPI, Execute_MatMul_CPU) { Execute_MatMul_CPU(false); }
 TEST(CAPI, Execute_MatMul_CPUAsync) { Execute_MatMul_CPU(true); }
 
+TEST(CAPI, ExecuteAddChainWithLazyFusion) {
+  setenv("TF_EAGER_LAZY_FUSION_MAX_NODES", "8", 1);
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_ContextOptionsSetAsync(opts, static_cast<unsigned char>(true));
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteContextOptions(opts);
+  unsetenv("TF_EAGER_LAZY_FUSION_MAX_NODES");
+
+  // Each op consumes the output of the previous one, so runs of the chain
+  // are fused into functions whose results must match op-by-op execution.
+  TFE_TensorHandle* one = TestScalarTensorHandle(ctx, 1.0f);
+  TFE_TensorHandle* x = TestScalarTensorHandle(ctx, 0.0f);
+  for (int i = 0; i < 100; ++i) {
+    TFE_Op* add = AddOp(ctx, x, one);
+    TFE_TensorHandle* retvals[1] = {nullptr};
+    int num_retvals = 1;
+    TFE_Execute(add, &retvals[0], &num_retvals, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    TFE_DeleteOp(add);
+    TFE_DeleteTensorHandle(x);
+    x = retvals[0];
+  }
+  TF_Tensor* t = TFE_TensorHandleResolve(x, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  EXPECT_EQ(100.0f, *static_cast<float*>(TF_TensorData(t)));
+  TF_DeleteTensor(t);
+  TFE_DeleteTensorHandle(x);
+  TFE_DeleteTensorHandle(one);
+  TFE_Executor* executor = TFE_ContextGetExecutorForThread(ctx);
+  TFE_ExecutorWaitForAllPendingNodes(executor, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteExecutor(executor);
+  TFE_DeleteContext(ctx);
+  TF_DeleteStatus(status);
+}
+
+TEST(CAPI, ExecuteAddWithDispatchCache) {
+  setenv("TF_EAGER_ENABLE_DISPATCH_CACHE", "1", 1);
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteContextOptions(opts);
+  unsetenv("TF_EAGER_ENABLE_DISPATCH_CACHE");
+
+  // The second op of each dtype is dispatched from the cache, and ops with
+  // different input dtypes must not share a kernel.
+  TFE_TensorHandle* f = TestScalarTensorHandle(ctx, 2.0f);
+  TFE_TensorHandle* i = TestScalarTensorHandle(ctx, 3);
+  for (int iter = 0; iter < 2; ++iter) {
+    for (TFE_TensorHandle* input : {f, i}) {
+      TFE_Op* add = AddOp(ctx, input, input);
+      TFE_TensorHandle* retvals[1] = {nullptr};
+      int num_retvals = 1;
+      TFE_Execute(add, &retvals[0], &num_retvals, status);
+      ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+      TFE_DeleteOp(add);
+      TF_Tensor* t = TFE_TensorHandleResolve(retvals[0], status);
+      ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+      TFE_DeleteTensorHandle(retvals[0]);
+      if (input == f) {
+        ASSERT_EQ(TF_FLOAT, TF_TensorType(t));
+        EXPECT_EQ(4.0f, *static_cast<float*>(TF_TensorData(t)));
+      } else {
+        ASSERT_EQ(TF_INT32, TF_TensorType(t));
+        EXPECT_EQ(6, *static_cast<int32_t*>(TF_TensorData(t)));
+      }
+      TF_DeleteTensor(t);
+    }
+  }
+  TFE_DeleteTensorHandle(f);
+  TFE_DeleteTensorHandle(i);
+  TFE_DeleteContext(ctx);
+  TF_DeleteStatus(status);
+}
+
 void Execute_MatMul_CPU_Runtime_Error(bool async) {
   TF_Status* status = TF_NewStatus();
   TFE_ContextOptions* opts = TFE_NewContextOptions();
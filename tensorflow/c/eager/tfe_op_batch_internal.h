@@ -0,0 +1,58 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_C_EAGER_TFE_OP_BATCH_INTERNAL_H_
+#define TENSORFLOW_C_EAGER_TFE_OP_BATCH_INTERNAL_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/c/eager/immediate_execution_context.h"
+#include "tensorflow/c/eager/immediate_execution_operation.h"
+#include "tensorflow/c/eager/immediate_execution_tensor_handle.h"
+
+struct TFE_OpBatch {
+  explicit TFE_OpBatch(tensorflow::ImmediateExecutionContext* ctx)
+      : ctx(ctx) {}
+
+  // An output of an op in the batch.
+  struct OpOutput {
+    int op_index;
+    int output_index;
+  };
+
+  // An input of an op in the batch: a tensor handle, if not null, or else an
+  // output of an earlier op.
+  struct Input {
+    tensorflow::ImmediateTensorHandlePtr handle;
+    OpOutput op_output;
+  };
+
+  struct Op {
+    tensorflow::ImmediateOpPtr op;
+    int num_outputs;
+    std::vector<Input> inputs;
+  };
+
+  tensorflow::ImmediateExecutionContext* const ctx;
+  std::vector<Op> ops;
+  std::vector<OpOutput> results;
+  bool traced = false;
+
+  // The function that the ops were last traced into, or empty if the batch
+  // changed since.
+  std::string function_name;
+};
+
+#endif  // TENSORFLOW_C_EAGER_TFE_OP_BATCH_INTERNAL_H_
@@ -24,6 +24,11 @@ constexpr char kSavedModelAssetsDirectory[] = "assets";
 // SavedModel assets.extra directory.
 constexpr char kSavedModelAssetsExtraDirectory[] = "assets.extra";
 
+// File in the assets.extra directory with the requests that warm up a
+// SavedModel after it is loaded.
+constexpr char kSavedModelWarmupRequestsFilename[] =
+    "tf_saved_model_warmup_requests";
+
 // SavedModel assets key for graph collection-def.
 constexpr char kSavedModelAssetsKey[] = "saved_model_assets";
 
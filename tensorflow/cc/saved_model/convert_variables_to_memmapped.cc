@@ -0,0 +1,48 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Writes the variables of a SavedModel to a memmapped package, from which
+// LoadSavedModel() restores them when
+// SavedModelLoadOptions::memmapped_variables_package names it.
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/cc/saved_model/memmapped_variables.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+int main(int argc, char* argv[]) {
+  std::string saved_model_dir;
+  std::string out_package;
+  std::vector<tensorflow::Flag> flag_list = {
+      tensorflow::Flag("saved_model_dir", &saved_model_dir,
+                       "Export directory of the SavedModel"),
+      tensorflow::Flag("out_package", &out_package,
+                       "Memmapped package to write the variables to"),
+  };
+  const std::string usage = tensorflow::Flags::Usage(argv[0], flag_list);
+  const bool parsed_flags_ok = tensorflow::Flags::Parse(&argc, argv, flag_list);
+  tensorflow::port::InitMain(usage.c_str(), &argc, &argv);
+  QCHECK(parsed_flags_ok && !saved_model_dir.empty() && !out_package.empty())
+      << usage;
+  TF_QCHECK_OK(tensorflow::ConvertSavedModelVariablesToMemmapped(
+      tensorflow::Env::Default(), saved_model_dir, out_package));
+  LOG(INFO) << "Wrote the variables of " << saved_model_dir << " to "
+            << out_package;
+  return 0;
+}
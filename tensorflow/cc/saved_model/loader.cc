@@ -15,10 +15,12 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/loader.h"
 
+#include <algorithm>
 #include <unordered_set>
 
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/cc/saved_model/loader_util.h"
+#include "tensorflow/cc/saved_model/memmapped_variables.h"
 #include "tensorflow/cc/saved_model/metrics.h"
 #include "tensorflow/cc/saved_model/reader.h"
 #include "tensorflow/cc/saved_model/util.h"
@@ -33,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/protobuf/graph_debug_info.pb.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/protobuf/saver.pb.h"
@@ -184,10 +187,49 @@ Status RunOnce(const RunOptions& run_options,
   return run_status;
 }
 
+// Runs `op_name` like RunOnce(), or its independent parts concurrently if
+// `load_options` has several threads to run them.
+Status RunOpOrIndependentTargets(
+    const RunOptions& run_options, const SavedModelLoadOptions& load_options,
+    const GraphDef& graph_def,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const string& op_name, Session* session) {
+  std::vector<string> targets = {op_name};
+  if (load_options.num_load_threads > 1) {
+    targets = internal::GetIndependentTargets(graph_def, op_name);
+  }
+  if (targets.size() == 1) {
+    RunMetadata run_metadata;
+    return RunOnce(run_options, inputs, {}, targets, nullptr /* outputs */,
+                   &run_metadata, session);
+  }
+
+  VLOG(1) << "Running " << targets.size() << " parts of " << op_name
+          << " concurrently.";
+  std::vector<Status> statuses(targets.size());
+  {
+    thread::ThreadPool pool(
+        Env::Default(), "saved_model_load",
+        std::min<int>(load_options.num_load_threads, targets.size()));
+    for (int i = 0; i < targets.size(); ++i) {
+      pool.Schedule([&, i]() {
+        RunMetadata run_metadata;
+        statuses[i] = RunOnce(run_options, inputs, {}, {targets[i]},
+                              nullptr /* outputs */, &run_metadata, session);
+      });
+    }
+  }
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return Status::OK();
+}
+
 // RunInitOp will return OK if the initialization op was run successfully.
 // An empty init_op_name indicates that there are no init ops to run.
-Status RunInitOp(const RunOptions& run_options, const string& export_dir,
-                 const MetaGraphDef& meta_graph_def,
+Status RunInitOp(const RunOptions& run_options,
+                 const SavedModelLoadOptions& load_options,
+                 const string& export_dir, const MetaGraphDef& meta_graph_def,
                  const std::vector<AssetFileDef>& asset_file_defs,
                  Session* session, const string& init_op_name) {
   if (!init_op_name.empty()) {
@@ -195,14 +237,16 @@ Status RunInitOp(const RunOptions& run_options, const string& export_dir,
               << export_dir;
     std::vector<std::pair<string, Tensor>> inputs;
     AddAssetsTensorsToInputs(export_dir, asset_file_defs, &inputs);
-    RunMetadata run_metadata;
-    return RunOnce(run_options, inputs, {}, {init_op_name},
-                   nullptr /* outputs */, &run_metadata, session);
+    return RunOpOrIndependentTargets(run_options, load_options,
+                                     meta_graph_def.graph_def(), inputs,
+                                     init_op_name, session);
   }
   return Status::OK();
 }
 
-Status RunRestore(const RunOptions& run_options, const string& export_dir,
+Status RunRestore(const RunOptions& run_options,
+                  const SavedModelLoadOptions& load_options,
+                  const GraphDef& graph_def, const string& export_dir,
                   const StringPiece restore_op_name,
                   const StringPiece variable_filename_const_op_name,
                   const std::vector<AssetFileDef>& asset_file_defs,
@@ -234,9 +278,34 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
 
   AddAssetsTensorsToInputs(export_dir, asset_file_defs, &inputs);
 
-  RunMetadata run_metadata;
-  return RunOnce(run_options, inputs, {}, {string(restore_op_name)},
-                 nullptr /* outputs */, &run_metadata, session);
+  return RunOpOrIndependentTargets(run_options, load_options, graph_def,
+                                   inputs, string(restore_op_name), session);
+}
+
+// Like RunRestore(), but feeds the restore op with the variables of the
+// memmapped package in `load_options`, and wraps `session` to keep them.
+Status RunMemmappedRestore(const RunOptions& run_options,
+                           const SavedModelLoadOptions& load_options,
+                           const MetaGraphDef& meta_graph,
+                           const string& export_dir,
+                           const std::vector<AssetFileDef>& asset_file_defs,
+                           std::unique_ptr<Session>* session) {
+  LOG(INFO) << "Restoring SavedModel bundle from memmapped variables at "
+            << load_options.memmapped_variables_package;
+  std::unique_ptr<MemmappedVariables> variables;
+  TF_RETURN_IF_ERROR(MemmappedVariables::Load(
+      Env::Default(), load_options.memmapped_variables_package, &variables));
+  std::vector<std::pair<string, Tensor>> inputs;
+  TF_RETURN_IF_ERROR(variables->AddRestoreInputs(
+      meta_graph.graph_def(), meta_graph.saver_def().filename_tensor_name(),
+      &inputs));
+  AddAssetsTensorsToInputs(export_dir, asset_file_defs, &inputs);
+  TF_RETURN_IF_ERROR(RunOpOrIndependentTargets(
+      run_options, load_options, meta_graph.graph_def(), inputs,
+      meta_graph.saver_def().restore_op_name(), session->get()));
+  *session = WrapSessionWithMemmappedVariables(std::move(*session),
+                                               std::move(variables));
+  return Status::OK();
 }
 
 }  // namespace
@@ -255,6 +324,7 @@ Status LoadMetagraphIntoSession(const SessionOptions& session_options,
 
 Status LoadSavedModelInternal(const SessionOptions& session_options,
                               const RunOptions& run_options,
+                              const SavedModelLoadOptions& load_options,
                               const string& export_dir,
                               const std::unordered_set<string>& tags,
                               SavedModelBundle* const bundle) {
@@ -264,8 +334,9 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
       ReadSavedModelDebugInfoIfPresent(export_dir, &bundle->debug_info));
   TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
       session_options, bundle->meta_graph_def, &bundle->session));
-  TF_RETURN_IF_ERROR(RestoreSession(run_options, bundle->meta_graph_def,
-                                    export_dir, &bundle->session));
+  TF_RETURN_IF_ERROR(RestoreSession(run_options, load_options,
+                                    bundle->meta_graph_def, export_dir,
+                                    &bundle->session));
   return Status::OK();
 }
 
@@ -273,12 +344,22 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle) {
+  return LoadSavedModel(session_options, run_options, SavedModelLoadOptions(),
+                        export_dir, tags, bundle);
+}
+
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options,
+                      const SavedModelLoadOptions& load_options,
+                      const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      SavedModelBundle* const bundle) {
   metrics::SavedModelReadApi(kCCLoadLabel).IncrementBy(1);
 
   // TODO(robson): Add tests for the counters.
   const uint64 start_microseconds = Env::Default()->NowMicros();
-  const Status status = LoadSavedModelInternal(session_options, run_options,
-                                               export_dir, tags, bundle);
+  const Status status = LoadSavedModelInternal(
+      session_options, run_options, load_options, export_dir, tags, bundle);
   auto log_and_count = [&](const string& status_str) {
     LOG(INFO) << "SavedModel load for tags { " << absl::StrJoin(tags, " ")
               << " }; Status: " << status_str << ": " << status << ". Took "
@@ -407,11 +488,25 @@ class LiteSessionWrapper : public Session {
 Status RestoreSession(const RunOptions& run_options,
                       const MetaGraphDef& meta_graph, const string& export_dir,
                       std::unique_ptr<Session>* session) {
+  return RestoreSession(run_options, SavedModelLoadOptions(), meta_graph,
+                        export_dir, session);
+}
+
+Status RestoreSession(const RunOptions& run_options,
+                      const SavedModelLoadOptions& load_options,
+                      const MetaGraphDef& meta_graph, const string& export_dir,
+                      std::unique_ptr<Session>* session) {
   const uint64 read_start_microseconds = Env::Default()->NowMicros();
   std::vector<AssetFileDef> asset_file_defs;
   TF_RETURN_IF_ERROR(internal::GetAssetFileDefs(meta_graph, &asset_file_defs));
-  if (meta_graph.has_saver_def()) {
-    TF_RETURN_IF_ERROR(RunRestore(run_options, export_dir,
+  if (meta_graph.has_saver_def() &&
+      !load_options.memmapped_variables_package.empty()) {
+    TF_RETURN_IF_ERROR(RunMemmappedRestore(run_options, load_options,
+                                           meta_graph, export_dir,
+                                           asset_file_defs, session));
+  } else if (meta_graph.has_saver_def()) {
+    TF_RETURN_IF_ERROR(RunRestore(run_options, load_options,
+                                  meta_graph.graph_def(), export_dir,
                                   meta_graph.saver_def().restore_op_name(),
                                   meta_graph.saver_def().filename_tensor_name(),
                                   asset_file_defs, session->get()));
@@ -425,8 +520,9 @@ Status RestoreSession(const RunOptions& run_options,
   string init_op_name;
   TF_RETURN_IF_ERROR(
       internal::GetInitOp(export_dir, meta_graph, &init_op_name));
-  TF_RETURN_IF_ERROR(RunInitOp(run_options, export_dir, meta_graph,
-                               asset_file_defs, session->get(), init_op_name));
+  TF_RETURN_IF_ERROR(RunInitOp(run_options, load_options, export_dir,
+                               meta_graph, asset_file_defs, session->get(),
+                               init_op_name));
   load_latency_by_stage->GetCell(export_dir, "restore_graph")
       ->Add(restore_graph_walltime);
   // Record wall time spent in init op.
@@ -439,6 +535,16 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
                       SavedModelBundleLite* const bundle) {
+  return LoadSavedModel(session_options, run_options, SavedModelLoadOptions(),
+                        export_dir, tags, bundle);
+}
+
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options,
+                      const SavedModelLoadOptions& load_options,
+                      const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      SavedModelBundleLite* const bundle) {
   SavedModelBundle legacy_bundle;
   SessionOptions rewritten_options(session_options);
   // We disallow calls to Session::Extend() on the returned session, so we can
@@ -452,8 +558,9 @@ Status LoadSavedModel(const SessionOptions& session_options,
       ->set_disable_output_partition_graphs(true);
   // TODO(mrry): Consider specializing the session creation to reduce peak
   // RAM consumption by using `Session::Create(GraphDef&&)`.
-  TF_RETURN_IF_ERROR(LoadSavedModel(rewritten_options, run_options, export_dir,
-                                    tags, &legacy_bundle));
+  TF_RETURN_IF_ERROR(LoadSavedModel(rewritten_options, run_options,
+                                    load_options, export_dir, tags,
+                                    &legacy_bundle));
   *bundle = SavedModelBundleLite(
       absl::make_unique<LiteSessionWrapper>(std::move(legacy_bundle.session)),
       std::move(*legacy_bundle.meta_graph_def.mutable_signature_def()));
@@ -97,6 +97,23 @@ class SavedModelBundleLite : public SavedModelBundleInterface {
   protobuf::Map<string, SignatureDef> signatures_;
 };
 
+/// Options of LoadSavedModel() that aren't options of the session or the runs.
+struct SavedModelLoadOptions {
+  /// The number of threads that run the independent parts of the restore op
+  /// and of the init op concurrently, e.g. the restore ops of the shards of a
+  /// sharded saver or the initializers of the lookup tables, at most this many
+  /// at a time to bound the memory they use. The ops are run as a whole if
+  /// this is 1 or if their parts share stateful ops.
+  int num_load_threads = 1;
+
+  /// If not empty, the memmapped package, written by
+  /// ConvertSavedModelVariablesToMemmapped() from the same SavedModel, from
+  /// which the variables are restored instead of from the variables
+  /// directory. The variables are then backed by the read-only mapping of the
+  /// package, which the processes that load it share.
+  std::string memmapped_variables_package;
+};
+
 // Restore variable and resources in the SavedModel export dir for the
 // indicated metagraph.
 // The recommended way to load a saved model is to call LoadSavedModel,
@@ -105,6 +122,12 @@ Status RestoreSession(const RunOptions& run_options,
                       const MetaGraphDef& meta_graph, const string& export_dir,
                       std::unique_ptr<Session>* session);
 
+// Like RestoreSession() above, with the given `load_options`.
+Status RestoreSession(const RunOptions& run_options,
+                      const SavedModelLoadOptions& load_options,
+                      const MetaGraphDef& meta_graph, const string& export_dir,
+                      std::unique_ptr<Session>* session);
+
 // Initialize a session which wraps this metagraph.
 // The recommended way to load a saved model is to call LoadSavedModel,
 // which provides an already initialized Metagraph, Session, and DebugInfo.
@@ -135,6 +158,20 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const std::unordered_set<string>& tags,
                       SavedModelBundleLite* const bundle);
 
+/// Like the LoadSavedModel() overloads above, with the given `load_options`.
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options,
+                      const SavedModelLoadOptions& load_options,
+                      const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      SavedModelBundle* const bundle);
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options,
+                      const SavedModelLoadOptions& load_options,
+                      const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      SavedModelBundleLite* const bundle);
+
 /// Checks whether the provided directory could contain a SavedModel. Note that
 /// the method does not load any data by itself. If the method returns `false`,
 /// the export directory definitely does not contain a SavedModel. If the method
@@ -17,13 +17,48 @@ limitations under the License.
 
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_def.pb.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/protobuf_internal.h"
 
 namespace tensorflow {
 namespace internal {
+namespace {
+
+// Returns true if `node` is a NoOp that only groups its control inputs.
+bool IsGroupingNoOp(const NodeDef& node) {
+  if (node.op() != "NoOp") return false;
+  for (const string& input : node.input()) {
+    if (!absl::StartsWith(input, "^")) return false;
+  }
+  return true;
+}
+
+// Functions and unknown ops are assumed to be stateful.
+bool IsStateful(const NodeDef& node) {
+  const OpDef* op_def;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok()) {
+    return true;
+  }
+  return op_def->is_stateful();
+}
+
+// Returns the name of the node of an input, e.g. "x" for "^x" or "x:1".
+absl::string_view InputNodeName(absl::string_view input) {
+  if (absl::StartsWith(input, "^")) return input.substr(1);
+  return input.substr(0, input.rfind(':'));
+}
+
+}  // namespace
+
 
 // A SavedModel may store the name of the initialization op to run in the
 // in the SignatureDef (v2) or a collection (v1). If an init_op collection
@@ -91,5 +126,50 @@ Status GetAssetFileDefs(const MetaGraphDef& meta_graph_def,
   return Status::OK();
 }
 
+std::vector<string> GetIndependentTargets(const GraphDef& graph_def,
+                                          const string& op_name) {
+  absl::flat_hash_map<absl::string_view, const NodeDef*> nodes;
+  for (const NodeDef& node : graph_def.node()) {
+    nodes[node.name()] = &node;
+  }
+  // Look through groups of a single op, e.g. the group of the tables
+  // initializer that a legacy init op may be.
+  auto group_it = nodes.find(op_name);
+  while (group_it != nodes.end() && IsGroupingNoOp(*group_it->second) &&
+         group_it->second->input_size() == 1) {
+    group_it = nodes.find(InputNodeName(group_it->second->input(0)));
+  }
+  if (group_it == nodes.end() || !IsGroupingNoOp(*group_it->second) ||
+      group_it->second->input_size() < 2) {
+    return {op_name};
+  }
+
+  // The index of the target that runs each stateful op.
+  absl::flat_hash_map<absl::string_view, int> stateful_op_targets;
+  std::vector<string> targets;
+  for (const string& target_input : group_it->second->input()) {
+    const int target = targets.size();
+    targets.emplace_back(InputNodeName(target_input));
+    absl::flat_hash_set<absl::string_view> visited;
+    std::vector<absl::string_view> stack = {InputNodeName(target_input)};
+    while (!stack.empty()) {
+      const absl::string_view name = stack.back();
+      stack.pop_back();
+      if (!visited.insert(name).second) continue;
+      const auto node_it = nodes.find(name);
+      if (node_it == nodes.end()) return {op_name};
+      const NodeDef& node = *node_it->second;
+      if (IsStateful(node) &&
+          !stateful_op_targets.emplace(name, target).second) {
+        return {op_name};
+      }
+      for (const string& input : node.input()) {
+        stack.push_back(InputNodeName(input));
+      }
+    }
+  }
+  return targets;
+}
+
 }  // namespace internal
 }  // namespace tensorflow
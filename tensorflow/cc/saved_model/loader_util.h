@@ -17,7 +17,9 @@ limitations under the License.
 #define TENSORFLOW_CC_SAVED_MODEL_LOADER_UTIL_H_
 
 #include <string>
+#include <vector>
 
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 
@@ -33,6 +35,13 @@ Status GetInitOp(const string& export_dir, const MetaGraphDef& meta_graph_def,
 Status GetAssetFileDefs(const MetaGraphDef& meta_graph_def,
                         std::vector<AssetFileDef>* asset_file_defs);
 
+// Returns the ops that can be run concurrently instead of `op_name`: the
+// control inputs of the NoOp that groups them, e.g. the restore ops of the
+// shards of a sharded saver or the table initializers of an init op, if none
+// of them shares a stateful op with another. Otherwise returns `op_name`.
+std::vector<string> GetIndependentTargets(const GraphDef& graph_def,
+                                          const string& op_name);
+
 }  // namespace internal
 }  // namespace tensorflow
 
@@ -0,0 +1,407 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/memmapped_variables.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/protobuf/tensor_bundle.pb.h"
+#include "tensorflow/core/util/memmapped_file_system.h"
+#include "tensorflow/core/util/memmapped_file_system_writer.h"
+#include "tensorflow/core/util/saved_tensor_slice_util.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+
+const char kMemmappedVariablesElement[] =
+    "memmapped_package://saved_model_variables";
+
+namespace {
+
+string VariableElement(int64_t index) {
+  return strings::StrCat(MemmappedFileSystem::kMemmappedPackagePrefix,
+                         "saved_model_variable_", index);
+}
+
+string VariableInfoElement(int64_t index) {
+  return strings::StrCat(VariableElement(index), ".info");
+}
+
+// The buffer of a variable backed by a memmapped package, which it keeps
+// mapped.
+class MemmappedVariableBuffer : public TensorBuffer {
+ public:
+  MemmappedVariableBuffer(std::shared_ptr<MemmappedFileSystem> file_system,
+                          std::unique_ptr<ReadOnlyMemoryRegion> region)
+      : TensorBuffer(const_cast<void*>(region->data())),
+        file_system_(std::move(file_system)),
+        region_(std::move(region)) {}
+
+  size_t size() const override { return region_->length(); }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size());
+    proto->set_allocator_name("MemmappedVariables");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<MemmappedFileSystem> file_system_;
+  const std::unique_ptr<ReadOnlyMemoryRegion> region_;
+};
+
+Status ReadTensorProto(MemmappedFileSystem* file_system,
+                       const string& element, TensorProto* proto) {
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  TF_RETURN_IF_ERROR(
+      file_system->NewReadOnlyMemoryRegionFromFile(element, &region));
+  if (!proto->ParseFromArray(region->data(), region->length())) {
+    return errors::DataLoss("Can't parse ", element,
+                            " as a TensorProto in the memmapped package");
+  }
+  return Status::OK();
+}
+
+// Sets `val` to the value of the Const node that is the input `index` of
+// `node`.
+Status GetConstInput(
+    const std::unordered_map<string, const NodeDef*>& nodes_by_name,
+    const NodeDef& node, int index, Tensor* val) {
+  if (node.input_size() <= index) {
+    return errors::InvalidArgument("Node ", node.name(), " has ",
+                                   node.input_size(), " inputs, expected ",
+                                   index + 1);
+  }
+  const auto it =
+      nodes_by_name.find(string(ParseTensorName(node.input(index)).node()));
+  if (it == nodes_by_name.end() || it->second->op() != "Const" ||
+      !it->second->attr().count("value")) {
+    return errors::Unimplemented("Input ", index, " of ", node.name(),
+                                 " is not a Const, so it can't be restored ",
+                                 "from a memmapped package");
+  }
+  if (!val->FromProto(it->second->attr().at("value").tensor())) {
+    return errors::InvalidArgument("Invalid value of ", it->second->name());
+  }
+  return Status::OK();
+}
+
+// Forwards to a session, and keeps the variables it was restored from until
+// the session is destroyed.
+class MemmappedVariablesSession : public Session {
+ public:
+  MemmappedVariablesSession(std::unique_ptr<Session> wrapped,
+                            std::unique_ptr<MemmappedVariables> variables)
+      : variables_(std::move(variables)), wrapped_(std::move(wrapped)) {}
+
+  Status Create(const GraphDef& graph) override {
+    return wrapped_->Create(graph);
+  }
+  Status Create(GraphDef&& graph) override {
+    return wrapped_->Create(std::move(graph));
+  }
+  Status Extend(const GraphDef& graph) override {
+    return wrapped_->Extend(graph);
+  }
+  Status Extend(GraphDef&& graph) override {
+    return wrapped_->Extend(std::move(graph));
+  }
+  Status Create(const RunOptions& run_options, const GraphDef& graph) override {
+    return wrapped_->Create(run_options, graph);
+  }
+  Status Extend(const RunOptions& run_options, const GraphDef& graph) override {
+    return wrapped_->Extend(run_options, graph);
+  }
+  Status Create(const RunOptions& run_options, GraphDef&& graph) override {
+    return wrapped_->Create(run_options, std::move(graph));
+  }
+  Status Extend(const RunOptions& run_options, GraphDef&& graph) override {
+    return wrapped_->Extend(run_options, std::move(graph));
+  }
+
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override {
+    return wrapped_->Run(inputs, output_tensor_names, target_node_names,
+                         outputs);
+  }
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override {
+    return wrapped_->Run(run_options, inputs, output_tensor_names,
+                         target_node_names, outputs, run_metadata);
+  }
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions& threadpool_options) override {
+    return wrapped_->Run(run_options, inputs, output_tensor_names,
+                         target_node_names, outputs, run_metadata,
+                         threadpool_options);
+  }
+
+  Status PRunSetup(const std::vector<string>& input_names,
+                   const std::vector<string>& output_names,
+                   const std::vector<string>& target_nodes,
+                   string* handle) override {
+    return wrapped_->PRunSetup(input_names, output_names, target_nodes,
+                               handle);
+  }
+  Status PRun(const string& handle,
+              const std::vector<std::pair<string, Tensor>>& inputs,
+              const std::vector<string>& output_names,
+              std::vector<Tensor>* outputs) override {
+    return wrapped_->PRun(handle, inputs, output_names, outputs);
+  }
+
+  Status ListDevices(std::vector<DeviceAttributes>* response) override {
+    return wrapped_->ListDevices(response);
+  }
+  Status LocalDeviceManager(const DeviceMgr** output) override {
+    return wrapped_->LocalDeviceManager(output);
+  }
+
+  Status Close() override { return wrapped_->Close(); }
+  Status Close(const RunOptions& run_options) override {
+    return wrapped_->Close(run_options);
+  }
+
+  Status MakeCallable(const CallableOptions& callable_options,
+                      CallableHandle* out_handle) override {
+    return wrapped_->MakeCallable(callable_options, out_handle);
+  }
+  Status RunCallable(CallableHandle handle,
+                     const std::vector<Tensor>& feed_tensors,
+                     std::vector<Tensor>* fetch_tensors,
+                     RunMetadata* run_metadata) override {
+    return wrapped_->RunCallable(handle, feed_tensors, fetch_tensors,
+                                 run_metadata);
+  }
+  Status RunCallable(
+      CallableHandle handle, const std::vector<Tensor>& feed_tensors,
+      std::vector<Tensor>* fetch_tensors, RunMetadata* run_metadata,
+      const thread::ThreadPoolOptions& threadpool_options) override {
+    return wrapped_->RunCallable(handle, feed_tensors, fetch_tensors,
+                                 run_metadata, threadpool_options);
+  }
+  Status ReleaseCallable(CallableHandle handle) override {
+    return wrapped_->ReleaseCallable(handle);
+  }
+
+  Status Finalize() override { return wrapped_->Finalize(); }
+
+ private:
+  // Declared first, so that it is destroyed after the session.
+  const std::unique_ptr<MemmappedVariables> variables_;
+  const std::unique_ptr<Session> wrapped_;
+};
+
+}  // namespace
+
+Status ConvertSavedModelVariablesToMemmapped(Env* env,
+                                             const string& export_dir,
+                                             const string& package_filename) {
+  BundleReader reader(
+      env, io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                        kSavedModelVariablesFilename));
+  TF_RETURN_IF_ERROR(reader.status());
+
+  // The keys of the variables, without those of the slices of partitioned
+  // variables, which are looked up whole.
+  std::vector<string> keys;
+  std::unordered_set<string> slice_keys;
+  BundleEntryProto entry;
+  reader.Seek(kHeaderEntryKey);
+  for (reader.Next(); reader.Valid(); reader.Next()) {
+    if (!entry.ParseFromArray(reader.value().data(), reader.value().size())) {
+      return errors::DataLoss("Can't parse the entry of ", reader.key(),
+                              " in the variables of ", export_dir);
+    }
+    for (const TensorSliceProto& slice : entry.slices()) {
+      slice_keys.insert(checkpoint::EncodeTensorNameSlice(
+          string(reader.key()), TensorSlice(slice)));
+    }
+    keys.emplace_back(reader.key());
+  }
+
+  MemmappedFileSystemWriter writer;
+  TF_RETURN_IF_ERROR(writer.InitializeToFile(env, package_filename));
+  std::vector<tstring> variable_keys;
+  for (const string& key : keys) {
+    if (slice_keys.count(key)) continue;
+    Tensor val;
+    TF_RETURN_IF_ERROR(reader.Lookup(key, &val));
+    const int64_t index = variable_keys.size();
+    TensorProto info;
+    if (DataTypeCanUseMemcpy(val.dtype())) {
+      info.set_dtype(val.dtype());
+      val.shape().AsProto(info.mutable_tensor_shape());
+      if (val.TotalBytes() > 0) {
+        TF_RETURN_IF_ERROR(writer.SaveTensor(val, VariableElement(index)));
+      }
+    } else {
+      val.AsProtoField(&info);
+    }
+    TF_RETURN_IF_ERROR(writer.SaveProtobuf(info, VariableInfoElement(index)));
+    variable_keys.push_back(key);
+  }
+
+  Tensor keys_tensor(DT_STRING,
+                     TensorShape({static_cast<int64_t>(variable_keys.size())}));
+  std::copy(variable_keys.begin(), variable_keys.end(),
+            keys_tensor.flat<tstring>().data());
+  TensorProto keys_proto;
+  keys_tensor.AsProtoField(&keys_proto);
+  TF_RETURN_IF_ERROR(
+      writer.SaveProtobuf(keys_proto, kMemmappedVariablesElement));
+  return writer.FlushAndClose();
+}
+
+Status MemmappedVariables::Load(
+    Env* env, const string& package_filename,
+    std::unique_ptr<MemmappedVariables>* variables) {
+  auto file_system = std::make_shared<MemmappedFileSystem>();
+  TF_RETURN_IF_ERROR(file_system->InitializeFromFile(env, package_filename));
+  TensorProto keys_proto;
+  TF_RETURN_IF_ERROR(ReadTensorProto(file_system.get(),
+                                     kMemmappedVariablesElement, &keys_proto));
+  Tensor keys;
+  if (keys_proto.dtype() != DT_STRING || !keys.FromProto(keys_proto) ||
+      keys.dims() != 1) {
+    return errors::DataLoss("Invalid list of variables in ",
+                            package_filename);
+  }
+
+  std::unique_ptr<MemmappedVariables> result(new MemmappedVariables);
+  for (int64_t index = 0; index < keys.NumElements(); ++index) {
+    const string key(keys.vec<tstring>()(index));
+    TensorProto info;
+    TF_RETURN_IF_ERROR(ReadTensorProto(file_system.get(),
+                                       VariableInfoElement(index), &info));
+    Tensor val;
+    if (DataTypeCanUseMemcpy(info.dtype()) &&
+        TensorShape::IsValid(info.tensor_shape())) {
+      const TensorShape shape(info.tensor_shape());
+      const uint64 num_bytes =
+          shape.num_elements() * DataTypeSize(info.dtype());
+      if (num_bytes == 0) {
+        val = Tensor(info.dtype(), shape);
+      } else {
+        std::unique_ptr<ReadOnlyMemoryRegion> region;
+        TF_RETURN_IF_ERROR(file_system->NewReadOnlyMemoryRegionFromFile(
+            VariableElement(index), &region));
+        if (region->length() != num_bytes) {
+          return errors::DataLoss("Variable ", key, " in ", package_filename,
+                                  " has ", region->length(),
+                                  " bytes, expected ", num_bytes);
+        }
+        val = Tensor(
+            info.dtype(), shape,
+            core::RefCountPtr<TensorBuffer>(
+                new MemmappedVariableBuffer(file_system, std::move(region))));
+        if (!val.IsAligned()) {
+          return errors::DataLoss("Variable ", key, " is not aligned in ",
+                                  package_filename);
+        }
+      }
+    } else if (!val.FromProto(info)) {
+      return errors::DataLoss("Invalid variable ", key, " in ",
+                              package_filename);
+    }
+    result->variables_.emplace(key, std::move(val));
+  }
+  *variables = std::move(result);
+  return Status::OK();
+}
+
+Status MemmappedVariables::Lookup(const string& key, Tensor* val) const {
+  const auto it = variables_.find(key);
+  if (it == variables_.end()) {
+    return errors::NotFound("Variable ", key,
+                            " is not in the memmapped package");
+  }
+  *val = it->second;
+  return Status::OK();
+}
+
+Status MemmappedVariables::AddRestoreInputs(
+    const GraphDef& graph_def, const string& filename_tensor_name,
+    std::vector<std::pair<string, Tensor>>* inputs) const {
+  std::unordered_map<string, const NodeDef*> nodes_by_name;
+  for (const NodeDef& node : graph_def.node()) {
+    nodes_by_name.emplace(node.name(), &node);
+  }
+  const TensorId filename_tensor = ParseTensorName(filename_tensor_name);
+  bool found_restore_op = false;
+  for (const NodeDef& node : graph_def.node()) {
+    if (node.op() != "RestoreV2" || node.input_size() == 0 ||
+        ParseTensorName(node.input(0)) != filename_tensor) {
+      continue;
+    }
+    found_restore_op = true;
+    Tensor tensor_names;
+    Tensor shape_and_slices;
+    TF_RETURN_IF_ERROR(GetConstInput(nodes_by_name, node, 1, &tensor_names));
+    TF_RETURN_IF_ERROR(
+        GetConstInput(nodes_by_name, node, 2, &shape_and_slices));
+    if (tensor_names.dtype() != DT_STRING ||
+        shape_and_slices.dtype() != DT_STRING ||
+        tensor_names.NumElements() != shape_and_slices.NumElements()) {
+      return errors::InvalidArgument("Invalid inputs of ", node.name());
+    }
+    for (int64_t i = 0; i < tensor_names.NumElements(); ++i) {
+      if (!shape_and_slices.flat<tstring>()(i).empty()) {
+        return errors::Unimplemented(
+            "Restoring the slice ", shape_and_slices.flat<tstring>()(i),
+            " of ", tensor_names.flat<tstring>()(i),
+            " from a memmapped package is not supported");
+      }
+      Tensor val;
+      TF_RETURN_IF_ERROR(Lookup(tensor_names.flat<tstring>()(i), &val));
+      inputs->emplace_back(strings::StrCat(node.name(), ":", i),
+                           std::move(val));
+    }
+  }
+  if (!found_restore_op) {
+    return errors::Unimplemented(
+        "The graph has no RestoreV2 op reading ", filename_tensor_name,
+        ", so its variables can't be restored from a memmapped package");
+  }
+  return Status::OK();
+}
+
+std::unique_ptr<Session> WrapSessionWithMemmappedVariables(
+    std::unique_ptr<Session> session,
+    std::unique_ptr<MemmappedVariables> variables) {
+  return std::unique_ptr<Session>(
+      new MemmappedVariablesSession(std::move(session), std::move(variables)));
+}
+
+}  // namespace tensorflow
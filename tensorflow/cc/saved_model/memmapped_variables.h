@@ -0,0 +1,97 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Packages the variables of a SavedModel into a memmapped package (see
+// MemmappedFileSystem), from which LoadSavedModel() restores them when
+// SavedModelLoadOptions::memmapped_variables_package is set.
+//
+// The restored variables are backed by the read-only mapping of the package,
+// so that the processes that load the same model share its pages in the page
+// cache instead of each holding a copy of the variables. MemmappedVariables
+// keeps a reference to each mapped tensor, so resource variables copy their
+// tensor on their first in-place update, as for any shared tensor; ref
+// variables are copied when they are restored.
+
+#ifndef TENSORFLOW_CC_SAVED_MODEL_MEMMAPPED_VARIABLES_H_
+#define TENSORFLOW_CC_SAVED_MODEL_MEMMAPPED_VARIABLES_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+
+// The element of the package that lists the checkpoint keys of the
+// variables, as a TensorProto of strings. The variable listed at index i has
+// its dtype and shape in the TensorProto element
+// "memmapped_package://saved_model_variable_<i>.info", which also holds the
+// value of string variables, and the data of others in the aligned element
+// "memmapped_package://saved_model_variable_<i>".
+extern const char kMemmappedVariablesElement[];
+
+// Writes the variables of the SavedModel in `export_dir` to the memmapped
+// package `package_filename`. Partitioned variables are written whole.
+Status ConvertSavedModelVariablesToMemmapped(Env* env,
+                                             const string& export_dir,
+                                             const string& package_filename);
+
+// The variables of a memmapped package, keyed by their checkpoint keys.
+class MemmappedVariables {
+ public:
+  // Maps the package `package_filename`, which stays mapped until this and
+  // the tensors of its variables are destroyed.
+  static Status Load(Env* env, const string& package_filename,
+                     std::unique_ptr<MemmappedVariables>* variables);
+
+  // Sets `val` to the variable keyed by `key`, which is read-only.
+  Status Lookup(const string& key, Tensor* val) const;
+
+  // Adds to `inputs` the outputs of the RestoreV2 ops of `graph_def` that read
+  // the checkpoint named by `filename_tensor_name`, fed with the variables
+  // they restore, so that running the restore op of the graph with `inputs`
+  // restores the variables without reading the checkpoint.
+  Status AddRestoreInputs(
+      const GraphDef& graph_def, const string& filename_tensor_name,
+      std::vector<std::pair<string, Tensor>>* inputs) const;
+
+  size_t size() const { return variables_.size(); }
+
+ private:
+  MemmappedVariables() = default;
+
+  std::unordered_map<string, Tensor> variables_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemmappedVariables);
+};
+
+// Returns a session that forwards to `session`, and that keeps `variables`
+// until `session` is destroyed, so that the variables restored from them are
+// never updated in place.
+std::unique_ptr<Session> WrapSessionWithMemmappedVariables(
+    std::unique_ptr<Session> session,
+    std::unique_ptr<MemmappedVariables> variables);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CC_SAVED_MODEL_MEMMAPPED_VARIABLES_H_
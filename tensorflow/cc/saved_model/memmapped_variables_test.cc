@@ -0,0 +1,159 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/memmapped_variables.h"
+
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/resource_variable_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kTestDataSharded[] =
+    "cc/saved_model/testdata/half_plus_two/00000123";
+
+string TestDataSharded() {
+  return io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+}
+
+string PackageFilename(const string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+TEST(MemmappedVariablesTest, LooksUpCheckpointedVariables) {
+  const string package = PackageFilename("half_plus_two_variables");
+  TF_ASSERT_OK(ConvertSavedModelVariablesToMemmapped(
+      Env::Default(), TestDataSharded(), package));
+  std::unique_ptr<MemmappedVariables> variables;
+  TF_ASSERT_OK(MemmappedVariables::Load(Env::Default(), package, &variables));
+
+  BundleReader reader(
+      Env::Default(), io::JoinPath(TestDataSharded(),
+                                   kSavedModelVariablesDirectory,
+                                   kSavedModelVariablesFilename));
+  TF_ASSERT_OK(reader.status());
+  int num_variables = 0;
+  reader.Seek(kHeaderEntryKey);
+  for (reader.Next(); reader.Valid(); reader.Next()) {
+    Tensor expected;
+    TF_ASSERT_OK(reader.ReadCurrent(&expected));
+    Tensor mapped;
+    TF_ASSERT_OK(variables->Lookup(string(reader.key()), &mapped));
+    test::ExpectTensorEqual<float>(mapped, expected);
+    ++num_variables;
+  }
+  EXPECT_GT(num_variables, 0);
+  EXPECT_EQ(variables->size(), num_variables);
+  Tensor missing;
+  EXPECT_TRUE(errors::IsNotFound(variables->Lookup("missing", &missing)));
+}
+
+TEST(MemmappedVariablesTest, LoadsSavedModel) {
+  const string package = PackageFilename("half_plus_two_loaded_variables");
+  TF_ASSERT_OK(ConvertSavedModelVariablesToMemmapped(
+      Env::Default(), TestDataSharded(), package));
+  SavedModelLoadOptions load_options;
+  load_options.memmapped_variables_package = package;
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), load_options,
+                              TestDataSharded(), {kSavedModelTagServe},
+                              &bundle));
+
+  const auto& signature_def = bundle.GetSignatures().at("regress_x_to_y");
+  std::vector<tstring> serialized_examples;
+  for (float x : {0, 1, 2, 3}) {
+    Example example;
+    (*example.mutable_features()->mutable_feature())["x"]
+        .mutable_float_list()
+        ->add_value(x);
+    serialized_examples.push_back(example.SerializeAsString());
+  }
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.session->Run(
+      {{signature_def.inputs().at(kRegressInputs).name(),
+        test::AsTensor<tstring>(serialized_examples, TensorShape({4}))}},
+      {signature_def.outputs().at(kRegressOutputs).name()}, {}, &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  test::ExpectTensorEqual<float>(
+      outputs[0], test::AsTensor<float>({2, 2.5, 3, 3.5}, TensorShape({4, 1})));
+}
+
+TEST(MemmappedVariablesTest, CopiesResourceVariablesOnUpdate) {
+  const string export_dir = io::JoinPath(testing::TmpDir(), "resource_vars");
+  const string variables_dir =
+      io::JoinPath(export_dir, kSavedModelVariablesDirectory);
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(variables_dir));
+  const string prefix =
+      io::JoinPath(variables_dir, kSavedModelVariablesFilename);
+  BundleWriter writer(Env::Default(), prefix);
+  TF_ASSERT_OK(writer.Add("v", test::AsTensor<float>({1, 2})));
+  TF_ASSERT_OK(writer.Finish());
+  const string package = PackageFilename("resource_vars_package");
+  TF_ASSERT_OK(ConvertSavedModelVariablesToMemmapped(Env::Default(),
+                                                     export_dir, package));
+  std::unique_ptr<MemmappedVariables> variables;
+  TF_ASSERT_OK(MemmappedVariables::Load(Env::Default(), package, &variables));
+  Tensor mapped;
+  TF_ASSERT_OK(variables->Lookup("v", &mapped));
+
+  Scope scope = Scope::NewRootScope();
+  auto filename = ops::Const(scope.WithOpName("filename"), string("unused"));
+  auto restore = ops::RestoreV2(scope.WithOpName("restore"), filename,
+                                test::AsTensor<tstring>({"v"}),
+                                test::AsTensor<tstring>({""}), {DT_FLOAT});
+  auto var = ops::VarHandleOp(scope.WithOpName("var"), DT_FLOAT,
+                              PartialTensorShape({2}));
+  auto assign = ops::AssignVariableOp(scope.WithOpName("assign"), var,
+                                      restore.tensors[0]);
+  auto update = ops::AssignAddVariableOp(scope.WithOpName("update"), var,
+                                         ops::Const(scope, {1.0f, 1.0f}));
+  auto read = ops::ReadVariableOp(scope.WithOpName("read"), var, DT_FLOAT);
+  GraphDef graph_def;
+  TF_ASSERT_OK(scope.ToGraphDef(&graph_def));
+
+  std::vector<std::pair<string, Tensor>> inputs;
+  TF_ASSERT_OK(variables->AddRestoreInputs(graph_def, "filename:0", &inputs));
+  ASSERT_EQ(inputs.size(), 1);
+  EXPECT_EQ(inputs[0].first, "restore:0");
+
+  std::unique_ptr<Session> session(NewSession(SessionOptions()));
+  TF_ASSERT_OK(session->Create(graph_def));
+  session = WrapSessionWithMemmappedVariables(std::move(session),
+                                              std::move(variables));
+  TF_ASSERT_OK(session->Run(inputs, {}, {"assign"}, nullptr));
+  inputs.clear();
+  TF_ASSERT_OK(session->Run({}, {}, {"update"}, nullptr));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {"read:0"}, {}, &outputs));
+  test::ExpectTensorEqual<float>(outputs[0], test::AsTensor<float>({2, 3}));
+  // The update wrote to a copy of the mapped tensor.
+  test::ExpectTensorEqual<float>(mapped, test::AsTensor<float>({1, 2}));
+  TF_ASSERT_OK(session->Close());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/cc/saved_model/loader_util.h"
 #include "tensorflow/cc/saved_model/metrics.h"
 #include "tensorflow/cc/saved_model/reader.h"
 #include "tensorflow/cc/saved_model/signature_constants.h"
@@ -26,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 
@@ -248,6 +250,48 @@ TEST_F(LoaderTest, MainOpFormat) {
   CheckSavedModelBundle(export_dir, bundle);
 }
 
+TEST_F(LoaderTest, ConcurrentLoad) {
+  SessionOptions session_options;
+  RunOptions run_options;
+  SavedModelLoadOptions load_options;
+  load_options.num_load_threads = 4;
+
+  for (const char* test_data : {kTestDataSharded, kTestDataMainOp}) {
+    SavedModelBundle bundle;
+    const string export_dir =
+        io::JoinPath(testing::TensorFlowSrcRoot(), test_data);
+    TF_ASSERT_OK(LoadSavedModel(session_options, run_options, load_options,
+                                export_dir, {kSavedModelTagServe}, &bundle));
+    CheckSavedModelBundle(export_dir, bundle);
+  }
+}
+
+TEST_F(LoaderTest, GetIndependentTargets) {
+  GraphDef graph_def;
+  ASSERT_TRUE(protobuf::TextFormat::ParseFromString(
+      R"pb(
+        node { name: "a" op: "VarHandleOp" }
+        node { name: "b" op: "VarHandleOp" }
+        node { name: "value" op: "Const" }
+        node { name: "init_a" op: "AssignVariableOp" input: [ "a", "value" ] }
+        node { name: "init_b" op: "AssignVariableOp" input: [ "b", "value" ] }
+        node { name: "init_ab" op: "NoOp" input: [ "^init_a", "^init_b" ] }
+        node { name: "init" op: "NoOp" input: "^init_ab" }
+        node { name: "init_a_b" op: "AssignVariableOp" input: [ "b", "a:0" ] }
+        node { name: "dependent" op: "NoOp" input: [ "^init_a", "^init_a_b" ] }
+      )pb",
+      &graph_def));
+
+  // Independent initializers run concurrently, also through a group of them.
+  EXPECT_EQ(internal::GetIndependentTargets(graph_def, "init"),
+            std::vector<string>({"init_a", "init_b"}));
+  // Initializers that share a variable run as a whole.
+  EXPECT_EQ(internal::GetIndependentTargets(graph_def, "dependent"),
+            std::vector<string>({"dependent"}));
+  EXPECT_EQ(internal::GetIndependentTargets(graph_def, "init_a"),
+            std::vector<string>({"init_a"}));
+}
+
 TEST_F(LoaderTest, InvalidExportPath) {
   SavedModelBundle bundle;
   RunOptions run_options;
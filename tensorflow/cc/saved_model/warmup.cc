@@ -0,0 +1,248 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/warmup.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <utility>
+
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+
+namespace tensorflow {
+namespace {
+
+// A run of a signature.
+struct WarmupRun {
+  string signature_name;
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names;
+  // Whether the inputs come from a warmup request, or from the SignatureDef.
+  bool recorded;
+};
+
+// Returns true if `key` is the signature of an op rather than of a function
+// of the model.
+bool IsOpSignature(const string& key) {
+  return key == kSavedModelInitOpSignatureKey ||
+         key == kSavedModelTrainOpSignatureKey;
+}
+
+std::vector<string> GetOutputNames(const SignatureDef& signature) {
+  std::vector<string> output_names;
+  for (const auto& key_and_output : signature.outputs()) {
+    output_names.push_back(key_and_output.second.name());
+  }
+  return output_names;
+}
+
+Status MakeRecordedRun(const protobuf::Map<string, SignatureDef>& signatures,
+                       const SavedModelWarmupRequest& request,
+                       WarmupRun* run) {
+  const auto signature_it = signatures.find(request.signature_name());
+  if (signature_it == signatures.end() ||
+      IsOpSignature(request.signature_name())) {
+    return errors::InvalidArgument("Warmup request for unknown signature \"",
+                                   request.signature_name(), "\"");
+  }
+  const SignatureDef& signature = signature_it->second;
+  run->signature_name = request.signature_name();
+  for (const auto& key_and_tensor : request.inputs()) {
+    const auto input_it = signature.inputs().find(key_and_tensor.first);
+    if (input_it == signature.inputs().end()) {
+      return errors::InvalidArgument("Warmup request for signature \"",
+                                     request.signature_name(),
+                                     "\" has unknown input \"",
+                                     key_and_tensor.first, "\"");
+    }
+    Tensor tensor;
+    if (!tensor.FromProto(key_and_tensor.second)) {
+      return errors::InvalidArgument("Warmup request for signature \"",
+                                     request.signature_name(),
+                                     "\" has an invalid tensor for input \"",
+                                     key_and_tensor.first, "\"");
+    }
+    run->inputs.emplace_back(input_it->second.name(), std::move(tensor));
+  }
+  run->output_names = GetOutputNames(signature);
+  run->recorded = true;
+  return Status::OK();
+}
+
+// Makes a run of `signature` with zero or empty inputs, of one element in
+// each unknown dimension. Returns false if the signature has inputs that
+// can't be made, e.g. composite ones or resources.
+bool MakeSignatureRun(const string& signature_name,
+                      const SignatureDef& signature, WarmupRun* run) {
+  run->signature_name = signature_name;
+  for (const auto& key_and_input : signature.inputs()) {
+    const TensorInfo& info = key_and_input.second;
+    if (info.encoding_case() != TensorInfo::kName ||
+        (!DataTypeCanUseMemcpy(info.dtype()) && info.dtype() != DT_STRING)) {
+      return false;
+    }
+    TensorShape shape;
+    if (!info.tensor_shape().unknown_rank()) {
+      for (const auto& dim : info.tensor_shape().dim()) {
+        shape.AddDim(std::max<int64_t>(dim.size(), 1));
+      }
+    }
+    Tensor tensor(info.dtype(), shape);
+    if (info.dtype() != DT_STRING) {
+      StringPiece data = tensor.tensor_data();
+      std::memset(const_cast<char*>(data.data()), 0, data.size());
+    }
+    run->inputs.emplace_back(info.name(), std::move(tensor));
+  }
+  run->output_names = GetOutputNames(signature);
+  run->recorded = false;
+  return true;
+}
+
+}  // namespace
+
+Status ReadSavedModelWarmupRequests(
+    const string& export_dir, int max_num_requests,
+    std::vector<SavedModelWarmupRequest>* requests) {
+  const string path = io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                                   kSavedModelWarmupRequestsFilename);
+  if (!Env::Default()->FileExists(path).ok()) return Status::OK();
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(path, &file));
+  io::RecordReader reader(file.get());
+  uint64 offset = 0;
+  tstring record;
+  for (int i = 0; i < max_num_requests; ++i) {
+    const Status status = reader.ReadRecord(&offset, &record);
+    if (errors::IsOutOfRange(status)) break;
+    TF_RETURN_IF_ERROR(status);
+    SavedModelWarmupRequest request;
+    if (!request.ParseFromString(record)) {
+      return errors::DataLoss("Invalid warmup request at offset ", offset,
+                              " of ", path);
+    }
+    requests->push_back(std::move(request));
+  }
+  return Status::OK();
+}
+
+Status WarmupSavedModel(const SavedModelBundleInterface& bundle,
+                        const std::vector<SavedModelWarmupRequest>& requests,
+                        const SavedModelWarmupOptions& options,
+                        std::map<string, SignatureWarmupStats>* stats) {
+  const protobuf::Map<string, SignatureDef>& signatures =
+      bundle.GetSignatures();
+  std::vector<WarmupRun> runs;
+  std::set<string> recorded_signatures;
+  for (const SavedModelWarmupRequest& request : requests) {
+    WarmupRun run;
+    TF_RETURN_IF_ERROR(MakeRecordedRun(signatures, request, &run));
+    recorded_signatures.insert(run.signature_name);
+    for (int i = 1; i < request.num_replays(); ++i) runs.push_back(run);
+    runs.push_back(std::move(run));
+  }
+  if (options.warmup_all_signatures) {
+    for (const auto& name_and_signature : signatures) {
+      if (IsOpSignature(name_and_signature.first) ||
+          recorded_signatures.count(name_and_signature.first) > 0) {
+        continue;
+      }
+      WarmupRun run;
+      if (MakeSignatureRun(name_and_signature.first,
+                           name_and_signature.second, &run)) {
+        runs.push_back(std::move(run));
+      } else {
+        VLOG(1) << "Can't make inputs to warm up signature "
+                << name_and_signature.first;
+      }
+    }
+  }
+  if (runs.empty()) return Status::OK();
+
+  LOG(INFO) << "Warming up SavedModel with " << runs.size() << " runs.";
+  mutex mu;
+  std::map<string, SignatureWarmupStats> run_stats;
+  Status status;
+  {
+    thread::ThreadPool pool(
+        Env::Default(), "saved_model_warmup",
+        std::max(1, std::min<int>(options.num_threads, runs.size())));
+    for (const WarmupRun& run : runs) {
+      pool.Schedule([&bundle, &run, &mu, &run_stats, &status]() {
+        const uint64 start_micros = Env::Default()->NowMicros();
+        std::vector<Tensor> outputs;
+        const Status run_status = bundle.GetSession()->Run(
+            run.inputs, run.output_names, {}, &outputs);
+        const int64_t micros = Env::Default()->NowMicros() - start_micros;
+
+        mutex_lock l(mu);
+        SignatureWarmupStats& signature_stats = run_stats[run.signature_name];
+        ++signature_stats.num_runs;
+        signature_stats.total_micros += micros;
+        signature_stats.max_micros =
+            std::max(signature_stats.max_micros, micros);
+        if (run_status.ok()) return;
+        ++signature_stats.num_failed_runs;
+        if (run.recorded) {
+          status.Update(run_status);
+        } else {
+          LOG(WARNING) << "Warmup of signature " << run.signature_name
+                       << " failed: " << run_status;
+        }
+      });
+    }
+  }
+
+  for (const auto& name_and_stats : run_stats) {
+    const SignatureWarmupStats& signature_stats = name_and_stats.second;
+    LOG(INFO) << "Warmed up signature " << name_and_stats.first << " with "
+              << signature_stats.num_runs << " runs in "
+              << signature_stats.total_micros << " microseconds, at most "
+              << signature_stats.max_micros << " per run.";
+    if (stats == nullptr) continue;
+    SignatureWarmupStats& total = (*stats)[name_and_stats.first];
+    total.num_runs += signature_stats.num_runs;
+    total.num_failed_runs += signature_stats.num_failed_runs;
+    total.total_micros += signature_stats.total_micros;
+    total.max_micros = std::max(total.max_micros, signature_stats.max_micros);
+  }
+  return status;
+}
+
+Status WarmupSavedModel(const SavedModelBundleInterface& bundle,
+                        const string& export_dir,
+                        const SavedModelWarmupOptions& options,
+                        std::map<string, SignatureWarmupStats>* stats) {
+  std::vector<SavedModelWarmupRequest> requests;
+  TF_RETURN_IF_ERROR(ReadSavedModelWarmupRequests(
+      export_dir, options.max_num_requests, &requests));
+  return WarmupSavedModel(bundle, requests, options, stats);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,82 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+/// Functions to warm up a loaded SavedModel before it serves requests.
+
+#ifndef TENSORFLOW_CC_SAVED_MODEL_WARMUP_H_
+#define TENSORFLOW_CC_SAVED_MODEL_WARMUP_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/saved_model_warmup.pb.h"
+
+namespace tensorflow {
+
+struct SavedModelWarmupOptions {
+  /// The number of threads that run the warmup requests concurrently.
+  int num_threads = 1;
+
+  /// If true, each signature without warmup requests is also run once, with
+  /// zero or empty inputs of one element in each unknown dimension, so that
+  /// its kernels are compiled and autotuned before the first requests.
+  /// Failures of these runs are only logged.
+  bool warmup_all_signatures = true;
+
+  /// The requests after this many in the warmup file are ignored.
+  int max_num_requests = 1000;
+};
+
+/// The warmup runs of a signature, and their latency.
+struct SignatureWarmupStats {
+  int64_t num_runs = 0;
+  int64_t num_failed_runs = 0;
+  int64_t total_micros = 0;
+  int64_t max_micros = 0;
+};
+
+/// Reads up to `max_num_requests` warmup requests from the
+/// assets.extra/tf_saved_model_warmup_requests TFRecord file of the SavedModel
+/// in `export_dir`, if it has one.
+Status ReadSavedModelWarmupRequests(
+    const string& export_dir, int max_num_requests,
+    std::vector<SavedModelWarmupRequest>* requests);
+
+/// Runs the signatures of `bundle` with the inputs of `requests`, and the
+/// other signatures if `options.warmup_all_signatures`. The runs feed and
+/// fetch all the inputs and outputs of the signatures, so that the executors
+/// they create are reused by the requests that do the same. Adds the stats of
+/// the runs to `stats`, by signature name, if it isn't null.
+///
+/// Returns an error if a warmup request is invalid or fails, after all the
+/// runs are done.
+Status WarmupSavedModel(const SavedModelBundleInterface& bundle,
+                        const std::vector<SavedModelWarmupRequest>& requests,
+                        const SavedModelWarmupOptions& options,
+                        std::map<string, SignatureWarmupStats>* stats);
+
+/// Like WarmupSavedModel() above, with the warmup requests of the SavedModel
+/// in `export_dir`.
+Status WarmupSavedModel(const SavedModelBundleInterface& bundle,
+                        const string& export_dir,
+                        const SavedModelWarmupOptions& options,
+                        std::map<string, SignatureWarmupStats>* stats);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CC_SAVED_MODEL_WARMUP_H_
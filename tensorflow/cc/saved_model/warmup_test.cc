@@ -0,0 +1,142 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/warmup.h"
+
+#include <memory>
+
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kTestData[] = "cc/saved_model/testdata/half_plus_two/00000123";
+
+class WarmupTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(),
+                                io::JoinPath(testing::TensorFlowSrcRoot(),
+                                             kTestData),
+                                {kSavedModelTagServe}, &bundle_));
+  }
+
+  SavedModelWarmupRequest MakeRegressRequest() {
+    Example example;
+    (*example.mutable_features()->mutable_feature())["x"]
+        .mutable_float_list()
+        ->add_value(1);
+    SavedModelWarmupRequest request;
+    request.set_signature_name("regress_x_to_y");
+    test::AsTensor<tstring>({example.SerializeAsString()}, TensorShape({1}))
+        .AsProtoTensorContent(&(*request.mutable_inputs())[kRegressInputs]);
+    return request;
+  }
+
+  SavedModelBundleLite bundle_;
+};
+
+TEST_F(WarmupTest, ReplaysRequestsAndRunsAllSignatures) {
+  SavedModelWarmupRequest request = MakeRegressRequest();
+  request.set_num_replays(3);
+  SavedModelWarmupOptions options;
+  options.num_threads = 4;
+  std::map<string, SignatureWarmupStats> stats;
+  TF_ASSERT_OK(WarmupSavedModel(bundle_, {request}, options, &stats));
+
+  EXPECT_EQ(stats["regress_x_to_y"].num_runs, 3);
+  EXPECT_EQ(stats["regress_x_to_y"].num_failed_runs, 0);
+  EXPECT_LE(stats["regress_x_to_y"].max_micros,
+            stats["regress_x_to_y"].total_micros);
+  // The signatures without requests run with inputs made from their shapes.
+  EXPECT_EQ(stats["serving_default"].num_runs, 1);
+  EXPECT_EQ(stats["serving_default"].num_failed_runs, 0);
+  EXPECT_EQ(stats.size(), bundle_.GetSignatures().size());
+}
+
+TEST_F(WarmupTest, OnlyReplaysRequests) {
+  SavedModelWarmupOptions options;
+  options.warmup_all_signatures = false;
+  std::map<string, SignatureWarmupStats> stats;
+  TF_ASSERT_OK(
+      WarmupSavedModel(bundle_, {MakeRegressRequest()}, options, &stats));
+  EXPECT_EQ(stats.size(), 1);
+  EXPECT_EQ(stats["regress_x_to_y"].num_runs, 1);
+}
+
+TEST_F(WarmupTest, RejectsInvalidRequests) {
+  SavedModelWarmupRequest request = MakeRegressRequest();
+  request.set_signature_name("unknown");
+  Status status = WarmupSavedModel(bundle_, {request},
+                                   SavedModelWarmupOptions(), nullptr);
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+
+  request = MakeRegressRequest();
+  (*request.mutable_inputs())["unknown"];
+  status = WarmupSavedModel(bundle_, {request}, SavedModelWarmupOptions(),
+                            nullptr);
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+TEST_F(WarmupTest, ReadsWarmupRequests) {
+  const string export_dir = io::JoinPath(testing::TmpDir(), "warmup_requests");
+  const string assets_extra_dir =
+      io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory);
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(assets_extra_dir));
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_ASSERT_OK(Env::Default()->NewWritableFile(
+        io::JoinPath(assets_extra_dir, kSavedModelWarmupRequestsFilename),
+        &file));
+    io::RecordWriter writer(file.get());
+    for (int i = 0; i < 3; ++i) {
+      TF_ASSERT_OK(
+          writer.WriteRecord(MakeRegressRequest().SerializeAsString()));
+    }
+    TF_ASSERT_OK(writer.Close());
+    TF_ASSERT_OK(file->Close());
+  }
+
+  std::vector<SavedModelWarmupRequest> requests;
+  TF_ASSERT_OK(ReadSavedModelWarmupRequests(export_dir, /*max_num_requests=*/2,
+                                            &requests));
+  ASSERT_EQ(requests.size(), 2);
+  EXPECT_EQ(requests[0].signature_name(), "regress_x_to_y");
+
+  std::map<string, SignatureWarmupStats> stats;
+  SavedModelWarmupOptions options;
+  options.warmup_all_signatures = false;
+  TF_ASSERT_OK(WarmupSavedModel(bundle_, export_dir, options, &stats));
+  EXPECT_EQ(stats["regress_x_to_y"].num_runs, 3);
+
+  // A SavedModel without warmup requests has none.
+  requests.clear();
+  TF_ASSERT_OK(ReadSavedModelWarmupRequests(
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestData), 10, &requests));
+  EXPECT_TRUE(requests.empty());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -109,6 +109,24 @@ void DumpStatsToStdout(const Stats& stats) {
   }
 }
 
+void DumpCompileTimesToStdout(const std::vector<CompileTime>& times) {
+  int max_name_size = 0;
+  int64_t total_us = 0;
+  for (const CompileTime& time : times) {
+    max_name_size = std::max<int>(max_name_size, time.entry_point.size());
+    total_us += time.convert_us + time.compile_us;
+  }
+  printf("Compiled %zu entry points, in %lld us of compile time\n",
+         times.size(), static_cast<long long>(total_us));  // NOLINT
+  for (const CompileTime& time : times) {
+    printf("  %-*s convert %10lld us, compile %10lld us%s\n", max_name_size,
+           time.entry_point.c_str(),
+           static_cast<long long>(time.convert_us),  // NOLINT
+           static_cast<long long>(time.compile_us),  // NOLINT
+           time.cached ? " (cached)" : "");
+  }
+}
+
 void Benchmark(const Options& options, const BenchmarkFn& fn, Stats* stats) {
   // If neither max_seconds or max_iters is set, stop at kDefaultMicros.
   const int64_t max_us = (options.max_micros <= 0 && options.max_iters <= 0)
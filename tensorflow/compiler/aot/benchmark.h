@@ -56,6 +56,18 @@ struct Stats {
 // form.
 void DumpStatsToStdout(const Stats& stats);
 
+// CompileTime holds the time tfcompile took to compile an entry point.
+struct CompileTime {
+  std::string entry_point;
+  int64_t convert_us = 0;  // Time to convert the graph to XLA, in us.
+  int64_t compile_us = 0;  // Time to compile and write the outputs, in us.
+  bool cached = false;     // Whether the object file came from the cache.
+};
+
+// DumpCompileTimesToStdout printfs to stdout the compile time of each entry
+// point, one per line, and their total.
+void DumpCompileTimesToStdout(const std::vector<CompileTime>& times);
+
 // BenchmarkFn is the signature of the function generated by tfcompile.
 typedef std::function<void()> BenchmarkFn;
 
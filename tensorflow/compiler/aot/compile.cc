@@ -15,14 +15,19 @@ limitations under the License.
 
 #include "tensorflow/compiler/aot/compile.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/base/call_once.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
 #include "llvm-c/Target.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "tensorflow/compiler/aot/benchmark.h"
 #include "tensorflow/compiler/aot/codegen.h"
 #include "tensorflow/compiler/aot/flags.h"
 #include "tensorflow/compiler/aot/quantize.h"
@@ -31,18 +36,25 @@ limitations under the License.
 #include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/compile_only_client.h"
 #include "tensorflow/compiler/xla/client/xla_computation.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_compiler.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/raw_coding.h"
 #include "tensorflow/core/platform/regexp.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
 namespace tfcompile {
@@ -57,11 +69,140 @@ bool RegisterQuantizeFn(const QuantizeXlaFn& fn) {
 
 namespace {
 
-// Compiles the XLA computation into executable code.
+// Each file of the object cache holds kObjectCacheMagic, then the result
+// buffer index, the number of buffer infos and their encodings as varints,
+// the serialized HloProfilePrinterData and the object file data, each prefixed
+// by its length, and finally the fixed64 fingerprint of all that precedes it,
+// so that corrupt and truncated files are detected.
+constexpr char kObjectCacheMagic[] = "tfcompile object cache v2\n";
+
+// Returns the path in `cache_dir` of the object file compiled from
+// `computation` with `aot_opts`. The key covers everything that the object
+// file depends on: the HLO, the target, the XLA flags and the compiler.
+Status ObjectCachePath(const string& cache_dir,
+                       const xla::XlaComputation& computation,
+                       const xla::cpu::CpuAotCompilationOptions& aot_opts,
+                       string* path) {
+  string hlo;
+  string debug_options;
+  TF_RET_CHECK(SerializeToStringDeterministic(computation.proto(), &hlo));
+  TF_RET_CHECK(SerializeToStringDeterministic(xla::GetDebugOptionsFromFlags(),
+                                              &debug_options));
+  string key;
+  for (absl::string_view part :
+       {absl::string_view(hlo), absl::string_view(debug_options),
+        absl::string_view(aot_opts.triple()),
+        absl::string_view(aot_opts.cpu_name()),
+        absl::string_view(aot_opts.features()),
+        absl::string_view(aot_opts.entry_point_name()),
+        absl::string_view(TF_VERSION_STRING),
+        absl::string_view(tf_git_version())}) {
+    core::PutVarint64(&key, part.size());
+    key.append(part.data(), part.size());
+  }
+  core::PutVarint64(&key, static_cast<int>(aot_opts.relocation_model()));
+  const Fprint128 fingerprint = Fingerprint128(key);
+  *path = io::JoinPath(
+      cache_dir, absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                              absl::Hex(fingerprint.low64, absl::kZeroPad16),
+                              ".o.cache"));
+  return Status::OK();
+}
+
+}  // namespace
+
+bool ReadCachedObject(
+    const string& path,
+    std::unique_ptr<xla::cpu::CpuAotCompilationResult>* aot) {
+  string contents;
+  if (!ReadFileToString(Env::Default(), path, &contents).ok()) return false;
+  absl::string_view input = contents;
+  if (input.size() < sizeof(uint64)) return false;
+  const uint64 fingerprint =
+      core::DecodeFixed64(input.data() + input.size() - sizeof(uint64));
+  input.remove_suffix(sizeof(uint64));
+  if (Fingerprint64(input) != fingerprint) return false;
+  if (!absl::ConsumePrefix(&input, kObjectCacheMagic)) return false;
+  uint64 result_buffer_index;
+  uint64 num_buffer_infos;
+  if (!core::GetVarint64(&input, &result_buffer_index) ||
+      !core::GetVarint64(&input, &num_buffer_infos) ||
+      num_buffer_infos > input.size() ||
+      result_buffer_index >= num_buffer_infos) {
+    return false;
+  }
+  std::vector<xla::cpu_function_runtime::BufferInfo> buffer_infos;
+  buffer_infos.reserve(num_buffer_infos);
+  for (uint64 i = 0; i < num_buffer_infos; ++i) {
+    std::pair<uint64, uint64> encoding;
+    if (!core::GetVarint64(&input, &encoding.first) ||
+        !core::GetVarint64(&input, &encoding.second)) {
+      return false;
+    }
+    buffer_infos.emplace_back(encoding);
+  }
+  uint64 profile_size;
+  if (!core::GetVarint64(&input, &profile_size) ||
+      profile_size > input.size()) {
+    return false;
+  }
+  std::unique_ptr<xla::HloProfilePrinterData> profile;
+  if (profile_size > 0) {
+    profile = absl::make_unique<xla::HloProfilePrinterData>();
+    if (!profile->ParseFromArray(input.data(), profile_size)) return false;
+  }
+  input.remove_prefix(profile_size);
+  uint64 object_size;
+  if (!core::GetVarint64(&input, &object_size) ||
+      object_size != input.size()) {
+    return false;
+  }
+  aot->reset(new xla::cpu::CpuAotCompilationResult(
+      xla::ObjectFileData(input.begin(), input.end()),
+      std::move(buffer_infos), result_buffer_index, std::move(profile)));
+  return true;
+}
+
+Status WriteCachedObject(const xla::cpu::CpuAotCompilationResult& aot,
+                         const string& path) {
+  string contents = kObjectCacheMagic;
+  core::PutVarint64(&contents, aot.result_buffer_index());
+  core::PutVarint64(&contents, aot.buffer_infos().size());
+  for (const xla::cpu_function_runtime::BufferInfo& buffer_info :
+       aot.buffer_infos()) {
+    const std::pair<uint64, uint64> encoding = buffer_info.Encode();
+    core::PutVarint64(&contents, encoding.first);
+    core::PutVarint64(&contents, encoding.second);
+  }
+  string profile;
+  if (aot.hlo_profile_printer_data() != nullptr) {
+    TF_RET_CHECK(SerializeToStringDeterministic(
+        *aot.hlo_profile_printer_data(), &profile));
+  }
+  core::PutVarint64(&contents, profile.size());
+  contents.append(profile);
+  core::PutVarint64(&contents, aot.object_file_data().size());
+  contents.append(aot.object_file_data().begin(),
+                  aot.object_file_data().end());
+  core::PutFixed64(&contents, Fingerprint64(contents));
+
+  Env* env = Env::Default();
+  string tmp_path = path;
+  if (!env->CreateUniqueFileName(&tmp_path, ".tmp")) {
+    return errors::Internal("Couldn't create a temporary file for ", path);
+  }
+  TF_RETURN_IF_ERROR(WriteStringToFile(env, tmp_path, contents));
+  return env->RenameFile(tmp_path, path);
+}
+
+namespace {
+
+// Compiles the XLA computation into executable code. If `cache_dir` is set,
+// the object file is reused from, or else added to, the object cache there.
 Status CompileXla(xla::CompileOnlyClient* client,
                   const xla::XlaComputation& computation,
                   const xla::cpu::CpuAotCompilationOptions& aot_opts,
-                  CompileResult* compile_result) {
+                  const string& cache_dir, CompileResult* compile_result) {
   // Retrieves arg and result layouts from the computation.
   // TODO(toddw): Should we let the user choose the major/minor ordering?
   xla::StatusOr<std::unique_ptr<xla::ProgramShape>> pshape_or =
@@ -72,6 +213,20 @@ Status CompileXla(xla::CompileOnlyClient* client,
   }
   compile_result->program_shape = pshape_or.ValueOrDie()->ToProto();
   xla::ProgramShapeProto* pshape = &compile_result->program_shape;
+  compile_result->entry_point = aot_opts.entry_point_name();
+  compile_result->pointer_size =
+      xla::CompileOnlyClient::PointerSizeForTriple(aot_opts.triple());
+
+  string cache_path;
+  if (!cache_dir.empty()) {
+    TF_RETURN_IF_ERROR(
+        ObjectCachePath(cache_dir, computation, aot_opts, &cache_path));
+    if (ReadCachedObject(cache_path, &compile_result->aot)) {
+      VLOG(1) << "Reusing the object file cached in " << cache_path;
+      compile_result->from_cache = true;
+      return Status::OK();
+    }
+  }
 
   // AotXlaComputationInstance::argument_layouts is a vector of Shape
   // pointers. Accumulate the Shape objects themselves in a separate vector
@@ -96,43 +251,47 @@ Status CompileXla(xla::CompileOnlyClient* client,
   compile_result->aot =
       xla::unique_ptr_static_cast<xla::cpu::CpuAotCompilationResult>(
           std::move(aot_or.ValueOrDie().back()));
-  compile_result->entry_point = aot_opts.entry_point_name();
-  compile_result->pointer_size =
-      xla::CompileOnlyClient::PointerSizeForTriple(aot_opts.triple());
+  if (!cache_path.empty()) {
+    // The cache is an optimization, so failing to update it isn't an error.
+    Status status = WriteCachedObject(*compile_result->aot, cache_path);
+    if (!status.ok()) {
+      LOG(WARNING) << "Couldn't cache the object file in " << cache_path
+                   << ": " << status;
+    }
+  }
   return Status::OK();
 }
 
-}  // namespace
-
-Status CompileGraph(GraphDef graph_def, const tf2xla::Config& config,
-                    const MainFlags& flags, CompileResult* compile_result) {
-  // Converts the graph into an XLA computation, and compiles the
-  // computation.
+xla::CompileOnlyClient* GetCompileOnlyClient() {
   // TODO(toddw): Should we let the user pick the XLA cpu vs. gpu client?
   se::Platform* cpu_platform =
       se::MultiPlatformManager::PlatformWithName("Host").ValueOrDie();
-  xla::CompileOnlyClient* client =
-      xla::ClientLibrary::GetOrCreateCompileOnlyClient(cpu_platform)
-          .ValueOrDie();
-  xla::XlaComputation computation;
+  return xla::ClientLibrary::GetOrCreateCompileOnlyClient(cpu_platform)
+      .ValueOrDie();
+}
+
+// Converts the graph into an XLA computation.
+Status ConvertGraph(GraphDef graph_def, const tf2xla::Config& config,
+                    const MainFlags& flags, xla::CompileOnlyClient* client,
+                    xla::XlaComputation* computation) {
   if (flags.mlir_components == "Bridge") {
     TF_RETURN_IF_ERROR(ConvertGraphDefToXlaViaMlir(
-        graph_def, config, &computation, flags.debug_info,
+        graph_def, config, computation, flags.debug_info,
         flags.debug_info_path_begin_marker));
   } else if (flags.mlir_components.empty() || flags.mlir_components == "None") {
     TF_RETURN_IF_ERROR(ConvertGraphDefToXla(std::move(graph_def), config,
-                                            client, &computation));
+                                            client, computation));
   } else {
     return errors::Unknown("Unknown mlir_components ", flags.mlir_components);
   }
 
   if (flags.experimental_quantize && *quantize_xla) {
-    TF_RETURN_IF_ERROR((*quantize_xla)(config, &computation));
+    TF_RETURN_IF_ERROR((*quantize_xla)(config, computation));
   }
 
   if (!flags.out_session_module.empty()) {
     TF_ASSIGN_OR_RETURN(std::unique_ptr<xla::HloSnapshot> module,
-                        computation.Snapshot());
+                        computation->Snapshot());
     // Serialize the HloSnapshot deterministically so that all the outputs of a
     // tf_library genrule are deterministic.
     const size_t size = module->ByteSizeLong();
@@ -143,12 +302,34 @@ Status CompileGraph(GraphDef graph_def, const tf2xla::Config& config,
         WriteStringToFile(Env::Default(), flags.out_session_module,
                           absl::string_view(serialized.get(), size)));
   }
+  return Status::OK();
+}
+
+// Compiles the computation with the options in the flags.
+Status CompileComputation(xla::CompileOnlyClient* client,
+                          const xla::XlaComputation& computation,
+                          const MainFlags& flags,
+                          CompileResult* compile_result) {
   xla::cpu::CpuAotCompilationOptions aot_opts(
       flags.target_triple, flags.target_cpu, flags.target_features,
       flags.entry_point,
       xla::cpu::CpuAotCompilationOptions::RelocationModel::BigPic);
 
-  return CompileXla(client, computation, aot_opts, compile_result);
+  return CompileXla(client, computation, aot_opts, flags.cache_dir,
+                    compile_result);
+}
+
+}  // namespace
+
+Status CompileGraph(GraphDef graph_def, const tf2xla::Config& config,
+                    const MainFlags& flags, CompileResult* compile_result) {
+  // Converts the graph into an XLA computation, and compiles the
+  // computation.
+  xla::CompileOnlyClient* client = GetCompileOnlyClient();
+  xla::XlaComputation computation;
+  TF_RETURN_IF_ERROR(
+      ConvertGraph(std::move(graph_def), config, flags, client, &computation));
+  return CompileComputation(client, computation, flags, compile_result);
 }
 
 static Status ReadProtoFile(const string& fname, protobuf::Message* proto) {
@@ -206,43 +387,45 @@ static std::string InterpolateErrorMessage(std::string message) {
   return message;
 }
 
-Status Main(const MainFlags& flags) {
-  absl::call_once(targets_init, &InitializeTargets);
+// Returns `status` with the graph nodes in its message interpolated.
+static Status InterpolateError(const Status& status) {
+  if (status.ok()) return status;
+  return errors::CreateWithUpdatedMessage(
+      status, InterpolateErrorMessage(status.error_message()));
+}
 
-  // Process config.
-  tf2xla::Config config;
+static Status ReadConfig(const MainFlags& flags, tf2xla::Config* config) {
   if (flags.config.empty()) {
     return errors::InvalidArgument("Must specify --config");
   }
-  TF_RETURN_IF_ERROR(ReadProtoFile(flags.config, &config));
-  TF_RETURN_IF_ERROR(ValidateConfig(config));
-  if (flags.dump_fetch_nodes) {
-    std::set<string> nodes;
-    for (const tf2xla::Fetch& fetch : config.fetch()) {
-      nodes.insert(fetch.id().node_name());
-    }
-    std::cout << absl::StrJoin(nodes, ",");
-    return Status::OK();
-  }
+  TF_RETURN_IF_ERROR(ReadProtoFile(flags.config, config));
+  return ValidateConfig(*config);
+}
 
-  // Read and initialize the graph.
+// Reads the graph in the flags and converts it into an XLA computation.
+static Status ReadAndConvertGraph(const MainFlags& flags,
+                                  const tf2xla::Config& config,
+                                  xla::XlaComputation* computation) {
   if (flags.graph.empty()) {
     return errors::InvalidArgument("Must specify --graph");
   }
   GraphDef graph_def;
   TF_RETURN_IF_ERROR(ReadProtoFile(flags.graph, &graph_def));
-  CompileResult compile_result;
+  return InterpolateError(ConvertGraph(std::move(graph_def), config, flags,
+                                       GetCompileOnlyClient(), computation));
+}
 
-  Status status =
-      CompileGraph(std::move(graph_def), config, flags, &compile_result);
-  if (!status.ok()) {
-    return errors::CreateWithUpdatedMessage(
-        status, InterpolateErrorMessage(status.error_message()));
-  }
+// Compiles the computation and writes the output files.
+static Status CompileAndWriteOutputs(const MainFlags& flags,
+                                     const tf2xla::Config& config,
+                                     const xla::XlaComputation& computation,
+                                     CompileResult* compile_result) {
+  TF_RETURN_IF_ERROR(InterpolateError(CompileComputation(
+      GetCompileOnlyClient(), computation, flags, compile_result)));
 
   // Write output files.
   Env* env = Env::Default();
-  const std::vector<char>& obj = compile_result.aot->object_file_data();
+  const std::vector<char>& obj = compile_result->aot->object_file_data();
   TF_RETURN_IF_ERROR(
       WriteStringToFile(env, flags.out_function_object,
                         absl::string_view(obj.data(), obj.size())));
@@ -260,15 +443,99 @@ Status Main(const MainFlags& flags) {
 
   MetadataResult metadata_result;
   TF_RETURN_IF_ERROR(
-      GenerateMetadata(codegen_opts, compile_result, &metadata_result));
+      GenerateMetadata(codegen_opts, *compile_result, &metadata_result));
   TF_RETURN_IF_ERROR(WriteStringToFile(env, flags.out_metadata_object,
                                        metadata_result.object_file_data));
   string header;
-  TF_RETURN_IF_ERROR(GenerateHeader(codegen_opts, config, compile_result,
+  TF_RETURN_IF_ERROR(GenerateHeader(codegen_opts, config, *compile_result,
                                     metadata_result, &header));
   TF_RETURN_IF_ERROR(WriteStringToFile(env, flags.out_header, header));
   return Status::OK();
 }
 
+Status Main(const MainFlags& flags) {
+  absl::call_once(targets_init, &InitializeTargets);
+
+  // Process config.
+  tf2xla::Config config;
+  TF_RETURN_IF_ERROR(ReadConfig(flags, &config));
+  if (flags.dump_fetch_nodes) {
+    std::set<string> nodes;
+    for (const tf2xla::Fetch& fetch : config.fetch()) {
+      nodes.insert(fetch.id().node_name());
+    }
+    std::cout << absl::StrJoin(nodes, ",");
+    return Status::OK();
+  }
+
+  // Read and convert the graph, and compile it.
+  xla::XlaComputation computation;
+  TF_RETURN_IF_ERROR(ReadAndConvertGraph(flags, config, &computation));
+  CompileResult compile_result;
+  return CompileAndWriteOutputs(flags, config, computation, &compile_result);
+}
+
+Status MainParallel(const std::vector<MainFlags>& flags_list,
+                    int num_threads) {
+  absl::call_once(targets_init, &InitializeTargets);
+  Env* env = Env::Default();
+  const int num_entry_points = flags_list.size();
+  std::vector<tf2xla::Config> configs(num_entry_points);
+  std::vector<xla::XlaComputation> computations(num_entry_points);
+  std::vector<Status> statuses(num_entry_points);
+  std::vector<benchmark::CompileTime> times(num_entry_points);
+
+  // The graphs are converted in order, on this thread. The conversion is a
+  // small part of the time, and it runs code that isn't required to be
+  // thread-safe, like the registered QuantizeXlaFn. The order doesn't change
+  // the computations, whose ids are assigned by their own XlaBuilder.
+  for (int i = 0; i < num_entry_points; ++i) {
+    const MainFlags& flags = flags_list[i];
+    times[i].entry_point = flags.cpp_class;
+    if (flags.dump_fetch_nodes) {
+      statuses[i] = errors::InvalidArgument(
+          "--dump_fetch_nodes can't be used for several entry points");
+      continue;
+    }
+    const uint64 start_us = env->NowMicros();
+    statuses[i] = ReadConfig(flags, &configs[i]);
+    if (statuses[i].ok()) {
+      statuses[i] = ReadAndConvertGraph(flags, configs[i], &computations[i]);
+    }
+    times[i].convert_us = env->NowMicros() - start_us;
+  }
+
+  // The computations are compiled concurrently, which is where most of the
+  // time goes.
+  {
+    thread::ThreadPool pool(
+        env, "tfcompile",
+        std::max(1, std::min(num_threads > 0 ? num_threads
+                                             : port::MaxParallelism(),
+                             num_entry_points)));
+    for (int i = 0; i < num_entry_points; ++i) {
+      if (!statuses[i].ok()) continue;
+      pool.Schedule([&, i]() {
+        const uint64 start_us = env->NowMicros();
+        CompileResult compile_result;
+        statuses[i] = CompileAndWriteOutputs(flags_list[i], configs[i],
+                                             computations[i], &compile_result);
+        times[i].compile_us = env->NowMicros() - start_us;
+        times[i].cached = compile_result.from_cache;
+      });
+    }
+  }
+  benchmark::DumpCompileTimesToStdout(times);
+
+  for (int i = 0; i < num_entry_points; ++i) {
+    if (!statuses[i].ok()) {
+      return errors::CreateWithUpdatedMessage(
+          statuses[i], absl::StrCat(flags_list[i].cpp_class, ": ",
+                                    statuses[i].error_message()));
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace tfcompile
 }  // namespace tensorflow
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "tensorflow/compiler/aot/flags.h"
 #include "tensorflow/compiler/tf2xla/tf2xla.pb.h"
@@ -36,6 +37,7 @@ struct CompileResult {
   xla::ProgramShapeProto program_shape;  // Static shape of args and results.
   string entry_point;                    // Name of generated function.
   int pointer_size = 0;                  // Size of a pointer in bytes.
+  bool from_cache = false;  // Whether the object file came from the cache.
 };
 
 // CompileGraph compiles the graph_def into an object file containing a function
@@ -45,9 +47,27 @@ struct CompileResult {
 Status CompileGraph(GraphDef graph_def, const tf2xla::Config& config,
                     const MainFlags& flags, CompileResult* compile_result);
 
+// Reads the compilation result cached in `path` by WriteCachedObject. Returns
+// false if there is none, or if it is corrupt or truncated.
+bool ReadCachedObject(const string& path,
+                      std::unique_ptr<xla::cpu::CpuAotCompilationResult>* aot);
+
+// Writes `aot` to `path` in the object cache. The file is written under a
+// unique name and renamed, so that concurrent compilations of the same
+// computation never read a partial file.
+Status WriteCachedObject(const xla::cpu::CpuAotCompilationResult& aot,
+                         const string& path);
+
 // The full compilation method, for reuse in a library setting.
 Status Main(const MainFlags& flags);
 
+// Runs Main for each of the entry points in `flags_list`, compiling them on
+// `num_threads` threads, or one per core if it is <= 0, and prints their
+// compile times to stdout. Returns the first error in the order of
+// `flags_list`.
+Status MainParallel(const std::vector<MainFlags>& flags_list,
+                    int num_threads);
+
 }  // namespace tfcompile
 }  // namespace tensorflow
 
@@ -0,0 +1,164 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/aot/compile.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/compiler/xla/cpu_function_runtime.h"
+#include "tensorflow/compiler/xla/service/hlo_profile_printer_data.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace tfcompile {
+namespace {
+
+using ::xla::cpu_function_runtime::BufferInfo;
+
+std::unique_ptr<xla::cpu::CpuAotCompilationResult> MakeCompilationResult(
+    bool with_profile) {
+  xla::ObjectFileData object_file_data;
+  for (int i = 0; i < 1000; ++i) {
+    object_file_data.push_back(static_cast<char>(i * 31));
+  }
+  std::vector<BufferInfo> buffer_infos = {
+      BufferInfo::MakeEntryParameter(/*size=*/16, /*param_number=*/0),
+      BufferInfo::MakeTempBuffer(/*size=*/1 << 20),
+      BufferInfo::MakeConstant(/*size=*/4),
+      BufferInfo::MakeOnStackBuffer(/*size=*/8),
+      BufferInfo::MakeEntryParameter(/*size=*/3, /*param_number=*/1),
+  };
+  std::unique_ptr<xla::HloProfilePrinterData> profile;
+  if (with_profile) {
+    profile = absl::make_unique<xla::HloProfilePrinterData>();
+    profile->set_profile_counters_size(7);
+    profile->set_entry_computation("entry");
+    (*profile->mutable_extra_metrics())["metric"] = 6;
+    auto* computation_info = profile->add_computation_infos();
+    computation_info->set_name("entry");
+    computation_info->set_profile_index(0);
+    auto* instruction_info = computation_info->add_instruction_infos();
+    instruction_info->set_long_name("%add = f32[] add(f32[] %x, f32[] %y)");
+    instruction_info->set_profile_index(1);
+  }
+  return absl::make_unique<xla::cpu::CpuAotCompilationResult>(
+      std::move(object_file_data), std::move(buffer_infos),
+      /*result_buffer_index=*/1, std::move(profile));
+}
+
+void ExpectEqual(const xla::cpu::CpuAotCompilationResult& expected,
+                 const xla::cpu::CpuAotCompilationResult& actual) {
+  EXPECT_EQ(actual.object_file_data(), expected.object_file_data());
+  EXPECT_EQ(actual.buffer_infos(), expected.buffer_infos());
+  EXPECT_EQ(actual.result_buffer_index(), expected.result_buffer_index());
+  if (expected.hlo_profile_printer_data() == nullptr) {
+    EXPECT_EQ(actual.hlo_profile_printer_data(), nullptr);
+  } else {
+    ASSERT_NE(actual.hlo_profile_printer_data(), nullptr);
+    EXPECT_EQ(actual.hlo_profile_printer_data()->SerializeAsString(),
+              expected.hlo_profile_printer_data()->SerializeAsString());
+  }
+}
+
+string CachePath(const string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+TEST(ObjectCacheTest, RoundTrip) {
+  for (bool with_profile : {false, true}) {
+    SCOPED_TRACE(with_profile);
+    const string path = CachePath("round_trip.o.cache");
+    std::unique_ptr<xla::cpu::CpuAotCompilationResult> aot =
+        MakeCompilationResult(with_profile);
+    TF_ASSERT_OK(WriteCachedObject(*aot, path));
+    std::unique_ptr<xla::cpu::CpuAotCompilationResult> cached;
+    ASSERT_TRUE(ReadCachedObject(path, &cached));
+    ExpectEqual(*aot, *cached);
+  }
+}
+
+TEST(ObjectCacheTest, EmptyObjectFile) {
+  const string path = CachePath("empty.o.cache");
+  xla::cpu::CpuAotCompilationResult aot(
+      xla::ObjectFileData(), {BufferInfo::MakeTempBuffer(/*size=*/4)},
+      /*result_buffer_index=*/0, /*hlo_profile_printer_data=*/nullptr);
+  TF_ASSERT_OK(WriteCachedObject(aot, path));
+  std::unique_ptr<xla::cpu::CpuAotCompilationResult> cached;
+  ASSERT_TRUE(ReadCachedObject(path, &cached));
+  ExpectEqual(aot, *cached);
+}
+
+TEST(ObjectCacheTest, MissingFileIsAMiss) {
+  std::unique_ptr<xla::cpu::CpuAotCompilationResult> cached;
+  EXPECT_FALSE(ReadCachedObject(CachePath("missing.o.cache"), &cached));
+  EXPECT_EQ(cached, nullptr);
+}
+
+TEST(ObjectCacheTest, TruncatedFileIsAMiss) {
+  const string path = CachePath("truncated.o.cache");
+  TF_ASSERT_OK(
+      WriteCachedObject(*MakeCompilationResult(/*with_profile=*/true), path));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), path, &contents));
+  for (int size = 0; size < contents.size(); ++size) {
+    SCOPED_TRACE(size);
+    TF_ASSERT_OK(WriteStringToFile(Env::Default(), path,
+                                   absl::string_view(contents.data(), size)));
+    std::unique_ptr<xla::cpu::CpuAotCompilationResult> cached;
+    EXPECT_FALSE(ReadCachedObject(path, &cached));
+  }
+}
+
+TEST(ObjectCacheTest, CorruptFileIsAMiss) {
+  const string path = CachePath("corrupt.o.cache");
+  TF_ASSERT_OK(
+      WriteCachedObject(*MakeCompilationResult(/*with_profile=*/true), path));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), path, &contents));
+  for (int i = 0; i < contents.size(); ++i) {
+    SCOPED_TRACE(i);
+    string corrupt = contents;
+    corrupt[i] ^= 0x10;
+    TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, corrupt));
+    std::unique_ptr<xla::cpu::CpuAotCompilationResult> cached;
+    EXPECT_FALSE(ReadCachedObject(path, &cached));
+  }
+  // Trailing data is corrupt too.
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, contents + "x"));
+  std::unique_ptr<xla::cpu::CpuAotCompilationResult> cached;
+  EXPECT_FALSE(ReadCachedObject(path, &cached));
+}
+
+TEST(ObjectCacheTest, OverwritesEntry) {
+  const string path = CachePath("overwritten.o.cache");
+  TF_ASSERT_OK(
+      WriteCachedObject(*MakeCompilationResult(/*with_profile=*/false), path));
+  std::unique_ptr<xla::cpu::CpuAotCompilationResult> aot =
+      MakeCompilationResult(/*with_profile=*/true);
+  TF_ASSERT_OK(WriteCachedObject(*aot, path));
+  std::unique_ptr<xla::cpu::CpuAotCompilationResult> cached;
+  ASSERT_TRUE(ReadCachedObject(path, &cached));
+  ExpectEqual(*aot, *cached);
+}
+
+}  // namespace
+}  // namespace tfcompile
+}  // namespace tensorflow
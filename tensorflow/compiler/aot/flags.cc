@@ -15,6 +15,11 @@ limitations under the License.
 
 #include "tensorflow/compiler/aot/flags.h"
 
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+
 namespace tensorflow {
 namespace tfcompile {
 
@@ -75,6 +80,10 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
        "function."},
       {"out_session_module", &flags->out_session_module,
        "Output session module proto."},
+      {"cache_dir", &flags->cache_dir,
+       "Directory of the object file cache.  If set, the object files are "
+       "cached there by the fingerprint of their HLO and of the target and "
+       "XLA flags, and recompiling an unchanged computation reuses them."},
       {"mlir_components", &flags->mlir_components,
        "The MLIR components to enable. Currently only Bridge is supported."},
       {"experimental_quantize", &flags->experimental_quantize,
@@ -88,5 +97,29 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
   flag_list->insert(flag_list->end(), tmp.begin(), tmp.end());
 }
 
+Status ReadEntryPoints(const string& entry_points,
+                       const MainFlags& default_flags,
+                       std::vector<MainFlags>* flags_list) {
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(Env::Default(), entry_points, &contents));
+  for (absl::string_view line : absl::StrSplit(contents, '\n')) {
+    std::vector<string> args =
+        absl::StrSplit(line, absl::ByAnyChar(" \t\r"), absl::SkipEmpty());
+    if (args.empty()) continue;
+    MainFlags flags = default_flags;
+    std::vector<Flag> flag_list;
+    AppendMainFlags(&flag_list, &flags);
+    std::vector<char*> argv = {const_cast<char*>("tfcompile")};
+    for (string& arg : args) argv.push_back(&arg[0]);
+    int argc = argv.size();
+    if (!Flags::Parse(&argc, argv.data(), flag_list) || argc != 1) {
+      return errors::InvalidArgument("Invalid flags in ", entry_points, ": ",
+                                     line);
+    }
+    flags_list->push_back(std::move(flags));
+  }
+  return Status::OK();
+}
+
 }  // namespace tfcompile
 }  // namespace tensorflow
@@ -19,6 +19,7 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/util/command_line_flags.h"
 
 namespace tensorflow {
@@ -41,6 +42,7 @@ struct MainFlags {
   string out_metadata_object;
   string out_header;
   string out_session_module;
+  string cache_dir;
   string mlir_components;
   bool experimental_quantize = false;
 
@@ -52,6 +54,13 @@ struct MainFlags {
 // Appends to flag_list a tensorflow::Flag for each field in MainFlags.
 void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags);
 
+// Reads the file `entry_points`, that holds the flags of an entry point on
+// each line, and appends to flags_list the MainFlags of each line, which
+// override `default_flags`. Empty lines are skipped.
+Status ReadEntryPoints(const string& entry_points,
+                       const MainFlags& default_flags,
+                       std::vector<MainFlags>* flags_list);
+
 }  // namespace tfcompile
 }  // namespace tensorflow
 
@@ -0,0 +1,116 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/aot/flags.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace tfcompile {
+namespace {
+
+// Writes `contents` to a file named `name`, and returns its path.
+string WriteEntryPoints(const string& name, const string& contents) {
+  const string path = io::JoinPath(testing::TmpDir(), name);
+  TF_CHECK_OK(WriteStringToFile(Env::Default(), path, contents));
+  return path;
+}
+
+MainFlags DefaultFlags() {
+  MainFlags flags;
+  flags.target_triple = "x86_64-pc-linux";
+  flags.entry_point = "entry";
+  flags.cache_dir = "/tmp/cache";
+  return flags;
+}
+
+TEST(ReadEntryPointsTest, OverridesDefaultFlags) {
+  const string path = WriteEntryPoints(
+      "entry_points.txt",
+      "--graph=a.pb --config=a.pbtxt --cpp_class=ns::A --entry_point=a\n"
+      "\n"
+      "  \t\n"
+      "--graph=b.pb\t--config=b.pbtxt  --cpp_class=ns::B "
+      "--gen_program_shape --target_cpu=skylake\r\n"
+      "--graph=c.pb --config=c.pbtxt --cpp_class=ns::C");
+  std::vector<MainFlags> flags_list;
+  TF_ASSERT_OK(ReadEntryPoints(path, DefaultFlags(), &flags_list));
+  ASSERT_EQ(flags_list.size(), 3);
+
+  EXPECT_EQ(flags_list[0].graph, "a.pb");
+  EXPECT_EQ(flags_list[0].config, "a.pbtxt");
+  EXPECT_EQ(flags_list[0].cpp_class, "ns::A");
+  EXPECT_EQ(flags_list[0].entry_point, "a");
+  EXPECT_FALSE(flags_list[0].gen_program_shape);
+
+  EXPECT_EQ(flags_list[1].graph, "b.pb");
+  EXPECT_EQ(flags_list[1].config, "b.pbtxt");
+  EXPECT_EQ(flags_list[1].cpp_class, "ns::B");
+  EXPECT_EQ(flags_list[1].entry_point, "entry");
+  EXPECT_EQ(flags_list[1].target_cpu, "skylake");
+  EXPECT_TRUE(flags_list[1].gen_program_shape);
+
+  EXPECT_EQ(flags_list[2].cpp_class, "ns::C");
+  EXPECT_EQ(flags_list[2].target_cpu, "");
+
+  for (const MainFlags& flags : flags_list) {
+    EXPECT_EQ(flags.target_triple, "x86_64-pc-linux");
+    EXPECT_EQ(flags.cache_dir, "/tmp/cache");
+  }
+}
+
+TEST(ReadEntryPointsTest, EmptyFile) {
+  const string path = WriteEntryPoints("empty_entry_points.txt", "\n\n");
+  std::vector<MainFlags> flags_list;
+  TF_ASSERT_OK(ReadEntryPoints(path, DefaultFlags(), &flags_list));
+  EXPECT_TRUE(flags_list.empty());
+}
+
+TEST(ReadEntryPointsTest, UnknownFlag) {
+  const string path = WriteEntryPoints(
+      "unknown_flag_entry_points.txt",
+      "--cpp_class=ns::A\n--cpp_class=ns::B --no_such_flag=1\n");
+  std::vector<MainFlags> flags_list;
+  const Status status = ReadEntryPoints(path, DefaultFlags(), &flags_list);
+  EXPECT_EQ(status.code(), error::INVALID_ARGUMENT) << status;
+  EXPECT_TRUE(absl::StrContains(status.error_message(), "--no_such_flag=1"))
+      << status;
+}
+
+TEST(ReadEntryPointsTest, PositionalArgument) {
+  const string path = WriteEntryPoints("positional_entry_points.txt",
+                                       "--cpp_class=ns::A graph.pb\n");
+  std::vector<MainFlags> flags_list;
+  EXPECT_EQ(ReadEntryPoints(path, DefaultFlags(), &flags_list).code(),
+            error::INVALID_ARGUMENT);
+}
+
+TEST(ReadEntryPointsTest, MissingFile) {
+  std::vector<MainFlags> flags_list;
+  EXPECT_FALSE(ReadEntryPoints(io::JoinPath(testing::TmpDir(), "missing.txt"),
+                               DefaultFlags(), &flags_list)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace tfcompile
+}  // namespace tensorflow
@@ -53,6 +53,11 @@ const char kUsageHeader[] =
     "\n"
     "   $ tfcompile --graph=mygraph.pb --config=myfile.pbtxt "
     "--cpp_class=\"mynamespace::MyComputation\"\n"
+    "\n"
+    "Several entry points can be compiled concurrently by listing the flags\n"
+    "of each one on a line of an --entry_points file, e.g.\n"
+    "\n"
+    "   $ tfcompile --entry_points=entry_points.txt --num_threads=8\n"
     "\n";
 
 }  // end namespace tfcompile
@@ -72,6 +77,15 @@ int main(int argc, char** argv) {
   std::vector<tensorflow::Flag> flag_list;
   AppendMainFlags(&flag_list, &flags);
   xla::AppendDebugOptionsFlags(&flag_list);
+  tensorflow::string entry_points;
+  tensorflow::int32 num_threads = 0;
+  flag_list.emplace_back(
+      "entry_points", &entry_points,
+      "File with the flags of an entry point on each line, which override "
+      "the other flags.  If set, the entry points are compiled concurrently.");
+  flag_list.emplace_back("num_threads", &num_threads,
+                         "Number of threads compiling the --entry_points, or "
+                         "one per core if it is <= 0.");
 
   tensorflow::string usage = tensorflow::tfcompile::kUsageHeader;
   usage += tensorflow::Flags::Usage(argv[0], flag_list);
@@ -85,7 +99,17 @@ int main(int argc, char** argv) {
   tensorflow::port::InitMain(usage.c_str(), &argc, &argv);
   QCHECK(argc == 1) << "\nERROR: This command does not take any arguments "
                        "other than flags. See --help.\n\n";
-  tensorflow::Status status = tensorflow::tfcompile::Main(flags);
+  tensorflow::Status status;
+  if (entry_points.empty()) {
+    status = tensorflow::tfcompile::Main(flags);
+  } else {
+    std::vector<tensorflow::tfcompile::MainFlags> flags_list;
+    status = tensorflow::tfcompile::ReadEntryPoints(entry_points, flags,
+                                                     &flags_list);
+    if (status.ok()) {
+      status = tensorflow::tfcompile::MainParallel(flags_list, num_threads);
+    }
+  }
   if (status.code() == tensorflow::error::INVALID_ARGUMENT) {
     std::cerr << "INVALID ARGUMENTS: " << status.error_message() << "\n\n";
     return 1;
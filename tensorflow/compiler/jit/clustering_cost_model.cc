@@ -0,0 +1,66 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/clustering_cost_model.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/types.h"
+
+namespace tensorflow {
+
+double ClusteringCostModel::BenefitUs(const ClusterStats& stats) const {
+  // Fusing a tensor saves writing it to memory and reading it back.
+  double saved_us = stats.num_ops * options_.op_overhead_us +
+                    2.0 * stats.fused_bytes / options_.bytes_per_us;
+  double compile_us = options_.compile_overhead_us +
+                      stats.num_ops * options_.compile_us_per_op;
+  return saved_us - options_.launch_overhead_us -
+         compile_us / std::max<int64_t>(options_.expected_executions, 1);
+}
+
+bool ClusteringCostModel::IsMergeProfitable(const ClusterStats& a,
+                                            const ClusterStats& b,
+                                            int64_t bytes_between) const {
+  double a_benefit_us = BenefitUs(a);
+  double b_benefit_us = BenefitUs(b);
+  if (a_benefit_us <= 0 && b_benefit_us <= 0) {
+    return true;
+  }
+  ClusterStats merged;
+  merged.num_ops = a.num_ops + b.num_ops;
+  merged.fused_bytes = a.fused_bytes + b.fused_bytes + bytes_between;
+  return BenefitUs(merged) >=
+         std::max(a_benefit_us, 0.0) + std::max(b_benefit_us, 0.0);
+}
+
+/*static*/ int64_t ClusteringCostModel::EdgeBytes(
+    const Edge& edge, const GraphShapeInfo& shape_info) {
+  if (edge.IsControlEdge()) {
+    return 0;
+  }
+  auto it = shape_info.find(edge.src()->name());
+  if (it == shape_info.end() || edge.src_output() >= it->second.size()) {
+    return 0;
+  }
+  const PartialTensorShape& shape = it->second[edge.src_output()].shape;
+  DataType dtype = edge.src()->output_type(edge.src_output());
+  if (!shape.IsFullyDefined() || !DataTypeCanUseMemcpy(dtype)) {
+    return 0;
+  }
+  return shape.num_elements() * DataTypeSize(dtype);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,87 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_JIT_CLUSTERING_COST_MODEL_H_
+#define TENSORFLOW_COMPILER_JIT_CLUSTERING_COST_MODEL_H_
+
+#include "tensorflow/compiler/jit/shape_inference.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Estimates whether compiling a cluster with XLA pays off, for the cost based
+// clustering of MarkForCompilationPass.
+//
+// Compiling a cluster saves the TF executor overhead of each of its ops and
+// the memory traffic of the tensors that XLA fuses away, i.e. that are
+// produced and consumed inside the cluster. In exchange each execution of the
+// cluster pays for an _XlaCompile/_XlaRun launch, and the compilation of the
+// cluster is amortized over its executions.
+class ClusteringCostModel {
+ public:
+  struct Options {
+    // The TF executor overhead of an op, in microseconds.
+    double op_overhead_us = 2.0;
+
+    // The overhead of launching a cluster, in microseconds.
+    double launch_overhead_us = 20.0;
+
+    // The memory bandwidth, in bytes per microsecond.
+    double bytes_per_us = 1e4;
+
+    // The time to compile a cluster is `compile_overhead_us` plus
+    // `compile_us_per_op` for each of its ops.
+    double compile_overhead_us = 5e4;
+    double compile_us_per_op = 1e3;
+
+    // The number of executions that a compilation is amortized over.
+    int64_t expected_executions = 1000;
+  };
+
+  // The properties of a cluster that its benefit depends on.
+  struct ClusterStats {
+    // The number of ops in the cluster, excluding Const and Identity ops.
+    int64_t num_ops = 0;
+
+    // The bytes of the tensors produced and consumed inside the cluster.
+    int64_t fused_bytes = 0;
+  };
+
+  explicit ClusteringCostModel(Options options) : options_(options) {}
+
+  // Returns the time that compiling a cluster with `stats` saves per
+  // execution, in microseconds, which is negative if it does not pay off.
+  double BenefitUs(const ClusterStats& stats) const;
+
+  // Returns true if merging clusters with `a` and `b`, between which flow
+  // tensors of `bytes_between` bytes, does not lose any benefit. A cluster
+  // that does not pay off on its own is not compiled, so it has no benefit,
+  // but merges of such clusters are allowed so that they can grow until they
+  // pay off.
+  bool IsMergeProfitable(const ClusterStats& a, const ClusterStats& b,
+                         int64_t bytes_between) const;
+
+  // Returns the bytes of the tensor that flows along the data edge `edge`, or
+  // 0 if its size is unknown per `shape_info`.
+  static int64_t EdgeBytes(const Edge& edge, const GraphShapeInfo& shape_info);
+
+ private:
+  const Options options_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_CLUSTERING_COST_MODEL_H_
@@ -0,0 +1,91 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/clustering_cost_model.h"
+
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+ClusteringCostModel::Options TestOptions() {
+  ClusteringCostModel::Options options;
+  options.op_overhead_us = 1;
+  options.launch_overhead_us = 10;
+  options.bytes_per_us = 1;
+  options.compile_overhead_us = 100;
+  options.compile_us_per_op = 20;
+  options.expected_executions = 10;
+  return options;
+}
+
+ClusteringCostModel::ClusterStats Stats(int64_t num_ops, int64_t fused_bytes) {
+  ClusteringCostModel::ClusterStats stats;
+  stats.num_ops = num_ops;
+  stats.fused_bytes = fused_bytes;
+  return stats;
+}
+
+TEST(ClusteringCostModelTest, Benefit) {
+  ClusteringCostModel cost_model(TestOptions());
+  // 5 ops and 2 * 10 bytes saved, a launch and (100 + 100) / 10 compile time
+  // spent.
+  EXPECT_DOUBLE_EQ(cost_model.BenefitUs(Stats(5, 10)), 25 - 10 - 20);
+  EXPECT_DOUBLE_EQ(cost_model.BenefitUs(Stats(5, 20)), 45 - 10 - 20);
+}
+
+TEST(ClusteringCostModelTest, MergeProfitability) {
+  ClusteringCostModel cost_model(TestOptions());
+  // Clusters that do not pay off on their own may grow.
+  EXPECT_TRUE(cost_model.IsMergeProfitable(Stats(1, 0), Stats(1, 0),
+                                           /*bytes_between=*/0));
+  // A cluster that pays off may absorb ops that fuse enough memory traffic to
+  // pay for their compilation, but not others.
+  EXPECT_TRUE(cost_model.IsMergeProfitable(Stats(5, 100), Stats(1, 0),
+                                           /*bytes_between=*/1));
+  EXPECT_FALSE(cost_model.IsMergeProfitable(Stats(5, 100), Stats(1, 0),
+                                            /*bytes_between=*/0));
+  // Merging two clusters that pay off saves a launch and a compilation.
+  EXPECT_TRUE(cost_model.IsMergeProfitable(Stats(5, 100), Stats(5, 100),
+                                           /*bytes_between=*/0));
+}
+
+TEST(ClusteringCostModelTest, EdgeBytes) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto known = ops::Placeholder(root.WithOpName("known"), DT_FLOAT,
+                                ops::Placeholder::Shape({2, 3}));
+  auto unknown = ops::Placeholder(root.WithOpName("unknown"), DT_FLOAT);
+  auto known_relu = ops::Relu(root.WithOpName("known_relu"), known);
+  auto unknown_relu = ops::Relu(root.WithOpName("unknown_relu"), unknown);
+  Graph graph(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&graph));
+
+  GraphShapeInfo shape_info;
+  TF_ASSERT_OK(InferShapes(&graph, /*arg_shapes=*/{},
+                           /*fnlib_def=*/nullptr, &shape_info));
+  const Edge* known_edge;
+  TF_ASSERT_OK(known_relu.node()->input_edge(0, &known_edge));
+  EXPECT_EQ(ClusteringCostModel::EdgeBytes(*known_edge, shape_info), 24);
+  const Edge* unknown_edge;
+  TF_ASSERT_OK(unknown_relu.node()->input_edge(0, &unknown_edge));
+  EXPECT_EQ(ClusteringCostModel::EdgeBytes(*unknown_edge, shape_info), 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <mutex>  // NOLINT
 
+#include "absl/algorithm/container.h"
 #include "absl/base/call_once.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_split.h"
@@ -129,7 +130,17 @@ void AppendMarkForCompilationPassFlagsInternal(std::vector<Flag>* flag_list) {
            &mark_for_compilation_flags
                 ->tf_xla_disable_resource_variable_safety_checks_for_debugging,
            "Disable resource variables related safety checks when clustering "
-           "(this is unsound).")};
+           "(this is unsound)."),
+      Flag("tf_xla_cost_based_clustering",
+           &mark_for_compilation_flags->tf_xla_cost_based_clustering,
+           "(experimental) Only grow and compile clusters as far as a cost "
+           "model of the launch overhead, the fusion benefit and the "
+           "compilation time estimates that it pays off.  Overrides "
+           "tf_xla_min_cluster_size."),
+      Flag("tf_xla_clustering_expected_executions",
+           &mark_for_compilation_flags->tf_xla_clustering_expected_executions,
+           "The number of executions of a cluster that "
+           "tf_xla_cost_based_clustering amortizes its compilation over.")};
   flag_list->insert(flag_list->end(), new_flags.begin(), new_flags.end());
 }
 
@@ -156,6 +167,8 @@ void AllocateAndParseFlags() {
       ->tf_xla_disable_deadness_safety_checks_for_debugging = false;
   mark_for_compilation_flags
       ->tf_xla_disable_resource_variable_safety_checks_for_debugging = false;
+  mark_for_compilation_flags->tf_xla_cost_based_clustering = false;
+  mark_for_compilation_flags->tf_xla_clustering_expected_executions = 1000;
 
   device_flags = new XlaDeviceFlags;
   device_flags->tf_xla_compile_on_demand = false;
@@ -164,6 +177,7 @@ void AllocateAndParseFlags() {
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
   ops_flags->tf_xla_async_compilation = false;
+  ops_flags->tf_xla_shape_bucketing = false;
 
   jitter_flags = new IntroduceFloatingPointJitterPassFlags;
   jitter_flags->jitter_amount = 1e-5;
@@ -185,6 +199,20 @@ void AllocateAndParseFlags() {
     jitter_flags->tensor_names = absl::StrSplit(sequence, ',');
     return true;
   };
+  auto setter_for_shape_bucket_boundaries = [](string sequence) {
+    std::vector<int64_t> boundaries;
+    for (absl::string_view boundary :
+         absl::StrSplit(sequence, ',', absl::SkipEmpty())) {
+      int64_t size;
+      if (!absl::SimpleAtoi(boundary, &size) || size <= 0) {
+        return false;
+      }
+      boundaries.push_back(size);
+    }
+    absl::c_sort(boundaries);
+    ops_flags->tf_xla_shape_bucket_boundaries = std::move(boundaries);
+    return true;
+  };
 
   flag_list = new std::vector<Flag>(
       {Flag("tf_xla_enable_lazy_compilation",
@@ -222,6 +250,15 @@ void AllocateAndParseFlags() {
             "When lazy compilation is enabled, asynchronous compilation starts "
             "the cluster compilation in the background, and the fallback path "
             "is executed until the compilation has finished."),
+       Flag("tf_xla_shape_bucketing", &ops_flags->tf_xla_shape_bucketing,
+            "If true then the dimensions of cluster arguments that vary across "
+            "executions are padded up to a bucket, so that clusters are "
+            "compiled once per bucket instead of once per shape."),
+       Flag("tf_xla_shape_bucket_boundaries",
+            setter_for_shape_bucket_boundaries, "",
+            "Comma separated sizes that tf_xla_shape_bucketing rounds "
+            "dimensions up to. Sizes above the largest one, or all sizes if "
+            "empty, are rounded up to a power of two."),
 
        Flag("tf_introduce_floating_point_jitter_to_tensors",
             setter_for_jitter_tensor_names, "",
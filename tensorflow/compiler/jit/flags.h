@@ -80,6 +80,15 @@ struct MarkForCompilationPassFlags {
   // variable concurrency semantics.  This is unsound in general, but can be
   // used as a debugging aid.
   bool tf_xla_disable_resource_variable_safety_checks_for_debugging;
+
+  // If true, clusters are only grown and compiled as far as the clustering
+  // cost model estimates that compiling them pays off, and
+  // tf_xla_min_cluster_size is ignored.  See ClusteringCostModel.
+  bool tf_xla_cost_based_clustering;
+
+  // The number of executions of a cluster that the cost based clustering
+  // amortizes its compilation over.
+  int64_t tf_xla_clustering_expected_executions;
 };
 
 // Flags associated with the XLA bridge's xla_device module.
@@ -102,6 +111,13 @@ struct XlaOpsCommonFlags {
   // If true, _XlaCompile compiles the cluster asynchronously with respect to
   // the main execution. The fallback path is taken while compilation happens.
   bool tf_xla_async_compilation;
+  // If true, the compilation cache rounds the dimensions of cluster arguments
+  // that vary across executions up to a bucket and compiles them as bounded
+  // dynamic dimensions, so that the sizes in a bucket share an executable.
+  bool tf_xla_shape_bucketing;
+  // The sizes that tf_xla_shape_bucketing rounds dimensions up to. Sizes above
+  // the largest one are rounded up to a power of two.
+  std::vector<int64_t> tf_xla_shape_bucket_boundaries;
 };
 
 // Flags for the build_xla_ops pass.
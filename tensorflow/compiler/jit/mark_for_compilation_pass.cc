@@ -25,12 +25,14 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_join.h"
+#include "tensorflow/compiler/jit/clustering_cost_model.h"
 #include "tensorflow/compiler/jit/compilability_check_util.h"
 #include "tensorflow/compiler/jit/deadness_analysis.h"
 #include "tensorflow/compiler/jit/defs.h"
 #include "tensorflow/compiler/jit/device_util.h"
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/resource_operation_safety_analysis.h"
+#include "tensorflow/compiler/jit/shape_inference.h"
 #include "tensorflow/compiler/jit/xla_cluster_util.h"
 #include "tensorflow/compiler/tf2xla/const_analysis.h"
 #include "tensorflow/compiler/tf2xla/resource_operation_table.h"
@@ -105,6 +107,11 @@ class MarkForCompilationPassImpl {
     std::atomic<int64_t>* fuel;
 
     bool dump_graphs;
+
+    // If set, clusters are grown and compiled as far as a ClusteringCostModel
+    // with these options estimates that it pays off, and min_cluster_size is
+    // ignored.
+    absl::optional<ClusteringCostModel::Options> cost_model_options;
   };
 
   MarkForCompilationPassImpl(DebugOptions debug_options, Graph* graph,
@@ -116,7 +123,11 @@ class MarkForCompilationPassImpl {
         flib_def_(flib_def),
         env_(env),
         global_jit_level_(global_jit_level),
-        cpu_global_jit_(cpu_global_jit) {}
+        cpu_global_jit_(cpu_global_jit) {
+    if (debug_options_.cost_model_options.has_value()) {
+      cost_model_.emplace(*debug_options_.cost_model_options);
+    }
+  }
 
   Status Run();
 
@@ -133,6 +144,7 @@ class MarkForCompilationPassImpl {
             bool is_xla_compile_attr_true, absl::optional<string> xla_scope)
         : cycles_graph_node_id_(tf_graph_node_id),
           effective_cluster_size_(effective_cluster_size),
+          node_ids_({tf_graph_node_id}),
           has_functional_control_flow_(has_functional_control_flow),
           devices_(std::move(devices)),
           resource_op_device_(resource_op_device),
@@ -170,6 +182,21 @@ class MarkForCompilationPassImpl {
     // The size of the cluster excluding constant and identity nodes.
     int effective_cluster_size() const { return effective_cluster_size_; }
 
+    // The TF graph node IDs of the nodes in this cluster.
+    absl::Span<const int> node_ids() const { return node_ids_; }
+
+    // The properties of the cluster that the clustering cost model uses.
+    ClusteringCostModel::ClusterStats cost_stats() const {
+      ClusteringCostModel::ClusterStats stats;
+      stats.num_ops = effective_cluster_size_;
+      stats.fused_bytes = fused_bytes_;
+      return stats;
+    }
+
+    // Records that `bytes` more bytes of tensors are produced and consumed
+    // inside the cluster.
+    void AddFusedBytes(int64_t bytes) { fused_bytes_ += bytes; }
+
     // True if the cluster has functional control flow like `If` and `While`.
     bool has_functional_control_flow() const {
       return has_functional_control_flow_;
@@ -228,6 +255,8 @@ class MarkForCompilationPassImpl {
     int cluster_size_ = 1;
     int cycles_graph_node_id_;
     int effective_cluster_size_;
+    std::vector<int> node_ids_;
+    int64_t fused_bytes_ = 0;
     bool has_functional_control_flow_;
     DeviceSet devices_;
     absl::optional<DeviceId> resource_op_device_;
@@ -305,6 +334,10 @@ class MarkForCompilationPassImpl {
   StatusOr<bool> ClusteringWillIntroduceInterDeviceDependency(
       const Cluster& from, const Cluster& to);
 
+  // Returns the bytes of the tensors that flow between `cluster_a` and
+  // `cluster_b`, per `shape_info_`.
+  int64_t BytesBetween(const Cluster& cluster_a, const Cluster& cluster_b);
+
   // Returns true if the devices in `cluster_a` and `cluster_b` are compatible
   // and therefore not a hindrance for combining the two clusters into a larger
   // cluster.
@@ -442,6 +475,8 @@ class MarkForCompilationPassImpl {
   std::unique_ptr<DeadnessAnalysis> deadness_analysis_;
   int64_t iteration_count_ = 0;
   absl::flat_hash_set<std::pair<int, int>> unsafe_resource_deps_;
+  absl::optional<ClusteringCostModel> cost_model_;
+  GraphShapeInfo shape_info_;
 };
 
 std::vector<int> MarkForCompilationPassImpl::FindAlternatePathForDebugging(
@@ -540,6 +575,12 @@ void MarkForCompilationPassImpl::Cluster::Merge(Cluster* other) {
 
   cluster_size_ += other->cluster_size_;
   effective_cluster_size_ += other->effective_cluster_size_;
+  fused_bytes_ += other->fused_bytes_;
+  if (node_ids_.size() < other->node_ids_.size()) {
+    node_ids_.swap(other->node_ids_);
+  }
+  absl::c_copy(other->node_ids_, std::back_inserter(node_ids_));
+  other->node_ids_.clear();
   has_functional_control_flow_ |= other->has_functional_control_flow_;
 
   devices_.UnionWith(other->devices_);
@@ -629,6 +670,18 @@ StatusOr<bool> MarkForCompilationPassImpl::Initialize() {
     TF_RETURN_IF_ERROR(DeadnessAnalysis::Run(*graph_, &deadness_analysis_));
   }
 
+  if (cost_model_.has_value()) {
+    XLA_SCOPED_LOGGING_TIMER_LEVEL("InferShapes", 1);
+    // The cost model treats the tensors of unknown size as small.
+    Status status = InferShapes(graph_, /*arg_shapes=*/{}, flib_def_,
+                                &shape_info_);
+    if (!status.ok()) {
+      VLOG(2) << "Could not infer shapes for the clustering cost model: "
+              << status;
+      shape_info_.clear();
+    }
+  }
+
   // Each compilation candidate belongs to a cluster. The cluster's
   // representative names the node in the 'cycles' graph that represents the
   // cluster.
@@ -860,7 +913,8 @@ Status MarkForCompilationPassImpl::CreateClusters() {
   // Mark clusters for compilation that:
   // * are placed on a device that requires compilation (an XlaDevice),
   // * are explicitly marked for compilation (_XlaCompile=true), or
-  // * have more than debug_options_.xla_min_cluster_size elements (applicable
+  // * have more than debug_options_.xla_min_cluster_size elements, or pay off
+  //   per the clustering cost model if clustering is cost based (applicable
   //   only if compilation is enabled, otherwise there will be no such
   //   candidates).
   for (Node* n : compilation_candidates_) {
@@ -876,8 +930,17 @@ Status MarkForCompilationPassImpl::CreateClusters() {
     // to (recursively) verify this fact, but that's probably not worth the
     // trouble.
 
-    if (cluster->effective_cluster_size() >= debug_options_.min_cluster_size ||
-        cluster->has_functional_control_flow() ||
+    absl::optional<double> benefit_us;
+    bool large_enough;
+    if (cost_model_.has_value()) {
+      benefit_us = cost_model_->BenefitUs(cluster->cost_stats());
+      large_enough = *benefit_us > 0;
+    } else {
+      large_enough =
+          cluster->effective_cluster_size() >= debug_options_.min_cluster_size;
+    }
+
+    if (large_enough || cluster->has_functional_control_flow() ||
         cluster->is_xla_compile_attr_true()) {
       string& name = cluster_names[cluster->cycles_graph_node_id()];
 
@@ -886,6 +949,9 @@ Status MarkForCompilationPassImpl::CreateClusters() {
       }
 
       n->AddAttr(kXlaClusterAttr, name);
+      if (benefit_us.has_value()) {
+        n->AddAttr(kXlaClusterBenefitUsAttr, static_cast<float>(*benefit_us));
+      }
       n->AddAttr(kXlaAlreadyClustered, true);
       VLOG(3) << "Assigning node " << n->name() << " to cluster " << name;
     }
@@ -1419,7 +1485,45 @@ StatusOr<bool> MarkForCompilationPassImpl::TryToContractEdge(Cluster* from,
     }
   }
 
-  return MergeClusters(from, to);
+  int64_t bytes_between = 0;
+  if (cost_model_.has_value()) {
+    bytes_between = BytesBetween(*from, *to);
+    if (!cost_model_->IsMergeProfitable(from->cost_stats(), to->cost_stats(),
+                                        bytes_between)) {
+      return LogNotContractableAndReturnFalse(
+          from, to, "the clustering cost model estimates it does not pay off");
+    }
+  }
+
+  if (!MergeClusters(from, to)) {
+    return false;
+  }
+  from->AddFusedBytes(bytes_between);
+  return true;
+}
+
+int64_t MarkForCompilationPassImpl::BytesBetween(const Cluster& cluster_a,
+                                                 const Cluster& cluster_b) {
+  const Cluster* smaller = &cluster_a;
+  const Cluster* larger = &cluster_b;
+  if (smaller->cluster_size() > larger->cluster_size()) {
+    std::swap(smaller, larger);
+  }
+  int64_t bytes = 0;
+  for (int node_id : smaller->node_ids()) {
+    Node* node = graph_->FindNodeId(node_id);
+    for (const Edge* edge : node->out_edges()) {
+      if (GetClusterForNode(edge->dst()) == larger) {
+        bytes += ClusteringCostModel::EdgeBytes(*edge, shape_info_);
+      }
+    }
+    for (const Edge* edge : node->in_edges()) {
+      if (GetClusterForNode(edge->src()) == larger) {
+        bytes += ClusteringCostModel::EdgeBytes(*edge, shape_info_);
+      }
+    }
+  }
+  return bytes;
 }
 
 Status MarkForCompilationPassImpl::Run() {
@@ -1757,6 +1861,12 @@ Status MarkForCompilationPass::Run(
   debug_options.min_cluster_size = flags->tf_xla_min_cluster_size;
   debug_options.fuel = GetPointerToFuel(flags->tf_xla_clustering_fuel);
   debug_options.dump_graphs = flags->tf_xla_clustering_debug;
+  if (flags->tf_xla_cost_based_clustering) {
+    ClusteringCostModel::Options cost_model_options;
+    cost_model_options.expected_executions =
+        flags->tf_xla_clustering_expected_executions;
+    debug_options.cost_model_options = cost_model_options;
+  }
 
   return MarkForCompilation(options, debug_options);
 }
@@ -1775,6 +1885,12 @@ Status MarkForCompilationPass::RunForTest(
   debug_options.min_cluster_size = flags->tf_xla_min_cluster_size;
   debug_options.fuel = GetPointerToFuel(flags->tf_xla_clustering_fuel);
   debug_options.dump_graphs = flags->tf_xla_clustering_debug;
+  if (flags->tf_xla_cost_based_clustering) {
+    ClusteringCostModel::Options cost_model_options;
+    cost_model_options.expected_executions =
+        flags->tf_xla_clustering_expected_executions;
+    debug_options.cost_model_options = cost_model_options;
+  }
 
   return MarkForCompilation(options, debug_options);
 }
@@ -16,6 +16,7 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/cc/framework/ops.h"
 #include "tensorflow/cc/ops/array_ops.h"
 #include "tensorflow/cc/ops/control_flow_ops_internal.h"
@@ -26,8 +27,10 @@ limitations under the License.
 #include "tensorflow/cc/ops/sendrecv_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/compiler/jit/defs.h"
+#include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/mark_for_compilation_pass_test_helper.h"
 #include "tensorflow/compiler/jit/node_matchers.h"
+#include "tensorflow/compiler/jit/xla_cluster_util.h"
 #include "tensorflow/compiler/tf2xla/xla_op_kernel.h"
 #include "tensorflow/compiler/tf2xla/xla_op_registry.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
@@ -37,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/test.h"
 
 using ::tensorflow::testing::FindNodeByName;
@@ -115,6 +119,51 @@ TEST(XlaCompilationTest, Chains) {
   EXPECT_TRUE(clusters.find("D") == clusters.cend());
 }
 
+TEST(XlaCompilationTest, CostBasedClustering) {
+  MarkForCompilationPassFlags* flags = GetMarkForCompilationPassFlags();
+  flags->tf_xla_cost_based_clustering = true;
+  auto reset_flags = gtl::MakeCleanup(
+      [flags] { flags->tf_xla_cost_based_clustering = false; });
+
+  // Only the chain of large tensors fuses enough memory traffic to pay for
+  // its launch and compilation.
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  {
+    GraphDefBuilder builder(GraphDefBuilder::kFailImmediately);
+    for (const auto& prefix_and_size : {std::make_pair("Large", 1024),
+                                        std::make_pair("Small", 2)}) {
+      string prefix = prefix_and_size.first;
+      Node* input = ops::SourceOp(
+          "Placeholder", builder.opts()
+                             .WithName(absl::StrCat(prefix, "Input"))
+                             .WithAttr("dtype", DT_FLOAT)
+                             .WithAttr("shape",
+                                       TensorShape({prefix_and_size.second,
+                                                    prefix_and_size.second})));
+      Node* a = ops::UnaryOp(
+          "Relu", input, builder.opts().WithName(absl::StrCat(prefix, "A")));
+      Node* b = ops::UnaryOp(
+          "Relu", a, builder.opts().WithName(absl::StrCat(prefix, "B")));
+      ops::UnaryOp("Relu", b,
+                   builder.opts().WithName(absl::StrCat(prefix, "C")));
+    }
+    TF_EXPECT_OK(GraphDefBuilderToGraph(builder, graph.get()));
+  }
+
+  TF_ASSERT_OK(MarkForCompilationPassTestHelper::MarkForCompilation(&graph));
+  auto clusters = GetClusters(*graph);
+  EXPECT_EQ(3, clusters.size());
+  EXPECT_FALSE(clusters["LargeA"].empty());
+  EXPECT_EQ(clusters["LargeA"], clusters["LargeB"]);
+  EXPECT_EQ(clusters["LargeA"], clusters["LargeC"]);
+  EXPECT_TRUE(clusters.find("SmallA") == clusters.cend());
+
+  float benefit_us;
+  TF_ASSERT_OK(GetNodeAttr(FindNodeByName(graph.get(), "LargeA")->attrs(),
+                           kXlaClusterBenefitUsAttr, &benefit_us));
+  EXPECT_GT(benefit_us, 0);
+}
+
 TEST(XlaCompilationTest, UncompilableCycles) {
   std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
   {
@@ -0,0 +1,104 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include <algorithm>
+
+#include "absl/types/variant.h"
+#include "tensorflow/compiler/tf2xla/shape_util.h"
+#include "tensorflow/compiler/xla/shape.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+int64_t ShapeBucketer::RoundUp(int64_t size) const {
+  auto it = std::lower_bound(boundaries_.begin(), boundaries_.end(), size);
+  if (it != boundaries_.end()) {
+    return *it;
+  }
+  int64_t bucket = 1;
+  while (bucket < size) {
+    bucket *= 2;
+  }
+  return bucket;
+}
+
+std::vector<XlaCompiler::Argument> ShapeBucketer::BucketArguments(
+    const string& cluster, absl::Span<const XlaCompiler::Argument> args) {
+  std::vector<XlaCompiler::Argument> bucketed_args(args.begin(), args.end());
+  mutex_lock lock(mu_);
+  std::vector<std::vector<int64_t>>& cluster_sizes = sizes_[cluster];
+  cluster_sizes.resize(args.size());
+  for (int i = 0; i < args.size(); ++i) {
+    XlaCompiler::Argument& arg = bucketed_args[i];
+    if (arg.kind != XlaCompiler::Argument::kParameter ||
+        !absl::holds_alternative<TensorShape>(arg.shape)) {
+      continue;
+    }
+    const TensorShape& shape = absl::get<TensorShape>(arg.shape);
+    std::vector<int64_t>& sizes = cluster_sizes[i];
+    if (sizes.empty() || sizes.size() != shape.dims()) {
+      sizes.assign(shape.dim_sizes().begin(), shape.dim_sizes().end());
+      continue;
+    }
+    bool any_varying = false;
+    for (int dim = 0; dim < shape.dims(); ++dim) {
+      if (sizes[dim] != shape.dim_size(dim)) {
+        sizes[dim] = -1;
+      }
+      any_varying |= sizes[dim] < 0;
+    }
+    if (!any_varying) {
+      continue;
+    }
+    xla::Shape xla_shape;
+    if (!TensorShapeToXLAShape(arg.type, shape, &xla_shape).ok()) {
+      continue;
+    }
+    for (int dim = 0; dim < shape.dims(); ++dim) {
+      if (sizes[dim] < 0) {
+        xla_shape.set_dimensions(dim, RoundUp(shape.dim_size(dim)));
+        xla_shape.set_dynamic_dimension(dim, true);
+      }
+    }
+    arg.shape = xla_shape;
+  }
+  return bucketed_args;
+}
+
+void ShapeBucketer::RecordLookup(const string& cluster, const string& bucket,
+                                 bool hit) {
+  mutex_lock lock(mu_);
+  BucketStats& stats = stats_[cluster][bucket];
+  ++(hit ? stats.hits : stats.misses);
+  if (!hit) {
+    VLOG(1) << "Shape bucket " << bucket << " of cluster " << cluster
+            << " missed the compilation cache, the bucket has "
+            << stats.hits << " hits and " << stats.misses << " misses";
+  }
+}
+
+absl::flat_hash_map<string, ShapeBucketer::BucketStats>
+ShapeBucketer::GetBucketStats(const string& cluster) const {
+  mutex_lock lock(mu_);
+  auto it = stats_.find(cluster);
+  if (it == stats_.end()) {
+    return {};
+  }
+  return it->second;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,90 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+#define TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/tf2xla/xla_compiler.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Rounds the dimensions of the arguments of clusters up to buckets, so that
+// the compilation cache compiles one executable per bucket instead of one per
+// shape when the shapes of the arguments vary across executions.
+//
+// A dimension of an argument is bucketed once it has been seen with two
+// different sizes, so clusters with static shapes keep being compiled for
+// their exact shapes. A bucketed dimension becomes a bounded dynamic dimension
+// of the xla::Shape of the argument: the caller passes the argument padded to
+// the bucket along with its actual sizes, and the executable reports the
+// actual sizes of its results, see DynamicPadder.
+class ShapeBucketer {
+ public:
+  // `boundaries` are the sorted sizes that dimensions are rounded up to.
+  // Sizes above the largest boundary are rounded up to a power of two.
+  explicit ShapeBucketer(std::vector<int64_t> boundaries)
+      : boundaries_(std::move(boundaries)) {}
+
+  // Returns the bucket that `size` is rounded up to.
+  int64_t RoundUp(int64_t size) const;
+
+  // Records the shapes of the parameters of an execution of `cluster`, and
+  // returns `args` where the dimensions that have varied across executions
+  // are rounded up to their bucket.
+  std::vector<XlaCompiler::Argument> BucketArguments(
+      const string& cluster, absl::Span<const XlaCompiler::Argument> args);
+
+  struct BucketStats {
+    // The number of executions that found a compiled executable.
+    int64_t hits = 0;
+    // The number of executions that did not.
+    int64_t misses = 0;
+  };
+
+  // Records whether an execution of `cluster` whose arguments are in
+  // `bucket`, e.g. the HumanString of their signature, found a compiled
+  // executable.
+  void RecordLookup(const string& cluster, const string& bucket, bool hit);
+
+  // Returns the lookups of each bucket of `cluster`.
+  absl::flat_hash_map<string, BucketStats> GetBucketStats(
+      const string& cluster) const;
+
+ private:
+  const std::vector<int64_t> boundaries_;
+
+  mutable mutex mu_;
+  // The sizes of the dimensions of each argument of each cluster, where a
+  // negative size marks a dimension that has varied.
+  absl::flat_hash_map<string, std::vector<std::vector<int64_t>>> sizes_
+      TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<string, absl::flat_hash_map<string, BucketStats>> stats_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShapeBucketer);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
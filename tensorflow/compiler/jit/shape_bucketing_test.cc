@@ -0,0 +1,101 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include "absl/types/variant.h"
+#include "tensorflow/compiler/xla/shape.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+std::vector<XlaCompiler::Argument> ParameterArgs(const TensorShape& shape) {
+  std::vector<XlaCompiler::Argument> args(1);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_FLOAT;
+  args[0].shape = shape;
+  return args;
+}
+
+TEST(ShapeBucketerTest, RoundUp) {
+  ShapeBucketer bucketer({10, 100});
+  EXPECT_EQ(bucketer.RoundUp(1), 10);
+  EXPECT_EQ(bucketer.RoundUp(10), 10);
+  EXPECT_EQ(bucketer.RoundUp(11), 100);
+  EXPECT_EQ(bucketer.RoundUp(101), 128);
+  EXPECT_EQ(bucketer.RoundUp(128), 128);
+}
+
+TEST(ShapeBucketerTest, BucketDimensionsThatVary) {
+  ShapeBucketer bucketer({});
+  std::vector<XlaCompiler::Argument> args = bucketer.BucketArguments(
+      "cluster", ParameterArgs(TensorShape({5, 3})));
+  ASSERT_TRUE(absl::holds_alternative<TensorShape>(args[0].shape));
+  EXPECT_EQ(absl::get<TensorShape>(args[0].shape), TensorShape({5, 3}));
+
+  // Only the first dimension varies, and is rounded up to 8.
+  args = bucketer.BucketArguments("cluster",
+                                  ParameterArgs(TensorShape({6, 3})));
+  ASSERT_TRUE(absl::holds_alternative<xla::Shape>(args[0].shape));
+  const xla::Shape& shape = absl::get<xla::Shape>(args[0].shape);
+  EXPECT_EQ(shape.dimensions(0), 8);
+  EXPECT_TRUE(shape.is_dynamic_dimension(0));
+  EXPECT_EQ(shape.dimensions(1), 3);
+  EXPECT_FALSE(shape.is_dynamic_dimension(1));
+
+  // The first dimension stays bucketed once it has varied.
+  args = bucketer.BucketArguments("cluster",
+                                  ParameterArgs(TensorShape({5, 3})));
+  ASSERT_TRUE(absl::holds_alternative<xla::Shape>(args[0].shape));
+  EXPECT_EQ(absl::get<xla::Shape>(args[0].shape).dimensions(0), 8);
+
+  // Other clusters are tracked separately.
+  args = bucketer.BucketArguments("other_cluster",
+                                  ParameterArgs(TensorShape({6, 3})));
+  EXPECT_TRUE(absl::holds_alternative<TensorShape>(args[0].shape));
+}
+
+TEST(ShapeBucketerTest, DoNotBucketConstants) {
+  ShapeBucketer bucketer({});
+  std::vector<XlaCompiler::Argument> args(1);
+  args[0].kind = XlaCompiler::Argument::kConstant;
+  args[0].type = DT_INT32;
+  for (int64_t size : {2, 3}) {
+    args[0].shape = TensorShape({size});
+    args[0].constant_value = Tensor(DT_INT32, {size});
+    std::vector<XlaCompiler::Argument> bucketed_args =
+        bucketer.BucketArguments("cluster", args);
+    EXPECT_TRUE(absl::holds_alternative<TensorShape>(bucketed_args[0].shape));
+  }
+}
+
+TEST(ShapeBucketerTest, RecordLookups) {
+  ShapeBucketer bucketer({});
+  bucketer.RecordLookup("cluster", "bucket", /*hit=*/false);
+  bucketer.RecordLookup("cluster", "bucket", /*hit=*/true);
+  bucketer.RecordLookup("cluster", "bucket", /*hit=*/true);
+  bucketer.RecordLookup("cluster", "other_bucket", /*hit=*/false);
+  auto stats = bucketer.GetBucketStats("cluster");
+  ASSERT_EQ(stats.size(), 2);
+  EXPECT_EQ(stats["bucket"].hits, 2);
+  EXPECT_EQ(stats["bucket"].misses, 1);
+  EXPECT_EQ(stats["other_bucket"].hits, 0);
+  EXPECT_EQ(stats["other_bucket"].misses, 1);
+  EXPECT_TRUE(bucketer.GetBucketStats("other_cluster").empty());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -37,6 +37,7 @@ limitations under the License.
 namespace tensorflow {
 
 const char* const kXlaClusterAttr = "_XlaCluster";
+const char* const kXlaClusterBenefitUsAttr = "_XlaClusterBenefitUs";
 const char* const kXlaOutsideCompilationAttr = "_XlaOutsideCompilation";
 const char* const kXlaCompileTimeConstantInputsAttr =
     "_XlaCompileTimeConstantInputs";
@@ -323,6 +324,10 @@ namespace {
 struct ClusterInfo {
   int size;
 
+  // The estimated benefit of compiling the cluster, if clustering is cost
+  // based.
+  absl::optional<float> benefit_us;
+
   // Maps op names to the number of times they appear in the cluster.
   absl::flat_hash_map<absl::string_view, int> op_histogram;
 };
@@ -346,6 +351,9 @@ void ClusterInfoToProtobuf(XlaAutoClusteringSummary::Cluster* result,
                            absl::string_view name, const ClusterInfo& info) {
   result->set_name(std::string(name));
   result->set_size(info.size);
+  if (info.benefit_us.has_value()) {
+    result->set_estimated_benefit_us(*info.benefit_us);
+  }
   HistogramMapToRepeatedOpAndCount(result->mutable_op_histogram(),
                                    info.op_histogram);
 }
@@ -364,6 +372,10 @@ XlaAutoClusteringSummary GetXlaAutoClusteringSummary(const Graph& graph) {
       ClusterInfo* info = &cluster_name_to_info[*cluster_name];
       info->size++;
       info->op_histogram[n->type_string()]++;
+      float benefit_us;
+      if (TryGetNodeAttr(n->attrs(), kXlaClusterBenefitUsAttr, &benefit_us)) {
+        info->benefit_us = benefit_us;
+      }
     } else {
       result.set_unclustered_node_count(result.unclustered_node_count() + 1);
       unclustered_op_histogram[n->type_string()]++;
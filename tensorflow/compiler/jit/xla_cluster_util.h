@@ -34,6 +34,11 @@ namespace tensorflow {
 // encapsulate subgraphs pass.
 extern const char* const kXlaClusterAttr;
 
+// The attribute with the benefit of compiling the cluster of a node per
+// execution, in microseconds, as estimated by the cost based clustering of the
+// mark for compilation pass.
+extern const char* const kXlaClusterBenefitUsAttr;
+
 // The attribute that marks nodes in a cluster to be placed outside the xla
 // compilation by the encapsulate subgraphs pass.
 extern const char* const kXlaOutsideCompilationAttr;
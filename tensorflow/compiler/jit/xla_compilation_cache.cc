@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/mlir/mlir_bridge_rollout_policy.h"
 #include "absl/base/call_once.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/types/variant.h"
@@ -123,7 +124,13 @@ constexpr int64_t
 
 XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
                                          DeviceType device_type)
-    : client_(client), device_type_(std::move(device_type)) {}
+    : client_(client),
+      device_type_(std::move(device_type)),
+      shape_bucketer_(GetXlaOpsCommonFlags().tf_xla_shape_bucketing
+                          ? absl::make_unique<ShapeBucketer>(
+                                GetXlaOpsCommonFlags()
+                                    .tf_xla_shape_bucket_boundaries)
+                          : nullptr) {}
 
 XlaCompilationCache::~XlaCompilationCache() {
   // Ensure any use of our programs have completed by waiting for all stream
@@ -196,10 +203,20 @@ StatusOr<XlaCompilationCache::Signature> XlaCompilationCache::BuildSignature(
         signature.args.push_back(arg.constant_value);
         break;
       case XlaCompiler::Argument::kParameter:
-      case XlaCompiler::Argument::kResource:
-        signature.args.push_back(
-            TensorTypeAndShape(arg.type, arg.DimensionSizesAsInlinedVector()));
+      case XlaCompiler::Argument::kResource: {
+        TensorTypeAndShape type_and_shape(arg.type,
+                                          arg.DimensionSizesAsInlinedVector());
+        if (absl::holds_alternative<xla::Shape>(arg.shape)) {
+          const xla::Shape& shape = absl::get<xla::Shape>(arg.shape);
+          for (int dim = 0; dim < type_and_shape.second.size(); ++dim) {
+            if (shape.IsArray() && shape.is_dynamic_dimension(dim)) {
+              type_and_shape.second[dim] = -type_and_shape.second[dim];
+            }
+          }
+        }
+        signature.args.push_back(std::move(type_and_shape));
         break;
+      }
       default:
         return errors::InvalidArgument(
             "Unhandled argument kind in XlaCompilationCache: ",
@@ -572,14 +589,24 @@ Status XlaCompilationCache::CompileImpl(
   DCHECK_NE(out_executable, nullptr);
   VLOG(2) << "XlaCompilationCache::Compile " << DebugString();
 
+  // Executions whose arguments are in the same buckets share a compilation.
+  const bool bucket_shapes =
+      shape_bucketer_ != nullptr && scope == CompileScope::kFunction;
+  std::vector<XlaCompiler::Argument> bucketed_args;
+  if (bucket_shapes) {
+    bucketed_args = shape_bucketer_->BucketArguments(function.name(), args);
+  }
+  const std::vector<XlaCompiler::Argument>& compile_args =
+      bucket_shapes ? bucketed_args : args;
+
   if (VLOG_IS_ON(2)) {
-    VLOG(2) << "num_inputs=" << args.size();
-    for (int i = 0, end = args.size(); i < end; i++) {
-      VLOG(3) << i << ": " << args[i].HumanString();
+    VLOG(2) << "num_inputs=" << compile_args.size();
+    for (int i = 0, end = compile_args.size(); i < end; i++) {
+      VLOG(3) << i << ": " << compile_args[i].HumanString();
     }
   }
-  TF_ASSIGN_OR_RETURN(Signature signature, BuildSignature(function, args));
-
+  TF_ASSIGN_OR_RETURN(Signature signature,
+                      BuildSignature(function, compile_args));
 
   // The outer lock protects the existence of the cache entry. It does not
   // protect the contents of the cache entry.
@@ -645,6 +672,10 @@ Status XlaCompilationCache::CompileImpl(
   CompileState state = entry->compile_state;
   *out_compilation_result = nullptr;
   *out_executable = nullptr;
+  if (bucket_shapes) {
+    shape_bucketer_->RecordLookup(function.name(), signature.HumanString(),
+                                  /*hit=*/state != CompileState::kUncompiled);
+  }
 
   if (state == CompileState::kUncompiled) {
     XLA_SCOPED_LOGGING_TIMER("Compilation of XLA executable");
@@ -656,12 +687,13 @@ Status XlaCompilationCache::CompileImpl(
       VLOG(2) << "Queueing asynchronous compilation for signature: "
               << human_signature;
       TF_RETURN_IF_ERROR(CompileAsynchronous(entry, compile_options, options,
-                                             args, function, ctx, scope));
+                                             compile_args, function, ctx,
+                                             scope));
       return Status::OK();
     } else {
       VLOG(2) << "Instantly compiling for signature: " << human_signature;
-      TF_RETURN_IF_ERROR(CompileStrict(entry, compile_options, options, args,
-                                       function, ctx, scope));
+      TF_RETURN_IF_ERROR(CompileStrict(entry, compile_options, options,
+                                       compile_args, function, ctx, scope));
     }
   } else if (state == CompileState::kCompiling) {
     VLOG(2) << "Ongoing asynchronous compilation for signature: "
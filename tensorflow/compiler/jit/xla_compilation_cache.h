@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
+#include "tensorflow/compiler/jit/shape_bucketing.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -43,6 +44,15 @@ namespace tensorflow {
 //
 // Currently no cache eviction policy is implemented and the cache grows without
 // bound.
+//
+// With --tf_xla_shape_bucketing, the dimensions of arguments that vary across
+// executions of a cluster are rounded up to buckets and compiled as bounded
+// dynamic dimensions, which bounds the number of compilations per cluster.
+//
+// The cache only lives as long as the process. Setting
+// --xla_persistent_compilation_cache_dir in XLA_FLAGS lets the backends reuse
+// the generated code across processes, which removes most of the cost of the
+// cache misses here.
 class XlaCompilationCache : public ResourceBase {
  public:
   XlaCompilationCache(xla::LocalClient* client, DeviceType device_type);
@@ -106,6 +116,10 @@ class XlaCompilationCache : public ResourceBase {
   xla::LocalClient* client() const { return client_; }
   const DeviceType& device_type() const { return device_type_; }
 
+  // Returns the bucketing of the shapes of cluster arguments, or null if
+  // shapes are not bucketed.
+  const ShapeBucketer* shape_bucketer() const { return shape_bucketer_.get(); }
+
   string DebugString() const override;
 
   // Describes the types, shapes and any compile-time constant arguments
@@ -115,7 +129,8 @@ class XlaCompilationCache : public ResourceBase {
 
     // List of args (either as a TensorTypeAndShape or as a Tensor value)
     // for compile-time constant arguments to the compilation, ordered by
-    // argument number. Tensors must be in host memory.
+    // argument number. Tensors must be in host memory. Bounded dynamic
+    // dimensions are recorded as their negated bound.
     using TensorTypeAndShape =
         std::pair<DataType, absl::InlinedVector<int64_t, 4>>;
     absl::InlinedVector<absl::variant<Tensor, TensorTypeAndShape>, 8> args;
@@ -160,6 +175,7 @@ class XlaCompilationCache : public ResourceBase {
 
   xla::LocalClient* const client_;
   const DeviceType device_type_;
+  const std::unique_ptr<ShapeBucketer> shape_bucketer_;
 
   // The value associated with a cache entry.
   struct Entry {
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_launch_util.h"
 
+#include <cstring>
 #include <memory>
 
 #include "absl/algorithm/container.h"
@@ -239,6 +240,41 @@ static void PopulateExecutionInputBuffer(xla::ExecutionInput& execution_input,
   }
 }
 
+// Copies `t` into a new buffer of the bounded dynamic `device_shape`, followed
+// by the sizes of its dimensions, which is where the executable reads them
+// from.
+static StatusOr<se::OwningDeviceMemory> CopyToDynamicShapeBuffer(
+    const Tensor& t, const xla::Shape& device_shape, se::Stream* stream,
+    const xla::TransferManager& transfer_manager, int device_ordinal,
+    se::DeviceMemoryAllocator* allocator) {
+  const int64_t metadata_offset = transfer_manager.GetByteSizeRequirement(
+      xla::ShapeUtil::MakeStaticShape(device_shape));
+  std::vector<int32> sizes(t.shape().dim_sizes().begin(),
+                           t.shape().dim_sizes().end());
+  const int64_t metadata_size = sizes.size() * sizeof(int32);
+  TF_ASSIGN_OR_RETURN(
+      se::OwningDeviceMemory buffer,
+      allocator->Allocate(device_ordinal,
+                          transfer_manager.GetByteSizeRequirement(
+                              device_shape)));
+  TF_RET_CHECK(static_cast<int64_t>(t.TotalBytes()) <= metadata_offset);
+  se::DeviceMemoryBase src = XlaTensor::DeviceMemoryFromTensor(t);
+  if (stream == nullptr) {
+    // Host platforms have no stream, and their buffers are in host memory.
+    char* dst = static_cast<char*>(buffer->opaque());
+    std::memcpy(dst, src.opaque(), t.TotalBytes());
+    std::memcpy(dst + metadata_offset, sizes.data(), metadata_size);
+    return std::move(buffer);
+  }
+  stream->ThenMemcpy(buffer.ptr(), src, t.TotalBytes());
+  se::DeviceMemory<uint8> metadata = stream->parent()->GetSubBuffer(
+      buffer.ptr(), metadata_offset, metadata_size);
+  stream->ThenMemcpy(&metadata, sizes.data(), metadata_size);
+  // `sizes` must outlive the copy.
+  TF_RETURN_IF_ERROR(stream->BlockHostUntilDone());
+  return std::move(buffer);
+}
+
 StatusOr<std::vector<xla::ExecutionInput>>
 XlaComputationLaunchContext::PopulateInputs(
     OpKernelContext* ctx,
@@ -291,6 +327,21 @@ XlaComputationLaunchContext::PopulateInputs(
 
     arguments.emplace_back(device_shape, host_shape);
     xla::ExecutionInput& execution_input = arguments.back();
+    if (device_shape.is_dynamic() && !is_resource_variable) {
+      // Arguments in a shape bucket are passed in a buffer of the size of the
+      // bucket.
+      se::Stream* stream = ctx->op_device_context()
+                               ? ctx->op_device_context()->stream()
+                               : nullptr;
+      TF_ASSIGN_OR_RETURN(
+          se::OwningDeviceMemory buffer,
+          CopyToDynamicShapeBuffer(*t, device_shape, stream,
+                                   *client_->backend().transfer_manager(),
+                                   device_ordinal_, xla_allocator_));
+      *execution_input.MutableBuffer(xla::ShapeIndex{}) =
+          xla::MaybeOwningDeviceMemory(std::move(buffer));
+      continue;
+    }
     se::DeviceMemoryBase dmem = XlaTensor::DeviceMemoryFromTensor(*t);
     PopulateExecutionInputBuffer(execution_input, xla::ShapeIndex{}, dmem,
                                  donate_buffer, device_ordinal_,
@@ -1164,6 +1164,30 @@ bool Conv2DOp::isCompatibleReturnTypes(TypeRange lhs, TypeRange rhs) {
   return true;
 }
 
+// The kernels only support sparse filters of 1x1 convolutions with unit
+// strides and dilations, which they run as fully-connected layers.
+static bool IsSparse1x1Conv2D(Conv2DOp op) {
+  auto filter_ty = op.filter().getType().dyn_cast<RankedTensorType>();
+  return filter_ty && filter_ty.getRank() == 4 &&
+         filter_ty.getDimSize(1) == 1 && filter_ty.getDimSize(2) == 1 &&
+         op.stride_h() == 1 && op.stride_w() == 1 &&
+         op.dilation_h_factor() == 1 && op.dilation_w_factor() == 1;
+}
+
+std::vector<std::vector<int>> Conv2DOp::GetFloatBlockSize() {
+  if (!IsSparse1x1Conv2D(*this)) return {};
+  return {{1, 1, 1, 4}};
+}
+
+std::vector<std::vector<int>> Conv2DOp::GetQuantizedBlockSize() {
+  // Hybrid convolutions have no sparse kernel.
+  if (!IsSparse1x1Conv2D(*this) ||
+      !IsQI8Type(getElementTypeOrSelf(input().getType()))) {
+    return {};
+  }
+  return {{1, 1, 1, 16}};
+}
+
 int64_t Conv2DOp::GetArithmeticCount(Operation *op) {
   int64_t count;
   if (ArithmeticCountUtilHelper::GetArithmeticCountForConvAndFullyconnectedOp(
@@ -24,6 +24,8 @@ limitations under the License.
 #include "tensorflow/compiler/tf2tensorrt/convert/convert_nodes.h"
 #include "tensorflow/compiler/tf2tensorrt/convert/utils.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_allocator.h"
+#include "tensorflow/compiler/tf2tensorrt/utils/trt_engine_disk_cache.h"
+#include "tensorflow/compiler/tf2tensorrt/utils/trt_engine_instance.pb.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_engine_utils.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_logger.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_lru_cache.h"
@@ -38,9 +40,11 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -63,6 +67,12 @@ using ::nvinfer1::IRuntime;
 #define LOG_FIRST_FEW_WARNING_WITH_PREFIX \
   LOG_FIRST_N(WARNING, 5) << "TF-TRT Warning: "
 
+// When the profiles are created from the shapes of live traffic, the fraction
+// of the collected calls whose shapes they cover, and the maximum number of
+// distinct shapes they are created from.
+constexpr double kTrafficShapesCoverage = 0.95;
+constexpr int kMaxTrafficShapes = 8;
+
 // Allocates device memory for an execution context to execute a TensorRT
 // engine and records the relevant information for deallocating the memory when
 // the engine finishes execution.
@@ -171,6 +181,15 @@ class TRTEngineOp : public AsyncOpKernel {
                           const TrtShapeOptimizationProfile& profiles,
                           TRTBaseAllocator* allocator);
 
+  // Binds the inputs and outputs of the call to `execution_context`, and
+  // enqueues the engine with it on `stream`.
+  Status EnqueueTrtEngine(OpKernelContext* ctx,
+                          nvinfer1::ICudaEngine* cuda_engine,
+                          nvinfer1::IExecutionContext* execution_context,
+                          int trt_context_idx, bool has_device_memory,
+                          const TrtShapeOptimizationProfile& profiles,
+                          TRTBaseAllocator* allocator, cudaStream_t stream);
+
   // Allocates necessary resources for calibration.
   Status AllocateCalibrationResources(OpKernelContext* ctx,
                                       TRTEngineCacheResource* cache_res);
@@ -199,6 +218,31 @@ class TRTEngineOp : public AsyncOpKernel {
   // Verify that the input shapes are consistent and can be handled by this op.
   Status VerifyInputShapes(const std::vector<TensorShape>& shapes);
 
+  // Collects the input shapes of the first profile_collection_calls_ calls,
+  // and then creates the profiles from the most frequent of them. Returns true
+  // if the shapes of this call were collected, in which case it should run the
+  // native segment. Creates profiles from the input shapes of this call
+  // instead if the disk cache has an engine with profiles already collected.
+  bool CollectTrafficShapes(
+      const std::vector<TensorShape>& input_concrete_shapes,
+      TRTEngineCacheResource* cache_resource);
+
+  // Returns the key of the engine for the input shapes, or the profiles, in
+  // the disk cache, or an empty string if engines aren't cached on disk.
+  string GetDiskCacheKey(const std::vector<TensorShape>& input_concrete_shapes,
+                         const TRTEngineCacheResource& cache_resource) const;
+
+  // Returns the engine of `key` in the disk cache, with its profiles restored,
+  // or nullptr if the cache has no such engine.
+  TrtUniquePtrType<nvinfer1::ICudaEngine> LoadEngineFromDiskCache(
+      const string& key, OpKernelContext* ctx,
+      TRTEngineCacheResource* cache_resource);
+
+  // Stores `engine` as the engine of `key` in the disk cache.
+  void SaveEngineToDiskCache(
+      const string& key, const std::vector<TensorShape>& input_concrete_shapes,
+      nvinfer1::ICudaEngine* engine);
+
   std::vector<string> input_nodes_;
   std::vector<string> output_nodes_;
 
@@ -231,6 +275,16 @@ class TRTEngineOp : public AsyncOpKernel {
   // Optimization profile generation strategy.
   ProfileStrategy profile_strategy_;
 
+  // The number of calls whose input shapes are collected to create the
+  // profiles from, if the profiles are created from the shapes of live
+  // traffic. Set by TF_TRT_PROFILE_COLLECTION_CALLS.
+  int64 profile_collection_calls_;
+
+  // Identifies everything the engines of the segment depend on but their
+  // input shapes or profiles in the disk cache, or is empty if engines aren't
+  // cached on disk.
+  string disk_cache_key_prefix_;
+
   // Whether the TRTEngineOp has any input with unknown dimensions.
   bool has_dynamic_shape_input_;
 
@@ -245,6 +299,12 @@ class TRTEngineOp : public AsyncOpKernel {
   int max_cached_engines_;
 
   int64 workspace_size_;
+
+  // The number of execution contexts with their own streams that concurrent
+  // calls of an engine without profiles run on, or 0 to run all calls on the
+  // stream of the op. Set by TF_TRT_NUM_EXECUTION_STREAMS.
+  int64 num_execution_streams_;
+
   mutex engine_mutex_;
   FunctionLibraryRuntime::Handle native_execution_func_handle_;
 
@@ -433,6 +493,7 @@ TRTEngineOp::TRTEngineOp(OpKernelConstruction* context)
   calibration_mode_ =
       (use_calibration_ && precision_mode_ == TrtPrecisionMode::INT8 &&
        calibration_data.empty());
+  const uint64 calibration_data_fingerprint = Fingerprint64(calibration_data);
   if (!calibration_data.empty()) {
     calibrator_.reset(new TRTInt8Calibrator(calibration_data));
     calibration_data.resize(0);
@@ -499,6 +560,47 @@ TRTEngineOp::TRTEngineOp(OpKernelConstruction* context)
   VLOG(2) << "TRTEngineOp has_dynamic_shape_input_: "
           << has_dynamic_shape_input_;
 
+  OP_REQUIRES_OK(context, ReadInt64FromEnvVar("TF_TRT_NUM_EXECUTION_STREAMS",
+                                              0, &num_execution_streams_));
+
+  profile_collection_calls_ = 0;
+  if (!use_implicit_batch_ && has_dynamic_shape_input_ && !static_engine_ &&
+      !profile_generation_mode_) {
+    OP_REQUIRES_OK(context,
+                   ReadInt64FromEnvVar("TF_TRT_PROFILE_COLLECTION_CALLS", 0,
+                                       &profile_collection_calls_));
+  }
+
+  // The engines built at runtime are cached on disk, keyed by the segment and
+  // its conversion parameters, the GPU and the TensorRT version.
+  if (!static_engine_ && TrtEngineDiskCache::Get() != nullptr) {
+    string serialized_segment_graph;
+    OP_REQUIRES(context,
+                SerializeToStringDeterministic(segment_graph_def_,
+                                               &serialized_segment_graph),
+                errors::Internal("Failed to serialize the segment of ",
+                                 name()));
+    cudaDeviceProp device_properties;
+    OP_REQUIRES(
+        context,
+        cudaGetDeviceProperties(
+            &device_properties,
+            context->device()->tensorflow_gpu_device_info()->gpu_id) ==
+            cudaSuccess,
+        errors::Internal("Failed to get the properties of the GPU of ",
+                         name()));
+    const std::tuple<int, int, int> trt_version = GetLoadedTensorRTVersion();
+    disk_cache_key_prefix_ = StrCat(
+        Fingerprint64(serialized_segment_graph), ",", precision_string, ",",
+        use_calibration_, ",", calibration_data_fingerprint, ",",
+        workspace_size_, ",", use_implicit_batch_, ",",
+        DebugString(input_partial_shapes_), ",",
+        ProfileStrategyToName(profile_strategy_), ",", device_properties.name,
+        ",", device_properties.major, ".", device_properties.minor, ",",
+        std::get<0>(trt_version), ".", std::get<1>(trt_version), ".",
+        std::get<2>(trt_version));
+  }
+
   if (has_dynamic_shape_input_ && !use_implicit_batch_) {
     OP_REQUIRES(context, !calibration_mode_,
                 errors::InvalidArgument(
@@ -843,13 +945,20 @@ void TRTEngineOp::ComputeAsync(OpKernelContext* ctx,
       ExecuteNativeSegment(ctx, async_helper);
       return;
     } else if (cache_res->profiles_.GetNumProfiles() == 0 && !static_engine_) {
-      // Add current shape if we did not collect any shapes so far.
-      if (!cache_res->profiles_.HasShape()) {
-        cache_res->profiles_.AddShape(input_concrete_shapes);
+      if (profile_collection_calls_ > 0) {
+        if (CollectTrafficShapes(input_concrete_shapes, cache_res)) {
+          ExecuteNativeSegment(ctx, async_helper);
+          return;
+        }
+      } else {
+        // Add current shape if we did not collect any shapes so far.
+        if (!cache_res->profiles_.HasShape()) {
+          cache_res->profiles_.AddShape(input_concrete_shapes);
+        }
+        // Create profiles out of collected shapes during profile generation.
+        cache_res->profiles_.InitProfiles(input_partial_shapes_,
+                                          profile_strategy_);
       }
-      // Create profiles out of collected shapes during profile generation.
-      cache_res->profiles_.InitProfiles(input_partial_shapes_,
-                                        profile_strategy_);
     }
   }
   StatusOr<std::pair<EngineContext*, int>> status =
@@ -925,8 +1034,36 @@ Status TRTEngineOp::ExecuteTrtEngine(
     VLOG(2) << binding_types;
   }
 
-  const int num_binding = cuda_engine->getNbBindings();
-  std::vector<void*> buffers(num_binding);
+  // Copied from gpu_kernel_helper.h as the header can only be used in *.cu.cc
+  // files.
+  const cudaStream_t* stream = CHECK_NOTNULL(
+      reinterpret_cast<const cudaStream_t*>(ctx->op_device_context()
+                                                ->stream()
+                                                ->implementation()
+                                                ->GpuStreamMemberHack()));
+
+  if (num_execution_streams_ > 0 && !profiles.NeedProfiles()) {
+    StreamExecutionContext* stream_context;
+    TF_RETURN_IF_ERROR(engine_context->GetStreamExecutionContext(
+        num_execution_streams_, &stream_context));
+    mutex_lock lock(stream_context->mu);
+    if (cudaEventRecord(stream_context->ready_event, *stream) != cudaSuccess ||
+        cudaStreamWaitEvent(stream_context->stream, stream_context->ready_event,
+                            0) != cudaSuccess) {
+      return errors::Internal("Failed to wait for the inputs of ", name());
+    }
+    TF_RETURN_IF_ERROR(EnqueueTrtEngine(
+        ctx, cuda_engine.get(), stream_context->context.get(),
+        /*trt_context_idx=*/0, /*has_device_memory=*/true, profiles, allocator,
+        stream_context->stream));
+    if (cudaEventRecord(stream_context->done_event, stream_context->stream) !=
+            cudaSuccess ||
+        cudaStreamWaitEvent(*stream, stream_context->done_event, 0) !=
+            cudaSuccess) {
+      return errors::Internal("Failed to wait for the TRT engine of ", name());
+    }
+    return Status::OK();
+  }
 
   // nvinfer1::IExecutionContext::enqueue is not thread safe and we need a mutex
   // for it.
@@ -939,25 +1076,30 @@ Status TRTEngineOp::ExecuteTrtEngine(
   if (VLOG_IS_ON(2)) {
     VLOG(2) << "Selected execution context: " << trt_context_idx;
   }
+  return EnqueueTrtEngine(ctx, cuda_engine.get(), execution_context,
+                          trt_context_idx, has_device_memory, profiles,
+                          allocator, *stream);
+}
+
+Status TRTEngineOp::EnqueueTrtEngine(
+    OpKernelContext* ctx, nvinfer1::ICudaEngine* cuda_engine,
+    nvinfer1::IExecutionContext* execution_context, int trt_context_idx,
+    bool has_device_memory, const TrtShapeOptimizationProfile& profiles,
+    TRTBaseAllocator* allocator, cudaStream_t stream) {
+  const int num_binding = cuda_engine->getNbBindings();
+  std::vector<void*> buffers(num_binding);
   const int num_batch =
       use_implicit_batch_ ? ctx->input(0).shape().dim_size(0) : 0;
 
-  TF_RETURN_IF_ERROR(SetTrtEngineInputs(
-      cuda_engine.get(), execution_context, trt_context_idx, buffers,
-      use_implicit_batch_, num_batch, profiles, ctx));
+  TF_RETURN_IF_ERROR(SetTrtEngineInputs(cuda_engine, execution_context,
+                                        trt_context_idx, buffers,
+                                        use_implicit_batch_, num_batch,
+                                        profiles, ctx));
 
-  TF_RETURN_IF_ERROR(SetTrtEngineOutputs(cuda_engine.get(), execution_context,
+  TF_RETURN_IF_ERROR(SetTrtEngineOutputs(cuda_engine, execution_context,
                                          trt_context_idx, buffers,
                                          use_implicit_batch_, num_batch, ctx));
 
-  // Copied from gpu_kernel_helper.h as the header can only be used in *.cu.cc
-  // files.
-  const cudaStream_t* stream = CHECK_NOTNULL(
-      reinterpret_cast<const cudaStream_t*>(ctx->op_device_context()
-                                                ->stream()
-                                                ->implementation()
-                                                ->GpuStreamMemberHack()));
-
   ContextDeviceMemory context_device_memory;
   if (!has_device_memory) {
     // Allocate device memory for the TensorRT engine execution. The device
@@ -966,7 +1108,7 @@ Status TRTEngineOp::ExecuteTrtEngine(
         execution_context, allocator));
   }
   // Enqueue the TensorRT engine for execution.
-  return TrtEnqueue(execution_context, buffers, *stream, use_implicit_batch_,
+  return TrtEnqueue(execution_context, buffers, stream, use_implicit_batch_,
                     num_batch);
 }
 
@@ -1167,9 +1309,16 @@ StatusOr<std::pair<EngineContext*, int>> TRTEngineOp::GetEngine(
     engine_contexts = cache_res->GetEngineContext(profile_id);
   }
 
-  // If cache does not have a compatible engine then create a new engine.
+  // If cache does not have a compatible engine then load one from the disk
+  // cache, or create a new engine.
   if (engine_contexts == nullptr) {
-    if (!allow_build_at_runtime_) {
+    const string disk_cache_key =
+        GetDiskCacheKey(input_concrete_shapes, *cache_res);
+    TrtUniquePtrType<nvinfer1::ICudaEngine> engine;
+    if (!disk_cache_key.empty()) {
+      engine = LoadEngineFromDiskCache(disk_cache_key, ctx, cache_res);
+    }
+    if (engine == nullptr && !allow_build_at_runtime_) {
       LOG_FIRST_FEW_WARNING_WITH_PREFIX
           << "Found no engine in cache matching input shapes. "
           << "Not building a new engine because "
@@ -1181,15 +1330,20 @@ StatusOr<std::pair<EngineContext*, int>> TRTEngineOp::GetEngine(
       return std::pair<EngineContext*, int>(&empty_context, 0);
     }
 
-    // Up to this point, calibrator_ can never be empty, since otherwise it
-    // means calibration_mode_ is true and this path won't get executed.
-    auto result = BuildEngine(input_concrete_shapes, batch_size,
-                              use_calibration_, calibrator_.get(), cache_res);
-    if (!result.ok()) {
-      return std::pair<EngineContext*, int>(&empty_context, 0);
+    if (engine == nullptr) {
+      // Up to this point, calibrator_ can never be empty, since otherwise it
+      // means calibration_mode_ is true and this path won't get executed.
+      auto result = BuildEngine(input_concrete_shapes, batch_size,
+                                use_calibration_, calibrator_.get(), cache_res);
+      if (!result.ok()) {
+        return std::pair<EngineContext*, int>(&empty_context, 0);
+      }
+      engine = std::move(result.ValueOrDie());
+      if (!disk_cache_key.empty()) {
+        SaveEngineToDiskCache(disk_cache_key, input_concrete_shapes,
+                              engine.get());
+      }
     }
-    TrtUniquePtrType<nvinfer1::ICudaEngine> engine =
-        std::move(result.ValueOrDie());
     std::vector<ExecutionContext> exec_contexts;
     TF_RETURN_IF_ERROR(cache_res->profiles_.CreateExecutionContexts(
         engine.get(), &exec_contexts));
@@ -1206,6 +1360,113 @@ StatusOr<std::pair<EngineContext*, int>> TRTEngineOp::GetEngine(
                                         use_implicit_batch_ ? 0 : profile_id);
 }
 
+bool TRTEngineOp::CollectTrafficShapes(
+    const std::vector<TensorShape>& input_concrete_shapes,
+    TRTEngineCacheResource* cache_resource) {
+  mutex_lock lock(engine_mutex_);
+  TrtShapeOptimizationProfile& profiles = cache_resource->profiles_;
+  if (profiles.GetNumProfiles() > 0) return false;
+  if (cache_resource->num_collected_shapes_ == 0) {
+    const string disk_cache_key =
+        GetDiskCacheKey(input_concrete_shapes, *cache_resource);
+    if (!disk_cache_key.empty() &&
+        TrtEngineDiskCache::Get()->Contains(disk_cache_key)) {
+      // The profiles of the cached engine replace these when it is loaded.
+      VLOG(1) << "Not collecting shapes for the profiles of the cached engine "
+              << "of " << name();
+      profiles.AddShape(input_concrete_shapes);
+      profiles.InitProfiles(input_partial_shapes_, profile_strategy_);
+      return false;
+    }
+  }
+  profiles.AddShape(input_concrete_shapes);
+  if (++cache_resource->num_collected_shapes_ < profile_collection_calls_) {
+    return true;
+  }
+  VLOG(1) << "Creating profiles for " << name() << " from the shapes of "
+          << profile_collection_calls_ << " calls";
+  profiles.KeepMostFrequentShapes(kTrafficShapesCoverage, kMaxTrafficShapes);
+  profiles.InitProfiles(input_partial_shapes_, profile_strategy_);
+  return false;
+}
+
+string TRTEngineOp::GetDiskCacheKey(
+    const std::vector<TensorShape>& input_concrete_shapes,
+    const TRTEngineCacheResource& cache_resource) const {
+  if (disk_cache_key_prefix_.empty()) return "";
+  std::vector<string> parts = {disk_cache_key_prefix_};
+  if (use_implicit_batch_) {
+    parts.push_back(DebugString(input_concrete_shapes));
+  } else if (profile_collection_calls_ > 0) {
+    // The profiles aren't known before the shapes are collected.
+    parts.push_back(StrCat("profiles from the shapes of ",
+                           profile_collection_calls_, " calls"));
+  } else {
+    parts.push_back(cache_resource.profiles_.ProfilesDebugString());
+  }
+  return TrtEngineDiskCache::MakeKey(parts);
+}
+
+TrtUniquePtrType<nvinfer1::ICudaEngine> TRTEngineOp::LoadEngineFromDiskCache(
+    const string& key, OpKernelContext* ctx,
+    TRTEngineCacheResource* cache_resource) {
+  TRTEngineInstance engine_instance;
+  Status status = TrtEngineDiskCache::Get()->Lookup(key, &engine_instance);
+  if (!status.ok()) {
+    if (!errors::IsNotFound(status)) {
+      LOG_FIRST_FEW_WARNING_WITH_PREFIX << "Failed to read the cached engine "
+                                        << "of " << name() << ": " << status;
+    }
+    return nullptr;
+  }
+  TrtUniquePtrType<IRuntime> infer(nvinfer1::createInferRuntime(logger));
+  infer->setGpuAllocator(cache_resource->allocator_.get());
+  // Need to initialize plugins in order to deserialize engines that contain
+  // plugins.
+  MaybeInitializeTrtPlugins(&logger);
+  const string& serialized_engine = engine_instance.serialized_engine();
+  TrtUniquePtrType<nvinfer1::ICudaEngine> engine(infer->deserializeCudaEngine(
+      serialized_engine.data(), serialized_engine.size(), nullptr));
+  if (engine == nullptr) {
+    LOG_FIRST_FEW_WARNING_WITH_PREFIX << "Failed to deserialize the cached "
+                                      << "engine of " << name();
+    return nullptr;
+  }
+  if (!use_implicit_batch_) {
+    status = cache_resource->profiles_.RestoreProfiles(engine.get(),
+                                                       ctx->num_inputs());
+    if (!status.ok()) {
+      LOG_FIRST_FEW_WARNING_WITH_PREFIX << "Failed to restore the profiles of "
+                                        << "the cached engine of " << name()
+                                        << ": " << status;
+      return nullptr;
+    }
+  }
+  VLOG(1) << "Loaded the engine of " << name() << " from the disk cache";
+  return engine;
+}
+
+void TRTEngineOp::SaveEngineToDiskCache(
+    const string& key, const std::vector<TensorShape>& input_concrete_shapes,
+    nvinfer1::ICudaEngine* engine) {
+  TrtUniquePtrType<nvinfer1::IHostMemory> serialized_engine(
+      engine->serialize());
+  if (serialized_engine == nullptr) return;
+  TRTEngineInstance engine_instance;
+  for (const TensorShape& shape : input_concrete_shapes) {
+    shape.AsProto(engine_instance.add_input_shapes());
+  }
+  engine_instance.set_serialized_engine(
+      static_cast<const char*>(serialized_engine->data()),
+      serialized_engine->size());
+  const Status status =
+      TrtEngineDiskCache::Get()->Insert(key, engine_instance);
+  if (!status.ok()) {
+    LOG_FIRST_FEW_WARNING_WITH_PREFIX << "Failed to cache the engine of "
+                                      << name() << ": " << status;
+  }
+}
+
 // TODO(hinsu): Move this allocation to CalibrationContext constructor, if
 // possible.
 Status TRTEngineOp::AllocateCalibrationResources(
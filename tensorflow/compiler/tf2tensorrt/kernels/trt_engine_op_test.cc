@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstdlib>
 #include <memory>
 #include <numeric>
 #include <utility>
@@ -346,6 +347,33 @@ TEST_P(TRTEngineOpTestWithParam, DynamicShapes) {
   EXPECT_EQ(0, cache->count({TensorShape({1, 37})}));
 }
 
+TEST_F(TRTEngineOpTestBase, ExecutionStreams) {
+  setenv("TF_TRT_NUM_EXECUTION_STREAMS", "2", /*overwrite=*/1);
+  TRTEngineOpTestBase::AddSimpleTrtOp(DT_FLOAT);
+  unsetenv("TF_TRT_NUM_EXECUTION_STREAMS");
+
+  // Each call runs on the next stream, so the third reuses the first one.
+  for (int i = 0; i < 3; ++i) {
+    ResetInputs();
+    OpsTestBase::AddInputFromArray<float>(TensorShape({1, 2}),
+                                          {static_cast<float>(i), 1.0f});
+    TF_ASSERT_OK(OpsTestBase::RunOpKernel());
+    Tensor* output = OpsTestBase::GetOutput(0);
+    EXPECT_THAT(absl::Span<const float>(output->flat<float>().data(),
+                                        output->NumElements()),
+                ElementsAre(2.0f * i, 2.0f));
+  }
+
+  TRTEngineCacheResource* cache_resource = nullptr;
+  TF_ASSERT_OK(device_->resource_manager()->Lookup(
+      std::string(kTfTrtContainerName), std::string(kOpName), &cache_resource));
+  core::ScopedUnref sc(cache_resource);
+  ASSERT_EQ(1, cache_resource->cache_.size());
+  EngineContext* ectx = cache_resource->cache_.begin()->second.get();
+  mutex_lock lock(ectx->mu);
+  EXPECT_EQ(2, ectx->stream_contexts.size());
+}
+
 template <typename T>
 class TRTEngineOpTest : public TRTEngineOpTestBase {};
 
@@ -0,0 +1,90 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/tf2tensorrt/utils/trt_engine_disk_cache.h"
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace tensorrt {
+
+TrtEngineDiskCache* TrtEngineDiskCache::Get() {
+  static TrtEngineDiskCache* cache = []() -> TrtEngineDiskCache* {
+    string directory;
+    TF_CHECK_OK(
+        ReadStringFromEnvVar("TF_TRT_ENGINE_CACHE_DIR", "", &directory));
+    if (directory.empty()) return nullptr;
+    const Status status = Env::Default()->RecursivelyCreateDir(directory);
+    if (!status.ok()) {
+      LOG(WARNING) << "TF-TRT Warning: Not caching engines in " << directory
+                   << ": " << status;
+      return nullptr;
+    }
+    VLOG(1) << "Caching TensorRT engines in " << directory;
+    return new TrtEngineDiskCache(directory);
+  }();
+  return cache;
+}
+
+TrtEngineDiskCache::TrtEngineDiskCache(const string& directory)
+    : directory_(directory) {}
+
+string TrtEngineDiskCache::MakeKey(const std::vector<string>& parts) {
+  const Fprint128 fingerprint = Fingerprint128(absl::StrJoin(parts, "\n"));
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+string TrtEngineDiskCache::GetPath(const string& key) const {
+  return io::JoinPath(directory_, absl::StrCat(key, ".trt_engine"));
+}
+
+bool TrtEngineDiskCache::Contains(const string& key) const {
+  return Env::Default()->FileExists(GetPath(key)).ok();
+}
+
+Status TrtEngineDiskCache::Lookup(const string& key,
+                                  TRTEngineInstance* engine) const {
+  const string path = GetPath(key);
+  if (!Env::Default()->FileExists(path).ok()) {
+    return errors::NotFound("No cached engine in ", path);
+  }
+  return ReadBinaryProto(Env::Default(), path, engine);
+}
+
+Status TrtEngineDiskCache::Insert(const string& key,
+                                  const TRTEngineInstance& engine) {
+  const string path = GetPath(key);
+  // Each writer has its own temporary file, which is renamed to replace the
+  // engine at once.
+  string tmp_path = path;
+  if (!Env::Default()->CreateUniqueFileName(&tmp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file for ", path);
+  }
+  TF_RETURN_IF_ERROR(WriteBinaryProto(Env::Default(), tmp_path, engine));
+  const Status status = Env::Default()->RenameFile(tmp_path, path);
+  if (!status.ok()) Env::Default()->DeleteFile(tmp_path).IgnoreError();
+  return status;
+}
+
+}  // namespace tensorrt
+}  // namespace tensorflow
@@ -0,0 +1,66 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_TF2TENSORRT_UTILS_TRT_ENGINE_DISK_CACHE_H_
+#define TENSORFLOW_COMPILER_TF2TENSORRT_UTILS_TRT_ENGINE_DISK_CACHE_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/tf2tensorrt/utils/trt_engine_instance.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace tensorrt {
+
+// A directory of serialized TensorRT engines, so that the engines built by a
+// process are reused when it restarts instead of being built again.
+//
+// Each engine is stored in a file named after its key, which must identify
+// everything the engine depends on: the segment, its precision and input
+// shapes or profiles, the GPU and the TensorRT version.
+class TrtEngineDiskCache {
+ public:
+  // Returns the cache in the directory set by the TF_TRT_ENGINE_CACHE_DIR
+  // environment variable, or nullptr if it isn't set.
+  static TrtEngineDiskCache* Get();
+
+  explicit TrtEngineDiskCache(const string& directory);
+
+  // Returns the key of the engine that depends on `parts`.
+  static string MakeKey(const std::vector<string>& parts);
+
+  // Returns true if the cache has the engine of `key`.
+  bool Contains(const string& key) const;
+
+  // Reads the engine of `key` into `engine`. Returns NotFound if the cache
+  // has no such engine.
+  Status Lookup(const string& key, TRTEngineInstance* engine) const;
+
+  // Stores `engine` as the engine of `key`. Concurrent readers see either the
+  // previous engine or the whole new one.
+  Status Insert(const string& key, const TRTEngineInstance& engine);
+
+ private:
+  string GetPath(const string& key) const;
+
+  const string directory_;
+};
+
+}  // namespace tensorrt
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_TF2TENSORRT_UTILS_TRT_ENGINE_DISK_CACHE_H_
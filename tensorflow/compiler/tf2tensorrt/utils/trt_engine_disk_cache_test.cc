@@ -0,0 +1,66 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/tf2tensorrt/utils/trt_engine_disk_cache.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace tensorrt {
+
+TEST(TrtEngineDiskCacheTest, MakesKeysFromParts) {
+  const string key = TrtEngineDiskCache::MakeKey({"segment", "FP16"});
+  EXPECT_EQ(key.size(), 32);
+  EXPECT_EQ(key, TrtEngineDiskCache::MakeKey({"segment", "FP16"}));
+  EXPECT_NE(key, TrtEngineDiskCache::MakeKey({"segment", "FP32"}));
+  EXPECT_NE(key, TrtEngineDiskCache::MakeKey({"segmentFP16"}));
+}
+
+TEST(TrtEngineDiskCacheTest, StoresEngines) {
+  const string directory = io::JoinPath(testing::TmpDir(), "trt_engine_cache");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(directory));
+  TrtEngineDiskCache cache(directory);
+  const string key = TrtEngineDiskCache::MakeKey({"segment"});
+  EXPECT_FALSE(cache.Contains(key));
+  TRTEngineInstance engine;
+  EXPECT_TRUE(errors::IsNotFound(cache.Lookup(key, &engine)));
+
+  engine.set_serialized_engine("engine");
+  engine.add_input_shapes()->add_dim()->set_size(8);
+  TF_ASSERT_OK(cache.Insert(key, engine));
+  engine.set_serialized_engine("new engine");
+  TF_ASSERT_OK(cache.Insert(key, engine));
+  EXPECT_TRUE(cache.Contains(key));
+
+  // A cache of the same directory, e.g. after a restart, has the engine.
+  TrtEngineDiskCache restarted_cache(directory);
+  TRTEngineInstance cached_engine;
+  TF_ASSERT_OK(restarted_cache.Lookup(key, &cached_engine));
+  EXPECT_EQ(cached_engine.serialized_engine(), "new engine");
+  ASSERT_EQ(cached_engine.input_shapes_size(), 1);
+  EXPECT_EQ(cached_engine.input_shapes(0).dim(0).size(), 8);
+
+  // No temporary files are left behind.
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(directory, &children));
+  EXPECT_EQ(children.size(), 1);
+}
+
+}  // namespace tensorrt
+}  // namespace tensorflow
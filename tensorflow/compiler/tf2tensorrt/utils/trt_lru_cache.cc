@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <sstream>
 
+#include "absl/memory/memory.h"
 #include "tensorflow/compiler/tf2tensorrt/utils/trt_allocator.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -29,6 +30,55 @@ limitations under the License.
 namespace tensorflow {
 namespace tensorrt {
 
+StreamExecutionContext::~StreamExecutionContext() {
+  if (stream != nullptr) {
+    cudaStreamSynchronize(stream);
+    cudaStreamDestroy(stream);
+  }
+  if (ready_event != nullptr) cudaEventDestroy(ready_event);
+  if (done_event != nullptr) cudaEventDestroy(done_event);
+}
+
+Status StreamExecutionContext::Create(
+    nvinfer1::ICudaEngine* cuda_engine,
+    std::unique_ptr<StreamExecutionContext>* context) {
+  ExecutionContext execution_context(cuda_engine->createExecutionContext(),
+                                     /*has_memory=*/true);
+  if (execution_context == nullptr) {
+    return errors::Internal("Failed to create a TRT execution context");
+  }
+  auto result =
+      absl::make_unique<StreamExecutionContext>(std::move(execution_context));
+  if (cudaStreamCreateWithFlags(&result->stream, cudaStreamNonBlocking) !=
+          cudaSuccess ||
+      cudaEventCreateWithFlags(&result->ready_event, cudaEventDisableTiming) !=
+          cudaSuccess ||
+      cudaEventCreateWithFlags(&result->done_event, cudaEventDisableTiming) !=
+          cudaSuccess) {
+    return errors::Internal("Failed to create the stream of a TRT execution "
+                            "context");
+  }
+  *context = std::move(result);
+  return Status::OK();
+}
+
+Status EngineContext::GetStreamExecutionContext(
+    int max_stream_contexts, StreamExecutionContext** stream_context) {
+  mutex_lock lock(mu);
+  const int idx = next_stream_context;
+  if (idx == stream_contexts.size()) {
+    std::unique_ptr<StreamExecutionContext> context;
+    TF_RETURN_IF_ERROR(
+        StreamExecutionContext::Create(cuda_engine.get(), &context));
+    VLOG(1) << "Created TRT execution context " << idx << " with its own "
+            << "stream";
+    stream_contexts.push_back(std::move(context));
+  }
+  next_stream_context = (idx + 1) % max_stream_contexts;
+  *stream_context = stream_contexts[idx].get();
+  return Status::OK();
+}
+
 string CalibrationContext::TerminateCalibration() {
   mutex_lock l(mu_);
   if (terminated_) return calibration_table_;
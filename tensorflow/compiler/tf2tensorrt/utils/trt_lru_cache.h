@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 
 #if GOOGLE_CUDA && GOOGLE_TENSORRT
+#include "third_party/gpus/cuda/include/cuda_runtime_api.h"
 #include "third_party/tensorrt/NvInfer.h"
 #endif  // GOOGLE_CUDA && GOOGLE_TENSORRT
 
@@ -118,6 +119,30 @@ class LRUCache {
 
 #if GOOGLE_CUDA && GOOGLE_TENSORRT
 
+// An execution context with a stream of its own, so that concurrent calls can
+// run an engine in parallel instead of one after another on the stream of the
+// op. The stream waits for the work enqueued on the stream of the op before the
+// call through ready_event, and the stream of the op waits for the engine
+// through done_event.
+struct StreamExecutionContext {
+  explicit StreamExecutionContext(ExecutionContext&& context)
+      : context(std::move(context)) {}
+  ~StreamExecutionContext();
+
+  // Creates an execution context of `cuda_engine` with its own device memory,
+  // since the memory allocated for a call is only ordered with the stream of
+  // the op.
+  static Status Create(nvinfer1::ICudaEngine* cuda_engine,
+                       std::unique_ptr<StreamExecutionContext>* context);
+
+  // Only one call at a time can enqueue the engine with the context.
+  mutex mu;
+  ExecutionContext context;
+  cudaStream_t stream = nullptr;
+  cudaEvent_t ready_event = nullptr;
+  cudaEvent_t done_event = nullptr;
+};
+
 struct EngineContext {
   EngineContext() {}  // Creates an empty context.
   EngineContext(TrtUniquePtrType<nvinfer1::ICudaEngine>&& cuda_engine,
@@ -151,6 +176,12 @@ struct EngineContext {
     return execution_contexts.size();
   }
 
+  // Returns the next of up to `max_stream_contexts` execution contexts with
+  // their own streams, in turn, creating it on first use. Only for engines
+  // without optimization profiles, since concurrent contexts can't share one.
+  Status GetStreamExecutionContext(int max_stream_contexts,
+                                   StreamExecutionContext** stream_context);
+
   // In explicit batch mode, we maintain a vector of contexts for each engine,
   // where each context is created for a specific profile. This is because it is
   // either not possible or non-trivial to change the profile of a context for
@@ -165,6 +196,10 @@ struct EngineContext {
   // Additional discussion about execution context management and thread safety
   // at https://github.com/tensorflow/tensorflow/issues/36959
   std::vector<ExecutionContext> execution_contexts TF_GUARDED_BY(mu);
+
+  std::vector<std::unique_ptr<StreamExecutionContext>> stream_contexts
+      TF_GUARDED_BY(mu);
+  int next_stream_context TF_GUARDED_BY(mu) = 0;
 };
 
 // Contains the context required to build the calibration data.
@@ -233,6 +268,10 @@ class TRTEngineCacheResource : public ResourceBase {
   // generation and engine build. During runtime the list of profiles is used to
   // look up a matching profile for the input data.
   TrtShapeOptimizationProfile profiles_;
+
+  // The number of calls whose input shapes were added to profiles_, when the
+  // profiles are created from the shapes of live traffic.
+  int64 num_collected_shapes_ = 0;
 };
 
 #endif  // GOOGLE_CUDA && GOOGLE_TENSORRT
@@ -17,8 +17,10 @@ limitations under the License.
 
 #include <algorithm>
 #include <functional>
+#include <unordered_map>
 
 #include "absl/algorithm/container.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/tf2tensorrt/common/utils.h"
 #include "tensorflow/compiler/tf2tensorrt/convert/utils.h"
 #include "tensorflow/core/platform/stream_executor.h"
@@ -242,6 +244,48 @@ bool AlreadyCollected(const std::vector<std::vector<nvinfer1::Dims>>& values,
   return false;
 }
 
+void TrtShapeOptimizationProfile::KeepMostFrequentShapes(double coverage,
+                                                         int max_shapes) {
+  struct CollectedShapes {
+    int index;  // Of the first call with the shapes.
+    int64 num_calls;
+  };
+  std::unordered_map<string, CollectedShapes> shapes_by_key;
+  for (int i = 0; i < input_shapes_.size(); i++) {
+    const string key = absl::StrCat(DebugString(input_shapes_[i]), ",",
+                              DebugString(input_shape_values_[i]));
+    auto it = shapes_by_key.emplace(key, CollectedShapes{i, 0}).first;
+    it->second.num_calls++;
+  }
+  std::vector<CollectedShapes> collected;
+  for (const auto& key_and_shapes : shapes_by_key) {
+    collected.push_back(key_and_shapes.second);
+  }
+  std::sort(collected.begin(), collected.end(),
+            [](const CollectedShapes& a, const CollectedShapes& b) {
+              return a.num_calls != b.num_calls ? a.num_calls > b.num_calls
+                                                : a.index < b.index;
+            });
+
+  std::vector<std::vector<TensorShape>> input_shapes;
+  std::vector<std::vector<nvinfer1::Dims>> input_shape_values;
+  int64 num_covered_calls = 0;
+  for (const CollectedShapes& shapes : collected) {
+    if (input_shapes.size() >= max_shapes ||
+        num_covered_calls >= coverage * input_shapes_.size()) {
+      break;
+    }
+    input_shapes.push_back(input_shapes_[shapes.index]);
+    input_shape_values.push_back(input_shape_values_[shapes.index]);
+    num_covered_calls += shapes.num_calls;
+  }
+  VLOG(1) << "Kept " << input_shapes.size() << " of " << collected.size()
+          << " collected shapes, of " << num_covered_calls << " of "
+          << input_shapes_.size() << " calls.";
+  input_shapes_.swap(input_shapes);
+  input_shape_values_.swap(input_shape_values);
+}
+
 void TrtShapeOptimizationProfile::InitProfiles(
     const std::vector<PartialTensorShape>& input_partial_shapes,
     ProfileStrategy strategy) {
@@ -540,6 +584,8 @@ Status TrtShapeOptimizationProfile::RestoreProfiles(
 
   TF_RETURN_IF_ERROR(SetPrunedMask(engine, n_network_inputs));
 
+  // The profiles of the engine replace those created from collected shapes.
+  profiles_.clear();
   for (int prof_idx = 0; prof_idx < n_profiles; prof_idx++) {
     OptimizationProfileConfig cfg;
 
@@ -575,6 +621,14 @@ Status TrtShapeOptimizationProfile::RestoreProfiles(
   return Status::OK();
 }
 
+string TrtShapeOptimizationProfile::ProfilesDebugString() const {
+  string profiles;
+  for (const OptimizationProfileConfig& profile : profiles_) {
+    absl::StrAppend(&profiles, profile.DebugString(), ";");
+  }
+  return profiles;
+}
+
 int TrtShapeOptimizationProfile::GetNumProfiles() const {
   return profiles_.size();
 }
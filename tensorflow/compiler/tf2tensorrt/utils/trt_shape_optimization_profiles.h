@@ -196,6 +196,12 @@ class TrtShapeOptimizationProfile {
   // Collects ShapeTensorCompatible tensor values, used only for unit tests.
   Status CollectShapeValues(const DataVec& input);
 
+  // Keeps only the most frequent of the collected shapes, as few as cover
+  // `coverage` of the calls they were collected from and at most `max_shapes`,
+  // so that profiles created from the shapes of live traffic serve most of it
+  // without being widened by rare shapes.
+  void KeepMostFrequentShapes(double coverage, int max_shapes);
+
   void clear() { profiles_.clear(); }
 
   // Returns the profile number that should be used to execute the network with
@@ -226,6 +232,9 @@ class TrtShapeOptimizationProfile {
   // Returns number of created profiles.
   int GetNumProfiles() const;
 
+  // Returns the min/opt/max dimensions of the created profiles.
+  string ProfilesDebugString() const;
+
   bool HasShape() const { return !input_shapes_.empty(); }
   bool NeedProfiles() const { return need_profiles_; }
 
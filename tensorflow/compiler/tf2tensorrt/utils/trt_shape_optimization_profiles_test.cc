@@ -245,6 +245,44 @@ TEST_P(TrtShapeOptimizationProfileTest, Dynamic) {
   CheckProfile(unseen_shapes, &profile, has_prof, false);
 }
 
+TEST_P(TrtShapeOptimizationProfileTest, KeepsMostFrequentShapes) {
+  // The profiles of one shape each are checked only once.
+  if (strategy_ != ProfileStrategy::kOptimal) return;
+
+  nvinfer1::Dims3 dims(-1, -1, 10);
+  DefineNetwork(network_.get(), dims);
+
+  // Shapes collected from 10 calls, 8 of which have the two most frequent.
+  TrtShapeOptimizationProfile profile;
+  std::vector<std::pair<std::vector<nvinfer1::Dims3>, int>> traffic{
+      {{nvinfer1::Dims3(2, 2, 10), nvinfer1::Dims3(2, 2, 10)}, 1},
+      {{nvinfer1::Dims3(8, 8, 10), nvinfer1::Dims3(8, 8, 10)}, 5},
+      {{nvinfer1::Dims3(4, 4, 10), nvinfer1::Dims3(4, 4, 10)}, 3},
+      {{nvinfer1::Dims3(16, 16, 10), nvinfer1::Dims3(16, 16, 10)}, 1},
+  };
+  for (const auto& shapes_and_calls : traffic) {
+    for (int i = 0; i < shapes_and_calls.second; i++) {
+      profile.AddShape(DimVecToShapeVec(shapes_and_calls.first, true));
+    }
+  }
+  profile.KeepMostFrequentShapes(/*coverage=*/0.8, /*max_shapes=*/4);
+  std::vector<PartialTensorShape> input_partial_shapes;
+  TF_CHECK_OK(GetNetworkInputShapes(network_.get(), &input_partial_shapes));
+  profile.InitProfiles(input_partial_shapes, strategy_);
+  EXPECT_EQ(profile.GetNumProfiles(), 2);
+
+  TF_CHECK_OK(profile.ConfigureBuilder(builder_.get(), builder_config_.get(),
+                                       network_.get()));
+  engine = TrtUniquePtrType<nvinfer1::ICudaEngine>(
+      builder_->buildEngineWithConfig(*network_.get(), *builder_config_.get()));
+  ASSERT_NE(nullptr, engine);
+  TF_CHECK_OK(profile.CreateExecutionContexts(engine.get(), &exec_contexts_));
+  CheckProfile(traffic[1].first, &profile, true, true);
+  CheckProfile(traffic[2].first, &profile, true, true);
+  CheckProfile(traffic[0].first, &profile, false, false);
+  CheckProfile(traffic[3].first, &profile, false, false);
+}
+
 }  // namespace tensorrt
 }  // namespace tensorflow
 
@@ -865,6 +865,18 @@ Status XlaCompiler::XLAShapeForArgument(
         TF_RETURN_IF_ERROR(RewriteLayoutWithShardedShape(
             arg_sharding, /*use_fast_memory=*/false,
             options_.shape_representation_fn, xla_shape));
+        // Keep the bounded dynamic dimensions of the argument, e.g. of the
+        // shape buckets of the compilation cache.
+        if (absl::holds_alternative<xla::Shape>(arg.shape)) {
+          const xla::Shape& arg_shape = absl::get<xla::Shape>(arg.shape);
+          if (xla_shape->IsArray() && xla_shape->rank() == arg_shape.rank()) {
+            for (int dim = 0; dim < arg_shape.rank(); ++dim) {
+              if (arg_shape.is_dynamic_dimension(dim)) {
+                xla_shape->set_dynamic_dimension(dim, true);
+              }
+            }
+          }
+        }
       } else {
         if (absl::holds_alternative<xla::Shape>(arg.shape)) {
           *xla_shape = absl::get<xla::Shape>(arg.shape);
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/service_executable_run_options.h"
 #include "tensorflow/compiler/xla/service/source_map_util.h"
 #include "tensorflow/compiler/xla/service/stream_pool.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 
 using xla::source_map_util::InvalidParameterArgument;
@@ -414,6 +415,40 @@ StatusOr<ScopedShapedBuffer> LocalClient::LiteralToShapedBuffer(
   return std::move(scoped_buffer);
 }
 
+StatusOr<ExecutionInput> LocalClient::LiteralToExecutionInput(
+    const LiteralSlice& literal, int device_ordinal,
+    se::DeviceMemoryAllocator* allocator) {
+  const TransferManager* transfer_manager = backend().transfer_manager();
+  const Shape& shape = literal.shape();
+  if (shape.IsArray() &&
+      ShapeUtil::Equal(transfer_manager->HostShapeToDeviceShape(shape),
+                       shape) &&
+      transfer_manager->CanUseHostBufferAsDeviceBuffer(literal.untyped_data(),
+                                                       shape)) {
+    ExecutionInput input(shape);
+    // Executables only write to the arguments they own.
+    input.SetUnownedBuffer(
+        {}, MaybeOwningDeviceMemory(se::DeviceMemoryBase(
+                const_cast<void*>(literal.untyped_data()),
+                literal.size_bytes())));
+    return std::move(input);
+  }
+  TF_ASSIGN_OR_RETURN(
+      ScopedShapedBuffer shaped_buffer,
+      LiteralToShapedBuffer(literal, device_ordinal, allocator));
+  ExecutionInput input(shaped_buffer.on_device_shape());
+  ShapedBuffer buffer = shaped_buffer.release();
+  se::DeviceMemoryAllocator* memory_allocator =
+      allocator != nullptr ? allocator : backend().memory_allocator();
+  for (auto& index_buffer : buffer.buffers()) {
+    input.SetBuffer(index_buffer.first,
+                    MaybeOwningDeviceMemory(se::OwningDeviceMemory(
+                        index_buffer.second, device_ordinal,
+                        memory_allocator)));
+  }
+  return std::move(input);
+}
+
 StatusOr<Literal> LocalClient::ShapedBufferToLiteral(
     const ShapedBuffer& shaped_buffer) {
   TF_ASSIGN_OR_RETURN(auto stream, mutable_backend()->BorrowStream(
@@ -422,6 +457,14 @@ StatusOr<Literal> LocalClient::ShapedBufferToLiteral(
                                                                  shaped_buffer);
 }
 
+Status LocalClient::ShapedBufferToLiteral(const ShapedBuffer& shaped_buffer,
+                                          MutableBorrowingLiteral literal) {
+  TF_ASSIGN_OR_RETURN(auto stream, mutable_backend()->BorrowStream(
+                                       shaped_buffer.device_ordinal()));
+  return backend().transfer_manager()->TransferLiteralFromDevice(
+      stream.get(), shaped_buffer, literal);
+}
+
 StatusOr<const ShapedBuffer*> LocalClient::GlobalDataToShapedBuffer(
     const GlobalDataHandle& data, int replica_number) {
   return local_service_->GlobalDataToShapedBuffer(data, replica_number);
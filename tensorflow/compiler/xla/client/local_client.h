@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/client/executable_build_options.h"
 #include "tensorflow/compiler/xla/client/xla_computation.h"
 #include "tensorflow/compiler/xla/executable_run_options.h"
+#include "tensorflow/compiler/xla/literal.h"
 #include "tensorflow/compiler/xla/service/compiler.h"
 #include "tensorflow/compiler/xla/service/executable.h"
 #include "tensorflow/compiler/xla/service/hlo.pb.h"
@@ -153,6 +154,17 @@ class LocalClient : public Client {
       const LiteralSlice& literal, int device_ordinal,
       se::DeviceMemoryAllocator* allocator = nullptr);
 
+  // Returns an argument for LocalExecutable::Run that holds the data of
+  // `literal`, e.g. a BorrowingLiteral over the host buffer of a framework
+  // tensor. If the device with the given ordinal can use the host memory of
+  // `literal`, as the CPU can when it is suitably aligned, the argument
+  // borrows that memory without a copy, and `literal` must outlive the
+  // execution. Otherwise the argument owns a copy of `literal` on the device,
+  // as in LiteralToShapedBuffer.
+  StatusOr<ExecutionInput> LiteralToExecutionInput(
+      const LiteralSlice& literal, int device_ordinal,
+      se::DeviceMemoryAllocator* allocator = nullptr);
+
   // Transfer the BorrowingLiteral to the device with the given ordinal.
   StatusOr<TransferToServerResponse> TransferToLocalServer(
       const ::xla::BorrowingLiteral& literal, int device_ordinal);
@@ -161,6 +173,12 @@ class LocalClient : public Client {
   // return as a Literal.
   StatusOr<Literal> ShapedBufferToLiteral(const ShapedBuffer& shaped_buffer);
 
+  // As above, but copies the data into the host memory that `literal`
+  // borrows, whose shape must be compatible with the on-host shape of
+  // `shaped_buffer`.
+  Status ShapedBufferToLiteral(const ShapedBuffer& shaped_buffer,
+                               MutableBorrowingLiteral literal);
+
   // Converts a GlobalDataHandle into a pointer to a ShapedBuffer that's valid
   // as long as the handle is valid.
   StatusOr<const ShapedBuffer*> GlobalDataToShapedBuffer(
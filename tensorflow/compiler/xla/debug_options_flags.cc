@@ -74,10 +74,12 @@ DebugOptions DefaultDebugOptionsIgnoringFlags() {
   opts.set_xla_allow_excess_precision(true);
   opts.set_xla_force_host_platform_device_count(1);
   opts.set_xla_gpu_all_reduce_combine_threshold_bytes(30 * 1024 * 1024);
+  opts.set_xla_gpu_collective_pipelining_memory_limit_bytes(1024 * 1024 * 1024);
   opts.set_xla_cpu_enable_xprof_traceme(false);
   opts.set_xla_gpu_unsafe_fallback_to_driver_on_ptxas_not_found(false);
   opts.set_xla_multiheap_size_constraint_per_heap(-1);
   opts.set_xla_detailed_logging_and_dumping(true);
+  opts.set_xla_persistent_compilation_cache_max_bytes(int64_t{4} << 30);
   return opts;
 }
 
@@ -334,6 +336,12 @@ static void AllocateFlags() {
       "Comma-separated list of hlo passes to be enabled. These names must "
       "exactly match the passes' names; no whitespace around commas. The "
       "unspecified passes are all disabled."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_hlo_pass_statistics",
+      bool_setter_for(&DebugOptions::set_xla_hlo_pass_statistics),
+      flag_values->xla_hlo_pass_statistics(),
+      "Logs the run time, the change in the number of instructions and the "
+      "growth of the peak RSS of each HLO pass at the end of each pipeline."));
   flag_objects->push_back(tensorflow::Flag(
       "xla_disable_all_hlo_passes",
       bool_setter_for(&DebugOptions::set_xla_disable_all_hlo_passes), false,
@@ -638,6 +646,39 @@ static void AllocateFlags() {
       flag_values->xla_gpu_force_compilation_parallelism(),
       "Overrides normal multi-threaded compilation settting to use this many "
       "threads. Setting to 0 (the default value) means no enforcement."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cpu_compilation_parallelism",
+      int32_setter_for(&DebugOptions::set_xla_cpu_compilation_parallelism),
+      flag_values->xla_cpu_compilation_parallelism(),
+      "Number of threads used to generate code for XLA:CPU modules. Setting "
+      "to 0 (the default value) uses the thread pool of the compile options, "
+      "if any, and 1 disables parallel code generation."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cpu_parallel_task_budget",
+      int32_setter_for(&DebugOptions::set_xla_cpu_parallel_task_budget),
+      flag_values->xla_cpu_parallel_task_budget(),
+      "Maximum number of parallel tasks assigned to an XLA:CPU instruction. "
+      "Values <= 0 (the default value) use the intra-op parallelism."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cpu_parallel_task_throughput",
+      string_setter_for(&DebugOptions::set_xla_cpu_parallel_task_throughput),
+      flag_values->xla_cpu_parallel_task_throughput(),
+      "Comma-separated name=value throughputs of the target used by the "
+      "XLA:CPU parallel task cost model: flops_per_ns, "
+      "transcendentals_per_ns, bytes_per_ns, max_bytes_per_ns and "
+      "min_task_ns."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_cuda_graphs",
+      bool_setter_for(&DebugOptions::set_xla_gpu_enable_cuda_graphs),
+      flag_values->xla_gpu_enable_cuda_graphs(),
+      "Captures the thunks of XLA:GPU executables into CUDA graphs on their "
+      "first run and replays the graphs on later runs."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_autotune_database_path",
+      string_setter_for(&DebugOptions::set_xla_gpu_autotune_database_path),
+      flag_values->xla_gpu_autotune_database_path(),
+      "An AutotuneDatabaseProto file whose GEMM and convolution autotuning "
+      "results are reused, and into which new results are merged."));
   flag_objects->push_back(tensorflow::Flag(
       "xla_gpu_deterministic_ops",
       bool_setter_for(&DebugOptions::set_xla_gpu_deterministic_ops),
@@ -654,6 +695,41 @@ static void AllocateFlags() {
           &DebugOptions::set_xla_gpu_all_reduce_combine_threshold_bytes),
       flag_values->xla_gpu_all_reduce_combine_threshold_bytes(),
       "Size threshold (in bytes) for the GPU all-reduce combiner."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_collective_pipelining_depth",
+      int32_setter_for(&DebugOptions::set_xla_gpu_collective_pipelining_depth),
+      flag_values->xla_gpu_collective_pipelining_depth(),
+      "Number of iterations ahead that the collectives of while loops are "
+      "issued, if their operands only depend on the induction variable and "
+      "loop invariant values. 0 disables pipelining."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_collective_pipelining_memory_limit_bytes",
+      int64_setter_for(
+          &DebugOptions::set_xla_gpu_collective_pipelining_memory_limit_bytes),
+      flag_values->xla_gpu_collective_pipelining_memory_limit_bytes(),
+      "Size (in bytes) of the results of pipelined collectives that the state "
+      "of a while loop may carry."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_collective_latency_ns",
+      int64_setter_for(&DebugOptions::set_xla_gpu_collective_latency_ns),
+      flag_values->xla_gpu_collective_latency_ns(),
+      "Latency (in nanoseconds) of collectives, which the combiners use with "
+      "xla_gpu_collective_bandwidth_bytes_per_second to only combine "
+      "collectives when that is estimated not to delay the computation."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_collective_bandwidth_bytes_per_second",
+      int64_setter_for(
+          &DebugOptions::set_xla_gpu_collective_bandwidth_bytes_per_second),
+      flag_values->xla_gpu_collective_bandwidth_bytes_per_second(),
+      "Bandwidth (in bytes of the result per second) of collectives, see "
+      "xla_gpu_collective_latency_ns."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_kernel_launch_overhead_ns",
+      int64_setter_for(&DebugOptions::set_xla_gpu_kernel_launch_overhead_ns),
+      flag_values->xla_gpu_kernel_launch_overhead_ns(),
+      "Launch overhead (in nanoseconds) of kernels. If set, horizontal loop "
+      "fusion fuses the kernels that are estimated to run faster than they "
+      "launch, instead of using fixed size limits."));
   flag_objects->push_back(tensorflow::Flag(
       "xla_gpu_all_reduce_contiguous",
       bool_setter_for(&DebugOptions::set_xla_gpu_all_reduce_contiguous),
@@ -681,6 +757,20 @@ static void AllocateFlags() {
       flag_values->xla_dump_hlo_pipeline_re(),
       "If specified, dumps HLO before and after optimization passes in the "
       "pass pipelines that match this regular expression."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_persistent_compilation_cache_dir",
+      string_setter_for(
+          &DebugOptions::set_xla_persistent_compilation_cache_dir),
+      flag_values->xla_persistent_compilation_cache_dir(),
+      "If non-empty, backends keep the code they generate in this directory "
+      "and reuse it across processes when the same code is compiled again."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_persistent_compilation_cache_max_bytes",
+      int64_setter_for(
+          &DebugOptions::set_xla_persistent_compilation_cache_max_bytes),
+      flag_values->xla_persistent_compilation_cache_max_bytes(),
+      "Size above which the oldest entries of the persistent compilation "
+      "cache are evicted."));
 
   ParseFlagsFromEnvAndDieIfUnknown("XLA_FLAGS", *flag_objects);
 }  // NOLINT(readability/fn_size)
@@ -0,0 +1,179 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "tensorflow/compiler/xla/pjrt/gpu_device.h"
+#include "tensorflow/compiler/xla/pjrt/pjrt_client.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/test.h"
+
+namespace xla {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+// BufferFromHostBuffers on GPU stages host buffers of up to this many S32
+// elements together, and transfers larger ones in chunks of kChunkElements.
+constexpr int64_t kCoalescedElements = (256 << 10) / sizeof(int32);
+constexpr int64_t kChunkElements = (4 << 20) / sizeof(int32);
+
+// The values and dimensions of a host buffer.
+struct HostData {
+  std::vector<int64_t> dims;
+  std::vector<int32> values;
+};
+
+HostData MakeHostData(std::vector<int64_t> dims, int32 first_value) {
+  HostData data;
+  data.values.resize(std::accumulate(dims.begin(), dims.end(), int64_t{1},
+                                     std::multiplies<int64_t>()));
+  std::iota(data.values.begin(), data.values.end(), first_value);
+  data.dims = std::move(dims);
+  return data;
+}
+
+// Returns the PjRtClient::HostBuffers of `batch`, whose
+// `on_done_with_host_buffer` is `on_done`.
+std::vector<PjRtClient::HostBuffer> MakeHostBuffers(
+    const std::vector<HostData>& batch, std::function<void()> on_done) {
+  std::vector<PjRtClient::HostBuffer> host_buffers;
+  for (const HostData& data : batch) {
+    host_buffers.push_back({data.values.data(), S32, data.dims, on_done});
+  }
+  return host_buffers;
+}
+
+class GpuHostBuffersTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    TF_ASSERT_OK_AND_ASSIGN(
+        client_, GetGpuClient(/*asynchronous=*/true, GpuAllocatorConfig(),
+                              /*distributed_client=*/nullptr, /*node_id=*/0));
+    device_ = client_->addressable_devices().at(0);
+  }
+
+  // Transfers `batch`, and checks that each of the returned buffers holds the
+  // values of its host buffer, and that every host buffer is done with.
+  void TransferAndCheck(const std::vector<HostData>& batch) {
+    absl::BlockingCounter done_counter(batch.size());
+    TF_ASSERT_OK_AND_ASSIGN(
+        std::vector<std::unique_ptr<PjRtBuffer>> buffers,
+        client_->BufferFromHostBuffers(
+            MakeHostBuffers(batch,
+                            [&done_counter]() {
+                              done_counter.DecrementCount();
+                            }),
+            PjRtClient::HostBufferSemantics::kImmutableUntilTransferCompletes,
+            device_));
+    ExpectBuffersEqual(batch, buffers);
+    done_counter.Wait();
+  }
+
+  void ExpectBuffersEqual(
+      const std::vector<HostData>& expected,
+      const std::vector<std::unique_ptr<PjRtBuffer>>& buffers) {
+    ASSERT_EQ(buffers.size(), expected.size());
+    for (int i = 0; i < buffers.size(); ++i) {
+      SCOPED_TRACE(i);
+      EXPECT_EQ(buffers[i]->device(), device_);
+      EXPECT_EQ(
+          buffers[i]->on_device_shape(),
+          ShapeUtil::MakeShapeWithDescendingLayout(S32, expected[i].dims));
+      TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> literal,
+                              buffers[i]->ToLiteral());
+      EXPECT_THAT(literal->data<int32>(),
+                  ElementsAreArray(expected[i].values));
+    }
+  }
+
+  std::unique_ptr<PjRtClient> client_;
+  PjRtDevice* device_ = nullptr;
+};
+
+TEST_F(GpuHostBuffersTest, SmallBuffers) {
+  std::vector<HostData> batch;
+  // Sizes that are not multiples of the staging alignment, empty buffers,
+  // and a buffer of the largest size that is staged together.
+  batch.push_back(MakeHostData({1}, 1));
+  batch.push_back(MakeHostData({3}, 10));
+  batch.push_back(MakeHostData({0}, 0));
+  batch.push_back(MakeHostData({}, 42));
+  batch.push_back(MakeHostData({7, 9}, 100));
+  batch.push_back(MakeHostData({kCoalescedElements}, -5));
+  batch.push_back(MakeHostData({17}, 1000));
+  TransferAndCheck(batch);
+}
+
+TEST_F(GpuHostBuffersTest, LargeBuffers) {
+  std::vector<HostData> batch;
+  // Sizes just above the coalescing threshold, at and around the chunk size,
+  // and of several chunks and a partial one.
+  batch.push_back(MakeHostData({kCoalescedElements + 1}, 1));
+  batch.push_back(MakeHostData({kChunkElements - 1}, 2));
+  batch.push_back(MakeHostData({kChunkElements}, 3));
+  batch.push_back(MakeHostData({kChunkElements + 1}, 4));
+  batch.push_back(MakeHostData({3, kChunkElements / 2 + 5}, 5));
+  TransferAndCheck(batch);
+}
+
+TEST_F(GpuHostBuffersTest, MixedBuffers) {
+  std::vector<HostData> batch;
+  // The returned buffers are in the order of the host buffers, however they
+  // are grouped for the transfers.
+  batch.push_back(MakeHostData({2 * kChunkElements + 3}, 1));
+  batch.push_back(MakeHostData({5}, 2));
+  batch.push_back(MakeHostData({kCoalescedElements + 1}, 3));
+  batch.push_back(MakeHostData({0}, 0));
+  batch.push_back(MakeHostData({4, 4}, 4));
+  batch.push_back(MakeHostData({kChunkElements}, 5));
+  batch.push_back(MakeHostData({kCoalescedElements}, 6));
+  TransferAndCheck(batch);
+}
+
+TEST_F(GpuHostBuffersTest, EmptyBatch) {
+  TransferAndCheck({});
+}
+
+TEST_F(GpuHostBuffersTest, ImmutableOnlyDuringCall) {
+  std::vector<HostData> batch;
+  batch.push_back(MakeHostData({3}, 1));
+  batch.push_back(MakeHostData({2 * kChunkElements + 3}, 2));
+  batch.push_back(MakeHostData({kCoalescedElements}, 3));
+  batch.push_back(MakeHostData({kChunkElements + 1}, 4));
+  const std::vector<HostData> expected = batch;
+  std::atomic<int> num_done{0};
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::unique_ptr<PjRtBuffer>> buffers,
+      client_->BufferFromHostBuffers(
+          MakeHostBuffers(batch, [&num_done]() { ++num_done; }),
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall, device_));
+  // The host buffers are done with when the call returns, so overwriting them
+  // must not change the transferred values.
+  EXPECT_EQ(num_done.load(), static_cast<int>(batch.size()));
+  for (HostData& data : batch) {
+    std::fill(data.values.begin(), data.values.end(), -1);
+  }
+  ExpectBuffersEqual(expected, buffers);
+}
+
+}  // namespace
+}  // namespace xla
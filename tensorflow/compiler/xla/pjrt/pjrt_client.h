@@ -430,6 +430,29 @@ class PjRtClient {
       HostBufferSemantics host_buffer_semantics,
       std::function<void()> on_done_with_host_buffer, PjRtDevice* device) = 0;
 
+  // A dense host buffer with dimensions in major-to-minor order, together with
+  // its optional `on_done_with_host_buffer`, see BufferFromHostBuffer.
+  struct HostBuffer {
+    const void* data;
+    PrimitiveType type;
+    absl::Span<int64_t const> dims;
+    std::function<void()> on_done_with_host_buffer;
+  };
+
+  // Transfers a batch of host buffers to `device`, e.g. the parameters of a
+  // model or the inputs of an execution, and returns one PjRtBuffer per host
+  // buffer. Each returned buffer becomes ready as soon as its own transfer
+  // completes, so consumers of the first buffers need not wait for the whole
+  // batch. Implementations may amortize the per-transfer overheads of
+  // BufferFromHostBuffer across the batch, e.g. by staging small buffers
+  // together and by pipelining the staging and the transfer of large buffers.
+  //
+  // The default implementation calls BufferFromHostBuffer once per buffer.
+  virtual StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>>
+  BufferFromHostBuffers(absl::Span<const HostBuffer> host_buffers,
+                        HostBufferSemantics host_buffer_semantics,
+                        PjRtDevice* device);
+
   // Note that literal must remain in scope until the transfer has completed, so
   // the caller should, for example, wait for BlockHostUntilReady() completes on
   // the return value before letting literal go out of scope.
@@ -0,0 +1,137 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/pjrt/pjrt_client.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "tensorflow/compiler/xla/pjrt/cpu_device.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/test.h"
+
+namespace xla {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+// The values and dimensions of a host buffer.
+struct HostData {
+  std::vector<int64_t> dims;
+  std::vector<int32> values;
+};
+
+HostData MakeHostData(std::vector<int64_t> dims, int32 first_value) {
+  HostData data;
+  data.values.resize(std::accumulate(dims.begin(), dims.end(), int64_t{1},
+                                     std::multiplies<int64_t>()));
+  std::iota(data.values.begin(), data.values.end(), first_value);
+  data.dims = std::move(dims);
+  return data;
+}
+
+std::vector<HostData> MakeHostBatch() {
+  std::vector<HostData> batch;
+  batch.push_back(MakeHostData({3}, 0));
+  batch.push_back(MakeHostData({0}, 0));
+  batch.push_back(MakeHostData({16, 17}, 100));
+  batch.push_back(MakeHostData({}, 42));
+  batch.push_back(MakeHostData({1 << 16}, -7));
+  return batch;
+}
+
+// Returns the PjRtClient::HostBuffers of `batch`, whose
+// `on_done_with_host_buffer` is `on_done`.
+std::vector<PjRtClient::HostBuffer> MakeHostBuffers(
+    const std::vector<HostData>& batch, std::function<void()> on_done) {
+  std::vector<PjRtClient::HostBuffer> host_buffers;
+  for (const HostData& data : batch) {
+    host_buffers.push_back({data.values.data(), S32, data.dims, on_done});
+  }
+  return host_buffers;
+}
+
+void ExpectBuffersEqual(
+    const std::vector<HostData>& expected,
+    const std::vector<std::unique_ptr<PjRtBuffer>>& buffers) {
+  ASSERT_EQ(buffers.size(), expected.size());
+  for (int i = 0; i < buffers.size(); ++i) {
+    SCOPED_TRACE(i);
+    EXPECT_EQ(buffers[i]->on_device_shape(),
+              ShapeUtil::MakeShapeWithDescendingLayout(S32, expected[i].dims));
+    TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> literal,
+                            buffers[i]->ToLiteral());
+    EXPECT_THAT(literal->data<int32>(), ElementsAreArray(expected[i].values));
+  }
+}
+
+// The CPU client uses the default BufferFromHostBuffers.
+TEST(PjRtClientTest, BufferFromHostBuffers) {
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PjRtClient> client,
+                          GetCpuClient(/*asynchronous=*/true));
+  PjRtDevice* device = client->addressable_devices().at(0);
+  const std::vector<HostData> batch = MakeHostBatch();
+  absl::BlockingCounter done_counter(batch.size());
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::unique_ptr<PjRtBuffer>> buffers,
+      client->BufferFromHostBuffers(
+          MakeHostBuffers(batch,
+                          [&done_counter]() { done_counter.DecrementCount(); }),
+          PjRtClient::HostBufferSemantics::kImmutableUntilTransferCompletes,
+          device));
+  for (const auto& buffer : buffers) EXPECT_EQ(buffer->device(), device);
+  ExpectBuffersEqual(batch, buffers);
+  done_counter.Wait();
+}
+
+TEST(PjRtClientTest, BufferFromHostBuffersImmutableOnlyDuringCall) {
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PjRtClient> client,
+                          GetCpuClient(/*asynchronous=*/true));
+  std::vector<HostData> batch = MakeHostBatch();
+  const std::vector<HostData> expected = batch;
+  std::atomic<int> num_done{0};
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::unique_ptr<PjRtBuffer>> buffers,
+      client->BufferFromHostBuffers(
+          MakeHostBuffers(batch, [&num_done]() { ++num_done; }),
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+          client->addressable_devices().at(0)));
+  // The host buffers are done with when the call returns.
+  EXPECT_EQ(num_done.load(), static_cast<int>(batch.size()));
+  for (HostData& data : batch) {
+    std::fill(data.values.begin(), data.values.end(), -1);
+  }
+  ExpectBuffersEqual(expected, buffers);
+}
+
+TEST(PjRtClientTest, BufferFromHostBuffersEmptyBatch) {
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PjRtClient> client,
+                          GetCpuClient(/*asynchronous=*/true));
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::unique_ptr<PjRtBuffer>> buffers,
+      client->BufferFromHostBuffers(
+          /*host_buffers=*/{},
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+          client->addressable_devices().at(0)));
+  EXPECT_TRUE(buffers.empty());
+}
+
+}  // namespace
+}  // namespace xla
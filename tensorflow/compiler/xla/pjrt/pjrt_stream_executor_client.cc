@@ -894,6 +894,244 @@ PjRtStreamExecutorClient::BufferFromHostBuffer(
   return std::unique_ptr<PjRtBuffer>(std::move(py_buffer));
 }
 
+namespace {
+
+// BufferFromHostBuffers stages the host buffers of up to this size together.
+constexpr int64_t kCoalescedTransferBytes = 256 << 10;
+
+// BufferFromHostBuffers transfers larger host buffers in chunks of this size.
+constexpr int64_t kTransferChunkBytes = 4 << 20;
+
+std::shared_ptr<void> AllocateStagingBuffer(
+    tensorflow::Allocator* host_memory_allocator, int64_t size) {
+  void* ptr = host_memory_allocator->AllocateRaw(
+      tensorflow::Allocator::kAllocatorAlignment, size);
+  return std::shared_ptr<void>(ptr, [host_memory_allocator](void* ptr) {
+    host_memory_allocator->DeallocateRaw(ptr);
+  });
+}
+
+// A transfer of BufferFromHostBuffers into a destination buffer.
+struct HostToDeviceTransfer {
+  const char* data;
+  int64_t size;
+  PjRtStreamExecutorBuffer* buffer;
+  // A usage hold on `buffer` until the transfer is enqueued.
+  PjRtStreamExecutorBuffer::ScopedHold::ForClosure device_buffer;
+  std::function<void()> on_done_with_host_buffer;
+  // The staged copy of `data`, if it was staged before the transfer.
+  std::shared_ptr<void> staging_buffer;
+};
+
+}  // namespace
+
+StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>>
+PjRtStreamExecutorClient::BufferFromHostBuffers(
+    absl::Span<const HostBuffer> host_buffers,
+    HostBufferSemantics host_buffer_semantics, PjRtDevice* device) {
+  tensorflow::profiler::TraceMe traceme(
+      "PjRtStreamExecutorClient::BufferFromHostBuffers");
+  // Device memory can only be addressed piecewise on GPU. On CPU,
+  // BufferFromHostBuffer avoids the transfers when it can.
+  if (platform_id() != kGpuId) {
+    return PjRtClient::BufferFromHostBuffers(host_buffers,
+                                             host_buffer_semantics, device);
+  }
+  VLOG(1) << "PjRtStreamExecutorClient::BufferFromHostBuffers: "
+          << host_buffers.size() << " buffers, device: "
+          << device->DebugString();
+  TF_ASSIGN_OR_RETURN(LocalDeviceState * local_device,
+                      tensorflow::down_cast<PjRtStreamExecutorDevice*>(device)
+                          ->GetLocalDeviceState());
+  TransferManager* transfer_manager = client()->backend().transfer_manager();
+  se::Stream* stream = local_device->host_to_device_stream();
+  bool stage_during_call =
+      host_buffer_semantics == HostBufferSemantics::kImmutableOnlyDuringCall;
+  bool stage = stage_during_call || should_stage_host_to_device_transfers();
+
+  std::vector<std::unique_ptr<PjRtBuffer>> buffers;
+  buffers.reserve(host_buffers.size());
+  std::vector<HostToDeviceTransfer> small_transfers;
+  std::vector<HostToDeviceTransfer> large_transfers;
+  int64_t coalesced_size = 0;
+  for (const HostBuffer& host_buffer : host_buffers) {
+    Shape shape = ShapeUtil::MakeShape(host_buffer.type, host_buffer.dims);
+    TF_ASSIGN_OR_RETURN(Shape compact_shape,
+                        transfer_manager->ChooseCompactLayoutForShape(shape));
+    int64_t size = ShapeUtil::ByteSizeOf(shape);
+    // Buffers whose on-device layout differs from the on-host layout are
+    // transposed by BufferFromHostBuffer.
+    if (!ShapeUtil::Equal(compact_shape, shape) ||
+        !ShapeUtil::Equal(
+            transfer_manager->HostShapeToDeviceShape(compact_shape), shape)) {
+      TF_ASSIGN_OR_RETURN(
+          std::unique_ptr<PjRtBuffer> buffer,
+          BufferFromHostBuffer(host_buffer.data, host_buffer.type,
+                               host_buffer.dims,
+                               /*byte_strides=*/absl::nullopt,
+                               host_buffer_semantics,
+                               host_buffer.on_done_with_host_buffer, device));
+      buffers.push_back(std::move(buffer));
+      continue;
+    }
+    TF_ASSIGN_OR_RETURN(
+        std::unique_ptr<PjRtStreamExecutorBuffer> py_buffer,
+        AllocateDestinationBuffer(compact_shape, device, local_device, stream,
+                                  /*is_uninitialized_create=*/false, this));
+    HostToDeviceTransfer transfer{static_cast<const char*>(host_buffer.data),
+                                  size,
+                                  py_buffer.get(),
+                                  /*device_buffer=*/{},
+                                  host_buffer.on_done_with_host_buffer,
+                                  /*staging_buffer=*/nullptr};
+    if (size <= kCoalescedTransferBytes) {
+      coalesced_size += RoundUpTo<int64_t>(
+          size, tensorflow::Allocator::kAllocatorAlignment);
+      small_transfers.push_back(std::move(transfer));
+    } else {
+      large_transfers.push_back(std::move(transfer));
+    }
+    buffers.push_back(std::move(py_buffer));
+  }
+  // Only hold the buffers once nothing can fail, so that they can be freed on
+  // errors.
+  for (auto* transfers : {&small_transfers, &large_transfers}) {
+    for (HostToDeviceTransfer& transfer : *transfers) {
+      PjRtStreamExecutorBuffer::ScopedHold device_buffer(
+          transfer.buffer->GetBufferWithUsageHold());
+      CHECK(device_buffer.ok());
+      transfer.device_buffer = device_buffer.ToClosure();
+    }
+  }
+
+  // The small buffers share a staging buffer, that is released once all of
+  // them are transferred.
+  std::shared_ptr<void> coalesced_staging_buffer;
+  if (stage && coalesced_size > 0) {
+    coalesced_staging_buffer =
+        AllocateStagingBuffer(host_memory_allocator(), coalesced_size);
+    char* staging_data = static_cast<char*>(coalesced_staging_buffer.get());
+    for (HostToDeviceTransfer& transfer : small_transfers) {
+      transfer.staging_buffer =
+          std::shared_ptr<void>(coalesced_staging_buffer, staging_data);
+      staging_data += RoundUpTo<int64_t>(
+          transfer.size, tensorflow::Allocator::kAllocatorAlignment);
+    }
+  }
+  // Copy the buffers before returning control to the caller if the caller only
+  // guaranteed that they are valid for the duration of the call. Otherwise,
+  // the large buffers are staged chunk by chunk on a separate thread.
+  auto copy_to_staging_buffer = [](HostToDeviceTransfer& transfer) {
+    if (transfer.staging_buffer) {
+      std::memcpy(transfer.staging_buffer.get(), transfer.data, transfer.size);
+    }
+    if (transfer.on_done_with_host_buffer) {
+      transfer.on_done_with_host_buffer();
+      transfer.on_done_with_host_buffer = nullptr;
+    }
+  };
+  if (stage_during_call) {
+    for (HostToDeviceTransfer& transfer : small_transfers) {
+      copy_to_staging_buffer(transfer);
+    }
+    for (HostToDeviceTransfer& transfer : large_transfers) {
+      transfer.staging_buffer =
+          AllocateStagingBuffer(host_memory_allocator(), transfer.size);
+      copy_to_staging_buffer(transfer);
+    }
+  }
+
+  // As in BufferFromHostBuffer, the transfers may not fail in ways we could
+  // report, so this function uses TF_CHECK_OK.
+  auto transfer_h2d = [local_device, stream, stage, stage_during_call,
+                       host_memory_allocator = host_memory_allocator(),
+                       small_transfers{std::move(small_transfers)},
+                       large_transfers{std::move(large_transfers)},
+                       coalesced_staging_buffer{
+                           std::move(coalesced_staging_buffer)}]() mutable {
+    // Enqueues the definition event of the buffer of `transfer` after its
+    // transfers, and releases `data` once they complete.
+    auto finish_transfer = [&](HostToDeviceTransfer& transfer,
+                               PjRtStreamExecutorBuffer::ScopedHold
+                                   device_buffer) {
+      std::shared_ptr<BufferSequencingEvent> event =
+          device_buffer->definition_events()[0];
+      TF_CHECK_OK(AddDestinationBufferSynchronization(
+          local_device, std::move(device_buffer), event, stream));
+      if (transfer.on_done_with_host_buffer) {
+        local_device->ThenExecuteCallback(
+            stream, std::move(transfer.on_done_with_host_buffer));
+      }
+    };
+
+    std::vector<PjRtStreamExecutorBuffer::ScopedHold> small_device_buffers;
+    small_device_buffers.reserve(small_transfers.size());
+    for (HostToDeviceTransfer& transfer : small_transfers) {
+      if (transfer.staging_buffer && !stage_during_call) {
+        std::memcpy(transfer.staging_buffer.get(), transfer.data,
+                    transfer.size);
+      }
+      small_device_buffers.emplace_back(transfer.device_buffer);
+      se::DeviceMemoryBase device_memory =
+          small_device_buffers.back()->device_memory()[0];
+      const void* data = transfer.data;
+      if (transfer.staging_buffer) {
+        data = transfer.staging_buffer.get();
+      }
+      if (transfer.size > 0) {
+        stream->ThenMemcpy(&device_memory, data, transfer.size);
+      }
+    }
+    for (int i = 0; i < small_transfers.size(); ++i) {
+      finish_transfer(small_transfers[i], std::move(small_device_buffers[i]));
+    }
+    if (coalesced_staging_buffer) {
+      local_device->ThenExecuteCallback(
+          stream, [coalesced_staging_buffer{
+                      std::move(coalesced_staging_buffer)}]() {});
+    }
+
+    for (HostToDeviceTransfer& transfer : large_transfers) {
+      PjRtStreamExecutorBuffer::ScopedHold device_buffer(
+          transfer.device_buffer);
+      se::DeviceMemoryBase device_memory = device_buffer->device_memory()[0];
+      for (int64_t offset = 0; offset < transfer.size;
+           offset += kTransferChunkBytes) {
+        int64_t chunk_size =
+            std::min(kTransferChunkBytes, transfer.size - offset);
+        const void* chunk_data = transfer.data + offset;
+        std::shared_ptr<void> chunk_staging_buffer;
+        if (transfer.staging_buffer) {
+          chunk_data =
+              static_cast<const char*>(transfer.staging_buffer.get()) + offset;
+        } else if (stage) {
+          chunk_staging_buffer =
+              AllocateStagingBuffer(host_memory_allocator, chunk_size);
+          std::memcpy(chunk_staging_buffer.get(), chunk_data, chunk_size);
+          chunk_data = chunk_staging_buffer.get();
+        }
+        se::DeviceMemoryBase chunk_memory(
+            static_cast<char*>(device_memory.opaque()) + offset, chunk_size);
+        stream->ThenMemcpy(&chunk_memory, chunk_data, chunk_size);
+        if (chunk_staging_buffer) {
+          // Release the chunk once it is transferred, so that its memory can
+          // be reused for the next chunks.
+          local_device->ThenExecuteCallback(
+              stream,
+              [chunk_staging_buffer{std::move(chunk_staging_buffer)}]() {});
+        }
+      }
+      finish_transfer(transfer, std::move(device_buffer));
+      if (transfer.staging_buffer) {
+        local_device->ThenExecuteCallback(
+            stream, [staging_buffer{std::move(transfer.staging_buffer)}]() {});
+      }
+    }
+  };
+  thread_pool()->Schedule(std::move(transfer_h2d));
+  return buffers;
+}
+
 StatusOr<std::unique_ptr<PjRtBuffer>>
 PjRtStreamExecutorClient::CreateUninitializedBuffer(const Shape& shape,
                                                     PjRtDevice* device) {
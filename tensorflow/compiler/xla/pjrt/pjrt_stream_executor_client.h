@@ -216,6 +216,13 @@ class PjRtStreamExecutorClient : public PjRtClient {
       std::function<void()> on_done_with_host_buffer,
       PjRtDevice* device) override;
 
+  // On GPU, stages the host buffers of up to 256KiB together and transfers
+  // them in one batch, and stages and transfers larger host buffers in chunks
+  // of 4MiB so that staging a chunk overlaps with the transfer of the last.
+  StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>> BufferFromHostBuffers(
+      absl::Span<const HostBuffer> host_buffers,
+      HostBufferSemantics host_buffer_semantics, PjRtDevice* device) override;
+
   StatusOr<std::unique_ptr<PjRtBuffer>> BufferFromHostLiteral(
       const LiteralSlice& literal, PjRtDevice* device) override;
 
@@ -133,10 +133,12 @@ absl::optional<GroupKey> CombineKey(const HloInstruction* instruction,
 
 }  // namespace
 
-AllGatherCombiner::AllGatherCombiner(int64_t combine_threshold_in_bytes,
-                                     int64_t combine_threshold_count)
+AllGatherCombiner::AllGatherCombiner(
+    int64_t combine_threshold_in_bytes, int64_t combine_threshold_count,
+    absl::optional<CollectiveCostModel> cost_model)
     : combine_threshold_in_bytes_(combine_threshold_in_bytes),
-      combine_threshold_count_(combine_threshold_count) {}
+      combine_threshold_count_(combine_threshold_count),
+      cost_model_(std::move(cost_model)) {}
 
 StatusOr<bool> AllGatherCombiner::Run(HloModule* module) {
   VLOG(1) << "Running AllGatherCombiner with threshold of "
@@ -166,7 +168,8 @@ StatusOr<bool> AllGatherCombiner::Run(HloModule* module) {
         bool computation_changed,
         CombineInstructionsByKey<GroupKey>(
             computation, key_fn, &CombineAllGathers,
-            combine_threshold_in_bytes_, combine_threshold_count_));
+            combine_threshold_in_bytes_, combine_threshold_count_,
+            cost_model_.has_value() ? &*cost_model_ : nullptr));
     changed |= computation_changed;
   }
 
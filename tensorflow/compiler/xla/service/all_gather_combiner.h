@@ -17,7 +17,9 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_ALL_GATHER_COMBINER_H_
 
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/array2d.h"
+#include "tensorflow/compiler/xla/service/collective_cost_model.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
 #include "tensorflow/compiler/xla/statusor.h"
@@ -31,8 +33,12 @@ namespace xla {
 // more efficient than many small ones.
 class AllGatherCombiner : public HloModulePass {
  public:
-  AllGatherCombiner(int64_t combine_threshold_in_bytes,
-                    int64_t combine_threshold_count);
+  // If `cost_model` is given, all gather ops are only combined up to the
+  // thresholds while that is estimated not to delay the computation, see
+  // CombineInstructionsByKey.
+  AllGatherCombiner(
+      int64_t combine_threshold_in_bytes, int64_t combine_threshold_count,
+      absl::optional<CollectiveCostModel> cost_model = absl::nullopt);
 
   absl::string_view name() const override { return "all-gather-combiner"; }
 
@@ -44,6 +50,8 @@ class AllGatherCombiner : public HloModulePass {
 
   // Combine all gather ops up to this threshold (number of operands).
   int64_t combine_threshold_count_;
+
+  absl::optional<CollectiveCostModel> cost_model_;
 };
 
 }  // namespace xla
@@ -319,5 +319,72 @@ ENTRY entry {
   EXPECT_FALSE(changed);
 }
 
+CollectiveCostModel TestCostModel() {
+  CollectiveCostModel cost_model;
+  cost_model.latency_seconds = 1e-5;
+  cost_model.seconds_per_byte = 1e-9;
+  cost_model.flops_per_second = 1e12;
+  cost_model.bytes_per_second = 1e11;
+  return cost_model;
+}
+
+// Combining all-gathers that are ready at the same time saves a latency.
+TEST_F(AllGatherCombinerTest, CostModelCombinesIndependentAllGathers) {
+  const char* const hlo_string = R"(
+HloModule Module
+
+ENTRY entry {
+  param0 = f32[32] parameter(0)
+  param1 = f32[32] parameter(1)
+  allgather0 = f32[128] all-gather(param0), replica_groups={}, dimensions={0}
+  allgather1 = f32[128] all-gather(param1), replica_groups={}, dimensions={0}
+  ROOT tuple = (f32[128], f32[128]) tuple(allgather0, allgather1)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+
+  AllGatherCombiner combine(1024 * 1024, kMaxCombineCount, TestCostModel());
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, combine.Run(module.get()));
+  EXPECT_TRUE(changed);
+  EXPECT_EQ(AllGatherCount(*module), 1);
+}
+
+// The operand of allgather1 is only ready after a long dot, and combining it
+// with allgather0 would delay the dot that uses allgather0.
+TEST_F(AllGatherCombinerTest, CostModelDoesNotDelayCriticalPath) {
+  const char* const hlo_string = R"(
+HloModule Module
+
+ENTRY entry {
+  param0 = f32[32] parameter(0)
+  param1 = f32[512,512] parameter(1)
+  allgather0 = f32[128] all-gather(param0), replica_groups={}, dimensions={0}
+  broadcast = f32[512,128] broadcast(allgather0), dimensions={1}
+  dot0 = f32[512,128] dot(param1, broadcast), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  dot1 = f32[512,512] dot(param1, param1), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  slice = f32[1,32] slice(dot1), slice={[0:1], [0:32]}
+  reshape = f32[32] reshape(slice)
+  allgather1 = f32[128] all-gather(reshape), replica_groups={}, dimensions={0}
+  ROOT tuple = (f32[512,128], f32[128]) tuple(dot0, allgather1)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+
+  AllGatherCombiner combine(1024 * 1024, kMaxCombineCount, TestCostModel());
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, combine.Run(module.get()));
+  EXPECT_FALSE(changed);
+  EXPECT_EQ(AllGatherCount(*module), 2);
+
+  // Without the cost model, nothing prevents combining them.
+  AllGatherCombiner combine_by_threshold(1024 * 1024, kMaxCombineCount);
+  TF_ASSERT_OK_AND_ASSIGN(changed, combine_by_threshold.Run(module.get()));
+  EXPECT_TRUE(changed);
+  EXPECT_EQ(AllGatherCount(*module), 1);
+}
+
 }  // namespace
 }  // namespace xla
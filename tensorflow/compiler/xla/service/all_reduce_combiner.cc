@@ -107,10 +107,12 @@ Status CombineAllReduces(absl::Span<HloInstruction* const> to_combine) {
 }
 }  // namespace
 
-AllReduceCombiner::AllReduceCombiner(int64_t combine_threshold_in_bytes,
-                                     int64_t combine_threshold_count)
+AllReduceCombiner::AllReduceCombiner(
+    int64_t combine_threshold_in_bytes, int64_t combine_threshold_count,
+    absl::optional<CollectiveCostModel> cost_model)
     : combine_threshold_in_bytes_(combine_threshold_in_bytes),
-      combine_threshold_count_(combine_threshold_count) {}
+      combine_threshold_count_(combine_threshold_count),
+      cost_model_(std::move(cost_model)) {}
 
 StatusOr<bool> AllReduceCombiner::Run(HloModule* module) {
   VLOG(1) << "Running AllReduceCombiner with threshold of "
@@ -144,7 +146,8 @@ StatusOr<bool> AllReduceCombiner::Run(HloModule* module) {
         bool computation_changed,
         CombineInstructionsByKey<AllReduceKey>(
             computation, key_fn, &CombineAllReduces,
-            combine_threshold_in_bytes_, combine_threshold_count_));
+            combine_threshold_in_bytes_, combine_threshold_count_,
+            cost_model_.has_value() ? &*cost_model_ : nullptr));
     changed |= computation_changed;
   }
 
@@ -0,0 +1,525 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/auto_sharding.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/xla/array.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_sharding.h"
+#include "tensorflow/compiler/xla/service/sharding_propagation.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace {
+
+// In the strategies of an instruction, the dimension of its result that each
+// axis of the device mesh shards, or one of these.
+constexpr int64_t kReplicated = -1;
+// Dots may shard their contracting dimension, which leaves partial sums to
+// all-reduce.
+constexpr int64_t kContracting = -2;
+
+// The price of per-device memory starts at a femtosecond per byte and doubles
+// at most this many times.
+constexpr double kInitialSecondsPerByte = 1e-15;
+constexpr int kMaxPriceDoublings = 64;
+
+struct Strategy {
+  HloSharding sharding;
+  // The time of the instruction and its collectives.
+  double seconds;
+  // The size of the result on each device.
+  int64_t memory_bytes;
+  // The sharding the strategy needs each operand in, or nullopt if the operand
+  // can be in any sharding.
+  std::vector<absl::optional<HloSharding>> operand_shardings;
+};
+
+struct Node {
+  HloInstruction* instruction;
+  std::vector<Strategy> strategies;
+  // The number of times the instructions of the other nodes use this one.
+  int64_t uses = 0;
+  // Whether the instruction had a sharding before the pass.
+  bool fixed;
+};
+
+// Returns the sharding where axis a of `mesh` shards dimension axis_dims[a] of
+// an array of `rank`, or replicates it if axis_dims[a] is negative.
+HloSharding MeshSharding(int64_t rank, absl::Span<const int64_t> mesh,
+                         absl::Span<const int64_t> axis_dims) {
+  std::vector<int64_t> tile_dims(rank, 1);
+  int64_t replication = 1;
+  for (int64_t a = 0; a < mesh.size(); ++a) {
+    if (axis_dims[a] >= 0) {
+      tile_dims[axis_dims[a]] = mesh[a];
+    } else {
+      replication *= mesh[a];
+    }
+  }
+  const int64_t device_count = Product(mesh);
+  if (replication == device_count) {
+    return HloSharding::Replicate();
+  }
+  if (replication > 1) {
+    tile_dims.push_back(replication);
+  }
+  Array<int64_t> tile_assignment(tile_dims);
+  std::vector<int64_t> coordinates(mesh.size());
+  std::vector<int64_t> index(tile_dims.size());
+  for (int64_t device = 0; device < device_count; ++device) {
+    int64_t remainder = device;
+    for (int64_t a = mesh.size() - 1; a >= 0; --a) {
+      coordinates[a] = remainder % mesh[a];
+      remainder /= mesh[a];
+    }
+    absl::c_fill(index, 0);
+    int64_t replica = 0;
+    for (int64_t a = 0; a < mesh.size(); ++a) {
+      if (axis_dims[a] >= 0) {
+        index[axis_dims[a]] = coordinates[a];
+      } else {
+        replica = replica * mesh[a] + coordinates[a];
+      }
+    }
+    if (replication > 1) {
+      index.back() = replica;
+    }
+    tile_assignment(index) = device;
+  }
+  return replication > 1 ? HloSharding::PartialTile(tile_assignment)
+                         : HloSharding::Tile(tile_assignment);
+}
+
+// Calls `fn` with each map from the axes of `mesh` to distinct dimensions of
+// `shape`, whose sizes the axes divide, or to kReplicated. If
+// `contracting_size` is positive, an axis may also map to kContracting if it
+// divides `contracting_size`.
+void ForEachAxisDims(
+    const Shape& shape, absl::Span<const int64_t> mesh,
+    int64_t contracting_size,
+    const std::function<void(absl::Span<const int64_t>)>& fn) {
+  std::vector<int64_t> axis_dims(mesh.size(), kReplicated);
+  std::vector<bool> used(shape.rank() + 1, false);
+  std::function<void(int64_t)> assign = [&](int64_t a) {
+    if (a == mesh.size()) {
+      fn(axis_dims);
+      return;
+    }
+    axis_dims[a] = kReplicated;
+    assign(a + 1);
+    if (mesh[a] == 1) {
+      return;
+    }
+    for (int64_t dim = 0; dim < shape.rank(); ++dim) {
+      if (!used[dim] && shape.dimensions(dim) % mesh[a] == 0) {
+        used[dim] = true;
+        axis_dims[a] = dim;
+        assign(a + 1);
+        used[dim] = false;
+      }
+    }
+    if (contracting_size > 0 && !used.back() &&
+        contracting_size % mesh[a] == 0) {
+      used.back() = true;
+      axis_dims[a] = kContracting;
+      assign(a + 1);
+      used.back() = false;
+    }
+    axis_dims[a] = kReplicated;
+  };
+  assign(0);
+}
+
+// Returns whether the strategies of `instruction` may shard its result.
+bool CanShard(const HloInstruction* instruction) {
+  if (instruction->IsElementwise()) {
+    return true;
+  }
+  switch (instruction->opcode()) {
+    case HloOpcode::kBroadcast:
+    case HloOpcode::kConstant:
+    case HloOpcode::kCopy:
+    case HloOpcode::kDot:
+    case HloOpcode::kGetTupleElement:
+    case HloOpcode::kIota:
+    case HloOpcode::kParameter:
+    case HloOpcode::kReduce:
+    case HloOpcode::kReshape:
+    case HloOpcode::kTranspose:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the dimensions of an operand of `dot` that are neither batch nor
+// contracting dimensions.
+std::vector<int64_t> NonContractingDims(
+    const Shape& shape, absl::Span<const int64_t> batch_dims,
+    absl::Span<const int64_t> contracting_dims) {
+  std::vector<int64_t> dims;
+  for (int64_t dim = 0; dim < shape.rank(); ++dim) {
+    if (!absl::c_linear_search(batch_dims, dim) &&
+        !absl::c_linear_search(contracting_dims, dim)) {
+      dims.push_back(dim);
+    }
+  }
+  return dims;
+}
+
+// Returns the sharding that operand `operand_index` of `dot` needs when axis a
+// of `mesh` shards dimension axis_dims[a] of its result.
+HloSharding DotOperandSharding(const HloInstruction* dot,
+                               int64_t operand_index,
+                               absl::Span<const int64_t> mesh,
+                               absl::Span<const int64_t> axis_dims) {
+  const DotDimensionNumbers& dnums = dot->dot_dimension_numbers();
+  const Shape& operand_shape = dot->operand(operand_index)->shape();
+  absl::Span<const int64_t> batch_dims = operand_index == 0
+                                             ? dnums.lhs_batch_dimensions()
+                                             : dnums.rhs_batch_dimensions();
+  absl::Span<const int64_t> contracting_dims =
+      operand_index == 0 ? dnums.lhs_contracting_dimensions()
+                         : dnums.rhs_contracting_dimensions();
+  std::vector<int64_t> lhs_non_contracting = NonContractingDims(
+      dot->operand(0)->shape(), dnums.lhs_batch_dimensions(),
+      dnums.lhs_contracting_dimensions());
+  std::vector<int64_t> non_contracting =
+      NonContractingDims(operand_shape, batch_dims, contracting_dims);
+  // The result has the batch dimensions, then the non-contracting dimensions
+  // of the lhs, then those of the rhs.
+  const int64_t batch_count = batch_dims.size();
+  const int64_t lhs_count = lhs_non_contracting.size();
+  std::vector<int64_t> operand_axis_dims(mesh.size(), kReplicated);
+  for (int64_t a = 0; a < mesh.size(); ++a) {
+    const int64_t dim = axis_dims[a];
+    if (dim == kContracting) {
+      operand_axis_dims[a] = contracting_dims[0];
+    } else if (dim >= 0 && dim < batch_count) {
+      operand_axis_dims[a] = batch_dims[dim];
+    } else if (operand_index == 0 && dim >= batch_count &&
+               dim < batch_count + lhs_count) {
+      operand_axis_dims[a] = non_contracting[dim - batch_count];
+    } else if (operand_index == 1 && dim >= batch_count + lhs_count) {
+      operand_axis_dims[a] = non_contracting[dim - batch_count - lhs_count];
+    }
+  }
+  return MeshSharding(operand_shape.rank(), mesh, operand_axis_dims);
+}
+
+// Returns the sharding that `operand` of `instruction` needs when
+// `instruction` has `sharding`, per the rules of ShardingPropagation.
+absl::optional<HloSharding> RequiredOperandSharding(
+    HloInstruction* instruction, const HloInstruction* operand,
+    const HloSharding& sharding) {
+  if (!operand->shape().IsArray()) {
+    return absl::nullopt;
+  }
+  if (sharding.IsReplicated()) {
+    return HloSharding::Replicate();
+  }
+  absl::optional<HloSharding> original;
+  if (instruction->has_sharding()) {
+    original = instruction->sharding();
+  }
+  instruction->set_sharding(sharding);
+  absl::optional<HloSharding> required =
+      ShardingPropagation::GetShardingFromUser(*operand, *instruction,
+                                               /*aggressiveness=*/3,
+                                               /*is_spmd=*/true);
+  if (original.has_value()) {
+    instruction->set_sharding(*original);
+  } else {
+    instruction->clear_sharding();
+  }
+  // Operands that the propagation can't shard are replicated.
+  return required.has_value() ? required : HloSharding::Replicate();
+}
+
+class StrategySearch {
+ public:
+  StrategySearch(const AutoShardingOptions& options,
+                 const HloCostAnalysis& cost_analysis)
+      : options_(options), cost_analysis_(cost_analysis) {}
+
+  // Adds the strategies of `instruction`, whose operands were added before.
+  void AddInstruction(HloInstruction* instruction);
+
+  // Returns the index of the chosen strategy of each node when per-device
+  // memory costs `seconds_per_byte`.
+  std::vector<int64_t> Solve(double seconds_per_byte) const;
+
+  // Returns the memory each device needs for the results of `choices`.
+  int64_t MemoryBytes(absl::Span<const int64_t> choices) const;
+
+  // Sets the shardings of `choices` on the instructions that had none, and
+  // returns whether any changed.
+  bool Annotate(absl::Span<const int64_t> choices) const;
+
+ private:
+  double ReshardSeconds(const HloInstruction* operand,
+                        const HloSharding& sharding,
+                        const absl::optional<HloSharding>& required) const;
+
+  const AutoShardingOptions& options_;
+  const HloCostAnalysis& cost_analysis_;
+  std::vector<Node> nodes_;
+  absl::flat_hash_map<const HloInstruction*, int64_t> node_indices_;
+};
+
+void StrategySearch::AddInstruction(HloInstruction* instruction) {
+  const Shape& shape = instruction->shape();
+  if (!shape.IsArray() ||
+      (instruction->has_sharding() && instruction->sharding().IsTuple())) {
+    return;
+  }
+  absl::Span<const int64_t> mesh = options_.device_mesh_shape;
+  const int64_t bytes = ShapeUtil::ByteSizeOf(shape);
+  // The cost analysis reports unknown costs as negative.
+  const double seconds = options_.cost_model.ComputeSeconds(
+      std::max<int64_t>(cost_analysis_.flop_count(*instruction), 0),
+      std::max<int64_t>(cost_analysis_.bytes_accessed(*instruction), 0));
+
+  Node node{instruction, {}, 0, instruction->has_sharding()};
+  auto add_strategy = [&](HloSharding sharding, int64_t shard_count,
+                          double collective_seconds,
+                          std::vector<absl::optional<HloSharding>> required) {
+    const int64_t memory_bytes =
+        ShapeUtil::ByteSizeOf(sharding.TileShape(shape));
+    node.strategies.push_back(
+        Strategy{std::move(sharding),
+                 seconds / shard_count + collective_seconds, memory_bytes,
+                 std::move(required)});
+  };
+  auto required_operand_shardings = [&](const HloSharding& sharding) {
+    std::vector<absl::optional<HloSharding>> required;
+    for (const HloInstruction* operand : instruction->operands()) {
+      required.push_back(
+          RequiredOperandSharding(instruction, operand, sharding));
+    }
+    return required;
+  };
+
+  if (node.fixed) {
+    const HloSharding sharding = instruction->sharding();
+    add_strategy(sharding,
+                 sharding.IsTileMaximal() ? 1 : sharding.NumTiles(),
+                 /*collective_seconds=*/0,
+                 required_operand_shardings(sharding));
+  } else if (!CanShard(instruction)) {
+    add_strategy(HloSharding::Replicate(), 1, /*collective_seconds=*/0,
+                 required_operand_shardings(HloSharding::Replicate()));
+  } else {
+    const bool is_dot = instruction->opcode() == HloOpcode::kDot;
+    int64_t contracting_size = 0;
+    if (is_dot && instruction->dot_dimension_numbers()
+                          .lhs_contracting_dimensions_size() == 1) {
+      contracting_size = instruction->operand(0)->shape().dimensions(
+          instruction->dot_dimension_numbers().lhs_contracting_dimensions(0));
+    }
+    ForEachAxisDims(
+        shape, mesh, contracting_size, [&](absl::Span<const int64_t> dims) {
+          HloSharding sharding = MeshSharding(shape.rank(), mesh, dims);
+          int64_t shard_count = 1;
+          double collective_seconds = 0;
+          for (int64_t a = 0; a < mesh.size(); ++a) {
+            if (dims[a] != kReplicated) {
+              shard_count *= mesh[a];
+            }
+          }
+          std::vector<absl::optional<HloSharding>> required;
+          if (is_dot) {
+            for (int64_t i = 0; i < 2; ++i) {
+              required.push_back(
+                  DotOperandSharding(instruction, i, mesh, dims));
+            }
+            if (absl::c_linear_search(dims, kContracting)) {
+              collective_seconds = options_.cost_model.CollectiveSeconds(
+                  ShapeUtil::ByteSizeOf(sharding.TileShape(shape)));
+            }
+          } else {
+            required = required_operand_shardings(sharding);
+          }
+          add_strategy(std::move(sharding), shard_count, collective_seconds,
+                       std::move(required));
+        });
+  }
+
+  for (const HloInstruction* operand : instruction->operands()) {
+    auto it = node_indices_.find(operand);
+    if (it != node_indices_.end()) {
+      ++nodes_[it->second].uses;
+    }
+  }
+  node_indices_[instruction] = nodes_.size();
+  nodes_.push_back(std::move(node));
+}
+
+double StrategySearch::ReshardSeconds(
+    const HloInstruction* operand, const HloSharding& sharding,
+    const absl::optional<HloSharding>& required) const {
+  // Replicated operands are sliced locally to any sharding.
+  if (!required.has_value() || sharding == *required ||
+      sharding.IsReplicated()) {
+    return 0;
+  }
+  return options_.cost_model.CollectiveSeconds(
+      ShapeUtil::ByteSizeOf(operand->shape()));
+}
+
+std::vector<int64_t> StrategySearch::Solve(double seconds_per_byte) const {
+  // costs[i][s] is the cost of strategy s of node i and of the best
+  // strategies of the nodes it depends on, where each node costs its users a
+  // share per use.
+  std::vector<std::vector<double>> costs(nodes_.size());
+  // operand_choices[i][s][k] is the best strategy of operand k of node i for
+  // strategy s, or -1 if the operand is not a node.
+  std::vector<std::vector<std::vector<int64_t>>> operand_choices(
+      nodes_.size());
+  for (int64_t i = 0; i < nodes_.size(); ++i) {
+    const Node& node = nodes_[i];
+    for (const Strategy& strategy : node.strategies) {
+      double cost = strategy.seconds + seconds_per_byte * strategy.memory_bytes;
+      std::vector<int64_t> choices(node.instruction->operand_count(), -1);
+      for (int64_t k = 0; k < node.instruction->operand_count(); ++k) {
+        const HloInstruction* operand = node.instruction->operand(k);
+        auto it = node_indices_.find(operand);
+        if (it == node_indices_.end()) {
+          continue;
+        }
+        const int64_t j = it->second;
+        double best_cost = std::numeric_limits<double>::infinity();
+        for (int64_t t = 0; t < nodes_[j].strategies.size(); ++t) {
+          double operand_cost =
+              costs[j][t] / nodes_[j].uses +
+              ReshardSeconds(operand, nodes_[j].strategies[t].sharding,
+                             strategy.operand_shardings[k]);
+          if (operand_cost < best_cost) {
+            best_cost = operand_cost;
+            choices[k] = t;
+          }
+        }
+        cost += best_cost;
+      }
+      costs[i].push_back(cost);
+      operand_choices[i].push_back(std::move(choices));
+    }
+  }
+
+  // Users are visited before their operands, and the first user that reaches
+  // an operand picks its strategy.
+  std::vector<int64_t> choices(nodes_.size(), -1);
+  for (int64_t i = nodes_.size() - 1; i >= 0; --i) {
+    if (choices[i] < 0) {
+      choices[i] = absl::c_min_element(costs[i]) - costs[i].begin();
+    }
+    const std::vector<int64_t>& operands = operand_choices[i][choices[i]];
+    for (int64_t k = 0; k < operands.size(); ++k) {
+      if (operands[k] < 0) {
+        continue;
+      }
+      const int64_t j = node_indices_.at(nodes_[i].instruction->operand(k));
+      if (choices[j] < 0) {
+        choices[j] = operands[k];
+      }
+    }
+  }
+  return choices;
+}
+
+int64_t StrategySearch::MemoryBytes(absl::Span<const int64_t> choices) const {
+  int64_t bytes = 0;
+  for (int64_t i = 0; i < nodes_.size(); ++i) {
+    bytes += nodes_[i].strategies[choices[i]].memory_bytes;
+  }
+  return bytes;
+}
+
+bool StrategySearch::Annotate(absl::Span<const int64_t> choices) const {
+  bool changed = false;
+  for (int64_t i = 0; i < nodes_.size(); ++i) {
+    const Node& node = nodes_[i];
+    if (node.fixed) {
+      continue;
+    }
+    const HloSharding& sharding = node.strategies[choices[i]].sharding;
+    VLOG(2) << "Sharding " << node.instruction->name() << " "
+            << sharding.ToString();
+    node.instruction->set_sharding(sharding);
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace
+
+StatusOr<bool> AutoSharding::Run(HloModule* module) {
+  absl::Span<const int64_t> mesh = options_.device_mesh_shape;
+  const int64_t num_partitions = module->config().num_partitions();
+  if (Product(mesh) != num_partitions ||
+      absl::c_any_of(mesh, [](int64_t size) { return size <= 0; })) {
+    return InvalidArgument(
+        "The device mesh [%s] does not match the %d partitions of module %s",
+        absl::StrJoin(mesh, ","), num_partitions, module->name());
+  }
+  if (num_partitions == 1) {
+    return false;
+  }
+
+  HloComputation* entry = module->entry_computation();
+  HloCostAnalysis cost_analysis(
+      [](const Shape& shape) { return ShapeUtil::ByteSizeOf(shape, 8); });
+  TF_RETURN_IF_ERROR(entry->Accept(&cost_analysis));
+  StrategySearch search(options_, cost_analysis);
+  for (HloInstruction* instruction : entry->MakeInstructionPostOrder()) {
+    search.AddInstruction(instruction);
+  }
+
+  std::vector<int64_t> choices = search.Solve(/*seconds_per_byte=*/0);
+  const int64_t budget = options_.memory_budget_per_device_bytes;
+  if (budget > 0) {
+    double seconds_per_byte = kInitialSecondsPerByte;
+    for (int i = 0; i < kMaxPriceDoublings; ++i) {
+      if (search.MemoryBytes(choices) <= budget) {
+        break;
+      }
+      choices = search.Solve(seconds_per_byte);
+      seconds_per_byte *= 2;
+    }
+    if (search.MemoryBytes(choices) > budget) {
+      LOG(WARNING) << "The shardings of " << module->name() << " need "
+                   << search.MemoryBytes(choices)
+                   << " bytes per device, more than the budget of " << budget
+                   << " bytes";
+    }
+  }
+  return search.Annotate(choices);
+}
+
+}  // namespace xla
@@ -0,0 +1,70 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_AUTO_SHARDING_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_AUTO_SHARDING_H_
+
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/collective_cost_model.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+
+struct AutoShardingOptions {
+  // The shape of the mesh of devices, whose product must be the number of
+  // partitions of the module. Device d is at the row-major coordinates of d in
+  // the mesh.
+  std::vector<int64_t> device_mesh_shape;
+  // The times of the instructions and of resharding their results.
+  CollectiveCostModel cost_model;
+  // The memory the results of the instructions of the entry computation may
+  // take on each device, or 0 for no limit.
+  int64_t memory_budget_per_device_bytes = 0;
+};
+
+// Searches shardings for the instructions of the entry computation, so that
+// ShardingPropagation and the SPMD partitioner can partition modules without
+// annotations.
+//
+// Each instruction has a set of strategies, each of which shards some of the
+// dimensions of its result along axes of the device mesh, or replicates it. A
+// strategy requires a sharding of each operand and costs the time of the
+// instruction, of the collectives it needs, and of resharding operands that
+// are sharded differently. The pass picks the strategies by dynamic
+// programming over the instructions in post order, which is exact for trees
+// and approximates instructions with several users by splitting their cost
+// among the users. The memory budget is enforced by adding a price per byte of
+// per-device memory to the cost, which doubles until the results fit.
+//
+// The shardings of instructions that already have one are kept, and the pass
+// only shards the other instructions.
+class AutoSharding : public HloModulePass {
+ public:
+  explicit AutoSharding(AutoShardingOptions options)
+      : options_(std::move(options)) {}
+  absl::string_view name() const override { return "auto-sharding"; }
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  AutoShardingOptions options_;
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_AUTO_SHARDING_H_
@@ -0,0 +1,159 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/auto_sharding.h"
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/sharding_propagation.h"
+#include "tensorflow/compiler/xla/service/spmd/spmd_partitioner.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace {
+
+constexpr absl::string_view kDot = R"(
+HloModule dot
+
+ENTRY entry {
+  lhs = f32[1024,1024] parameter(0)
+  rhs = f32[1024,1024] parameter(1)
+  ROOT dot = f32[1024,1024] dot(lhs, rhs), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+}
+)";
+
+class AutoShardingTest : public HloTestBase {
+ protected:
+  static AutoShardingOptions Options() {
+    AutoShardingOptions options;
+    options.device_mesh_shape = {2};
+    options.cost_model.latency_seconds = 1e-5;
+    options.cost_model.seconds_per_byte = 1e-10;
+    return options;
+  }
+};
+
+TEST_F(AutoShardingTest, ShardLargeDot) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module, ParseAndReturnVerifiedModule(kDot, /*replica_count=*/1,
+                                                /*num_partitions=*/2));
+  AutoSharding auto_sharding(Options());
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RunHloPass(&auto_sharding, module.get()));
+  EXPECT_TRUE(changed);
+  const HloInstruction* dot = FindInstruction(module.get(), "dot");
+  ASSERT_TRUE(dot->has_sharding());
+  EXPECT_FALSE(dot->sharding().IsReplicated());
+
+  // The SPMD partitioner halves the dot on each device.
+  TF_ASSERT_OK(
+      ShardingPropagation(/*is_spmd=*/true).Run(module.get()).status());
+  spmd::SpmdPartitionerOptions options;
+  options.allow_module_signature_change = true;
+  TF_ASSERT_OK(spmd::SpmdPartitioner(/*num_partitions=*/2, /*num_replicas=*/1,
+                                     options)
+                   .Run(module.get())
+                   .status());
+  const HloInstruction* partitioned_dot =
+      FindInstruction(module.get(), HloOpcode::kDot);
+  ASSERT_NE(partitioned_dot, nullptr);
+  EXPECT_EQ(ShapeUtil::ElementsIn(partitioned_dot->shape()), 1024 * 512);
+}
+
+TEST_F(AutoShardingTest, KeepUserShardings) {
+  constexpr absl::string_view kHloString = R"(
+HloModule dot
+
+ENTRY entry {
+  lhs = f32[1024,1024] parameter(0), sharding={replicated}
+  rhs = f32[1024,1024] parameter(1)
+  ROOT dot = f32[1024,1024] dot(lhs, rhs), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module, ParseAndReturnVerifiedModule(
+                       kHloString, /*replica_count=*/1, /*num_partitions=*/2));
+  AutoSharding auto_sharding(Options());
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RunHloPass(&auto_sharding, module.get()));
+  EXPECT_TRUE(changed);
+  EXPECT_TRUE(FindInstruction(module.get(), "lhs")->sharding().IsReplicated());
+  EXPECT_TRUE(FindInstruction(module.get(), "rhs")->has_sharding());
+  EXPECT_TRUE(FindInstruction(module.get(), "dot")->has_sharding());
+}
+
+TEST_F(AutoShardingTest, ShardParameterToFitMemoryBudget) {
+  // Sharding x needs to reshard it for one of its users, which is only worth
+  // it to save memory.
+  constexpr absl::string_view kHloString = R"(
+HloModule add_transpose
+
+ENTRY entry {
+  x = f32[1024,1024] parameter(0)
+  transpose = f32[1024,1024] transpose(x), dimensions={1,0}
+  ROOT add = f32[1024,1024] add(transpose, x)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module, ParseAndReturnVerifiedModule(
+                       kHloString, /*replica_count=*/1, /*num_partitions=*/2));
+  AutoSharding auto_sharding(Options());
+  TF_ASSERT_OK(RunHloPass(&auto_sharding, module.get()).status());
+  EXPECT_TRUE(FindInstruction(module.get(), "x")->sharding().IsReplicated());
+  EXPECT_FALSE(FindInstruction(module.get(), "add")->sharding().IsReplicated());
+
+  // Replicating x takes 4 MiB and the halves of the other results 2 MiB each.
+  TF_ASSERT_OK_AND_ASSIGN(
+      module, ParseAndReturnVerifiedModule(kHloString, /*replica_count=*/1,
+                                           /*num_partitions=*/2));
+  AutoShardingOptions options = Options();
+  options.memory_budget_per_device_bytes = 7 << 20;
+  AutoSharding budgeted_auto_sharding(options);
+  TF_ASSERT_OK(RunHloPass(&budgeted_auto_sharding, module.get()).status());
+  EXPECT_FALSE(FindInstruction(module.get(), "x")->sharding().IsReplicated());
+}
+
+TEST_F(AutoShardingTest, MeshMustMatchPartitions) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module, ParseAndReturnVerifiedModule(kDot, /*replica_count=*/1,
+                                                /*num_partitions=*/2));
+  AutoShardingOptions options = Options();
+  options.device_mesh_shape = {2, 2};
+  AutoSharding auto_sharding(options);
+  EXPECT_FALSE(RunHloPass(&auto_sharding, module.get()).ok());
+}
+
+TEST_F(AutoShardingTest, ShardOverTwoMeshAxes) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module, ParseAndReturnVerifiedModule(kDot, /*replica_count=*/1,
+                                                /*num_partitions=*/4));
+  AutoShardingOptions options = Options();
+  options.device_mesh_shape = {2, 2};
+  AutoSharding auto_sharding(options);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed,
+                          RunHloPass(&auto_sharding, module.get()));
+  EXPECT_TRUE(changed);
+  // Each device computes a quarter of the dot.
+  const HloInstruction* dot = FindInstruction(module.get(), "dot");
+  ASSERT_TRUE(dot->has_sharding());
+  EXPECT_EQ(ShapeUtil::ElementsIn(dot->sharding().TileShape(dot->shape())),
+            1024 * 1024 / 4);
+}
+
+}  // namespace
+}  // namespace xla
@@ -46,6 +46,10 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -57,6 +61,10 @@ using absl::StrAppendFormat;
 using memory_space_assignment::PresetAssignments;
 using ::tensorflow::strings::HumanReadableNumBytes;
 
+// Heap simulations of fewer buffers are fast enough that starting threads for
+// them would only slow them down.
+constexpr int64_t kMinBuffersForParallelHeapSimulation = 4096;
+
 // Given the interference map of a graph (the list of interfering node indices
 // for each node), perform graph coloring such that interfering nodes are
 // assigned to different colors. Returns the assigned color of the nodes, where
@@ -1470,30 +1478,21 @@ Status BufferAssigner::AssignBuffersWithSequentialOrdering(
   // runs of alloc / free calls sorted in decreasing size order.
   const HloOrdering& hlo_ordering = assignment->hlo_ordering();
 
-  // Returns a heap algorithm that chooses the best result from several
-  // algorithms.
-  auto get_heap_algorithm = [&](int64_t alignment) {
-    auto algorithms = absl::make_unique<
-        std::vector<std::unique_ptr<HeapAlgorithm<HloValue>>>>();
-    algorithms->push_back(
-        absl::make_unique<ConstrainedGlobalDecreasingSizeBestFitHeap>(
-            assignment->multiheap_size_constraint_per_heap(), alignment,
-            GlobalDecreasingSizeBestFitHeap<HloValue>::kSpatial));
-    algorithms->push_back(
-        absl::make_unique<ConstrainedGlobalDecreasingSizeBestFitHeap>(
-            assignment->multiheap_size_constraint_per_heap(), alignment,
-            GlobalDecreasingSizeBestFitHeap<HloValue>::kTemporal));
-    return absl::make_unique<ChooseBestHeapAlgorithm<HloValue>>(
-        std::move(algorithms));
+  // A heap simulation of the buffers of one color, either in a single
+  // computation or in the whole module.
+  struct Simulation {
+    const HloComputation* computation;
+    LogicalBuffer::Color color;
+    flat_hash_set<const HloValue*> buffers;
   };
-
+  std::vector<Simulation> simulations;
+  HloSchedule schedule(&assignment->module());
   if (run_whole_module_heap_simulation) {
     // Run the heap simulation over the whole module. This reduces memory
     // usage, since buffers for kCall, kWhile, and kConditional
     // sub-computations are only live for the duration of their calling
     // instructions.
     VLOG(1) << "Running whole-module heap simulation";
-    HloSchedule schedule(&assignment->module());
     flat_hash_set<const HloValue*> all_buffers_to_assign;
     for (const auto& pair : buffers_to_assign_sequentially) {
       const HloComputation* computation = pair.first;
@@ -1505,22 +1504,10 @@ Status BufferAssigner::AssignBuffersWithSequentialOrdering(
       all_buffers_to_assign.insert(buffers_to_assign.begin(),
                                    buffers_to_assign.end());
     }
-    auto color_map = SplitBuffersByColor(all_buffers_to_assign);
-    for (auto& single_colored_set : color_map) {
-      auto color = single_colored_set.first;
-      VLOG(2) << "Simulating heap for color " << color;
-      int64_t alignment = assignment->color_alignment_(color);
-      HeapSimulator::Options options;
-      options.alloc_constants = allocate_buffers_for_constants_;
-      options.buffers_to_assign = &single_colored_set.second;
-
-      TF_ASSIGN_OR_RETURN(
-          HeapSimulator::Result<HloValue> result,
-          HeapSimulator::Run(
-              get_heap_algorithm(alignment), assignment->module(), schedule,
-              assignment->alias_analysis(), assignment->buffer_size_, options));
-      AssignBuffersFromHeapSimulator(result, assignment,
-                                     single_colored_set.first);
+    for (auto& single_colored_set :
+         SplitBuffersByColor(all_buffers_to_assign)) {
+      simulations.push_back({/*computation=*/nullptr, single_colored_set.first,
+                             std::move(single_colored_set.second)});
     }
   } else {
     // Run the heap-simulation on a per-computation basis. Buffers for
@@ -1529,28 +1516,92 @@ Status BufferAssigner::AssignBuffersWithSequentialOrdering(
     VLOG(1) << "Running per-computation heap simulation";
     for (const auto& pair : buffers_to_assign_sequentially) {
       const HloComputation* computation = pair.first;
-      const flat_hash_set<const HloValue*>& buffers_to_assign = pair.second;
-      const HloInstructionSequence* instruction_sequence =
-          hlo_ordering.SequentialOrder(*computation);
-      CHECK(instruction_sequence != nullptr) << computation->name();
-      auto color_map = SplitBuffersByColor(buffers_to_assign);
-      for (auto& single_colored_set : color_map) {
-        auto color = single_colored_set.first;
-        VLOG(2) << "Simulating heap for color " << color;
-        int64_t alignment = assignment->color_alignment_(color);
-        HeapSimulator::Options options;
-        options.buffers_to_assign = &single_colored_set.second;
-        TF_ASSIGN_OR_RETURN(
-            HeapSimulator::Result<HloValue> result,
-            HeapSimulator::Run(get_heap_algorithm(alignment), *computation,
-                               *instruction_sequence,
-                               assignment->alias_analysis(),
-                               assignment->buffer_size_, options));
-        AssignBuffersFromHeapSimulator(result, assignment,
-                                       single_colored_set.first);
+      CHECK(hlo_ordering.SequentialOrder(*computation) != nullptr)
+          << computation->name();
+      for (auto& single_colored_set : SplitBuffersByColor(pair.second)) {
+        simulations.push_back({computation, single_colored_set.first,
+                               std::move(single_colored_set.second)});
       }
     }
   }
+
+  // The simulations don't interact, so large ones run in parallel. With a
+  // single simulation, the heap algorithms it chooses from run in parallel
+  // instead.
+  int64_t num_buffers = 0;
+  for (const Simulation& simulation : simulations) {
+    num_buffers += simulation.buffers.size();
+  }
+  std::unique_ptr<tensorflow::thread::ThreadPool> thread_pool;
+  if (num_buffers >= kMinBuffersForParallelHeapSimulation) {
+    thread_pool = absl::make_unique<tensorflow::thread::ThreadPool>(
+        tensorflow::Env::Default(), "heap_simulation",
+        std::min<int64_t>(tensorflow::port::MaxParallelism(),
+                          std::max<int64_t>(simulations.size(), 2)));
+  }
+  tensorflow::thread::ThreadPool* algorithm_thread_pool =
+      simulations.size() == 1 ? thread_pool.get() : nullptr;
+
+  // Returns a heap algorithm that chooses the best result from several
+  // algorithms.
+  auto get_heap_algorithm = [&](int64_t alignment) {
+    auto algorithms = absl::make_unique<
+        std::vector<std::unique_ptr<HeapAlgorithm<HloValue>>>>();
+    algorithms->push_back(
+        absl::make_unique<ConstrainedGlobalDecreasingSizeBestFitHeap>(
+            assignment->multiheap_size_constraint_per_heap(), alignment,
+            GlobalDecreasingSizeBestFitHeap<HloValue>::kSpatial));
+    algorithms->push_back(
+        absl::make_unique<ConstrainedGlobalDecreasingSizeBestFitHeap>(
+            assignment->multiheap_size_constraint_per_heap(), alignment,
+            GlobalDecreasingSizeBestFitHeap<HloValue>::kTemporal));
+    return absl::make_unique<ChooseBestHeapAlgorithm<HloValue>>(
+        std::move(algorithms), algorithm_thread_pool);
+  };
+
+  auto simulate = [&](const Simulation& simulation)
+      -> StatusOr<HeapSimulator::Result<HloValue>> {
+    VLOG(2) << "Simulating heap for color " << simulation.color;
+    int64_t alignment = assignment->color_alignment_(simulation.color);
+    HeapSimulator::Options options;
+    options.buffers_to_assign = &simulation.buffers;
+    if (simulation.computation == nullptr) {
+      options.alloc_constants = allocate_buffers_for_constants_;
+      return HeapSimulator::Run(get_heap_algorithm(alignment),
+                                assignment->module(), schedule,
+                                assignment->alias_analysis(),
+                                assignment->buffer_size_, options);
+    }
+    return HeapSimulator::Run(
+        get_heap_algorithm(alignment), *simulation.computation,
+        *hlo_ordering.SequentialOrder(*simulation.computation),
+        assignment->alias_analysis(), assignment->buffer_size_, options);
+  };
+
+  std::vector<StatusOr<HeapSimulator::Result<HloValue>>> results(
+      simulations.size());
+  if (thread_pool != nullptr && simulations.size() > 1) {
+    tensorflow::BlockingCounter counter(simulations.size());
+    for (int64_t i = 0; i < simulations.size(); ++i) {
+      thread_pool->Schedule([&, i] {
+        results[i] = simulate(simulations[i]);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  } else {
+    for (int64_t i = 0; i < simulations.size(); ++i) {
+      results[i] = simulate(simulations[i]);
+    }
+  }
+
+  // Allocations are created in the order of the simulations, regardless of
+  // the order in which they finished.
+  for (int64_t i = 0; i < simulations.size(); ++i) {
+    TF_ASSIGN_OR_RETURN(HeapSimulator::Result<HloValue> result,
+                        std::move(results[i]));
+    AssignBuffersFromHeapSimulator(result, assignment, simulations[i].color);
+  }
   return Status::OK();
 }
 
@@ -16,12 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_COLLECTIVE_COMBINER_UTILS_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_COLLECTIVE_COMBINER_UTILS_H_
 
+#include <algorithm>
 #include <functional>
+#include <limits>
 #include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/xla/service/collective_cost_model.h"
 #include "tensorflow/compiler/xla/service/hlo_domain_map.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_instructions.h"
@@ -42,12 +46,18 @@ namespace xla {
 // `key_fn` should return equal keys for two instructions that might be combined
 // together. Instructions will be combined until the threshold for output byte
 // size or instruction count is reached.
+//
+// If `cost_model` is given, instructions are also only combined while the
+// combined instruction, which starts when the operands of all of them are
+// ready, is estimated to finish before any of them would delay the end of the
+// computation.
 template <typename K>
 StatusOr<bool> CombineInstructionsByKey(
     HloComputation* computation,
     const std::function<absl::optional<K>(const HloInstruction*)>& key_fn,
     const std::function<Status(absl::Span<HloInstruction* const>)>& combine_fn,
-    int64_t combine_threshold_bytes, int64_t combine_threshold_count) {
+    int64_t combine_threshold_bytes, int64_t combine_threshold_count,
+    const CollectiveCostModel* cost_model = nullptr) {
   // Cache keys for each instruction and build sets of instructions with the
   // same key that might be combined together.
   absl::flat_hash_map<HloInstruction*, K> keys;
@@ -75,6 +85,15 @@ StatusOr<bool> CombineInstructionsByKey(
     std::unique_ptr<HloReachabilityMap> reachability =
         HloReachabilityMap::Build(computation);
 
+    // The critical path changes with every combine group as well.
+    absl::optional<CriticalPathEstimate> critical_path;
+    if (cost_model != nullptr) {
+      TF_ASSIGN_OR_RETURN(critical_path,
+                          EstimateCriticalPath(*computation, *cost_model));
+    }
+    double to_combine_ready_seconds = 0;
+    double to_combine_deadline_seconds = std::numeric_limits<double>::max();
+
     for (HloInstruction* instruction :
          computation->MakeInstructionPostOrder()) {
       auto it = keys.find(instruction);
@@ -129,6 +148,25 @@ StatusOr<bool> CombineInstructionsByKey(
         break;
       }
 
+      if (critical_path.has_value()) {
+        double ready_seconds =
+            std::max(to_combine_ready_seconds,
+                     critical_path->ready_seconds.at(instruction));
+        double deadline_seconds =
+            std::min(to_combine_deadline_seconds,
+                     critical_path->finish_seconds.at(instruction) +
+                         critical_path->slack_seconds.at(instruction));
+        if (!to_combine.empty() &&
+            ready_seconds + cost_model->CollectiveSeconds(to_combine_bytes +
+                                                          instruction_bytes) >
+                deadline_seconds) {
+          VLOG(1) << "Combining would delay the computation.";
+          break;
+        }
+        to_combine_ready_seconds = ready_seconds;
+        to_combine_deadline_seconds = deadline_seconds;
+      }
+
       VLOG(1) << "Adding instruction to set.";
       to_combine.push_back(instruction);
       to_combine_bytes += instruction_bytes;
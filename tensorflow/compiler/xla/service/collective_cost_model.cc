@@ -0,0 +1,139 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/collective_cost_model.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_query.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
+
+namespace xla {
+namespace {
+
+int64_t ResultBytes(const Shape& shape) {
+  int64_t bytes = 0;
+  ShapeUtil::ForEachSubshape(
+      shape, [&](const Shape& subshape, const ShapeIndex& /*index*/) {
+        if (subshape.IsArray()) {
+          bytes += ShapeUtil::ByteSizeOf(subshape);
+        }
+      });
+  return bytes;
+}
+
+}  // namespace
+
+Status CollectiveCostModel::FitCollectiveTimes(
+    absl::Span<const std::pair<int64_t, double>> measurements) {
+  double n = measurements.size();
+  double sum_bytes = 0, sum_seconds = 0, sum_bytes_squared = 0,
+         sum_bytes_seconds = 0;
+  for (const auto& measurement : measurements) {
+    double bytes = measurement.first;
+    sum_bytes += bytes;
+    sum_seconds += measurement.second;
+    sum_bytes_squared += bytes * bytes;
+    sum_bytes_seconds += bytes * measurement.second;
+  }
+  double denominator = n * sum_bytes_squared - sum_bytes * sum_bytes;
+  if (measurements.size() < 2 || denominator <= 0) {
+    return InvalidArgument(
+        "Fitting collective times needs measurements of at least two sizes, "
+        "got %d measurements",
+        measurements.size());
+  }
+  seconds_per_byte =
+      (n * sum_bytes_seconds - sum_bytes * sum_seconds) / denominator;
+  latency_seconds = (sum_seconds - seconds_per_byte * sum_bytes) / n;
+  // Noisy measurements may not fit a positive latency or time per byte.
+  seconds_per_byte = std::max(seconds_per_byte, 0.0);
+  latency_seconds = std::max(latency_seconds, 0.0);
+  return Status::OK();
+}
+
+StatusOr<CriticalPathEstimate> EstimateCriticalPath(
+    const HloComputation& computation, const CollectiveCostModel& model) {
+  HloCostAnalysis cost_analysis(
+      [](const Shape& shape) { return ShapeUtil::ByteSizeOf(shape, 8); });
+  TF_RETURN_IF_ERROR(computation.Accept(&cost_analysis));
+
+  std::vector<HloInstruction*> post_order =
+      computation.MakeInstructionPostOrder();
+  absl::flat_hash_map<const HloInstruction*, double> seconds;
+  CriticalPathEstimate estimate;
+  double collectives_finish_seconds = 0;
+  for (const HloInstruction* instruction : post_order) {
+    const bool is_collective =
+        hlo_query::IsCollectiveCommunicationOp(instruction->opcode());
+    double instruction_seconds;
+    if (is_collective) {
+      instruction_seconds =
+          model.CollectiveSeconds(ResultBytes(instruction->shape()));
+    } else {
+      // The cost analysis reports unknown costs as negative.
+      double flops =
+          std::max<int64_t>(cost_analysis.flop_count(*instruction), 0);
+      double bytes =
+          std::max<int64_t>(cost_analysis.bytes_accessed(*instruction), 0);
+      instruction_seconds = model.ComputeSeconds(flops, bytes);
+    }
+    double ready = 0;
+    for (const HloInstruction* operand : instruction->operands()) {
+      ready = std::max(ready, estimate.finish_seconds.at(operand));
+    }
+    for (const HloInstruction* predecessor :
+         instruction->control_predecessors()) {
+      ready = std::max(ready, estimate.finish_seconds.at(predecessor));
+    }
+    double start = ready;
+    if (is_collective) {
+      start = std::max(start, collectives_finish_seconds);
+      collectives_finish_seconds = start + instruction_seconds;
+    }
+    seconds[instruction] = instruction_seconds;
+    estimate.ready_seconds[instruction] = ready;
+    estimate.finish_seconds[instruction] = start + instruction_seconds;
+    estimate.total_seconds =
+        std::max(estimate.total_seconds, start + instruction_seconds);
+  }
+
+  // The latest time each instruction can finish at is the latest time all of
+  // its users can start at.
+  absl::flat_hash_map<const HloInstruction*, double> latest_finish_seconds;
+  for (auto it = post_order.rbegin(); it != post_order.rend(); ++it) {
+    const HloInstruction* instruction = *it;
+    double latest_finish = estimate.total_seconds;
+    for (const HloInstruction* user : instruction->users()) {
+      latest_finish = std::min(
+          latest_finish, latest_finish_seconds.at(user) - seconds.at(user));
+    }
+    for (const HloInstruction* successor :
+         instruction->control_successors()) {
+      latest_finish =
+          std::min(latest_finish,
+                   latest_finish_seconds.at(successor) - seconds.at(successor));
+    }
+    latest_finish_seconds[instruction] = latest_finish;
+    estimate.slack_seconds[instruction] = std::max(
+        latest_finish - estimate.finish_seconds.at(instruction), 0.0);
+  }
+  return estimate;
+}
+
+}  // namespace xla
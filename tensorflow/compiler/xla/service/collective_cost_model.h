@@ -0,0 +1,90 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_COLLECTIVE_COST_MODEL_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_COLLECTIVE_COST_MODEL_H_
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+
+// Estimates the run time of the instructions of a computation, which the
+// collective combiners use to only combine collectives when that does not
+// delay the computation.
+//
+// Collectives follow an alpha-beta model: a collective takes a fixed latency
+// plus a time per byte of its result. Both are properties of the interconnect
+// and can be fitted to measured run times of collectives, e.g. of NCCL
+// benchmarks, with FitCollectiveTimes. The other instructions take the time of
+// the slowest of their floating point operations and memory accesses.
+struct CollectiveCostModel {
+  // The alpha and beta of collectives.
+  double latency_seconds = 0;
+  double seconds_per_byte = 0;
+
+  // The throughput of the other instructions.
+  double flops_per_second = 1e12;
+  double bytes_per_second = 1e11;
+
+  // Returns the time of a collective with a result of `bytes`.
+  double CollectiveSeconds(int64_t bytes) const {
+    return latency_seconds + seconds_per_byte * bytes;
+  }
+
+  // Returns the time of another instruction that does `flops` floating point
+  // operations and accesses `bytes` of memory.
+  double ComputeSeconds(double flops, double bytes) const {
+    return std::max(flops / flops_per_second, bytes / bytes_per_second);
+  }
+
+  // Sets latency_seconds and seconds_per_byte to the least squares fit of the
+  // (bytes, seconds) pairs of `measurements`, which must have at least two
+  // different sizes.
+  Status FitCollectiveTimes(
+      absl::Span<const std::pair<int64_t, double>> measurements);
+};
+
+// The times of the instructions of a computation when each instruction starts
+// as soon as its operands are ready, except that collectives share the
+// interconnect and run one at a time, in post order.
+struct CriticalPathEstimate {
+  // The time the last operand of an instruction is ready at.
+  absl::flat_hash_map<const HloInstruction*, double> ready_seconds;
+  // The time an instruction finishes at.
+  absl::flat_hash_map<const HloInstruction*, double> finish_seconds;
+  // The time an instruction may finish later than it does without its users
+  // delaying the end of the computation. The collectives after it are assumed
+  // to not be delayed, since they can often run earlier instead, e.g. when
+  // the delay comes from combining it with a later collective.
+  absl::flat_hash_map<const HloInstruction*, double> slack_seconds;
+  // The time of the computation, which is the length of its critical path.
+  double total_seconds = 0;
+};
+
+// Returns the time of each instruction of `computation` per `model`.
+StatusOr<CriticalPathEstimate> EstimateCriticalPath(
+    const HloComputation& computation, const CollectiveCostModel& model);
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_COLLECTIVE_COST_MODEL_H_
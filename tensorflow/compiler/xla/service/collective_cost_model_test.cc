@@ -0,0 +1,87 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/collective_cost_model.h"
+
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace {
+
+using CollectiveCostModelTest = HloTestBase;
+
+TEST_F(CollectiveCostModelTest, FitCollectiveTimes) {
+  std::vector<std::pair<int64_t, double>> measurements;
+  for (int64_t bytes : {1 << 10, 1 << 16, 1 << 20, 1 << 24}) {
+    measurements.push_back({bytes, 2e-5 + bytes * 1e-10});
+  }
+  CollectiveCostModel model;
+  TF_ASSERT_OK(model.FitCollectiveTimes(measurements));
+  EXPECT_NEAR(model.latency_seconds, 2e-5, 1e-9);
+  EXPECT_NEAR(model.seconds_per_byte, 1e-10, 1e-15);
+  EXPECT_NEAR(model.CollectiveSeconds(1 << 22), 2e-5 + (1 << 22) * 1e-10,
+              1e-9);
+}
+
+TEST_F(CollectiveCostModelTest, FitNeedsTwoSizes) {
+  CollectiveCostModel model;
+  EXPECT_FALSE(model.FitCollectiveTimes({{1024, 1e-5}, {1024, 2e-5}}).ok());
+}
+
+TEST_F(CollectiveCostModelTest, CollectivesRunOneAtATime) {
+  const char* const hlo_string = R"(
+HloModule Module
+
+ENTRY entry {
+  param0 = f32[256] parameter(0)
+  param1 = f32[256] parameter(1)
+  allgather0 = f32[1024] all-gather(param0), replica_groups={}, dimensions={0}
+  allgather1 = f32[1024] all-gather(param1), replica_groups={}, dimensions={0}
+  ROOT tuple = (f32[1024], f32[1024]) tuple(allgather0, allgather1)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  CollectiveCostModel model;
+  model.latency_seconds = 1e-5;
+  model.seconds_per_byte = 1e-9;
+  TF_ASSERT_OK_AND_ASSIGN(
+      CriticalPathEstimate estimate,
+      EstimateCriticalPath(*module->entry_computation(), model));
+
+  const HloComputation* entry = module->entry_computation();
+  const HloInstruction* first = entry->root_instruction()->operand(0);
+  const HloInstruction* second = entry->root_instruction()->operand(1);
+  if (estimate.finish_seconds.at(first) > estimate.finish_seconds.at(second)) {
+    std::swap(first, second);
+  }
+  // Both all-gathers are ready at the start, the second one runs after the
+  // first, and only the first one can finish later. The tuple takes a
+  // negligible time.
+  const double seconds = model.CollectiveSeconds(4096);
+  EXPECT_EQ(estimate.ready_seconds.at(second), 0);
+  EXPECT_NEAR(estimate.finish_seconds.at(first), seconds, 1e-9);
+  EXPECT_NEAR(estimate.finish_seconds.at(second), 2 * seconds, 1e-9);
+  EXPECT_NEAR(estimate.total_seconds, 2 * seconds, 1e-9);
+  EXPECT_NEAR(estimate.slack_seconds.at(first), seconds, 1e-9);
+  EXPECT_NEAR(estimate.slack_seconds.at(second), 0, 1e-9);
+}
+
+}  // namespace
+}  // namespace xla
@@ -0,0 +1,318 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/collective_pipeliner.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_query.h"
+#include "tensorflow/compiler/xla/service/while_loop_analysis.h"
+#include "tensorflow/compiler/xla/service/while_util.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace {
+
+using ElementFn = std::function<HloInstruction*(int64_t)>;
+
+// Clones `instruction` of the body of a loop and the instructions it depends
+// on into `computation`, where element i of the state of the loop, i.e.
+// get-tuple-element(`param`, i), is element(i).
+HloInstruction* CloneWithElements(
+    HloInstruction* instruction, const HloInstruction* param,
+    HloComputation* computation, const ElementFn& element,
+    absl::flat_hash_map<const HloInstruction*, HloInstruction*>* clones) {
+  auto it = clones->find(instruction);
+  if (it != clones->end()) {
+    return it->second;
+  }
+  HloInstruction* clone;
+  if (instruction->opcode() == HloOpcode::kGetTupleElement &&
+      instruction->operand(0) == param) {
+    clone = element(instruction->tuple_index());
+  } else {
+    std::vector<HloInstruction*> operands;
+    operands.reserve(instruction->operand_count());
+    for (HloInstruction* operand : instruction->operands()) {
+      operands.push_back(
+          CloneWithElements(operand, param, computation, element, clones));
+    }
+    clone = computation->AddInstruction(
+        instruction->CloneWithNewOperands(instruction->shape(), operands));
+  }
+  (*clones)[instruction] = clone;
+  return clone;
+}
+
+// Returns the induction variable of the iteration where the elements of the
+// state of the loop are element(i), followed by its values in the `count`
+// iterations after it. `update` is the induction variable that the body of the
+// loop computes for the next iteration.
+std::vector<HloInstruction*> InductionVariables(HloInstruction* update,
+                                                const HloInstruction* param,
+                                                int64_t indvar_index,
+                                                HloComputation* computation,
+                                                const ElementFn& element,
+                                                int64_t count) {
+  std::vector<HloInstruction*> indvars = {element(indvar_index)};
+  for (int64_t i = 0; i < count; ++i) {
+    HloInstruction* indvar = indvars.back();
+    absl::flat_hash_map<const HloInstruction*, HloInstruction*> clones;
+    indvars.push_back(CloneWithElements(
+        update, param, computation,
+        [&](int64_t index) {
+          return index == indvar_index ? indvar : element(index);
+        },
+        &clones));
+  }
+  return indvars;
+}
+
+struct PipelinedCollective {
+  HloInstruction* collective;
+  // The number of iterations ahead the collective is issued.
+  int64_t depth;
+};
+
+StatusOr<bool> PipelineCollectivesOfLoop(HloInstruction* while_instr,
+                                         int64_t max_depth,
+                                         int64_t memory_limit_bytes,
+                                         int64_t* next_channel_id) {
+  HloComputation* body = while_instr->while_body();
+  const HloInstruction* param = body->parameter_instruction(0);
+  HloInstruction* root = body->root_instruction();
+  if (!while_instr->shape().IsTuple() || root->opcode() != HloOpcode::kTuple) {
+    return false;
+  }
+  absl::optional<int64_t> indvar_index =
+      GetLoopInductionVarTupleIdx(while_instr);
+  absl::optional<int64_t> trip_count = ComputeWhileLoopTripCount(while_instr);
+  if (!indvar_index.has_value() || !trip_count.has_value() ||
+      *trip_count < 2) {
+    return false;
+  }
+
+  // The elements of the state of the loop that the operands of a pipelined
+  // collective may depend on: the induction variable and the loop invariant
+  // elements.
+  absl::flat_hash_set<int64_t> elements = {*indvar_index};
+  for (int64_t i = 0; i < root->operand_count(); ++i) {
+    const HloInstruction* operand = root->operand(i);
+    if (operand->opcode() == HloOpcode::kGetTupleElement &&
+        operand->operand(0) == param && operand->tuple_index() == i) {
+      elements.insert(i);
+    }
+  }
+
+  // Instructions that can be computed an iteration ahead, and the collectives
+  // of such instructions.
+  absl::flat_hash_set<const HloInstruction*> pipelinable;
+  std::vector<HloInstruction*> collectives;
+  for (HloInstruction* instruction : body->MakeInstructionPostOrder()) {
+    if (instruction->opcode() == HloOpcode::kGetTupleElement &&
+        instruction->operand(0) == param) {
+      if (elements.contains(instruction->tuple_index())) {
+        pipelinable.insert(instruction);
+      }
+      continue;
+    }
+    if (!absl::c_all_of(instruction->operands(),
+                        [&](const HloInstruction* operand) {
+                          return pipelinable.contains(operand);
+                        })) {
+      continue;
+    }
+    if (hlo_query::IsCollectiveCommunicationOp(instruction->opcode())) {
+      if (instruction->control_predecessors().empty() &&
+          instruction->control_successors().empty()) {
+        collectives.push_back(instruction);
+      }
+      continue;
+    }
+    if (instruction->opcode() == HloOpcode::kParameter ||
+        instruction->HasSideEffect() ||
+        (instruction->opcode() != HloOpcode::kFusion &&
+         !instruction->called_computations().empty())) {
+      continue;
+    }
+    pipelinable.insert(instruction);
+  }
+  HloInstruction* update = root->mutable_operand(*indvar_index);
+  if (collectives.empty() || !pipelinable.contains(update)) {
+    return false;
+  }
+
+  // The results of the collectives issued ahead are live across iterations,
+  // so each iteration ahead costs the size of one more result.
+  std::vector<PipelinedCollective> pipelined;
+  int64_t memory_left = memory_limit_bytes;
+  int64_t max_pipelined_depth = 0;
+  for (HloInstruction* collective : collectives) {
+    int64_t bytes = ShapeUtil::ByteSizeOf(collective->shape(), sizeof(void*));
+    int64_t depth = std::min(max_depth, *trip_count - 1);
+    if (bytes > 0) {
+      depth = std::min(depth, memory_left / bytes);
+    }
+    if (depth <= 0) {
+      VLOG(2) << "Not pipelining " << collective->name() << " of "
+              << while_instr->name() << ", its " << bytes
+              << " bytes exceed the memory limit";
+      continue;
+    }
+    VLOG(1) << "Pipelining " << collective->name() << " of "
+            << while_instr->name() << " " << depth << " iterations ahead";
+    memory_left -= depth * bytes;
+    max_pipelined_depth = std::max(max_pipelined_depth, depth);
+    pipelined.push_back({collective, depth});
+  }
+  if (pipelined.empty()) {
+    return false;
+  }
+
+  // Returns a clone of `collective` for the iteration where the induction
+  // variable is `indvar` and the other elements are element(i).
+  auto clone_collective = [&](HloInstruction* collective,
+                              HloComputation* computation,
+                              HloInstruction* indvar,
+                              const ElementFn& element) {
+    absl::flat_hash_map<const HloInstruction*, HloInstruction*> clones;
+    HloInstruction* clone = CloneWithElements(
+        collective, param, computation,
+        [&](int64_t index) {
+          return index == *indvar_index ? indvar : element(index);
+        },
+        &clones);
+    if (clone->channel_id().has_value()) {
+      clone->set_channel_id((*next_channel_id)++);
+    }
+    return clone;
+  };
+
+  // Peel the collectives of the first iterations off into the computation of
+  // the loop.
+  HloComputation* computation = while_instr->parent();
+  HloInstruction* init = while_instr->mutable_operand(0);
+  absl::flat_hash_map<int64_t, HloInstruction*> init_elements;
+  ElementFn init_element = [&](int64_t index) {
+    if (init->opcode() == HloOpcode::kTuple) {
+      return init->mutable_operand(index);
+    }
+    HloInstruction*& element = init_elements[index];
+    if (element == nullptr) {
+      element =
+          computation->AddInstruction(HloInstruction::CreateGetTupleElement(
+              init->shape().tuple_shapes(index), init, index));
+    }
+    return element;
+  };
+  std::vector<HloInstruction*> init_indvars =
+      InductionVariables(update, param, *indvar_index, computation,
+                         init_element, max_pipelined_depth - 1);
+  std::vector<HloInstruction*> peeled;
+  for (const PipelinedCollective& collective : pipelined) {
+    for (int64_t i = 0; i < collective.depth; ++i) {
+      peeled.push_back(clone_collective(collective.collective, computation,
+                                        init_indvars[i], init_element));
+    }
+  }
+
+  // Carry the results through the loop, each iteration uses the result of the
+  // oldest collective and issues the next one.
+  TF_ASSIGN_OR_RETURN(WhileUtil::MakeInstructionsLiveInResult result,
+                      WhileUtil::MakeInstructionsLiveIn(while_instr, peeled));
+  HloComputation* new_body = result.new_while_instr->while_body();
+  HloInstruction* new_param = new_body->parameter_instruction(0);
+  HloInstruction* new_root = new_body->root_instruction();
+  absl::flat_hash_map<int64_t, HloInstruction*> body_elements;
+  ElementFn body_element = [&](int64_t index) {
+    HloInstruction*& element = body_elements[index];
+    if (element == nullptr) {
+      element = new_body->AddInstruction(HloInstruction::CreateGetTupleElement(
+          new_param->shape().tuple_shapes(index), new_param, index));
+    }
+    return element;
+  };
+  std::vector<HloInstruction*> body_indvars =
+      InductionVariables(update, param, *indvar_index, new_body, body_element,
+                         max_pipelined_depth);
+  const int64_t old_element_count = root->operand_count();
+  int64_t live_in_index = 0;
+  for (const PipelinedCollective& collective : pipelined) {
+    HloInstruction* next =
+        clone_collective(collective.collective, new_body,
+                         body_indvars[collective.depth], body_element);
+    HloInstruction* collective_in_body =
+        result.while_body_instruction_map.at(collective.collective);
+    const std::vector<HloInstruction*>& carried =
+        result.while_body_live_in_values;
+    TF_RETURN_IF_ERROR(
+        collective_in_body->ReplaceAllUsesWith(carried[live_in_index]));
+    TF_RETURN_IF_ERROR(
+        new_body->RemoveInstructionAndUnusedOperands(collective_in_body));
+    for (int64_t i = 0; i < collective.depth; ++i) {
+      HloInstruction* operand = i + 1 < collective.depth
+                                    ? carried[live_in_index + i + 1]
+                                    : next;
+      TF_RETURN_IF_ERROR(new_root->ReplaceOperandWith(
+          old_element_count + live_in_index + i, operand));
+    }
+    live_in_index += collective.depth;
+  }
+  return true;
+}
+
+}  // namespace
+
+StatusOr<bool> CollectivePipeliner::Run(HloModule* module) {
+  if (max_depth_ <= 0) {
+    return false;
+  }
+  // Loops nested in the body of another loop are pipelined first, since
+  // pipelining a loop replaces its body.
+  std::vector<HloInstruction*> while_instrs;
+  for (HloComputation* computation : module->MakeComputationPostOrder()) {
+    if (computation->IsFusionComputation()) {
+      continue;
+    }
+    for (HloInstruction* instruction : computation->instructions()) {
+      if (instruction->opcode() == HloOpcode::kWhile) {
+        while_instrs.push_back(instruction);
+      }
+    }
+  }
+
+  int64_t next_channel_id = hlo_query::NextChannelId(*module);
+  bool changed = false;
+  for (HloInstruction* while_instr : while_instrs) {
+    TF_ASSIGN_OR_RETURN(
+        bool pipelined,
+        PipelineCollectivesOfLoop(while_instr, max_depth_, memory_limit_bytes_,
+                                  &next_channel_id));
+    changed |= pipelined;
+  }
+  return changed;
+}
+
+}  // namespace xla
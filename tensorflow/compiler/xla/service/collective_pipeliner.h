@@ -0,0 +1,72 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_COLLECTIVE_PIPELINER_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_COLLECTIVE_PIPELINER_H_
+
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+
+// HLO pass that software-pipelines collectives of while loops across
+// iterations. A collective of the loop body can be pipelined if its operands
+// only depend on the induction variable and on loop invariant values, e.g. the
+// all-gather of the weights of one layer of a stack of layers:
+//
+// Pattern before this pass:
+// while (i < n):
+//   w = all-gather(dynamic-slice(weights, i))
+//   x = f(x, w)
+//   i += 1
+// Pattern after this pass, with a depth of 1:
+// w0 = all-gather(dynamic-slice(weights, 0))
+// while (i < n):
+//   x = f(x, w0)
+//   w0 = all-gather(dynamic-slice(weights, i + 1))
+//   i += 1
+//
+// The collective of the first `depth` iterations is peeled off into the
+// computation of the loop, and each iteration issues the collective of the
+// iteration `depth` ahead, whose result is carried through the state of the
+// loop. That collective does not depend on the computation of the iteration,
+// so it can be converted to an asynchronous collective that overlaps with it.
+// The collectives of the last `depth` iterations read clamped indices, their
+// results are not used.
+//
+// Each iteration ahead keeps the result of one more collective live, so the
+// depth of each collective is limited, in order of the body, by the number of
+// bytes that the carried results of a loop may occupy in total.
+class CollectivePipeliner : public HloModulePass {
+ public:
+  // `max_depth` is the number of iterations ahead collectives are issued, and
+  // `memory_limit_bytes` the size of the results they may carry per loop.
+  CollectivePipeliner(int64_t max_depth, int64_t memory_limit_bytes)
+      : max_depth_(max_depth), memory_limit_bytes_(memory_limit_bytes) {}
+  ~CollectivePipeliner() override = default;
+
+  absl::string_view name() const override { return "collective-pipeliner"; }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  const int64_t max_depth_;
+  const int64_t memory_limit_bytes_;
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_COLLECTIVE_PIPELINER_H_
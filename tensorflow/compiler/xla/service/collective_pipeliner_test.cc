@@ -0,0 +1,228 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/collective_pipeliner.h"
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace xla {
+namespace {
+
+namespace op = ::xla::testing::opcode_matchers;
+
+// A loop over 4 layers that all-gathers the f32[2,16] shard of the weights of
+// each layer, 512 bytes once gathered.
+constexpr absl::string_view kLayerLoop = R"(
+  HloModule layer_loop
+
+  %while_condition {
+    %param = (s32[], f32[4,2,16], f32[8,16]) parameter(0)
+    %i = s32[] get-tuple-element(%param), index=0
+    %n = s32[] constant(4)
+    ROOT %result = pred[] compare(%i, %n), direction=LT
+  }
+
+  %while_body {
+    %param = (s32[], f32[4,2,16], f32[8,16]) parameter(0)
+    %i = s32[] get-tuple-element(%param), index=0
+    %weights = f32[4,2,16] get-tuple-element(%param), index=1
+    %x = f32[8,16] get-tuple-element(%param), index=2
+    %zero = s32[] constant(0)
+    %slice = f32[1,2,16] dynamic-slice(%weights, %i, %zero, %zero), dynamic_slice_sizes={1,2,16}
+    %shard = f32[2,16] reshape(%slice)
+    %all-gather = f32[8,16] all-gather(%shard), channel_id=1, replica_groups={{0,1,2,3}}, dimensions={0}, use_global_device_ids=true
+    %next_x = f32[8,16] multiply(%x, %all-gather)
+    %one = s32[] constant(1)
+    %next_i = s32[] add(%i, %one)
+    ROOT %loop_result = (s32[], f32[4,2,16], f32[8,16]) tuple(%next_i, %weights, %next_x)
+  }
+
+  ENTRY %entry {
+    %weights = f32[4,2,16] parameter(0)
+    %x = f32[8,16] parameter(1)
+    %zero = s32[] constant(0)
+    %init = (s32[], f32[4,2,16], f32[8,16]) tuple(%zero, %weights, %x)
+    %while = (s32[], f32[4,2,16], f32[8,16]) while(%init), condition=%while_condition, body=%while_body
+    ROOT %result = f32[8,16] get-tuple-element(%while), index=2
+  }
+)";
+
+class CollectivePipelinerTest : public HloTestBase {
+ protected:
+  static HloInstruction* FindWhile(HloModule* module) {
+    for (HloInstruction* instruction :
+         module->entry_computation()->instructions()) {
+      if (instruction->opcode() == HloOpcode::kWhile) {
+        return instruction;
+      }
+    }
+    return nullptr;
+  }
+};
+
+TEST_F(CollectivePipelinerTest, PipelineAllGatherOfWeights) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(
+                                           kLayerLoop, /*replica_count=*/4));
+  CollectivePipeliner pipeliner(/*max_depth=*/1,
+                                /*memory_limit_bytes=*/1024);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunHloPass(&pipeliner, module.get()));
+  EXPECT_TRUE(changed);
+
+  // The all-gather of the first layer is peeled off before the loop.
+  HloInstruction* while_instr = FindWhile(module.get());
+  ASSERT_NE(while_instr, nullptr);
+  ASSERT_EQ(while_instr->shape().tuple_shapes_size(), 4);
+  const HloInstruction* peeled = while_instr->operand(0)->operand(3);
+  EXPECT_THAT(peeled, op::AllGather(op::Reshape(op::DynamicSlice(
+                          op::Parameter(0), op::Constant(), op::Constant(),
+                          op::Constant()))));
+
+  // The body multiplies by the carried all-gather and issues the all-gather of
+  // the next layer.
+  HloComputation* body = while_instr->while_body();
+  const HloInstruction* multiply = nullptr;
+  const HloInstruction* next = body->root_instruction()->operand(3);
+  for (const HloInstruction* instruction : body->instructions()) {
+    if (instruction->opcode() == HloOpcode::kMultiply) {
+      multiply = instruction;
+    }
+    if (instruction->opcode() == HloOpcode::kAllGather) {
+      EXPECT_EQ(instruction, next);
+    }
+  }
+  ASSERT_NE(multiply, nullptr);
+  EXPECT_THAT(multiply->operand(1),
+              op::GetTupleElement(op::Parameter(0), 3));
+  EXPECT_THAT(next, op::AllGather(op::Reshape(op::DynamicSlice(
+                        op::GetTupleElement(op::Parameter(0), 1), op::Add(),
+                        op::Constant(), op::Constant()))));
+  EXPECT_THAT(next->operand(0)->operand(0)->operand(1),
+              op::Add(op::GetTupleElement(op::Parameter(0), 0),
+                      op::Constant()));
+
+  // Each clone of the all-gather is on a channel of its own.
+  EXPECT_NE(peeled->channel_id(), next->channel_id());
+  EXPECT_NE(*peeled->channel_id(), 1);
+  EXPECT_NE(*next->channel_id(), 1);
+}
+
+TEST_F(CollectivePipelinerTest, PipelineTwoIterationsAhead) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(
+                                           kLayerLoop, /*replica_count=*/4));
+  CollectivePipeliner pipeliner(/*max_depth=*/2,
+                                /*memory_limit_bytes=*/1024);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunHloPass(&pipeliner, module.get()));
+  EXPECT_TRUE(changed);
+
+  HloInstruction* while_instr = FindWhile(module.get());
+  ASSERT_NE(while_instr, nullptr);
+  ASSERT_EQ(while_instr->shape().tuple_shapes_size(), 5);
+  EXPECT_THAT(while_instr->operand(0)->operand(3), op::AllGather());
+  EXPECT_THAT(while_instr->operand(0)->operand(4), op::AllGather());
+
+  // The second carried result moves to the first, and the all-gather two
+  // iterations ahead to the second.
+  const HloInstruction* root = while_instr->while_body()->root_instruction();
+  EXPECT_THAT(root->operand(3), op::GetTupleElement(op::Parameter(0), 4));
+  EXPECT_THAT(root->operand(4),
+              op::AllGather(op::Reshape(op::DynamicSlice(
+                  op::GetTupleElement(),
+                  op::Add(op::Add(op::GetTupleElement(op::Parameter(0), 0),
+                                  op::Constant()),
+                          op::Constant()),
+                  op::Constant(), op::Constant()))));
+}
+
+TEST_F(CollectivePipelinerTest, DepthIsLimitedByMemory) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(
+                                           kLayerLoop, /*replica_count=*/4));
+  // 1000 bytes only fit one 512 byte result.
+  CollectivePipeliner pipeliner(/*max_depth=*/3,
+                                /*memory_limit_bytes=*/1000);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunHloPass(&pipeliner, module.get()));
+  EXPECT_TRUE(changed);
+  HloInstruction* while_instr = FindWhile(module.get());
+  ASSERT_NE(while_instr, nullptr);
+  EXPECT_EQ(while_instr->shape().tuple_shapes_size(), 4);
+}
+
+TEST_F(CollectivePipelinerTest, NoPipeliningWithoutMemory) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(
+                                           kLayerLoop, /*replica_count=*/4));
+  CollectivePipeliner pipeliner(/*max_depth=*/1,
+                                /*memory_limit_bytes=*/256);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunHloPass(&pipeliner, module.get()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(CollectivePipelinerTest, DepthIsLimitedByTripCount) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(
+                                           kLayerLoop, /*replica_count=*/4));
+  CollectivePipeliner pipeliner(/*max_depth=*/8,
+                                /*memory_limit_bytes=*/1 << 20);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunHloPass(&pipeliner, module.get()));
+  EXPECT_TRUE(changed);
+  HloInstruction* while_instr = FindWhile(module.get());
+  ASSERT_NE(while_instr, nullptr);
+  EXPECT_EQ(while_instr->shape().tuple_shapes_size(), 3 + 3);
+}
+
+TEST_F(CollectivePipelinerTest, DoNotPipelineLoopVariantOperand) {
+  constexpr absl::string_view kHloModule = R"(
+    HloModule loop_variant
+
+    %while_condition {
+      %param = (s32[], f32[2,16]) parameter(0)
+      %i = s32[] get-tuple-element(%param), index=0
+      %n = s32[] constant(4)
+      ROOT %result = pred[] compare(%i, %n), direction=LT
+    }
+
+    %while_body {
+      %param = (s32[], f32[2,16]) parameter(0)
+      %i = s32[] get-tuple-element(%param), index=0
+      %x = f32[2,16] get-tuple-element(%param), index=1
+      %all-gather = f32[8,16] all-gather(%x), channel_id=1, replica_groups={{0,1,2,3}}, dimensions={0}, use_global_device_ids=true
+      %next_x = f32[2,16] slice(%all-gather), slice={[0:2], [0:16]}
+      %one = s32[] constant(1)
+      %next_i = s32[] add(%i, %one)
+      ROOT %loop_result = (s32[], f32[2,16]) tuple(%next_i, %next_x)
+    }
+
+    ENTRY %entry {
+      %x = f32[2,16] parameter(0)
+      %zero = s32[] constant(0)
+      %init = (s32[], f32[2,16]) tuple(%zero, %x)
+      %while = (s32[], f32[2,16]) while(%init), condition=%while_condition, body=%while_body
+      ROOT %result = f32[2,16] get-tuple-element(%while), index=1
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(
+                                           kHloModule, /*replica_count=*/4));
+  CollectivePipeliner pipeliner(/*max_depth=*/1,
+                                /*memory_limit_bytes=*/1 << 20);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunHloPass(&pipeliner, module.get()));
+  EXPECT_FALSE(changed);
+}
+
+}  // namespace
+}  // namespace xla
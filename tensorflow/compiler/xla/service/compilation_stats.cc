@@ -15,15 +15,24 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/compilation_stats.h"
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "tensorflow/compiler/xla/metric_table_report.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/platform.h"
+
+#if !defined(PLATFORM_WINDOWS)
+#include <sys/resource.h>
+#endif
 
 namespace xla {
 
@@ -33,6 +42,9 @@ class NoopStats : public CompilationStats {
 
   void StartPass(absl::string_view pass_name) override {}
 
+  void RecordPassEffects(absl::string_view pass_name,
+                         const PassEffects& effects) override {}
+
   void EndPass(absl::string_view pass_name) override {}
 
   void CompilationReport() override {}
@@ -46,6 +58,9 @@ class Stats : public CompilationStats {
 
   void StartPass(absl::string_view pass_name) override;
 
+  void RecordPassEffects(absl::string_view pass_name,
+                         const PassEffects& effects) override;
+
   void EndPass(absl::string_view pass_name) override;
 
   void CompilationReport() override;
@@ -54,12 +69,26 @@ class Stats : public CompilationStats {
 
  private:
   struct PassInfo {
-    PassInfo(absl::string_view name, double duration)
-        : name(name), duration_ms(duration) {}
+    PassInfo(absl::string_view name, double duration,
+             const PassEffects& effects)
+        : name(name),
+          duration_ms(duration),
+          instruction_count_delta(effects.instruction_count_delta),
+          peak_rss_bytes(effects.peak_rss_bytes_after) {
+      if (effects.peak_rss_bytes_before >= 0 &&
+          effects.peak_rss_bytes_after >= 0) {
+        peak_rss_growth_bytes =
+            effects.peak_rss_bytes_after - effects.peak_rss_bytes_before;
+      }
+    }
 
     std::string name;
     int num_runs = 1;
     double duration_ms;
+    int64_t instruction_count_delta;
+    // The peak RSS at the end of the pass, and how much the pass grew it.
+    int64_t peak_rss_bytes;
+    int64_t peak_rss_growth_bytes = 0;
   };
 
   // Info about the passes that have been run so far.
@@ -69,6 +98,8 @@ class Stats : public CompilationStats {
   std::string current_pass_;
   // The start time of the currently running pass.
   uint64 start_micros_;
+  // The effects of the currently running pass.
+  PassEffects current_effects_;
 };
 
 /* static */
@@ -81,12 +112,38 @@ std::unique_ptr<CompilationStats> CompilationStats::MakeStats() {
   return absl::make_unique<Stats>();
 }
 
+/* static */
+int64_t CompilationStats::PeakRssBytes() {
+#if defined(PLATFORM_WINDOWS)
+  return -1;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return -1;
+  }
+#if defined(__APPLE__)
+  // ru_maxrss is in bytes on macOS, and in kilobytes on Linux.
+  return usage.ru_maxrss;
+#else
+  return int64_t{usage.ru_maxrss} * 1024;
+#endif
+#endif
+}
+
 void Stats::StartPass(absl::string_view pass_name) {
   CHECK(!pass_running_) << "Can't start " << pass_name << " while running "
                         << current_pass_;
   pass_running_ = true;
   current_pass_ = std::string(pass_name);
   start_micros_ = tensorflow::Env::Default()->NowMicros();
+  current_effects_ = PassEffects();
+}
+
+void Stats::RecordPassEffects(absl::string_view pass_name,
+                              const PassEffects& effects) {
+  CHECK(pass_running_);
+  CHECK_EQ(current_pass_, std::string(pass_name));
+  current_effects_ = effects;
 }
 
 void Stats::EndPass(absl::string_view pass_name) {
@@ -95,7 +152,7 @@ void Stats::EndPass(absl::string_view pass_name) {
   pass_running_ = false;
   uint64 end_micros = tensorflow::Env::Default()->NowMicros();
   double duration_ms = (end_micros - start_micros_) / 1000.0;
-  passes_.push_back(PassInfo(current_pass_, duration_ms));
+  passes_.push_back(PassInfo(current_pass_, duration_ms, current_effects_));
 }
 
 void Stats::CompilationReport() {
@@ -110,27 +167,43 @@ void Stats::CompilationReport() {
     if (it == summary.end()) {
       summary.insert(std::make_pair(pass_name, pass_run));
     } else {
-      ++summary.at(pass_name).num_runs;
-      summary.at(pass_name).duration_ms += pass_run.duration_ms;
+      PassInfo& info = it->second;
+      ++info.num_runs;
+      info.duration_ms += pass_run.duration_ms;
+      info.instruction_count_delta += pass_run.instruction_count_delta;
+      info.peak_rss_bytes =
+          std::max(info.peak_rss_bytes, pass_run.peak_rss_bytes);
+      info.peak_rss_growth_bytes += pass_run.peak_rss_growth_bytes;
     }
   }
 
-  std::vector<PassInfo> sorted_summary;
-  sorted_summary.reserve(summary.size());
-  for (auto& it : summary) {
-    sorted_summary.push_back(it.second);
+  MetricTableReport report;
+  report.SetMetricName("microseconds");
+  report.SetEntryName("passes");
+  report.SetShowEntryTable();
+  report.SetShowAllEntries();
+  for (const auto& it : summary) {
+    const PassInfo& pass_info = it.second;
+    MetricTableReport::Entry entry;
+    entry.text = absl::StrFormat("%s (%d runs, %+d instructions",
+                                 pass_info.name, pass_info.num_runs,
+                                 pass_info.instruction_count_delta);
+    if (pass_info.peak_rss_bytes >= 0) {
+      absl::StrAppend(
+          &entry.text, ", peak RSS +",
+          tensorflow::strings::HumanReadableNumBytes(
+              pass_info.peak_rss_growth_bytes),
+          " to ",
+          tensorflow::strings::HumanReadableNumBytes(pass_info.peak_rss_bytes));
+    }
+    absl::StrAppend(&entry.text, ")");
+    entry.short_text = pass_info.name;
+    entry.category_text = pass_info.name;
+    entry.metric = pass_info.duration_ms * 1000;
+    report.AddEntry(std::move(entry));
   }
-  absl::c_sort(sorted_summary, [](const PassInfo& a, const PassInfo& b) {
-    // Sort passes that take the longest first, break ties using pass names.
-    return std::make_pair(b.duration_ms, a.name) <
-           std::make_pair(a.duration_ms, b.name);
-  });
   LOG(INFO) << "Total runtime (ms) of HLO passes: " << total_duration;
-  LOG(INFO) << "Pass name, num runs, time (ms)";
-  for (auto& pass_info : sorted_summary) {
-    LOG(INFO) << pass_info.name << ", " << pass_info.num_runs << ", "
-              << pass_info.duration_ms;
-  }
+  report.WriteReportToInfoLog(total_duration * 1000);
 }
 
 int Stats::GetPassesSize() { return passes_.size(); }
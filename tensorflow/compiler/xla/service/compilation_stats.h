@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_COMPILATION_STATS_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_COMPILATION_STATS_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -25,19 +26,37 @@ namespace xla {
 
 // This class is used to collect information about HLO passes and print some
 // statistics at the end of compilation. From HloPassPipeline, we call StartPass
-// before the execution of a pass, and EndPass after. Currently, we only collect
-// timing information and how many times each pass was run. In the future, we
-// can add more things, such as the size of the HLO graph after each pass.
+// before the execution of a pass, RecordPassEffects once the pass ran, and
+// EndPass after. We collect timing information, how many times each pass was
+// run, how the pass changed the number of HLO instructions and how much it
+// grew the peak memory use of the process.
 class CompilationStats {
  public:
+  // How a run of a pass changed the HLO and the memory use of the process.
+  struct PassEffects {
+    // Number of instructions after the pass minus before it.
+    int64_t instruction_count_delta = 0;
+    // Peak resident set size of the process before and after the pass, or -1
+    // if it is unknown.
+    int64_t peak_rss_bytes_before = -1;
+    int64_t peak_rss_bytes_after = -1;
+  };
+
   virtual ~CompilationStats() = default;
 
   static std::unique_ptr<CompilationStats> MakeNoopStats();
 
   static std::unique_ptr<CompilationStats> MakeStats();
 
+  // Returns the peak resident set size of the process since it started, or -1
+  // if it is unknown on this platform.
+  static int64_t PeakRssBytes();
+
   virtual void StartPass(absl::string_view pass_name) = 0;
 
+  virtual void RecordPassEffects(absl::string_view pass_name,
+                                 const PassEffects& effects) = 0;
+
   virtual void EndPass(absl::string_view pass_name) = 0;
 
   virtual void CompilationReport() = 0;
@@ -23,26 +23,37 @@ limitations under the License.
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SmallVectorMemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/AlwaysInliner.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/llvm_ir_runtime.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/coding.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/raw_coding.h"
 
 namespace xla {
 namespace cpu {
@@ -78,13 +89,67 @@ class FilteredPassManager : public llvm::legacy::PassManager {
  private:
   bool disable_expensive_passes_;
 };
+
+// Functions with at least this many instructions are not inlined when a
+// module is compiled in parallel, so that they can be compiled on their own.
+constexpr unsigned kMinInstructionsForOutOfLineCall = 1024;
+
 }  // anonymous namespace
 
 llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> CompilerFunctor::operator()(
     llvm::Module& module) {
-  FilteredPassManager module_passes(disable_expensive_passes_);
-  llvm::legacy::FunctionPassManager function_passes(&module);
+  VLOG(2) << "IR before optimizations";
+  XLA_VLOG_LINES(2, llvm_ir::DumpModuleToString(module));
+
+  if (pre_optimization_hook_) {
+    pre_optimization_hook_(module);
+  }
+
+  std::string persistent_key;
+  if (persistent_cache_ != nullptr) {
+    persistent_key = PersistentCacheKey(module);
+    if (absl::optional<std::string> object_file =
+            persistent_cache_->Lookup(persistent_key)) {
+      std::unique_ptr<llvm::MemoryBuffer> memory_buffer =
+          llvm::MemoryBuffer::getMemBufferCopy(*object_file,
+                                               module.getModuleIdentifier());
+      RunPostCodegenHook(*memory_buffer);
+      return std::move(memory_buffer);
+    }
+  }
+
+  OptimizeModule(target_machine_, module);
+
+  VLOG(2) << "IR after optimizations";
+  XLA_VLOG_LINES(2, llvm_ir::DumpModuleToString(module));
+
+  if (post_optimization_hook_) {
+    post_optimization_hook_(module);
+  }
 
+  std::unique_ptr<llvm::MemoryBuffer> memory_buffer =
+      EmitObjectFile(target_machine_, module);
+
+  if (persistent_cache_ != nullptr) {
+    Status status = persistent_cache_->Insert(
+        persistent_key, absl::string_view(memory_buffer->getBufferStart(),
+                                          memory_buffer->getBufferSize()));
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to persist object file: " << status;
+    }
+  }
+
+  RunPostCodegenHook(*memory_buffer);
+
+  return std::move(memory_buffer);
+}
+
+std::vector<std::unique_ptr<llvm::MemoryBuffer>>
+CompilerFunctor::CompileInParallel(
+    llvm::Module& module, int num_partitions,
+    const std::function<std::unique_ptr<llvm::TargetMachine>()>&
+        target_machine_builder,
+    tensorflow::thread::ThreadPool* thread_pool) {
   VLOG(2) << "IR before optimizations";
   XLA_VLOG_LINES(2, llvm_ir::DumpModuleToString(module));
 
@@ -92,8 +157,119 @@ llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> CompilerFunctor::operator()(
     pre_optimization_hook_(module);
   }
 
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> object_files;
+  std::string persistent_key;
+  if (persistent_cache_ != nullptr) {
+    persistent_key =
+        absl::StrCat("split;", num_partitions, ";", PersistentCacheKey(module));
+    if (absl::optional<std::string> value =
+            persistent_cache_->Lookup(persistent_key)) {
+      // The value holds the object files, each preceded by its size.
+      absl::string_view rest = *value;
+      while (rest.size() >= sizeof(uint64_t)) {
+        uint64_t size = tensorflow::core::DecodeFixed64(rest.data());
+        rest.remove_prefix(sizeof(uint64_t));
+        if (size > rest.size()) break;
+        object_files.push_back(llvm::MemoryBuffer::getMemBufferCopy(
+            llvm::StringRef(rest.data(), size),
+            absl::StrCat(module.getModuleIdentifier(), ".",
+                         object_files.size())));
+        rest.remove_prefix(size);
+      }
+      if (rest.empty()) {
+        for (const auto& object_file : object_files) {
+          RunPostCodegenHook(*object_file);
+        }
+        return object_files;
+      }
+      LOG(WARNING) << "Ignoring malformed persistent compilation cache entry";
+      object_files.clear();
+    }
+  }
+
+  // Large computations are kept out of line so that they can be placed in
+  // different partitions. Smaller functions stay local and are placed with
+  // their callers, so the inlining of e.g. reduction computations is the
+  // same as on the serial path.
+  for (llvm::Function& function : module.functions()) {
+    if (!function.isDeclaration() && function.hasLocalLinkage() &&
+        !function.hasFnAttribute(llvm::Attribute::AlwaysInline) &&
+        function.getInstructionCount() >= kMinInstructionsForOutOfLineCall) {
+      function.setLinkage(llvm::GlobalValue::ExternalLinkage);
+      function.setVisibility(llvm::GlobalValue::HiddenVisibility);
+      function.addFnAttr(llvm::Attribute::NoInline);
+    }
+  }
+
+  // Each partition is moved to its own context through bitcode, since
+  // contexts cannot be shared across threads, and the object files are
+  // linked back together by the JIT.
+  std::vector<std::string> partitions;
+  llvm::SplitModule(
+      module, num_partitions,
+      [&](std::unique_ptr<llvm::Module> partition) {
+        std::string bitcode;
+        llvm::raw_string_ostream os(bitcode);
+        llvm::WriteBitcodeToFile(*partition, os);
+        os.flush();
+        partitions.push_back(std::move(bitcode));
+      },
+      /*PreserveLocals=*/true);
+  VLOG(1) << "Compiling " << partitions.size() << " partitions of module "
+          << module.getModuleIdentifier() << " in parallel";
+
+  object_files.resize(partitions.size());
+  tensorflow::mutex hook_mu;
+  tensorflow::BlockingCounter counter(partitions.size());
+  for (int i = 0; i < partitions.size(); ++i) {
+    thread_pool->Schedule([&, i] {
+      llvm::LLVMContext context;
+      llvm::Expected<std::unique_ptr<llvm::Module>> partition =
+          llvm::parseBitcodeFile(
+              llvm::MemoryBufferRef(partitions[i], module.getName()), context);
+      if (!partition) {
+        LOG(FATAL) << "Failed to parse bitcode: "
+                   << llvm::toString(partition.takeError());
+      }
+      std::unique_ptr<llvm::TargetMachine> target_machine =
+          target_machine_builder();
+      OptimizeModule(target_machine.get(), **partition);
+      if (post_optimization_hook_) {
+        tensorflow::mutex_lock lock(hook_mu);
+        post_optimization_hook_(**partition);
+      }
+      object_files[i] = EmitObjectFile(target_machine.get(), **partition);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+
+  if (persistent_cache_ != nullptr) {
+    std::string value;
+    for (const auto& object_file : object_files) {
+      tensorflow::core::PutFixed64(&value, object_file->getBufferSize());
+      value.append(object_file->getBufferStart(),
+                   object_file->getBufferSize());
+    }
+    Status status = persistent_cache_->Insert(persistent_key, value);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to persist object files: " << status;
+    }
+  }
+
+  for (const auto& object_file : object_files) {
+    RunPostCodegenHook(*object_file);
+  }
+  return object_files;
+}
+
+void CompilerFunctor::OptimizeModule(llvm::TargetMachine* target_machine,
+                                     llvm::Module& module) const {
+  FilteredPassManager module_passes(disable_expensive_passes_);
+  llvm::legacy::FunctionPassManager function_passes(&module);
+
   // Add the appropriate TargetLibraryInfo and TargetTransformInfo.
-  AddTargetInfoPasses(&module_passes);
+  AddTargetInfoPasses(target_machine, &module_passes);
 
   // Build up optimization pipeline.
   if (optimize_for_size_) {
@@ -124,38 +300,50 @@ llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> CompilerFunctor::operator()(
   CHECK(!llvm::verifyModule(module, &llvm::dbgs()));
 
   runtime::RewriteIRRuntimeFunctions(&module, fast_math_flags_);
+}
 
+/*static*/ std::unique_ptr<llvm::MemoryBuffer> CompilerFunctor::EmitObjectFile(
+    llvm::TargetMachine* target_machine, llvm::Module& module) {
   // Buffer for holding machine code prior to constructing the ObjectFile.
   llvm::SmallVector<char, 0> stream_buffer;
   llvm::raw_svector_ostream ostream(stream_buffer);
 
-  VLOG(2) << "IR after optimizations";
-  XLA_VLOG_LINES(2, llvm_ir::DumpModuleToString(module));
-
-  if (post_optimization_hook_) {
-    post_optimization_hook_(module);
-  }
-
   // Generate code.
   llvm::MCContext* mc_context;
   llvm::legacy::PassManager codegen_passes;
-  target_machine_->addPassesToEmitMC(codegen_passes, mc_context, ostream);
+  target_machine->addPassesToEmitMC(codegen_passes, mc_context, ostream);
   codegen_passes.run(module);
 
-  std::unique_ptr<llvm::MemoryBuffer> memory_buffer(
+  return std::unique_ptr<llvm::MemoryBuffer>(
       new llvm::SmallVectorMemoryBuffer(std::move(stream_buffer)));
+}
 
+std::string CompilerFunctor::PersistentCacheKey(
+    const llvm::Module& module) const {
+  // The IR is taken before optimization, so the key covers everything that
+  // the optimization and code generation passes depend on.
+  return absl::StrCat(
+      "llvm;", target_machine_->getTargetTriple().str(), ";",
+      target_machine_->getTargetCPU().str(), ";",
+      target_machine_->getTargetFeatureString().str(), ";", opt_level_, ";",
+      optimize_for_size_, ";", disable_expensive_passes_, ";",
+      fast_math_flags_.isFast(), fast_math_flags_.noNaNs(),
+      fast_math_flags_.noInfs(), fast_math_flags_.approxFunc(),
+      fast_math_flags_.allowReciprocal(), ";",
+      llvm_ir::DumpModuleToString(module));
+}
+
+void CompilerFunctor::RunPostCodegenHook(
+    const llvm::MemoryBuffer& memory_buffer) const {
   if (post_codegen_hook_) {
     llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> obj_file =
-        llvm::object::ObjectFile::createObjectFile(*memory_buffer);
+        llvm::object::ObjectFile::createObjectFile(memory_buffer);
     if (obj_file) {
       post_codegen_hook_(*obj_file.get());
     } else {
       LOG(WARNING) << "Could convert memory buffer to object file!";
     }
   }
-
-  return std::move(memory_buffer);
 }
 
 static std::vector<llvm::VecDesc> VectorFunctionsForTargetLibraryInfoImpl() {
@@ -201,8 +389,9 @@ static std::vector<llvm::VecDesc> VectorFunctionsForTargetLibraryInfoImpl() {
 }
 
 void CompilerFunctor::AddTargetInfoPasses(
+    llvm::TargetMachine* target_machine,
     llvm::legacy::PassManagerBase* passes) const {
-  llvm::Triple target_triple(target_machine_->getTargetTriple());
+  llvm::Triple target_triple(target_machine->getTargetTriple());
   auto target_library_info_impl =
       absl::make_unique<llvm::TargetLibraryInfoImpl>(target_triple);
   target_library_info_impl->addVectorizableFunctions(
@@ -211,7 +400,7 @@ void CompilerFunctor::AddTargetInfoPasses(
   passes->add(
       new llvm::TargetLibraryInfoWrapperPass(*target_library_info_impl));
   passes->add(createTargetTransformInfoWrapperPass(
-      target_machine_->getTargetIRAnalysis()));
+      target_machine->getTargetIRAnalysis()));
 }
 
 void CompilerFunctor::AddOptimizationPasses(
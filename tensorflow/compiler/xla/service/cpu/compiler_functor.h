@@ -16,6 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_COMPILER_FUNCTOR_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_COMPILER_FUNCTOR_H_
 
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
@@ -23,13 +28,19 @@ limitations under the License.
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/llvm_compiler.h"
+#include "tensorflow/compiler/xla/service/persistent_compilation_cache.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 namespace cpu {
 
 // Functor class for compiling an LLVM module down to an object file. For use by
 // Orc JIT compile layer.
+//
+// If `persistent_cache` is not null, object files are looked up in it by the
+// unoptimized IR and the code generation options, and stored into it after
+// they are generated. The post-optimization hook is not invoked on a hit.
 class CompilerFunctor : public llvm::orc::IRCompileLayer::IRCompiler {
  public:
   explicit CompilerFunctor(
@@ -39,7 +50,8 @@ class CompilerFunctor : public llvm::orc::IRCompileLayer::IRCompiler {
       LLVMCompiler::ModuleHook pre_optimization_hook = nullptr,
       LLVMCompiler::ModuleHook post_optimization_hook = nullptr,
       std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook =
-          nullptr)
+          nullptr,
+      PersistentCompilationCache* persistent_cache = nullptr)
       : IRCompiler(llvm::orc::IRSymbolMapper::ManglingOptions()),
         target_machine_(target_machine),
         opt_level_(opt_level),
@@ -48,22 +60,48 @@ class CompilerFunctor : public llvm::orc::IRCompileLayer::IRCompiler {
         fast_math_flags_(fast_math_flags),
         pre_optimization_hook_(std::move(pre_optimization_hook)),
         post_optimization_hook_(std::move(post_optimization_hook)),
-        post_codegen_hook_(std::move(post_codegen_hook)) {}
+        post_codegen_hook_(std::move(post_codegen_hook)),
+        persistent_cache_(persistent_cache) {}
 
   // Compile a Module to an ObjectFile.
   llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> operator()(
       llvm::Module& module) override;
 
+  // Compiles `module` to at most `num_partitions` object files, optimizing and
+  // generating code for its partitions in parallel on `thread_pool`. Every
+  // partition uses its own target machine created by `target_machine_builder`
+  // and is passed to the post-optimization hook.
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> CompileInParallel(
+      llvm::Module& module, int num_partitions,
+      const std::function<std::unique_ptr<llvm::TargetMachine>()>&
+          target_machine_builder,
+      tensorflow::thread::ThreadPool* thread_pool);
+
  private:
+  // Runs the optimization passes for `target_machine` over `module`.
+  void OptimizeModule(llvm::TargetMachine* target_machine,
+                      llvm::Module& module) const;
+
+  // Generates the object file of `module` for `target_machine`.
+  static std::unique_ptr<llvm::MemoryBuffer> EmitObjectFile(
+      llvm::TargetMachine* target_machine, llvm::Module& module);
+
   // Populates the given pass manager with TargetLibraryInfo and
   // TargetTransformInfo passes.
-  void AddTargetInfoPasses(llvm::legacy::PassManagerBase* passes) const;
+  void AddTargetInfoPasses(llvm::TargetMachine* target_machine,
+                           llvm::legacy::PassManagerBase* passes) const;
 
   // Populates the given pass managers based on the optimization level.
   void AddOptimizationPasses(llvm::legacy::PassManagerBase* module_passes,
                              llvm::legacy::FunctionPassManager* function_passes,
                              unsigned opt_level, unsigned size_level) const;
 
+  // Returns the key of `module` in the persistent cache.
+  std::string PersistentCacheKey(const llvm::Module& module) const;
+
+  // Invokes the post-codegen hook, if any, on `memory_buffer`.
+  void RunPostCodegenHook(const llvm::MemoryBuffer& memory_buffer) const;
+
   llvm::TargetMachine* target_machine_;
   const unsigned opt_level_;
   const bool optimize_for_size_;
@@ -72,6 +110,7 @@ class CompilerFunctor : public llvm::orc::IRCompileLayer::IRCompiler {
   LLVMCompiler::ModuleHook pre_optimization_hook_;
   LLVMCompiler::ModuleHook post_optimization_hook_;
   std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook_;
+  PersistentCompilationCache* persistent_cache_;
 };
 
 }  // namespace cpu
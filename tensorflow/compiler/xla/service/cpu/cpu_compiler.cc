@@ -18,6 +18,7 @@ limitations under the License.
 #include <stddef.h>
 #include <string.h>
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <string>
@@ -30,6 +31,7 @@ limitations under the License.
 #include "absl/base/call_once.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/IR/Function.h"
@@ -115,6 +117,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/logistic_expander.h"
 #include "tensorflow/compiler/xla/service/map_inliner.h"
 #include "tensorflow/compiler/xla/service/operand_upcaster.h"
+#include "tensorflow/compiler/xla/service/persistent_compilation_cache.h"
 #include "tensorflow/compiler/xla/service/qr_expander.h"
 #include "tensorflow/compiler/xla/service/reduce_scatter_decomposer.h"
 #include "tensorflow/compiler/xla/service/reshape_mover.h"
@@ -140,6 +143,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/platform/dynamic_annotations.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace {
 
@@ -509,10 +514,18 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
   }();
 
   // Outline ops in the entry computation into calls to subcomputations.
-  const int max_parallelism =
+  const DebugOptions& debug_options = module->config().debug_options();
+  int max_parallelism =
       module->config().intra_op_parallelism_threads() > 0
           ? module->config().intra_op_parallelism_threads()
           : tensorflow::port::NumSchedulableCPUs();
+  if (debug_options.xla_cpu_parallel_task_budget() > 0) {
+    max_parallelism =
+        std::min(max_parallelism, debug_options.xla_cpu_parallel_task_budget());
+  }
+  TF_ASSIGN_OR_RETURN(ParallelTaskThroughput throughput,
+                      ParallelTaskThroughput::Parse(
+                          debug_options.xla_cpu_parallel_task_throughput()));
   if (!is_aot_compile) {
     // Run ParallelTaskAssigner to assign parallel tasks to HLOs in module.
     // Note this is not run for AOT because it would bring in thread pool
@@ -520,7 +533,8 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
     // binary size (and most AOT applications are single-threaded).
     // TODO(b/29630486) Support multi-threaded AOT.
     pipeline.AddPass<ParallelTaskAssigner>(
-        max_parallelism, ShapeSizeBytesFunction(), target_machine_features);
+        max_parallelism, ShapeSizeBytesFunction(), target_machine_features,
+        throughput);
   }
   // Copy insertion should be performed immediately before IR emission to
   // avoid inserting unnecessary copies (later pass adds an instruction which
@@ -697,6 +711,10 @@ namespace {
 // Post-compilation callback functor for use by SimpleOrcJIT.
 //
 // Dumps machine code if dumping is enabled for the module.
+// Modules with fewer LLVM instructions than this per partition are not worth
+// splitting for parallel code generation.
+constexpr int64_t kMinInstructionsPerCodegenPartition = 4096;
+
 struct OrcJITPostCompilationHook {
   // Gets an std::function that implements this hook.
   static std::function<void(const llvm::object::ObjectFile& obj_file)> Create(
@@ -767,7 +785,8 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
       module->config().debug_options().xla_llvm_disable_expensive_passes(),
       llvm_ir::GetCpuFastMathFlags(module->config()), pre_optimization_ir_hook,
       post_optimization_ir_hook,
-      OrcJITPostCompilationHook::Create(module.get()));
+      OrcJITPostCompilationHook::Create(module.get()),
+      PersistentCompilationCache::Get(module->config().debug_options()));
   if (!jit) {
     return InternalError("Creating JIT failed: %s",
                          llvm::toString(jit.takeError()));
@@ -864,10 +883,47 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
 
   TF_RETURN_IF_ERROR(VerifyLlvmModule(*llvm_module));
 
-  // JIT compile the LLVM IR module to in-memory machine code.
-  llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
-                                                 std::move(llvm_context));
-  cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  // JIT compile the LLVM IR module to in-memory machine code, compiling large
+  // modules in parallel if there is a thread pool. The IR and object files
+  // are dumped per module, so dumping and user hooks disable it.
+  tensorflow::thread::ThreadPool* thread_pool;
+  absl::optional<tensorflow::thread::ThreadPool> overriding_thread_pool;
+  switch (module->config().debug_options().xla_cpu_compilation_parallelism()) {
+    case 0:
+      thread_pool = options.thread_pool;
+      break;
+    case 1:
+      thread_pool = nullptr;
+      break;
+    default:
+      overriding_thread_pool.emplace(
+          tensorflow::Env::Default(), "xla_cpu_compile",
+          module->config().debug_options().xla_cpu_compilation_parallelism());
+      thread_pool = &*overriding_thread_pool;
+      break;
+  }
+  int num_partitions = 1;
+  if (thread_pool != nullptr && !DumpingEnabledForHloModule(*module) &&
+      !user_pre_optimization_hook_ && !user_post_optimization_hook_) {
+    int64_t num_functions = 0;
+    int64_t num_instructions = 0;
+    for (const llvm::Function& function : llvm_module->functions()) {
+      if (function.isDeclaration()) continue;
+      ++num_functions;
+      num_instructions += function.getInstructionCount();
+    }
+    num_partitions = std::min<int64_t>(
+        {thread_pool->NumThreads(), num_functions,
+         num_instructions / kMinInstructionsPerCodegenPartition});
+  }
+  if (num_partitions > 1) {
+    cantFail((*jit)->AddModuleInParallel(*llvm_module, num_partitions,
+                                         thread_pool));
+  } else {
+    llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
+                                                   std::move(llvm_context));
+    cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  }
 
   auto cpu_executable = absl::make_unique<CpuExecutable>(
       std::move(*jit), std::move(assignment), std::move(module), function_name,
@@ -26,6 +26,7 @@ const char* const kLlvmIrDotTilingFactor = "xla_llvm_dot_tiling_factor";
 const char* const kXlaForceEnableExperimentalLlvmIrGemm =
     "xla_force_enable_experimental_llvm_ir_gemm";
 const char* const kLlvmIrGemmTileSize = "xla_llvm_ir_gemm_tile_size";
+const char* const kLlvmIrSmallGemmMaxMacs = "xla_llvm_ir_small_gemm_max_macs";
 
 }  // namespace
 
@@ -99,6 +100,18 @@ absl::optional<std::tuple<int64_t, int64_t, int64_t>> LlvmIrGemmTileSize(
                                                tile_size_n_in_vector_width);
 }
 
+absl::optional<int64_t> LlvmIrSmallGemmMaxMacs(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  auto it = extra_options_map.find(kLlvmIrSmallGemmMaxMacs);
+  int64_t max_macs;
+  if (it != extra_options_map.end() &&
+      absl::SimpleAtoi(it->second, &max_macs)) {
+    return max_macs;
+  }
+  return absl::nullopt;
+}
+
 }  // namespace options
 }  // namespace cpu
 }  // namespace xla
@@ -30,6 +30,7 @@ bool ForceEnableExperimentalLlvmIrGemm(const HloModuleConfig& config);
 absl::optional<int64_t> LlvmIrGemvTilingFactor(const HloModuleConfig& config);
 absl::optional<std::tuple<int64_t, int64_t, int64_t>> LlvmIrGemmTileSize(
     const HloModuleConfig& config);
+absl::optional<int64_t> LlvmIrSmallGemmMaxMacs(const HloModuleConfig& config);
 
 }  // namespace options
 }  // namespace cpu
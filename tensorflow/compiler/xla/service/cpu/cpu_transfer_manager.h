@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_TRANSFER_MANAGER_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_TRANSFER_MANAGER_H_
 
+#include <cstdint>
 #include <vector>
 
 #include "absl/types/span.h"
+#include "tensorflow/compiler/xla/cpu_function_runtime.h"
 #include "tensorflow/compiler/xla/literal.h"
 #include "tensorflow/compiler/xla/service/cpu/xfeed_manager.h"
 #include "tensorflow/compiler/xla/service/generic_transfer_manager.h"
@@ -56,6 +58,15 @@ class CpuTransferManager : public GenericTransferManager {
     return true;
   }
 
+  // The generated code assumes that arrays are aligned to kMinAlign.
+  bool CanUseHostBufferAsDeviceBuffer(const void* data,
+                                      const Shape& shape) const override {
+    return shape.IsArray() && shape.is_static() &&
+           reinterpret_cast<uintptr_t>(data) %
+                   cpu_function_runtime::kMinAlign ==
+               0;
+  }
+
   Status ReadDynamicShapes(se::Stream* stream, ShapedBuffer* device_buffer,
                            Shape* device_shape) override;
 
@@ -97,7 +97,9 @@ enum class DotImplementationStrategy {
 
   // The dot operation is lowered into LLVM IR that implements a tiled
   // Matrix*Matrix operation.  No fusions are supported.  The two inputs
-  // and the output have to be row major.
+  // and the output have to be row major.  The kernel is register blocked and
+  // specialized for the shape of the operation, and is emitted once per shape
+  // so that the inner dot operations of a batch dot share it.
   kTiledLlvmIrGemm,
 
   // The dot operation is lowered into linalg.matmul op and lowered to LLVM IR.
@@ -990,19 +992,21 @@ bool IsAlignedGemm(const DotInfo& dot_info,
                        dot_info.result_shape, target_machine_features);
 }
 
+// Number of multiply-accumulates below which a GEMM is emitted as a tiled LLVM
+// IR kernel rather than calling multi-threaded Eigen.  At this size the GEMM
+// takes a few microseconds on a single core, which is comparable to the
+// latency of a thread pool fork/join.
+constexpr int64_t kDefaultSmallGemmMaxMacs = 32 * 32 * 64;
+
 bool CanEmitTiledLlvmIrGemm(
     const HloModuleConfig& config, const DotInfo& dot_info,
     const TargetMachineFeatures& target_machine_features) {
   CHECK(IsAlignedGemm(dot_info, target_machine_features));
 
-  if (ShouldUseMultiThreadedEigen(config)) {
-    return false;
-  }
-
-  int m = dot_info.result_shape.dimensions(0);
-  int k = dot_info.lhs_shape.dimensions(
+  int64_t m = dot_info.result_shape.dimensions(0);
+  int64_t k = dot_info.lhs_shape.dimensions(
       dot_info.dim_nums.lhs_contracting_dimensions(0));
-  int n = dot_info.result_shape.dimensions(1);
+  int64_t n = dot_info.result_shape.dimensions(1);
 
   if (!options::ForceEnableExperimentalLlvmIrGemm(config)) {
     // TODO(sanjoy):  We should make these numbers micro-arch specific.
@@ -1011,6 +1015,15 @@ bool CanEmitTiledLlvmIrGemm(
     if (!small_gemm) {
       return false;
     }
+
+    // Multi-threaded Eigen only pays for the cost of dispatching its work to
+    // the thread pool for GEMMs that are large enough, smaller ones run faster
+    // on the calling thread with a kernel specialized for their shape.
+    if (ShouldUseMultiThreadedEigen(config) &&
+        m * k * n > options::LlvmIrSmallGemmMaxMacs(config).value_or(
+                        kDefaultSmallGemmMaxMacs)) {
+      return false;
+    }
   }
 
   bool lhs_canonical = dot_info.dim_nums.lhs_contracting_dimensions(0) == 1;
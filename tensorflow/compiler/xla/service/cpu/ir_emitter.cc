@@ -2317,7 +2317,8 @@ Status IrEmitter::HandleTopK(HloInstruction* hlo) {
        b_.getInt64(input->shape().dimensions().back()), b_.getInt64(k),
        BitCast(values_ptr, b_.getFloatTy()->getPointerTo()),
        BitCast(out_values_ptr, b_.getFloatTy()->getPointerTo()),
-       BitCast(out_indices_ptr, b_.getInt32Ty()->getPointerTo())},
+       BitCast(out_indices_ptr, b_.getInt32Ty()->getPointerTo()),
+       GetExecutableRunOptionsArgument()},
       b_.getVoidTy());
 
   llvm_ir::EmitTuple(GetIrArrayFor(hlo), {out_values_ptr, out_indices_ptr},
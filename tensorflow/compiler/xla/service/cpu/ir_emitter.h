@@ -521,10 +521,12 @@ class IrEmitter : public DfsHloVisitorWithDefault,
 
   // Returns whether the given instruction should be emitted as a parallel loop.
   bool ShouldEmitParallelLoopFor(const HloInstruction& op) const {
-    // Emit parallel loop for root instruction if dynamic outer-dimension loop
+    // Emit parallel loop for the root instruction, and for the instructions
+    // coarsened into the same parallel loop, if dynamic outer-dimension loop
     // bounds were specified.
     return num_dynamic_loop_bounds_ > 0 &&
-           op.parent()->root_instruction() == &op;
+           (op.parent()->root_instruction() == &op ||
+            !op.outer_dimension_partitions().empty());
   }
 
   // This struct contains all the state needed to emit instructions for
@@ -15,8 +15,13 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
 
+#include <cmath>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
@@ -24,6 +29,10 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/dynamic_update_slice_util.h"
+#include "tensorflow/compiler/xla/layout_util.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/cpu_info.h"
 
 namespace xla {
 namespace cpu {
@@ -53,74 +62,106 @@ class SimpleCostModel : public ParallelCostModel {
 class DefaultCostModel : public ParallelCostModel {
  public:
   DefaultCostModel(const int64_t max_parallelism,
-                   const HloCostAnalysis::ShapeSizeFunction& shape_size,
+                   const ParallelTaskThroughput& throughput,
                    std::unique_ptr<HloCostAnalysis> cost_analysis)
       : max_parallelism_(max_parallelism),
-        shape_size_(shape_size),
-        cost_analysis_(std::move(cost_analysis)) {}
+        throughput_(throughput),
+        cost_analysis_(std::move(cost_analysis)) {
+    if (throughput_.max_bytes_per_ns <= 0) {
+      throughput_.max_bytes_per_ns =
+          throughput_.bytes_per_ns *
+          std::ceil(std::sqrt(tensorflow::port::MaxParallelism()));
+    }
+  }
   ~DefaultCostModel() override {}
 
   int64_t GetParallelTaskCount(HloInstruction* instruction) override {
-    // Parameters for parallel task count computation.
-    int64_t instruction_cost;
-    int64_t min_cost_per_thread;
-    int64_t max_parallelism;
-    // Calculate flops-to-bytes-ratio for 'instruction'.
-    const int64_t bytes_accessed =
-        std::max(int64_t{1}, cost_analysis_->bytes_accessed(*instruction));
-    const float flops_to_bytes_ratio =
-        cost_analysis_->flop_count(*instruction) /
-        static_cast<float>(bytes_accessed);
-    // Check for I/O bound instructions.
-    if (flops_to_bytes_ratio <= 1.0) {
-      // Limit max parallelism for I/O bound instructions by assuming a
-      // sub-linear scaling function (fit based on empirical benchmark results).
-      // TODO(b/29630486) Develop system bandwidth model.
+    return GetGroupParallelTaskCount({instruction});
+  }
+
+  int64_t GetGroupParallelTaskCount(
+      absl::Span<HloInstruction* const> instructions) override {
+    // Running times on a single core of the arithmetic and of the memory
+    // accesses of 'instructions'.
+    double compute_ns = 0;
+    double memory_ns = 0;
+    for (const HloInstruction* instruction : instructions) {
+      compute_ns +=
+          cost_analysis_->flop_count(*instruction) / throughput_.flops_per_ns +
+          cost_analysis_->transcendental_count(*instruction) /
+              throughput_.transcendentals_per_ns;
+      memory_ns += cost_analysis_->bytes_accessed(*instruction) /
+                   throughput_.bytes_per_ns;
+    }
+    int64_t max_parallelism = max_parallelism_;
+    if (memory_ns > compute_ns) {
+      // Memory bound instructions stop scaling once they saturate the memory
+      // bandwidth of the machine.
       max_parallelism = std::min<int64_t>(
-          max_parallelism_,
-          std::ceil(std::sqrt(tensorflow::port::MaxParallelism())));
-      // Use shape size instruction cost and L2 cache size min per-thread cost.
-      instruction_cost = shape_size_(instruction->shape());
-      min_cost_per_thread = 256LL << 10;  // 256KB L2 Cache size.
-    } else {
-      // Use max parallelism for compute bound instructions.
-      max_parallelism = max_parallelism_;
-      // Calculate the instruction cost in cycles.
-      // TODO(b/29630486) Improve on this linear cost model.
-      // Consider making 'min_cost_per_thread' be a function of the target
-      // bandwidth limit for instructions with low arithmetic complexity.
-      instruction_cost =
-          1 * cost_analysis_->flop_count(*instruction) +
-          2 * cost_analysis_->transcendental_count(*instruction) +
-          10 * cost_analysis_->bytes_accessed(*instruction);
-      // Minimum per-thread cost is 100us of work on a 2GHz core.
-      min_cost_per_thread = 100000;
+          max_parallelism,
+          std::ceil(throughput_.max_bytes_per_ns / throughput_.bytes_per_ns));
     }
-    // Return target parallel task count in [1, max_parallelism_].
-    return std::min(
-        max_parallelism,
-        std::max(int64_t{1}, instruction_cost / min_cost_per_thread));
+    // Split the work in tasks that run for at least 'min_task_ns' each.
+    const double serial_ns = std::max(compute_ns, memory_ns);
+    const int64_t task_count =
+        static_cast<int64_t>(serial_ns / throughput_.min_task_ns);
+    // Return target parallel task count in [1, max_parallelism].
+    return std::min(max_parallelism, std::max(int64_t{1}, task_count));
   }
 
  private:
   const int64_t max_parallelism_;
-  const HloCostAnalysis::ShapeSizeFunction shape_size_;
+  ParallelTaskThroughput throughput_;
   const std::unique_ptr<HloCostAnalysis> cost_analysis_;
 };
 
+/*static*/ StatusOr<ParallelTaskThroughput> ParallelTaskThroughput::Parse(
+    absl::string_view spec) {
+  ParallelTaskThroughput throughput;
+  const absl::flat_hash_map<absl::string_view, double*> fields = {
+      {"flops_per_ns", &throughput.flops_per_ns},
+      {"transcendentals_per_ns", &throughput.transcendentals_per_ns},
+      {"bytes_per_ns", &throughput.bytes_per_ns},
+      {"max_bytes_per_ns", &throughput.max_bytes_per_ns},
+      {"min_task_ns", &throughput.min_task_ns},
+  };
+  for (absl::string_view entry :
+       absl::StrSplit(spec, ',', absl::SkipWhitespace())) {
+    std::vector<absl::string_view> name_and_value = absl::StrSplit(entry, '=');
+    double value;
+    if (name_and_value.size() != 2 || !fields.contains(name_and_value[0]) ||
+        !absl::SimpleAtod(name_and_value[1], &value)) {
+      return InvalidArgument("Invalid parallel task throughput entry: '%s'",
+                             entry);
+    }
+    *fields.at(name_and_value[0]) = value;
+  }
+  if (throughput.flops_per_ns <= 0 || throughput.transcendentals_per_ns <= 0 ||
+      throughput.bytes_per_ns <= 0 || throughput.min_task_ns <= 0) {
+    return InvalidArgument(
+        "Parallel task throughputs and task time must be positive: '%s'", spec);
+  }
+  return throughput;
+}
+
 ParallelTaskAssignment::ParallelTaskAssignment(
     const int64_t max_parallelism,
     const HloCostAnalysis::ShapeSizeFunction& shape_size, HloModule* module,
-    const TargetMachineFeatures* target_machine_features)
+    const TargetMachineFeatures* target_machine_features,
+    const ParallelTaskThroughput& throughput)
     : target_machine_features_(*target_machine_features) {
   VLOG(1) << "ParallelTaskAssignment max_parallelism: " << max_parallelism;
-  // Run cost analysis on 'module'.
+  // Run cost analysis on the computations of 'module' that may be assigned
+  // parallel tasks.
   auto cost_analysis = absl::make_unique<HloCostAnalysis>(shape_size);
-  HloComputation* computation = module->entry_computation();
-  Status status = computation->root_instruction()->Accept(cost_analysis.get());
+  Status status = Status::OK();
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    status = computation->Accept(cost_analysis.get());
+    if (!status.ok()) break;
+  }
   if (status.ok()) {
     // Set default cost model based on 'cost_analysis'.
-    cost_model_.reset(new DefaultCostModel(max_parallelism, shape_size,
+    cost_model_.reset(new DefaultCostModel(max_parallelism, throughput,
                                            std::move(cost_analysis)));
   } else {
     // Fall back to a simple cost model based on hlo size and L2 cache size.
@@ -132,6 +173,25 @@ ParallelTaskAssignment::ParallelTaskAssignment(
 
 int64_t ParallelTaskAssignment::GetTargetParallelTaskCount(
     HloInstruction* instruction) {
+  if (!IsParallelizable(instruction)) {
+    return 1;
+  }
+  // Consult 'cost_model_' to compute target parallel task count.
+  return cost_model_->GetParallelTaskCount(instruction);
+}
+
+int64_t ParallelTaskAssignment::GetTargetParallelTaskCount(
+    absl::Span<HloInstruction* const> instructions) {
+  for (const HloInstruction* instruction : instructions) {
+    if (!IsParallelizable(instruction)) {
+      return 1;
+    }
+  }
+  return cost_model_->GetGroupParallelTaskCount(instructions);
+}
+
+bool ParallelTaskAssignment::IsParallelizable(
+    const HloInstruction* instruction) const {
   // Currently, we do not assign parallel tasks to instructions with at least
   // one of the following properties:
   // *) Internal threading (library calls to kConv, kDot, kFft, kCustomCall).
@@ -147,124 +207,158 @@ int64_t ParallelTaskAssignment::GetTargetParallelTaskCount(
   if (llvm_ir::MayBeImplementedAsInPlaceDynamicUpdateSlice(instruction) ||
       instruction->shape().IsTuple() || opcode == HloOpcode::kRng ||
       opcode == HloOpcode::kConstant) {
-    return 1;
+    return false;
   }
 
   // Only allow instructions that can be trivially parallelized (where all
   // outputs can be computed independently of each other).
-  if (instruction->IsElementwise() || instruction->IsLoopFusion() ||
-      opcode == HloOpcode::kBroadcast || opcode == HloOpcode::kConcatenate ||
-      opcode == HloOpcode::kDynamicSlice ||
-      opcode == HloOpcode::kDynamicUpdateSlice ||
-      opcode == HloOpcode::kGather || opcode == HloOpcode::kIota ||
-      opcode == HloOpcode::kPad || opcode == HloOpcode::kReduce ||
-      opcode == HloOpcode::kReduceWindow || opcode == HloOpcode::kReshape ||
-      opcode == HloOpcode::kReverse || opcode == HloOpcode::kSlice ||
-      opcode == HloOpcode::kTranspose ||
-      (opcode == HloOpcode::kConvolution &&
-       !PotentiallyImplementedAsEigenConvolution(*instruction,
-                                                 target_machine_features_))) {
-    // Consult 'cost_model_' to compute target parallel task count.
-    return cost_model_->GetParallelTaskCount(instruction);
-  }
-
-  return 1;
+  return instruction->IsElementwise() || instruction->IsLoopFusion() ||
+         opcode == HloOpcode::kBroadcast || opcode == HloOpcode::kConcatenate ||
+         opcode == HloOpcode::kDynamicSlice ||
+         opcode == HloOpcode::kDynamicUpdateSlice ||
+         opcode == HloOpcode::kGather || opcode == HloOpcode::kIota ||
+         opcode == HloOpcode::kPad || opcode == HloOpcode::kReduce ||
+         opcode == HloOpcode::kReduceWindow || opcode == HloOpcode::kReshape ||
+         opcode == HloOpcode::kReverse || opcode == HloOpcode::kSlice ||
+         opcode == HloOpcode::kTranspose ||
+         (opcode == HloOpcode::kConvolution &&
+          !PotentiallyImplementedAsEigenConvolution(*instruction,
+                                                    target_machine_features_));
 }
 
 StatusOr<bool> ParallelTaskAssigner::Run(HloModule* module) {
   XLA_VLOG_LINES(2, "ParallelTaskAssigner ENTRY");
   XLA_VLOG_LINES(3, module->ToString());
-  // Compute target parallel task counts for all instructions in 'module'.
-  HloToParallelTasks hlo_to_parallel_tasks;
-  ComputeTargetParallelTasks(module, &hlo_to_parallel_tasks);
+  ParallelTaskAssignment parallel_task_assignment(
+      max_parallelism_, shape_size_function_, module, &target_machine_features_,
+      throughput_);
 
   // Assign parallel tasks to target specific instructions in 'module'.
   // TODO(b/27458679) Support inter-op parallelism.
-  bool changed = AssignParallelTasks(module, hlo_to_parallel_tasks);
+  bool changed = AssignParallelTasksHelper(module, module->entry_computation(),
+                                           &parallel_task_assignment);
 
   XLA_VLOG_LINES(2, "ParallelTaskAssigner EXIT");
   XLA_VLOG_LINES(3, module->ToString());
   return changed;
 }
 
-bool ParallelTaskAssigner::AssignParallelTasks(
-    HloModule* module, const HloToParallelTasks& hlo_to_parallel_tasks) {
-  return AssignParallelTasksHelper(module, module->entry_computation(),
-                                   hlo_to_parallel_tasks);
-}
-
 bool ParallelTaskAssigner::AssignParallelTasksHelper(
     HloModule* module, HloComputation* computation,
-    const HloToParallelTasks& hlo_to_parallel_tasks) {
+    ParallelTaskAssignment* parallel_task_assignment) {
   bool changed = false;
-  // Snapshot set of instructions because outlining modifies the set below.
-  std::vector<HloInstruction*> instructions(computation->instructions().begin(),
-                                            computation->instructions().end());
-  for (auto* instruction : instructions) {
-    // Assign parallel tasks to sub-computations for While and Call HLOs.
-    // TODO(b/27458679) Evaluate alternative intra-op parallelism placement,
-    // and support other callable computations like reduce.
+  // Assign parallel tasks to sub-computations for While and Call HLOs.
+  // TODO(b/27458679) Evaluate alternative intra-op parallelism placement,
+  // and support other callable computations like reduce.
+  for (auto* instruction : computation->instructions()) {
     if (instruction->opcode() == HloOpcode::kWhile) {
       changed |= AssignParallelTasksHelper(module, instruction->while_body(),
-                                           hlo_to_parallel_tasks);
-      continue;
+                                           parallel_task_assignment);
     } else if (instruction->opcode() == HloOpcode::kCall) {
       changed |= AssignParallelTasksHelper(module, instruction->to_apply(),
-                                           hlo_to_parallel_tasks);
-      continue;
+                                           parallel_task_assignment);
     }
-    // Skip if no parallel tasks were computed in first pass.
-    auto it = hlo_to_parallel_tasks.find(instruction);
-    if (it == hlo_to_parallel_tasks.end()) {
+  }
+
+  // Compute the target parallel task counts of all the loops before
+  // outlining, which replaces the instructions known to the cost model.
+  struct ParallelLoop {
+    std::vector<HloInstruction*> instructions;
+    std::vector<int64_t> dim_partition_counts;
+  };
+  std::vector<ParallelLoop> loops;
+  for (auto& group :
+       CoarsenParallelLoops(computation, *parallel_task_assignment)) {
+    const int64_t target_parallel_task_count =
+        parallel_task_assignment->GetTargetParallelTaskCount(group);
+    if (target_parallel_task_count <= 1) {
       continue;
     }
-    // Get target parallel task count computed for 'instruction'.
-    const int64_t target_parallel_task_count = (*it).second;
     // Assign feasible dimension partitions (based on actual dimension sizes).
-    auto dim_partition_counts = ShapePartitionAssigner(instruction->shape())
+    auto dim_partition_counts = ShapePartitionAssigner(group.back()->shape())
                                     .Run(target_parallel_task_count);
-    const int64_t total_partition_count =
-        ShapePartitionAssigner::GetTotalPartitionCount(dim_partition_counts);
-    if (total_partition_count <= 1) {
+    if (ShapePartitionAssigner::GetTotalPartitionCount(dim_partition_counts) <=
+        1) {
       // Feasible partition calculation resulting in no partitioning, so skip.
       continue;
     }
+    loops.push_back({std::move(group), std::move(dim_partition_counts)});
+  }
 
-    // Outline 'instruction' in 'computation' for parallel task assignment.
+  for (const ParallelLoop& loop : loops) {
+    // Outline the instructions of 'loop' in 'computation' for parallel task
+    // assignment.
+    const HloInstruction* last = loop.instructions.back();
     auto* call = module->OutlineExpressionFromComputation(
-        {instruction}, absl::StrCat("parallel_", instruction->name()),
+        loop.instructions, absl::StrCat("parallel_", last->name()),
         computation);
 
-    // Set assigned dimension partitioning to 'instruction'.
-    auto* new_root = call->to_apply()->root_instruction();
-    new_root->set_outer_dimension_partitions(dim_partition_counts);
+    // Set assigned dimension partitioning to the outlined instructions, so
+    // that every task computes the same partition of each of them.
+    for (auto* instruction : call->to_apply()->instructions()) {
+      if (instruction->opcode() != HloOpcode::kParameter) {
+        instruction->set_outer_dimension_partitions(loop.dim_partition_counts);
+      }
+    }
 
-    VLOG(2) << "Assigned parallel task count: " << total_partition_count
-            << " to instruction: " << new_root->name()
+    auto* new_root = call->to_apply()->root_instruction();
+    VLOG(2) << "Assigned parallel task count: "
+            << ShapePartitionAssigner::GetTotalPartitionCount(
+                   loop.dim_partition_counts)
+            << " to " << loop.instructions.size()
+            << " instruction(s) with root: " << new_root->name()
             << " parent: " << new_root->parent()->name();
     changed = true;
   }
   return changed;
 }
 
-void ParallelTaskAssigner::ComputeTargetParallelTasks(
-    HloModule* module, HloToParallelTasks* hlo_to_parallel_tasks) {
-  ParallelTaskAssignment parallel_task_assignment(max_parallelism_,
-                                                  shape_size_function_, module,
-                                                  &target_machine_features_);
-
-  // Compute parallel task counts for all instructions in 'module'.
-  for (auto* computation : module->MakeNonfusionComputations()) {
-    for (auto* instruction : computation->instructions()) {
-      // Query ParallelTaskAssignment for target parallel task count.
-      const int64_t target_parallel_task_count =
-          parallel_task_assignment.GetTargetParallelTaskCount(instruction);
-      if (target_parallel_task_count > 1) {
-        hlo_to_parallel_tasks->insert(
-            {instruction, target_parallel_task_count});
+std::vector<std::vector<HloInstruction*>>
+ParallelTaskAssigner::CoarsenParallelLoops(
+    HloComputation* computation,
+    const ParallelTaskAssignment& parallel_task_assignment) const {
+  std::vector<std::vector<HloInstruction*>> groups;
+  // The group that ends with each instruction, as an index into 'groups'.
+  absl::flat_hash_map<const HloInstruction*, int64_t> group_of_last;
+  for (HloInstruction* instruction : computation->MakeInstructionPostOrder()) {
+    if (!parallel_task_assignment.IsParallelizable(instruction)) {
+      continue;
+    }
+    // Only elementwise loops iterate over their output like their operands,
+    // so only they can be extended with the instructions they use.
+    const bool is_elementwise_loop =
+        (instruction->IsElementwise() &&
+         instruction->opcode() != HloOpcode::kCopy) ||
+        instruction->IsLoopFusion();
+    int64_t group_index = -1;
+    if (is_elementwise_loop) {
+      for (int64_t i = 0; i < instruction->operand_count(); ++i) {
+        const HloInstruction* operand = instruction->operand(i);
+        auto it = group_of_last.find(operand);
+        // The operand must only be used within the loop, and its elements
+        // must be read in the order they are written by the same task.
+        if (it != group_of_last.end() && operand->user_count() == 1 &&
+            operand != computation->root_instruction() &&
+            instruction->IsElementwiseOnOperand(i) &&
+            ShapeUtil::SameDimensions(operand->shape(), instruction->shape()) &&
+            LayoutUtil::Equal(operand->shape().layout(),
+                              instruction->shape().layout())) {
+          group_index = it->second;
+          group_of_last.erase(it);
+          break;
+        }
       }
     }
+    if (group_index < 0) {
+      group_index = groups.size();
+      groups.emplace_back();
+    }
+    groups[group_index].push_back(instruction);
+    if (is_elementwise_loop) {
+      group_of_last[instruction] = group_index;
+    }
   }
+  return groups;
 }
 
 }  // namespace cpu
@@ -16,19 +16,60 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PARALLEL_TASK_ASSIGNMENT_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PARALLEL_TASK_ASSIGNMENT_H_
 
+#include <algorithm>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tensorflow/compiler/xla/service/cpu/target_machine_features.h"
 #include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/compiler/xla/statusor.h"
 
 namespace xla {
 namespace cpu {
 
+// Throughput of the target used to convert the costs computed by
+// HloCostAnalysis into running times. The defaults describe a generic x86
+// server core; measured values can be passed with
+// --xla_cpu_parallel_task_throughput.
+struct ParallelTaskThroughput {
+  // Floating point operations per nanosecond of one core.
+  double flops_per_ns = 8.0;
+  // Transcendental operations per nanosecond of one core.
+  double transcendentals_per_ns = 0.5;
+  // Memory bandwidth of one core, in bytes per nanosecond.
+  double bytes_per_ns = 8.0;
+  // Memory bandwidth of the machine, in bytes per nanosecond. Values <= 0
+  // select a bandwidth that scales with the square root of the core count,
+  // which fits empirical benchmark results.
+  double max_bytes_per_ns = 0.0;
+  // Minimum running time of a parallel task, in nanoseconds, so that it
+  // amortizes the cost of the fork/join.
+  double min_task_ns = 20000.0;
+
+  // Returns the defaults overridden by the comma-separated `name=value` pairs
+  // in `spec`, e.g. "flops_per_ns=16,bytes_per_ns=10".
+  static StatusOr<ParallelTaskThroughput> Parse(absl::string_view spec);
+};
+
 // Simple interface for different parallel cost model implementations.
 class ParallelCostModel {
  public:
   virtual ~ParallelCostModel() = default;
   virtual int64_t GetParallelTaskCount(HloInstruction* instruction) = 0;
+
+  // Returns the parallel task count for running 'instructions' in a single
+  // parallel loop. Defaults to the largest count of any of them.
+  virtual int64_t GetGroupParallelTaskCount(
+      absl::Span<HloInstruction* const> instructions) {
+    int64_t count = 1;
+    for (HloInstruction* instruction : instructions) {
+      count = std::max(count, GetParallelTaskCount(instruction));
+    }
+    return count;
+  }
 };
 
 // ParallelTaskAssignment computes parallel task counts for HLOs in 'module'.
@@ -38,15 +79,26 @@ class ParallelTaskAssignment {
   // 'shape_size': shape size function used by HloCostAnalysis during parallel
   //               task assignment.
   // 'module': the containing HloModule.
+  // 'throughput': the target throughput used by the cost model.
   ParallelTaskAssignment(const int64_t max_parallelism,
                          const HloCostAnalysis::ShapeSizeFunction& shape_size,
                          HloModule* module,
-                         const TargetMachineFeatures* target_machine_features);
+                         const TargetMachineFeatures* target_machine_features,
+                         const ParallelTaskThroughput& throughput = {});
   ~ParallelTaskAssignment() {}
 
   // Computes and returns the target parallel task count for 'instruction'.
   int64_t GetTargetParallelTaskCount(HloInstruction* instruction);
 
+  // Computes and returns the target parallel task count for running the
+  // parallelizable 'instructions' in a single parallel loop.
+  int64_t GetTargetParallelTaskCount(
+      absl::Span<HloInstruction* const> instructions);
+
+  // Returns true if the outputs of 'instruction' can be computed
+  // independently of each other, so that it can be split into parallel tasks.
+  bool IsParallelizable(const HloInstruction* instruction) const;
+
  private:
   std::unique_ptr<ParallelCostModel> cost_model_;
   const TargetMachineFeatures& target_machine_features_;
@@ -60,17 +112,25 @@ class ParallelTaskAssignment {
 // own embedded computation, which is compiled as a parallel compute function,
 // and which is invoked from a kCall instruction that is lowered in codegen to
 // a runtime parallel fork/join call.
+//
+// Chains of elementwise HLOs over the same iteration space, where each HLO is
+// only used by the next one, are coarsened into a single parallel loop: they
+// are outlined together and every task computes the same partition of each
+// of them, so that the fork/join is only paid once for the chain.
 class ParallelTaskAssigner : public HloModulePass {
  public:
   // 'max_parallelism': the maximum parallel task count per instruction.
   // 'shape_size': shape size function used by HloCostAnalysis during parallel
   //               task assignment.
+  // 'throughput': the target throughput used by the cost model.
   ParallelTaskAssigner(const int64_t max_parallelism,
                        const HloCostAnalysis::ShapeSizeFunction& shape_size,
-                       const TargetMachineFeatures* target_machine_features)
+                       const TargetMachineFeatures* target_machine_features,
+                       const ParallelTaskThroughput& throughput = {})
       : max_parallelism_(max_parallelism),
         shape_size_function_(shape_size),
-        target_machine_features_(*target_machine_features) {}
+        target_machine_features_(*target_machine_features),
+        throughput_(throughput) {}
   ~ParallelTaskAssigner() override {}
 
   absl::string_view name() const override {
@@ -82,25 +142,23 @@ class ParallelTaskAssigner : public HloModulePass {
   StatusOr<bool> Run(HloModule* module) override;
 
  private:
-  using HloToParallelTasks = std::unordered_map<const HloInstruction*, int64_t>;
-
-  // Assigns target parallel tasks from 'hlo_to_parallel_tasks' to HLOs in
-  // 'module'.
+  // Assigns target parallel tasks computed by 'parallel_task_assignment' to
+  // HLOs in 'computation' and the computations it calls.
   // Returns true if the computation was changed, false otherwise.
-  bool AssignParallelTasks(HloModule* module,
-                           const HloToParallelTasks& hlo_to_parallel_tasks);
   bool AssignParallelTasksHelper(
       HloModule* module, HloComputation* computation,
-      const HloToParallelTasks& hlo_to_parallel_tasks);
+      ParallelTaskAssignment* parallel_task_assignment);
 
-  // Computes target parallel task counts (returned in 'parallel_task_counts')
-  // for parallelizable instructions in 'module'.
-  void ComputeTargetParallelTasks(HloModule* module,
-                                  HloToParallelTasks* hlo_to_parallel_tasks);
+  // Groups the parallelizable instructions of 'computation' into the
+  // instruction sequences that run as a single parallel loop, in post order.
+  std::vector<std::vector<HloInstruction*>> CoarsenParallelLoops(
+      HloComputation* computation,
+      const ParallelTaskAssignment& parallel_task_assignment) const;
 
   int64_t max_parallelism_;
   HloCostAnalysis::ShapeSizeFunction shape_size_function_;
   const TargetMachineFeatures& target_machine_features_;
+  const ParallelTaskThroughput throughput_;
 };
 
 }  // namespace cpu
@@ -205,5 +205,79 @@ TEST_F(ParallelTaskAssignmentTest, ConstantNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(ParallelTaskAssignmentTest, ElementwiseChainCoarsenedIntoOneLoop) {
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_chain
+    ENTRY chain {
+      p = f32[1234567] parameter(0)
+      exp = f32[1234567] exponential(p)
+      ROOT neg = f32[1234567] negate(exp)
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+
+  // Both instructions are computed by the tasks of a single fork/join.
+  HloInstruction* call = m->entry_computation()->root_instruction();
+  ASSERT_EQ(call->opcode(), HloOpcode::kCall);
+  EXPECT_EQ(m->entry_computation()->instruction_count(), 2);
+  HloComputation* loop = call->to_apply();
+  EXPECT_EQ(loop->instruction_count(), 3);
+  for (const HloInstruction* instruction : loop->instructions()) {
+    if (instruction->opcode() != HloOpcode::kParameter) {
+      EXPECT_FALSE(instruction->outer_dimension_partitions().empty())
+          << instruction->name();
+      EXPECT_EQ(instruction->outer_dimension_partitions(),
+                loop->root_instruction()->outer_dimension_partitions());
+    }
+  }
+}
+
+TEST_F(ParallelTaskAssignmentTest, MultiUseInstructionNotCoarsened) {
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_multi_use
+    ENTRY multi_use {
+      p = f32[1234567] parameter(0)
+      exp = f32[1234567] exponential(p)
+      neg = f32[1234567] negate(exp)
+      ROOT add = f32[1234567] add(exp, neg)
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+
+  // 'exp' is used twice, so it is its own loop and 'neg' and 'add' form
+  // another one.
+  int64_t num_calls = 0;
+  for (const HloInstruction* instruction :
+       m->entry_computation()->instructions()) {
+    if (instruction->opcode() == HloOpcode::kCall) ++num_calls;
+  }
+  EXPECT_EQ(num_calls, 2);
+}
+
+TEST(ParallelTaskThroughputTest, Parse) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      cpu::ParallelTaskThroughput throughput,
+      cpu::ParallelTaskThroughput::Parse("flops_per_ns=16, min_task_ns=1e4"));
+  EXPECT_EQ(throughput.flops_per_ns, 16.0);
+  EXPECT_EQ(throughput.min_task_ns, 1e4);
+  const cpu::ParallelTaskThroughput defaults;
+  EXPECT_EQ(throughput.bytes_per_ns, defaults.bytes_per_ns);
+
+  TF_ASSERT_OK_AND_ASSIGN(throughput, cpu::ParallelTaskThroughput::Parse(""));
+  EXPECT_EQ(throughput.flops_per_ns, defaults.flops_per_ns);
+
+  EXPECT_FALSE(cpu::ParallelTaskThroughput::Parse("flops=16").ok());
+  EXPECT_FALSE(cpu::ParallelTaskThroughput::Parse("bytes_per_ns=x").ok());
+  EXPECT_FALSE(cpu::ParallelTaskThroughput::Parse("min_task_ns=0").ok());
+}
+
 }  // namespace
 }  // namespace xla
@@ -17,6 +17,9 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <atomic>
+
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -33,8 +36,21 @@ using tensorflow::uint64;
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      void*, int64_t*, uint64_t*);
 
-// Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
-// Calls 'function_ptr' for first partition inline.
+namespace {
+
+// Number of helper tasks of all the fork/joins in the process that are queued
+// or running on the intra-op thread pools.
+std::atomic<int64_t> in_flight_helper_tasks(0);
+
+}  // namespace
+
+// Calls 'function_ptr' for each of the 'num_partitions' partitions, in
+// parallel on the intra-op thread pool.
+// Only dispatches as many helper tasks as there are threads of the pool that
+// are not busy with the helper tasks of other fork/joins, up to
+// 'num_partitions - 1'. The helper tasks and the calling thread claim the
+// partitions one at a time until all of them are computed, so partitions are
+// computed inline when the machine is oversubscribed.
 // Uses blocking counter to synchronize threads after parallel calls complete.
 //
 // The 'partitions' array has a total number of elements equal to
@@ -86,24 +102,36 @@ TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
 
   std::vector<XlaCustomCallStatus> statuses(num_partitions);
 
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
-  tensorflow::BlockingCounter bc(num_partitions - 1);
-  for (int32_t i = 1; i < num_partitions; ++i) {
-    const int64_t offset = i * stride;
-    run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
-         partitions, offset, &bc, &statuses]() {
-          function(result_ptr, run_options_ptr, nullptr, buffer_table,
-                   &statuses[i], &partitions[offset], prof_counters);
-          bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
-        });
+  // Index of the next partition to compute.
+  std::atomic<int32_t> next_partition(0);
+  auto compute_partitions = [&]() {
+    for (int32_t i = next_partition.fetch_add(1); i < num_partitions;
+         i = next_partition.fetch_add(1)) {
+      function(result_ptr, run_options_ptr, nullptr, buffer_table,
+               &statuses[i], &partitions[i * stride], prof_counters);
+      VLOG(3) << "ParallelForkJoin partition " << i << " done.";
+    }
+  };
+
+  // Dispatch helper tasks to the idle threads of the pool.
+  const Eigen::ThreadPoolDevice* pool = run_options->intra_op_thread_pool();
+  const int64_t idle_threads =
+      pool->numThreads() -
+      in_flight_helper_tasks.load(std::memory_order_relaxed);
+  const int64_t num_helpers = std::max<int64_t>(
+      0, std::min<int64_t>(num_partitions - 1, idle_threads));
+  in_flight_helper_tasks.fetch_add(num_helpers, std::memory_order_relaxed);
+  tensorflow::BlockingCounter bc(num_helpers);
+  for (int64_t i = 0; i < num_helpers; ++i) {
+    pool->enqueueNoNotification([&compute_partitions, &bc]() {
+      compute_partitions();
+      in_flight_helper_tasks.fetch_sub(1, std::memory_order_relaxed);
+      bc.DecrementCount();
+    });
   }
 
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, buffer_table, &statuses[0],
-           &partitions[0], prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
+  // Compute partitions inline until all of them are claimed.
+  compute_partitions();
   bc.Wait();
 
   // Collect all error messages (if any).
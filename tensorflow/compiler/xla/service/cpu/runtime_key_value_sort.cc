@@ -14,17 +14,191 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/compiler/xla/service/cpu/runtime_key_value_sort.h"
 
+#define EIGEN_USE_THREADS
+
 #include <algorithm>
+#include <cmath>
 #include <cstring>
-#include <memory>
 #include <numeric>
-#include <string>
+#include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/compiler/xla/executable_run_options.h"
 #include "tensorflow/core/platform/dynamic_annotations.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
 
+namespace {
+
+// Rows are sorted by several threads in chunks of at least this many
+// elements, if there are fewer rows than threads.
+constexpr int64_t kMinParallelSortChunkElements = 1 << 14;
+
+// A rough cost of a call to the less-than function, in cycles.
+constexpr double kComparisonCycles = 20;
+
+// The arguments of __xla_cpu_runtime_KeyValueSort.
+struct SortParams {
+  int64_t sort_dimension_elements;
+  int64_t sort_dimension_offset;
+  char** values;
+  int32_t values_count;
+  tensorflow::int32* values_primitive_type_size_in_bytes;
+  bool is_stable;
+  char* run_options;
+  int64_t* prof_counters;
+  void (*less_than)(char*, char*, char**, char**, int64_t*);
+};
+
+// Compares two elements of the row at 'base_offset' by their indices in the
+// row. 'comparison_values' is the buffer of the 2 * 'values_count' operands
+// of the less-than function, so each thread needs its own.
+class Comparator {
+ public:
+  Comparator(const SortParams& params, int64_t base_offset,
+             char** comparison_values)
+      : params_(params),
+        base_offset_(base_offset),
+        comparison_values_(comparison_values) {}
+
+  bool operator()(int64_t a, int64_t b) const {
+    for (int32_t i = 0; i < params_.values_count; ++i) {
+      int64_t memory_index_lhs =
+          (base_offset_ + a * params_.sort_dimension_offset) *
+          params_.values_primitive_type_size_in_bytes[i];
+      int64_t memory_index_rhs =
+          (base_offset_ + b * params_.sort_dimension_offset) *
+          params_.values_primitive_type_size_in_bytes[i];
+      comparison_values_[i * 2] = params_.values[i] + memory_index_lhs;
+      comparison_values_[i * 2 + 1] = params_.values[i] + memory_index_rhs;
+    }
+    char result = 0;  // Overwritten by less_than.
+    params_.less_than(&result, params_.run_options, comparison_values_,
+                      nullptr, params_.prof_counters);
+    return result != 0u;
+  }
+
+ private:
+  const SortParams& params_;
+  const int64_t base_offset_;
+  char** const comparison_values_;
+};
+
+// Returns the offset of the first element of the 'index'-th row.
+int64_t BaseOffset(const SortParams& params, int64_t index) {
+  // 'index' can be split into two values which index into the 'c' dimension
+  // and the 'a' dimension, respectively. 'index' % 'c' is the index into the
+  // 'c' dimension, 'index' / 'c' is the index into the 'a' dimension. When
+  // calculating the base offset, we need to multiply the index into the 'a'
+  // dimension with 'b' * 'c'.
+  // 'index' / 'c' * 'c' * 'b' = ('index' - 'index' % 'c') * 'b'.
+  const int64_t c = params.sort_dimension_offset;
+  return index % c + (index - index % c) * params.sort_dimension_elements;
+}
+
+// Sorts the row indices [begin, end), which must be in ascending order if the
+// sort should be stable, to keep their relative order in case of ties.
+void SortIndices(const SortParams& params, int64_t base_offset,
+                 int64_t* begin, int64_t* end) {
+  std::vector<char*> comparison_values(2 * params.values_count);
+  Comparator compare(params, base_offset, comparison_values.data());
+  if (params.is_stable) {
+    std::stable_sort(begin, end, compare);
+  } else {
+    std::sort(begin, end, compare);
+  }
+}
+
+// Reorders the values of the row at 'base_offset' according to the order
+// defined by 'indices', through 'scratch'.
+void Reorder(const SortParams& params, int64_t base_offset,
+             const int64_t* indices, std::vector<char>* scratch) {
+  const int64_t b = params.sort_dimension_elements;
+  const int64_t c = params.sort_dimension_offset;
+  for (int32_t idx = 0; idx < params.values_count; ++idx) {
+    const int64_t size = params.values_primitive_type_size_in_bytes[idx];
+    char* row = params.values[idx] + base_offset * size;
+    scratch->resize(b * size);
+    char* reordered = scratch->data();
+    for (int64_t i = 0; i < b; ++i) {
+      memcpy(reordered + i * size, row + indices[i] * c * size, size);
+    }
+    if (c == 1) {
+      memcpy(row, reordered, b * size);
+    } else {
+      for (int64_t i = 0; i < b; ++i) {
+        memcpy(row + i * c * size, reordered + i * size, size);
+      }
+    }
+  }
+}
+
+// Sorts the rows [begin, end) with the calling thread.
+void SortRows(const SortParams& params, int64_t begin, int64_t end) {
+  const int64_t b = params.sort_dimension_elements;
+  std::vector<int64_t> indices(b);
+  std::vector<char> scratch;
+  for (int64_t index = begin; index < end; ++index) {
+    const int64_t base_offset = BaseOffset(params, index);
+    std::iota(indices.begin(), indices.end(), 0);
+    SortIndices(params, base_offset, indices.data(), indices.data() + b);
+    Reorder(params, base_offset, indices.data(), &scratch);
+  }
+}
+
+// Sorts the 'index'-th row with the threads of 'device': chunks of the row
+// are sorted in parallel, and then merged pairwise, in parallel across the
+// pairs. std::merge keeps the order of ties, so the sort stays stable.
+void ParallelSortRow(const SortParams& params, int64_t index,
+                     int64_t num_chunks,
+                     const Eigen::ThreadPoolDevice& device) {
+  const int64_t b = params.sort_dimension_elements;
+  const int64_t base_offset = BaseOffset(params, index);
+  const int64_t chunk_size = (b + num_chunks - 1) / num_chunks;
+  auto chunk_begin = [&](int64_t chunk) {
+    return std::min(b, chunk * chunk_size);
+  };
+  std::vector<int64_t> indices(b);
+  std::iota(indices.begin(), indices.end(), 0);
+  device.parallelFor(
+      num_chunks,
+      Eigen::TensorOpCost(0, 0,
+                          chunk_size * std::log2(chunk_size) *
+                              kComparisonCycles),
+      [&](Eigen::Index first, Eigen::Index last) {
+        for (Eigen::Index chunk = first; chunk < last; ++chunk) {
+          SortIndices(params, base_offset, indices.data() + chunk_begin(chunk),
+                      indices.data() + chunk_begin(chunk + 1));
+        }
+      });
+
+  std::vector<int64_t> merged(b);
+  for (int64_t width = 1; width < num_chunks; width *= 2) {
+    const int64_t num_merges = (num_chunks + 2 * width - 1) / (2 * width);
+    device.parallelFor(
+        num_merges,
+        Eigen::TensorOpCost(0, 0, 2 * width * chunk_size * kComparisonCycles),
+        [&](Eigen::Index first, Eigen::Index last) {
+          std::vector<char*> comparison_values(2 * params.values_count);
+          Comparator compare(params, base_offset, comparison_values.data());
+          for (Eigen::Index merge = first; merge < last; ++merge) {
+            const int64_t lo = chunk_begin(2 * merge * width);
+            const int64_t mid = chunk_begin((2 * merge + 1) * width);
+            const int64_t hi = chunk_begin((2 * merge + 2) * width);
+            std::merge(indices.data() + lo, indices.data() + mid,
+                       indices.data() + mid, indices.data() + hi,
+                       merged.data() + lo, compare);
+          }
+        });
+    indices.swap(merged);
+  }
+
+  std::vector<char> scratch;
+  Reorder(params, base_offset, indices.data(), &scratch);
+}
+
+}  // namespace
+
 TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_KeyValueSort(
     int64_t a, int64_t b, int64_t c, char** values, int32_t values_count,
     tensorflow::int32* values_primitive_type_size_in_bytes, bool is_stable,
@@ -44,70 +218,51 @@ TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_KeyValueSort(
   // many rows that we need to sort. We iterate through these, calculate a
   // 'base_offset' value which points to the first element in that row, and add
   // i * c for accessing the 'i'-th element in that row.
+  //
+  // The rows are independent, so they are sorted in parallel on the intra-op
+  // thread pool, if there is one. If there are fewer rows than threads, large
+  // rows are each sorted by all the threads instead.
+  const SortParams params{b,
+                          c,
+                          values,
+                          values_count,
+                          values_primitive_type_size_in_bytes,
+                          is_stable,
+                          run_options,
+                          prof_counters,
+                          less_than};
+  const int64_t num_iteration_elements = a * c;
+  const auto* executable_run_options =
+      reinterpret_cast<const xla::ExecutableRunOptions*>(run_options);
+  const Eigen::ThreadPoolDevice* device =
+      executable_run_options != nullptr
+          ? executable_run_options->intra_op_thread_pool()
+          : nullptr;
+  // The less-than function doesn't update the profile counters atomically.
+  if (device == nullptr || device->numThreads() <= 1 ||
+      prof_counters != nullptr || b <= 1) {
+    SortRows(params, 0, num_iteration_elements);
+    return;
+  }
 
-  int64_t sort_dimension_elements = b;
-  int64_t num_iteration_elements = a * c;
-  int64_t sort_dimension_offset = c;
-
-  std::unique_ptr<int64_t[]> indices(new int64_t[sort_dimension_elements]);
-  std::unique_ptr<char*[]> comparison_values(new char*[2 * values_count]);
-  std::iota(indices.get(), indices.get() + sort_dimension_elements, 0);
-  std::unique_ptr<std::string[]> reordered_values(
-      new std::string[sort_dimension_elements]);
-  for (int64_t index = 0; index < num_iteration_elements; ++index) {
-    // If the sort should be stable, we have to reinitialize indices to iota to
-    // guarantee that we still keep the relative order in case of ties.
-    if (is_stable && index > 0) {
-      std::iota(indices.get(), indices.get() + sort_dimension_elements, 0);
-    }
-    // 'index' can be split into two values which index into the 'c' dimension
-    // and the 'a' dimension, respectively. 'index' % 'c' is the index into the
-    // 'c' dimension, 'index' / 'c' is the index into the 'a' dimension. When
-    // calculating the base offset, we need to multiply the index into the 'a'
-    // dimension with 'b' * 'c'.
-    // 'index' / 'c' * 'c' * 'b' = ('index' - 'index' % 'c') * 'b'.
-    int64_t base_offset =
-        index % sort_dimension_offset +
-        (index - index % sort_dimension_offset) * sort_dimension_elements;
-    auto compare_function = [&](int64_t a, int64_t b) -> bool {
-      for (int32_t i = 0; i < values_count; ++i) {
-        int64_t memory_index_lhs = (base_offset + a * sort_dimension_offset) *
-                                   values_primitive_type_size_in_bytes[i];
-        int64_t memory_index_rhs = (base_offset + b * sort_dimension_offset) *
-                                   values_primitive_type_size_in_bytes[i];
-        comparison_values[i * 2] = values[i] + memory_index_lhs;
-        comparison_values[i * 2 + 1] = values[i] + memory_index_rhs;
-      }
-      char result = 0;  // Overwritten by less_than.
-      less_than(&result, run_options, comparison_values.get(), nullptr,
-                prof_counters);
-      return result != 0u;
-    };
-    if (is_stable) {
-      std::stable_sort(indices.get(), indices.get() + sort_dimension_elements,
-                       compare_function);
-    } else {
-      std::sort(indices.get(), indices.get() + sort_dimension_elements,
-                compare_function);
+  const int64_t num_chunks = std::min<int64_t>(
+      device->numThreads(), b / kMinParallelSortChunkElements);
+  if (num_iteration_elements < device->numThreads() && num_chunks > 1) {
+    for (int64_t index = 0; index < num_iteration_elements; ++index) {
+      ParallelSortRow(params, index, num_chunks, *device);
     }
+    return;
+  }
 
-    // Reorder the values according to the order defined by 'indices'.
-    for (int32_t idx = 0; idx < values_count; ++idx) {
-      for (int64_t i = 0; i < sort_dimension_elements; ++i) {
-        int64_t memory_index =
-            (base_offset + indices[i] * sort_dimension_offset) *
-            values_primitive_type_size_in_bytes[idx];
-
-        reordered_values[i] =
-            std::string(values[idx] + memory_index,
-                        values_primitive_type_size_in_bytes[idx]);
-      }
-      for (int64_t i = 0; i < sort_dimension_elements; ++i) {
-        int64_t memory_index = (base_offset + i * sort_dimension_offset) *
-                               values_primitive_type_size_in_bytes[idx];
-        memcpy(values[idx] + memory_index, reordered_values[i].c_str(),
-               values_primitive_type_size_in_bytes[idx]);
-      }
-    }
+  int64_t row_bytes = 0;
+  for (int32_t i = 0; i < values_count; ++i) {
+    row_bytes += b * values_primitive_type_size_in_bytes[i];
   }
+  device->parallelFor(
+      num_iteration_elements,
+      Eigen::TensorOpCost(row_bytes, row_bytes,
+                          b * std::log2(b) * kComparisonCycles),
+      [&](Eigen::Index begin, Eigen::Index end) {
+        SortRows(params, begin, end);
+      });
 }
@@ -35,6 +35,8 @@ extern "C" {
 // - pointers to the parameter buffers (char**)
 // - pointers to the buffer tables = nullptr for thread local functions (char**)
 // - profile counters = 'prof_counters' (int64_t*)
+// The rows are sorted on the intra-op thread pool of 'run_options', if it has
+// one, so 'less_than' must be safe to call concurrently.
 extern void __xla_cpu_runtime_KeyValueSort(
     int64_t a, int64_t b, int64_t c, char** values, int32_t values_count,
     tensorflow::int32* values_primitive_type_size_in_bytes, bool is_stable,
@@ -0,0 +1,182 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+#include "tensorflow/compiler/xla/service/cpu/runtime_key_value_sort.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/compiler/xla/executable_run_options.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace xla {
+namespace {
+
+// Rows of at least this many elements are sorted by several threads, if there
+// are fewer rows than threads.
+constexpr int64_t kMinParallelSortChunkElements = 1 << 14;
+
+constexpr int kNumThreads = 8;
+
+// Returns an integer whose order is the total order of floats, in which
+// -NaN < -Inf < -0 < +0 < +Inf < +NaN, as in comparators emitted by XLA.
+int32_t TotalOrderKey(float value) {
+  int32_t x;
+  std::memcpy(&x, &value, sizeof(x));
+  return x < 0 ? x ^ std::numeric_limits<int32_t>::max() : x;
+}
+
+// A less-than function of KeyValueSort that compares the F32 keys of the
+// first operand in their total order, and ignores the S32 payload of the
+// second one.
+void KeyLessThan(char* result, char* run_options, char** params,
+                 char** buffer_table, int64_t* prof_counters) {
+  float lhs, rhs;
+  std::memcpy(&lhs, params[0], sizeof(lhs));
+  std::memcpy(&rhs, params[1], sizeof(rhs));
+  *result = TotalOrderKey(lhs) < TotalOrderKey(rhs);
+}
+
+// Returns keys of which many are tied, including zeros of both signs, NaNs
+// of both signs and infinities.
+std::vector<float> MakeKeys(int64_t size, int seed) {
+  const float kSpecialKeys[] = {0.0f,
+                                -0.0f,
+                                std::numeric_limits<float>::infinity(),
+                                -std::numeric_limits<float>::infinity(),
+                                std::numeric_limits<float>::quiet_NaN(),
+                                -std::numeric_limits<float>::quiet_NaN()};
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> dist(-16, 16 + 6);
+  std::vector<float> keys(size);
+  for (float& key : keys) {
+    const int k = dist(gen);
+    key = k > 16 ? kSpecialKeys[k - 17] : static_cast<float>(k);
+  }
+  return keys;
+}
+
+class KeyValueSortTest : public ::testing::Test {
+ protected:
+  KeyValueSortTest()
+      : pool_(tensorflow::Env::Default(), "XLAEigen", kNumThreads),
+        device_(pool_.AsEigenThreadPool(), pool_.NumThreads()) {
+    run_options_.set_intra_op_thread_pool(&device_);
+  }
+
+  // Sorts the [a, b, c] shaped `keys` along `b`, together with the payload
+  // that holds the position of each key, and checks the result against a
+  // serial std::stable_sort of each row.
+  void SortAndCheck(int64_t a, int64_t b, int64_t c, bool is_stable,
+                    const ExecutableRunOptions* run_options) {
+    std::vector<float> keys = MakeKeys(a * b * c, /*seed=*/a + b + c);
+    std::vector<int32_t> payload(keys.size());
+    std::iota(payload.begin(), payload.end(), 0);
+    const std::vector<float> original_keys = keys;
+
+    char* values[] = {reinterpret_cast<char*>(keys.data()),
+                      reinterpret_cast<char*>(payload.data())};
+    tensorflow::int32 sizes[] = {sizeof(float), sizeof(int32_t)};
+    __xla_cpu_runtime_KeyValueSort(
+        a, b, c, values, /*values_count=*/2, sizes, is_stable,
+        reinterpret_cast<char*>(const_cast<ExecutableRunOptions*>(run_options)),
+        /*prof_counters=*/nullptr, &KeyLessThan);
+
+    std::vector<int32_t> expected(b);
+    for (int64_t i = 0; i < a; ++i) {
+      for (int64_t j = 0; j < c; ++j) {
+        auto position = [&](int64_t k) { return (i * b + k) * c + j; };
+        for (int64_t k = 0; k < b; ++k) expected[k] = position(k);
+        std::stable_sort(expected.begin(), expected.end(),
+                         [&](int32_t lhs, int32_t rhs) {
+                           return TotalOrderKey(original_keys[lhs]) <
+                                  TotalOrderKey(original_keys[rhs]);
+                         });
+        for (int64_t k = 0; k < b; ++k) {
+          const int64_t p = position(k);
+          ASSERT_EQ(TotalOrderKey(keys[p]),
+                    TotalOrderKey(original_keys[expected[k]]))
+              << "row (" << i << ", " << j << "), element " << k;
+          if (is_stable) {
+            ASSERT_EQ(payload[p], expected[k])
+                << "row (" << i << ", " << j << "), element " << k;
+          } else {
+            // The payload moved with its key.
+            ASSERT_EQ(TotalOrderKey(original_keys[payload[p]]),
+                      TotalOrderKey(keys[p]))
+                << "row (" << i << ", " << j << "), element " << k;
+          }
+        }
+      }
+    }
+  }
+
+  tensorflow::thread::ThreadPool pool_;
+  Eigen::ThreadPoolDevice device_;
+  ExecutableRunOptions run_options_;
+};
+
+TEST_F(KeyValueSortTest, SerialWithoutThreadPool) {
+  SortAndCheck(/*a=*/3, /*b=*/1000, /*c=*/2, /*is_stable=*/true,
+               /*run_options=*/nullptr);
+  SortAndCheck(/*a=*/1, /*b=*/4 * kMinParallelSortChunkElements, /*c=*/1,
+               /*is_stable=*/true, /*run_options=*/nullptr);
+}
+
+TEST_F(KeyValueSortTest, ManyRows) {
+  SortAndCheck(/*a=*/64, /*b=*/1000, /*c=*/1, /*is_stable=*/true,
+               &run_options_);
+  SortAndCheck(/*a=*/8, /*b=*/500, /*c=*/5, /*is_stable=*/true,
+               &run_options_);
+  SortAndCheck(/*a=*/64, /*b=*/1000, /*c=*/1, /*is_stable=*/false,
+               &run_options_);
+}
+
+TEST_F(KeyValueSortTest, FewLongRowsStable) {
+  // More chunks than threads could sort, a number of chunks that is not a
+  // power of two, and a row that is not a multiple of the chunk size.
+  SortAndCheck(/*a=*/1, /*b=*/kNumThreads * kMinParallelSortChunkElements + 123,
+               /*c=*/1, /*is_stable=*/true, &run_options_);
+  SortAndCheck(/*a=*/1, /*b=*/3 * kMinParallelSortChunkElements, /*c=*/1,
+               /*is_stable=*/true, &run_options_);
+  SortAndCheck(/*a=*/2, /*b=*/5 * kMinParallelSortChunkElements + 1, /*c=*/1,
+               /*is_stable=*/true, &run_options_);
+}
+
+TEST_F(KeyValueSortTest, FewLongRowsWithMinorDimension) {
+  SortAndCheck(/*a=*/1, /*b=*/4 * kMinParallelSortChunkElements + 7, /*c=*/3,
+               /*is_stable=*/true, &run_options_);
+}
+
+TEST_F(KeyValueSortTest, FewLongRowsUnstable) {
+  SortAndCheck(/*a=*/1, /*b=*/kNumThreads * kMinParallelSortChunkElements + 123,
+               /*c=*/1, /*is_stable=*/false, &run_options_);
+}
+
+TEST_F(KeyValueSortTest, RowsJustBelowParallelSortThreshold) {
+  SortAndCheck(/*a=*/1, /*b=*/2 * kMinParallelSortChunkElements - 1, /*c=*/1,
+               /*is_stable=*/true, &run_options_);
+}
+
+}  // namespace
+}  // namespace xla
@@ -15,61 +15,147 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/runtime_topk.h"
 
+#define EIGEN_USE_THREADS
+
 #include <algorithm>
-#include <memory>
-#include <numeric>
+#include <cstring>
+#include <functional>
 #include <vector>
 
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/compiler/xla/executable_run_options.h"
 #include "tensorflow/core/platform/dynamic_annotations.h"
 #include "tensorflow/core/platform/macros.h"
 
-template <typename T>
+namespace {
+
+// Rows are split into chunks of at least this many elements, selected by
+// several threads, if there are fewer rows than threads.
+constexpr int64_t kMinParallelTopKChunkElements = 1 << 14;
+
+// Returns the key of 'value' at 'index' in a row, such that the keys of the
+// top k are the k smallest. Values are ordered in integers, to enforce a
+// total order of -NaN < -Inf < -0 < +0 < +Inf < +NaN, and ties are broken
+// by the smaller index. Comparing the keys as integers is branch-free, and
+// computing them vectorizes.
+inline tensorflow::uint64 SortKey(float value, tensorflow::int32 index) {
+  tensorflow::uint32 x;
+  std::memcpy(&x, &value, sizeof(x));
+  // Flip the negative values, and the sign of the others, so that the
+  // unsigned order of 'x' is the order of the values.
+  x = static_cast<tensorflow::int32>(x) < 0 ? ~x : x | 0x80000000u;
+  return static_cast<tensorflow::uint64>(~x) << 32 |
+         static_cast<tensorflow::uint32>(index);
+}
+
+// Sets keys[0, n) to the keys of values[begin, begin + n), and moves the
+// min(k, n) smallest of them to the front, in no particular order.
+void SelectTopK(const float* values, int64_t begin, int64_t n, int64_t k,
+                tensorflow::uint64* keys) {
+  for (int64_t i = 0; i < n; ++i) {
+    keys[i] = SortKey(values[begin + i], begin + i);
+  }
+  if (k < n) {
+    std::nth_element(keys, keys + k, keys + n);
+  }
+}
+
+// Sorts the k keys of a row, and writes their values and indices.
+void WriteTopK(const float* values_batch, int64_t k, tensorflow::uint64* keys,
+               float* out_values_batch, tensorflow::int32* out_indices_batch) {
+  std::sort(keys, keys + k);
+  for (int64_t i = 0; i < k; ++i) {
+    const tensorflow::int32 index = static_cast<tensorflow::uint32>(keys[i]);
+    out_indices_batch[i] = index;
+    out_values_batch[i] = values_batch[index];
+  }
+}
+
+}  // namespace
+
 static void TopK(int64_t batch_size, int64_t input_size, int64_t k,
-                 const T* values, T* out_values,
-                 tensorflow::int32* out_indices) {
+                 const float* values, float* out_values,
+                 tensorflow::int32* out_indices,
+                 const Eigen::ThreadPoolDevice* device) {
   // 'values' is managed by the JIT code, so msan can't tell they are
   // initialized.
   TF_ANNOTATE_MEMORY_IS_INITIALIZED(values,
-                                    input_size * batch_size * sizeof(T));
-
-  std::vector<tensorflow::int32> temp_indices(input_size);
-  for (int64_t batch = 0; batch != batch_size; ++batch) {
-    std::iota(temp_indices.begin(), temp_indices.end(), 0);
-
-    const T* values_batch = values + batch * input_size;
-
-    auto convert_to_int = [](T value) {
-      tensorflow::uint32 x;
-      std::memcpy(&x, &value, sizeof(x));
-      return static_cast<tensorflow::int32>(x) < 0
-                 ? std::numeric_limits<tensorflow::int32>::max() - x
-                 : x;
-    };
-
-    auto kth_element = temp_indices.begin() + k;
-    std::partial_sort(temp_indices.begin(), kth_element, temp_indices.end(),
-                      [&](size_t i1, size_t i2) {
-                        // Do the comparison in integers to enforce a total
-                        // order of -NaN < -Inf < -0 < +0 < +Inf < +NaN.
-                        int32_t v1 = convert_to_int(values_batch[i1]);
-                        int32_t v2 = convert_to_int(values_batch[i2]);
-                        if (v1 == v2) {
-                          return i1 < i2;  // Stabilize sorting.
-                        }
-                        return v1 > v2;
-                      });
-
-    T* out_values_batch = out_values + batch * k;
-    tensorflow::int32* out_indices_batch = out_indices + batch * k;
-    std::copy(temp_indices.begin(), kth_element, out_indices_batch);
-    for (int64_t i = 0; i < k; i++) {
-      out_values_batch[i] = values_batch[temp_indices[i]];
+                                    input_size * batch_size * sizeof(float));
+
+  // The rows are selected in parallel on the intra-op thread pool, if there
+  // is one. If there are fewer rows than threads, large rows are split into
+  // chunks, whose top k are selected in parallel and then merged.
+  const int num_threads = device != nullptr ? device->numThreads() : 1;
+  const int64_t num_chunks = std::max<int64_t>(
+      1, std::min<int64_t>(num_threads / std::max<int64_t>(batch_size, 1),
+                           input_size / kMinParallelTopKChunkElements));
+  auto parallel_for = [&](int64_t n, double cycles_per_unit,
+                          const std::function<void(Eigen::Index,
+                                                   Eigen::Index)>& f) {
+    if (device == nullptr || num_threads <= 1) {
+      f(0, n);
+    } else {
+      device->parallelFor(
+          n, Eigen::TensorOpCost(sizeof(float), 0, cycles_per_unit), f);
     }
+  };
+
+  if (num_chunks == 1) {
+    parallel_for(
+        batch_size, 10.0 * input_size,
+        [&](Eigen::Index first, Eigen::Index last) {
+          std::vector<tensorflow::uint64> keys(input_size);
+          for (Eigen::Index batch = first; batch < last; ++batch) {
+            const float* values_batch = values + batch * input_size;
+            SelectTopK(values_batch, 0, input_size, k, keys.data());
+            WriteTopK(values_batch, k, keys.data(), out_values + batch * k,
+                      out_indices + batch * k);
+          }
+        });
+    return;
   }
+
+  const int64_t chunk_size = (input_size + num_chunks - 1) / num_chunks;
+  std::vector<tensorflow::uint64> keys(batch_size * input_size);
+  parallel_for(
+      batch_size * num_chunks, 10.0 * chunk_size,
+      [&](Eigen::Index first, Eigen::Index last) {
+        for (Eigen::Index i = first; i < last; ++i) {
+          const int64_t batch = i / num_chunks;
+          const int64_t begin =
+              std::min(input_size, i % num_chunks * chunk_size);
+          const int64_t end = std::min(input_size, begin + chunk_size);
+          SelectTopK(values + batch * input_size, begin, end - begin, k,
+                     keys.data() + batch * input_size + begin);
+        }
+      });
+  parallel_for(
+      batch_size, 10.0 * num_chunks * k,
+      [&](Eigen::Index first, Eigen::Index last) {
+        for (Eigen::Index batch = first; batch < last; ++batch) {
+          // Gather the top k of each chunk at the front of the row.
+          tensorflow::uint64* keys_batch = keys.data() + batch * input_size;
+          int64_t num_candidates = 0;
+          for (int64_t begin = 0; begin < input_size; begin += chunk_size) {
+            const int64_t n = std::min({k, chunk_size, input_size - begin});
+            std::copy(keys_batch + begin, keys_batch + begin + n,
+                      keys_batch + num_candidates);
+            num_candidates += n;
+          }
+          std::nth_element(keys_batch, keys_batch + k,
+                           keys_batch + num_candidates);
+          WriteTopK(values + batch * input_size, k, keys_batch,
+                    out_values + batch * k, out_indices + batch * k);
+        }
+      });
 }
 
 TF_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_TopKF32(
     int64_t batch_size, int64_t input_size, int64_t k, const float* values,
-    float* out_values, tensorflow::int32* out_indices) {
-  TopK(batch_size, input_size, k, values, out_values, out_indices);
+    float* out_values, tensorflow::int32* out_indices,
+    const void* run_options_ptr) {
+  const xla::ExecutableRunOptions* run_options =
+      static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
+  TopK(batch_size, input_size, k, values, out_values, out_indices,
+       run_options != nullptr ? run_options->intra_op_thread_pool() : nullptr);
 }
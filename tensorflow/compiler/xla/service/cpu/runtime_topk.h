@@ -21,11 +21,14 @@ limitations under the License.
 extern "C" {
 
 // Calculates `batch_size` topk operations with `input_size` inputs each. The
-// outputs are written to `out_values` and `out_indices`.
+// outputs are written to `out_values` and `out_indices`. The rows are
+// processed on the intra-op thread pool of `run_options_ptr`, an
+// xla::ExecutableRunOptions, if it has one.
 extern void __xla_cpu_runtime_TopKF32(int64_t batch_size, int64_t input_size,
                                       int64_t k, const float* values,
                                       float* out_values,
-                                      tensorflow::int32* out_indices);
+                                      tensorflow::int32* out_indices,
+                                      const void* run_options_ptr);
 }
 
 #endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_TOPK_H
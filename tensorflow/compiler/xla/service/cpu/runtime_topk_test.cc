@@ -0,0 +1,162 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+#include "tensorflow/compiler/xla/service/cpu/runtime_topk.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/compiler/xla/executable_run_options.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace xla {
+namespace {
+
+// Rows of at least twice this many elements are split into chunks, if there
+// are fewer rows than threads.
+constexpr int64_t kMinParallelTopKChunkElements = 1 << 14;
+
+constexpr int kNumThreads = 8;
+
+// Returns an integer whose order is the total order of floats, in which
+// -NaN < -Inf < -0 < +0 < +Inf < +NaN.
+int32_t TotalOrderKey(float value) {
+  int32_t x;
+  std::memcpy(&x, &value, sizeof(x));
+  return x < 0 ? x ^ std::numeric_limits<int32_t>::max() : x;
+}
+
+// Returns values of which many are tied, including zeros of both signs, NaNs
+// of both signs and infinities.
+std::vector<float> MakeValues(int64_t size, int seed) {
+  const float kSpecialValues[] = {0.0f,
+                                  -0.0f,
+                                  std::numeric_limits<float>::infinity(),
+                                  -std::numeric_limits<float>::infinity(),
+                                  std::numeric_limits<float>::quiet_NaN(),
+                                  -std::numeric_limits<float>::quiet_NaN()};
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> dist(-1000, 1000 + 6);
+  std::vector<float> values(size);
+  for (float& value : values) {
+    const int v = dist(gen);
+    value = v > 1000 ? kSpecialValues[v - 1001] : static_cast<float>(v);
+  }
+  return values;
+}
+
+class TopKTest : public ::testing::Test {
+ protected:
+  TopKTest()
+      : pool_(tensorflow::Env::Default(), "XLAEigen", kNumThreads),
+        device_(pool_.AsEigenThreadPool(), pool_.NumThreads()) {
+    run_options_.set_intra_op_thread_pool(&device_);
+  }
+
+  // Selects the top `k` of each of the `batch_size` rows of `input_size`
+  // values, and checks them against a stable sort of each row in descending
+  // order, which breaks ties by the smaller index.
+  void TopKAndCheck(int64_t batch_size, int64_t input_size, int64_t k,
+                    const ExecutableRunOptions* run_options) {
+    const std::vector<float> values =
+        MakeValues(batch_size * input_size, /*seed=*/input_size + k);
+    std::vector<float> out_values(batch_size * k);
+    std::vector<tensorflow::int32> out_indices(batch_size * k);
+    __xla_cpu_runtime_TopKF32(batch_size, input_size, k, values.data(),
+                              out_values.data(), out_indices.data(),
+                              run_options);
+
+    std::vector<tensorflow::int32> expected(input_size);
+    for (int64_t batch = 0; batch < batch_size; ++batch) {
+      const float* row = values.data() + batch * input_size;
+      std::iota(expected.begin(), expected.end(), 0);
+      std::stable_sort(expected.begin(), expected.end(),
+                       [&](tensorflow::int32 lhs, tensorflow::int32 rhs) {
+                         return TotalOrderKey(row[lhs]) >
+                                TotalOrderKey(row[rhs]);
+                       });
+      for (int64_t i = 0; i < k; ++i) {
+        ASSERT_EQ(out_indices[batch * k + i], expected[i])
+            << "row " << batch << ", element " << i;
+        ASSERT_EQ(TotalOrderKey(out_values[batch * k + i]),
+                  TotalOrderKey(row[expected[i]]))
+            << "row " << batch << ", element " << i;
+      }
+    }
+  }
+
+  tensorflow::thread::ThreadPool pool_;
+  Eigen::ThreadPoolDevice device_;
+  ExecutableRunOptions run_options_;
+};
+
+TEST_F(TopKTest, SerialWithoutRunOptions) {
+  TopKAndCheck(/*batch_size=*/5, /*input_size=*/100, /*k=*/10,
+               /*run_options=*/nullptr);
+  TopKAndCheck(/*batch_size=*/1,
+               /*input_size=*/4 * kMinParallelTopKChunkElements, /*k=*/10,
+               /*run_options=*/nullptr);
+}
+
+TEST_F(TopKTest, ManyRows) {
+  TopKAndCheck(/*batch_size=*/64, /*input_size=*/1000, /*k=*/10,
+               &run_options_);
+  TopKAndCheck(/*batch_size=*/16, /*input_size=*/7, /*k=*/7, &run_options_);
+}
+
+TEST_F(TopKTest, FewLongRows) {
+  TopKAndCheck(/*batch_size=*/1,
+               /*input_size=*/kNumThreads * kMinParallelTopKChunkElements + 123,
+               /*k=*/10, &run_options_);
+  TopKAndCheck(/*batch_size=*/3,
+               /*input_size=*/2 * kMinParallelTopKChunkElements + 1, /*k=*/1,
+               &run_options_);
+}
+
+TEST_F(TopKTest, FewLongRowsKLargerThanChunk) {
+  // The row is split into 4 chunks, each of which has fewer elements than k.
+  TopKAndCheck(/*batch_size=*/2,
+               /*input_size=*/4 * kMinParallelTopKChunkElements + 5,
+               /*k=*/kMinParallelTopKChunkElements + 7, &run_options_);
+  // All the elements of a row.
+  TopKAndCheck(/*batch_size=*/1,
+               /*input_size=*/2 * kMinParallelTopKChunkElements + 3,
+               /*k=*/2 * kMinParallelTopKChunkElements + 3, &run_options_);
+}
+
+TEST_F(TopKTest, OrdersSpecialValues) {
+  const float kNaN = std::numeric_limits<float>::quiet_NaN();
+  const float kInf = std::numeric_limits<float>::infinity();
+  const std::vector<float> values = {0.0f, -kNaN, 1.0f, -0.0f, -kInf,
+                                     kNaN, kInf,  1.0f, -1.0f, 0.0f};
+  std::vector<float> out_values(values.size());
+  std::vector<tensorflow::int32> out_indices(values.size());
+  __xla_cpu_runtime_TopKF32(/*batch_size=*/1, values.size(), values.size(),
+                            values.data(), out_values.data(),
+                            out_indices.data(), &run_options_);
+  EXPECT_EQ(out_indices,
+            std::vector<tensorflow::int32>({5, 6, 2, 7, 0, 9, 3, 8, 4, 1}));
+}
+
+}  // namespace
+}  // namespace xla
@@ -94,8 +94,11 @@ SimpleOrcJIT::SimpleOrcJIT(
     bool disable_expensive_passes, llvm::FastMathFlags fast_math_flags,
     LLVMCompiler::ModuleHook pre_optimization_hook,
     LLVMCompiler::ModuleHook post_optimization_hook,
-    std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook)
-    : target_machine_(InferTargetMachineForJIT(target_options, opt_level)),
+    std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook,
+    PersistentCompilationCache* persistent_cache)
+    : target_options_(target_options),
+      opt_level_(opt_level),
+      target_machine_(InferTargetMachineForJIT(target_options_, opt_level_)),
       target_triple_(target_machine_->getTargetTriple()),
       data_layout_(target_machine_->createDataLayout()),
       target_process_control_(std::move(target_process_control)),
@@ -111,7 +114,8 @@ SimpleOrcJIT::SimpleOrcJIT(
               target_machine_.get(), opt_level, optimize_for_size,
               disable_expensive_passes, fast_math_flags,
               std::move(pre_optimization_hook),
-              std::move(post_optimization_hook), std::move(post_codegen_hook))),
+              std::move(post_optimization_hook), std::move(post_codegen_hook),
+              persistent_cache)),
       main_jit_dylib_(&execution_session_->createBareJITDylib("<main>")),
       gdb_jit_event_listener_(
           llvm::JITEventListener::createGDBRegistrationListener()) {
@@ -165,7 +169,8 @@ llvm::Expected<std::unique_ptr<SimpleOrcJIT>> SimpleOrcJIT::Create(
     bool disable_expensive_passes, llvm::FastMathFlags fast_math_flags,
     LLVMCompiler::ModuleHook pre_optimization_hook,
     LLVMCompiler::ModuleHook post_optimization_hook,
-    std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook) {
+    std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook,
+    PersistentCompilationCache* persistent_cache) {
   auto SSP = std::make_shared<llvm::orc::SymbolStringPool>();
   auto target_process_control =
       llvm::orc::SelfExecutorProcessControl::Create(std::move(SSP));
@@ -179,7 +184,8 @@ llvm::Expected<std::unique_ptr<SimpleOrcJIT>> SimpleOrcJIT::Create(
       std::move(*target_process_control), std::move(execution_session),
       target_options, opt_level, optimize_for_size, disable_expensive_passes,
       fast_math_flags, std::move(pre_optimization_hook),
-      std::move(post_optimization_hook), std::move(post_codegen_hook));
+      std::move(post_optimization_hook), std::move(post_codegen_hook),
+      persistent_cache);
 }
 
 llvm::JITEvaluatedSymbol SimpleOrcJIT::ResolveRuntimeSymbol(
@@ -225,6 +231,26 @@ llvm::Error SimpleOrcJIT::AddModule(llvm::orc::ThreadSafeModule module) {
   return compile_layer_.add(*main_jit_dylib_, std::move(module));
 }
 
+llvm::Error SimpleOrcJIT::AddModuleInParallel(
+    llvm::Module& module, int num_partitions,
+    tensorflow::thread::ThreadPool* thread_pool) {
+  auto& compiler = static_cast<CompilerFunctor&>(compile_layer_.getCompiler());
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> object_files =
+      compiler.CompileInParallel(
+          module, num_partitions,
+          [this]() {
+            return InferTargetMachineForJIT(target_options_, opt_level_);
+          },
+          thread_pool);
+  for (std::unique_ptr<llvm::MemoryBuffer>& object_file : object_files) {
+    if (llvm::Error err =
+            object_layer_.add(*main_jit_dylib_, std::move(object_file))) {
+      return err;
+    }
+  }
+  return llvm::Error::success();
+}
+
 void SimpleOrcJIT::DoneCompiling() {
   // The target machine takes a non-trivial amount of memory, so once we are
   // done compiling throw it away.
@@ -0,0 +1,74 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+class CpuParallelCodegenTest : public HloTestBase {
+ protected:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = HloTestBase::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_compilation_parallelism(4);
+    return debug_options;
+  }
+
+  // Returns a module whose entry calls `num_computations` computations of
+  // `num_ops` elementwise ops each, which is large enough to be split.
+  static std::string LargeModule(int num_computations, int num_ops) {
+    std::string hlo = "HloModule LargeModule\n";
+    for (int c = 0; c < num_computations; ++c) {
+      absl::StrAppend(&hlo, "\ncomputation", c, " {\n",
+                      "  x0 = f32[16] parameter(0)\n",
+                      "  half = f32[] constant(0.5)\n",
+                      "  halves = f32[16] broadcast(half), dimensions={}\n");
+      for (int i = 0; i < num_ops; ++i) {
+        absl::StrAppend(&hlo, "  y", i, " = f32[16] multiply(x", i,
+                        ", halves)\n", "  x", i + 1, " = f32[16] add(y", i,
+                        ", halves)\n");
+      }
+      absl::StrAppend(&hlo, "  ROOT r = f32[16] sine(x", num_ops, ")\n}\n");
+    }
+    absl::StrAppend(&hlo, "\nENTRY main {\n  p = f32[16] parameter(0)\n");
+    for (int c = 0; c < num_computations; ++c) {
+      absl::StrAppend(&hlo, "  c", c, " = f32[16] call(",
+                      c == 0 ? "p" : absl::StrCat("c", c - 1),
+                      "), to_apply=computation", c, "\n");
+    }
+    absl::StrAppend(&hlo, "  ROOT out = f32[16] copy(c", num_computations - 1,
+                    ")\n}\n");
+    return hlo;
+  }
+};
+
+TEST_F(CpuParallelCodegenTest, LargeModuleMatchesReference) {
+  // The calls are kept out of line by skipping the HLO passes, so the emitted
+  // module has a large function per computation.
+  EXPECT_TRUE(RunAndCompareNoHloPasses(LargeModule(8, 64), ErrorSpec{1e-5}));
+}
+
+TEST_F(CpuParallelCodegenTest, SmallModuleMatchesReference) {
+  EXPECT_TRUE(RunAndCompareNoHloPasses(LargeModule(2, 2), ErrorSpec{1e-5}));
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,90 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Tests that small GEMMs are emitted as shape specialized LLVM IR kernels
+// instead of calls to multi-threaded Eigen.
+
+#include "tensorflow/compiler/xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+class CpuSmallGemmTest : public CpuCodegenTest {
+ protected:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = CpuCodegenTest::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_multi_thread_eigen(true);
+    return debug_options;
+  }
+};
+
+TEST_F(CpuSmallGemmTest, SmallDotUsesTiledKernel) {
+  constexpr char hlo_text[] = R"(
+    HloModule SmallDot
+    ENTRY main {
+      lhs = f32[16,32] parameter(0)
+      rhs = f32[32,16] parameter(1)
+      ROOT dot = f32[16,16] dot(lhs, rhs), lhs_contracting_dims={1},
+                                           rhs_contracting_dims={0}
+    }
+  )";
+
+  CompileAndVerifyIr(hlo_text, R"(
+    CHECK-NOT: EigenMatMul
+    CHECK: gemm_F32_16x32x16
+  )");
+}
+
+TEST_F(CpuSmallGemmTest, SmallBatchDotSharesTiledKernel) {
+  constexpr char hlo_text[] = R"(
+    HloModule SmallBatchDot
+    ENTRY main {
+      lhs = f32[8,16,32] parameter(0)
+      rhs = f32[8,32,16] parameter(1)
+      ROOT dot = f32[8,16,16] dot(lhs, rhs), lhs_batch_dims={0},
+                                             lhs_contracting_dims={2},
+                                             rhs_batch_dims={0},
+                                             rhs_contracting_dims={1}
+    }
+  )";
+
+  CompileAndVerifyIr(hlo_text, R"(
+    CHECK-NOT: EigenMatMul
+    CHECK: define internal void @gemm_F32_16x32x16
+    CHECK-NOT: define internal void @gemm_F32_16x32x16
+  )");
+}
+
+TEST_F(CpuSmallGemmTest, LargerDotCallsEigen) {
+  constexpr char hlo_text[] = R"(
+    HloModule LargerDot
+    ENTRY main {
+      lhs = f32[32,128] parameter(0)
+      rhs = f32[128,128] parameter(1)
+      ROOT dot = f32[32,128] dot(lhs, rhs), lhs_contracting_dims={1},
+                                            rhs_contracting_dims={0}
+    }
+  )";
+
+  CompileAndVerifyIr(hlo_text, R"(
+    CHECK: call void @__xla_cpu_runtime_EigenMatMulF32
+  )");
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -42,6 +42,7 @@ TEST_F(CpuTopKTest, CallRuntimeUnbatched) {
 
   constexpr char filecheck_pattern[] = R"(
     CHECK: call void @__xla_cpu_runtime_TopKF32(i64 1, i64 100, i64 10,
+    CHECK-SAME: %run_options)
   )";
 
   CpuAotCompilationOptions options{
@@ -69,6 +70,7 @@ TEST_F(CpuTopKTest, CallRuntimeBatched) {
 
   constexpr char filecheck_pattern[] = R"(
     CHECK: call void @__xla_cpu_runtime_TopKF32(i64 5, i64 100, i64 10,
+    CHECK-SAME: %run_options)
   )";
 
   CpuAotCompilationOptions options{
@@ -0,0 +1,257 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/autotune_database.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/autotune_maps/autotune_serialize.h"
+#include "tensorflow/core/util/proto/proto_utils.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+std::string EntryKey(const AutotuneDatabaseEntry& entry) {
+  AutotuneDatabaseEntry key = entry;
+  key.clear_result();
+  std::string serialized;
+  CHECK(tensorflow::SerializeToStringDeterministic(key, &serialized));
+  return serialized;
+}
+
+// Returns true if `a` should be preferred over `b`. Failed results and results
+// without a run time, e.g. of GEMMs for which no algorithm could be picked,
+// are only preferred over each other.
+bool IsBetterResult(const tensorflow::AutotuneResult& a,
+                    const tensorflow::AutotuneResult& b) {
+  auto usable = [](const tensorflow::AutotuneResult& result) {
+    return !result.has_failure() && result.has_run_time();
+  };
+  if (!usable(a)) {
+    return false;
+  }
+  return !usable(b) ||
+         tensorflow::proto_utils::FromDurationProto(a.run_time()) <
+             tensorflow::proto_utils::FromDurationProto(b.run_time());
+}
+
+}  // namespace
+
+AutotuneDatabase::AutotuneDatabase(std::string path, tensorflow::Env* env)
+    : path_(std::move(path)), env_(env) {}
+
+/*static*/ AutotuneDatabase* AutotuneDatabase::Get(
+    const DebugOptions& debug_options) {
+  const std::string& path = debug_options.xla_gpu_autotune_database_path();
+  if (path.empty()) {
+    return nullptr;
+  }
+  static tensorflow::mutex mu(tensorflow::LINKER_INITIALIZED);
+  static auto* databases =
+      new absl::flat_hash_map<std::string, std::unique_ptr<AutotuneDatabase>>();
+  tensorflow::mutex_lock lock(mu);
+  std::unique_ptr<AutotuneDatabase>& database = (*databases)[path];
+  if (database == nullptr) {
+    database = std::make_unique<AutotuneDatabase>(path);
+    Status status = database->Load();
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to load the autotune database " << path << ": "
+                   << status;
+    } else {
+      VLOG(1) << "Loaded " << database->size() << " autotuning results from "
+              << path;
+    }
+  }
+  return database.get();
+}
+
+/*static*/ AutotuneDatabaseEntry AutotuneDatabase::DeviceEntry(
+    se::StreamExecutor* stream_executor) {
+  AutotuneDatabaseEntry entry;
+  const se::DeviceDescription& description =
+      stream_executor->GetDeviceDescription();
+  entry.set_device(description.name());
+  entry.set_driver_version(description.driver_version());
+  se::CudaComputeCapability cc = description.cuda_compute_capability();
+  entry.mutable_cc()->set_major(cc.major);
+  entry.mutable_cc()->set_minor(cc.minor);
+  if (auto* dnn = stream_executor->AsDnn()) {
+    StatusOr<se::dnn::VersionInfo> version_or = dnn->GetVersion();
+    if (version_or.ok()) {
+      const se::dnn::VersionInfo& version = version_or.ValueOrDie();
+      entry.mutable_cudnn_version()->set_major(version.major_version());
+      entry.mutable_cudnn_version()->set_minor(version.minor_version());
+      entry.mutable_cudnn_version()->set_patch(version.patch());
+    }
+  }
+  if (auto* blas = stream_executor->AsBlas()) {
+    std::string blas_version;
+    if (blas->GetVersion(&blas_version).ok()) {
+      entry.set_blas_version(blas_version);
+    }
+  }
+  return entry;
+}
+
+absl::optional<tensorflow::AutotuneResult> AutotuneDatabase::Lookup(
+    const AutotuneDatabaseEntry& device, const std::string& hlo) const {
+  AutotuneDatabaseEntry key = device;
+  key.set_hlo(hlo);
+  tensorflow::mutex_lock lock(mu_);
+  auto it = entries_.find(EntryKey(key));
+  if (it == entries_.end()) {
+    return absl::nullopt;
+  }
+  return it->second.result();
+}
+
+void AutotuneDatabase::Insert(const AutotuneDatabaseEntry& device,
+                              const std::string& hlo,
+                              const tensorflow::AutotuneResult& result) {
+  AutotuneDatabaseEntry entry = device;
+  entry.set_hlo(hlo);
+  *entry.mutable_result() = result;
+  tensorflow::mutex_lock lock(mu_);
+  if (MergeEntry(entry)) {
+    dirty_ = true;
+  }
+}
+
+void AutotuneDatabase::Merge(const AutotuneDatabaseProto& proto) {
+  tensorflow::mutex_lock lock(mu_);
+  for (const AutotuneDatabaseEntry& entry : proto.entries()) {
+    if (MergeEntry(entry)) {
+      dirty_ = true;
+    }
+  }
+}
+
+bool AutotuneDatabase::MergeEntry(const AutotuneDatabaseEntry& entry) {
+  auto inserted = entries_.emplace(EntryKey(entry), entry);
+  if (inserted.second) {
+    return true;
+  }
+  AutotuneDatabaseEntry& existing = inserted.first->second;
+  if (!IsBetterResult(entry.result(), existing.result())) {
+    return false;
+  }
+  *existing.mutable_result() = entry.result();
+  return true;
+}
+
+AutotuneDatabaseProto AutotuneDatabase::ToProto() const {
+  tensorflow::mutex_lock lock(mu_);
+  std::vector<const std::pair<const std::string, AutotuneDatabaseEntry>*>
+      sorted;
+  sorted.reserve(entries_.size());
+  for (const auto& entry : entries_) {
+    sorted.push_back(&entry);
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const auto* a, const auto* b) { return a->first < b->first; });
+  AutotuneDatabaseProto proto;
+  for (const auto* entry : sorted) {
+    *proto.add_entries() = entry->second;
+  }
+  return proto;
+}
+
+Status AutotuneDatabase::Load() {
+  tensorflow::mutex_lock lock(mu_);
+  return LoadLocked();
+}
+
+Status AutotuneDatabase::LoadLocked() {
+  std::string contents;
+  Status status = tensorflow::ReadFileToString(env_, path_, &contents);
+  if (tensorflow::errors::IsNotFound(status)) {
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(status);
+  AutotuneDatabaseProto proto;
+  if (!proto.ParseFromString(contents)) {
+    return tensorflow::errors::DataLoss("Failed to parse autotune database ",
+                                        path_);
+  }
+  for (const AutotuneDatabaseEntry& entry : proto.entries()) {
+    MergeEntry(entry);
+  }
+  if (!proto.tf_autotune_maps().empty()) {
+    // The maps of another version of TF are rejected, which must not prevent
+    // XLA from using its own entries.
+    status = tensorflow::LoadSerializedAutotuneMaps(proto.tf_autotune_maps());
+    if (!status.ok()) {
+      LOG(WARNING) << "Ignoring the TF autotune maps of " << path_ << ": "
+                   << status;
+    }
+  }
+  return Status::OK();
+}
+
+Status AutotuneDatabase::Save() {
+  {
+    tensorflow::mutex_lock lock(mu_);
+    if (!dirty_) {
+      return Status::OK();
+    }
+    TF_RETURN_IF_ERROR(LoadLocked());
+    dirty_ = false;
+  }
+  Status status = WriteToFile(ToProto());
+  if (!status.ok()) {
+    tensorflow::mutex_lock lock(mu_);
+    dirty_ = true;
+  }
+  return status;
+}
+
+Status AutotuneDatabase::WriteToFile(AutotuneDatabaseProto proto) const {
+  TF_RETURN_IF_ERROR(
+      tensorflow::SerializeAutotuneMaps(proto.mutable_tf_autotune_maps()));
+  std::string contents;
+  CHECK(tensorflow::SerializeToStringDeterministic(proto, &contents));
+
+  // Write to a file that no other process uses and rename it into place, so
+  // that readers only ever see complete databases.
+  std::string tmp_path = path_;
+  if (!env_->CreateUniqueFileName(&tmp_path, ".tmp")) {
+    return tensorflow::errors::Internal(
+        "Failed to create a unique file name for ", path_);
+  }
+  TF_RETURN_IF_ERROR(tensorflow::WriteStringToFile(env_, tmp_path, contents));
+  Status status = env_->RenameFile(tmp_path, path_);
+  if (!status.ok()) {
+    env_->DeleteFile(tmp_path).IgnoreError();
+    return status;
+  }
+  VLOG(1) << "Saved " << proto.entries_size() << " autotuning results to "
+          << path_;
+  return Status::OK();
+}
+
+int64_t AutotuneDatabase::size() const {
+  tensorflow::mutex_lock lock(mu_);
+  return entries_.size();
+}
+
+}  // namespace gpu
+}  // namespace xla
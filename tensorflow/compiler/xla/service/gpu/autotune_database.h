@@ -0,0 +1,113 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_DATABASE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_DATABASE_H_
+
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_autotuning.pb.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/xla.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/autotuning.pb.h"
+
+namespace xla {
+namespace gpu {
+
+// Autotuning results of GEMMs and convolutions stored in a file, so that
+// jobs running on the same kind of GPU don't autotune the same instructions
+// again.
+//
+// Results are keyed by the model of the device, the versions of the driver,
+// cuDNN and cuBLAS, and the canonical text of the instruction. The file is a
+// binary AutotuneDatabaseProto. Get() loads it on first use, and Save() merges
+// the new entries into it. When two databases have results for the same key,
+// e.g. after autotuning on the same GPU in different jobs, the faster result
+// is kept.
+//
+// The file also carries the autotune maps of the convolution kernels of TF
+// (see tensorflow/core/util/autotune_maps), which are loaded into the TF
+// runtime with the database and serialized from it when it is saved, so that
+// a single file serves both the XLA and the TF kernels of a program.
+class AutotuneDatabase {
+ public:
+  explicit AutotuneDatabase(std::string path,
+                            tensorflow::Env* env = tensorflow::Env::Default());
+
+  AutotuneDatabase(const AutotuneDatabase&) = delete;
+  AutotuneDatabase& operator=(const AutotuneDatabase&) = delete;
+
+  // Returns the database that xla_gpu_autotune_database_path points to, which
+  // is loaded on first use, or nullptr if the flag is empty.
+  static AutotuneDatabase* Get(const DebugOptions& debug_options);
+
+  // Returns an entry with the device and library versions of
+  // `stream_executor`, which Lookup and Insert use as part of their key.
+  static AutotuneDatabaseEntry DeviceEntry(
+      se::StreamExecutor* stream_executor);
+
+  // Returns the result for `hlo` on the device of `device`, if any.
+  absl::optional<tensorflow::AutotuneResult> Lookup(
+      const AutotuneDatabaseEntry& device, const std::string& hlo) const;
+
+  // Adds the result for `hlo` on the device of `device`. It is written to the
+  // file by the next call to Save.
+  void Insert(const AutotuneDatabaseEntry& device, const std::string& hlo,
+              const tensorflow::AutotuneResult& result);
+
+  // Merges the entries of `proto` into the database.
+  void Merge(const AutotuneDatabaseProto& proto);
+
+  // Returns the entries of the database, sorted by key.
+  AutotuneDatabaseProto ToProto() const;
+
+  // Merges the entries of the file into the database. A missing file is an
+  // empty database.
+  Status Load();
+
+  // Writes the database to the file if entries were added since it was last
+  // loaded or saved. The file is read again first, so that the entries that
+  // other processes saved in the meantime are kept.
+  Status Save();
+
+  int64_t size() const;
+
+ private:
+  // Merges `entry` into entries_, returns true if this changed the database.
+  bool MergeEntry(const AutotuneDatabaseEntry& entry)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status LoadLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status WriteToFile(AutotuneDatabaseProto proto) const;
+
+  const std::string path_;
+  tensorflow::Env* const env_;
+
+  mutable tensorflow::mutex mu_;
+  // Entries keyed by their serialized device and instruction fields.
+  absl::flat_hash_map<std::string, AutotuneDatabaseEntry> entries_
+      TF_GUARDED_BY(mu_);
+  bool dirty_ TF_GUARDED_BY(mu_) = false;
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_DATABASE_H_
@@ -0,0 +1,159 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/autotune_database.h"
+
+#include <string>
+
+#include "absl/time/time.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/util/proto/proto_utils.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+using tensorflow::AutotuneResult;
+
+class AutotuneDatabaseTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tensorflow::Env* env = tensorflow::Env::Default();
+    std::string dir;
+    ASSERT_TRUE(env->LocalTempFilename(&dir));
+    TF_ASSERT_OK(env->RecursivelyCreateDir(dir));
+    path_ = tensorflow::io::JoinPath(dir, "autotune.pb");
+  }
+
+  static AutotuneDatabaseEntry Device(const std::string& name) {
+    AutotuneDatabaseEntry device;
+    device.set_device(name);
+    device.mutable_cc()->set_major(7);
+    device.mutable_cudnn_version()->set_major(8);
+    device.set_blas_version("11402");
+    return device;
+  }
+
+  static AutotuneResult GemmResult(int64_t algorithm, int64_t run_time_us) {
+    AutotuneResult result;
+    result.mutable_gemm()->set_algorithm(algorithm);
+    *result.mutable_run_time() = tensorflow::proto_utils::ToDurationProto(
+        absl::Microseconds(run_time_us));
+    return result;
+  }
+
+  std::string path_;
+};
+
+TEST_F(AutotuneDatabaseTest, KeyedByDeviceAndInstruction) {
+  AutotuneDatabase database(path_);
+  database.Insert(Device("V100"), "dot.1", GemmResult(3, 10));
+
+  absl::optional<AutotuneResult> result =
+      database.Lookup(Device("V100"), "dot.1");
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->gemm().algorithm(), 3);
+  EXPECT_FALSE(database.Lookup(Device("A100"), "dot.1").has_value());
+  EXPECT_FALSE(database.Lookup(Device("V100"), "dot.2").has_value());
+
+  AutotuneDatabaseEntry other_cudnn = Device("V100");
+  other_cudnn.mutable_cudnn_version()->set_minor(1);
+  EXPECT_FALSE(database.Lookup(other_cudnn, "dot.1").has_value());
+}
+
+TEST_F(AutotuneDatabaseTest, SaveAndLoad) {
+  AutotuneDatabase database(path_);
+  database.Insert(Device("V100"), "dot.1", GemmResult(3, 10));
+  database.Insert(Device("V100"), "dot.2", GemmResult(5, 10));
+  TF_ASSERT_OK(database.Save());
+
+  // Another process sees the same entries.
+  AutotuneDatabase other(path_);
+  TF_ASSERT_OK(other.Load());
+  EXPECT_EQ(other.size(), 2);
+  absl::optional<AutotuneResult> result = other.Lookup(Device("V100"), "dot.2");
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->gemm().algorithm(), 5);
+}
+
+TEST_F(AutotuneDatabaseTest, MissingFileIsEmpty) {
+  AutotuneDatabase database(path_);
+  TF_ASSERT_OK(database.Load());
+  EXPECT_EQ(database.size(), 0);
+}
+
+TEST_F(AutotuneDatabaseTest, CorruptedFileIsNotOverwritten) {
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(),
+                                             path_, "not a proto"));
+  AutotuneDatabase database(path_);
+  EXPECT_FALSE(database.Load().ok());
+  database.Insert(Device("V100"), "dot.1", GemmResult(3, 10));
+  EXPECT_FALSE(database.Save().ok());
+
+  std::string contents;
+  TF_ASSERT_OK(tensorflow::ReadFileToString(tensorflow::Env::Default(), path_,
+                                            &contents));
+  EXPECT_EQ(contents, "not a proto");
+}
+
+TEST_F(AutotuneDatabaseTest, SaveKeepsEntriesOfOtherProcesses) {
+  AutotuneDatabase first(path_);
+  AutotuneDatabase second(path_);
+  first.Insert(Device("V100"), "dot.1", GemmResult(3, 10));
+  second.Insert(Device("V100"), "dot.2", GemmResult(5, 10));
+  TF_ASSERT_OK(first.Save());
+  TF_ASSERT_OK(second.Save());
+
+  AutotuneDatabase merged(path_);
+  TF_ASSERT_OK(merged.Load());
+  EXPECT_EQ(merged.size(), 2);
+}
+
+TEST_F(AutotuneDatabaseTest, MergeKeepsFasterResult) {
+  AutotuneDatabase database(path_);
+  database.Insert(Device("V100"), "dot.1", GemmResult(3, 20));
+  database.Insert(Device("V100"), "dot.2", GemmResult(5, 10));
+
+  AutotuneDatabase other(path_);
+  other.Insert(Device("V100"), "dot.1", GemmResult(4, 10));
+  other.Insert(Device("V100"), "dot.2", GemmResult(6, 20));
+  AutotuneResult failed = GemmResult(7, 1);
+  failed.mutable_failure()->set_kind(AutotuneResult::WRONG_RESULT);
+  other.Insert(Device("V100"), "dot.3", GemmResult(8, 30));
+  database.Merge(other.ToProto());
+  database.Insert(Device("V100"), "dot.3", failed);
+
+  EXPECT_EQ(database.size(), 3);
+  EXPECT_EQ(database.Lookup(Device("V100"), "dot.1")->gemm().algorithm(), 4);
+  EXPECT_EQ(database.Lookup(Device("V100"), "dot.2")->gemm().algorithm(), 5);
+  EXPECT_EQ(database.Lookup(Device("V100"), "dot.3")->gemm().algorithm(), 8);
+}
+
+TEST_F(AutotuneDatabaseTest, ToProtoIsDeterministic) {
+  AutotuneDatabase a(path_);
+  AutotuneDatabase b(path_);
+  a.Insert(Device("V100"), "dot.1", GemmResult(3, 10));
+  a.Insert(Device("A100"), "dot.2", GemmResult(5, 10));
+  b.Insert(Device("A100"), "dot.2", GemmResult(5, 10));
+  b.Insert(Device("V100"), "dot.1", GemmResult(3, 10));
+  EXPECT_EQ(a.ToProto().SerializeAsString(), b.ToProto().SerializeAsString());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <limits>
 
+#include "tensorflow/compiler/xla/service/gpu/autotune_database.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_comparator.h"
 #include "tensorflow/compiler/xla/service/gpu/gemm_thunk.h"
@@ -247,20 +248,47 @@ static StatusOr<absl::optional<se::blas::AlgorithmType>> DoGemmAutotune(
   cache_misses++;
   VLOG(4) << "Autotuning cache miss";
 
+  auto options = HloPrintOptions::Canonical();
+  options.set_print_backend_config(true);
+  const std::string canonical_hlo = instr->ToString(options);
+
+  AutotuneDatabase* database =
+      AutotuneDatabase::Get(instr->GetModule()->config().debug_options());
+  AutotuneDatabaseEntry device;
+  if (database != nullptr) {
+    device = AutotuneDatabase::DeviceEntry(stream->parent());
+    if (absl::optional<AutotuneResult> stored =
+            database->Lookup(device, canonical_hlo)) {
+      VLOG(4) << "Autotune database hit";
+      absl::optional<se::blas::AlgorithmType> result;
+      if (stored->has_gemm()) {
+        result = stored->gemm().algorithm();
+      }
+      CHECK(autotune_cache.emplace(key, result).second);
+      return result;
+    }
+  }
+
   // Make sure any previous activity on this executor is done. We don't want
   // other work still running on the GPU to interfere with autotuning.
   if (!stream->parent()->SynchronizeAllActivity()) {
-    auto options = HloPrintOptions::Canonical();
-    options.set_print_backend_config(true);
     return InternalError(
         "Failed to synchronize GPU for autotuning gemm instruction: %s",
-        instr->ToString(options));
+        canonical_hlo);
   }
 
   TF_ASSIGN_OR_RETURN(absl::optional<se::blas::AlgorithmType> result,
                       DoUncachedGemmAutotune(instr, stream, allocator));
 
   CHECK(autotune_cache.emplace(key, result).second);
+  if (database != nullptr) {
+    // An empty result records that the generic algorithm is used.
+    AutotuneResult stored;
+    if (result.has_value()) {
+      stored.mutable_gemm()->set_algorithm(*result);
+    }
+    database->Insert(device, canonical_hlo, stored);
+  }
   return result;
 }
 
@@ -317,6 +345,13 @@ StatusOr<bool> GemmAlgorithmPicker::Run(HloModule* module) {
         bool result, RunOnComputation(computation, stream_exec_, allocator_));
     changed |= result;
   }
+  if (AutotuneDatabase* database =
+          AutotuneDatabase::Get(module->config().debug_options())) {
+    Status status = database->Save();
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to save the autotune database: " << status;
+    }
+  }
   return changed;
 }
 
@@ -61,6 +61,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/bitcast_dtypes_expander.h"
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/call_inliner.h"
+#include "tensorflow/compiler/xla/service/collective_cost_model.h"
+#include "tensorflow/compiler/xla/service/collective_pipeliner.h"
 #include "tensorflow/compiler/xla/service/collectives_schedule_linearizer.h"
 #include "tensorflow/compiler/xla/service/comparison_expander.h"
 #include "tensorflow/compiler/xla/service/conditional_canonicalizer.h"
@@ -242,6 +244,50 @@ int64_t GetSizeOfShape(const Shape& shape, int pointer_size) {
   return ShapeUtil::ByteSizeOf(shape, pointer_size) + metadata_size;
 }
 
+// Returns the model the collective combiners estimate the time of collectives
+// with, if its latency and bandwidth are set.
+absl::optional<CollectiveCostModel> GetCollectiveCostModel(
+    const DebugOptions& debug_options, se::StreamExecutor* stream_exec) {
+  if (debug_options.xla_gpu_collective_latency_ns() <= 0 ||
+      debug_options.xla_gpu_collective_bandwidth_bytes_per_second() <= 0) {
+    return absl::nullopt;
+  }
+  CollectiveCostModel cost_model;
+  cost_model.latency_seconds =
+      debug_options.xla_gpu_collective_latency_ns() * 1e-9;
+  cost_model.seconds_per_byte =
+      1.0 / debug_options.xla_gpu_collective_bandwidth_bytes_per_second();
+  const se::DeviceDescription& description =
+      stream_exec->GetDeviceDescription();
+  if (description.memory_bandwidth() > 0) {
+    cost_model.bytes_per_second = description.memory_bandwidth();
+  }
+  if (description.core_count() > 0 && description.clock_rate_ghz() > 0) {
+    // 64 FP32 lanes per SM doing one FMA per cycle.
+    cost_model.flops_per_second =
+        description.core_count() * description.clock_rate_ghz() * 1e9 * 64 * 2;
+  }
+  return cost_model;
+}
+
+// Returns the model horizontal loop fusion estimates the time of kernels
+// with, if their launch overhead is set.
+absl::optional<HorizontalFusionCostModel> GetHorizontalFusionCostModel(
+    const DebugOptions& debug_options, se::StreamExecutor* stream_exec) {
+  if (debug_options.xla_gpu_kernel_launch_overhead_ns() <= 0) {
+    return absl::nullopt;
+  }
+  HorizontalFusionCostModel cost_model;
+  cost_model.launch_overhead_seconds =
+      debug_options.xla_gpu_kernel_launch_overhead_ns() * 1e-9;
+  const se::DeviceDescription& description =
+      stream_exec->GetDeviceDescription();
+  if (description.memory_bandwidth() > 0) {
+    cost_model.bytes_per_second = description.memory_bandwidth();
+  }
+  return cost_model;
+}
+
 }  // end anonymous namespace
 
 using OwnedThunkSchedule = GpuExecutable::OwnedThunkSchedule;
@@ -528,7 +574,8 @@ Status GpuCompiler::OptimizeHloModule(
 
   {
     HloPassFix<HloPassPipeline> horizontal_fusion("horizontal fusion");
-    horizontal_fusion.AddPass<GpuHorizontalLoopFusion>();
+    horizontal_fusion.AddPass<GpuHorizontalLoopFusion>(
+        GetHorizontalFusionCostModel(debug_options, stream_exec));
     horizontal_fusion.AddPass<GpuHorizontalInputFusion>();
     // FusionBitcastLift must be after InstructionFusion, as it undoes
     // part of it.
@@ -541,12 +588,20 @@ Status GpuCompiler::OptimizeHloModule(
 
   {
     HloPassPipeline pipeline("post-fusion optimization");
+    if (debug_options.xla_gpu_collective_pipelining_depth() > 0) {
+      pipeline.AddPass<CollectivePipeliner>(
+          debug_options.xla_gpu_collective_pipelining_depth(),
+          debug_options.xla_gpu_collective_pipelining_memory_limit_bytes());
+      pipeline.AddPass<HloDCE>();
+    }
+    absl::optional<CollectiveCostModel> collective_cost_model =
+        GetCollectiveCostModel(debug_options, stream_exec);
     pipeline.AddPass<AllGatherCombiner>(
         /*combine_threshold_in_bytes=*/1024 * 1024 * 1024,
-        /*combine_threshold_count=*/256);
+        /*combine_threshold_count=*/256, collective_cost_model);
     pipeline.AddPass<AllReduceCombiner>(
         debug_options.xla_gpu_all_reduce_combine_threshold_bytes(),
-        /*combine_threshold_count=*/256);
+        /*combine_threshold_count=*/256, collective_cost_model);
     pipeline.AddPass<ReduceScatterCombiner>(
         /*combine_threshold_in_bytes=*/30 * 1024 * 1024,
         /*combine_threshold_count=*/256);
@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/gpu/autotune_database.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/convolution_thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_asm_opts_util.h"
@@ -280,6 +281,20 @@ StatusOr<AutotuneResult> GpuConvAlgorithmPicker::PickBestAlgorithm(
     autotune_cache_stats.cache_misses++;
   }
 
+  AutotuneDatabase* database = AutotuneDatabase::Get(
+      instr->GetModule()->config().debug_options());
+  AutotuneDatabaseEntry device;
+  if (database != nullptr) {
+    device = AutotuneDatabase::DeviceEntry(stream_exec_);
+    if (absl::optional<AutotuneResult> stored =
+            database->Lookup(device, std::get<1>(key))) {
+      VLOG(4) << "Autotune database hit";
+      tensorflow::mutex_lock lock(autotune_cache_lock);
+      CHECK(autotune_cache.insert({key, *stored}).second);
+      return *stored;
+    }
+  }
+
   // Make sure any previous activity on this executor is done. We don't want
   // other work still running on the GPU to interfere with autotuning.
   if (!stream_exec_->SynchronizeAllActivity()) {
@@ -316,6 +331,9 @@ StatusOr<AutotuneResult> GpuConvAlgorithmPicker::PickBestAlgorithm(
   if (result_or.ok()) {
     tensorflow::mutex_lock lock(autotune_cache_lock);
     CHECK(autotune_cache.insert({key, result_or.ValueOrDie()}).second);
+    if (database != nullptr) {
+      database->Insert(device, std::get<1>(key), result_or.ValueOrDie());
+    }
   }
   return result_or;
 }
@@ -811,6 +829,14 @@ StatusOr<bool> GpuConvAlgorithmPicker::Run(HloModule* module) {
     autotune_cache_stats.LogStats();
   }
 
+  if (AutotuneDatabase* database =
+          AutotuneDatabase::Get(module->config().debug_options())) {
+    Status status = database->Save();
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to save the autotune database: " << status;
+    }
+  }
+
   return changed;
 }
 
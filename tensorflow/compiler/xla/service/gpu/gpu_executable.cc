@@ -119,6 +119,16 @@ GpuExecutable::GpuExecutable(GpuExecutable::Params params)
   XlaDebugInfoManager::Get()->RegisterModule(
       ModuleUniqueName(module_name_, shared_module().get()), shared_module(),
       debug_buffer_assignment_);
+  if (has_module() &&
+      module().config().debug_options().xla_gpu_enable_cuda_graphs()) {
+    if (auto* thunk_schedule =
+            absl::get_if<OwnedThunkSchedule>(&thunks_or_bef_)) {
+      if (ThunkGraphCache::IsSupported(**thunk_schedule)) {
+        thunk_graph_cache_ =
+            absl::make_unique<ThunkGraphCache>(**thunk_schedule);
+      }
+    }
+  }
 }
 
 GpuExecutable::~GpuExecutable() {
@@ -178,7 +188,8 @@ Status ExecuteThunks(const std::string& module_name,
                      const ThunkSchedule& thunk_schedule,
                      const ServiceExecutableRunOptions* run_options,
                      const BufferAllocations& buffer_allocations,
-                     bool block_host_until_done) {
+                     bool block_host_until_done,
+                     ThunkGraphCache* thunk_graph_cache) {
   XlaDebugInfoManager::Get()->OnModuleStart(module_name);
   auto cleanup = MakeCleanup(
       [&]() { XlaDebugInfoManager::Get()->OnModuleStop(module_name); });
@@ -207,9 +218,41 @@ Status ExecuteThunks(const std::string& module_name,
       [&] { return absl::StrCat(module_name, ":XLA GPU module"); },
       tensorflow::profiler::TraceMeLevel::kInfo);
 
+  const GpuExecutableRunOptions* gpu_options =
+      run_options->run_options().gpu_executable_run_options();
+  auto execute_params = [&](se::Stream* stream) {
+    return Thunk::ExecuteParams{
+        &buffer_allocations,
+        stream,
+        async_comms_stream.ok() ? async_comms_stream->get() : nullptr,
+        run_options->run_options().run_id(),
+        run_options->run_options().device_assignment(),
+        gpu_options && gpu_options->gpu_global_device_ids()
+            ? &*gpu_options->gpu_global_device_ids()
+            : nullptr,
+        gpu_options && gpu_options->nccl_unique_id_callback()
+            ? &gpu_options->nccl_unique_id_callback()
+            : nullptr};
+  };
+
   absl::flat_hash_map<const Thunk*, std::unique_ptr<se::Event>>
       thunk_to_finish_event;
-  for (const std::unique_ptr<Thunk>& thunk : thunk_schedule.TotalOrder()) {
+  const ThunkSequence& thunks = thunk_schedule.TotalOrder();
+  for (size_t i = 0; i < thunks.size(); ++i) {
+    // Replay the graph of the thunks starting at `i`, if any. Graphs are only
+    // used with a single stream and contain no cross-stream dependencies.
+    if (const ThunkGraphCache::Segment* segment =
+            thunk_graph_cache ? thunk_graph_cache->SegmentStartingAt(i)
+                              : nullptr) {
+      VLOG(2) << "Executing the graph of thunks [" << segment->begin << ", "
+              << segment->end << ")";
+      TF_RETURN_IF_ERROR(thunk_graph_cache->Execute(
+          *segment, thunks, execute_params(main_stream)));
+      i = segment->end - 1;
+      continue;
+    }
+    const std::unique_ptr<Thunk>& thunk = thunks[i];
+
     // Annotate execution of this op if tracing was enabled when we started
     // running this module.  If tracing is enabled *while* we're running the
     // module, we won't get any data, but that's probably an OK trade-off.
@@ -229,21 +272,7 @@ Status ExecuteThunks(const std::string& module_name,
     TF_RET_CHECK(async_comms_stream.ok() || !NeedsAsyncCommsStream(*thunk))
         << "`run_options` must have a stream borrower for async thunks.";
 
-    const GpuExecutableRunOptions* gpu_options =
-        run_options->run_options().gpu_executable_run_options();
-    Thunk::ExecuteParams thunk_params{
-        &buffer_allocations,
-        stream,
-        async_comms_stream.ok() ? async_comms_stream->get() : nullptr,
-        run_options->run_options().run_id(),
-        run_options->run_options().device_assignment(),
-        gpu_options && gpu_options->gpu_global_device_ids()
-            ? &*gpu_options->gpu_global_device_ids()
-            : nullptr,
-        gpu_options && gpu_options->nccl_unique_id_callback()
-            ? &gpu_options->nccl_unique_id_callback()
-            : nullptr};
-    TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(thunk_params));
+    TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(execute_params(stream)));
     if (thunk_schedule.Depended(thunk.get())) {
       auto finish_event = absl::make_unique<se::Event>(main_stream->parent());
       finish_event->Init();
@@ -812,7 +841,8 @@ Status GpuExecutable::ExecuteThunksOrBef(
   TF_RETURN_IF_ERROR(
       CheckCompatibilityWithServiceExecutableRunOptions(run_options));
   return ExecuteThunks(module_name_, thunk_schedule, run_options,
-                       buffer_allocations, block_host_until_done);
+                       buffer_allocations, block_host_until_done,
+                       thunk_graph_cache_.get());
 #endif  // BEF_EXECUTABLE
 }
 
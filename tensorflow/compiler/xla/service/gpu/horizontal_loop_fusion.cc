@@ -47,8 +47,10 @@ PrimitiveType GetUniqueOutputTypeOfFusible(const HloInstruction& fusible) {
 
 class HorizontalLoopFusionImpl {
  public:
-  explicit HorizontalLoopFusionImpl(HloComputation* computation)
-      : computation_(computation) {}
+  HorizontalLoopFusionImpl(
+      HloComputation* computation,
+      const absl::optional<HorizontalFusionCostModel>& cost_model)
+      : computation_(computation), cost_model_(cost_model) {}
 
   ~HorizontalLoopFusionImpl() {}
 
@@ -75,8 +77,10 @@ class HorizontalLoopFusionImpl {
   // acquire the next set of fusion candidates based on some heuristics.
   class FusionCandidates {
    public:
-    explicit FusionCandidates(HloInstruction* consumer)
-        : fusible_instrs_(), pos_(0) {
+    FusionCandidates(
+        HloInstruction* consumer,
+        const absl::optional<HorizontalFusionCostModel>& cost_model)
+        : fusible_instrs_(), pos_(0), cost_model_(cost_model) {
       Initialize(consumer);
     }
 
@@ -89,9 +93,11 @@ class HorizontalLoopFusionImpl {
     std::vector<HloInstruction*> fusible_instrs_;
     // `pos_` points to the start position of the next span.
     size_t pos_;
+    const absl::optional<HorizontalFusionCostModel>& cost_model_;
   };
 
   HloComputation* computation_;
+  const absl::optional<HorizontalFusionCostModel>& cost_model_;
 };  // HorizontalLoopFusionImpl
 
 bool IsFusibleCandidate(const HloInstruction& instr) {
@@ -130,8 +136,11 @@ bool IsFusibleCandidate(const HloInstruction& instr) {
 // instruction count in its fused computation. We roughly observe that if a
 // fusion instruction has shapes smaller than `kShapeThreshold` and has fewer
 // instructions than `kInstrCountThreshold`, it is launch-latency-bound and
-// profitable by horizontal fusion.
-bool IsProfitableFusionCandidate(const HloInstruction& instr) {
+// profitable by horizontal fusion. With a cost model, the instruction must
+// be launch-bound by the model instead of smaller than `kShapeThreshold`.
+bool IsProfitableFusionCandidate(
+    const HloInstruction& instr,
+    const absl::optional<HorizontalFusionCostModel>& cost_model) {
   constexpr int64_t kShapeThreshold = 128 * 2048;
   constexpr int64_t kInstrCountThreshold = 30;
   const HloInstruction* root = (instr.opcode() == HloOpcode::kFusion)
@@ -139,7 +148,11 @@ bool IsProfitableFusionCandidate(const HloInstruction& instr) {
                                    : &instr;
 
   // Too large shapes are not easily profitable.
-  if (root->opcode() == HloOpcode::kTuple) {
+  if (cost_model.has_value()) {
+    if (!cost_model->IsLaunchBound(instr)) {
+      return false;
+    }
+  } else if (root->opcode() == HloOpcode::kTuple) {
     // Since all output shapes are the same, use the first shape as the
     // representative.
     Shape shape = root->operand(0)->shape();
@@ -219,7 +232,7 @@ void HorizontalLoopFusionImpl::FusionCandidates::Initialize(
       VLOG(2) << "Reject maybe illegal instr " << instr->ToString()
               << "; including it may create cycles in HLO.";
       continue;
-    } else if (!IsProfitableFusionCandidate(*instr)) {
+    } else if (!IsProfitableFusionCandidate(*instr, cost_model_)) {
       VLOG(2) << "Reject may-not-be profitable fusion instr "
               << instr->ToString();
       continue;
@@ -268,13 +281,15 @@ HorizontalLoopFusionImpl::FusionCandidates::GetNextSpanOfFusions() {
   }
 
   // Fusing too many computations at a time may not be easily profitable and
-  // may increase compile time due to large kernels. Set a limit to it.
-  constexpr int64_t kMaxFusionBatchSize = 32;
+  // may increase compile time due to large kernels. Set a limit to it. With a
+  // cost model, the candidates are known to be launch-bound, so each one
+  // fused saves about a launch, and the limit only bounds compile time.
+  const int64_t max_fusion_batch_size = cost_model_.has_value() ? 256 : 32;
   // CUDA has a parameter size limit of ~4k bytes.
   constexpr int64_t kMaxCudaParamSize = 4000;
   size_t accum_io_size = 0;
   auto reach_max_fusion_batch_size = [&](size_t left, size_t right) -> bool {
-    if (right - left >= kMaxFusionBatchSize) {
+    if (right - left >= max_fusion_batch_size) {
       return true;
     }
 
@@ -303,12 +318,14 @@ HorizontalLoopFusionImpl::FusionCandidates::GetNextSpanOfFusions() {
                GetOutputSizeOfFusible(*fusible_instrs_[right])) {
       // Cannot fuse computations who have different numbers of outputs.
       break;
-    } else if (GetInstrCountOfFusible(*fusible_instrs_[left]) !=
-               GetInstrCountOfFusible(*fusible_instrs_[right])) {
+    } else if (!cost_model_.has_value() &&
+               GetInstrCountOfFusible(*fusible_instrs_[left]) !=
+                   GetInstrCountOfFusible(*fusible_instrs_[right])) {
       // Do not fuse computations of different instruction counts as it may
       // introduce control divergence. This is a very simple heuristic to avoid
       // fusing computations with too much discrepancy and we may improve it
-      // when the needs arise.
+      // when the needs arise. Launch-bound computations are fused regardless,
+      // since the divergence costs little compared to their launches.
       break;
     } else if (reach_max_fusion_batch_size(left, right)) {
       // Hit max fusion batch size.
@@ -490,7 +507,8 @@ StatusOr<bool> HorizontalLoopFusionImpl::Run() {
   absl::c_reverse(use_to_def_order);
   for (size_t i = 0; i < use_to_def_order.size(); ++i) {
     HloInstruction* consumer = use_to_def_order[i];
-    HorizontalLoopFusionImpl::FusionCandidates fusion_candidates(consumer);
+    HorizontalLoopFusionImpl::FusionCandidates fusion_candidates(consumer,
+                                                                 cost_model_);
     while (true) {
       auto fusibles = fusion_candidates.GetNextSpanOfFusions();
       if (fusibles.empty()) {
@@ -523,9 +541,27 @@ StatusOr<bool> HorizontalLoopFusionImpl::Run() {
 
 }  // namespace
 
+double HorizontalFusionCostModel::MemorySeconds(
+    const HloInstruction& instr) const {
+  int64_t bytes = 0;
+  auto add_bytes = [&](const Shape& shape) {
+    ShapeUtil::ForEachSubshape(
+        shape, [&](const Shape& subshape, const ShapeIndex& /*index*/) {
+          if (subshape.IsArray()) {
+            bytes += ShapeUtil::ByteSizeOf(subshape);
+          }
+        });
+  };
+  for (const HloInstruction* operand : instr.operands()) {
+    add_bytes(operand->shape());
+  }
+  add_bytes(instr.shape());
+  return bytes / bytes_per_second;
+}
+
 StatusOr<bool> GpuHorizontalLoopFusion::RunOnComputation(
     HloComputation* computation) {
-  HorizontalLoopFusionImpl horizontal_fusion_impl(computation);
+  HorizontalLoopFusionImpl horizontal_fusion_impl(computation, cost_model_);
   return horizontal_fusion_impl.Run();
 }
 
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HORIZONTAL_LOOP_FUSION_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HORIZONTAL_LOOP_FUSION_H_
 
+#include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
@@ -25,6 +26,21 @@ limitations under the License.
 namespace xla {
 namespace gpu {
 
+// A model of the run time of small kernels, as their launch overhead plus the
+// time they access their operands and outputs in memory.
+struct HorizontalFusionCostModel {
+  double launch_overhead_seconds = 5e-6;
+  double bytes_per_second = 1e11;
+
+  // Returns the time `instr` spends accessing memory, once launched.
+  double MemorySeconds(const HloInstruction& instr) const;
+
+  // Returns whether launching `instr` takes longer than running it.
+  bool IsLaunchBound(const HloInstruction& instr) const {
+    return MemorySeconds(instr) < launch_overhead_seconds;
+  }
+};
+
 // This optimization pass horizontally fuses computations for reducing kernel
 // launch overhead while increasing kernel launch dims on GPU. The initial
 // motivation of this horizontal fusion is due to the observation that the
@@ -94,9 +110,17 @@ namespace gpu {
 // output dims of the concatenate will be used as the kernel launch dims.
 // Instruction bitcasts can be used for Reshape2 and Reshape3 as long as the
 // outputs of Mul and Add are row-major.
+//
+// With `cost_model`, the fusion candidates are the launch-bound instructions
+// instead of those under fixed size limits, and as many of them are fused
+// into one kernel as the CUDA parameter space allows, regardless of their
+// instruction counts. The elements of the concatenate are spread evenly over
+// the blocks of the kernel, so its work is balanced by element count.
 class GpuHorizontalLoopFusion : public HloModulePass {
  public:
-  GpuHorizontalLoopFusion() {}
+  explicit GpuHorizontalLoopFusion(
+      absl::optional<HorizontalFusionCostModel> cost_model = absl::nullopt)
+      : cost_model_(cost_model) {}
 
   absl::string_view name() const override {
     return "gpu_horizontal_loop_fusion";
@@ -106,6 +130,8 @@ class GpuHorizontalLoopFusion : public HloModulePass {
 
  private:
   StatusOr<bool> RunOnComputation(HloComputation*);
+
+  absl::optional<HorizontalFusionCostModel> cost_model_;
 };
 
 }  // namespace gpu
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/horizontal_loop_fusion.h"
 
+#include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/xla/literal.h"
 #include "tensorflow/compiler/xla/service/gpu/fusion_merger.h"
 #include "tensorflow/compiler/xla/service/gpu/instruction_fusion.h"
@@ -586,6 +587,59 @@ TEST_F(HorizontalLoopFusionTest, TraversalOrder) {
   EXPECT_EQ(total_fusion_instrs, 2);
 }
 
+// Returns a module whose root tuple has `num_ops` negations of distinct
+// f32[`size`] parameters.
+std::string NegationsModule(int num_ops, int64_t size) {
+  std::string params, negations, results, shapes;
+  for (int i = 0; i < num_ops; ++i) {
+    absl::StrAppend(&params, "  p", i, " = f32[", size, "]{0} parameter(", i,
+                    ")\n");
+    absl::StrAppend(&negations, "  neg", i, " = f32[", size,
+                    "]{0} negate(p", i, ")\n");
+    absl::StrAppend(&results, i > 0 ? ", " : "", "neg", i);
+    absl::StrAppend(&shapes, i > 0 ? ", " : "", "f32[", size, "]{0}");
+  }
+  return absl::StrCat("HloModule Negations\n\nENTRY entry {\n", params,
+                      negations, "  ROOT tuple = (", shapes, ") tuple(",
+                      results, ")\n}\n");
+}
+
+int64_t CountFusions(const HloModule& module) {
+  return absl::c_count_if(module.entry_computation()->instructions(),
+                          [](const HloInstruction* instr) {
+                            return instr->opcode() == HloOpcode::kFusion;
+                          });
+}
+
+TEST_F(HorizontalLoopFusionTest, CostModelFusesManySmallKernels) {
+  auto module =
+      ParseAndReturnVerifiedModule(NegationsModule(40, 16)).ValueOrDie();
+  auto cost_driven_module = module->Clone();
+
+  // Without a cost model, at most 32 kernels are fused together.
+  EXPECT_TRUE(GpuHorizontalLoopFusion().Run(module.get()).ValueOrDie());
+  EXPECT_EQ(CountFusions(*module), 2);
+
+  EXPECT_TRUE(GpuHorizontalLoopFusion(HorizontalFusionCostModel())
+                  .Run(cost_driven_module.get())
+                  .ValueOrDie());
+  EXPECT_EQ(CountFusions(*cost_driven_module), 1);
+}
+
+TEST_F(HorizontalLoopFusionTest, CostModelSkipsKernelsThatAreNotLaunchBound) {
+  // Each negation accesses 1.6MB, which takes longer than a launch.
+  auto module =
+      ParseAndReturnVerifiedModule(NegationsModule(2, 200000)).ValueOrDie();
+  HorizontalFusionCostModel cost_model;
+  EXPECT_FALSE(cost_model.IsLaunchBound(
+      *module->entry_computation()->root_instruction()->operand(0)));
+  EXPECT_FALSE(
+      GpuHorizontalLoopFusion(cost_model).Run(module.get()).ValueOrDie());
+
+  // Without a cost model, they are under the size limit and fused.
+  EXPECT_TRUE(GpuHorizontalLoopFusion().Run(module.get()).ValueOrDie());
+}
+
 }  // namespace
 }  // namespace gpu
 }  // namespace xla
@@ -20,6 +20,9 @@ limitations under the License.
 #include <fstream>
 
 #include "absl/base/call_once.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Support/SourceMgr.h"
 #include "tensorflow/compiler/xla/service/algebraic_simplifier.h"
@@ -46,6 +49,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 #include "tensorflow/compiler/xla/service/hlo_verifier.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
+#include "tensorflow/compiler/xla/service/persistent_compilation_cache.h"
 #include "tensorflow/compiler/xla/service/tuple_simplifier.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/types.h"
@@ -389,13 +393,42 @@ std::vector<uint8> NVPTXCompiler::CompileGpuAsmOrGetCachedResult(
         if (relocatable) {
           ptxas_config.extra_flags.push_back("-c");
         }
-        StatusOr<std::vector<uint8>> maybe_cubin = se::CompileGpuAsm(
-            stream_exec->device_ordinal(), cache_ptx->c_str(), ptxas_config);
+        // Cubins outlive the process in the persistent cache, if there is
+        // one. Its key covers everything that ptxas is given.
+        PersistentCompilationCache* persistent_cache =
+            PersistentCompilationCache::Get(hlo_module_config.debug_options());
+        std::string persistent_key;
+        absl::optional<std::string> persisted_cubin;
+        if (persistent_cache != nullptr) {
+          persistent_key = absl::StrCat(
+              "ptxas;sm_", cc.major, cc.minor, ";",
+              ptxas_config.disable_gpuasm_optimizations, ";",
+              ptxas_config.preferred_cuda_dir, ";",
+              absl::StrJoin(ptxas_config.extra_flags, " "), ";", ptx);
+          persisted_cubin = persistent_cache->Lookup(persistent_key);
+        }
+        StatusOr<std::vector<uint8>> maybe_cubin =
+            persisted_cubin.has_value()
+                ? StatusOr<std::vector<uint8>>(std::vector<uint8>(
+                      persisted_cubin->begin(), persisted_cubin->end()))
+                : se::CompileGpuAsm(stream_exec->device_ordinal(),
+                                    cache_ptx->c_str(), ptxas_config);
 
         if (maybe_cubin.ok()) {
           cache_value->cubin_data = std::move(maybe_cubin).ValueOrDie();
           VLOG(2) << "Compiled PTX size:" << ptx.size()
                   << " CUBIN size: " << cache_value->cubin_data.size();
+          if (persistent_cache != nullptr && !persisted_cubin.has_value()) {
+            Status status = persistent_cache->Insert(
+                persistent_key,
+                absl::string_view(
+                    reinterpret_cast<const char*>(
+                        cache_value->cubin_data.data()),
+                    cache_value->cubin_data.size()));
+            if (!status.ok()) {
+              LOG(WARNING) << "Failed to persist cubin: " << status;
+            }
+          }
         } else {
           if (maybe_cubin.status().code() ==
               tensorflow::error::Code::NOT_FOUND) {
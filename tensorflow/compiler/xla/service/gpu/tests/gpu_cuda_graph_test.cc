@@ -0,0 +1,128 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/service/gpu/tests/gpu_codegen_test.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+class GpuCudaGraphTest : public GpuCodegenTest {
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = GpuCodegenTest::GetDebugOptionsForTest();
+    debug_options.set_xla_gpu_enable_cuda_graphs(true);
+    return debug_options;
+  }
+};
+
+// Several kernels in sequence, which are captured into a single graph.
+constexpr char kSoftmax[] = R"(
+HloModule softmax
+
+max {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT max = f32[] maximum(lhs, rhs)
+}
+
+add {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT add = f32[] add(lhs, rhs)
+}
+
+ENTRY main {
+  p = f32[64,128] parameter(0)
+  neg_inf = f32[] constant(-inf)
+  row_max = f32[64] reduce(p, neg_inf), dimensions={1}, to_apply=max
+  row_max_b = f32[64,128] broadcast(row_max), dimensions={0}
+  shifted = f32[64,128] subtract(p, row_max_b)
+  exp = f32[64,128] exponential(shifted)
+  zero = f32[] constant(0)
+  row_sum = f32[64] reduce(exp, zero), dimensions={1}, to_apply=add
+  row_sum_b = f32[64,128] broadcast(row_sum), dimensions={0}
+  ROOT softmax = f32[64,128] divide(exp, row_sum_b)
+}
+)";
+
+TEST_F(GpuCudaGraphTest, ReplaysGraphAcrossRuns) {
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(kSoftmax));
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Executable> executable,
+      test_runner_.CreateExecutable(module->Clone(), /*run_hlo_passes=*/true));
+
+  for (int run = 0; run < 4; ++run) {
+    Literal argument(ShapeUtil::MakeShape(F32, {64, 128}));
+    TF_ASSERT_OK(argument.Populate<float>([&](absl::Span<const int64_t> index) {
+      return std::sin(run + 0.1f * index[0] + 0.01f * index[1]);
+    }));
+    TF_ASSERT_OK_AND_ASSIGN(
+        Literal result,
+        test_runner_.ExecuteWithExecutable(executable.get(), {&argument}));
+    TF_ASSERT_OK_AND_ASSIGN(
+        Literal expected,
+        reference_runner_.Execute(module->Clone(), {&argument},
+                                  /*run_hlo_passes=*/true));
+    EXPECT_TRUE(LiteralTestUtil::Near(expected, result, ErrorSpec{1e-5, 1e-5}))
+        << "run " << run;
+  }
+}
+
+TEST_F(GpuCudaGraphTest, ExecutesControlFlowOutsideGraphs) {
+  constexpr char hlo_text[] = R"(
+HloModule while
+
+cond {
+  state = (s32[], f32[1024]) parameter(0)
+  i = s32[] get-tuple-element(state), index=0
+  limit = s32[] constant(5)
+  ROOT lt = pred[] compare(i, limit), direction=LT
+}
+
+body {
+  state = (s32[], f32[1024]) parameter(0)
+  i = s32[] get-tuple-element(state), index=0
+  x = f32[1024] get-tuple-element(state), index=1
+  one = s32[] constant(1)
+  next_i = s32[] add(i, one)
+  half = f32[] constant(0.5)
+  half_b = f32[1024] broadcast(half), dimensions={}
+  next_x = f32[1024] multiply(x, half_b)
+  ROOT next = (s32[], f32[1024]) tuple(next_i, next_x)
+}
+
+ENTRY main {
+  p = f32[1024] parameter(0)
+  e = f32[1024] exponential(p)
+  zero = s32[] constant(0)
+  init = (s32[], f32[1024]) tuple(zero, e)
+  loop = (s32[], f32[1024]) while(init), condition=cond, body=body
+  x = f32[1024] get-tuple-element(loop), index=1
+  ROOT out = f32[1024] sine(x)
+}
+)";
+  EXPECT_TRUE(RunAndCompare(hlo_text, ErrorSpec{1e-5, 1e-5}));
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,230 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/thunk_graph_cache.h"
+
+#include "absl/algorithm/container.h"
+#include "absl/memory/memory.h"
+#include "tensorflow/compiler/xla/service/gpu/buffer_allocations.h"
+#include "tensorflow/compiler/xla/service/gpu/sequential_thunk.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/logging.h"
+
+#if GOOGLE_CUDA
+#include "third_party/gpus/cuda/include/cuda.h"
+#include "tensorflow/stream_executor/cuda/cuda_driver.h"
+#include "tensorflow/stream_executor/gpu/gpu_executor.h"
+#include "tensorflow/stream_executor/gpu/gpu_stream.h"
+#endif  // GOOGLE_CUDA
+
+namespace xla {
+namespace gpu {
+
+#if GOOGLE_CUDA
+
+namespace {
+
+Status ToStatus(CUresult result, const char* call) {
+  if (result == CUDA_SUCCESS) {
+    return Status::OK();
+  }
+  const char* message = nullptr;
+  cuGetErrorString(result, &message);
+  return InternalError("%s failed: %s", call,
+                       message != nullptr ? message : "unknown error");
+}
+
+}  // namespace
+
+struct ThunkGraphCache::Graph {
+  ~Graph() {
+    if (exec != nullptr) {
+      se::gpu::ScopedActivateContext activation(context);
+      cuGraphExecDestroy(exec);
+    }
+  }
+
+  se::gpu::GpuContext* context = nullptr;
+  CUgraphExec exec = nullptr;
+  // The buffer addresses the graph was captured with.
+  std::vector<const void*> addresses;
+  // Set when the segment failed to be captured, it is then always executed
+  // directly.
+  bool disabled = false;
+};
+
+#else  // GOOGLE_CUDA
+
+struct ThunkGraphCache::Graph {};
+
+#endif  // GOOGLE_CUDA
+
+ThunkGraphCache::ThunkGraphCache(const ThunkSchedule& thunk_schedule) {
+  const ThunkSequence& thunks = thunk_schedule.TotalOrder();
+  auto can_capture = [&](const Thunk& thunk) {
+    // Cross-stream dependencies are recorded with events between thunks,
+    // which would have to be captured with them.
+    return IsCapturable(thunk) && !thunk_schedule.Depended(&thunk) &&
+           thunk_schedule.DependsOn(&thunk).empty();
+  };
+  size_t begin = 0;
+  while (begin < thunks.size()) {
+    if (!can_capture(*thunks[begin])) {
+      ++begin;
+      continue;
+    }
+    size_t end = begin + 1;
+    while (end < thunks.size() && can_capture(*thunks[end])) {
+      ++end;
+    }
+    if (end - begin >= kMinThunksPerSegment) {
+      segment_index_by_begin_[begin] = segments_.size();
+      segments_.push_back({begin, end});
+    }
+    begin = end;
+  }
+  VLOG(2) << "Executing " << segments_.size() << " segments of "
+          << thunks.size() << " thunks with graphs";
+}
+
+ThunkGraphCache::~ThunkGraphCache() = default;
+
+/*static*/ bool ThunkGraphCache::IsSupported(
+    const ThunkSchedule& thunk_schedule) {
+#if GOOGLE_CUDA
+  return thunk_schedule.StreamCount() == 1;
+#else
+  return false;
+#endif
+}
+
+/*static*/ bool ThunkGraphCache::IsCapturable(const Thunk& thunk) {
+  switch (thunk.kind()) {
+    case Thunk::kKernel:
+    case Thunk::kMemset32BitValue:
+    case Thunk::kMemzero:
+    case Thunk::kCopy:
+      return true;
+    case Thunk::kSequential:
+      return absl::c_all_of(
+          static_cast<const SequentialThunk&>(thunk).thunks(),
+          [](const std::unique_ptr<Thunk>& thunk) {
+            return IsCapturable(*thunk);
+          });
+    default:
+      // Library calls may allocate or synchronize with the host, and control
+      // flow reads predicates back to the host.
+      return false;
+  }
+}
+
+const ThunkGraphCache::Segment* ThunkGraphCache::SegmentStartingAt(
+    size_t index) const {
+  auto it = segment_index_by_begin_.find(index);
+  return it == segment_index_by_begin_.end() ? nullptr
+                                             : &segments_[it->second];
+}
+
+Status ThunkGraphCache::Execute(const Segment& segment,
+                                const ThunkSequence& thunks,
+                                const Thunk::ExecuteParams& params) {
+  auto execute_directly = [&]() -> Status {
+    for (size_t i = segment.begin; i < segment.end; ++i) {
+      TF_RETURN_IF_ERROR(thunks[i]->ExecuteOnStream(params));
+    }
+    return Status::OK();
+  };
+
+#if GOOGLE_CUDA
+  se::Stream* stream = params.stream;
+  const BufferAllocations& buffer_allocations = *params.buffer_allocations;
+  std::vector<const void*> addresses(buffer_allocations.size());
+  for (BufferAllocation::Index i = 0; i < addresses.size(); ++i) {
+    addresses[i] = buffer_allocations.GetDeviceAddress(i).opaque();
+  }
+
+  tensorflow::mutex_lock lock(mu_);
+  std::unique_ptr<Graph>& graph =
+      graphs_[{stream->parent()->device_ordinal(),
+               segment_index_by_begin_.at(segment.begin)}];
+  if (graph == nullptr) {
+    graph = absl::make_unique<Graph>();
+    graph->context =
+        se::gpu::ExtractGpuExecutor(stream->parent())->gpu_context();
+  }
+  if (graph->disabled) {
+    return execute_directly();
+  }
+
+  se::gpu::ScopedActivateContext activation(graph->context);
+  CUstream cu_stream = se::gpu::AsGpuStreamValue(stream);
+  if (graph->exec == nullptr || graph->addresses != addresses) {
+    // Capture the thunks into a new graph. Nothing is executed while the
+    // stream is capturing.
+    Status status = ToStatus(
+        cuStreamBeginCapture(cu_stream, CU_STREAM_CAPTURE_MODE_THREAD_LOCAL),
+        "cuStreamBeginCapture");
+    if (status.ok()) {
+      for (size_t i = segment.begin; i < segment.end && status.ok(); ++i) {
+        status = thunks[i]->ExecuteOnStream(params);
+      }
+      CUgraph cu_graph = nullptr;
+      Status end_status = ToStatus(cuStreamEndCapture(cu_stream, &cu_graph),
+                                   "cuStreamEndCapture");
+      if (status.ok()) status = end_status;
+
+      if (status.ok() && graph->exec != nullptr) {
+        // Only the buffer addresses changed, so the graph has the same
+        // topology and the executable graph can be updated in place.
+        CUgraphNode error_node;
+        CUgraphExecUpdateResult update_result;
+        if (cuGraphExecUpdate(graph->exec, cu_graph, &error_node,
+                              &update_result) != CUDA_SUCCESS) {
+          VLOG(2) << "Failed to update graph, instantiating it again: "
+                  << update_result;
+          cuGraphExecDestroy(graph->exec);
+          graph->exec = nullptr;
+        }
+      }
+      if (status.ok() && graph->exec == nullptr) {
+        status = ToStatus(
+            cuGraphInstantiate(&graph->exec, cu_graph, nullptr, nullptr, 0),
+            "cuGraphInstantiate");
+      }
+      if (cu_graph != nullptr) {
+        cuGraphDestroy(cu_graph);
+      }
+    }
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to capture thunks [" << segment.begin << ", "
+                   << segment.end << ") into a graph, executing them "
+                   << "directly: " << status;
+      if (graph->exec != nullptr) {
+        cuGraphExecDestroy(graph->exec);
+        graph->exec = nullptr;
+      }
+      graph->disabled = true;
+      return execute_directly();
+    }
+    graph->addresses = std::move(addresses);
+  }
+  return ToStatus(cuGraphLaunch(graph->exec, cu_stream), "cuGraphLaunch");
+#else   // GOOGLE_CUDA
+  return execute_directly();
+#endif  // GOOGLE_CUDA
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,98 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_THUNK_GRAPH_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_THUNK_GRAPH_CACHE_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/compiler/xla/service/gpu/thunk.h"
+#include "tensorflow/compiler/xla/service/gpu/thunk_schedule.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace xla {
+namespace gpu {
+
+// Executes the thunks of a ThunkSchedule by replaying CUDA graphs, which
+// launches all the kernels of a graph with a single call instead of one call
+// per kernel.
+//
+// The total order of the schedule is split into segments of consecutive
+// thunks that only enqueue device work on their stream (kernels, memsets and
+// device to device copies). The first time a segment is executed with a given
+// set of buffer addresses, its thunks are captured into a graph instead of
+// being executed, and the graph is launched. Later executions with the same
+// addresses launch the graph again. When the addresses change, the segment is
+// captured again and the executable graph is updated in place, which is much
+// cheaper than instantiating a new one. The thunks between segments, e.g.
+// host callbacks, conditionals and loops, are executed as usual.
+//
+// Graphs are only used for schedules with a single stream, and only with
+// CUDA; IsSupported returns false otherwise.
+class ThunkGraphCache {
+ public:
+  // A range [begin, end) of the total order of the schedule.
+  struct Segment {
+    size_t begin;
+    size_t end;
+  };
+
+  explicit ThunkGraphCache(const ThunkSchedule& thunk_schedule);
+  ~ThunkGraphCache();
+
+  ThunkGraphCache(const ThunkGraphCache&) = delete;
+  ThunkGraphCache& operator=(const ThunkGraphCache&) = delete;
+
+  // Returns true if the thunks of `thunk_schedule` can be executed through
+  // graphs.
+  static bool IsSupported(const ThunkSchedule& thunk_schedule);
+
+  // Returns true if `thunk` only enqueues work on its stream that can be
+  // captured into a graph.
+  static bool IsCapturable(const Thunk& thunk);
+
+  // Returns the segment that begins with the thunk at `index` in the total
+  // order, or nullptr if that thunk does not begin a segment.
+  const Segment* SegmentStartingAt(size_t index) const;
+
+  // Executes the thunks of `segment` on `params.stream`.
+  Status Execute(const Segment& segment, const ThunkSequence& thunks,
+                 const Thunk::ExecuteParams& params);
+
+ private:
+  struct Graph;
+
+  // Segments with fewer thunks are executed directly, since replaying a graph
+  // does not save enough launches to amortize capturing it.
+  static constexpr size_t kMinThunksPerSegment = 2;
+
+  std::vector<Segment> segments_;
+  absl::flat_hash_map<size_t, size_t> segment_index_by_begin_;
+
+  tensorflow::mutex mu_;
+  // Graphs keyed by device ordinal and segment index.
+  absl::flat_hash_map<std::pair<int, size_t>, std::unique_ptr<Graph>> graphs_
+      TF_GUARDED_BY(mu_);
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_THUNK_GRAPH_CACHE_H_
@@ -20,12 +20,14 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/compiler/xla/map_util.h"
 #include "tensorflow/compiler/xla/service/hlo_live_range.h"
 #include "tensorflow/compiler/xla/service/hlo_schedule.h"
 #include "tensorflow/compiler/xla/service/memory_space_assignment_repacking.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 
 namespace xla {
 
@@ -519,16 +521,29 @@ template <typename BufferType>
 typename GlobalDecreasingSizeBestFitHeap<BufferType>::BufferIntervalCompare
 GlobalDecreasingSizeBestFitHeap<BufferType>::GetTemporalBufferIntervalCompare()
     const {
-  return [&](const BufferInterval& x, const BufferInterval& y) {
-    int64_t x_end = x.end;
-    for (auto colocation : GetTransitiveColocations(x)) {
-      x_end = std::max(x_end, buffer_intervals_.at(colocation).end);
-    }
-
-    int64_t y_end = y.end;
-    for (auto colocation : GetTransitiveColocations(y)) {
-      y_end = std::max(y_end, buffer_intervals_.at(colocation).end);
+  // Returns the latest free time of the interval and its transitive
+  // colocations. This runs in every comparison, so unlike
+  // GetTransitiveColocations it doesn't build a set: a buffer is only ever
+  // colocated with one other buffer, so none is visited twice.
+  auto colocations_end = [&](const BufferInterval& interval) {
+    int64_t end = interval.end;
+    absl::InlinedVector<const BufferInterval*, 4> worklist = {&interval};
+    while (!worklist.empty()) {
+      const BufferInterval* item = worklist.back();
+      worklist.pop_back();
+      for (const BufferType* buffer_colocated : item->colocations) {
+        const BufferInterval& colocation =
+            buffer_intervals_.at(buffer_colocated);
+        end = std::max(end, colocation.end);
+        worklist.push_back(&colocation);
+      }
     }
+    return end;
+  };
+  return [&, colocations_end](const BufferInterval& x,
+                              const BufferInterval& y) {
+    int64_t x_end = colocations_end(x);
+    int64_t y_end = colocations_end(y);
 
     if (x_end - x.start != y_end - y.start) {
       return x_end - x.start > y_end - y.start;
@@ -625,12 +640,38 @@ void GlobalDecreasingSizeBestFitHeap<BufferType>::Free(const BufferType* buffer,
 
 using Chunk = HeapSimulator::Chunk;
 
+namespace {
+
+// Recomputes the `subtree_end` of `node` from its own end and its children.
+void UpdateSubtreeEnd(BufferIntervalTreeNode* node) {
+  node->subtree_end = node->end;
+  if (node->left != nullptr) {
+    node->subtree_end = std::max(node->subtree_end, node->left->subtree_end);
+  }
+  if (node->right != nullptr) {
+    node->subtree_end = std::max(node->subtree_end, node->right->subtree_end);
+  }
+}
+
+// The splitmix64 sequence, which is cheap and well distributed enough for
+// treap priorities.
+uint64_t NextPriority(uint64_t* state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+}  // namespace
+
 void BufferIntervalTree::Add(int64_t start, int64_t end, const Chunk& chunk) {
   node_storage_.emplace_back(BufferIntervalTreeNode{
       start, end, end, chunk,
-      /*left=*/nullptr, /*right=*/nullptr, /*parent=*/nullptr});
+      /*left=*/nullptr, /*right=*/nullptr, /*parent=*/nullptr,
+      /*priority=*/NextPriority(&priority_state_)});
+  BufferIntervalTreeNode* node = &node_storage_.back();
   if (root_ == nullptr) {
-    root_ = &node_storage_.back();
+    root_ = node;
     // This is root.
     return;
   }
@@ -640,145 +681,125 @@ void BufferIntervalTree::Add(int64_t start, int64_t end, const Chunk& chunk) {
     parent->subtree_end = std::max(parent->subtree_end, end);
     if (parent->start > start) {
       if (parent->left == nullptr) {
-        parent->left = &node_storage_.back();
-        node_storage_.back().parent = parent;
-        return;
+        parent->left = node;
+        break;
       }
       parent = parent->left;
     } else {
       if (parent->right == nullptr) {
-        parent->right = &node_storage_.back();
-        node_storage_.back().parent = parent;
-        return;
+        parent->right = node;
+        break;
       }
       parent = parent->right;
     }
   }
+  node->parent = parent;
+
+  // Restore the heap order of the priorities.
+  while (node->parent != nullptr && node->parent->priority < node->priority) {
+    RotateUp(node);
+  }
 }
 
-bool BufferIntervalTree::Remove(int64_t start, int64_t end,
-                                const Chunk& chunk) {
-  BufferIntervalTreeNode* to_delete = root_;
-  while (to_delete != nullptr) {
-    if (to_delete->start == start && to_delete->end == end &&
-        to_delete->chunk.offset == chunk.offset) {
-      break;
+void BufferIntervalTree::RotateUp(BufferIntervalTreeNode* node) {
+  // Turn:
+  //        parent                node
+  //        /    \               /    \
+  //     node     c    into     a    parent
+  //    /    \                       /    \
+  //   a      b                     b      c
+  //
+  // or the mirror image of it if node is the right child of parent.
+  BufferIntervalTreeNode* parent = node->parent;
+  BufferIntervalTreeNode* grandparent = parent->parent;
+  if (parent->left == node) {
+    parent->left = node->right;
+    if (node->right != nullptr) {
+      node->right->parent = parent;
     }
-    if (start < to_delete->start) {
-      to_delete = to_delete->left;
-    } else {
-      to_delete = to_delete->right;
+    node->right = parent;
+  } else {
+    parent->right = node->left;
+    if (node->left != nullptr) {
+      node->left->parent = parent;
     }
+    node->left = parent;
   }
-  if (to_delete == nullptr) {
-    // Nothing to delete.
-    return false;
+  parent->parent = node;
+  node->parent = grandparent;
+  if (grandparent == nullptr) {
+    root_ = node;
+  } else if (grandparent->left == parent) {
+    grandparent->left = node;
+  } else {
+    grandparent->right = node;
   }
-  // Found the node to be deleted, enter deletion sequence.
-
-  // Recursively traverse the parents of node and fix up the `subtree_end`
-  // invariant of a node. Recursive lambda need an explicit
-  // std::function declaration.
-  std::function<void(BufferIntervalTreeNode*)> fix_up =
-      [&](BufferIntervalTreeNode* node) {
-        if (node == nullptr) {
-          return;
-        }
-        node->subtree_end = node->end;
-        if (node->left) {
-          node->subtree_end =
-              std::max(node->subtree_end, node->left->subtree_end);
-        }
-        if (node->right) {
-          node->subtree_end =
-              std::max(node->subtree_end, node->right->subtree_end);
-        }
-        // Recursively go up.
-        fix_up(node->parent);
-      };
-
-  if (to_delete->right == nullptr) {
-    // to_delete has no right child, simply move up left child of to_delete if
-    // any.
-    //
-    // Turn:
-    //      parent
-    //       /
-    // to_delete
-    //  /      \
-    // left    nullptr
-    //
-    // Into:
-    //      parent
-    //      /
-    //    left
-    if (root_ == to_delete) {
-      // Deleting root is simply reseting root;
-      root_ = to_delete->left;
-      return true;
-    }
+  // The subtree of the grandparent still has the same nodes, so only the
+  // rotated nodes need to be updated.
+  UpdateSubtreeEnd(parent);
+  UpdateSubtreeEnd(node);
+}
 
-    if (to_delete == to_delete->parent->left) {
-      // to_delete is left child of parent.
-      to_delete->parent->left = to_delete->left;
+BufferIntervalTreeNode* BufferIntervalTree::Find(int64_t start, int64_t end,
+                                                 const Chunk& chunk) const {
+  // Rotations can move nodes with the same start to either side of each
+  // other, so both subtrees are searched when the starts are equal.
+  std::vector<BufferIntervalTreeNode*> visiting_stack;
+  if (root_ != nullptr) {
+    visiting_stack.push_back(root_);
+  }
+  while (!visiting_stack.empty()) {
+    BufferIntervalTreeNode* top = visiting_stack.back();
+    visiting_stack.pop_back();
+    if (top->start == start && top->end == end &&
+        top->chunk.offset == chunk.offset) {
+      return top;
     }
-    if (to_delete == to_delete->parent->right) {
-      // to_delete is right child of parent.
-      to_delete->parent->right = to_delete->left;
+    if (start <= top->start && top->left != nullptr) {
+      visiting_stack.push_back(top->left);
     }
-    // Rewire parent to the node being moved up.
-    if (to_delete->left) {
-      to_delete->left->parent = to_delete->parent;
+    if (start >= top->start && top->right != nullptr) {
+      visiting_stack.push_back(top->right);
     }
-    // Fix up starting from subroot.
-    fix_up(to_delete);
+  }
+  return nullptr;
+}
+
+bool BufferIntervalTree::Remove(int64_t start, int64_t end,
+                                const Chunk& chunk) {
+  BufferIntervalTreeNode* to_delete = Find(start, end, chunk);
+  if (to_delete == nullptr) {
+    // Nothing to delete.
+    return false;
+  }
+
+  // Rotate the node down until it has at most one child, keeping the heap
+  // order of the priorities of the other nodes.
+  while (to_delete->left != nullptr && to_delete->right != nullptr) {
+    RotateUp(to_delete->left->priority > to_delete->right->priority
+                 ? to_delete->left
+                 : to_delete->right);
+  }
+
+  // Replace the node by its only child, if any.
+  BufferIntervalTreeNode* child =
+      to_delete->left != nullptr ? to_delete->left : to_delete->right;
+  BufferIntervalTreeNode* parent = to_delete->parent;
+  if (child != nullptr) {
+    child->parent = parent;
+  }
+  if (parent == nullptr) {
+    root_ = child;
+  } else if (parent->left == to_delete) {
+    parent->left = child;
   } else {
-    // 1. Find left-most node of the right subtree, promote it to the position
-    // of to_delete.
-    BufferIntervalTreeNode* to_promote = to_delete->right;
-    while (to_promote->left != nullptr) {
-      // Go to left-most subtree.
-      to_promote = to_promote->left;
-    }
+    parent->right = child;
+  }
 
-    // 2. Copy the content of `to_promote` to `to_delete`.
-    to_delete->start = to_promote->start;
-    to_delete->end = to_promote->end;
-    // This is incorrect but we will fix this up later in the `fix_up`
-    // procedure.
-    to_delete->subtree_end = to_promote->subtree_end;
-    to_delete->chunk = to_promote->chunk;
-    auto to_promote_parent = to_promote->parent;
-    // 3. Move the right child of `to_promote` up if there is any.
-    //
-    // Turn
-    //
-    // to_delete
-    //         \
-    //        to_promote_parent
-    //         /
-    //    to_promote
-    //          \
-    //          right
-    // into
-    //
-    // to_promote
-    //         \
-    //         to_promote_parent
-    //         /
-    //      right
-    if (to_promote_parent->left == to_promote) {
-      to_promote_parent->left = to_promote->right;
-    } else {
-      to_promote_parent->right = to_promote->right;
-    }
-    if (to_promote->right) {
-      // Set correct parent.
-      to_promote->right->parent = to_promote_parent;
-    }
-    // 4. Recursive fix up the `subtree_end` starting from
-    // `to_promote_parent`.
-    fix_up(to_promote_parent);
+  // Fix up the `subtree_end` invariant of the ancestors.
+  for (BufferIntervalTreeNode* node = parent; node != nullptr;
+       node = node->parent) {
+    UpdateSubtreeEnd(node);
   }
   // Don't free the entry in node_storage_ until we free the entire tree.
   return true;
@@ -882,7 +903,8 @@ GlobalDecreasingSizeBestFitHeap<BufferType>::FindChunkCandidate(
   //   |+-a-+  +-------b-------+  +---c---+
   //   ----------------------------------------> time
   for (auto colocation : GetTransitiveColocations(buffer_interval)) {
-    auto colocation_interval = buffer_intervals_.at(colocation);
+    const BufferInterval& colocation_interval =
+        buffer_intervals_.at(colocation);
     auto colocation_overlapping = interval_tree_.ChunksOverlappingInTime(
         colocation_interval.start, colocation_interval.end);
     VLOG(1) << "  Alias size " << colocation_interval.size << ", start "
@@ -963,7 +985,7 @@ void GlobalDecreasingSizeBestFitHeap<BufferType>::CommitChunk(
                      chunk_candidate.chunk);
   for (auto colocation : GetTransitiveColocations(buffer_interval)) {
     AddToChunkMap(colocation, chunk_candidate.chunk);
-    auto colocation_interval = buffer_intervals_[colocation];
+    const BufferInterval& colocation_interval = buffer_intervals_[colocation];
     interval_tree_.Add(colocation_interval.start, colocation_interval.end,
                        chunk_candidate.chunk);
   }
@@ -1037,8 +1059,22 @@ ChooseBestHeapAlgorithm<BufferType>::Finish() {
   std::vector<Result> results(algorithms_.size());
   int64_t min_size = INT64_MAX;
   int min_size_index = -1;
+  if (thread_pool_ != nullptr && algorithms_.size() > 1) {
+    // The algorithms were given the same buffers, but don't share any state.
+    tensorflow::BlockingCounter counter(algorithms_.size());
+    for (int i = 0; i < algorithms_.size(); ++i) {
+      thread_pool_->Schedule([&, i] {
+        results[i] = algorithms_[i]->Finish();
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  } else {
+    for (int i = 0; i < algorithms_.size(); ++i) {
+      results[i] = algorithms_[i]->Finish();
+    }
+  }
   for (int i = 0; i < algorithms_.size(); ++i) {
-    results[i] = algorithms_[i]->Finish();
     if (results[i].heap_size < min_size) {
       min_size = results[i].heap_size;
       min_size_index = i;
@@ -36,6 +36,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_schedule.h"
 #include "tensorflow/compiler/xla/service/tuple_points_to_analysis.h"
 #include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 
@@ -325,9 +326,18 @@ struct BufferIntervalTreeNode {
   BufferIntervalTreeNode* right;
   // parent
   BufferIntervalTreeNode* parent;
+  // Heap priority of the node in the treap, higher priorities are closer to
+  // the root.
+  uint64_t priority;
 };
 
 // An interval tree that can query buffers overlapping in time.
+//
+// The tree is a treap keyed by alloc time: nodes get pseudo-random priorities
+// and are rotated so that parents have higher priorities than their children,
+// which keeps the tree balanced in expectation even when buffers are added in
+// increasing alloc time, e.g. when many buffers have the same size. The
+// priorities are a fixed sequence, so the shape of the tree is deterministic.
 class BufferIntervalTree {
  public:
   using Chunk = HeapSimulator::Chunk;
@@ -345,8 +355,16 @@ class BufferIntervalTree {
   BufferIntervalTreeNode* GetRoot() { return root_; }
 
  private:
+  // Returns the node with the given interval and chunk offset, or nullptr.
+  BufferIntervalTreeNode* Find(int64_t start, int64_t end,
+                               const Chunk& chunk) const;
+
+  // Rotates `node` above its parent.
+  void RotateUp(BufferIntervalTreeNode* node);
+
   BufferIntervalTreeNode* root_ = nullptr;
   std::list<BufferIntervalTreeNode> node_storage_;
+  uint64_t priority_state_ = 0;
 };
 
 // GlobalDecreasingSizeBestFitHeap collects the live intervals of all buffers,
@@ -492,7 +510,8 @@ class ConstrainedGlobalDecreasingSizeBestFitHeap
 };
 
 // A heap algorithm that chooses the best results from other algorithms added to
-// it.
+// it. If `thread_pool` is not null, the algorithms finish in parallel on it,
+// which must then not wait for Finish() to return from one of its threads.
 template <typename BufferType>
 class ChooseBestHeapAlgorithm : public HeapAlgorithm<BufferType> {
  public:
@@ -500,8 +519,9 @@ class ChooseBestHeapAlgorithm : public HeapAlgorithm<BufferType> {
 
   ChooseBestHeapAlgorithm(
       std::unique_ptr<std::vector<std::unique_ptr<HeapAlgorithm<BufferType>>>>
-          algorithms)
-      : algorithms_(std::move(*algorithms)) {}
+          algorithms,
+      tensorflow::thread::ThreadPool* thread_pool = nullptr)
+      : algorithms_(std::move(*algorithms)), thread_pool_(thread_pool) {}
   ~ChooseBestHeapAlgorithm() override {}
 
   void Alloc(const BufferType* buffer, int64_t size) override {
@@ -527,6 +547,7 @@ class ChooseBestHeapAlgorithm : public HeapAlgorithm<BufferType> {
 
  private:
   std::vector<std::unique_ptr<HeapAlgorithm<BufferType>>> algorithms_;
+  tensorflow::thread::ThreadPool* thread_pool_;
 };
 
 }  // namespace xla
@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/heap_simulator.h"
 
+#include <functional>
+#include <map>
 #include <memory>
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -33,6 +36,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -1632,5 +1637,149 @@ TEST_F(IntervalTreeTest, ThreeLevelsRightLeftChunkDifferent) {
   ASSERT_EQ(tree.GetRoot(), nullptr);
 }
 
+
+TEST_F(IntervalTreeTest, BalancedWithIncreasingStarts) {
+  // Buffers of the same size are added in increasing alloc time, which would
+  // make an unbalanced search tree a list.
+  constexpr int64_t kNumIntervals = 10000;
+  BufferIntervalTree tree;
+  for (int64_t i = 0; i < kNumIntervals; ++i) {
+    tree.Add(i, i + 10, HeapSimulator::Chunk({i, 1}));
+  }
+  std::function<int64_t(const BufferIntervalTreeNode*)> depth =
+      [&](const BufferIntervalTreeNode* node) -> int64_t {
+    return node == nullptr
+               ? 0
+               : 1 + std::max(depth(node->left), depth(node->right));
+  };
+  EXPECT_LT(depth(tree.GetRoot()), 100);
+  EXPECT_EQ(tree.GetRoot()->subtree_end, kNumIntervals + 9);
+  EXPECT_EQ(tree.ChunksOverlappingInTime(100, 105).size(), 16);
+
+  // Remove every other interval.
+  for (int64_t i = 0; i < kNumIntervals; i += 2) {
+    EXPECT_TRUE(tree.Remove(i, i + 10, HeapSimulator::Chunk({i, 1})));
+  }
+  EXPECT_EQ(tree.ChunksOverlappingInTime(100, 105).size(), 8);
+  for (const HeapSimulator::Chunk& chunk :
+       tree.ChunksOverlappingInTime(100, 105)) {
+    EXPECT_EQ(chunk.offset % 2, 1);
+  }
+  for (int64_t i = 1; i < kNumIntervals; i += 2) {
+    EXPECT_TRUE(tree.Remove(i, i + 10, HeapSimulator::Chunk({i, 1})));
+  }
+  EXPECT_EQ(tree.GetRoot(), nullptr);
+}
+
+TEST_F(IntervalTreeTest, RemoveIntervalsWithSameStart) {
+  BufferIntervalTree tree;
+  for (int64_t i = 0; i < 100; ++i) {
+    tree.Add(5, 10 + i, HeapSimulator::Chunk({i, 1}));
+  }
+  for (int64_t i = 99; i >= 0; --i) {
+    EXPECT_TRUE(tree.Remove(5, 10 + i, HeapSimulator::Chunk({i, 1})));
+    if (i > 0) {
+      EXPECT_EQ(tree.GetRoot()->subtree_end, 9 + i);
+    }
+  }
+  EXPECT_EQ(tree.GetRoot(), nullptr);
+}
+
+class ChooseBestHeapAlgorithmTest : public HeapAlgorithmTestBase {};
+
+TEST_F(ChooseBestHeapAlgorithmTest, FinishInParallel) {
+  auto make_heap = [](tensorflow::thread::ThreadPool* thread_pool) {
+    auto algorithms = absl::make_unique<
+        std::vector<std::unique_ptr<HeapAlgorithm<HloValue>>>>();
+    algorithms->push_back(
+        absl::make_unique<GlobalDecreasingSizeBestFitHeap<HloValue>>(
+            /*alignment=*/1,
+            GlobalDecreasingSizeBestFitHeap<HloValue>::kSpatial));
+    algorithms->push_back(
+        absl::make_unique<GlobalDecreasingSizeBestFitHeap<HloValue>>(
+            /*alignment=*/1,
+            GlobalDecreasingSizeBestFitHeap<HloValue>::kTemporal));
+    return absl::make_unique<ChooseBestHeapAlgorithm<HloValue>>(
+        std::move(algorithms), thread_pool);
+  };
+  tensorflow::thread::ThreadPool thread_pool(tensorflow::Env::Default(),
+                                             "test", 2);
+  for (tensorflow::thread::ThreadPool* pool :
+       {static_cast<tensorflow::thread::ThreadPool*>(nullptr), &thread_pool}) {
+    auto heap = make_heap(pool);
+    // space
+    //   ^
+    //   |  +-----------+
+    //   |  |     c     |
+    //   |  +-----------+
+    //   |+-------+    +---+
+    //   ||   a   |    | b |
+    //   ||       |    |   |
+    //   |+-------+    +---+
+    //   ----------------------> time
+    heap->Alloc(buffer_a_, 30);
+    heap->Alloc(buffer_c_, 10);
+    heap->Free(buffer_a_, 30);
+    heap->Alloc(buffer_b_, 20);
+    heap->Free(buffer_c_, 10);
+    heap->Free(buffer_b_, 20);
+
+    const HeapSimulator::Result<HloValue> result = heap->Finish();
+    EXPECT_EQ(40, result.heap_size);
+    const auto& chunk_map = result.heap_results[0].chunk_map;
+    EXPECT_EQ(0, chunk_map.at(buffer_a_).offset);
+    EXPECT_EQ(0, chunk_map.at(buffer_b_).offset);
+    EXPECT_EQ(30, chunk_map.at(buffer_c_).offset);
+  }
+}
+
+// Simulates a schedule of `num_buffers` buffers with a few different sizes,
+// each of which is live for a short time, like the temporaries of the layers
+// of a large model.
+void BM_GlobalDecreasingSizeBestFitHeap(::testing::benchmark::State& state) {
+  const int64_t num_buffers = state.range(0);
+  const bool temporal = state.range(1);
+  HloComputation::Builder builder("benchmark");
+  std::vector<std::unique_ptr<HloValue>> buffers;
+  for (int64_t i = 0; i < num_buffers; ++i) {
+    HloInstruction* constant = builder.AddInstruction(
+        HloInstruction::CreateConstant(LiteralUtil::CreateR0<float>(1.0)));
+    buffers.push_back(absl::make_unique<HloValue>(i, constant, ShapeIndex{}));
+  }
+  std::minstd_rand0 engine(0);
+  std::vector<int64_t> sizes(num_buffers);
+  std::vector<int64_t> lifetimes(num_buffers);
+  for (int64_t i = 0; i < num_buffers; ++i) {
+    sizes[i] = int64_t{1024} << (engine() % 4);
+    lifetimes[i] = 1 + engine() % 32;
+  }
+
+  for (auto s : state) {
+    GlobalDecreasingSizeBestFitHeap<HloValue> heap(
+        /*alignment=*/64,
+        temporal ? GlobalDecreasingSizeBestFitHeap<HloValue>::kTemporal
+                 : GlobalDecreasingSizeBestFitHeap<HloValue>::kSpatial);
+    // Buffers to free, keyed by the step at which they are freed.
+    std::multimap<int64_t, int64_t> frees;
+    for (int64_t i = 0; i < num_buffers; ++i) {
+      for (auto it = frees.begin(); it != frees.end() && it->first <= i;
+           it = frees.erase(it)) {
+        heap.Free(buffers[it->second].get(), sizes[it->second]);
+      }
+      heap.Alloc(buffers[i].get(), sizes[i]);
+      frees.emplace(i + lifetimes[i], i);
+    }
+    for (const auto& free : frees) {
+      heap.Free(buffers[free.second].get(), sizes[free.second]);
+    }
+    ::testing::benchmark::DoNotOptimize(heap.Finish());
+  }
+}
+BENCHMARK(BM_GlobalDecreasingSizeBestFitHeap)
+    ->ArgPair(1 << 10, 0)
+    ->ArgPair(1 << 14, 0)
+    ->ArgPair(1 << 17, 0)
+    ->ArgPair(1 << 17, 1);
+
 }  // namespace
 }  // namespace xla
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 
 #include <functional>
+#include <memory>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -29,6 +30,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
 
 namespace xla {
 
@@ -96,6 +99,18 @@ void RecordPassEndMetadata(HloModuleGroup& module_group,
   }
 }
 
+int64_t InstructionCount(const HloModule& module) {
+  return module.instruction_count();
+}
+
+int64_t InstructionCount(const HloModuleGroup& module_group) {
+  int64_t count = 0;
+  for (const HloModule* module : module_group.modules()) {
+    count += module->instruction_count();
+  }
+  return count;
+}
+
 void SetInstructionMetadata(HloModule& module) {
   StatusOr<int64_t> pass_id = module.metadata()->current_pass_id();
   if (!pass_id.ok()) {
@@ -153,6 +168,16 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
   static constexpr absl::string_view kPipelineEnd = "pipeline-end";
   std::string pipeline_name = std::string(name());
 
+  // Pipelines that were not given stats of their own report them when
+  // requested.
+  std::unique_ptr<CompilationStats> reported_stats;
+  CompilationStats* compilation_stats = compilation_stats_;
+  if (debug_options.xla_hlo_pass_statistics() &&
+      compilation_stats_ == empty_compilation_stats_.get()) {
+    reported_stats = CompilationStats::MakeStats();
+    compilation_stats = reported_stats.get();
+  }
+
   TF_RETURN_IF_ERROR(RunInvariantCheckers(hlo, kPipelineStart));
 
   RecordPassStartMetadata(*hlo, std::string(kPipelineStart), pipeline_name);
@@ -173,10 +198,36 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
     VLOG(1) << "  HLO pass " << pass_name;
     VLOG(2) << "  Module hash " << hlo->Hash();
     if (!pass->IsPassPipeline()) {
-      compilation_stats_->StartPass(pass_name);
+      compilation_stats->StartPass(pass_name);
     }
+    // Counting the instructions and reading the peak RSS are cheap enough to
+    // be done for every pass, so that the effects of the passes can be traced
+    // in production.
+    CompilationStats::PassEffects effects;
+    const int64_t instruction_count_before = InstructionCount(*hlo);
+    effects.peak_rss_bytes_before = CompilationStats::PeakRssBytes();
+    tensorflow::profiler::TraceMe traceme(
+        [&] {
+          return tensorflow::profiler::TraceMeEncode(
+              absl::StrCat("HloPass:", pass_name),
+              {{"pipeline", pipeline_name}, {"module", hlo->name()}});
+        },
+        tensorflow::profiler::TraceMeLevel::kInfo);
     RecordPassStartMetadata(*hlo, pass_name, pipeline_name);
     TF_ASSIGN_OR_RETURN(bool pass_changed, RunHelper(pass, hlo));
+    effects.instruction_count_delta =
+        InstructionCount(*hlo) - instruction_count_before;
+    effects.peak_rss_bytes_after = CompilationStats::PeakRssBytes();
+    traceme.AppendMetadata([&] {
+      return tensorflow::profiler::TraceMeEncode(
+          {{"changed", pass_changed ? "true" : "false"},
+           {"instruction_count_delta", effects.instruction_count_delta},
+           {"peak_rss_bytes", effects.peak_rss_bytes_after}});
+    });
+    traceme.Stop();
+    if (!pass->IsPassPipeline()) {
+      compilation_stats->RecordPassEffects(pass_name, effects);
+    }
     SetInstructionMetadata(*hlo);
     if (!dump_regex.empty() && (pass_changed || dump_regex != ".*")) {
       MaybeDumpHloAndSaveFilenames(*hlo,
@@ -192,9 +243,14 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
     }
     TF_RETURN_IF_ERROR(RunInvariantCheckers(hlo, pass_name));
     if (!pass->IsPassPipeline()) {
-      compilation_stats_->EndPass(pass_name);
+      compilation_stats->EndPass(pass_name);
     }
   }
+  if (reported_stats != nullptr) {
+    LOG(INFO) << "HLO pass statistics of pipeline " << pipeline_name
+              << " on " << hlo->name() << ":";
+    reported_stats->CompilationReport();
+  }
   return changed;
 }
 
@@ -35,6 +35,12 @@ namespace xla {
 class PhaseOrderPipeline;
 
 // Pipeline of HLO passes.
+//
+// Each pass is traced as a TraceMe event "HloPass:<pass name>", whose metadata
+// has the change in the number of instructions and the peak RSS after the
+// pass. They are also recorded in the CompilationStats of the pipeline. With
+// --xla_hlo_pass_statistics, pipelines without CompilationStats log a table of
+// them at the end of Run.
 class HloPassPipeline : public HloPassInterface {
  public:
   explicit HloPassPipeline(const string& name,
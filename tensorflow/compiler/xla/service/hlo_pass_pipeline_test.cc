@@ -15,6 +15,11 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/compilation_stats.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
@@ -297,5 +302,95 @@ TEST_F(HloPassPipelineTest, SetHloModuleMetadata) {
   }
 }
 
+
+// A module pass which negates the root of the entry computation.
+class NegateRootModulePass : public HloModulePass {
+  absl::string_view name() const override { return "negate-root"; }
+
+  StatusOr<bool> Run(HloModule* module) override {
+    HloComputation* entry = module->entry_computation();
+    HloInstruction* root = entry->root_instruction();
+    entry->set_root_instruction(entry->AddInstruction(
+        HloInstruction::CreateUnary(root->shape(), HloOpcode::kNegate, root)));
+    return true;
+  }
+};
+
+// Compilation stats which keep the effects of the passes by name.
+class RecordingStats : public CompilationStats {
+ public:
+  void StartPass(absl::string_view pass_name) override {}
+
+  void RecordPassEffects(absl::string_view pass_name,
+                         const PassEffects& effects) override {
+    effects_.emplace_back(std::string(pass_name), effects);
+  }
+
+  void EndPass(absl::string_view pass_name) override {}
+
+  void CompilationReport() override {}
+
+  int GetPassesSize() override { return effects_.size(); }
+
+  std::vector<std::pair<std::string, PassEffects>> effects_;
+};
+
+TEST_F(HloPassPipelineTest, RecordPassEffects) {
+  const string module_str = R"(
+HloModule RecordPassEffects
+
+ENTRY main {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT foo = f32[] multiply(a, b)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(module_str));
+  RecordingStats stats;
+  HloPassPipeline pipeline(TestName(), &stats);
+  pipeline.AddPass<NegateRootModulePass>();
+  pipeline.AddPass<FooToBarModulePass>();
+  // Nested pipelines are not recorded, their passes are recorded by the stats
+  // of the nested pipeline.
+  HloPassPipeline& nested = pipeline.AddPass<HloPassPipeline>("nested");
+  nested.AddPass<NegateRootModulePass>();
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, pipeline.Run(module.get()));
+  EXPECT_TRUE(changed);
+
+  ASSERT_THAT(stats.effects_, SizeIs(2));
+  EXPECT_EQ(stats.effects_[0].first, "negate-root");
+  EXPECT_EQ(stats.effects_[0].second.instruction_count_delta, 1);
+  EXPECT_EQ(stats.effects_[1].first, "foo2bar");
+  EXPECT_EQ(stats.effects_[1].second.instruction_count_delta, 0);
+  for (const auto& pass_effects : stats.effects_) {
+    EXPECT_GE(pass_effects.second.peak_rss_bytes_after,
+              pass_effects.second.peak_rss_bytes_before);
+  }
+}
+
+TEST_F(HloPassPipelineTest, ReportPassStatistics) {
+  const string module_str = R"(
+HloModule ReportPassStatistics
+
+ENTRY main {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT foo = f32[] multiply(a, b)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(module_str));
+  DebugOptions debug_options = module->config().debug_options();
+  debug_options.set_xla_hlo_pass_statistics(true);
+  module->config().set_debug_options(debug_options);
+  HloPassPipeline pipeline(TestName());
+  pipeline.AddPass<NegateRootModulePass>();
+  pipeline.AddPass<NegateRootModulePass>();
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, pipeline.Run(module.get()));
+  EXPECT_TRUE(changed);
+  EXPECT_EQ(module->entry_computation()->instruction_count(), 5);
+}
+
 }  // namespace
 }  // namespace xla
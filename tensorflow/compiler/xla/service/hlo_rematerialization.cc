@@ -25,6 +25,7 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -120,6 +121,9 @@ struct RematStrategy {
     // Change the layout into a compact form and uncompress it back at a later
     // program point.
     kCompress,
+    // Copy the node to host memory and back to device memory at a later
+    // program point.
+    kHostOffload,
   } kind;
   Shape compact_shape;
 };
@@ -245,6 +249,7 @@ class InstructionList {
   //    for (auto item = q.first(); item != nullptr; item = q.next(item)) {...}
   Item* first() const { return first_; }
   Item* next(Item* item) const { return item->next; }
+  Item* prev(Item* item) const { return item->prev; }
 
   Item* first_skip_node() const { return first_skip_node_; }
   Item* next_skip_node(Item* item) const { return item->next_skip_node; }
@@ -289,20 +294,24 @@ class InstructionList {
                              })
             << "}";
 
-    // Find the minimal position number of any instruction in
-    // 'before_instructions'.
-    CHECK(!before_instructions.empty());
+    return InsertBefore(to_insert, Earliest(before_instructions));
+  }
+
+  // Returns the earliest instruction of 'items' in the list.
+  Item* Earliest(absl::Span<Item* const> items) const {
+    // Find the minimal position number of any instruction in 'items'.
+    CHECK(!items.empty());
     Item* min_position_item = nullptr;
-    for (Item* item : before_instructions) {
+    for (Item* item : items) {
       if (min_position_item == nullptr ||
           item->position < min_position_item->position) {
         min_position_item = item;
       }
     }
 
-    // Because more than one instruction in 'before_instructions' may have a
-    // position number of 'min_position_number', find the first such instruction
-    // with position number 'min_position_number'.
+    // Because more than one instruction in 'items' may have a position number
+    // of 'min_position_number', find the first such instruction with position
+    // number 'min_position_number'.
 
     // First find first instruction with the min position.
     while (min_position_item->prev != nullptr &&
@@ -310,11 +319,11 @@ class InstructionList {
       min_position_item = min_position_item->prev;
     }
 
-    // Now scan forwards until we find one of the before_instructions.
-    while (!absl::c_linear_search(before_instructions, min_position_item)) {
+    // Now scan forwards until we find one of the items.
+    while (!absl::c_linear_search(items, min_position_item)) {
       min_position_item = min_position_item->next;
     }
-    return InsertBefore(to_insert, min_position_item);
+    return min_position_item;
   }
 
   // Scan the list and promote nodes to express lane if should_promote(Item)
@@ -497,7 +506,10 @@ class MemoryUsageTracker {
       const HloRematerialization::CompactShapeFunction& compact_shape_function,
       const TuplePointsToAnalysis& points_to_analysis,
       const InstructionList& instruction_list,
-      HloRematerialization::RematerializationMode mode);
+      HloRematerialization::RematerializationMode mode,
+      const HloRematerialization::HostMemoryOffloadConfig*
+          host_memory_offload_config = nullptr,
+      const HloCostAnalysis* cost_analysis = nullptr);
 
   // Starts the placement of the given instruction. This adds the sizes of the
   // LogicalBuffers defined by the instruction to the current memory
@@ -507,9 +519,9 @@ class MemoryUsageTracker {
   // EndInstruction memory for dead operand(s) is freed.
   Status BeginInstruction(Item* item);
 
-  int64_t RematerializationCost(const std::vector<Item*>& items,
-                                int64_t memory_reduced,
-                                int64_t memory_limit_bytes) {
+  double RematerializationCost(const std::vector<Item*>& items,
+                               int64_t memory_reduced,
+                               int64_t memory_limit_bytes) {
     // If none of the users of any 'item' have been placed in the
     // sequence (as tracked by memory_tracker), then rematerialization of
     // 'item' is a zero-cost move of 'item->instruction' in the sequence.
@@ -528,6 +540,14 @@ class MemoryUsageTracker {
     }
 
     CHECK_GT(memory_reduced, 0);
+    if (HasTimeCostModel()) {
+      // Return the time spent recomputing per byte saved.
+      double seconds = 0;
+      for (const Item* item : items) {
+        seconds += ElapsedSeconds(item);
+      }
+      return seconds / memory_reduced;
+    }
     // Return the inverse of the benefit of rematerialization.
     return memory_limit_bytes / memory_reduced;
   }
@@ -550,6 +570,51 @@ class MemoryUsageTracker {
   Status AddCompressInstructions(Item* original_item, Item* compressed_item,
                                  Item* uncompressed_item);
 
+  // Where the copies of a value offloaded to host memory are placed, see
+  // PlaceHostOffload.
+  struct HostOffloadPlacement {
+    // The copy to host memory completes right before this item.
+    Item* copy_done_to_host_before;
+    // The copy back to device memory starts right after this item.
+    Item* copy_start_to_device_after;
+    // The part of the transfers which isn't overlapped with other
+    // instructions.
+    double stall_seconds;
+  };
+
+  // Returns true if the output of the given instruction can be offloaded to
+  // host memory at the current program point.
+  bool CanHostOffload(Item* item) const;
+
+  // Returns the number of bytes that the current memory usage will be reduced
+  // by if the given instruction is offloaded to host memory.
+  int64_t MemoryReducedIfHostOffloaded(Item* item) const;
+
+  // Places the copies of the output of 'item' to host memory and back. The
+  // copy to host memory starts right after 'item' and completes once the
+  // instructions after it are estimated to take as long as the transfer, or
+  // at the current program point. Likewise the copy back to device memory
+  // starts early enough before the first unplaced use of 'item' to hide the
+  // transfer, but after the current program point.
+  HostOffloadPlacement PlaceHostOffload(Item* item) const;
+
+  // Adjusts memory usage to account for the offloading of original_item to
+  // host memory. The copies are placed before calling this method.
+  Status AddHostOffloadInstructions(Item* original_item,
+                                    Item* copy_start_to_host,
+                                    Item* copy_done_to_host,
+                                    Item* copy_start_to_device,
+                                    Item* copy_done_to_device);
+
+  // Returns the estimated time the instruction of 'item' takes, or 0 if there
+  // is no cost analysis.
+  double ElapsedSeconds(const Item* item) const;
+
+  // Returns true if the candidates are ranked by their estimated time.
+  bool HasTimeCostModel() const {
+    return host_memory_offload_config_ != nullptr;
+  }
+
   // Adjusts memory usage to account for the rematerialization of
   // original_item for all remaining unplaced uses. The rematerialization
   // is remat_item. This method should be called after the HLO graph has
@@ -572,6 +637,11 @@ class MemoryUsageTracker {
       absl::flat_hash_map<const HloInstruction*, bool>* rematerializable_map,
       int min_block_size, int max_block_size);
 
+  const HloRematerialization::HostMemoryOffloadConfig*
+  host_memory_offload_config() const {
+    return host_memory_offload_config_;
+  }
+
   // Returns whether the given instruction has been placed (BeginInstruction
   // has been called with 'instruction' as the argument).
   bool IsPlaced(const HloInstruction* instruction) const {
@@ -742,6 +812,11 @@ class MemoryUsageTracker {
                     const ShapeIndex& index, UsesList&& uses, bool live_out,
                     bool has_indirect_uses) {
     int buffer_id = buffers_.size();
+    // Values offloaded to host memory don't use any device memory.
+    const bool in_host_memory =
+        host_memory_offload_config_ != nullptr && shape.has_layout() &&
+        shape.layout().memory_space() ==
+            host_memory_offload_config_->host_memory_space;
     auto get_num_of_unique_users = [](const UsesList& uses) -> int64_t {
       absl::flat_hash_set<Item*> users_set;
       for (const ItemUse& use : uses) {
@@ -749,9 +824,10 @@ class MemoryUsageTracker {
       }
       return users_set.size();
     };
-    buffers_.push_back(Buffer{
-        buffer_id, defining_instruction, size_function_(shape), shape, live_out,
-        has_indirect_uses, index, uses, get_num_of_unique_users(uses)});
+    buffers_.push_back(Buffer{buffer_id, defining_instruction,
+                              in_host_memory ? 0 : size_function_(shape),
+                              shape, live_out, has_indirect_uses, index, uses,
+                              get_num_of_unique_users(uses)});
     return buffers_.back();
   }
 
@@ -780,6 +856,13 @@ class MemoryUsageTracker {
   Item* in_progress_item_ = nullptr;
 
   HloRematerialization::RematerializationMode mode_;
+
+  // Configuration of the offloading to host memory, or nullptr if values are
+  // not offloaded.
+  const HloRematerialization::HostMemoryOffloadConfig*
+      host_memory_offload_config_;
+  const HloCostAnalysis* cost_analysis_;
+
   // All buffers in the computation.
   std::vector<Buffer> buffers_;
 };
@@ -790,12 +873,17 @@ MemoryUsageTracker::MemoryUsageTracker(
     const HloRematerialization::CompactShapeFunction& compact_shape_function,
     const TuplePointsToAnalysis& points_to_analysis,
     const InstructionList& instruction_list,
-    HloRematerialization::RematerializationMode mode)
+    HloRematerialization::RematerializationMode mode,
+    const HloRematerialization::HostMemoryOffloadConfig*
+        host_memory_offload_config,
+    const HloCostAnalysis* cost_analysis)
     : computation_(computation),
       instruction_list_(instruction_list),
       size_function_(size_function),
       compact_shape_function_(compact_shape_function),
-      mode_(mode) {
+      mode_(mode),
+      host_memory_offload_config_(host_memory_offload_config),
+      cost_analysis_(cost_analysis) {
   PointsToSet::BufferSet live_out_set =
       points_to_analysis.GetPointsToSet(computation_->root_instruction())
           .CreateFlattenedSet();
@@ -1069,6 +1157,169 @@ Status MemoryUsageTracker::AddCompressInstructions(Item* original_item,
   return Status::OK();
 }
 
+bool MemoryUsageTracker::CanHostOffload(Item* item) const {
+  if (host_memory_offload_config_ == nullptr || !item->placed ||
+      item == in_progress_item_ || item->denylisted ||
+      item->buffers_output.size() != 1 ||
+      item->buffers_defined != item->buffers_output) {
+    return false;
+  }
+  const Buffer& buffer = buffers_.at(item->buffers_output[0]);
+  const Shape& shape = item->instruction->shape();
+  return !buffer.live_out && !buffer.has_indirect_uses && shape.IsArray() &&
+         shape.has_layout() &&
+         shape.layout().memory_space() !=
+             host_memory_offload_config_->host_memory_space &&
+         item->instruction->opcode() != HloOpcode::kParameter &&
+         HasUnplacedUsers(item);
+}
+
+int64_t MemoryUsageTracker::MemoryReducedIfHostOffloaded(Item* item) const {
+  CHECK_NE(in_progress_item_, nullptr);
+  if (!CanHostOffload(item)) {
+    return 0;
+  }
+  BufferId buffer_id = item->buffers_output[0];
+  if (IsCurrentlyLive(buffer_id) && !IsInUse(buffer_id) &&
+      IsInstructionCurrentlyLive(item)) {
+    return AllocatedSize(buffer_id);
+  }
+  return 0;
+}
+
+MemoryUsageTracker::HostOffloadPlacement MemoryUsageTracker::PlaceHostOffload(
+    Item* item) const {
+  CHECK(CanHostOffload(item));
+  const HloRematerialization::HostMemoryOffloadConfig& config =
+      *host_memory_offload_config_;
+  const Buffer& buffer = buffers_.at(item->buffers_output[0]);
+  const double to_host_seconds =
+      buffer.size / config.bandwidth_to_host_bytes_per_second;
+  const double from_host_seconds =
+      buffer.size / config.bandwidth_from_host_bytes_per_second;
+
+  HostOffloadPlacement placement;
+  double to_host_elapsed = 0;
+  placement.copy_done_to_host_before = instruction_list_.next(item);
+  while (placement.copy_done_to_host_before != in_progress_item_ &&
+         to_host_elapsed < to_host_seconds) {
+    to_host_elapsed += ElapsedSeconds(placement.copy_done_to_host_before);
+    placement.copy_done_to_host_before =
+        instruction_list_.next(placement.copy_done_to_host_before);
+  }
+
+  ItemList unplaced_users;
+  for (const ItemUse& use : buffer.users) {
+    if (!use.user->placed) {
+      unplaced_users.push_back(use.user);
+    }
+  }
+  double from_host_elapsed = 0;
+  placement.copy_start_to_device_after =
+      instruction_list_.prev(instruction_list_.Earliest(unplaced_users));
+  while (placement.copy_start_to_device_after != in_progress_item_ &&
+         from_host_elapsed < from_host_seconds) {
+    from_host_elapsed += ElapsedSeconds(placement.copy_start_to_device_after);
+    placement.copy_start_to_device_after =
+        instruction_list_.prev(placement.copy_start_to_device_after);
+  }
+
+  placement.stall_seconds =
+      std::max(0.0, to_host_seconds - to_host_elapsed) +
+      std::max(0.0, from_host_seconds - from_host_elapsed);
+  return placement;
+}
+
+Status MemoryUsageTracker::AddHostOffloadInstructions(
+    Item* original_item, Item* copy_start_to_host, Item* copy_done_to_host,
+    Item* copy_start_to_device, Item* copy_done_to_device) {
+  CHECK_EQ(original_item->buffers_output.size(), 1);
+  BufferId original_buffer_id = original_item->buffers_output[0];
+  // The original buffer is dead once the copy to host memory is done, which
+  // is before the current program point.
+  memory_usage_ -= AllocatedSize(original_buffer_id);
+
+  UsesList placed_users;
+  UsesList unplaced_users;
+  Buffer& original_buffer = buffers_.at(original_buffer_id);
+  for (ItemUse& user : original_buffer.users) {
+    if (user.user->placed) {
+      CHECK(IsFinished(user.user)) << user.user->instruction->name();
+      placed_users.push_back(user);
+    } else {
+      unplaced_users.push_back(user);
+    }
+  }
+  original_buffer.users = std::move(placed_users);
+  original_buffer.unfinished_user_count = 0;
+  // The copy-start reads the original buffer asynchronously, so it must stay
+  // alive until the copy-done.
+  original_buffer.users.push_back(
+      ItemUse{copy_start_to_host, 0, absl::nullopt});
+  original_buffer.users.push_back(ItemUse{copy_done_to_host, 0, absl::nullopt});
+  // We are reallocating the vector containing the buffers potentially,
+  // invalidating the original_buffer reference, so copy the index that we need
+  // across NewBuffer calls.
+  ShapeIndex copied_index = original_buffer.index;
+
+  // Like the while instruction, the copy-done defines no new buffer: its
+  // output is the destination buffer allocated by the copy-start. The buffer
+  // in host memory doesn't use device memory.
+  Buffer& host_buffer = NewBuffer(
+      copy_start_to_host,
+      ShapeUtil::GetTupleElementShape(copy_start_to_host->instruction->shape(),
+                                      0),
+      copied_index,
+      {ItemUse{copy_done_to_host, 0, absl::nullopt},
+       ItemUse{copy_start_to_device, 0, absl::nullopt}},
+      /*live_out=*/false, /*has_indirect_uses=*/false);
+  // The copy-done to host is already finished.
+  host_buffer.unfinished_user_count = 1;
+  copy_start_to_host->buffers_used = {original_buffer_id};
+  copy_start_to_host->buffers_defined = {host_buffer.id};
+  copy_start_to_host->buffers_output = {host_buffer.id};
+  copy_done_to_host->buffers_used = {host_buffer.id, original_buffer_id};
+  copy_done_to_host->buffers_output = {host_buffer.id};
+  const BufferId host_buffer_id = host_buffer.id;
+
+  unplaced_users.push_back(ItemUse{copy_done_to_device, 0, absl::nullopt});
+  Buffer& device_buffer = NewBuffer(
+      copy_start_to_device,
+      ShapeUtil::GetTupleElementShape(
+          copy_start_to_device->instruction->shape(), 0),
+      copied_index, std::move(unplaced_users), /*live_out=*/false,
+      /*has_indirect_uses=*/false);
+  copy_start_to_device->buffers_used = {host_buffer_id};
+  copy_start_to_device->buffers_defined = {device_buffer.id};
+  copy_start_to_device->buffers_output = {device_buffer.id};
+  copy_done_to_device->buffers_used = {device_buffer.id};
+  copy_done_to_device->buffers_output = {device_buffer.id};
+
+  for (ItemUse& user : device_buffer.users) {
+    if (user.user == copy_done_to_device) {
+      continue;
+    }
+    BufferIdList& buffers_used = user.user->buffers_used;
+    std::replace(buffers_used.begin(), buffers_used.end(), original_buffer_id,
+                 device_buffer.id);
+  }
+  return Status::OK();
+}
+
+double MemoryUsageTracker::ElapsedSeconds(const Item* item) const {
+  if (cost_analysis_ == nullptr) {
+    return 0;
+  }
+  const HloInstruction& instruction = *item->instruction;
+  const double flops = cost_analysis_->flop_count(instruction) +
+                       cost_analysis_->transcendental_count(instruction);
+  return std::max(
+      flops / host_memory_offload_config_->flops_per_second,
+      cost_analysis_->bytes_accessed(instruction) /
+          static_cast<double>(
+              host_memory_offload_config_->bytes_accessed_per_second));
+}
+
 Status MemoryUsageTracker::AddRematerializedInstruction(
     Item* original_item, Item* remat_item, absl::Span<Item*> indirect_users) {
   VLOG(3) << "AddRematerializedInstruction: original_instruction = "
@@ -1381,7 +1632,7 @@ MemoryUsageTracker::PickRematerializationCandidates(
     absl::flat_hash_map<const HloInstruction*, bool>* rematerializable_map,
     int min_block_size, int max_block_size) {
   std::vector<Item*> best_items;
-  int64_t best_cost = 0;
+  double best_cost = 0;
   RematStrategy best_strategy;
 
   int effort = 0;
@@ -1398,6 +1649,23 @@ MemoryUsageTracker::PickRematerializationCandidates(
       // instructions.
       break;
     }
+    // Values can be offloaded to host memory even if their instruction can't
+    // be rematerialized.
+    if (block.size() == 1 && CanHostOffload(block[0])) {
+      const int64_t memory_reduced = MemoryReducedIfHostOffloaded(block[0]);
+      effort++;
+      if (memory_reduced > 0) {
+        const double cost =
+            PlaceHostOffload(block[0]).stall_seconds / memory_reduced;
+        if (best_items.empty() || cost < best_cost) {
+          VLOG(3) << "candidate " << block[0]->instruction->name()
+                  << " now best when offloaded to host memory";
+          best_strategy.kind = RematStrategy::kHostOffload;
+          best_items = block;
+          best_cost = cost;
+        }
+      }
+    }
     // If any item in the starting block are denylisted or non-rematable, then
     // break and move on to next start_item (we can actually move to the last
     // invalid item in this block, but let's ignore that optimization for now).
@@ -1428,7 +1696,16 @@ MemoryUsageTracker::PickRematerializationCandidates(
                   MemoryReducedIfCompressed(item, compact_shape);
               effort++;
               if (memory_reduced > 0) {
-                const int64_t cost = memory_limit_bytes / memory_reduced;
+                // The compressed value is written and read back.
+                const double cost =
+                    HasTimeCostModel()
+                        ? 2.0 *
+                              (AllocatedSize(item) +
+                               size_function_(compact_shape)) /
+                              host_memory_offload_config_
+                                  ->bytes_accessed_per_second /
+                              memory_reduced
+                        : memory_limit_bytes / memory_reduced;
                 if (best_items.empty() || cost < best_cost) {
                   VLOG(3) << "candidate " << candidate->name() << "("
                           << candidate->ToShortString() << ")"
@@ -1476,7 +1753,7 @@ MemoryUsageTracker::PickRematerializationCandidates(
       const int64_t memory_reduced = MemoryReducedIfRematerialized(block);
       effort++;
       if (memory_reduced > 0) {
-        const int cost =
+        const double cost =
             RematerializationCost(block, memory_reduced, memory_limit_bytes);
 
         VLOG(5) << "Candidate block of size " << block.size()
@@ -1484,7 +1761,11 @@ MemoryUsageTracker::PickRematerializationCandidates(
                 << ", memory reduced " << memory_reduced << ", cost per byte "
                 << cost;
 
-        if (best_items.empty() || cost < best_cost) {
+        // At equal cost, recomputing is preferred over offloading, which
+        // adds more instructions.
+        if (best_items.empty() || cost < best_cost ||
+            (cost == best_cost &&
+             best_strategy.kind == RematStrategy::kHostOffload)) {
           VLOG(5) << "Candidate block of size " << block.size()
                   << " starting from " << block[0]->instruction->name()
                   << " now best";
@@ -1743,6 +2024,82 @@ StatusOr<int64_t> CompressInstruction(MemoryUsageTracker* memory_tracker,
   return 2;
 }
 
+StatusOr<int64_t> OffloadInstructionToHost(MemoryUsageTracker* memory_tracker,
+                                           Item* best_item,
+                                           InstructionList* instruction_list) {
+  HloInstruction* best = best_item->instruction;
+  const MemoryUsageTracker::HostOffloadPlacement placement =
+      memory_tracker->PlaceHostOffload(best_item);
+  VLOG(5) << "Offloading instruction " << best->name() << " to host memory, "
+          << "stalling for " << placement.stall_seconds << "s";
+
+  HloComputation* computation = best->parent();
+  Shape host_shape = best->shape();
+  host_shape.mutable_layout()->set_memory_space(
+      memory_tracker->host_memory_offload_config()->host_memory_space);
+  const Shape context_shape = ShapeUtil::MakeShape(U32, {});
+  HloInstruction* copy_start_to_host = computation->AddInstruction(
+      HloInstruction::CreateCopyStart(
+          ShapeUtil::MakeTupleShape({host_shape, best->shape(), context_shape}),
+          best),
+      /*new_name=*/best->name() + ".remat_copy_start_to_host");
+  HloInstruction* copy_done_to_host = computation->AddInstruction(
+      HloInstruction::CreateUnary(host_shape, HloOpcode::kCopyDone,
+                                  copy_start_to_host),
+      /*new_name=*/best->name() + ".remat_copy_done_to_host");
+  HloInstruction* copy_start_to_device = computation->AddInstruction(
+      HloInstruction::CreateCopyStart(
+          ShapeUtil::MakeTupleShape({best->shape(), host_shape, context_shape}),
+          copy_done_to_host),
+      /*new_name=*/best->name() + ".remat_copy_start_to_device");
+  HloInstruction* copy_done_to_device = computation->AddInstruction(
+      HloInstruction::CreateUnary(best->shape(), HloOpcode::kCopyDone,
+                                  copy_start_to_device),
+      /*new_name=*/best->name() + ".remat_copy_done_to_device");
+
+  // Replace each remaining use of 'best' with the copy back to the device.
+  ItemList place_before;
+  std::vector<HloInstruction*> best_users_copy = best->users();
+  for (HloInstruction* user : best_users_copy) {
+    if (!memory_tracker->IsPlaced(user)) {
+      VLOG(5) << "  Replacing use of " << best->name() << " in " << user->name()
+              << " with " << copy_done_to_device->name();
+      TF_RETURN_IF_ERROR(best->ReplaceUseWith(user, copy_done_to_device));
+      place_before.push_back(instruction_list->GetItem(user));
+    }
+  }
+
+  Item* copy_start_to_host_item =
+      instruction_list->CreateItem(copy_start_to_host);
+  Item* copy_done_to_host_item =
+      instruction_list->CreateItem(copy_done_to_host);
+  Item* copy_start_to_device_item =
+      instruction_list->CreateItem(copy_start_to_device);
+  Item* copy_done_to_device_item =
+      instruction_list->CreateItem(copy_done_to_device);
+  copy_start_to_host_item->placed = true;
+  copy_done_to_host_item->placed = true;
+
+  instruction_list->InsertAfterInstructions(copy_start_to_host_item,
+                                            {best_item});
+  instruction_list->InsertBeforeInstructions(
+      copy_done_to_host_item, {placement.copy_done_to_host_before});
+  instruction_list->InsertAfterInstructions(
+      copy_start_to_device_item, {placement.copy_start_to_device_after});
+  instruction_list->InsertBeforeInstructions(copy_done_to_device_item,
+                                             place_before);
+
+  TF_RETURN_IF_ERROR(memory_tracker->AddHostOffloadInstructions(
+      best_item, copy_start_to_host_item, copy_done_to_host_item,
+      copy_start_to_device_item, copy_done_to_device_item));
+
+  for (HloInstruction* copy : {copy_start_to_host, copy_done_to_host,
+                               copy_start_to_device, copy_done_to_device}) {
+    instruction_list->Denylist(copy);
+  }
+  return 4;
+}
+
 // A simple struct to encapsulate the number of instructions added during
 // rematerialization.
 struct InstructionsAdded {
@@ -1793,6 +2150,18 @@ StatusOr<InstructionsAdded> RematerializeBestBlock(
         num_instructions_added.net_instructions_added,
         CompressInstruction(memory_tracker, best_items[0],
                             best_strategy.compact_shape, instruction_list));
+  } else if (best_strategy.kind == RematStrategy::kHostOffload) {
+    CHECK(best_items.size() == 1)
+        << "More than one instruction offloaded simultaneously.";
+    VLOG(1) << "Offloading instruction " << best_items[0]->instruction->name()
+            << " to host memory (saving "
+            << HumanReadableNumBytes(
+                   memory_tracker->MemoryReducedIfHostOffloaded(best_items[0]))
+            << ")";
+    TF_ASSIGN_OR_RETURN(
+        num_instructions_added.net_instructions_added,
+        OffloadInstructionToHost(memory_tracker, best_items[0],
+                                 instruction_list));
   } else {
     TF_ASSIGN_OR_RETURN(
         num_instructions_added.net_instructions_added,
@@ -1807,9 +2176,10 @@ StatusOr<int64_t> HloRematerialization::ComputePeakMemory(
     const HloComputation* computation,
     const HloInstructionSequence& order) const {
   InstructionList instruction_list(order);
-  MemoryUsageTracker tracker(computation, size_function_,
-                             compact_shape_function_, *points_to_analysis_,
-                             instruction_list, mode_);
+  MemoryUsageTracker tracker(
+      computation, size_function_, compact_shape_function_,
+      *points_to_analysis_, instruction_list, mode_,
+      host_memory_offload_config_ ? &*host_memory_offload_config_ : nullptr);
   int64_t peak_memory = tracker.memory_usage();
   for (auto* item = instruction_list.first(); item != nullptr;
        item = instruction_list.next(item)) {
@@ -1853,7 +2223,9 @@ StatusOr<bool> HloRematerialization::RematerializeComputation(
   InstructionList instruction_list(schedule->sequence(computation));
   MemoryUsageTracker memory_tracker(
       computation, size_function_, compact_shape_function_,
-      *points_to_analysis_, instruction_list, mode_);
+      *points_to_analysis_, instruction_list, mode_,
+      host_memory_offload_config_ ? &*host_memory_offload_config_ : nullptr,
+      cost_analysis_.get());
 
   instruction_list.PromoteNodesToSkip([&](Item* item) {
     return memory_tracker.AllocatedSize(item) >= min_remat_size;
@@ -2041,10 +2413,29 @@ StatusOr<bool> HloRematerialization::Run(HloModule* module) {
   rematerialized_computations_.clear();
   instructions_rematerialized_ = 0;
   net_instructions_added_ = 0;
+  cost_analysis_.reset();
 
   TF_RET_CHECK(module->has_schedule());
   TF_ASSIGN_OR_RETURN(points_to_analysis_, TuplePointsToAnalysis::Run(module));
 
+  if (host_memory_offload_config_.has_value()) {
+    // The cost analysis estimates how long the instructions take, to decide
+    // between recomputing and offloading values and to overlap the copies to
+    // and from host memory with compute.
+    cost_analysis_ = absl::make_unique<HloCostAnalysis>(size_function_);
+    for (HloComputation* computation : module->MakeNonfusionComputations()) {
+      Status status = computation->Accept(cost_analysis_.get());
+      if (!status.ok()) {
+        // Without a cost analysis the transfers are assumed to not overlap
+        // with anything, and recomputation to be free.
+        VLOG(1) << "Cost analysis failed, rematerializing without it: "
+                << status;
+        cost_analysis_.reset();
+        break;
+      }
+    }
+  }
+
   // Adjust memory limit to account for the output of the entry
   // computation. This is necessary because the per-computation accounting in
   // MemoryUsageTracker do not include output as these are typically allocated
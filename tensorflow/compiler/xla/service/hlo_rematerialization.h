@@ -17,7 +17,9 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/types/optional.h"
 #include "tensorflow/compiler/xla/service/call_graph.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
@@ -33,6 +35,15 @@ namespace xla {
 // memory use is defined as the total size of all live HLO instruction
 // values. Parameters and constants are included in memory use estimates.
 //
+// A value can be rematerialized by recomputing it, by keeping it in a compact
+// form (see CompactShapeFunction), or, if a HostMemoryOffloadConfig is given,
+// by copying it to host memory with an asynchronous copy-start/copy-done pair
+// and back before its next use. In the latter case the candidates are ranked by
+// the time they are estimated to add per byte of memory saved: the compute time
+// of the recomputed instructions, and the part of the transfers which doesn't
+// overlap with the instructions scheduled between the copy-start and the
+// copy-done.
+//
 // CSE will undo the effects of this optimization and should not be run after
 // this pass. In general, this pass should be run very late, immediately before
 // code generation.
@@ -63,6 +74,18 @@ class HloRematerialization : public HloModulePass {
     kPostFusion  // Rematerialization pass after multi-output fusion.
   };
 
+  // Configuration of the offloading of values to host memory.
+  struct HostMemoryOffloadConfig {
+    // Memory space of the values in host memory.
+    int64_t host_memory_space;
+    float bandwidth_to_host_bytes_per_second;
+    float bandwidth_from_host_bytes_per_second;
+    // Throughput of the device, used to estimate the time the instructions
+    // take from their HloCostAnalysis.
+    float flops_per_second;
+    float bytes_accessed_per_second;
+  };
+
   static Shape DefaultCompactShapeFunction(const Shape& shape) { return shape; }
 
   // Constructor parameters:
@@ -80,13 +103,18 @@ class HloRematerialization : public HloModulePass {
   //
   //   compact_shape_function: Function which returns the compact form of a
   //   shape. If nullptr is provided, an default identity function is used.
+  //
+  //   host_memory_offload_config: If set, values may also be offloaded to host
+  //     memory, and all the candidates are ranked by their estimated time.
   explicit HloRematerialization(
       const ShapeSizeFunction& size_function, int64_t memory_limit_bytes,
       RematerializationSizes* sizes, RematerializationPass pass_location,
       int block_size_limit, int block_rematerialization_factor,
       CompactShapeFunction compact_shape_function = nullptr,
       RematerializationMode mode = RematerializationMode::kRecomputeAndCompress,
-      int64_t min_remat_size = 0)
+      int64_t min_remat_size = 0,
+      absl::optional<HostMemoryOffloadConfig> host_memory_offload_config =
+          absl::nullopt)
       : size_function_(size_function),
         memory_limit_bytes_(memory_limit_bytes),
         sizes_(sizes),
@@ -97,7 +125,8 @@ class HloRematerialization : public HloModulePass {
                                     ? DefaultCompactShapeFunction
                                     : std::move(compact_shape_function)),
         mode_(mode),
-        min_remat_size_(min_remat_size) {}
+        min_remat_size_(min_remat_size),
+        host_memory_offload_config_(std::move(host_memory_offload_config)) {}
   ~HloRematerialization() override = default;
 
   absl::string_view name() const override { return "rematerialization"; }
@@ -197,6 +226,12 @@ class HloRematerialization : public HloModulePass {
   RematerializationMode mode_;
 
   int64_t min_remat_size_;
+
+  absl::optional<HostMemoryOffloadConfig> host_memory_offload_config_;
+
+  // Cost analysis of the module, only computed when values may be offloaded
+  // to host memory.
+  std::unique_ptr<HloCostAnalysis> cost_analysis_;
 };
 
 }  // namespace xla
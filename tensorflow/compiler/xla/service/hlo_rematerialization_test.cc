@@ -18,6 +18,7 @@ limitations under the License.
 #include <memory>
 #include <string>
 
+#include "absl/algorithm/container.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_matchers.h"
@@ -1039,6 +1040,143 @@ ENTRY %entry {
                                              ::testing::Ne(fusion))),
                    op::Add()));
 }
+
+class HostOffloadingRematerializationTest : public RematerializationTestBase {
+ protected:
+  static constexpr int64_t kHostMemorySpace = 5;
+
+  StatusOr<bool> RunHloRematerialization(
+      int64_t memory_limit_bytes, HloModule* module,
+      float bandwidth_to_and_from_host_bytes_per_second) {
+    TF_EXPECT_OK(verifier().Run(module).status());
+    HloRematerialization::HostMemoryOffloadConfig config;
+    config.host_memory_space = kHostMemorySpace;
+    config.bandwidth_to_host_bytes_per_second =
+        bandwidth_to_and_from_host_bytes_per_second;
+    config.bandwidth_from_host_bytes_per_second =
+        bandwidth_to_and_from_host_bytes_per_second;
+    config.flops_per_second = 1e12;
+    config.bytes_accessed_per_second = 1e11;
+    HloRematerialization remat(
+        ByteSizeOf, memory_limit_bytes,
+        /*sizes=*/nullptr,
+        HloRematerialization::RematerializationPass::kPreFusion,
+        /*block_size_limit=*/1, /*block_rematerialization_factor=*/1, nullptr,
+        HloRematerialization::RematerializationMode::kRecomputeAndCompress,
+        /*min_remat_size=*/0, config);
+    TF_ASSIGN_OR_RETURN(bool changed, remat.Run(module));
+    TF_EXPECT_OK(verifier().Run(module).status());
+    return changed;
+  }
+};
+
+// The rng can't be recomputed, so it is offloaded to host memory while %a, %b
+// and %c are live.
+TEST_F(HostOffloadingRematerializationTest, OffloadNonRematerializableValue) {
+  const string& hlo_string = R"(
+HloModule fusion, is_scheduled=true
+
+%add_float {
+  %x = f32[] parameter(0)
+  %y = f32[] parameter(1)
+  ROOT %add = f32[] add(f32[] %x, f32[] %y)
+}
+
+ENTRY %entry {
+  %p0 = f32[] parameter(0)
+  %p1 = f32[] parameter(1)
+  %rng = f32[1024]{0} rng(f32[] %p0, f32[] %p1), distribution=rng_uniform
+  %bcast = f32[1024]{0} broadcast(f32[] %p0), dimensions={}
+  %a = f32[1024]{0} negate(f32[1024]{0} %bcast)
+  %b = f32[1024]{0} exponential(f32[1024]{0} %a)
+  %c = f32[1024]{0} add(f32[1024]{0} %a, f32[1024]{0} %b)
+  %d = f32[1024]{0} add(f32[1024]{0} %c, f32[1024]{0} %rng)
+  %zero = f32[] constant(0)
+  ROOT %reduce = f32[] reduce(f32[1024]{0} %d, f32[] %zero), dimensions={0}, to_apply=%add_float
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  const HloInstruction* rng =
+      module->entry_computation()->GetInstructionWithName("rng");
+  TF_ASSERT_OK_AND_ASSIGN(
+      bool changed,
+      RunHloRematerialization(/*memory_limit_bytes=*/14 * 1024, module.get(),
+                              /*bandwidth_to_and_from_host_bytes_per_second=*/
+                              1e12));
+  EXPECT_TRUE(changed);
+
+  const HloInstruction* d =
+      module->entry_computation()->GetInstructionWithName("d");
+  EXPECT_THAT(d->operand(1),
+              op::CopyDone(op::CopyStart(op::CopyDone(op::CopyStart(rng)))));
+  const HloInstruction* to_host = d->operand(1)->operand(0)->operand(0);
+  EXPECT_EQ(to_host->shape().layout().memory_space(), kHostMemorySpace);
+  EXPECT_EQ(d->operand(1)->shape().layout().memory_space(), 0);
+
+  // The value is copied to the host after %rng and back before %d.
+  const HloInstructionSequence& sequence =
+      module->schedule().sequence(module->entry_computation());
+  auto position = [&](const HloInstruction* instruction) {
+    return absl::c_find(sequence.instructions(), instruction) -
+           sequence.instructions().begin();
+  };
+  EXPECT_LT(position(rng), position(to_host->operand(0)));
+  EXPECT_LT(position(d->operand(1)), position(d));
+}
+
+// %big is needed by %d while %a, %b and %c are live. It is cheap to recompute,
+// so it is only offloaded when the link to the host is fast enough to hide the
+// copies behind the computation.
+TEST_F(HostOffloadingRematerializationTest, OffloadOrRecomputeByTime) {
+  const string& hlo_string = R"(
+HloModule fusion, is_scheduled=true
+
+%add_float {
+  %x = f32[] parameter(0)
+  %y = f32[] parameter(1)
+  ROOT %add = f32[] add(f32[] %x, f32[] %y)
+}
+
+ENTRY %entry {
+  %p0 = f32[] parameter(0)
+  %p1 = f32[] parameter(1)
+  %big = f32[1024]{0} broadcast(f32[] %p1), dimensions={}
+  %bcast = f32[1024]{0} broadcast(f32[] %p0), dimensions={}
+  %a = f32[1024]{0} add(f32[1024]{0} %bcast, f32[1024]{0} %big)
+  %b = f32[1024]{0} exponential(f32[1024]{0} %a)
+  %c = f32[1024]{0} add(f32[1024]{0} %a, f32[1024]{0} %b)
+  %d = f32[1024]{0} add(f32[1024]{0} %c, f32[1024]{0} %big)
+  %zero = f32[] constant(0)
+  ROOT %reduce = f32[] reduce(f32[1024]{0} %d, f32[] %zero), dimensions={0}, to_apply=%add_float
+}
+)";
+
+  for (bool fast_link : {false, true}) {
+    SCOPED_TRACE(fast_link);
+    TF_ASSERT_OK_AND_ASSIGN(auto module,
+                            ParseAndReturnVerifiedModule(hlo_string));
+    const HloInstruction* big =
+        module->entry_computation()->GetInstructionWithName("big");
+    TF_ASSERT_OK_AND_ASSIGN(
+        bool changed,
+        RunHloRematerialization(/*memory_limit_bytes=*/14 * 1024, module.get(),
+                                /*bandwidth_to_and_from_host_bytes_per_second=*/
+                                fast_link ? 1e15 : 1e9));
+    EXPECT_TRUE(changed);
+
+    const HloInstruction* d =
+        module->entry_computation()->GetInstructionWithName("d");
+    if (fast_link) {
+      EXPECT_THAT(d->operand(1), op::CopyDone(op::CopyStart(
+                                     op::CopyDone(op::CopyStart(big)))));
+    } else {
+      EXPECT_THAT(d->operand(1), AllOf(op::Broadcast(), ::testing::Ne(big)));
+    }
+  }
+}
+
 }  // namespace
 
 }  // namespace xla
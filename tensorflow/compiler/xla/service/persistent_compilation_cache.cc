@@ -0,0 +1,190 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/persistent_compilation_cache.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/raw_coding.h"
+
+namespace xla {
+namespace {
+
+constexpr char kMagic[] = "XLAPCC01";
+constexpr size_t kMagicSize = sizeof(kMagic) - 1;
+// Magic, key fingerprint (two words), value size and value fingerprint.
+constexpr size_t kHeaderSize = kMagicSize + 4 * sizeof(uint64_t);
+constexpr char kEntrySuffix[] = ".xlacache";
+constexpr int64_t kDefaultMaxBytes = int64_t{4} << 30;
+
+}  // namespace
+
+PersistentCompilationCache::PersistentCompilationCache(std::string dir,
+                                                       int64_t max_bytes,
+                                                       tensorflow::Env* env)
+    : dir_(std::move(dir)), max_bytes_(max_bytes), env_(env) {}
+
+/*static*/ PersistentCompilationCache* PersistentCompilationCache::Get(
+    const DebugOptions& debug_options) {
+  const std::string& dir = debug_options.xla_persistent_compilation_cache_dir();
+  if (dir.empty()) {
+    return nullptr;
+  }
+  static tensorflow::mutex mu(tensorflow::LINKER_INITIALIZED);
+  static auto* caches =
+      new absl::flat_hash_map<std::string,
+                              std::unique_ptr<PersistentCompilationCache>>();
+  tensorflow::mutex_lock lock(mu);
+  std::unique_ptr<PersistentCompilationCache>& cache = (*caches)[dir];
+  if (cache == nullptr) {
+    tensorflow::Env* env = tensorflow::Env::Default();
+    tensorflow::Status status = env->RecursivelyCreateDir(dir);
+    if (!status.ok() && !tensorflow::errors::IsAlreadyExists(status)) {
+      LOG(WARNING) << "Persistent compilation cache disabled, failed to "
+                   << "create " << dir << ": " << status;
+      caches->erase(dir);
+      return nullptr;
+    }
+    int64_t max_bytes =
+        debug_options.xla_persistent_compilation_cache_max_bytes();
+    cache = std::make_unique<PersistentCompilationCache>(
+        dir, max_bytes > 0 ? max_bytes : kDefaultMaxBytes, env);
+  }
+  return cache.get();
+}
+
+std::string PersistentCompilationCache::FileNameForKey(
+    absl::string_view key) const {
+  tensorflow::Fprint128 fp = tensorflow::Fingerprint128(key);
+  return tensorflow::io::JoinPath(
+      dir_, absl::StrCat(absl::Hex(fp.high64, absl::kZeroPad16),
+                         absl::Hex(fp.low64, absl::kZeroPad16), kEntrySuffix));
+}
+
+absl::optional<std::string> PersistentCompilationCache::Lookup(
+    absl::string_view key) const {
+  const std::string file_name = FileNameForKey(key);
+  std::string contents;
+  if (!tensorflow::ReadFileToString(env_, file_name, &contents).ok()) {
+    return absl::nullopt;
+  }
+
+  tensorflow::Fprint128 key_fp = tensorflow::Fingerprint128(key);
+  const char* header = contents.data();
+  bool valid =
+      contents.size() >= kHeaderSize &&
+      absl::string_view(header, kMagicSize) == kMagic &&
+      tensorflow::core::DecodeFixed64(header + kMagicSize) == key_fp.low64 &&
+      tensorflow::core::DecodeFixed64(header + kMagicSize + 8) ==
+          key_fp.high64 &&
+      tensorflow::core::DecodeFixed64(header + kMagicSize + 16) ==
+          contents.size() - kHeaderSize;
+  if (valid) {
+    absl::string_view value(contents.data() + kHeaderSize,
+                            contents.size() - kHeaderSize);
+    valid = tensorflow::core::DecodeFixed64(header + kMagicSize + 24) ==
+            tensorflow::Fingerprint64(value);
+  }
+  if (!valid) {
+    LOG(WARNING) << "Ignoring corrupted compilation cache entry " << file_name;
+    env_->DeleteFile(file_name).IgnoreError();
+    return absl::nullopt;
+  }
+  VLOG(2) << "Persistent compilation cache hit: " << file_name;
+  return contents.substr(kHeaderSize);
+}
+
+Status PersistentCompilationCache::Insert(absl::string_view key,
+                                          absl::string_view value) {
+  tensorflow::Fprint128 key_fp = tensorflow::Fingerprint128(key);
+  std::string contents(kMagic, kMagicSize);
+  tensorflow::core::PutFixed64(&contents, key_fp.low64);
+  tensorflow::core::PutFixed64(&contents, key_fp.high64);
+  tensorflow::core::PutFixed64(&contents, value.size());
+  tensorflow::core::PutFixed64(&contents, tensorflow::Fingerprint64(value));
+  contents.append(value.data(), value.size());
+
+  // Write to a file that no other process uses and rename it into place, so
+  // that readers only ever see complete entries.
+  const std::string file_name = FileNameForKey(key);
+  std::string tmp_name = file_name;
+  if (!env_->CreateUniqueFileName(&tmp_name, ".tmp")) {
+    return tensorflow::errors::Internal(
+        "Failed to create a unique file name for ", file_name);
+  }
+  TF_RETURN_IF_ERROR(tensorflow::WriteStringToFile(env_, tmp_name, contents));
+  Status status = env_->RenameFile(tmp_name, file_name);
+  if (!status.ok()) {
+    env_->DeleteFile(tmp_name).IgnoreError();
+    return status;
+  }
+  VLOG(2) << "Persistent compilation cache insert: " << file_name;
+  return EvictIfNeeded();
+}
+
+Status PersistentCompilationCache::EvictIfNeeded() {
+  std::vector<std::string> children;
+  TF_RETURN_IF_ERROR(env_->GetChildren(dir_, &children));
+
+  struct Entry {
+    std::string path;
+    int64_t size;
+    int64_t mtime_nsec;
+  };
+  std::vector<Entry> entries;
+  int64_t total_bytes = 0;
+  for (const std::string& child : children) {
+    if (!absl::EndsWith(child, kEntrySuffix)) continue;
+    std::string path = tensorflow::io::JoinPath(dir_, child);
+    tensorflow::FileStatistics stat;
+    // Another process may have evicted the entry in the meantime.
+    if (!env_->Stat(path, &stat).ok()) continue;
+    total_bytes += stat.length;
+    entries.push_back({std::move(path), stat.length, stat.mtime_nsec});
+  }
+  if (total_bytes <= max_bytes_) {
+    return Status::OK();
+  }
+
+  // Lookups do not touch the entries, so this evicts in insertion order.
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) {
+              return a.mtime_nsec < b.mtime_nsec;
+            });
+  for (const Entry& entry : entries) {
+    if (total_bytes <= max_bytes_) break;
+    Status status = env_->DeleteFile(entry.path);
+    if (!status.ok() && !tensorflow::errors::IsNotFound(status)) {
+      return status;
+    }
+    VLOG(2) << "Persistent compilation cache evict: " << entry.path;
+    total_bytes -= entry.size;
+  }
+  return Status::OK();
+}
+
+}  // namespace xla
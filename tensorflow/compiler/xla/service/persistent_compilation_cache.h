@@ -0,0 +1,70 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_PERSISTENT_COMPILATION_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_PERSISTENT_COMPILATION_CACHE_H_
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/xla.pb.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+
+// A cache of compilation artifacts (e.g. object code or cubins) stored in a
+// directory, so that they survive the process and are shared by all the
+// processes that use the same directory.
+//
+// Entries are looked up by a key that must capture everything the artifact
+// depends on: the code being compiled, the target and the compiler options.
+// Each entry is written to a temporary file and renamed into place, so
+// concurrent readers never observe a partial entry and concurrent writers of
+// the same key simply replace each other's identical entries. Every entry also
+// carries fingerprints of its key and value that are checked on lookup, and
+// corrupted entries are treated as misses.
+//
+// When the entries exceed `max_bytes`, the ones written first are evicted.
+class PersistentCompilationCache {
+ public:
+  PersistentCompilationCache(std::string dir, int64_t max_bytes,
+                             tensorflow::Env* env = tensorflow::Env::Default());
+
+  // Returns the process-wide cache configured by
+  // `xla_persistent_compilation_cache_dir`, or nullptr if it is not set.
+  static PersistentCompilationCache* Get(const DebugOptions& debug_options);
+
+  // Returns the value stored for `key`, if any.
+  absl::optional<std::string> Lookup(absl::string_view key) const;
+
+  // Stores `value` for `key` and evicts entries if the cache is too large.
+  Status Insert(absl::string_view key, absl::string_view value);
+
+  const std::string& dir() const { return dir_; }
+
+ private:
+  std::string FileNameForKey(absl::string_view key) const;
+  Status EvictIfNeeded();
+
+  const std::string dir_;
+  const int64_t max_bytes_;
+  tensorflow::Env* const env_;
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_PERSISTENT_COMPILATION_CACHE_H_
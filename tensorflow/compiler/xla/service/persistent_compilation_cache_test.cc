@@ -0,0 +1,97 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/persistent_compilation_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+
+namespace xla {
+namespace {
+
+class PersistentCompilationCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tensorflow::Env* env = tensorflow::Env::Default();
+    ASSERT_TRUE(env->LocalTempFilename(&dir_));
+    TF_ASSERT_OK(env->RecursivelyCreateDir(dir_));
+  }
+
+  std::vector<std::string> Entries() {
+    std::vector<std::string> children;
+    TF_CHECK_OK(tensorflow::Env::Default()->GetChildren(dir_, &children));
+    return children;
+  }
+
+  std::string dir_;
+};
+
+TEST_F(PersistentCompilationCacheTest, InsertAndLookup) {
+  PersistentCompilationCache cache(dir_, /*max_bytes=*/1 << 20);
+  EXPECT_FALSE(cache.Lookup("a").has_value());
+  TF_ASSERT_OK(cache.Insert("a", std::string("value\0a", 7)));
+  TF_ASSERT_OK(cache.Insert("b", "value b"));
+  EXPECT_EQ(cache.Lookup("a"), std::string("value\0a", 7));
+  EXPECT_EQ(cache.Lookup("b"), "value b");
+  EXPECT_EQ(Entries().size(), 2);
+
+  // Another cache over the same directory, like another process would use,
+  // sees the same entries.
+  PersistentCompilationCache other(dir_, /*max_bytes=*/1 << 20);
+  EXPECT_EQ(other.Lookup("b"), "value b");
+}
+
+TEST_F(PersistentCompilationCacheTest, CorruptedEntryIsAMiss) {
+  PersistentCompilationCache cache(dir_, /*max_bytes=*/1 << 20);
+  TF_ASSERT_OK(cache.Insert("a", "value a"));
+  std::vector<std::string> entries = Entries();
+  ASSERT_EQ(entries.size(), 1);
+  const std::string path = tensorflow::io::JoinPath(dir_, entries[0]);
+  std::string contents;
+  TF_ASSERT_OK(tensorflow::ReadFileToString(tensorflow::Env::Default(), path,
+                                            &contents));
+  contents.back() ^= 1;
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(), path,
+                                             contents));
+
+  EXPECT_FALSE(cache.Lookup("a").has_value());
+  EXPECT_TRUE(Entries().empty());
+}
+
+TEST_F(PersistentCompilationCacheTest, EvictsAboveMaxBytes) {
+  const std::string value(100, 'x');
+  PersistentCompilationCache cache(dir_, /*max_bytes=*/300);
+  TF_ASSERT_OK(cache.Insert("a", value));
+  TF_ASSERT_OK(cache.Insert("b", value));
+  TF_ASSERT_OK(cache.Insert("c", value));
+  TF_ASSERT_OK(cache.Insert("d", value));
+
+  // Every entry also has a header, so at most two of them fit.
+  int hits = 0;
+  for (const char* key : {"a", "b", "c", "d"}) {
+    if (cache.Lookup(key).has_value()) ++hits;
+  }
+  EXPECT_GE(hits, 1);
+  EXPECT_LE(hits, 2);
+  EXPECT_EQ(Entries().size(), hits);
+}
+
+}  // namespace
+}  // namespace xla
@@ -281,6 +281,14 @@ class TransferManager {
     return false;
   }
 
+  // Returns true if executables on the platform can use the host memory at
+  // `data` as the device buffer of an array of `shape` without a copy, e.g.
+  // because the device is the host and `data` is suitably aligned.
+  virtual bool CanUseHostBufferAsDeviceBuffer(const void* data,
+                                              const Shape& shape) const {
+    return false;
+  }
+
   /////
   // The TransferManager class also serves as a point to register objects for
   // the various platforms.
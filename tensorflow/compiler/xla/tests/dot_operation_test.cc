@@ -1872,5 +1872,91 @@ void DOT_ReorderContracting(::testing::benchmark::State& state) {
 
 BENCHMARK(DOT_ReorderContracting)->UseRealTime();
 
+// Benchmarks the small and skinny (batch) matrix multiplications typical of
+// RNN cells and MLP towers, for which the CPU backend emits GEMM kernels
+// specialized for the shape instead of calling Eigen.
+// Arguments: batch size (0 for a non-batch dot), m, k, n.
+void DOT_SmallGemm(::testing::benchmark::State& state) {
+  const int64_t batch = state.range(0);
+  const int64_t m = state.range(1);
+  const int64_t k = state.range(2);
+  const int64_t n = state.range(3);
+
+  se::Platform* platform = PlatformUtil::GetDefaultPlatform().ValueOrDie();
+  auto executors = PlatformUtil::GetStreamExecutors(platform).ValueOrDie();
+  se::StreamExecutorMemoryAllocator allocator(platform, executors);
+
+  xla::LocalClientOptions client_options;
+  client_options.set_platform(platform);
+  auto client =
+      ClientLibrary::GetOrCreateLocalClient(client_options).ValueOrDie();
+  int device_ordinal = client->default_device_ordinal();
+
+  std::vector<int64_t> lhs_dims = {m, k};
+  std::vector<int64_t> rhs_dims = {k, n};
+  if (batch > 0) {
+    lhs_dims.insert(lhs_dims.begin(), batch);
+    rhs_dims.insert(rhs_dims.begin(), batch);
+  }
+  const Shape lhs_shape = ShapeUtil::MakeShape(F32, lhs_dims);
+  const Shape rhs_shape = ShapeUtil::MakeShape(F32, rhs_dims);
+
+  XlaBuilder builder("SmallGemm");
+  auto lhs = Parameter(&builder, 0, lhs_shape, "lhs");
+  auto rhs = Parameter(&builder, 1, rhs_shape, "rhs");
+  if (batch > 0) {
+    BatchDot(lhs, rhs);
+  } else {
+    Dot(lhs, rhs);
+  }
+  auto computation = builder.Build().ConsumeValueOrDie();
+
+  auto lhs_literal = MakeFakeLiteral(lhs_shape).ConsumeValueOrDie();
+  auto rhs_literal = MakeFakeLiteral(rhs_shape).ConsumeValueOrDie();
+  ScopedShapedBuffer lhs_buffer =
+      client->LiteralToShapedBuffer(lhs_literal, device_ordinal)
+          .ConsumeValueOrDie();
+  ScopedShapedBuffer rhs_buffer =
+      client->LiteralToShapedBuffer(rhs_literal, device_ordinal)
+          .ConsumeValueOrDie();
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto executables,
+      client->Compile(
+          computation,
+          {&lhs_buffer.on_host_shape(), &rhs_buffer.on_host_shape()},
+          ExecutableBuildOptions()));
+  auto executable = std::move(executables[0]);
+
+  se::Stream stream(executors[device_ordinal]);
+  stream.Init();
+
+  ExecutableRunOptions options;
+  options.set_allocator(&allocator);
+
+  const int kWarmups = 2;
+  for (int i = 0; i < kWarmups; ++i) {
+    ASSERT_IS_OK(executable->Run({&lhs_buffer, &rhs_buffer}, options));
+  }
+
+  for (auto s : state) {
+    ASSERT_IS_OK(executable->Run({&lhs_buffer, &rhs_buffer}, options));
+  }
+  state.SetItemsProcessed(state.iterations() * std::max<int64_t>(batch, 1) *
+                          2 * m * k * n);
+}
+
+BENCHMARK(DOT_SmallGemm)
+    ->Args({0, 1, 256, 256})
+    ->Args({0, 8, 64, 64})
+    ->Args({0, 16, 32, 16})
+    ->Args({0, 32, 128, 32})
+    ->Args({0, 128, 128, 8})
+    ->Args({0, 32, 128, 128})
+    ->Args({64, 8, 32, 8})
+    ->Args({64, 16, 64, 16})
+    ->Args({256, 4, 16, 4})
+    ->UseRealTime();
+
 }  // namespace
 }  // namespace xla
@@ -15,15 +15,20 @@ limitations under the License.
 
 #include <initializer_list>
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "absl/types/optional.h"
+
 #include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
 #include "tensorflow/compiler/xla/client/sharding_builder.h"
 #include "tensorflow/compiler/xla/client/xla_builder.h"
 #include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/service/hlo_input_output_alias_config.h"
 #include "tensorflow/compiler/xla/service/local_service.h"
+#include "tensorflow/compiler/xla/service/maybe_owning_device_memory.h"
 #include "tensorflow/compiler/xla/service/platform_util.h"
 #include "tensorflow/compiler/xla/service/shaped_buffer.h"
 #include "tensorflow/compiler/xla/service/transfer_manager.h"
@@ -36,6 +41,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/tests/test_macros.h"
 #include "tensorflow/compiler/xla/tests/test_utils.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
@@ -900,6 +906,173 @@ XLA_TEST_F(LocalClientExecuteTest, ShapeBufferToLiteralConversion64bit) {
        LiteralUtil::CreateR0<int64_t>(123456789000LL)}));
 }
 
+// Whether LiteralToExecutionInput borrows suitably aligned host memory
+// instead of copying it to the device.
+#ifdef XLA_TEST_BACKEND_CPU
+constexpr bool kBorrowsAlignedHostMemory = true;
+#else
+constexpr bool kBorrowsAlignedHostMemory = false;
+#endif
+
+// Compiles x + {2, 3, 4} for an F32[3] x, with x aliased to the result as
+// `alias_kind`, if set.
+std::unique_ptr<LocalExecutable> CompileAddConstant(
+    LocalClient* client, const std::string& name,
+    absl::optional<HloInputOutputAliasConfig::AliasKind> alias_kind) {
+  XlaBuilder builder(name);
+  const Shape shape = ShapeUtil::MakeShapeWithLayout(F32, {3}, {0});
+  auto x = Parameter(&builder, 0, shape, "x");
+  Add(x, ConstantR1<float>(&builder, {2.0f, 3.0f, 4.0f}));
+  if (alias_kind.has_value()) {
+    builder.SetUpAlias(/*output_index=*/{}, /*param_number=*/0,
+                       /*param_index=*/{}, *alias_kind);
+  }
+  auto executables =
+      client->Compile(builder.Build().ValueOrDie(), {&shape},
+                      ExecutableBuildOptions())
+          .ConsumeValueOrDie();
+  CHECK_EQ(executables.size(), 1);
+  return std::move(executables[0]);
+}
+
+XLA_TEST_F(LocalClientExecuteTest, LiteralToExecutionInputAligned) {
+  // Literals own memory aligned for any backend.
+  Literal x = LiteralUtil::CreateR1<float>({0.0f, 1.0f, 2.0f});
+  TF_ASSERT_OK_AND_ASSIGN(
+      ExecutionInput input,
+      local_client_->LiteralToExecutionInput(
+          x, local_client_->default_device_ordinal(), allocator_));
+  const MaybeOwningDeviceMemory& buffer = input.Buffer({});
+  if (kBorrowsAlignedHostMemory) {
+    EXPECT_FALSE(buffer.HasOwnership());
+    EXPECT_EQ(buffer.AsDeviceMemoryBase().opaque(), x.untyped_data());
+  } else {
+    EXPECT_TRUE(buffer.HasOwnership());
+  }
+
+  std::unique_ptr<LocalExecutable> executable = CompileAddConstant(
+      local_client_, TestName(), /*alias_kind=*/absl::nullopt);
+  std::vector<ExecutionInput> arguments;
+  arguments.push_back(std::move(input));
+  TF_ASSERT_OK_AND_ASSIGN(
+      ExecutionOutput output,
+      executable->Run(std::move(arguments), DefaultExecutableRunOptions()));
+  LiteralTestUtil::ExpectR1Near<float>({2.0f, 4.0f, 6.0f},
+                                       ShapedBufferToLiteral(output.Result()),
+                                       error_spec_);
+  LiteralTestUtil::ExpectR1Equal<float>({0.0f, 1.0f, 2.0f}, x);
+}
+
+XLA_TEST_F(LocalClientExecuteTest, LiteralToExecutionInputMisaligned) {
+  // The floats start 4 bytes into an aligned buffer, so they are too
+  // misaligned for the generated code.
+  Literal storage = LiteralUtil::CreateR1<float>({-1.0f, 0.0f, 1.0f, 2.0f});
+  const Shape shape = ShapeUtil::MakeShapeWithLayout(F32, {3}, {0});
+  const char* data = static_cast<const char*>(storage.untyped_data()) + 4;
+  BorrowingLiteral x(data, shape);
+  TF_ASSERT_OK_AND_ASSIGN(
+      ExecutionInput input,
+      local_client_->LiteralToExecutionInput(
+          x, local_client_->default_device_ordinal(), allocator_));
+  const MaybeOwningDeviceMemory& buffer = input.Buffer({});
+  EXPECT_TRUE(buffer.HasOwnership());
+  EXPECT_NE(buffer.AsDeviceMemoryBase().opaque(), data);
+
+  std::unique_ptr<LocalExecutable> executable = CompileAddConstant(
+      local_client_, TestName(), /*alias_kind=*/absl::nullopt);
+  std::vector<ExecutionInput> arguments;
+  arguments.push_back(std::move(input));
+  TF_ASSERT_OK_AND_ASSIGN(
+      ExecutionOutput output,
+      executable->Run(std::move(arguments), DefaultExecutableRunOptions()));
+  LiteralTestUtil::ExpectR1Near<float>({2.0f, 4.0f, 6.0f},
+                                       ShapedBufferToLiteral(output.Result()),
+                                       error_spec_);
+}
+
+XLA_TEST_F(LocalClientExecuteTest,
+           DISABLED_ON_INTERPRETER(LiteralToExecutionInputMayAlias)) {
+  // A borrowed argument can't be donated, so the executable copies it
+  // instead of updating the host memory in place; a copied argument is
+  // donated.
+  for (bool misaligned : {false, true}) {
+    SCOPED_TRACE(misaligned);
+    Literal storage = LiteralUtil::CreateR1<float>({-1.0f, 0.0f, 1.0f, 2.0f});
+    const Shape shape = ShapeUtil::MakeShapeWithLayout(F32, {3}, {0});
+    const char* data =
+        static_cast<const char*>(storage.untyped_data()) + (misaligned ? 4 : 0);
+    BorrowingLiteral x(data, shape);
+    Literal expected_x = x.Clone();
+    TF_ASSERT_OK_AND_ASSIGN(
+        ExecutionInput input,
+        local_client_->LiteralToExecutionInput(
+            x, local_client_->default_device_ordinal(), allocator_));
+
+    std::unique_ptr<LocalExecutable> executable = CompileAddConstant(
+        local_client_, TestName(), HloInputOutputAliasConfig::kMayAlias);
+    std::vector<ExecutionInput> arguments;
+    arguments.push_back(std::move(input));
+    TF_ASSERT_OK_AND_ASSIGN(
+        ExecutionOutput output,
+        executable->Run(std::move(arguments), DefaultExecutableRunOptions()));
+    Literal expected = LiteralUtil::CreateR1<float>(
+        misaligned ? std::vector<float>{2.0f, 4.0f, 6.0f}
+                   : std::vector<float>{1.0f, 3.0f, 5.0f});
+    EXPECT_TRUE(LiteralTestUtil::Near(
+        expected, ShapedBufferToLiteral(output.Result()), error_spec_));
+    EXPECT_EQ(x, expected_x);
+    if (kBorrowsAlignedHostMemory && !misaligned) {
+      EXPECT_NE(output.Result().root_buffer().opaque(), data);
+    }
+  }
+}
+
+XLA_TEST_F(LocalClientExecuteTest,
+           DISABLED_ON_INTERPRETER(LiteralToExecutionInputMustAlias)) {
+  Literal x = LiteralUtil::CreateR1<float>({0.0f, 1.0f, 2.0f});
+  TF_ASSERT_OK_AND_ASSIGN(
+      ExecutionInput input,
+      local_client_->LiteralToExecutionInput(
+          x, local_client_->default_device_ordinal(), allocator_));
+
+  std::unique_ptr<LocalExecutable> executable = CompileAddConstant(
+      local_client_, TestName(), HloInputOutputAliasConfig::kMustAlias);
+  std::vector<ExecutionInput> arguments;
+  arguments.push_back(std::move(input));
+  StatusOr<ExecutionOutput> output =
+      executable->Run(std::move(arguments), DefaultExecutableRunOptions());
+  if (kBorrowsAlignedHostMemory) {
+    // The borrowed host memory can't be donated.
+    ASSERT_FALSE(output.ok());
+    EXPECT_THAT(output.status().error_message(),
+                ::testing::HasSubstr("must-alias"));
+  } else {
+    TF_ASSERT_OK(output.status());
+    LiteralTestUtil::ExpectR1Near<float>(
+        {2.0f, 4.0f, 6.0f},
+        ShapedBufferToLiteral(output.ValueOrDie().Result()),
+        error_spec_);
+  }
+  LiteralTestUtil::ExpectR1Equal<float>({0.0f, 1.0f, 2.0f}, x);
+}
+
+XLA_TEST_F(LocalClientExecuteTest, ShapedBufferToMutableBorrowingLiteral) {
+  XlaBuilder builder(TestName());
+  auto x = Parameter(&builder, 0, ShapeUtil::MakeShape(F32, {2, 2}), "x");
+  Neg(x);
+  auto x_value = LiteralToShapedBuffer(
+      LiteralUtil::CreateR2<float>({{1.0f, 2.0f}, {3.0f, 4.0f}}));
+  ScopedShapedBuffer result =
+      ExecuteLocallyOrDie(builder.Build().ValueOrDie(), {&x_value});
+
+  std::vector<float> out(4, 0.0f);
+  TF_ASSERT_OK(local_client_->ShapedBufferToLiteral(
+      result,
+      MutableBorrowingLiteral(reinterpret_cast<const char*>(out.data()),
+                              result.on_host_shape())));
+  EXPECT_EQ(out, std::vector<float>({-1.0f, -2.0f, -3.0f, -4.0f}));
+}
+
 // Disabled on interpreter backend since infeed HLO is unsupported.
 XLA_TEST_F(LocalClientExecuteTest, DISABLED_ON_INTERPRETER(InfeedTest)) {
   XlaBuilder builder(TestName());
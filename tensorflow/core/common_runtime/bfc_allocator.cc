@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <atomic>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
@@ -37,6 +38,13 @@ limitations under the License.
 namespace tensorflow {
 
 constexpr BFCAllocator::ChunkHandle BFCAllocator::kInvalidChunkHandle;
+constexpr size_t BFCAllocator::kMaxThreadCacheChunkBytes;
+constexpr int BFCAllocator::kNumThreadCacheSizeClasses;
+
+namespace {
+// Source of BFCAllocator::thread_cache_key_ values.
+std::atomic<int64_t> next_thread_cache_key{1};
+}  // namespace
 
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name,
@@ -256,7 +264,35 @@ void* BFCAllocator::AllocateRawInternalWithRetry(
 void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
                                 const AllocationAttributes& allocation_attr) {
   VLOG(3) << "AllocateRaw " << Name() << "  " << num_bytes;
-  void* result = [&] {
+  if (thread_cache_enabled_ && num_bytes > 0 &&
+      num_bytes <= kMaxThreadCacheChunkBytes &&
+      allocation_attr.freed_by_func == nullptr) {
+    const int size_class = ThreadCacheSizeClass(num_bytes);
+    void* result = AllocateFromThreadCache(size_class);
+    if (result == nullptr) {
+      result =
+          AllocateRawFromBins(unused_alignment,
+                              ThreadCacheSizeClassBytes(size_class),
+                              allocation_attr);
+      if (result != nullptr) {
+        ThreadCacheOwnerShard* shard = ThreadCacheOwnerShardFor(result);
+        mutex_lock l(shard->mu);
+        shard->size_classes[result] = size_class;
+      }
+    }
+    VLOG(3) << "AllocateRaw " << Name() << "  " << num_bytes << " " << result;
+    return result;
+  }
+  void* result = AllocateRawFromBins(unused_alignment, num_bytes,
+                                     allocation_attr);
+  VLOG(3) << "AllocateRaw " << Name() << "  " << num_bytes << " " << result;
+  return result;
+}
+
+void* BFCAllocator::AllocateRawFromBins(
+    size_t unused_alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  return [&] {
     if (!allocation_attr.retry_on_failure) {
       // Return immediately upon the first failure if this is for allocating an
       // optional scratch space.
@@ -287,8 +323,123 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
                                           allocation_attr);
     }
   }();
-  VLOG(3) << "AllocateRaw " << Name() << "  " << num_bytes << " " << result;
-  return result;
+}
+
+void BFCAllocator::EnableThreadLocalCache(size_t max_cached_bytes_per_thread) {
+  mutex_lock l(lock_);
+  DCHECK_EQ(next_allocation_id_, 1) << "EnableThreadLocalCache() must be "
+                                       "called before the first allocation.";
+  thread_cache_enabled_ = max_cached_bytes_per_thread > 0;
+  max_thread_cache_bytes_ = max_cached_bytes_per_thread;
+  thread_cache_key_ = next_thread_cache_key.fetch_add(1);
+}
+
+// static
+int BFCAllocator::ThreadCacheSizeClass(size_t num_bytes) {
+  DCHECK_GT(num_bytes, 0);
+  DCHECK_LE(num_bytes, kMaxThreadCacheChunkBytes);
+  const size_t rounded_bytes = RoundedBytes(num_bytes);
+  const int size_class =
+      Log2Ceiling64(rounded_bytes) - static_cast<int>(kMinAllocationBits);
+  DCHECK_LT(size_class, kNumThreadCacheSizeClasses);
+  return size_class;
+}
+
+BFCAllocator::ThreadCache* BFCAllocator::GetThreadCache() {
+  // The caches used by the calling thread, keyed by thread_cache_key_. The most
+  // recently used entry is remembered, since most threads only ever allocate
+  // from one caching allocator.
+  static thread_local absl::flat_hash_map<int64_t, ThreadCache*> caches;
+  static thread_local int64_t last_key = 0;
+  static thread_local ThreadCache* last_cache = nullptr;
+  if (last_key == thread_cache_key_) return last_cache;
+
+  ThreadCache*& cache = caches[thread_cache_key_];
+  if (cache == nullptr) {
+    mutex_lock l(thread_caches_mu_);
+    thread_caches_.push_back(absl::make_unique<ThreadCache>());
+    cache = thread_caches_.back().get();
+  }
+  last_key = thread_cache_key_;
+  last_cache = cache;
+  return cache;
+}
+
+void* BFCAllocator::AllocateFromThreadCache(int size_class) {
+  ThreadCache* cache = GetThreadCache();
+  mutex_lock l(cache->mu);
+  std::vector<void*>& free_list = cache->free_lists[size_class];
+  if (free_list.empty()) return nullptr;
+  void* ptr = free_list.back();
+  free_list.pop_back();
+  const size_t bytes = ThreadCacheSizeClassBytes(size_class);
+  cache->cached_bytes -= bytes;
+  thread_cache_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+  thread_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+  return ptr;
+}
+
+bool BFCAllocator::DeallocateToThreadCache(void* ptr) {
+  ThreadCacheOwnerShard* shard = ThreadCacheOwnerShardFor(ptr);
+  int size_class;
+  {
+    mutex_lock l(shard->mu);
+    auto it = shard->size_classes.find(ptr);
+    if (it == shard->size_classes.end()) return false;
+    size_class = it->second;
+  }
+
+  const size_t bytes = ThreadCacheSizeClassBytes(size_class);
+  ThreadCache* cache = GetThreadCache();
+  {
+    mutex_lock l(cache->mu);
+    if (cache->cached_bytes + bytes <= max_thread_cache_bytes_) {
+      cache->free_lists[size_class].push_back(ptr);
+      cache->cached_bytes += bytes;
+      thread_cache_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  // The calling thread's cache is full, so return the chunk to the bins.
+  {
+    mutex_lock l(shard->mu);
+    shard->size_classes.erase(ptr);
+  }
+  DeallocateRawInternal(ptr);
+  return true;
+}
+
+bool BFCAllocator::FlushThreadCachesLocked() {
+  if (!thread_cache_enabled_ ||
+      thread_cache_bytes_.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  bool freed_any = false;
+  mutex_lock caches_lock(thread_caches_mu_);
+  for (const auto& cache : thread_caches_) {
+    mutex_lock cache_lock(cache->mu);
+    for (int size_class = 0; size_class < kNumThreadCacheSizeClasses;
+         ++size_class) {
+      std::vector<void*>& free_list = cache->free_lists[size_class];
+      for (void* ptr : free_list) {
+        ThreadCacheOwnerShard* shard = ThreadCacheOwnerShardFor(ptr);
+        {
+          mutex_lock shard_lock(shard->mu);
+          shard->size_classes.erase(ptr);
+        }
+        DeallocateRawLocked(ptr);
+        freed_any = true;
+      }
+      const size_t bytes =
+          free_list.size() * ThreadCacheSizeClassBytes(size_class);
+      cache->cached_bytes -= bytes;
+      thread_cache_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+      free_list.clear();
+    }
+  }
+  VLOG(2) << "Flushed thread-local caches of allocator " << Name();
+  return freed_any;
 }
 
 // static
@@ -427,6 +578,16 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     }
   }
 
+  // Chunks held in thread-local caches are free from the clients' point of
+  // view. Return them to the bins before declaring an out-of-memory condition.
+  if (FlushThreadCachesLocked()) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      AddTraceMe("MemoryAllocation", ptr);
+      return ptr;
+    }
+  }
+
   if ((freed_before == 0) && (!timestamped_chunks_.empty())) {
     // We're unable to satisfy an allocation request without a specific
     // timestamp requirement.  Rather than fail, try merging any held-out
@@ -492,6 +653,89 @@ double BFCAllocator::GetFragmentation() {
          bytes_available;
 }
 
+double BFCAllocator::Fragmentation() {
+  mutex_lock l(lock_);
+  if (total_region_allocated_bytes_ <= stats_.bytes_in_use) return 0.0;
+  return GetFragmentation();
+}
+
+size_t BFCAllocator::Defragment(size_t min_release_bytes) {
+  const size_t alignment = sub_allocator_->FreeRangeAlignment();
+  if (alignment == 0) return 0;
+  min_release_bytes = std::max(min_release_bytes, alignment);
+
+  mutex_lock l(lock_);
+  // Collect the free chunks first, since releasing memory modifies the
+  // regions.
+  std::vector<ChunkHandle> free_chunks;
+  for (const AllocationRegion& region : region_manager_.regions()) {
+    ChunkHandle h = region_manager_.get_handle(region.ptr());
+    while (h != kInvalidChunkHandle) {
+      const Chunk* c = ChunkFromHandle(h);
+      // Chunks with a freed_at_count may still be used by pending work.
+      if (!c->in_use() && c->freed_at_count == 0) free_chunks.push_back(h);
+      h = c->next;
+    }
+  }
+
+  size_t released_bytes = 0;
+  for (ChunkHandle h : free_chunks) {
+    Chunk* c = ChunkFromHandle(h);
+    const uintptr_t chunk_begin = reinterpret_cast<uintptr_t>(c->ptr);
+    const uintptr_t chunk_end = chunk_begin + c->size;
+    const uintptr_t begin =
+        (chunk_begin + alignment - 1) / alignment * alignment;
+    const uintptr_t end = chunk_end / alignment * alignment;
+    if (end <= begin || end - begin < min_release_bytes) continue;
+
+    MaybeRemoveFreeChunkFromBin(h);
+    // The chunks on either side of the released range end their regions.
+    ChunkHandle tail = kInvalidChunkHandle;
+    if (end < chunk_end) {
+      tail = AllocateChunk();
+      // AllocateChunk() may have moved the chunks.
+      c = ChunkFromHandle(h);
+      Chunk* t = ChunkFromHandle(tail);
+      t->ptr = reinterpret_cast<void*>(end);
+      t->size = chunk_end - end;
+      t->requested_size = 0;
+      t->allocation_id = -1;
+      t->bin_num = kInvalidBinNum;
+      t->freed_at_count = 0;
+      t->prev = kInvalidChunkHandle;
+      t->next = c->next;
+      if (t->next != kInvalidChunkHandle) ChunkFromHandle(t->next)->prev = tail;
+      region_manager_.set_handle(t->ptr, tail);
+    } else if (c->next != kInvalidChunkHandle) {
+      ChunkFromHandle(c->next)->prev = kInvalidChunkHandle;
+    }
+    c->next = kInvalidChunkHandle;
+    if (begin > chunk_begin) {
+      c->size = begin - chunk_begin;
+    } else {
+      if (c->prev != kInvalidChunkHandle) {
+        ChunkFromHandle(c->prev)->next = kInvalidChunkHandle;
+      }
+      DeleteChunk(h);
+      h = kInvalidChunkHandle;
+    }
+
+    void* release_ptr = reinterpret_cast<void*>(begin);
+    region_manager_.RemoveRange(release_ptr, reinterpret_cast<void*>(end));
+    sub_allocator_->Free(release_ptr, end - begin);
+    total_region_allocated_bytes_ -= end - begin;
+    released_bytes += end - begin;
+
+    if (h != kInvalidChunkHandle) InsertFreeChunkIntoBin(h);
+    if (tail != kInvalidChunkHandle) InsertFreeChunkIntoBin(tail);
+  }
+  if (released_bytes > 0) {
+    VLOG(1) << "Released " << strings::HumanReadableNumBytes(released_bytes)
+            << " of free memory from " << Name() << ".";
+  }
+  return released_bytes;
+}
+
 void BFCAllocator::AddTraceMe(absl::string_view traceme_name, const void* ptr) {
   BFCAllocator::Chunk* chunk = ChunkFromHandle(region_manager_.get_handle(ptr));
   AddTraceMe(traceme_name, chunk->ptr, chunk->requested_size, chunk->size);
@@ -524,6 +768,42 @@ void BFCAllocator::AddTraceMe(absl::string_view traceme_name,
                                {"shape", annotation.pending_shape_func()}});
           },
       /*level=*/profiler::TraceMeLevel::kInfo);
+  MaybeAddMemoryMapTraceMe();
+}
+
+void BFCAllocator::MaybeAddMemoryMapTraceMe() {
+  if (!profiler::TraceMe::Active(profiler::TraceMeLevel::kVerbose)) return;
+  const uint64 now_micros = Env::Default()->NowMicros();
+  if (now_micros < next_memory_map_traceme_micros_) return;
+  next_memory_map_traceme_micros_ =
+      now_micros + kMemoryMapTraceMeIntervalMicros;
+  profiler::TraceMe::InstantActivity(
+      [this]() TF_NO_THREAD_SAFETY_ANALYSIS {
+        // The non-empty bins, as
+        // "bin:bytes_in_use:bytes_in_bin:chunks_in_use:chunks_in_bin;".
+        std::string bin_summary;
+        const std::array<BinDebugInfo, kNumBins> bin_infos =
+            get_bin_debug_info();
+        for (BinNum bin_num = 0; bin_num < kNumBins; bin_num++) {
+          const BinDebugInfo& bin_info = bin_infos[bin_num];
+          if (bin_info.total_chunks_in_bin == 0) continue;
+          strings::StrAppend(&bin_summary, bin_num, ":",
+                             bin_info.total_bytes_in_use, ":",
+                             bin_info.total_bytes_in_bin, ":",
+                             bin_info.total_chunks_in_use, ":",
+                             bin_info.total_chunks_in_bin, ";");
+        }
+        int64_t bytes_available =
+            memory_limit_ - stats_.bytes_reserved - stats_.bytes_in_use;
+        return tensorflow::profiler::TraceMeEncode(
+            "MemoryMapSnapshot", {{"allocator_name", name_},
+                                  {"bytes_reserved", stats_.bytes_reserved},
+                                  {"bytes_allocated", stats_.bytes_in_use},
+                                  {"bytes_available", bytes_available},
+                                  {"fragmentation", GetFragmentation()},
+                                  {"bin_summary", bin_summary}});
+      },
+      /*level=*/profiler::TraceMeLevel::kVerbose);
 }
 
 void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
@@ -655,7 +935,10 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(3) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
-  DeallocateRawInternal(ptr);
+  if (!thread_cache_enabled_ || ptr == nullptr ||
+      !DeallocateToThreadCache(ptr)) {
+    DeallocateRawInternal(ptr);
+  }
   retry_helper_.NotifyDealloc();
 }
 
@@ -665,7 +948,10 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     return;
   }
   mutex_lock l(lock_);
+  DeallocateRawLocked(ptr);
+}
 
+void BFCAllocator::DeallocateRawLocked(void* ptr) {
   // Find the chunk from the ptr.
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
@@ -1115,10 +1401,24 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
   MemoryDump md;
   md.set_allocator_name(Name());
 
+  // Chunks held in thread-local caches are reported as free.
+  absl::flat_hash_set<const void*> thread_cached_chunks;
+  if (thread_cache_enabled_) {
+    mutex_lock caches_lock(thread_caches_mu_);
+    for (const auto& cache : thread_caches_) {
+      mutex_lock cache_lock(cache->mu);
+      for (const std::vector<void*>& free_list : cache->free_lists) {
+        thread_cached_chunks.insert(free_list.begin(), free_list.end());
+      }
+    }
+  }
+
   // Record the general stats
   MemAllocatorStats* mas = md.mutable_stats();
-  mas->set_num_allocs(stats_.num_allocs);
-  mas->set_bytes_in_use(stats_.bytes_in_use);
+  mas->set_num_allocs(stats_.num_allocs +
+                      thread_cache_hits_.load(std::memory_order_relaxed));
+  mas->set_bytes_in_use(stats_.bytes_in_use -
+                        thread_cache_bytes_.load(std::memory_order_relaxed));
   mas->set_peak_bytes_in_use(stats_.peak_bytes_in_use);
   mas->set_largest_alloc_size(stats_.largest_alloc_size);
 
@@ -1143,7 +1443,7 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
     while (h != kInvalidChunkHandle) {
       const Chunk* c = ChunkFromHandle(h);
       MemChunk* mc = md.add_chunk();
-      mc->set_in_use(c->in_use());
+      mc->set_in_use(c->in_use() && !thread_cached_chunks.contains(c->ptr));
       mc->set_address(reinterpret_cast<uint64>(c->ptr));
       mc->set_size(c->size);
       mc->set_requested_size(c->requested_size);
@@ -1179,11 +1479,18 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  if (!thread_cache_enabled_) {
+    return stats_;
+  }
+  AllocatorStats stats = stats_;
+  stats.num_allocs += thread_cache_hits_.load(std::memory_order_relaxed);
+  stats.bytes_in_use -= thread_cache_bytes_.load(std::memory_order_relaxed);
+  return stats;
 }
 
 bool BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
+  thread_cache_hits_.store(0, std::memory_order_relaxed);
   stats_.num_allocs = 0;
   stats_.peak_bytes_in_use = stats_.bytes_in_use;
   stats_.largest_alloc_size = 0;
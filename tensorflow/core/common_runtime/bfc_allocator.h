@@ -17,12 +17,14 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
@@ -85,6 +87,58 @@ class BFCAllocator : public Allocator {
 
   MemoryDump RecordMemoryMap();
 
+  // Returns the fraction of the free memory of this allocator that is not in
+  // its largest free chunk, which is in [0, 1].
+  double Fragmentation();
+
+  // Returns the memory behind large free chunks to the sub-allocator, without
+  // moving any allocations, and returns the number of bytes released.
+  //
+  // Only has an effect if the sub-allocator supports freeing parts of the
+  // memory it returned (see SubAllocator::FreeRangeAlignment()). The aligned
+  // part of every free chunk that covers at least `min_release_bytes` bytes is
+  // freed, and the region containing it is split around it. Later growth of
+  // the allocator obtains the released bytes as one contiguous region: e.g.
+  // with GpuVirtualMemAllocator, the physical pages behind several holes
+  // between live allocations are remapped at the end of the address space.
+  // This reduces the fragmentation reported by Fragmentation().
+  //
+  // REQUIRES: No work that may access memory freed to this allocator is
+  // pending, e.g. the device is idle between steps.
+  size_t Defragment(size_t min_release_bytes);
+
+  // Makes DefragmentBetweenSteps() call Defragment(min_release_bytes). Off by
+  // default, since releasing memory makes later growth remap it.
+  void EnableDefragmentBetweenSteps(size_t min_release_bytes) {
+    defragment_min_release_bytes_ = min_release_bytes;
+  }
+
+  // Called by the device when no work is pending, e.g. after a step. Returns
+  // the number of bytes released, which is 0 unless enabled with
+  // EnableDefragmentBetweenSteps().
+  size_t DefragmentBetweenSteps() {
+    if (defragment_min_release_bytes_ == 0) return 0;
+    return Defragment(defragment_min_release_bytes_);
+  }
+
+  // Enables a per-thread cache of small chunks in front of the bins.
+  //
+  // When enabled, allocations of at most kMaxThreadCacheChunkBytes bytes are
+  // rounded up to a power-of-two size class, and freed chunks of such sizes are
+  // kept in a cache owned by the freeing thread, holding at most
+  // `max_cached_bytes_per_thread` bytes. Subsequent allocations of the same
+  // size class on that thread are served from the cache without taking
+  // `lock_`. Cached chunks are returned to the bins when the allocator would
+  // otherwise run out of memory.
+  //
+  // AllocatorStats and RecordMemoryMap() report cached chunks as free. The
+  // cache is bypassed for allocations that set
+  // AllocationAttributes::freed_by_func, so it should only be enabled for
+  // allocators that do not use timestamped chunks (e.g. host memory).
+  //
+  // REQUIRES: No memory has been allocated from this allocator yet.
+  void EnableThreadLocalCache(size_t max_cached_bytes_per_thread);
+
  protected:
   // This setting controls when a chunk should be split, if its size exceeds the
   // requested allocation size. It is not expected to be changed after
@@ -105,6 +159,11 @@ class BFCAllocator : public Allocator {
       const AllocationAttributes& allocation_attr);
 
   void DeallocateRawInternal(void* ptr);
+  void DeallocateRawLocked(void* ptr) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Allocates `num_bytes` from the bins, honoring `allocation_attr`.
+  void* AllocateRawFromBins(size_t alignment, size_t num_bytes,
+                            const AllocationAttributes& allocation_attr);
 
   // Chunks whose freed_at_count is later than the safe frontier value are kept
   // on a special list and not subject to merging immediately upon being freed.
@@ -138,6 +197,13 @@ class BFCAllocator : public Allocator {
                   int64_t req_bytes, int64_t alloc_bytes)
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Adds a TraceMe of the occupancy of the bins, for the fragmentation
+  // timeline of the memory profile. As it walks all the chunks, it is only
+  // added at the verbose level, and at most every
+  // kMemoryMapTraceMeIntervalMicros.
+  void MaybeAddMemoryMapTraceMe() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  static constexpr uint64 kMemoryMapTraceMeIntervalMicros = 10 * 1000;
+
   // A ChunkHandle is an index into the chunks_ vector in BFCAllocator
   // kInvalidChunkHandle means an invalid chunk
   typedef size_t ChunkHandle;
@@ -312,6 +378,17 @@ class BFCAllocator : public Allocator {
     void set_handle(const void* p, ChunkHandle h) { handles_[IndexFor(p)] = h; }
     void erase(const void* p) { set_handle(p, kInvalidChunkHandle); }
 
+    // Returns a region for [ptr, ptr + memory_size), which must be within this
+    // region, with the same handles.
+    AllocationRegion Slice(void* ptr, size_t memory_size) const {
+      AllocationRegion slice(ptr, memory_size);
+      const size_t first = IndexFor(ptr);
+      std::copy(handles_.begin() + first,
+                handles_.begin() + first + slice.handles_.size(),
+                slice.handles_.begin());
+      return slice;
+    }
+
    private:
     void Swap(AllocationRegion* other) {
       std::swap(ptr_, other->ptr_);
@@ -394,6 +471,31 @@ class BFCAllocator : public Allocator {
       return regions_.erase(it);
     }
 
+    // Removes [ptr, end_ptr) from the region containing it, which is replaced
+    // by the non-empty parts before and after the removed range.
+    void RemoveRange(void* ptr, void* end_ptr) {
+      auto it =
+          std::upper_bound(regions_.begin(), regions_.end(), ptr, &Comparator);
+      DCHECK(it != regions_.end());
+      char* begin = static_cast<char*>(ptr);
+      char* end = static_cast<char*>(end_ptr);
+      char* region_begin = static_cast<char*>(it->ptr());
+      char* region_end = static_cast<char*>(it->end_ptr());
+      DCHECK_LE(region_begin, begin);
+      DCHECK_LE(end, region_end);
+      std::vector<AllocationRegion> parts;
+      if (region_begin < begin) {
+        parts.push_back(it->Slice(region_begin, begin - region_begin));
+      }
+      if (end < region_end) {
+        parts.push_back(it->Slice(end, region_end - end));
+      }
+      it = regions_.erase(it);
+      for (AllocationRegion& part : parts) {
+        it = regions_.insert(it, std::move(part)) + 1;
+      }
+    }
+
     ChunkHandle get_handle(const void* p) const {
       return RegionFor(p)->get_handle(p);
     }
@@ -511,6 +613,56 @@ class BFCAllocator : public Allocator {
     size_t total_chunks_in_bin = 0;
   };
 
+  // The largest chunk size that may be held in a thread-local cache, and the
+  // number of power-of-two size classes (from kMinAllocationSize up to
+  // kMaxThreadCacheChunkBytes) that the caches are bucketed into.
+  static constexpr size_t kMaxThreadCacheChunkBytes = 64 << 10;
+  static constexpr int kNumThreadCacheSizeClasses = 9;
+  static constexpr int kNumThreadCacheOwnerShards = 32;
+
+  // Free chunks cached for reuse by a single thread. `mu` is only contended
+  // when the caches are flushed or inspected by another thread.
+  struct ThreadCache {
+    mutex mu;
+    std::array<std::vector<void*>, kNumThreadCacheSizeClasses> free_lists
+        TF_GUARDED_BY(mu);
+    size_t cached_bytes TF_GUARDED_BY(mu) = 0;
+  };
+
+  // Maps every chunk owned by the thread-local caching layer (either in use by
+  // a client, or cached by a thread) to its size class. Sharded by address, so
+  // that DeallocateRaw() can identify cacheable chunks without taking `lock_`.
+  struct ThreadCacheOwnerShard {
+    mutex mu;
+    absl::flat_hash_map<const void*, int> size_classes TF_GUARDED_BY(mu);
+  };
+
+  static int ThreadCacheSizeClass(size_t num_bytes);
+  static size_t ThreadCacheSizeClassBytes(int size_class) {
+    return kMinAllocationSize << size_class;
+  }
+  ThreadCacheOwnerShard* ThreadCacheOwnerShardFor(const void* ptr) {
+    return &thread_cache_owners_[(reinterpret_cast<std::uintptr_t>(ptr) >>
+                                  kMinAllocationBits) %
+                                 kNumThreadCacheOwnerShards];
+  }
+
+  // Returns the calling thread's cache for this allocator, creating it the
+  // first time it is requested.
+  ThreadCache* GetThreadCache();
+
+  // Returns a cached chunk of `size_class`, or nullptr if the calling thread
+  // has none.
+  void* AllocateFromThreadCache(int size_class);
+
+  // Returns true if `ptr` is owned by the caching layer, in which case it has
+  // been either cached or returned to the bins.
+  bool DeallocateToThreadCache(void* ptr);
+
+  // Returns every cached chunk to the bins. Returns true if any chunk was
+  // freed.
+  bool FlushThreadCachesLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Computes and returns a BinDebugInfo for each Bin.
   std::array<BinDebugInfo, kNumBins> get_bin_debug_info()
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
@@ -588,6 +740,9 @@ class BFCAllocator : public Allocator {
 
   std::atomic<uint64> safe_frontier_ = {0};
 
+  // See EnableDefragmentBetweenSteps(). 0 if disabled.
+  size_t defragment_min_release_bytes_ = 0;
+
   // Structures mutable after construction
   mutable mutex lock_;
   RegionManager region_manager_ TF_GUARDED_BY(lock_);
@@ -603,6 +758,24 @@ class BFCAllocator : public Allocator {
 
   // Stats.
   AllocatorStats stats_ TF_GUARDED_BY(lock_);
+  uint64 next_memory_map_traceme_micros_ TF_GUARDED_BY(lock_) = 0;
+
+  // Thread-local caching layer; see EnableThreadLocalCache().
+  bool thread_cache_enabled_ = false;
+  size_t max_thread_cache_bytes_ = 0;
+  // Unique among all BFCAllocators, so that per-thread cache lookups are not
+  // confused by a new allocator reusing a destroyed allocator's address.
+  int64_t thread_cache_key_ = 0;
+  mutex thread_caches_mu_;
+  std::vector<std::unique_ptr<ThreadCache>> thread_caches_
+      TF_GUARDED_BY(thread_caches_mu_);
+  std::array<ThreadCacheOwnerShard, kNumThreadCacheOwnerShards>
+      thread_cache_owners_;
+  // Total bytes currently held in thread caches. These chunks are in use from
+  // the point of view of the bins, but free from the point of view of clients.
+  std::atomic<int64_t> thread_cache_bytes_{0};
+  // Number of allocations served from thread caches.
+  std::atomic<int64_t> thread_cache_hits_{0};
 #ifdef TENSORFLOW_MEM_DEBUG
   int64 action_counter_ = 0 TF_GUARDED_BY(lock_);
 #define MEM_DEBUG_SIZE_HISTORY_SIZE 4096
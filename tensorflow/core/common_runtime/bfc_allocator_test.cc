@@ -0,0 +1,249 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/bfc_memory_map.pb.h"
+
+namespace tensorflow {
+namespace {
+
+std::unique_ptr<BFCAllocator> NewCPUBFCAllocator(size_t memory_limit) {
+  return absl::make_unique<BFCAllocator>(
+      new BasicCPUAllocator(port::kNUMANoAffinity, {}, {}), memory_limit,
+      /*allow_growth=*/true, "cpu_bfc");
+}
+
+// Hands out consecutive ranges of one buffer, any kMiB-aligned part of which
+// may be freed on its own.
+class PartiallyFreeableSubAllocator : public SubAllocator {
+ public:
+  static constexpr size_t kMiB = 1 << 20;
+
+  explicit PartiallyFreeableSubAllocator(size_t size)
+      : SubAllocator({}, {}),
+        buffer_(static_cast<char*>(port::AlignedMalloc(size, kMiB))),
+        size_(size) {}
+  ~PartiallyFreeableSubAllocator() override { port::AlignedFree(buffer_); }
+
+  void* Alloc(size_t alignment, size_t num_bytes,
+              size_t* bytes_received) override {
+    if (next_ + num_bytes > size_) return nullptr;
+    void* ptr = buffer_ + next_;
+    next_ += num_bytes;
+    *bytes_received = num_bytes;
+    return ptr;
+  }
+  void Free(void* ptr, size_t num_bytes) override {
+    freed_bytes_ += num_bytes;
+  }
+  bool SupportsCoalescing() const override { return true; }
+  size_t FreeRangeAlignment() const override { return kMiB; }
+
+  size_t freed_bytes() const { return freed_bytes_; }
+
+ private:
+  char* const buffer_;
+  const size_t size_;
+  size_t next_ = 0;
+  size_t freed_bytes_ = 0;
+};
+
+TEST(BFCAllocatorDefragmentTest, ReleasesFreeChunksBetweenAllocations) {
+  constexpr size_t kMiB = PartiallyFreeableSubAllocator::kMiB;
+  auto* sub_allocator = new PartiallyFreeableSubAllocator(64 * kMiB);
+  BFCAllocator a(sub_allocator, 16 * kMiB, /*allow_growth=*/false, "bfc");
+
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 4; ++i) {
+    ptrs.push_back(a.AllocateRaw(64, 4 * kMiB));
+    ASSERT_NE(ptrs.back(), nullptr);
+  }
+  EXPECT_EQ(a.Fragmentation(), 0.0);
+  // Leaves two free chunks of 4MiB, between the remaining allocations.
+  a.DeallocateRaw(ptrs[0]);
+  a.DeallocateRaw(ptrs[2]);
+  EXPECT_DOUBLE_EQ(a.Fragmentation(), 0.5);
+
+  EXPECT_EQ(a.Defragment(/*min_release_bytes=*/8 * kMiB), 0);
+  EXPECT_EQ(a.Defragment(/*min_release_bytes=*/kMiB), 8 * kMiB);
+  EXPECT_EQ(sub_allocator->freed_bytes(), 8 * kMiB);
+  EXPECT_EQ(a.Fragmentation(), 0.0);
+
+  // The released memory is obtained again as one contiguous region.
+  void* large = a.AllocateRaw(64, 8 * kMiB);
+  ASSERT_NE(large, nullptr);
+  EXPECT_EQ(a.GetStats()->bytes_in_use, 16 * kMiB);
+
+  // The allocations that were not moved are still usable.
+  memset(ptrs[1], 1, 4 * kMiB);
+  memset(ptrs[3], 1, 4 * kMiB);
+  memset(large, 1, 8 * kMiB);
+  a.DeallocateRaw(ptrs[1]);
+  a.DeallocateRaw(ptrs[3]);
+  a.DeallocateRaw(large);
+}
+
+TEST(BFCAllocatorDefragmentTest, DefragmentBetweenStepsIsOptIn) {
+  constexpr size_t kMiB = PartiallyFreeableSubAllocator::kMiB;
+  auto* sub_allocator = new PartiallyFreeableSubAllocator(64 * kMiB);
+  BFCAllocator a(sub_allocator, 16 * kMiB, /*allow_growth=*/false, "bfc");
+
+  void* first = a.AllocateRaw(64, 4 * kMiB);
+  void* second = a.AllocateRaw(64, 4 * kMiB);
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+  a.DeallocateRaw(first);
+  EXPECT_EQ(a.DefragmentBetweenSteps(), 0);
+  EXPECT_EQ(sub_allocator->freed_bytes(), 0);
+
+  a.EnableDefragmentBetweenSteps(/*min_release_bytes=*/kMiB);
+  // Releases the chunk of `first` and the free memory after `second`.
+  EXPECT_EQ(a.DefragmentBetweenSteps(), 12 * kMiB);
+  EXPECT_EQ(sub_allocator->freed_bytes(), 12 * kMiB);
+  a.DeallocateRaw(second);
+}
+
+TEST(BFCAllocatorThreadLocalCacheTest, ReusesChunksOnSameThread) {
+  auto a = NewCPUBFCAllocator(1 << 30);
+  a->EnableThreadLocalCache(1 << 20);
+
+  void* p1 = a->AllocateRaw(64, 1000);
+  ASSERT_NE(p1, nullptr);
+  a->DeallocateRaw(p1);
+  // The chunk is cached, so it is reported as free.
+  EXPECT_EQ(a->GetStats()->bytes_in_use, 0);
+
+  // An allocation of the same size class hits the cache.
+  void* p2 = a->AllocateRaw(64, 900);
+  EXPECT_EQ(p1, p2);
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_EQ(stats->num_allocs, 2);
+  EXPECT_EQ(stats->bytes_in_use, 1024);
+  a->DeallocateRaw(p2);
+}
+
+TEST(BFCAllocatorThreadLocalCacheTest, LargeAllocationsBypassCache) {
+  auto a = NewCPUBFCAllocator(1 << 30);
+  a->EnableThreadLocalCache(1 << 20);
+
+  void* p = a->AllocateRaw(64, 1 << 20);
+  ASSERT_NE(p, nullptr);
+  EXPECT_EQ(a->RequestedSize(p), 1 << 20);
+  a->DeallocateRaw(p);
+  EXPECT_EQ(a->GetStats()->bytes_in_use, 0);
+}
+
+TEST(BFCAllocatorThreadLocalCacheTest, MemoryMapReportsCachedChunksAsFree) {
+  auto a = NewCPUBFCAllocator(1 << 30);
+  a->EnableThreadLocalCache(1 << 20);
+
+  void* cached = a->AllocateRaw(64, 4096);
+  void* live = a->AllocateRaw(64, 4096);
+  a->DeallocateRaw(cached);
+
+  MemoryDump md = a->RecordMemoryMap();
+  EXPECT_EQ(md.stats().bytes_in_use, 4096);
+  for (const MemChunk& chunk : md.chunk()) {
+    if (chunk.address() == reinterpret_cast<uint64>(cached)) {
+      EXPECT_FALSE(chunk.in_use());
+    } else if (chunk.address() == reinterpret_cast<uint64>(live)) {
+      EXPECT_TRUE(chunk.in_use());
+    }
+  }
+  a->DeallocateRaw(live);
+}
+
+TEST(BFCAllocatorThreadLocalCacheTest, FlushesCachesBeforeRunningOutOfMemory) {
+  // A single 2MiB region, which the thread caches may hold entirely.
+  auto a = NewCPUBFCAllocator(2 << 20);
+  a->EnableThreadLocalCache(2 << 20);
+
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 32; ++i) {
+    void* p = a->AllocateRaw(64, 64 << 10);
+    ASSERT_NE(p, nullptr);
+    ptrs.push_back(p);
+  }
+  for (void* p : ptrs) a->DeallocateRaw(p);
+
+  // This allocation can only succeed once the cached chunks are returned to
+  // the bins and coalesced.
+  AllocationAttributes attrs;
+  attrs.retry_on_failure = false;
+  void* large = a->AllocateRaw(64, 2 << 20, attrs);
+  ASSERT_NE(large, nullptr);
+  a->DeallocateRaw(large);
+  EXPECT_EQ(a->GetStats()->bytes_in_use, 0);
+}
+
+TEST(BFCAllocatorThreadLocalCacheTest, ChunksMayBeFreedOnOtherThreads) {
+  auto a = NewCPUBFCAllocator(1 << 30);
+  a->EnableThreadLocalCache(64 << 10);
+
+  constexpr int kNumThreads = 8;
+  constexpr int kNumAllocations = 1000;
+  std::vector<void*> ptrs(kNumThreads * kNumAllocations);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&a, &ptrs, t]() {
+        for (int i = 0; i < kNumAllocations; ++i) {
+          ptrs[t * kNumAllocations + i] = a->AllocateRaw(64, 256 + i % 4096);
+        }
+      });
+    }
+  }
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&a, &ptrs, t]() {
+        // Free the chunks allocated by a different thread.
+        const int owner = (t + 1) % kNumThreads;
+        for (int i = 0; i < kNumAllocations; ++i) {
+          a->DeallocateRaw(ptrs[owner * kNumAllocations + i]);
+        }
+      });
+    }
+  }
+  EXPECT_EQ(a->GetStats()->bytes_in_use, 0);
+}
+
+void BM_AllocateDeallocate(::testing::benchmark::State& state) {
+  const bool use_thread_cache = state.range(0);
+  static BFCAllocator* a = NewCPUBFCAllocator(1 << 30).release();
+  static BFCAllocator* cached = [] {
+    BFCAllocator* a = NewCPUBFCAllocator(1 << 30).release();
+    a->EnableThreadLocalCache(1 << 20);
+    return a;
+  }();
+  BFCAllocator* allocator = use_thread_cache ? cached : a;
+  for (auto s : state) {
+    void* p = allocator->AllocateRaw(64, 4096);
+    allocator->DeallocateRaw(p);
+  }
+}
+BENCHMARK(BM_AllocateDeallocate)->Arg(0)->Arg(1)->ThreadRange(1, 64);
+
+}  // namespace
+}  // namespace tensorflow
@@ -48,6 +48,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/port.h"
@@ -1355,10 +1358,39 @@ Status ColocationGraph::GetDevicesForNode(
 }
 
 Status ColocationGraph::InitializeMembers() {
-  for (Node* node : graph_.op_nodes()) {
-    Status status = InitializeMember(*node, &members_[node->id()]);
-    if (!status.ok()) {
-      return AttachDef(status, *node);
+  // Graphs with at least this many nodes have their members initialized with
+  // the help of a thread pool, which is not worth starting for smaller graphs.
+  constexpr int kMinNodesForParallelInitialization = 8192;
+  if (graph_.num_op_nodes() < kMinNodesForParallelInitialization) {
+    for (Node* node : graph_.op_nodes()) {
+      Status status = InitializeMember(*node, &members_[node->id()]);
+      if (!status.ok()) {
+        return AttachDef(status, *node);
+      }
+    }
+    return Status::OK();
+  }
+
+  // The members are independent of each other, and initializing one is
+  // dominated by the kernel lookups for each device type.
+  std::vector<Node*> nodes;
+  nodes.reserve(graph_.num_op_nodes());
+  for (Node* node : graph_.op_nodes()) nodes.push_back(node);
+  std::vector<Status> statuses(nodes.size());
+  {
+    thread::ThreadPool pool(Env::Default(), "colocation_graph",
+                            port::MaxParallelism());
+    pool.ParallelFor(nodes.size(), /*cost_per_unit=*/10000,
+                     [this, &nodes, &statuses](int64_t begin, int64_t end) {
+                       for (int64_t i = begin; i < end; ++i) {
+                         statuses[i] = InitializeMember(
+                             *nodes[i], &members_[nodes[i]->id()]);
+                       }
+                     });
+  }
+  for (int i = 0; i < nodes.size(); ++i) {
+    if (!statuses[i].ok()) {
+      return AttachDef(statuses[i], *nodes[i]);
     }
   }
   return Status::OK();
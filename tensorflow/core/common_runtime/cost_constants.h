@@ -23,6 +23,14 @@ constexpr char kTpuCostName[] = "tpu";
 constexpr char kGcuCostName[] = "gcu";
 constexpr char kNoOpCostName[] = "no_op";
 
+// Time spent in the kernels of a request, for each type of device, named by
+// the lower-case device type and kKernelCostSuffix. For devices that run
+// kernels asynchronously, such as GPUs, it is the time spent launching them.
+constexpr char kKernelCostSuffix[] = "_kernel";
+constexpr char kCpuKernelCostName[] = "cpu_kernel";
+// Time spent by the intra-op threads of a request run with a RunHandler.
+constexpr char kIntraOpCostName[] = "intra_op";
+
 // Each type of per-request cost could have the following versions.
 //
 // A server may have costs that cannot be directly attributed to a specific
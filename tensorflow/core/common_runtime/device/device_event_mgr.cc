@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -28,6 +29,17 @@ namespace {
 //  - Should EventMgrs be shared between devices on a machine with multiple
 //  devices of the same type?
 static const int kNumThreads = 2;
+
+bool UseHostCallbacks() {
+  bool use_host_callbacks;
+  Status s = ReadBoolFromEnvVar("TF_EVENT_MGR_USE_HOST_CALLBACKS",
+                                /*default_val=*/false, &use_host_callbacks);
+  if (!s.ok()) {
+    LOG(ERROR) << "Polling for device events: " << s;
+    return false;
+  }
+  return use_host_callbacks;
+}
 }  // namespace
 
 namespace device_event_mgr {
@@ -95,13 +107,19 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
       polling_active_delay_usecs_(gpu_options.polling_active_delay_usecs()
                                       ? gpu_options.polling_active_delay_usecs()
                                       : 10),
+      use_host_callbacks_(UseHostCallbacks()),
       threadpool_(Env::Default(), "Device_Event_Manager", kNumThreads) {
   device_event_mgr::InitThreadpoolLabels(&threadpool_);
-  StartPollingLoop();
+  if (!use_host_callbacks_) StartPollingLoop();
 }
 
 EventMgr::~EventMgr() {
   StopPollingLoop();
+  {
+    // The pending host callbacks refer to this object.
+    mutex_lock l(mu_);
+    while (num_pending_callbacks_ > 0) callbacks_done_.wait(l);
+  }
 
   // Events are owned by this object.
   for (auto& e : free_events_) {
@@ -185,6 +203,37 @@ void EventMgr::QueueInUse(se::Stream* stream, InUse in_use) {
   if (was_empty) events_pending_.notify_all();
 }
 
+void EventMgr::QueueHostCallback(se::Stream* stream,
+                                 std::function<void()> func) {
+  {
+    mutex_lock l(mu_);
+    ++num_pending_callbacks_;
+  }
+  // Shared between the host callback and the fallback below, so that `func`
+  // runs exactly once even if the callback is enqueued on a failed stream.
+  auto state = std::make_shared<HostCallbackState>();
+  state->func = std::move(func);
+  stream->ThenDoHostCallback([this, state]() {
+    // If the fallback below already ran `func`, this object may be gone.
+    if (!state->claimed.exchange(true)) RunHostCallback(std::move(state->func));
+  });
+  if (!stream->ok() && !state->claimed.exchange(true)) {
+    // The callback may never run. Rather than drop `func` and block the
+    // destructor forever, schedule it now.
+    LOG(WARNING) << "Stream is in an error state, running host callback "
+                    "without waiting for it";
+    RunHostCallback(std::move(state->func));
+  }
+}
+
+void EventMgr::RunHostCallback(std::function<void()> func) {
+  // Host callbacks must not call into the device runtime, which `func` may
+  // do, so it runs on the threadpool like the functions of polled events.
+  threadpool_.Schedule(std::move(func));
+  mutex_lock l(mu_);
+  if (--num_pending_callbacks_ == 0) callbacks_done_.notify_all();
+}
+
 // This function must be called periodically to check whether pending
 // events have recorded, and then retire them.  Initial observations
 // suggest that typical behavior in a TensorFlow program is to have
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_DEVICE_DEVICE_EVENT_MGR_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_DEVICE_DEVICE_EVENT_MGR_H_
 
+#include <atomic>
 #include <deque>
 #include <vector>
 
@@ -63,6 +64,12 @@ void WarnIfInCallback(std::function<void()> f);
 // An object to keep track of pending Events in the StreamExecutor streams
 // and associated Tensors that cannot safely be deleted until the associated
 // Events are recorded.
+//
+// By default, completed Events are found by a polling loop, which adds either
+// latency or CPU usage depending on GPUOptions.polling_active_delay_usecs. If
+// the TF_EVENT_MGR_USE_HOST_CALLBACKS environment variable is true, no Events
+// are used: a host callback is enqueued on the stream instead, which the
+// device runtime calls as soon as the preceding work on the stream completes.
 class EventMgr {
  public:
   virtual ~EventMgr();
@@ -71,6 +78,10 @@ class EventMgr {
   // func must be brief and non-blocking since it executes in the one
   // thread used for all such callbacks and also buffer deletions.
   inline void ThenExecute(se::Stream* stream, std::function<void()> func) {
+    if (use_host_callbacks_) {
+      QueueHostCallback(stream, std::move(func));
+      return;
+    }
     ToFreeVector to_free;
     {
       mutex_lock l(mu_);
@@ -86,6 +97,7 @@ class EventMgr {
   friend class EventMgrFactory;
   se::StreamExecutor* const exec_;
   const int32 polling_active_delay_usecs_;
+  const bool use_host_callbacks_;
   mutex mu_;
   condition_variable events_pending_ TF_GUARDED_BY(mu_);
 
@@ -116,6 +128,21 @@ class EventMgr {
     QueueInUse(stream, {nullptr, std::move(func)});
   }
 
+  // Enqueues a host callback on `stream` that schedules `func` on the
+  // threadpool. Only used if use_host_callbacks_.
+  void QueueHostCallback(se::Stream* stream, std::function<void()> func)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // The function of a host callback, and whether it has been claimed by either
+  // the callback or the fallback for a failed stream.
+  struct HostCallbackState {
+    std::atomic<bool> claimed{false};
+    std::function<void()> func;
+  };
+
+  // Schedules `func` on the threadpool and retires its pending callback.
+  void RunHostCallback(std::function<void()> func) TF_LOCKS_EXCLUDED(mu_);
+
   // This function should be called at roughly the same tempo as
   // QueueTensors() to check whether pending events have recorded,
   // and then retire them.  It appends InUse elements that need cleanup
@@ -141,6 +168,10 @@ class EventMgr {
   bool stop_polling_ TF_GUARDED_BY(mu_);
   std::unique_ptr<Notification> polling_stopped_;
 
+  // The number of host callbacks that have been enqueued but have not run yet.
+  int64_t num_pending_callbacks_ TF_GUARDED_BY(mu_) = 0;
+  condition_variable callbacks_done_ TF_GUARDED_BY(mu_);
+
   // The main PollLoop for the event manager runs in this threadpool.
   thread::ThreadPool threadpool_;
 };
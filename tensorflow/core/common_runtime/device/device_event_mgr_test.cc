@@ -138,6 +138,30 @@ TEST(EventMgr, WarnIfInCallback) {
   note.WaitForNotification();
   EXPECT_TRUE(hit);
 }
+
+TEST(EventMgr, HostCallbacks) {
+  setenv("TF_EVENT_MGR_USE_HOST_CALLBACKS", "true", /*overwrite=*/1);
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  TEST_EventMgr em(stream_exec, GPUOptions());
+  unsetenv("TF_EVENT_MGR_USE_HOST_CALLBACKS");
+  TEST_EventMgrHelper th(&em);
+  std::unique_ptr<se::Stream> stream(new se::Stream(stream_exec));
+  CHECK(stream);
+  stream->Init();
+  const int kNumCallbacks = 100;
+  std::atomic<int> num_done(0);
+  Notification note;
+  for (int i = 0; i < kNumCallbacks; ++i) {
+    em.ThenExecute(stream.get(), [&num_done, &note]() {
+      if (num_done.fetch_add(1) + 1 == kNumCallbacks) note.Notify();
+    });
+  }
+  note.WaitForNotification();
+  EXPECT_EQ(kNumCallbacks, num_done);
+  // No events are used in this mode.
+  EXPECT_EQ(0, th.queue_size());
+  EXPECT_EQ(0, th.free_size());
+}
 }  // namespace
 
 // Provides access to private resources of BaseGPUDevice.
@@ -26,6 +26,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/collective_executor_mgr.h"
 #include "tensorflow/core/common_runtime/collective_param_resolver_local.h"
 #include "tensorflow/core/common_runtime/constant_folding.h"
+#include "tensorflow/core/common_runtime/cost_constants.h"
+#include "tensorflow/core/common_runtime/cost_util.h"
 #include "tensorflow/core/common_runtime/debugger_state_interface.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/device_resolver_local.h"
@@ -39,6 +41,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
+#include "tensorflow/core/common_runtime/request_cost.h"
+#include "tensorflow/core/common_runtime/request_cost_accessor.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/function.h"
@@ -664,6 +668,14 @@ Status DirectSession::RunInternal(
   args.start_time_usecs = start_time_usecs;
   args.deadline = deadline;
 
+  // Attributes the costs of the step to the request it serves, if any.
+  std::unique_ptr<RequestCostAccessor> request_cost_accessor =
+      CreateRequestCostAccessor();
+  RequestCost* request_cost = request_cost_accessor != nullptr
+                                  ? request_cost_accessor->GetRequestCost()
+                                  : nullptr;
+  args.request_cost = request_cost;
+
   const bool do_trace = (run_options.trace_level() > RunOptions::NO_TRACE);
 
   bool update_cost_model = false;
@@ -683,6 +695,19 @@ Status DirectSession::RunInternal(
     run_state.collector.reset(
         new StepStatsCollector(run_metadata->mutable_step_stats()));
     args.stats_collector = run_state.collector.get();
+  } else if (run_metadata != nullptr && StepStatsSampleEveryNSteps() > 0 &&
+             executor_step_count % StepStatsSampleEveryNSteps() == 0) {
+    // Record the timings of a sample of the nodes of this step, which is cheap
+    // enough to be done on production traffic.
+    const int64_t node_sample_rate = StepStatsSampleEveryNNodes();
+    int64_t num_nodes = 0;
+    for (const auto& item : executors_and_keys->items) {
+      num_nodes += item.graph->num_op_nodes();
+    }
+    run_state.sampled_collector.reset(new SampledStepStatsCollector(
+        run_metadata->mutable_step_stats(), node_sample_rate,
+        num_nodes / std::max<int64_t>(node_sample_rate, 1) + 1));
+    args.stats_collector = run_state.sampled_collector.get();
   }
 
   std::unique_ptr<DeviceProfilerSession> device_profiler_session;
@@ -765,6 +790,11 @@ Status DirectSession::RunInternal(
     run_status.Update(errors::Cancelled("Run call was cancelled"));
   }
 
+  if (request_cost != nullptr && handler != nullptr) {
+    request_cost->RecordCost(
+        {{kIntraOpCostName, absl::Nanoseconds(handler->intra_op_time_ns())}});
+  }
+
   if (device_profiler_session) {
     TF_RETURN_IF_ERROR(device_profiler_session->CollectData(
         run_metadata->mutable_step_stats()));
@@ -783,6 +813,9 @@ Status DirectSession::RunInternal(
   if (run_state.collector) {
     run_state.collector->Finalize();
   }
+  if (run_state.sampled_collector) {
+    run_state.sampled_collector->Finalize();
+  }
 
   // Build and return the cost model as instructed.
   if (update_cost_model) {
@@ -1870,14 +1903,19 @@ Status DirectSession::MakeCallable(const CallableOptions& callable_options,
 
 class DirectSession::RunCallableCallFrame : public CallFrameInterface {
  public:
+  // If `use_caller_buffer` is not null, `(*use_caller_buffer)[i]` is true if
+  // the tensor initially in `(*fetch_tensors)[i]` is a caller-owned
+  // destination for that fetch.
   RunCallableCallFrame(DirectSession* session,
                        ExecutorsAndKeys* executors_and_keys,
                        const std::vector<Tensor>* feed_tensors,
-                       std::vector<Tensor>* fetch_tensors)
+                       std::vector<Tensor>* fetch_tensors,
+                       const std::vector<bool>* use_caller_buffer)
       : session_(session),
         executors_and_keys_(executors_and_keys),
         feed_tensors_(feed_tensors),
-        fetch_tensors_(fetch_tensors) {}
+        fetch_tensors_(fetch_tensors),
+        use_caller_buffer_(use_caller_buffer) {}
 
   size_t num_args() const override {
     return executors_and_keys_->input_types.size();
@@ -1899,15 +1937,44 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
     if (index > fetch_tensors_->size()) {
       return errors::Internal("RetVal index out of bounds: ", index);
     }
-    (*fetch_tensors_)[index] = val;
+    Tensor* fetch_tensor = &(*fetch_tensors_)[index];
+    if (HasCallerBuffer(index, val.dtype(), val.shape())) {
+      if (val.SharesBufferWith(*fetch_tensor)) {
+        // The value was produced directly in the caller's buffer.
+        return Status::OK();
+      }
+      if (DataTypeCanUseMemcpy(val.dtype())) {
+        StringPiece src = val.tensor_data();
+        memcpy(const_cast<char*>(fetch_tensor->tensor_data().data()),
+               src.data(), src.size());
+        return Status::OK();
+      }
+    }
+    *fetch_tensor = val;
     return Status::OK();
   }
 
+  bool GetRetvalBuffer(int index, DataType dtype, const TensorShape& shape,
+                       Tensor* val) override {
+    if (!HasCallerBuffer(index, dtype, shape)) return false;
+    *val = (*fetch_tensors_)[index];
+    return true;
+  }
+
  private:
+  bool HasCallerBuffer(int index, DataType dtype, const TensorShape& shape) {
+    if (use_caller_buffer_ == nullptr || !(*use_caller_buffer_)[index]) {
+      return false;
+    }
+    const Tensor& fetch_tensor = (*fetch_tensors_)[index];
+    return fetch_tensor.dtype() == dtype && fetch_tensor.shape() == shape;
+  }
+
   DirectSession* const session_;                   // Not owned.
   ExecutorsAndKeys* const executors_and_keys_;     // Not owned.
   const std::vector<Tensor>* const feed_tensors_;  // Not owned.
   std::vector<Tensor>* const fetch_tensors_;       // Not owned.
+  const std::vector<bool>* const use_caller_buffer_;  // Not owned.
 };
 
 ::tensorflow::Status DirectSession::RunCallable(
@@ -1990,10 +2057,28 @@ class DirectSession::RunCallableCallFrame : public CallFrameInterface {
     actual_feed_tensors = &feed_tensors;
   }
 
+  // Identify the initialized fetch tensors that the caller exclusively owns,
+  // which the fetched values will be written into.
+  std::vector<bool> use_caller_buffer;
+  const CallableOptions& callable_options =
+      executors_and_keys->callable_options;
+  if (callable_options.fetch_into_caller_buffers() &&
+      fetch_tensors != nullptr) {
+    use_caller_buffer.resize(fetch_tensors->size());
+    for (int i = 0; i < fetch_tensors->size(); ++i) {
+      const Tensor& t = (*fetch_tensors)[i];
+      use_caller_buffer[i] =
+          t.IsInitialized() && t.NumElements() > 0 && t.RefCountIsOne() &&
+          callable_options.fetch_devices().count(callable_options.fetch(i)) ==
+              0;
+    }
+  }
+
   // A specialized CallFrame implementation that takes advantage of the
   // optimized RunCallable interface.
-  RunCallableCallFrame call_frame(this, executors_and_keys.get(),
-                                  actual_feed_tensors, fetch_tensors);
+  RunCallableCallFrame call_frame(
+      this, executors_and_keys.get(), actual_feed_tensors, fetch_tensors,
+      use_caller_buffer.empty() ? nullptr : &use_caller_buffer);
 
   if (LogMemory::IsEnabled()) {
     LogMemory::RecordStep(step_id, run_state_args.handle);
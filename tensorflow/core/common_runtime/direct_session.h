@@ -51,6 +51,7 @@ class CostModel;
 class DebugGateway;
 class Device;
 class DirectSessionFactory;
+class SampledStepStatsCollector;
 
 class DirectSession : public Session {
  public:
@@ -201,6 +202,7 @@ class DirectSession : public Session {
     Status status TF_GUARDED_BY(mu);
     std::unique_ptr<CollectiveExecutor::Handle> collective_executor;
     std::unique_ptr<StepStatsCollector> collector;
+    std::unique_ptr<SampledStepStatsCollector> sampled_collector;
     TensorStore tensor_store;
     ScopedStepContainer step_container;
 
@@ -199,6 +199,46 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_Callable) {
   }
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_CallableCallerBuffers) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  CallableOptions callable_options =
+      MakeCallableOptions({}, {y_ + ":0", y_neg_ + ":0"}, {});
+  callable_options.set_fetch_into_caller_buffers(true);
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+
+  std::vector<Tensor> outputs = {Tensor(DT_FLOAT, TensorShape({2, 1})),
+                                 Tensor(DT_FLOAT, TensorShape({2, 1}))};
+  const char* y_data = outputs[0].tensor_data().data();
+  // The caller still holds a reference to the second buffer, so it must not
+  // be written.
+  Tensor y_neg_alias = outputs[1];
+  test::FillValues<float>(&y_neg_alias, {7, 7});
+
+  for (int i = 0; i < 2; ++i) {
+    TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+    ASSERT_EQ(2, outputs.size());
+    EXPECT_EQ(y_data, outputs[0].tensor_data().data());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+    EXPECT_FALSE(outputs[1].SharesBufferWith(y_neg_alias));
+    EXPECT_FLOAT_EQ(-5.0, outputs[1].matrix<float>()(0, 0));
+    test::ExpectTensorEqual<float>(
+        y_neg_alias, test::AsTensor<float>({7, 7}, TensorShape({2, 1})));
+  }
+
+  // A buffer with a mismatched shape is replaced.
+  outputs[0] = Tensor(DT_FLOAT, TensorShape({3}));
+  TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+  EXPECT_EQ(TensorShape({2, 1}), outputs[0].shape());
+  EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
 TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_OptimizeForStaticGraph) {
   Initialize({3, 2, -1, 0});
   SessionOptions options(DefaultSessionOptions());
@@ -154,6 +154,8 @@ EagerContext::EagerContext(
       use_send_tensor_rpc_(false),
       pin_small_ops_to_cpu_(ReadBoolFromEnvVar(
           "TF_EAGER_ENABLE_SMALL_TENSOR_CPU_PINNING", false)),
+      use_dispatch_cache_(
+          ReadBoolFromEnvVar("TF_EAGER_ENABLE_DISPATCH_CACHE", false)),
       run_eager_op_as_function_(run_eager_op_as_function) {
   ResetPFLR(device_mgr, opts.env, &opts.config, TF_GRAPH_DEF_VERSION,
             &func_lib_def_, opts.config.graph_options().optimizer_options(),
@@ -458,6 +460,7 @@ void EagerContext::ClearCachesAndDefaultExecutor() {
   mutex_lock ml(cache_mu_);
   default_executor_.WaitForAllPendingNodes().IgnoreError();
   kernel_cache_.clear();
+  dispatch_cache_.clear();
   for (auto& entry : registered_functions_) {
     entry.second->cached_kernel_keys->clear();
   }
@@ -1003,6 +1006,26 @@ core::RefCountPtr<KernelAndDevice> EagerContext::GetCachedKernel(
   return new_ref;
 }
 
+core::RefCountPtr<KernelAndDevice> EagerContext::GetCachedDispatchKernel(
+    Fprint128 dispatch_key) {
+  tf_shared_lock l(cache_mu_);
+  auto iter = dispatch_cache_.find(dispatch_key);
+  if (iter == dispatch_cache_.end()) {
+    return nullptr;
+  }
+  core::RefCountPtr<KernelAndDevice> new_ref(iter->second.get());
+  new_ref->Ref();
+  return new_ref;
+}
+
+void EagerContext::AddKernelToDispatchCache(Fprint128 dispatch_key,
+                                            KernelAndDevice* kernel) {
+  mutex_lock ml(cache_mu_);
+  core::RefCountPtr<KernelAndDevice> new_ref(kernel);
+  new_ref->Ref();
+  dispatch_cache_[dispatch_key] = std::move(new_ref);
+}
+
 void EagerContext::AddKernelToCache(Fprint128 cache_key,
                                     KernelAndDevice* kernel) {
   mutex_lock ml(cache_mu_);
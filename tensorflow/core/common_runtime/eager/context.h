@@ -255,6 +255,18 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
 
   void AddKernelToCache(Fprint128 cache_key, KernelAndDevice* kernel);
 
+  // The dispatch cache maps the signature of an op that has no requested
+  // device, i.e. its name, attributes and the dtypes and devices of its inputs
+  // (see GetDispatchCacheKey in execute.h), to the kernel that was created for
+  // it. A hit skips the placement of the op and the computation of its kernel
+  // cache key. It is enabled by the TF_EAGER_ENABLE_DISPATCH_CACHE environment
+  // variable, and is cleared together with the kernel cache.
+  bool UseDispatchCache() const { return use_dispatch_cache_; }
+  core::RefCountPtr<KernelAndDevice> GetCachedDispatchKernel(
+      Fprint128 dispatch_key);
+  void AddKernelToDispatchCache(Fprint128 dispatch_key,
+                                KernelAndDevice* kernel);
+
   bool LogDevicePlacement() const { return log_device_placement_; }
   void SetLogDevicePlacement(bool enable) override {
     log_device_placement_ = enable;
@@ -706,6 +718,9 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
   std::unordered_map<Fprint128, core::RefCountPtr<KernelAndDevice>,
                      Fprint128Hasher>
       kernel_cache_ TF_GUARDED_BY(cache_mu_);
+  std::unordered_map<Fprint128, core::RefCountPtr<KernelAndDevice>,
+                     Fprint128Hasher>
+      dispatch_cache_ TF_GUARDED_BY(cache_mu_);
   std::unordered_map<string, RegisteredFunction*> registered_functions_
       TF_GUARDED_BY(cache_mu_);
 
@@ -814,6 +829,7 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
   bool lazy_copy_function_remote_inputs_ = false;
   bool use_send_tensor_rpc_;
   const bool pin_small_ops_to_cpu_;
+  const bool use_dispatch_cache_;
 
   // Function that will be invoked in destructor to deallocate resources related
   // to this context.
@@ -182,6 +182,18 @@ Status EagerOperation::Execute(absl::Span<AbstractTensorHandle*> retvals,
 
   // Run eager placement logic.
   class Device* device = absl::get<class Device*>(Device());
+  Fprint128 dispatch_key;
+  if (device == nullptr && ctx_.UseDispatchCache() &&
+      GetDispatchKey(this, &dispatch_key)) {
+    core::RefCountPtr<KernelAndDevice> kernel =
+        ctx_.GetCachedDispatchKernel(dispatch_key);
+    if (kernel != nullptr && kernel->device() != nullptr) {
+      device = kernel->device();
+      SetDispatchKernel(std::move(kernel));
+    } else {
+      SetDispatchKey(dispatch_key);
+    }
+  }
   if (device == nullptr) {
     TF_RETURN_IF_ERROR(eager::MaybePinToResourceDevice(&device, *this));
   }
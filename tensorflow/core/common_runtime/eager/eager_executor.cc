@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <forward_list>
 
 #include "tensorflow/core/lib/core/errors.h"
@@ -29,6 +30,21 @@ bool IsAsyncWaitForRemoteFunctionEnabled() {
                                  true, &enabled));
   return enabled;
 }
+
+int64 LazyFusionMaxNodes() {
+  int64 max_nodes = 0;
+  Status s =
+      ReadInt64FromEnvVar("TF_EAGER_LAZY_FUSION_MAX_NODES", 0, &max_nodes);
+  if (!s.ok()) {
+    LOG(WARNING) << "Disabling lazy fusion of eager ops: " << s;
+    return 0;
+  }
+  return max_nodes > 1 ? max_nodes : 0;
+}
+
+// How long the executor thread in lazy mode waits for the client to enqueue
+// more nodes before it runs the fusable nodes at the front of the queue.
+constexpr int64 kLazyFusionDelayMicros = 50;
 }  // namespace
 
 EagerExecutor::EagerExecutor(bool async)
@@ -40,7 +56,8 @@ EagerExecutor::EagerExecutor(bool async)
                     : nullptr),
       last_eager_client_(nullptr),
       enable_async_wait_for_remote_function_(
-          IsAsyncWaitForRemoteFunctionEnabled()) {}
+          IsAsyncWaitForRemoteFunctionEnabled()),
+      max_fused_nodes_(async ? LazyFusionMaxNodes() : 0) {}
 
 EagerExecutor::~EagerExecutor() {
   tensorflow::mutex_lock l(node_queue_mutex_);
@@ -149,10 +166,12 @@ Status EagerExecutor::AddOrExecute(std::unique_ptr<EagerNode> node) {
     } else {
       status = status_;
       if (status.ok()) {
-        node_queue_.push(std::move(item));
+        node_queue_.push_back(std::move(item));
         // If there were no previous nodes pending, wake the run thread to
-        // start processing requests again.
-        if (node_queue_.size() == 1) {
+        // start processing requests again. In lazy mode, also wake it once
+        // enough nodes are pending to be fused.
+        if (node_queue_.size() == 1 ||
+            static_cast<int64>(node_queue_.size()) == max_fused_nodes_) {
           nodes_pending_.notify_all();
         }
 
@@ -231,7 +250,7 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
     if (from_queue) {
       // Since this was from the async queue, pop it from the front of the queue
       DCHECK(!node_queue_.empty() && item.get() == node_queue_.front().get());
-      node_queue_.pop();
+      node_queue_.pop_front();
     } else if (async) {
       // If it is an Async node then we will find the node in the unfinished
       // nodes list. However we only notify if we are at the front of the list
@@ -265,7 +284,7 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
       }
       while (!node_queue_.empty()) {
         items_to_destroy.push_front(std::move(node_queue_.front()));
-        node_queue_.pop();
+        node_queue_.pop_front();
       }
       for (auto& it : unfinished_nodes_) {
         items_to_destroy.push_front(std::move(it.second));
@@ -322,12 +341,28 @@ void EagerExecutor::Run() {
       gtl::MakeCleanup([this] { thread_exited_notification_.Notify(); });
   while (true) {
     core::RefCountPtr<NodeItem> curr_item;
+    std::vector<core::RefCountPtr<NodeItem>> fused_items;
     {
       tensorflow::mutex_lock l(node_queue_mutex_);
       while (node_queue_.empty() || !status_.ok()) {
         if (state_ == ExecutorState::kShutDown) return;
         nodes_pending_.wait(l);
       }
+      if (max_fused_nodes_ > 0 &&
+          node_queue_.front()->node->AsFusable() != nullptr) {
+        // Only nodes that are already in the queue are fused, so give the
+        // client a chance to enqueue the ops that follow.
+        const uint64 deadline =
+            Env::Default()->NowMicros() + kLazyFusionDelayMicros;
+        while (static_cast<int64>(node_queue_.size()) < max_fused_nodes_ &&
+               status_.ok() && state_ == ExecutorState::kActive) {
+          const uint64 now = Env::Default()->NowMicros();
+          if (now >= deadline) break;
+          nodes_pending_.wait_for(l, std::chrono::microseconds(deadline - now));
+        }
+        if (node_queue_.empty() || !status_.ok()) continue;
+        CollectFusableItemsLocked(&fused_items);
+      }
       // Obtain raw pointer since we don't want to remove from the queue until
       // the node has been run. Otherwise, WaitForAllPendingNodes can return
       // too early.
@@ -335,8 +370,15 @@ void EagerExecutor::Run() {
       // will then contain a nullptr. This can be a problem in
       // WaitForAllPendingNodes where we get the top EagerNode pointer
       // and register a notification for its completion.
-      curr_item.reset(node_queue_.front().get());
-      curr_item->Ref();
+      if (fused_items.size() <= 1) {
+        fused_items.clear();
+        curr_item.reset(node_queue_.front().get());
+        curr_item->Ref();
+      }
+    }
+    if (!fused_items.empty()) {
+      RunFusedItems(std::move(fused_items));
+      continue;
     }
     Status status = RunItem(std::move(curr_item), /*from_queue=*/true);
     if (!status.ok()) {
@@ -398,6 +440,47 @@ Status EagerExecutor::RunItem(core::RefCountPtr<NodeItem> item,
   return status();
 }
 
+void EagerExecutor::CollectFusableItemsLocked(
+    std::vector<core::RefCountPtr<NodeItem>>* items) {
+  const void* domain = nullptr;
+  for (const core::RefCountPtr<NodeItem>& item : node_queue_) {
+    if (static_cast<int64>(items->size()) >= max_fused_nodes_) break;
+    FusableEagerNode* node = item->node->AsFusable();
+    if (node == nullptr) break;
+    if (items->empty()) {
+      domain = node->FusionDomain();
+    } else if (node->FusionDomain() != domain) {
+      break;
+    }
+    item->Ref();
+    items->emplace_back(item.get());
+  }
+}
+
+void EagerExecutor::RunFusedItems(
+    std::vector<core::RefCountPtr<NodeItem>> items) {
+  DVLOG(3) << "Running " << items.size() << " fused nodes: [id "
+           << items.front()->id << " to " << items.back()->id << "]";
+  std::vector<FusableEagerNode*> nodes;
+  nodes.reserve(items.size());
+  for (const core::RefCountPtr<NodeItem>& item : items) {
+    nodes.push_back(item->node->AsFusable());
+  }
+  Status status = nodes.front()->RunFused(nodes);
+  if (status.ok()) {
+    for (const core::RefCountPtr<NodeItem>& item : items) {
+      NodeDone(item, status, /*from_queue=*/true);
+    }
+    return;
+  }
+  VLOG(1) << "Failed to run fused nodes, running them one by one: " << status;
+  for (core::RefCountPtr<NodeItem>& item : items) {
+    // A failing node aborts the rest of the queue, including the remaining
+    // items.
+    if (!RunItem(std::move(item), /*from_queue=*/true).ok()) break;
+  }
+}
+
 Status EagerExecutor::MoveToUnfinished(core::RefCountPtr<NodeItem> item,
                                        bool from_queue) {
   tensorflow::mutex_lock l(node_queue_mutex_);
@@ -407,7 +490,7 @@ Status EagerExecutor::MoveToUnfinished(core::RefCountPtr<NodeItem> item,
 
   if (from_queue) {
     DCHECK(!node_queue_.empty() && item.get() == node_queue_.front().get());
-    node_queue_.pop();
+    node_queue_.pop_front();
   }
 
   DVLOG(3) << "Add Node: [id " << item->id << "] to unfinished map.";
@@ -17,12 +17,14 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstddef>
+#include <deque>
 #include <map>
 #include <memory>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
@@ -40,6 +42,7 @@ namespace tensorflow {
 
 class AsyncEagerNode;
 class AsyncRemoteExecuteNode;
+class FusableEagerNode;
 namespace eager {
 class EagerClient;
 }
@@ -71,6 +74,9 @@ class EagerNode {
   virtual AsyncEagerNode* AsAsync() { return nullptr; }
   virtual AsyncRemoteExecuteNode* AsAsyncRemoteExecuteNode() { return nullptr; }
 
+  // Returns nullptr iff this node cannot be fused with adjacent nodes.
+  virtual FusableEagerNode* AsFusable() { return nullptr; }
+
   virtual string DebugString() const = 0;
 
   // Indicates whether a node failure should make the executor unusable.
@@ -91,6 +97,21 @@ class AsyncEagerNode : public EagerNode {
   }
 };
 
+// A synchronous node that an executor in lazy mode may run together with the
+// nodes that follow it in its queue (see EagerExecutor).
+class FusableEagerNode : public EagerNode {
+ public:
+  // Only nodes with the same fusion domain are fused. Nodes of different types
+  // must have different domains.
+  virtual const void* FusionDomain() const = 0;
+
+  // Runs `nodes`, a run of consecutive nodes of the same domain of which this
+  // is the first, as a single computation. If this fails, the executor runs the
+  // nodes one by one instead, so on failure this must not have had any visible
+  // effect.
+  virtual Status RunFused(absl::Span<FusableEagerNode* const> nodes) = 0;
+};
+
 class AsyncRemoteExecuteNode : public AsyncEagerNode {
  public:
   AsyncRemoteExecuteNode* AsAsyncRemoteExecuteNode() final { return this; }
@@ -111,6 +132,12 @@ class AsyncRemoteExecuteNode : public AsyncEagerNode {
 // TODO(agarwal): Implement optimizations over EagerNode traces.
 class EagerExecutor {
  public:
+  // In async mode, the executor runs in lazy mode if the
+  // TF_EAGER_LAZY_FUSION_MAX_NODES environment variable is greater than one.
+  // In this mode, the executor thread waits briefly for the client to enqueue
+  // more nodes whenever a fusable node is at the front of the queue, and runs
+  // runs of up to that many consecutive fusable nodes with
+  // FusableEagerNode::RunFused().
   explicit EagerExecutor(bool async);
 
   ~EagerExecutor();
@@ -204,6 +231,13 @@ class EagerExecutor {
   void Run();
 
   Status RunItem(core::RefCountPtr<NodeItem> item, bool from_queue);
+  // Runs `items`, which are at the front of the queue, with RunFused().
+  void RunFusedItems(std::vector<core::RefCountPtr<NodeItem>> items);
+  // Adds references to the run of fusable nodes at the front of the queue to
+  // `items`, without removing them from the queue.
+  void CollectFusableItemsLocked(
+      std::vector<core::RefCountPtr<NodeItem>>* items)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(node_queue_mutex_);
   Status MoveToUnfinished(core::RefCountPtr<NodeItem> item, bool from_queue);
 
   // The impl of WaitForAllPendingNodes
@@ -221,7 +255,7 @@ class EagerExecutor {
   condition_variable nodes_pending_ TF_GUARDED_BY(node_queue_mutex_);
 
   // Queue of pending NodeItems. Ordered by NodeItem::id.
-  std::queue<core::RefCountPtr<NodeItem>> node_queue_
+  std::deque<core::RefCountPtr<NodeItem>> node_queue_
       TF_GUARDED_BY(node_queue_mutex_);
 
   // Ordered by NodeItem::id.
@@ -258,6 +292,9 @@ class EagerExecutor {
 
   const bool enable_async_wait_for_remote_function_;
 
+  // The maximum number of nodes fused in lazy mode, or 0 if it is disabled.
+  const int64 max_fused_nodes_;
+
   // Callbacks to run on destruction.
   std::unordered_map<intptr_t, std::vector<std::function<void()>>> cleanups_;
 };
@@ -37,6 +37,9 @@ void EagerOperation::Clear() {
   }
   inputs_.clear();
   custom_device_tensor_handles_count_ = 0;
+  dispatch_key_ = absl::nullopt;
+  dispatch_kernel_.reset();
+  output_buffers_.clear();
   ClearInferenceState();
 }
 
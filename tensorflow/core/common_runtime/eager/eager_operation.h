@@ -212,6 +212,30 @@ class EagerOperation : public ImmediateExecutionOperation {
     return eager_func_params_;
   }
 
+  // The key of this op in the dispatch cache of the context, if it is
+  // eligible for the cache (see EagerContext::UseDispatchCache).
+  const absl::optional<Fprint128>& dispatch_key() const {
+    return dispatch_key_;
+  }
+  void SetDispatchKey(Fprint128 dispatch_key) { dispatch_key_ = dispatch_key; }
+
+  // The kernel found in the dispatch cache for this op, which is consumed by
+  // the next call to `ReleaseDispatchKernel()`.
+  void SetDispatchKernel(core::RefCountPtr<KernelAndDevice> kernel) {
+    dispatch_kernel_ = std::move(kernel);
+  }
+  core::RefCountPtr<KernelAndDevice> ReleaseDispatchKernel() {
+    return std::move(dispatch_kernel_);
+  }
+
+  // Buffers, one per output or uninitialized, that the kernel of this op
+  // should write its outputs into if their types and shapes match (see
+  // EagerKernelExecute). Cleared by `Clear()`.
+  void SetOutputBuffers(std::vector<Tensor> output_buffers) {
+    output_buffers_ = std::move(output_buffers);
+  }
+  const std::vector<Tensor>& output_buffers() const { return output_buffers_; }
+
   // Op name recorded for memory debugging purpose.
   const char* op_name() const { return op_name_; }
 
@@ -278,6 +302,11 @@ class EagerOperation : public ImmediateExecutionOperation {
 
   absl::optional<EagerFunctionParams> eager_func_params_;
 
+  absl::optional<Fprint128> dispatch_key_;
+  core::RefCountPtr<KernelAndDevice> dispatch_kernel_;
+
+  std::vector<Tensor> output_buffers_;
+
   // Inference information
   const tensorflow::OpDef* op_def_;  // op definition from protobuf
   int inference_arg_idx_;  // arg definition index for the next input to be
@@ -819,10 +819,32 @@ Status WrapInCallOp(EagerOperation* op, EagerOperation** wrapped_op) {
   return AddMixedTypeListAttrs(*wrapped_op, op_attrs, opdef);
 }
 
+// Checks that `*num_retvals` is large enough for the outputs of `kernel`, sets
+// it to the number of outputs and passes the kernel to `out_kernel`.
+Status SetKernelOutputs(core::RefCountPtr<KernelAndDevice> kernel,
+                        int* num_retvals,
+                        core::RefCountPtr<KernelAndDevice>* out_kernel) {
+  int num_outputs = kernel->num_outputs();
+  if (num_outputs > *num_retvals) {
+    return errors::InvalidArgument("Expecting ", num_outputs,
+                                   " outputs, but *num_retvals is ",
+                                   *num_retvals);
+  }
+  *num_retvals = num_outputs;
+  *out_kernel = std::move(kernel);
+  return Status::OK();
+}
+
 Status GetOrCreateKernelAndDevice(
     EagerOperation* op, TensorHandle** retvals, int* num_retvals,
     core::RefCountPtr<KernelAndDevice>* out_kernel) {
   EagerContext& ctx = op->EagerContext();
+  core::RefCountPtr<KernelAndDevice> kernel = op->ReleaseDispatchKernel();
+  if (kernel != nullptr) {
+    // The op was placed from the dispatch cache, so the kernel cache lookup
+    // is skipped as well.
+    return SetKernelOutputs(std::move(kernel), num_retvals, out_kernel);
+  }
   Device* device = absl::get<Device*>(op->Device());
 
   // Save the original value of reuse_rendezvous_for_functions from the context.
@@ -917,7 +939,8 @@ Status GetOrCreateKernelAndDevice(
     }
   }
 
-  core::RefCountPtr<KernelAndDevice> kernel = ctx.GetCachedKernel(cache_key);
+  kernel = ctx.GetCachedKernel(cache_key);
+  bool kernel_is_cached = kernel != nullptr;
   AbstractOperationPtr wrapped_op_releaser;
   if (kernel == nullptr) {
     VLOG(2) << "Creating new kernel for " << op->Name() << " on device "
@@ -1064,21 +1087,18 @@ Status GetOrCreateKernelAndDevice(
       TF_RETURN_IF_ERROR(OpDefForOp(op->Name().data(), &op_def));
       if (KernelCacheEnabled(*op_def)) {
         ctx.AddKernelToCache(cache_key, kernel.get());
+        kernel_is_cached = true;
       }
     }
   }
 
-  int num_outputs = kernel->num_outputs();
-  if (num_outputs > *num_retvals) {
-    return errors::InvalidArgument("Expecting ", num_outputs,
-                                   " outputs, but *num_retvals is ",
-                                   *num_retvals);
+  // Only kernels that are in the kernel cache are added to the dispatch cache,
+  // so that both caches hold the same set of kernels.
+  if (kernel_is_cached && op->dispatch_key().has_value()) {
+    ctx.AddKernelToDispatchCache(*op->dispatch_key(), kernel.get());
   }
-  *num_retvals = num_outputs;
 
-  kernel->Ref();  // Ownership of reference is passed to out_kernel.
-  out_kernel->reset(kernel.get());
-  return Status::OK();
+  return SetKernelOutputs(std::move(kernel), num_retvals, out_kernel);
 }
 
 Status CreateUnshapedOutput(
@@ -1176,7 +1196,7 @@ Status AddOrExecuteNode(core::RefCountPtr<KernelAndDevice> kernel,
     ExecuteNode node(&ctx, *inputs, eager_func_params, kernel, graph_collector,
                      op->GetCancellationManager(),
                      {retvals, static_cast<size_t>(num_outputs)},
-                     op->GetStackTrace());
+                     op->GetStackTrace(), op->output_buffers());
     Status s = executor.SyncExecute(&node);
     // We release the inputs AFTER executing the operation in sync mode since
     // ExecuteNode does not increment the reference count and thus does not have
@@ -1589,6 +1609,48 @@ void CollectGraphs(EagerContext* ctx) {
 }
 }  // namespace
 
+bool GetDispatchKey(EagerOperation* op, Fprint128* dispatch_key) {
+  EagerContext& ctx = op->EagerContext();
+  if (op->is_function() || ctx.RunEagerOpAsFunction() ||
+      op->Device() != kVariantDeviceNull) {
+    return false;
+  }
+  const absl::InlinedVector<TensorHandle*, 4>* inputs;
+  if (!op->TensorHandleInputs(&inputs).ok()) {
+    return false;
+  }
+  Fprint128 key = op->MutableAttrs()->CacheKey(op->DeviceName());
+  key = FingerprintCat128(key, ctx.AllowSoftPlacement());
+  key = FingerprintCat128(key, ctx.PinSmallOpsToCPU());
+  key = FingerprintCat128(key, ctx.GetReuseRendezvousForFunctions());
+  Device* host_cpu = ctx.HostCPU();
+  for (TensorHandle* input : *inputs) {
+    // Packed inputs are rewritten before the kernel is looked up, and the
+    // devices of remote resources must be validated on every call.
+    if (input->Type() == TensorHandle::PACKED ||
+        input->resource_remote_device_incarnation() != 0) {
+      return false;
+    }
+    Device* input_device = input->DeviceOrHostCPU(ctx);
+    key = FingerprintCat128(key, input->dtype);
+    key = FingerprintCat128(key, reinterpret_cast<intptr_t>(input_device));
+    if (input->dtype == DT_RESOURCE) {
+      key = FingerprintCat128(
+          key, reinterpret_cast<intptr_t>(input->resource_device()));
+    } else if (ctx.PinSmallOpsToCPU() && input_device == host_cpu &&
+               (input->dtype == DT_INT32 || input->dtype == DT_INT64)) {
+      // Small integer inputs on the CPU may pin the op to the CPU.
+      int64_t num_elements;
+      if (!input->NumElements(&num_elements).ok()) {
+        return false;
+      }
+      key = FingerprintCat128(key, num_elements <= 64);
+    }
+  }
+  *dispatch_key = key;
+  return true;
+}
+
 Status EagerExecute(EagerOperation* op, TensorHandle** retvals,
                     int* num_retvals) {
   profiler::TraceMe activity(
@@ -1638,10 +1700,14 @@ Status EagerKernelExecute(
     const core::RefCountPtr<KernelAndDevice>& kernel,
     GraphCollector* graph_collector, CancellationManager* cancellation_manager,
     absl::Span<TensorHandle*> retvals,
-    const absl::optional<ManagedStackTrace>& stack_trace) {
+    const absl::optional<ManagedStackTrace>& stack_trace,
+    absl::Span<const Tensor> output_buffers) {
   profiler::TraceMe activity("EagerKernelExecute",
                              profiler::TraceMeLevel::kInfo);
   std::vector<EagerKernelRet> outputs(1);
+  if (!output_buffers.empty()) {
+    outputs.assign(output_buffers.begin(), output_buffers.end());
+  }
 
   ExecuteNodeArgs inputs(op_inputs.size());
   TF_RETURN_IF_ERROR(inputs.Init(ctx, op_inputs, kernel));
@@ -45,15 +45,26 @@ namespace tensorflow {
 Status EagerExecute(EagerOperation* op, TensorHandle** retvals,
                     int* num_retvals);
 
+// Computes the key of `op` in the dispatch cache of its context, which covers
+// everything that the placement of the op depends on: its name, attributes and
+// requested device, the placement policies of the context, and the dtype and
+// device of each input. Returns false if `op` is not eligible for the cache,
+// e.g. because it has an assigned device or is a function.
+bool GetDispatchKey(EagerOperation* op, Fprint128* dispatch_key);
+
 // Low-level utility to execute the kernel specified by `kernel` on
-// `kernel->device()`, with the inputs op_inputs, in the context 'ctx'.
+// `kernel->device()`, with the inputs op_inputs, in the context 'ctx'. The
+// kernel of a primitive op on a CPU device writes each output whose type and
+// shape match the initialized tensor at its index in `output_buffers` into
+// the buffer of that tensor.
 Status EagerKernelExecute(
     EagerContext* ctx, const absl::InlinedVector<TensorHandle*, 4>& op_inputs,
     const absl::optional<EagerFunctionParams>& eager_func_params,
     const core::RefCountPtr<KernelAndDevice>& kernel,
     GraphCollector* graph_collector, CancellationManager* cancellation_manager,
     absl::Span<TensorHandle*> retvals,
-    const absl::optional<ManagedStackTrace>& stack_trace = {});
+    const absl::optional<ManagedStackTrace>& stack_trace = {},
+    absl::Span<const Tensor> output_buffers = {});
 
 // Low-level utility to copy a tensor handle from one device to another. If
 // successful, result TensorHandle will be populated. If the caller requests for
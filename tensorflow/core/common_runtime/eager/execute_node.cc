@@ -14,7 +14,23 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/eager/execute_node.h"
 
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/common_runtime/eager/attr_builder.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#if !defined(IS_MOBILE_PLATFORM)
+#include "tensorflow/core/framework/graph_to_functiondef.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#endif  // IS_MOBILE_PLATFORM
 
 namespace tensorflow {
 
@@ -141,4 +157,202 @@ Status ExecuteNodeArgs::GetLocalArg(const FunctionArgIndex& index,
   }
 }
 
+namespace {
+
+constexpr char kFusedFunctionPrefix[] = "__eager_fused_";
+
+// Returns a hash of the attributes of `ndef` that does not depend on their
+// order.
+uint64 AttrsHash(const NodeDef& ndef) {
+  uint64 hash = 0;
+  for (const auto& attr : ndef.attr()) {
+    hash += Hash64Combine(Hash64(attr.first), FastAttrValueHash(attr.second));
+  }
+  return hash;
+}
+
+}  // namespace
+
+bool AsyncExecuteNode::IsFusable() const {
+  // Only stateless op kernels are fused, so that the nodes can be run again
+  // one by one if the fused function fails, and whose inputs and outputs are
+  // all on the device of the kernel, so that the outputs of the function are
+  // on the devices of the output handles.
+  const OpKernel* op_kernel = kernel_->kernel();
+  Device* device = kernel_->device();
+  if (op_kernel == nullptr || device == nullptr ||
+      eager_func_params_.has_value() || graph_collector_ != nullptr ||
+      cancellation_manager_ != nullptr) {
+    return false;
+  }
+  const OpDef* op_def;
+  if (!OpDefForOp(op_kernel->type_string(), &op_def).ok() ||
+      op_def->is_stateful()) {
+    return false;
+  }
+  for (int i = 0; i < inputs_.size(); ++i) {
+    const DataType dtype = kernel_->input_dtypes()[i];
+    if (kernel_->InputDevice(i) != device || IsRefType(dtype) ||
+        dtype == DT_RESOURCE || inputs_[i]->Type() != TensorHandle::LOCAL) {
+      return false;
+    }
+  }
+  for (int i = 0; i < retvals_.size(); ++i) {
+    if (kernel_->OutputDevice(i) != device ||
+        kernel_->OutputResourceDevice(i) != nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#if !defined(IS_MOBILE_PLATFORM)
+Status AsyncExecuteNode::GetFusedKernel(
+    absl::Span<AsyncExecuteNode* const> nodes,
+    absl::InlinedVector<TensorHandle*, 4>* inputs,
+    absl::InlinedVector<TensorHandle*, 4>* retvals,
+    core::RefCountPtr<KernelAndDevice>* kernel) const {
+  Device* device = kernel_->device();
+  // The sources of the inputs of each node: a function argument, for a handle
+  // that is not computed by the run, or an output of a previous node.
+  constexpr int kArg = -1;
+  std::vector<std::vector<std::pair<int, int>>> node_inputs(nodes.size());
+  absl::flat_hash_map<TensorHandle*, int> arg_index;
+  absl::flat_hash_map<TensorHandle*, std::pair<int, int>> producer;
+  string structure = strings::StrCat(kFusedFunctionPrefix, device->name());
+  for (int n = 0; n < nodes.size(); ++n) {
+    const AsyncExecuteNode* node = nodes[n];
+    const NodeDef& ndef = node->kernel_->kernel()->def();
+    strings::StrAppend(&structure, ";", ndef.op(), "#", AttrsHash(ndef));
+    for (TensorHandle* handle : node->inputs_) {
+      auto it = producer.find(handle);
+      if (it != producer.end()) {
+        node_inputs[n].push_back(it->second);
+      } else {
+        auto result = arg_index.emplace(handle, inputs->size());
+        if (result.second) inputs->push_back(handle);
+        node_inputs[n].emplace_back(kArg, result.first->second);
+      }
+      strings::StrAppend(&structure, ",", node_inputs[n].back().first, ":",
+                         node_inputs[n].back().second);
+    }
+    for (int i = 0; i < node->retvals_.size(); ++i) {
+      producer[node->retvals_[i]] = {n, i};
+      retvals->push_back(node->retvals_[i]);
+    }
+  }
+  const Fprint128 cache_key = Fingerprint128(structure);
+  *kernel = ctx_->GetCachedKernel(cache_key);
+  if (*kernel != nullptr) return Status::OK();
+
+  const string name = strings::StrCat(kFusedFunctionPrefix, cache_key.high64,
+                                      "_", cache_key.low64);
+  if (ctx_->FindFunctionDef(name) == nullptr) {
+    Graph graph(OpRegistry::Global());
+    std::vector<Node*> arg_nodes(inputs->size());
+    for (int i = 0; i < inputs->size(); ++i) {
+      TF_RETURN_IF_ERROR(NodeBuilder(strings::StrCat("arg", i),
+                                     FunctionLibraryDefinition::kArgOp)
+                             .Attr("T", (*inputs)[i]->dtype)
+                             .Attr("index", i)
+                             .Finalize(&graph, &arg_nodes[i]));
+    }
+    std::vector<Node*> op_nodes(nodes.size());
+    int retval_index = 0;
+    for (int n = 0; n < nodes.size(); ++n) {
+      NodeDef ndef = nodes[n]->kernel_->kernel()->def();
+      ndef.set_name(strings::StrCat("node", n));
+      ndef.clear_input();
+      ndef.set_device(device->name());
+      Status s;
+      op_nodes[n] = graph.AddNode(std::move(ndef), &s);
+      TF_RETURN_IF_ERROR(s);
+      for (int j = 0; j < node_inputs[n].size(); ++j) {
+        const std::pair<int, int>& src = node_inputs[n][j];
+        if (src.first == kArg) {
+          graph.AddEdge(arg_nodes[src.second], 0, op_nodes[n], j);
+        } else {
+          graph.AddEdge(op_nodes[src.first], src.second, op_nodes[n], j);
+        }
+      }
+      for (int i = 0; i < nodes[n]->retvals_.size(); ++i) {
+        Node* retval_node;
+        TF_RETURN_IF_ERROR(
+            NodeBuilder(strings::StrCat("retval", retval_index),
+                        FunctionLibraryDefinition::kRetOp)
+                .Input(op_nodes[n], i)
+                .Attr("index", retval_index)
+                .Finalize(&graph, &retval_node));
+        ++retval_index;
+      }
+    }
+    FunctionDef fdef;
+    TF_RETURN_IF_ERROR(GraphToFunctionDef(graph, name, &fdef));
+    TF_RETURN_IF_ERROR(ctx_->AddFunctionDef(fdef));
+  }
+
+  FunctionLibraryRuntime* flr = ctx_->func_lib(device);
+  if (flr == nullptr) {
+    return errors::NotFound(
+        "Unable to find a FunctionLibraryRuntime corresponding to device ",
+        device->name());
+  }
+  auto runner = flr->runner() != nullptr ? flr->runner() : ctx_->runner();
+  kernel->reset(new KernelAndDeviceFunc(
+      flr, ctx_->pflr(), std::vector<Device*>(inputs->size(), device),
+      /*composite_devices=*/{}, /*input_resource_dtypes_and_shapes=*/{},
+      runner, ctx_->GetCollectiveExecutorHandle(), ctx_->HostCPU(), name,
+      /*outputs_on_op_device=*/true, ctx_->RendezvousCreator(),
+      /*get_op_id=*/nullptr));
+  NodeDef ndef;
+  ndef.set_name(name);
+  ndef.set_op(name);
+  ndef.set_device(device->name());
+  // The presence of a config enables the grappler optimizations, including
+  // the remapper fusions, when the function is instantiated.
+  AddNodeAttr("config_proto", ConfigProto().SerializeAsString(), &ndef);
+  TF_RETURN_IF_ERROR((*kernel)->Init(ctx_->LogDevicePlacement(), ndef,
+                                     /*graph_collector=*/nullptr));
+  ctx_->AddKernelToCache(cache_key, kernel->get());
+  return Status::OK();
+}
+#endif  // !IS_MOBILE_PLATFORM
+
+Status AsyncExecuteNode::RunFused(absl::Span<FusableEagerNode* const> nodes) {
+#if defined(IS_MOBILE_PLATFORM)
+  return errors::Unimplemented(
+      "Fusing eager ops is not available on mobile devices.");
+#else   // !IS_MOBILE_PLATFORM
+  // A fusion domain is a device, which only AsyncExecuteNodes use.
+  std::vector<AsyncExecuteNode*> execute_nodes;
+  execute_nodes.reserve(nodes.size());
+  for (FusableEagerNode* node : nodes) {
+    execute_nodes.push_back(static_cast<AsyncExecuteNode*>(node));
+  }
+  absl::InlinedVector<TensorHandle*, 4> inputs;
+  absl::InlinedVector<TensorHandle*, 4> retvals;
+  core::RefCountPtr<KernelAndDevice> kernel;
+  TF_RETURN_IF_ERROR(GetFusedKernel(execute_nodes, &inputs, &retvals, &kernel));
+  // Check the placement of the outputs before running the function, since
+  // the outputs are set as they are produced.
+  if (kernel->num_outputs() != static_cast<int>(retvals.size())) {
+    return errors::Internal("Fused function ", kernel->name(), " has ",
+                            kernel->num_outputs(), " outputs, expected ",
+                            retvals.size());
+  }
+  for (int i = 0; i < retvals.size(); ++i) {
+    if (ctx_->CanonicalDevice(kernel->OutputDevice(i)) !=
+        retvals[i]->device()) {
+      return errors::Unimplemented("Output ", i, " of fused function ",
+                                   kernel->name(),
+                                   " is not placed on the device of its op");
+    }
+  }
+  return EagerKernelExecute(ctx_, inputs, /*eager_func_params=*/absl::nullopt,
+                            kernel, /*graph_collector=*/nullptr,
+                            /*cancellation_manager=*/nullptr,
+                            absl::MakeSpan(retvals));
+#endif  // !IS_MOBILE_PLATFORM
+}
+
 }  // namespace tensorflow
@@ -98,7 +98,8 @@ class ExecuteNode : public EagerNode {
               GraphCollector* graph_collector,
               CancellationManager* cancellation_manager,
               absl::Span<TensorHandle*> retvals,
-              absl::optional<ManagedStackTrace> stack_trace)
+              absl::optional<ManagedStackTrace> stack_trace,
+              absl::Span<const Tensor> output_buffers = {})
       : EagerNode(),
         ctx_(ctx),
         inputs_(inputs),
@@ -107,7 +108,8 @@ class ExecuteNode : public EagerNode {
         graph_collector_(graph_collector),
         cancellation_manager_(cancellation_manager),
         retvals_(retvals),
-        stack_trace_(stack_trace) {}
+        stack_trace_(stack_trace),
+        output_buffers_(output_buffers) {}
 
   Status Run() override {
     int i = 0;
@@ -123,7 +125,7 @@ class ExecuteNode : public EagerNode {
     }
     return EagerKernelExecute(ctx_, inputs_, eager_func_params_, kernel_,
                               graph_collector_, cancellation_manager_, retvals_,
-                              stack_trace_);
+                              stack_trace_, output_buffers_);
   }
 
   void Abort(Status status) override {}
@@ -143,9 +145,14 @@ class ExecuteNode : public EagerNode {
   CancellationManager* const cancellation_manager_;
   absl::Span<TensorHandle*> retvals_;
   absl::optional<ManagedStackTrace> stack_trace_;
+  absl::Span<const Tensor> output_buffers_;
 };
 
-class AsyncExecuteNode : public EagerNode {
+// Runs a kernel from the executor thread. In lazy mode (see EagerExecutor),
+// runs of these nodes that execute stateless op kernels on the same device are
+// fused into a function, which is instantiated with grappler and cached in the
+// kernel cache of the context under the structure of the run.
+class AsyncExecuteNode : public FusableEagerNode {
  public:
   AsyncExecuteNode(EagerContext* ctx,
                    const absl::InlinedVector<TensorHandle*, 4>& inputs,
@@ -155,7 +162,7 @@ class AsyncExecuteNode : public EagerNode {
                    CancellationManager* cancellation_manager,
                    absl::Span<TensorHandle*> retvals,
                    absl::optional<ManagedStackTrace> stack_trace)
-      : EagerNode(),
+      : FusableEagerNode(),
         ctx_(ctx),
         inputs_(inputs),
         eager_func_params_(eager_func_params),
@@ -225,6 +232,15 @@ class AsyncExecuteNode : public EagerNode {
     }
   }
 
+  FusableEagerNode* AsFusable() override {
+    if (!fusable_.has_value()) fusable_ = IsFusable();
+    return *fusable_ ? this : nullptr;
+  }
+
+  const void* FusionDomain() const override { return kernel_->device(); }
+
+  Status RunFused(absl::Span<FusableEagerNode* const> nodes) override;
+
   std::string DebugString() const override {
     std::string out = "[AsyncExecuteNode]";
     strings::StrAppend(&out, " kernel: ", kernel_->name());
@@ -232,6 +248,14 @@ class AsyncExecuteNode : public EagerNode {
   }
 
  private:
+  bool IsFusable() const;
+  // Returns the kernel of the function that runs the fused `nodes`, and the
+  // inputs and outputs of the function.
+  Status GetFusedKernel(absl::Span<AsyncExecuteNode* const> nodes,
+                        absl::InlinedVector<TensorHandle*, 4>* inputs,
+                        absl::InlinedVector<TensorHandle*, 4>* retvals,
+                        core::RefCountPtr<KernelAndDevice>* kernel) const;
+
   EagerContext* ctx_;
   absl::InlinedVector<TensorHandle*, 4> inputs_;
   const absl::optional<EagerFunctionParams> eager_func_params_;
@@ -240,6 +264,7 @@ class AsyncExecuteNode : public EagerNode {
   CancellationManager* const cancellation_manager_;
   absl::optional<ManagedStackTrace> stack_trace_;
   absl::InlinedVector<TensorHandle*, 2> retvals_;
+  absl::optional<bool> fusable_;
 };
 
 }  // namespace tensorflow
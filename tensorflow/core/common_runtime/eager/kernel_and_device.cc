@@ -15,9 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
 
+#include <cstring>
 #include <memory>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/strings/match.h"
+#include "absl/types/variant.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/eager/attr_builder.h"
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
@@ -243,6 +246,48 @@ struct OpExecutionState : public core::RefCounted {
   // TODO(nareshmodi): consider refcounting the cancellation_manager.
   CancellationManager cancellation_manager;
 };
+
+// Returns the tensor at `index` in `outputs` if it was initialized by the
+// caller of Run() as a buffer for that output, or nullptr.
+const Tensor* OutputBuffer(const std::vector<EagerKernelRet>& outputs,
+                           int index) {
+  if (index >= static_cast<int>(outputs.size())) return nullptr;
+  const Tensor* buffer = absl::get_if<Tensor>(&outputs[index]);
+  return buffer != nullptr && buffer->IsInitialized() ? buffer : nullptr;
+}
+
+// Offers the output buffers of a Run() call to the kernel, which allocates
+// each output that matches its buffer in the buffer (see
+// OpKernelContext::Params::output_retval_indices).
+class OutputBufferFrame : public CallFrameInterface {
+ public:
+  explicit OutputBufferFrame(const std::vector<EagerKernelRet>& outputs)
+      : outputs_(outputs) {}
+
+  size_t num_args() const override { return 0; }
+  size_t num_retvals() const override { return outputs_.size(); }
+
+  Status GetArg(int index, const Tensor** val) override {
+    return errors::Internal("An op kernel has no arguments.");
+  }
+  Status SetRetval(int index, const Tensor& val) override {
+    return errors::Internal("An op kernel has no return values.");
+  }
+
+  bool GetRetvalBuffer(int index, DataType dtype, const TensorShape& shape,
+                       Tensor* val) override {
+    const Tensor* buffer = OutputBuffer(outputs_, index);
+    if (buffer == nullptr || buffer->dtype() != dtype ||
+        buffer->shape() != shape) {
+      return false;
+    }
+    *val = *buffer;
+    return true;
+  }
+
+ private:
+  const std::vector<EagerKernelRet>& outputs_;
+};
 }  // anonymous namespace
 
 Status KernelAndDeviceOp::Run(
@@ -293,6 +338,28 @@ Status KernelAndDeviceOp::Run(
 
   params.coordination_service_agent = coordination_service_agent;
 
+  // Tensors in `outputs` are buffers for the outputs of kernels on the host,
+  // whose callers can read them directly.
+  std::vector<EagerKernelRet> output_buffers;
+  if (outputs != nullptr && device_->device_type() == DEVICE_CPU) {
+    for (int i = 0, end = outputs->size(); i < end; ++i) {
+      if (OutputBuffer(*outputs, i) != nullptr) {
+        output_buffers.swap(*outputs);
+        break;
+      }
+    }
+  }
+  OutputBufferFrame output_buffer_frame(output_buffers);
+  absl::InlinedVector<int, 4> output_retval_indices;
+  if (!output_buffers.empty()) {
+    for (int i = 0; i < kernel_->num_outputs(); ++i) {
+      output_retval_indices.push_back(
+          OutputBuffer(output_buffers, i) != nullptr ? i : -1);
+    }
+    params.call_frame = &output_buffer_frame;
+    params.output_retval_indices = output_retval_indices.data();
+  }
+
   OpKernelContext context(&params);
 
   {
@@ -323,7 +390,19 @@ Status KernelAndDeviceOp::Run(
     outputs->clear();
     for (int i = 0; i < context.num_outputs(); ++i) {
       const auto* output_tensor = context.mutable_output(i);
-      if (output_tensor != nullptr) {
+      const Tensor* buffer = OutputBuffer(output_buffers, i);
+      if (output_tensor != nullptr && buffer != nullptr &&
+          buffer->dtype() == output_tensor->dtype() &&
+          buffer->shape() == output_tensor->shape() &&
+          DataTypeCanUseMemcpy(buffer->dtype())) {
+        // The kernel forwarded an input or otherwise didn't allocate the
+        // output in its buffer.
+        if (!buffer->SharesBufferWith(*output_tensor) &&
+            buffer->TotalBytes() > 0) {
+          memcpy(buffer->data(), output_tensor->data(), buffer->TotalBytes());
+        }
+        outputs->push_back(*buffer);
+      } else if (output_tensor != nullptr) {
         outputs->push_back(Tensor(*output_tensor));
       } else {
         outputs->push_back(Tensor());
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <vector>
@@ -22,6 +23,9 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/common_runtime/cost_constants.h"
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/entry.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
@@ -30,7 +34,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/pending_counts.h"
 #include "tensorflow/core/common_runtime/propagator_state.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
+#include "tensorflow/core/common_runtime/request_cost.h"
 #include "tensorflow/core/common_runtime/simple_propagator_state.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -46,6 +52,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_node_util.h"
@@ -59,6 +66,7 @@ limitations under the License.
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
@@ -72,6 +80,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
 namespace tensorflow {
@@ -143,6 +152,26 @@ class ExecutorImpl : public Executor {
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
     kernel_stats_.Initialize(immutable_state_.graph_view());
+
+    bool use_critical_path_priority = false;
+    TF_RETURN_IF_ERROR(
+        ReadBoolFromEnvVar("TF_EXECUTOR_CRITICAL_PATH_PRIORITY",
+                           /*default_val=*/false, &use_critical_path_priority));
+    if (use_critical_path_priority) {
+      kernel_stats_.InitializeCriticalPathRanks(graph,
+                                                immutable_state_.graph_view());
+    }
+
+    bool use_step_temp_arena = false;
+    TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_EXECUTOR_STEP_TEMP_ARENA",
+                                          /*default_val=*/false,
+                                          &use_step_temp_arena));
+    // Only host memory is carved into arenas: device allocators are already
+    // pooling allocators, and their memory may be in use by a stream after
+    // the step's kernels have been executed.
+    use_step_temp_arena_ =
+        use_step_temp_arena &&
+        immutable_state_.params().device->device_type() == DEVICE_CPU;
     return Status::OK();
   }
 
@@ -184,6 +213,54 @@ class ExecutorImpl : public Executor {
       return is_expensive_[node.node_id];
     }
 
+    // Computes a static critical-path rank for every node in `gview`: the
+    // estimated cost of the most expensive path from the node to any sink of
+    // `graph`, including the node itself. Once computed, the executor orders
+    // each batch of ready nodes by decreasing rank, so that long dependency
+    // chains are started before short ones.
+    //
+    // REQUIRES: `Initialize(gview)` has been called.
+    void InitializeCriticalPathRanks(const Graph& graph,
+                                     const GraphView& gview) {
+      critical_path_ranks_.assign(gview.num_nodes(), 0);
+      // In post order every node appears after all the nodes reachable from
+      // it (back edges of loops are ignored), so the ranks of a node's
+      // successors are final when the node itself is visited.
+      std::vector<Node*> post_order;
+      GetPostOrder(graph, &post_order);
+      for (const Node* n : post_order) {
+        const NodeItem* item = gview.node(n->id());
+        if (item == nullptr) continue;
+        uint64 max_successor_rank = 0;
+        for (const EdgeInfo& e : item->output_edges()) {
+          max_successor_rank =
+              std::max(max_successor_rank, critical_path_ranks_[e.dst_id]);
+        }
+        for (const ControlEdgeInfo& e : item->output_control_edges()) {
+          max_successor_rank =
+              std::max(max_successor_rank, critical_path_ranks_[e.dst_id]);
+        }
+        const uint64 node_cost = is_expensive_[item->node_id]
+                                     ? kExpensiveNodeRankCost
+                                     : kInexpensiveNodeRankCost;
+        critical_path_ranks_[item->node_id] = max_successor_rank + node_cost;
+      }
+    }
+
+    // Returns true iff `InitializeCriticalPathRanks()` has been called, and
+    // ready nodes should be dispatched in critical-path order.
+    bool UseCriticalPathPriority() const {
+      return !critical_path_ranks_.empty();
+    }
+
+    // Returns the critical-path rank of the given node. Nodes with a larger
+    // rank should be scheduled first.
+    //
+    // REQUIRES: `UseCriticalPathPriority()` is true.
+    uint64 CriticalPathRank(const NodeItem& node) const {
+      return critical_path_ranks_[node.node_id];
+    }
+
     // Updates the dynamic cost estimate, which is used to determine whether the
     // given node is expensive. The new cost estimate is a weighted average of
     // the old cost estimate and the latest cost. We only update cost estimates
@@ -209,14 +286,26 @@ class ExecutorImpl : public Executor {
     static constexpr uint64 kOpIsExpensiveThresholdCycles = 8000;
     static constexpr uint64 kCostDecay = 10;
 
+    // Relative costs used to weigh nodes when computing critical-path ranks.
+    static constexpr uint64 kExpensiveNodeRankCost = 100;
+    static constexpr uint64 kInexpensiveNodeRankCost = 1;
+
     std::vector<bool> is_expensive_;
     // std::unique_ptr<std::atomic<bool>[]> is_expensive_;
     std::unique_ptr<std::atomic_uint_fast64_t[]> cost_estimates_;
+    // Empty unless critical-path priority scheduling is enabled.
+    std::vector<uint64> critical_path_ranks_;
   };
 
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
 
+  // If true, the temporary tensors of each step are allocated from a
+  // `StepArenaAllocator`, whose first block is sized by the peak arena usage
+  // of the most recently finished step.
+  bool use_step_temp_arena_ = false;
+  std::atomic<size_t> step_temp_arena_bytes_{0};
+
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
 
@@ -272,9 +361,13 @@ class ExecutorImpl : public Executor {
 template <class PropagatorStateType>
 class ExecutorState {
  public:
+  // If `step_temp_arena_bytes` is not null, the temporary tensors of the step
+  // are allocated from a per-step arena, sized by and updated with the value
+  // it points to.
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                std::atomic<size_t>* step_temp_arena_bytes);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -360,6 +453,12 @@ class ExecutorState {
   // Step-local container.
   ScopedStepContainer* step_container_;
   StepStatsCollectorInterface* const stats_collector_;
+  RequestCost* const request_cost_;
+  // Time spent in the synchronous kernels, recorded only if `request_cost_` is
+  // set. Async kernels mostly wait for other work, e.g. a Recv or a function
+  // whose kernels record their own time, and the step may have ended by the
+  // time ComputeAsync() returns, so they aren't timed.
+  std::atomic<int64_t> kernel_time_ns_{0};
   const tracing::EventCollector* const event_collector_;
   Context context_;
 
@@ -369,6 +468,10 @@ class ExecutorState {
   CallFrameInterface* call_frame_;
   const ImmutableExecutorState& immutable_state_;
   ExecutorImpl::KernelStats* const kernel_stats_;
+  std::atomic<size_t>* const step_temp_arena_bytes_;
+  // Finished (rather than deleted) when the step ends. Not null iff
+  // `step_temp_arena_bytes_` is not null.
+  StepArenaAllocator* step_temp_arena_ = nullptr;
   CancellationManager* cancellation_manager_;
   CoordinationServiceAgent* coordination_service_agent_;
   // If not null, use this device to schedule intra-op operation
@@ -397,7 +500,8 @@ class ExecutorState {
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats,
+    std::atomic<size_t>* step_temp_arena_bytes)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -411,6 +515,7 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       tensor_store_(args.tensor_store),
       step_container_(args.step_container),
       stats_collector_(args.stats_collector),
+      request_cost_(args.request_cost),
       event_collector_(
           tracing::GetEventCollector(tracing::EventCategory::kCompute)),
       context_(ContextKind::kThread),
@@ -418,6 +523,7 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       call_frame_(args.call_frame),
       immutable_state_(immutable_state),
       kernel_stats_(kernel_stats),
+      step_temp_arena_bytes_(step_temp_arena_bytes),
       cancellation_manager_(args.cancellation_manager),
       coordination_service_agent_(args.coordination_service_agent),
       runner_(args.runner),
@@ -430,6 +536,11 @@ ExecutorState<PropagatorStateType>::ExecutorState(
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  if (step_temp_arena_bytes_ != nullptr) {
+    step_temp_arena_ = new StepArenaAllocator(
+        immutable_state_.params().device->GetAllocator(AllocatorAttributes()),
+        step_temp_arena_bytes_->load(std::memory_order_relaxed));
+  }
 }
 
 template <class PropagatorStateType>
@@ -438,6 +549,17 @@ ExecutorState<PropagatorStateType>::~ExecutorState() {
     device_context_->Unref();
   }
   delete slice_reader_cache_;
+  if (request_cost_ != nullptr) {
+    request_cost_->RecordCost(
+        {{absl::StrCat(absl::AsciiStrToLower(
+                           immutable_state_.params().device->device_type()),
+                       kKernelCostSuffix),
+          absl::Nanoseconds(kernel_time_ns_.load(std::memory_order_relaxed))}});
+  }
+  if (step_temp_arena_ != nullptr) {
+    step_temp_arena_bytes_->store(step_temp_arena_->Finish(),
+                                  std::memory_order_relaxed);
+  }
 }
 
 template <class PropagatorStateType>
@@ -566,6 +688,7 @@ Status ExecutorState<PropagatorStateType>::ProcessSync(
   OpKernel* op_kernel = item.kernel;
   Device* device = immutable_state_.params().device;
   const bool is_expensive = kernel_stats_->IsExpensive(item);
+  const uint64 start_ns = request_cost_ != nullptr ? EnvTime::NowNanos() : 0;
 
   if (TF_PREDICT_FALSE(MightTrace(event_collector_, is_expensive))) {
     tracing::ScopedRegion region(tracing::EventCategory::kCompute,
@@ -591,6 +714,10 @@ Status ExecutorState<PropagatorStateType>::ProcessSync(
   } else {
     device->Compute(op_kernel, &ctx);
   }
+  if (request_cost_ != nullptr) {
+    kernel_time_ns_.fetch_add(EnvTime::NowNanos() - start_ns,
+                              std::memory_order_relaxed);
+  }
   nodestats::SetOpEnd(stats);
   if (outputs->size() < item.num_outputs) outputs->resize(item.num_outputs);
   s = ProcessOutputs(item, &ctx, outputs->data(), stats);
@@ -720,11 +847,13 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
   params.resource_manager = device->resource_manager();
   params.step_container = step_container_;
   params.slice_reader_cache = slice_reader_cache_;
+  params.step_temp_allocator = step_temp_arena_;
   params.inputs = &inputs;
   params.input_alloc_attrs = &input_alloc_attrs;
   params.runner = &runner_;
   params.run_all_kernels_inline = run_all_kernels_inline_;
   params.stats_collector = stats_collector_;
+  params.request_cost = request_cost_;
   params.inc_num_deferred_ops_function = [this]() {
     mutex_lock lock(num_deferred_ops_mu_);
     num_deferred_ops_++;
@@ -811,9 +940,15 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
 
       // Set up compute params.
       params.op_kernel = item.kernel;
+      params.op_device_context = item.device_context != nullptr
+                                     ? item.device_context
+                                     : device_context_;
       params.frame_iter = propagator_.GetFrameAndIter(tagged_node);
       params.is_input_dead = is_input_dead;
       params.output_attr_array = item.output_attrs();
+      params.output_retval_indices =
+          call_frame_ != nullptr ? immutable_state_.output_retval_indices(item)
+                                 : nullptr;
       params.forward_from_array = item.forward_from();
       params.outputs_required_array = item.outputs_required.get();
 
@@ -1165,6 +1300,19 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
     scheduled_nsec = nodestats::NowInNsec();
   }
 
+  if (kernel_stats_->UseCriticalPathPriority() && ready->size() > 1) {
+    // Order the ready nodes by decreasing critical-path rank. Expensive nodes
+    // are dispatched to the thread pool in this order, and inexpensive nodes
+    // are appended to `inline_ready` in this order, so the node with the
+    // longest remaining chain starts first. The last expensive node, which
+    // has the lowest rank, is the one that may run inline.
+    std::stable_sort(ready->begin(), ready->end(),
+                     [this](const TaggedNode& a, const TaggedNode& b) {
+                       return kernel_stats_->CriticalPathRank(*a.node_item) >
+                              kernel_stats_->CriticalPathRank(*b.node_item);
+                     });
+  }
+
   if (run_all_kernels_inline_) {
     if (inline_ready == nullptr) {
       // Schedule all ready kernels from a single closure. This ensure that,
@@ -1356,11 +1504,14 @@ void ExecutorState<PropagatorStateType>::Finish() {
 
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
   if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(
+         args, immutable_state_, &kernel_stats_,
+         use_step_temp_arena_ ? &step_temp_arena_bytes_ : nullptr))
         ->RunAsync(std::move(done));
   } else {
-    (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+    (new ExecutorState<SimplePropagatorState>(
+         args, immutable_state_, &kernel_stats_,
+         use_step_temp_arena_ ? &step_temp_arena_bytes_ : nullptr))
         ->RunAsync(std::move(done));
   }
 }
@@ -33,6 +33,7 @@ limitations under the License.
 
 namespace tensorflow {
 
+class RequestCost;
 class StepStatsCollector;
 
 // Executor runs a graph computation.
@@ -105,6 +106,11 @@ class Executor {
     int64_t start_time_usecs = 0;
     // The deadline for the kernel to complete by. Empty if unspecified.
     absl::optional<absl::Time> deadline;
+    // If not null, the time spent in the synchronous kernels of the step is
+    // recorded there when the step ends, as the cost named by the lower-case
+    // device type and kKernelCostSuffix, e.g. "cpu_kernel". The functions
+    // called by the kernels record their costs there too.
+    RequestCost* request_cost = nullptr;
 
     // If true, calls Sync() on the device.
     bool sync_on_finish = false;
@@ -28,7 +28,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/lower_functional_ops.h"
+#include "tensorflow/core/common_runtime/cost_constants.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/request_cost.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/op.h"
@@ -86,10 +88,11 @@ class ExecutorTest : public ::testing::Test {
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
-  Status Run(Rendezvous* rendez) {
+  Status Run(Rendezvous* rendez, RequestCost* request_cost = nullptr) {
     Executor::Args args;
     args.rendezvous = rendez;
     args.stats_collector = &step_stats_collector_;
+    args.request_cost = request_cost;
     args.runner = runner_;
     return exec_->Run(args);
   }
@@ -175,6 +178,23 @@ TEST_F(ExecutorTest, SimpleAdd) {
   EXPECT_EQ(2.0, V(out));  // out = 1.0 + 1.0 = 2.0
 }
 
+TEST_F(ExecutorTest, RecordsKernelTimeInRequestCost) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  auto tmp = test::graph::Add(g.get(), in0, in0);
+  test::graph::Send(g.get(), tmp, "c", BOB, 1, ALICE);
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0),
+                             false));
+  RequestCost request_cost;
+  TF_ASSERT_OK(Run(rendez_, &request_cost));
+  const auto costs = request_cost.GetCosts();
+  ASSERT_EQ(costs.size(), 1);
+  ASSERT_TRUE(costs.contains(kCpuKernelCostName));
+  EXPECT_GT(costs.at(kCpuKernelCostName), absl::ZeroDuration());
+}
+
 TEST_F(ExecutorTest, SelfAdd) {
   // v0 <- a
   // v1 = v0 + v0
@@ -255,6 +275,62 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWithCriticalPathPriority) {
+  setenv("TF_EXECUTOR_CRITICAL_PATH_PRIORITY", "true", /*overwrite=*/1);
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  unsetenv("TF_EXECUTOR_CRITICAL_PATH_PRIORITY");
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+TEST_F(ExecutorTest, CriticalPathPriorityStartsLongestChainFirst) {
+  setenv("TF_EXECUTOR_CRITICAL_PATH_PRIORITY", "true", /*overwrite=*/1);
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  Node* in = test::graph::Constant(g.get(), V(1.0));
+  // Chains of 1 to 4 identities, the shortest one consuming `in` first. They
+  // are all inexpensive, so they run inline one after another.
+  std::vector<string> chain_heads;
+  for (int length = 1; length <= 4; ++length) {
+    Node* n = test::graph::Identity(g.get(), in);
+    chain_heads.push_back(n->name());
+    for (int i = 1; i < length; ++i) {
+      n = test::graph::Identity(g.get(), n);
+    }
+  }
+  Create(std::move(g));
+  unsetenv("TF_EXECUTOR_CRITICAL_PATH_PRIORITY");
+  TF_ASSERT_OK(Run(rendez_));
+
+  // The stats of the nodes are collected as they finish.
+  step_stats_collector_.Finalize();
+  std::vector<string> execution_order;
+  for (const DeviceStepStats& dev_stats : step_stats_.dev_stats()) {
+    for (const NodeExecStats& node_stats : dev_stats.node_stats()) {
+      execution_order.push_back(node_stats.node_name());
+    }
+  }
+  std::vector<int> head_positions;
+  for (const string& head : chain_heads) {
+    auto it = std::find(execution_order.begin(), execution_order.end(), head);
+    ASSERT_NE(it, execution_order.end()) << head;
+    head_positions.push_back(it - execution_order.begin());
+  }
+  // The longer the chain, the earlier its head runs.
+  for (int i = 1, end = head_positions.size(); i < end; ++i) {
+    EXPECT_LT(head_positions[i], head_positions[i - 1])
+        << "Chain of " << i + 1 << " nodes started after the chain of " << i;
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -0,0 +1,698 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/frozen_plan_executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/entry.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/renamed_device.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace {
+
+typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
+typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
+
+static const string& kFrozenPlanExecutor =
+    *new string("FROZEN_PLAN_EXECUTOR");
+
+// Number of runs whose kernel costs are measured before the plan is frozen.
+constexpr int kNumRecordedRuns = 8;
+
+// Estimated cost of handing a value from one lane to another, which involves
+// waking up a thread in the inter-op thread pool.
+constexpr uint64 kCrossLaneOverheadNanos = 10 * 1000;
+
+constexpr int64_t kDefaultMaxLanes = 4;
+
+// Returns an error if `n` cannot be executed by a frozen plan.
+Status ValidateNodeForFrozenPlan(const Node& n) {
+  for (DataType dt : n.output_types()) {
+    if (IsRefType(dt)) {
+      return errors::Unimplemented(
+          "Frozen plan executor does not support reference-typed edges, but "
+          "saw type ",
+          DataTypeString(dt), " in outputs of node ", n.name());
+    }
+  }
+  if (n.IsControlFlow()) {
+    return errors::FailedPrecondition(
+        "Frozen plan executor does not support low level control flow, but "
+        "saw control flow node ",
+        n.name());
+  }
+  if (n.IsSend() || n.IsHostSend() || n.IsRecv() || n.IsHostRecv()) {
+    return errors::Unimplemented(
+        "Frozen plan executor does not support send/recv nodes, but saw ",
+        n.name());
+  }
+  if (n.IsCollective()) {
+    return errors::Unimplemented(
+        "Frozen plan executor does not support collective ops, but saw ",
+        n.name());
+  }
+  return Status::OK();
+}
+
+class FrozenPlanExecutorImpl : public Executor {
+ public:
+  explicit FrozenPlanExecutorImpl(const LocalExecutorParams& params)
+      : params_(params) {}
+
+  ~FrozenPlanExecutorImpl() override {
+    for (const KernelState& kernel_state : kernels_) {
+      if (kernel_state.kernel != nullptr) {
+        params_.delete_kernel(kernel_state.kernel);
+      }
+    }
+  }
+
+  Status Initialize(const Graph& graph, int max_lanes);
+
+  void RunAsync(const Args& args, DoneCallback done) override;
+
+ private:
+  class RunState;
+
+  // Represents cached graph structure state for each kernel.
+  struct KernelState {
+    // The kernel object. Not owned.
+    //
+    // This pointer is managed by `params_.create_kernel()` and
+    // `params_.delete_kernel()`.
+    OpKernel* kernel = nullptr;
+
+    // These fields determine the range of elements in the per-run `inputs`
+    // vector that corresponds to the inputs of `kernel`.
+    size_t input_start_index;
+    size_t num_inputs;
+
+    size_t num_outputs;
+
+    // For the `j`th output of `kernel`, `output_locations[j]` contains the
+    // locations in the flat `inputs` vector to which that output must be
+    // copied.
+    std::vector<std::vector<size_t>> output_locations;
+
+    // Memory space information for each output of `kernel`.
+    std::vector<AllocatorAttributes> output_alloc_attrs;
+
+    // Indices in `kernels_` of the kernels that consume an output of
+    // `kernel`, or have a control dependency on it. Contains no duplicates.
+    std::vector<int> successors;
+  };
+
+  // An assignment of every kernel to a lane. Each lane executes its kernels
+  // sequentially, in topological order. Immutable once built.
+  struct Plan {
+    // For each lane, the indices in `kernels_` of the kernels it executes.
+    std::vector<std::vector<int>> lanes;
+
+    // For each kernel, the lane executing it and its position in that lane.
+    std::vector<int> lane_of;
+    std::vector<size_t> position_in_lane;
+
+    // For each kernel, the number of its predecessors executed by a different
+    // lane, which must complete before the kernel may start.
+    std::vector<int> num_cross_lane_inputs;
+
+    // For each kernel, its successors executed by a different lane.
+    std::vector<std::vector<int>> cross_lane_successors;
+  };
+
+  // Returns a plan with a single lane that executes all kernels.
+  std::unique_ptr<const Plan> BuildSequentialPlan() const;
+
+  // Returns a plan that spreads the kernels across up to `max_lanes_` lanes,
+  // using list scheduling with the given per-kernel cost estimates.
+  std::unique_ptr<const Plan> BuildPlan(
+      const std::vector<uint64>& cost_nanos) const;
+
+  // Accumulates the kernel costs measured in a recorded run, and freezes the
+  // plan once enough runs have been recorded.
+  void RecordCosts(const std::vector<uint64>& cost_nanos);
+
+  const LocalExecutorParams params_;
+
+  // All following members are read-only after Initialize().
+
+  // The kernels of the graph, in topological order.
+  std::vector<KernelState> kernels_;
+
+  // The sum of the number of inputs for each kernel in the graph.
+  size_t total_num_inputs_ = 0;
+
+  // Memory space information for each input, in the same order as the flat
+  // `inputs` vector.
+  std::vector<AllocatorAttributes> input_alloc_attrs_;
+
+  int max_lanes_ = 1;
+
+  std::shared_ptr<const Plan> sequential_plan_;
+
+  mutex mu_;
+  // The replayed plan. Null until `kNumRecordedRuns` runs have been recorded.
+  std::shared_ptr<const Plan> frozen_plan_ TF_GUARDED_BY(mu_);
+  int num_recorded_runs_ TF_GUARDED_BY(mu_) = 0;
+  std::vector<uint64> total_cost_nanos_ TF_GUARDED_BY(mu_);
+};
+
+// The state associated with one invocation of FrozenPlanExecutorImpl::RunAsync.
+// Deletes itself once the last lane has finished.
+class FrozenPlanExecutorImpl::RunState {
+ public:
+  RunState(FrozenPlanExecutorImpl* impl, std::shared_ptr<const Plan> plan,
+           const Args& args, bool record_costs, DoneCallback done);
+  ~RunState();
+
+  // Starts executing every lane.
+  void Start();
+
+ private:
+  // Per-lane state. A lane runs on at most one thread at a time.
+  struct Lane {
+    OpKernelContext::Params params;
+    TensorValueVec node_inputs;
+    AllocatorAttributeVec input_alloc_attrs;
+  };
+
+  void InitializeParams(const Args& args, Lane* lane);
+
+  // Executes the kernels of `lane_id`, starting at `position`. If `is_ready`
+  // is true, the kernel at `position` is known to have all of its inputs.
+  void RunLane(int lane_id, size_t position, bool is_ready);
+
+  void ExecuteKernel(Lane* lane, int kernel_index);
+
+  void Abort(const Status& s);
+
+  void LaneDone();
+
+  FrozenPlanExecutorImpl* const impl_;
+  const std::shared_ptr<const Plan> plan_;
+  const bool record_costs_;
+  DoneCallback done_;
+
+  Args::Runner runner_;
+  Device* device_;
+  std::unique_ptr<Device> user_device_;
+  DeviceContext* device_context_ = nullptr;
+
+  // The inputs to each kernel. See `SingleThreadedExecutorImpl::Run()` for a
+  // description of the layout.
+  std::vector<Entry> inputs_;
+
+  // For each kernel with cross-lane inputs, the number of such inputs that
+  // have not been produced yet, plus one for the kernel's own lane reaching
+  // it.
+  std::unique_ptr<std::atomic<int>[]> pending_;
+
+  std::unique_ptr<Lane[]> lanes_;
+  std::atomic<int> num_pending_lanes_;
+
+  // Measured cost of each kernel. Only populated if `record_costs_` is true.
+  std::vector<uint64> cost_nanos_;
+
+  std::atomic<bool> aborted_{false};
+  mutex mu_;
+  Status status_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RunState);
+};
+
+Status FrozenPlanExecutorImpl::Initialize(const Graph& graph, int max_lanes) {
+  max_lanes_ = std::max(1, max_lanes);
+
+  // Topologicially sort `graph` to get a sequence of OpKernels.
+  std::vector<Node*> ordered_nodes;
+  ordered_nodes.reserve(graph.num_nodes());
+  GetReversePostOrder(graph, &ordered_nodes);
+  if (static_cast<int>(ordered_nodes.size()) != graph.num_nodes()) {
+    return errors::InvalidArgument("Graph had ", graph.num_nodes(),
+                                   " but reverse post-order had ",
+                                   ordered_nodes.size());
+  }
+
+  std::vector<int> node_id_to_index(graph.num_node_ids(), -1);
+  kernels_.resize(ordered_nodes.size());
+  size_t input_start_index = 0;
+  for (size_t i = 0; i < ordered_nodes.size(); ++i) {
+    const Node* n = ordered_nodes[i];
+    node_id_to_index[n->id()] = i;
+    KernelState& kernel_state = kernels_[i];
+    TF_RETURN_IF_ERROR(
+        params_.create_kernel(n->properties(), &kernel_state.kernel));
+    kernel_state.input_start_index = input_start_index;
+    kernel_state.num_inputs = n->num_inputs();
+    kernel_state.num_outputs = n->num_outputs();
+    input_start_index += kernel_state.num_inputs;
+  }
+  total_num_inputs_ = input_start_index;
+
+  // Build the mapping from each node output to the input slot for the
+  // corresponding destination node, and the dependencies between kernels.
+  for (size_t i = 0; i < ordered_nodes.size(); ++i) {
+    const Node* n = ordered_nodes[i];
+    KernelState& kernel_state = kernels_[i];
+    kernel_state.output_locations.resize(kernel_state.num_outputs);
+    for (const Edge* e : n->out_edges()) {
+      const int dst_index = node_id_to_index[e->dst()->id()];
+      if (!e->IsControlEdge()) {
+        kernel_state.output_locations[e->src_output()].push_back(
+            kernels_[dst_index].input_start_index + e->dst_input());
+      }
+      kernel_state.successors.push_back(dst_index);
+    }
+    std::sort(kernel_state.successors.begin(), kernel_state.successors.end());
+    kernel_state.successors.erase(std::unique(kernel_state.successors.begin(),
+                                              kernel_state.successors.end()),
+                                  kernel_state.successors.end());
+
+    // Compute allocator attributes for each node output.
+    kernel_state.output_alloc_attrs.resize(kernel_state.num_outputs);
+    const OpKernel* op_kernel = kernel_state.kernel;
+    for (int out = 0; out < n->num_outputs(); out++) {
+      DCHECK_LT(out, op_kernel->output_memory_types().size());
+      if (op_kernel->output_memory_types()[out] == HOST_MEMORY) {
+        AllocatorAttributes h;
+        h.set_on_host(true);
+        kernel_state.output_alloc_attrs[out].Merge(h);
+      }
+    }
+  }
+
+  input_alloc_attrs_.resize(total_num_inputs_);
+  for (const KernelState& kernel_state : kernels_) {
+    for (size_t j = 0; j < kernel_state.output_locations.size(); ++j) {
+      for (size_t output_location : kernel_state.output_locations[j]) {
+        input_alloc_attrs_[output_location] =
+            kernel_state.output_alloc_attrs[j];
+      }
+    }
+  }
+
+  sequential_plan_ = BuildSequentialPlan();
+  mutex_lock l(mu_);
+  total_cost_nanos_.assign(kernels_.size(), 0);
+  return Status::OK();
+}
+
+std::unique_ptr<const FrozenPlanExecutorImpl::Plan>
+FrozenPlanExecutorImpl::BuildSequentialPlan() const {
+  const int num_kernels = kernels_.size();
+  auto plan = absl::make_unique<Plan>();
+  plan->lanes.resize(1);
+  plan->lanes[0].reserve(num_kernels);
+  plan->lane_of.assign(num_kernels, 0);
+  plan->position_in_lane.resize(num_kernels);
+  plan->num_cross_lane_inputs.assign(num_kernels, 0);
+  plan->cross_lane_successors.resize(num_kernels);
+  for (int i = 0; i < num_kernels; ++i) {
+    plan->lanes[0].push_back(i);
+    plan->position_in_lane[i] = i;
+  }
+  return plan;
+}
+
+std::unique_ptr<const FrozenPlanExecutorImpl::Plan>
+FrozenPlanExecutorImpl::BuildPlan(const std::vector<uint64>& cost_nanos) const {
+  const int num_kernels = kernels_.size();
+  std::vector<std::vector<int>> predecessors(num_kernels);
+  for (int i = 0; i < num_kernels; ++i) {
+    for (int successor : kernels_[i].successors) {
+      predecessors[successor].push_back(i);
+    }
+  }
+
+  // Greedy list scheduling: visit the kernels in topological order, and
+  // assign each one to the lane where it can start the earliest. Starting a
+  // lane, and consuming a value produced by another lane, both incur a thread
+  // handoff, so cheap kernels stay in the lane of their producers.
+  std::vector<uint64> lane_available_at(max_lanes_, kCrossLaneOverheadNanos);
+  lane_available_at[0] = 0;
+  std::vector<uint64> finish_time(num_kernels, 0);
+  std::vector<int> lane_of(num_kernels, 0);
+  for (int i = 0; i < num_kernels; ++i) {
+    int best_lane = 0;
+    uint64 best_start_time = std::numeric_limits<uint64>::max();
+    for (int lane = 0; lane < max_lanes_; ++lane) {
+      uint64 start_time = lane_available_at[lane];
+      for (int predecessor : predecessors[i]) {
+        const uint64 handoff =
+            lane_of[predecessor] == lane ? 0 : kCrossLaneOverheadNanos;
+        start_time = std::max(start_time, finish_time[predecessor] + handoff);
+      }
+      if (start_time < best_start_time) {
+        best_lane = lane;
+        best_start_time = start_time;
+      }
+    }
+    lane_of[i] = best_lane;
+    finish_time[i] = best_start_time + cost_nanos[i];
+    lane_available_at[best_lane] = finish_time[i];
+  }
+
+  // Renumber the lanes that are actually used, in order of first use.
+  std::vector<int> lane_ids(max_lanes_, -1);
+  auto plan = absl::make_unique<Plan>();
+  plan->lane_of.resize(num_kernels);
+  plan->position_in_lane.resize(num_kernels);
+  plan->num_cross_lane_inputs.assign(num_kernels, 0);
+  plan->cross_lane_successors.resize(num_kernels);
+  for (int i = 0; i < num_kernels; ++i) {
+    int& lane_id = lane_ids[lane_of[i]];
+    if (lane_id == -1) {
+      lane_id = plan->lanes.size();
+      plan->lanes.emplace_back();
+    }
+    plan->lane_of[i] = lane_id;
+    plan->position_in_lane[i] = plan->lanes[lane_id].size();
+    plan->lanes[lane_id].push_back(i);
+  }
+  for (int i = 0; i < num_kernels; ++i) {
+    for (int successor : kernels_[i].successors) {
+      if (plan->lane_of[successor] != plan->lane_of[i]) {
+        plan->cross_lane_successors[i].push_back(successor);
+        ++plan->num_cross_lane_inputs[successor];
+      }
+    }
+  }
+  VLOG(1) << "Froze execution plan with " << plan->lanes.size()
+          << " lane(s) for " << num_kernels << " kernels.";
+  return plan;
+}
+
+void FrozenPlanExecutorImpl::RecordCosts(const std::vector<uint64>& cost_nanos) {
+  mutex_lock l(mu_);
+  if (frozen_plan_ != nullptr) return;
+  for (size_t i = 0; i < cost_nanos.size(); ++i) {
+    total_cost_nanos_[i] += cost_nanos[i];
+  }
+  if (++num_recorded_runs_ < kNumRecordedRuns) return;
+
+  std::vector<uint64> average_cost_nanos(total_cost_nanos_.size());
+  for (size_t i = 0; i < total_cost_nanos_.size(); ++i) {
+    average_cost_nanos[i] = total_cost_nanos_[i] / num_recorded_runs_;
+  }
+  frozen_plan_ = BuildPlan(average_cost_nanos);
+}
+
+void FrozenPlanExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
+  std::shared_ptr<const Plan> plan;
+  bool record_costs = false;
+  {
+    mutex_lock l(mu_);
+    plan = frozen_plan_;
+  }
+  if (plan == nullptr) {
+    plan = sequential_plan_;
+    record_costs = true;
+  }
+  (new RunState(this, std::move(plan), args, record_costs, std::move(done)))
+      ->Start();
+}
+
+FrozenPlanExecutorImpl::RunState::RunState(FrozenPlanExecutorImpl* impl,
+                                           std::shared_ptr<const Plan> plan,
+                                           const Args& args, bool record_costs,
+                                           DoneCallback done)
+    : impl_(impl),
+      plan_(std::move(plan)),
+      record_costs_(record_costs),
+      done_(std::move(done)),
+      runner_(args.runner),
+      device_(impl->params_.device),
+      inputs_(impl->total_num_inputs_),
+      pending_(new std::atomic<int>[impl->kernels_.size()]),
+      lanes_(new Lane[plan_->lanes.size()]),
+      num_pending_lanes_(plan_->lanes.size()) {
+  // Override intra op thread pool if requested.
+  if (args.user_intra_op_threadpool != nullptr) {
+    user_device_ = RenamedDevice::NewRenamedDevice(
+        device_->name(), device_, /*owns_underlying=*/false,
+        /*isolate_session_state=*/false, args.user_intra_op_threadpool);
+    device_ = user_device_.get();
+  }
+  device_->TryGetDeviceContext(&device_context_).IgnoreError();
+
+  for (size_t i = 0; i < impl_->kernels_.size(); ++i) {
+    const int num_cross_lane_inputs = plan_->num_cross_lane_inputs[i];
+    pending_[i].store(num_cross_lane_inputs > 0 ? num_cross_lane_inputs + 1 : 0,
+                      std::memory_order_relaxed);
+  }
+  for (size_t i = 0; i < plan_->lanes.size(); ++i) {
+    InitializeParams(args, &lanes_[i]);
+  }
+  if (record_costs_) {
+    cost_nanos_.assign(impl_->kernels_.size(), 0);
+  }
+}
+
+FrozenPlanExecutorImpl::RunState::~RunState() {
+  if (device_context_ != nullptr) {
+    device_context_->Unref();
+  }
+}
+
+void FrozenPlanExecutorImpl::RunState::InitializeParams(const Args& args,
+                                                        Lane* lane) {
+  OpKernelContext::Params& params = lane->params;
+  params.step_id = args.step_id;
+  params.device = device_;
+  params.log_memory = false;
+  params.rendezvous = args.rendezvous;
+  params.session_state = args.session_state;
+  params.session_metadata = impl_->params_.session_metadata;
+  params.tensor_store = args.tensor_store;
+  params.cancellation_manager = args.cancellation_manager;
+  params.call_frame = args.call_frame;
+  params.function_library = impl_->params_.function_library;
+  params.resource_manager = device_->resource_manager();
+  params.step_container = args.step_container;
+  params.collective_executor = args.collective_executor;
+  params.slice_reader_cache = nullptr;
+  params.inputs = &lane->node_inputs;
+  params.input_alloc_attrs = &lane->input_alloc_attrs;
+  params.runner = &runner_;
+  params.run_all_kernels_inline = args.run_all_kernels_inline;
+  params.stats_collector = args.stats_collector;
+  params.executor_type = &kFrozenPlanExecutor;
+  // The graph is loopless and condless.
+  params.frame_iter = FrameAndIter(0, 0);
+  params.is_input_dead = false;
+  params.op_device_context = device_context_;
+  params.forward_from_array = nullptr;
+}
+
+void FrozenPlanExecutorImpl::RunState::Start() {
+  // Copy the runner, because `this` may be deleted while the last lane is
+  // being scheduled.
+  Args::Runner runner = runner_;
+  const int num_lanes = plan_->lanes.size();
+  for (int lane_id = 0; lane_id < num_lanes; ++lane_id) {
+    runner([this, lane_id]() { RunLane(lane_id, 0, /*is_ready=*/false); });
+  }
+}
+
+void FrozenPlanExecutorImpl::RunState::RunLane(int lane_id, size_t position,
+                                               bool is_ready) {
+  const std::vector<int>& kernel_indices = plan_->lanes[lane_id];
+  Lane* lane = &lanes_[lane_id];
+  for (; position < kernel_indices.size(); ++position) {
+    const int kernel_index = kernel_indices[position];
+    if (!is_ready && plan_->num_cross_lane_inputs[kernel_index] > 0 &&
+        pending_[kernel_index].fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      // The producer of the last missing input resumes this lane.
+      return;
+    }
+    is_ready = false;
+
+    ExecuteKernel(lane, kernel_index);
+
+    for (int successor : plan_->cross_lane_successors[kernel_index]) {
+      if (pending_[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        const int successor_lane = plan_->lane_of[successor];
+        const size_t successor_position = plan_->position_in_lane[successor];
+        runner_([this, successor_lane, successor_position]() {
+          RunLane(successor_lane, successor_position, /*is_ready=*/true);
+        });
+      }
+    }
+  }
+  LaneDone();
+}
+
+void FrozenPlanExecutorImpl::RunState::ExecuteKernel(Lane* lane,
+                                                     int kernel_index) {
+  const KernelState& kernel_state = impl_->kernels_[kernel_index];
+  const size_t input_start_index = kernel_state.input_start_index;
+  const size_t num_inputs = kernel_state.num_inputs;
+  const size_t num_outputs = kernel_state.num_outputs;
+
+  if (aborted_.load(std::memory_order_acquire)) {
+    // Release the inputs, but do not run any more kernels.
+    for (size_t j = 0; j < num_inputs; ++j) {
+      inputs_[input_start_index + j].ClearVal();
+    }
+    return;
+  }
+
+  TensorValueVec& node_inputs = lane->node_inputs;
+  AllocatorAttributeVec& input_alloc_attrs = lane->input_alloc_attrs;
+  node_inputs.clear();
+  node_inputs.resize(num_inputs);
+  input_alloc_attrs.clear();
+  input_alloc_attrs.resize(num_inputs);
+  for (size_t j = 0; j < num_inputs; ++j) {
+    Entry& input = inputs_[input_start_index + j];
+    if (TF_PREDICT_FALSE(input.state != Entry::State::HAS_VALUE)) {
+      Abort(errors::Internal("Input ", j, " of kernel ",
+                             kernel_state.kernel->name(),
+                             " did not have a valid value."));
+      for (size_t k = 0; k < num_inputs; ++k) {
+        inputs_[input_start_index + k].ClearVal();
+      }
+      return;
+    }
+    node_inputs[j].tensor = input.val.get();
+    input_alloc_attrs[j] = impl_->input_alloc_attrs_[input_start_index + j];
+  }
+  lane->params.op_kernel = kernel_state.kernel;
+  lane->params.output_attr_array = kernel_state.output_alloc_attrs.data();
+  OpKernelContext ctx(&lane->params, num_outputs);
+
+  const uint64 start_nanos = record_costs_ ? EnvTime::NowNanos() : 0;
+  device_->Compute(kernel_state.kernel, &ctx);
+  if (record_costs_) {
+    cost_nanos_[kernel_index] = EnvTime::NowNanos() - start_nanos;
+  }
+
+  // Free the inputs to the current kernel.
+  for (size_t j = 0; j < num_inputs; ++j) {
+    inputs_[input_start_index + j].ClearVal();
+  }
+  if (TF_PREDICT_FALSE(!ctx.status().ok())) {
+    Abort(ctx.status());
+    return;
+  }
+
+  // Forward the outputs of the kernel to the inputs of subsequent kernels.
+  for (size_t j = 0; j < num_outputs; ++j) {
+    TensorValue val = ctx.release_output(j);
+    const std::vector<size_t>& output_locations =
+        kernel_state.output_locations[j];
+    const size_t num_destinations = output_locations.size();
+    if (num_destinations > 0) {
+      if (TF_PREDICT_FALSE(val.tensor == nullptr)) {
+        Abort(errors::Internal("Kernel ", kernel_state.kernel->name(),
+                               " did not produce required output ", j));
+        continue;
+      }
+      for (size_t k = 0; k < num_destinations - 1; ++k) {
+        Entry& input = inputs_[output_locations[k]];
+        input.state = Entry::State::HAS_VALUE;
+        input.val.Init(*val.tensor);
+      }
+      // Move the output to the last consumer to avoid the cost of copying it.
+      Entry& input = inputs_[output_locations[num_destinations - 1]];
+      input.state = Entry::State::HAS_VALUE;
+      input.val.Init(std::move(*val.tensor));
+    }
+    delete val.tensor;
+  }
+}
+
+void FrozenPlanExecutorImpl::RunState::Abort(const Status& s) {
+  mutex_lock l(mu_);
+  if (status_.ok()) {
+    status_ = s;
+  }
+  aborted_.store(true, std::memory_order_release);
+}
+
+void FrozenPlanExecutorImpl::RunState::LaneDone() {
+  if (num_pending_lanes_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+  Status status;
+  {
+    mutex_lock l(mu_);
+    status = status_;
+  }
+  if (record_costs_ && status.ok()) {
+    impl_->RecordCosts(cost_nanos_);
+  }
+  DoneCallback done = std::move(done_);
+  delete this;
+  done(status);
+}
+
+class FrozenPlanExecutorRegistrar {
+ public:
+  FrozenPlanExecutorRegistrar() {
+    ExecutorFactory::Register(kFrozenPlanExecutor, new Factory());
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      Executor* ret;
+      TF_RETURN_IF_ERROR(NewFrozenPlanExecutor(params, graph, &ret));
+      out_executor->reset(ret);
+      return Status::OK();
+    }
+  };
+};
+static FrozenPlanExecutorRegistrar registrar;
+
+}  // namespace
+
+Status NewFrozenPlanExecutor(const LocalExecutorParams& params,
+                             const Graph& graph, Executor** executor) {
+  for (const Node* n : graph.nodes()) {
+    Status s = ValidateNodeForFrozenPlan(*n);
+    if (!s.ok()) {
+      VLOG(1) << "Using the default executor instead of a frozen plan: " << s;
+      return NewLocalExecutor(params, graph, executor);
+    }
+  }
+
+  int64_t max_lanes;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_FROZEN_PLAN_EXECUTOR_MAX_LANES",
+                                         kDefaultMaxLanes, &max_lanes));
+  auto impl = absl::make_unique<FrozenPlanExecutorImpl>(params);
+  TF_RETURN_IF_ERROR(impl->Initialize(graph, max_lanes));
+  *executor = impl.release();
+  return Status::OK();
+}
+
+}  // namespace tensorflow
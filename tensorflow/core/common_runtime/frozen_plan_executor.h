@@ -0,0 +1,49 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_FROZEN_PLAN_EXECUTOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_FROZEN_PLAN_EXECUTOR_H_
+
+#include "tensorflow/core/common_runtime/executor.h"
+
+namespace tensorflow {
+
+// Creates a new `Executor` for executing `graph` with a precomputed
+// ("frozen") schedule. The executor is also registered with the
+// `ExecutorFactory` as "FROZEN_PLAN_EXECUTOR", so that it can be selected with
+// `ConfigProto.experimental.executor_type`.
+//
+// The first few runs execute the kernels one at a time in topological order,
+// like the single-threaded executor, while measuring the cost of each kernel.
+// The measured costs are then used to assign every kernel to one of a small
+// number of "lanes", and to fix the order of the kernels within each lane.
+// Subsequent runs replay that plan: each lane runs its kernels back-to-back,
+// and only dependencies between different lanes are counted at runtime. Graphs
+// of cheap kernels typically end up in a single lane, avoiding all thread
+// handoffs, whereas independent expensive branches are spread across lanes.
+//
+// The frozen plan is only used for graphs that the single-threaded executor
+// could run (no reference-typed edges, no low level control flow, no
+// send/recv nodes and no collective ops). For any other graph, this executor
+// transparently delegates to the default executor.
+//
+// The maximum number of lanes defaults to 4, and may be changed with the
+// TF_FROZEN_PLAN_EXECUTOR_MAX_LANES environment variable.
+Status NewFrozenPlanExecutor(const LocalExecutorParams& params,
+                             const Graph& graph, Executor** executor);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_FROZEN_PLAN_EXECUTOR_H_
@@ -0,0 +1,246 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/frozen_plan_executor.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// Forwards its input after sleeping for a millisecond, so that it is
+// considered expensive when the plan is frozen.
+class SlowIdentityOp : public OpKernel {
+ public:
+  using OpKernel::OpKernel;
+
+  void Compute(OpKernelContext* ctx) override {
+    Env::Default()->SleepForMicroseconds(1000);
+    ctx->set_output(0, ctx->input(0));
+  }
+};
+REGISTER_OP("FrozenPlanSlowIdentity").Input("x: float").Output("y: float");
+REGISTER_KERNEL_BUILDER(Name("FrozenPlanSlowIdentity").Device(DEVICE_CPU),
+                        SlowIdentityOp);
+
+// The number of runs after which the plan is guaranteed to be frozen.
+constexpr int kNumRunsToFreeze = 16;
+
+class FrozenPlanExecutorTest : public ::testing::Test {
+ protected:
+  FrozenPlanExecutorTest()
+      : device_(DeviceFactory::NewDevice("CPU", {},
+                                         "/job:localhost/replica:0/task:0")),
+        thread_pool_(Env::Default(), "frozen_plan_test", 4) {}
+
+  void Create(std::unique_ptr<const Graph> graph) {
+    const int version = graph->versions().producer();
+    LocalExecutorParams params;
+    params.device = device_.get();
+    params.create_kernel =
+        [this, version](const std::shared_ptr<const NodeProperties>& props,
+                        OpKernel** kernel) {
+          return CreateNonCachedKernel(device_.get(), nullptr, props, version,
+                                       kernel);
+        };
+    params.delete_kernel = [](OpKernel* kernel) {
+      DeleteNonCachedKernel(kernel);
+    };
+    TF_CHECK_OK(NewExecutor("FROZEN_PLAN_EXECUTOR", params, *graph, &exec_));
+  }
+
+  Status Run(CallFrameInterface* call_frame) {
+    Executor::Args args;
+    args.call_frame = call_frame;
+    args.runner = [this](std::function<void()> fn) {
+      thread_pool_.Schedule(std::move(fn));
+    };
+    return exec_->Run(args);
+  }
+
+  std::unique_ptr<Device> device_;
+  thread::ThreadPool thread_pool_;
+  std::unique_ptr<Executor> exec_;
+};
+
+// A float val -> Tensor<float>
+Tensor V(const float val) {
+  Tensor tensor(DT_FLOAT, TensorShape({}));
+  tensor.scalar<float>()() = val;
+  return tensor;
+}
+
+// Tensor<float> -> a float val.
+float V(const Tensor& tensor) {
+  CHECK_EQ(tensor.dtype(), DT_FLOAT);
+  CHECK(TensorShapeUtils::IsScalar(tensor.shape()));
+  return tensor.scalar<float>()();
+}
+
+Node* SlowIdentity(Graph* g, Node* input) {
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "FrozenPlanSlowIdentity")
+                  .Input(input)
+                  .Finalize(g, &ret));
+  return ret;
+}
+
+TEST_F(FrozenPlanExecutorTest, SimpleAdd) {
+  // c = a + b
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto in1 = test::graph::Arg(g.get(), 1, DT_FLOAT);
+  auto tmp = test::graph::Add(g.get(), in0, in1);
+  test::graph::Retval(g.get(), 0, tmp);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  for (int i = 0; i < kNumRunsToFreeze; ++i) {
+    FunctionCallFrame call_frame({DT_FLOAT, DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(1.0), V(i)}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(1.0 + i, V(retvals[0]));
+  }
+}
+
+TEST_F(FrozenPlanExecutorTest, IndependentExpensiveBranches) {
+  // Four slow branches, which the frozen plan spreads across lanes, joined by
+  // a tree of additions.
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  std::vector<Node*> branches;
+  for (int i = 0; i < 4; ++i) {
+    branches.push_back(SlowIdentity(g.get(), SlowIdentity(g.get(), in)));
+  }
+  auto sum0 = test::graph::Add(g.get(), branches[0], branches[1]);
+  auto sum1 = test::graph::Add(g.get(), branches[2], branches[3]);
+  test::graph::Retval(g.get(), 0, test::graph::Add(g.get(), sum0, sum1));
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  for (int i = 0; i < kNumRunsToFreeze; ++i) {
+    FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(i)}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(4.0 * i, V(retvals[0]));
+  }
+}
+
+// Builds a graph which adds N copies of one argument, parenthesized randomly.
+void BuildTree(int N, Graph* g) {
+  CHECK_GT(N, 1);
+  auto in = test::graph::Arg(g, 0, DT_FLOAT);
+  std::vector<Node*> nodes;
+  for (int i = 0; i < N; ++i) {
+    nodes.push_back(test::graph::Identity(g, in, 0));
+  }
+  random::PhiloxRandom philox(0, 17);
+  random::SimplePhilox rnd(&philox);
+  while (nodes.size() > 1) {
+    int x = rnd.Uniform(nodes.size());
+    auto in0 = nodes[x];
+    nodes[x] = nodes.back();
+    nodes.resize(nodes.size() - 1);
+    x = rnd.Uniform(nodes.size());
+    auto in1 = nodes[x];
+    nodes[x] = test::graph::Add(g, in0, in1);
+  }
+  test::graph::Retval(g, 0, nodes.back());
+  FixupSourceAndSinkEdges(g);
+}
+
+TEST_F(FrozenPlanExecutorTest, RandomTree) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(1024, g.get());
+  Create(std::move(g));
+  for (int i = 0; i < kNumRunsToFreeze; ++i) {
+    FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(1024.0, V(retvals[0]));
+  }
+}
+
+TEST_F(FrozenPlanExecutorTest, OpError) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto zero = test::graph::Constant(g.get(), V(0.0));
+  auto inf = test::graph::Unary(g.get(), "Reciprocal", zero);
+  auto check = test::graph::CheckNumerics(g.get(), inf, "message");
+  auto two = test::graph::Constant(g.get(), V(2.0));
+  test::graph::Binary(g.get(), "Mul", check, two);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  for (int i = 0; i < kNumRunsToFreeze; ++i) {
+    FunctionCallFrame call_frame({}, {});
+    EXPECT_TRUE(errors::IsInvalidArgument(Run(&call_frame)));
+  }
+}
+
+void BM_FrozenPlanExecutor(::testing::benchmark::State& state) {
+  const int width = state.range(0);
+  const int depth = state.range(1);
+
+  Graph* g = new Graph(OpRegistry::Global());
+  random::PhiloxRandom philox(1729, 17);
+  random::SimplePhilox rand(&philox);
+  std::vector<Node*> cur;
+  for (int i = 0; i < width; ++i) {
+    cur.push_back(test::graph::Constant(g, V(1.0)));
+  }
+  for (int i = 0; i < depth; ++i) {
+    std::vector<Node*> next;
+    for (int j = 0; j < width; ++j) {
+      next.push_back(test::graph::Identity(g, cur[rand.Uniform(width)]));
+    }
+    cur.swap(next);
+  }
+  FixupSourceAndSinkEdges(g);
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr, "FROZEN_PLAN_EXECUTOR",
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+}
+BENCHMARK(BM_FrozenPlanExecutor)->UseRealTime()->ArgPair(16, 16);
+BENCHMARK(BM_FrozenPlanExecutor)->UseRealTime()->ArgPair(64, 64);
+
+}  // namespace
+}  // namespace tensorflow
@@ -163,6 +163,8 @@ class FunctionLibraryRuntimeOverlay : public FunctionLibraryRuntime {
 
   Status GetRetTypes(Handle h, DataTypeVector* ret_types) override;
 
+  bool IsSingleComponentOnDevice(Handle handle) override;
+
   void Run(const Options& opts, Handle handle, gtl::ArraySlice<Tensor> args,
            std::vector<Tensor>* rets, DoneCallback done) override;
 
@@ -232,6 +234,10 @@ Status FunctionLibraryRuntimeOverlay::GetRetTypes(Handle h,
   return base_flr_->GetRetTypes(h, ret_types);
 }
 
+bool FunctionLibraryRuntimeOverlay::IsSingleComponentOnDevice(Handle handle) {
+  return base_flr_->IsSingleComponentOnDevice(handle);
+}
+
 void FunctionLibraryRuntimeOverlay::Run(const Options& opts, Handle handle,
                                         gtl::ArraySlice<Tensor> args,
                                         std::vector<Tensor>* rets,
@@ -344,6 +350,8 @@ class FunctionLibraryRuntimeImpl : public FunctionLibraryRuntime {
 
   Status GetRetTypes(Handle handle, DataTypeVector* ret_types) override;
 
+  bool IsSingleComponentOnDevice(Handle handle) override;
+
   Status CreateKernel(const std::shared_ptr<const NodeProperties>& props,
                       OpKernel** kernel) override;
 
@@ -535,6 +543,7 @@ class CallOp : public AsyncOpKernel {
     opts.cancellation_manager = ctx->cancellation_manager();
     opts.step_container = ctx->step_container();
     opts.stats_collector = ctx->stats_collector();
+    opts.request_cost = ctx->request_cost();
     opts.runner = ctx->runner();
     opts.run_all_kernels_inline = ctx->run_all_kernels_inline();
     opts.collective_executor = ctx->collective_executor();
@@ -600,6 +609,12 @@ Status FunctionLibraryRuntimeImpl::GetRetTypes(Handle h,
   return Status::OK();
 }
 
+bool FunctionLibraryRuntimeImpl::IsSingleComponentOnDevice(Handle handle) {
+  return parent_->GetHandleOnDevice(device_name_, handle,
+                                    /*include_multi_device=*/true) !=
+         kInvalidLocalHandle;
+}
+
 Status FunctionLibraryRuntimeImpl::CreateKernel(
     const std::shared_ptr<const NodeProperties>& props, OpKernel** kernel) {
   return CreateKernel(props, this, kernel);
@@ -1074,6 +1089,7 @@ void FunctionLibraryRuntimeImpl::ExecutorArgsFromOptions(
   exec_args->step_id = run_opts.step_id;
   exec_args->rendezvous = run_opts.rendezvous;
   exec_args->stats_collector = run_opts.stats_collector;
+  exec_args->request_cost = run_opts.request_cost;
   exec_args->cancellation_manager = run_opts.cancellation_manager;
   exec_args->step_container = run_opts.step_container;
   if (run_opts.runner) {
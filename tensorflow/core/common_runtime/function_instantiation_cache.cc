@@ -0,0 +1,198 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/function_instantiation_cache.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/framework/device.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/function_instantiation_cache.pb.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+namespace {
+
+constexpr char kSendDeviceAttr[] = "send_device";
+constexpr char kSendDeviceIncarnationAttr[] = "send_device_incarnation";
+
+std::string CachePath(const std::string& cache_dir, const std::string& key) {
+  return io::JoinPath(
+      cache_dir, strings::StrCat(strings::FpToString(Fingerprint64(key)),
+                                 ".pb"));
+}
+
+// Updates the send device incarnations of the send/recv nodes in `graph_def`,
+// which are specific to the process that partitioned the graph.
+Status UpdateIncarnations(const DeviceSet& device_set, GraphDef* graph_def) {
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    auto* attrs = node.mutable_attr();
+    auto incarnation_it = attrs->find(kSendDeviceIncarnationAttr);
+    auto device_it = attrs->find(kSendDeviceAttr);
+    if (incarnation_it == attrs->end() || device_it == attrs->end()) continue;
+    const Device* device = device_set.FindDeviceByName(device_it->second.s());
+    if (device == nullptr) {
+      return errors::NotFound("Cached function refers to unknown device ",
+                              device_it->second.s());
+    }
+    incarnation_it->second.set_i(
+        static_cast<int64_t>(device->attributes().incarnation()));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+const std::string& FunctionInstantiationCacheDir() {
+  static const std::string* cache_dir = [] {
+    auto* dir = new std::string;
+    Status s = ReadStringFromEnvVar("TF_PFLR_INSTANTIATION_CACHE_DIR",
+                                    /*default_val=*/"", dir);
+    if (!s.ok()) {
+      LOG(WARNING) << "Disabling the function instantiation cache: " << s;
+      dir->clear();
+    }
+    return dir;
+  }();
+  return *cache_dir;
+}
+
+std::string FunctionInstantiationCacheKey(const std::string& function_key,
+                                          const GraphDef& graph_def,
+                                          const DeviceSet& device_set) {
+  std::vector<std::string> devices;
+  devices.reserve(device_set.devices().size());
+  for (const Device* device : device_set.devices()) {
+    devices.push_back(
+        strings::StrCat(device->name(), "=", device->device_type()));
+  }
+  std::sort(devices.begin(), devices.end());
+
+  std::string serialized_graph_def;
+  SerializeToStringDeterministic(graph_def, &serialized_graph_def);
+  return strings::StrCat(
+      TF_VERSION_STRING, "\n", function_key, "\n", absl::StrJoin(devices, ","),
+      "\n", strings::FpToString(Fingerprint64(serialized_graph_def)));
+}
+
+Status LookupFunctionInstantiation(
+    Env* env, const std::string& cache_dir, const std::string& key,
+    const DeviceSet& device_set, FunctionLibraryDefinition* lib_def,
+    std::unordered_map<std::string, std::unique_ptr<Graph>>* subgraphs,
+    std::unordered_map<std::string, std::string>* node_name_to_control_ret) {
+  const std::string path = CachePath(cache_dir, key);
+  if (!env->FileExists(path).ok()) {
+    return errors::NotFound("No cached instantiation in ", path);
+  }
+  CachedMultiDeviceFunction cached;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env, path, &cached));
+  if (cached.key() != key) {
+    return errors::NotFound("Cached instantiation in ", path,
+                            " has a different key");
+  }
+  for (auto& it : *cached.mutable_component_graphs()) {
+    if (device_set.FindDeviceByName(it.first) == nullptr) {
+      return errors::NotFound("Cached function refers to unknown device ",
+                              it.first);
+    }
+    TF_RETURN_IF_ERROR(UpdateIncarnations(device_set, &it.second));
+  }
+
+  // The component graphs carry the functions they call, like the ones
+  // returned by PartitionFunctionGraph().
+  std::unordered_map<std::string, std::unique_ptr<Graph>> cached_subgraphs;
+  for (auto& it : *cached.mutable_component_graphs()) {
+    auto subgraph = absl::make_unique<Graph>(lib_def->default_registry());
+    GraphConstructorOptions opts;
+    opts.allow_internal_ops = true;
+    opts.expect_device_spec = true;
+    TF_RETURN_IF_ERROR(
+        ConvertGraphDefToGraph(opts, std::move(it.second), subgraph.get()));
+    cached_subgraphs.emplace(it.first, std::move(subgraph));
+  }
+
+  // The optimization passes may have rewritten functions in the library, so
+  // the cached definitions replace the existing ones. They are added to a
+  // copy of `lib_def`, which is only updated once they all were.
+  FunctionLibraryDefinition cached_lib_def(*lib_def);
+  for (const FunctionDef& fdef : cached.library().function()) {
+    const std::string& name = fdef.signature().name();
+    if (cached_lib_def.Contains(name)) {
+      TF_RETURN_IF_ERROR(cached_lib_def.ReplaceFunction(name, fdef));
+    } else {
+      TF_RETURN_IF_ERROR(cached_lib_def.AddFunctionDef(fdef));
+    }
+  }
+  for (const GradientDef& grad : cached.library().gradient()) {
+    TF_RETURN_IF_ERROR(cached_lib_def.AddGradientDef(grad));
+  }
+
+  lib_def->Clear();
+  TF_RETURN_IF_ERROR(lib_def->AddLibrary(cached_lib_def));
+  for (auto& it : cached_subgraphs) {
+    subgraphs->emplace(it.first, std::move(it.second));
+  }
+  for (const auto& it : cached.node_name_to_control_ret()) {
+    node_name_to_control_ret->emplace(it.first, it.second);
+  }
+  VLOG(1) << "Loaded cached function instantiation from " << path;
+  return Status::OK();
+}
+
+Status InsertFunctionInstantiation(
+    Env* env, const std::string& cache_dir, const std::string& key,
+    const FunctionLibraryDefinition& lib_def,
+    const std::unordered_map<std::string, std::unique_ptr<Graph>>& subgraphs,
+    const std::unordered_map<std::string, std::string>&
+        node_name_to_control_ret) {
+  CachedMultiDeviceFunction cached;
+  cached.set_key(key);
+  *cached.mutable_library() = lib_def.ToProto();
+  for (const auto& it : subgraphs) {
+    it.second->ToGraphDef(&(*cached.mutable_component_graphs())[it.first]);
+  }
+  for (const auto& it : node_name_to_control_ret) {
+    (*cached.mutable_node_name_to_control_ret())[it.first] = it.second;
+  }
+
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(cache_dir));
+  const std::string path = CachePath(cache_dir, key);
+  const std::string tmp_path =
+      strings::StrCat(path, ".tmp.", strings::FpToString(random::New64()));
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env, tmp_path, cached));
+  Status s = env->RenameFile(tmp_path, path);
+  if (!s.ok()) {
+    env->DeleteFile(tmp_path).IgnoreError();
+    return s;
+  }
+  VLOG(1) << "Stored function instantiation in " << path;
+  return Status::OK();
+}
+
+}  // namespace tensorflow
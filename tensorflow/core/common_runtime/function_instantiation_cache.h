@@ -0,0 +1,78 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_FUNCTION_INSTANTIATION_CACHE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_FUNCTION_INSTANTIATION_CACHE_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "tensorflow/core/common_runtime/device_set.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+
+// An on-disk cache of the placed, optimized and partitioned graphs of
+// multi-device functions, which allows a process to skip the placement,
+// optimization and partitioning steps when instantiating a function that a
+// previous process instantiated with the same definition, attributes and
+// options on the same set of devices.
+//
+// The cache is disabled unless the TF_PFLR_INSTANTIATION_CACHE_DIR
+// environment variable names a directory. Entries are never evicted: the
+// directory should be cleared when the set of registered optimization passes
+// changes without a change of the TensorFlow version.
+
+// Returns the directory of the cache, or an empty string if it is disabled.
+const std::string& FunctionInstantiationCacheDir();
+
+// Returns the key under which the instantiation of a function is cached.
+// `function_key` is the canonicalized name, attributes and options of the
+// function, and `graph_def` is its body, including the reachable function
+// library.
+std::string FunctionInstantiationCacheKey(const std::string& function_key,
+                                          const GraphDef& graph_def,
+                                          const DeviceSet& device_set);
+
+// Looks up the instantiation cached under `key` in `cache_dir`. On success,
+// adds the cached function library to `lib_def` and stores the component
+// graphs, keyed by device name, in `*subgraphs`. The incarnations of the
+// devices in the send/recv nodes of the component graphs are updated to those
+// in `device_set`. Returns a NotFound error on a cache miss. On error,
+// `lib_def`, `*subgraphs` and `*node_name_to_control_ret` are left unchanged.
+Status LookupFunctionInstantiation(
+    Env* env, const std::string& cache_dir, const std::string& key,
+    const DeviceSet& device_set, FunctionLibraryDefinition* lib_def,
+    std::unordered_map<std::string, std::unique_ptr<Graph>>* subgraphs,
+    std::unordered_map<std::string, std::string>* node_name_to_control_ret);
+
+// Stores an instantiation under `key` in `cache_dir`. The entry is written to
+// a temporary file that is then renamed, so that concurrent readers (possibly
+// in other processes) never observe a partially written entry.
+Status InsertFunctionInstantiation(
+    Env* env, const std::string& cache_dir, const std::string& key,
+    const FunctionLibraryDefinition& lib_def,
+    const std::unordered_map<std::string, std::unique_ptr<Graph>>& subgraphs,
+    const std::unordered_map<std::string, std::string>&
+        node_name_to_control_ret);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_FUNCTION_INSTANTIATION_CACHE_H_
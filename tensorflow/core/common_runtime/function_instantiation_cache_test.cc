@@ -0,0 +1,197 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/function_instantiation_cache.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/function_ops.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/partitioning_utils.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kJobPrefix[] = "/job:a/replica:0/task:0";
+
+std::unique_ptr<DeviceMgr> NewDeviceMgr() {
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_CHECK_OK(DeviceFactory::AddDevices(options, kJobPrefix, &devices));
+  return absl::make_unique<StaticDeviceMgr>(std::move(devices));
+}
+
+std::unique_ptr<DeviceSet> NewDeviceSet(const DeviceMgr& device_mgr) {
+  auto device_set = absl::make_unique<DeviceSet>();
+  for (Device* d : device_mgr.ListDevices()) device_set->AddDevice(d);
+  return device_set;
+}
+
+class FunctionInstantiationCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    cache_dir_ = io::JoinPath(testing::TmpDir(), "instantiation_cache",
+                              strings::FpToString(random::New64()));
+    device_mgr_ = NewDeviceMgr();
+    device_set_ = NewDeviceSet(*device_mgr_);
+  }
+
+  // Partitions a graph that forwards its argument on CPU:0 through an
+  // identity on CPU:1, so that both subgraphs contain send/recv nodes.
+  void Partition(
+      std::unordered_map<string, std::unique_ptr<Graph>>* subgraphs) {
+    Scope s = Scope::NewRootScope();
+    Scope s0 = s.WithDevice(strings::StrCat(kJobPrefix, "/device:CPU:0"));
+    Scope s1 = s.WithDevice(strings::StrCat(kJobPrefix, "/device:CPU:1"));
+    auto x = ops::_Arg(s0.WithOpName("x"), DT_FLOAT, 0);
+    auto id_x = ops::Identity(s1.WithOpName("id_x"), x);
+    auto retval = ops::_Retval(s0.WithOpName("retval"), id_x, 0);
+    auto graph = absl::make_unique<Graph>(OpRegistry::Global());
+    TF_ASSERT_OK(s.ToGraph(graph.get()));
+    for (Node* n : graph->op_nodes()) {
+      n->set_assigned_device_name(n->requested_device());
+    }
+    TF_ASSERT_OK(
+        PartitionFunctionGraph(*device_set_, std::move(graph), subgraphs));
+  }
+
+  string cache_dir_;
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  std::unique_ptr<DeviceSet> device_set_;
+};
+
+TEST_F(FunctionInstantiationCacheTest, KeyDependsOnDevicesAndGraph) {
+  GraphDef graph_def;
+  const string key =
+      FunctionInstantiationCacheKey("f", graph_def, *device_set_);
+  EXPECT_EQ(key, FunctionInstantiationCacheKey("f", graph_def, *device_set_));
+  EXPECT_NE(key, FunctionInstantiationCacheKey("g", graph_def, *device_set_));
+
+  DeviceSet one_device;
+  one_device.AddDevice(device_mgr_->ListDevices()[0]);
+  EXPECT_NE(key, FunctionInstantiationCacheKey("f", graph_def, one_device));
+
+  graph_def.add_node()->set_name("n");
+  EXPECT_NE(key, FunctionInstantiationCacheKey("f", graph_def, *device_set_));
+}
+
+TEST_F(FunctionInstantiationCacheTest, MissIsNotFound) {
+  FunctionLibraryDefinition lib_def(OpRegistry::Global(), {});
+  std::unordered_map<string, std::unique_ptr<Graph>> subgraphs;
+  std::unordered_map<string, string> node_name_to_control_ret;
+  Status s = LookupFunctionInstantiation(
+      Env::Default(), cache_dir_, "missing", *device_set_, &lib_def,
+      &subgraphs, &node_name_to_control_ret);
+  EXPECT_TRUE(errors::IsNotFound(s)) << s;
+  EXPECT_TRUE(subgraphs.empty());
+}
+
+TEST_F(FunctionInstantiationCacheTest, RoundTripUpdatesIncarnations) {
+  std::unordered_map<string, std::unique_ptr<Graph>> subgraphs;
+  Partition(&subgraphs);
+  ASSERT_EQ(subgraphs.size(), 2);
+
+  FunctionDefLibrary proto;
+  *proto.add_function() = test::function::XTimesTwo();
+  FunctionLibraryDefinition lib_def(OpRegistry::Global(), proto);
+  TF_ASSERT_OK(InsertFunctionInstantiation(Env::Default(), cache_dir_, "key",
+                                           lib_def, subgraphs,
+                                           {{"node", "control_ret"}}));
+
+  // A new process has new device incarnations.
+  std::unique_ptr<DeviceMgr> new_device_mgr = NewDeviceMgr();
+  std::unique_ptr<DeviceSet> new_device_set = NewDeviceSet(*new_device_mgr);
+  FunctionLibraryDefinition new_lib_def(OpRegistry::Global(), {});
+  std::unordered_map<string, std::unique_ptr<Graph>> new_subgraphs;
+  std::unordered_map<string, string> node_name_to_control_ret;
+  TF_ASSERT_OK(LookupFunctionInstantiation(
+      Env::Default(), cache_dir_, "key", *new_device_set, &new_lib_def,
+      &new_subgraphs, &node_name_to_control_ret));
+
+  EXPECT_NE(new_lib_def.Find("XTimesTwo"), nullptr);
+  EXPECT_EQ(node_name_to_control_ret.at("node"), "control_ret");
+  ASSERT_EQ(new_subgraphs.size(), 2);
+  int num_send_recv = 0;
+  for (const auto& it : new_subgraphs) {
+    EXPECT_EQ(it.second->num_op_nodes(),
+              subgraphs.at(it.first)->num_op_nodes());
+    for (Node* n : it.second->op_nodes()) {
+      if (!n->IsSend() && !n->IsRecv()) continue;
+      ++num_send_recv;
+      string send_device;
+      int64_t incarnation;
+      TF_ASSERT_OK(GetNodeAttr(n->attrs(), "send_device", &send_device));
+      TF_ASSERT_OK(
+          GetNodeAttr(n->attrs(), "send_device_incarnation", &incarnation));
+      const Device* device = new_device_set->FindDeviceByName(send_device);
+      ASSERT_NE(device, nullptr);
+      EXPECT_EQ(incarnation,
+                static_cast<int64_t>(device->attributes().incarnation()));
+    }
+  }
+  EXPECT_GT(num_send_recv, 0);
+}
+
+TEST_F(FunctionInstantiationCacheTest, FailedLookupKeepsLibrary) {
+  std::unordered_map<string, std::unique_ptr<Graph>> subgraphs;
+  Partition(&subgraphs);
+  FunctionDefLibrary proto;
+  *proto.add_function() = test::function::XTimesTwo();
+  GradientDef* grad = proto.add_gradient();
+  grad->set_function_name("XTimesTwo");
+  grad->set_gradient_func("XTimesFour");
+  FunctionLibraryDefinition lib_def(OpRegistry::Global(), proto);
+  TF_ASSERT_OK(InsertFunctionInstantiation(Env::Default(), cache_dir_, "key",
+                                           lib_def, subgraphs,
+                                           {{"node", "control_ret"}}));
+
+  // The library of the new process has another gradient for XTimesTwo, which
+  // the cached one conflicts with once XTimesTwo was added.
+  FunctionDefLibrary new_proto;
+  *new_proto.add_function() = test::function::XTimesFour();
+  GradientDef* new_grad = new_proto.add_gradient();
+  new_grad->set_function_name("XTimesTwo");
+  new_grad->set_gradient_func("XTimes16");
+  FunctionLibraryDefinition new_lib_def(OpRegistry::Global(), new_proto);
+  std::unordered_map<string, std::unique_ptr<Graph>> new_subgraphs;
+  std::unordered_map<string, string> node_name_to_control_ret;
+  Status s = LookupFunctionInstantiation(
+      Env::Default(), cache_dir_, "key", *device_set_, &new_lib_def,
+      &new_subgraphs, &node_name_to_control_ret);
+  EXPECT_FALSE(s.ok());
+  EXPECT_FALSE(errors::IsNotFound(s)) << s;
+
+  EXPECT_EQ(new_lib_def.Find("XTimesTwo"), nullptr);
+  EXPECT_NE(new_lib_def.Find("XTimesFour"), nullptr);
+  EXPECT_EQ(new_lib_def.FindGradient("XTimesTwo"), "XTimes16");
+  EXPECT_TRUE(new_subgraphs.empty());
+  EXPECT_TRUE(node_name_to_control_ret.empty());
+}
+
+}  // namespace
+}  // namespace tensorflow
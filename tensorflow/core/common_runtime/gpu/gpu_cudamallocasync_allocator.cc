@@ -13,6 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "absl/types/optional.h"
 #ifdef GOOGLE_CUDA
 #include "third_party/gpus/cuda/include/cuda.h"
@@ -41,6 +45,19 @@ static std::string GetCudaErrorMessage(CUresult result) {
 }
 #endif  // GOOGLE_CUDA
 
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED
+// The pools of the live allocators, and their GPUs, to which new pools get
+// access.
+static std::vector<CUmemoryPool*>* AllPools() {
+  static auto* all_pools = new std::vector<CUmemoryPool*>();
+  return all_pools;
+}
+static std::vector<PlatformDeviceId>* AllIds() {
+  static auto* all_ids = new std::vector<PlatformDeviceId>();
+  return all_ids;
+}
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+
 void GpuCudaMallocAsyncAllocator::PrintAllocatorStatistics() {
   mutex_lock lock(lock_);
 
@@ -115,6 +132,7 @@ GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
   // Initialized here as it only exist if compiled with a recent
   // enough CUDA.
   pool_ = nullptr;
+  owns_pool_ = false;
   cuda_stream_ = nullptr;
   int driverVersion;
   cuDriverGetVersion(&driverVersion);
@@ -164,17 +182,37 @@ GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
            "old, "
         << " OS not supported, CUDA version too old(request CUDA11.2+).";
 
-  if (auto status =
-          cuDeviceGetDefaultMemPool(&pool_, platform_device_id.value()))
-    LOG(FATAL) <<  // Crash OK.
-        "Failed to get default CUDA pool: " << GetCudaErrorMessage(status);
+  bool per_stream_pool = false;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_CUDA_MALLOC_ASYNC_PER_STREAM_POOL",
+                                 /*default_val=*/false, &per_stream_pool));
+  if (per_stream_pool) {
+    CUmemPoolProps props;
+    memset(&props, 0, sizeof(props));
+    props.allocType = CU_MEM_ALLOCATION_TYPE_PINNED;
+    props.handleTypes = CU_MEM_HANDLE_TYPE_NONE;
+    props.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+    props.location.id = platform_device_id.value();
+    if (auto status = cuMemPoolCreate(&pool_, &props))
+      LOG(FATAL) <<  // Crash OK.
+          "Failed to create CUDA pool: " << GetCudaErrorMessage(status);
+    owns_pool_ = true;
+  } else {
+    if (auto status =
+            cuDeviceGetDefaultMemPool(&pool_, platform_device_id.value()))
+      LOG(FATAL) <<  // Crash OK.
+          "Failed to get default CUDA pool: " << GetCudaErrorMessage(status);
+  }
 
+  int64_t release_threshold = pool_size;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_CUDA_MALLOC_ASYNC_RELEASE_THRESHOLD",
+                                  release_threshold, &release_threshold));
   VLOG(1) << Name() << " CudaMallocAsync initialized on platform: "
           << platform_device_id.value() << " with pool size of: " << pool_size
-          << " this ptr: " << this;
-  uint64_t pool_size_64 = pool_size;
+          << ", release threshold of: " << release_threshold
+          << (owns_pool_ ? ", in its own pool" : "") << " this ptr: " << this;
+  uint64_t release_threshold_64 = release_threshold;
   if (auto status = cuMemPoolSetAttribute(
-          pool_, CU_MEMPOOL_ATTR_RELEASE_THRESHOLD, &pool_size_64))
+          pool_, CU_MEMPOOL_ATTR_RELEASE_THRESHOLD, &release_threshold_64))
     LOG(FATAL) <<  // Crash OK.
         "Failed to set CUDA pool attribute: " << GetCudaErrorMessage(status);
 
@@ -189,7 +227,16 @@ GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
   TF_CHECK_OK(tensorflow::ReadBoolFromEnvVar("TF_DETERMINISTIC_ALLOCATOR",
                                              /*default_val=*/false,
                                              &deterministic));
-  if (deterministic) {
+  if (!deterministic) {
+    // Lets another stream reuse the memory freed on the stream of this
+    // allocator as soon as it waits on an event recorded after the free.
+    int enable = 1;
+    if (auto status = cuMemPoolSetAttribute(
+            pool_, CU_MEMPOOL_ATTR_REUSE_FOLLOW_EVENT_DEPENDENCIES, &enable)) {
+      LOG(FATAL) <<  // Crash OK.
+          "Failed to set CUDA pool attribute: " << GetCudaErrorMessage(status);
+    }
+  } else {
     int disable = 0;
     if (auto status = cuMemPoolSetAttribute(
             pool_, CU_MEMPOOL_ATTR_REUSE_ALLOW_OPPORTUNISTIC, &disable)) {
@@ -205,8 +252,8 @@ GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
   }
 
   // Set read/write access to all GPUs.
-  static auto* all_pools_ = new std::vector<CUmemoryPool*>();
-  static auto* all_ids_ = new std::vector<PlatformDeviceId>();
+  auto* all_pools_ = AllPools();
+  auto* all_ids_ = AllIds();
   DCHECK(all_pools_->size() == all_ids_->size());
   for (int i = 0; i < all_pools_->size(); ++i) {
     // Set the current pool access to the previous GPUs.
@@ -266,7 +313,23 @@ GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
 #endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
 }
 
-GpuCudaMallocAsyncAllocator::~GpuCudaMallocAsyncAllocator() {}
+GpuCudaMallocAsyncAllocator::~GpuCudaMallocAsyncAllocator() {
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  auto* all_pools = AllPools();
+  auto it = std::find(all_pools->begin(), all_pools->end(), &pool_);
+  if (it != all_pools->end()) {
+    AllIds()->erase(AllIds()->begin() + (it - all_pools->begin()));
+    all_pools->erase(it);
+  }
+  if (owns_pool_ && pool_ != nullptr) {
+    se::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+    if (auto result = cuMemPoolDestroy(pool_)) {
+      VLOG(1) << "Failed to destroy CUDA pool: "
+              << GetCudaErrorMessage(result);
+    }
+  }
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
 
 void* GpuCudaMallocAsyncAllocator::AllocateRaw(size_t alignment,
                                                size_t num_bytes) {
@@ -371,8 +434,25 @@ size_t GpuCudaMallocAsyncAllocator::AllocatedSize(const void* ptr) const {
 
 absl::optional<AllocatorStats> GpuCudaMallocAsyncAllocator::GetStats() {
   if (!stats_) return absl::nullopt;
-  mutex_lock l(lock_);
-  return *stats_;
+  AllocatorStats stats;
+  {
+    mutex_lock l(lock_);
+    stats = *stats_;
+  }
+#if CUDA_VERSION >= 11030
+  // When the pool is shared, these are the bytes of all its allocators.
+  cuuint64_t mem_reserved_current = 0;
+  cuuint64_t mem_reserved_high = 0;
+  if (pool_ != nullptr &&
+      cuMemPoolGetAttribute(pool_, CU_MEMPOOL_ATTR_RESERVED_MEM_CURRENT,
+                            &mem_reserved_current) == CUDA_SUCCESS &&
+      cuMemPoolGetAttribute(pool_, CU_MEMPOOL_ATTR_RESERVED_MEM_HIGH,
+                            &mem_reserved_high) == CUDA_SUCCESS) {
+    stats.bytes_reserved = mem_reserved_current;
+    stats.peak_bytes_reserved = mem_reserved_high;
+  }
+#endif
+  return stats;
 }
 
 bool GpuCudaMallocAsyncAllocator::ClearStats() {
@@ -381,6 +461,14 @@ bool GpuCudaMallocAsyncAllocator::ClearStats() {
   stats_->num_allocs = 0;
   stats_->peak_bytes_in_use = stats_->bytes_in_use;
   stats_->largest_alloc_size = 0;
+#if CUDA_VERSION >= 11030
+  // Resets the high watermarks of the pool to its current usage.
+  if (owns_pool_) {
+    cuuint64_t zero = 0;
+    cuMemPoolSetAttribute(pool_, CU_MEMPOOL_ATTR_RESERVED_MEM_HIGH, &zero);
+    cuMemPoolSetAttribute(pool_, CU_MEMPOOL_ATTR_USED_MEM_HIGH, &zero);
+  }
+#endif
   return true;
 }
 
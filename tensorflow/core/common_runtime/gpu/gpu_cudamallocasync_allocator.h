@@ -62,6 +62,17 @@ namespace tensorflow {
 // Here, the pool_size isn't the absolute max as for [Gpu]BFCAllocator.
 // The pool can grow above that up to the total GPU memory.  But the
 // driver can return the excess memory to other processes.
+//
+// By default, all the allocators of a GPU share its default pool, whose
+// release threshold is then the pool_size of the last one created. With
+// `TF_CUDA_MALLOC_ASYNC_PER_STREAM_POOL=true`, each allocator, and thus
+// each stream it allocates on, gets its own pool instead, so that the
+// virtual devices of a GPU don't serialize on each other's frees and keep
+// their own memory. `TF_CUDA_MALLOC_ASYNC_RELEASE_THRESHOLD=nb_bytes`
+// overrides the release threshold, which defaults to pool_size. Memory
+// freed on one stream is reused by another one once the latter waits on an
+// event recorded after the free. The reserved bytes of the pool are
+// reported in the stats with CUDA 11.3+.
 class GpuCudaMallocAsyncAllocator : public Allocator {
  public:
   explicit GpuCudaMallocAsyncAllocator(PlatformDeviceId platform_device_id,
@@ -104,10 +115,12 @@ class GpuCudaMallocAsyncAllocator : public Allocator {
   // Not owned.
   CUstream cuda_stream_;
 
-  // Not owned. The default pool of the associated GPU.
+  // The default pool of the associated GPU, or the pool of this allocator
+  // if owns_pool_ is true.
   // If null, then the instanciation failed and the first allocation
   // will return an error.
   CUmemoryPool pool_;
+  bool owns_pool_;
 #endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
 
   // Just a counter for the number of time this class is instantiated.
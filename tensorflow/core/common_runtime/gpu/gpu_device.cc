@@ -28,12 +28,16 @@ limitations under the License.
 #include <string.h>
 
 #include <algorithm>
+#include <atomic>
 #include <list>
 #include <map>
+#include <memory>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_split.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
@@ -44,6 +48,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_id_manager.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/common_runtime/local_device.h"
@@ -380,6 +385,72 @@ class BaseGPUDevice::StreamGroupFactory {
   TF_DISALLOW_COPY_AND_ASSIGN(StreamGroupFactory);
 };
 
+namespace {
+
+// Defers the deallocations of a GPU allocator until all the compute streams
+// of a device have passed them. Otherwise a buffer freed once the ops using it
+// are enqueued on one stream could be reused by an op on another stream
+// before those ops ran.
+class MultiStreamAllocator : public Allocator {
+ public:
+  MultiStreamAllocator(Allocator* allocator, EventMgr* em,
+                       std::vector<se::Stream*> streams)
+      : allocator_(allocator), em_(em), streams_(std::move(streams)) {}
+
+  std::string Name() override { return allocator_->Name(); }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return allocator_->AllocateRaw(alignment, num_bytes);
+  }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override {
+    return allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    if (ptr == nullptr) return;
+    // The callbacks don't refer to `this`, which the device may destroy
+    // before they run.
+    Allocator* allocator = allocator_;
+    auto num_pending = std::make_shared<std::atomic<int>>(streams_.size());
+    for (se::Stream* stream : streams_) {
+      em_->ThenExecute(stream, [allocator, ptr, num_pending]() {
+        if (num_pending->fetch_sub(1) == 1) allocator->DeallocateRaw(ptr);
+      });
+    }
+  }
+
+  bool TracksAllocationSizes() const override {
+    return allocator_->TracksAllocationSizes();
+  }
+
+  size_t RequestedSize(const void* ptr) const override {
+    return allocator_->RequestedSize(ptr);
+  }
+
+  size_t AllocatedSize(const void* ptr) const override {
+    return allocator_->AllocatedSize(ptr);
+  }
+
+  int64_t AllocationId(const void* ptr) const override {
+    return allocator_->AllocationId(ptr);
+  }
+
+  absl::optional<AllocatorStats> GetStats() override {
+    return allocator_->GetStats();
+  }
+
+  bool ClearStats() override { return allocator_->ClearStats(); }
+
+ private:
+  Allocator* const allocator_;  // not owned
+  EventMgr* const em_;          // not owned
+  const std::vector<se::Stream*> streams_;
+};
+
+}  // namespace
+
 BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
                              Bytes memory_limit, const DeviceLocality& locality,
                              TfDeviceId tf_device_id,
@@ -402,14 +473,17 @@ BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
 
 BaseGPUDevice::~BaseGPUDevice() {
   delete gpu_device_info_;
-  if (scratch_) gpu_allocator_->DeallocateRaw(scratch_);
+  for (char* scratch : scratch_) gpu_allocator_->DeallocateRaw(scratch);
   device_context_->Unref();
+  for (auto& key_and_context : device_contexts_) {
+    key_and_context.second->Unref();
+  }
 }
 
 // This should be idempotent if already initialized.
 Status BaseGPUDevice::InitScratchBuffers() {
   mutex_lock l(scratch_init_mutex_);
-  if (!scratch_) {
+  while (scratch_.size() < num_compute_streams_) {
     DCHECK(stream_);
     size_t scratch_buffer_size = Eigen::kGpuScratchSize + sizeof(unsigned int);
     profiler::ScopedMemoryDebugAnnotation op_annotation("ScratchBuffer");
@@ -424,7 +498,7 @@ Status BaseGPUDevice::InitScratchBuffers() {
         se::DeviceMemoryBase(scratch_buffer, scratch_buffer_size));
     TF_RETURN_IF_ERROR(executor_->SynchronousMemZero(
         &mem, Eigen::kGpuScratchSize + sizeof(unsigned int)));
-    scratch_ = static_cast<char*>(scratch_buffer);
+    scratch_.push_back(static_cast<char*>(scratch_buffer));
   }
   return Status::OK();
 }
@@ -439,8 +513,20 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
 
   executor_ = executor_status.ValueOrDie();
 
+  num_compute_streams_ = std::max(
+      options.config.gpu_options().experimental().num_compute_streams(), 1);
+  if (num_compute_streams_ > gpu_stream_util::kMaxComputeStreams) {
+    return errors::InvalidArgument(
+        "num_compute_streams must be at most ",
+        gpu_stream_util::kMaxComputeStreams, ", got ", num_compute_streams_);
+  }
   stream_ = StreamGroupFactory::Global().GetOrCreate(
       tf_device_id_, 0, executor_, options.config.gpu_options());
+  compute_streams_.push_back(stream_);
+  for (int i = 1; i < num_compute_streams_; ++i) {
+    compute_streams_.push_back(StreamGroupFactory::Global().GetOrCreate(
+        tf_device_id_, i, executor_, options.config.gpu_options()));
+  }
   device_context_ =
       new GPUDeviceContext(0, stream_->compute,
 #if TENSORFLOW_USE_ROCM
@@ -451,6 +537,15 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
 
   em_ = EventMgrFactory::Singleton()->GetEventMgr(executor_,
                                                   options.config.gpu_options());
+  if (num_compute_streams_ > 1) {
+    std::vector<se::Stream*> streams;
+    for (const StreamGroup* group : compute_streams_) {
+      streams.push_back(group->compute);
+    }
+    multi_stream_allocator_ = absl::make_unique<MultiStreamAllocator>(
+        gpu_allocator_, em_, std::move(streams));
+    gpu_allocator_ = multi_stream_allocator_.get();
+  }
 
   GPUKernelTracker::Params tracker_params(
       options.config.gpu_options().experimental().kernel_tracker_max_interval(),
@@ -462,6 +557,12 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
   if (timestamped_allocator_ ||
       (tracker_params.max_interval > 0 || tracker_params.max_bytes > 0 ||
        tracker_params.max_pending > 0)) {
+    if (num_compute_streams_ > 1) {
+      // The tracker only follows the kernels of the first stream.
+      return errors::InvalidArgument(
+          "num_compute_streams > 1 is not supported with timestamped_allocator "
+          "or kernel tracking");
+    }
     SharedCounter* timing_counter = nullptr;
     if (timestamped_allocator_) {
       // In this case the SharedCounter was already created and set in the
@@ -646,6 +747,9 @@ void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
   }
   se::Stream* stream = gpu_device_context->stream();
   const auto stream_id = gpu_device_context->stream_id();
+  for (se::Stream* wait_stream : gpu_device_context->wait_streams()) {
+    stream->ThenWaitFor(wait_stream);
+  }
 
   const bool vlog_1 = VLOG_IS_ON(1);
 
@@ -724,7 +828,13 @@ Status BaseGPUDevice::Sync() {
   // enqueued the operation has completed.  We do use other streams for copies
   // and collectives, but in those cases the (Async)OpKernels themselves block
   // until the queued operation has finished.
-  return stream_->compute->BlockHostUntilDone();
+  for (const StreamGroup* group : compute_streams_) {
+    TF_RETURN_IF_ERROR(group->compute->BlockHostUntilDone());
+  }
+  // No queued work may still access the memory freed to the allocator, so it
+  // may be released, e.g. between steps with sync_on_finish.
+  GPUProcessState::singleton()->DefragmentGPUAllocator(tf_device_id_);
+  return Status::OK();
 }
 
 void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
@@ -737,6 +847,9 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
   }
   se::Stream* stream = gpu_device_context->stream();
   const auto stream_id = gpu_device_context->stream_id();
+  for (se::Stream* wait_stream : gpu_device_context->wait_streams()) {
+    stream->ThenWaitFor(wait_stream);
+  }
 
   VLOG(1) << "GpuDevice::ComputeAsync " << op_kernel->name() << " op "
           << op_kernel->type_string() << " on GPU" << tf_device_id_
@@ -1112,11 +1225,12 @@ void BaseGPUDevice::ReinitializeDevice(OpKernelContext* context,
   ConcretePerOpGpuDevice* concrete_device =
       static_cast<ConcretePerOpGpuDevice*>(device);
   DCHECK(concrete_device);
-  DCHECK_EQ(stream_id, 0);
+  DCHECK_LT(stream_id, compute_streams_.size());
   const gpuStream_t* gpu_stream = reinterpret_cast<const gpuStream_t*>(
-      stream_->compute->implementation()->GpuStreamMemberHack());
+      compute_streams_[stream_id]->compute->implementation()
+          ->GpuStreamMemberHack());
   concrete_device->Reinitialize(context, gpu_stream, tf_device_id_, allocator,
-                                scratch_);
+                                scratch_[stream_id]);
 }
 
 PerOpGpuDevice* BaseGPUDevice::MakeGpuDevice() {
@@ -1133,7 +1247,6 @@ Status BaseGPUDevice::ReinitializeGpuDevice(OpKernelContext* context,
     const int stream_id = gpu_dc->stream_id();
     VLOG(1) << "  eigen_gpu_device(" << dc << ") => stream[" << stream_id
             << "]";
-    CHECK_EQ(stream_id, 0);
     ReinitializeDevice(context, device, stream_id, allocator);
   } else {
     ReinitializeDevice(context, device, 0, allocator);
@@ -1141,6 +1254,45 @@ Status BaseGPUDevice::ReinitializeGpuDevice(OpKernelContext* context,
   return Status::OK();
 }
 
+GPUDeviceContext* BaseGPUDevice::GetDeviceContext(int stream_id,
+                                                  uint32 wait_mask) {
+  mutex_lock l(device_contexts_mu_);
+  GPUDeviceContext*& context = device_contexts_[{stream_id, wait_mask}];
+  if (context == nullptr) {
+    const StreamGroup* group = compute_streams_[stream_id];
+    context = new GPUDeviceContext(stream_id, group->compute,
+#if TENSORFLOW_USE_ROCM
+                                   group->nccl,
+#endif
+                                   group->host_to_device,
+                                   group->device_to_host,
+                                   group->device_to_device);
+    gtl::InlinedVector<se::Stream*, 4> wait_streams;
+    for (int i = 0; i < num_compute_streams_; ++i) {
+      if (wait_mask & (uint32{1} << i)) {
+        wait_streams.push_back(compute_streams_[i]->compute);
+      }
+    }
+    context->set_wait_streams(std::move(wait_streams));
+  }
+  return context;
+}
+
+Status BaseGPUDevice::AssignDeviceContexts(
+    const Graph& graph, std::vector<DeviceContext*>* device_contexts) {
+  if (num_compute_streams_ <= 1) return Status::OK();
+  gpu_stream_util::StreamAssignment assignment;
+  TF_RETURN_IF_ERROR(gpu_stream_util::AssignStreams(
+      graph, num_compute_streams_, &assignment));
+  device_contexts->assign(graph.num_node_ids(), nullptr);
+  for (const Node* node : graph.op_nodes()) {
+    const int id = node->id();
+    (*device_contexts)[id] = GetDeviceContext(assignment.stream_ids[id],
+                                              assignment.wait_masks[id]);
+  }
+  return Status::OK();
+}
+
 Allocator* BaseGPUDevice::GetScopedAllocator(AllocatorAttributes attr,
                                              int64_t step_id) {
   if (attr.scope_id > 0) {
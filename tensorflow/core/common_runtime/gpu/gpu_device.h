@@ -23,8 +23,10 @@ limitations under the License.
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/device/device_id_utils.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
@@ -86,6 +88,12 @@ class BaseGPUDevice : public LocalDevice {
                                DeviceContext* dc,
                                Allocator* allocator) override;
 
+  // Assigns the nodes of `graph` to the compute streams, if the device has
+  // several.
+  Status AssignDeviceContexts(
+      const Graph& graph,
+      std::vector<DeviceContext*>* device_contexts) override;
+
   // Returns the platform GPU id of this device within the native driver system;
   // e.g., for CUDA and ROCm this is the ordinal of the GPU within the system.
   int gpu_id() const {
@@ -149,8 +157,22 @@ class BaseGPUDevice : public LocalDevice {
 
   StreamGroup* stream_;
   mutex scratch_init_mutex_;
-  char* scratch_ = nullptr;
+  // The scratch buffers used by Eigen, one for each compute stream.
+  std::vector<char*> scratch_;
   GPUDeviceContext* device_context_;
+
+  // The stream groups of the compute streams, the first of which is stream_,
+  // if GPUOptions.Experimental.num_compute_streams is > 1.
+  int num_compute_streams_ = 1;
+  std::vector<StreamGroup*> compute_streams_;
+  // The device contexts of the nodes assigned to the compute streams, by
+  // stream id and the bitmask of the streams they wait for.
+  mutex device_contexts_mu_;
+  absl::flat_hash_map<std::pair<int, uint32>, GPUDeviceContext*>
+      device_contexts_ TF_GUARDED_BY(device_contexts_mu_);
+  // Wraps the GPU allocator to defer deallocations until all the compute
+  // streams have passed them, if there are several.
+  std::unique_ptr<Allocator> multi_stream_allocator_;
   GpuDeviceInfo* gpu_device_info_ = nullptr;
   mutex trace_mu_;
   TfDeviceId tf_device_id_;
@@ -165,6 +187,10 @@ class BaseGPUDevice : public LocalDevice {
   // Initialize scratch buffers used by Eigen.
   Status InitScratchBuffers();
 
+  // Returns the device context of the ops that run on compute stream
+  // `stream_id` after the compute streams in `wait_mask`.
+  GPUDeviceContext* GetDeviceContext(int stream_id, uint32 wait_mask);
+
   void ReinitializeDevice(OpKernelContext* context, PerOpGpuDevice* device,
                           int stream_id, Allocator* allocator);
 
@@ -94,6 +94,16 @@ class GPUDeviceTest : public ::testing::Test {
     return options;
   }
 
+  // Returns the FreeRangeAlignment() of the sub-allocator of the allocator of
+  // the given GPU.
+  static size_t SubAllocatorFreeRangeAlignment(int tf_device_id) {
+    GPUProcessState* process_state = GPUProcessState::singleton();
+    mutex_lock l(process_state->mu_);
+    CHECK_LT(tf_device_id, process_state->gpu_allocators_.size());
+    return process_state->gpu_allocators_[tf_device_id]
+        .sub_allocator->FreeRangeAlignment();
+  }
+
   void InitCPUTensor(Tensor* cpu_tensor, int num_elements, float value) {
     auto tensor = cpu_tensor->tensor<float, 1>();
     for (int i = 0; i < num_elements; ++i) {
@@ -192,6 +202,52 @@ TEST_F(GPUDeviceTest, CudaMallocAsyncPreallocate) {
   EXPECT_EQ(status.code(), error::OK);
 }
 
+TEST_F(GPUDeviceTest, CudaMallocAsyncPerStreamPool) {
+#ifndef GOOGLE_CUDA
+  return;
+#elif CUDA_VERSION < 11030
+  LOG(INFO) << "CUDA toolkit too old, skipping this test: " << CUDA_VERSION;
+  return;
+#else
+  int driverVersion;
+  cuDriverGetVersion(&driverVersion);
+  if (driverVersion < 11030) {
+    LOG(INFO) << "Driver version too old, skipping this test: "
+              << driverVersion;
+    return;
+  }
+#endif
+
+  // Two virtual devices on the same GPU, each with its own pool.
+  SessionOptions opts = MakeSessionOptions("0", 0, 2, {{64, 64}}, {},
+                                           /*use_cuda_malloc_async=*/true);
+  setenv("TF_CUDA_MALLOC_ASYNC_PER_STREAM_POOL", "true", 1);
+  setenv("TF_CUDA_MALLOC_ASYNC_RELEASE_THRESHOLD", "1048576", 1);
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  unsetenv("TF_CUDA_MALLOC_ASYNC_PER_STREAM_POOL");
+  unsetenv("TF_CUDA_MALLOC_ASYNC_RELEASE_THRESHOLD");
+  ASSERT_EQ(devices.size(), 2);
+
+  AllocatorAttributes allocator_attributes = AllocatorAttributes();
+  allocator_attributes.set_gpu_compatible(true);
+  Allocator* allocator0 = devices[0]->GetAllocator(allocator_attributes);
+  Allocator* allocator1 = devices[1]->GetAllocator(allocator_attributes);
+  ASSERT_NE(allocator0, allocator1);
+  void* ptr = allocator0->AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  EXPECT_NE(ptr, nullptr);
+
+  // Only the pool of the first device has reserved memory.
+  absl::optional<AllocatorStats> stats0 = allocator0->GetStats();
+  absl::optional<AllocatorStats> stats1 = allocator1->GetStats();
+  ASSERT_TRUE(stats0 && stats1);
+  EXPECT_GE(stats0->bytes_reserved, 1024);
+  EXPECT_GE(stats0->peak_bytes_reserved, stats0->bytes_reserved);
+  EXPECT_EQ(stats1->bytes_reserved, 0);
+  allocator0->DeallocateRaw(ptr);
+}
+
 TEST_F(GPUDeviceTest, FailedToParseVisibleDeviceList) {
   SessionOptions opts = MakeSessionOptions("0,abc");
   std::vector<std::unique_ptr<Device>> devices;
@@ -478,6 +534,64 @@ TEST_F(GPUDeviceTest, UnifiedMemoryAllocation) {
   allocator->DeallocateRaw(ptr);
 }
 
+TEST_F(GPUDeviceTest, DefragmentAllocatorOnSync) {
+#if !defined(GOOGLE_CUDA) || CUDA_VERSION < 10020
+  return;
+#endif
+  constexpr size_t kMiB = 1 << 20;
+  SessionOptions opts = MakeSessionOptions("0", 0, 1, {{64}});
+  setenv("TF_GPU_BFC_DEFRAGMENT_MIN_MB", "2", 1);
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  unsetenv("TF_GPU_BFC_DEFRAGMENT_MIN_MB");
+  ASSERT_EQ(devices.size(), 1);
+  if (SubAllocatorFreeRangeAlignment(0) == 0) {
+    LOG(INFO) << "GPU virtual memory management unsupported, skipping this "
+                 "test";
+    return;
+  }
+
+  Allocator* allocator = devices[0]->GetAllocator(AllocatorAttributes());
+  AllocationAttributes no_retry;
+  no_retry.retry_on_failure = false;
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 4; ++i) {
+    ptrs.push_back(allocator->AllocateRaw(Allocator::kAllocatorAlignment,
+                                          8 * kMiB, no_retry));
+    ASSERT_NE(ptrs.back(), nullptr);
+  }
+  // Leaves free chunks of 8MiB between the remaining allocations, and less
+  // than 32MiB after them.
+  allocator->DeallocateRaw(ptrs[0]);
+  allocator->DeallocateRaw(ptrs[2]);
+  EXPECT_EQ(allocator->AllocateRaw(Allocator::kAllocatorAlignment, 40 * kMiB,
+                                   no_retry),
+            nullptr);
+
+  // Syncing the device releases the free memory, which the allocator obtains
+  // again as one region.
+  TF_ASSERT_OK(devices[0]->Sync());
+  void* large = allocator->AllocateRaw(Allocator::kAllocatorAlignment,
+                                       40 * kMiB, no_retry);
+  EXPECT_NE(large, nullptr);
+  allocator->DeallocateRaw(large);
+  allocator->DeallocateRaw(ptrs[1]);
+  allocator->DeallocateRaw(ptrs[3]);
+}
+
+TEST_F(GPUDeviceTest, DefragmentAllocatorIsOptIn) {
+  SessionOptions opts = MakeSessionOptions("0", 0, 1, {{64}});
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  ASSERT_EQ(devices.size(), 1);
+  EXPECT_EQ(SubAllocatorFreeRangeAlignment(0), 0);
+  TF_ASSERT_OK(devices[0]->Sync());
+  EXPECT_EQ(GPUProcessState::singleton()->DefragmentGPUAllocator(TfDeviceId(0)),
+            0);
+}
+
 TEST_F(GPUDeviceTest, CopyTensorInSameDevice) {
   SessionOptions opts = MakeSessionOptions("0");
   std::vector<std::unique_ptr<Device>> devices;
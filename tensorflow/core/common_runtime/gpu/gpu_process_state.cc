@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_virtual_mem_allocator.h"
 #include "tensorflow/core/common_runtime/pool_allocator.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
+#include "tensorflow/core/common_runtime/size_class_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tracking_allocator.h"
@@ -43,6 +44,11 @@ limitations under the License.
 
 namespace tensorflow {
 
+static bool UseBFCGpuHostAllocator() {
+  const char* allocator_env = std::getenv("TF_GPU_HOST_ALLOCATOR");
+  return allocator_env != nullptr && std::strcmp(allocator_env, "bfc") == 0;
+}
+
 // NOLINTNEXTLINE(clang-diagnostic-unused-function)
 static bool UseCudaMallocAllocator() {
   const char* allocator_env = std::getenv("TF_GPU_ALLOCATOR");
@@ -72,6 +78,23 @@ static bool UseCudaMallocAsyncAllocator() {
 #endif
 }
 
+// Returns the minimum size of the free memory ranges that the GPU allocators
+// release between steps, or 0 if they don't. Releasing memory requires the
+// virtual memory allocator, which then maps one physical memory handle per
+// page of the min allocation granularity. The memory is released when the
+// device is synced, so this is only safe if steps don't overlap on a GPU.
+// NOLINTNEXTLINE(clang-diagnostic-unused-function)
+static size_t GpuBFCDefragmentMinBytes() {
+  int64_t min_mb = 0;
+  Status status = ReadInt64FromEnvVar("TF_GPU_BFC_DEFRAGMENT_MIN_MB",
+                                      /*default_val=*/0, &min_mb);
+  if (!status.ok()) {
+    LOG(ERROR) << "GetGPUAllocator: " << status.error_message();
+    return 0;
+  }
+  return min_mb > 0 ? static_cast<size_t>(min_mb) << 20 : 0;
+}
+
 /*static*/ GPUProcessState* GPUProcessState::singleton(GPUProcessState* ps) {
   static GPUProcessState* instance = ps ? ps : new GPUProcessState;
   DCHECK((!ps) || (ps == instance))
@@ -98,11 +121,39 @@ int GPUProcessState::BusIdForGPU(TfDeviceId tf_device_id) {
 static SubAllocator* CreateSubAllocator(
     const GPUOptions& options, PlatformDeviceId platform_device_id,
     const std::vector<SubAllocator::Visitor>& alloc_visitors,
-    size_t total_bytes, const std::vector<TfDeviceId>& peer_gpu_ids) {
+    size_t total_bytes, const std::vector<TfDeviceId>& peer_gpu_ids,
+    bool release_free_ranges) {
   auto executor = DeviceIdUtil::ExecutorForPlatformDeviceId(GPUMachineManager(),
                                                             platform_device_id)
                       .ValueOrDie();
 
+#if defined(GOOGLE_CUDA) && CUDA_VERSION >= 10020
+  // Freeing parts of allocations requires the virtual memory allocator, which
+  // is otherwise disabled below.
+  if (release_free_ranges && options.per_process_gpu_memory_fraction() <= 1.0 &&
+      !options.experimental().use_unified_memory()) {
+    auto* gpu_context = reinterpret_cast<stream_executor::gpu::GpuContext*>(
+        executor->implementation()->GpuContextHack());
+    std::vector<PlatformDeviceId> platform_peer_gpu_ids;
+    platform_peer_gpu_ids.reserve(peer_gpu_ids.size());
+    for (const TfDeviceId peer_tf_device_id : peer_gpu_ids) {
+      PlatformDeviceId peer_platform_device_id;
+      TF_CHECK_OK(GpuIdManager::TfToPlatformDeviceId(
+          peer_tf_device_id, &peer_platform_device_id));
+      platform_peer_gpu_ids.push_back(peer_platform_device_id);
+    }
+    // Released ranges leave holes in the virtual address space, which are not
+    // reused, so reserve much more of it than the physical memory limit.
+    auto allocator = GpuVirtualMemAllocator::Create(
+        alloc_visitors, {}, *gpu_context, platform_device_id,
+        /*virtual_address_space_size=*/total_bytes * 16, platform_peer_gpu_ids,
+        /*map_granularity_pages=*/true);
+    if (allocator.ok()) return allocator.ValueOrDie().release();
+    LOG(WARNING) << "Not releasing free GPU memory between steps: "
+                 << allocator.status();
+  }
+#endif
+
   // FIXME(imintz): Observed OOM issues when using the virtual memory
   // allocators. This should be reenabled when resolved.
 #if 0 && defined(GOOGLE_CUDA) && CUDA_VERSION >= 10020
@@ -179,13 +230,17 @@ Allocator* GPUProcessState::GetGPUAllocator(
     while (bus_id >= gpu_visitors_.size()) {
       gpu_visitors_.push_back({});
     }
-    auto* sub_allocator =
-        CreateSubAllocator(options, platform_device_id, gpu_visitors_[bus_id],
-                           total_bytes, peer_gpu_ids);
+    const size_t defragment_min_bytes = GpuBFCDefragmentMinBytes();
+    auto* sub_allocator = CreateSubAllocator(
+        options, platform_device_id, gpu_visitors_[bus_id], total_bytes,
+        peer_gpu_ids, /*release_free_ranges=*/defragment_min_bytes > 0);
     GPUBFCAllocator* gpu_bfc_allocator = new GPUBFCAllocator(
         sub_allocator, total_bytes, options,
         strings::StrCat("GPU_", tf_device_id.value(), "_bfc"),
         options.experimental().internal_fragmentation_fraction());
+    if (defragment_min_bytes > 0) {
+      gpu_bfc_allocator->EnableDefragmentBetweenSteps(defragment_min_bytes);
+    }
     Allocator* gpu_allocator = gpu_bfc_allocator;
 
     SharedCounter* timing_counter = nullptr;
@@ -278,6 +333,16 @@ SharedCounter* GPUProcessState::GPUAllocatorCounter(TfDeviceId tf_device_id) {
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 }
 
+size_t GPUProcessState::DefragmentGPUAllocator(TfDeviceId tf_device_id) {
+  tf_shared_lock l(mu_);
+  if (tf_device_id.value() >= static_cast<int64_t>(gpu_allocators_.size())) {
+    return 0;
+  }
+  GPUBFCAllocator* bfc_allocator =
+      gpu_allocators_[tf_device_id.value()].bfc_allocator;
+  return bfc_allocator == nullptr ? 0 : bfc_allocator->DefragmentBetweenSteps();
+}
+
 Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
   CHECK(process_state_);
   if (!HasGPUDevice() ||
@@ -294,13 +359,12 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     // we take a unique lock and populate these vectors.
     tf_shared_lock lock(mu_);
 
-    if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types &&
-        !gpu_host_allocators_.empty() &&
-        gpu_host_allocators_[0].recording_allocator != nullptr) {
-      return gpu_host_allocators_[0].recording_allocator.get();
-    }
     if (static_cast<int>(gpu_host_allocators_.size()) > numa_node) {
-      return gpu_host_allocators_[0].allocator.get();
+      if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types &&
+          gpu_host_allocators_[numa_node].recording_allocator != nullptr) {
+        return gpu_host_allocators_[numa_node].recording_allocator.get();
+      }
+      return gpu_host_allocators_[numa_node].allocator.get();
     }
   }
 
@@ -325,15 +389,17 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
   CHECK_NE(nullptr, se);
 
   while (static_cast<int>(gpu_host_allocators_.size()) <= numa_node) {
-    while (gpu_host_alloc_visitors_.size() <= numa_node) {
+    // The allocator of the next node, whose memory is pinned on that node.
+    const int node = gpu_host_allocators_.size();
+    while (gpu_host_alloc_visitors_.size() <= node) {
       gpu_host_alloc_visitors_.push_back({});
     }
-    while (gpu_host_free_visitors_.size() <= numa_node) {
+    while (gpu_host_free_visitors_.size() <= node) {
       gpu_host_free_visitors_.push_back({});
     }
-    SubAllocator* sub_allocator = new DeviceHostAllocator(
-        se, numa_node, gpu_host_alloc_visitors_[numa_node],
-        gpu_host_free_visitors_[numa_node]);
+    SubAllocator* sub_allocator =
+        new DeviceHostAllocator(se, node, gpu_host_alloc_visitors_[node],
+                                gpu_host_free_visitors_[node]);
     // TODO(zheng-xq): evaluate whether 64GB by default is the best choice.
     int64_t gpu_host_mem_limit_in_mb = -1;
     Status status = ReadInt64FromEnvVar("TF_GPU_HOST_MEM_LIMIT_IN_MB",
@@ -344,9 +410,17 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     }
     int64_t gpu_host_mem_limit = gpu_host_mem_limit_in_mb * (1LL << 20);
 
-    Allocator* allocator =
-        new BFCAllocator(sub_allocator, gpu_host_mem_limit,
-                         /*allow_growth=*/true, /*name=*/"gpu_host_bfc");
+    // The size-class allocator wastes less of the scarce pinned memory than
+    // the BFC allocator, and scales with the number of threads.
+    Allocator* allocator;
+    if (UseBFCGpuHostAllocator()) {
+      allocator =
+          new BFCAllocator(sub_allocator, gpu_host_mem_limit,
+                           /*allow_growth=*/true, /*name=*/"gpu_host_bfc");
+    } else {
+      allocator = new SizeClassAllocator(sub_allocator, gpu_host_mem_limit,
+                                         strings::StrCat("gpu_host_", node));
+    }
 
     if (LogMemory::IsEnabled() && !allocator->TracksAllocationSizes()) {
       // Wrap the allocator to track allocation ids for better logging
@@ -361,7 +435,7 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types) {
       ProcessState::MemDesc md;
       md.loc = ProcessState::MemDesc::CPU;
-      md.dev_index = 0;
+      md.dev_index = node;
       md.gpu_registered = true;
       md.nic_registered = false;
       allocator_parts.recording_allocator.reset(
@@ -371,9 +445,9 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     }
   }
   if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types) {
-    return gpu_host_allocators_[0].recording_allocator.get();
+    return gpu_host_allocators_[numa_node].recording_allocator.get();
   } else {
-    return gpu_host_allocators_[0].allocator.get();
+    return gpu_host_allocators_[numa_node].allocator.get();
   }
 }
 
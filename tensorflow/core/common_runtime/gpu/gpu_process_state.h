@@ -124,6 +124,14 @@ class GPUProcessState {
 
   SharedCounter* GPUAllocatorCounter(TfDeviceId tf_device_id);
 
+  // Returns the memory behind large free chunks of the allocator of the given
+  // GPU to the driver, if enabled with TF_GPU_BFC_DEFRAGMENT_MIN_MB, and
+  // returns the number of bytes released.
+  //
+  // REQUIRES: No work that may access memory freed to the allocator is
+  // pending on the GPU.
+  size_t DefragmentGPUAllocator(TfDeviceId tf_device_id);
+
  protected:
   // GPUProcessState is a singleton that should not normally be deleted except
   // at process shutdown.
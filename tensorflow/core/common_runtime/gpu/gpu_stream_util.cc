@@ -0,0 +1,89 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace gpu_stream_util {
+namespace {
+
+// Returns true if `node` runs on stream 0 after all the other streams.
+bool JoinsStreams(const Node& node) {
+  return node.IsArg() || node.IsRetval() || node.IsSend() || node.IsRecv() ||
+         node.op_def().is_stateful();
+}
+
+}  // namespace
+
+Status AssignStreams(const Graph& graph, int num_streams,
+                     StreamAssignment* assignment) {
+  if (num_streams < 1 || num_streams > kMaxComputeStreams) {
+    return errors::InvalidArgument("The number of compute streams must be "
+                                   "between 1 and ",
+                                   kMaxComputeStreams, ", got ", num_streams);
+  }
+  const uint32 all_streams = num_streams == kMaxComputeStreams
+                                 ? ~uint32{0}
+                                 : (uint32{1} << num_streams) - 1;
+  assignment->stream_ids.assign(graph.num_node_ids(), 0);
+  assignment->wait_masks.assign(graph.num_node_ids(), 0);
+  // Whether a consumer of each node already continues its stream.
+  std::vector<bool> continued(graph.num_node_ids(), false);
+  std::vector<int64_t> num_nodes(num_streams, 0);
+
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order, NodeComparatorName());
+  for (const Node* node : order) {
+    if (!node->IsOp()) continue;
+    const int id = node->id();
+    int stream = -1;
+    uint32 wait_mask = 0;
+    if (JoinsStreams(*node)) {
+      stream = 0;
+      wait_mask = all_streams;
+    } else {
+      for (int i = 0; i < node->num_inputs() && stream == -1; ++i) {
+        const Edge* edge;
+        TF_RETURN_IF_ERROR(node->input_edge(i, &edge));
+        const int src_id = edge->src()->id();
+        if (edge->src()->IsOp() && !continued[src_id]) {
+          stream = assignment->stream_ids[src_id];
+          continued[src_id] = true;
+        }
+      }
+      if (stream == -1) {
+        stream = std::min_element(num_nodes.begin(), num_nodes.end()) -
+                 num_nodes.begin();
+      }
+      for (const Edge* edge : node->in_edges()) {
+        if (edge->src()->IsOp()) {
+          wait_mask |= uint32{1} << assignment->stream_ids[edge->src()->id()];
+        }
+      }
+    }
+    ++num_nodes[stream];
+    assignment->stream_ids[id] = stream;
+    assignment->wait_masks[id] = wait_mask & ~(uint32{1} << stream);
+  }
+  return Status::OK();
+}
+
+}  // namespace gpu_stream_util
+}  // namespace tensorflow
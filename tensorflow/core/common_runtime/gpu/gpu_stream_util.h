@@ -0,0 +1,56 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_UTIL_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_UTIL_H_
+
+#include <vector>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace gpu_stream_util {
+
+// The largest number of compute streams a graph can be assigned to.
+constexpr int kMaxComputeStreams = 32;
+
+struct StreamAssignment {
+  // The compute stream of each node, indexed by node id.
+  std::vector<int> stream_ids;
+  // The bitmask of the other streams that the stream of each node waits for
+  // before the node runs, indexed by node id.
+  std::vector<uint32> wait_masks;
+};
+
+// Assigns the nodes of `graph` to `num_streams` compute streams, so that
+// independent branches can run concurrently. Like the stream assignment of
+// XLA, a node continues the stream of the first of its inputs whose stream no
+// other node has continued yet, so that chains stay on one stream, and
+// otherwise starts a branch on the stream with the fewest nodes. A node waits
+// for the streams of all its inputs, data or control.
+//
+// Stateful nodes, arguments, return values, sends and receives run on stream
+// 0 after the work enqueued on all the other streams, since the state they
+// update and the tensors they pass to and from other graphs are used in
+// other steps, which are only ordered with each other on stream 0.
+Status AssignStreams(const Graph& graph, int num_streams,
+                     StreamAssignment* assignment);
+
+}  // namespace gpu_stream_util
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_GPU_GPU_STREAM_UTIL_H_
@@ -0,0 +1,99 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
+
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace gpu_stream_util {
+namespace {
+
+class GpuStreamUtilTest : public ::testing::Test {
+ protected:
+  // Builds a diamond of two independent chains between "a" and "d", and a
+  // stateful "random" node.
+  void SetUp() override {
+    Scope s = Scope::NewRootScope();
+    auto a = ops::Const(s.WithOpName("a"), 1.0f, {2, 2});
+    auto b1 = ops::Square(s.WithOpName("b1"), a);
+    auto b2 = ops::Neg(s.WithOpName("b2"), a);
+    auto c1 = ops::Square(s.WithOpName("c1"), b1);
+    auto c2 = ops::Neg(s.WithOpName("c2"), b2);
+    auto d = ops::Add(s.WithOpName("d"), c1, c2);
+    ops::RandomUniform(s.WithOpName("random").WithControlDependencies({d}),
+                       ops::Const(s, {2, 2}), DT_FLOAT);
+    TF_ASSERT_OK(s.ToGraph(&graph_));
+    for (const Node* node : graph_.op_nodes()) ids_[node->name()] = node->id();
+  }
+
+  int Stream(const string& name) const {
+    return assignment_.stream_ids[ids_.at(name)];
+  }
+  uint32 WaitMask(const string& name) const {
+    return assignment_.wait_masks[ids_.at(name)];
+  }
+
+  Graph graph_{OpRegistry::Global()};
+  absl::flat_hash_map<string, int> ids_;
+  StreamAssignment assignment_;
+};
+
+TEST_F(GpuStreamUtilTest, RunsIndependentChainsOnDifferentStreams) {
+  TF_ASSERT_OK(AssignStreams(graph_, 2, &assignment_));
+  EXPECT_EQ(Stream("c1"), Stream("b1"));
+  EXPECT_EQ(Stream("c2"), Stream("b2"));
+  EXPECT_NE(Stream("b1"), Stream("b2"));
+  EXPECT_TRUE(Stream("a") == Stream("b1") || Stream("a") == Stream("b2"));
+
+  // Only the nodes forking and joining the chains wait for another stream.
+  EXPECT_EQ(WaitMask("b1") | WaitMask("b2"), 1 << Stream("a"));
+  EXPECT_EQ(WaitMask("c1"), 0);
+  EXPECT_EQ(WaitMask("c2"), 0);
+  EXPECT_EQ(Stream("d"), Stream("c1"));
+  EXPECT_EQ(WaitMask("d"), 1 << Stream("c2"));
+}
+
+TEST_F(GpuStreamUtilTest, RunsStatefulNodesAfterAllStreams) {
+  TF_ASSERT_OK(AssignStreams(graph_, 4, &assignment_));
+  EXPECT_EQ(Stream("random"), 0);
+  EXPECT_EQ(WaitMask("random"), 0b1110);
+}
+
+TEST_F(GpuStreamUtilTest, UsesOneStream) {
+  TF_ASSERT_OK(AssignStreams(graph_, 1, &assignment_));
+  for (const auto& name_and_id : ids_) {
+    EXPECT_EQ(assignment_.stream_ids[name_and_id.second], 0);
+    EXPECT_EQ(assignment_.wait_masks[name_and_id.second], 0);
+  }
+}
+
+TEST_F(GpuStreamUtilTest, RejectsInvalidNumbersOfStreams) {
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(AssignStreams(graph_, 0, &assignment_)));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      AssignStreams(graph_, kMaxComputeStreams + 1, &assignment_)));
+}
+
+}  // namespace
+}  // namespace gpu_stream_util
+}  // namespace tensorflow
@@ -15,12 +15,17 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 
+#include <atomic>
+#include <cstring>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_reference.h"
@@ -31,9 +36,12 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/tensor_coding.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/util.h"
 
 // IMPLEMENTATION NOTE:
@@ -148,7 +156,8 @@ void GPUUtil::SetProtoFromGPU(const Tensor& tensor, Device* dev,
   const int64_t total_bytes = is_dead ? 0 : tensor.TotalBytes();
   if (total_bytes > 0) {
     profiler::ScopedAnnotation annotation("SetProtoFromGPU");
-    alloc = GPUProcessState::singleton()->GetGpuHostAllocator(0);
+    alloc = GPUProcessState::singleton()->GetGpuHostAllocator(
+        dev->attributes().locality().numa_node());
     buf = static_cast<char*>(
         alloc->AllocateRaw(Allocator::kAllocatorAlignment, total_bytes));
     if (LogMemory::IsEnabled()) {
@@ -295,6 +304,203 @@ void GPUUtil::CopyGPUTensorToCPU(Device* gpu_device,
       });
 }
 
+namespace {
+
+// The number of pinned buffers through which a chunked host-to-device copy is
+// staged.
+constexpr int kNumChunkStagingBuffers = 4;
+
+// The chunk size set by SetHostToDeviceCopyChunkingForTesting(), or -1.
+std::atomic<int64_t> chunk_bytes_for_testing{-1};
+// The chunk at which chunked copies fail, set by
+// SetHostToDeviceCopyChunkingForTesting(), or -1.
+std::atomic<int64_t> fail_at_chunk_for_testing{-1};
+
+// Returns the size of the chunks in which host tensors that are not in pinned
+// memory are copied to a GPU, which is set by the TF_GPU_H2D_COPY_CHUNK_BYTES
+// environment variable. Tensors of at most this size, and all tensors if it is
+// 0 (the default), are copied with a single memcpy.
+int64_t HostToDeviceCopyChunkBytes() {
+  const int64_t chunk_bytes_override = chunk_bytes_for_testing.load();
+  if (chunk_bytes_override >= 0) return chunk_bytes_override;
+  static const int64_t chunk_bytes = [] {
+    int64_t value;
+    Status s = ReadInt64FromEnvVar("TF_GPU_H2D_COPY_CHUNK_BYTES",
+                                   /*default_val=*/0, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << "Copying host tensors to GPUs in one piece: " << s;
+      return int64_t{0};
+    }
+    return value;
+  }();
+  return chunk_bytes;
+}
+
+// Returns true if the buffer of `tensor` was allocated by `host_allocator`.
+bool IsAllocatedBy(const Tensor& tensor, Allocator* host_allocator) {
+  AllocationDescription desc;
+  DMAHelper::buffer(&tensor)->FillAllocationDescription(&desc);
+  return desc.allocator_name() == host_allocator->Name();
+}
+
+// Copies a host buffer to a GPU in fixed-size chunks. Each chunk is staged
+// into one of a ring of pinned buffers, and transferred by the host-to-device
+// stream while the next chunks are staged, so that the source is never pinned
+// (or staged) in full. The object deletes itself once the copy is done.
+//
+// If a transfer fails, the chunks that are not staged yet are skipped, and
+// the copy fails once the transfers in flight are done.
+class ChunkedHostToDeviceCopy {
+ public:
+  ChunkedHostToDeviceCopy(const char* src, char* dst, int64_t total_bytes,
+                          int64_t chunk_bytes, Allocator* host_allocator,
+                          std::vector<char*> buffers, se::Stream* stream,
+                          EventMgr* event_mgr, thread::ThreadPool* workers,
+                          TensorReference input_ref, StatusCallback done)
+      : src_(src),
+        dst_(dst),
+        total_bytes_(total_bytes),
+        chunk_bytes_(chunk_bytes),
+        num_chunks_((total_bytes + chunk_bytes - 1) / chunk_bytes),
+        host_allocator_(host_allocator),
+        buffers_(std::move(buffers)),
+        stream_(stream),
+        event_mgr_(event_mgr),
+        workers_(workers),
+        input_ref_(input_ref),
+        done_(std::move(done)),
+        fail_at_chunk_(fail_at_chunk_for_testing.load()),
+        num_pending_chunks_(num_chunks_) {}
+
+  // Starts the copy. Allocates the staging buffers, and returns false (without
+  // starting the copy) if they cannot be allocated.
+  static bool Start(const char* src, char* dst, int64_t total_bytes,
+                    int64_t chunk_bytes, Allocator* host_allocator,
+                    se::Stream* stream, EventMgr* event_mgr,
+                    thread::ThreadPool* workers,
+                    const TensorReference& input_ref, StatusCallback* done) {
+    std::vector<char*> buffers;
+    const int64_t num_chunks = (total_bytes + chunk_bytes - 1) / chunk_bytes;
+    for (int i = 0; i < std::min<int64_t>(kNumChunkStagingBuffers, num_chunks);
+         ++i) {
+      void* buffer =
+          host_allocator->AllocateRaw(Allocator::kAllocatorAlignment,
+                                      chunk_bytes);
+      if (buffer == nullptr) {
+        for (char* b : buffers) host_allocator->DeallocateRaw(b);
+        return false;
+      }
+      buffers.push_back(static_cast<char*>(buffer));
+    }
+    auto* copy = new ChunkedHostToDeviceCopy(
+        src, dst, total_bytes, chunk_bytes, host_allocator, std::move(buffers),
+        stream, event_mgr, workers, input_ref, std::move(*done));
+    const int num_buffers = copy->buffers_.size();
+    for (int i = 0; i < num_buffers; ++i) copy->CopyChunk(i);
+    return true;
+  }
+
+ private:
+  // Stages chunk `chunk` into its buffer, and enqueues its transfer.
+  void CopyChunk(int64_t chunk) {
+    if (chunk == fail_at_chunk_) {
+      SetError(errors::Internal("Injected failure of the CPU->GPU copy of "
+                                "chunk ",
+                                chunk));
+    }
+    if (failed()) {
+      // Skips this chunk and those that would have reused its buffer.
+      FinishChunks(NumChunksFrom(chunk));
+      return;
+    }
+    const int64_t offset = chunk * chunk_bytes_;
+    const int64_t bytes = std::min(chunk_bytes_, total_bytes_ - offset);
+    char* buffer = buffers_[chunk % buffers_.size()];
+    std::memcpy(buffer, src_ + offset, bytes);
+    DeviceMemoryBase gpu_dst_ptr(dst_ + offset, bytes);
+    stream_->ThenMemcpy(&gpu_dst_ptr, buffer, bytes);
+    event_mgr_->ThenExecute(stream_, [this, chunk]() { ChunkDone(chunk); });
+  }
+
+  // Called when the transfer of `chunk` is done, which frees its buffer for
+  // the chunk that is `buffers_.size()` chunks later.
+  void ChunkDone(int64_t chunk) {
+    if (!stream_->ok()) {
+      SetError(errors::Internal("CPU->GPU Memcpy failed"));
+    }
+    const int64_t next_chunk = chunk + buffers_.size();
+    if (next_chunk < num_chunks_ && !failed()) {
+      // EventMgr callbacks must be brief, so the next chunk is staged on
+      // another thread.
+      workers_->Schedule([this, next_chunk]() {
+        CopyChunk(next_chunk);
+        FinishChunks(1);
+      });
+    } else {
+      FinishChunks(1 + NumChunksFrom(next_chunk));
+    }
+  }
+
+  // Returns the number of chunks from `chunk` on that use its buffer.
+  int64_t NumChunksFrom(int64_t chunk) const {
+    if (chunk >= num_chunks_) return 0;
+    return (num_chunks_ - 1 - chunk) / buffers_.size() + 1;
+  }
+
+  void SetError(const Status& status) TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    status_.Update(status);
+  }
+
+  bool failed() TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    return !status_.ok();
+  }
+
+  // Accounts for `num_chunks` chunks that were transferred or skipped, and
+  // whose buffers are no longer needed, and finishes the copy after the last
+  // one.
+  void FinishChunks(int64_t num_chunks) {
+    if (num_pending_chunks_.fetch_sub(num_chunks) != num_chunks) return;
+    for (char* buffer : buffers_) host_allocator_->DeallocateRaw(buffer);
+    input_ref_.Unref();
+    StatusCallback done = std::move(done_);
+    Status status;
+    {
+      mutex_lock l(mu_);
+      status = status_;
+    }
+    delete this;
+    done(status);
+  }
+
+  const char* const src_;
+  char* const dst_;
+  const int64_t total_bytes_;
+  const int64_t chunk_bytes_;
+  const int64_t num_chunks_;
+  Allocator* const host_allocator_;
+  const std::vector<char*> buffers_;
+  se::Stream* const stream_;
+  EventMgr* const event_mgr_;
+  thread::ThreadPool* const workers_;
+  TensorReference input_ref_;
+  StatusCallback done_;
+  const int64_t fail_at_chunk_;
+  std::atomic<int64_t> num_pending_chunks_;
+  mutex mu_;
+  Status status_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+/*  static */
+void GPUUtil::SetHostToDeviceCopyChunkingForTesting(int64_t chunk_bytes,
+                                                    int64_t fail_at_chunk) {
+  chunk_bytes_for_testing.store(chunk_bytes);
+  fail_at_chunk_for_testing.store(fail_at_chunk);
+}
+
 /*  static */
 void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
                                  const DeviceContext* device_context,
@@ -323,6 +529,27 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
   }
 
   const int64_t total_bytes = cpu_tensor->TotalBytes();
+  // Use of cpu_tensor may outlive stack scope, so keep a ref.
+  TensorReference input_ref(*cpu_tensor);
+
+  // Copying a large tensor that is not in pinned memory with a single memcpy
+  // stages all of it, so it is copied in chunks instead.
+  const int64_t chunk_bytes = HostToDeviceCopyChunkBytes();
+  if (chunk_bytes > 0 && total_bytes > chunk_bytes) {
+    Allocator* host_allocator =
+        GPUProcessState::singleton()->GetGpuHostAllocator(
+            gpu_device->attributes().locality().numa_node());
+    if (!IsAllocatedBy(*cpu_tensor, host_allocator) &&
+        ChunkedHostToDeviceCopy::Start(
+            static_cast<const char*>(GetBase(cpu_tensor)),
+            static_cast<char*>(GetBase(gpu_tensor)), total_bytes, chunk_bytes,
+            host_allocator, recv_host_to_device_stream, dev_info->event_mgr,
+            gpu_device->tensorflow_cpu_worker_threads()->workers, input_ref,
+            &done)) {
+      return;
+    }
+  }
+
   // Note that 0-size tensors have no backing buffer.
   if (total_bytes > 0) {
     void* src_ptr = GetBase(cpu_tensor);
@@ -330,8 +557,6 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
     DeviceMemoryBase gpu_dst_ptr(dst_ptr, total_bytes);
     recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, src_ptr, total_bytes);
   }
-  // Use of cpu_tensor may outlive stack scope, so keep a ref.
-  TensorReference input_ref(*cpu_tensor);
   dev_info->event_mgr->ThenExecute(
       recv_host_to_device_stream,
       [recv_host_to_device_stream, done, input_ref]() {
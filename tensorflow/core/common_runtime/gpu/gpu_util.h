@@ -90,6 +90,14 @@ class GPUUtil {
                                  Device* gpu_device, Tensor* gpu_tensor,
                                  StatusCallback done, bool sync_dst_compute);
 
+  // For tests: overrides TF_GPU_H2D_COPY_CHUNK_BYTES, the size of the chunks
+  // in which CopyCPUTensorToGPU() copies large host tensors that are not in
+  // pinned memory, and makes those chunked copies fail at the chunk of index
+  // `fail_at_chunk` if it is not negative. A negative `chunk_bytes` restores
+  // the environment variable.
+  static void SetHostToDeviceCopyChunkingForTesting(int64_t chunk_bytes,
+                                                    int64_t fail_at_chunk = -1);
+
   static void DeviceToDeviceCopy(
       DeviceContext* send_dev_context, DeviceContext* recv_dev_context,
       Device* src, Device* dst, AllocatorAttributes src_alloc_attr,
@@ -0,0 +1,130 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#include "tensorflow/core/common_runtime/gpu/gpu_util.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_device.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int64_t kChunkBytes = 1024;
+
+class GPUUtilTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    SessionOptions options;
+    (*options.config.mutable_device_count())["GPU"] = 1;
+    TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+        options, "/job:localhost/replica:0/task:0", &devices_));
+    device_ = devices_[0].get();
+    device_context_ = device_->tensorflow_gpu_device_info()->default_context;
+  }
+
+  void TearDown() override {
+    GPUUtil::SetHostToDeviceCopyChunkingForTesting(-1);
+  }
+
+  // Returns a host tensor of `num_bytes` bytes, which are all different from
+  // those of the tensors of other `seed`s.
+  Tensor HostTensor(int64_t num_bytes, int seed) {
+    Tensor tensor(cpu_allocator(), DT_UINT8, TensorShape({num_bytes}));
+    auto bytes = tensor.vec<uint8>();
+    for (int64_t i = 0; i < num_bytes; ++i) {
+      bytes(i) = static_cast<uint8>(i * 7 + seed);
+    }
+    return tensor;
+  }
+
+  Status CopyToGPU(const Tensor& cpu_tensor, Tensor* gpu_tensor) {
+    Notification note;
+    Status status;
+    GPUUtil::CopyCPUTensorToGPU(
+        &cpu_tensor, device_context_, device_, gpu_tensor,
+        [&](const Status& s) {
+          status = s;
+          note.Notify();
+        },
+        /*sync_dst_compute=*/true);
+    note.WaitForNotification();
+    return status;
+  }
+
+  Tensor CopyToCPU(const Tensor& gpu_tensor) {
+    Tensor cpu_tensor(cpu_allocator(), gpu_tensor.dtype(), gpu_tensor.shape());
+    TF_CHECK_OK(device_context_->CopyDeviceTensorToCPUSync(
+        &gpu_tensor, /*tensor_name=*/"", device_, &cpu_tensor));
+    return cpu_tensor;
+  }
+
+  Tensor GPUTensor(int64_t num_bytes) {
+    return Tensor(device_->GetAllocator(AllocatorAttributes()), DT_UINT8,
+                  TensorShape({num_bytes}));
+  }
+
+  std::vector<std::unique_ptr<Device>> devices_;
+  Device* device_ = nullptr;
+  DeviceContext* device_context_ = nullptr;
+};
+
+TEST_F(GPUUtilTest, CopiesInChunks) {
+  GPUUtil::SetHostToDeviceCopyChunkingForTesting(kChunkBytes);
+  // Sizes around one chunk, which is copied in one piece, around the four
+  // staging buffers, and of chunks that reuse them.
+  for (int64_t num_bytes :
+       {int64_t{1}, kChunkBytes - 1, kChunkBytes, kChunkBytes + 1,
+        2 * kChunkBytes, 4 * kChunkBytes - 1, 4 * kChunkBytes,
+        4 * kChunkBytes + 1, 9 * kChunkBytes, 10 * kChunkBytes + 3}) {
+    SCOPED_TRACE(num_bytes);
+    const Tensor cpu_tensor = HostTensor(num_bytes, /*seed=*/1);
+    Tensor gpu_tensor = GPUTensor(num_bytes);
+    TF_ASSERT_OK(CopyToGPU(cpu_tensor, &gpu_tensor));
+    test::ExpectTensorEqual<uint8>(CopyToCPU(gpu_tensor), cpu_tensor);
+  }
+}
+
+TEST_F(GPUUtilTest, FailsPartwayThroughChunkedCopy) {
+  constexpr int64_t kNumBytes = 10 * kChunkBytes;
+  for (int64_t fail_at_chunk : {0, 3, 4, 9}) {
+    SCOPED_TRACE(fail_at_chunk);
+    GPUUtil::SetHostToDeviceCopyChunkingForTesting(kChunkBytes, fail_at_chunk);
+    const Tensor cpu_tensor = HostTensor(kNumBytes, /*seed=*/2);
+    Tensor gpu_tensor = GPUTensor(kNumBytes);
+    const Status status = CopyToGPU(cpu_tensor, &gpu_tensor);
+    EXPECT_EQ(status.code(), error::INTERNAL) << status;
+
+    // The device can still be copied to.
+    GPUUtil::SetHostToDeviceCopyChunkingForTesting(kChunkBytes);
+    TF_ASSERT_OK(CopyToGPU(cpu_tensor, &gpu_tensor));
+    test::ExpectTensorEqual<uint8>(CopyToCPU(gpu_tensor), cpu_tensor);
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -63,7 +63,8 @@ GpuVirtualMemAllocator::Create(
     const std::vector<Visitor>& alloc_visitors,
     const std::vector<Visitor>& free_visitors, GpuContext& gpu_context,
     PlatformDeviceId gpu_id, size_t virtual_address_space_size,
-    const std::vector<PlatformDeviceId>& peer_gpu_ids) {
+    const std::vector<PlatformDeviceId>& peer_gpu_ids,
+    bool map_granularity_pages) {
   std::vector<GpuDeviceHandle> access_gpu_handles;
   access_gpu_handles.reserve(peer_gpu_ids.size() + 1);
 
@@ -105,7 +106,8 @@ GpuVirtualMemAllocator::Create(
 
   return std::unique_ptr<GpuVirtualMemAllocator>(new GpuVirtualMemAllocator(
       alloc_visitors, free_visitors, gpu_context, gpu_id,
-      std::move(access_gpu_handles), vmem, max_granularity));
+      std::move(access_gpu_handles), vmem, max_granularity,
+      map_granularity_pages));
 }
 
 GpuVirtualMemAllocator::GpuVirtualMemAllocator(
@@ -113,13 +115,14 @@ GpuVirtualMemAllocator::GpuVirtualMemAllocator(
     const std::vector<Visitor>& free_visitors, GpuContext& gpu_context,
     PlatformDeviceId gpu_id,
     const std::vector<GpuDeviceHandle> access_gpu_handles,
-    GpuDriver::VmemSpan vmem, size_t granularity)
+    GpuDriver::VmemSpan vmem, size_t granularity, bool map_granularity_pages)
     : SubAllocator(alloc_visitors, free_visitors),
       gpu_context_(gpu_context),
       gpu_id_(gpu_id),
       access_gpu_handles_(access_gpu_handles),
       vmem_(vmem),
-      granularity_(granularity) {}
+      granularity_(granularity),
+      map_granularity_pages_(map_granularity_pages) {}
 
 GpuVirtualMemAllocator::~GpuVirtualMemAllocator() {
   for (const auto mapping : mappings_) {
@@ -147,30 +150,71 @@ void* GpuVirtualMemAllocator::Alloc(size_t alignment, size_t num_bytes,
     return nullptr;
   }
 
-  // Create physical memory backing allocation.
-  auto maybe_handle =
-      GpuDriver::CreateMemoryHandle(&gpu_context_, padded_bytes);
-  if (!maybe_handle.ok()) {
-    LOG(ERROR) << maybe_handle.status();
-    return nullptr;
-  }
-  GpuDriver::GenericMemoryHandle handle = std::move(maybe_handle).ValueOrDie();
-
-  // Map VAs for this physical memory.
-  auto status =
-      GpuDriver::MapMemory(&gpu_context_, next_va, handle, access_gpu_handles_);
-  if (!status.ok()) {
-    LOG(ERROR) << status;
-    GpuDriver::ReleaseMemoryHandle(&gpu_context_, std::move(handle));
-    return nullptr;
+  if (map_granularity_pages_) {
+    if (!MapGranularityPages(next_va, padded_bytes)) return nullptr;
+    next_alloc_offset_ += padded_bytes;
+  } else {
+    // Create physical memory backing allocation.
+    auto maybe_handle =
+        GpuDriver::CreateMemoryHandle(&gpu_context_, padded_bytes);
+    if (!maybe_handle.ok()) {
+      LOG(ERROR) << maybe_handle.status();
+      return nullptr;
+    }
+    GpuDriver::GenericMemoryHandle handle =
+        std::move(maybe_handle).ValueOrDie();
+
+    // Map VAs for this physical memory.
+    auto status = GpuDriver::MapMemory(&gpu_context_, next_va, handle,
+                                       access_gpu_handles_);
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      GpuDriver::ReleaseMemoryHandle(&gpu_context_, std::move(handle));
+      return nullptr;
+    }
+    next_alloc_offset_ += handle.bytes;
+    mappings_.push_back({next_va, std::move(handle)});
   }
-  next_alloc_offset_ += handle.bytes;
-  mappings_.push_back({next_va, std::move(handle)});
   VisitAlloc(reinterpret_cast<void*>(next_va), gpu_id_.value(), padded_bytes);
   *bytes_received = padded_bytes;
   return reinterpret_cast<void*>(next_va);
 }
 
+bool GpuVirtualMemAllocator::MapGranularityPages(GpuDevicePtr va,
+                                                 size_t num_bytes) {
+  std::vector<Mapping> new_mappings;
+  new_mappings.reserve(num_bytes / granularity_);
+  for (size_t offset = 0; offset < num_bytes; offset += granularity_) {
+    auto maybe_handle =
+        GpuDriver::CreateMemoryHandle(&gpu_context_, granularity_);
+    Status status = maybe_handle.status();
+    if (status.ok()) {
+      status = GpuDriver::MapMemory(&gpu_context_, va + offset,
+                                    maybe_handle.ValueOrDie(),
+                                    access_gpu_handles_);
+      if (status.ok()) {
+        new_mappings.push_back(
+            {va + offset, std::move(maybe_handle).ValueOrDie()});
+      } else {
+        GpuDriver::ReleaseMemoryHandle(&gpu_context_,
+                                       std::move(maybe_handle).ValueOrDie());
+      }
+    }
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      for (auto& mapping : new_mappings) {
+        GpuDriver::UnmapMemory(&gpu_context_, mapping.va,
+                               mapping.physical.bytes);
+        GpuDriver::ReleaseMemoryHandle(&gpu_context_,
+                                       std::move(mapping.physical));
+      }
+      return false;
+    }
+  }
+  for (auto& mapping : new_mappings) mappings_.push_back(std::move(mapping));
+  return true;
+}
+
 void GpuVirtualMemAllocator::Free(void* ptr, size_t num_bytes) {
   if (ptr == nullptr) return;
 
@@ -187,7 +231,7 @@ void GpuVirtualMemAllocator::Free(void* ptr, size_t num_bytes) {
   }
 
   int num_mappings_to_free = 0;
-  int total_bytes = 0;
+  size_t total_bytes = 0;
   for (auto it = mapping_it; it != mappings_.end() && total_bytes < num_bytes;
        ++it) {
     ++num_mappings_to_free;
@@ -46,7 +46,8 @@ class GpuVirtualMemAllocator : public SubAllocator {
          const std::vector<Visitor>& free_visitors,
          stream_executor::gpu::GpuContext& gpu_context, PlatformDeviceId gpu_id,
          size_t virtual_address_space_size,
-         const std::vector<PlatformDeviceId>& peer_gpu_ids);
+         const std::vector<PlatformDeviceId>& peer_gpu_ids,
+         bool map_granularity_pages = false);
   ~GpuVirtualMemAllocator() override;
 
   // Allocates memory at least as large as requested by num_bytes. Will be
@@ -64,19 +65,31 @@ class GpuVirtualMemAllocator : public SubAllocator {
   // next_alloc_offset_. To accommodate this, the virtual_address_space_size
   // should be much larger than the max physical size of the allocator.
   //
-  // In practice, since the BFC allocator coalesces adjacent AllocationRegions,
-  // this free function should never be invoked.
+  // If the allocator maps granularity pages, any part of an allocation that is
+  // aligned to the min allocation granularity may be freed, which
+  // BFCAllocator::Defragment() uses to return the physical memory behind free
+  // chunks.
   void Free(void* ptr, size_t num_bytes) override;
 
   bool SupportsCoalescing() const override { return true; }
 
+  size_t FreeRangeAlignment() const override {
+    return map_granularity_pages_ ? granularity_ : 0;
+  }
+
  private:
   GpuVirtualMemAllocator(
       const std::vector<Visitor>& alloc_visitors,
       const std::vector<Visitor>& free_visitors,
       stream_executor::gpu::GpuContext& gpu_context, PlatformDeviceId gpu_id,
       std::vector<stream_executor::gpu::GpuDeviceHandle> access_device_handles,
-      stream_executor::gpu::GpuDriver::VmemSpan vmem, size_t granularity);
+      stream_executor::gpu::GpuDriver::VmemSpan vmem, size_t granularity,
+      bool map_granularity_pages);
+
+  // Maps [va, va + num_bytes) to one physical memory handle per page of
+  // granularity_ bytes. Returns false, with nothing mapped, on failure.
+  bool MapGranularityPages(stream_executor::gpu::GpuDevicePtr va,
+                           size_t num_bytes);
 
   stream_executor::gpu::GpuContext& gpu_context_;
   PlatformDeviceId gpu_id_;
@@ -97,6 +110,12 @@ class GpuVirtualMemAllocator : public SubAllocator {
   // Smallest allocation as determined by CUDA.
   const size_t granularity_;
 
+  // Whether each allocation is backed by one physical memory handle per page
+  // of granularity_ bytes rather than by a single handle. This costs one
+  // cuMemCreate and cuMemMap call per page, but allows freeing parts of
+  // allocations.
+  const bool map_granularity_pages_;
+
   struct Mapping {
     stream_executor::gpu::GpuDevicePtr va;
     stream_executor::gpu::GpuDriver::GenericMemoryHandle physical;
@@ -34,7 +34,8 @@ using ::stream_executor::gpu::GpuDriver;
 constexpr size_t k2MiB{2 << 20};
 
 // Creates an allocator with 8 MiB of virtual address space.
-std::unique_ptr<GpuVirtualMemAllocator> CreateAllocator() {
+std::unique_ptr<GpuVirtualMemAllocator> CreateAllocator(
+    bool map_granularity_pages = false) {
   PlatformDeviceId gpu_id(0);
   auto executor =
       DeviceIdUtil::ExecutorForPlatformDeviceId(GPUMachineManager(), gpu_id)
@@ -43,7 +44,8 @@ std::unique_ptr<GpuVirtualMemAllocator> CreateAllocator() {
       executor->implementation()->GpuContextHack());
   return GpuVirtualMemAllocator::Create(
              {}, {}, *gpu_context, gpu_id,
-             /*virtual_address_space_size=*/4 * k2MiB, {})
+             /*virtual_address_space_size=*/4 * k2MiB, {},
+             map_granularity_pages)
       .ValueOrDie();
 }
 
@@ -179,6 +181,32 @@ TEST(GpuVirtualMemAllocatorTest, FreeRange) {
   ASSERT_EQ(re_alloc, first_alloc);
 }
 
+TEST(GpuVirtualMemAllocatorTest, MapsWholeAllocationsByDefault) {
+  auto allocator = CreateAllocator();
+  EXPECT_EQ(allocator->FreeRangeAlignment(), 0);
+}
+
+TEST(GpuVirtualMemAllocatorTest, FreePartOfAllocation) {
+  auto allocator = CreateAllocator(/*map_granularity_pages=*/true);
+  ASSERT_EQ(allocator->FreeRangeAlignment(), k2MiB);
+  size_t bytes_received;  // Ignored in this test.
+  void* alloc = allocator->Alloc(/*alignment=*/0, /*num_bytes=*/3 * k2MiB,
+                                 &bytes_received);
+  ASSERT_NE(alloc, nullptr);
+
+  char* middle = reinterpret_cast<char*>(alloc) + k2MiB;
+  allocator->Free(middle, k2MiB);
+
+  void* next_alloc =
+      allocator->Alloc(/*alignment=*/0, /*num_bytes=*/k2MiB, &bytes_received);
+  ASSERT_NE(next_alloc, nullptr);
+  ASSERT_EQ(next_alloc, reinterpret_cast<char*>(alloc) + 3 * k2MiB);
+
+  // The remaining parts of the allocation may be freed separately.
+  allocator->Free(alloc, k2MiB);
+  allocator->Free(middle + k2MiB, 2 * k2MiB);
+}
+
 }  // namespace
 }  // namespace tensorflow
 
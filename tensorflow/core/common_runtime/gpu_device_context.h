@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 
+#include <utility>
+
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
@@ -59,6 +61,15 @@ class GPUDeviceContext : public DeviceContext {
   }
   int stream_id() const { return stream_id_; }
 
+  // The other compute streams that stream() waits for before an op runs with
+  // this context, when the device has several compute streams.
+  const gtl::InlinedVector<se::Stream*, 4>& wait_streams() const {
+    return wait_streams_;
+  }
+  void set_wait_streams(gtl::InlinedVector<se::Stream*, 4> wait_streams) {
+    wait_streams_ = std::move(wait_streams);
+  }
+
   void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
                              Tensor* device_tensor, StatusCallback done,
                              bool sync_dst_compute) const override;
@@ -92,6 +103,7 @@ class GPUDeviceContext : public DeviceContext {
   se::Stream* device_to_host_stream_;
   // Streams to use for copying data between GPUs.
   gtl::InlinedVector<se::Stream*, 4> device_to_device_stream_;
+  gtl::InlinedVector<se::Stream*, 4> wait_streams_;
 };
 
 }  // namespace tensorflow
@@ -44,9 +44,12 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/scanner.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
@@ -88,6 +91,10 @@ bool IsValidNodeName(StringPiece s, bool allow_internal_ops) {
   }
 }
 
+// Graphs with at least this many nodes are converted with the help of a
+// thread pool, which is not worth starting for smaller graphs.
+constexpr int kMinNodesForParallelPreparation = 8192;
+
 class GraphConstructor {
  public:
   struct Options {
@@ -227,6 +234,12 @@ class GraphConstructor {
   Status IsNodeFullyMapped(const NodeDef& node_def, bool* is_node_mapped);
   Status ValidateColocationConstraints(const NodeDef& node_def);
   Status MakeNode(NodeDef&& node_def, Node** node);
+  // Validates `node_def` and prepares it for addition to g_, without
+  // modifying g_. Only used when not importing.
+  Status PrepareNode(NodeDef node_def, Graph::PreparedNode* prepared);
+  // Calls PrepareNode() on all nodes of a large graph in parallel, and stores
+  // the results in `prepared_nodes_`.
+  Status PrepareNodesInParallel();
   Status MakeEdge(Node* src, int output_index, Node* dst, int input_index);
   Status ValidateShape(Node* node);
   Status ModifyNodeDefForImport(NodeDef* node_def);
@@ -281,7 +294,7 @@ class GraphConstructor {
   virtual const NodeDef& get_node_def(int i) const = 0;
   // Destructively reads the i^th node in the graph, avoiding a copy if
   // possible. After calling this method, the result of get_node_def(i) is
-  // undefined.
+  // undefined. May be called concurrently for different nodes.
   virtual NodeDef consume_node_def(int i) = 0;
   // Returns the version information for the graph, or nullptr if none is
   // available.
@@ -385,6 +398,10 @@ class GraphConstructor {
   };
   std::vector<EdgeInfo> back_edges_;
 
+  // If not empty, the nodes prepared by PrepareNodesInParallel(), indexed by
+  // their index within node_defs_.
+  std::vector<Graph::PreparedNode> prepared_nodes_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GraphConstructor);
 };
 
@@ -431,7 +448,7 @@ class NodeDefMovingGraphConstructor : public GraphConstructor {
       : GraphConstructor(opts, g, refiner, return_tensors, return_nodes,
                          missing_unused_input_map_keys),
         graph_def_(std::move(graph_def)),
-        is_consumed_(graph_def_.node_size(), false) {}
+        is_consumed_(new bool[graph_def_.node_size()]()) {}
 
  private:
   size_t node_def_count() const override { return graph_def_.node().size(); }
@@ -451,7 +468,9 @@ class NodeDefMovingGraphConstructor : public GraphConstructor {
   }
 
   GraphDef graph_def_;
-  std::vector<bool> is_consumed_;
+  // Not a std::vector<bool>, so that different nodes may be consumed
+  // concurrently.
+  std::unique_ptr<bool[]> is_consumed_;
 };
 
 bool ForwardCompatibilityWindowPassed(const VersionDef& versions) {
@@ -777,6 +796,47 @@ Status GraphConstructor::MakeNode(NodeDef&& node_def, Node** node) {
   return Status::OK();
 }
 
+Status GraphConstructor::PrepareNode(NodeDef node_def,
+                                     Graph::PreparedNode* prepared) {
+  DCHECK(!opts_.importing);
+  const OpDef* op_def;
+  TF_RETURN_IF_ERROR(g_->op_registry()->LookUpOpDef(node_def.op(), &op_def));
+  if (opts_.add_default_attributes) {
+    AddDefaultsToNodeDef(*op_def, &node_def);
+  }
+  if (opts_.validate_nodes) {
+    TF_RETURN_IF_ERROR(ValidateNodeDef(node_def, *op_def));
+  }
+  return g_->PrepareNode(std::move(node_def), prepared);
+}
+
+Status GraphConstructor::PrepareNodesInParallel() {
+  const int num_nodes = node_def_count();
+  std::vector<Graph::PreparedNode> prepared_nodes(num_nodes);
+  std::vector<Status> statuses(num_nodes);
+  {
+    thread::ThreadPool pool(Env::Default(), "graph_constructor",
+                            port::MaxParallelism());
+    // The op lookups, attr validation and type inference of a node take a
+    // few microseconds.
+    pool.ParallelFor(num_nodes, /*cost_per_unit=*/10000,
+                     [this, &prepared_nodes, &statuses](int64_t begin,
+                                                        int64_t end) {
+                       for (int64_t i = begin; i < end; ++i) {
+                         statuses[i] = PrepareNode(consume_node_def(i),
+                                                   &prepared_nodes[i]);
+                       }
+                     });
+  }
+  // Report the error of the first invalid node, as the sequential conversion
+  // of a graph in topological order would for most graphs.
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  prepared_nodes_ = std::move(prepared_nodes);
+  return Status::OK();
+}
+
 Status GraphConstructor::ValidateShape(Node* node) {
   if (!opts_.importing || !opts_.validate_shape) return Status::OK();
   TF_RETURN_IF_ERROR(refiner_->AddNode(node));
@@ -1108,6 +1168,14 @@ Status GraphConstructor::Convert() {
     TF_RETURN_IF_ERROR(g_->AddFunctionLibrary(*library()));
   }
 
+  // Preparing a node does not depend on the other nodes unless they are being
+  // imported into an existing graph, so the nodes of a large graph are
+  // prepared in parallel.
+  if (!opts_.importing &&
+      node_def_count() >= kMinNodesForParallelPreparation) {
+    TF_RETURN_IF_ERROR(PrepareNodesInParallel());
+  }
+
   std::vector<InputInfo> inputs;
   int processed = 0;
 
@@ -1124,7 +1192,11 @@ Status GraphConstructor::Convert() {
     inputs.clear();
     bool has_data_back_edge = false;
 
-    NodeDef node_def = consume_node_def(o);
+    NodeDef consumed_node_def;
+    if (prepared_nodes_.empty()) consumed_node_def = consume_node_def(o);
+    NodeDef& node_def = prepared_nodes_.empty()
+                            ? consumed_node_def
+                            : prepared_nodes_[o].props->node_def;
 
     // input_already_exists[i] is true iff the i-th input of the node we're
     // importing refers to a preexisting node in g_ (i.e. input[i] existed prior
@@ -1218,8 +1290,14 @@ Status GraphConstructor::Convert() {
       }
     }
 
-    if (opts_.importing) {
+    if (!prepared_nodes_.empty()) {
+      node = g_->AddPreparedNode(std::move(prepared_nodes_[o]));
+      if (opts_.expect_device_spec) {
+        node->set_assigned_device_name(node->def().device());
+      }
+    } else if (opts_.importing) {
       TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&node_def));
+      TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
     } else {
       const OpDef* op_def;
       TF_RETURN_IF_ERROR(
@@ -1230,10 +1308,9 @@ Status GraphConstructor::Convert() {
       if (opts_.validate_nodes) {
         TF_RETURN_IF_ERROR(ValidateNodeDef(node_def, *op_def));
       }
+      TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
     }
 
-    TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
-
     gdef_nodes_[node_name].node = node;
 
     // Remove duplicate control inputs before adding edges to the graph. It
@@ -1269,7 +1346,10 @@ Status GraphConstructor::Convert() {
                  << " NODES IN A CYCLE";
     for (int64_t i = 0; i < node_def_count(); i++) {
       if (pending_count_[i] != 0) {
-        LOG(WARNING) << "PENDING: " << SummarizeNodeDef(get_node_def(i))
+        const NodeDef& node_def = prepared_nodes_.empty()
+                                      ? get_node_def(i)
+                                      : prepared_nodes_[i].props->node_def;
+        LOG(WARNING) << "PENDING: " << SummarizeNodeDef(node_def)
                      << " WITH PENDING COUNT = " << pending_count_[i];
       }
     }
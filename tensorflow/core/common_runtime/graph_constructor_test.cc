@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/version.h"
 
@@ -3258,5 +3259,64 @@ TEST_F(GraphConstructorTest, ImportGraphDef_UnknownOps) {
        "when the module is first accessed."});
 }
 
+
+// Returns a chain of `num_nodes` TestMul nodes fed by a single TestInput.
+GraphDef MakeChainGraphDef(int num_nodes) {
+  GraphDef gdef;
+  NodeDef* input = gdef.add_node();
+  input->set_name("input");
+  input->set_op("TestInput");
+  string prev = "input:0";
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = gdef.add_node();
+    node->set_name(strings::StrCat("mul", i));
+    node->set_op("TestMul");
+    node->add_input(prev);
+    node->add_input("input:1");
+    prev = node->name();
+  }
+  return gdef;
+}
+
+TEST_F(GraphConstructorTest, ConvertLargeGraphDef) {
+  // Large enough for the nodes to be prepared in parallel.
+  const int kNumNodes = 10000;
+  TF_ASSERT_OK(ConvertGraphDefToGraph(GraphConstructorOptions(),
+                                      MakeChainGraphDef(kNumNodes), &graph_));
+  EXPECT_EQ(graph_.num_op_nodes(), kNumNodes + 1);
+  EXPECT_TRUE(HasEdge("input", 0, "mul0", 0));
+  for (int i = 0; i < kNumNodes; ++i) {
+    const string name = strings::StrCat("mul", i);
+    ASSERT_TRUE(HasNode(name)) << name;
+    EXPECT_TRUE(HasEdge("input", 1, name, 1)) << name;
+    if (i > 0) {
+      EXPECT_TRUE(HasEdge(strings::StrCat("mul", i - 1), 0, name, 0)) << name;
+    }
+  }
+}
+
+TEST_F(GraphConstructorTest, ConvertLargeGraphDef_ReportsFirstError) {
+  GraphDef gdef = MakeChainGraphDef(10000);
+  gdef.mutable_node(5000)->set_op("UnknownOpA");
+  gdef.mutable_node(9000)->set_op("UnknownOpB");
+  Status s =
+      ConvertGraphDefToGraph(GraphConstructorOptions(), std::move(gdef),
+                             &graph_);
+  EXPECT_FALSE(s.ok());
+  EXPECT_TRUE(str_util::StrContains(s.error_message(), "UnknownOpA")) << s;
+}
+
+void BM_ConvertGraphDefToGraph(::testing::benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  const GraphDef gdef = MakeChainGraphDef(num_nodes);
+  for (auto s : state) {
+    Graph graph(OpRegistry::Global());
+    TF_CHECK_OK(
+        ConvertGraphDefToGraph(GraphConstructorOptions(), gdef, &graph));
+  }
+  state.SetItemsProcessed(state.iterations() * num_nodes);
+}
+BENCHMARK(BM_ConvertGraphDefToGraph)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 17);
+
 }  // namespace
 }  // namespace tensorflow
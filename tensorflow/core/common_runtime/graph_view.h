@@ -30,6 +30,7 @@ limitations under the License.
 namespace tensorflow {
 
 class Device;
+class DeviceContext;
 class Graph;
 class Node;
 class OpKernel;
@@ -92,6 +93,10 @@ struct NodeItem {
   // If the kernel is a Const op, this containts points to the constant tensor.
   const Tensor* const_tensor = nullptr;
 
+  // If non-null, the device context to execute this node with instead of the
+  // one of the device. Owned by the device.
+  DeviceContext* device_context = nullptr;
+
   // Cached values of node->num_inputs() and node->num_outputs(), to
   // avoid levels of indirection.
   int num_inputs;
@@ -0,0 +1,417 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_reducer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+namespace {
+
+// The phases of the algorithm, which keep the buffer keys of their transfers
+// apart.
+enum Phase {
+  kLocalReduceScatter = 0,
+  kRemoteReduceScatter = 1,
+  kRemoteAllGather = 2,
+  kLocalAllGather = 3,
+};
+
+// Tracks the transfers of one step of a phase, which run concurrently.
+class PendingTransfers {
+ public:
+  explicit PendingTransfers(std::function<void(const Status&)> abort)
+      : abort_(std::move(abort)) {}
+
+  // Returns the callback of a new transfer.
+  StatusCallback Add() {
+    {
+      mutex_lock l(mu_);
+      ++num_pending_;
+    }
+    return [this](const Status& s) {
+      if (!s.ok()) abort_(s);
+      mutex_lock l(mu_);
+      status_.Update(s);
+      if (--num_pending_ == 0) cv_.notify_all();
+    };
+  }
+
+  // Blocks until all transfers are done, and returns their status.
+  Status Wait() {
+    mutex_lock l(mu_);
+    while (num_pending_ > 0) cv_.wait(l);
+    return status_;
+  }
+
+ private:
+  const std::function<void(const Status&)> abort_;
+  mutex mu_;
+  condition_variable cv_;
+  int num_pending_ TF_GUARDED_BY(mu_) = 0;
+  Status status_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+HierarchicalReducer::HierarchicalReducer()
+    : col_ctx_(nullptr), col_params_(nullptr), task_idx_(0), local_idx_(0) {}
+
+Status HierarchicalReducer::GroupRanksByTask(
+    const CollGroupParams& group, std::vector<std::vector<int>>* task_ranks) {
+  task_ranks->clear();
+  std::vector<string> tasks;
+  for (int rank = 0; rank < group.members.size(); ++rank) {
+    const string& task = group.members[rank].task;
+    auto it = std::find(tasks.begin(), tasks.end(), task);
+    if (it == tasks.end()) {
+      tasks.push_back(task);
+      task_ranks->emplace_back();
+      it = tasks.end() - 1;
+    }
+    (*task_ranks)[it - tasks.begin()].push_back(rank);
+  }
+  for (int t = 1; t < task_ranks->size(); ++t) {
+    if ((*task_ranks)[t].size() != (*task_ranks)[0].size()) {
+      return errors::InvalidArgument(
+          "HierarchicalReduce requires the same number of devices on every "
+          "task, but task ",
+          tasks[0], " has ", (*task_ranks)[0].size(), " and task ", tasks[t],
+          " has ", (*task_ranks)[t].size());
+    }
+  }
+  return Status::OK();
+}
+
+Status HierarchicalReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  if (col_params->instance.type != REDUCTION_COLLECTIVE) {
+    return errors::Internal("HierarchicalReduce expects a reduction, got ",
+                            col_params->instance.type);
+  }
+  std::vector<std::vector<int>> task_ranks;
+  return GroupRanksByTask(col_params->group, &task_ranks);
+}
+
+Status HierarchicalReducer::InitializeCollectiveContext(
+    std::shared_ptr<CollectiveContext> col_ctx) {
+  DCHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = col_ctx->col_params.get();
+  TF_RETURN_IF_ERROR(GroupRanksByTask(col_params_->group, &task_ranks_));
+  for (int t = 0; t < task_ranks_.size(); ++t) {
+    for (int l = 0; l < task_ranks_[t].size(); ++l) {
+      if (task_ranks_[t][l] == col_params_->default_rank) {
+        task_idx_ = t;
+        local_idx_ = l;
+      }
+    }
+  }
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void HierarchicalReducer::StartAbort(const Status& s) {
+  {
+    mutex_lock l(status_mu_);
+    if (!status_.ok()) return;
+    LOG(ERROR) << "Aborting HierarchicalReduce with " << s;
+    status_.Update(s);
+  }
+  // Cancellation cancels the pending transfers already.
+  CancellationManager* cancel_mgr = col_ctx_->op_ctx->cancellation_manager();
+  if (cancel_mgr == nullptr ||
+      (!cancel_mgr->IsCancelled() && !cancel_mgr->IsCancelling())) {
+    col_ctx_->col_exec->StartAbort(s);
+  }
+}
+
+void HierarchicalReducer::DispatchSend(int phase, int chunk_idx, int peer_rank,
+                                       const Tensor* tensor,
+                                       const StatusCallback& done) {
+  const string send_buf_key =
+      strings::StrCat(col_ctx_->exec_key, ":", phase, ":", chunk_idx, ":",
+                      col_params_->default_rank, ":", peer_rank);
+  VLOG(3) << "DispatchSend rank=" << col_params_->default_rank << " send key "
+          << send_buf_key << " chunk " << ca_->TBounds(*tensor);
+  col_ctx_->col_exec->remote_access()->PostToPeer(
+      col_params_->group.members[peer_rank].device.name(),
+      col_params_->group.members[peer_rank].task, send_buf_key,
+      col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), tensor, col_ctx_->device_locality,
+      col_ctx_->op_ctx->cancellation_manager(), done);
+}
+
+void HierarchicalReducer::DispatchRecv(int phase, int chunk_idx, int peer_rank,
+                                       Tensor* tensor,
+                                       const StatusCallback& done) {
+  const string recv_buf_key =
+      strings::StrCat(col_ctx_->exec_key, ":", phase, ":", chunk_idx, ":",
+                      peer_rank, ":", col_params_->default_rank);
+  VLOG(3) << "DispatchRecv rank=" << col_params_->default_rank << " recv key "
+          << recv_buf_key;
+  col_ctx_->col_exec->remote_access()->RecvFromPeer(
+      col_params_->group.members[peer_rank].device.name(),
+      col_params_->group.members[peer_rank].task,
+      col_params_->group.members[peer_rank].is_local, recv_buf_key,
+      col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), tensor,
+      col_ctx_->device_locality, 0 /*dev_to_dev_stream_index*/,
+      col_ctx_->op_ctx->cancellation_manager(), done);
+}
+
+Status HierarchicalReducer::Reduce(Tensor* chunk, Tensor* tmp) {
+  return collective_util::ComputeBinOp(col_ctx_->op_ctx, col_ctx_->op_params,
+                                       col_ctx_->device, col_params_->merge_op,
+                                       chunk, tmp);
+}
+
+Status HierarchicalReducer::Finalize(Tensor* chunk) {
+  if (col_params_->final_op == nullptr) return Status::OK();
+  return collective_util::ComputeBinOp(col_ctx_->op_ctx, col_ctx_->op_params,
+                                       col_ctx_->device, col_params_->final_op,
+                                       chunk, &group_size_tensor_);
+}
+
+void HierarchicalReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  // Like `RingReducer`, this doesn't require non-overlapping collectives.
+  col_ctx_->col_exec->UnblockDependencies(*col_params_);
+
+  // Start by copying input to output if they're not already the same, i.e. if
+  // we're not computing in-place on the input tensor.
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    Notification note;
+    Status status;
+    profiler::TraceMe activity("MemCpyAsync", profiler::TraceMeLevel::kInfo);
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+    if (!status.ok()) {
+      done(status);
+      return;
+    }
+  }
+
+  Status s = RunPhases();
+  {
+    mutex_lock l(status_mu_);
+    status_.Update(s);
+    s = status_;
+  }
+  if (s.ok()) ca_->ConsumeFinalValue(col_ctx_->output);
+  ca_.reset();
+  done(s);
+}
+
+Status HierarchicalReducer::RunPhases() {
+  const int num_tasks = task_ranks_.size();
+  const int num_local = task_ranks_[task_idx_].size();
+  const std::vector<int>& local_ranks = task_ranks_[task_idx_];
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  ca_.reset(MakeCollectiveAdapter(col_ctx_->output, num_local * num_tasks,
+                                  col_ctx_->device->GetAllocator(attr)));
+  // The chunks of shard `l` are those of `l * num_tasks` and up. Empty tail
+  // chunks are skipped on both sides.
+  auto chunk_idx = [num_tasks](int shard, int sub) {
+    return shard * num_tasks + sub;
+  };
+  auto is_empty = [this](int c) { return ca_->ChunkBytes(c) == 0; };
+
+  if (col_params_->final_op) {
+    Tensor group_size_val = ca_->Scalar(col_params_->group.group_size);
+    if (col_params_->group.device_type != DEVICE_CPU) {
+      group_size_tensor_ = ca_->Scalar(
+          col_ctx_->device->GetAllocator(col_ctx_->op_ctx->input_alloc_attr(0)),
+          AllocationAttributes());
+      Notification note;
+      Status status;
+      col_ctx_->op_ctx->op_device_context()->CopyCPUTensorToDevice(
+          &group_size_val, col_ctx_->device, &group_size_tensor_,
+          [&note, &status](const Status& s) {
+            status = s;
+            note.Notify();
+          });
+      note.WaitForNotification();
+      TF_RETURN_IF_ERROR(status);
+    } else {
+      group_size_tensor_ = group_size_val;
+    }
+  }
+
+  // Temporaries for the shard of this device from each other local device.
+  std::vector<Tensor> local_tmps(num_local * num_tasks);
+  for (int l = 0; l < num_local; ++l) {
+    if (l == local_idx_) continue;
+    for (int t = 0; t < num_tasks; ++t) {
+      local_tmps[chunk_idx(l, t)] = ca_->TempChunk(chunk_idx(local_idx_, t));
+    }
+  }
+  std::vector<Tensor> remote_tmps(num_tasks);
+  for (int t = 0; t < num_tasks; ++t) {
+    remote_tmps[t] = ca_->TempChunk(chunk_idx(local_idx_, t));
+  }
+  const DeviceBase::GpuDeviceInfo* gpu_info =
+      col_ctx_->device->tensorflow_gpu_device_info();
+  if (gpu_info) {
+    // As in `RingReducer`, the temporaries are not guaranteed to be valid
+    // until the queued events on the compute stream complete.
+    Notification note;
+    TF_RETURN_IF_ERROR(gpu_info->default_context->ThenExecute(
+        col_ctx_->device, gpu_info->stream, [&note]() { note.Notify(); }));
+    note.WaitForNotification();
+  }
+  auto abort = [this](const Status& s) { StartAbort(s); };
+
+  // 1. Reduce-scatter within the task: send shard `l` to the l-th device and
+  // reduce the shard of this device from the others.
+  {
+    profiler::TraceMe activity("LocalReduceScatter",
+                               profiler::TraceMeLevel::kInfo);
+    std::vector<Tensor> chunks(num_local * num_tasks);
+    PendingTransfers pending(abort);
+    for (int l = 0; l < num_local; ++l) {
+      if (l == local_idx_) continue;
+      for (int t = 0; t < num_tasks; ++t) {
+        const int c = chunk_idx(l, t);
+        if (is_empty(c)) continue;
+        chunks[c] = ca_->ChunkAlias(c);
+        DispatchSend(kLocalReduceScatter, c, local_ranks[l], &chunks[c],
+                     pending.Add());
+        const int own_c = chunk_idx(local_idx_, t);
+        if (is_empty(own_c)) continue;
+        DispatchRecv(kLocalReduceScatter, own_c, local_ranks[l],
+                     &local_tmps[c], pending.Add());
+      }
+    }
+    TF_RETURN_IF_ERROR(pending.Wait());
+    for (int t = 0; t < num_tasks; ++t) {
+      const int own_c = chunk_idx(local_idx_, t);
+      if (is_empty(own_c)) continue;
+      Tensor chunk = ca_->ChunkAlias(own_c);
+      for (int l = 0; l < num_local; ++l) {
+        if (l == local_idx_) continue;
+        TF_RETURN_IF_ERROR(Reduce(&chunk, &local_tmps[chunk_idx(l, t)]));
+      }
+    }
+  }
+
+  // 2. All-reduce the shard of this device over the ring of the devices with
+  // the same local index on every task. After the reduce-scatter steps, this
+  // device holds the chunk `(task_idx_ + 1) % num_tasks` of the shard.
+  const int next_rank = task_ranks_[(task_idx_ + 1) % num_tasks][local_idx_];
+  const int prev_rank =
+      task_ranks_[(task_idx_ + num_tasks - 1) % num_tasks][local_idx_];
+  for (int phase : {kRemoteReduceScatter, kRemoteAllGather}) {
+    profiler::TraceMe activity(
+        phase == kRemoteReduceScatter ? "RemoteReduceScatter"
+                                      : "RemoteAllGather",
+        profiler::TraceMeLevel::kInfo);
+    // The all-gather starts with the chunk that the reduce-scatter completed.
+    const int first_sub = phase == kRemoteReduceScatter ? task_idx_
+                                                        : task_idx_ + 1;
+    for (int step = 0; step < num_tasks - 1; ++step) {
+      const int send_c =
+          chunk_idx(local_idx_, (first_sub - step + num_tasks) % num_tasks);
+      const int recv_sub = (first_sub - step - 1 + 2 * num_tasks) % num_tasks;
+      const int recv_c = chunk_idx(local_idx_, recv_sub);
+      Tensor send_chunk = ca_->ChunkAlias(send_c);
+      Tensor recv_chunk = ca_->ChunkAlias(recv_c);
+      Tensor* recv_into = phase == kRemoteReduceScatter ? &remote_tmps[recv_sub]
+                                                        : &recv_chunk;
+      PendingTransfers pending(abort);
+      if (!is_empty(send_c)) {
+        DispatchSend(phase, send_c, next_rank, &send_chunk, pending.Add());
+      }
+      if (!is_empty(recv_c)) {
+        DispatchRecv(phase, recv_c, prev_rank, recv_into, pending.Add());
+      }
+      TF_RETURN_IF_ERROR(pending.Wait());
+      if (phase == kRemoteReduceScatter && !is_empty(recv_c)) {
+        TF_RETURN_IF_ERROR(Reduce(&recv_chunk, recv_into));
+      }
+    }
+    if (phase == kRemoteReduceScatter) {
+      const int final_c = chunk_idx(local_idx_, (task_idx_ + 1) % num_tasks);
+      if (!is_empty(final_c)) {
+        Tensor final_chunk = ca_->ChunkAlias(final_c);
+        TF_RETURN_IF_ERROR(Finalize(&final_chunk));
+      }
+    }
+  }
+
+  // 3. All-gather within the task: send the shard of this device to every
+  // other local device and receive theirs.
+  {
+    profiler::TraceMe activity("LocalAllGather",
+                               profiler::TraceMeLevel::kInfo);
+    std::vector<Tensor> chunks(num_local * num_tasks);
+    PendingTransfers pending(abort);
+    for (int t = 0; t < num_tasks; ++t) {
+      const int own_c = chunk_idx(local_idx_, t);
+      if (!is_empty(own_c)) chunks[own_c] = ca_->ChunkAlias(own_c);
+    }
+    for (int l = 0; l < num_local; ++l) {
+      if (l == local_idx_) continue;
+      for (int t = 0; t < num_tasks; ++t) {
+        const int own_c = chunk_idx(local_idx_, t);
+        if (!is_empty(own_c)) {
+          DispatchSend(kLocalAllGather, own_c, local_ranks[l], &chunks[own_c],
+                       pending.Add());
+        }
+        const int c = chunk_idx(l, t);
+        if (is_empty(c)) continue;
+        chunks[c] = ca_->ChunkAlias(c);
+        DispatchRecv(kLocalAllGather, c, local_ranks[l], &chunks[c],
+                     pending.Add());
+      }
+    }
+    TF_RETURN_IF_ERROR(pending.Wait());
+  }
+  return Status::OK();
+}
+
+namespace {
+REGISTER_COLLECTIVE(HierarchicalReduce, HierarchicalReducer);
+}  // namespace
+
+}  // namespace tensorflow
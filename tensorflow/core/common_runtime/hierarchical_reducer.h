@@ -0,0 +1,98 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+
+namespace tensorflow {
+class Device;
+
+// Topology-aware implementation of collective all-reduce, for groups whose
+// devices are spread over several tasks with fast links between the devices
+// of a task and slower links between tasks.
+//
+// With T tasks of L devices each, the tensor is cut into L shards of T
+// chunks, and the reduction runs in three phases:
+// 1. Within each task, the devices reduce-scatter the shards, so that the
+//    l-th device of the task holds the sum of its shard over the task.
+// 2. The l-th devices of all tasks all-reduce their shard over a ring, so
+//    only 2 * (T - 1) / (T * L) of the tensor leaves each device through the
+//    inter-task links.
+// 3. Within each task, the devices all-gather the shards.
+//
+// Every task must have the same number of devices in the group. Selected by
+// the "hierarchical" communication hint.
+class HierarchicalReducer : public CollectiveImplementationInterface {
+ public:
+  HierarchicalReducer();
+  ~HierarchicalReducer() override = default;
+
+  // Checks that every task has the same number of devices in the group.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  Status InitializeCollectiveContext(
+      std::shared_ptr<CollectiveContext> col_ctx) override;
+
+  // Begins async execution of the hierarchical reduce algorithm.
+  // Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+ private:
+  // Ranks of the group members, grouped by task in the order of their first
+  // member. Fails unless all tasks have the same number of members.
+  static Status GroupRanksByTask(const CollGroupParams& group,
+                                 std::vector<std::vector<int>>* task_ranks);
+
+  // Runs the three phases and returns their status.
+  Status RunPhases();
+
+  // Sends `chunk_idx` to, or receives it from, the member `peer_rank` in
+  // `phase`. Receives into `tensor`.
+  void DispatchSend(int phase, int chunk_idx, int peer_rank,
+                    const Tensor* tensor, const StatusCallback& done);
+  void DispatchRecv(int phase, int chunk_idx, int peer_rank, Tensor* tensor,
+                    const StatusCallback& done);
+
+  // Aborts the outstanding transfers of the collective on the first error.
+  void StartAbort(const Status& s);
+
+  // Reduces `tmp` into `chunk` with the merge op.
+  Status Reduce(Tensor* chunk, Tensor* tmp);
+
+  // Applies the final op to `chunk`, if any.
+  Status Finalize(Tensor* chunk);
+
+  std::shared_ptr<CollectiveContext> col_ctx_;
+  const CollectiveParams* col_params_;  // Not owned
+  std::unique_ptr<CollectiveAdapter> ca_;
+  std::vector<std::vector<int>> task_ranks_;
+  int task_idx_;
+  int local_idx_;
+  Tensor group_size_tensor_;
+  mutex status_mu_;
+  Status status_ TF_GUARDED_BY(status_mu_);
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
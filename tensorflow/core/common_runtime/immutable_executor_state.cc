@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/immutable_executor_state.h"
 
 #include "absl/memory/memory.h"
+#include "tensorflow/core/framework/device.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -96,6 +97,15 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
 
   pending_ids_.resize(gview_.num_nodes());
 
+  const bool is_cpu_device =
+      params_.device != nullptr && params_.device->device_type() == DEVICE_CPU;
+
+  std::vector<DeviceContext*> device_contexts;
+  if (params_.device != nullptr) {
+    TF_RETURN_IF_ERROR(
+        params_.device->AssignDeviceContexts(graph, &device_contexts));
+  }
+
   // Preprocess every node in the graph to create an instance of op
   // kernel for each node.
   requires_control_flow_ = false;
@@ -154,6 +164,7 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
       const_tensors_.emplace_back(*const_tensor);
     }
     item->const_tensor = const_tensor;
+    if (!device_contexts.empty()) item->device_context = device_contexts[id];
     item->is_noop = (item->kernel->type_string_view() == "NoOp");
     item->is_enter = IsEnter(n);
     if (item->is_enter) {
@@ -240,6 +251,32 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
       }
       item->outputs_required = std::move(outputs_required);
     }
+
+    // Record which outputs of a root-frame node are returned directly by a
+    // `_Retval` node, so that the kernel may write them into buffers provided
+    // by the caller.
+    if (is_cpu_device && frame_name.empty()) {
+      for (const Edge* e : n->out_edges()) {
+        if (e->IsControlEdge() || !e->dst()->IsRetval() ||
+            IsRefType(n->output_type(e->src_output()))) {
+          continue;
+        }
+        int retval_index;
+        TF_RETURN_IF_ERROR(
+            GetNodeAttr(e->dst()->attrs(), "index", &retval_index));
+        if (output_retval_indices_.size() <= id) {
+          output_retval_indices_.resize(id + 1);
+        }
+        std::unique_ptr<int[]>& indices = output_retval_indices_[id];
+        if (indices == nullptr) {
+          indices.reset(new int[n->num_outputs()]);
+          std::fill(&indices[0], &indices[n->num_outputs()], -1);
+        }
+        if (indices[e->src_output()] < 0) {
+          indices[e->src_output()] = retval_index;
+        }
+      }
+    }
   }
 
   // Rewrite each `EdgeInfo::input_slot` member to refer directly to the input
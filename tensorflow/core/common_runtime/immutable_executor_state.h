@@ -101,6 +101,16 @@ class ImmutableExecutorState {
 
   bool requires_control_flow_support() const { return requires_control_flow_; }
 
+  // Returns an array indexed by output number of `node_item`, holding the
+  // index of the `_Retval` node that consumes each output directly, or -1.
+  // Returns nullptr if no output of `node_item` is consumed by a `_Retval`
+  // node, or if the graph is not placed on a CPU device.
+  const int* output_retval_indices(const NodeItem& node_item) const {
+    return node_item.node_id < output_retval_indices_.size()
+               ? output_retval_indices_[node_item.node_id].get()
+               : nullptr;
+  }
+
   // Copies the pending counts for nodes in this graph to the given array.
   //
   // This method provides a more efficient way of initializing
@@ -155,6 +165,9 @@ class ImmutableExecutorState {
   // Shallow copies of the constant tensors used in the graph.
   std::vector<Tensor> const_tensors_;
 
+  // Maps dense node IDs to the array returned by `output_retval_indices()`.
+  std::vector<std::unique_ptr<int[]>> output_retval_indices_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ImmutableExecutorState);
 };
 
@@ -22,6 +22,7 @@ limitations under the License.
 #include "absl/strings/str_join.h"
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/common_runtime/function_instantiation_cache.h"
 #include "tensorflow/core/common_runtime/function_optimization_registry.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
@@ -706,101 +707,16 @@ Status GetGraphAndArgRets(
   return Status::OK();
 }
 
-Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
-    const string& function_name, AttrSlice attrs,
+Status ProcessFunctionLibraryRuntime::OptimizeAndPartitionMultiDeviceFunction(
+    const string& function_name, const FunctionDef* fdef,
+    const FunctionLibraryDefinition* lib_def,
     const FunctionLibraryRuntime::InstantiateOptions& options,
-    FunctionLibraryRuntime::Handle* handle) {
-  // Check if this function has already been instantiated.
-  const string& function_key = Canonicalize(function_name, attrs, options);
-
-  {
-    mutex_lock l(mu_);
-    const auto& it = table_.find(function_key);
-    if (it != table_.end()) {
-      *handle = it->second;
-      ++mdevice_data_[*handle]->instantiation_counter_;
-      return Status::OK();
-    }
-  }
-
-  VLOG(1) << "Instantiating MultiDevice function \"" << function_name
-          << "\" on default device \"" << options.target << "\"";
-  if (VLOG_IS_ON(3)) {
-    int index = 0;
-    VLOG(3) << "Requested input devices:";
-    for (const string& device : options.input_devices) {
-      VLOG(3) << "    [input " << index++ << "] " << device;
-    }
-    index = 0;
-    VLOG(3) << "Requested output devices:";
-    for (const string& device : options.output_devices) {
-      VLOG(3) << "    [output " << index++ << "] " << device;
-    }
-  }
-
-  const FunctionLibraryDefinition* lib_def =
-      options.lib_def == nullptr ? lib_def_ : options.lib_def;
-
-  const FunctionDef* fdef = lib_def->Find(function_name);
-  if (fdef == nullptr) {
-    return errors::InvalidArgument("Failed to find function \"", function_name,
-                                   "\" in function library: ", lib_def);
-  }
-
-  TF_RETURN_IF_ERROR(ValidateMultiDeviceOptions(*fdef, options));
-
-  std::unique_ptr<Graph> graph;
-  std::vector<Node*> arg_nodes, ret_nodes;
-  std::vector<string> ret_node_names;
-  DataTypeVector ret_types;
-  std::vector<string> control_ret_node_names;
-
-  TF_RETURN_IF_ERROR(GetGraphAndArgRets(
-      function_name, attrs, fdef, lib_def, &graph, &arg_nodes, &ret_nodes,
-      &ret_node_names, &ret_types, &control_ret_node_names));
-
-  GraphDef graph_def;
-  graph->ToGraphDef(&graph_def);
-  FunctionLibraryDefinition reachable_lib_def =
-      lib_def->ReachableDefinitions(graph_def);
-  *graph_def.mutable_library() = reachable_lib_def.ToProto();
-  if (options.graph_collector != nullptr) {
-    options.graph_collector->CollectRawGraph(graph_def);
-  }
-
-  Device* default_device = nullptr;
-  if (options.default_device_to_target && !options.target.empty()) {
-    // Make the `target` device the default device if nothing else is hard
-    // coded. This allows the same function definition to be specialized to
-    // different devices depending on the `PartitionedCallOp` device.
-    FunctionLibraryRuntime* flr = GetFLR(options.target);
-    if (flr == nullptr) {
-      return errors::InvalidArgument(
-          "Cannot instantiate multi-device function with target device ",
-          options.target);
-    }
-    default_device = flr->device();
-  }
-  const std::shared_ptr<DeviceSet> dev_set = device_set();
-
-  TF_RETURN_IF_ERROR(
-      SetArgShape(options.input_resource_dtypes_and_shapes, arg_nodes));
-  TF_RETURN_IF_ERROR(PinArgsAndRets(
-      options.input_devices, options.output_devices, *dev_set, arg_nodes,
-      ret_nodes, lib_def_,
-      options.config_proto.allow_soft_placement() ? default_device : nullptr));
-
-  auto data = absl::make_unique<MultiDeviceFunctionData>(
-      function_name, function_key, ret_node_names.size(),
-      std::move(reachable_lib_def), std::move(ret_types));
-
-  // The runtime shouldn't depend on duplication between the function library
-  // owned by the graph and the one owned by the runtime. To ensure this, for
-  // now we ensure that the graph function library is empty and the runtime
-  // library receives the query from LookUps on the graph function library.
-  graph->mutable_flib_def()->set_default_registry(&data->lib_def_);
-  graph->mutable_flib_def()->Clear();
-
+    Device* default_device, const std::shared_ptr<DeviceSet>& dev_set,
+    std::unique_ptr<Graph> graph, std::vector<string> ret_node_names,
+    std::vector<string> control_ret_node_names,
+    FunctionLibraryDefinition* data_lib_def,
+    std::unordered_map<string, string>* node_name_to_control_ret,
+    std::unordered_map<string, std::unique_ptr<Graph>>* subgraphs) {
   // Do not run function/graph optimization passes for component functions,
   // since they have already processed the main function.
   const bool should_run_optimization_passes = !options.is_component_function;
@@ -810,13 +726,10 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
             << function_name;
   }
 
-  // Mapping from a function body node name to the control output name.
-  std::unordered_map<string, string> node_name_to_control_ret;
-
   bool control_rets_updated = false;
   if (should_run_optimization_passes) {
     TF_RETURN_IF_ERROR(FunctionOptimizationPassRegistry::Global().Run(
-        *dev_set, options.config_proto, &graph, &data->lib_def_,
+        *dev_set, options.config_proto, &graph, data_lib_def,
         &control_ret_node_names, &control_rets_updated));
   }
 
@@ -824,11 +737,11 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
     // Function graph pass may have resulted in different nodes/node names for
     // control rets.
     for (const auto& control_ret : control_ret_node_names) {
-      node_name_to_control_ret.emplace(control_ret, control_ret);
+      node_name_to_control_ret->emplace(control_ret, control_ret);
     }
   } else {
     for (const auto& control_ret : fdef->control_ret()) {
-      node_name_to_control_ret.emplace(control_ret.second, control_ret.first);
+      node_name_to_control_ret->emplace(control_ret.second, control_ret.first);
     }
   }
 
@@ -839,7 +752,7 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
   session_options.config = options.config_proto;
   optimization_options.session_options = &session_options;
   optimization_options.graph = &graph;
-  optimization_options.flib_def = &data->lib_def_;
+  optimization_options.flib_def = data_lib_def;
   optimization_options.device_set = dev_set.get();
   optimization_options.is_function_graph = true;
   std::vector<CompositeDevice*> composite_devices;
@@ -879,7 +792,7 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
     DumpGraph("Before running graph optimization fn", graph.get());
     Status status = options.optimize_graph_fn(
         std::move(ret_node_names), std::move(control_ret_node_names),
-        &data->lib_def_, *dev_set, cpu_device, &graph);
+        data_lib_def, *dev_set, cpu_device, &graph);
     if (!status.ok()) {
       LOG(WARNING) << "Ignoring multi-device function optimization failure: "
                    << status.ToString();
@@ -911,18 +824,17 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
   VLOG(4) << "Main function graph to be partitioned:";
   VLOG(4) << DebugString(graph->ToGraphDefDebug());
 
-  std::unordered_map<string, std::unique_ptr<Graph>> subgraphs;
   TF_RETURN_IF_ERROR(
-      PartitionFunctionGraph(*dev_set, std::move(graph), &subgraphs));
+      PartitionFunctionGraph(*dev_set, std::move(graph), subgraphs));
 
-  for (const auto& pair : subgraphs) {
+  for (const auto& pair : *subgraphs) {
     DumpGraph(strings::StrCat("Before running POST_PARTITIONING passes (",
                               pair.first, ")"),
               pair.second.get());
   }
   optimization_options.graph = nullptr;
   optimization_options.device_set = nullptr;
-  optimization_options.partition_graphs = &subgraphs;
+  optimization_options.partition_graphs = subgraphs;
   // Normally POST_PARTITIONING passes are run by distributed workers.
   // Distributed workers are currently not supported in this code path, so we
   // run the passes here.
@@ -930,6 +842,150 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
     TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
         OptimizationPassRegistry::POST_PARTITIONING, optimization_options));
   }
+  return Status::OK();
+}
+
+Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
+    const string& function_name, AttrSlice attrs,
+    const FunctionLibraryRuntime::InstantiateOptions& options,
+    FunctionLibraryRuntime::Handle* handle) {
+  // Check if this function has already been instantiated.
+  const string& function_key = Canonicalize(function_name, attrs, options);
+
+  {
+    mutex_lock l(mu_);
+    const auto& it = table_.find(function_key);
+    if (it != table_.end()) {
+      *handle = it->second;
+      ++mdevice_data_[*handle]->instantiation_counter_;
+      return Status::OK();
+    }
+  }
+
+  VLOG(1) << "Instantiating MultiDevice function \"" << function_name
+          << "\" on default device \"" << options.target << "\"";
+  if (VLOG_IS_ON(3)) {
+    int index = 0;
+    VLOG(3) << "Requested input devices:";
+    for (const string& device : options.input_devices) {
+      VLOG(3) << "    [input " << index++ << "] " << device;
+    }
+    index = 0;
+    VLOG(3) << "Requested output devices:";
+    for (const string& device : options.output_devices) {
+      VLOG(3) << "    [output " << index++ << "] " << device;
+    }
+  }
+
+  const FunctionLibraryDefinition* lib_def =
+      options.lib_def == nullptr ? lib_def_ : options.lib_def;
+
+  const FunctionDef* fdef = lib_def->Find(function_name);
+  if (fdef == nullptr) {
+    return errors::InvalidArgument("Failed to find function \"", function_name,
+                                   "\" in function library: ", lib_def);
+  }
+
+  TF_RETURN_IF_ERROR(ValidateMultiDeviceOptions(*fdef, options));
+
+  std::unique_ptr<Graph> graph;
+  std::vector<Node*> arg_nodes, ret_nodes;
+  std::vector<string> ret_node_names;
+  DataTypeVector ret_types;
+  std::vector<string> control_ret_node_names;
+
+  TF_RETURN_IF_ERROR(GetGraphAndArgRets(
+      function_name, attrs, fdef, lib_def, &graph, &arg_nodes, &ret_nodes,
+      &ret_node_names, &ret_types, &control_ret_node_names));
+
+  GraphDef graph_def;
+  graph->ToGraphDef(&graph_def);
+  FunctionLibraryDefinition reachable_lib_def =
+      lib_def->ReachableDefinitions(graph_def);
+  *graph_def.mutable_library() = reachable_lib_def.ToProto();
+  if (options.graph_collector != nullptr) {
+    options.graph_collector->CollectRawGraph(graph_def);
+  }
+
+  Device* default_device = nullptr;
+  if (options.default_device_to_target && !options.target.empty()) {
+    // Make the `target` device the default device if nothing else is hard
+    // coded. This allows the same function definition to be specialized to
+    // different devices depending on the `PartitionedCallOp` device.
+    FunctionLibraryRuntime* flr = GetFLR(options.target);
+    if (flr == nullptr) {
+      return errors::InvalidArgument(
+          "Cannot instantiate multi-device function with target device ",
+          options.target);
+    }
+    default_device = flr->device();
+  }
+  const std::shared_ptr<DeviceSet> dev_set = device_set();
+
+  TF_RETURN_IF_ERROR(
+      SetArgShape(options.input_resource_dtypes_and_shapes, arg_nodes));
+  TF_RETURN_IF_ERROR(PinArgsAndRets(
+      options.input_devices, options.output_devices, *dev_set, arg_nodes,
+      ret_nodes, lib_def_,
+      options.config_proto.allow_soft_placement() ? default_device : nullptr));
+
+  auto data = absl::make_unique<MultiDeviceFunctionData>(
+      function_name, function_key, ret_node_names.size(),
+      std::move(reachable_lib_def), std::move(ret_types));
+
+  // The runtime shouldn't depend on duplication between the function library
+  // owned by the graph and the one owned by the runtime. To ensure this, for
+  // now we ensure that the graph function library is empty and the runtime
+  // library receives the query from LookUps on the graph function library.
+  graph->mutable_flib_def()->set_default_registry(&data->lib_def_);
+  graph->mutable_flib_def()->Clear();
+
+  // The optimized and partitioned graphs may be found in the on-disk
+  // instantiation cache. The cache is only used for top-level functions whose
+  // instantiation key does not depend on the state of this process.
+  const string& cache_dir = FunctionInstantiationCacheDir();
+  string cache_key;
+  if (!cache_dir.empty() && !options.is_component_function &&
+      options.lib_def == nullptr && options.state_handle.empty() &&
+      options.graph_collector == nullptr &&
+      options.composite_devices.empty()) {
+    cache_key = FunctionInstantiationCacheKey(function_key, graph_def, *dev_set);
+  }
+
+  // Mapping from a function body node name to the control output name.
+  std::unordered_map<string, string> node_name_to_control_ret;
+  std::unordered_map<string, std::unique_ptr<Graph>> subgraphs;
+  bool cache_hit = false;
+  if (!cache_key.empty()) {
+    Status s = LookupFunctionInstantiation(
+        env_, cache_dir, cache_key, *dev_set, &data->lib_def_, &subgraphs,
+        &node_name_to_control_ret);
+    cache_hit = s.ok();
+    if (!cache_hit) {
+      if (!errors::IsNotFound(s)) {
+        LOG(WARNING) << "Ignoring cached instantiation of function \""
+                     << function_name << "\": " << s;
+      }
+      subgraphs.clear();
+      node_name_to_control_ret.clear();
+    }
+  }
+  if (!cache_hit) {
+    TF_RETURN_IF_ERROR(OptimizeAndPartitionMultiDeviceFunction(
+        function_name, fdef, lib_def, options, default_device, dev_set,
+        std::move(graph), std::move(ret_node_names),
+        std::move(control_ret_node_names), &data->lib_def_,
+        &node_name_to_control_ret, &subgraphs));
+    if (!cache_key.empty()) {
+      Status s = InsertFunctionInstantiation(env_, cache_dir, cache_key,
+                                             data->lib_def_, subgraphs,
+                                             node_name_to_control_ret);
+      if (!s.ok()) {
+        LOG(WARNING) << "Failed to cache instantiation of function \""
+                     << function_name << "\": " << s;
+      }
+    }
+  }
   for (const auto& pair : subgraphs) {
     const auto* optimized_subgraph = pair.second.get();
     DumpGraph(
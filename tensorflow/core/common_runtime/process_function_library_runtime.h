@@ -357,6 +357,19 @@ class ProcessFunctionLibraryRuntime {
       const FunctionLibraryRuntime::InstantiateOptions& options,
       FunctionLibraryRuntime::Handle* handle);
 
+  // Runs the optimization passes and the placer on the body `graph` of a
+  // multi-device function, and partitions it into per-device `subgraphs`.
+  Status OptimizeAndPartitionMultiDeviceFunction(
+      const string& function_name, const FunctionDef* fdef,
+      const FunctionLibraryDefinition* lib_def,
+      const FunctionLibraryRuntime::InstantiateOptions& options,
+      Device* default_device, const std::shared_ptr<DeviceSet>& dev_set,
+      std::unique_ptr<Graph> graph, std::vector<string> ret_node_names,
+      std::vector<string> control_ret_node_names,
+      FunctionLibraryDefinition* data_lib_def,
+      std::unordered_map<string, string>* node_name_to_control_ret,
+      std::unordered_map<string, std::unique_ptr<Graph>>* subgraphs);
+
   void InstantiateRemote(
       const string& function_name, AttrSlice attrs,
       const FunctionLibraryRuntime::InstantiateOptions& options,
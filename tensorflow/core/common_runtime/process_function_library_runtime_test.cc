@@ -784,6 +784,37 @@ TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_EmptyBodySwap) {
   test::ExpectTensorEqual<float>(y2, test::AsTensor<float>({1, 2}));
 }
 
+TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_SingleComponentOnDevice) {
+  Init({test::function::XTimesTwo()});
+  FunctionLibraryRuntime::Handle handle;
+  TF_CHECK_OK(Instantiate("XTimesTwo", {{"T", DT_FLOAT}},
+                          MakeOptions("CPU:0", {"CPU:0"}, {"CPU:0"}),
+                          &handle));
+  FunctionLibraryRuntime* flr0 =
+      proc_flr_->GetFLR("/job:a/replica:0/task:0/device:CPU:0");
+  FunctionLibraryRuntime* flr1 =
+      proc_flr_->GetFLR("/job:a/replica:0/task:0/device:CPU:1");
+  EXPECT_TRUE(flr0->IsSingleComponentOnDevice(handle));
+  EXPECT_FALSE(flr1->IsSingleComponentOnDevice(handle));
+
+  // The function runs with a call frame, and without a rendezvous.
+  FunctionCallFrame frame({DT_FLOAT}, {DT_FLOAT});
+  TF_CHECK_OK(frame.SetArgs({test::AsTensor<float>({1, 2, 3, 4})}));
+  Status status;
+  Notification done;
+  flr0->Run(FunctionLibraryRuntime::Options(), handle, &frame,
+            [&status, &done](const Status& s) {
+              status = s;
+              done.Notify();
+            });
+  done.WaitForNotification();
+  TF_ASSERT_OK(status);
+  std::vector<Tensor> rets;
+  TF_ASSERT_OK(frame.ConsumeRetvals(&rets, /*allow_dead_tensors=*/false));
+  test::ExpectTensorEqual<float>(rets[0], test::AsTensor<float>({2, 4, 6, 8}));
+  EXPECT_TRUE(rendezvous_ref_counts_.empty());
+}
+
 Tensor GetResourceHandle(const string& var_name, const string& container,
                          const string& device_name) {
   ResourceHandle handle;
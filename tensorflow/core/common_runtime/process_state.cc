@@ -100,9 +100,21 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
       }
       int64_t cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
       DCHECK(sub_allocator);
-      allocator =
+      BFCAllocator* bfc_allocator =
           new BFCAllocator(sub_allocator, cpu_mem_limit, /*allow_growth=*/true,
                            /*name=*/"bfc_cpu_allocator_for_gpu");
+      int64_t thread_cache_in_kb = 0;
+      status = ReadInt64FromEnvVar("TF_CPU_BFC_THREAD_LOCAL_CACHE_IN_KB",
+                                   /*default_val=*/0, &thread_cache_in_kb);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
+      if (thread_cache_in_kb > 0) {
+        bfc_allocator->EnableThreadLocalCache(thread_cache_in_kb * (1LL << 10));
+        VLOG(2) << "Using " << thread_cache_in_kb
+                << " KB thread-local caches for ProcessState CPU allocator";
+      }
+      allocator = bfc_allocator;
       VLOG(2) << "Using BFCAllocator with memory limit of "
               << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
     } else if (sub_allocator) {
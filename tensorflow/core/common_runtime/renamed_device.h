@@ -138,6 +138,12 @@ class RenamedDevice : public Device {
     return underlying_device_->TryGetDeviceContext(out_context);
   }
 
+  Status AssignDeviceContexts(
+      const Graph& graph,
+      std::vector<DeviceContext*>* device_contexts) override {
+    return underlying_device_->AssignDeviceContexts(graph, device_contexts);
+  }
+
   // Returns the resource manager associated w/ this device.
   ResourceMgr* resource_manager() override {
     if (isolate_session_state_) {
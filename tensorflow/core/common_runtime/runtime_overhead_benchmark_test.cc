@@ -0,0 +1,289 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of the framework overhead per node, as opposed to the cost of the
+// kernels measured by the op benchmarks. Most of them run a synthetic graph of
+// `width` chains of `depth` AddV2 nodes on float tensors of `op_size`
+// elements, in each of the runtimes: the executors alone, DirectSession, and
+// op by op in eager and TFRT. The items per second are nodes per second, and
+// with an `op_size` of 1 their inverse is the overhead of a node.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow/c/eager/abstract_tensor_handle.h"
+#include "tensorflow/c/eager/immediate_execution_context.h"
+#include "tensorflow/c/eager/immediate_execution_operation.h"
+#include "tensorflow/c/eager/immediate_execution_tensor_handle.h"
+#include "tensorflow/c/tensor_interface.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/eager/context.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/common_runtime/rendezvous_mgr.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/public/session_options.h"
+
+#ifdef PLATFORM_GOOGLE
+#include "tensorflow/core/tfrt/eager/c_api_tfrt.h"
+#endif
+
+namespace tensorflow {
+namespace {
+
+constexpr char kDevice[] = "/job:localhost/replica:0/task:0/device:CPU:0";
+
+// Returns a float tensor of `op_size` ones.
+Tensor OpInput(int64_t op_size) {
+  Tensor tensor(DT_FLOAT, TensorShape({op_size}));
+  tensor.flat<float>().setConstant(1.0f);
+  return tensor;
+}
+
+// Adds `width` chains of `depth` AddV2 nodes reading `input` to `g`. Each node
+// adds the previous nodes of its chain and of the next one, so that a layer
+// only starts once the previous one is done. Returns the last layer.
+std::vector<Node*> AddSyntheticLayers(Graph* g, Node* input, int width,
+                                      int depth) {
+  std::vector<Node*> layer(width, input);
+  for (int i = 0; i < depth; ++i) {
+    std::vector<Node*> next(width);
+    for (int j = 0; j < width; ++j) {
+      next[j] =
+          test::graph::Binary(g, "AddV2", layer[j], layer[(j + 1) % width]);
+    }
+    layer.swap(next);
+  }
+  return layer;
+}
+
+void SetNodesProcessed(::testing::benchmark::State& state, int64_t num_nodes) {
+  state.SetLabel(strings::StrCat("Nodes = ", num_nodes));
+  state.SetItemsProcessed(num_nodes * static_cast<int64_t>(state.iterations()));
+}
+
+// Widths, depths and op sizes of the synthetic graphs.
+void SyntheticGraphArgs(benchmark::internal::Benchmark* b) {
+  b->UseRealTime();
+  // Tall skinny graph.
+  b->Args({1, 1024, 1});
+  // Short fat graph.
+  b->Args({64, 16, 1});
+  b->Args({16, 64, 1});
+  // Large ops, where the overhead should be negligible.
+  b->Args({16, 64, 1 << 16});
+}
+
+// Runs the synthetic graph with the executor of `executor_type`, without the
+// overhead of a session.
+void RunSyntheticGraphOnExecutor(::testing::benchmark::State& state,
+                                 const char* executor_type) {
+  const int width = state.range(0);
+  const int depth = state.range(1);
+  const int op_size = state.range(2);
+
+  Graph* g = new Graph(OpRegistry::Global());
+  AddSyntheticLayers(g, test::graph::Constant(g, OpInput(op_size)), width,
+                     depth);
+  FixupSourceAndSinkEdges(g);
+  test::Benchmark("cpu", g, /*options=*/nullptr, /*init=*/nullptr,
+                  /*rendez=*/nullptr, executor_type,
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  SetNodesProcessed(state, width * depth);
+}
+
+void BM_Executor(::testing::benchmark::State& state) {
+  RunSyntheticGraphOnExecutor(state, "");
+}
+BENCHMARK(BM_Executor)->Apply(SyntheticGraphArgs);
+
+void BM_SingleThreadedExecutor(::testing::benchmark::State& state) {
+  RunSyntheticGraphOnExecutor(state, "SINGLE_THREADED_EXECUTOR");
+}
+BENCHMARK(BM_SingleThreadedExecutor)->Apply(SyntheticGraphArgs);
+
+// Runs the synthetic graph in a DirectSession using the executor of
+// `executor_type`, feeding its input and fetching its last layer.
+void RunSyntheticGraphInSession(::testing::benchmark::State& state,
+                                const string& executor_type) {
+  const int width = state.range(0);
+  const int depth = state.range(1);
+  const int op_size = state.range(2);
+
+  Graph g(OpRegistry::Global());
+  Node* input;
+  TF_CHECK_OK(NodeBuilder(g.NewName("input"), "Placeholder")
+                  .Attr("dtype", DT_FLOAT)
+                  .Finalize(&g, &input));
+  CallableOptions callable_options;
+  callable_options.add_feed(input->name());
+  for (Node* output : AddSyntheticLayers(&g, input, width, depth)) {
+    callable_options.add_fetch(output->name());
+  }
+  GraphDef graph_def;
+  g.ToGraphDef(&graph_def);
+
+  SessionOptions options;
+  // Keep the graph as built, so that its nodes aren't merged or rewritten.
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions::L0);
+  options.config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_disable_meta_optimizer(true);
+  if (!executor_type.empty()) {
+    options.config.set_inter_op_parallelism_threads(-1);
+    options.config.mutable_experimental()->set_executor_type(executor_type);
+  }
+  std::unique_ptr<Session> session(NewSession(options));
+  TF_CHECK_OK(session->Create(graph_def));
+  Session::CallableHandle handle;
+  TF_CHECK_OK(session->MakeCallable(callable_options, &handle));
+
+  const std::vector<Tensor> inputs = {OpInput(op_size)};
+  for (auto s : state) {
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session->RunCallable(handle, inputs, &outputs, nullptr));
+  }
+  TF_CHECK_OK(session->ReleaseCallable(handle));
+  SetNodesProcessed(state, width * depth);
+}
+
+void BM_DirectSession(::testing::benchmark::State& state) {
+  RunSyntheticGraphInSession(state, "");
+}
+BENCHMARK(BM_DirectSession)->Apply(SyntheticGraphArgs);
+
+void BM_DirectSessionSingleThreadedExecutor(
+    ::testing::benchmark::State& state) {
+  RunSyntheticGraphInSession(state, "SINGLE_THREADED_EXECUTOR");
+}
+BENCHMARK(BM_DirectSessionSingleThreadedExecutor)->Apply(SyntheticGraphArgs);
+
+// Runs the synthetic graph op by op in `ctx`.
+void RunSyntheticGraphEagerly(::testing::benchmark::State& state,
+                              ImmediateExecutionContext* ctx) {
+  const int width = state.range(0);
+  const int depth = state.range(1);
+  const int op_size = state.range(2);
+
+  AbstractTensorPtr input(ctx->CreateTensor(DT_FLOAT, {op_size}));
+  float* input_data = static_cast<float*>(input->Data());
+  std::fill(input_data, input_data + op_size, 1.0f);
+  ImmediateTensorHandlePtr input_handle(ctx->CreateLocalHandle(input.get()));
+  ImmediateOpPtr op(ctx->CreateOperation());
+
+  for (auto s : state) {
+    std::vector<AbstractTensorHandle*> layer(width, input_handle.get());
+    std::vector<AbstractTensorHandlePtr> layer_handles;
+    for (int i = 0; i < depth; ++i) {
+      std::vector<AbstractTensorHandle*> next(width);
+      std::vector<AbstractTensorHandlePtr> next_handles(width);
+      for (int j = 0; j < width; ++j) {
+        TF_CHECK_OK(op->Reset("AddV2", /*raw_device_name=*/nullptr));
+        TF_CHECK_OK(op->AddInput(layer[j]));
+        TF_CHECK_OK(op->AddInput(layer[(j + 1) % width]));
+        int num_retvals = 1;
+        TF_CHECK_OK(op->Execute(absl::MakeSpan(&next[j], 1), &num_retvals));
+        next_handles[j].reset(next[j]);
+      }
+      layer.swap(next);
+      layer_handles.swap(next_handles);
+    }
+  }
+  SetNodesProcessed(state, width * depth);
+}
+
+void BM_Eager(::testing::benchmark::State& state) {
+  std::vector<std::unique_ptr<Device>> devices;
+  devices.push_back(DeviceFactory::NewDevice("CPU", {}, kDevice));
+  DeviceMgr* device_mgr = new StaticDeviceMgr(std::move(devices));
+  ImmediateContextPtr ctx(new EagerContext(
+      SessionOptions(), ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT,
+      /*async=*/false, device_mgr, /*device_mgr_owned=*/true,
+      new IntraProcessRendezvous(device_mgr)));
+  RunSyntheticGraphEagerly(state, ctx.get());
+}
+BENCHMARK(BM_Eager)->Apply(SyntheticGraphArgs);
+
+#ifdef PLATFORM_GOOGLE
+void BM_Tfrt(::testing::benchmark::State& state) {
+  ImmediateContextPtr ctx(new tfrt::tf::ContextInterface(
+      SessionOptions(), ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT,
+      /*is_async=*/false, /*use_tfrt_distributed_runtime=*/false));
+  RunSyntheticGraphEagerly(state, ctx.get());
+}
+BENCHMARK(BM_Tfrt)->Apply(SyntheticGraphArgs);
+#endif
+
+// Sends a tensor of `op_size` floats through a chain of `length` Send/Recv
+// pairs in the local rendezvous, to time the rendezvous overhead.
+void BM_SendRecv(::testing::benchmark::State& state) {
+  const int length = state.range(0);
+  const int op_size = state.range(1);
+
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* cur = test::graph::Constant(g, OpInput(op_size));
+  for (int i = 0; i < length; ++i) {
+    const string tensor_name = strings::StrCat("edge_", i);
+    test::graph::Send(g, cur, tensor_name, kDevice, 1, kDevice);
+    cur = test::graph::Recv(g, tensor_name, "float", kDevice, 1, kDevice);
+  }
+  FixupSourceAndSinkEdges(g);
+  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  SetNodesProcessed(state, 2 * length);
+}
+BENCHMARK(BM_SendRecv)->UseRealTime()->ArgPair(256, 1)->ArgPair(256, 1 << 16);
+
+// Calls a library function in a chain of `length` calls, to time the overhead
+// of a function call.
+void BM_FunctionCall(::testing::benchmark::State& state) {
+  const int length = state.range(0);
+  const int op_size = state.range(1);
+
+  FunctionDefLibrary library;
+  *library.add_function() = test::function::XTimesTwo();
+  Graph* g = new Graph(OpRegistry::Global());
+  TF_CHECK_OK(g->AddFunctionLibrary(library));
+  Node* cur = test::graph::Constant(g, OpInput(op_size));
+  for (int i = 0; i < length; ++i) {
+    TF_CHECK_OK(NodeBuilder(g->NewName("call"), "XTimesTwo", &g->flib_def())
+                    .Input(cur)
+                    .Attr("T", DT_FLOAT)
+                    .Finalize(g, &cur));
+  }
+  FixupSourceAndSinkEdges(g);
+  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  SetNodesProcessed(state, length);
+}
+BENCHMARK(BM_FunctionCall)->UseRealTime()->ArgPair(256, 1)->ArgPair(256, 1024);
+
+}  // namespace
+}  // namespace tensorflow
@@ -14,11 +14,15 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 
+#include <algorithm>
 #include <deque>
 #include <memory>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+
 #include "tensorflow/core/common_runtime/eval_const_tensor.h"
 #include "tensorflow/core/common_runtime/function_utils.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
@@ -31,6 +35,11 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -39,11 +48,237 @@ using shape_inference::InferenceContext;
 using shape_inference::ShapeAndType;
 using shape_inference::ShapeHandle;
 
+namespace {
+
+bool UseShapeInferenceCacheByDefault() {
+  static const bool use_cache = [] {
+    bool value;
+    Status s = ReadBoolFromEnvVar("TF_ENABLE_SHAPE_INFERENCE_CACHE",
+                                  /*default_val=*/false, &value);
+    if (!s.ok()) {
+      LOG(WARNING) << "Disabling the shape inference cache: " << s;
+      return false;
+    }
+    return value;
+  }();
+  return use_cache;
+}
+
+// The output shapes of a shape function, expressed relative to its input
+// shapes so that they can be recreated in another InferenceContext while
+// preserving the dimensions that the outputs share with the inputs.
+struct CachedShapeFnResult {
+  struct Dim {
+    // The known value of the dimension, or -1.
+    int64_t value = -1;
+    // If the dimension is unknown and is one of those of the inputs, its
+    // position among those of the inputs.
+    int input = -1;
+    int input_dim = -1;
+    // Otherwise, the index of the new unknown dimension, which may be shared
+    // between outputs.
+    int new_dim = -1;
+  };
+  struct Shape {
+    // If the output is one of the input shapes, the index of the input.
+    int input = -1;
+    bool rank_known = false;
+    std::vector<Dim> dims;
+  };
+  std::vector<Shape> outputs;
+};
+
+// A process-wide cache of the results of shape functions keyed by a
+// fingerprint of the op, attrs and input shapes of the node. It is cleared when
+// it grows beyond kMaxEntries, which bounds its memory use.
+class ShapeFnResultCache {
+ public:
+  static constexpr int kMaxEntries = 1 << 16;
+
+  static ShapeFnResultCache* Global() {
+    static ShapeFnResultCache* cache = new ShapeFnResultCache;
+    return cache;
+  }
+
+  std::shared_ptr<const CachedShapeFnResult> Lookup(const Fprint128& key) {
+    tf_shared_lock l(mu_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return nullptr;
+    return it->second;
+  }
+
+  void Insert(const Fprint128& key,
+              std::shared_ptr<const CachedShapeFnResult> result) {
+    mutex_lock l(mu_);
+    if (entries_.size() >= kMaxEntries) entries_.clear();
+    entries_.emplace(key, std::move(result));
+  }
+
+ private:
+  mutex mu_;
+  absl::flat_hash_map<Fprint128, std::shared_ptr<const CachedShapeFnResult>,
+                      Fprint128Hasher>
+      entries_ TF_GUARDED_BY(mu_);
+};
+
+// Returns the position of `d` among the dimensions of the inputs of `c` as
+// `*input` and `*input_dim`, or false if it is not one of them.
+bool FindInputDim(InferenceContext* c, DimensionHandle d, int* input,
+                  int* input_dim) {
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    ShapeHandle s = c->input(i);
+    if (!c->RankKnown(s)) continue;
+    for (int j = 0; j < c->Rank(s); ++j) {
+      if (c->Dim(s, j).SameHandle(d)) {
+        *input = i;
+        *input_dim = j;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Computes the key under which the result of the shape function of `node` is
+// cached, given the inputs set in `c`. Returns false if the result may not be
+// cached, because the inputs carry handle data.
+bool ShapeFnCacheKey(const Node* node, int graph_def_version,
+                     InferenceContext* c, Fprint128* key) {
+  string buf = strings::StrCat(node->type_string(), ";", graph_def_version);
+  std::vector<std::pair<const string*, const AttrValue*>> attrs;
+  attrs.reserve(node->def().attr_size());
+  for (const auto& attr : node->def().attr()) {
+    attrs.emplace_back(&attr.first, &attr.second);
+  }
+  std::sort(attrs.begin(), attrs.end(),
+            [](const std::pair<const string*, const AttrValue*>& a,
+               const std::pair<const string*, const AttrValue*>& b) {
+              return *a.first < *b.first;
+            });
+  string serialized;
+  for (const auto& attr : attrs) {
+    SerializeToStringDeterministic(*attr.second, &serialized);
+    strings::StrAppend(&buf, ";", *attr.first, "=", serialized.size(), ":",
+                       serialized);
+  }
+
+  // Unknown dimensions are numbered in order of first appearance, so that the
+  // key reflects which of them are shared between inputs.
+  std::vector<DimensionHandle> unknown_dims;
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    if (c->input_handle_shapes_and_types(i) != nullptr) return false;
+    ShapeHandle s = c->input(i);
+    if (s.Handle() == 0) {
+      buf.append(";n");
+    } else if (!c->RankKnown(s)) {
+      buf.append(";?");
+    } else {
+      strings::StrAppend(&buf, ";", c->Rank(s), ":");
+      for (int j = 0; j < c->Rank(s); ++j) {
+        DimensionHandle d = c->Dim(s, j);
+        if (c->ValueKnown(d)) {
+          strings::StrAppend(&buf, c->Value(d), ",");
+          continue;
+        }
+        auto it = std::find_if(
+            unknown_dims.begin(), unknown_dims.end(),
+            [d](DimensionHandle other) { return other.SameHandle(d); });
+        strings::StrAppend(&buf, "u", it - unknown_dims.begin(), ",");
+        if (it == unknown_dims.end()) unknown_dims.push_back(d);
+      }
+    }
+  }
+  *key = Fingerprint128(buf);
+  return true;
+}
+
+// Records the outputs of `c`, whose shape function has run with the inputs
+// `inputs`. Returns nullptr if the result may not be cached, because the shape
+// function depended on more than the input shapes or produced handle data.
+std::shared_ptr<const CachedShapeFnResult> RecordShapeFnResult(
+    InferenceContext* c, const std::vector<ShapeHandle>& inputs) {
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    if (c->requested_input_tensor(i) ||
+        c->requested_input_tensor_as_partial_shape(i) ||
+        !c->input(i).SameHandle(inputs[i])) {
+      return nullptr;
+    }
+  }
+  auto result = std::make_shared<CachedShapeFnResult>();
+  std::vector<DimensionHandle> new_dims;
+  for (int i = 0; i < c->num_outputs(); ++i) {
+    ShapeHandle s = c->output(i);
+    if (s.Handle() == 0 || c->output_handle_shapes_and_types(i) != nullptr) {
+      return nullptr;
+    }
+    result->outputs.emplace_back();
+    CachedShapeFnResult::Shape& output = result->outputs.back();
+    for (int j = 0; j < c->num_inputs(); ++j) {
+      if (s.SameHandle(c->input(j))) {
+        output.input = j;
+        break;
+      }
+    }
+    if (output.input >= 0 || !c->RankKnown(s)) continue;
+    output.rank_known = true;
+    output.dims.resize(c->Rank(s));
+    for (int j = 0; j < c->Rank(s); ++j) {
+      DimensionHandle d = c->Dim(s, j);
+      CachedShapeFnResult::Dim& dim = output.dims[j];
+      if (c->ValueKnown(d)) {
+        dim.value = c->Value(d);
+      } else if (!FindInputDim(c, d, &dim.input, &dim.input_dim)) {
+        auto it = std::find_if(
+            new_dims.begin(), new_dims.end(),
+            [d](DimensionHandle other) { return other.SameHandle(d); });
+        dim.new_dim = it - new_dims.begin();
+        if (it == new_dims.end()) new_dims.push_back(d);
+      }
+    }
+  }
+  return result;
+}
+
+// Sets the outputs of `c` from `result`.
+void ApplyShapeFnResult(const CachedShapeFnResult& result,
+                        InferenceContext* c) {
+  std::vector<DimensionHandle> new_dims;
+  for (int i = 0; i < c->num_outputs(); ++i) {
+    const CachedShapeFnResult::Shape& output = result.outputs[i];
+    if (output.input >= 0) {
+      c->set_output(i, c->input(output.input));
+      continue;
+    }
+    if (!output.rank_known) {
+      c->set_output(i, c->UnknownShape());
+      continue;
+    }
+    std::vector<DimensionHandle> dims;
+    dims.reserve(output.dims.size());
+    for (const CachedShapeFnResult::Dim& dim : output.dims) {
+      if (dim.value >= 0) {
+        dims.push_back(c->MakeDim(dim.value));
+      } else if (dim.input >= 0) {
+        dims.push_back(c->Dim(c->input(dim.input), dim.input_dim));
+      } else {
+        while (static_cast<int>(new_dims.size()) <= dim.new_dim) {
+          new_dims.push_back(c->UnknownDim());
+        }
+        dims.push_back(new_dims[dim.new_dim]);
+      }
+    }
+    c->set_output(i, c->MakeShape(dims));
+  }
+}
+
+}  // namespace
+
 ShapeRefiner::ShapeRefiner(int graph_def_version,
                            const OpRegistryInterface* ops)
     : graph_def_version_(graph_def_version),
       ops_registry_(ops),
-      graph_runner_(Env::Default()) {}
+      graph_runner_(Env::Default()),
+      use_shape_inference_cache_(UseShapeInferenceCacheByDefault()) {}
 
 ShapeRefiner::ShapeRefiner(const VersionDef& versions,
                            const OpRegistryInterface* ops)
@@ -259,12 +494,51 @@ Status ShapeRefiner::AddNodeInternal(
         "', did you forget to define it?");
   }
 
+  // The results of shape functions of ops in the global registry that do not
+  // depend on the outer context or on a function library are cacheable.
+  Fprint128 cache_key;
+  bool cacheable = false;
+  if (use_shape_inference_cache_ && outer_context == nullptr &&
+      op_reg_data->shape_inference_fn != nullptr &&
+      !(function_library_ && IsFunctionCall(*function_library_, *node))) {
+    const OpRegistrationData* global_op_reg_data;
+    cacheable =
+        OpRegistry::Global()
+            ->LookUp(node->type_string(), &global_op_reg_data)
+            .ok() &&
+        global_op_reg_data == op_reg_data &&
+        ShapeFnCacheKey(node, graph_def_version_, ic.get(), &cache_key);
+  }
+  if (cacheable) {
+    std::shared_ptr<const CachedShapeFnResult> result =
+        ShapeFnResultCache::Global()->Lookup(cache_key);
+    if (result != nullptr) {
+      ApplyShapeFnResult(*result, ic.get());
+      node_to_context_[node].reset(
+          new ExtendedInferenceContext(std::move(ic), node));
+      return Status::OK();
+    }
+  }
+  std::vector<ShapeHandle> inputs;
+  if (cacheable) {
+    inputs.reserve(ic->num_inputs());
+    for (int i = 0; i < ic->num_inputs(); ++i) inputs.push_back(ic->input(i));
+  }
+
   std::unique_ptr<ExtendedInferenceContext> ec(
       new ExtendedInferenceContext(std::move(ic), node));
 
   // Run the shape inference function, and return if there was an error.
   TF_RETURN_IF_ERROR(RunShapeFn(node, op_reg_data, ec.get(), outer_context));
 
+  if (cacheable) {
+    std::shared_ptr<const CachedShapeFnResult> result =
+        RecordShapeFnResult(ec->get_context(), inputs);
+    if (result != nullptr) {
+      ShapeFnResultCache::Global()->Insert(cache_key, std::move(result));
+    }
+  }
+
   // Store the resulting context object in the map.
   node_to_context_[node].swap(ec);
 
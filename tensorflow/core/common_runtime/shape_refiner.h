@@ -138,6 +138,17 @@ class ShapeRefiner {
     disable_constant_propagation_ = disable;
   }
 
+  // Enables a process-wide cache of the results of shape functions, shared by
+  // all ShapeRefiners that enable it, so that nodes whose op, attrs and input
+  // shapes were already seen (e.g. by a previous pass over a rewritten copy of
+  // the same graph) do not run their shape function again. Only the results
+  // of shape functions that depend on nothing but the input shapes are
+  // cached. Defaults to the value of the TF_ENABLE_SHAPE_INFERENCE_CACHE
+  // environment variable, or false.
+  void set_use_shape_inference_cache(bool use_shape_inference_cache) {
+    use_shape_inference_cache_ = use_shape_inference_cache;
+  }
+
   // Set function library to enable function shape inference.
   // Without function library, function inference always yields unknown shapes.
   // With this enabled, shape inference can take more time since it descends
@@ -315,6 +326,7 @@ class ShapeRefiner {
 
   bool require_shape_inference_fns_ = true;
   bool disable_constant_propagation_ = false;
+  bool use_shape_inference_cache_;
 
   // Function library is optional, but has to be set to enable function
   // shape inference.
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/resource_variable_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/function_testlib.h"
+#include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -28,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
@@ -221,6 +223,80 @@ TEST_F(ShapeRefinerTest, MissingShapeInferenceFns) {
   TF_EXPECT_OK(m.AddNode(b));
 }
 
+namespace {
+
+int num_counting_shape_fn_calls = 0;
+
+// An op whose output shares a dimension with each of its inputs, and has a new
+// unknown dimension.
+REGISTER_OP("TestOpWithCountingShapeFn")
+    .Input("a: float")
+    .Input("b: float")
+    .Output("o: float")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      ++num_counting_shape_fn_calls;
+      c->set_output(0, c->MakeShape({c->Dim(c->input(0), 0), c->UnknownDim(),
+                                     c->Dim(c->input(1), 1)}));
+      return Status::OK();
+    });
+
+}  // namespace
+
+TEST_F(ShapeRefinerTest, ShapeInferenceCache) {
+  Scope root = Scope::NewRootScope();
+  auto a = ops::Placeholder(
+      root, DT_FLOAT, ops::Placeholder::Shape(PartialTensorShape({-1, 3})));
+  auto b = ops::Placeholder(
+      root, DT_FLOAT, ops::Placeholder::Shape(PartialTensorShape({3, -1})));
+  auto c = ops::Placeholder(
+      root, DT_FLOAT, ops::Placeholder::Shape(PartialTensorShape({-1, 4})));
+  Node* ab;
+  TF_ASSERT_OK(NodeBuilder("ab", "TestOpWithCountingShapeFn")
+                   .Input(a.node())
+                   .Input(b.node())
+                   .Finalize(root.graph(), &ab));
+  Node* cb;
+  TF_ASSERT_OK(NodeBuilder("cb", "TestOpWithCountingShapeFn")
+                   .Input(c.node())
+                   .Input(b.node())
+                   .Finalize(root.graph(), &cb));
+
+  num_counting_shape_fn_calls = 0;
+  for (int i = 0; i < 2; ++i) {
+    ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
+    m.set_use_shape_inference_cache(true);
+    TF_ASSERT_OK(m.AddNode(a.node()));
+    TF_ASSERT_OK(m.AddNode(b.node()));
+    TF_ASSERT_OK(m.AddNode(ab));
+    // The shape function only runs for the first refiner.
+    EXPECT_EQ(1, num_counting_shape_fn_calls);
+
+    // The cached result preserves the dimensions shared with the inputs.
+    shape_inference::InferenceContext* ctx = m.GetContext(ab);
+    EXPECT_EQ("[?,?,?]", ctx->DebugString(ctx->output(0)));
+    EXPECT_TRUE(SameHandle(ctx->Dim(ctx->output(0), 0),
+                           ctx->Dim(ctx->input(0), 0)));
+    EXPECT_TRUE(SameHandle(ctx->Dim(ctx->output(0), 2),
+                           ctx->Dim(ctx->input(1), 1)));
+  }
+
+  // Different input shapes miss the cache.
+  ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
+  m.set_use_shape_inference_cache(true);
+  TF_ASSERT_OK(m.AddNode(b.node()));
+  TF_ASSERT_OK(m.AddNode(c.node()));
+  TF_ASSERT_OK(m.AddNode(cb));
+  EXPECT_EQ(2, num_counting_shape_fn_calls);
+
+  // A refiner without the cache always runs the shape function.
+  ShapeRefiner uncached(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
+  uncached.set_use_shape_inference_cache(false);
+  TF_ASSERT_OK(uncached.AddNode(a.node()));
+  TF_ASSERT_OK(uncached.AddNode(b.node()));
+  TF_ASSERT_OK(uncached.AddNode(ab));
+  EXPECT_EQ(3, num_counting_shape_fn_calls);
+}
+
 TEST_F(ShapeRefinerTest, PropagateConstants) {
   // Reduction dimension is a variable, so we don't know its value.
   // So the output shape value is unknown (though its rank is known).
@@ -1560,5 +1636,37 @@ TEST_F(ShapeRefinerTest, FunctionShapeInferenceWorksForResourceHandles) {
   EXPECT_RESOURCE_SINGLE_TYPE(DataType::DT_FLOAT, m, swap, 1);
 }
 
+// Measures the time spent in shape inference when a graph is constructed, as
+// DirectSession does on setup, with and without the shape inference cache.
+void BM_ImportGraphDefShapeInference(::testing::benchmark::State& state) {
+  const int num_layers = state.range(0);
+  const bool use_cache = state.range(1);
+
+  Scope root = Scope::NewRootScope();
+  Output x = ops::Placeholder(
+      root, DT_FLOAT, ops::Placeholder::Shape(PartialTensorShape({-1, 64})));
+  auto w = ops::Const(root, 1.0f, {64, 64});
+  auto bias = ops::Const(root, 1.0f, {64});
+  for (int i = 0; i < num_layers; ++i) {
+    x = ops::Relu(root, ops::BiasAdd(root, ops::MatMul(root, x, w), bias));
+  }
+  GraphDef graph_def;
+  TF_CHECK_OK(root.ToGraphDef(&graph_def));
+
+  for (auto s : state) {
+    Graph graph(OpRegistry::Global());
+    ShapeRefiner refiner(graph.versions(), graph.op_registry());
+    refiner.set_use_shape_inference_cache(use_cache);
+    TF_CHECK_OK(ImportGraphDef(ImportGraphDefOptions(), graph_def, &graph,
+                               &refiner));
+  }
+  state.SetItemsProcessed(state.iterations() * graph_def.node_size());
+}
+BENCHMARK(BM_ImportGraphDefShapeInference)
+    ->ArgPair(100, 0)
+    ->ArgPair(100, 1)
+    ->ArgPair(1000, 0)
+    ->ArgPair(1000, 1);
+
 }  // namespace
 }  // namespace tensorflow
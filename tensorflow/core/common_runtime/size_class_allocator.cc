@@ -0,0 +1,248 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/size_class_allocator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/hash/hash.h"
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+void UpdateMax(std::atomic<int64_t>* max, int64_t value) {
+  int64_t current = max->load();
+  while (value > current && !max->compare_exchange_weak(current, value)) {
+  }
+}
+
+// An index of the calling thread, shared by all the allocators.
+int ThreadIndex() {
+  static std::atomic<int> next_index{0};
+  static thread_local int index = next_index.fetch_add(1);
+  return index;
+}
+
+}  // namespace
+
+SizeClassAllocator::SizeClassAllocator(SubAllocator* sub_allocator,
+                                       int64_t memory_limit,
+                                       const string& name, int num_shards)
+    : sub_allocator_(sub_allocator),
+      memory_limit_(memory_limit),
+      name_(name),
+      shards_(new Shard[std::max(num_shards, 1)]),
+      num_shards_(std::max(num_shards, 1)) {}
+
+SizeClassAllocator::~SizeClassAllocator() {
+  ReleaseCachedBuffers();
+  mutex_lock l(slabs_mu_);
+  for (void* slab : slabs_) sub_allocator_->Free(slab, kSlabBytes);
+}
+
+size_t SizeClassAllocator::RoundUp(size_t num_bytes) {
+  if (num_bytes <= kMinClassBytes) return kMinClassBytes;
+  // The classes above the largest power of two below num_bytes.
+  const size_t step =
+      (size_t{1} << Log2Floor64(num_bytes - 1)) / kClassesPerDoubling;
+  return (num_bytes + step - 1) / step * step;
+}
+
+SizeClassAllocator::Shard& SizeClassAllocator::ThreadShard() {
+  return shards_[ThreadIndex() % num_shards_];
+}
+
+SizeClassAllocator::Shard& SizeClassAllocator::BufferShard(
+    const void* ptr) const {
+  return shards_[absl::Hash<const void*>()(ptr) % num_shards_];
+}
+
+void* SizeClassAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  if (num_bytes == 0) return nullptr;
+  alignment = std::max(alignment, Allocator::kAllocatorAlignment);
+  const size_t class_bytes = RoundUp(num_bytes);
+  void* ptr = TakeCachedBuffer(alignment, class_bytes);
+  if (ptr == nullptr) {
+    ptr = class_bytes <= kMaxSlabClassBytes
+              ? AllocateFromSlab(alignment, class_bytes)
+              : AllocateFromSubAllocator(alignment, class_bytes);
+    if (ptr == nullptr) return nullptr;
+  }
+  {
+    Shard& shard = BufferShard(ptr);
+    mutex_lock l(shard.mu);
+    shard.buffers[ptr] = {num_bytes, class_bytes};
+  }
+  ++num_allocs_;
+  UpdateMax(&peak_bytes_in_use_, bytes_in_use_ += class_bytes);
+  UpdateMax(&largest_alloc_size_, num_bytes);
+  return ptr;
+}
+
+void* SizeClassAllocator::TakeCachedBuffer(size_t alignment,
+                                           size_t class_bytes) {
+  const int first = ThreadIndex() % num_shards_;
+  for (int i = 0; i < num_shards_; ++i) {
+    Shard& shard = shards_[(first + i) % num_shards_];
+    mutex_lock l(shard.mu);
+    auto it = shard.free_buffers.find(class_bytes);
+    if (it == shard.free_buffers.end()) continue;
+    std::vector<void*>& buffers = it->second;
+    // The most recently freed buffers are the likeliest to be in the caches.
+    for (auto buffer = buffers.rbegin(); buffer != buffers.rend(); ++buffer) {
+      void* ptr = *buffer;
+      if (reinterpret_cast<uintptr_t>(ptr) % alignment != 0) continue;
+      buffers.erase(std::next(buffer).base());
+      if (buffers.empty()) shard.free_buffers.erase(it);
+      cached_bytes_ -= class_bytes;
+      return ptr;
+    }
+  }
+  return nullptr;
+}
+
+void* SizeClassAllocator::AllocateFromSlab(size_t alignment,
+                                           size_t class_bytes) {
+  char* slab = static_cast<char*>(AllocateFromSubAllocator(alignment,
+                                                             kSlabBytes));
+  if (slab == nullptr) return nullptr;
+  {
+    mutex_lock l(slabs_mu_);
+    slabs_.push_back(slab);
+  }
+  const size_t num_buffers = kSlabBytes / class_bytes;
+  {
+    Shard& shard = ThreadShard();
+    mutex_lock l(shard.mu);
+    std::vector<void*>& buffers = shard.free_buffers[class_bytes];
+    for (size_t i = num_buffers - 1; i > 0; --i) {
+      buffers.push_back(slab + i * class_bytes);
+    }
+  }
+  cached_bytes_ += (num_buffers - 1) * class_bytes;
+  return slab;
+}
+
+void* SizeClassAllocator::AllocateFromSubAllocator(size_t alignment,
+                                                   size_t num_bytes) {
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    const int64_t reserved = bytes_reserved_ += num_bytes;
+    if (reserved <= memory_limit_) {
+      size_t bytes_received;
+      void* ptr = sub_allocator_->Alloc(alignment, num_bytes, &bytes_received);
+      if (ptr != nullptr) {
+        UpdateMax(&peak_bytes_reserved_, reserved);
+        return ptr;
+      }
+    }
+    bytes_reserved_ -= num_bytes;
+    if (attempt == 0) ReleaseCachedBuffers();
+  }
+  LOG(WARNING) << name_ << " ran out of memory trying to allocate "
+               << num_bytes << " bytes, with " << bytes_reserved_
+               << " bytes allocated and a limit of " << memory_limit_;
+  return nullptr;
+}
+
+void SizeClassAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  size_t class_bytes;
+  {
+    Shard& shard = BufferShard(ptr);
+    mutex_lock l(shard.mu);
+    auto it = shard.buffers.find(ptr);
+    CHECK(it != shard.buffers.end())  // Crash OK
+        << name_ << " was asked to free an unknown buffer " << ptr;
+    class_bytes = it->second.class_bytes;
+    shard.buffers.erase(it);
+  }
+  bytes_in_use_ -= class_bytes;
+  {
+    Shard& shard = ThreadShard();
+    mutex_lock l(shard.mu);
+    shard.free_buffers[class_bytes].push_back(ptr);
+  }
+  cached_bytes_ += class_bytes;
+}
+
+void SizeClassAllocator::ReleaseCachedBuffers() {
+  for (int i = 0; i < num_shards_; ++i) {
+    std::vector<std::pair<size_t, std::vector<void*>>> free_buffers;
+    {
+      mutex_lock l(shards_[i].mu);
+      auto& shard_buffers = shards_[i].free_buffers;
+      for (auto it = shard_buffers.begin(); it != shard_buffers.end();) {
+        if (it->first <= kMaxSlabClassBytes) {
+          ++it;
+          continue;
+        }
+        free_buffers.push_back(std::move(*it));
+        shard_buffers.erase(it++);
+      }
+    }
+    for (const auto& class_and_buffers : free_buffers) {
+      const size_t class_bytes = class_and_buffers.first;
+      for (void* ptr : class_and_buffers.second) {
+        sub_allocator_->Free(ptr, class_bytes);
+      }
+      const int64_t bytes = class_bytes * class_and_buffers.second.size();
+      cached_bytes_ -= bytes;
+      bytes_reserved_ -= bytes;
+    }
+  }
+}
+
+size_t SizeClassAllocator::RequestedSize(const void* ptr) const {
+  Shard& shard = BufferShard(ptr);
+  mutex_lock l(shard.mu);
+  auto it = shard.buffers.find(ptr);
+  CHECK(it != shard.buffers.end())  // Crash OK
+      << name_ << " was asked for the size of an unknown buffer " << ptr;
+  return it->second.requested_bytes;
+}
+
+size_t SizeClassAllocator::AllocatedSize(const void* ptr) const {
+  Shard& shard = BufferShard(ptr);
+  mutex_lock l(shard.mu);
+  auto it = shard.buffers.find(ptr);
+  CHECK(it != shard.buffers.end())  // Crash OK
+      << name_ << " was asked for the size of an unknown buffer " << ptr;
+  return it->second.class_bytes;
+}
+
+absl::optional<AllocatorStats> SizeClassAllocator::GetStats() {
+  AllocatorStats stats;
+  stats.num_allocs = num_allocs_;
+  stats.bytes_in_use = bytes_in_use_;
+  stats.peak_bytes_in_use = peak_bytes_in_use_;
+  stats.largest_alloc_size = largest_alloc_size_;
+  stats.bytes_limit = memory_limit_;
+  stats.bytes_reserved = bytes_reserved_;
+  stats.peak_bytes_reserved = peak_bytes_reserved_;
+  stats.bytes_reservable_limit = memory_limit_;
+  return stats;
+}
+
+bool SizeClassAllocator::ClearStats() {
+  num_allocs_ = 0;
+  peak_bytes_in_use_ = bytes_in_use_.load();
+  largest_alloc_size_ = 0;
+  peak_bytes_reserved_ = bytes_reserved_.load();
+  return true;
+}
+
+}  // namespace tensorflow
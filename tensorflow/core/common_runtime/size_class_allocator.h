@@ -0,0 +1,134 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_SIZE_CLASS_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_SIZE_CLASS_ALLOCATOR_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator that caches freed buffers by size class, for memory that is
+// expensive to obtain from the SubAllocator, like pinned host memory.
+//
+// Sizes are rounded up to one of kClassesPerDoubling classes between two
+// powers of two, so that at most 1/kClassesPerDoubling of a buffer is
+// wasted. Freed buffers stay cached in the shard of the freeing thread, and
+// each thread allocates from its own shard first, so that threads rarely
+// contend on a lock. The buffers of the small classes are carved from slabs
+// of kSlabBytes, as the SubAllocator may be page-granular. When the memory
+// obtained from the SubAllocator would exceed `memory_limit`, the cached
+// buffers of the large classes are returned to it first.
+class SizeClassAllocator : public Allocator {
+ public:
+  static constexpr int kClassesPerDoubling = 4;
+  static constexpr size_t kMinClassBytes = 256;
+  static constexpr size_t kMaxSlabClassBytes = 64 << 10;
+  static constexpr size_t kSlabBytes = 2 << 20;
+
+  // Takes ownership of sub_allocator.
+  SizeClassAllocator(SubAllocator* sub_allocator, int64_t memory_limit,
+                     const string& name, int num_shards = 16);
+  ~SizeClassAllocator() override;
+
+  // Returns the size class of an allocation of `num_bytes`.
+  static size_t RoundUp(size_t num_bytes);
+
+  string Name() override { return name_; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+
+  void DeallocateRaw(void* ptr) override;
+
+  bool TracksAllocationSizes() const override { return true; }
+
+  size_t RequestedSize(const void* ptr) const override;
+
+  size_t AllocatedSize(const void* ptr) const override;
+
+  absl::optional<AllocatorStats> GetStats() override;
+
+  bool ClearStats() override;
+
+  // Returns the cached buffers of the large classes to the SubAllocator.
+  void ReleaseCachedBuffers();
+
+  // Bytes of the cached buffers.
+  int64_t cached_bytes() const { return cached_bytes_; }
+
+ private:
+  struct Buffer {
+    size_t requested_bytes;
+    size_t class_bytes;
+  };
+
+  struct Shard {
+    mutable mutex mu;
+    // Cached buffers, by size class.
+    absl::flat_hash_map<size_t, std::vector<void*>> free_buffers
+        TF_GUARDED_BY(mu);
+    // Allocated buffers whose address hashes to this shard.
+    absl::flat_hash_map<const void*, Buffer> buffers TF_GUARDED_BY(mu);
+  };
+
+  // Returns a cached buffer of `class_bytes`, or nullptr.
+  void* TakeCachedBuffer(size_t alignment, size_t class_bytes);
+
+  // Allocates a buffer of `class_bytes` from a new slab, caching the rest of
+  // the slab, or returns nullptr.
+  void* AllocateFromSlab(size_t alignment, size_t class_bytes);
+
+  // Allocates `num_bytes` from the SubAllocator, or returns nullptr if it
+  // would exceed the memory limit.
+  void* AllocateFromSubAllocator(size_t alignment, size_t num_bytes);
+
+  // The shard of the calling thread's cache.
+  Shard& ThreadShard();
+
+  // The shard that tracks the buffer at `ptr`.
+  Shard& BufferShard(const void* ptr) const;
+
+  const std::unique_ptr<SubAllocator> sub_allocator_;
+  const int64_t memory_limit_;
+  const string name_;
+  const std::unique_ptr<Shard[]> shards_;
+  const int num_shards_;
+
+  mutex slabs_mu_;
+  std::vector<void*> slabs_ TF_GUARDED_BY(slabs_mu_);
+
+  std::atomic<int64_t> cached_bytes_{0};
+  std::atomic<int64_t> bytes_reserved_{0};
+  std::atomic<int64_t> peak_bytes_reserved_{0};
+  std::atomic<int64_t> bytes_in_use_{0};
+  std::atomic<int64_t> peak_bytes_in_use_{0};
+  std::atomic<int64_t> num_allocs_{0};
+  std::atomic<int64_t> largest_alloc_size_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SizeClassAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_SIZE_CLASS_ALLOCATOR_H_
@@ -0,0 +1,164 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/size_class_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Counts the calls to a BasicCPUAllocator.
+class CountingSubAllocator : public BasicCPUAllocator {
+ public:
+  CountingSubAllocator() : BasicCPUAllocator(port::kNUMANoAffinity, {}, {}) {}
+
+  void* Alloc(size_t alignment, size_t num_bytes,
+              size_t* bytes_received) override {
+    ++num_allocs_;
+    return BasicCPUAllocator::Alloc(alignment, num_bytes, bytes_received);
+  }
+
+  void Free(void* ptr, size_t num_bytes) override {
+    ++num_frees_;
+    BasicCPUAllocator::Free(ptr, num_bytes);
+  }
+
+  std::atomic<int> num_allocs_{0};
+  std::atomic<int> num_frees_{0};
+};
+
+TEST(SizeClassAllocatorTest, RoundsUpToSizeClasses) {
+  EXPECT_EQ(SizeClassAllocator::RoundUp(1), 256);
+  EXPECT_EQ(SizeClassAllocator::RoundUp(256), 256);
+  EXPECT_EQ(SizeClassAllocator::RoundUp(257), 320);
+  EXPECT_EQ(SizeClassAllocator::RoundUp(512), 512);
+  EXPECT_EQ(SizeClassAllocator::RoundUp(513), 640);
+  EXPECT_EQ(SizeClassAllocator::RoundUp(1000), 1024);
+  EXPECT_EQ(SizeClassAllocator::RoundUp((1 << 20) + 1), 1310720);
+  for (size_t n = 257; n < (1 << 16); n += 97) {
+    const size_t class_bytes = SizeClassAllocator::RoundUp(n);
+    EXPECT_GE(class_bytes, n);
+    EXPECT_LT(class_bytes - n,
+              class_bytes / SizeClassAllocator::kClassesPerDoubling);
+  }
+}
+
+TEST(SizeClassAllocatorTest, ReusesFreedBuffers) {
+  auto* sub_allocator = new CountingSubAllocator;
+  SizeClassAllocator allocator(sub_allocator, 1 << 30, "test");
+  const size_t kBytes = 1000 << 10;
+  void* ptr = allocator.AllocateRaw(64, kBytes);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(allocator.RequestedSize(ptr), kBytes);
+  EXPECT_EQ(allocator.AllocatedSize(ptr), 1 << 20);
+  allocator.DeallocateRaw(ptr);
+  EXPECT_EQ(allocator.cached_bytes(), 1 << 20);
+
+  // The same size class reuses the buffer, another one doesn't.
+  void* same_class = allocator.AllocateRaw(64, kBytes - 10);
+  EXPECT_EQ(same_class, ptr);
+  void* other_class = allocator.AllocateRaw(64, 2 * kBytes);
+  EXPECT_EQ(sub_allocator->num_allocs_, 2);
+  EXPECT_EQ(allocator.cached_bytes(), 0);
+
+  absl::optional<AllocatorStats> stats = allocator.GetStats();
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->num_allocs, 3);
+  EXPECT_EQ(stats->bytes_in_use, 3 << 20);
+  EXPECT_EQ(stats->bytes_reserved, 3 << 20);
+  EXPECT_EQ(stats->largest_alloc_size, 2 * kBytes);
+  allocator.DeallocateRaw(same_class);
+  allocator.DeallocateRaw(other_class);
+  EXPECT_EQ(allocator.GetStats()->bytes_in_use, 0);
+  EXPECT_EQ(sub_allocator->num_frees_, 0);
+}
+
+TEST(SizeClassAllocatorTest, CarvesSmallBuffersFromSlabs) {
+  auto* sub_allocator = new CountingSubAllocator;
+  SizeClassAllocator allocator(sub_allocator, 1 << 30, "test");
+  std::vector<void*> buffers;
+  for (int i = 0; i < 100; ++i) {
+    buffers.push_back(allocator.AllocateRaw(64, 1000));
+    ASSERT_NE(buffers.back(), nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffers.back()) % 64, 0);
+  }
+  EXPECT_EQ(sub_allocator->num_allocs_, 1);
+  EXPECT_EQ(allocator.GetStats()->bytes_in_use, 100 * 1024);
+  EXPECT_EQ(allocator.GetStats()->bytes_reserved,
+            SizeClassAllocator::kSlabBytes);
+
+  // Slabs are kept until the allocator is destroyed.
+  for (void* ptr : buffers) allocator.DeallocateRaw(ptr);
+  allocator.ReleaseCachedBuffers();
+  EXPECT_EQ(sub_allocator->num_frees_, 0);
+  EXPECT_EQ(allocator.cached_bytes(), SizeClassAllocator::kSlabBytes);
+}
+
+TEST(SizeClassAllocatorTest, ReleasesCachedBuffersAtMemoryLimit) {
+  auto* sub_allocator = new CountingSubAllocator;
+  SizeClassAllocator allocator(sub_allocator, 4 << 20, "test");
+  allocator.DeallocateRaw(allocator.AllocateRaw(64, 2 << 20));
+  EXPECT_EQ(allocator.cached_bytes(), 2 << 20);
+
+  // Over the limit with the cached buffer, but not without it.
+  void* ptr = allocator.AllocateRaw(64, 3 << 20);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(sub_allocator->num_frees_, 1);
+  EXPECT_EQ(allocator.cached_bytes(), 0);
+  EXPECT_EQ(allocator.GetStats()->bytes_reserved, 3 << 20);
+
+  EXPECT_EQ(allocator.AllocateRaw(64, 2 << 20), nullptr);
+  EXPECT_EQ(allocator.GetStats()->bytes_reserved, 3 << 20);
+  allocator.DeallocateRaw(ptr);
+}
+
+TEST(SizeClassAllocatorTest, AllocatesFromManyThreads) {
+  auto* sub_allocator = new CountingSubAllocator;
+  SizeClassAllocator allocator(sub_allocator, 1 << 30, "test",
+                               /*num_shards=*/4);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 8);
+    for (int i = 0; i < 8; ++i) {
+      pool.Schedule([&allocator, i]() {
+        std::vector<void*> buffers;
+        for (int j = 0; j < 1000; ++j) {
+          const size_t num_bytes = (i + 1 + j % 10) * (100 << 10);
+          buffers.push_back(allocator.AllocateRaw(64, num_bytes));
+          if (buffers.size() == 10) {
+            for (void* ptr : buffers) allocator.DeallocateRaw(ptr);
+            buffers.clear();
+          }
+        }
+      });
+    }
+  }
+  EXPECT_EQ(allocator.GetStats()->bytes_in_use, 0);
+  EXPECT_EQ(allocator.GetStats()->num_allocs, 8000);
+  EXPECT_EQ(allocator.cached_bytes(), allocator.GetStats()->bytes_reserved);
+  // Most allocations reuse a buffer freed by one of the threads.
+  EXPECT_LT(sub_allocator->num_allocs_, 8000 / 4);
+  allocator.ReleaseCachedBuffers();
+  EXPECT_EQ(allocator.GetStats()->bytes_reserved, 0);
+  EXPECT_EQ(sub_allocator->num_frees_, sub_allocator->num_allocs_);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,148 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+constexpr size_t StepArenaAllocator::kMinBlockBytes;
+constexpr size_t StepArenaAllocator::kMaxBlockBytes;
+constexpr size_t StepArenaAllocator::kMaxArenaAllocationBytes;
+
+namespace {
+
+size_t RoundUp(size_t bytes, size_t alignment) {
+  return (bytes + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+StepArenaAllocator::StepArenaAllocator(Allocator* base,
+                                       size_t initial_block_bytes)
+    : base_(base),
+      next_block_bytes_(RoundUp(
+          std::min(std::max(initial_block_bytes, kMinBlockBytes),
+                   kMaxBlockBytes),
+          kAllocatorAlignment)) {}
+
+StepArenaAllocator::~StepArenaAllocator() {
+  DCHECK_EQ(num_outstanding_, 0);
+  DCHECK(blocks_.empty());
+}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  if (num_bytes > kMaxArenaAllocationBytes ||
+      alignment > kAllocatorAlignment) {
+    void* ptr = base_->AllocateRaw(alignment, num_bytes);
+    if (ptr != nullptr) {
+      mutex_lock l(mu_);
+      DCHECK(!finished_);
+      ++num_outstanding_;
+    }
+    return ptr;
+  }
+
+  // Every allocation occupies at least one aligned slot, so that distinct
+  // allocations never share an address and every pointer lies strictly
+  // inside its block.
+  const size_t bytes =
+      RoundUp(std::max<size_t>(num_bytes, 1), kAllocatorAlignment);
+  mutex_lock l(mu_);
+  DCHECK(!finished_);
+  if (blocks_.empty() ||
+      blocks_.back().offset + bytes > blocks_.back().size) {
+    if (!blocks_.empty() && blocks_.back().num_live == 0) {
+      ReleaseBlockLocked(blocks_.size() - 1);
+    }
+    const size_t block_bytes = std::max(next_block_bytes_, bytes);
+    void* data = base_->AllocateRaw(kAllocatorAlignment, block_bytes);
+    if (data == nullptr) return nullptr;
+    blocks_.push_back({static_cast<char*>(data), block_bytes, 0, 0});
+    next_block_bytes_ = std::min(2 * block_bytes, kMaxBlockBytes);
+  }
+  Block& block = blocks_.back();
+  void* ptr = block.data + block.offset;
+  block.offset += bytes;
+  ++block.num_live;
+  ++num_outstanding_;
+  block_bytes_in_use_ += bytes;
+  peak_block_bytes_in_use_ =
+      std::max(peak_block_bytes_in_use_, block_bytes_in_use_);
+  return ptr;
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  bool delete_self = false;
+  {
+    mutex_lock l(mu_);
+    const int index = FindBlockLocked(ptr);
+    if (index < 0) {
+      base_->DeallocateRaw(ptr);
+    } else if (--blocks_[index].num_live == 0) {
+      if (index + 1 == static_cast<int>(blocks_.size()) && !finished_) {
+        // Rewind the current block, so that its memory is reused by
+        // subsequent allocations.
+        block_bytes_in_use_ -= blocks_[index].offset;
+        blocks_[index].offset = 0;
+      } else {
+        ReleaseBlockLocked(index);
+      }
+    }
+    --num_outstanding_;
+    delete_self = finished_ && num_outstanding_ == 0;
+  }
+  if (delete_self) delete this;
+}
+
+size_t StepArenaAllocator::Finish() {
+  size_t peak_bytes;
+  bool delete_self;
+  {
+    mutex_lock l(mu_);
+    DCHECK(!finished_);
+    finished_ = true;
+    if (!blocks_.empty() && blocks_.back().num_live == 0) {
+      ReleaseBlockLocked(blocks_.size() - 1);
+    }
+    peak_bytes = peak_block_bytes_in_use_;
+    delete_self = num_outstanding_ == 0;
+  }
+  if (delete_self) delete this;
+  return peak_bytes;
+}
+
+int StepArenaAllocator::FindBlockLocked(const void* ptr) const {
+  // There are only a few blocks per step, because block sizes grow
+  // geometrically, so a linear scan from the current block is cheapest.
+  const char* p = static_cast<const char*>(ptr);
+  for (int i = static_cast<int>(blocks_.size()) - 1; i >= 0; --i) {
+    const Block& block = blocks_[i];
+    if (p >= block.data && p < block.data + block.size) return i;
+  }
+  return -1;
+}
+
+void StepArenaAllocator::ReleaseBlockLocked(int index) {
+  DCHECK_EQ(blocks_[index].num_live, 0);
+  block_bytes_in_use_ -= blocks_[index].offset;
+  base_->DeallocateRaw(blocks_[index].data);
+  blocks_.erase(blocks_.begin() + index);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,100 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator for the temporary buffers allocated during a single step.
+//
+// Small allocations are carved out of large blocks obtained from a base
+// allocator by bumping an offset. The number of live allocations in each block
+// is counted: when the current block becomes empty its offset is rewound, so
+// that the temporaries of successive kernels reuse the same memory, and any
+// other block is returned to the base allocator as soon as it becomes empty.
+// Allocations that are too large, or that require a stronger alignment than
+// `Allocator::kAllocatorAlignment`, are forwarded to the base allocator.
+//
+// The owner calls `Finish()` at the end of the step instead of deleting the
+// allocator. Since a temporary tensor may outlive the step (e.g. when a kernel
+// forwards it to an output), the allocator deletes itself once it is finished
+// and all of its allocations have been deallocated.
+class StepArenaAllocator : public Allocator {
+ public:
+  // Bounds on the size of the blocks obtained from the base allocator.
+  static constexpr size_t kMinBlockBytes = 64 << 10;
+  static constexpr size_t kMaxBlockBytes = 64 << 20;
+
+  // Allocations larger than this are forwarded to the base allocator.
+  static constexpr size_t kMaxArenaAllocationBytes = 1 << 20;
+
+  // Creates an allocator that obtains memory from `base`, which must outlive
+  // it. The first block has `initial_block_bytes` bytes, clamped to
+  // [kMinBlockBytes, kMaxBlockBytes]; a good value is the result of `Finish()`
+  // from a previous step of the same computation.
+  StepArenaAllocator(Allocator* base, size_t initial_block_bytes);
+
+  std::string Name() override { return "step_arena"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+
+  // Marks the end of the step. No further allocations may be made, and
+  // `this` may be deleted at any point after this call. Returns the peak
+  // number of block bytes in use during the step.
+  size_t Finish();
+
+ private:
+  ~StepArenaAllocator() override;
+
+  struct Block {
+    char* data;
+    size_t size;
+    size_t offset;
+    int64_t num_live;
+  };
+
+  // Returns the index in `blocks_` of the block containing `ptr`, or -1.
+  int FindBlockLocked(const void* ptr) const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void ReleaseBlockLocked(int index) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Allocator* const base_;
+
+  mutex mu_;
+  // The last block is the one that allocations are currently made from.
+  std::vector<Block> blocks_ TF_GUARDED_BY(mu_);
+  size_t next_block_bytes_ TF_GUARDED_BY(mu_);
+  // Sum of the offsets of all blocks in `blocks_`, and its peak value.
+  size_t block_bytes_in_use_ TF_GUARDED_BY(mu_) = 0;
+  size_t peak_block_bytes_in_use_ TF_GUARDED_BY(mu_) = 0;
+  // Number of allocations, from blocks or from `base_`, not yet deallocated.
+  int64_t num_outstanding_ TF_GUARDED_BY(mu_) = 0;
+  bool finished_ TF_GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
@@ -0,0 +1,124 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Forwards to the CPU allocator and counts the outstanding allocations.
+class CountingAllocator : public Allocator {
+ public:
+  std::string Name() override { return "counting"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_allocs_;
+    ++num_outstanding_;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+  void DeallocateRaw(void* ptr) override {
+    --num_outstanding_;
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+
+  int num_allocs() const { return num_allocs_; }
+  int num_outstanding() const { return num_outstanding_; }
+
+ private:
+  int num_allocs_ = 0;
+  int num_outstanding_ = 0;
+};
+
+TEST(StepArenaAllocatorTest, SmallAllocationsShareOneBlock) {
+  CountingAllocator base;
+  auto* arena = new StepArenaAllocator(&base, 0);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 100; ++i) {
+    void* ptr = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % Allocator::kAllocatorAlignment,
+              0);
+    ptrs.push_back(ptr);
+  }
+  EXPECT_EQ(base.num_allocs(), 1);
+  for (void* ptr : ptrs) arena->DeallocateRaw(ptr);
+  EXPECT_EQ(arena->Finish(), 100 * 128);
+  EXPECT_EQ(base.num_outstanding(), 0);
+}
+
+TEST(StepArenaAllocatorTest, EmptyCurrentBlockIsReused) {
+  CountingAllocator base;
+  auto* arena = new StepArenaAllocator(&base, 0);
+  for (int i = 0; i < 1000; ++i) {
+    void* ptr = arena->AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+    ASSERT_NE(ptr, nullptr);
+    arena->DeallocateRaw(ptr);
+  }
+  EXPECT_EQ(base.num_allocs(), 1);
+  EXPECT_EQ(arena->Finish(), 4096);
+  EXPECT_EQ(base.num_outstanding(), 0);
+}
+
+TEST(StepArenaAllocatorTest, LargeAllocationsAreForwarded) {
+  CountingAllocator base;
+  auto* arena = new StepArenaAllocator(&base, 0);
+  void* ptr = arena->AllocateRaw(Allocator::kAllocatorAlignment,
+                                 StepArenaAllocator::kMaxArenaAllocationBytes +
+                                     1);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(base.num_allocs(), 1);
+  EXPECT_EQ(base.num_outstanding(), 1);
+  arena->DeallocateRaw(ptr);
+  EXPECT_EQ(base.num_outstanding(), 0);
+  EXPECT_EQ(arena->Finish(), 0);
+}
+
+TEST(StepArenaAllocatorTest, FullBlocksAreReleasedWhenEmpty) {
+  CountingAllocator base;
+  auto* arena = new StepArenaAllocator(&base, 0);
+  const size_t size = StepArenaAllocator::kMinBlockBytes / 2;
+  void* a = arena->AllocateRaw(Allocator::kAllocatorAlignment, size);
+  void* b = arena->AllocateRaw(Allocator::kAllocatorAlignment, size);
+  // The first block is full, so this one comes from a second block.
+  void* c = arena->AllocateRaw(Allocator::kAllocatorAlignment, size);
+  EXPECT_EQ(base.num_allocs(), 2);
+  arena->DeallocateRaw(a);
+  arena->DeallocateRaw(b);
+  EXPECT_EQ(base.num_outstanding(), 1);
+  arena->DeallocateRaw(c);
+  EXPECT_EQ(arena->Finish(), 3 * size);
+  EXPECT_EQ(base.num_outstanding(), 0);
+}
+
+TEST(StepArenaAllocatorTest, TensorsMayOutliveTheStep) {
+  CountingAllocator base;
+  auto* arena = new StepArenaAllocator(&base, 0);
+  Tensor t(arena, DT_FLOAT, TensorShape({16}));
+  t.flat<float>().setConstant(1.0f);
+  arena->Finish();
+  // `arena` stays alive until `t` releases its buffer.
+  EXPECT_EQ(base.num_outstanding(), 1);
+  EXPECT_EQ(t.flat<float>()(15), 1.0f);
+  t = Tensor();
+  EXPECT_EQ(base.num_outstanding(), 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/scanner.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
@@ -556,4 +557,111 @@ void StepStatsCollector::FinalizeInternal() {
     }
   }
 }
+
+SampledStepStatsCollector::SampledStepStatsCollector(StepStats* step_stats,
+                                                     int64_t node_sample_rate,
+                                                     int64_t capacity)
+    : step_stats_(step_stats),
+      node_sample_rate_(std::max<int64_t>(node_sample_rate, 1)),
+      records_(new Record[capacity]),
+      capacity_(capacity) {}
+
+NodeExecStatsInterface* SampledStepStatsCollector::CreateNodeExecStats(
+    const NodeDef* node) {
+  const int64_t n = num_nodes_.fetch_add(1, std::memory_order_relaxed);
+  if (n % node_sample_rate_ != 0) return nullptr;
+  const int64_t index = n / node_sample_rate_;
+  if (index >= capacity_) return nullptr;
+  Record* record = &records_[index];
+  record->node_ = node;
+  return record;
+}
+
+int64_t SampledStepStatsCollector::num_dropped() const {
+  const int64_t num_sampled =
+      (num_nodes_.load(std::memory_order_relaxed) + node_sample_rate_ - 1) /
+      node_sample_rate_;
+  return std::max<int64_t>(num_sampled - capacity_, 0);
+}
+
+void SampledStepStatsCollector::Record::RecordExecutorStarted() {
+  all_start_nanos_ = EnvTime::NowNanos();
+}
+
+void SampledStepStatsCollector::Record::RecordComputeStarted() {
+  op_start_nanos_ = EnvTime::NowNanos();
+}
+
+void SampledStepStatsCollector::Record::RecordComputeEnded() {
+  op_end_nanos_ = EnvTime::NowNanos();
+}
+
+void SampledStepStatsCollector::Record::RecordExecutorEnded() {
+  all_end_nanos_ = EnvTime::NowNanos();
+}
+
+void SampledStepStatsCollector::Finalize() {
+  if (!step_stats_ || finalized_) return;
+  finalized_ = true;
+  const int64_t num_records =
+      std::min(capacity_, (num_nodes_.load() + node_sample_rate_ - 1) /
+                              node_sample_rate_);
+  std::map<string, DeviceStepStats*> dev_stats_pb;
+  for (auto& ds : *step_stats_->mutable_dev_stats()) {
+    dev_stats_pb[ds.device()] = &ds;
+  }
+  for (int64_t i = 0; i < num_records; ++i) {
+    const Record& record = records_[i];
+    // The node was sampled, but its execution was abandoned.
+    if (record.device_ == nullptr) continue;
+    DeviceStepStats*& dss = dev_stats_pb[*record.device_];
+    if (dss == nullptr) {
+      dss = step_stats_->add_dev_stats();
+      dss->set_device(*record.device_);
+    }
+    NodeExecStats* stats = dss->add_node_stats();
+    const NodeDef& node = *record.node_;
+    stats->set_node_name(node.name());
+    stats->set_timeline_label(strings::StrCat(node.name(), " = ", node.op(),
+                                              "(",
+                                              absl::StrJoin(node.input(), ", "),
+                                              ")"));
+    const int64_t start = record.all_start_nanos_;
+    stats->set_scheduled_micros(record.scheduled_nanos_ /
+                                EnvTime::kMicrosToNanos);
+    stats->set_scheduled_nanos(record.scheduled_nanos_);
+    stats->set_all_start_micros(start / EnvTime::kMicrosToNanos);
+    stats->set_all_start_nanos(start);
+    stats->set_op_start_rel_micros(
+        (record.op_start_nanos_ - start) / EnvTime::kMicrosToNanos);
+    stats->set_op_start_rel_nanos(record.op_start_nanos_ - start);
+    stats->set_op_end_rel_micros((record.op_end_nanos_ - start) /
+                                 EnvTime::kMicrosToNanos);
+    stats->set_op_end_rel_nanos(record.op_end_nanos_ - start);
+    stats->set_all_end_rel_micros((record.all_end_nanos_ - start) /
+                                  EnvTime::kMicrosToNanos);
+    stats->set_all_end_rel_nanos(record.all_end_nanos_ - start);
+  }
+}
+
+int64_t StepStatsSampleEveryNSteps() {
+  static const int64_t every_n_steps = [] {
+    int64_t value;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_STEP_STATS_SAMPLE_EVERY_N_STEPS",
+                                    /*default_val=*/0, &value));
+    return value;
+  }();
+  return every_n_steps;
+}
+
+int64_t StepStatsSampleEveryNNodes() {
+  static const int64_t every_n_nodes = [] {
+    int64_t value;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_STEP_STATS_SAMPLE_EVERY_N_NODES",
+                                    /*default_val=*/1, &value));
+    return value;
+  }();
+  return every_n_nodes;
+}
+
 }  // namespace tensorflow
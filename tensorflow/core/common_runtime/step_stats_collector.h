@@ -15,12 +15,14 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_STATS_COLLECTOR_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_STATS_COLLECTOR_H_
 
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
@@ -202,6 +204,83 @@ class StepStatsCollector : public StepStatsCollectorInterface {
   uint64 collected_nodes_ TF_GUARDED_BY(mu_) = 0;
 };
 
+// A low-overhead alternative to `StepStatsCollector`, which records the
+// timings of only one in every `node_sample_rate` nodes executed in a step.
+//
+// The statistics of sampled nodes are recorded into a buffer of `capacity`
+// entries that is allocated up front, by claiming an entry with a single
+// atomic increment: recording takes no locks and makes no allocations. Nodes
+// executed after the buffer is full are not recorded. No memory or output
+// information is collected. The recorded entries are converted to `StepStats`
+// by `Finalize()`, off the hot path, after the step has finished.
+class SampledStepStatsCollector : public StepStatsCollectorInterface {
+ public:
+  // Does not take ownership of `step_stats`.
+  SampledStepStatsCollector(StepStats* step_stats, int64_t node_sample_rate,
+                            int64_t capacity);
+
+  NodeExecStatsInterface* CreateNodeExecStats(const NodeDef* node) override;
+  string ReportAllocsOnResourceExhausted(const string& err) override {
+    return "";
+  }
+
+  // Populates the StepStats passed from the constructor with the statistics
+  // of the sampled nodes. Must be called after all nodes of the step are done,
+  // while the graphs and devices of the step are still alive.
+  void Finalize();
+
+  // Returns the number of sampled nodes that were not recorded because the
+  // buffer was full.
+  int64_t num_dropped() const;
+
+ private:
+  class Record : public NodeExecStatsInterface {
+   public:
+    // Stores `device`, which must outlive the call to `Finalize()`.
+    void Done(const string& device) override { device_ = &device; }
+    void RecordExecutorStarted() override;
+    void RecordComputeStarted() override;
+    void RecordComputeEnded() override;
+    void RecordExecutorEnded() override;
+    bool TrackAllocations() const override { return false; }
+    void SetMemory(OpKernelContext* ctx) override {}
+    void SetOutput(int slot, const Tensor* tensor) override {}
+    void SetScheduled(int64_t nanos) override { scheduled_nanos_ = nanos; }
+
+   private:
+    friend class SampledStepStatsCollector;
+
+    const NodeDef* node_ = nullptr;
+    const string* device_ = nullptr;
+    int64_t scheduled_nanos_ = 0;
+    int64_t all_start_nanos_ = 0;
+    int64_t op_start_nanos_ = 0;
+    int64_t op_end_nanos_ = 0;
+    int64_t all_end_nanos_ = 0;
+  };
+
+  StepStats* const step_stats_;
+  const int64_t node_sample_rate_;
+  std::unique_ptr<Record[]> records_;
+  const int64_t capacity_;
+  // The number of nodes for which CreateNodeExecStats() was called.
+  std::atomic<int64_t> num_nodes_{0};
+  bool finalized_ = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SampledStepStatsCollector);
+};
+
+// Returns the rate at which sessions sample steps with a
+// `SampledStepStatsCollector` when tracing is not requested, which is set by
+// the TF_STEP_STATS_SAMPLE_EVERY_N_STEPS environment variable. 0, the default,
+// disables sampling.
+int64_t StepStatsSampleEveryNSteps();
+
+// Returns the `node_sample_rate` for `SampledStepStatsCollector`s created by
+// sessions, which is set by the TF_STEP_STATS_SAMPLE_EVERY_N_NODES environment
+// variable (default 1).
+int64_t StepStatsSampleEveryNNodes();
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_STATS_COLLECTOR_H_
@@ -0,0 +1,111 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+std::vector<NodeDef> MakeNodes(int num_nodes) {
+  std::vector<NodeDef> nodes(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    nodes[i].set_name(strings::StrCat("n", i));
+    nodes[i].set_op("NoOp");
+  }
+  return nodes;
+}
+
+// Executes `node` the way the executor does, if it is sampled.
+void Execute(SampledStepStatsCollector* collector, const NodeDef& node,
+             const string& device) {
+  NodeExecStatsInterface* stats = collector->CreateNodeExecStats(&node);
+  if (stats == nullptr) return;
+  EXPECT_FALSE(stats->TrackAllocations());
+  stats->SetScheduled(Env::Default()->NowNanos());
+  stats->RecordExecutorStarted();
+  stats->RecordComputeStarted();
+  stats->RecordComputeEnded();
+  stats->RecordExecutorEnded();
+  stats->Done(device);
+}
+
+TEST(SampledStepStatsCollectorTest, RecordsOneInNNodes) {
+  const string device = "/job:a/replica:0/task:0/device:CPU:0";
+  std::vector<NodeDef> nodes = MakeNodes(10);
+  StepStats step_stats;
+  SampledStepStatsCollector collector(&step_stats, /*node_sample_rate=*/3,
+                                      /*capacity=*/10);
+  for (const NodeDef& node : nodes) Execute(&collector, node, device);
+  collector.Finalize();
+
+  ASSERT_EQ(step_stats.dev_stats_size(), 1);
+  const DeviceStepStats& dev_stats = step_stats.dev_stats(0);
+  EXPECT_EQ(dev_stats.device(), device);
+  ASSERT_EQ(dev_stats.node_stats_size(), 4);
+  for (int i = 0; i < 4; ++i) {
+    const NodeExecStats& stats = dev_stats.node_stats(i);
+    EXPECT_EQ(stats.node_name(), strings::StrCat("n", 3 * i));
+    EXPECT_GT(stats.all_start_nanos(), 0);
+    EXPECT_GE(stats.op_start_rel_nanos(), 0);
+    EXPECT_GE(stats.op_end_rel_nanos(), stats.op_start_rel_nanos());
+    EXPECT_GE(stats.all_end_rel_nanos(), stats.op_end_rel_nanos());
+  }
+  EXPECT_EQ(collector.num_dropped(), 0);
+}
+
+TEST(SampledStepStatsCollectorTest, DropsNodesWhenFull) {
+  const string device = "/job:a/replica:0/task:0/device:CPU:0";
+  std::vector<NodeDef> nodes = MakeNodes(10);
+  StepStats step_stats;
+  SampledStepStatsCollector collector(&step_stats, /*node_sample_rate=*/1,
+                                      /*capacity=*/4);
+  for (const NodeDef& node : nodes) Execute(&collector, node, device);
+  collector.Finalize();
+
+  ASSERT_EQ(step_stats.dev_stats_size(), 1);
+  EXPECT_EQ(step_stats.dev_stats(0).node_stats_size(), 4);
+  EXPECT_EQ(collector.num_dropped(), 6);
+}
+
+TEST(SampledStepStatsCollectorTest, GroupsNodesByDevice) {
+  const string cpu0 = "/job:a/replica:0/task:0/device:CPU:0";
+  const string cpu1 = "/job:a/replica:0/task:0/device:CPU:1";
+  std::vector<NodeDef> nodes = MakeNodes(4);
+  StepStats step_stats;
+  SampledStepStatsCollector collector(&step_stats, /*node_sample_rate=*/1,
+                                      /*capacity=*/4);
+  Execute(&collector, nodes[0], cpu0);
+  Execute(&collector, nodes[1], cpu1);
+  Execute(&collector, nodes[2], cpu0);
+  // A sampled node which the executor never finishes is not reported.
+  ASSERT_NE(collector.CreateNodeExecStats(&nodes[3]), nullptr);
+  collector.Finalize();
+
+  ASSERT_EQ(step_stats.dev_stats_size(), 2);
+  EXPECT_EQ(step_stats.dev_stats(0).device(), cpu0);
+  EXPECT_EQ(step_stats.dev_stats(0).node_stats_size(), 2);
+  EXPECT_EQ(step_stats.dev_stats(1).device(), cpu1);
+  EXPECT_EQ(step_stats.dev_stats(1).node_stats_size(), 1);
+}
+
+}  // namespace
+}  // namespace tensorflow
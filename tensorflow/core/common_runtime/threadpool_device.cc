@@ -41,6 +41,7 @@ info. It does not have any negative impact on performance. */
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/types.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
@@ -104,6 +105,15 @@ ThreadPoolDevice::ThreadPoolDevice(const SessionOptions& options,
 ThreadPoolDevice::~ThreadPoolDevice() {}
 
 Allocator* ThreadPoolDevice::GetAllocator(AllocatorAttributes attr) {
+  if (!numa_allocators_.empty()) {
+    // Threads are pinned to their NUMA node when they start (e.g. by the
+    // RunHandlerPool), so the affinity is only queried once per thread.
+    static thread_local const int numa_node =
+        port::NUMAGetThreadNodeAffinity();
+    if (numa_node >= 0 && numa_node < numa_allocators_.size()) {
+      return numa_allocators_[numa_node];
+    }
+  }
   return allocator_;
 }
 
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_THREADPOOL_DEVICE_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_THREADPOOL_DEVICE_H_
 
+#include <vector>
+
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/local_device.h"
 #include "tensorflow/core/common_runtime/node_file_writer.h"
@@ -31,6 +33,13 @@ class ThreadPoolDevice : public LocalDevice {
   ~ThreadPoolDevice() override;
 
   Allocator* GetAllocator(AllocatorAttributes attr) override;
+
+  // Makes GetAllocator() return `numa_allocators[n]` on threads pinned to
+  // NUMA node `n`, instead of the allocator passed to the constructor. The
+  // allocators are not owned. Must be called before the device is used.
+  void SetThreadNUMANodeAllocators(std::vector<Allocator*> numa_allocators) {
+    numa_allocators_ = std::move(numa_allocators);
+  }
   Allocator* GetScopedAllocator(AllocatorAttributes attr,
                                 int64_t step_id) override;
   ScopedAllocatorMgr* GetScopedAllocatorMgr() const override {
@@ -54,6 +63,7 @@ class ThreadPoolDevice : public LocalDevice {
   void LogOutputs(OpKernel* op_kernel, OpKernelContext* context);
 
   Allocator* allocator_;  // Not owned
+  std::vector<Allocator*> numa_allocators_;  // Not owned
   std::unique_ptr<ScopedAllocatorMgr> scoped_allocator_mgr_;
   NodeFileWriter* node_file_writer_ = nullptr;  // not owned
 };
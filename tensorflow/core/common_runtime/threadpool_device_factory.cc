@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -38,6 +39,22 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<std::unique_ptr<Device>>* devices) override {
     int num_numa_nodes = port::NUMANumNodes();
+    // When the RunHandlerPool pins its threads to NUMA nodes, the devices that
+    // are not bound to a node allocate from the node of the running thread.
+    bool use_thread_numa_node_allocators = false;
+    TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_RUN_HANDLER_USE_NUMA_AFFINITY",
+                                          /*default_val=*/false,
+                                          &use_thread_numa_node_allocators));
+    std::vector<Allocator*> numa_allocators;
+    if (use_thread_numa_node_allocators && port::NUMAEnabled() &&
+        num_numa_nodes > 1 &&
+        !options.config.experimental().use_numa_affinity()) {
+      ProcessState::singleton()->EnableNUMA();
+      for (int i = 0; i < num_numa_nodes; ++i) {
+        numa_allocators.push_back(
+            ProcessState::singleton()->GetCPUAllocator(i));
+      }
+    }
     int n = 1;
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
@@ -63,6 +80,9 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
         tpd = absl::make_unique<ThreadPoolDevice>(
             options, name, Bytes(256 << 20), DeviceLocality(),
             ProcessState::singleton()->GetCPUAllocator(port::kNUMANoAffinity));
+        if (!numa_allocators.empty()) {
+          tpd->SetThreadNUMANodeAllocators(numa_allocators);
+        }
       }
       devices->push_back(std::move(tpd));
     }
@@ -310,6 +310,19 @@ Status CopyBatch(CopyBatchParams params,
                  std::function<Status()> allocation_callback,
                  std::vector<Tensor>* out_tensors);
 
+// Copies the input elements to a padded batch.
+//
+// Each component of the batch has the corresponding `padded_shapes` entry as
+// the shape of its elements, where unknown dimensions are padded to the
+// largest size of the dimension in the batch. The padding is filled with the
+// scalar in the corresponding `padding_values` entry. The `parallel_copy`
+// argument indicates whether to parallelize the copy of large elements.
+Status CopyPaddedBatch(CopyBatchParams params,
+                       const std::vector<std::vector<Tensor>>& batch_elements,
+                       const std::vector<PartialTensorShape>& padded_shapes,
+                       const std::vector<Tensor>& padding_values,
+                       bool parallel_copy, std::vector<Tensor>* out_tensors);
+
 // Computes the set of experiments to apply based on the job name, rollout
 // percentage of registered experiments, and the TF_DATA_EXPERIMENT_OPT_IN and
 // TF_DATA_EXPERIMENT_OPT_OUT environment variables.
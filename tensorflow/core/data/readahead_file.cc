@@ -0,0 +1,142 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/readahead_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace data {
+
+ReadaheadRandomAccessFile::ReadaheadRandomAccessFile(
+    std::unique_ptr<RandomAccessFile> file, size_t block_size, int depth,
+    thread::ThreadPool* thread_pool)
+    : file_(std::move(file)),
+      block_size_(block_size),
+      depth_(depth),
+      thread_pool_(thread_pool) {
+  DCHECK_GT(block_size_, 0);
+  DCHECK_GE(depth_, 0);
+}
+
+ReadaheadRandomAccessFile::~ReadaheadRandomAccessFile() {
+  mutex_lock l(mu_);
+  while (num_pending_reads_ > 0) {
+    cond_var_.wait(l);
+  }
+}
+
+Status ReadaheadRandomAccessFile::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+Status ReadaheadRandomAccessFile::Read(uint64 offset, size_t n,
+                                       StringPiece* result,
+                                       char* scratch) const {
+  mutex_lock l(mu_);
+  size_t num_read = 0;
+  Status status;
+  while (num_read < n) {
+    const uint64 position = offset + num_read;
+    const uint64 index = position / block_size_;
+    if (index > last_block_) {
+      status = errors::OutOfRange("Read less bytes than requested");
+      break;
+    }
+    std::shared_ptr<Block> block = GetBlock(index);
+    UpdateReadahead(index);
+    while (!block->done) {
+      cond_var_.wait(l);
+    }
+    if (!block->status.ok() && !errors::IsOutOfRange(block->status)) {
+      // Drop the block so that the read is retried by the next call.
+      blocks_.erase(index);
+      status = block->status;
+      break;
+    }
+    const size_t block_offset = position - index * block_size_;
+    if (block_offset >= block->data.size()) {
+      status = errors::OutOfRange("Read less bytes than requested");
+      break;
+    }
+    const size_t num_bytes =
+        std::min(n - num_read, block->data.size() - block_offset);
+    memcpy(scratch + num_read, block->data.data() + block_offset, num_bytes);
+    num_read += num_bytes;
+  }
+  *result = StringPiece(scratch, num_read);
+  return status;
+}
+
+std::shared_ptr<ReadaheadRandomAccessFile::Block>
+ReadaheadRandomAccessFile::GetBlock(uint64 index) const {
+  auto it = blocks_.find(index);
+  if (it != blocks_.end()) {
+    return it->second;
+  }
+  return StartRead(index);
+}
+
+std::shared_ptr<ReadaheadRandomAccessFile::Block>
+ReadaheadRandomAccessFile::StartRead(uint64 index) const {
+  auto block = std::make_shared<Block>();
+  blocks_[index] = block;
+  ++num_pending_reads_;
+  thread_pool_->Schedule([this, index, block]() {
+    // Only this closure accesses `block->data` until `block->done` is set.
+    block->data.resize(block_size_);
+    StringPiece data;
+    Status s = file_->Read(index * block_size_, block_size_, &data,
+                           &block->data[0]);
+    if (data.data() != block->data.data()) {
+      // Some files return views of their own buffers.
+      memmove(&block->data[0], data.data(), data.size());
+    }
+    block->data.resize(data.size());
+
+    mutex_lock l(mu_);
+    block->status = s;
+    block->done = true;
+    if (errors::IsOutOfRange(s)) {
+      last_block_ = std::min(last_block_, index);
+    }
+    --num_pending_reads_;
+    cond_var_.notify_all();
+  });
+  return block;
+}
+
+void ReadaheadRandomAccessFile::UpdateReadahead(uint64 index) const {
+  for (auto it = blocks_.begin(); it != blocks_.end();) {
+    if (it->first < index ||
+        it->first - index > static_cast<uint64>(depth_)) {
+      // Outstanding reads complete into their own `Block`s.
+      blocks_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  for (uint64 i = index + 1; i <= index + depth_ && i <= last_block_; ++i) {
+    if (!blocks_.contains(i)) {
+      StartRead(i);
+    }
+  }
+}
+
+}  // namespace data
+}  // namespace tensorflow
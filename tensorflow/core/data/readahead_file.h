@@ -0,0 +1,97 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_READAHEAD_FILE_H_
+#define TENSORFLOW_CORE_DATA_READAHEAD_FILE_H_
+
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+namespace data {
+
+// A `RandomAccessFile` that reads a file sequentially ahead of its reader.
+//
+// The file is read in aligned blocks of `block_size` bytes. Every `Read()`
+// keeps up to `depth` reads of the blocks following the one being read in
+// flight on `thread_pool`, so that several reads of a single file are
+// outstanding at any time. Reads that skip backwards or far ahead are served
+// correctly, but discard the blocks read ahead.
+//
+// Like other `RandomAccessFile`s, this class is thread-safe.
+class ReadaheadRandomAccessFile : public RandomAccessFile {
+ public:
+  // `thread_pool` must outlive this file.
+  ReadaheadRandomAccessFile(std::unique_ptr<RandomAccessFile> file,
+                            size_t block_size, int depth,
+                            thread::ThreadPool* thread_pool);
+
+  // Waits for the outstanding reads.
+  ~ReadaheadRandomAccessFile() override;
+
+  Status Name(StringPiece* result) const override;
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override;
+
+ private:
+  struct Block {
+    // Whether the read of the block completed.
+    bool done = false;
+    Status status;
+    // The bytes of the block. Shorter than `block_size_` for the last block.
+    std::string data;
+  };
+
+  // Returns the block at `index`, starting its read if needed.
+  std::shared_ptr<Block> GetBlock(uint64 index) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Starts reading the block at `index`.
+  std::shared_ptr<Block> StartRead(uint64 index) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Starts reading the `depth_` blocks following `index`, and discards the
+  // blocks that are not in [index, index + depth_].
+  void UpdateReadahead(uint64 index) const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::unique_ptr<RandomAccessFile> file_;
+  const size_t block_size_;
+  const int depth_;
+  thread::ThreadPool* const thread_pool_;
+
+  mutable mutex mu_;
+  mutable condition_variable cond_var_;
+  // The blocks being read or read ahead, keyed by index.
+  mutable absl::flat_hash_map<uint64, std::shared_ptr<Block>> blocks_
+      TF_GUARDED_BY(mu_);
+  mutable int64_t num_pending_reads_ TF_GUARDED_BY(mu_) = 0;
+  // The index of the first block known to reach the end of the file.
+  mutable uint64 last_block_ TF_GUARDED_BY(mu_) =
+      std::numeric_limits<uint64>::max();
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReadaheadRandomAccessFile);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_READAHEAD_FILE_H_
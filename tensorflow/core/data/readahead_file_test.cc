@@ -0,0 +1,112 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/readahead_file.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+class ReadaheadRandomAccessFileTest : public ::testing::Test {
+ protected:
+  ReadaheadRandomAccessFileTest()
+      : thread_pool_(Env::Default(), "readahead_test", /*num_threads=*/4) {}
+
+  // Writes a file of `size` bytes and returns its contents.
+  std::string WriteFile(const std::string& name, size_t size) {
+    std::string contents(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+      contents[i] = static_cast<char>(i % 251);
+    }
+    filename_ = io::JoinPath(testing::TmpDir(), name);
+    TF_CHECK_OK(WriteStringToFile(Env::Default(), filename_, contents));
+    return contents;
+  }
+
+  std::unique_ptr<ReadaheadRandomAccessFile> Open(size_t block_size,
+                                                  int depth) {
+    std::unique_ptr<RandomAccessFile> file;
+    TF_CHECK_OK(Env::Default()->NewRandomAccessFile(filename_, &file));
+    return absl::make_unique<ReadaheadRandomAccessFile>(
+        std::move(file), block_size, depth, &thread_pool_);
+  }
+
+  thread::ThreadPool thread_pool_;
+  std::string filename_;
+};
+
+TEST_F(ReadaheadRandomAccessFileTest, SequentialReads) {
+  const std::string contents = WriteFile("sequential", 10000);
+  for (int depth : {0, 1, 4}) {
+    auto file = Open(/*block_size=*/256, depth);
+    std::vector<char> scratch(333);
+    std::string read;
+    Status s;
+    while (s.ok()) {
+      StringPiece result;
+      s = file->Read(read.size(), scratch.size(), &result, scratch.data());
+      read.append(result.data(), result.size());
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(s)) << s;
+    EXPECT_EQ(read, contents);
+  }
+}
+
+TEST_F(ReadaheadRandomAccessFileTest, RandomReads) {
+  const std::string contents = WriteFile("random", 10000);
+  auto file = Open(/*block_size=*/100, /*depth=*/3);
+  std::vector<char> scratch(1000);
+  for (uint64 offset : {5000, 0, 9000, 4950, 123, 8999}) {
+    StringPiece result;
+    TF_ASSERT_OK(file->Read(offset, 1000, &result, scratch.data()));
+    EXPECT_EQ(result, StringPiece(contents).substr(offset, 1000));
+  }
+}
+
+TEST_F(ReadaheadRandomAccessFileTest, ReadPastEndOfFile) {
+  const std::string contents = WriteFile("past_end", 1000);
+  auto file = Open(/*block_size=*/128, /*depth=*/2);
+  std::vector<char> scratch(500);
+  StringPiece result;
+  Status s = file->Read(800, 500, &result, scratch.data());
+  EXPECT_TRUE(errors::IsOutOfRange(s)) << s;
+  EXPECT_EQ(result, StringPiece(contents).substr(800));
+
+  s = file->Read(2000, 10, &result, scratch.data());
+  EXPECT_TRUE(errors::IsOutOfRange(s)) << s;
+  EXPECT_TRUE(result.empty());
+}
+
+TEST_F(ReadaheadRandomAccessFileTest, Name) {
+  WriteFile("name", 10);
+  auto file = Open(/*block_size=*/8, /*depth=*/1);
+  StringPiece name;
+  TF_ASSERT_OK(file->Name(&name));
+  EXPECT_EQ(name, filename_);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
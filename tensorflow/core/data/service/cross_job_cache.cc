@@ -0,0 +1,122 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/cross_job_cache.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace data {
+
+CrossJobElementCache::CrossJobElementCache(
+    std::unique_ptr<TaskIterator> iterator, int64_t max_size_bytes)
+    : iterator_(std::move(iterator)), max_size_bytes_(max_size_bytes) {}
+
+Status CrossJobElementCache::Get(int64_t& index, std::vector<Tensor>& element,
+                                 bool& end_of_sequence) {
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      while (true) {
+        TF_RETURN_IF_ERROR(status_);
+        if (index < first_index_) {
+          VLOG(3) << "Element " << index << " was evicted from the cross-job "
+                  << "cache; skipping to element " << first_index_;
+          index = first_index_;
+        }
+        const int64_t end_index = first_index_ + elements_.size();
+        if (index < end_index) {
+          element = elements_[index - first_index_];
+          end_of_sequence = false;
+          return Status::OK();
+        }
+        if (end_of_sequence_) {
+          end_of_sequence = true;
+          return Status::OK();
+        }
+        if (!producing_) {
+          break;
+        }
+        cv_.wait(l);
+      }
+      producing_ = true;
+    }
+
+    std::vector<Tensor> next;
+    bool end_of_input = false;
+    Status s = iterator_->GetNext(next, end_of_input);
+
+    mutex_lock l(mu_);
+    producing_ = false;
+    cv_.notify_all();
+    if (!s.ok()) {
+      status_ = s;
+      return s;
+    }
+    if (end_of_input) {
+      end_of_sequence_ = true;
+      continue;
+    }
+    int64_t element_size = 0;
+    for (const Tensor& tensor : next) {
+      element_size += tensor.TotalBytes();
+    }
+    elements_.push_back(std::move(next));
+    element_sizes_.push_back(element_size);
+    size_bytes_ += element_size;
+    EvictElements();
+  }
+}
+
+void CrossJobElementCache::EvictElements() {
+  while (size_bytes_ > max_size_bytes_ && elements_.size() > 1) {
+    size_bytes_ -= element_sizes_.front();
+    elements_.pop_front();
+    element_sizes_.pop_front();
+    ++first_index_;
+  }
+}
+
+int64_t CrossJobElementCache::Cardinality() const {
+  return iterator_->Cardinality();
+}
+
+int64_t CrossJobElementCache::SizeBytes() const {
+  mutex_lock l(mu_);
+  return size_bytes_;
+}
+
+CachedTaskIterator::CachedTaskIterator(
+    std::shared_ptr<CrossJobElementCache> cache)
+    : cache_(std::move(cache)) {}
+
+Status CachedTaskIterator::GetNext(std::vector<Tensor>& element,
+                                   bool& end_of_sequence) {
+  TF_RETURN_IF_ERROR(cache_->Get(next_index_, element, end_of_sequence));
+  if (!end_of_sequence) {
+    ++next_index_;
+  }
+  return Status::OK();
+}
+
+int64_t CachedTaskIterator::Cardinality() const {
+  return cache_->Cardinality();
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,97 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_CROSS_JOB_CACHE_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_CROSS_JOB_CACHE_H_
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/data/service/task_runner.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+// A sliding window over the elements of a dataset, shared by the tasks of
+// different jobs reading the same dataset on a worker.
+//
+// The elements are produced once by `iterator` and cached until the cache
+// exceeds `max_size_bytes`, at which point the oldest elements are evicted.
+// Every reader tracks the index of the next element it reads. A reader that
+// falls behind the window skips to the oldest cached element, so the cache is
+// only meant for datasets of infinite cardinality, such as repeated training
+// datasets, where readers do not need to observe every element.
+class CrossJobElementCache {
+ public:
+  CrossJobElementCache(std::unique_ptr<TaskIterator> iterator,
+                       int64_t max_size_bytes);
+
+  // Reads the element at `index`, producing it if needed. If the element was
+  // evicted, reads the oldest cached element and updates `index` to its index.
+  Status Get(int64_t& index, std::vector<Tensor>& element,
+             bool& end_of_sequence) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the cardinality of the cached dataset.
+  int64_t Cardinality() const;
+
+  // Returns the number of bytes used by the cached elements.
+  int64_t SizeBytes() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Evicts the oldest elements until the cache fits in `max_size_bytes_`. The
+  // newest element is never evicted.
+  void EvictElements() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Only used for producing elements by the reader that set `producing_`.
+  const std::unique_ptr<TaskIterator> iterator_;
+  const int64_t max_size_bytes_;
+
+  mutable mutex mu_;
+  // Notified when a reader stops producing an element.
+  condition_variable cv_;
+  // Whether a reader is producing the next element.
+  bool producing_ TF_GUARDED_BY(mu_) = false;
+  bool end_of_sequence_ TF_GUARDED_BY(mu_) = false;
+  Status status_ TF_GUARDED_BY(mu_);
+  // The cached elements, starting at index `first_index_`.
+  std::deque<std::vector<Tensor>> elements_ TF_GUARDED_BY(mu_);
+  std::deque<int64_t> element_sizes_ TF_GUARDED_BY(mu_);
+  int64_t first_index_ TF_GUARDED_BY(mu_) = 0;
+  int64_t size_bytes_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CrossJobElementCache);
+};
+
+// A task iterator reading its elements from a `CrossJobElementCache`.
+class CachedTaskIterator : public TaskIterator {
+ public:
+  explicit CachedTaskIterator(std::shared_ptr<CrossJobElementCache> cache);
+
+  Status GetNext(std::vector<Tensor>& element, bool& end_of_sequence) override;
+  int64_t Cardinality() const override;
+
+ private:
+  const std::shared_ptr<CrossJobElementCache> cache_;
+  int64_t next_index_ = 0;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_CROSS_JOB_CACHE_H_
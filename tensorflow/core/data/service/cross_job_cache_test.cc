@@ -0,0 +1,159 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/cross_job_cache.h"
+
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/data/service/task_runner.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Produces the scalars 0, 1, 2, ... and counts the produced elements.
+class RangeTaskIterator : public TaskIterator {
+ public:
+  explicit RangeTaskIterator(int64_t* num_produced)
+      : num_produced_(num_produced) {}
+
+  Status GetNext(std::vector<Tensor>& element, bool& end_of_sequence) override {
+    element = {Tensor(next_++)};
+    end_of_sequence = false;
+    ++*num_produced_;
+    return Status::OK();
+  }
+
+  int64_t Cardinality() const override { return kInfiniteCardinality; }
+
+ private:
+  int64_t next_ = 0;
+  int64_t* const num_produced_;
+};
+
+class ErrorTaskIterator : public TaskIterator {
+ public:
+  Status GetNext(std::vector<Tensor>& element, bool& end_of_sequence) override {
+    return errors::Internal("Failed to produce an element.");
+  }
+
+  int64_t Cardinality() const override { return kInfiniteCardinality; }
+};
+
+int64_t GetValue(TaskIterator& iterator) {
+  std::vector<Tensor> element;
+  bool end_of_sequence;
+  TF_CHECK_OK(iterator.GetNext(element, end_of_sequence));
+  CHECK(!end_of_sequence);
+  return element[0].scalar<int64_t>()();
+}
+
+TEST(CrossJobElementCacheTest, ReadersShareElements) {
+  int64_t num_produced = 0;
+  auto cache = std::make_shared<CrossJobElementCache>(
+      absl::make_unique<RangeTaskIterator>(&num_produced),
+      /*max_size_bytes=*/1 << 20);
+  CachedTaskIterator reader1(cache), reader2(cache);
+  for (int64_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(GetValue(reader1), i);
+  }
+  for (int64_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(GetValue(reader2), i);
+  }
+  EXPECT_EQ(num_produced, 10);
+  EXPECT_EQ(cache->SizeBytes(), 10 * sizeof(int64_t));
+  EXPECT_EQ(reader1.Cardinality(), kInfiniteCardinality);
+}
+
+TEST(CrossJobElementCacheTest, SlowReaderSkipsEvictedElements) {
+  int64_t num_produced = 0;
+  auto cache = std::make_shared<CrossJobElementCache>(
+      absl::make_unique<RangeTaskIterator>(&num_produced),
+      /*max_size_bytes=*/5 * sizeof(int64_t));
+  CachedTaskIterator fast_reader(cache), slow_reader(cache);
+  EXPECT_EQ(GetValue(slow_reader), 0);
+  for (int64_t i = 0; i < 20; ++i) {
+    EXPECT_EQ(GetValue(fast_reader), i);
+  }
+  EXPECT_EQ(cache->SizeBytes(), 5 * sizeof(int64_t));
+  // Elements 1 to 14 were evicted.
+  EXPECT_EQ(GetValue(slow_reader), 15);
+  EXPECT_EQ(GetValue(slow_reader), 16);
+  EXPECT_EQ(num_produced, 20);
+}
+
+TEST(CrossJobElementCacheTest, NewestElementIsNeverEvicted) {
+  int64_t num_produced = 0;
+  auto cache = std::make_shared<CrossJobElementCache>(
+      absl::make_unique<RangeTaskIterator>(&num_produced),
+      /*max_size_bytes=*/0);
+  CachedTaskIterator reader1(cache), reader2(cache);
+  EXPECT_EQ(GetValue(reader1), 0);
+  EXPECT_EQ(GetValue(reader2), 0);
+  EXPECT_EQ(GetValue(reader1), 1);
+  EXPECT_EQ(GetValue(reader2), 1);
+  EXPECT_EQ(num_produced, 2);
+}
+
+TEST(CrossJobElementCacheTest, ConcurrentReaders) {
+  int64_t num_produced = 0;
+  auto cache = std::make_shared<CrossJobElementCache>(
+      absl::make_unique<RangeTaskIterator>(&num_produced),
+      /*max_size_bytes=*/1 << 20);
+  constexpr int kNumReaders = 8;
+  constexpr int kNumElements = 1000;
+  std::vector<std::vector<int64_t>> values(kNumReaders);
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 0; i < kNumReaders; ++i) {
+      threads.push_back(absl::WrapUnique(Env::Default()->StartThread(
+          /*thread_options=*/{}, /*name=*/"reader", [&cache, &values, i]() {
+            CachedTaskIterator reader(cache);
+            for (int j = 0; j < kNumElements; ++j) {
+              values[i].push_back(GetValue(reader));
+            }
+          })));
+    }
+  }
+  std::vector<int64_t> expected(kNumElements);
+  for (int j = 0; j < kNumElements; ++j) {
+    expected[j] = j;
+  }
+  for (int i = 0; i < kNumReaders; ++i) {
+    EXPECT_EQ(values[i], expected);
+  }
+  EXPECT_EQ(num_produced, kNumElements);
+}
+
+TEST(CrossJobElementCacheTest, Error) {
+  auto cache = std::make_shared<CrossJobElementCache>(
+      absl::make_unique<ErrorTaskIterator>(), /*max_size_bytes=*/1 << 20);
+  CachedTaskIterator reader1(cache), reader2(cache);
+  std::vector<Tensor> element;
+  bool end_of_sequence;
+  EXPECT_TRUE(errors::IsInternal(reader1.GetNext(element, end_of_sequence)));
+  EXPECT_TRUE(errors::IsInternal(reader2.GetNext(element, end_of_sequence)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
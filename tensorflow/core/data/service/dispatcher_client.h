@@ -59,9 +59,10 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   Status GetDatasetDef(int64_t dataset_id, DatasetDef& dataset_def);
 
   // Gets the next split for the specified job id, repetition, and split
-  // provider index.
+  // provider index, for the worker at `worker_address`.
   Status GetSplit(int64_t job_id, int64_t repetition,
-                  int64_t split_provider_index, Tensor& split,
+                  int64_t split_provider_index,
+                  const std::string& worker_address, Tensor& split,
                   bool& end_of_splits);
 
   // Registers a dataset with the tf.data service, and stores the generated
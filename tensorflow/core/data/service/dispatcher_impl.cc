@@ -41,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/dispatcher_state.h"
 #include "tensorflow/core/data/service/grpc_util.h"
 #include "tensorflow/core/data/service/journal.h"
+#include "tensorflow/core/data/service/split_assigner.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -73,6 +74,11 @@ constexpr char kDatasetsDir[] = "datasets";
 constexpr int64_t kDefaultJobGcCheckIntervalMs = 10 * 60 * 1000;  // 10 minutes.
 constexpr int64_t kDefaultJobGcTimeoutMs = 5 * 60 * 1000;         // 5 minutes.
 constexpr int64_t kDefaultClientTimeoutMs = 2 * 60 * 1000;        // 2 minutes.
+constexpr int64_t kDefaultJournalCompactionUpdates = 100 * 1000;
+// Splits read ahead to give workers splits they read before. Fault tolerant
+// dispatchers hand out splits in order, since they restore split providers by
+// the number of splits produced.
+constexpr int64_t kSplitLookahead = 16;
 
 constexpr std::array<const char*, 8> kNodeNameSharingOps = {
     "HashTable",
@@ -96,6 +102,22 @@ std::string JournalDir(const std::string& work_dir) {
   return io::JoinPath(work_dir, kJournalDir);
 }
 
+// Reads the journal files from `start_sequence_number` into `updates`.
+Status ReadJournal(Env* env, const std::string& journal_dir,
+                   int64_t start_sequence_number,
+                   std::vector<Update>& updates) {
+  FileJournalReader reader(env, journal_dir, start_sequence_number);
+  while (true) {
+    Update update;
+    bool end_of_journal = false;
+    TF_RETURN_IF_ERROR(reader.Read(update, end_of_journal));
+    if (end_of_journal) {
+      return Status::OK();
+    }
+    updates.push_back(std::move(update));
+  }
+}
+
 std::string DatasetsDir(const std::string& work_dir) {
   return io::JoinPath(work_dir, kDatasetsDir);
 }
@@ -144,6 +166,10 @@ DispatcherConfig ApplyConfigDefaults(const DispatcherConfig& config) {
   if (new_config.client_timeout_ms() == 0) {
     new_config.set_client_timeout_ms(kDefaultClientTimeoutMs);
   }
+  if (new_config.journal_compaction_updates() == 0) {
+    new_config.set_journal_compaction_updates(
+        kDefaultJournalCompactionUpdates);
+  }
   return new_config;
 }
 
@@ -167,8 +193,10 @@ DataServiceDispatcherImpl::~DataServiceDispatcherImpl() {
     mutex_lock l(mu_);
     cancelled_ = true;
     job_gc_thread_cv_.notify_all();
+    journal_compaction_thread_cv_.notify_all();
   }
   job_gc_thread_.reset();
+  journal_compaction_thread_.reset();
 }
 
 Status DataServiceDispatcherImpl::Start() {
@@ -196,24 +224,13 @@ Status DataServiceDispatcherImpl::Start() {
       env_, JournalDir(config_.work_dir()));
   LOG(INFO) << "Attempting to restore dispatcher state from journal in "
             << JournalDir(config_.work_dir());
-  Update update;
-  bool end_of_journal = false;
-  FileJournalReader reader(env_, JournalDir(config_.work_dir()));
-  Status s = reader.Read(update, end_of_journal);
-  if (errors::IsNotFound(s)) {
-    LOG(INFO) << "No journal found. Starting dispatcher from new state.";
-  } else if (!s.ok()) {
-    return s;
-  } else {
-    while (!end_of_journal) {
-      TF_RETURN_IF_ERROR(ApplyWithoutJournaling(update));
-      TF_RETURN_IF_ERROR(reader.Read(update, end_of_journal));
-    }
-  }
+  TF_RETURN_IF_ERROR(RestoreState());
   for (const auto& job : state_.ListJobs()) {
     if (IsDynamicShard(job->processing_mode)) {
-      TF_RETURN_IF_ERROR(
-          RestoreSplitProviders(*job, split_providers_[job->job_id]));
+      std::vector<std::unique_ptr<SplitProvider>> split_providers;
+      TF_RETURN_IF_ERROR(RestoreSplitProviders(*job, split_providers));
+      split_assigners_[job->job_id] =
+          MakeSplitAssigners(std::move(split_providers));
     }
   }
   for (const auto& client_id : state_.ListActiveClientIds()) {
@@ -225,10 +242,97 @@ Status DataServiceDispatcherImpl::Start() {
   // Initialize the journal writer in `Start` so that we fail fast in case it
   // can't be initialized.
   TF_RETURN_IF_ERROR(journal_writer_.value()->EnsureInitialized());
+  if (config_.journal_compaction_updates() > 0) {
+    journal_compaction_thread_ = absl::WrapUnique(
+        env_->StartThread({}, "journal-compaction-thread",
+                          [&] { JournalCompactionThread(); }));
+  }
   started_ = true;
   return Status::OK();
 }
 
+Status DataServiceDispatcherImpl::RestoreState()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  const std::string journal_dir = JournalDir(config_.work_dir());
+  int64_t start_sequence_number = 0;
+  Status snapshot_status =
+      LatestJournalSnapshot(env_, journal_dir, start_sequence_number);
+  const bool has_snapshot = snapshot_status.ok();
+  if (!has_snapshot && !errors::IsNotFound(snapshot_status)) {
+    return snapshot_status;
+  }
+  std::vector<Update> updates;
+  Status journal_status;
+  {
+    // Reads the journal after the snapshot while the snapshot is restored.
+    std::unique_ptr<Thread> reader_thread(env_->StartThread(
+        {}, "journal-reader-thread", [&, start_sequence_number] {
+          journal_status =
+              ReadJournal(env_, journal_dir, start_sequence_number, updates);
+        }));
+    if (has_snapshot) {
+      DispatcherStateSnapshot snapshot;
+      snapshot_status = ReadJournalSnapshot(env_, journal_dir,
+                                            start_sequence_number, snapshot);
+      if (snapshot_status.ok()) {
+        snapshot_status = state_.Restore(snapshot);
+      }
+    }
+  }
+  TF_RETURN_IF_ERROR(snapshot_status);
+  if (errors::IsNotFound(journal_status)) {
+    if (!has_snapshot) {
+      LOG(INFO) << "No journal found. Starting dispatcher from new state.";
+      return Status::OK();
+    }
+  } else {
+    TF_RETURN_IF_ERROR(journal_status);
+  }
+  for (const Update& update : updates) {
+    TF_RETURN_IF_ERROR(ApplyWithoutJournaling(update));
+  }
+  LOG(INFO) << "Restored dispatcher state from "
+            << (has_snapshot ? "a snapshot and " : "") << updates.size()
+            << " journal updates.";
+  return Status::OK();
+}
+
+Status DataServiceDispatcherImpl::CompactJournal()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  updates_since_compaction_ = 0;
+  TF_ASSIGN_OR_RETURN(pending_snapshot_sequence_number_,
+                      journal_writer_.value()->Rotate());
+  pending_snapshot_ = absl::make_unique<DispatcherStateSnapshot>();
+  state_.Snapshot(*pending_snapshot_);
+  journal_compaction_thread_cv_.notify_all();
+  return Status::OK();
+}
+
+void DataServiceDispatcherImpl::JournalCompactionThread() {
+  const std::string journal_dir = JournalDir(config_.work_dir());
+  while (true) {
+    std::unique_ptr<DispatcherStateSnapshot> snapshot;
+    int64_t sequence_number;
+    {
+      mutex_lock l(mu_);
+      while (!cancelled_ && !pending_snapshot_) {
+        journal_compaction_thread_cv_.wait(l);
+      }
+      if (cancelled_) {
+        return;
+      }
+      snapshot = std::move(pending_snapshot_);
+      sequence_number = pending_snapshot_sequence_number_;
+    }
+    // The journal stays readable from the previous snapshot if this fails.
+    Status s =
+        WriteJournalSnapshot(env_, journal_dir, sequence_number, *snapshot);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to compact the dispatcher journal: " << s;
+    }
+  }
+}
+
 size_t DataServiceDispatcherImpl::NumActiveJobs() TF_LOCKS_EXCLUDED(mu_) {
   mutex_lock l(mu_);
   int64 count = 0;
@@ -410,18 +514,25 @@ Status DataServiceDispatcherImpl::GetSplit(const GetSplitRequest* request,
             << " is greater than the requested repetition " << repetition;
     return Status::OK();
   }
-  SplitProvider* split_provider =
-      split_providers_[job_id][provider_index].get();
-  DCHECK(split_provider != nullptr);
+  SplitAssigner* split_assigner =
+      split_assigners_[job_id][provider_index].get();
+  DCHECK(split_assigner != nullptr);
+  std::vector<std::string> worker_tags;
+  std::shared_ptr<const Worker> worker;
+  if (state_.WorkerFromAddress(request->worker_address(), worker).ok()) {
+    worker_tags = worker->tags;
+  }
   Tensor split;
   bool end_of_splits = false;
-  TF_RETURN_IF_ERROR(split_provider->GetNext(&split, &end_of_splits));
+  TF_RETURN_IF_ERROR(split_assigner->GetNext(
+      GetWorkerLocation(request->worker_address(), worker_tags),
+      env_->NowMicros(), split, end_of_splits));
   TF_RETURN_IF_ERROR(RecordSplitProduced(
       job_id, repetition, request->split_provider_index(), end_of_splits));
   response->set_end_of_splits(end_of_splits);
   if (end_of_splits) {
-    // Reset the split provider to prepare for the next repetition.
-    TF_RETURN_IF_ERROR(split_providers_[job_id][provider_index]->Reset());
+    // Reset the split assigner to prepare for the next repetition.
+    TF_RETURN_IF_ERROR(split_assigner->Reset());
   } else {
     split.AsProtoTensorContent(response->mutable_split());
   }
@@ -445,6 +556,19 @@ Status DataServiceDispatcherImpl::MakeSplitProviders(
   return Status::OK();
 }
 
+std::vector<std::unique_ptr<SplitAssigner>>
+DataServiceDispatcherImpl::MakeSplitAssigners(
+    std::vector<std::unique_ptr<SplitProvider>> split_providers) {
+  int64_t lookahead = config_.fault_tolerant_mode() ? 1 : kSplitLookahead;
+  std::vector<std::unique_ptr<SplitAssigner>> split_assigners;
+  split_assigners.reserve(split_providers.size());
+  for (auto& split_provider : split_providers) {
+    split_assigners.push_back(
+        absl::make_unique<SplitAssigner>(std::move(split_provider), lookahead));
+  }
+  return split_assigners;
+}
+
 Status DataServiceDispatcherImpl::GetVersion(const GetVersionRequest* request,
                                              GetVersionResponse* response) {
   response->set_version(kDataServiceVersion);
@@ -687,9 +811,11 @@ Status DataServiceDispatcherImpl::CreateJob(
   int64_t job_id = state_.NextAvailableJobId();
   int64_t num_split_providers = 0;
   if (IsDynamicShard(request.processing_mode_def())) {
+    std::vector<std::unique_ptr<SplitProvider>> split_providers;
     TF_RETURN_IF_ERROR(
-        MakeSplitProviders(request.dataset_id(), split_providers_[job_id]));
-    num_split_providers = split_providers_[job_id].size();
+        MakeSplitProviders(request.dataset_id(), split_providers));
+    num_split_providers = split_providers.size();
+    split_assigners_[job_id] = MakeSplitAssigners(std::move(split_providers));
   }
   Update update;
   CreateJobUpdate* create_job = update.mutable_create_job();
@@ -1036,7 +1162,17 @@ Status DataServiceDispatcherImpl::Apply(const Update& update)
   if (journal_writer_.has_value()) {
     TF_RETURN_IF_ERROR(journal_writer_.value()->Write(update));
   }
-  return state_.Apply(update);
+  TF_RETURN_IF_ERROR(state_.Apply(update));
+  if (journal_compaction_thread_ &&
+      ++updates_since_compaction_ >= config_.journal_compaction_updates()) {
+    // The update is already journaled and applied, so a failure to compact
+    // only delays the compaction.
+    Status s = CompactJournal();
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to compact the dispatcher journal: " << s;
+    }
+  }
+  return Status::OK();
 }
 
 void DataServiceDispatcherImpl::JobGcThread() {
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/dataset_store.h"
 #include "tensorflow/core/data/service/dispatcher.pb.h"
 #include "tensorflow/core/data/service/dispatcher_state.h"
+#include "tensorflow/core/data/service/split_assigner.h"
 #include "tensorflow/core/data/service/task_remover.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -183,6 +184,9 @@ class DataServiceDispatcherImpl {
       int64_t dataset_id,
       std::vector<std::unique_ptr<SplitProvider>>& split_providers)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Makes split assigners handing out the splits of `split_providers`.
+  std::vector<std::unique_ptr<SplitAssigner>> MakeSplitAssigners(
+      std::vector<std::unique_ptr<SplitProvider>> split_providers);
   // Registers a dataset with the given fingerprint, storing the new dataset's
   // id in `dataset_id`.
   Status RegisterDataset(uint64 fingerprint, const DatasetDef& dataset,
@@ -276,6 +280,14 @@ class DataServiceDispatcherImpl {
   // used when recovering state when the dispatcher starts.
   Status ApplyWithoutJournaling(const Update& update)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Restores the state from the latest journal snapshot and the journal after
+  // it, which is read concurrently with the restoring of the snapshot.
+  Status RestoreState() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Rotates the journal, and queues a snapshot of the state for the journal
+  // compaction thread to replace the previous journal files with.
+  Status CompactJournal() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // A thread which writes the queued journal snapshots.
+  void JournalCompactionThread();
   // A thread which periodically checks for jobs to clean up.
   void JobGcThread();
   // Releases job clients that haven't heartbeated recently.
@@ -305,9 +317,10 @@ class DataServiceDispatcherImpl {
       worker_stubs_ TF_GUARDED_BY(mu_);
   // Store of dataset definitions.
   std::unique_ptr<DatasetStore> dataset_store_ TF_GUARDED_BY(mu_);
-  // Mapping from job id to the split providers for the job.
-  absl::flat_hash_map<int64_t, std::vector<std::unique_ptr<SplitProvider>>>
-      split_providers_ TF_GUARDED_BY(mu_);
+  // Mapping from job id to the split assigners for the job, one per split
+  // provider.
+  absl::flat_hash_map<int64_t, std::vector<std::unique_ptr<SplitAssigner>>>
+      split_assigners_ TF_GUARDED_BY(mu_);
   // Mapping from round robin job id to the round the job is currently on. This
   // is based on the data provided by client heartbeats, and may be stale.
   absl::flat_hash_map<int64_t, int64_t> round_robin_rounds_ TF_GUARDED_BY(mu_);
@@ -325,6 +338,17 @@ class DataServiceDispatcherImpl {
   condition_variable job_gc_thread_cv_;
   std::unique_ptr<Thread> job_gc_thread_;
 
+  // Number of updates journaled since the journal was last compacted.
+  int64_t updates_since_compaction_ TF_GUARDED_BY(mu_) = 0;
+  // Snapshot to be written by the journal compaction thread, which replaces
+  // the journal files before `pending_snapshot_sequence_number_`.
+  std::unique_ptr<DispatcherStateSnapshot> pending_snapshot_
+      TF_GUARDED_BY(mu_);
+  int64_t pending_snapshot_sequence_number_ TF_GUARDED_BY(mu_) = 0;
+  // Condition variable for waking up the journal compaction thread.
+  condition_variable journal_compaction_thread_cv_;
+  std::unique_ptr<Thread> journal_compaction_thread_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(DataServiceDispatcherImpl);
 };
 
@@ -14,8 +14,12 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/service/dispatcher_state.h"
 
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -87,6 +91,204 @@ Status DispatcherState::Apply(const Update& update) {
   return Status::OK();
 }
 
+void DispatcherState::Snapshot(DispatcherStateSnapshot& snapshot) const {
+  snapshot.Clear();
+  snapshot.set_next_available_dataset_id(next_available_dataset_id_);
+  snapshot.set_next_available_job_id(next_available_job_id_);
+  snapshot.set_next_available_job_client_id(next_available_job_client_id_);
+  snapshot.set_next_available_task_id(next_available_task_id_);
+  for (const auto& it : datasets_by_id_) {
+    RegisterDatasetUpdate* dataset = snapshot.add_datasets();
+    dataset->set_dataset_id(it.second->dataset_id);
+    dataset->set_fingerprint(it.second->fingerprint);
+    *dataset->mutable_metadata() = it.second->metadata;
+  }
+  for (const auto& it : id_element_spec_info_) {
+    SetElementSpecUpdate* element_spec = snapshot.add_element_specs();
+    element_spec->set_dataset_id(it.first);
+    element_spec->set_element_spec(it.second);
+  }
+
+  std::vector<std::pair<int64_t, std::shared_ptr<Worker>>> workers;
+  for (const auto& it : workers_) {
+    StatusOr<int64_t> index = worker_index_resolver_.GetWorkerIndex(it.first);
+    workers.emplace_back(
+        index.ok() ? index.ValueOrDie() : std::numeric_limits<int64_t>::max(),
+        it.second);
+  }
+  std::sort(workers.begin(), workers.end(),
+            [](const auto& a, const auto& b) {
+              return a.first != b.first ? a.first < b.first
+                                        : a.second->address < b.second->address;
+            });
+  for (const auto& index_and_worker : workers) {
+    const Worker& worker = *index_and_worker.second;
+    RegisterWorkerUpdate* register_worker = snapshot.add_workers();
+    register_worker->set_worker_address(worker.address);
+    register_worker->set_transfer_address(worker.transfer_address);
+    *register_worker->mutable_worker_tags() = {worker.tags.begin(),
+                                               worker.tags.end()};
+  }
+
+  std::vector<int64_t> job_ids;
+  for (const auto& it : jobs_) {
+    job_ids.push_back(it.first);
+  }
+  std::sort(job_ids.begin(), job_ids.end());
+  for (int64_t job_id : job_ids) {
+    const Job& job = *jobs_.at(job_id);
+    JobSnapshot* job_snapshot = snapshot.add_jobs();
+    CreateJobUpdate* create_job = job_snapshot->mutable_create_job();
+    create_job->set_job_id(job.job_id);
+    create_job->set_dataset_id(job.dataset_id);
+    *create_job->mutable_processing_mode_def() = job.processing_mode;
+    if (job.named_job_key.has_value()) {
+      create_job->mutable_named_job_key()->set_name(job.named_job_key->name);
+      create_job->mutable_named_job_key()->set_index(job.named_job_key->index);
+    }
+    if (job.num_consumers.has_value()) {
+      create_job->set_num_consumers(job.num_consumers.value());
+    }
+    create_job->set_target_workers(job.target_workers);
+    if (job.distributed_epoch_state.has_value()) {
+      const DistributedEpochState& state = job.distributed_epoch_state.value();
+      create_job->set_num_split_providers(state.repetitions.size());
+      *job_snapshot->mutable_repetitions() = {state.repetitions.begin(),
+                                              state.repetitions.end()};
+      *job_snapshot->mutable_split_indices() = {state.indices.begin(),
+                                                state.indices.end()};
+    }
+    for (const auto& task : tasks_by_job_.at(job_id)) {
+      TaskSnapshot* task_snapshot = job_snapshot->add_tasks();
+      CreateTaskUpdate* create_task = task_snapshot->mutable_create_task();
+      create_task->set_task_id(task->task_id);
+      create_task->set_job_id(job_id);
+      create_task->set_worker_address(task->worker_address);
+      create_task->set_transfer_address(task->transfer_address);
+      *create_task->mutable_worker_tags() = {task->worker_tags.begin(),
+                                             task->worker_tags.end()};
+      task_snapshot->set_starting_round(task->starting_round);
+      task_snapshot->set_finished(task->finished);
+    }
+    std::queue<PendingTask> pending_tasks = job.pending_tasks;
+    for (; !pending_tasks.empty(); pending_tasks.pop()) {
+      const PendingTask& pending_task = pending_tasks.front();
+      const Task& task = *pending_task.task;
+      PendingTaskSnapshot* pending_snapshot = job_snapshot->add_pending_tasks();
+      CreatePendingTaskUpdate* create_pending_task =
+          pending_snapshot->mutable_create_pending_task();
+      create_pending_task->set_task_id(task.task_id);
+      create_pending_task->set_job_id(job_id);
+      create_pending_task->set_worker_address(task.worker_address);
+      create_pending_task->set_transfer_address(task.transfer_address);
+      *create_pending_task->mutable_worker_tags() = {task.worker_tags.begin(),
+                                                     task.worker_tags.end()};
+      pending_snapshot->set_target_round(pending_task.target_round);
+      *pending_snapshot->mutable_ready_consumers() = {
+          pending_task.ready_consumers.begin(),
+          pending_task.ready_consumers.end()};
+      pending_snapshot->set_failures(pending_task.failures);
+      pending_snapshot->set_removed(task.removed);
+    }
+    job_snapshot->set_num_clients(job.num_clients);
+    job_snapshot->set_last_client_released_micros(
+        job.last_client_released_micros);
+    job_snapshot->set_finished(job.finished);
+    job_snapshot->set_garbage_collected(job.garbage_collected);
+  }
+
+  for (const auto& it : jobs_for_client_ids_) {
+    // `JobForJobClientId` may leave null entries for unknown clients.
+    if (!it.second) {
+      continue;
+    }
+    AcquireJobClientUpdate* job_client = snapshot.add_job_clients();
+    job_client->set_job_client_id(it.first);
+    job_client->set_job_id(it.second->job_id);
+  }
+}
+
+Status DispatcherState::Restore(const DispatcherStateSnapshot& snapshot) {
+  if (!datasets_by_id_.empty() || !workers_.empty() || !jobs_.empty()) {
+    return errors::FailedPrecondition(
+        "Dispatcher state can only be restored before updates are applied.");
+  }
+  for (const auto& dataset : snapshot.datasets()) {
+    RegisterDataset(dataset);
+  }
+  for (const auto& element_spec : snapshot.element_specs()) {
+    SetElementSpec(element_spec);
+  }
+  for (const auto& worker : snapshot.workers()) {
+    RegisterWorker(worker);
+  }
+
+  for (const auto& job_snapshot : snapshot.jobs()) {
+    const int64_t job_id = job_snapshot.create_job().job_id();
+    CreateJob(job_snapshot.create_job());
+    std::shared_ptr<Job> job = jobs_[job_id];
+    if (job->distributed_epoch_state.has_value()) {
+      DistributedEpochState& state = job->distributed_epoch_state.value();
+      if (static_cast<size_t>(job_snapshot.repetitions_size()) !=
+              state.repetitions.size() ||
+          static_cast<size_t>(job_snapshot.split_indices_size()) !=
+              state.indices.size()) {
+        return errors::DataLoss("Inconsistent split providers in snapshot of ",
+                                "job ", job_id);
+      }
+      state.repetitions.assign(job_snapshot.repetitions().begin(),
+                               job_snapshot.repetitions().end());
+      state.indices.assign(job_snapshot.split_indices().begin(),
+                           job_snapshot.split_indices().end());
+    }
+    for (const auto& task_snapshot : job_snapshot.tasks()) {
+      CreateTask(task_snapshot.create_task());
+      std::shared_ptr<Task>& task =
+          tasks_[task_snapshot.create_task().task_id()];
+      task->starting_round = task_snapshot.starting_round();
+      if (task_snapshot.finished()) {
+        task->finished = true;
+        tasks_by_worker_[task->worker_address].erase(task->task_id);
+      }
+    }
+    for (const auto& pending_snapshot : job_snapshot.pending_tasks()) {
+      CreatePendingTask(pending_snapshot.create_pending_task());
+      PendingTask& pending_task = job->pending_tasks.back();
+      pending_task.target_round = pending_snapshot.target_round();
+      pending_task.ready_consumers.insert(
+          pending_snapshot.ready_consumers().begin(),
+          pending_snapshot.ready_consumers().end());
+      pending_task.failures = pending_snapshot.failures();
+      if (pending_snapshot.removed()) {
+        const Task& task = *pending_task.task;
+        pending_task.task->removed = true;
+        tasks_by_worker_[task.worker_address].erase(task.task_id);
+        tasks_.erase(task.task_id);
+      }
+    }
+    job->num_clients = job_snapshot.num_clients();
+    job->last_client_released_micros =
+        job_snapshot.last_client_released_micros();
+    job->finished = job_snapshot.finished();
+    job->garbage_collected = job_snapshot.garbage_collected();
+  }
+
+  for (const auto& job_client : snapshot.job_clients()) {
+    auto it = jobs_.find(job_client.job_id());
+    if (it == jobs_.end()) {
+      return errors::DataLoss("Unknown job ", job_client.job_id(),
+                              " of job client ", job_client.job_client_id(),
+                              " in snapshot");
+    }
+    jobs_for_client_ids_[job_client.job_client_id()] = it->second;
+  }
+  next_available_dataset_id_ = snapshot.next_available_dataset_id();
+  next_available_job_id_ = snapshot.next_available_job_id();
+  next_available_job_client_id_ = snapshot.next_available_job_client_id();
+  next_available_task_id_ = snapshot.next_available_task_id();
+  return Status::OK();
+}
+
 void DispatcherState::RegisterDataset(
     const RegisterDatasetUpdate& register_dataset) {
   int64_t id = register_dataset.dataset_id();
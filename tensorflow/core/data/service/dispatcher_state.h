@@ -72,6 +72,13 @@ class DispatcherState {
   // Applies the given update to the dispatcher's state.
   Status Apply(const Update& update);
 
+  // Stores a snapshot of the state in `snapshot`, from which `Restore` can
+  // recreate the state without replaying the updates that led to it.
+  void Snapshot(DispatcherStateSnapshot& snapshot) const;
+  // Restores the state from `snapshot`. Must be called before any update is
+  // applied.
+  Status Restore(const DispatcherStateSnapshot& snapshot);
+
   // A dataset registered with the dispatcher.
   struct Dataset {
     explicit Dataset(int64_t dataset_id, int64_t fingerprint,
@@ -621,5 +621,71 @@ TEST(DispatcherState, ListActiveClients) {
   EXPECT_THAT(state.ListActiveClientIds(), UnorderedElementsAre(6, 8));
 }
 
+TEST(DispatcherState, SnapshotAndRestore) {
+  DispatcherState state;
+  TF_ASSERT_OK(RegisterDataset(/*id=*/10, /*fingerprint=*/1, state));
+  TF_ASSERT_OK(RegisterDataset(/*id=*/11, /*fingerprint=*/2, state));
+  TF_ASSERT_OK(SetElementSpec(/*dataset_id=*/10, "element_spec", state));
+  TF_ASSERT_OK(RegisterWorker("worker_a", state));
+  TF_ASSERT_OK(RegisterWorker("worker_b", state));
+  TF_ASSERT_OK(CreateNamedJob(/*job_id=*/3, /*dataset_id=*/10,
+                              NamedJobKey("job", 0), state));
+  TF_ASSERT_OK(CreateAnonymousJob(/*job_id=*/4, /*dataset_id=*/11, state));
+  TF_ASSERT_OK(CreateTask(/*task_id=*/20, /*job_id=*/3, "worker_a", state));
+  TF_ASSERT_OK(CreateTask(/*task_id=*/21, /*job_id=*/3, "worker_b", state));
+  TF_ASSERT_OK(FinishTask(/*task_id=*/21, state));
+  TF_ASSERT_OK(AcquireJobClientId(/*job_id=*/3, /*job_client_id=*/6, state));
+  TF_ASSERT_OK(AcquireJobClientId(/*job_id=*/4, /*job_client_id=*/7, state));
+  TF_ASSERT_OK(ReleaseJobClientId(/*job_client_id=*/7, /*release_time=*/100,
+                                  state));
+  DispatcherStateSnapshot snapshot;
+  state.Snapshot(snapshot);
+
+  DispatcherState restored;
+  TF_ASSERT_OK(restored.Restore(snapshot));
+  EXPECT_EQ(restored.NextAvailableDatasetId(), state.NextAvailableDatasetId());
+  EXPECT_EQ(restored.NextAvailableJobId(), state.NextAvailableJobId());
+  EXPECT_EQ(restored.NextAvailableJobClientId(),
+            state.NextAvailableJobClientId());
+  EXPECT_EQ(restored.NextAvailableTaskId(), state.NextAvailableTaskId());
+  std::shared_ptr<const Dataset> dataset;
+  TF_EXPECT_OK(restored.DatasetFromFingerprint(2, dataset));
+  EXPECT_EQ(dataset->dataset_id, 11);
+  std::string element_spec;
+  TF_EXPECT_OK(restored.GetElementSpec(10, element_spec));
+  EXPECT_EQ(element_spec, "element_spec");
+  EXPECT_THAT(restored.ListWorkers(), SizeIs(2));
+
+  std::shared_ptr<const Job> job;
+  TF_ASSERT_OK(restored.NamedJobByKey(NamedJobKey("job", 0), job));
+  EXPECT_EQ(job->job_id, 3);
+  EXPECT_EQ(job->num_clients, 1);
+  EXPECT_FALSE(job->finished);
+  std::vector<std::shared_ptr<const Task>> tasks;
+  TF_ASSERT_OK(restored.TasksForJob(3, tasks));
+  ASSERT_THAT(tasks, SizeIs(2));
+  EXPECT_EQ(tasks[0]->task_id, 20);
+  EXPECT_FALSE(tasks[0]->finished);
+  EXPECT_TRUE(tasks[1]->finished);
+  TF_ASSERT_OK(restored.TasksForWorker("worker_b", tasks));
+  EXPECT_THAT(tasks, IsEmpty());
+  TF_ASSERT_OK(restored.JobFromId(4, job));
+  EXPECT_EQ(job->num_clients, 0);
+  EXPECT_EQ(job->last_client_released_micros, 100);
+  EXPECT_THAT(restored.ListActiveClientIds(), UnorderedElementsAre(6));
+
+  // Updates apply to the restored state as to the original one.
+  TF_ASSERT_OK(FinishTask(/*task_id=*/20, restored));
+  TF_ASSERT_OK(restored.JobFromId(3, job));
+  EXPECT_TRUE(job->finished);
+}
+
+TEST(DispatcherState, RestoreNonEmptyState) {
+  DispatcherState state;
+  TF_ASSERT_OK(RegisterDataset(/*id=*/10, state));
+  EXPECT_THAT(state.Restore(DispatcherStateSnapshot()),
+              StatusIs(error::FAILED_PRECONDITION));
+}
+
 }  // namespace data
 }  // namespace tensorflow
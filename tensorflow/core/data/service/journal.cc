@@ -15,7 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/journal.h"
 
+#include <string>
+#include <vector>
+
 #include "absl/memory/memory.h"
+#include "absl/strings/match.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
@@ -29,6 +33,8 @@ namespace data {
 
 namespace {
 constexpr StringPiece kJournal = "journal";
+constexpr StringPiece kSnapshot = "snapshot";
+constexpr StringPiece kTempSuffix = ".tmp";
 
 Status ParseSequenceNumber(const std::string& journal_file,
                            int64_t* sequence_number) {
@@ -38,6 +44,14 @@ Status ParseSequenceNumber(const std::string& journal_file,
   }
   return Status::OK();
 }
+
+// Returns true if `file` is a journal file, or a snapshot if `prefix` is
+// kSnapshot, and stores its sequence number.
+bool MatchSequenceFile(const std::string& file, StringPiece prefix,
+                       int64_t* sequence_number) {
+  return absl::StartsWith(file, absl::StrCat(prefix, "_")) &&
+         RE2::FullMatch(file, ".*_(\\d+)", sequence_number);
+}
 }  // namespace
 
 std::string DataServiceJournalFile(const std::string& journal_dir,
@@ -46,6 +60,77 @@ std::string DataServiceJournalFile(const std::string& journal_dir,
                       absl::StrCat(kJournal, "_", sequence_number));
 }
 
+std::string DataServiceJournalSnapshotFile(const std::string& journal_dir,
+                                           int64_t sequence_number) {
+  return io::JoinPath(journal_dir,
+                      absl::StrCat(kSnapshot, "_", sequence_number));
+}
+
+Status WriteJournalSnapshot(Env* env, const std::string& journal_dir,
+                            int64_t sequence_number,
+                            const DispatcherStateSnapshot& snapshot) {
+  std::string serialized;
+  if (!snapshot.SerializeToString(&serialized)) {
+    return errors::Internal("Failed to serialize the dispatcher state.");
+  }
+  const std::string snapshot_file =
+      DataServiceJournalSnapshotFile(journal_dir, sequence_number);
+  const std::string temp_file = absl::StrCat(snapshot_file, kTempSuffix);
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_RETURN_IF_ERROR(env->NewWritableFile(temp_file, &file));
+    TF_RETURN_IF_ERROR(file->Append(serialized));
+    TF_RETURN_IF_ERROR(file->Sync());
+    TF_RETURN_IF_ERROR(file->Close());
+  }
+  TF_RETURN_IF_ERROR(env->RenameFile(temp_file, snapshot_file));
+  VLOG(1) << "Wrote journal snapshot " << snapshot_file << " of "
+          << serialized.size() << " bytes";
+
+  std::vector<std::string> files;
+  TF_RETURN_IF_ERROR(env->GetChildren(journal_dir, &files));
+  for (const auto& file : files) {
+    int64_t file_sequence_number;
+    if ((MatchSequenceFile(file, kJournal, &file_sequence_number) ||
+         MatchSequenceFile(file, kSnapshot, &file_sequence_number)) &&
+        file_sequence_number < sequence_number) {
+      TF_RETURN_IF_ERROR(env->DeleteFile(io::JoinPath(journal_dir, file)));
+    }
+  }
+  return Status::OK();
+}
+
+Status LatestJournalSnapshot(Env* env, const std::string& journal_dir,
+                             int64_t& sequence_number) {
+  std::vector<std::string> files;
+  TF_RETURN_IF_ERROR(env->GetChildren(journal_dir, &files));
+  sequence_number = -1;
+  for (const auto& file : files) {
+    int64_t file_sequence_number;
+    if (MatchSequenceFile(file, kSnapshot, &file_sequence_number)) {
+      sequence_number = std::max(sequence_number, file_sequence_number);
+    }
+  }
+  if (sequence_number < 0) {
+    return errors::NotFound("No journal snapshot in ", journal_dir);
+  }
+  return Status::OK();
+}
+
+Status ReadJournalSnapshot(Env* env, const std::string& journal_dir,
+                           int64_t sequence_number,
+                           DispatcherStateSnapshot& snapshot) {
+  const std::string snapshot_file =
+      DataServiceJournalSnapshotFile(journal_dir, sequence_number);
+  std::string serialized;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, snapshot_file, &serialized));
+  if (!snapshot.ParseFromString(serialized)) {
+    return errors::DataLoss("Failed to parse journal snapshot ",
+                            snapshot_file);
+  }
+  return Status::OK();
+}
+
 FileJournalWriter::FileJournalWriter(Env* env, const std::string& journal_dir)
     : env_(env), journal_dir_(journal_dir) {}
 
@@ -58,18 +143,36 @@ Status FileJournalWriter::EnsureInitialized() {
   TF_RETURN_IF_ERROR(env_->GetChildren(journal_dir_, &journal_files));
   int64_t latest_sequence_number = -1;
   for (const auto& file : journal_files) {
+    if (absl::StartsWith(file, kSnapshot)) {
+      continue;
+    }
     int64_t sequence_number;
     TF_RETURN_IF_ERROR(ParseSequenceNumber(file, &sequence_number));
     latest_sequence_number = std::max(latest_sequence_number, sequence_number);
   }
+  return OpenFile(latest_sequence_number + 1);
+}
+
+Status FileJournalWriter::OpenFile(int64_t sequence_number) {
   std::string journal_file =
-      DataServiceJournalFile(journal_dir_, latest_sequence_number + 1);
+      DataServiceJournalFile(journal_dir_, sequence_number);
   TF_RETURN_IF_ERROR(env_->NewAppendableFile(journal_file, &file_));
   writer_ = absl::make_unique<io::RecordWriter>(file_.get());
+  sequence_number_ = sequence_number;
   VLOG(1) << "Created journal writer to write to " << journal_file;
   return Status::OK();
 }
 
+StatusOr<int64_t> FileJournalWriter::Rotate() {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  TF_RETURN_IF_ERROR(writer_->Close());
+  TF_RETURN_IF_ERROR(file_->Close());
+  writer_.reset();
+  file_.reset();
+  TF_RETURN_IF_ERROR(OpenFile(sequence_number_ + 1));
+  return sequence_number_;
+}
+
 Status FileJournalWriter::Write(const Update& update) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
   std::string s = update.SerializeAsString();
@@ -86,14 +189,17 @@ Status FileJournalWriter::Write(const Update& update) {
   return Status::OK();
 }
 
-FileJournalReader::FileJournalReader(Env* env, StringPiece journal_dir)
-    : env_(env), journal_dir_(journal_dir) {}
+FileJournalReader::FileJournalReader(Env* env, StringPiece journal_dir,
+                                     int64_t start_sequence_number)
+    : env_(env),
+      journal_dir_(journal_dir),
+      sequence_number_(start_sequence_number) {}
 
 Status FileJournalReader::EnsureInitialized() {
   if (reader_) {
     return Status::OK();
   }
-  return UpdateFile(DataServiceJournalFile(journal_dir_, 0));
+  return UpdateFile(DataServiceJournalFile(journal_dir_, sequence_number_));
 }
 
 Status FileJournalReader::Read(Update& update, bool& end_of_journal) {
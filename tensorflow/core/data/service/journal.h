@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/statusor.h"
 
 namespace tensorflow {
 namespace data {
@@ -28,6 +29,31 @@ namespace data {
 std::string DataServiceJournalFile(const std::string& journal_dir,
                                    int64_t sequence_number);
 
+// Returns the location of the snapshot of the dispatcher state which replaces
+// the journal files before `sequence_number`.
+std::string DataServiceJournalSnapshotFile(const std::string& journal_dir,
+                                           int64_t sequence_number);
+
+// Writes `snapshot` as the state after the journal files before
+// `sequence_number`, then deletes those files and the older snapshots. The
+// snapshot is synced to a temporary file before it is renamed, so that a
+// failure leaves the journal readable from the previous snapshot.
+Status WriteJournalSnapshot(Env* env, const std::string& journal_dir,
+                            int64_t sequence_number,
+                            const DispatcherStateSnapshot& snapshot);
+
+// Finds the latest snapshot in the journal directory, which replaces the
+// journal files before `sequence_number`. Returns NOT_FOUND if there is no
+// snapshot.
+Status LatestJournalSnapshot(Env* env, const std::string& journal_dir,
+                             int64_t& sequence_number);
+
+// Reads the snapshot which replaces the journal files before
+// `sequence_number`.
+Status ReadJournalSnapshot(Env* env, const std::string& journal_dir,
+                           int64_t sequence_number,
+                           DispatcherStateSnapshot& snapshot);
+
 // Interface for writing to a journal.
 class JournalWriter {
  public:
@@ -36,6 +62,9 @@ class JournalWriter {
   virtual Status Write(const Update& update) = 0;
   // Initializes the writer if it is not yet initialized.
   virtual Status EnsureInitialized() = 0;
+  // Closes the current journal file, so that later updates are written to a
+  // new one, and returns the sequence number of the new file.
+  virtual StatusOr<int64_t> Rotate() = 0;
 };
 
 // FileJournalWriter is not thread-safe, requiring external synchronization when
@@ -54,6 +83,10 @@ class JournalWriter {
 // "journal_0", "journal_1", and "journal_2", the writer will write to
 // "journal_3". The writer will flush updates as they are written, so that they
 // can be stored durably in case of machine failure.
+//
+// To compact the journal, the dispatcher rotates the writer and writes a
+// snapshot of its state at that point, e.g. "snapshot_4" replaces "journal_0"
+// to "journal_3", which are then deleted.
 class FileJournalWriter : public JournalWriter {
  public:
   // Creates a journal writer to write to the given journal directory.
@@ -65,10 +98,16 @@ class FileJournalWriter : public JournalWriter {
 
   Status Write(const Update& update) override;
   Status EnsureInitialized() override;
+  StatusOr<int64_t> Rotate() override;
 
  private:
+  // Opens the journal file to write to.
+  Status OpenFile(int64_t sequence_number);
+
   Env* env_;
   const std::string journal_dir_;
+  // Sequence number of current journal file.
+  int64_t sequence_number_ = 0;
   std::unique_ptr<WritableFile> file_;
   std::unique_ptr<io::RecordWriter> writer_;
 };
@@ -86,10 +125,12 @@ class JournalReader {
 // used by multiple threads.
 //
 // The journal reader reads through all journal files in the configured journal
-// directory, in order of their sequence numbers. See FileJournalWriter above.
+// directory from `start_sequence_number`, in order of their sequence numbers.
+// See FileJournalWriter above.
 class FileJournalReader : public JournalReader {
  public:
-  explicit FileJournalReader(Env* env, StringPiece journal_dir);
+  explicit FileJournalReader(Env* env, StringPiece journal_dir,
+                             int64_t start_sequence_number = 0);
   FileJournalReader(const FileJournalReader&) = delete;
   FileJournalReader& operator=(const FileJournalReader&) = delete;
 
@@ -104,7 +145,7 @@ class FileJournalReader : public JournalReader {
   Env* env_;
   const std::string journal_dir_;
   // Sequence number of current journal file.
-  int64_t sequence_number_ = 0;
+  int64_t sequence_number_;
   std::unique_ptr<RandomAccessFile> file_;
   std::unique_ptr<io::SequentialRecordReader> reader_;
 };
@@ -66,8 +66,9 @@ Update MakeRegisterDatasetUpdate() {
 }
 
 Status CheckJournalContent(StringPiece journal_dir,
-                           const std::vector<Update>& expected) {
-  FileJournalReader reader(Env::Default(), journal_dir);
+                           const std::vector<Update>& expected,
+                           int64_t start_sequence_number = 0) {
+  FileJournalReader reader(Env::Default(), journal_dir, start_sequence_number);
   for (const auto& update : expected) {
     Update result;
     bool end_of_journal = true;
@@ -113,6 +114,49 @@ TEST(Journal, AppendExistingJournal) {
   TF_EXPECT_OK(CheckJournalContent(journal_dir, updates));
 }
 
+TEST(Journal, CompactWithSnapshot) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  TF_ASSERT_OK(writer.Write(MakeCreateJobUpdate()));
+  TF_ASSERT_OK_AND_ASSIGN(int64_t sequence_number, writer.Rotate());
+  EXPECT_EQ(sequence_number, 1);
+  TF_ASSERT_OK(writer.Write(MakeFinishTaskUpdate()));
+
+  DispatcherStateSnapshot snapshot;
+  snapshot.set_next_available_job_id(9);
+  TF_ASSERT_OK(WriteJournalSnapshot(Env::Default(), journal_dir,
+                                    sequence_number, snapshot));
+  EXPECT_TRUE(errors::IsNotFound(Env::Default()->FileExists(
+      DataServiceJournalFile(journal_dir, /*sequence_number=*/0))));
+
+  int64_t latest_sequence_number;
+  TF_ASSERT_OK(LatestJournalSnapshot(Env::Default(), journal_dir,
+                                     latest_sequence_number));
+  EXPECT_EQ(latest_sequence_number, sequence_number);
+  DispatcherStateSnapshot result;
+  TF_ASSERT_OK(ReadJournalSnapshot(Env::Default(), journal_dir,
+                                   latest_sequence_number, result));
+  EXPECT_EQ(result.next_available_job_id(), 9);
+
+  // A new writer appends after the snapshot.
+  FileJournalWriter new_writer(Env::Default(), journal_dir);
+  TF_ASSERT_OK(new_writer.Write(MakeRegisterDatasetUpdate()));
+  TF_EXPECT_OK(CheckJournalContent(
+      journal_dir, {MakeFinishTaskUpdate(), MakeRegisterDatasetUpdate()},
+      latest_sequence_number));
+}
+
+TEST(Journal, MissingSnapshot) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  TF_ASSERT_OK(writer.Write(MakeCreateJobUpdate()));
+  int64_t sequence_number;
+  EXPECT_TRUE(errors::IsNotFound(
+      LatestJournalSnapshot(Env::Default(), journal_dir, sequence_number)));
+}
+
 TEST(Journal, MissingFile) {
   std::string journal_dir;
   EXPECT_TRUE(NewJournalDir(journal_dir));
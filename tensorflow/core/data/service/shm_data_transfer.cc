@@ -0,0 +1,747 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shm_data_transfer.h"
+
+#if !defined(PLATFORM_WINDOWS)
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/data/service/shm_data_transfer.pb.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/framework/variant.h"
+#include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numbers.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/raw_coding.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/env_var.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr uint64 kShmMagic = 0x6873617461646674;  // "tfdatash"
+// The ring buffer data starts one page after the header.
+constexpr size_t kShmHeaderBytes = 4096;
+constexpr size_t kShmAlignment = Allocator::kAllocatorAlignment;
+// Bounds the size of the messages read from the socket.
+constexpr uint64 kMaxMessageBytes = uint64{1} << 40;
+
+// The header at the beginning of a connection's shared memory object.
+struct ShmHeader {
+  uint64 magic;
+  uint64 capacity;
+  // The position up to which the client released the ring buffer. Positions
+  // increase monotonically; the offset of a position is `position % capacity`.
+  std::atomic<uint64> released;
+};
+static_assert(sizeof(ShmHeader) <= kShmHeaderBytes, "ShmHeader is too large");
+
+uint64 RoundUp(uint64 value, uint64 alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+Status IOErrorFromErrno(absl::string_view context) {
+  return errors::Unavailable(context, ": ", strerror(errno));
+}
+
+// A mapping of the shared memory object of a connection.
+class ShmRegion {
+ public:
+  // Creates the shared memory object `name` with a ring buffer of `capacity`
+  // bytes.
+  static Status Create(const std::string& name, uint64 capacity,
+                       std::unique_ptr<ShmRegion>* out) {
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      return IOErrorFromErrno(absl::StrCat("Failed to create ", name));
+    }
+    const size_t size = kShmHeaderBytes + capacity;
+    if (ftruncate(fd, size) != 0) {
+      Status s = IOErrorFromErrno(absl::StrCat("Failed to resize ", name));
+      close(fd);
+      shm_unlink(name.c_str());
+      return s;
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+      shm_unlink(name.c_str());
+      return IOErrorFromErrno(absl::StrCat("Failed to map ", name));
+    }
+    auto* header = new (base) ShmHeader();
+    header->magic = kShmMagic;
+    header->capacity = capacity;
+    header->released.store(0, std::memory_order_release);
+    out->reset(new ShmRegion(base, size));
+    return Status::OK();
+  }
+
+  // Maps the existing shared memory object `name`.
+  static Status Open(const std::string& name, std::unique_ptr<ShmRegion>* out) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+      return errors::FailedPrecondition(
+          "Failed to open the shared memory object ", name, ": ",
+          strerror(errno),
+          ". The shared memory data transfer protocol requires the tf.data "
+          "service worker to run on the same host as the client.");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      Status s = IOErrorFromErrno(absl::StrCat("Failed to stat ", name));
+      close(fd);
+      return s;
+    }
+    const size_t size = st.st_size;
+    if (size <= kShmHeaderBytes) {
+      close(fd);
+      return errors::DataLoss("Shared memory object ", name, " is too small.");
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+      return IOErrorFromErrno(absl::StrCat("Failed to map ", name));
+    }
+    out->reset(new ShmRegion(base, size));
+    if ((*out)->header()->magic != kShmMagic ||
+        (*out)->capacity() != size - kShmHeaderBytes) {
+      out->reset();
+      return errors::DataLoss("Shared memory object ", name,
+                              " is not a tf.data ring buffer.");
+    }
+    return Status::OK();
+  }
+
+  ~ShmRegion() { munmap(base_, size_); }
+
+  ShmHeader* header() const { return static_cast<ShmHeader*>(base_); }
+  char* data() const { return static_cast<char*>(base_) + kShmHeaderBytes; }
+  uint64 capacity() const { return header()->capacity; }
+
+ private:
+  ShmRegion(void* base, size_t size) : base_(base), size_(size) {}
+
+  void* const base_;
+  const size_t size_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShmRegion);
+};
+
+Status WriteAll(int fd, const char* data, size_t n) {
+  while (n > 0) {
+    ssize_t written = send(fd, data, n, MSG_NOSIGNAL);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return IOErrorFromErrno("Failed to write to the transfer socket");
+    }
+    data += written;
+    n -= written;
+  }
+  return Status::OK();
+}
+
+Status ReadAll(int fd, char* data, size_t n) {
+  while (n > 0) {
+    ssize_t num_read = recv(fd, data, n, 0);
+    if (num_read < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return IOErrorFromErrno("Failed to read from the transfer socket");
+    }
+    if (num_read == 0) {
+      return errors::Unavailable("The transfer socket was closed.");
+    }
+    data += num_read;
+    n -= num_read;
+  }
+  return Status::OK();
+}
+
+Status WriteMessage(int fd, const protobuf::MessageLite& message) {
+  std::string buffer(sizeof(uint64), '\0');
+  core::EncodeFixed64(&buffer[0], message.ByteSizeLong());
+  if (!message.AppendToString(&buffer)) {
+    return errors::Internal("Failed to serialize a ", message.GetTypeName());
+  }
+  return WriteAll(fd, buffer.data(), buffer.size());
+}
+
+Status ReadMessage(int fd, protobuf::MessageLite* message) {
+  char length[sizeof(uint64)];
+  TF_RETURN_IF_ERROR(ReadAll(fd, length, sizeof(length)));
+  const uint64 size = core::DecodeFixed64(length);
+  if (size > kMaxMessageBytes) {
+    return errors::DataLoss("Invalid message size ", size);
+  }
+  std::string buffer(size, '\0');
+  TF_RETURN_IF_ERROR(ReadAll(fd, &buffer[0], size));
+  if (!message->ParseFromString(buffer)) {
+    return errors::DataLoss("Failed to parse a ", message->GetTypeName());
+  }
+  return Status::OK();
+}
+
+// Server side of the shared memory transfer protocol.
+class ShmDataTransferServer : public DataTransferServer {
+ public:
+  ShmDataTransferServer(GetElementT get_element, uint64 buffer_bytes)
+      : get_element_(std::move(get_element)),
+        buffer_bytes_(RoundUp(buffer_bytes, kShmAlignment)) {}
+
+  ~ShmDataTransferServer() override {
+    {
+      mutex_lock l(mu_);
+      cancelled_ = true;
+      if (listen_fd_ >= 0) {
+        shutdown(listen_fd_, SHUT_RDWR);
+      }
+      for (int fd : connection_fds_) {
+        shutdown(fd, SHUT_RDWR);
+      }
+    }
+    // Joins the accept thread.
+    accept_thread_.reset();
+    {
+      mutex_lock l(mu_);
+      while (num_connections_ > 0) {
+        cond_var_.wait(l);
+      }
+    }
+    if (listen_fd_ >= 0) {
+      close(listen_fd_);
+    }
+  }
+
+  Status Start() override {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+      return IOErrorFromErrno("Failed to create the transfer socket");
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr),
+             sizeof(addr)) != 0) {
+      return IOErrorFromErrno("Failed to bind the transfer socket");
+    }
+    socklen_t addr_len = sizeof(addr);
+    if (getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr),
+                    &addr_len) != 0) {
+      return IOErrorFromErrno("Failed to get the transfer socket address");
+    }
+    port_ = ntohs(addr.sin_port);
+    if (listen(listen_fd_, SOMAXCONN) != 0) {
+      return IOErrorFromErrno("Failed to listen on the transfer socket");
+    }
+    accept_thread_ = absl::WrapUnique(Env::Default()->StartThread(
+        {}, "tf_data_shm_transfer_accept", [this]() { AcceptLoop(); }));
+    return Status::OK();
+  }
+
+  int get_port() override { return port_; }
+
+ private:
+  void AcceptLoop() {
+    while (true) {
+      int fd = accept(listen_fd_, nullptr, nullptr);
+      if (fd < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        mutex_lock l(mu_);
+        if (!cancelled_) {
+          LOG(ERROR) << "Failed to accept a shared memory transfer client: "
+                     << strerror(errno);
+        }
+        return;
+      }
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      int64_t connection_id;
+      {
+        mutex_lock l(mu_);
+        if (cancelled_) {
+          close(fd);
+          return;
+        }
+        connection_fds_.insert(fd);
+        ++num_connections_;
+        connection_id = next_connection_id_++;
+      }
+      Env::Default()->SchedClosure([this, fd, connection_id]() {
+        Status s = ServeConnection(fd, connection_id);
+        VLOG(2) << "Shared memory transfer connection " << connection_id
+                << " finished: " << s;
+        mutex_lock l(mu_);
+        connection_fds_.erase(fd);
+        close(fd);
+        --num_connections_;
+        cond_var_.notify_all();
+      });
+    }
+  }
+
+  Status ServeConnection(int fd, int64_t connection_id) {
+    const std::string name =
+        absl::StrCat("/tf_data_", getpid(), "_", port_, "_", connection_id);
+    std::unique_ptr<ShmRegion> region;
+    TF_RETURN_IF_ERROR(ShmRegion::Create(name, buffer_bytes_, &region));
+    ShmHandshake handshake;
+    handshake.set_shm_name(name);
+    ShmHandshakeAck ack;
+    Status s = WriteMessage(fd, handshake);
+    if (s.ok()) {
+      s = ReadMessage(fd, &ack);
+    }
+    // Once the client mapped the object, the memory is released with the last
+    // mapping.
+    shm_unlink(name.c_str());
+    TF_RETURN_IF_ERROR(s);
+
+    uint64 head = 0;
+    while (true) {
+      GetElementRequest request;
+      TF_RETURN_IF_ERROR(ReadMessage(fd, &request));
+      GetElementResult result;
+      ShmGetElementResponse response;
+      s = get_element_(&request, &result);
+      if (s.ok()) {
+        s = EncodeElement(std::move(result), *region, head, response);
+      }
+      if (!s.ok()) {
+        response.Clear();
+        response.set_status_code(s.code());
+        response.set_status_message(s.error_message());
+      }
+      TF_RETURN_IF_ERROR(WriteMessage(fd, response));
+    }
+  }
+
+  // Copies the components of `result` to the ring buffer of `region`, whose
+  // next free position is `head`, and describes them in `response`.
+  Status EncodeElement(GetElementResult&& result, const ShmRegion& region,
+                       uint64& head, ShmGetElementResponse& response) {
+    response.set_element_index(result.element_index);
+    response.set_end_of_sequence(result.end_of_sequence);
+    response.set_skip_task(result.skip);
+
+    // Serializes the components which can not be copied with `memcpy`.
+    std::vector<std::unique_ptr<protobuf::MessageLite>> messages(
+        result.components.size());
+    uint64 total_bytes = 0;
+    for (size_t i = 0; i < result.components.size(); ++i) {
+      const Tensor& tensor = result.components[i];
+      ShmComponent* component = response.add_components();
+      component->set_dtype(tensor.dtype());
+      tensor.shape().AsProto(component->mutable_shape());
+      if (DataTypeCanUseMemcpy(tensor.dtype())) {
+        component->set_encoding(ShmComponent::RAW);
+        component->set_size(tensor.tensor_data().size());
+      } else if (tensor.dtype() == DT_VARIANT &&
+                 TensorShapeUtils::IsScalar(tensor.shape()) &&
+                 tensor.scalar<Variant>()().get<CompressedElement>()) {
+        component->set_encoding(ShmComponent::COMPRESSED_ELEMENT);
+        messages[i] = absl::make_unique<CompressedElement>(
+            *tensor.scalar<Variant>()().get<CompressedElement>());
+        component->set_size(messages[i]->ByteSizeLong());
+      } else {
+        component->set_encoding(ShmComponent::TENSOR_PROTO);
+        auto proto = absl::make_unique<TensorProto>();
+        tensor.AsProtoTensorContent(proto.get());
+        component->set_size(proto->ByteSizeLong());
+        messages[i] = std::move(proto);
+      }
+      total_bytes += RoundUp(component->size(), kShmAlignment);
+    }
+
+    uint64 begin = head;
+    uint64 offset;
+    const bool in_ring = total_bytes > 0 && Allocate(region, total_bytes, head,
+                                                     offset);
+    if (in_ring) {
+      response.set_range_begin(begin);
+      response.set_range_end(head);
+    }
+    for (size_t i = 0; i < result.components.size(); ++i) {
+      ShmComponent* component = response.mutable_components(i);
+      char* dst;
+      if (in_ring) {
+        component->set_offset(offset);
+        dst = region.data() + offset;
+        offset += RoundUp(component->size(), kShmAlignment);
+      } else {
+        component->mutable_data()->resize(component->size());
+        dst = &(*component->mutable_data())[0];
+      }
+      if (messages[i]) {
+        if (!messages[i]->SerializeToArray(dst, component->size())) {
+          return errors::Internal("Failed to serialize component ", i);
+        }
+      } else {
+        StringPiece data = result.components[i].tensor_data();
+        memcpy(dst, data.data(), data.size());
+      }
+    }
+    return Status::OK();
+  }
+
+  // Allocates `num_bytes` contiguous bytes of the ring buffer of `region` if
+  // the client released enough of it. On success, `offset` is the offset of
+  // the allocated bytes and `head` is advanced past them.
+  bool Allocate(const ShmRegion& region, uint64 num_bytes, uint64& head,
+                uint64& offset) {
+    const uint64 capacity = region.capacity();
+    if (num_bytes > capacity) {
+      return false;
+    }
+    uint64 start = head;
+    if (start % capacity + num_bytes > capacity) {
+      // Skips the end of the ring buffer to keep the element contiguous.
+      start += capacity - start % capacity;
+    }
+    const uint64 released =
+        region.header()->released.load(std::memory_order_acquire);
+    if (start + num_bytes - released > capacity) {
+      return false;
+    }
+    offset = start % capacity;
+    head = start + num_bytes;
+    return true;
+  }
+
+  const GetElementT get_element_;
+  const uint64 buffer_bytes_;
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::unique_ptr<Thread> accept_thread_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  absl::flat_hash_set<int> connection_fds_ TF_GUARDED_BY(mu_);
+  int64_t num_connections_ TF_GUARDED_BY(mu_) = 0;
+  int64_t next_connection_id_ TF_GUARDED_BY(mu_) = 0;
+};
+
+// The client's view of a connection's ring buffer. Tracks the ranges still
+// referenced by tensors and publishes the released prefix to the server.
+class ShmRing {
+ public:
+  explicit ShmRing(std::unique_ptr<ShmRegion> region)
+      : region_(std::move(region)) {}
+
+  const ShmRegion& region() const { return *region_; }
+
+  void Release(uint64 begin, uint64 end) TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    released_ranges_[begin] = end;
+    auto it = released_ranges_.begin();
+    while (it != released_ranges_.end() && it->first == released_) {
+      released_ = it->second;
+      it = released_ranges_.erase(it);
+    }
+    region_->header()->released.store(released_, std::memory_order_release);
+  }
+
+ private:
+  const std::unique_ptr<ShmRegion> region_;
+
+  mutex mu_;
+  uint64 released_ TF_GUARDED_BY(mu_) = 0;
+  // The ranges released out of order, keyed by their beginning.
+  std::map<uint64, uint64> released_ranges_ TF_GUARDED_BY(mu_);
+};
+
+// A range of the ring buffer used by an element, released on destruction.
+class ShmRange {
+ public:
+  ShmRange(std::shared_ptr<ShmRing> ring, uint64 begin, uint64 end)
+      : ring_(std::move(ring)), begin_(begin), end_(end) {}
+  ~ShmRange() { ring_->Release(begin_, end_); }
+
+ private:
+  const std::shared_ptr<ShmRing> ring_;
+  const uint64 begin_;
+  const uint64 end_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShmRange);
+};
+
+// A tensor buffer in the ring buffer of a connection.
+class ShmTensorBuffer : public TensorBuffer {
+ public:
+  ShmTensorBuffer(std::shared_ptr<ShmRange> range, void* data, size_t size)
+      : TensorBuffer(data), range_(std::move(range)), size_(size) {}
+
+  size_t size() const override { return size_; }
+
+  TensorBuffer* root_buffer() override { return this; }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(static_cast<int64_t>(size_));
+    proto->set_allocator_name("shm_data_transfer");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ShmRange> range_;
+  const size_t size_;
+};
+
+// Client side of the shared memory transfer protocol.
+class ShmDataTransferClient : public DataTransferClient {
+ public:
+  static Status Create(const std::string& address,
+                       std::unique_ptr<DataTransferClient>* out) {
+    const size_t colon = address.rfind(':');
+    int32 port;
+    if (colon == std::string::npos ||
+        !strings::safe_strto32(address.substr(colon + 1), &port)) {
+      return errors::InvalidArgument(
+          "Failed to parse the port of shared memory transfer address ",
+          address);
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+      return IOErrorFromErrno("Failed to create the transfer socket");
+    }
+    auto client = absl::WrapUnique(new ShmDataTransferClient(fd));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                sizeof(addr)) != 0) {
+      return IOErrorFromErrno(absl::StrCat(
+          "Failed to connect to the shared memory transfer server at ",
+          address));
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    ShmHandshake handshake;
+    TF_RETURN_IF_ERROR(ReadMessage(fd, &handshake));
+    std::unique_ptr<ShmRegion> region;
+    TF_RETURN_IF_ERROR(ShmRegion::Open(handshake.shm_name(), &region));
+    client->ring_ = std::make_shared<ShmRing>(std::move(region));
+    TF_RETURN_IF_ERROR(WriteMessage(fd, ShmHandshakeAck()));
+    VLOG(2) << "Create ShmDataTransferClient for worker " << address << ".";
+    *out = std::move(client);
+    return Status::OK();
+  }
+
+  ~ShmDataTransferClient() override { close(fd_); }
+
+  Status GetElement(const GetElementRequest& req,
+                    GetElementResult& result) override {
+    VLOG(3) << "GetElement for task " << req.task_id()
+            << " from shared memory worker.";
+    mutex_lock l(mu_);
+    TF_RETURN_IF_ERROR(VerifyClientIsNotCancelled());
+    Status s = WriteMessage(fd_, req);
+    ShmGetElementResponse response;
+    if (s.ok()) {
+      s = ReadMessage(fd_, &response);
+    }
+    if (!s.ok()) {
+      TF_RETURN_IF_ERROR(VerifyClientIsNotCancelled());
+      return s;
+    }
+    std::shared_ptr<ShmRange> range;
+    if (response.range_end() > response.range_begin()) {
+      range = std::make_shared<ShmRange>(ring_, response.range_begin(),
+                                         response.range_end());
+    }
+    if (response.status_code() != error::OK) {
+      return Status(static_cast<error::Code>(response.status_code()),
+                    response.status_message());
+    }
+    result.element_index = response.element_index();
+    result.end_of_sequence = response.end_of_sequence();
+    result.skip = response.skip_task();
+    for (const ShmComponent& component : response.components()) {
+      result.components.emplace_back();
+      TF_RETURN_IF_ERROR(
+          DecodeComponent(component, range, result.components.back()));
+    }
+    return Status::OK();
+  }
+
+  void TryCancel() override {
+    VLOG(2) << "Cancel ShmDataTransferClient.";
+    cancelled_.store(true);
+    // Unblocks the outstanding `GetElement` call.
+    shutdown(fd_, SHUT_RDWR);
+  }
+
+ private:
+  explicit ShmDataTransferClient(int fd) : fd_(fd) {}
+
+  Status VerifyClientIsNotCancelled() const {
+    if (cancelled_.load()) {
+      return errors::Cancelled("Client was cancelled.");
+    }
+    return Status::OK();
+  }
+
+  Status DecodeComponent(const ShmComponent& component,
+                         const std::shared_ptr<ShmRange>& range,
+                         Tensor& tensor) {
+    const char* data;
+    if (component.location_case() == ShmComponent::kOffset) {
+      if (!range || component.offset() + component.size() >
+                        ring_->region().capacity()) {
+        return errors::DataLoss("Invalid component offset ",
+                                component.offset());
+      }
+      data = ring_->region().data() + component.offset();
+    } else {
+      if (component.data().size() != component.size()) {
+        return errors::DataLoss("Invalid component size ", component.size());
+      }
+      data = component.data().data();
+    }
+    switch (component.encoding()) {
+      case ShmComponent::RAW: {
+        if (!TensorShape::IsValid(component.shape()) ||
+            !DataTypeCanUseMemcpy(component.dtype())) {
+          return errors::DataLoss("Invalid component.");
+        }
+        TensorShape shape(component.shape());
+        if (shape.num_elements() * DataTypeSize(component.dtype()) !=
+            component.size()) {
+          return errors::DataLoss("Invalid component size ", component.size());
+        }
+        if (component.location_case() == ShmComponent::kOffset) {
+          // The tensor references the ring buffer until it is destroyed.
+          auto* buf = new ShmTensorBuffer(range, const_cast<char*>(data),
+                                          component.size());
+          tensor = Tensor(component.dtype(), shape, buf);
+          buf->Unref();
+        } else {
+          tensor = Tensor(component.dtype(), shape);
+          memcpy(const_cast<char*>(tensor.tensor_data().data()), data,
+                 component.size());
+        }
+        return Status::OK();
+      }
+      case ShmComponent::TENSOR_PROTO: {
+        TensorProto proto;
+        if (!proto.ParseFromArray(data, component.size()) ||
+            !tensor.FromProto(proto)) {
+          return errors::Internal("Failed to parse tensor.");
+        }
+        return Status::OK();
+      }
+      case ShmComponent::COMPRESSED_ELEMENT: {
+        CompressedElement compressed;
+        if (!compressed.ParseFromArray(data, component.size())) {
+          return errors::Internal("Failed to parse compressed element.");
+        }
+        tensor = Tensor(DT_VARIANT, TensorShape{});
+        tensor.scalar<Variant>()() = std::move(compressed);
+        return Status::OK();
+      }
+      default:
+        return errors::DataLoss("Unknown component encoding ",
+                                component.encoding());
+    }
+  }
+
+  const int fd_;
+  std::atomic<bool> cancelled_{false};
+  std::shared_ptr<ShmRing> ring_;
+  // Serializes the requests sent over the socket.
+  mutex mu_;
+};
+
+int64_t GetShmTransferBufferBytes() {
+  int64_t buffer_bytes;
+  Status s = ReadInt64FromEnvVar("TF_DATA_SHM_TRANSFER_BUFFER_BYTES",
+                                 kDefaultShmTransferBufferBytes, &buffer_bytes);
+  if (!s.ok() || buffer_bytes <= 0) {
+    LOG(WARNING) << "Invalid TF_DATA_SHM_TRANSFER_BUFFER_BYTES, using the "
+                 << "default of " << kDefaultShmTransferBufferBytes
+                 << " bytes: " << s;
+    return kDefaultShmTransferBufferBytes;
+  }
+  return buffer_bytes;
+}
+
+class ShmTransferRegistrar {
+ public:
+  ShmTransferRegistrar() {
+    DataTransferServer::Register(
+        kShmTransferProtocol, [](DataTransferServer::GetElementT get_element) {
+          return std::make_shared<ShmDataTransferServer>(
+              std::move(get_element), GetShmTransferBufferBytes());
+        });
+    DataTransferClient::Register(
+        kShmTransferProtocol, [](DataTransferClient::Config config,
+                                 std::unique_ptr<DataTransferClient>* out) {
+          return ShmDataTransferClient::Create(config.address, out);
+        });
+  }
+};
+static ShmTransferRegistrar shm_transfer_registrar;
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // !defined(PLATFORM_WINDOWS)
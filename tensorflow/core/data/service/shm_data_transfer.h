@@ -0,0 +1,47 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_SHM_DATA_TRANSFER_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_SHM_DATA_TRANSFER_H_
+
+#include <cstdint>
+
+namespace tensorflow {
+namespace data {
+
+// A data transfer protocol for clients running on the same host as the
+// tf.data service worker.
+//
+// Workers started with `data_transfer_protocol="shm"` listen on a loopback
+// socket whose port replaces `%port%` in their `data_transfer_address` (e.g.
+// "localhost:%port%"), and clients reading with `data_transfer_protocol="shm"`
+// connect to the port of the worker's transfer address. Each connection owns a
+// ring buffer in POSIX shared memory: the worker copies the element tensors
+// into the ring buffer and sends only their descriptors over the socket. The
+// client wraps the ring buffer memory into tensors without copying it, and
+// releases the memory once the tensors are destroyed. Elements which do not fit
+// in the remaining space of the ring buffer are sent over the socket instead.
+//
+// The protocol is only available on POSIX platforms.
+constexpr const char kShmTransferProtocol[] = "shm";
+
+// The default size of the ring buffer of a connection. It can be overridden
+// with the `TF_DATA_SHM_TRANSFER_BUFFER_BYTES` environment variable of the
+// worker.
+constexpr int64_t kDefaultShmTransferBufferBytes = 64 << 20;
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_SHM_DATA_TRANSFER_H_
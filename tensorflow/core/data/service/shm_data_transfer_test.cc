@@ -0,0 +1,218 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shm_data_transfer.h"
+
+#include <stdlib.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/variant.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Produces elements `[index, "element_<index>"]` until `num_elements`, and
+// fails for task 42.
+Status GetTestElement(int64_t num_elements, int64_t size, int64_t& index,
+                      const GetElementRequest* request,
+                      GetElementResult* result) {
+  if (request->task_id() == 42) {
+    return errors::NotFound("Task 42 not found.");
+  }
+  if (index >= num_elements) {
+    result->end_of_sequence = true;
+    return Status::OK();
+  }
+  result->element_index = index;
+  result->end_of_sequence = false;
+  result->skip = false;
+  Tensor numbers(DT_INT64, TensorShape({size}));
+  numbers.flat<int64_t>().setConstant(index);
+  result->components.push_back(numbers);
+  result->components.push_back(
+      test::AsScalar<tstring>(absl::StrCat("element_", index)));
+  ++index;
+  return Status::OK();
+}
+
+bool IsInSharedMemory(const Tensor& tensor) {
+  TensorDescription description;
+  tensor.FillDescription(&description);
+  return description.allocation_description().allocator_name() ==
+         "shm_data_transfer";
+}
+
+class ShmDataTransferTest : public ::testing::Test {
+ protected:
+  void StartServer(int64_t num_elements, int64_t size) {
+    TF_ASSERT_OK(DataTransferServer::Build(
+        kShmTransferProtocol,
+        [this, num_elements, size](const GetElementRequest* request,
+                                   GetElementResult* result) {
+          return GetTestElement(num_elements, size, index_, request, result);
+        },
+        &server_));
+    TF_ASSERT_OK(server_->Start());
+  }
+
+  std::unique_ptr<DataTransferClient> NewClient() {
+    std::unique_ptr<DataTransferClient> client;
+    TF_CHECK_OK(DataTransferClient::Build(
+        kShmTransferProtocol,
+        {/*protocol=*/"grpc",
+         /*address=*/absl::StrCat("localhost:", server_->get_port())},
+        &client));
+    return client;
+  }
+
+  // The index of the next element produced by the server.
+  int64_t index_ = 0;
+  std::shared_ptr<DataTransferServer> server_;
+};
+
+TEST_F(ShmDataTransferTest, GetElements) {
+  StartServer(/*num_elements=*/10, /*size=*/1000);
+  std::unique_ptr<DataTransferClient> client = NewClient();
+  GetElementRequest request;
+  request.set_task_id(1);
+  std::vector<std::vector<Tensor>> elements;
+  while (true) {
+    GetElementResult result;
+    TF_ASSERT_OK(client->GetElement(request, result));
+    if (result.end_of_sequence) {
+      break;
+    }
+    ASSERT_EQ(result.components.size(), 2);
+    EXPECT_TRUE(IsInSharedMemory(result.components[0]));
+    EXPECT_TRUE(result.components[0].IsAligned());
+    elements.push_back(std::move(result.components));
+  }
+  ASSERT_EQ(elements.size(), 10);
+  for (int64_t i = 0; i < elements.size(); ++i) {
+    Tensor expected(DT_INT64, TensorShape({1000}));
+    expected.flat<int64_t>().setConstant(i);
+    test::ExpectEqual(elements[i][0], expected);
+    test::ExpectEqual(elements[i][1],
+                      test::AsScalar<tstring>(absl::StrCat("element_", i)));
+  }
+}
+
+TEST_F(ShmDataTransferTest, ElementsLargerThanRingBuffer) {
+  setenv("TF_DATA_SHM_TRANSFER_BUFFER_BYTES", "4096", /*overwrite=*/1);
+  StartServer(/*num_elements=*/3, /*size=*/10000);
+  unsetenv("TF_DATA_SHM_TRANSFER_BUFFER_BYTES");
+  std::unique_ptr<DataTransferClient> client = NewClient();
+  GetElementRequest request;
+  request.set_task_id(1);
+  for (int64_t i = 0; i < 3; ++i) {
+    GetElementResult result;
+    TF_ASSERT_OK(client->GetElement(request, result));
+    ASSERT_FALSE(result.end_of_sequence);
+    EXPECT_FALSE(IsInSharedMemory(result.components[0]));
+    Tensor expected(DT_INT64, TensorShape({10000}));
+    expected.flat<int64_t>().setConstant(i);
+    test::ExpectEqual(result.components[0], expected);
+  }
+}
+
+TEST_F(ShmDataTransferTest, RingBufferIsReused) {
+  setenv("TF_DATA_SHM_TRANSFER_BUFFER_BYTES", "65536", /*overwrite=*/1);
+  StartServer(/*num_elements=*/100, /*size=*/1000);
+  unsetenv("TF_DATA_SHM_TRANSFER_BUFFER_BYTES");
+  std::unique_ptr<DataTransferClient> client = NewClient();
+  GetElementRequest request;
+  request.set_task_id(1);
+  // Each element uses 8KB of the 64KB ring buffer, so the ring buffer is only
+  // reused if the elements destroyed by the loop are released.
+  for (int64_t i = 0; i < 100; ++i) {
+    GetElementResult result;
+    TF_ASSERT_OK(client->GetElement(request, result));
+    ASSERT_FALSE(result.end_of_sequence);
+    EXPECT_TRUE(IsInSharedMemory(result.components[0]));
+    EXPECT_EQ(result.components[0].flat<int64_t>()(999), i);
+  }
+}
+
+TEST_F(ShmDataTransferTest, CompressedElement) {
+  TF_ASSERT_OK(DataTransferServer::Build(
+      kShmTransferProtocol,
+      [](const GetElementRequest* request, GetElementResult* result) {
+        CompressedElement compressed;
+        compressed.set_data("compressed data");
+        Tensor tensor(DT_VARIANT, TensorShape{});
+        tensor.scalar<Variant>()() = std::move(compressed);
+        result->components.push_back(tensor);
+        result->end_of_sequence = false;
+        result->skip = false;
+        return Status::OK();
+      },
+      &server_));
+  TF_ASSERT_OK(server_->Start());
+  std::unique_ptr<DataTransferClient> client = NewClient();
+  GetElementResult result;
+  TF_ASSERT_OK(client->GetElement(GetElementRequest(), result));
+  ASSERT_EQ(result.components.size(), 1);
+  const CompressedElement* compressed =
+      result.components[0].scalar<Variant>()().get<CompressedElement>();
+  ASSERT_NE(compressed, nullptr);
+  EXPECT_EQ(compressed->data(), "compressed data");
+}
+
+TEST_F(ShmDataTransferTest, PropagatesErrors) {
+  StartServer(/*num_elements=*/10, /*size=*/10);
+  std::unique_ptr<DataTransferClient> client = NewClient();
+  GetElementRequest request;
+  request.set_task_id(42);
+  GetElementResult result;
+  Status s = client->GetElement(request, result);
+  EXPECT_TRUE(errors::IsNotFound(s)) << s;
+}
+
+TEST_F(ShmDataTransferTest, Cancel) {
+  StartServer(/*num_elements=*/10, /*size=*/10);
+  std::unique_ptr<DataTransferClient> client = NewClient();
+  client->TryCancel();
+  GetElementResult result;
+  Status s = client->GetElement(GetElementRequest(), result);
+  EXPECT_TRUE(errors::IsCancelled(s)) << s;
+}
+
+TEST_F(ShmDataTransferTest, NoServer) {
+  StartServer(/*num_elements=*/10, /*size=*/10);
+  const int port = server_->get_port();
+  server_.reset();
+  std::unique_ptr<DataTransferClient> client;
+  Status s = DataTransferClient::Build(
+      kShmTransferProtocol, {"grpc", absl::StrCat("localhost:", port)},
+      &client);
+  EXPECT_TRUE(errors::IsUnavailable(s)) << s;
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
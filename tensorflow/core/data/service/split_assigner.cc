@@ -0,0 +1,190 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/split_assigner.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr absl::string_view kZoneTagPrefix = "zone:";
+
+// Weight of the latest time between requests in the time per split.
+constexpr double kSplitTimeDecay = 0.3;
+
+// Preferences of a worker for a buffered split, from the least preferred.
+enum SplitPreference {
+  kReadElsewhere = 0,
+  kUnread = 1,
+  kReadInZone = 2,
+  kReadOnHost = 3,
+  kReadByWorker = 4,
+};
+
+}  // namespace
+
+WorkerLocation GetWorkerLocation(const std::string& address,
+                                 const std::vector<std::string>& worker_tags) {
+  WorkerLocation location;
+  location.address = address;
+  location.host = address.substr(0, address.rfind(':'));
+  for (const std::string& tag : worker_tags) {
+    if (absl::StartsWith(tag, kZoneTagPrefix)) {
+      location.zone = tag.substr(kZoneTagPrefix.size());
+    }
+  }
+  return location;
+}
+
+SplitAssigner::SplitAssigner(std::unique_ptr<SplitProvider> split_provider,
+                             int64_t lookahead)
+    : split_provider_(std::move(split_provider)),
+      lookahead_(std::max<int64_t>(lookahead, 1)) {}
+
+Status SplitAssigner::GetNext(const WorkerLocation& worker,
+                              int64_t now_micros, Tensor& split,
+                              bool& end_of_splits) {
+  RecordRequest(worker.address, now_micros);
+  TF_RETURN_IF_ERROR(FillBuffer());
+  if (buffer_.empty()) {
+    end_of_splits = true;
+    return Status::OK();
+  }
+  if (IsStraggler(worker.address, now_micros)) {
+    return errors::Unavailable(
+        "Worker ", worker.address, " is expected to take longer than other ",
+        "workers to process the remaining ", buffer_.size(),
+        " splits of the repetition");
+  }
+  auto best = buffer_.begin();
+  int best_preference = Preference(worker, best->key);
+  auto window_end =
+      buffer_.begin() + std::min<int64_t>(buffer_.size(), lookahead_);
+  for (auto it = buffer_.begin() + 1; it != window_end; ++it) {
+    int preference = Preference(worker, it->key);
+    if (preference > best_preference) {
+      best = it;
+      best_preference = preference;
+    }
+  }
+  split = std::move(best->split);
+  readers_[best->key] = worker;
+  buffer_.erase(best);
+  worker_stats_[worker.address].assigned_micros = now_micros;
+  end_of_splits = false;
+  return Status::OK();
+}
+
+Status SplitAssigner::Reset() {
+  buffer_.clear();
+  end_of_provider_ = false;
+  return split_provider_->Reset();
+}
+
+Status SplitAssigner::FillBuffer() {
+  // One more split than the lookahead tells whether the remaining splits are
+  // the tail of the repetition.
+  while (!end_of_provider_ &&
+         static_cast<int64_t>(buffer_.size()) <= lookahead_) {
+    BufferedSplit buffered;
+    TF_RETURN_IF_ERROR(
+        split_provider_->GetNext(&buffered.split, &end_of_provider_));
+    if (end_of_provider_) {
+      break;
+    }
+    TensorProto proto;
+    buffered.split.AsProtoTensorContent(&proto);
+    buffered.key = proto.SerializeAsString();
+    buffer_.push_back(std::move(buffered));
+  }
+  return Status::OK();
+}
+
+void SplitAssigner::RecordRequest(const std::string& address,
+                                  int64_t now_micros) {
+  WorkerStats& stats = worker_stats_[address];
+  if (stats.assigned_micros < 0) {
+    return;
+  }
+  double split_micros = now_micros - stats.assigned_micros;
+  stats.split_micros =
+      stats.split_micros == 0
+          ? split_micros
+          : kSplitTimeDecay * split_micros +
+                (1 - kSplitTimeDecay) * stats.split_micros;
+  stats.assigned_micros = -1;
+}
+
+bool SplitAssigner::IsStraggler(const std::string& address,
+                                int64_t now_micros) const {
+  auto it = worker_stats_.find(address);
+  if (!end_of_provider_ || it == worker_stats_.end() ||
+      it->second.split_micros == 0) {
+    return false;
+  }
+  const double finish_micros = now_micros + it->second.split_micros;
+  // Workers processing a split, which they are expected to finish and then
+  // request and finish another split sooner than `address`. Workers overdue
+  // by a split are assumed to be gone.
+  int64_t num_faster_workers = 0;
+  for (const auto& address_and_stats : worker_stats_) {
+    const WorkerStats& stats = address_and_stats.second;
+    if (address_and_stats.first == address || stats.assigned_micros < 0 ||
+        stats.split_micros == 0 ||
+        now_micros > stats.assigned_micros + 2 * stats.split_micros) {
+      continue;
+    }
+    double next_request_micros = std::max<double>(
+        now_micros, stats.assigned_micros + stats.split_micros);
+    if (next_request_micros + stats.split_micros < finish_micros) {
+      ++num_faster_workers;
+    }
+  }
+  return num_faster_workers >= static_cast<int64_t>(buffer_.size());
+}
+
+int SplitAssigner::Preference(const WorkerLocation& worker,
+                              const std::string& key) const {
+  auto it = readers_.find(key);
+  if (it == readers_.end()) {
+    return kUnread;
+  }
+  const WorkerLocation& reader = it->second;
+  if (reader.address == worker.address) {
+    return kReadByWorker;
+  }
+  if (reader.host == worker.host) {
+    return kReadOnHost;
+  }
+  if (!reader.zone.empty() && reader.zone == worker.zone) {
+    return kReadInZone;
+  }
+  return kReadElsewhere;
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,123 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_SPLIT_ASSIGNER_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_SPLIT_ASSIGNER_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace data {
+
+// Where a worker runs, for preferring splits whose data is local to it.
+struct WorkerLocation {
+  std::string address;
+  // The host of `address`, shared by the workers of a machine.
+  std::string host;
+  // The zone of the worker, or empty if unknown.
+  std::string zone;
+};
+
+// Returns the location of the worker at `address`, whose zone is given by a
+// worker tag of the form "zone:<zone>", if any.
+WorkerLocation GetWorkerLocation(const std::string& address,
+                                 const std::vector<std::string>& worker_tags);
+
+// Hands out the splits of a split provider to the workers of a dynamically
+// sharded job.
+//
+// The assigner reads `lookahead` splits ahead of the workers, and gives each
+// worker the buffered split it is the most likely to read fastest: one
+// it read in a previous repetition, whose data it may have cached, then one
+// read by a worker of the same host, then of the same zone. Splits nobody
+// read come before splits read by workers elsewhere, which are left for those
+// workers. With a `lookahead` of 1, the splits are handed out in order.
+//
+// The time per split of each worker is estimated from the times between its
+// requests. In the tail of a repetition, once the split provider has no more
+// splits, a worker is refused a split with an Unavailable error if enough
+// faster workers are expected to finish the remaining splits before it would,
+// so that slow workers don't extend the repetition. Refused workers retry,
+// until the other workers took the remaining splits.
+//
+// Not thread-safe.
+class SplitAssigner {
+ public:
+  SplitAssigner(std::unique_ptr<SplitProvider> split_provider,
+                int64_t lookahead);
+
+  // Gets the next split for `worker`, which requests it at `now_micros`.
+  Status GetNext(const WorkerLocation& worker, int64_t now_micros,
+                 Tensor& split, bool& end_of_splits);
+
+  // Resets the assigner for the next repetition, after the end of splits.
+  Status Reset();
+
+ private:
+  struct BufferedSplit {
+    Tensor split;
+    // The serialized split, identifying it across repetitions.
+    std::string key;
+  };
+
+  struct WorkerStats {
+    // When the worker was last handed a split, or -1 if it requested another
+    // split since.
+    int64_t assigned_micros = -1;
+    // Moving average of the time between a split and the next request.
+    double split_micros = 0;
+  };
+
+  // Reads splits from the split provider until more than `lookahead_` are
+  // buffered.
+  Status FillBuffer();
+
+  // Updates the time per split of `address`, which requests a split at
+  // `now_micros`.
+  void RecordRequest(const std::string& address, int64_t now_micros);
+
+  // Returns true if faster workers are expected to finish the buffered splits
+  // before `address`, when the split provider has no more splits.
+  bool IsStraggler(const std::string& address, int64_t now_micros) const;
+
+  // Returns how much `worker` prefers the split with `key`.
+  int Preference(const WorkerLocation& worker, const std::string& key) const;
+
+  const std::unique_ptr<SplitProvider> split_provider_;
+  const int64_t lookahead_;
+
+  std::deque<BufferedSplit> buffer_;
+  // Whether the split provider returned the end of splits.
+  bool end_of_provider_ = false;
+  // The worker that last read each split.
+  absl::flat_hash_map<std::string, WorkerLocation> readers_;
+  absl::flat_hash_map<std::string, WorkerStats> worker_stats_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SplitAssigner);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_SPLIT_ASSIGNER_H_
@@ -0,0 +1,146 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/split_assigner.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/data/split_utils.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using ::testing::UnorderedElementsAre;
+
+std::unique_ptr<SplitAssigner> MakeAssigner(int64_t num_splits,
+                                            int64_t lookahead) {
+  return absl::make_unique<SplitAssigner>(
+      absl::make_unique<IndexSplitProvider>(num_splits), lookahead);
+}
+
+// Gets the next split for `worker`, or -1 at the end of splits.
+int64_t Next(SplitAssigner& assigner, const WorkerLocation& worker,
+             int64_t now_micros = 0) {
+  Tensor split;
+  bool end_of_splits;
+  TF_CHECK_OK(assigner.GetNext(worker, now_micros, split, end_of_splits));
+  return end_of_splits ? -1 : split.scalar<int64_t>()();
+}
+
+TEST(SplitAssignerTest, GetWorkerLocation) {
+  WorkerLocation location =
+      GetWorkerLocation("host1:5000", {"COLOCATED", "zone:us-east1-b"});
+  EXPECT_EQ(location.address, "host1:5000");
+  EXPECT_EQ(location.host, "host1");
+  EXPECT_EQ(location.zone, "us-east1-b");
+  EXPECT_EQ(GetWorkerLocation("host1", {}).zone, "");
+}
+
+TEST(SplitAssignerTest, HandsOutSplitsInOrder) {
+  std::unique_ptr<SplitAssigner> assigner =
+      MakeAssigner(/*num_splits=*/3, /*lookahead=*/1);
+  WorkerLocation worker1 = GetWorkerLocation("host1:1", {});
+  WorkerLocation worker2 = GetWorkerLocation("host2:1", {});
+  for (int repetition = 0; repetition < 2; ++repetition) {
+    EXPECT_EQ(Next(*assigner, worker1), 0);
+    EXPECT_EQ(Next(*assigner, worker2), 1);
+    EXPECT_EQ(Next(*assigner, worker2), 2);
+    EXPECT_EQ(Next(*assigner, worker1), -1);
+    TF_ASSERT_OK(assigner->Reset());
+  }
+}
+
+TEST(SplitAssignerTest, PrefersSplitsReadBefore) {
+  std::unique_ptr<SplitAssigner> assigner =
+      MakeAssigner(/*num_splits=*/4, /*lookahead=*/4);
+  WorkerLocation worker1 = GetWorkerLocation("host1:1", {});
+  WorkerLocation worker2 = GetWorkerLocation("host2:1", {});
+  EXPECT_EQ(Next(*assigner, worker1), 0);
+  EXPECT_EQ(Next(*assigner, worker2), 1);
+  EXPECT_EQ(Next(*assigner, worker2), 2);
+  EXPECT_EQ(Next(*assigner, worker1), 3);
+  EXPECT_EQ(Next(*assigner, worker1), -1);
+  TF_ASSERT_OK(assigner->Reset());
+
+  std::vector<int64_t> splits1 = {Next(*assigner, worker1),
+                                  Next(*assigner, worker1)};
+  EXPECT_THAT(splits1, UnorderedElementsAre(0, 3));
+  // A new worker on the host of worker2 takes its splits.
+  WorkerLocation worker3 = GetWorkerLocation("host2:2", {});
+  std::vector<int64_t> splits3 = {Next(*assigner, worker3),
+                                  Next(*assigner, worker3)};
+  EXPECT_THAT(splits3, UnorderedElementsAre(1, 2));
+}
+
+TEST(SplitAssignerTest, PrefersSplitsReadInZone) {
+  std::unique_ptr<SplitAssigner> assigner =
+      MakeAssigner(/*num_splits=*/2, /*lookahead=*/2);
+  WorkerLocation worker1 = GetWorkerLocation("host1:1", {"zone:a"});
+  WorkerLocation worker2 = GetWorkerLocation("host2:1", {"zone:b"});
+  EXPECT_EQ(Next(*assigner, worker1), 0);
+  EXPECT_EQ(Next(*assigner, worker2), 1);
+  EXPECT_EQ(Next(*assigner, worker1), -1);
+  TF_ASSERT_OK(assigner->Reset());
+
+  EXPECT_EQ(Next(*assigner, GetWorkerLocation("host3:1", {"zone:b"})), 1);
+  EXPECT_EQ(Next(*assigner, GetWorkerLocation("host4:1", {"zone:c"})), 0);
+}
+
+TEST(SplitAssignerTest, WithholdsTailFromStragglers) {
+  std::unique_ptr<SplitAssigner> assigner =
+      MakeAssigner(/*num_splits=*/12, /*lookahead=*/1);
+  WorkerLocation fast = GetWorkerLocation("fast:1", {});
+  WorkerLocation slow = GetWorkerLocation("slow:1", {});
+  // The fast worker takes 10us per split, the slow worker 100us.
+  EXPECT_EQ(Next(*assigner, fast, 0), 0);
+  EXPECT_EQ(Next(*assigner, slow, 0), 1);
+  for (int64_t split = 2; split <= 10; ++split) {
+    EXPECT_EQ(Next(*assigner, fast, (split - 1) * 10), split);
+  }
+  // The fast worker would finish the last split before the slow worker.
+  Tensor split;
+  bool end_of_splits;
+  Status s = assigner->GetNext(slow, 100, split, end_of_splits);
+  EXPECT_TRUE(errors::IsUnavailable(s)) << s;
+  EXPECT_EQ(Next(*assigner, fast, 100), 11);
+  EXPECT_EQ(Next(*assigner, slow, 105), -1);
+  EXPECT_EQ(Next(*assigner, fast, 110), -1);
+}
+
+TEST(SplitAssignerTest, StopsWithholdingFromGoneWorkers) {
+  std::unique_ptr<SplitAssigner> assigner =
+      MakeAssigner(/*num_splits=*/4, /*lookahead=*/1);
+  WorkerLocation fast = GetWorkerLocation("fast:1", {});
+  WorkerLocation slow = GetWorkerLocation("slow:1", {});
+  EXPECT_EQ(Next(*assigner, fast, 0), 0);
+  EXPECT_EQ(Next(*assigner, slow, 0), 1);
+  EXPECT_EQ(Next(*assigner, fast, 10), 2);
+  // The fast worker is overdue for its next split, so the slow worker takes
+  // the last one.
+  EXPECT_EQ(Next(*assigner, slow, 100), 3);
+  EXPECT_EQ(Next(*assigner, fast, 200), -1);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
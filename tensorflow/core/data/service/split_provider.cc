@@ -39,8 +39,8 @@ Status DataServiceSplitProvider::GetNext(Tensor* split, bool* end_of_splits) {
   return grpc_util::Retry(
       [this, split, end_of_splits] {
         return dispatcher_->GetSplit(job_id_, repetition_,
-                                     split_provider_index_, *split,
-                                     *end_of_splits);
+                                     split_provider_index_, worker_address_,
+                                     *split, *end_of_splits);
       },
       "get next split",
       /*deadline_micros=*/Env::Default()->NowMicros() +
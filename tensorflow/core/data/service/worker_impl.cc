@@ -28,10 +28,12 @@ limitations under the License.
 #include "tensorflow/c/c_api_internal.h"
 #include "tensorflow/c/tf_status_helper.h"
 #include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/data/hash_utils.h"
 #include "tensorflow/core/data/service/auto_shard_rewriter.h"
 #include "tensorflow/core/data/service/common.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/credentials_factory.h"
+#include "tensorflow/core/data/service/cross_job_cache.h"
 #include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
 #include "tensorflow/core/data/service/dispatcher.pb.h"
@@ -283,12 +285,8 @@ Status DataServiceWorkerImpl::EnsureTaskInitialized(
     return Status::OK();
   }
   TF_ASSIGN_OR_RETURN(DatasetDef dataset_def, GetDatasetDef(task.task_def));
-  TF_ASSIGN_OR_RETURN(std::unique_ptr<standalone::Dataset> dataset,
-                      MakeDataset(dataset_def, task.task_def));
-  TF_ASSIGN_OR_RETURN(std::unique_ptr<standalone::Iterator> iterator,
-                      MakeDatasetIterator(*dataset, task.task_def));
-  auto task_iterator = absl::make_unique<StandaloneTaskIterator>(
-      std::move(dataset), std::move(iterator));
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<TaskIterator> task_iterator,
+                      MakeTaskIterator(dataset_def, task.task_def));
   TF_RETURN_IF_ERROR(TaskRunner::Create(
       config_, task.task_def, std::move(task_iterator), task.task_runner));
 
@@ -350,7 +348,7 @@ DataServiceWorkerImpl::MakeDatasetIterator(standalone::Dataset& dataset,
     for (int i = 0; i < task_def.num_split_providers(); ++i) {
       split_providers.push_back(absl::make_unique<DataServiceSplitProvider>(
           config_.dispatcher_address(), config_.protocol(), task_def.job_id(),
-          i, config_.dispatcher_timeout_ms()));
+          i, task_def.worker_address(), config_.dispatcher_timeout_ms()));
     }
     TF_RETURN_IF_ERROR(
         dataset.MakeIterator(std::move(split_providers), &iterator));
@@ -361,6 +359,59 @@ DataServiceWorkerImpl::MakeDatasetIterator(standalone::Dataset& dataset,
                                  task_def.processing_mode_def().DebugString());
 }
 
+StatusOr<std::unique_ptr<TaskIterator>> DataServiceWorkerImpl::MakeTaskIterator(
+    const DatasetDef& dataset_def, const TaskDef& task_def) {
+  if (config_.cross_job_cache_size_bytes() <= 0 ||
+      IsDynamicShard(task_def.processing_mode_def())) {
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<standalone::Dataset> dataset,
+                        MakeDataset(dataset_def, task_def));
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<standalone::Iterator> iterator,
+                        MakeDatasetIterator(*dataset, task_def));
+    return std::unique_ptr<TaskIterator>(
+        absl::make_unique<StandaloneTaskIterator>(std::move(dataset),
+                                                  std::move(iterator)));
+  }
+
+  // Without dynamic sharding, the tasks of all jobs reading the same dataset
+  // produce the same elements. The fingerprint covers the auto-shard rewrite,
+  // so that statically sharded tasks only share caches with the same shard.
+  TF_ASSIGN_OR_RETURN(AutoShardRewriter auto_shard_rewriter,
+                      AutoShardRewriter::Create(task_def));
+  TF_ASSIGN_OR_RETURN(
+      GraphDef rewritten_graph,
+      auto_shard_rewriter.ApplyAutoShardRewrite(dataset_def.graph()));
+  uint64 fingerprint;
+  TF_RETURN_IF_ERROR(HashGraph(rewritten_graph, &fingerprint));
+
+  mutex_lock l(element_caches_mu_);
+  std::shared_ptr<CrossJobElementCache> cache =
+      element_caches_[fingerprint].lock();
+  if (!cache) {
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<standalone::Dataset> dataset,
+                        MakeDataset(dataset_def, task_def));
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<standalone::Iterator> iterator,
+                        MakeDatasetIterator(*dataset, task_def));
+    auto task_iterator = absl::make_unique<StandaloneTaskIterator>(
+        std::move(dataset), std::move(iterator));
+    if (task_iterator->Cardinality() != kInfiniteCardinality) {
+      // Readers skip the elements evicted from the cache, so finite datasets
+      // are not cached.
+      element_caches_.erase(fingerprint);
+      return std::unique_ptr<TaskIterator>(std::move(task_iterator));
+    }
+    cache = std::make_shared<CrossJobElementCache>(
+        std::move(task_iterator), config_.cross_job_cache_size_bytes());
+    element_caches_[fingerprint] = cache;
+    VLOG(1) << "Created cross-job cache for dataset " << task_def.dataset_id()
+            << " with fingerprint " << fingerprint;
+  } else {
+    VLOG(1) << "Task " << task_def.task_id() << " reads from the cross-job "
+            << "cache of dataset " << task_def.dataset_id();
+  }
+  return std::unique_ptr<TaskIterator>(
+      absl::make_unique<CachedTaskIterator>(std::move(cache)));
+}
+
 void DataServiceWorkerImpl::StopTask(Task& task) TF_LOCKS_EXCLUDED(mu_) {
   {
     mutex_lock l(task.mu);
@@ -23,6 +23,7 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/data/service/common.pb.h"
+#include "tensorflow/core/data/service/cross_job_cache.h"
 #include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
 #include "tensorflow/core/data/service/dispatcher_client.h"
@@ -117,6 +118,12 @@ class DataServiceWorkerImpl {
   // Creates an iterator for `dataset`.
   StatusOr<std::unique_ptr<standalone::Iterator>> MakeDatasetIterator(
       standalone::Dataset& dataset, const TaskDef& task_def) const;
+  // Creates the iterator of a task. If the cross-job cache is enabled and
+  // applies to the task, the iterator reads from the cache of the task's
+  // dataset.
+  StatusOr<std::unique_ptr<TaskIterator>> MakeTaskIterator(
+      const DatasetDef& dataset_def, const TaskDef& task_def)
+      TF_LOCKS_EXCLUDED(element_caches_mu_);
 
   const experimental::WorkerConfig config_;
   // The worker's own address.
@@ -148,6 +155,12 @@ class DataServiceWorkerImpl {
   int64_t outstanding_requests_ TF_GUARDED_BY(mu_) = 0;
   CancellationManager cancellation_manager_;
 
+  mutex element_caches_mu_;
+  // Caches shared by the tasks of different jobs, keyed by the fingerprint of
+  // the tasks' datasets. A cache is destroyed with the last task reading it.
+  absl::flat_hash_map<uint64, std::weak_ptr<CrossJobElementCache>>
+      element_caches_ TF_GUARDED_BY(element_caches_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(DataServiceWorkerImpl);
 };
 
@@ -35,13 +35,17 @@ limitations under the License.
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/snapshot.pb.h"
 
@@ -58,8 +62,65 @@ constexpr const char* const kCurrentCheckpointID = "current_checkpoint_id";
 constexpr const char* const kIndex = "index";
 constexpr const char* const kStartIndex = "start_index";
 
+// Returns the thread pool shared by the snapshot writers and readers of the
+// process for compressing and decompressing blocks.
+thread::ThreadPool* CompressionThreadPool() {
+  static thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), ThreadOptions(),
+                             "snapshot_compression", port::MaxParallelism(),
+                             /*low_latency_hint=*/false);
+  return pool;
+}
+
+// Runs `fn(i)` for every `i` in `[0, n)` on the compression thread pool and
+// returns the first error.
+Status ParallelForBlocks(int64_t n,
+                         const std::function<Status(int64_t)>& fn) {
+  BlockingCounter counter(n);
+  mutex mu;
+  Status status;
+  for (int64_t i = 0; i < n; ++i) {
+    CompressionThreadPool()->Schedule([&, i]() {
+      Status s = fn(i);
+      if (!s.ok()) {
+        mutex_lock l(mu);
+        status.Update(s);
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  return status;
+}
+
+// Returns the parts of the buffers of `iov` covering the bytes `[begin, end)`
+// of their concatenation.
+std::vector<struct iovec> SliceIOVec(const std::vector<struct iovec>& iov,
+                                     int64_t begin, int64_t end) {
+  std::vector<struct iovec> slices;
+  int64_t offset = 0;
+  for (const struct iovec& buffer : iov) {
+    const int64_t buffer_end = offset + buffer.iov_len;
+    if (buffer_end > begin && offset < end) {
+      const int64_t slice_begin = std::max(begin, offset);
+      const int64_t slice_end = std::min(end, buffer_end);
+      struct iovec slice;
+      slice.iov_base = static_cast<char*>(buffer.iov_base) +
+                       (slice_begin - offset);
+      slice.iov_len = slice_end - slice_begin;
+      slices.push_back(slice);
+    }
+    if (buffer_end >= end) {
+      break;
+    }
+    offset = buffer_end;
+  }
+  return slices;
+}
+
 }  // namespace
 
+/* static */ constexpr const int64_t CustomWriter::kCompressionBlockSizeBytes;
 /* static */ constexpr const int64_t
     CustomReader::kSnappyReaderInputBufferSizeBytes;
 /* static */ constexpr const int64_t
@@ -279,8 +340,35 @@ Status CustomWriter::WriteTensors(const std::vector<Tensor>& tensors) {
   DCHECK_EQ(position, uncompressed.data() + total_size);
 
   string output;
-  if (!port::Snappy_Compress(uncompressed.data(), total_size, &output)) {
-    return errors::Internal("Failed to compress using snappy.");
+  if (total_size <= kCompressionBlockSizeBytes) {
+    if (!port::Snappy_Compress(uncompressed.data(), total_size, &output)) {
+      return errors::Internal("Failed to compress using snappy.");
+    }
+  } else {
+    const int64_t num_blocks =
+        (total_size + kCompressionBlockSizeBytes - 1) /
+        kCompressionBlockSizeBytes;
+    std::vector<string> blocks(num_blocks);
+    TF_RETURN_IF_ERROR(ParallelForBlocks(num_blocks, [&](int64_t i) {
+      const int64_t begin = i * kCompressionBlockSizeBytes;
+      const int64_t size =
+          std::min(kCompressionBlockSizeBytes, total_size - begin);
+      if (!port::Snappy_Compress(uncompressed.data() + begin, size,
+                                 &blocks[i])) {
+        return errors::Internal("Failed to compress using snappy.");
+      }
+      return Status::OK();
+    }));
+    metadata.set_compression_block_size_bytes(kCompressionBlockSizeBytes);
+    int64_t output_size = 0;
+    for (const string& block : blocks) {
+      metadata.add_compressed_block_sizes(block.size());
+      output_size += block.size();
+    }
+    output.reserve(output_size);
+    for (const string& block : blocks) {
+      output.append(block);
+    }
   }
 
 #if defined(TF_CORD_SUPPORT)
@@ -874,11 +962,6 @@ Status CustomReader::SnappyUncompress(
         tensor_proto_strs) {
   tstring compressed;
   TF_RETURN_IF_ERROR(ReadRecord(&compressed));
-  size_t size;
-  if (!port::Snappy_GetUncompressedLength(compressed.data(), compressed.size(),
-                                          &size)) {
-    return errors::Internal("Could not get snappy uncompressed length");
-  }
 
   int num_tensors = metadata->tensor_metadata_size();
   std::vector<struct iovec> iov(num_tensors);
@@ -904,6 +987,14 @@ Status CustomReader::SnappyUncompress(
     total_size += iov[index].iov_len;
     index++;
   }
+  if (metadata->compressed_block_sizes_size() > 0) {
+    return SnappyUncompressBlocks(*metadata, compressed, iov);
+  }
+  size_t size;
+  if (!port::Snappy_GetUncompressedLength(compressed.data(), compressed.size(),
+                                          &size)) {
+    return errors::Internal("Could not get snappy uncompressed length");
+  }
   const int64_t size_int = size;
   if (size_int != total_size) {
     return errors::Internal("Uncompressed size mismatch. Snappy expects ", size,
@@ -917,6 +1008,56 @@ Status CustomReader::SnappyUncompress(
   return Status::OK();
 }
 
+Status CustomReader::SnappyUncompressBlocks(
+    const experimental::SnapshotTensorMetadata& metadata,
+    const tstring& compressed, const std::vector<struct iovec>& iov) {
+  const int64_t block_size = metadata.compression_block_size_bytes();
+  const int64_t num_blocks = metadata.compressed_block_sizes_size();
+  int64_t total_size = 0;
+  for (const struct iovec& buffer : iov) {
+    total_size += buffer.iov_len;
+  }
+  if (block_size <= 0 ||
+      (total_size + block_size - 1) / block_size != num_blocks) {
+    return errors::DataLoss("Invalid compression blocks: ", num_blocks,
+                            " blocks of ", block_size, " bytes for ",
+                            total_size, " uncompressed bytes");
+  }
+  std::vector<int64_t> block_offsets(num_blocks);
+  int64_t compressed_size = 0;
+  for (int64_t i = 0; i < num_blocks; ++i) {
+    block_offsets[i] = compressed_size;
+    compressed_size += metadata.compressed_block_sizes(i);
+  }
+  if (compressed_size != static_cast<int64_t>(compressed.size())) {
+    return errors::DataLoss("Compressed size mismatch. The record has ",
+                            compressed.size(), " bytes whereas the blocks ",
+                            "metadata suggests ", compressed_size);
+  }
+  return ParallelForBlocks(num_blocks, [&](int64_t i) {
+    const char* block = compressed.data() + block_offsets[i];
+    const size_t block_compressed_size = metadata.compressed_block_sizes(i);
+    const int64_t begin = i * block_size;
+    const int64_t end = std::min(begin + block_size, total_size);
+    size_t size;
+    if (!port::Snappy_GetUncompressedLength(block, block_compressed_size,
+                                            &size)) {
+      return errors::Internal("Could not get snappy uncompressed length");
+    }
+    if (static_cast<int64_t>(size) != end - begin) {
+      return errors::Internal("Uncompressed size mismatch. Snappy expects ",
+                              size, " whereas the block metadata suggests ",
+                              end - begin);
+    }
+    std::vector<struct iovec> slices = SliceIOVec(iov, begin, end);
+    if (!port::Snappy_UncompressToIOVec(block, block_compressed_size,
+                                        slices.data(), slices.size())) {
+      return errors::Internal("Failed to perform snappy decompression.");
+    }
+    return Status::OK();
+  });
+}
+
 Status CustomReader::ReadRecord(tstring* record) {
   tstring header;
   TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(kHeaderSize, &header));
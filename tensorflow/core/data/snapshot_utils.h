@@ -130,6 +130,12 @@ class CustomWriter : public Writer {
   static constexpr const char* const kWriteCord = "WriteCord";
   static constexpr const char* const kSeparator = "::";
 
+  // With snappy compression, elements larger than this are split into blocks
+  // of this many uncompressed bytes, which are compressed in parallel and can
+  // be decompressed in parallel by `CustomReader`. Smaller elements are
+  // compressed as a single block, as in earlier versions of the format.
+  static constexpr const int64_t kCompressionBlockSizeBytes = 1 << 20;  // 1 MiB
+
   CustomWriter(const std::string& filename, const std::string& compression_type,
                const DataTypeVector& dtypes);
 
@@ -294,6 +300,12 @@ class CustomReader : public Reader {
       std::vector<std::pair<std::unique_ptr<char[]>, size_t>>*
           tensor_proto_strs);
 
+  // Decompresses the independently compressed snappy blocks described by
+  // `metadata` from `compressed` into `iov`, in parallel.
+  Status SnappyUncompressBlocks(
+      const experimental::SnapshotTensorMetadata& metadata,
+      const tstring& compressed, const std::vector<struct iovec>& iov);
+
   Status ReadRecord(tstring* record);
 
 #if defined(TF_CORD_SUPPORT)
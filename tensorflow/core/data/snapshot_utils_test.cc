@@ -16,9 +16,11 @@ limitations under the License.
 #include "tensorflow/core/data/snapshot_utils.h"
 
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -91,6 +93,48 @@ TEST(SnapshotUtilTest, CombinationRoundTripTest) {
   SnapshotRoundTrip(io::compression::kSnappy, 2);
 }
 
+TEST(SnapshotUtilTest, CompressionBlocksRoundTrip) {
+  // The element spans several compression blocks, whose boundaries do not
+  // match the tensor boundaries.
+  std::vector<Tensor> tensors;
+  DataTypeVector dtypes;
+  for (int i = 0; i < 3; ++i) {
+    Tensor numbers(DT_INT64, TensorShape({300000 + i}));
+    numbers.flat<int64_t>().setConstant(i);
+    tensors.push_back(numbers);
+    dtypes.push_back(DT_INT64);
+    tensors.push_back(Tensor(tstring(std::string(200000, 'a' + i))));
+    dtypes.push_back(DT_STRING);
+  }
+
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  std::unique_ptr<Writer> writer;
+  TF_ASSERT_OK(Writer::Create(Env::Default(), filename,
+                              io::compression::kSnappy, /*version=*/1, dtypes,
+                              &writer));
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(writer->WriteTensors(tensors));
+  }
+  TF_ASSERT_OK(writer->Close());
+
+  std::unique_ptr<Reader> reader;
+  TF_ASSERT_OK(Reader::Create(Env::Default(), filename,
+                              io::compression::kSnappy, /*version=*/1, dtypes,
+                              &reader));
+  for (int i = 0; i < 3; ++i) {
+    std::vector<Tensor> read_tensors;
+    TF_ASSERT_OK(reader->ReadTensors(&read_tensors));
+    ASSERT_EQ(read_tensors.size(), tensors.size());
+    for (int j = 0; j < tensors.size(); ++j) {
+      test::ExpectEqual(read_tensors[j], tensors[j]);
+    }
+  }
+  std::vector<Tensor> read_tensors;
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadTensors(&read_tensors)));
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+}
+
 void SnapshotReaderBenchmarkLoop(::testing::benchmark::State& state,
                                  std::string compression_type, int version) {
   tensorflow::DataTypeVector dtypes;
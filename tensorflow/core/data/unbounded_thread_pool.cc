@@ -15,15 +15,285 @@ limitations under the License.
 
 #include "tensorflow/core/data/unbounded_thread_pool.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/resource.h"
-#include "tensorflow/core/platform/unbounded_work_queue.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
+namespace {
+
+constexpr char kSharedThreadName[] = "tf_data_thread_pool";
+constexpr int64_t kDefaultIdleTimeoutMs = 60 * 1000;
+
+int64_t ReadInt64Option(const char* env_var, int64_t default_val) {
+  int64_t value;
+  Status s = ReadInt64FromEnvVar(env_var, default_val, &value);
+  if (!s.ok()) {
+    LOG(WARNING) << s;
+    return default_val;
+  }
+  return value;
+}
+
+int64_t MaxThreads() {
+  static const int64_t max_threads =
+      ReadInt64Option("TF_DATA_THREAD_POOL_MAX_THREADS", /*default_val=*/0);
+  return max_threads;
+}
+
+int64_t IdleTimeoutMicros() {
+  static const int64_t idle_timeout_micros =
+      ReadInt64Option("TF_DATA_THREAD_POOL_IDLE_TIMEOUT_MS",
+                      kDefaultIdleTimeoutMs) *
+      EnvTime::kMillisToMicros;
+  return idle_timeout_micros;
+}
+
+}  // namespace
+
+// Tracks the work that an `UnboundedThreadPool` submitted to its `WorkQueue`.
+// All fields are guarded by the `WorkQueue` mutex.
+struct UnboundedThreadPool::Client {
+  // The closures passed to `Schedule()` that wait for a physical thread.
+  std::deque<std::function<void()>> pending;
+  // Whether the client is in the round-robin list of clients with pending
+  // closures.
+  bool ready = false;
+  // The number of closures of this client that are running.
+  int64_t num_running = 0;
+  condition_variable cond_var;
+};
+
+// A queue of work that is run by an elastic set of physical threads, possibly
+// shared by multiple `UnboundedThreadPool`s.
+class UnboundedThreadPool::WorkQueue {
+ public:
+  WorkQueue(Env* env, const string& thread_name,
+            const ThreadOptions& thread_options, int64_t max_threads,
+            int64_t idle_timeout_micros)
+      : env_(env),
+        thread_name_(thread_name),
+        thread_options_(thread_options),
+        max_threads_(max_threads),
+        idle_timeout_micros_(idle_timeout_micros) {}
+
+  ~WorkQueue() {
+    absl::flat_hash_map<int64_t, std::unique_ptr<Thread>> threads;
+    std::vector<std::unique_ptr<Thread>> exited_threads;
+    {
+      mutex_lock l(mu_);
+      // Wake up all `PooledThreadFunc` threads and cause them to terminate
+      // before joining them when `threads` is destroyed.
+      cancelled_ = true;
+      cond_var_.notify_all();
+      threads.swap(threads_);
+      exited_threads.swap(exited_threads_);
+    }
+  }
+
+  // Returns the work queue shared by the pools that use the default `Env` and
+  // thread options.
+  static std::shared_ptr<WorkQueue> Shared() {
+    static auto* shared = new std::shared_ptr<WorkQueue>(
+        std::make_shared<WorkQueue>(Env::Default(), kSharedThreadName,
+                                    ThreadOptions(), MaxThreads(),
+                                    IdleTimeoutMicros()));
+    return *shared;
+  }
+
+  void Schedule(Client* client, std::function<void()> fn,
+                bool is_logical_thread) {
+    std::vector<std::unique_ptr<Thread>> exited_threads;
+    {
+      mutex_lock l(mu_);
+      exited_threads.swap(exited_threads_);
+      bool start_thread;
+      if (is_logical_thread) {
+        logical_threads_.push_back({client, std::move(fn)});
+        start_thread = logical_threads_.size() > num_idle_threads_;
+      } else {
+        client->pending.push_back(std::move(fn));
+        if (!client->ready) {
+          client->ready = true;
+          ready_clients_.push_back(client);
+        }
+        ++num_pending_;
+        // NOTE: The queue may be non-empty, so we must account for queued
+        // work when considering how many threads are free.
+        start_thread =
+            logical_threads_.size() + num_pending_ > num_idle_threads_ &&
+            (max_threads_ <= 0 ||
+             static_cast<int64_t>(threads_.size()) < max_threads_);
+      }
+      cond_var_.notify_one();
+      if (start_thread) {
+        // NOTE: `PooledThreadFunc` will eventually increment
+        // `num_idle_threads_` at the beginning of its work loop.
+        const int64_t id = next_thread_id_++;
+        threads_[id] = absl::WrapUnique(env_->StartThread(
+            {}, thread_name_, [this, id]() { PooledThreadFunc(id); }));
+        RecordThreads();
+      }
+    }
+    // Joins the threads that exited, outside the lock.
+    exited_threads.clear();
+  }
+
+  // Drops the pending closures of `client` and waits for its running work to
+  // complete.
+  void Unregister(Client* client) {
+    mutex_lock l(mu_);
+    if (!client->pending.empty() ||
+        std::any_of(logical_threads_.begin(), logical_threads_.end(),
+                    [client](const Work& work) {
+                      return work.client == client;
+                    })) {
+      LOG(ERROR) << "UnboundedThreadPool was deleted with pending work in its "
+                 << "queue. This may indicate a potential use-after-free bug.";
+    }
+    num_pending_ -= client->pending.size();
+    client->pending.clear();
+    if (client->ready) {
+      ready_clients_.erase(
+          std::find(ready_clients_.begin(), ready_clients_.end(), client));
+      client->ready = false;
+    }
+    logical_threads_.erase(
+        std::remove_if(
+            logical_threads_.begin(), logical_threads_.end(),
+            [client](const Work& work) { return work.client == client; }),
+        logical_threads_.end());
+    while (client->num_running > 0) {
+      client->cond_var.wait(l);
+    }
+  }
+
+  int64_t NumThreads() const {
+    mutex_lock l(mu_);
+    return threads_.size();
+  }
+
+ private:
+  struct Work {
+    Client* client;
+    std::function<void()> fn;
+  };
+
+  bool HasWork() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return !logical_threads_.empty() || !ready_clients_.empty();
+  }
+
+  // Returns the next work item. Logical threads come first, followed by the
+  // pending closures of the clients in round-robin order.
+  Work PopWork() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Work work;
+    if (!logical_threads_.empty()) {
+      work = std::move(logical_threads_.front());
+      logical_threads_.pop_front();
+    } else {
+      Client* client = ready_clients_.front();
+      ready_clients_.pop_front();
+      work = {client, std::move(client->pending.front())};
+      client->pending.pop_front();
+      --num_pending_;
+      if (client->pending.empty()) {
+        client->ready = false;
+      } else {
+        ready_clients_.push_back(client);
+      }
+    }
+    ++work.client->num_running;
+    return work;
+  }
+
+  void PooledThreadFunc(int64_t id) {
+    // If specified, make sure the thread runs on the correct NUMA node.
+    if (thread_options_.numa_node != port::kNUMANoAffinity) {
+      port::NUMASetThreadNodeAffinity(thread_options_.numa_node);
+    }
+
+    while (true) {
+      Work work;
+      {
+        mutex_lock l(mu_);
+        ++num_idle_threads_;
+        RecordThreads();
+        bool timed_out = false;
+        while (!cancelled_ && !HasWork() && !timed_out) {
+          // Wait for a new work function to be submitted, the idle timeout
+          // to expire, or the queue to be destroyed.
+          if (idle_timeout_micros_ > 0) {
+            timed_out = cond_var_.wait_for(l, std::chrono::microseconds(
+                                                  idle_timeout_micros_)) ==
+                        std::cv_status::timeout;
+          } else {
+            cond_var_.wait(l);
+          }
+        }
+        --num_idle_threads_;
+        if (cancelled_) {
+          return;
+        }
+        if (!HasWork()) {
+          // Hand the thread over to be joined by the next `Schedule()` call,
+          // since a thread cannot join itself.
+          auto it = threads_.find(id);
+          exited_threads_.push_back(std::move(it->second));
+          threads_.erase(it);
+          RecordThreads();
+          return;
+        }
+        work = PopWork();
+      }
+
+      work.fn();
+
+      mutex_lock l(mu_);
+      if (--work.client->num_running == 0) {
+        work.client->cond_var.notify_all();
+      }
+    }
+  }
+
+  void RecordThreads() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    metrics::RecordTFDataThreadPoolThreads(thread_name_, "total",
+                                           threads_.size());
+    metrics::RecordTFDataThreadPoolThreads(thread_name_, "idle",
+                                           num_idle_threads_);
+  }
+
+  Env* const env_;  // Not owned.
+  const string thread_name_;
+  const ThreadOptions thread_options_;
+  const int64_t max_threads_;
+  const int64_t idle_timeout_micros_;
+
+  mutable mutex mu_;
+  condition_variable cond_var_ TF_GUARDED_BY(mu_);
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  std::deque<Work> logical_threads_ TF_GUARDED_BY(mu_);
+  std::deque<Client*> ready_clients_ TF_GUARDED_BY(mu_);
+  size_t num_pending_ TF_GUARDED_BY(mu_) = 0;
+  size_t num_idle_threads_ TF_GUARDED_BY(mu_) = 0;
+  int64_t next_thread_id_ TF_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_map<int64_t, std::unique_ptr<Thread>> threads_
+      TF_GUARDED_BY(mu_);
+  std::vector<std::unique_ptr<Thread>> exited_threads_ TF_GUARDED_BY(mu_);
+};
 
 // A logical implementation of the `tensorflow::Thread` interface that uses
 // physical threads in an `UnboundedThreadPool` to perform the work.
@@ -57,7 +327,8 @@ class UnboundedThreadPool::LogicalThreadFactory : public ThreadFactory {
   std::unique_ptr<Thread> StartThread(const string& name,
                                       std::function<void()> fn) override {
     auto done = std::make_shared<Notification>();
-    pool_->ScheduleOnWorkQueue(std::move(fn), done);
+    pool_->ScheduleOnWorkQueue(std::move(fn), done,
+                               /*is_logical_thread=*/true);
     return absl::make_unique<LogicalThreadWrapper>(std::move(done));
   }
 
@@ -65,6 +336,34 @@ class UnboundedThreadPool::LogicalThreadFactory : public ThreadFactory {
   UnboundedThreadPool* const pool_;  // Not owned.
 };
 
+UnboundedThreadPool::UnboundedThreadPool(Env* env, const string& thread_name)
+    : UnboundedThreadPool(env, thread_name, ThreadOptions()) {}
+
+UnboundedThreadPool::UnboundedThreadPool(Env* env, const string& thread_name,
+                                         const ThreadOptions& thread_options)
+    : work_queue_(env == Env::Default() &&
+                          thread_options.stack_size == 0 &&
+                          thread_options.guard_size == 0 &&
+                          thread_options.numa_node == port::kNUMANoAffinity
+                      ? WorkQueue::Shared()
+                      : std::make_shared<WorkQueue>(
+                            env, thread_name, thread_options, MaxThreads(),
+                            IdleTimeoutMicros())),
+      client_(absl::make_unique<Client>()) {}
+
+UnboundedThreadPool::UnboundedThreadPool(Env* env, const string& thread_name,
+                                         const ThreadOptions& thread_options,
+                                         int64_t max_threads,
+                                         int64_t idle_timeout_micros)
+    : work_queue_(std::make_shared<WorkQueue>(env, thread_name, thread_options,
+                                              max_threads,
+                                              idle_timeout_micros)),
+      client_(absl::make_unique<Client>()) {}
+
+UnboundedThreadPool::~UnboundedThreadPool() {
+  work_queue_->Unregister(client_.get());
+}
+
 std::shared_ptr<ThreadFactory> UnboundedThreadPool::get_thread_factory() {
   return std::make_shared<LogicalThreadFactory>(this);
 }
@@ -74,13 +373,18 @@ void UnboundedThreadPool::Schedule(std::function<void()> fn) {
     tensorflow::ResourceTagger tag(kTFDataResourceTag, "ThreadPool");
     fn();
   };
-  ScheduleOnWorkQueue(std::move(tagged_fn), /*done=*/nullptr);
+  ScheduleOnWorkQueue(std::move(tagged_fn), /*done=*/nullptr,
+                      /*is_logical_thread=*/false);
 }
 
 int UnboundedThreadPool::NumThreads() const { return -1; }
 
 int UnboundedThreadPool::CurrentThreadId() const { return -1; }
 
+int64_t UnboundedThreadPool::NumPhysicalThreads() const {
+  return work_queue_->NumThreads();
+}
+
 namespace {
 void WorkQueueFunc(const std::function<void()>& fn,
                    std::shared_ptr<Notification> done) {
@@ -92,9 +396,11 @@ void WorkQueueFunc(const std::function<void()>& fn,
 }  // namespace
 
 void UnboundedThreadPool::ScheduleOnWorkQueue(
-    std::function<void()> fn, std::shared_ptr<Notification> done) {
-  unbounded_work_queue_.Schedule(
-      std::bind(&WorkQueueFunc, std::move(fn), std::move(done)));
+    std::function<void()> fn, std::shared_ptr<Notification> done,
+    bool is_logical_thread) {
+  work_queue_->Schedule(
+      client_.get(), std::bind(&WorkQueueFunc, std::move(fn), std::move(done)),
+      is_logical_thread);
 }
 
 }  // namespace data
@@ -23,23 +23,43 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/threadpool_interface.h"
 #include "tensorflow/core/platform/env.h"
-#include "tensorflow/core/platform/unbounded_work_queue.h"
 
 namespace tensorflow {
 namespace data {
 
 // An `UnboundedThreadPool` provides a mechanism for temporally multiplexing a
 // potentially large number of "logical" threads onto a smaller number of
-// "physical" threads. The multiplexing is achieved by using an
-// `UnboundedWorkQueue`.
+// "physical" threads.
+//
+// The physical threads are elastic: a thread that stays idle for longer than
+// the idle timeout exits, so bursts of work do not leave idle threads behind.
+// Pools created with the default `Env` and thread options share their
+// physical threads with all such pools in the process, and queued closures
+// passed to `Schedule()` are served round-robin across the pools. The limits
+// of the shared threads can be configured with the following environment
+// variables:
+//
+// * TF_DATA_THREAD_POOL_MAX_THREADS: the maximum number of physical threads
+//   that are started to run closures passed to `Schedule()`. Logical threads
+//   created through `get_thread_factory()` are typically long-lived and may
+//   block on each other, so they always get a physical thread. 0 (the
+//   default) means no limit.
+// * TF_DATA_THREAD_POOL_IDLE_TIMEOUT_MS: how long an idle physical thread is
+//   kept before it exits. Defaults to one minute. 0 means idle threads are
+//   kept forever.
 class UnboundedThreadPool : public thread::ThreadPoolInterface {
  public:
-  UnboundedThreadPool(Env* env, const string& thread_name)
-      : unbounded_work_queue_(env, thread_name) {}
+  UnboundedThreadPool(Env* env, const string& thread_name);
   UnboundedThreadPool(Env* env, const string& thread_name,
-                      const ThreadOptions& thread_options)
-      : unbounded_work_queue_(env, thread_name, thread_options) {}
-  ~UnboundedThreadPool() override = default;
+                      const ThreadOptions& thread_options);
+  // Creates a pool with its own physical threads, limited by `max_threads`
+  // and `idle_timeout_micros` as described above.
+  UnboundedThreadPool(Env* env, const string& thread_name,
+                      const ThreadOptions& thread_options, int64_t max_threads,
+                      int64_t idle_timeout_micros);
+  // Waits for the running work of this pool to complete. Work that is still
+  // queued is dropped.
+  ~UnboundedThreadPool() override;
 
   // Returns an implementation of `ThreadFactory` that can be used to create
   // logical threads in this pool.
@@ -49,14 +69,22 @@ class UnboundedThreadPool : public thread::ThreadPoolInterface {
   int NumThreads() const override;
   int CurrentThreadId() const override;
 
+  // Returns the number of physical threads that currently back this pool,
+  // including the threads shared with other pools.
+  int64_t NumPhysicalThreads() const;
+
  private:
   class LogicalThreadFactory;
   class LogicalThreadWrapper;
+  class WorkQueue;
+  struct Client;
 
   void ScheduleOnWorkQueue(std::function<void()> fn,
-                           std::shared_ptr<Notification> done);
+                           std::shared_ptr<Notification> done,
+                           bool is_logical_thread);
 
-  UnboundedWorkQueue unbounded_work_queue_;
+  const std::shared_ptr<WorkQueue> work_queue_;
+  const std::unique_ptr<Client> client_;
 };
 
 }  // namespace data
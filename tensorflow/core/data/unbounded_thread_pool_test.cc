@@ -15,8 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/data/unbounded_thread_pool.h"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -79,6 +85,87 @@ TEST(UnboundedThreadPool, MultipleBlockingThreads) {
   }
 }
 
+TEST(UnboundedThreadPool, IdleThreadsExit) {
+  UnboundedThreadPool pool(Env::Default(), "test", ThreadOptions(),
+                           /*max_threads=*/0, /*idle_timeout_micros=*/1000);
+  auto thread_factory = pool.get_thread_factory();
+
+  const int kNumThreads = 5;
+  std::vector<std::unique_ptr<Thread>> threads;
+  Notification n;
+  BlockingCounter bc(kNumThreads);
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(thread_factory->StartThread("", [&bc, &n]() {
+      bc.DecrementCount();
+      n.WaitForNotification();
+    }));
+  }
+  bc.Wait();
+  EXPECT_GE(pool.NumPhysicalThreads(), kNumThreads);
+  n.Notify();
+  threads.clear();
+
+  // The idle threads exit once the idle timeout expires, and are joined by
+  // the next scheduled closure.
+  while (pool.NumPhysicalThreads() > 0) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  Notification done;
+  pool.Schedule([&done]() { done.Notify(); });
+  done.WaitForNotification();
+  EXPECT_LE(pool.NumPhysicalThreads(), 1);
+}
+
+TEST(UnboundedThreadPool, MaxThreadsLimitsScheduledClosures) {
+  const int kMaxThreads = 2;
+  UnboundedThreadPool pool(Env::Default(), "test", ThreadOptions(),
+                           kMaxThreads, /*idle_timeout_micros=*/0);
+
+  const int kNumClosures = 20;
+  mutex mu;
+  int num_running = 0;
+  int max_running = 0;
+  BlockingCounter bc(kNumClosures);
+  for (int i = 0; i < kNumClosures; ++i) {
+    pool.Schedule([&]() {
+      {
+        mutex_lock l(mu);
+        max_running = std::max(max_running, ++num_running);
+      }
+      Env::Default()->SleepForMicroseconds(1000);
+      {
+        mutex_lock l(mu);
+        --num_running;
+      }
+      bc.DecrementCount();
+    });
+  }
+  bc.Wait();
+  EXPECT_LE(max_running, kMaxThreads);
+  EXPECT_LE(pool.NumPhysicalThreads(), kMaxThreads);
+}
+
+TEST(UnboundedThreadPool, MaxThreadsDoesNotLimitLogicalThreads) {
+  const int kMaxThreads = 2;
+  UnboundedThreadPool pool(Env::Default(), "test", ThreadOptions(),
+                           kMaxThreads, /*idle_timeout_micros=*/0);
+  auto thread_factory = pool.get_thread_factory();
+
+  // The logical threads block until all of them have started, which requires
+  // more physical threads than `kMaxThreads`.
+  const int kNumThreads = 5;
+  std::vector<std::unique_ptr<Thread>> threads;
+  BlockingCounter bc(kNumThreads);
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(thread_factory->StartThread("", [&bc]() {
+      bc.DecrementCount();
+      bc.Wait();
+    }));
+  }
+  threads.clear();
+  EXPECT_GE(pool.NumPhysicalThreads(), kNumThreads);
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -0,0 +1,285 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/chunked_tensor_transport.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+
+namespace tensorflow {
+namespace {
+
+auto* chunked_tensor_bytes = monitoring::Counter<0>::New(
+    "/tensorflow/core/rpc/chunked_tensor_bytes",
+    "The number of content bytes of the tensors received in chunks by "
+    "RecvTensor calls.");
+
+// Fetches the chunks of a staged tensor into `tensor`, and deletes itself
+// once they have all arrived or one of them failed.
+class ChunkFetcher {
+ public:
+  ChunkFetcher(WorkerInterface* src_worker, const ChunkedTensor& chunked,
+               Tensor tensor, Tensor* val, StatusCallback done)
+      : src_worker_(src_worker),
+        staging_id_(chunked.staging_id()),
+        chunk_bytes_(chunked.chunk_bytes()),
+        num_chunks_((tensor.TotalBytes() + chunk_bytes_ - 1) / chunk_bytes_),
+        tensor_(std::move(tensor)),
+        val_(val),
+        done_(std::move(done)) {}
+
+  void Start() {
+    const int64_t num_initial = std::min<int64_t>(
+        num_chunks_, ChunkedTensorTransport::kMaxChunksInFlight);
+    {
+      mutex_lock l(mu_);
+      next_chunk_ = num_initial;
+      num_outstanding_ = num_initial;
+    }
+    for (int64_t i = 0; i < num_initial; ++i) FetchChunk(i);
+  }
+
+ private:
+  void FetchChunk(int64_t chunk) {
+    auto* request = new RecvTensorChunkRequest;
+    auto* response = new RecvTensorChunkResponse;
+    request->set_staging_id(staging_id_);
+    request->set_offset(chunk * chunk_bytes_);
+    request->set_length(std::min<int64_t>(
+        chunk_bytes_, tensor_.TotalBytes() - request->offset()));
+    src_worker_->RecvTensorChunkAsync(
+        request, response, [this, request, response](const Status& s) {
+          Status status = s;
+          if (status.ok() && response->data().size() != request->length()) {
+            status = errors::DataLoss("Received ", response->data().size(),
+                                      " bytes for a chunk of ",
+                                      request->length(), " bytes");
+          }
+          if (status.ok()) {
+            char* output = const_cast<char*>(tensor_.tensor_data().data());
+            std::memcpy(output + request->offset(), response->data().data(),
+                        request->length());
+          }
+          delete request;
+          delete response;
+
+          int64_t next_chunk = -1;
+          bool finished = false;
+          {
+            mutex_lock l(mu_);
+            status_.Update(status);
+            if (status_.ok() && next_chunk_ < num_chunks_) {
+              next_chunk = next_chunk_++;
+            } else {
+              finished = --num_outstanding_ == 0;
+            }
+          }
+          if (next_chunk >= 0) {
+            FetchChunk(next_chunk);
+          } else if (finished) {
+            Finish();
+          }
+        });
+  }
+
+  void Finish() {
+    // No chunk is outstanding, so `status_` doesn't change anymore.
+    Status status;
+    {
+      mutex_lock l(mu_);
+      status = status_;
+    }
+    if (status.ok()) {
+      chunked_tensor_bytes->GetCell()->IncrementBy(tensor_.TotalBytes());
+      *val_ = std::move(tensor_);
+    }
+    done_(status);
+    delete this;
+  }
+
+  WorkerInterface* const src_worker_;  // Not owned.
+  const uint64 staging_id_;
+  const int64_t chunk_bytes_;
+  const int64_t num_chunks_;
+  Tensor tensor_;
+  Tensor* const val_;  // Not owned.
+  const StatusCallback done_;
+
+  mutex mu_;
+  int64_t next_chunk_ TF_GUARDED_BY(mu_) = 0;
+  int64_t num_outstanding_ TF_GUARDED_BY(mu_) = 0;
+  Status status_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+ChunkedTensorTransport::ChunkedTensorTransport(
+    int64_t chunk_bytes, std::unique_ptr<TensorTransport> base,
+    int64_t stale_tensor_secs)
+    : chunk_bytes_(std::max<int64_t>(chunk_bytes, 1)),
+      stale_tensor_secs_(stale_tensor_secs),
+      base_(std::move(base)) {}
+
+int64_t ChunkedTensorTransport::num_staged_tensors() const {
+  mutex_lock l(mu_);
+  return staged_.size();
+}
+
+void ChunkedTensorTransport::DropTensorsStagedBefore(uint64 cutoff_micros) {
+  mutex_lock l(mu_);
+  while (!staging_order_.empty() &&
+         staging_order_.front().second < cutoff_micros) {
+    // Usually the receiver has fetched the tensor already.
+    staged_.erase(staging_order_.front().first);
+    staging_order_.pop_front();
+  }
+}
+
+bool ChunkedTensorTransport::PrepareRecv(
+    const string& src_worker, StringPiece rendezvous_key,
+    const Device* dst_device, const AllocatorAttributes& alloc_attrs,
+    ::google::protobuf::Any* options) {
+  if (!alloc_attrs.on_host() && dst_device->device_type() != DEVICE_CPU) {
+    return false;
+  }
+  ChunkedTensorRecvOptions recv_options;
+  if (base_ != nullptr &&
+      !base_->PrepareRecv(src_worker, rendezvous_key, dst_device, alloc_attrs,
+                          recv_options.mutable_base_options())) {
+    recv_options.clear_base_options();
+  }
+  options->PackFrom(recv_options);
+  return true;
+}
+
+bool ChunkedTensorTransport::Send(
+    const ::google::protobuf::Any& request_options, const Tensor& val,
+    ::google::protobuf::Any* response_options) {
+  ChunkedTensorRecvOptions recv_options;
+  if (!request_options.UnpackTo(&recv_options)) return false;
+  if (base_ != nullptr && recv_options.has_base_options() &&
+      base_->Send(recv_options.base_options(), val, response_options)) {
+    return true;
+  }
+  if (!DataTypeCanUseMemcpy(val.dtype()) ||
+      static_cast<int64_t>(val.TotalBytes()) <= chunk_bytes_) {
+    return false;
+  }
+  const uint64 now_micros = Env::Default()->NowMicros();
+  DropTensorsStagedBefore(now_micros - stale_tensor_secs_ * 1000000);
+
+  uint64 staging_id;
+  {
+    mutex_lock l(mu_);
+    do {
+      staging_id = random::New64();
+    } while (staged_.contains(staging_id));
+    staged_.emplace(staging_id,
+                    StagedTensor{val, static_cast<int64_t>(val.TotalBytes())});
+    staging_order_.emplace_back(staging_id, now_micros);
+  }
+  ChunkedTensor chunked;
+  chunked.set_dtype(val.dtype());
+  val.shape().AsProto(chunked.mutable_shape());
+  chunked.set_staging_id(staging_id);
+  chunked.set_chunk_bytes(chunk_bytes_);
+  response_options->PackFrom(chunked);
+  return true;
+}
+
+void ChunkedTensorTransport::RecvTensorChunkAsync(
+    const RecvTensorChunkRequest* request, RecvTensorChunkResponse* response,
+    StatusCallback done) {
+  Tensor val;
+  {
+    mutex_lock l(mu_);
+    auto it = staged_.find(request->staging_id());
+    if (it == staged_.end()) {
+      done(errors::NotFound("No staged tensor ", request->staging_id(),
+                            ". It may have been sent over ",
+                            stale_tensor_secs_, " seconds ago."));
+      return;
+    }
+    StagedTensor& staged = it->second;
+    const int64_t size = staged.val.TotalBytes();
+    if (request->offset() < 0 || request->length() <= 0 ||
+        request->offset() > size - request->length()) {
+      done(errors::InvalidArgument("Invalid chunk of ", request->length(),
+                                   " bytes at ", request->offset(),
+                                   " of a tensor of ", size, " bytes"));
+      return;
+    }
+    val = staged.val;
+    staged.remaining_bytes -= request->length();
+    if (staged.remaining_bytes <= 0) staged_.erase(it);
+  }
+  response->set_data(val.tensor_data().data() + request->offset(),
+                     request->length());
+  done(Status::OK());
+}
+
+void ChunkedTensorTransport::RecvAsync(
+    const ::google::protobuf::Any& response_options,
+    WorkerInterface* src_worker, Device* dst_device,
+    const AllocatorAttributes& alloc_attrs, Tensor* val, StatusCallback done) {
+  if (!response_options.Is<ChunkedTensor>() && base_ != nullptr) {
+    base_->RecvAsync(response_options, src_worker, dst_device, alloc_attrs,
+                     val, std::move(done));
+    return;
+  }
+  ChunkedTensor chunked;
+  if (!response_options.UnpackTo(&chunked) || chunked.chunk_bytes() <= 0) {
+    done(errors::Internal("Invalid chunked tensor: ",
+                          response_options.DebugString()));
+    return;
+  }
+  if (src_worker == nullptr) {
+    done(errors::Internal("Chunked tensors need the sending worker"));
+    return;
+  }
+  TensorShape shape;
+  Status s = TensorShape::BuildTensorShape(chunked.shape(), &shape);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+  Tensor tensor(dst_device->GetAllocator(alloc_attrs), chunked.dtype(),
+                shape);
+  if (!tensor.IsInitialized()) {
+    done(errors::ResourceExhausted("Could not allocate a tensor of shape ",
+                                   shape.DebugString(), " for its chunks"));
+    return;
+  }
+  if (tensor.TotalBytes() == 0) {
+    *val = std::move(tensor);
+    done(Status::OK());
+    return;
+  }
+  (new ChunkFetcher(src_worker, chunked, std::move(tensor), val,
+                    std::move(done)))
+      ->Start();
+}
+
+}  // namespace tensorflow
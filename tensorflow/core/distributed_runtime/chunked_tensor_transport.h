@@ -0,0 +1,99 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_CHUNKED_TENSOR_TRANSPORT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_CHUNKED_TENSOR_TRANSPORT_H_
+
+#include <deque>
+#include <memory>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// A TensorTransport that sends the content of large tensors in chunks,
+// instead of encoding it in a single RecvTensorResponse, which must fit in a
+// gRPC message and be received completely before it is decoded.
+//
+// The sender keeps a reference to each tensor of more than `chunk_bytes`
+// bytes, and the receiver fetches its content with RecvTensorChunk calls to
+// the sending worker, up to kMaxChunksInFlight at a time, copying each chunk
+// into the destination tensor as it arrives. The sender drops a tensor once
+// all of its content has been fetched, or after `stale_tensor_secs` in case
+// the receiver failed. Only host tensors of types that can be memcpy'd use
+// the transport.
+//
+// A `base` transport, e.g. shared memory, is offered along with chunking and
+// preferred by the sender when it accepts the tensor.
+class ChunkedTensorTransport : public TensorTransport {
+ public:
+  static constexpr int kMaxChunksInFlight = 4;
+  static constexpr int64_t kDefaultStaleTensorSecs = 300;
+
+  ChunkedTensorTransport(int64_t chunk_bytes,
+                         std::unique_ptr<TensorTransport> base,
+                         int64_t stale_tensor_secs = kDefaultStaleTensorSecs);
+
+  bool PrepareRecv(const string& src_worker, StringPiece rendezvous_key,
+                   const Device* dst_device,
+                   const AllocatorAttributes& alloc_attrs,
+                   ::google::protobuf::Any* options) override;
+
+  bool Send(const ::google::protobuf::Any& request_options, const Tensor& val,
+            ::google::protobuf::Any* response_options) override;
+
+  void RecvAsync(const ::google::protobuf::Any& response_options,
+                 WorkerInterface* src_worker, Device* dst_device,
+                 const AllocatorAttributes& alloc_attrs, Tensor* val,
+                 StatusCallback done) override;
+
+  void RecvTensorChunkAsync(const RecvTensorChunkRequest* request,
+                            RecvTensorChunkResponse* response,
+                            StatusCallback done) override;
+
+  // The number of tensors kept for their receivers.
+  int64_t num_staged_tensors() const;
+
+ private:
+  struct StagedTensor {
+    Tensor val;
+    // The number of bytes of content not fetched yet.
+    int64_t remaining_bytes;
+  };
+
+  // Drops the tensors staged before `cutoff_micros`.
+  void DropTensorsStagedBefore(uint64 cutoff_micros);
+
+  const int64_t chunk_bytes_;
+  const int64_t stale_tensor_secs_;
+  const std::unique_ptr<TensorTransport> base_;
+
+  mutable mutex mu_;
+  absl::flat_hash_map<uint64, StagedTensor> staged_ TF_GUARDED_BY(mu_);
+  // Ids and staging times of the tensors, oldest first. May hold the ids of
+  // tensors that were fetched already.
+  std::deque<std::pair<uint64, uint64>> staging_order_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ChunkedTensorTransport);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_CHUNKED_TENSOR_TRANSPORT_H_
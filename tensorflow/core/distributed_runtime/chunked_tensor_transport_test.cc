@@ -0,0 +1,241 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/chunked_tensor_transport.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/distributed_runtime/shared_memory_tensor_transport.h"
+#include "tensorflow/core/distributed_runtime/test_utils.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int64_t kChunkBytes = 1000;
+
+class FakeDevice : public Device {
+ public:
+  FakeDevice() : Device(nullptr, MakeAttributes()) {}
+  Status Sync() override { return Status::OK(); }
+  Allocator* GetAllocator(AllocatorAttributes) override {
+    return cpu_allocator();
+  }
+
+ private:
+  static DeviceAttributes MakeAttributes() {
+    DeviceAttributes attr;
+    attr.set_name("/job:worker/replica:0/task:0/device:CPU:0");
+    attr.set_device_type(DEVICE_CPU);
+    return attr;
+  }
+};
+
+// Serves RecvTensorChunk calls from the transport of the sender, either
+// inline or when the test runs the deferred calls.
+class FakeWorker : public TestWorkerInterface {
+ public:
+  explicit FakeWorker(TensorTransport* transport) : transport_(transport) {}
+
+  void RecvTensorChunkAsync(const RecvTensorChunkRequest* request,
+                            RecvTensorChunkResponse* response,
+                            StatusCallback done) override {
+    ++num_calls_;
+    if (!defer_) {
+      transport_->RecvTensorChunkAsync(request, response, std::move(done));
+      return;
+    }
+    deferred_.push_back([this, request, response, done]() {
+      transport_->RecvTensorChunkAsync(request, response, done);
+    });
+  }
+
+  // Runs the deferred calls, and those they issue, and returns the largest
+  // number of calls that were outstanding at once.
+  int RunDeferredCalls() {
+    int max_outstanding = 0;
+    while (!deferred_.empty()) {
+      max_outstanding = std::max<int>(max_outstanding, deferred_.size());
+      std::function<void()> call = std::move(deferred_.front());
+      deferred_.erase(deferred_.begin());
+      call();
+    }
+    return max_outstanding;
+  }
+
+  bool defer_ = false;
+  int num_calls_ = 0;
+
+ private:
+  TensorTransport* const transport_;
+  std::vector<std::function<void()>> deferred_;
+};
+
+class ChunkedTensorTransportTest : public ::testing::Test {
+ protected:
+  ChunkedTensorTransportTest()
+      : transport_(kChunkBytes, /*base=*/nullptr), worker_(&transport_) {}
+
+  // Runs the receiver and the sender sides of a RecvTensor call of `val`.
+  // Leaves the receiver side running if the worker defers its calls.
+  void StartTransfer(const Tensor& val, Tensor* received, bool* transported,
+                     Status* status) {
+    ::google::protobuf::Any request_options;
+    ASSERT_TRUE(transport_.PrepareRecv("/job:worker/replica:0/task:1", "key",
+                                       &cpu_, AllocatorAttributes(),
+                                       &request_options));
+    *transported = transport_.Send(request_options, val, &response_options_);
+    if (!*transported) return;
+    transport_.RecvAsync(response_options_, &worker_, &cpu_,
+                         AllocatorAttributes(), received,
+                         [status](const Status& s) { *status = s; });
+  }
+
+  ChunkedTensorTransport transport_;
+  FakeWorker worker_;
+  ::google::protobuf::Any response_options_;
+  FakeDevice cpu_;
+};
+
+Tensor FloatTensor(int64_t n) {
+  Tensor val(DT_FLOAT, TensorShape({n}));
+  auto flat = val.flat<float>();
+  for (int64_t i = 0; i < n; ++i) flat(i) = i;
+  return val;
+}
+
+TEST_F(ChunkedTensorTransportTest, TransfersTensorInChunks) {
+  // Several chunks, the last of which is partial.
+  const Tensor val = FloatTensor(2600);
+  Tensor received;
+  bool transported;
+  Status status = errors::Unknown("Not done");
+  StartTransfer(val, &received, &transported, &status);
+  ASSERT_TRUE(transported);
+  TF_ASSERT_OK(status);
+  test::ExpectTensorEqual<float>(received, val);
+  EXPECT_EQ(worker_.num_calls_, 11);
+  EXPECT_TRUE(response_options_.Is<ChunkedTensor>());
+  EXPECT_EQ(transport_.num_staged_tensors(), 0);
+}
+
+TEST_F(ChunkedTensorTransportTest, KeepsChunksInFlight) {
+  worker_.defer_ = true;
+  const Tensor val = FloatTensor(5000);
+  Tensor received;
+  bool transported;
+  Status status = errors::Unknown("Not done");
+  StartTransfer(val, &received, &transported, &status);
+  ASSERT_TRUE(transported);
+  EXPECT_EQ(worker_.RunDeferredCalls(),
+            ChunkedTensorTransport::kMaxChunksInFlight);
+  TF_ASSERT_OK(status);
+  test::ExpectTensorEqual<float>(received, val);
+  EXPECT_EQ(worker_.num_calls_, 20);
+}
+
+TEST_F(ChunkedTensorTransportTest, SmallAndStringTensorsUseResponse) {
+  Tensor received;
+  bool transported;
+  Status status;
+  StartTransfer(FloatTensor(kChunkBytes / sizeof(float)), &received,
+                &transported, &status);
+  EXPECT_FALSE(transported);
+  StartTransfer(Tensor(DT_STRING, TensorShape({10000})), &received,
+                &transported, &status);
+  EXPECT_FALSE(transported);
+  EXPECT_EQ(transport_.num_staged_tensors(), 0);
+}
+
+TEST_F(ChunkedTensorTransportTest, RejectsUnknownTensorsAndChunks) {
+  ::google::protobuf::Any request_options;
+  request_options.PackFrom(ChunkedTensorRecvOptions());
+  ASSERT_TRUE(
+      transport_.Send(request_options, FloatTensor(1000), &response_options_));
+  ChunkedTensor chunked;
+  ASSERT_TRUE(response_options_.UnpackTo(&chunked));
+
+  RecvTensorChunkRequest request;
+  RecvTensorChunkResponse response;
+  Status status;
+  auto done = [&status](const Status& s) { status = s; };
+  request.set_staging_id(chunked.staging_id() + 1);
+  request.set_length(kChunkBytes);
+  transport_.RecvTensorChunkAsync(&request, &response, done);
+  EXPECT_TRUE(errors::IsNotFound(status)) << status;
+
+  request.set_staging_id(chunked.staging_id());
+  request.set_offset(3500);
+  transport_.RecvTensorChunkAsync(&request, &response, done);
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+
+  request.set_offset(3000);
+  request.set_length(1000);
+  transport_.RecvTensorChunkAsync(&request, &response, done);
+  TF_EXPECT_OK(status);
+  EXPECT_EQ(response.data().size(), 1000);
+  EXPECT_EQ(transport_.num_staged_tensors(), 1);
+}
+
+TEST(ChunkedTensorTransport, DropsStaleTensors) {
+  ChunkedTensorTransport transport(kChunkBytes, /*base=*/nullptr,
+                                   /*stale_tensor_secs=*/0);
+  ::google::protobuf::Any request_options;
+  request_options.PackFrom(ChunkedTensorRecvOptions());
+  ::google::protobuf::Any response_options;
+  ASSERT_TRUE(
+      transport.Send(request_options, FloatTensor(1000), &response_options));
+  Env::Default()->SleepForMicroseconds(1000);
+  ASSERT_TRUE(
+      transport.Send(request_options, FloatTensor(1000), &response_options));
+  EXPECT_EQ(transport.num_staged_tensors(), 1);
+}
+
+TEST(ChunkedTensorTransport, PrefersBaseTransport) {
+  std::unique_ptr<TensorTransport> shared_memory =
+      SharedMemoryTensorTransport::Create();
+  if (shared_memory == nullptr) GTEST_SKIP() << "No POSIX shared memory";
+  ChunkedTensorTransport transport(kChunkBytes, std::move(shared_memory));
+  FakeDevice cpu;
+  ::google::protobuf::Any request_options;
+  ASSERT_TRUE(transport.PrepareRecv("/job:worker/replica:0/task:1", "key",
+                                    &cpu, AllocatorAttributes(),
+                                    &request_options));
+  const Tensor val = FloatTensor(64 << 10);
+  ::google::protobuf::Any response_options;
+  ASSERT_TRUE(transport.Send(request_options, val, &response_options));
+  EXPECT_TRUE(response_options.Is<SharedMemoryTensorLocation>());
+  Tensor received;
+  Status status;
+  transport.RecvAsync(response_options, /*src_worker=*/nullptr, &cpu,
+                      AllocatorAttributes(), &received,
+                      [&status](const Status& s) { status = s; });
+  TF_ASSERT_OK(status);
+  test::ExpectTensorEqual<float>(received, val);
+  EXPECT_EQ(transport.num_staged_tensors(), 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
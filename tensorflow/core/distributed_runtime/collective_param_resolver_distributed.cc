@@ -360,41 +360,89 @@ Status CollectiveParamResolverDistributed::UpdateInstanceCache(
   return ir->status;
 }
 
+std::vector<StatusCallback>
+CollectiveParamResolverDistributed::TakePendingInstanceWaiters(
+    const std::pair<int32, int32>& key) {
+  std::vector<StatusCallback> waiters;
+  mutex_lock l(pending_mu_);
+  auto it = pending_instance_calls_.find(key);
+  if (it != pending_instance_calls_.end()) {
+    waiters = std::move(it->second);
+    pending_instance_calls_.erase(it);
+  }
+  return waiters;
+}
+
 void CollectiveParamResolverDistributed::CompleteInstanceDistributed(
     const string& device, CollectiveParams* cp, CancellationManager* cancel_mgr,
     const StatusCallback& done) {
   if (group_leader_.empty()) {
     // This is the group leader so resolution is local.
     return CompleteInstanceLocal(device, cp, done);
-  } else if (InstanceIsCached(cp->group.group_key, cp->instance.instance_key)) {
-    return CompleteInstanceLocal(device, cp, done);
-  } else {
-    CompleteInstanceCall* call = new CompleteInstanceCall(
-        cp->group, cp->instance, cp->name, device, cp->is_source, cancel_mgr,
-        group_leader_, worker_cache_);
-    CancellationToken abortion_token =
-        abortion_cancel_mgr_.get_cancellation_token();
-    bool already_aborted = !abortion_cancel_mgr_.RegisterCallback(
-        abortion_token, [call] { call->Cancel(); });
-    if (already_aborted) {
-      done(errors::Cancelled("collective ops already aborted"));
-      delete call;
-      return;
-    }
-    call->Start([this, device, cp, call, abortion_token, done](Status s) {
-      abortion_cancel_mgr_.DeregisterCallback(abortion_token);
-      if (s.ok()) {
-        s = UpdateInstanceCache(cp, call->resp_);
-      }
-      if (s.ok()) {
-        CompleteInstanceLocal(device, cp, done);
-      } else {
-        done(s);
+  }
+  const std::pair<int32, int32> key(cp->group.group_key,
+                                    cp->instance.instance_key);
+  const bool coalesce = cp->instance.type != BROADCAST_COLLECTIVE;
+  bool cached;
+  {
+    // The cache is checked under pending_mu_ so that a device cannot miss
+    // both the cache and a call that completes concurrently.
+    mutex_lock l(pending_mu_);
+    cached = InstanceIsCached(key.first, key.second);
+    if (!cached && coalesce) {
+      auto it = pending_instance_calls_.find(key);
+      if (it != pending_instance_calls_.end()) {
+        VLOG(2) << "CompleteInstanceDistributed " << device
+                << " waits for the pending call of instance " << key.second;
+        it->second.push_back([this, device, cp, done](const Status& s) {
+          if (s.ok()) {
+            CompleteInstanceLocal(device, cp, done);
+          } else {
+            done(s);
+          }
+        });
+        return;
       }
-      delete call;
-    });
+      pending_instance_calls_[key];
+    }
+  }
+  if (cached) {
+    return CompleteInstanceLocal(device, cp, done);
+  }
+  CompleteInstanceCall* call = new CompleteInstanceCall(
+      cp->group, cp->instance, cp->name, device, cp->is_source, cancel_mgr,
+      group_leader_, worker_cache_);
+  CancellationToken abortion_token =
+      abortion_cancel_mgr_.get_cancellation_token();
+  bool already_aborted = !abortion_cancel_mgr_.RegisterCallback(
+      abortion_token, [call] { call->Cancel(); });
+  if (already_aborted) {
+    Status s = errors::Cancelled("collective ops already aborted");
+    std::vector<StatusCallback> waiters;
+    if (coalesce) waiters = TakePendingInstanceWaiters(key);
+    done(s);
+    for (const StatusCallback& waiter : waiters) waiter(s);
+    delete call;
     return;
   }
+  call->Start([this, device, cp, call, abortion_token, key, coalesce,
+               done](Status s) {
+    abortion_cancel_mgr_.DeregisterCallback(abortion_token);
+    if (s.ok()) {
+      s = UpdateInstanceCache(cp, call->resp_);
+    }
+    // The cache is updated before the waiters are taken, so that devices
+    // arriving from now on find the instance in the cache.
+    std::vector<StatusCallback> waiters;
+    if (coalesce) waiters = TakePendingInstanceWaiters(key);
+    if (s.ok()) {
+      CompleteInstanceLocal(device, cp, done);
+    } else {
+      done(s);
+    }
+    for (const StatusCallback& waiter : waiters) waiter(s);
+    delete call;
+  });
 }
 
 void CollectiveParamResolverDistributed::StartAbort(const Status& s) {
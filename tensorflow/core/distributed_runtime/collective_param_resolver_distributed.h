@@ -15,6 +15,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COLLECTIVE_PARAM_RESOLVER_DISTRIBUTED_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COLLECTIVE_PARAM_RESOLVER_DISTRIBUTED_H_
 
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/collective_param_resolver_local.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
@@ -81,15 +85,30 @@ class CollectiveParamResolverDistributed : public CollectiveParamResolverLocal {
 
   // Finish populating *cp.  Semantics are like those of
   // CompleteInstanceLocal but will make a remote call to the group
-  // leader if necessary.
+  // leader if necessary.  Concurrent calls for the same instance from the
+  // devices of this task share a single remote call.
   void CompleteInstanceDistributed(const string& device, CollectiveParams* cp,
                                    CancellationManager* cancel_mgr,
                                    const StatusCallback& done)
-      TF_LOCKS_EXCLUDED(instance_mu_, group_mu_);
+      TF_LOCKS_EXCLUDED(instance_mu_, group_mu_, pending_mu_);
+
+  // Removes the in-flight CompleteInstance call for `key` and returns the
+  // callbacks of the devices waiting for it.
+  std::vector<StatusCallback> TakePendingInstanceWaiters(
+      const std::pair<int32, int32>& key) TF_LOCKS_EXCLUDED(pending_mu_);
 
   WorkerCacheInterface* worker_cache_;  // Not owned
   const string group_leader_;
   CancellationManager abortion_cancel_mgr_;
+
+  // CompleteInstance calls to the group leader that are in flight, keyed by
+  // (group_key, instance_key), with the devices of this task that wait for
+  // the response instead of issuing their own call. Only collectives other
+  // than broadcast are coalesced, since the leader resolves the broadcast
+  // source by counting the calls of all members.
+  mutex pending_mu_;
+  absl::flat_hash_map<std::pair<int32, int32>, std::vector<StatusCallback>>
+      pending_instance_calls_ TF_GUARDED_BY(pending_mu_);
 };
 
 }  // namespace tensorflow
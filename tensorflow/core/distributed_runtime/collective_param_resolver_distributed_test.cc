@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/collective_param_resolver_distributed.h"
 
+#include <atomic>
+
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/test_collective_executor_mgr.h"
@@ -104,6 +106,25 @@ class FakeNcclCommunicator : public NcclCommunicatorInterface {
   void StartAbort(const Status& s) override {}
 };
 
+// Counts the CompleteInstance calls served by a worker.
+class CountingWorker : public Worker {
+ public:
+  explicit CountingWorker(WorkerEnv* env) : Worker(env) {}
+
+  void CompleteInstanceAsync(CallOptions* opts,
+                             const CompleteInstanceRequest* request,
+                             CompleteInstanceResponse* response,
+                             StatusCallback done) override {
+    ++num_instance_calls_;
+    Worker::CompleteInstanceAsync(opts, request, response, std::move(done));
+  }
+
+  int num_instance_calls() const { return num_instance_calls_; }
+
+ private:
+  std::atomic<int> num_instance_calls_{0};
+};
+
 class DeviceResDistTest : public ::testing::Test {
  public:
   ~DeviceResDistTest() override {
@@ -155,7 +176,8 @@ class DeviceResDistTest : public ::testing::Test {
     worker_env->collective_executor_mgr =
         absl::make_unique<TestCollectiveExecutorMgr>(
             cp_resolvers_[worker_name].get(), /*rma=*/nullptr);
-    workers_[worker_name] = absl::make_unique<Worker>(worker_env.get());
+    workers_[worker_name] =
+        absl::make_unique<CountingWorker>(worker_env.get());
     worker_envs_[worker_name] = std::move(worker_env);
     wc_.AddWorker(worker_name, workers_[worker_name].get());
   }
@@ -310,7 +332,7 @@ class DeviceResDistTest : public ::testing::Test {
       cp_resolvers_;
   absl::flat_hash_map<string, std::vector<string>> dev_by_task_;
   absl::flat_hash_map<string, std::unique_ptr<WorkerEnv>> worker_envs_;
-  absl::flat_hash_map<string, std::unique_ptr<Worker>> workers_;
+  absl::flat_hash_map<string, std::unique_ptr<CountingWorker>> workers_;
   // Below are keyed by device names;
   absl::flat_hash_map<string, CollectiveParams*> cp_;
   absl::flat_hash_map<string, Status> status_;
@@ -337,6 +359,31 @@ TEST_F(DeviceResDistTest, Workers2Devices2) {
   ValidateCollectiveParams(num_workers, num_devices);
 }
 
+TEST_F(DeviceResDistTest, CoalescesInstanceCalls) {
+  const int num_workers = 2;
+  const int num_devices = 4;
+  DefineWorkers(num_workers, num_devices, "CPU", /*nccl*/ false);
+  DefineCollectiveParams(num_workers, num_devices, "CPU");
+  IssueRequests(num_workers, num_devices);
+  ValidateCollectiveParams(num_workers, num_devices);
+  // The devices of task 1 resolve the instance with a single call to the
+  // leader.
+  EXPECT_EQ(workers_["/job:worker/replica:0/task:0"]->num_instance_calls(), 1);
+}
+
+TEST_F(DeviceResDistTest, DoesNotCoalesceBroadcastCalls) {
+  const int num_workers = 2;
+  const int num_devices = 2;
+  const int source_rank = 2;
+  DefineWorkers(num_workers, num_devices, "CPU", /*nccl*/ false);
+  DefineCollectiveParams(num_workers, num_devices, "CPU", BROADCAST_COLLECTIVE,
+                         source_rank);
+  IssueRequests(num_workers, num_devices);
+  ValidateCollectiveParams(num_workers, num_devices);
+  EXPECT_EQ(workers_["/job:worker/replica:0/task:0"]->num_instance_calls(),
+            num_devices);
+}
+
 TEST_F(DeviceResDistTest, DifferentIncarnation) {
   const int num_workers = 2;
   const int num_devices = 1;
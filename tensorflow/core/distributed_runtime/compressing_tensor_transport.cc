@@ -0,0 +1,332 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/compressing_tensor_transport.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/snappy.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+#include "zlib.h"  // NOLINT(build/include_subdir)
+
+namespace tensorflow {
+namespace {
+
+auto* compressed_tensor_bytes = monitoring::Counter<0>::New(
+    "/tensorflow/core/rpc/compressed_tensor_bytes",
+    "The number of content bytes of the tensors sent compressed by "
+    "RecvTensor calls.");
+
+auto* compressed_tensor_wire_bytes = monitoring::Counter<0>::New(
+    "/tensorflow/core/rpc/compressed_tensor_wire_bytes",
+    "The number of bytes that the compressed content of the tensors of "
+    "RecvTensor calls took in their responses.");
+
+// The approximate number of cycles that compressing or decompressing a byte
+// takes.
+constexpr int64_t kCyclesPerByte = 10;
+
+// A tensor is sent compressed only if its first chunk shrinks below this
+// fraction of its size.
+constexpr double kMaxCompressionRatio = 0.875;
+
+}  // namespace
+
+Status CompressingTensorTransport::Create(
+    const RPCOptions::TensorCompression& options, thread::ThreadPool* pool,
+    std::unique_ptr<TensorTransport> base,
+    std::unique_ptr<CompressingTensorTransport>* transport) {
+  Algorithm algorithm;
+  if (options.algorithm() == "zlib") {
+    algorithm = Algorithm::kZlib;
+    if (options.level() < 0 || options.level() > 9) {
+      return errors::InvalidArgument("Invalid zlib tensor compression level ",
+                                     options.level());
+    }
+  } else if (options.algorithm() == "snappy") {
+    algorithm = Algorithm::kSnappy;
+    string unused;
+    if (!port::Snappy_Compress("", 0, &unused)) {
+      return errors::Unimplemented(
+          "Snappy tensor compression is not available in this build");
+    }
+  } else {
+    return errors::InvalidArgument("Unknown tensor compression algorithm \"",
+                                   options.algorithm(), "\"");
+  }
+  transport->reset(new CompressingTensorTransport(algorithm, options, pool,
+                                                  std::move(base)));
+  return Status::OK();
+}
+
+CompressingTensorTransport::CompressingTensorTransport(
+    Algorithm algorithm, const RPCOptions::TensorCompression& options,
+    thread::ThreadPool* pool, std::unique_ptr<TensorTransport> base)
+    : algorithm_(algorithm),
+      algorithm_name_(options.algorithm()),
+      level_(options.level() == 0 ? Z_DEFAULT_COMPRESSION : options.level()),
+      min_bytes_(options.min_bytes() == 0 ? kDefaultMinBytes
+                                          : options.min_bytes()),
+      bfloat16_edges_(options.bfloat16_edges().begin(),
+                      options.bfloat16_edges().end()),
+      pool_(pool),
+      base_(std::move(base)) {}
+
+bool CompressingTensorTransport::Compress(StringPiece input,
+                                          string* output) const {
+  switch (algorithm_) {
+    case Algorithm::kZlib: {
+      uLongf output_size = compressBound(input.size());
+      output->resize(output_size);
+      if (compress2(reinterpret_cast<Bytef*>(&(*output)[0]), &output_size,
+                    reinterpret_cast<const Bytef*>(input.data()), input.size(),
+                    level_) != Z_OK) {
+        return false;
+      }
+      output->resize(output_size);
+      return true;
+    }
+    case Algorithm::kSnappy:
+      return port::Snappy_Compress(input.data(), input.size(), output);
+  }
+  return false;
+}
+
+bool CompressingTensorTransport::Uncompress(StringPiece input, char* output,
+                                            size_t size) const {
+  switch (algorithm_) {
+    case Algorithm::kZlib: {
+      uLongf output_size = size;
+      return uncompress(reinterpret_cast<Bytef*>(output), &output_size,
+                        reinterpret_cast<const Bytef*>(input.data()),
+                        input.size()) == Z_OK &&
+             output_size == size;
+    }
+    case Algorithm::kSnappy: {
+      size_t output_size;
+      return port::Snappy_GetUncompressedLength(input.data(), input.size(),
+                                                &output_size) &&
+             output_size == size &&
+             port::Snappy_Uncompress(input.data(), input.size(), output);
+    }
+  }
+  return false;
+}
+
+void CompressingTensorTransport::ForEachChunk(
+    int64_t num_chunks, const std::function<void(int64_t)>& fn) const {
+  if (pool_ == nullptr || num_chunks <= 1) {
+    for (int64_t i = 0; i < num_chunks; ++i) fn(i);
+    return;
+  }
+  pool_->ParallelFor(num_chunks, kChunkBytes * kCyclesPerByte,
+                     [&fn](int64_t begin, int64_t end) {
+                       for (int64_t i = begin; i < end; ++i) fn(i);
+                     });
+}
+
+bool CompressingTensorTransport::PrepareRecv(
+    const string& src_worker, StringPiece rendezvous_key,
+    const Device* dst_device, const AllocatorAttributes& alloc_attrs,
+    ::google::protobuf::Any* options) {
+  if (!alloc_attrs.on_host() && dst_device->device_type() != DEVICE_CPU) {
+    return false;
+  }
+  TensorCompressionRecvOptions recv_options;
+  recv_options.set_algorithm(algorithm_name_);
+  for (const string& edge : bfloat16_edges_) {
+    if (absl::StrContains(rendezvous_key, edge)) {
+      recv_options.set_allow_bfloat16(true);
+      break;
+    }
+  }
+  if (base_ != nullptr &&
+      !base_->PrepareRecv(src_worker, rendezvous_key, dst_device, alloc_attrs,
+                          recv_options.mutable_base_options())) {
+    recv_options.clear_base_options();
+  }
+  options->PackFrom(recv_options);
+  return true;
+}
+
+bool CompressingTensorTransport::Send(
+    const ::google::protobuf::Any& request_options, const Tensor& val,
+    ::google::protobuf::Any* response_options) {
+  TensorCompressionRecvOptions recv_options;
+  if (!request_options.UnpackTo(&recv_options)) return false;
+  if (base_ != nullptr && recv_options.has_base_options() &&
+      base_->Send(recv_options.base_options(), val, response_options)) {
+    return true;
+  }
+  if (recv_options.algorithm() != algorithm_name_ ||
+      !DataTypeCanUseMemcpy(val.dtype()) || val.NumElements() == 0 ||
+      val.TotalBytes() < min_bytes_) {
+    return false;
+  }
+
+  Tensor wire = val;
+  if (recv_options.allow_bfloat16() && val.dtype() == DT_FLOAT) {
+    wire = Tensor(DT_BFLOAT16, val.shape());
+    RoundFloatToBFloat16(val.flat<float>().data(),
+                         wire.flat<bfloat16>().data(), val.NumElements());
+  }
+  const StringPiece content = wire.tensor_data();
+  const int64_t num_chunks = (content.size() + kChunkBytes - 1) / kChunkBytes;
+
+  CompressedTensor compressed;
+  compressed.set_dtype(val.dtype());
+  val.shape().AsProto(compressed.mutable_shape());
+  if (wire.dtype() != val.dtype()) compressed.set_wire_dtype(wire.dtype());
+  compressed.set_algorithm(algorithm_name_);
+  compressed.set_chunk_bytes(kChunkBytes);
+  for (int64_t i = 0; i < num_chunks; ++i) compressed.add_chunks();
+  auto compress_chunk = [this, &content, &compressed](int64_t i) {
+    const StringPiece input = content.substr(i * kChunkBytes, kChunkBytes);
+    CompressedTensor::Chunk* chunk = compressed.mutable_chunks(i);
+    if (Compress(input, chunk->mutable_data()) &&
+        chunk->data().size() < input.size()) {
+      chunk->set_compressed(true);
+    } else {
+      chunk->set_data(input.data(), input.size());
+    }
+  };
+
+  // Lossless compression is only worth its time on content that compresses,
+  // which the first chunk tells cheaply.
+  compress_chunk(0);
+  const int64_t first_chunk_bytes =
+      std::min<int64_t>(content.size(), kChunkBytes);
+  if (wire.dtype() == val.dtype() &&
+      compressed.chunks(0).data().size() >
+          kMaxCompressionRatio * first_chunk_bytes) {
+    return false;
+  }
+  ForEachChunk(num_chunks - 1,
+               [&compress_chunk](int64_t i) { compress_chunk(i + 1); });
+
+  int64_t wire_bytes = 0;
+  for (const CompressedTensor::Chunk& chunk : compressed.chunks()) {
+    wire_bytes += chunk.data().size();
+  }
+  compressed_tensor_bytes->GetCell()->IncrementBy(val.TotalBytes());
+  compressed_tensor_wire_bytes->GetCell()->IncrementBy(wire_bytes);
+  response_options->PackFrom(compressed);
+  return true;
+}
+
+void CompressingTensorTransport::RecvAsync(
+    const ::google::protobuf::Any& response_options,
+    WorkerInterface* src_worker, Device* dst_device,
+    const AllocatorAttributes& alloc_attrs, Tensor* val, StatusCallback done) {
+  if (!response_options.Is<CompressedTensor>() && base_ != nullptr) {
+    base_->RecvAsync(response_options, src_worker, dst_device, alloc_attrs,
+                     val, std::move(done));
+    return;
+  }
+  CompressedTensor compressed;
+  if (!response_options.UnpackTo(&compressed)) {
+    done(errors::Internal("Invalid compressed tensor: ",
+                          response_options.DebugString()));
+    return;
+  }
+  TensorShape shape;
+  Status s = TensorShape::BuildTensorShape(compressed.shape(), &shape);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+  const DataType dtype = compressed.dtype();
+  const DataType wire_dtype = compressed.wire_dtype() == DT_INVALID
+                                  ? dtype
+                                  : compressed.wire_dtype();
+  if (!DataTypeCanUseMemcpy(dtype) ||
+      (wire_dtype != dtype &&
+       !(dtype == DT_FLOAT && wire_dtype == DT_BFLOAT16))) {
+    done(errors::Internal("Unexpected compressed tensor of type ",
+                          DataTypeString(dtype), " sent as ",
+                          DataTypeString(wire_dtype)));
+    return;
+  }
+  const int64_t wire_size = shape.num_elements() * DataTypeSize(wire_dtype);
+  const int64_t chunk_bytes = compressed.chunk_bytes();
+  if (compressed.algorithm() != algorithm_name_ || chunk_bytes <= 0 ||
+      compressed.chunks_size() != (wire_size + chunk_bytes - 1) / chunk_bytes) {
+    done(errors::Internal("Unexpected ", compressed.chunks_size(),
+                          " chunks of ", chunk_bytes,
+                          " bytes compressed with \"", compressed.algorithm(),
+                          "\" for a tensor of ", wire_size, " bytes"));
+    return;
+  }
+
+  Allocator* allocator = dst_device->GetAllocator(alloc_attrs);
+  Tensor wire = wire_dtype == dtype ? Tensor(allocator, dtype, shape)
+                                    : Tensor(wire_dtype, shape);
+  char* output = const_cast<char*>(wire.tensor_data().data());
+  mutex mu;
+  Status status;
+  ForEachChunk(compressed.chunks_size(), [&](int64_t i) {
+    const CompressedTensor::Chunk& chunk = compressed.chunks(i);
+    const int64_t offset = i * chunk_bytes;
+    const int64_t size = std::min(chunk_bytes, wire_size - offset);
+    bool ok;
+    if (chunk.compressed()) {
+      ok = Uncompress(chunk.data(), output + offset, size);
+    } else {
+      ok = chunk.data().size() == size;
+      if (ok) std::memcpy(output + offset, chunk.data().data(), size);
+    }
+    if (!ok) {
+      mutex_lock l(mu);
+      status.Update(
+          errors::DataLoss("Could not decompress chunk ", i, " of a tensor"));
+    }
+  });
+  if (!status.ok()) {
+    done(status);
+    return;
+  }
+
+  if (wire_dtype == dtype) {
+    *val = std::move(wire);
+  } else {
+    Tensor decoded(allocator, dtype, shape);
+    BFloat16ToFloat(wire.flat<bfloat16>().data(), decoded.flat<float>().data(),
+                    shape.num_elements());
+    *val = std::move(decoded);
+  }
+  done(Status::OK());
+}
+
+void CompressingTensorTransport::RecvTensorChunkAsync(
+    const RecvTensorChunkRequest* request, RecvTensorChunkResponse* response,
+    StatusCallback done) {
+  if (base_ == nullptr) {
+    TensorTransport::RecvTensorChunkAsync(request, response, std::move(done));
+    return;
+  }
+  base_->RecvTensorChunkAsync(request, response, std::move(done));
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,101 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COMPRESSING_TENSOR_TRANSPORT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COMPRESSING_TENSOR_TRANSPORT_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+
+// A TensorTransport that compresses the content of the tensors of RecvTensor
+// calls, for workers whose network is slower than their compression. The
+// compressed content travels in RecvTensorResponse::transport_options.
+//
+// The content is cut into chunks, which `pool` compresses and decompresses
+// in parallel. Chunks that don't get smaller are sent as is, and a tensor
+// whose first chunk doesn't compress well, e.g. random weights, is encoded in
+// the response as usual. The float tensors of the edges that the receiver
+// lists in `bfloat16_edges` are rounded to bfloat16 first.
+//
+// A `base` transport, e.g. shared memory, is offered along with compression
+// and preferred by the sender when it accepts the tensor.
+class CompressingTensorTransport : public TensorTransport {
+ public:
+  static constexpr int64_t kDefaultMinBytes = 4 << 10;
+  static constexpr int64_t kChunkBytes = 256 << 10;
+
+  // `pool`, which is not owned and may be null, runs the (de)compression of
+  // the chunks. Fails if `options.algorithm` is unknown or not available in
+  // this build.
+  static Status Create(const RPCOptions::TensorCompression& options,
+                       thread::ThreadPool* pool,
+                       std::unique_ptr<TensorTransport> base,
+                       std::unique_ptr<CompressingTensorTransport>* transport);
+
+  bool PrepareRecv(const string& src_worker, StringPiece rendezvous_key,
+                   const Device* dst_device,
+                   const AllocatorAttributes& alloc_attrs,
+                   ::google::protobuf::Any* options) override;
+
+  bool Send(const ::google::protobuf::Any& request_options, const Tensor& val,
+            ::google::protobuf::Any* response_options) override;
+
+  void RecvAsync(const ::google::protobuf::Any& response_options,
+                 WorkerInterface* src_worker, Device* dst_device,
+                 const AllocatorAttributes& alloc_attrs, Tensor* val,
+                 StatusCallback done) override;
+
+  void RecvTensorChunkAsync(const RecvTensorChunkRequest* request,
+                            RecvTensorChunkResponse* response,
+                            StatusCallback done) override;
+
+ private:
+  enum class Algorithm { kZlib, kSnappy };
+
+  CompressingTensorTransport(Algorithm algorithm,
+                             const RPCOptions::TensorCompression& options,
+                             thread::ThreadPool* pool,
+                             std::unique_ptr<TensorTransport> base);
+
+  // Returns false if `input` could not be compressed.
+  bool Compress(StringPiece input, string* output) const;
+  // Returns false unless `input` decompresses to exactly `size` bytes.
+  bool Uncompress(StringPiece input, char* output, size_t size) const;
+
+  // Runs `fn(i)` for each of `num_chunks` chunks, in parallel in `pool_`.
+  void ForEachChunk(int64_t num_chunks,
+                    const std::function<void(int64_t)>& fn) const;
+
+  const Algorithm algorithm_;
+  const string algorithm_name_;
+  const int level_;
+  const int64_t min_bytes_;
+  const std::vector<string> bfloat16_edges_;
+  thread::ThreadPool* const pool_;  // Not owned.
+  const std::unique_ptr<TensorTransport> base_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CompressingTensorTransport);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_COMPRESSING_TENSOR_TRANSPORT_H_
@@ -0,0 +1,234 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/compressing_tensor_transport.h"
+
+#include <random>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/distributed_runtime/shared_memory_tensor_transport.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kKey[] =
+    "/job:worker/replica:0/task:1/device:CPU:0;0000000000000001;"
+    "/job:worker/replica:0/task:0/device:CPU:0;edge_3_dense/MatMul;0:0";
+
+class FakeDevice : public Device {
+ public:
+  FakeDevice() : Device(nullptr, MakeAttributes()) {}
+  Status Sync() override { return Status::OK(); }
+  Allocator* GetAllocator(AllocatorAttributes) override {
+    return cpu_allocator();
+  }
+
+ private:
+  static DeviceAttributes MakeAttributes() {
+    DeviceAttributes attr;
+    attr.set_name("/job:worker/replica:0/task:0/device:CPU:0");
+    attr.set_device_type(DEVICE_CPU);
+    return attr;
+  }
+};
+
+class CompressingTensorTransportTest : public ::testing::Test {
+ protected:
+  CompressingTensorTransportTest()
+      : pool_(Env::Default(), "compression", /*num_threads=*/4) {
+    options_.set_algorithm("zlib");
+  }
+
+  void CreateTransport(std::unique_ptr<TensorTransport> base = nullptr) {
+    TF_ASSERT_OK(CompressingTensorTransport::Create(options_, &pool_,
+                                                    std::move(base),
+                                                    &transport_));
+  }
+
+  // Runs the receiver and the sender sides of a RecvTensor call of `val`.
+  Status Transfer(const Tensor& val, Tensor* received, bool* transported,
+                  const string& key = kKey) {
+    ::google::protobuf::Any request_options;
+    if (!transport_->PrepareRecv("/job:worker/replica:0/task:1", key, &cpu_,
+                                 AllocatorAttributes(), &request_options)) {
+      return errors::FailedPrecondition("PrepareRecv() declined");
+    }
+    *transported = transport_->Send(request_options, val, &response_options_);
+    if (!*transported) return Status::OK();
+    Status status;
+    transport_->RecvAsync(response_options_, /*src_worker=*/nullptr, &cpu_,
+                          AllocatorAttributes(), received,
+                          [&status](const Status& s) { status = s; });
+    return status;
+  }
+
+  thread::ThreadPool pool_;
+  RPCOptions::TensorCompression options_;
+  std::unique_ptr<CompressingTensorTransport> transport_;
+  ::google::protobuf::Any response_options_;
+  FakeDevice cpu_;
+};
+
+// Returns a tensor of `n` floats of few distinct values, which compress well.
+Tensor CompressibleTensor(int64_t n) {
+  Tensor val(DT_FLOAT, TensorShape({n}));
+  auto flat = val.flat<float>();
+  for (int64_t i = 0; i < n; ++i) flat(i) = (i % 7 == 0) ? 0.5f * (i % 3) : 0;
+  return val;
+}
+
+TEST_F(CompressingTensorTransportTest, TransfersTensorInChunks) {
+  CreateTransport();
+  // Several chunks, the last of which is partial.
+  const Tensor val = CompressibleTensor(
+      5 * CompressingTensorTransport::kChunkBytes / sizeof(float) / 2 + 3);
+  Tensor received;
+  bool transported;
+  TF_ASSERT_OK(Transfer(val, &received, &transported));
+  ASSERT_TRUE(transported);
+  test::ExpectTensorEqual<float>(received, val);
+
+  CompressedTensor compressed;
+  ASSERT_TRUE(response_options_.UnpackTo(&compressed));
+  EXPECT_EQ(compressed.chunks_size(), 3);
+  EXPECT_EQ(compressed.wire_dtype(), DT_INVALID);
+  int64_t wire_bytes = 0;
+  for (const auto& chunk : compressed.chunks()) {
+    EXPECT_TRUE(chunk.compressed());
+    wire_bytes += chunk.data().size();
+  }
+  EXPECT_LT(wire_bytes, val.TotalBytes() / 4);
+}
+
+TEST_F(CompressingTensorTransportTest, IncompressibleTensorsUseResponse) {
+  CreateTransport();
+  Tensor val(DT_INT32, TensorShape({64 << 10}));
+  std::mt19937 random(0);
+  auto flat = val.flat<int32>();
+  for (int64_t i = 0; i < flat.size(); ++i) flat(i) = random();
+  Tensor received;
+  bool transported;
+  TF_ASSERT_OK(Transfer(val, &received, &transported));
+  EXPECT_FALSE(transported);
+}
+
+TEST_F(CompressingTensorTransportTest, SmallAndStringTensorsUseResponse) {
+  CreateTransport();
+  Tensor received;
+  bool transported;
+  TF_ASSERT_OK(Transfer(CompressibleTensor(16), &received, &transported));
+  EXPECT_FALSE(transported);
+  TF_ASSERT_OK(Transfer(Tensor(DT_STRING, TensorShape({10000})), &received,
+                        &transported));
+  EXPECT_FALSE(transported);
+}
+
+TEST_F(CompressingTensorTransportTest, RoundsEdgesToBFloat16) {
+  options_.add_bfloat16_edges("dense/MatMul");
+  CreateTransport();
+  Tensor val(DT_FLOAT, TensorShape({64 << 10}));
+  std::mt19937 random(0);
+  std::normal_distribution<float> normal;
+  auto flat = val.flat<float>();
+  for (int64_t i = 0; i < flat.size(); ++i) flat(i) = normal(random);
+
+  // Lossy, and sent even though random floats don't compress.
+  Tensor received;
+  bool transported;
+  TF_ASSERT_OK(Transfer(val, &received, &transported));
+  ASSERT_TRUE(transported);
+  EXPECT_EQ(received.dtype(), DT_FLOAT);
+  test::ExpectClose(received, val, /*atol=*/0.0, /*rtol=*/1.0 / 128);
+  CompressedTensor compressed;
+  ASSERT_TRUE(response_options_.UnpackTo(&compressed));
+  EXPECT_EQ(compressed.wire_dtype(), DT_BFLOAT16);
+
+  // Other edges are lossless.
+  const Tensor compressible = CompressibleTensor(64 << 10);
+  TF_ASSERT_OK(Transfer(compressible, &received, &transported,
+                        "/job:worker/replica:0/task:1/device:CPU:0;1;"
+                        "/job:worker/replica:0/task:0/device:CPU:0;"
+                        "edge_4_other;0:0"));
+  ASSERT_TRUE(transported);
+  test::ExpectTensorEqual<float>(received, compressible);
+}
+
+TEST_F(CompressingTensorTransportTest, RequiresSameAlgorithm) {
+  CreateTransport();
+  TensorCompressionRecvOptions recv_options;
+  recv_options.set_algorithm("snappy");
+  ::google::protobuf::Any request_options;
+  request_options.PackFrom(recv_options);
+  EXPECT_FALSE(transport_->Send(request_options, CompressibleTensor(64 << 10),
+                                &response_options_));
+}
+
+TEST_F(CompressingTensorTransportTest, DetectsCorruptChunks) {
+  CreateTransport();
+  Tensor received;
+  bool transported;
+  TF_ASSERT_OK(Transfer(CompressibleTensor(64 << 10), &received, &transported));
+  ASSERT_TRUE(transported);
+
+  CompressedTensor compressed;
+  ASSERT_TRUE(response_options_.UnpackTo(&compressed));
+  compressed.mutable_chunks(0)->mutable_data()->resize(10);
+  ::google::protobuf::Any corrupt;
+  corrupt.PackFrom(compressed);
+  Status status;
+  transport_->RecvAsync(corrupt, /*src_worker=*/nullptr, &cpu_,
+                        AllocatorAttributes(), &received,
+                        [&status](const Status& s) { status = s; });
+  EXPECT_TRUE(errors::IsDataLoss(status)) << status;
+}
+
+TEST_F(CompressingTensorTransportTest, PrefersBaseTransport) {
+  std::unique_ptr<TensorTransport> shared_memory =
+      SharedMemoryTensorTransport::Create();
+  if (shared_memory == nullptr) GTEST_SKIP() << "No POSIX shared memory";
+  CreateTransport(std::move(shared_memory));
+  const Tensor val = CompressibleTensor(64 << 10);
+  Tensor received;
+  bool transported;
+  TF_ASSERT_OK(Transfer(val, &received, &transported));
+  ASSERT_TRUE(transported);
+  EXPECT_TRUE(response_options_.Is<SharedMemoryTensorLocation>());
+  test::ExpectTensorEqual<float>(received, val);
+}
+
+TEST(CompressingTensorTransport, RejectsUnknownAlgorithms) {
+  RPCOptions::TensorCompression options;
+  options.set_algorithm("lz4");
+  std::unique_ptr<CompressingTensorTransport> transport;
+  EXPECT_TRUE(errors::IsInvalidArgument(CompressingTensorTransport::Create(
+      options, /*pool=*/nullptr, /*base=*/nullptr, &transport)));
+
+  options.set_algorithm("zlib");
+  options.set_level(10);
+  EXPECT_TRUE(errors::IsInvalidArgument(CompressingTensorTransport::Create(
+      options, /*pool=*/nullptr, /*base=*/nullptr, &transport)));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <iterator>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -46,6 +47,9 @@ namespace {
 
 constexpr int kDefaultHeartbeatTimeoutMs = 10 * 1000;  // 10 seconds
 constexpr char kHealthCheckThread[] = "CoordinationServiceHealthCheck";
+// Granularity of the heartbeat timer wheel, which is also the period of the
+// staleness check.
+constexpr int64_t kHeartbeatSlotUs = 1000 * 1000;  // 1 second
 
 std::string GetTaskName(const std::string& job_name, int task_id) {
   return strings::StrCat("/job:", job_name, "/replica:", 0, "/task:", task_id);
@@ -105,6 +109,13 @@ class CoordinationServiceStandaloneImpl : public CoordinationServiceInterface {
   void PropagateError(const std::string& job, int task_id, Status error)
       TF_LOCKS_EXCLUDED(state_mu_);
   void DoneClusterRegistration(Status s) TF_EXCLUSIVE_LOCKS_REQUIRED(state_mu_);
+  // Schedules the staleness check of `task_name` in `slot`, if not -1.
+  void ScheduleStalenessCheck(const std::string& task_name, int64_t slot)
+      TF_LOCKS_EXCLUDED(heartbeat_wheel_mu_);
+  // Sets the error of the connected tasks whose last heartbeat was in a slot
+  // of the wheel that has expired, and returns their names.
+  std::vector<std::string> CheckStaleness()
+      TF_LOCKS_EXCLUDED(state_mu_, heartbeat_wheel_mu_);
 
   class TaskState {
    public:
@@ -128,11 +139,14 @@ class CoordinationServiceStandaloneImpl : public CoordinationServiceInterface {
 
     State GetState() { return state_; }
     Status GetStatus() { return status_; }
-    void SetConnected(uint64 task_incarnation);
+    // The methods that record a heartbeat return the slot of the heartbeat
+    // timer wheel in which the task must be checked for staleness, or -1 if
+    // the task is already scheduled in that slot.
+    int64_t SetConnected(uint64 task_incarnation);
     void SetRegisteredCallback(StatusCallback cb);
-    Status RecordHeartbeat(uint64 task_incarnation);
+    Status RecordHeartbeat(uint64 task_incarnation, int64_t* slot);
     int64 TimeSinceLastHeartbeatMs();
-    void InvokeRegisteredCallback(Status s);
+    int64_t InvokeRegisteredCallback(Status s);
     void SetError(Status status);
 
    private:
@@ -145,8 +159,12 @@ class CoordinationServiceStandaloneImpl : public CoordinationServiceInterface {
 
     State state_ = State::DISCONNECTED;
     Status status_;
+    int64_t UpdateLastHeartbeat();
+
     mutex last_heartbeat_mu_;
     int64 last_heartbeat_us_ TF_GUARDED_BY(last_heartbeat_mu_);
+    // Latest slot of the heartbeat timer wheel that holds this task.
+    int64_t heartbeat_slot_ TF_GUARDED_BY(last_heartbeat_mu_) = -1;
   };
 
   std::unique_ptr<CoordinationClientCache> client_cache_;
@@ -166,6 +184,15 @@ class CoordinationServiceStandaloneImpl : public CoordinationServiceInterface {
   absl::flat_hash_map<std::string, std::vector<StatusOrValueCallback>> get_cb_
       TF_GUARDED_BY(kv_mu_);
 
+  // Heartbeat timer wheel: the names of the tasks that sent a heartbeat in
+  // each slot of kHeartbeatSlotUs that is not older than the heartbeat
+  // timeout. The staleness check only visits the tasks of the slots that
+  // expire, rather than scanning the whole cluster, and a task whose later
+  // heartbeat moved it to a newer slot is skipped.
+  mutex heartbeat_wheel_mu_;
+  std::map<int64_t, std::vector<std::string>> heartbeat_wheel_
+      TF_GUARDED_BY(heartbeat_wheel_mu_);
+
   mutex check_staleness_thread_shutdown_mu_;
   condition_variable check_staleness_thread_cv_;
   bool shutting_down_ TF_GUARDED_BY(check_staleness_thread_shutdown_mu_) =
@@ -175,13 +202,21 @@ class CoordinationServiceStandaloneImpl : public CoordinationServiceInterface {
   TF_DISALLOW_COPY_AND_ASSIGN(CoordinationServiceStandaloneImpl);
 };
 
-void CoordinationServiceStandaloneImpl::TaskState::SetConnected(
+int64_t CoordinationServiceStandaloneImpl::TaskState::UpdateLastHeartbeat() {
+  mutex_lock l(last_heartbeat_mu_);
+  last_heartbeat_us_ = Env::Default()->NowMicros();
+  const int64_t slot = last_heartbeat_us_ / kHeartbeatSlotUs;
+  if (slot == heartbeat_slot_) return -1;
+  heartbeat_slot_ = slot;
+  return slot;
+}
+
+int64_t CoordinationServiceStandaloneImpl::TaskState::SetConnected(
     uint64 task_incarnation) {
   state_ = State::CONNECTED;
   status_ = Status::OK();
   task_incarnation_ = task_incarnation;
-  mutex_lock l(last_heartbeat_mu_);
-  last_heartbeat_us_ = Env::Default()->NowMicros();
+  return UpdateLastHeartbeat();
 }
 
 void CoordinationServiceStandaloneImpl::TaskState::SetRegisteredCallback(
@@ -198,15 +233,15 @@ void CoordinationServiceStandaloneImpl::TaskState::SetError(
 }
 
 Status CoordinationServiceStandaloneImpl::TaskState::RecordHeartbeat(
-    uint64 task_incarnation) {
+    uint64 task_incarnation, int64_t* slot) {
+  *slot = -1;
   if (!status_.ok()) return status_;
   if (task_incarnation != task_incarnation_) {
     return errors::Aborted("Incarnation ID mismatch: expecting ",
                            task_incarnation_, " but got ", task_incarnation,
                            ". This means the remote task has restarted.");
   }
-  mutex_lock l(last_heartbeat_mu_);
-  last_heartbeat_us_ = Env::Default()->NowMicros();
+  *slot = UpdateLastHeartbeat();
   return Status::OK();
 }
 
@@ -215,13 +250,13 @@ int64 CoordinationServiceStandaloneImpl::TaskState::TimeSinceLastHeartbeatMs() {
   return (Env::Default()->NowMicros() - last_heartbeat_us_) / 1000;
 }
 
-void CoordinationServiceStandaloneImpl::TaskState::InvokeRegisteredCallback(
+int64_t CoordinationServiceStandaloneImpl::TaskState::InvokeRegisteredCallback(
     Status s) {
   if (!is_callback_invoked_.exchange(true, std::memory_order_acq_rel)) {
     registered_callback_(s);
-    mutex_lock l(last_heartbeat_mu_);
-    last_heartbeat_us_ = Env::Default()->NowMicros();
+    return UpdateLastHeartbeat();
   }
+  return -1;
 }
 
 CoordinationServiceStandaloneImpl::CoordinationServiceStandaloneImpl(
@@ -265,43 +300,77 @@ void CoordinationServiceStandaloneImpl::StartCheckStaleness() {
         while (true) {
           {
             mutex_lock l(check_staleness_thread_shutdown_mu_);
-            check_staleness_thread_cv_.wait_for(l, std::chrono::seconds(1));
+            check_staleness_thread_cv_.wait_for(
+                l, std::chrono::microseconds(kHeartbeatSlotUs));
             if (shutting_down_) {
               return;
             }
           }
-          Status status = Status::OK();
-          {
-            mutex_lock l(state_mu_);
-            for (const auto& worker_state : cluster_state_) {
-              // Skip workers that are not registered or in error state
-              if (worker_state.second->GetState() !=
-                  TaskState::State::CONNECTED) {
-                continue;
-              }
-              const bool is_stale =
-                  worker_state.second->TimeSinceLastHeartbeatMs() >
-                  heartbeat_timeout_ms_;
-              VLOG(1) << "Checking staleness for " << worker_state.first
-                      << " stale?=" << is_stale;
-              if (is_stale) {
-                status = errors::Unavailable(
-                    "Task ", worker_state.first,
+          for (const std::string& task_name : CheckStaleness()) {
+            DeviceNameUtils::ParseFullName(task_name, &parsed);
+            PropagateError(
+                parsed.job, parsed.task,
+                errors::Unavailable(
+                    "Task ", task_name,
                     " heartbeat timeout. This indicates that the remote task "
-                    "has failed, got preempted, or crashed unexpectedly.");
-                worker_state.second->SetError(status);
-                DeviceNameUtils::ParseFullName(worker_state.first, &parsed);
-                break;
-              }
-            }
-          }
-          if (!status.ok()) {
-            PropagateError(parsed.job, parsed.task, status);
+                    "has failed, got preempted, or crashed unexpectedly."));
           }
         }
       }));
 }
 
+void CoordinationServiceStandaloneImpl::ScheduleStalenessCheck(
+    const std::string& task_name, int64_t slot) {
+  if (slot < 0) return;
+  mutex_lock l(heartbeat_wheel_mu_);
+  heartbeat_wheel_[slot].push_back(task_name);
+}
+
+std::vector<std::string> CoordinationServiceStandaloneImpl::CheckStaleness() {
+  // A slot expires once all the heartbeats it may hold are older than the
+  // timeout.
+  const int64_t now_us = Env::Default()->NowMicros();
+  std::vector<std::string> candidates;
+  {
+    mutex_lock l(heartbeat_wheel_mu_);
+    auto it = heartbeat_wheel_.begin();
+    for (; it != heartbeat_wheel_.end(); ++it) {
+      if ((it->first + 1) * kHeartbeatSlotUs +
+              static_cast<int64_t>(heartbeat_timeout_ms_) * 1000 >
+          now_us) {
+        break;
+      }
+      candidates.insert(candidates.end(),
+                        std::make_move_iterator(it->second.begin()),
+                        std::make_move_iterator(it->second.end()));
+    }
+    heartbeat_wheel_.erase(heartbeat_wheel_.begin(), it);
+  }
+  std::vector<std::string> stale_tasks;
+  if (candidates.empty()) return stale_tasks;
+  mutex_lock l(state_mu_);
+  for (const std::string& task_name : candidates) {
+    auto state_it = cluster_state_.find(task_name);
+    // Skip workers that are not registered or in error state
+    if (state_it == cluster_state_.end() ||
+        state_it->second->GetState() != TaskState::State::CONNECTED) {
+      continue;
+    }
+    const bool is_stale =
+        state_it->second->TimeSinceLastHeartbeatMs() > heartbeat_timeout_ms_;
+    VLOG(1) << "Checking staleness for " << task_name
+            << " stale?=" << is_stale;
+    if (is_stale) {
+      state_it->second->SetError(errors::Unavailable(
+          "Task ", task_name,
+          " heartbeat timeout. This indicates that the remote task "
+          "has failed, got preempted, or crashed unexpectedly."));
+      stale_tasks.push_back(task_name);
+    }
+  }
+  return stale_tasks;
+}
+
 void CoordinationServiceStandaloneImpl::Stop() {
   {
     mutex_lock l(kv_mu_);
@@ -326,6 +395,7 @@ void CoordinationServiceStandaloneImpl::RegisterWorker(
   const std::string& task_name = GetTaskName(job_name, task_id);
 
   Status status;
+  int64_t slot = -1;
   {
     mutex_lock l(state_mu_);
     if (!cluster_state_.contains(task_name)) {
@@ -345,9 +415,10 @@ void CoordinationServiceStandaloneImpl::RegisterWorker(
       // Hit this path when the task is registering itself for the first time,
       // or it's already in ERROR state and now register again. In both cases,
       // the service allows it to be registered.
-      cluster_state_[task_name]->SetConnected(incarnation);
+      slot = cluster_state_[task_name]->SetConnected(incarnation);
     }
   }
+  ScheduleStalenessCheck(task_name, slot);
   if (!status.ok()) PropagateError(job_name, task_id, status);
   done(status);
 }
@@ -381,7 +452,8 @@ CoordinationServiceStandaloneImpl::ListClusterDevices() {
 void CoordinationServiceStandaloneImpl::DoneClusterRegistration(Status s) {
   for (const auto& task_state : cluster_state_) {
     if (task_state.second != nullptr) {
-      task_state.second->InvokeRegisteredCallback(s);
+      ScheduleStalenessCheck(task_state.first,
+                             task_state.second->InvokeRegisteredCallback(s));
     }
   }
   cluster_registered_cv_.notify_all();
@@ -411,22 +483,27 @@ Status CoordinationServiceStandaloneImpl::RecordHeartbeat(
     const std::string& job_name, int task_id, uint64 incarnation) {
   const std::string& task_name = GetTaskName(job_name, task_id);
   Status s = Status::OK();
+  int64_t slot;
   {
-    mutex_lock l(state_mu_);
-    if (!cluster_state_.contains(task_name)) {
+    // Heartbeats only read the task states, and only update their heartbeat
+    // time, which has its own lock, so that they don't serialize on
+    // `state_mu_`.
+    tf_shared_lock l(state_mu_);
+    auto it = cluster_state_.find(task_name);
+    if (it == cluster_state_.end()) {
       return errors::InvalidArgument(
           "Unexpected worker heartbeat with job_name=", job_name,
           ", task_id=", task_id);
-    } else if (!cluster_state_[task_name]->GetStatus().ok()) {
-      return cluster_state_[task_name]->GetStatus();
-    } else if (cluster_state_[task_name]->GetState() ==
-               TaskState::State::DISCONNECTED) {
+    } else if (!it->second->GetStatus().ok()) {
+      return it->second->GetStatus();
+    } else if (it->second->GetState() == TaskState::State::DISCONNECTED) {
       return errors::InvalidArgument(
           "Task with job_name=", job_name, ", task_id=", task_id,
           " must be registered before sending heartbeat messages");
     }
-    s = cluster_state_[task_name]->RecordHeartbeat(incarnation);
+    s = it->second->RecordHeartbeat(incarnation, &slot);
   }
+  ScheduleStalenessCheck(task_name, slot);
   if (!s.ok()) {
     PropagateError(job_name, task_id, s);
   }
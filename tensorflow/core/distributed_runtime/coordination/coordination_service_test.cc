@@ -305,6 +305,51 @@ TEST_F(CoordinationServiceTest, TestWorkerHeartbeatTimeout) {
       coord_service->RecordHeartbeat("worker", 1, w1_incarnation)));
 }
 
+TEST_F(CoordinationServiceTest, TestHeartbeatKeepsWorkerAlive) {
+  ServerDef server_def = GetMultiClientServerDef("worker", 2);
+  const uint64 w0_incarnation = random::New64();
+  const uint64 w1_incarnation = random::New64();
+
+  auto client_cache = std::make_unique<TestCoordinationClientCache>();
+  TestCoordinationClient wi0;
+  client_cache->AddWorker("/job:worker/replica:0/task:0", &wi0);
+  TestCoordinationClient wi1;
+  client_cache->AddWorker("/job:worker/replica:0/task:1", &wi1);
+
+  auto coord_config = server_def.mutable_default_session_config()
+                          ->mutable_experimental()
+                          ->mutable_coordination_config();
+  coord_config->set_service_type(kCoordinationServiceType);
+  coord_config->set_heartbeat_timeout_in_ms(kHeartbeatTimeoutMs);
+  std::unique_ptr<CoordinationServiceInterface> coord_service =
+      CoordinationServiceInterface::EnableCoordinationService(
+          kCoordinationServiceType, &worker_env_, server_def,
+          std::move(client_cache));
+
+  absl::Notification register0;
+  coord_service->RegisterWorker("worker", 0, w0_incarnation, [&](Status s) {
+    TF_ASSERT_OK(s);
+    register0.Notify();
+  });
+  register0.WaitForNotification();
+  absl::Notification register1;
+  coord_service->RegisterWorker("worker", 1, w1_incarnation, [&](Status s) {
+    TF_ASSERT_OK(s);
+    register1.Notify();
+  });
+  register1.WaitForNotification();
+
+  // Only worker 0 sends heartbeats, over more than two timeouts.
+  for (int i = 0; i < 8; ++i) {
+    Env::Default()->SleepForMicroseconds(kHeartbeatTimeoutMs * 1000 / 4);
+    TF_EXPECT_OK(coord_service->RecordHeartbeat("worker", 0, w0_incarnation));
+  }
+  EXPECT_TRUE(errors::IsUnavailable(
+      coord_service->RecordHeartbeat("worker", 1, w1_incarnation)));
+  // The timeout of worker 1 is propagated to worker 0.
+  EXPECT_TRUE(errors::IsUnavailable(wi0.GetStatus())) << wi0.GetStatus();
+}
+
 TEST_F(CoordinationServiceTest, TestWorkerRestart) {
   const ServerDef& server_def = GetMultiClientServerDef("worker", 2);
   const uint64 w0_incarnation = random::New64();
@@ -43,8 +43,10 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/graph/validate.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/tracing.h"
@@ -294,6 +296,35 @@ Status GraphMgr::InitItem(const string& handle, const GraphDef& gdef,
   return Status::OK();
 }
 
+// Returns the key of a graph registration in the item cache, or an empty
+// string if the registration must not share its item with others.
+static string ItemCacheKey(const string& handle, const GraphDef& gdef,
+                           const GraphOptions& graph_options,
+                           const DebugOptions& debug_options,
+                           const ConfigProto& config_proto,
+                           int64_t collective_graph_key) {
+  // tfdbg decorates and publishes the graph of every registration.
+  if (!debug_options.debug_tensor_watch_opts().empty()) return "";
+  string serialized;
+  for (const protobuf::MessageLite* msg :
+       std::vector<const protobuf::MessageLite*>{&gdef, &graph_options,
+                                                 &config_proto}) {
+    string buf;
+    if (!SerializeToStringDeterministic(*msg, &buf)) return "";
+    strings::StrAppend(&serialized, buf.size(), ":", buf);
+  }
+  const Fprint128 fp = Fingerprint128(serialized);
+  return strings::StrCat(handle, "/", collective_graph_key, "/",
+                         strings::FpToString(fp.low64),
+                         strings::FpToString(fp.high64));
+}
+
+void GraphMgr::ReleaseHandle(Item* item) {
+  if (--item->num_handles == 0 && !item->cache_key.empty()) {
+    item_cache_.erase(item->cache_key);
+  }
+}
+
 Status GraphMgr::Register(const string& handle, const GraphDef& gdef,
                           const GraphOptions& graph_options,
                           const DebugOptions& debug_options,
@@ -301,6 +332,25 @@ Status GraphMgr::Register(const string& handle, const GraphDef& gdef,
                           int64_t collective_graph_key, WorkerSession* session,
                           DistributedFunctionLibraryRuntime* cluster_flr,
                           string* graph_handle) {
+  const string cache_key =
+      ItemCacheKey(handle, gdef, graph_options, debug_options, config_proto,
+                   collective_graph_key);
+  if (!cache_key.empty()) {
+    mutex_lock l(mu_);
+    auto iter = item_cache_.find(cache_key);
+    if (iter != item_cache_.end()) {
+      Item* item = iter->second;
+      item->Ref();
+      ++item->num_handles;
+      *graph_handle =
+          strings::Printf("%016llx", static_cast<long long>(++next_id_));
+      CHECK(table_.insert({*graph_handle, item}).second);
+      VLOG(1) << "Graph " << *graph_handle << " reuses the executors of graph "
+              << item->handle;
+      return Status::OK();
+    }
+  }
+
   Item* item = new Item;
   Status s = InitItem(handle, gdef, graph_options, debug_options, config_proto,
                       collective_graph_key, session, cluster_flr, item);
@@ -315,7 +365,13 @@ Status GraphMgr::Register(const string& handle, const GraphDef& gdef,
     *graph_handle =
         strings::Printf("%016llx", static_cast<long long>(++next_id_));
     item->handle = *graph_handle;
+    item->num_handles = 1;
     CHECK(table_.insert({*graph_handle, item}).second);
+    // A concurrent registration of the same graph may have been cached
+    // first, in which case this item stays private to its handle.
+    if (!cache_key.empty() && item_cache_.emplace(cache_key, item).second) {
+      item->cache_key = cache_key;
+    }
   }
   return Status::OK();
 }
@@ -332,6 +388,7 @@ Status GraphMgr::Deregister(const string& handle) {
     }
     item = iter->second;
     table_.erase(iter);
+    ReleaseHandle(item);
   }
   item->Unref();
   return Status::OK();
@@ -344,6 +401,7 @@ Status GraphMgr::DeregisterAll() {
     mutex_lock l(mu_);
     for (const auto& entry : table_) {
       items.push_back(entry.second);
+      ReleaseHandle(entry.second);
     }
     table_.clear();
   }
@@ -353,6 +411,15 @@ Status GraphMgr::DeregisterAll() {
   return Status::OK();
 }
 
+bool GraphMgr::SharesExecutorsForTest(const string& handle_a,
+                                      const string& handle_b) {
+  mutex_lock l(mu_);
+  auto iter_a = table_.find(handle_a);
+  auto iter_b = table_.find(handle_b);
+  return iter_a != table_.end() && iter_b != table_.end() &&
+         iter_a->second == iter_b->second;
+}
+
 Status GraphMgr::SendInputs(const int64_t step_id, const NamedTensors& in) {
   Rendezvous* rendezvous = worker_env_->rendezvous_mgr->Find(step_id);
   std::vector<string> keys;
@@ -108,6 +108,10 @@ class GraphMgr {
   // Deregister all graphs.
   Status DeregisterAll();
 
+  // Returns true if "handle_a" and "handle_b" are registered and share their
+  // executors. For testing only.
+  bool SharesExecutorsForTest(const string& handle_a, const string& handle_b);
+
  private:
   typedef GraphMgr ME;
 
@@ -145,6 +149,12 @@ class GraphMgr {
     GraphMgr* graph_mgr;
 
     int64_t collective_graph_key;
+
+    // Key of this item in `item_cache_`, or empty if it isn't cached.
+    string cache_key;
+
+    // Number of graph handles in `table_` that refer to this item.
+    int num_handles = 0;
   };
 
   const WorkerEnv* worker_env_;  // Not owned.
@@ -166,6 +176,17 @@ class GraphMgr {
   // mechanism to gc these graphs.
   std::unordered_map<string, Item*> table_;
 
+  // Registered items by a fingerprint of their registration arguments. A
+  // registration of a graph that is already registered in the same session,
+  // e.g. the same partition of a different subgraph of a master session,
+  // refers to the existing item instead of building new executors. Entries
+  // don't own a reference, and are removed with the last handle of the item.
+  std::unordered_map<string, Item*> item_cache_ TF_GUARDED_BY(mu_);
+
+  // Accounts for the removal of a handle of `item` from `table_`, and removes
+  // the item from `item_cache_` with its last handle.
+  void ReleaseHandle(Item* item) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   void StartParallelExecutors(
       const string& handle, int64_t step_id, Item* item, Rendezvous* rendezvous,
       CollectiveExecutor::Handle* ce_handle, StepStatsCollector* collector,
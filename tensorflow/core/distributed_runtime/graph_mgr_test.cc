@@ -0,0 +1,254 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/graph_mgr.h"
+
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/build_graph_options.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
+#include "tensorflow/core/distributed_runtime/test_utils.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/distributed_runtime/worker_session.h"
+#include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/framework/control_flow.h"
+#include "tensorflow/core/framework/device_factory.h"
+#include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/default_device.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kSession[] = "graph_mgr_test_session";
+constexpr char kWorker[] = "/job:worker/replica:0/task:0";
+constexpr char kDevice[] = "/job:worker/replica:0/task:0/device:CPU:0";
+
+// Returns the rendezvous key of "tensor" sent on the test device.
+string Key(const string& tensor) {
+  return Rendezvous::CreateKey(kDevice, /*src_incarnation=*/1, kDevice, tensor,
+                               FrameAndIter(0, 0));
+}
+
+// Returns a graph that receives "x" and sends "y" = -"x".
+GraphDef NegGraph() {
+  Graph graph(OpRegistry::Global());
+  Node* x = test::graph::Recv(&graph, "x", "float", kDevice, 1, kDevice);
+  Node* neg = test::graph::Unary(&graph, "Neg", x);
+  test::graph::Send(&graph, neg, "y", kDevice, 1, kDevice);
+  GraphDef gdef;
+  graph.ToGraphDef(&gdef);
+  graph::SetDefaultDevice(kDevice, &gdef);
+  return gdef;
+}
+
+class GraphMgrTest : public ::testing::Test {
+ protected:
+  GraphMgrTest() {
+    std::vector<std::unique_ptr<Device>> devices;
+    devices.push_back(DeviceFactory::NewDevice("CPU", SessionOptions(), kWorker));
+    device_mgr_ = absl::make_unique<StaticDeviceMgr>(std::move(devices));
+    compute_pool_ = absl::make_unique<thread::ThreadPool>(
+        Env::Default(), "graph_mgr_test", /*num_threads=*/2);
+    worker_env_.env = Env::Default();
+    worker_env_.device_mgr = device_mgr_.get();
+    worker_env_.compute_pool = compute_pool_.get();
+    rendezvous_mgr_ = absl::make_unique<RpcRendezvousMgr>(&worker_env_);
+    worker_env_.rendezvous_mgr = rendezvous_mgr_.get();
+    worker_session_ = WorkerSession::CreateWithBorrowedDeviceMgr(
+        kSession, kWorker, absl::make_unique<TestWorkerCache>(),
+        device_mgr_.get(), /*graph_mgr=*/nullptr,
+        /*remote_device_mgr=*/nullptr);
+    graph_mgr_ = absl::make_unique<GraphMgr>(&worker_env_, device_mgr_.get());
+  }
+
+  Status Register(const GraphDef& gdef, const GraphOptions& graph_options,
+                  const DebugOptions& debug_options, string* graph_handle) {
+    return graph_mgr_->Register(kSession, gdef, graph_options, debug_options,
+                                ConfigProto(),
+                                BuildGraphOptions::kNoCollectiveGraphKey,
+                                worker_session_.get(),
+                                /*cluster_flr=*/nullptr, graph_handle);
+  }
+
+  Status Register(const GraphDef& gdef, string* graph_handle) {
+    return Register(gdef, GraphOptions(), DebugOptions(), graph_handle);
+  }
+
+  // Runs one step of the registered NegGraph() "graph_handle".
+  Status RunNeg(const string& graph_handle, float x, float* y) {
+    const int64_t step_id = next_step_id_++;
+    GraphMgr::NamedTensors in;
+    in[Key("x")] = test::AsScalar<float>(x);
+    CancellationManager cancellation_manager;
+    Notification done;
+    Status status;
+    graph_mgr_->ExecuteAsync(graph_handle, step_id, ExecutorOpts(), in,
+                             worker_session_.get(), /*collector=*/nullptr,
+                             /*response=*/nullptr, &cancellation_manager,
+                             /*coordination_service_agent=*/nullptr,
+                             [&status, &done](const Status& s) {
+                               status = s;
+                               done.Notify();
+                             });
+    done.WaitForNotification();
+    if (status.ok()) {
+      GraphMgr::NamedTensors out = {{Key("y"), Tensor()}};
+      status = graph_mgr_->RecvOutputs(step_id, &out);
+      if (status.ok()) *y = out[Key("y")].scalar<float>()();
+    }
+    rendezvous_mgr_->Cleanup(step_id);
+    return status;
+  }
+
+  std::unique_ptr<DeviceMgr> device_mgr_;
+  std::unique_ptr<thread::ThreadPool> compute_pool_;
+  WorkerEnv worker_env_;
+  std::unique_ptr<RpcRendezvousMgr> rendezvous_mgr_;
+  std::shared_ptr<WorkerSession> worker_session_;
+  std::unique_ptr<GraphMgr> graph_mgr_;
+  int64_t next_step_id_ = 1;
+};
+
+TEST_F(GraphMgrTest, IdenticalRegistrationsShareExecutors) {
+  const GraphDef gdef = NegGraph();
+  string handle_a;
+  string handle_b;
+  TF_ASSERT_OK(Register(gdef, &handle_a));
+  TF_ASSERT_OK(Register(gdef, &handle_b));
+  EXPECT_NE(handle_a, handle_b);
+  EXPECT_TRUE(graph_mgr_->SharesExecutorsForTest(handle_a, handle_b));
+
+  float y = 0;
+  TF_ASSERT_OK(RunNeg(handle_a, 1.0f, &y));
+  EXPECT_EQ(y, -1.0f);
+  TF_ASSERT_OK(RunNeg(handle_b, 2.0f, &y));
+  EXPECT_EQ(y, -2.0f);
+}
+
+TEST_F(GraphMgrTest, DeregisterKeepsSharedExecutors) {
+  const GraphDef gdef = NegGraph();
+  string handle_a;
+  string handle_b;
+  TF_ASSERT_OK(Register(gdef, &handle_a));
+  TF_ASSERT_OK(Register(gdef, &handle_b));
+  TF_ASSERT_OK(graph_mgr_->Deregister(handle_a));
+
+  float y = 0;
+  EXPECT_TRUE(errors::IsAborted(RunNeg(handle_a, 1.0f, &y)));
+  TF_ASSERT_OK(RunNeg(handle_b, 3.0f, &y));
+  EXPECT_EQ(y, -3.0f);
+
+  // A new registration still shares the executors of the remaining handle.
+  string handle_c;
+  TF_ASSERT_OK(Register(gdef, &handle_c));
+  EXPECT_TRUE(graph_mgr_->SharesExecutorsForTest(handle_b, handle_c));
+
+  // Once the last handle is gone, the next registration builds new executors.
+  TF_ASSERT_OK(graph_mgr_->Deregister(handle_b));
+  TF_ASSERT_OK(graph_mgr_->Deregister(handle_c));
+  string handle_d;
+  TF_ASSERT_OK(Register(gdef, &handle_d));
+  TF_ASSERT_OK(RunNeg(handle_d, 4.0f, &y));
+  EXPECT_EQ(y, -4.0f);
+}
+
+TEST_F(GraphMgrTest, DeregisterAllReleasesSharedExecutors) {
+  const GraphDef gdef = NegGraph();
+  string handle_a;
+  string handle_b;
+  TF_ASSERT_OK(Register(gdef, &handle_a));
+  TF_ASSERT_OK(Register(gdef, &handle_b));
+  TF_ASSERT_OK(graph_mgr_->DeregisterAll());
+
+  string handle_c;
+  TF_ASSERT_OK(Register(gdef, &handle_c));
+  EXPECT_FALSE(graph_mgr_->SharesExecutorsForTest(handle_a, handle_c));
+  float y = 0;
+  TF_ASSERT_OK(RunNeg(handle_c, 5.0f, &y));
+  EXPECT_EQ(y, -5.0f);
+}
+
+TEST_F(GraphMgrTest, DifferentRegistrationsDontShareExecutors) {
+  const GraphDef gdef = NegGraph();
+  string handle_a;
+  TF_ASSERT_OK(Register(gdef, &handle_a));
+
+  // A different graph.
+  GraphDef other_gdef = gdef;
+  other_gdef.mutable_versions()->set_producer(gdef.versions().producer() - 1);
+  string handle_b;
+  TF_ASSERT_OK(Register(other_gdef, &handle_b));
+  EXPECT_FALSE(graph_mgr_->SharesExecutorsForTest(handle_a, handle_b));
+
+  // The same graph with different options.
+  GraphOptions graph_options;
+  graph_options.set_build_cost_model(1);
+  string handle_c;
+  TF_ASSERT_OK(Register(gdef, graph_options, DebugOptions(), &handle_c));
+  EXPECT_FALSE(graph_mgr_->SharesExecutorsForTest(handle_a, handle_c));
+
+  float y = 0;
+  TF_ASSERT_OK(RunNeg(handle_c, 6.0f, &y));
+  EXPECT_EQ(y, -6.0f);
+}
+
+TEST_F(GraphMgrTest, DebugWatchesDontShareExecutors) {
+  const GraphDef gdef = NegGraph();
+  DebugOptions debug_options;
+  for (const NodeDef& ndef : gdef.node()) {
+    if (ndef.op() == "Neg") {
+      DebugTensorWatch* watch = debug_options.add_debug_tensor_watch_opts();
+      watch->set_node_name(ndef.name());
+      watch->set_output_slot(0);
+      watch->add_debug_ops("DebugIdentity");
+    }
+  }
+  ASSERT_EQ(debug_options.debug_tensor_watch_opts_size(), 1);
+
+  string handle_a;
+  string handle_b;
+  string handle_c;
+  TF_ASSERT_OK(Register(gdef, &handle_a));
+  TF_ASSERT_OK(Register(gdef, GraphOptions(), debug_options, &handle_b));
+  TF_ASSERT_OK(Register(gdef, GraphOptions(), debug_options, &handle_c));
+  EXPECT_FALSE(graph_mgr_->SharesExecutorsForTest(handle_a, handle_b));
+  EXPECT_FALSE(graph_mgr_->SharesExecutorsForTest(handle_b, handle_c));
+
+  // A registration without watches still shares the undecorated executors.
+  string handle_d;
+  TF_ASSERT_OK(Register(gdef, &handle_d));
+  EXPECT_TRUE(graph_mgr_->SharesExecutorsForTest(handle_a, handle_d));
+
+  float y = 0;
+  TF_ASSERT_OK(RunNeg(handle_b, 7.0f, &y));
+  EXPECT_EQ(y, -7.0f);
+}
+
+}  // namespace
+}  // namespace tensorflow
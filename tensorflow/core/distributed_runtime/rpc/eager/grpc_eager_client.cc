@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_client.h"
 
+#include <memory>
+#include <vector>
+
+#include "grpcpp/alarm.h"
 #include "grpcpp/generic/generic_stub.h"
 #include "tensorflow/core/distributed_runtime/call_options.h"
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_service.h"
@@ -60,6 +64,29 @@ bool EnableStreaming() {
   return result;
 }
 
+/*
+ * With streaming enabled, setting "TF_EAGER_CLIENT_ENQUEUE_BATCH_SIZE" to more
+ * than 1 batches consecutive StreamingEnqueue requests of a context into a
+ * single request of up to that many queue items. A batch is sent when it is
+ * full, or "TF_EAGER_CLIENT_ENQUEUE_BATCH_LATENCY_US" microseconds after its
+ * first request, 0 meaning as soon as the completion queue thread of the
+ * client gets to it. The responses of the batches sent are still received
+ * while later batches are being filled.
+ */
+int64_t EnqueueBatchSize() {
+  int64_t result;
+  TF_CHECK_OK(
+      ReadInt64FromEnvVar("TF_EAGER_CLIENT_ENQUEUE_BATCH_SIZE", 1, &result));
+  return result;
+}
+
+int64_t EnqueueBatchLatencyUs() {
+  int64_t result;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_EAGER_CLIENT_ENQUEUE_BATCH_LATENCY_US",
+                                  0, &result));
+  return result;
+}
+
 // Ref-counted thread to handle callbacks for completed requests a GRPC
 // completion queue. The thread might be shared by multiple eager clients, and
 // each one of them should hold a reference count to ensure that the thread
@@ -105,11 +132,27 @@ class GrpcEagerClient : public EagerClient {
  public:
   GrpcEagerClient(const tensorflow::SharedGrpcChannelPtr& channel,
                   GrpcEagerClientThread* thread, const string& target)
-      : stub_(channel), thread_(thread), target_(target) {
+      : stub_(channel),
+        thread_(thread),
+        target_(target),
+        enqueue_batch_latency_us_(EnqueueBatchLatencyUs()) {
     // Hold a reference to make sure the corresponding EagerClientThread
     // outlives the client.
     thread_->Ref();
     cq_ = thread->completion_queue();
+    const int64_t enqueue_batch_size =
+        EnableStreaming() ? EnqueueBatchSize() : 1;
+    if (enqueue_batch_size > 1) {
+      enqueue_batcher_ = std::make_unique<EnqueueBatcher>(
+          enqueue_batch_size,
+          [this](const EnqueueRequest& request, EnqueueResponse* response,
+                 StatusCallback done) {
+            mutex_lock l(mu_);
+            GetEnqueueDispatcherLocked(request.context_id())
+                ->SendNextRequest(request, response, std::move(done));
+          },
+          [this](uint64 context_id) { ScheduleEnqueueFlush(context_id); });
+    }
   }
   ~GrpcEagerClient() override { thread_->Unref(); }
 
@@ -165,6 +208,11 @@ class GrpcEagerClient : public EagerClient {
     VLOG(1) << "Sending RPC to close remote eager context "
             << request->DebugString();
 
+    // Requests batched before the context is closed are sent, and cancelled
+    // together with the streaming call.
+    if (enqueue_batcher_ != nullptr) {
+      enqueue_batcher_->Flush(request->context_id());
+    }
     mutex_lock l(mu_);
     const auto& it = enqueue_dispatchers_.find(request->context_id());
     if (it != enqueue_dispatchers_.end()) {
@@ -181,20 +229,13 @@ class GrpcEagerClient : public EagerClient {
                              EnqueueResponse* response,
                              StatusCallback done) override {
     StatusCallback done_wrapped = callback_wrapper(std::move(done));
-    if (EnableStreaming()) {
+    if (enqueue_batcher_ != nullptr) {
+      enqueue_batcher_->Add(*request, response, std::move(done_wrapped));
+    } else if (EnableStreaming()) {
       mutex_lock l(mu_);
-      auto it = enqueue_dispatchers_.find(request->context_id());
-      if (it == enqueue_dispatchers_.end()) {
-        auto it_and_bool = enqueue_dispatchers_.emplace(
-            std::piecewise_construct,
-            std::forward_as_tuple(request->context_id()),
-            std::forward_as_tuple(
-                &stub_, cq_,
-                "/tensorflow.eager.EagerService/StreamingEnqueue"));
-        it = it_and_bool.first;
-      }
       // TODO(haoyuzhang): Consider supporting cancellation for streaming RPC?
-      it->second.SendNextRequest(*request, response, std::move(done_wrapped));
+      GetEnqueueDispatcherLocked(request->context_id())
+          ->SendNextRequest(*request, response, std::move(done_wrapped));
     } else {
       Notification n;
       Status status;
@@ -220,6 +261,59 @@ class GrpcEagerClient : public EagerClient {
   std::unordered_map<uint64, StreamingRPCDispatcher<EnqueueResponse>>
       enqueue_dispatchers_ TF_GUARDED_BY(mu_);
 
+  // Batches the StreamingEnqueue requests, if enabled. Sends the batches
+  // through `enqueue_dispatchers_`, so it takes `mu_` while holding its own
+  // lock.
+  std::unique_ptr<EnqueueBatcher> enqueue_batcher_;
+  const int64_t enqueue_batch_latency_us_;
+
+  StreamingRPCDispatcher<EnqueueResponse>* GetEnqueueDispatcherLocked(
+      uint64 context_id) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    auto it = enqueue_dispatchers_.find(context_id);
+    if (it == enqueue_dispatchers_.end()) {
+      it = enqueue_dispatchers_
+               .emplace(std::piecewise_construct,
+                        std::forward_as_tuple(context_id),
+                        std::forward_as_tuple(
+                            &stub_, cq_,
+                            "/tensorflow.eager.EagerService/StreamingEnqueue"))
+               .first;
+    }
+    return &it->second;
+  }
+
+  // Flushes the batch of `context_id` on the completion queue thread, after
+  // the batching latency. A late flush finds a later batch, or none, which is
+  // harmless.
+  class EnqueueFlushTag : public GrpcClientCQTag {
+   public:
+    EnqueueFlushTag(GrpcEagerClient* client, uint64 context_id)
+        : client_(client), context_id_(context_id) {
+      client_->Ref();
+      alarm_.Set(client_->cq_,
+                 gpr_time_add(gpr_now(GPR_CLOCK_MONOTONIC),
+                              gpr_time_from_micros(
+                                  client_->enqueue_batch_latency_us_,
+                                  GPR_TIMESPAN)),
+                 static_cast<GrpcClientCQTag*>(this));
+    }
+
+    void OnCompleted(bool ok) override {
+      client_->enqueue_batcher_->Flush(context_id_);
+      client_->Unref();
+      delete this;
+    }
+
+   private:
+    GrpcEagerClient* const client_;
+    const uint64 context_id_;
+    ::grpc::Alarm alarm_;
+  };
+
+  void ScheduleEnqueueFlush(uint64 context_id) {
+    new EnqueueFlushTag(this, context_id);
+  }
+
   StatusCallback callback_wrapper(StatusCallback done) {
     Ref();
     return [this, done = std::move(done)](const Status& status) {
@@ -293,6 +387,66 @@ class GrpcEagerClientCache : public EagerClientCache {
 
 }  // namespace
 
+EnqueueBatcher::EnqueueBatcher(int64_t batch_size, SendFn send,
+                               ScheduleFlushFn schedule_flush)
+    : batch_size_(batch_size),
+      send_(std::move(send)),
+      schedule_flush_(std::move(schedule_flush)) {}
+
+void EnqueueBatcher::Add(const EnqueueRequest& request,
+                         EnqueueResponse* response, StatusCallback done) {
+  const uint64 context_id = request.context_id();
+  mutex_lock l(mu_);
+  std::unique_ptr<Batch>& batch = batches_[context_id];
+  const bool is_first = batch == nullptr;
+  if (is_first) {
+    batch = std::make_unique<Batch>();
+    batch->request.set_context_id(context_id);
+  }
+  for (const QueueItem& item : request.queue()) {
+    *batch->request.add_queue() = item;
+  }
+  batch->parts.push_back({response, request.queue_size(), std::move(done)});
+  if (batch->request.queue_size() >= batch_size_) {
+    FlushLocked(context_id);
+  } else if (is_first) {
+    schedule_flush_(context_id);
+  }
+}
+
+void EnqueueBatcher::Flush(uint64 context_id) {
+  mutex_lock l(mu_);
+  FlushLocked(context_id);
+}
+
+void EnqueueBatcher::FlushLocked(uint64 context_id) {
+  auto it = batches_.find(context_id);
+  if (it == batches_.end()) return;
+  std::shared_ptr<Batch> batch(std::move(it->second));
+  batches_.erase(it);
+  VLOG(3) << "Sending a batch of " << batch->parts.size()
+          << " Enqueue requests with " << batch->request.queue_size()
+          << " items";
+  auto response = std::make_shared<EnqueueResponse>();
+  send_(batch->request, response.get(),
+        [batch, response](const Status& status) {
+          // The server answers each queue item with one QueueResponse, in
+          // order, and stops at the first failing item, so all the requests
+          // of the batch share its error.
+          int offset = 0;
+          for (Batch::Part& part : batch->parts) {
+            if (status.ok()) {
+              for (int i = 0; i < part.num_items; ++i) {
+                part.response->add_queue_response()->Swap(
+                    response->mutable_queue_response(offset + i));
+              }
+            }
+            offset += part.num_items;
+            part.done(status);
+          }
+        });
+}
+
 EagerClientCache* NewGrpcEagerClientCache(
     std::shared_ptr<tensorflow::GrpcChannelCache> channel) {
   return new GrpcEagerClientCache(channel);
@@ -16,14 +16,72 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_EAGER_GRPC_EAGER_CLIENT_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_EAGER_GRPC_EAGER_CLIENT_H_
 
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include "tensorflow/core/distributed_runtime/eager/eager_client.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/eager_service.pb.h"
 
 namespace tensorflow {
 namespace eager {
 // The GrpcChannelCache is not owned.
 EagerClientCache* NewGrpcEagerClientCache(
     std::shared_ptr<tensorflow::GrpcChannelCache> channel);
+
+// Batches consecutive StreamingEnqueue requests of a context into a single
+// request of up to `batch_size` queue items, and splits the response of the
+// batch among the requests. Used by the gRPC eager client.
+//
+// This class is thread safe.
+class EnqueueBatcher {
+ public:
+  // Sends the batched `request`. The batches of a context are sent in order,
+  // with the lock of the batcher held, so `done` should not be called inline.
+  using SendFn = std::function<void(const EnqueueRequest& request,
+                                    EnqueueResponse* response,
+                                    StatusCallback done)>;
+  // Called for the first request of a batch. Flush(context_id) must be called
+  // later, for instance after a batching latency.
+  using ScheduleFlushFn = std::function<void(uint64 context_id)>;
+
+  EnqueueBatcher(int64_t batch_size, SendFn send,
+                 ScheduleFlushFn schedule_flush);
+
+  // Appends the items of `request` to the batch of its context, and sends the
+  // batch if it is full. Once the batch is answered, the items of its
+  // response are moved to `response`, and `done` is called.
+  void Add(const EnqueueRequest& request, EnqueueResponse* response,
+           StatusCallback done) TF_LOCKS_EXCLUDED(mu_);
+
+  // Sends the batch of `context_id`, if any.
+  void Flush(uint64 context_id) TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Batch {
+    struct Part {
+      EnqueueResponse* response;
+      int num_items;
+      StatusCallback done;
+    };
+    EnqueueRequest request;
+    std::vector<Part> parts;
+  };
+
+  void FlushLocked(uint64 context_id) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64_t batch_size_;
+  const SendFn send_;
+  const ScheduleFlushFn schedule_flush_;
+
+  mutex mu_;
+  std::unordered_map<uint64, std::unique_ptr<Batch>> batches_
+      TF_GUARDED_BY(mu_);
+};
 }  // namespace eager
 }  // namespace tensorflow
 
@@ -15,13 +15,18 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/eager/grpc_eager_client.h"
 
+#include <memory>
+#include <vector>
+
 #include "tensorflow/c/tf_status.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/eager_service.pb.h"
 
 namespace tensorflow {
 namespace eager {
@@ -54,5 +59,183 @@ TEST(GrpcEagerClientCache, TestGetClientThreadSafety) {
   counter.Wait();
 }
 
+// Records the batches sent by an EnqueueBatcher and the flushes it schedules,
+// and answers the batches on demand.
+class EnqueueBatcherTest : public ::testing::Test {
+ protected:
+  struct SentBatch {
+    EnqueueRequest request;
+    EnqueueResponse* response;
+    StatusCallback done;
+  };
+
+  std::unique_ptr<EnqueueBatcher> MakeBatcher(int64_t batch_size) {
+    return std::make_unique<EnqueueBatcher>(
+        batch_size,
+        [this](const EnqueueRequest& request, EnqueueResponse* response,
+               StatusCallback done) {
+          sent_.push_back({request, response, std::move(done)});
+        },
+        [this](uint64 context_id) { scheduled_flushes_.push_back(context_id); });
+  }
+
+  // Returns a request of `context_id` with operations `first_id`, ...,
+  // `first_id` + `num_items` - 1.
+  static EnqueueRequest MakeRequest(uint64 context_id, int first_id,
+                                    int num_items) {
+    EnqueueRequest request;
+    request.set_context_id(context_id);
+    for (int i = 0; i < num_items; ++i) {
+      request.add_queue()->mutable_operation()->set_id(first_id + i);
+    }
+    return request;
+  }
+
+  // Answers the operation of every item of `batch` with a shape of one
+  // dimension, the size of which is the operation id.
+  static void Answer(SentBatch* batch) {
+    for (const QueueItem& item : batch->request.queue()) {
+      batch->response->add_queue_response()->add_shape()->add_dim()->set_size(
+          item.operation().id());
+    }
+    batch->done(Status::OK());
+  }
+
+  // Returns the operation ids that `response` answers.
+  static std::vector<int64_t> AnsweredIds(const EnqueueResponse& response) {
+    std::vector<int64_t> ids;
+    for (const QueueResponse& queue_response : response.queue_response()) {
+      ids.push_back(queue_response.shape(0).dim(0).size());
+    }
+    return ids;
+  }
+
+  static std::vector<int64_t> Ids(const EnqueueRequest& request) {
+    std::vector<int64_t> ids;
+    for (const QueueItem& item : request.queue()) {
+      ids.push_back(item.operation().id());
+    }
+    return ids;
+  }
+
+  std::vector<SentBatch> sent_;
+  std::vector<uint64> scheduled_flushes_;
+};
+
+TEST_F(EnqueueBatcherTest, SendsFullBatch) {
+  auto batcher = MakeBatcher(/*batch_size=*/3);
+  EnqueueResponse responses[3];
+  Status statuses[3] = {errors::Unknown("not done"), errors::Unknown("not done"),
+                        errors::Unknown("not done")};
+  for (int i = 0; i < 3; ++i) {
+    batcher->Add(MakeRequest(/*context_id=*/1, /*first_id=*/i,
+                             /*num_items=*/1),
+                 &responses[i],
+                 [&statuses, i](const Status& s) { statuses[i] = s; });
+    // Only the first request of the batch schedules a flush.
+    EXPECT_EQ(scheduled_flushes_, std::vector<uint64>({1}));
+    ASSERT_EQ(sent_.size(), i < 2 ? 0 : 1);
+  }
+
+  EXPECT_EQ(sent_[0].request.context_id(), 1);
+  EXPECT_EQ(Ids(sent_[0].request), std::vector<int64_t>({0, 1, 2}));
+  Answer(&sent_[0]);
+  for (int i = 0; i < 3; ++i) {
+    TF_EXPECT_OK(statuses[i]);
+    EXPECT_EQ(AnsweredIds(responses[i]), std::vector<int64_t>({i}));
+  }
+
+  // The scheduled flush finds no batch.
+  batcher->Flush(1);
+  EXPECT_EQ(sent_.size(), 1);
+}
+
+TEST_F(EnqueueBatcherTest, SplitsResponseAmongRequests) {
+  auto batcher = MakeBatcher(/*batch_size=*/10);
+  EnqueueResponse responses[3];
+  int num_done = 0;
+  auto done = [&num_done](const Status& s) {
+    TF_EXPECT_OK(s);
+    ++num_done;
+  };
+  batcher->Add(MakeRequest(/*context_id=*/1, /*first_id=*/0, /*num_items=*/2),
+               &responses[0], done);
+  batcher->Add(MakeRequest(/*context_id=*/1, /*first_id=*/2, /*num_items=*/0),
+               &responses[1], done);
+  batcher->Add(MakeRequest(/*context_id=*/1, /*first_id=*/2, /*num_items=*/3),
+               &responses[2], done);
+  EXPECT_TRUE(sent_.empty());
+
+  batcher->Flush(1);
+  ASSERT_EQ(sent_.size(), 1);
+  EXPECT_EQ(Ids(sent_[0].request), std::vector<int64_t>({0, 1, 2, 3, 4}));
+  EXPECT_EQ(num_done, 0);
+  Answer(&sent_[0]);
+  EXPECT_EQ(num_done, 3);
+  EXPECT_EQ(AnsweredIds(responses[0]), std::vector<int64_t>({0, 1}));
+  EXPECT_TRUE(AnsweredIds(responses[1]).empty());
+  EXPECT_EQ(AnsweredIds(responses[2]), std::vector<int64_t>({2, 3, 4}));
+}
+
+TEST_F(EnqueueBatcherTest, PassesErrorToAllRequests) {
+  auto batcher = MakeBatcher(/*batch_size=*/10);
+  EnqueueResponse responses[2];
+  std::vector<Status> statuses;
+  for (int i = 0; i < 2; ++i) {
+    batcher->Add(MakeRequest(/*context_id=*/1, /*first_id=*/i,
+                             /*num_items=*/1),
+                 &responses[i],
+                 [&statuses](const Status& s) { statuses.push_back(s); });
+  }
+  batcher->Flush(1);
+  ASSERT_EQ(sent_.size(), 1);
+  sent_[0].done(errors::Internal("remote op failed"));
+
+  ASSERT_EQ(statuses.size(), 2);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(statuses[i].code(), error::INTERNAL);
+    EXPECT_EQ(responses[i].queue_response_size(), 0);
+  }
+}
+
+TEST_F(EnqueueBatcherTest, FlushesContextsSeparately) {
+  auto batcher = MakeBatcher(/*batch_size=*/10);
+  EnqueueResponse responses[3];
+  auto done = [](const Status& s) { TF_EXPECT_OK(s); };
+  batcher->Add(MakeRequest(/*context_id=*/1, /*first_id=*/0, /*num_items=*/1),
+               &responses[0], done);
+  batcher->Add(MakeRequest(/*context_id=*/2, /*first_id=*/1, /*num_items=*/1),
+               &responses[1], done);
+  batcher->Add(MakeRequest(/*context_id=*/1, /*first_id=*/2, /*num_items=*/1),
+               &responses[2], done);
+  EXPECT_EQ(scheduled_flushes_, std::vector<uint64>({1, 2}));
+
+  // Closing context 1 flushes its batch only.
+  batcher->Flush(1);
+  ASSERT_EQ(sent_.size(), 1);
+  EXPECT_EQ(sent_[0].request.context_id(), 1);
+  EXPECT_EQ(Ids(sent_[0].request), std::vector<int64_t>({0, 2}));
+  batcher->Flush(1);
+  EXPECT_EQ(sent_.size(), 1);
+
+  // A new request of context 1 starts a new batch.
+  EnqueueResponse response;
+  batcher->Add(MakeRequest(/*context_id=*/1, /*first_id=*/3, /*num_items=*/1),
+               &response, done);
+  EXPECT_EQ(scheduled_flushes_, std::vector<uint64>({1, 2, 1}));
+
+  batcher->Flush(2);
+  ASSERT_EQ(sent_.size(), 2);
+  EXPECT_EQ(sent_[1].request.context_id(), 2);
+  EXPECT_EQ(Ids(sent_[1].request), std::vector<int64_t>({1}));
+  for (SentBatch& batch : sent_) {
+    Answer(&batch);
+  }
+  EXPECT_EQ(AnsweredIds(responses[0]), std::vector<int64_t>({0}));
+  EXPECT_EQ(AnsweredIds(responses[1]), std::vector<int64_t>({1}));
+  EXPECT_EQ(AnsweredIds(responses[2]), std::vector<int64_t>({2}));
+  EXPECT_TRUE(AnsweredIds(response).empty());
+}
+
 }  // namespace eager
 }  // namespace tensorflow
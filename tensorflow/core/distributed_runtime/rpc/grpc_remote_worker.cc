@@ -66,6 +66,7 @@ class GrpcRemoteWorker : public WorkerInterface {
         instancesource_(Method(GrpcWorkerMethod::kCompleteInstance)),
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
         markrecvfinished_(Method(GrpcWorkerMethod::kMarkRecvFinished)),
+        recvtensorchunk_(Method(GrpcWorkerMethod::kRecvTensorChunk)),
         logger_(logger),
         target_(target) {}
 
@@ -195,6 +196,12 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(request, response, getstepsequence_, std::move(done));
   }
 
+  void RecvTensorChunkAsync(const RecvTensorChunkRequest* request,
+                            RecvTensorChunkResponse* response,
+                            StatusCallback done) override {
+    IssueRequest(request, response, recvtensorchunk_, std::move(done));
+  }
+
   void RecvTensorAsync(CallOptions* call_opts, const RecvTensorRequest* request,
                        TensorResponse* response, StatusCallback done) override {
     VLOG(1) << "RecvTensorAsync req: " << request->DebugString();
@@ -329,6 +336,7 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string instancesource_;
   const ::grpc::string getstepsequence_;
   const ::grpc::string markrecvfinished_;
+  const ::grpc::string recvtensorchunk_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
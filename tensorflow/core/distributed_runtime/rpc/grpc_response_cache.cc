@@ -15,9 +15,31 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_response_cache.h"
 #include "absl/types/optional.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
+namespace {
+
+auto* response_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/rpc/response_cache_lookups",
+    "The number of requests looked up in the gRPC response cache, by result: "
+    "'hit' for a finished response, 'coalesced' for a response that is being "
+    "computed, or 'miss'.",
+    "result");
+
+auto* response_cache_evictions = monitoring::Counter<0>::New(
+    "/tensorflow/core/rpc/response_cache_evictions",
+    "The number of finished responses evicted from the gRPC response cache "
+    "to stay within its byte limit.");
+
+// The bytes of tensor content that a finished response holds.
+int64_t ResponseBytes(const Tensor& tensor) { return tensor.TotalBytes(); }
+
+}  // namespace
+
+GrpcResponseCache::GrpcResponseCache(int64_t max_bytes)
+    : max_bytes_(max_bytes) {}
 
 bool GrpcResponseCache::QueueRequest(int64_t request_id, int64_t step_id,
                                      const FinishResponseCB& cb) {
@@ -29,6 +51,8 @@ bool GrpcResponseCache::QueueRequest(int64_t request_id, int64_t step_id,
 
   if (entry.state == ResponseCacheEntry::State::FINISHED) {
     VLOG(1) << "Reuse cached response for " << request_id;
+    response_cache_lookups->GetCell("hit")->IncrementBy(1);
+    lru_.splice(lru_.begin(), lru_, entry.lru_pos);
     // Make a copy of the ResponseCacheEntry so that we can run FinishResponse
     // outside the critical section. FinishResponse can be potentially
     // expensive.
@@ -44,11 +68,13 @@ bool GrpcResponseCache::QueueRequest(int64_t request_id, int64_t step_id,
   if (entry.state == ResponseCacheEntry::State::ACTIVE) {
     VLOG(1) << "Found active request for " << request_id
             << ".  Adding entry to response queue.";
+    response_cache_lookups->GetCell("coalesced")->IncrementBy(1);
     mu_.unlock();
     return true;
   } else {
     VLOG(2) << "No cache entry for " << request_id
             << ", running user computation.";
+    response_cache_lookups->GetCell("miss")->IncrementBy(1);
     entry.step_id = step_id;
     entry.state = ResponseCacheEntry::State::ACTIVE;
     mu_.unlock();
@@ -80,12 +106,15 @@ void GrpcResponseCache::OnRequestFinished(int64_t request_id,
     entry.is_dead = is_dead;
     entry.response_status = status;
     entry.state = ResponseCacheEntry::State::FINISHED;
+    entry.lru_pos = lru_.insert(lru_.begin(), request_id);
+    cached_bytes_ += ResponseBytes(tensor);
 
     // We copy the extra work out of the critical section in order to avoid
     // serializing the work for sending response.
     entry_copy = entry;
 
     entry.callbacks.clear();
+    EvictEntriesLocked();
   }
 
   for (auto& cb : entry_copy->callbacks) {
@@ -95,7 +124,8 @@ void GrpcResponseCache::OnRequestFinished(int64_t request_id,
 
 void GrpcResponseCache::EraseRequestId(int64_t request_id) {
   mutex_lock m(mu_);
-  response_cache_.erase(request_id);
+  auto it = response_cache_.find(request_id);
+  if (it != response_cache_.end()) EraseEntryLocked(it);
 }
 
 void GrpcResponseCache::CleanEntriesForStep(int64_t step_id) {
@@ -105,11 +135,38 @@ void GrpcResponseCache::CleanEntriesForStep(int64_t step_id) {
        it != last;) {
     if (it->second.step_id == step_id) {
       VLOG(1) << "Erase stale GrpcResponseCache entry " << it->first;
-      it = response_cache_.erase(it);
+      it = EraseEntryLocked(it);
     } else {
       ++it;
     }
   }
 }
 
+int64_t GrpcResponseCache::cached_bytes() {
+  mutex_lock m(mu_);
+  return cached_bytes_;
+}
+
+gtl::FlatMap<int64_t, GrpcResponseCache::ResponseCacheEntry>::iterator
+GrpcResponseCache::EraseEntryLocked(
+    gtl::FlatMap<int64_t, ResponseCacheEntry>::iterator it) {
+  const ResponseCacheEntry& entry = it->second;
+  if (entry.state == ResponseCacheEntry::State::FINISHED) {
+    cached_bytes_ -= ResponseBytes(entry.tensor);
+    lru_.erase(entry.lru_pos);
+  }
+  return response_cache_.erase(it);
+}
+
+void GrpcResponseCache::EvictEntriesLocked() {
+  if (max_bytes_ < 0) return;
+  while (cached_bytes_ > max_bytes_ && !lru_.empty()) {
+    const int64_t request_id = lru_.back();
+    VLOG(1) << "Evict GrpcResponseCache entry " << request_id << " to keep "
+            << cached_bytes_ << " cached bytes within " << max_bytes_;
+    response_cache_evictions->GetCell()->IncrementBy(1);
+    EraseEntryLocked(response_cache_.find(request_id));
+  }
+}
+
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_RESPONSE_CACHE_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_RESPONSE_CACHE_H_
 
+#include <list>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -37,12 +38,22 @@ namespace tensorflow {
 // * PENDING: this is the first call of the RPC, and it will transition to
 // * ACTIVE: another thread is active processing this RPC
 // * FINISHED: the worker has finished processing the method
+//
+// Duplicate requests that arrive while the RPC is ACTIVE wait for its
+// response rather than running the method again. FINISHED responses hold at
+// most `max_bytes` bytes of tensor content in total; beyond that, the least
+// recently used of them are evicted, and a retry of an evicted request runs
+// the method again. A negative `max_bytes` disables the limit.
 
 class GrpcResponseCache {
  public:
   using FinishResponseCB = std::function<void(
       const Tensor& tensor, bool is_dead, const Status& status)>;
 
+  static constexpr int64_t kDefaultMaxBytes = 1LL << 30;
+
+  explicit GrpcResponseCache(int64_t max_bytes = kDefaultMaxBytes);
+
   // Add the given request to the cache.
   // If the request is in the cache,
   //    If it is finished, invoke `cb` immediately
@@ -64,6 +75,9 @@ class GrpcResponseCache {
   // Erase cache entries with the given step_id
   void CleanEntriesForStep(int64_t step_id);
 
+  // The number of bytes of tensor content held by the finished responses.
+  int64_t cached_bytes();
+
  private:
   struct ResponseCacheEntry {
     enum class State {
@@ -82,12 +96,29 @@ class GrpcResponseCache {
       cb(tensor, is_dead, response_status);
     }
     std::vector<FinishResponseCB> callbacks;
+
+    // Position in `lru_` of a FINISHED entry.
+    std::list<int64_t>::iterator lru_pos;
   };
 
+  // Erases the entry `it` points to, and returns the next one.
+  gtl::FlatMap<int64_t, ResponseCacheEntry>::iterator EraseEntryLocked(
+      gtl::FlatMap<int64_t, ResponseCacheEntry>::iterator it)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Evicts the least recently used FINISHED entries until they fit in
+  // `max_bytes_`.
+  void EvictEntriesLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64_t max_bytes_;
+
   mutex mu_;
   // response_cache_ is expected to be small, as entries are cleared immediately
   // on ack from the receiver.
   gtl::FlatMap<int64_t, ResponseCacheEntry> response_cache_ TF_GUARDED_BY(mu_);
+  // Request ids of the FINISHED entries, most recently used first.
+  std::list<int64_t> lru_ TF_GUARDED_BY(mu_);
+  int64_t cached_bytes_ TF_GUARDED_BY(mu_) = 0;
 };
 
 }  // namespace tensorflow
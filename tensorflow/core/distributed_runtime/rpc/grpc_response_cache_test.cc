@@ -0,0 +1,110 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_response_cache.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// A tensor of `bytes` bytes of content.
+Tensor MakeTensor(int64_t bytes) {
+  return Tensor(DT_INT8, TensorShape({bytes}));
+}
+
+class GrpcResponseCacheTest : public ::testing::Test {
+ protected:
+  // Looks up `request_id`, and returns whether the response was cached or
+  // being computed.
+  bool Queue(GrpcResponseCache* cache, int64_t request_id,
+             int64_t step_id = 1) {
+    return cache->QueueRequest(
+        request_id, step_id,
+        [this](const Tensor& tensor, bool is_dead, const Status& status) {
+          ++num_responses_;
+          last_bytes_ = tensor.TotalBytes();
+        });
+  }
+
+  int num_responses_ = 0;
+  int64_t last_bytes_ = -1;
+};
+
+TEST_F(GrpcResponseCacheTest, CoalescesConcurrentRequests) {
+  GrpcResponseCache cache;
+  EXPECT_FALSE(Queue(&cache, 1));
+  EXPECT_TRUE(Queue(&cache, 1));
+  EXPECT_TRUE(Queue(&cache, 1));
+  EXPECT_EQ(num_responses_, 0);
+
+  cache.OnRequestFinished(1, MakeTensor(100), false, Status::OK());
+  EXPECT_EQ(num_responses_, 3);
+  EXPECT_EQ(last_bytes_, 100);
+  EXPECT_EQ(cache.cached_bytes(), 100);
+
+  // Retries are answered from the cache.
+  EXPECT_TRUE(Queue(&cache, 1));
+  EXPECT_EQ(num_responses_, 4);
+
+  cache.EraseRequestId(1);
+  EXPECT_EQ(cache.cached_bytes(), 0);
+  EXPECT_FALSE(Queue(&cache, 1));
+}
+
+TEST_F(GrpcResponseCacheTest, EvictsLeastRecentlyUsedResponses) {
+  GrpcResponseCache cache(/*max_bytes=*/250);
+  for (int64_t id = 1; id <= 2; ++id) {
+    ASSERT_FALSE(Queue(&cache, id));
+    cache.OnRequestFinished(id, MakeTensor(100), false, Status::OK());
+  }
+  // Using 1 makes 2 the least recently used response.
+  EXPECT_TRUE(Queue(&cache, 1));
+
+  ASSERT_FALSE(Queue(&cache, 3));
+  cache.OnRequestFinished(3, MakeTensor(100), false, Status::OK());
+  EXPECT_EQ(cache.cached_bytes(), 200);
+  EXPECT_TRUE(Queue(&cache, 1));
+  EXPECT_TRUE(Queue(&cache, 3));
+  EXPECT_FALSE(Queue(&cache, 2));
+
+  // A response over the limit is still sent, but evicts all others.
+  EXPECT_TRUE(Queue(&cache, 2));
+  cache.OnRequestFinished(2, MakeTensor(1000), false, Status::OK());
+  EXPECT_EQ(num_responses_, 8);
+  EXPECT_EQ(last_bytes_, 1000);
+  EXPECT_EQ(cache.cached_bytes(), 0);
+  EXPECT_FALSE(Queue(&cache, 1));
+}
+
+TEST_F(GrpcResponseCacheTest, CleansEntriesForStep) {
+  GrpcResponseCache cache(/*max_bytes=*/-1);
+  ASSERT_FALSE(Queue(&cache, 1, /*step_id=*/1));
+  cache.OnRequestFinished(1, MakeTensor(100), false, Status::OK());
+  ASSERT_FALSE(Queue(&cache, 2, /*step_id=*/2));
+  cache.OnRequestFinished(2, MakeTensor(1 << 20), false, Status::OK());
+  EXPECT_EQ(cache.cached_bytes(), 100 + (1 << 20));
+
+  cache.CleanEntriesForStep(2);
+  EXPECT_EQ(cache.cached_bytes(), 100);
+  EXPECT_TRUE(Queue(&cache, 1));
+  EXPECT_FALSE(Queue(&cache, 2));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -27,6 +27,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/collective_param_resolver_distributed.h"
+#include "tensorflow/core/distributed_runtime/chunked_tensor_transport.h"
+#include "tensorflow/core/distributed_runtime/compressing_tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/device_resolver_distributed.h"
 #include "tensorflow/core/distributed_runtime/graph_mgr.h"
 #include "tensorflow/core/distributed_runtime/local_master.h"
@@ -42,6 +44,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 #include "tensorflow/core/distributed_runtime/rpc_collective_executor_mgr.h"
 #include "tensorflow/core/distributed_runtime/server_lib.h"
+#include "tensorflow/core/distributed_runtime/shared_memory_tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/worker_cache_wrapper.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/framework/op.h"
@@ -300,6 +303,26 @@ Status GrpcServer::Init(const GrpcServerOptions& opts) {
         return WorkerCacheFactory(options, worker_cache);
       });
   worker_env_.compute_pool = ComputePool(sess_opts);
+  if (config.rpc_options().use_shared_memory_tensor_transport()) {
+    tensor_transport_ = SharedMemoryTensorTransport::Create();
+    if (tensor_transport_ == nullptr) {
+      LOG(WARNING) << "Shared memory tensor transport is not supported on "
+                      "this platform.";
+    }
+  }
+  if (config.rpc_options().recv_tensor_chunk_bytes() > 0) {
+    tensor_transport_ = std::make_unique<ChunkedTensorTransport>(
+        config.rpc_options().recv_tensor_chunk_bytes(),
+        std::move(tensor_transport_));
+  }
+  if (!config.rpc_options().tensor_compression().algorithm().empty()) {
+    std::unique_ptr<CompressingTensorTransport> compressing;
+    TF_RETURN_IF_ERROR(CompressingTensorTransport::Create(
+        config.rpc_options().tensor_compression(), worker_env_.compute_pool,
+        std::move(tensor_transport_), &compressing));
+    tensor_transport_ = std::move(compressing);
+  }
+  worker_env_.tensor_transport = tensor_transport_.get();
 
   // Finish setting up master environment.
   master_env_.ops = OpRegistry::Global();
@@ -39,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
@@ -148,6 +149,7 @@ class GrpcWorkerServiceThread {
     SETUP_FOR_REQUEST(RunGraph, 100, true);
     SETUP_FOR_REQUEST(CleanupGraph, 100, false);
     SETUP_FOR_REQUEST(MarkRecvFinished, 10, false);
+    SETUP_FOR_REQUEST(RecvTensorChunk, 100, true);
 
     // TODO(ncteisen): Determine a better policy for enqueuing the
     // appropriate number of each request type.
@@ -239,6 +241,20 @@ class GrpcWorkerServiceThread {
     ENQUEUE_REQUEST(MarkRecvFinished, false);
   }
 
+  void RecvTensorChunkHandler(
+      WorkerCall<RecvTensorChunkRequest, RecvTensorChunkResponse>* call) {
+    Schedule([this, call]() {
+      worker_->RecvTensorChunkAsync(
+          &call->request, &call->response, [call](const Status& s) {
+            if (!s.ok()) {
+              VLOG(3) << "Bad response from RecvTensorChunk: " << s;
+            }
+            call->SendResponse(ToGrpcStatus(s));
+          });
+    });
+    ENQUEUE_REQUEST(RecvTensorChunk, true);
+  }
+
   void RunGraphHandler(WorkerCall<RunGraphRequest, RunGraphResponse>* call) {
     Schedule([this, call]() {
       CallOptions* call_opts = new CallOptions;
@@ -424,7 +440,11 @@ GrpcWorker::GrpcWorker(WorkerEnv* worker_env, const ConfigProto& config)
       recv_buf_max_chunk_(
           config.experimental().recv_buf_max_chunk() > 0
               ? config.experimental().recv_buf_max_chunk()
-              : (config.experimental().recv_buf_max_chunk() < 0 ? 0 : 4096)) {
+              : (config.experimental().recv_buf_max_chunk() < 0 ? 0 : 4096)),
+      response_cache_max_bytes_(
+          config.rpc_options().cache_rpc_response_max_bytes() == 0
+              ? GrpcResponseCache::kDefaultMaxBytes
+              : config.rpc_options().cache_rpc_response_max_bytes()) {
   if (config.rpc_options().cache_rpc_response()) {
     EnableResponseCache();
   }
@@ -432,7 +452,8 @@ GrpcWorker::GrpcWorker(WorkerEnv* worker_env, const ConfigProto& config)
 
 void GrpcWorker::EnableResponseCache() {
   VLOG(3) << "Enabling gRPC tensor response cache.";
-  response_cache_ = absl::make_unique<GrpcResponseCache>();
+  response_cache_ =
+      absl::make_unique<GrpcResponseCache>(response_cache_max_bytes_);
 }
 
 // GrpcRecvTensorAsync: unlike the other Worker methods, which use protocol
@@ -448,11 +469,24 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
 
   bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
 
-  auto do_response = [response, done, cache_enabled](const Tensor& tensor,
-                                                     bool is_dead,
-                                                     const Status& status) {
+  TensorTransport* transport =
+      request->has_transport_options() ? env_->tensor_transport : nullptr;
+  auto do_response = [request, response, done, cache_enabled, transport](
+                         const Tensor& tensor, bool is_dead,
+                         const Status& status) {
     if (status.ok()) {
-      grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
+      RecvTensorResponse transported;
+      if (transport != nullptr && !is_dead &&
+          transport->Send(request->transport_options(), tensor,
+                          transported.mutable_transport_options())) {
+        // Only the metadata goes in the response.
+        transported.set_send_start_micros(Env::Default()->NowMicros());
+        transported.set_require_ack(cache_enabled);
+        grpc::EncodeRecvTensorResponseToByteBuffer(transported, response);
+      } else {
+        grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled,
+                                       response);
+      }
     }
     done(status);
   };
@@ -744,6 +778,18 @@ void GrpcWorker::CleanupGraphAsync(const CleanupGraphRequest* request,
   Worker::CleanupGraphAsync(request, response, done);
 }
 
+void GrpcWorker::RecvTensorChunkAsync(const RecvTensorChunkRequest* request,
+                                      RecvTensorChunkResponse* response,
+                                      StatusCallback done) {
+  if (env_->tensor_transport == nullptr) {
+    done(errors::FailedPrecondition(
+        "RecvTensorChunk requires a tensor transport on the worker"));
+    return;
+  }
+  env_->tensor_transport->RecvTensorChunkAsync(request, response,
+                                               std::move(done));
+}
+
 WorkerEnv* GrpcWorker::env() { return env_; }
 
 void GrpcWorker::RemoveCacheEntryForId(int64_t request_id) {
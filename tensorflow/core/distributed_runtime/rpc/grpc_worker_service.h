@@ -56,6 +56,12 @@ class GrpcWorker : public Worker {
                          CleanupGraphResponse* response,
                          StatusCallback done) override;
 
+  // Serves the chunks of the tensors that `env()->tensor_transport` keeps for
+  // their receivers.
+  void RecvTensorChunkAsync(const RecvTensorChunkRequest* request,
+                            RecvTensorChunkResponse* response,
+                            StatusCallback done) override;
+
   WorkerEnv* env();
 
   void EnableResponseCache();
@@ -65,6 +71,7 @@ class GrpcWorker : public Worker {
  private:
   std::unique_ptr<GrpcResponseCache> response_cache_;
   const int32 recv_buf_max_chunk_;
+  const int64_t response_cache_max_bytes_;
 };
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* worker_env,
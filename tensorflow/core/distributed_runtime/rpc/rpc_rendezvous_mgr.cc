@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/request_id.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/framework/types.h"
@@ -57,7 +58,8 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
 // Used only to retrieve tensors from remote processes.
 class RpcRecvTensorCall : public BaseRecvTensorCall {
  public:
-  RpcRecvTensorCall() : wi_(nullptr), dst_device_(nullptr) {}
+  RpcRecvTensorCall()
+      : wi_(nullptr), dst_device_(nullptr), transport_(nullptr) {}
 
   void Init(WorkerInterface* wi, int64_t step_id, StringPiece key,
             AllocatorAttributes alloc_attrs, Device* dst_device,
@@ -72,6 +74,17 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     req_.set_request_id(GetUniqueRequestId());
   }
 
+  // Asks the sender to send the tensor through `transport` instead of the
+  // response, if both support it.
+  void MaybeUseTransport(TensorTransport* transport) {
+    if (transport != nullptr &&
+        transport->PrepareRecv(src_worker_, req_.rendezvous_key(), dst_device_,
+                               alloc_attrs_,
+                               req_.mutable_transport_options())) {
+      transport_ = transport;
+    }
+  }
+
   void Reset() {
     // The RpcRemoteRendezvous using this object is responsible for calling
     // ReleaseWorker() before Reset().
@@ -80,6 +93,9 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
 
     alloc_attrs_ = AllocatorAttributes();
     dst_device_ = nullptr;
+    transport_ = nullptr;
+    transported_tensor_ = Tensor();
+    use_transported_tensor_ = false;
     // We don't clear opts_ and assume that Init will set up the state for
     // opts_ appropriately.
     req_.Clear();
@@ -123,7 +139,9 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     wi_ = nullptr;
   }
 
-  const Tensor& tensor() const { return resp_.tensor(); }
+  const Tensor& tensor() const {
+    return use_transported_tensor_ ? transported_tensor_ : resp_.tensor();
+  }
 
   bool is_dead() const { return resp_.metadata().is_dead(); }
 
@@ -146,6 +164,20 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
       if (!s.ok()) {
         mutex_lock l(mu_);
         status_.Update(s);
+      } else if (transport_ != nullptr &&
+                 resp_.metadata().has_transport_options()) {
+        // The sender handed the tensor to the transport.
+        use_transported_tensor_ = true;
+        transport_->RecvAsync(resp_.metadata().transport_options(), wi_,
+                              dst_device_, alloc_attrs_, &transported_tensor_,
+                              [this, recv_done](const Status& s) {
+                                if (!s.ok()) {
+                                  mutex_lock l(mu_);
+                                  status_.Update(s);
+                                }
+                                recv_done();
+                              });
+        return;
       }
       recv_done();
     };
@@ -173,9 +205,12 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   WorkerInterface* wi_;  // Not owned.
   AllocatorAttributes alloc_attrs_;
   Device* dst_device_;
+  TensorTransport* transport_;  // Not owned.
   CallOptions opts_;
   RecvTensorRequest req_;
   TensorResponse resp_;
+  Tensor transported_tensor_;
+  bool use_transported_tensor_ = false;
   Rendezvous::Args recv_args_;
   Rendezvous::DoneCallback done_;
 
@@ -271,6 +306,7 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
 
   call->Init(rwi, step_id_, parsed.FullKey(), recv_args.alloc_attrs, dst_device,
              recv_args, std::move(done));
+  call->MaybeUseTransport(env_->tensor_transport);
 
   // Record "call" in active_ so that it can be aborted cleanly.
   RegisterCall(call, recv_args);
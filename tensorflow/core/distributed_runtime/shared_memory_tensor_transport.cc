@@ -0,0 +1,275 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/shared_memory_tensor_transport.h"
+
+#include "tensorflow/core/platform/platform.h"
+
+#if !defined(PLATFORM_WINDOWS)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // !defined(PLATFORM_WINDOWS)
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+
+namespace tensorflow {
+
+#if !defined(PLATFORM_WINDOWS)
+namespace {
+
+// The buffer of a received tensor, mapped from a shared memory object.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(void* data, size_t size)
+      : TensorBuffer(data), size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocated_bytes(size_);
+    proto->set_allocator_name("SharedMemoryTensorTransport");
+  }
+
+ private:
+  ~MappedTensorBuffer() override { munmap(data(), size_); }
+
+  const size_t size_;
+};
+
+// Identifies the host by its name and boot, and its shared memory file
+// system, which differs between containers without a shared IPC namespace.
+string GetHostId() {
+  string host_id = port::Hostname();
+  string boot_id;
+  if (ReadFileToString(Env::Default(), "/proc/sys/kernel/random/boot_id",
+                       &boot_id)
+          .ok()) {
+    strings::StrAppend(&host_id, "/", boot_id);
+  }
+  struct stat shm_stat;
+  if (stat("/dev/shm", &shm_stat) == 0) {
+    strings::StrAppend(&host_id, "/", shm_stat.st_dev, ":", shm_stat.st_ino);
+  }
+  return host_id;
+}
+
+}  // namespace
+
+std::unique_ptr<SharedMemoryTensorTransport>
+SharedMemoryTensorTransport::Create(int64_t min_bytes,
+                                    int64_t stale_object_secs) {
+  return std::unique_ptr<SharedMemoryTensorTransport>(
+      new SharedMemoryTensorTransport(GetHostId(), min_bytes,
+                                      stale_object_secs));
+}
+
+SharedMemoryTensorTransport::SharedMemoryTensorTransport(
+    string host_id, int64_t min_bytes, int64_t stale_object_secs)
+    : host_id_(std::move(host_id)),
+      // Empty objects can't be mapped.
+      min_bytes_(std::max<int64_t>(min_bytes, 1)),
+      stale_object_secs_(stale_object_secs) {}
+
+SharedMemoryTensorTransport::~SharedMemoryTensorTransport() {
+  UnlinkObjectsCreatedBefore(kuint64max);
+}
+
+void SharedMemoryTensorTransport::UnlinkObjectsCreatedBefore(
+    uint64 cutoff_micros) {
+  mutex_lock l(mu_);
+  while (!objects_.empty() && objects_.front().second < cutoff_micros) {
+    // Usually the receiver has unlinked the object already.
+    shm_unlink(objects_.front().first.c_str());
+    objects_.pop_front();
+  }
+}
+
+bool SharedMemoryTensorTransport::PrepareRecv(
+    const string& src_worker, StringPiece rendezvous_key,
+    const Device* dst_device, const AllocatorAttributes& alloc_attrs,
+    ::google::protobuf::Any* options) {
+  if (!alloc_attrs.on_host() && dst_device->device_type() != DEVICE_CPU) {
+    return false;
+  }
+  SharedMemoryRecvOptions recv_options;
+  recv_options.set_host_id(host_id_);
+  options->PackFrom(recv_options);
+  return true;
+}
+
+bool SharedMemoryTensorTransport::Send(
+    const ::google::protobuf::Any& request_options, const Tensor& val,
+    ::google::protobuf::Any* response_options) {
+  SharedMemoryRecvOptions recv_options;
+  if (!request_options.UnpackTo(&recv_options) ||
+      recv_options.host_id() != host_id_ ||
+      !DataTypeCanUseMemcpy(val.dtype()) || val.TotalBytes() < min_bytes_) {
+    return false;
+  }
+  const uint64 now_micros = Env::Default()->NowMicros();
+  UnlinkObjectsCreatedBefore(now_micros - stale_object_secs_ * 1000000);
+
+  string name;
+  {
+    mutex_lock l(mu_);
+    name = strings::StrCat("/tf_", getpid(), "_", next_object_id_++);
+  }
+  const size_t size = val.TotalBytes();
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    LOG_EVERY_N(WARNING, 1000)
+        << "Could not create shared memory object " << name << ": "
+        << strerror(errno) << ". Sending tensors over RPC.";
+    return false;
+  }
+  void* data = MAP_FAILED;
+  if (ftruncate(fd, size) == 0) {
+    data = mmap(nullptr, size, PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG_EVERY_N(WARNING, 1000)
+        << "Could not map shared memory object " << name << ": "
+        << strerror(errno) << ". Sending tensors over RPC.";
+    shm_unlink(name.c_str());
+    return false;
+  }
+  std::memcpy(data, val.tensor_data().data(), size);
+  munmap(data, size);
+
+  {
+    mutex_lock l(mu_);
+    objects_.emplace_back(name, now_micros);
+  }
+  SharedMemoryTensorLocation location;
+  location.set_name(name);
+  location.set_dtype(val.dtype());
+  val.shape().AsProto(location.mutable_shape());
+  response_options->PackFrom(location);
+  return true;
+}
+
+void SharedMemoryTensorTransport::RecvAsync(
+    const ::google::protobuf::Any& response_options,
+    WorkerInterface* src_worker, Device* dst_device,
+    const AllocatorAttributes& alloc_attrs, Tensor* val, StatusCallback done) {
+  SharedMemoryTensorLocation location;
+  if (!response_options.UnpackTo(&location)) {
+    done(errors::Internal("Invalid shared memory tensor location: ",
+                          response_options.DebugString()));
+    return;
+  }
+  TensorShape shape;
+  Status s = TensorShape::BuildTensorShape(location.shape(), &shape);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+  if (!DataTypeCanUseMemcpy(location.dtype())) {
+    done(errors::Internal("Unexpected shared memory tensor of type ",
+                          DataTypeString(location.dtype())));
+    return;
+  }
+  const size_t size = shape.num_elements() * DataTypeSize(location.dtype());
+
+  const int fd = shm_open(location.name().c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    done(errors::Internal("Could not open shared memory object ",
+                          location.name(), ": ", strerror(errno)));
+    return;
+  }
+  shm_unlink(location.name().c_str());
+  struct stat object_stat;
+  if (fstat(fd, &object_stat) != 0 || object_stat.st_size < size) {
+    close(fd);
+    done(errors::Internal("Shared memory object ", location.name(),
+                          " is smaller than its tensor of ", size, " bytes"));
+    return;
+  }
+  // Private, so that ops that modify the tensor in place don't write to the
+  // object.
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    done(errors::Internal("Could not map shared memory object ",
+                          location.name(), ": ", strerror(errno)));
+    return;
+  }
+  MappedTensorBuffer* buffer = new MappedTensorBuffer(data, size);
+  core::ScopedUnref unref(buffer);
+  Tensor mapped(location.dtype(), shape, buffer);
+
+  if (alloc_attrs.gpu_compatible() || dst_device->device_type() != DEVICE_CPU) {
+    // The destination needs memory of its own allocator.
+    Tensor copy(dst_device->GetAllocator(alloc_attrs), location.dtype(),
+                shape);
+    std::memcpy(const_cast<char*>(copy.tensor_data().data()),
+                mapped.tensor_data().data(), size);
+    *val = std::move(copy);
+  } else {
+    *val = std::move(mapped);
+  }
+  done(Status::OK());
+}
+
+#else
+
+std::unique_ptr<SharedMemoryTensorTransport>
+SharedMemoryTensorTransport::Create(int64_t min_bytes,
+                                    int64_t stale_object_secs) {
+  return nullptr;
+}
+
+SharedMemoryTensorTransport::~SharedMemoryTensorTransport() {}
+
+bool SharedMemoryTensorTransport::PrepareRecv(
+    const string& src_worker, StringPiece rendezvous_key,
+    const Device* dst_device, const AllocatorAttributes& alloc_attrs,
+    ::google::protobuf::Any* options) {
+  return false;
+}
+
+bool SharedMemoryTensorTransport::Send(
+    const ::google::protobuf::Any& request_options, const Tensor& val,
+    ::google::protobuf::Any* response_options) {
+  return false;
+}
+
+void SharedMemoryTensorTransport::RecvAsync(
+    const ::google::protobuf::Any& response_options,
+    WorkerInterface* src_worker, Device* dst_device,
+    const AllocatorAttributes& alloc_attrs, Tensor* val, StatusCallback done) {
+  done(errors::Unimplemented("Shared memory tensors are not supported"));
+}
+
+#endif  // !defined(PLATFORM_WINDOWS)
+
+}  // namespace tensorflow
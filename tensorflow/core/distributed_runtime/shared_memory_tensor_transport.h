@@ -0,0 +1,94 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARED_MEMORY_TENSOR_TRANSPORT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARED_MEMORY_TENSOR_TRANSPORT_H_
+
+#include <deque>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/distributed_runtime/tensor_transport.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// A TensorTransport between workers on the same host, which share the
+// content of tensors through POSIX shared memory objects.
+//
+// The sender copies the tensor into a new object, so the memory of the
+// tensor is released as usual, and the receiver maps the object as the
+// buffer of the received tensor, without copying it again unless the tensor
+// must come from the allocator of the destination, e.g. GPU-compatible host
+// memory. Only tensors of types that can be memcpy'd and of at least
+// `min_bytes` bytes use the transport.
+//
+// The receiver unlinks each object once it has mapped it. The sender unlinks
+// those that are still linked after `stale_object_secs`, in case their RPC
+// failed, and when it is destroyed. Objects are only accessible to the user
+// that runs the workers.
+class SharedMemoryTensorTransport : public TensorTransport {
+ public:
+  static constexpr int64_t kDefaultMinBytes = 64 << 10;
+  static constexpr int64_t kDefaultStaleObjectSecs = 300;
+
+  // Returns nullptr if the platform has no POSIX shared memory.
+  static std::unique_ptr<SharedMemoryTensorTransport> Create(
+      int64_t min_bytes = kDefaultMinBytes,
+      int64_t stale_object_secs = kDefaultStaleObjectSecs);
+
+  ~SharedMemoryTensorTransport() override;
+
+  bool PrepareRecv(const string& src_worker, StringPiece rendezvous_key,
+                   const Device* dst_device,
+                   const AllocatorAttributes& alloc_attrs,
+                   ::google::protobuf::Any* options) override;
+
+  bool Send(const ::google::protobuf::Any& request_options, const Tensor& val,
+            ::google::protobuf::Any* response_options) override;
+
+  void RecvAsync(const ::google::protobuf::Any& response_options,
+                 WorkerInterface* src_worker, Device* dst_device,
+                 const AllocatorAttributes& alloc_attrs, Tensor* val,
+                 StatusCallback done) override;
+
+  // Identifies this host and its shared memory file system.
+  const string& host_id() const { return host_id_; }
+
+ private:
+  SharedMemoryTensorTransport(string host_id, int64_t min_bytes,
+                              int64_t stale_object_secs);
+
+  // Unlinks the objects created before `cutoff_micros`.
+  void UnlinkObjectsCreatedBefore(uint64 cutoff_micros);
+
+  const string host_id_;
+  const int64_t min_bytes_;
+  const int64_t stale_object_secs_;
+
+  mutex mu_;
+  int64_t next_object_id_ TF_GUARDED_BY(mu_) = 0;
+  // Names and creation times of the objects that the receivers may not have
+  // unlinked yet, oldest first.
+  std::deque<std::pair<string, uint64>> objects_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedMemoryTensorTransport);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARED_MEMORY_TENSOR_TRANSPORT_H_
@@ -0,0 +1,193 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/shared_memory_tensor_transport.h"
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+
+namespace tensorflow {
+namespace {
+
+class FakeDevice : public Device {
+ public:
+  explicit FakeDevice(const string& type)
+      : Device(nullptr, MakeAttributes(type)) {}
+  Status Sync() override { return Status::OK(); }
+  Allocator* GetAllocator(AllocatorAttributes) override {
+    return cpu_allocator();
+  }
+
+ private:
+  static DeviceAttributes MakeAttributes(const string& type) {
+    DeviceAttributes attr;
+    attr.set_name(strings::StrCat("/job:worker/replica:0/task:0/device:", type,
+                                  ":0"));
+    attr.set_device_type(type);
+    return attr;
+  }
+};
+
+class SharedMemoryTensorTransportTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    transport_ = SharedMemoryTensorTransport::Create(/*min_bytes=*/16);
+    if (transport_ == nullptr) {
+      GTEST_SKIP() << "No POSIX shared memory";
+    }
+  }
+
+  // Runs the receiver and the sender sides of a RecvTensor call of `val`.
+  Status Transfer(const Tensor& val, const AllocatorAttributes& alloc_attrs,
+                  Tensor* received, bool* transported) {
+    ::google::protobuf::Any request_options;
+    if (!transport_->PrepareRecv("/job:worker/replica:0/task:1", "key", &cpu_,
+                                 alloc_attrs, &request_options)) {
+      return errors::FailedPrecondition("PrepareRecv() declined");
+    }
+    ::google::protobuf::Any response_options;
+    *transported = transport_->Send(request_options, val, &response_options);
+    if (!*transported) return Status::OK();
+    Status status;
+    transport_->RecvAsync(response_options, /*src_worker=*/nullptr, &cpu_,
+                          alloc_attrs, received,
+                          [&status](const Status& s) { status = s; });
+    return status;
+  }
+
+  std::unique_ptr<SharedMemoryTensorTransport> transport_;
+  FakeDevice cpu_{DEVICE_CPU};
+};
+
+TEST_F(SharedMemoryTensorTransportTest, TransfersTensor) {
+  Tensor val(DT_FLOAT, TensorShape({64, 32}));
+  test::FillIota<float>(&val, 1.0f);
+  Tensor received;
+  bool transported;
+  TF_ASSERT_OK(Transfer(val, AllocatorAttributes(), &received, &transported));
+  ASSERT_TRUE(transported);
+  test::ExpectTensorEqual<float>(received, val);
+
+  // The received tensor can be modified without affecting the sender.
+  received.flat<float>()(0) = -1.0f;
+  EXPECT_EQ(val.flat<float>()(0), 1.0f);
+}
+
+TEST_F(SharedMemoryTensorTransportTest, CopiesIntoGpuCompatibleMemory) {
+  Tensor val(DT_INT32, TensorShape({100}));
+  test::FillIota<int32>(&val, 0);
+  AllocatorAttributes alloc_attrs;
+  alloc_attrs.set_on_host(true);
+  alloc_attrs.set_gpu_compatible(true);
+  Tensor received;
+  bool transported;
+  TF_ASSERT_OK(Transfer(val, alloc_attrs, &received, &transported));
+  ASSERT_TRUE(transported);
+  test::ExpectTensorEqual<int32>(received, val);
+}
+
+TEST_F(SharedMemoryTensorTransportTest, ReceiverUnlinksObject) {
+  Tensor val(DT_FLOAT, TensorShape({16}));
+  test::FillIota<float>(&val, 0.0f);
+  ::google::protobuf::Any request_options;
+  ASSERT_TRUE(transport_->PrepareRecv("", "key", &cpu_, AllocatorAttributes(),
+                                      &request_options));
+  ::google::protobuf::Any response_options;
+  ASSERT_TRUE(transport_->Send(request_options, val, &response_options));
+
+  Tensor received;
+  Status status;
+  auto done = [&status](const Status& s) { status = s; };
+  transport_->RecvAsync(response_options, /*src_worker=*/nullptr, &cpu_,
+                        AllocatorAttributes(), &received, done);
+  TF_EXPECT_OK(status);
+  transport_->RecvAsync(response_options, /*src_worker=*/nullptr, &cpu_,
+                        AllocatorAttributes(), &received, done);
+  EXPECT_FALSE(status.ok());
+}
+
+TEST_F(SharedMemoryTensorTransportTest, SmallAndStringTensorsUseResponse) {
+  Tensor received;
+  bool transported;
+  TF_ASSERT_OK(Transfer(test::AsTensor<float>({1.0f, 2.0f}),
+                        AllocatorAttributes(), &received, &transported));
+  EXPECT_FALSE(transported);
+
+  Tensor strings(DT_STRING, TensorShape({100}));
+  TF_ASSERT_OK(
+      Transfer(strings, AllocatorAttributes(), &received, &transported));
+  EXPECT_FALSE(transported);
+}
+
+TEST_F(SharedMemoryTensorTransportTest, OtherHostsUseResponse) {
+  SharedMemoryRecvOptions recv_options;
+  recv_options.set_host_id("another host");
+  ::google::protobuf::Any request_options;
+  request_options.PackFrom(recv_options);
+  ::google::protobuf::Any response_options;
+  EXPECT_FALSE(transport_->Send(request_options,
+                                Tensor(DT_FLOAT, TensorShape({1024})),
+                                &response_options));
+}
+
+TEST_F(SharedMemoryTensorTransportTest, DeviceMemoryUsesResponse) {
+  FakeDevice gpu(DEVICE_GPU);
+  ::google::protobuf::Any request_options;
+  EXPECT_FALSE(transport_->PrepareRecv("", "key", &gpu, AllocatorAttributes(),
+                                       &request_options));
+  AllocatorAttributes on_host;
+  on_host.set_on_host(true);
+  EXPECT_TRUE(transport_->PrepareRecv("", "key", &gpu, on_host,
+                                      &request_options));
+}
+
+TEST(SharedMemoryTensorTransport, UnlinksStaleObjects) {
+  auto transport = SharedMemoryTensorTransport::Create(
+      /*min_bytes=*/1, /*stale_object_secs=*/0);
+  if (transport == nullptr) GTEST_SKIP() << "No POSIX shared memory";
+  FakeDevice cpu(DEVICE_CPU);
+  ::google::protobuf::Any request_options;
+  ASSERT_TRUE(transport->PrepareRecv("", "key", &cpu, AllocatorAttributes(),
+                                     &request_options));
+  const Tensor val = test::AsTensor<float>({1.0f, 2.0f});
+  ::google::protobuf::Any stale_options;
+  ASSERT_TRUE(transport->Send(request_options, val, &stale_options));
+  Env::Default()->SleepForMicroseconds(1000);
+  ::google::protobuf::Any fresh_options;
+  ASSERT_TRUE(transport->Send(request_options, val, &fresh_options));
+
+  Tensor received;
+  Status status;
+  transport->RecvAsync(stale_options, /*src_worker=*/nullptr, &cpu,
+                       AllocatorAttributes(), &received,
+                       [&status](const Status& s) { status = s; });
+  EXPECT_FALSE(status.ok());
+  transport->RecvAsync(fresh_options, /*src_worker=*/nullptr, &cpu,
+                       AllocatorAttributes(), &received,
+                       [&status](const Status& s) { status = s; });
+  TF_EXPECT_OK(status);
+  test::ExpectTensorEqual<float>(received, val);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,90 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_TRANSPORT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_TRANSPORT_H_
+
+#include "google/protobuf/any.pb.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+
+class Device;
+class WorkerInterface;
+
+// A data path for the content of the tensors of RecvTensor calls that
+// bypasses the RPC system, e.g. shared memory between workers on the same
+// host, or RDMA into registered memory. The RecvTensor RPC stays the control
+// plane:
+//
+// 1. The receiver calls PrepareRecv() to describe in
+//    RecvTensorRequest::transport_options how it can accept the tensor.
+// 2. The sender passes these options and the tensor to Send(). If Send()
+//    accepts them, the response only carries the options that Send()
+//    returns, in RecvTensorResponse::transport_options, instead of the
+//    tensor.
+// 3. The receiver passes these options to RecvAsync() to get the tensor.
+//
+// Whenever either side declines, e.g. because the workers are on different
+// hosts or the tensor is small, the tensor is encoded in the RPC response as
+// usual. Implementations must be thread-safe.
+class TensorTransport {
+ public:
+  virtual ~TensorTransport() {}
+
+  // Receiver side. Returns true and fills `options` if the tensor of a
+  // RecvTensor call of `rendezvous_key` from `src_worker` to `dst_device`,
+  // allocated with `alloc_attrs`, may come through this transport.
+  virtual bool PrepareRecv(const string& src_worker,
+                           StringPiece rendezvous_key, const Device* dst_device,
+                           const AllocatorAttributes& alloc_attrs,
+                           ::google::protobuf::Any* options) = 0;
+
+  // Sender side. `val` is the requested tensor, in host memory and not dead.
+  // Returns true and fills `response_options` if its content was handed to
+  // this transport, or false if it has to be encoded in the response.
+  virtual bool Send(const ::google::protobuf::Any& request_options,
+                    const Tensor& val,
+                    ::google::protobuf::Any* response_options) = 0;
+
+  // Receiver side. Gets the tensor that Send() described in
+  // `response_options` into `*val`, for `dst_device` and `alloc_attrs` as
+  // given to PrepareRecv(), and runs `done`. `src_worker` served the
+  // RecvTensor call, for transports that fetch the content from it.
+  virtual void RecvAsync(const ::google::protobuf::Any& response_options,
+                         WorkerInterface* src_worker, Device* dst_device,
+                         const AllocatorAttributes& alloc_attrs, Tensor* val,
+                         StatusCallback done) = 0;
+
+  // Sender side. Serves a RecvTensorChunk call for content that Send() kept
+  // for the receiver to fetch. Only implemented by such transports, and by
+  // those that delegate to them.
+  virtual void RecvTensorChunkAsync(const RecvTensorChunkRequest* request,
+                                    RecvTensorChunkResponse* response,
+                                    StatusCallback done) {
+    done(errors::Unimplemented("RecvTensorChunk is not supported by this "
+                               "tensor transport"));
+  }
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_TRANSPORT_H_
@@ -31,6 +31,7 @@ class DeviceMgr;
 class Env;
 class RendezvousMgrInterface;
 class SessionMgr;
+class TensorTransport;
 
 // The worker environment class, which holds a bag of pointers to
 // per-worker singletons.
@@ -64,6 +65,10 @@ struct WorkerEnv {
 
   // A pool of threads for scheduling compute work.
   thread::ThreadPool* compute_pool = nullptr;
+
+  // If set, the data path for the tensors of RecvTensor calls between workers
+  // that both support it, bypassing the RPC system. Not owned.
+  TensorTransport* tensor_transport = nullptr;
 };
 
 }  // end namespace tensorflow
@@ -129,6 +129,15 @@ class WorkerInterface {
                                     GetStepSequenceResponse* response,
                                     StatusCallback done) = 0;
 
+  // Fetches a part of a tensor that the worker kept for a RecvTensor call,
+  // for tensor transports that send large tensors in chunks. Only
+  // implemented by the gRPC workers.
+  virtual void RecvTensorChunkAsync(const RecvTensorChunkRequest* request,
+                                    RecvTensorChunkResponse* response,
+                                    StatusCallback done) {
+    done(errors::Unimplemented("RecvTensorChunkAsync()"));
+  }
+
   Status GetStatus(const GetStatusRequest* request,
                    GetStatusResponse* response) {
     Status ret;
@@ -381,6 +381,11 @@ class SubAllocator {
   // returned by this allocator.
   virtual bool SupportsCoalescing() const = 0;
 
+  // Returns the alignment of the parts of the memory returned by Alloc() that
+  // may be passed to Free() on their own, or 0 if Free() may only be called on
+  // whole allocations.
+  virtual size_t FreeRangeAlignment() const { return 0; }
+
  protected:
   // Implementation of Alloc() method must call this on newly allocated
   // value.
@@ -153,8 +153,8 @@ Status ValidateEinsumEllipsis(absl::string_view subscript,
 }  // namespace
 
 Status EinsumShape(shape_inference::InferenceContext* c) {
-  // We assume that the equation has a valid format. Either (x),(y)->(z)
-  // or (x)->(z), where each of (x), (y) and (z) are concatenation of zero or
+  // We assume that the equation has a valid format, (x),(y),...->(z) with one
+  // or more inputs, where each of (x), (y) and (z) are concatenation of zero or
   // more latin alphabets and contains at most one ellipsis ('...').
   string equation;
   TF_RETURN_IF_ERROR(c->GetAttr("equation", &equation));
@@ -163,8 +163,8 @@ Status EinsumShape(shape_inference::InferenceContext* c) {
   TF_RETURN_IF_ERROR(
       ParseEinsumEquation(equation, &input_labels, &output_labels));
 
-  if (c->num_inputs() == 0 || c->num_inputs() > 2) {
-    return errors::InvalidArgument("Expected either 1 or 2 inputs but got: ",
+  if (c->num_inputs() == 0) {
+    return errors::InvalidArgument("Expected at least 1 input but got: ",
                                    c->num_inputs());
   }
   const int input_labels_size = input_labels.size();
@@ -248,15 +248,12 @@ Status EinsumShape(shape_inference::InferenceContext* c) {
     }
   }
 
-  // For two inputs, broadcast the two input broadcast shapes to create the
-  // output broadcast shape. For one input, just copy the single broadcast
-  // shape.
-  ShapeHandle output_bcast_shape;
-  if (input_bcast_shapes.size() == 1) {
-    output_bcast_shape = input_bcast_shapes[0];
-  } else if (input_bcast_shapes.size() == 2) {
+  // Broadcast the input broadcast shapes together to create the output
+  // broadcast shape. For one input, just copy the single broadcast shape.
+  ShapeHandle output_bcast_shape = input_bcast_shapes[0];
+  for (int i = 1; i < input_bcast_shapes.size(); ++i) {
     TF_RETURN_IF_ERROR(BroadcastBinaryOpOutputShapeFnHelper(
-        c, input_bcast_shapes[0], input_bcast_shapes[1], true,
+        c, output_bcast_shape, input_bcast_shapes[i], true,
         &output_bcast_shape));
   }
 
@@ -255,6 +255,12 @@ TEST(CommonShapeFnsTest, Einsum_ShapeFn) {
   set_equation(2, ",abcd->badc");
   INFER_OK(op, "[];[?,?,?,?]", "[d1_1,d1_0,d1_3,d1_2]");
 
+  // More than two inputs.
+  set_equation(3, "ab,bc,cd->ad");
+  INFER_OK(op, "[?,?];[?,?];[?,?]", "[d0_0,d2_1]");
+  set_equation(3, "...ab,...bc,c->...a");
+  INFER_OK(op, "[?,?,?];[1,?,?];[?]", "[d0_0,d0_1]");
+
   // Ellipsis cases.
   set_equation(1, "a...bc->c...");
   INFER_OK(op, "[?,?,?,?,?]", "[d0_4,d0_1,d0_2]");
@@ -886,6 +886,7 @@ Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
                              profiler::TraceMeLevel::kInfo);
   DVLOG(3) << prefix() << " GetNext enter";
   auto model = ctx->model();
+  int64_t start_nanos = 0;
   if (collect_resource_usage(ctx)) {
     int64_t now_nanos = EnvTime::NowNanos();
     auto output = node_->output();
@@ -893,6 +894,7 @@ Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
       output->record_stop(now_nanos);
     }
     node_->record_start(now_nanos);
+    start_nanos = now_nanos;
   }
   out_tensors->clear();
   Status s = GetNextInternal(ctx, out_tensors, end_of_sequence);
@@ -906,6 +908,9 @@ Status DatasetBaseIterator::GetNext(IteratorContext* ctx,
   }
   if (collect_resource_usage(ctx)) {
     int64_t now_nanos = EnvTime::NowNanos();
+    node_->record_getnext_latency(
+        (now_nanos - start_nanos) /
+        static_cast<int64_t>(EnvTime::kMicrosToNanos));
     node_->record_stop(now_nanos);
     auto output = node_->output();
     if (output) {
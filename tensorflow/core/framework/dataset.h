@@ -658,6 +658,13 @@ class SerializationContext {
 
     // The name of the device doing the serialization.
     std::string device_name;
+
+    // If non-empty, iterators with large buffers may save their buffers
+    // incrementally to files in this directory: a save then writes only the
+    // buffer entries modified since the previous save, together with the list
+    // of files needed to reconstruct the buffer. The files are not garbage
+    // collected and must outlive the checkpoints that reference them.
+    std::string incremental_checkpoint_dir;
   };
 
   explicit SerializationContext(Params params) : params_(params) {}
@@ -676,6 +683,10 @@ class SerializationContext {
 
   const std::string& device_name() const { return params_.device_name; }
 
+  const std::string& incremental_checkpoint_dir() const {
+    return params_.incremental_checkpoint_dir;
+  }
+
  private:
   Params params_;
 
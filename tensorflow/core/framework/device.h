@@ -31,6 +31,7 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/control_flow.h"
@@ -151,6 +152,15 @@ class Device : public DeviceBase {
     return Status::OK();
   }
 
+  // Sets `device_contexts` to the DeviceContext* to execute each node of
+  // `graph` with, indexed by node id, for devices that run ops on several
+  // streams. Leaves it empty if all nodes use the context of
+  // TryGetDeviceContext(). The contexts are owned by the device.
+  virtual Status AssignDeviceContexts(
+      const Graph& graph, std::vector<DeviceContext*>* device_contexts) {
+    return Status::OK();
+  }
+
   // Returns the op segment of this device.  The caller can reuse op
   // kernels registered for the same session running on this device.
   OpSegment* op_segment() { return &op_seg_; }
@@ -1819,7 +1819,8 @@ string FunctionLibraryRuntime::Options::DebugString() const {
       " cancellation_manager=", IsSet(cancellation_manager),
       " collective_executor=", IsSet(collective_executor),
       " step_container=", IsSet(step_container),
-      " stats_collector=", IsSet(stats_collector), " runner=", IsSet(runner),
+      " stats_collector=", IsSet(stats_collector),
+      " request_cost=", IsSet(request_cost), " runner=", IsSet(runner),
       " remote_execution=", remote_execution, " source_device=", source_device,
       " create_rendezvous=", create_rendezvous,
       " allow_dead_tensors=", allow_dead_tensors,
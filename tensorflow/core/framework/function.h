@@ -60,6 +60,7 @@ class ResourceMgr;
 class Rendezvous;
 class ScopedStepContainer;
 class StepStatsCollectorInterface;
+class RequestCost;
 class Node;
 
 // FunctionDefHelper::Create is a convenient helper to construct a
@@ -307,6 +308,16 @@ class CallFrameInterface {
   virtual bool CanConsumeArg(int index) const { return false; }
 
   virtual Status SetRetval(int index, const Tensor& val) = 0;
+
+  // Optionally provides a caller-owned buffer for the return value at
+  // `index`. If this returns true, `*val` aliases a buffer of the given type
+  // and shape, into which the kernel producing the return value may write the
+  // value directly, before passing a tensor that shares the buffer with `*val`
+  // to `SetRetval()`.
+  virtual bool GetRetvalBuffer(int index, DataType dtype,
+                               const TensorShape& shape, Tensor* val) {
+    return false;
+  }
 };
 
 // Represents a function call frame. I.e., the data structure used to
@@ -785,6 +796,13 @@ class FunctionLibraryRuntime {
   // Returns the return types for the function identified by handle `h`.
   virtual Status GetRetTypes(Handle h, DataTypeVector* ret_types) = 0;
 
+  // Returns true if the function identified by `handle` runs entirely on the
+  // device of this runtime: it was instantiated for it, or it is a
+  // multi-device function whose only component is placed on it. Running such
+  // a function with a `CallFrameInterface` passes its arguments and return
+  // values to its executor directly, without a rendezvous.
+  virtual bool IsSingleComponentOnDevice(Handle handle) = 0;
+
   // Asynchronously invokes the instantiated function identified by
   // "handle".
   //
@@ -817,6 +835,9 @@ class FunctionLibraryRuntime {
     ScopedStepContainer* step_container = nullptr;
     StepStatsCollectorInterface* stats_collector = nullptr;
     CoordinationServiceAgent* coordination_service_agent = nullptr;
+    // If not null, the time spent in the kernels of the function is recorded
+    // there, see Executor::Args::request_cost.
+    RequestCost* request_cost = nullptr;
 
     std::function<void(std::function<void()>)>* runner = nullptr;
 
@@ -96,9 +96,19 @@ void LocalRendezvous::ItemQueue::push_back(Item* item) {
   }
 }
 
+constexpr int LocalRendezvous::kNumShards;
+
 LocalRendezvous::~LocalRendezvous() {
-  if (!table_.empty()) {
-    StartAbort(errors::Cancelled("LocalRendezvous deleted"));
+  for (Shard& shard : shards_) {
+    bool empty;
+    {
+      mutex_lock l(shard.mu);
+      empty = shard.table.empty();
+    }
+    if (!empty) {
+      StartAbort(errors::Cancelled("LocalRendezvous deleted"));
+      break;
+    }
   }
 }
 
@@ -122,15 +132,16 @@ Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
         ->IncrementBy(1);
   }
 
-  mu_.lock();
-  if (!status_.ok()) {
+  Shard* shard = GetShard(key_hash);
+  shard->mu.lock();
+  if (!shard->status.ok()) {
     // Rendezvous has been aborted.
-    Status s = status_;
-    mu_.unlock();
+    Status s = shard->status;
+    shard->mu.unlock();
     return s;
   }
 
-  ItemQueue* queue = &table_[key_hash];
+  ItemQueue* queue = &shard->table[key_hash];
   if (queue->head == nullptr || queue->head->type == Item::kSend) {
     // There is no waiter for this message. Append the message
     // into the queue. The waiter will pick it up when arrives.
@@ -139,7 +150,7 @@ Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
     // the lock.
     DVLOG(2) << "Enqueue Send Item (key:" << key.FullKey() << "). ";
     queue->push_back(new Item(send_args, val, is_dead));
-    mu_.unlock();
+    shard->mu.unlock();
     return Status::OK();
   }
 
@@ -150,11 +161,11 @@ Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
   // Delete the queue when the last element has been consumed.
   if (item->next == nullptr) {
     DVLOG(2) << "Clean up Send/Recv queue (key:" << key.FullKey() << "). ";
-    table_.erase(key_hash);
+    shard->table.erase(key_hash);
   } else {
     queue->head = item->next;
   }
-  mu_.unlock();
+  shard->mu.unlock();
 
   // Notify the waiter by invoking its done closure, outside the
   // lock.
@@ -170,16 +181,17 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
   uint64 key_hash = KeyHash(key.FullKey());
   DVLOG(2) << "Recv " << this << " " << key_hash << " " << key.FullKey();
 
-  mu_.lock();
-  if (!status_.ok()) {
+  Shard* shard = GetShard(key_hash);
+  shard->mu.lock();
+  if (!shard->status.ok()) {
     // Rendezvous has been aborted.
-    Status s = status_;
-    mu_.unlock();
+    Status s = shard->status;
+    shard->mu.unlock();
     done(s, Rendezvous::Args(), recv_args, Tensor(), false);
     return;
   }
 
-  ItemQueue* queue = &table_[key_hash];
+  ItemQueue* queue = &shard->table[key_hash];
   if (queue->head == nullptr || queue->head->type == Item::kRecv) {
     // There is no message to pick up.
     // Only recv-related fields need to be filled.
@@ -205,8 +217,9 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
       already_cancelled = !cm->RegisterCallback(token, [this, token, key_hash] {
         Item* item = nullptr;
         {
-          mutex_lock l(mu_);
-          ItemQueue* queue = &table_[key_hash];
+          Shard* shard = GetShard(key_hash);
+          mutex_lock l(shard->mu);
+          ItemQueue* queue = &shard->table[key_hash];
           // Find an item in the queue with a cancellation token that matches
           // `token`, and remove it.
           if (queue->head != nullptr && queue->head->type == Item::kRecv) {
@@ -217,7 +230,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
                 if (queue->head->next == nullptr) {
                   // We have a single-element queue, so we can erase it from
                   // the table.
-                  table_.erase(key_hash);
+                  shard->table.erase(key_hash);
                 } else {
                   // Remove the current item from the queue.
                   if (curr == queue->head) {
@@ -249,7 +262,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
       });
     }
     if (already_cancelled) {
-      mu_.unlock();
+      shard->mu.unlock();
       // Unref case (2)
       if (rc_owner_) rc_owner_->Unref();
       done(StatusGroup::MakeDerived(
@@ -286,7 +299,7 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
       queue->push_back(new Item(recv_args, std::move(done), token));
     }
 
-    mu_.unlock();
+    shard->mu.unlock();
     return;
   }
 
@@ -298,11 +311,11 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
   // Delete the queue when the last element has been consumed.
   if (item->next == nullptr) {
     DVLOG(2) << "Clean up Send/Recv queue (key:" << key.FullKey() << "). ";
-    table_.erase(key_hash);
+    shard->table.erase(key_hash);
   } else {
     queue->head = item->next;
   }
-  mu_.unlock();
+  shard->mu.unlock();
 
   // Invoke done() without holding the table lock.
   DCHECK_EQ(item->type, Item::kSend);
@@ -313,22 +326,30 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
 
 void LocalRendezvous::StartAbort(const Status& status) {
   CHECK(!status.ok());
-  Table table;
+  Status first_status;
   {
     mutex_lock l(mu_);
     status_.Update(status);
-    table_.swap(table);
+    first_status = status_;
   }
-  for (auto& p : table) {
-    Item* item = p.second.head;
-    while (item != nullptr) {
-      if (item->type == Item::kRecv) {
-        (*item->recv_state.waiter)(status, Rendezvous::Args(),
-                                   Rendezvous::Args(), Tensor(), false);
+  for (Shard& shard : shards_) {
+    Table table;
+    {
+      mutex_lock l(shard.mu);
+      shard.status.Update(first_status);
+      shard.table.swap(table);
+    }
+    for (auto& p : table) {
+      Item* item = p.second.head;
+      while (item != nullptr) {
+        if (item->type == Item::kRecv) {
+          (*item->recv_state.waiter)(status, Rendezvous::Args(),
+                                     Rendezvous::Args(), Tensor(), false);
+        }
+        Item* to_delete = item;
+        item = item->next;
+        delete to_delete;
       }
-      Item* to_delete = item;
-      item = item->next;
-      delete to_delete;
     }
   }
 }
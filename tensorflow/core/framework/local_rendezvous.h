@@ -16,10 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_LOCAL_RENDEZVOUS_H_
 #define TENSORFLOW_CORE_FRAMEWORK_LOCAL_RENDEZVOUS_H_
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
-#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -65,14 +65,30 @@ class LocalRendezvous {
     Item* tail = nullptr;
   };
 
-  typedef gtl::FlatMap<uint64, ItemQueue> Table;
+  // An empty `absl::flat_hash_map` does not allocate, which matters because a
+  // rendezvous is typically created for every step.
+  typedef absl::flat_hash_map<uint64, ItemQueue> Table;
+
+  // The table is sharded by key hash, so that Send and Recv calls for
+  // different keys rarely contend for the same lock.
+  static constexpr int kNumShards = 16;
+
+  struct Shard {
+    mutex mu;
+    Table table TF_GUARDED_BY(mu);
+    // A copy of `status_`, so that Send and Recv only need to acquire the
+    // lock of their shard.
+    Status status TF_GUARDED_BY(mu);
+  };
+
+  Shard* GetShard(uint64 key_hash) { return &shards_[key_hash % kNumShards]; }
 
   // Pointer to the owner class of this LocalRendezvous if it is refcounted.
   const Rendezvous* rc_owner_;
 
-  // TODO(zhifengc): shard table_.
+  Shard shards_[kNumShards];
+
   mutex mu_;
-  Table table_ TF_GUARDED_BY(mu_);
   Status status_ TF_GUARDED_BY(mu_);
 
   TF_DISALLOW_COPY_AND_ASSIGN(LocalRendezvous);
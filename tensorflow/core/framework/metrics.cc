@@ -62,6 +62,22 @@ auto* graph_unused_outputs = monitoring::Counter<1>::New(
     "/tensorflow/core/graph_unused_outputs",
     "The number of unused outputs for ops of a given type.", "name");
 
+auto* tensor_list_copies = monitoring::Counter<1>::New(
+    "/tensorflow/core/tensor_list_copies",
+    "The number of times ops of a given type copied their input TensorList "
+    "because it could not be updated in place.",
+    "name");
+
+auto* tensor_list_copied_elements = monitoring::Counter<1>::New(
+    "/tensorflow/core/tensor_list_copied_elements",
+    "The number of TensorList elements copied by ops of a given type.", "name");
+
+auto* constant_folding_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/grappler/constant_folding_cache_lookups",
+    "The number of lookups of folded constants in the process-wide cache of "
+    "the constant folding optimizer, by whether they hit or missed.",
+    "outcome");
+
 auto* tf_data_autotune_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/autotune", "tf.data autotuning", "name");
 
@@ -99,6 +115,14 @@ auto* tf_data_get_next_duration_usecs_histogram = monitoring::Sampler<0>::New(
     {monitoring::Buckets::Explicit(
         {2., 4., 8., 16., 32., 64., 128., 256., 512., 1024., 1e6})});
 
+auto* tf_data_getnext_latency_usecs_histogram = monitoring::Sampler<1>::New(
+    {"/tensorflow/data/iterator_getnext_latency",
+     "Microseconds spent in the `GetNext()` calls of tf.data iterators, "
+     "including the time spent in their inputs.",
+     "name"},
+    // Power of 2 with bucket count 24 (> 8 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
 auto* tf_data_used_vs_budget_ratio_histogram = monitoring::Sampler<0>::New(
     {"/tensorflow/data/used_vs_budget_ratio",
      "Ratio of tf.data used ram over ram budget when running optimization."},
@@ -168,6 +192,21 @@ auto* tf_data_autotune_stopping_criteria_counter =
                                 "algorithm stopping criterion is met.",
                                 "name");
 
+auto* tf_data_autotune_parameter_gauge = monitoring::Gauge<int64, 3>::New(
+    "/tensorflow/data/autotune_parameter",
+    "The values chosen by tf.data autotuning for tunable parameters.",
+    "model_id", "node", "parameter");
+
+auto* tf_data_autotune_budget_gauge = monitoring::Gauge<int64, 2>::New(
+    "/tensorflow/data/autotune_budget",
+    "The resource budgets granted to tf.data autotuning models.", "model_id",
+    "resource");
+
+auto* tf_data_thread_pool_threads_gauge = monitoring::Gauge<int64, 2>::New(
+    "/tensorflow/data/thread_pool_threads",
+    "The number of physical threads of tf.data thread pools.", "name",
+    "state");
+
 auto* parse_dense_feature_counter = monitoring::Counter<0>::New(
     "/tensorflow/data/dense_feature",
     "The number of dense features parsed by ops for parsing tf.Example.");
@@ -232,6 +271,16 @@ monitoring::Counter<2>* GetGraphOptimizationCounter() {
   return graph_optimization_counter;
 }
 
+void RecordConstantFoldingCacheLookup(bool hit) {
+  constant_folding_cache_lookups->GetCell(hit ? "hit" : "miss")
+      ->IncrementBy(1);
+}
+
+monitoring::CounterCell* GetConstantFoldingCacheLookupsCounter(
+    const string& outcome) {
+  return constant_folding_cache_lookups->GetCell(outcome);
+}
+
 void RecordTFDataAutotune(const string& name) {
   tf_data_autotune_counter->GetCell(name)->IncrementBy(1);
 }
@@ -252,6 +301,10 @@ monitoring::CounterCell* GetTFDataElementsCounter(const string& name) {
   return tf_data_elements_counter->GetCell(name);
 }
 
+monitoring::SamplerCell* GetTFDataGetNextLatencySampler(const string& name) {
+  return tf_data_getnext_latency_usecs_histogram->GetCell(name);
+}
+
 monitoring::GaugeCell<std::function<std::string()>>* GetTFDataModelGauge(
     const string& id) {
   return tf_data_model_gauge->GetCell(id);
@@ -346,6 +399,22 @@ void RecordTFDataAutotuneStoppingCriteria(const string& name) {
   tf_data_autotune_stopping_criteria_counter->GetCell(name)->IncrementBy(1);
 }
 
+void RecordTFDataAutotuneParameter(const string& model_id, const string& node,
+                                   const string& parameter, int64_t value) {
+  tf_data_autotune_parameter_gauge->GetCell(model_id, node, parameter)
+      ->Set(value);
+}
+
+void RecordTFDataAutotuneBudget(const string& model_id, const string& resource,
+                                int64_t value) {
+  tf_data_autotune_budget_gauge->GetCell(model_id, resource)->Set(value);
+}
+
+void RecordTFDataThreadPoolThreads(const string& name, const string& state,
+                                   int64_t num_threads) {
+  tf_data_thread_pool_threads_gauge->GetCell(name, state)->Set(num_threads);
+}
+
 void RecordParseDenseFeature(int64 num_features) {
   static auto* parse_dense_feature_counter_cell =
       parse_dense_feature_counter->GetCell();
@@ -437,5 +506,19 @@ void RecordUnusedOutput(const string& op_name) {
   graph_unused_outputs->GetCell(op_name)->IncrementBy(1);
 }
 
+void RecordTensorListCopy(const string& op_name, int64_t num_elements) {
+  tensor_list_copies->GetCell(op_name)->IncrementBy(1);
+  tensor_list_copied_elements->GetCell(op_name)->IncrementBy(num_elements);
+}
+
+monitoring::CounterCell* GetTensorListCopiesCounter(const string& op_name) {
+  return tensor_list_copies->GetCell(op_name);
+}
+
+monitoring::CounterCell* GetTensorListCopiedElementsCounter(
+    const string& op_name) {
+  return tensor_list_copied_elements->GetCell(op_name);
+}
+
 }  // namespace metrics
 }  // namespace tensorflow
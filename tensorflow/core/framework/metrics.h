@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset_options.pb.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/platform/types.h"
@@ -59,6 +60,12 @@ monitoring::CounterCell* GetTFDataBytesReadCounter(const string& name);
 // The `name` argument identifies the Dataset type (e.g. "Batch" or "Map").
 monitoring::CounterCell* GetTFDataElementsCounter(const string& name);
 
+// Returns a sampler that can be used to record the latencies (in microseconds)
+// of the `GetNext()` calls of the iterators of a tf.data.Dataset.
+//
+// The `name` argument identifies the Dataset type (e.g. "Batch" or "Map").
+monitoring::SamplerCell* GetTFDataGetNextLatencySampler(const string& name);
+
 // Returns a gauge than can be used to record the performance model information.
 //
 // The `id` argument represents the (unique) model ID.
@@ -138,6 +145,28 @@ void RecordTFDataAutoShardRewriteBatchSize(
 // criterion is met.
 void RecordTFDataAutotuneStoppingCriteria(const string& name);
 
+// Records the value the tf.data autotuning chose for a tunable parameter.
+//
+// The `model_id` is a unique identifier of the autotuning model, `node` is the
+// long name of the node owning the parameter and `parameter` is its name (e.g.
+// "parallelism").
+void RecordTFDataAutotuneParameter(const string& model_id, const string& node,
+                                   const string& parameter, int64_t value);
+
+// Records a resource budget granted to a tf.data autotuning model.
+//
+// The `model_id` is a unique identifier of the autotuning model and `resource`
+// identifies the budget ("cpu" or "ram").
+void RecordTFDataAutotuneBudget(const string& model_id, const string& resource,
+                                int64_t value);
+
+// Records the number of physical threads of a tf.data thread pool.
+//
+// The `name` argument identifies the thread pool and `state` identifies the
+// threads counted ("total" or "idle").
+void RecordTFDataThreadPoolThreads(const string& name, const string& state,
+                                   int64_t num_threads);
+
 // Records parsing of dense tensor features.
 void RecordParseDenseFeature(int64_t num_features);
 
@@ -160,6 +189,16 @@ void UpdateGraphPendingQueueLength(uint64 len);
 // Records that one output of an op of type `op_name` was unused.
 void RecordUnusedOutput(const string& op_name);
 
+// Records that an op of type `op_name` could not update its input TensorList
+// in place, and copied the `num_elements` elements of the list instead.
+void RecordTensorListCopy(const string& op_name, int64_t num_elements);
+
+// Returns the counters of the TensorList copies, and of the elements they
+// copied, recorded for ops of type `op_name` by RecordTensorListCopy().
+monitoring::CounterCell* GetTensorListCopiesCounter(const string& op_name);
+monitoring::CounterCell* GetTensorListCopiedElementsCounter(
+    const string& op_name);
+
 // Updates the metrics stored about time spent building graphs.
 //
 // By "GraphBuild", we refer to building a client graph, which is a sub-graph of
@@ -259,6 +298,15 @@ class ScopedCounter final {
 // passes.
 monitoring::Counter<2>* GetGraphOptimizationCounter();
 
+// Records a lookup in the process-wide cache of the constants that nodes fold
+// to, which hit the cache if `hit`.
+void RecordConstantFoldingCacheLookup(bool hit);
+
+// Returns the counter of the constant folding cache lookups with the given
+// `outcome`, which is "hit" or "miss".
+monitoring::CounterCell* GetConstantFoldingCacheLookupsCounter(
+    const string& outcome);
+
 
 // Updates metrics for time to distribute variables to all TPU hosts.
 void UpdateTpuVariableDistributionTime(const uint64 distribution_time_usecs);
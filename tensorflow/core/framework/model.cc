@@ -15,15 +15,21 @@ limitations under the License.
 
 #include "tensorflow/core/framework/model.h"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 
 #include "absl/time/clock.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/model.pb.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/host_info.h"
 #include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -34,6 +40,22 @@ constexpr int64_t Model::kOptimizationPeriodMaxMs;
 
 namespace {
 
+// Returns whether the optimization loops of the models of the process share
+// their resource budgets.
+bool UseAutotuneCoordination() {
+  static const bool use_autotune_coordination = []() {
+    bool value;
+    Status s = ReadBoolFromEnvVar("TF_DATA_AUTOTUNE_COORDINATION",
+                                  /*default_val=*/true, &value);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to read TF_DATA_AUTOTUNE_COORDINATION: " << s;
+      return true;
+    }
+    return value;
+  }();
+  return use_autotune_coordination;
+}
+
 // Returns true if all parameters have reached their max values.
 bool AreAllParametersMax(const Model::ModelParameters& parameters) {
   for (const auto& pair : parameters) {
@@ -1176,6 +1198,81 @@ string Node::DebugString() const {
   return debug_strings[long_name()];
 }
 
+std::vector<int64_t> LatencyHistogram::Counts() const {
+  std::vector<int64_t> counts(kNumBuckets);
+  for (int i = 0; i < kNumBuckets; ++i) {
+    counts[i] = counts_[i].load(std::memory_order_relaxed);
+  }
+  return counts;
+}
+
+int64_t LatencyHistogram::Count() const {
+  int64_t count = 0;
+  for (const auto& bucket_count : counts_) {
+    count += bucket_count.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+int64_t LatencyHistogram::Percentile(double percentile) const {
+  const std::vector<int64_t> counts = Counts();
+  int64_t total = 0;
+  for (int64_t count : counts) {
+    total += count;
+  }
+  if (total == 0) {
+    return 0;
+  }
+  const int64_t rank = std::max<int64_t>(
+      1, static_cast<int64_t>(std::ceil(percentile / 100.0 * total)));
+  int64_t num_seen = 0;
+  for (int i = 0; i < kNumBuckets - 1; ++i) {
+    num_seen += counts[i];
+    if (num_seen >= rank) {
+      return BucketLowerBound(i + 1) - 1;
+    }
+  }
+  return (int64_t{1} << kMaxValueBits) - 1;
+}
+
+int LatencyHistogram::BucketIndex(int64_t latency_us) {
+  if (latency_us < kSubBuckets) {
+    return std::max<int64_t>(latency_us, 0);
+  }
+  latency_us = std::min(latency_us, (int64_t{1} << kMaxValueBits) - 1);
+  const int exponent = Log2Floor64(latency_us);
+  const int sub_bucket =
+      (latency_us >> (exponent - kSubBucketBits)) - kSubBuckets;
+  return (exponent - kSubBucketBits + 1) * kSubBuckets + sub_bucket;
+}
+
+int64_t LatencyHistogram::BucketLowerBound(int index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  const int exponent = index / kSubBuckets - 1 + kSubBucketBits;
+  const int sub_bucket = index % kSubBuckets;
+  return static_cast<int64_t>(kSubBuckets + sub_bucket)
+         << (exponent - kSubBucketBits);
+}
+
+void Node::Metrics::record_getnext_latency(const LatencyHistogram& histogram) {
+  const std::vector<int64_t> counts = histogram.Counts();
+  mutex_lock l(recorded_getnext_latency_mu_);
+  recorded_getnext_latency_counts_.resize(counts.size());
+  for (size_t i = 0; i < counts.size(); ++i) {
+    // The sampler has no bulk update, so the new latencies of a bucket are
+    // added one by one at the lower bound of the bucket. This costs as much as
+    // recording the latencies in the sampler directly, but is done outside of
+    // the `GetNext()` calls.
+    const int64_t delta = counts[i] - recorded_getnext_latency_counts_[i];
+    for (int64_t j = 0; j < delta; ++j) {
+      getnext_latency_sampler_->Add(LatencyHistogram::BucketLowerBound(i));
+    }
+    recorded_getnext_latency_counts_[i] = counts[i];
+  }
+}
+
 void Node::FlushMetrics() {
   if (!record_metrics_) {
     return;
@@ -1183,6 +1280,20 @@ void Node::FlushMetrics() {
   metrics_.record_bytes_consumed(bytes_consumed_);
   metrics_.record_bytes_produced(bytes_produced_);
   metrics_.record_num_elements(num_elements_);
+  metrics_.record_getnext_latency(getnext_latency_);
+  // Exports a summary of the latency histogram to the profiler, if it is
+  // active.
+  profiler::TraceMe::InstantActivity(
+      [this]() {
+        return profiler::TraceMeEncode(
+            "IteratorGetNextLatency",
+            {{"node", long_name()},
+             {"count", getnext_latency_.Count()},
+             {"p50_us", getnext_latency_.Percentile(50)},
+             {"p90_us", getnext_latency_.Percentile(90)},
+             {"p99_us", getnext_latency_.Percentile(99)}});
+      },
+      profiler::TraceMeLevel::kInfo);
 }
 
 double Node::OutputTime(Node::NodeValues* input_times,
@@ -1762,6 +1873,18 @@ Status Model::OptimizeLoop(AutotuneAlgorithm algorithm, int64_t cpu_budget,
       },
       /*deregister_fn=*/&unused));
 
+  AutotuneCoordinator* coordinator =
+      UseAutotuneCoordination() ? AutotuneCoordinator::Get() : nullptr;
+  if (coordinator) {
+    coordinator->Register(this, cpu_budget, ram_budget);
+  }
+  auto unregister = gtl::MakeCleanup([this, coordinator]() {
+    if (coordinator) {
+      coordinator->Unregister(this);
+    }
+  });
+  const std::string model_id = strings::StrCat(reinterpret_cast<uint64>(this));
+
   int64_t last_optimization_ms = 0;
   int64_t current_time_ms = EnvTime::NowMicros() / EnvTime::kMillisToMicros;
   while (true) {
@@ -1780,12 +1903,34 @@ Status Model::OptimizeLoop(AutotuneAlgorithm algorithm, int64_t cpu_budget,
       }
     }
 
+    int64_t granted_cpu_budget = cpu_budget;
+    int64_t granted_ram_budget = ram_budget;
+    if (coordinator) {
+      AutotuneCoordinator::Budget budget = coordinator->GetBudget(this);
+      granted_cpu_budget = budget.cpu_budget;
+      granted_ram_budget = budget.ram_budget;
+    }
+    metrics::RecordTFDataAutotuneBudget(model_id, "cpu", granted_cpu_budget);
+    metrics::RecordTFDataAutotuneBudget(model_id, "ram", granted_ram_budget);
+
     int64_t start_ms = EnvTime::NowMicros() / EnvTime::kMillisToMicros;
-    Optimize(algorithm, cpu_budget, ram_budget, /*model_input_time=*/0,
-             cancellation_manager);
+    Optimize(algorithm, granted_cpu_budget, granted_ram_budget,
+             /*model_input_time=*/0, cancellation_manager);
     int64_t end_ms = EnvTime::NowMicros() / EnvTime::kMillisToMicros;
     VLOG(2) << "Optimized for " << end_ms - start_ms << " ms.";
 
+    if (coordinator) {
+      std::shared_ptr<Node> snapshot;
+      {
+        tf_shared_lock l(mu_);
+        snapshot = output_->Snapshot();
+      }
+      coordinator->RecordOutputTime(
+          this, OutputTime(snapshot, /*model_input_time=*/0,
+                           /*gradients=*/nullptr));
+    }
+    RecordTunableParameters();
+
     // Exponentially increase the period of running the optimization
     // until a threshold is reached.
     {
@@ -1799,6 +1944,24 @@ Status Model::OptimizeLoop(AutotuneAlgorithm algorithm, int64_t cpu_budget,
   }
 }
 
+void Model::RecordTunableParameters() {
+  std::shared_ptr<Node> output;
+  {
+    tf_shared_lock l(mu_);
+    output = output_;
+  }
+  const std::string model_id = strings::StrCat(reinterpret_cast<uint64>(this));
+  for (auto& pair : CollectTunableParameters(output)) {
+    int64_t value;
+    {
+      mutex_lock l(*pair.second->state->mu);
+      value = std::round(pair.second->state->value);
+    }
+    metrics::RecordTFDataAutotuneParameter(model_id, pair.first,
+                                           pair.second->name, value);
+  }
+}
+
 void Model::OptimizeGradientDescent(
     std::shared_ptr<Node> snapshot,
     const OptimizationParams& optimization_params,
@@ -2068,6 +2231,79 @@ std::string Model::DebugString() {
   return cached_debug_string_;
 }
 
+AutotuneCoordinator* AutotuneCoordinator::Get() {
+  static AutotuneCoordinator* coordinator = new AutotuneCoordinator();
+  return coordinator;
+}
+
+void AutotuneCoordinator::Register(const Model* model, int64_t cpu_budget,
+                                   int64_t ram_budget) {
+  mutex_lock l(mu_);
+  ModelState& state = models_[model];
+  state.cpu_budget = cpu_budget;
+  state.ram_budget = ram_budget;
+  state.output_time = 0;
+}
+
+void AutotuneCoordinator::Unregister(const Model* model) {
+  mutex_lock l(mu_);
+  models_.erase(model);
+}
+
+void AutotuneCoordinator::RecordOutputTime(const Model* model,
+                                           double output_time) {
+  mutex_lock l(mu_);
+  auto it = models_.find(model);
+  if (it != models_.end()) {
+    it->second.output_time = output_time;
+  }
+}
+
+AutotuneCoordinator::Budget AutotuneCoordinator::GetBudget(const Model* model) {
+  mutex_lock l(mu_);
+  auto it = models_.find(model);
+  if (it == models_.end()) {
+    DCHECK(false) << "The model is not registered.";
+    return {1, 0};
+  }
+  const ModelState& own = it->second;
+
+  int64_t global_cpu_budget = 0;
+  int64_t global_ram_budget = 0;
+  double total_output_time = 0;
+  int64_t num_estimates = 0;
+  for (const auto& pair : models_) {
+    global_cpu_budget = std::max(global_cpu_budget, pair.second.cpu_budget);
+    global_ram_budget = std::max(global_ram_budget, pair.second.ram_budget);
+    if (pair.second.output_time > 0) {
+      total_output_time += pair.second.output_time;
+      ++num_estimates;
+    }
+  }
+
+  // Models without an estimate yet are weighted like an average model, so that
+  // they start with an equal share.
+  const double default_weight =
+      num_estimates > 0 ? total_output_time / num_estimates : 1.0;
+  auto weight = [default_weight](const ModelState& state) {
+    return state.output_time > 0 ? state.output_time : default_weight;
+  };
+  double total_weight = 0;
+  for (const auto& pair : models_) {
+    total_weight += weight(pair.second);
+  }
+  const double share = weight(own) / total_weight;
+
+  Budget budget;
+  budget.cpu_budget = std::min(
+      own.cpu_budget,
+      std::max<int64_t>(1, std::round(share * global_cpu_budget)));
+  budget.ram_budget = std::min(
+      own.ram_budget,
+      static_cast<int64_t>(std::round(share * global_ram_budget)));
+  return budget;
+}
+
 }  // namespace model
 }  // namespace data
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
 #define TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
 
+#include <atomic>
 #include <list>
 #include <memory>
 #include <string>
@@ -115,6 +116,54 @@ std::shared_ptr<Parameter> MakeParameter(const string& name,
                                          std::shared_ptr<SharedState> state,
                                          double min, double max);
 
+// A histogram of latencies in microseconds, which can be recorded from many
+// threads without locking. The buckets are log-linear in the style of HDR
+// histograms: each power of two range of values is divided into
+// `kSubBuckets` linear sub-buckets, which bounds the relative error of a
+// recorded value by `1 / kSubBuckets`.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 3;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  // Larger values (about 12 days) are recorded in the last bucket.
+  static constexpr int kMaxValueBits = 40;
+  static constexpr int kNumBuckets =
+      (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+  LatencyHistogram() {
+    for (auto& count : counts_) {
+      count = 0;
+    }
+  }
+
+  // Records a latency.
+  void Add(int64_t latency_us) {
+    counts_[BucketIndex(latency_us)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Returns the number of recorded latencies in each bucket.
+  std::vector<int64_t> Counts() const;
+
+  // Returns the number of recorded latencies.
+  int64_t Count() const;
+
+  // Returns the largest value of the bucket which contains the given
+  // percentile (in [0, 100]) of the recorded latencies, or 0 if no latency was
+  // recorded.
+  int64_t Percentile(double percentile) const;
+
+  // Returns the index of the bucket of the given latency.
+  static int BucketIndex(int64_t latency_us);
+
+  // Returns the smallest latency recorded in the given bucket.
+  static int64_t BucketLowerBound(int index);
+
+ private:
+  std::atomic<int64_t> counts_[kNumBuckets];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LatencyHistogram);
+};
+
 // Abstract representation of a TensorFlow input pipeline node. It collects
 // information about inputs to this node, processing time spent executing the
 // node logic, number of elements produced by the node, various other
@@ -287,6 +336,17 @@ class Node {
   // Records that the node produced an element.
   void record_element() TF_LOCKS_EXCLUDED(mu_) { num_elements_++; }
 
+  // Records the latency of a `GetNext()` call of the node's iterator,
+  // including the time spent in its inputs.
+  void record_getnext_latency(int64_t latency_us) TF_LOCKS_EXCLUDED(mu_) {
+    getnext_latency_.Add(latency_us);
+  }
+
+  // Returns the histogram of the `GetNext()` latencies of the node's iterator.
+  const LatencyHistogram& getnext_latency() const TF_LOCKS_EXCLUDED(mu_) {
+    return getnext_latency_;
+  }
+
   // Records that a node thread has started executing.
   void record_start(int64_t time_nanos) TF_LOCKS_EXCLUDED(mu_) {
     DCHECK_EQ(work_start_, 0);
@@ -397,6 +457,8 @@ class Node {
         : bytes_consumed_counter_(metrics::GetTFDataBytesConsumedCounter(name)),
           bytes_produced_counter_(metrics::GetTFDataBytesProducedCounter(name)),
           num_elements_counter_(metrics::GetTFDataElementsCounter(name)),
+          getnext_latency_sampler_(
+              metrics::GetTFDataGetNextLatencySampler(name)),
           recorded_bytes_consumed_(0),
           recorded_bytes_produced_(0),
           recorded_num_elements_(0) {}
@@ -425,13 +487,21 @@ class Node {
       num_elements_counter_->IncrementBy(delta);
     }
 
+    // Expects the histogram of all `GetNext()` latencies and records the
+    // latencies added since last invocation.
+    void record_getnext_latency(const LatencyHistogram& histogram);
+
    private:
     monitoring::CounterCell* const bytes_consumed_counter_;
     monitoring::CounterCell* const bytes_produced_counter_;
     monitoring::CounterCell* const num_elements_counter_;
+    monitoring::SamplerCell* const getnext_latency_sampler_;
     std::atomic<int64_t> recorded_bytes_consumed_;
     std::atomic<int64_t> recorded_bytes_produced_;
     std::atomic<int64_t> recorded_num_elements_;
+    mutex recorded_getnext_latency_mu_;
+    std::vector<int64_t> recorded_getnext_latency_counts_
+        TF_GUARDED_BY(recorded_getnext_latency_mu_);
   };
 
   // Returns the number of inputs.
@@ -572,6 +642,7 @@ class Node {
   std::atomic<int64_t> bytes_produced_;
   std::atomic<int64_t> num_elements_;
   std::atomic<int64_t> processing_time_;
+  LatencyHistogram getnext_latency_;
   std::atomic<bool> record_metrics_;
   Metrics metrics_;
   absl::flat_hash_map<string, std::shared_ptr<Parameter>> parameters_
@@ -666,6 +737,10 @@ class Model {
   // Uses the given algorithm and resource budgets to periodically perform the
   // autotuning optimization.
   //
+  // Unless `TF_DATA_AUTOTUNE_COORDINATION` is set to false, the budgets are
+  // shared with the optimization loops of the other models of the process
+  // through `AutotuneCoordinator`.
+  //
   // To terminate the execution of the optimization loop, the caller needs to
   // invoke `cancellation_mgr->StartCancel()`.
   Status OptimizeLoop(AutotuneAlgorithm algorithm, int64_t cpu_budget,
@@ -778,6 +853,9 @@ class Model {
   // buffers were full.
   double TotalMaximumBufferedBytes(std::shared_ptr<Node> node);
 
+  // Exports the current values of the tunable parameters as metrics.
+  void RecordTunableParameters() TF_LOCKS_EXCLUDED(mu_);
+
   // Used for coordination between different input pipeline threads. Exclusive
   // access is required only when adding or removing nodes. Concurrent access to
   // existing nodes is protected by a node mutex.
@@ -802,6 +880,59 @@ class Model {
   std::string cached_debug_string_ = "";
 };
 
+// Shares the CPU and RAM budgets of the process among the optimization loops of
+// all `Model`s.
+//
+// Every optimization loop registers the budgets it was given. The global
+// budgets are the largest registered budgets, so a process with a single input
+// pipeline is tuned exactly as before. With several input pipelines, each
+// model is granted a share of the global budgets proportional to its latest
+// estimated output time, so that parallelism and buffer memory shift towards
+// the pipelines that limit throughput the most instead of every pipeline
+// tuning itself up to the number of cores of the machine.
+class AutotuneCoordinator {
+ public:
+  struct Budget {
+    int64_t cpu_budget;
+    int64_t ram_budget;
+  };
+
+  AutotuneCoordinator() = default;
+
+  // Returns the coordinator shared by all models of the process.
+  static AutotuneCoordinator* Get();
+
+  // Registers the `model` with the budgets it would use on its own.
+  void Register(const Model* model, int64_t cpu_budget, int64_t ram_budget)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Unregisters the `model`, returning its share to the other models.
+  void Unregister(const Model* model) TF_LOCKS_EXCLUDED(mu_);
+
+  // Records the latest estimated output time of the `model`, in nanoseconds.
+  void RecordOutputTime(const Model* model, double output_time)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the budgets granted to the `model`, which must be registered. The
+  // granted budgets never exceed the budgets the model was registered with and
+  // the granted CPU budget is at least 1.
+  Budget GetBudget(const Model* model) TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct ModelState {
+    int64_t cpu_budget;
+    int64_t ram_budget;
+    // The latest estimated output time, or 0 if the model was not optimized
+    // yet.
+    double output_time = 0;
+  };
+
+  mutex mu_;
+  absl::flat_hash_map<const Model*, ModelState> models_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AutotuneCoordinator);
+};
+
 }  // namespace model
 }  // namespace data
 }  // namespace tensorflow
@@ -1176,6 +1176,102 @@ TEST(RecordTimeTest, RecordTimeTest) {
   EXPECT_FALSE(source->is_recording());
 }
 
+TEST(LatencyHistogramTest, BucketBoundaries) {
+  for (int i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+    const int64_t lower_bound = LatencyHistogram::BucketLowerBound(i);
+    EXPECT_EQ(LatencyHistogram::BucketIndex(lower_bound), i);
+    if (i > 0) {
+      EXPECT_EQ(LatencyHistogram::BucketIndex(lower_bound - 1), i - 1);
+    }
+  }
+  EXPECT_EQ(LatencyHistogram::BucketIndex(-1), 0);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(int64_t{1} << 50),
+            LatencyHistogram::kNumBuckets - 1);
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.Count(), 0);
+  EXPECT_EQ(histogram.Percentile(50), 0);
+  for (int64_t latency_us = 1; latency_us <= 1000; ++latency_us) {
+    histogram.Add(latency_us);
+  }
+  EXPECT_EQ(histogram.Count(), 1000);
+  // The percentiles are exact up to the relative error of the buckets.
+  for (double percentile : {1.0, 50.0, 90.0, 99.0, 100.0}) {
+    const double expected = percentile * 10;
+    EXPECT_GE(histogram.Percentile(percentile), expected);
+    EXPECT_LE(histogram.Percentile(percentile),
+              expected * (1.0 + 1.0 / LatencyHistogram::kSubBuckets));
+  }
+}
+
+TEST(LatencyHistogramTest, RecordGetNextLatency) {
+  std::shared_ptr<Node> source = model::MakeSourceNode({});
+  source->record_getnext_latency(10);
+  source->record_getnext_latency(20);
+  EXPECT_EQ(source->getnext_latency().Count(), 2);
+  EXPECT_LE(source->getnext_latency().Percentile(50), 10);
+}
+
+TEST(AutotuneCoordinatorTest, SingleModelIsGrantedItsBudget) {
+  AutotuneCoordinator coordinator;
+  Model model;
+  coordinator.Register(&model, /*cpu_budget=*/8, /*ram_budget=*/1000);
+  AutotuneCoordinator::Budget budget = coordinator.GetBudget(&model);
+  EXPECT_EQ(budget.cpu_budget, 8);
+  EXPECT_EQ(budget.ram_budget, 1000);
+
+  coordinator.RecordOutputTime(&model, 12345);
+  budget = coordinator.GetBudget(&model);
+  EXPECT_EQ(budget.cpu_budget, 8);
+  EXPECT_EQ(budget.ram_budget, 1000);
+}
+
+TEST(AutotuneCoordinatorTest, BudgetIsSharedByOutputTime) {
+  AutotuneCoordinator coordinator;
+  Model fast, slow;
+  coordinator.Register(&fast, /*cpu_budget=*/8, /*ram_budget=*/1000);
+  coordinator.Register(&slow, /*cpu_budget=*/8, /*ram_budget=*/1000);
+
+  // Models without estimates share the budgets equally.
+  EXPECT_EQ(coordinator.GetBudget(&fast).cpu_budget, 4);
+  EXPECT_EQ(coordinator.GetBudget(&slow).cpu_budget, 4);
+  EXPECT_EQ(coordinator.GetBudget(&fast).ram_budget, 500);
+  EXPECT_EQ(coordinator.GetBudget(&slow).ram_budget, 500);
+
+  // The pipeline with the largest output time limits throughput the most.
+  coordinator.RecordOutputTime(&fast, 100);
+  coordinator.RecordOutputTime(&slow, 300);
+  EXPECT_EQ(coordinator.GetBudget(&fast).cpu_budget, 2);
+  EXPECT_EQ(coordinator.GetBudget(&slow).cpu_budget, 6);
+  EXPECT_EQ(coordinator.GetBudget(&fast).ram_budget, 250);
+  EXPECT_EQ(coordinator.GetBudget(&slow).ram_budget, 750);
+
+  // Unregistering a model returns its share to the others.
+  coordinator.Unregister(&fast);
+  EXPECT_EQ(coordinator.GetBudget(&slow).cpu_budget, 8);
+  EXPECT_EQ(coordinator.GetBudget(&slow).ram_budget, 1000);
+}
+
+TEST(AutotuneCoordinatorTest, GrantedBudgetIsBounded) {
+  AutotuneCoordinator coordinator;
+  Model small, large;
+  coordinator.Register(&small, /*cpu_budget=*/2, /*ram_budget=*/100);
+  coordinator.Register(&large, /*cpu_budget=*/16, /*ram_budget=*/1000);
+  coordinator.RecordOutputTime(&small, 1000000);
+  coordinator.RecordOutputTime(&large, 1);
+
+  // The granted budgets never exceed the registered budgets ...
+  AutotuneCoordinator::Budget budget = coordinator.GetBudget(&small);
+  EXPECT_EQ(budget.cpu_budget, 2);
+  EXPECT_EQ(budget.ram_budget, 100);
+  // ... and every model can use at least one core.
+  budget = coordinator.GetBudget(&large);
+  EXPECT_EQ(budget.cpu_budget, 1);
+  EXPECT_EQ(budget.ram_budget, 0);
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace data
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op_kernel.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <mutex>  // NOLINT
@@ -24,6 +25,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/base/call_once.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/match.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -46,10 +48,12 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/platform_strings.h"
@@ -685,9 +689,8 @@ Status OpKernelContext::allocate_output(StringPiece name,
 }
 
 Status OpKernelContext::allocate_tensor(
-    DataType type, const TensorShape& shape, Tensor* out_tensor,
-    AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   Tensor new_tensor(
       a, type, shape,
       AllocationAttributes(
@@ -732,6 +735,19 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
                             " mutable_output(index) = ", mutable_output(index),
                             " kernel=", params_->op_kernel->name());
   }
+  if (params_->output_retval_indices != nullptr &&
+      params_->output_retval_indices[index] >= 0 && attr.value == 0 &&
+      attr.scope_id == 0 && !track_allocations()) {
+    // Write the output directly into a buffer provided by the caller, if any.
+    auto output_tensor = MakeUnique<Tensor>();
+    if (params_->call_frame->GetRetvalBuffer(
+            params_->output_retval_indices[index], type, shape,
+            output_tensor.get())) {
+      outputs_[index] = TensorValue(output_tensor.release());
+      *output = outputs_[index].tensor;
+      return Status::OK();
+    }
+  }
   if (attr.scope_id > 0) {
     maybe_initialize_scope_id_set();
     if (!allocated_scope_ids_->insert(attr.scope_id).second) {
@@ -754,6 +770,20 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
   return s;
 }
 
+Allocator* OpKernelContext::get_temp_allocator(
+    AllocatorAttributes allocator_attr,
+    const AllocationAttributes& allocation_attr) {
+  // The step allocator only serves plain host-memory temporaries whose
+  // allocations are not tracked or logged individually, and whose memory is
+  // not subject to timestamped reuse.
+  if (params_->step_temp_allocator != nullptr && allocator_attr.value == 0 &&
+      allocation_attr.freed_by_func == nullptr && !track_allocations() &&
+      !params_->log_memory) {
+    return params_->step_temp_allocator;
+  }
+  return get_allocator(allocator_attr);
+}
+
 Status OpKernelContext::allocate_temp(
     DataType type, const TensorShape& shape, Tensor* out_temp,
     AllocatorAttributes allocator_attr,
@@ -776,8 +806,8 @@ Status OpKernelContext::allocate_temp(
   profiler::ScopedMemoryDebugAnnotation op_annotation(
       op_kernel().name_view().data(), step_id(), "temp", type,
       [&shape]() { return shape.DebugString(); });
-  Status s =
-      allocate_tensor(type, shape, out_temp, allocator_attr, allocation_attr);
+  Status s = allocate_tensor(get_temp_allocator(allocator_attr, allocation_attr),
+                             type, shape, out_temp, allocation_attr);
   if (track_allocations() && s.ok() && out_temp->TotalBytes() > 0) {
     Allocator* a = get_allocator(allocator_attr);
     if (a->TracksAllocationSizes()) {
@@ -1065,10 +1095,40 @@ struct KernelRegistration {
 // This maps from 'op_type' + DeviceType to the set of KernelDefs and
 // factory functions for instantiating the OpKernel that matches the
 // KernelDef.
+//
+// Kernel lookups are memoized: the registration that matches a NodeDef only
+// depends on the values of the attrs that the kernels registered for its op
+// and device type constrain, so the results for each registry key are cached
+// by a fingerprint of those values. The cache is cleared whenever the registry
+// changes, e.g. when a kernel library is loaded.
 struct KernelRegistry {
+  // The memoized results of lookups of one registry key.
+  struct LookupCacheEntry {
+    // The sorted names of the attrs constrained by the kernels registered
+    // under the key or the corresponding DEVICE_DEFAULT key.
+    std::vector<string> constrained_attrs;
+    // Maps a fingerprint of the values of `constrained_attrs` to the matching
+    // registration, which is nullptr if none matches, and whether some
+    // registration did not match.
+    absl::flat_hash_map<Fprint128, std::pair<const KernelRegistration*, bool>,
+                        Fprint128Hasher>
+        results;
+  };
+
   mutex mu;
   std::unordered_multimap<string, KernelRegistration> registry
       TF_GUARDED_BY(mu);
+
+  // Acquired after `mu`. Entries are only added while holding `mu`, so that
+  // they always reflect the current contents of `registry`.
+  mutex lookup_cache_mu;
+  absl::flat_hash_map<string, std::unique_ptr<LookupCacheEntry>> lookup_cache
+      TF_GUARDED_BY(lookup_cache_mu);
+
+  void ClearLookupCache() TF_EXCLUSIVE_LOCKS_REQUIRED(mu) {
+    mutex_lock l(lookup_cache_mu);
+    lookup_cache.clear();
+  }
 };
 
 #if defined(_WIN32)
@@ -1211,6 +1271,7 @@ void SetupOrDisableJit(KernelRegistry* registry) {
   for (auto& jit_kernel : jit_kernels) {
     all_kernels.insert(std::move(jit_kernel));
   }
+  registry->ClearLookupCache();
 }
 
 void* GlobalKernelRegistry() {
@@ -1256,6 +1317,7 @@ void OpKernelRegistrar::InitInternal(const KernelDef* kernel_def,
   global_registry->registry.emplace(
       key,
       KernelRegistration(*kernel_def, kernel_class_name, std::move(factory)));
+  global_registry->ClearLookupCache();
   delete kernel_def;
 }
 
@@ -1284,22 +1346,57 @@ const string& GetKernelLabelAttr(const AttrSlice& node_attrs) {
     return attr_value->s();
 }
 
-// TODO(irving): Replace with const Node& version below.
-Status FindKernelRegistration(
-    const DeviceType& device_type, StringPiece node_name,
-    bool has_experimental_debug_info,
+// Returns the sorted names of the attrs constrained by the kernels registered
+// under `key` or `default_key`.
+std::vector<string> ConstrainedAttrs(const KernelRegistry& registry,
+                                     const string& key,
+                                     const string& default_key)
+    TF_SHARED_LOCKS_REQUIRED(registry.mu) {
+  std::vector<string> names;
+  for (const string* k : {&key, &default_key}) {
+    auto regs = registry.registry.equal_range(*k);
+    for (auto iter = regs.first; iter != regs.second; ++iter) {
+      for (const auto& constraint : iter->second.def.constraint()) {
+        names.push_back(constraint.name());
+      }
+    }
+  }
+  std::sort(names.begin(), names.end());
+  names.erase(std::unique(names.begin(), names.end()), names.end());
+  return names;
+}
+
+// Returns a fingerprint of the values in `attrs` of the attrs named in
+// `names`, which distinguishes missing attrs from present ones.
+Fprint128 ConstrainedAttrsFingerprint(const std::vector<string>& names,
+                                      AttrSlice attrs) {
+  string buf;
+  string serialized;
+  for (const string& name : names) {
+    const AttrValue* attr_value = attrs.Find(name);
+    if (attr_value == nullptr) {
+      buf.push_back('-');
+      continue;
+    }
+    SerializeToStringDeterministic(*attr_value, &serialized);
+    strings::StrAppend(&buf, serialized.size(), ":", serialized);
+  }
+  return Fingerprint128(buf);
+}
+
+// Finds the registration under `key`, or `default_key` if there is none for
+// `device_type`, that matches `node_attrs`.
+Status FindKernelRegistrationUncached(
+    const KernelRegistry& registry, const string& key,
+    const string& default_key, const DeviceType& device_type,
+    StringPiece node_name, bool has_experimental_debug_info,
     const NodeDef_ExperimentalDebugInfo& experimental_debug_info,
-    StringPiece node_op, AttrSlice node_attrs, const KernelRegistration** reg,
-    bool* was_attr_mismatch) {
+    AttrSlice node_attrs, const KernelRegistration** reg,
+    bool* was_attr_mismatch) TF_SHARED_LOCKS_REQUIRED(registry.mu) {
   *reg = nullptr;
   *was_attr_mismatch = false;
 
-  const string& label = GetKernelLabelAttr(node_attrs);
-
-  const string key = Key(node_op, device_type, label);
-  auto typed_registry = GlobalKernelRegistryTyped();
-  tf_shared_lock lock(typed_registry->mu);
-  auto regs = typed_registry->registry.equal_range(key);
+  auto regs = registry.registry.equal_range(key);
   for (auto iter = regs.first; iter != regs.second; ++iter) {
     // If there is a kernel registered for the op and device_type,
     // check that the attrs match.
@@ -1329,8 +1426,7 @@ Status FindKernelRegistration(
   // default kernel.
   if (*reg == nullptr &&
       !IsSymbolicExecutionDevice(device_type.type_string())) {
-    const string default_key = Key(node_op, DEVICE_DEFAULT, label);
-    auto regs = typed_registry->registry.equal_range(default_key);
+    auto regs = registry.registry.equal_range(default_key);
     for (auto iter = regs.first; iter != regs.second; ++iter) {
       // If there is a kernel registered for the op and device_type,
       // check that the attrs match.
@@ -1364,6 +1460,67 @@ Status FindKernelRegistration(
   return Status::OK();
 }
 
+// TODO(irving): Replace with const Node& version below.
+Status FindKernelRegistration(
+    const DeviceType& device_type, StringPiece node_name,
+    bool has_experimental_debug_info,
+    const NodeDef_ExperimentalDebugInfo& experimental_debug_info,
+    StringPiece node_op, AttrSlice node_attrs, const KernelRegistration** reg,
+    bool* was_attr_mismatch) {
+  const string& label = GetKernelLabelAttr(node_attrs);
+
+  const string key = Key(node_op, device_type, label);
+  auto typed_registry = GlobalKernelRegistryTyped();
+  tf_shared_lock lock(typed_registry->mu);
+
+  const std::vector<string>* constrained_attrs = nullptr;
+  Fprint128 fingerprint;
+  {
+    tf_shared_lock cache_lock(typed_registry->lookup_cache_mu);
+    auto it = typed_registry->lookup_cache.find(key);
+    if (it != typed_registry->lookup_cache.end()) {
+      // Entries are never removed while `mu` is held, and their
+      // `constrained_attrs` never change, so the pointer stays valid after
+      // `cache_lock` is released.
+      constrained_attrs = &it->second->constrained_attrs;
+      fingerprint =
+          ConstrainedAttrsFingerprint(*constrained_attrs, node_attrs);
+      auto result = it->second->results.find(fingerprint);
+      if (result != it->second->results.end()) {
+        *reg = result->second.first;
+        *was_attr_mismatch = result->second.second;
+        return Status::OK();
+      }
+    }
+  }
+
+  const string default_key = Key(node_op, DEVICE_DEFAULT, label);
+  TF_RETURN_IF_ERROR(FindKernelRegistrationUncached(
+      *typed_registry, key, default_key, device_type, node_name,
+      has_experimental_debug_info, experimental_debug_info, node_attrs, reg,
+      was_attr_mismatch));
+
+  std::vector<string> new_constrained_attrs;
+  if (constrained_attrs == nullptr) {
+    new_constrained_attrs =
+        ConstrainedAttrs(*typed_registry, key, default_key);
+    fingerprint =
+        ConstrainedAttrsFingerprint(new_constrained_attrs, node_attrs);
+  }
+  mutex_lock cache_lock(typed_registry->lookup_cache_mu);
+  std::unique_ptr<KernelRegistry::LookupCacheEntry>& entry =
+      typed_registry->lookup_cache[key];
+  // If another thread added an entry for `key` in the meantime, its
+  // `constrained_attrs` are the same as `new_constrained_attrs`.
+  if (entry == nullptr) {
+    entry = absl::make_unique<KernelRegistry::LookupCacheEntry>();
+    entry->constrained_attrs = std::move(new_constrained_attrs);
+  }
+  entry->results.emplace(fingerprint,
+                         std::make_pair(*reg, *was_attr_mismatch));
+  return Status::OK();
+}
+
 Status FindKernelRegistration(const DeviceType& device_type,
                               const NodeDef& node_def,
                               const KernelRegistration** reg,
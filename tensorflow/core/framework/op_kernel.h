@@ -81,6 +81,7 @@ class ScopedStepContainer;
 class CollectiveExecutor;
 class StepStatsCollectorInterface;
 class CoordinationServiceAgent;
+class RequestCost;
 
 // A label that is added to kernels that are JIT compiled. These labels will be
 // removed before kernels are looked up, so they can be used without specifying
@@ -605,9 +606,18 @@ class OpKernelContext {
     bool track_allocations = false;
     bool log_memory = false;
 
+    // If not null, an allocator whose lifetime is scoped to the current step,
+    // used for temporary tensors with default allocator attributes. Not owned.
+    Allocator* step_temp_allocator = nullptr;
+
     // Array indexed by output number for this node
     const AllocatorAttributes* output_attr_array = nullptr;
 
+    // If not null, an array indexed by output number for this node, holding
+    // the index of the return value in `call_frame` that each output is
+    // fetched as, or -1.
+    const int* output_retval_indices = nullptr;
+
     // Shared resources accessible by this op kernel invocation.
     ResourceMgr* resource_manager = nullptr;
 
@@ -658,6 +668,9 @@ class OpKernelContext {
     std::function<void(std::function<void()>)>* runner = nullptr;
     StepStatsCollectorInterface* stats_collector = nullptr;
     GraphCollector* graph_collector = nullptr;
+    // The cost of the request of the step, for the functions called by the
+    // kernel to record their costs into.
+    RequestCost* request_cost = nullptr;
     bool run_all_kernels_inline = false;
     const std::string* executor_type = nullptr;
 
@@ -1099,6 +1112,7 @@ class OpKernelContext {
   StepStatsCollectorInterface* stats_collector() const {
     return params_->stats_collector;
   }
+  RequestCost* request_cost() const { return params_->request_cost; }
 
   // Shared resources accessible to this kernel.
   ResourceMgr* resource_manager() const { return params_->resource_manager; }
@@ -1248,8 +1262,20 @@ class OpKernelContext {
 
   Status allocate_tensor(DataType type, const TensorShape& shape,
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
+                         const AllocationAttributes& allocation_attr) {
+    return allocate_tensor(get_allocator(allocator_attr), type, shape,
+                           out_tensor, allocation_attr);
+  }
+
+  Status allocate_tensor(Allocator* a, DataType type, const TensorShape& shape,
+                         Tensor* out_tensor,
                          const AllocationAttributes& allocation_attr);
 
+  // Returns the allocator to use for a temporary tensor with the given
+  // attributes.
+  Allocator* get_temp_allocator(AllocatorAttributes allocator_attr,
+                                const AllocationAttributes& allocation_attr);
+
   // Helpers for `set_output()`.
 
   // Returns `true` if the tensor was copied into an allocated output.
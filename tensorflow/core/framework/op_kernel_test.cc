@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/kernel_def_builder.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel_test_base.h"
@@ -548,6 +549,45 @@ TEST_F(OpKernelBuilderTest, BuilderTypeListAttr) {
                 error::INVALID_ARGUMENT);
 }
 
+REGISTER_OP("LateRegistered").Attr("T: type");
+REGISTER_KERNEL_BUILDER(
+    Name("LateRegistered").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    DummyKernel);
+
+OpKernel* CreateDummyKernel(OpKernelConstruction* context) {
+  return new DummyKernel(context);
+}
+
+TEST_F(OpKernelBuilderTest, LookupCacheInvalidatedByRegistration) {
+  // Repeated lookups are answered from the lookup cache.
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ("DummyKernel", GetKernelClassName("LateRegistered", DEVICE_CPU,
+                                                {"T|type|DT_FLOAT"}));
+    ExpectFailure("LateRegistered", DEVICE_CPU, {"T|type|DT_INT32"},
+                  error::NOT_FOUND);
+  }
+
+  // Registering kernels, as loading a kernel library does, invalidates the
+  // cached lookups of both the new and the existing constraint values.
+  kernel_factory::OpKernelRegistrar int32_registrar(
+      KernelDefBuilder("LateRegistered")
+          .Device(DEVICE_CPU)
+          .TypeConstraint<int32>("T")
+          .Build(),
+      "LateInt32Kernel", CreateDummyKernel);
+  kernel_factory::OpKernelRegistrar float_registrar(
+      KernelDefBuilder("LateRegistered")
+          .Device(DEVICE_CPU)
+          .TypeConstraint<float>("T")
+          .Priority(1)
+          .Build(),
+      "LateFloatKernel", CreateDummyKernel);
+  EXPECT_EQ("LateInt32Kernel", GetKernelClassName("LateRegistered", DEVICE_CPU,
+                                                  {"T|type|DT_INT32"}));
+  EXPECT_EQ("LateFloatKernel", GetKernelClassName("LateRegistered", DEVICE_CPU,
+                                                  {"T|type|DT_FLOAT"}));
+}
+
 REGISTER_OP("DuplicateKernel");
 REGISTER_KERNEL_BUILDER(Name("DuplicateKernel").Device(DEVICE_CPU),
                         DummyKernel);
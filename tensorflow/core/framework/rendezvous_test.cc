@@ -15,12 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/framework/rendezvous.h"
 
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -518,5 +521,52 @@ void BM_PingPong(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_PingPong)->Arg(100)->Arg(200)->Arg(300);
 
+void BM_ConcurrentSendRecv(::testing::benchmark::State& state) {
+  const int num_pairs = state.range(0);
+  constexpr int kMessagesPerPair = 100;
+  std::vector<Rendezvous::ParsedKey> keys;
+  keys.reserve(num_pairs);
+  for (int i = 0; i < num_pairs; ++i) {
+    keys.push_back(MakeKey(strings::StrCat("key", i)));
+  }
+  thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "test", 2 * num_pairs);
+
+  // Benchmark loop
+  // In each iteration, each of `num_pairs` producers sends kMessagesPerPair
+  // messages under its own key, while a matching consumer receives them.
+  for (auto s : state) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    BlockingCounter counter(2 * num_pairs);
+    for (int i = 0; i < num_pairs; ++i) {
+      const Rendezvous::ParsedKey* key = &keys[i];
+      pool->Schedule([rendez, key, &counter]() {
+        Tensor val = V("val");
+        Rendezvous::Args args;
+        for (int j = 0; j < kMessagesPerPair; ++j) {
+          TF_CHECK_OK(rendez->Send(*key, args, val, /*is_dead=*/false));
+        }
+        counter.DecrementCount();
+      });
+      pool->Schedule([rendez, key, &counter]() {
+        Tensor val;
+        bool is_dead = false;
+        Rendezvous::Args args;
+        for (int j = 0; j < kMessagesPerPair; ++j) {
+          TF_CHECK_OK(rendez->Recv(*key, args, &val, &is_dead));
+        }
+        CHECK_EQ("val", V(val));
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+    rendez->Unref();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(num_pairs) * kMessagesPerPair *
+                          state.iterations());
+  delete pool;
+}
+BENCHMARK(BM_ConcurrentSendRecv)->RangeMultiplier(2)->Range(1, 128);
+
 }  // namespace
 }  // namespace tensorflow
@@ -15,8 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/framework/resource_var.h"
 
+#include <thread>  // NOLINT(build/c++11)
+
 #include "tensorflow/core/framework/resource_handle.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -37,4 +40,62 @@ Status Var::AsGraphDef(GraphDefBuilder* builder, Node** out) const {
       ops::UnaryOp("Identity", var, builder->opts().WithControlInput(assign));
   return Status::OK();
 }
+
+bool Var::SnapshotReadsEnabled() {
+  static const bool enabled = [] {
+    bool enabled;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_RESOURCE_VARIABLE_SNAPSHOT_READS",
+                                   /*default_val=*/false, &enabled));
+    return enabled;
+  }();
+  return enabled;
+}
+
+bool Var::ReadSnapshot(Tensor* out) {
+  if (snapshot_.load(std::memory_order_acquire) == nullptr) return false;
+  for (;;) {
+    const uint32 epoch = snapshot_epoch_.load();
+    std::atomic<int>& readers = snapshot_readers_[epoch % 2];
+    readers.fetch_add(1);
+    if (snapshot_epoch_.load() != epoch) {
+      // SetSnapshot() may have stopped waiting for readers of `epoch`.
+      readers.fetch_sub(1);
+      continue;
+    }
+    const Snapshot* snapshot = snapshot_.load();
+    if (snapshot != nullptr) *out = snapshot->tensor;
+    readers.fetch_sub(1);
+    return snapshot != nullptr;
+  }
+}
+
+void Var::PublishSnapshot() {
+  if (!SnapshotReadsEnabled() || !is_initialized || copy_on_read_mode.load()) {
+    return;
+  }
+  SetSnapshot(&tensor_);
+}
+
+void Var::SetSnapshot(const Tensor* value) {
+  mutex_lock l(snapshot_mu_);
+  Snapshot* old = snapshot_.load();
+  if (value != nullptr && old != nullptr &&
+      old->tensor.dtype() == value->dtype() &&
+      old->tensor.shape() == value->shape() &&
+      old->tensor.SharesBufferWith(*value)) {
+    return;
+  }
+  snapshot_.store(value != nullptr ? new Snapshot(*value) : nullptr);
+  if (old == nullptr) return;
+  // Readers that registered with the current epoch may have loaded `old`.
+  // Those of the previous epoch were gone when the last call that advanced
+  // the epoch returned, and readers that find the new epoch only see the new
+  // snapshot.
+  const uint32 epoch = snapshot_epoch_.fetch_add(1);
+  while (snapshot_readers_[epoch % 2].load() != 0) {
+    std::this_thread::yield();
+  }
+  delete old;
+}
+
 }  //  end namespace tensorflow
@@ -16,9 +16,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 #define TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 
+#include <atomic>
+
 #include "tensorflow/core/framework/resource_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
 
 // Forward declarations to avoid introducing a dependency on headers in
 // "tensorflow/core/graph/...".
@@ -63,6 +66,18 @@ namespace tensorflow {
 // mutex as desired. To access the variable in dense mode grab the mutex either
 // directly or via `MaybeLockVariableInputMutexesInOrder` on all variables being
 // modified and then call `PrepareToUpdateVariable` on them in any order.
+//
+// With TF_RESOURCE_VARIABLE_SNAPSHOT_READS=1, dense reads in copy-on-write mode
+// also skip the mutex: writers publish the value they leave behind as a
+// snapshot, and readers alias the snapshot's tensor instead of the variable's.
+// The snapshot is one more alias of the buffer, so later writes copy before
+// updating and the published buffer never changes under a reader; a write
+// that takes long no longer blocks the reads issued meanwhile, which see the
+// previous value. Replaced snapshots are freed RCU-style, once the readers
+// that may still be loading them are done, which takes a few instructions
+// and never waits for a holder of the mutex. Code that modifies the tensor
+// through `tensor()` drops the snapshot, so that readers fall back to the
+// mutex until the next reader under the mutex publishes it again.
 class Var : public ResourceBase {
  public:
   explicit Var(DataType dtype) : tensor_(dtype) {}
@@ -71,12 +86,32 @@ class Var : public ResourceBase {
   // increasing mu() address.
   // TODO(ebrevdo): Use LockSet instead of exposing mu.
   mutex* mu() { return &mu_; }
-  Tensor* tensor() { return &tensor_; }
+  Tensor* tensor() {
+    DropSnapshot();
+    return &tensor_;
+  }
+
+  // Like `tensor()`, but keeps the published snapshot. Only for reads, and
+  // for writes that call `PublishSnapshot()` before releasing mu().
+  Tensor* tensor_keeping_snapshot() { return &tensor_; }
+
+  // Returns whether TF_RESOURCE_VARIABLE_SNAPSHOT_READS is set.
+  static bool SnapshotReadsEnabled();
+
+  // If a snapshot is published, sets `*out` to alias its tensor and returns
+  // true, otherwise returns false. Does not grab mu().
+  bool ReadSnapshot(Tensor* out);
+
+  // Publishes the current value of the variable as its snapshot, if snapshot
+  // reads are enabled and the variable is initialized in copy-on-write mode.
+  // REQUIRES: mu() held, in exclusive mode if the tensor was modified.
+  void PublishSnapshot();
 
   // Uninitializes the variable, by reverting the state of the tensor to
   // the state when the variable is first created.
   void Uninitialize() {
     // move frees the buffer of the tensor after unused goes out of scope.
+    DropSnapshot();
     Tensor unused = std::move(tensor_);
     is_initialized = false;
   }
@@ -104,10 +139,31 @@ class Var : public ResourceBase {
   std::atomic<bool> copy_on_read_mode{false};
 
  private:
+  struct Snapshot {
+    explicit Snapshot(const Tensor& t) : tensor(t) {}
+    const Tensor tensor;
+  };
+
+  void DropSnapshot() {
+    if (snapshot_.load(std::memory_order_acquire) != nullptr) {
+      SetSnapshot(nullptr);
+    }
+  }
+  // Publishes a snapshot of `*value`, or none if `value` is nullptr.
+  void SetSnapshot(const Tensor* value);
+
   mutex mu_;
   Tensor tensor_;
 
-  ~Var() override {}
+  // Serializes SetSnapshot().
+  mutex snapshot_mu_;
+  std::atomic<Snapshot*> snapshot_{nullptr};
+  // Readers register in snapshot_readers_[snapshot_epoch_ % 2] while they
+  // load snapshot_, and SetSnapshot() advances the epoch to wait for them.
+  std::atomic<uint32> snapshot_epoch_{0};
+  std::atomic<int> snapshot_readers_[2] = {{0}, {0}};
+
+  ~Var() override { delete snapshot_.load(std::memory_order_relaxed); }
   TF_DISALLOW_COPY_AND_ASSIGN(Var);
 };
 
@@ -15,6 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/framework/resource_var.h"
 
+#include <stdlib.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -34,5 +41,92 @@ TEST(ResourceVarTest, Uninitialize) {
   EXPECT_FALSE(var->is_initialized);
   EXPECT_TRUE(var->tensor()->data() == nullptr);
 }
+
+Tensor FilledTensor(int32 value) {
+  Tensor t(DT_INT32, TensorShape({16}));
+  t.flat<int32>().setConstant(value);
+  return t;
+}
+
+class ResourceVarSnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    setenv("TF_RESOURCE_VARIABLE_SNAPSHOT_READS", "1", 1);
+    ASSERT_TRUE(Var::SnapshotReadsEnabled());
+  }
+};
+
+TEST_F(ResourceVarSnapshotTest, PublishAndDrop) {
+  RefCountPtr<Var> var{new Var(DT_INT32)};
+  Tensor out;
+  var->PublishSnapshot();
+  EXPECT_FALSE(var->ReadSnapshot(&out));
+
+  *var->tensor() = FilledTensor(1);
+  var->is_initialized = true;
+  var->PublishSnapshot();
+  ASSERT_TRUE(var->ReadSnapshot(&out));
+  EXPECT_TRUE(out.SharesBufferWith(*var->tensor_keeping_snapshot()));
+
+  // Writes that publish leave the old snapshot to concurrent readers.
+  *var->tensor_keeping_snapshot() = FilledTensor(2);
+  ASSERT_TRUE(var->ReadSnapshot(&out));
+  EXPECT_EQ(out.flat<int32>()(0), 1);
+  var->PublishSnapshot();
+  ASSERT_TRUE(var->ReadSnapshot(&out));
+  EXPECT_EQ(out.flat<int32>()(0), 2);
+
+  // Any other access for writing drops it.
+  var->tensor();
+  EXPECT_FALSE(var->ReadSnapshot(&out));
+  var->PublishSnapshot();
+  EXPECT_TRUE(var->ReadSnapshot(&out));
+  var->Uninitialize();
+  EXPECT_FALSE(var->ReadSnapshot(&out));
+
+  // Nothing is published in copy-on-read mode.
+  *var->tensor() = FilledTensor(3);
+  var->is_initialized = true;
+  var->copy_on_read_mode.store(true);
+  var->PublishSnapshot();
+  EXPECT_FALSE(var->ReadSnapshot(&out));
+}
+
+TEST_F(ResourceVarSnapshotTest, ConcurrentReadsSeeWholeValues) {
+  RefCountPtr<Var> var{new Var(DT_INT32)};
+  *var->tensor() = FilledTensor(0);
+  var->is_initialized = true;
+  var->PublishSnapshot();
+  constexpr int kNumWrites = 2000;
+  std::atomic<bool> done(false);
+  std::vector<std::unique_ptr<Thread>> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back(
+        Env::Default()->StartThread({}, "reader", [&var, &done]() {
+          int32 last = 0;
+          while (!done.load()) {
+            Tensor out;
+            CHECK(var->ReadSnapshot(&out));
+            const auto values = out.flat<int32>();
+            CHECK_GE(values(0), last);
+            for (int j = 1; j < values.size(); ++j) {
+              CHECK_EQ(values(j), values(0));
+            }
+            last = values(0);
+          }
+        }));
+  }
+  for (int i = 1; i <= kNumWrites; ++i) {
+    mutex_lock l(*var->mu());
+    *var->tensor_keeping_snapshot() = FilledTensor(i);
+    var->PublishSnapshot();
+  }
+  done.store(true);
+  readers.clear();
+  Tensor out;
+  ASSERT_TRUE(var->ReadSnapshot(&out));
+  EXPECT_EQ(out.flat<int32>()(0), kNumWrites);
+}
+
 }  // namespace core
 }  // namespace tensorflow
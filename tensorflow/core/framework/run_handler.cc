@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/framework/run_handler.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <list>
 #include <memory>
@@ -28,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/denormal.h"
+#include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/setround.h"
@@ -52,14 +54,18 @@ RunHandlerEnvironment::RunHandlerEnvironment(
     : env_(env), thread_options_(thread_options), name_(name) {}
 
 RunHandlerEnvironment::EnvThread* RunHandlerEnvironment::CreateThread(
-    std::function<void()> f, const std::string& thread_name) {
-  return env_->StartThread(thread_options_, thread_name, [=]() {
+    std::function<void()> f, const std::string& thread_name, int numa_node) {
+  ThreadOptions thread_options = thread_options_;
+  if (numa_node != port::kNUMANoAffinity) {
+    thread_options.numa_node = numa_node;
+  }
+  return env_->StartThread(thread_options, thread_name, [=]() {
     // Set the processor flag to flush denormals to zero.
     port::ScopedFlushDenormal flush;
     // Set the processor rounding mode to ROUND TO NEAREST.
     port::ScopedSetRound round(FE_TONEAREST);
-    if (thread_options_.numa_node != port::kNUMANoAffinity) {
-      port::NUMASetThreadNodeAffinity(thread_options_.numa_node);
+    if (thread_options.numa_node != port::kNUMANoAffinity) {
+      port::NUMASetThreadNodeAffinity(thread_options.numa_node);
     }
     f();
   });
@@ -131,6 +137,7 @@ ThreadWorkSource::ThreadWorkSource()
       blocking_inflight_(0),
       non_blocking_inflight_(0),
       traceme_id_(0),
+      numa_node_(port::kNUMANoAffinity),
       version_(0),
       sub_thread_pool_waiter_(nullptr) {
   queue_waiters_.next = &queue_waiters_;
@@ -302,12 +309,21 @@ unsigned ThreadWorkSource::NonBlockingWorkShardingFactor() {
   return non_blocking_work_sharding_factor_;
 }
 
+int ThreadWorkSource::NumaNode() const {
+  return numa_node_.load(std::memory_order_relaxed);
+}
+
+void ThreadWorkSource::SetNumaNode(int numa_node) {
+  numa_node_.store(numa_node, std::memory_order_relaxed);
+}
+
 std::string ThreadWorkSource::ToString() {
   return strings::StrCat("traceme_id = ", GetTracemeId(),
                          ", inter queue size = ", TaskQueueSize(true),
                          ", inter inflight = ", GetInflightTaskCount(true),
                          ", intra queue size = ", TaskQueueSize(false),
-                         ", intra inflight = ", GetInflightTaskCount(false));
+                         ", intra inflight = ", GetInflightTaskCount(false),
+                         ", numa node = ", NumaNode());
 }
 
 RunHandlerThreadPool::RunHandlerThreadPool(
@@ -325,6 +341,7 @@ RunHandlerThreadPool::RunHandlerThreadPool(
       queue_waiters_(queue_waiters),
       use_sub_thread_pool_(ParamFromEnvBoolWithDefault(
           "TF_RUN_HANDLER_USE_SUB_THREAD_POOL", false)),
+      num_numa_nodes_(1),
       num_threads_in_sub_thread_pool_(ParamFromEnvWithDefault(
           "TF_RUN_HANDLER_NUM_THREADS_IN_SUB_THREAD_POOL",
           std::vector<int>({num_blocking_threads / 2,
@@ -336,9 +353,23 @@ RunHandlerThreadPool::RunHandlerThreadPool(
           "TF_RUN_HANDLER_SUB_THREAD_POOL_END_REQUEST_PERCENTAGE",
           std::vector<double>({0.4, 1}))) {
   thread_data_.resize(num_threads_);
+  if (ParamFromEnvBoolWithDefault("TF_RUN_HANDLER_USE_NUMA_AFFINITY", false) &&
+      port::NUMAEnabled() && port::NUMANumNodes() > 1) {
+    num_numa_nodes_ = port::NUMANumNodes();
+    // Spread the blocking and the non-blocking threads evenly over the nodes,
+    // giving each node a contiguous range of thread ids.
+    for (int i = 0; i < num_blocking_threads_; ++i) {
+      thread_data_[i].numa_node = i * num_numa_nodes_ / num_blocking_threads_;
+    }
+    for (int i = 0; i < num_non_blocking_threads_; ++i) {
+      thread_data_[num_blocking_threads_ + i].numa_node =
+          i * num_numa_nodes_ / num_non_blocking_threads_;
+    }
+  }
   VLOG(1) << "Creating RunHandlerThreadPool " << name << " with  "
           << num_blocking_threads_ << " blocking threads and "
-          << num_non_blocking_threads_ << " non-blocking threads.";
+          << num_non_blocking_threads_ << " non-blocking threads over "
+          << num_numa_nodes_ << " NUMA nodes.";
 }
 
 RunHandlerThreadPool::~RunHandlerThreadPool() {
@@ -377,15 +408,16 @@ void RunHandlerThreadPool::Start() {
         },
         is_blocking_thread
             ? strings::StrCat(name_, "_blocking_thread_", sub_thread_pool_id)
-            : strings::StrCat(name_, "_non_blocking_thread")));
+            : strings::StrCat(name_, "_non_blocking_thread"),
+        thread_data_[i].numa_node));
   }
 }
 
 void RunHandlerThreadPool::StartOneThreadForTesting() {
   cancelled_ = false;
   thread_data_[0].sub_thread_pool_id = 0;
-  thread_data_[0].thread.reset(
-      env_.CreateThread([this]() { WorkerLoop(0, true); }, name_));
+  thread_data_[0].thread.reset(env_.CreateThread(
+      [this]() { WorkerLoop(0, true); }, name_, thread_data_[0].numa_node));
 }
 
 void RunHandlerThreadPool::AddWorkToQueue(ThreadWorkSource* tws,
@@ -432,17 +464,30 @@ void RunHandlerThreadPool::SetThreadWorkSources(
     // thread_work_sources are order as start_request_idx, 0, 2, 4 ... 1, 3,
     // 5... for half of the threads and start_request_idx, 1, 3, 5 ... 0, 2,
     // 4... for the other half of the threads.
+    //
+    // If the thread is pinned to a NUMA node, the sources of requests on that
+    // node (or on no particular node) are ordered before the others, so that
+    // the thread only runs work of other nodes when its node has none.
     static const int num_shards =
         ParamFromEnvWithDefault("TF_RUN_HANDLER_QUEUE_SHARDS", 1);
-    int token = tid % num_shards;
-    for (int i = 0; i < num_shards; ++i) {
-      for (int j = token; j < thread_work_sources.size(); j += num_shards) {
-        if (j != start_request_idx) {
+    const int numa_node = thread_data_[tid].numa_node;
+    const int num_passes = numa_node == port::kNUMANoAffinity ? 1 : 2;
+    for (int pass = 0; pass < num_passes; ++pass) {
+      int token = tid % num_shards;
+      for (int i = 0; i < num_shards; ++i) {
+        for (int j = token; j < thread_work_sources.size(); j += num_shards) {
+          if (j == start_request_idx) continue;
+          if (num_passes > 1) {
+            const int source_node = thread_work_sources[j]->NumaNode();
+            const bool is_local = source_node == port::kNUMANoAffinity ||
+                                  source_node == numa_node;
+            if (is_local != (pass == 0)) continue;
+          }
           thread_data_[tid].new_thread_work_sources->emplace_back(
               thread_work_sources[j]);
         }
+        token = (token + 1) % num_shards;
       }
-      token = (token + 1) % num_shards;
     }
     thread_data_[tid].sources_not_empty.notify_all();
   }
@@ -473,6 +518,17 @@ int RunHandlerThreadPool::NumNonBlockingThreads() const {
   return num_non_blocking_threads_;
 }
 
+int RunHandlerThreadPool::NumNumaNodes() const { return num_numa_nodes_; }
+
+int RunHandlerThreadPool::NumaNode(int tid) const {
+  return thread_data_[tid].numa_node;
+}
+
+void RunHandlerThreadPool::SetNumaNodeForTesting(int tid, int numa_node) {
+  thread_data_[tid].numa_node = numa_node;
+  num_numa_nodes_ = std::max(num_numa_nodes_, numa_node + 1);
+}
+
 RunHandlerThreadPool::ThreadData::ThreadData()
     : new_version(0),
       current_index(0),
@@ -484,7 +540,8 @@ RunHandlerThreadPool::ThreadData::ThreadData()
       current_thread_work_sources(
           new Eigen::MaxSizeVector<ThreadWorkSource*>(static_cast<int32>(
               ParamFromEnvWithDefault("TF_RUN_HANDLER_MAX_CONCURRENT_HANDLERS",
-                                      kMaxConcurrentHandlers)))) {}
+                                      kMaxConcurrentHandlers)))),
+      numa_node(port::kNUMANoAffinity) {}
 
 Task RunHandlerThreadPool::FindTask(
     int searching_range_start, int searching_range_end, int thread_id,
@@ -740,6 +797,10 @@ class RunHandler::Impl {
   void ScheduleInterOpClosure(std::function<void()> fn);
   void ScheduleIntraOpClosure(std::function<void()> fn);
 
+  int64_t intra_op_time_ns() const {
+    return intra_op_time_ns_.load(std::memory_order_relaxed);
+  }
+
   void Reset(int64_t step_id,
              const RunOptions::Experimental::RunHandlerPoolOptions& options);
 
@@ -769,6 +830,7 @@ class RunHandler::Impl {
   std::unique_ptr<thread::ThreadPoolInterface> thread_pool_interface_;
   internal::ThreadWorkSource tws_;
   RunOptions::Experimental::RunHandlerPoolOptions options_;
+  std::atomic<int64_t> intra_op_time_ns_{0};
 };
 
 // Contains shared state across all run handlers present in the pool. Also
@@ -845,6 +907,10 @@ class RunHandlerPool::Impl {
     uint64 version;
     int num_active_requests;
     RunHandler::Impl* handler_impl;
+    const int caller_numa_node =
+        run_handler_thread_pool()->NumNumaNodes() > 1
+            ? port::NUMAGetThreadNodeAffinity()
+            : port::kNUMANoAffinity;
     {
       mutex_lock l(mu_);
       if (!has_free_handler()) {
@@ -870,6 +936,7 @@ class RunHandlerPool::Impl {
       // sorted_active_handlers_.
       handler_impl = free_handlers_.back();
       handler_impl->Reset(step_id, options);
+      handler_impl->tws()->SetNumaNode(ChooseNumaNode(caller_numa_node));
       free_handlers_.pop_back();
 
       num_active_requests = sorted_active_handlers_.size() + 1;
@@ -943,6 +1010,20 @@ class RunHandlerPool::Impl {
 
   void LogInfo() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Returns the NUMA node for a new request: `caller_numa_node`, the node of
+  // the calling thread, if it is pinned to one, and otherwise the node with
+  // the fewest active requests.
+  int ChooseNumaNode(int caller_numa_node) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Replaces the start requests in `request_idx_list`, chosen for the threads
+  // starting at `first_tid`, that are on another NUMA node than their thread
+  // by requests on the node of the thread, if there are any.
+  void AffineStartRequestsToNumaNodes(
+      int first_tid,
+      const Eigen::MaxSizeVector<internal::ThreadWorkSource*>&
+          thread_work_sources,
+      std::vector<int>* request_idx_list);
+
   // Maximum number of handlers pre-created during pool construction time. The
   // number has been chosen expecting each handler might at least want 1
   // inter-op thread for execution (during compute intensive workloads like
@@ -998,6 +1079,7 @@ void RunHandlerPool::Impl::RecomputePoolStats(
 
   std::vector<int> request_idx_list = ChooseRequestsWithExponentialDistribution(
       num_active_requests, num_blocking_threads);
+  AffineStartRequestsToNumaNodes(0, thread_work_sources, &request_idx_list);
   for (int i = 0; i < num_blocking_threads; ++i) {
     VLOG(2) << "Set work for tid=" << i
             << " with start_request_idx=" << request_idx_list[i];
@@ -1007,6 +1089,8 @@ void RunHandlerPool::Impl::RecomputePoolStats(
 
   request_idx_list = ChooseRequestsWithExponentialDistribution(
       num_active_requests, num_non_blocking_threads);
+  AffineStartRequestsToNumaNodes(num_blocking_threads, thread_work_sources,
+                                 &request_idx_list);
   for (int i = 0; i < num_non_blocking_threads; ++i) {
     VLOG(2) << "Set work for tid=" << (i + num_blocking_threads)
             << " with start_request_idx=" << request_idx_list[i];
@@ -1016,6 +1100,64 @@ void RunHandlerPool::Impl::RecomputePoolStats(
   }
 }
 
+int RunHandlerPool::Impl::ChooseNumaNode(int caller_numa_node) {
+  const int num_numa_nodes = run_handler_thread_pool()->NumNumaNodes();
+  if (num_numa_nodes <= 1) return port::kNUMANoAffinity;
+  if (caller_numa_node >= 0 && caller_numa_node < num_numa_nodes) {
+    return caller_numa_node;
+  }
+  std::vector<int> num_requests(num_numa_nodes, 0);
+  for (RunHandler::Impl* handler_impl : sorted_active_handlers_) {
+    const int numa_node = handler_impl->tws()->NumaNode();
+    if (numa_node >= 0 && numa_node < num_numa_nodes) ++num_requests[numa_node];
+  }
+  return std::min_element(num_requests.begin(), num_requests.end()) -
+         num_requests.begin();
+}
+
+void RunHandlerPool::Impl::AffineStartRequestsToNumaNodes(
+    int first_tid,
+    const Eigen::MaxSizeVector<internal::ThreadWorkSource*>&
+        thread_work_sources,
+    std::vector<int>* request_idx_list) {
+  const int num_numa_nodes = run_handler_thread_pool()->NumNumaNodes();
+  if (num_numa_nodes <= 1) return;
+
+  // The requests on each node, in priority order.
+  std::vector<std::vector<int>> node_requests(num_numa_nodes);
+  for (int i = 0; i < thread_work_sources.size(); ++i) {
+    const int numa_node = thread_work_sources[i]->NumaNode();
+    if (numa_node >= 0 && numa_node < num_numa_nodes) {
+      node_requests[numa_node].push_back(i);
+    }
+  }
+  std::vector<int> node_threads(num_numa_nodes, 0);
+  const int num_threads = request_idx_list->size();
+  for (int i = 0; i < num_threads; ++i) {
+    const int numa_node = run_handler_thread_pool()->NumaNode(first_tid + i);
+    if (numa_node >= 0 && numa_node < num_numa_nodes) ++node_threads[numa_node];
+  }
+  // Distribute the threads of each node over the requests of the node with
+  // the same exponential preference for earlier requests as across nodes.
+  std::vector<std::vector<int>> node_choices(num_numa_nodes);
+  for (int n = 0; n < num_numa_nodes; ++n) {
+    if (!node_requests[n].empty() && node_threads[n] > 0) {
+      node_choices[n] = ChooseRequestsWithExponentialDistribution(
+          node_requests[n].size(), node_threads[n]);
+    }
+  }
+  std::vector<int> next_choice(num_numa_nodes, 0);
+  for (int i = 0; i < num_threads; ++i) {
+    const int numa_node = run_handler_thread_pool()->NumaNode(first_tid + i);
+    if (numa_node < 0 || numa_node >= num_numa_nodes ||
+        node_choices[numa_node].empty()) {
+      continue;
+    }
+    const int choice = node_choices[numa_node][next_choice[numa_node]++];
+    (*request_idx_list)[i] = node_requests[numa_node][choice];
+  }
+}
+
 void RunHandlerPool::Impl::LogInfo() {
   if (iterations_++ % 50000 == 10 && VLOG_IS_ON(1)) {
     int num_active_requests = sorted_active_handlers_.size();
@@ -1071,8 +1213,13 @@ void RunHandler::Impl::ScheduleInterOpClosure(std::function<void()> fn) {
 
 void RunHandler::Impl::ScheduleIntraOpClosure(std::function<void()> fn) {
   VLOG(3) << "Scheduling intra work for " << tws()->GetTracemeId();
-  pool_impl_->run_handler_thread_pool()->AddWorkToQueue(tws(), false,
-                                                        std::move(fn));
+  pool_impl_->run_handler_thread_pool()->AddWorkToQueue(
+      tws(), false, [this, fn = std::move(fn)]() {
+        const uint64 start_ns = EnvTime::NowNanos();
+        fn();
+        intra_op_time_ns_.fetch_add(EnvTime::NowNanos() - start_ns,
+                                    std::memory_order_relaxed);
+      });
 }
 
 void RunHandler::Impl::Reset(
@@ -1080,6 +1227,7 @@ void RunHandler::Impl::Reset(
     const RunOptions::Experimental::RunHandlerPoolOptions& options) {
   start_time_us_ = tensorflow::Env::Default()->NowMicros();
   step_id_ = step_id;
+  intra_op_time_ns_.store(0, std::memory_order_relaxed);
   options_ = options;
   tws_.SetTracemeId(step_id);
 }
@@ -1114,6 +1262,12 @@ thread::ThreadPoolInterface* RunHandler::AsIntraThreadPoolInterface() {
   return impl_->thread_pool_interface();
 }
 
+int RunHandler::numa_node() const { return impl_->tws()->NumaNode(); }
+
+int64_t RunHandler::intra_op_time_ns() const {
+  return impl_->intra_op_time_ns();
+}
+
 RunHandler::~RunHandler() { impl_->pool_impl()->ReleaseHandler(impl_); }
 
 }  // namespace tensorflow
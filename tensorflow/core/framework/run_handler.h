@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/histogram/histogram.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 
@@ -90,12 +91,27 @@ class RunHandlerPool {
 // pool since it maintains a global view across all sessions and optimizes pool
 // scheduling to improve (median and tail) latency.
 //
+// When the environment variable TF_RUN_HANDLER_USE_NUMA_AFFINITY is set on a
+// host with several NUMA nodes, the threads of the pool are pinned to the
+// nodes, and each handler is affined to the node of the thread that called
+// RunHandlerPool::Get() (or to the least loaded node if that thread is not
+// pinned). Threads prefer work from the handlers of their own node, and only
+// run work of other nodes when there is none on theirs.
+//
 // This class is thread safe.
 class RunHandler {
  public:
   void ScheduleInterOpClosure(std::function<void()> fn);
   thread::ThreadPoolInterface* AsIntraThreadPoolInterface();
 
+  // Returns the NUMA node this handler is affined to, or
+  // port::kNUMANoAffinity.
+  int numa_node() const;
+
+  // Returns the time spent in the intra-op closures that completed since the
+  // handler was obtained, e.g. to attribute it to the request of the step.
+  int64_t intra_op_time_ns() const;
+
   ~RunHandler();
 
  private:
@@ -129,8 +145,10 @@ class RunHandlerEnvironment {
   RunHandlerEnvironment(Env* env, const ThreadOptions& thread_options,
                         const string& name);
 
+  // Starts a thread running `f`. If `numa_node` is not port::kNUMANoAffinity
+  // it overrides the NUMA node of the thread options.
   EnvThread* CreateThread(std::function<void()> f,
-                          const std::string& thread_name);
+                          const std::string& thread_name, int numa_node);
 
   Task CreateTask(std::function<void()> f);
 
@@ -184,6 +202,12 @@ class ThreadWorkSource {
 
   unsigned NonBlockingWorkShardingFactor();
 
+  // The NUMA node of the request this work source belongs to, or
+  // port::kNUMANoAffinity.
+  int NumaNode() const;
+
+  void SetNumaNode(int numa_node);
+
   std::string ToString();
 
  private:
@@ -205,6 +229,7 @@ class ThreadWorkSource {
   mutex waiters_mu_;
   Waiter queue_waiters_ TF_GUARDED_BY(waiters_mu_);
   std::atomic<int64_t> traceme_id_;
+  std::atomic<int> numa_node_;
 
   mutex run_handler_waiter_mu_;
   uint64 version_ TF_GUARDED_BY(run_handler_waiter_mu_);
@@ -237,7 +262,8 @@ class RunHandlerThreadPool {
 
   // Set work queues from which the thread 'tid' can steal its work.
   // The request with start_request_idx will be attempted first. Other requests
-  // will be attempted in FIFO order based on their arrival time.
+  // will be attempted in FIFO order based on their arrival time, those on the
+  // NUMA node of the thread before those on other nodes.
   void SetThreadWorkSources(
       int tid, int start_request_idx, uint64 version,
       const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources);
@@ -252,6 +278,16 @@ class RunHandlerThreadPool {
 
   int NumNonBlockingThreads() const;
 
+  // Returns the number of NUMA nodes the threads are spread over, which is 1
+  // unless NUMA affinity is enabled.
+  int NumNumaNodes() const;
+
+  // Returns the NUMA node thread 'tid' is pinned to, or port::kNUMANoAffinity.
+  int NumaNode(int tid) const;
+
+  // Must be called before the threads are started.
+  void SetNumaNodeForTesting(int tid, int numa_node);
+
   void WorkerLoop(int thread_id, bool may_steal_blocking_work);
 
   // Search tasks from Requets range searching_range_start to
@@ -286,6 +322,9 @@ class RunHandlerThreadPool {
         current_thread_work_sources;
 
     int sub_thread_pool_id;
+
+    // The NUMA node the thread is pinned to.
+    int numa_node;
   };
 
   const int num_threads_;
@@ -299,6 +338,7 @@ class RunHandlerThreadPool {
   Eigen::MaxSizeVector<Waiter>* queue_waiters_;
 
   bool use_sub_thread_pool_;
+  int num_numa_nodes_;
   std::vector<int> num_threads_in_sub_thread_pool_;
 
   // Threads in each sub thread pool will search tasks from the given
@@ -583,6 +583,58 @@ TEST(RunHandlerThreadPool, MultipleSubThreadPool) {
   delete run_handler_thread_pool;
 }
 
+TEST(RunHandlerThreadPool, PrefersRequestsOnThreadNumaNode) {
+  setenv("TF_RUN_HANDLER_USE_SUB_THREAD_POOL", "false", true);
+
+  Eigen::MaxSizeVector<mutex> waiters_mu(1);
+  waiters_mu.resize(1);
+  Eigen::MaxSizeVector<internal::Waiter> waiters(1);
+  waiters.resize(1);
+  internal::RunHandlerThreadPool* run_handler_thread_pool =
+      new internal::RunHandlerThreadPool(
+          /*num_blocking_threads=*/1, /*num_non_blocking_threads=*/0,
+          Env::Default(), ThreadOptions(), "tf_run_handler_pool", &waiters_mu,
+          &waiters);
+  run_handler_thread_pool->SetNumaNodeForTesting(/*tid=*/0, /*numa_node=*/1);
+  EXPECT_EQ(run_handler_thread_pool->NumNumaNodes(), 2);
+
+  // Requests 1 and 3 are on the node of the thread.
+  Eigen::MaxSizeVector<internal::ThreadWorkSource*> thread_work_sources(4);
+  thread_work_sources.resize(4);
+  internal::ThreadWorkSource tws[4];
+  for (int i = 0; i < 4; ++i) {
+    tws[i].SetWaiter(1, &waiters[0], &waiters_mu[0]);
+    tws[i].SetNumaNode(i % 2);
+    thread_work_sources[i] = &tws[i];
+  }
+
+  mutex mu;
+  std::vector<int> order;
+  BlockingCounter counter(4);
+  for (int i = 0; i < 4; ++i) {
+    run_handler_thread_pool->AddWorkToQueue(&tws[i], /*is_blocking=*/true,
+                                            [&mu, &order, &counter, i] {
+                                              {
+                                                mutex_lock l(mu);
+                                                order.push_back(i);
+                                              }
+                                              counter.DecrementCount();
+                                            });
+  }
+  run_handler_thread_pool->SetThreadWorkSources(
+      /*tid=*/0, /*start_request_idx=*/3, /*version=*/1, thread_work_sources);
+  run_handler_thread_pool->StartOneThreadForTesting();
+  counter.Wait();
+
+  // The start request first, then the other request on the node, then the
+  // requests on the other node in arrival order.
+  {
+    mutex_lock l(mu);
+    EXPECT_EQ(order, std::vector<int>({3, 1, 0, 2}));
+  }
+  delete run_handler_thread_pool;
+}
+
 SessionOptions DefaultSessionOptions() {
   SessionOptions options;
   (*options.config.mutable_device_count())["CPU"] = 2;
@@ -23,6 +23,9 @@ limitations under the License.
 //   default constructors and destructors when T is not a simple type
 //   (e.g., string.), and skips them otherwise.
 //
+// * InlineBuffer: holds the data of a small tensor of a simple type in the
+//   same heap allocation as the buffer itself.
+//
 // * Helper<T>: provides various routines given type T.  The routines
 //   includes running the constructor and destructor of T[], encoding
 //   an decoding T[] into/from a Cord, etc.
@@ -154,6 +157,77 @@ bool MemoryLoggingEnabled() {
   return memory_logging_enabled;
 }
 
+// Tensors of simple types with at most this many bytes, which are allocated by
+// the base CPU allocator, store their data inline in an `InlineBuffer`.
+constexpr size_t kMaxInlineBufferBytes = 16;
+
+// A ref-counted buffer whose data immediately follows it in a single
+// port::AlignedMalloc() allocation. Creating and destroying a small tensor then
+// costs one heap allocation rather than two, and skips the allocator.
+class InlineBuffer : public TensorBuffer {
+ public:
+  // Returns a new buffer of `num_bytes` <= kMaxInlineBufferBytes bytes, whose
+  // contents are uninitialized.
+  static InlineBuffer* New(size_t num_bytes) {
+    DCHECK_LE(num_bytes, kMaxInlineBufferBytes);
+    // The data follows the buffer at an offset that keeps it aligned as
+    // strictly as that of any other tensor.
+    const size_t data_offset =
+        (sizeof(InlineBuffer) + EIGEN_MAX_ALIGN_BYTES - 1) /
+        EIGEN_MAX_ALIGN_BYTES * EIGEN_MAX_ALIGN_BYTES;
+    void* ptr = port::AlignedMalloc(data_offset + kMaxInlineBufferBytes,
+                                    EIGEN_MAX_ALIGN_BYTES);
+    CHECK(ptr != nullptr) << "Failed to allocate an inline tensor buffer";
+    return new (ptr) InlineBuffer(static_cast<char*>(ptr) + data_offset,
+                                  num_bytes);
+  }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+
+  bool GetAllocatedBytes(size_t* out_bytes) const override { return false; }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    // The memory comes from the same heap as that of the base CPU allocator,
+    // which is the allocator the tensor was requested from.
+    proto->set_requested_bytes(size());
+    proto->set_allocator_name(cpu_allocator_base()->Name());
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+  // The buffer is at the start of its allocation, so it owns the memory it is
+  // constructed in.
+  static void operator delete(void* ptr) { port::AlignedFree(ptr); }
+  static void operator delete(void*, void*) {
+    // Some compilers require an overridden class-specific deallocation
+    // function, which will be called if placement `new` throws an exception.
+  }
+
+ private:
+  InlineBuffer(void* data, size_t size) : TensorBuffer(data), size_(size) {}
+  ~InlineBuffer() override {}
+
+  const size_t size_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InlineBuffer);
+};
+
+// Returns a new InlineBuffer for `num_elements` elements of `type` if a tensor
+// with that many elements, requested from `a`, may be stored inline, and
+// nullptr otherwise. Tensors are only stored inline when nothing observes the
+// allocations of `a`, since inline buffers bypass it.
+TensorBuffer* MaybeNewInlineBuffer(Allocator* a, DataType type,
+                                   int64_t num_elements) {
+  if (!DataTypeCanUseMemcpy(type)) return nullptr;
+  const size_t num_bytes = num_elements * DataTypeSize(type);
+  if (num_bytes == 0 || num_bytes > kMaxInlineBufferBytes) return nullptr;
+  if (a != cpu_allocator_base() || CPUAllocatorStatsEnabled() ||
+      MemoryLoggingEnabled()) {
+    return nullptr;
+  }
+  return InlineBuffer::New(num_bytes);
+}
+
 // A set of helper functions depending on T.
 template <typename T>
 struct Helper {
@@ -812,7 +886,10 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape)
   set_dtype(type);
   CHECK_NOTNULL(a);
   if (shape_.num_elements() > 0 || a->AllocatesOpaqueHandle()) {
-    CASES(type, buf_ = new Buffer<T>(a, shape.num_elements()));
+    buf_ = MaybeNewInlineBuffer(a, type, shape_.num_elements());
+    if (buf_ == nullptr) {
+      CASES(type, buf_ = new Buffer<T>(a, shape.num_elements()));
+    }
   }
   if (MemoryLoggingEnabled() && buf_ != nullptr && buf_->data() != nullptr) {
     LogMemory::RecordTensorAllocation("Unknown", LogMemory::UNKNOWN_STEP_ID,
@@ -826,7 +903,13 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape,
   set_dtype(type);
   CHECK_NOTNULL(a);
   if (shape_.num_elements() > 0 || a->AllocatesOpaqueHandle()) {
-    CASES(type, buf_ = new Buffer<T>(a, shape.num_elements(), allocation_attr));
+    if (allocation_attr.freed_by_func == nullptr) {
+      buf_ = MaybeNewInlineBuffer(a, type, shape_.num_elements());
+    }
+    if (buf_ == nullptr) {
+      CASES(type,
+            buf_ = new Buffer<T>(a, shape.num_elements(), allocation_attr));
+    }
   }
   if (MemoryLoggingEnabled() && !allocation_attr.allocation_will_be_logged &&
       buf_ != nullptr && buf_->data() != nullptr) {
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/framework/tensor.h"
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
@@ -1491,6 +1493,45 @@ void BM_Assign(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_Assign);
 
+TEST(Tensor, SmallTensorsStoredInline) {
+  Tensor a(DT_INT32, TensorShape({4}));
+  EXPECT_TRUE(a.IsAligned());
+  EXPECT_EQ(a.TotalBytes(), 16);
+  test::FillIota<int32>(&a, 0);
+  Tensor b = a;
+  EXPECT_TRUE(b.SharesBufferWith(a));
+  b.vec<int32>()(3) = 7;
+  test::ExpectTensorEqual<int32>(a, test::AsTensor<int32>({0, 1, 2, 7}));
+
+  TensorDescription tensor_desc;
+  a.FillDescription(&tensor_desc);
+  EXPECT_EQ(tensor_desc.allocation_description().allocator_name(),
+            cpu_allocator_base()->Name());
+  EXPECT_EQ(tensor_desc.allocation_description().requested_bytes(), 16);
+
+  // Slices of an inline tensor refer to its buffer.
+  Tensor c = a.Slice(1, 3);
+  EXPECT_TRUE(c.SharesBufferWith(a));
+  test::ExpectTensorEqual<int32>(c, test::AsTensor<int32>({1, 2}));
+
+  // Larger tensors and non-simple types are unaffected.
+  Tensor d(DT_INT32, TensorShape({5}));
+  d.flat<int32>().setZero();
+  Tensor e(DT_STRING, TensorShape({1}));
+  EXPECT_EQ(e.flat<tstring>()(0), "");
+}
+
+// Benchmark creating and destroying a small vector, as produced by shape ops.
+void BM_CreateAndDestroySmallVector(::testing::benchmark::State& state) {
+  TensorShape shape({4});
+  Allocator* allocator = cpu_allocator();
+  for (auto s : state) {
+    Tensor a(allocator, DT_INT32, shape);
+    a.vec<int32>()(0) = 37;
+  }
+}
+BENCHMARK(BM_CreateAndDestroySmallVector);
+
 // Ensure tensor_data() works on empty tensors
 TEST(Tensor, EmptyTensorData) {
   Tensor empty;
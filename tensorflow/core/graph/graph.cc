@@ -546,18 +546,21 @@ void Graph::Copy(const Graph& src) {
 }
 
 Node* Graph::AddNode(NodeDef node_def, Status* status) {
-  const OpRegistrationData* op_reg_data;
-  status->Update(ops_.LookUp(node_def.op(), &op_reg_data));
+  PreparedNode prepared;
+  status->Update(PrepareNode(std::move(node_def), &prepared));
   if (!status->ok()) return nullptr;
+  return AddPreparedNode(std::move(prepared));
+}
+
+Status Graph::PrepareNode(NodeDef node_def, PreparedNode* prepared) const {
+  const OpRegistrationData* op_reg_data;
+  TF_RETURN_IF_ERROR(ops_.LookUp(node_def.op(), &op_reg_data));
 
   DataTypeVector inputs;
   DataTypeVector outputs;
-  status->Update(
-      InOutTypesForNode(node_def, op_reg_data->op_def, &inputs, &outputs));
-  if (!status->ok()) {
-    *status = AttachDef(*status, node_def);
-    return nullptr;
-  }
+  Status status =
+      InOutTypesForNode(node_def, op_reg_data->op_def, &inputs, &outputs);
+  if (!status.ok()) return AttachDef(status, node_def);
 
   Node::NodeClass node_class = op_reg_data->is_function_op
                                    ? Node::NC_FUNCTION_OP
@@ -568,9 +571,8 @@ Node* Graph::AddNode(NodeDef node_def, Status* status) {
     const auto ctor_type =
         full_type::SpecializeType(AttrSlice(node_def), op_reg_data->op_def);
     if (!ctor_type.ok()) {
-      *status = errors::InvalidArgument("type error: ",
-                                        ctor_type.status().ToString());
-      return nullptr;
+      return errors::InvalidArgument("type error: ",
+                                     ctor_type.status().ToString());
     }
     const FullTypeDef ctor_typedef = ctor_type.ValueOrDie();
     if (ctor_typedef.type_id() != TFT_UNSET) {
@@ -580,11 +582,15 @@ Node* Graph::AddNode(NodeDef node_def, Status* status) {
     VLOG(3) << "AddNode: no type constructor for " << node_def.name();
   }
 
-  Node* node = AllocateNode(std::make_shared<NodeProperties>(
-                                &op_reg_data->op_def, std::move(node_def),
-                                inputs, outputs, op_reg_data->fwd_type_fn),
-                            nullptr, node_class);
-  return node;
+  prepared->props = std::make_shared<NodeProperties>(
+      &op_reg_data->op_def, std::move(node_def), inputs, outputs,
+      op_reg_data->fwd_type_fn);
+  prepared->node_class = node_class;
+  return Status::OK();
+}
+
+Node* Graph::AddPreparedNode(PreparedNode prepared) {
+  return AllocateNode(std::move(prepared.props), nullptr, prepared.node_class);
 }
 
 Node* Graph::CopyNode(const Node* node) {
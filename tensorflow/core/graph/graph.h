@@ -550,6 +550,22 @@ class Graph {
   // Returns nullptr and sets *status on error.
   Node* AddNode(NodeDef node_def, Status* status);
 
+  // A node that has been prepared for addition to this graph by
+  // PrepareNode().
+  struct PreparedNode {
+    std::shared_ptr<NodeProperties> props;
+    Node::NodeClass node_class;
+  };
+
+  // Performs the part of AddNode() that does not modify the graph: infers the
+  // Op and input/output types for the node. Unlike AddNode(), this may be
+  // called concurrently from several threads.
+  Status PrepareNode(NodeDef node_def, PreparedNode* prepared) const;
+
+  // Adds a node prepared by PrepareNode() on this graph, and returns it.
+  // *this owns the returned instance.
+  Node* AddPreparedNode(PreparedNode prepared);
+
   // Copies *node, which may belong to another graph, to a new node,
   // which is returned.  Does not copy any edges.  *this owns the
   // returned instance.
@@ -0,0 +1,76 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/robust_stats.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+
+Status FitOpCostCalibration(const OpPerformanceList& measurements,
+                            const OpLevelCostEstimator& estimator,
+                            int min_samples, OpCostCalibration* calibration) {
+  if (min_samples < 1) {
+    return errors::InvalidArgument("min_samples must be positive, got ",
+                                   min_samples);
+  }
+
+  // The ratios are fitted in log space, so that a kernel twice as fast as
+  // predicted weighs as much as one twice as slow.
+  std::map<std::pair<string, string>, std::vector<double>> log_ratios;
+  for (const OpPerformance& measurement : measurements.op_performance()) {
+    if (measurement.compute_cost() <= 0) continue;
+    OpContext op_context;
+    op_context.name = measurement.node();
+    op_context.op_info = measurement.op();
+    const Costs costs = estimator.PredictCosts(op_context);
+    if (costs.inaccurate || costs.execution_time.count() <= 0) {
+      VLOG(2) << "Skipping the measurement of " << measurement.node()
+              << " without an accurate prediction";
+      continue;
+    }
+    log_ratios[{measurement.op().op(), measurement.op().device().type()}]
+        .push_back(std::log(static_cast<double>(measurement.compute_cost()) /
+                            costs.execution_time.count()));
+  }
+
+  calibration->Clear();
+  for (auto& op_and_ratios : log_ratios) {
+    const int num_samples = op_and_ratios.second.size();
+    if (num_samples < min_samples) continue;
+    const RobustStats stats(std::move(op_and_ratios.second));
+    OpCostCalibration::Entry* entry = calibration->add_entry();
+    entry->set_op(op_and_ratios.first.first);
+    entry->set_device_type(op_and_ratios.first.second);
+    entry->set_time_scale(std::exp(stats.mean()));
+    entry->set_num_samples(num_samples);
+    VLOG(1) << "Calibrated " << entry->op() << " on " << entry->device_type()
+            << " by " << entry->time_scale() << " from " << num_samples
+            << " measurements";
+  }
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
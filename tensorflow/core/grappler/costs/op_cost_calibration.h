@@ -0,0 +1,43 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
+
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Fits a correction factor of the predicted execution time for every op type
+// and device type in `measurements`, e.g. the output of
+// CostGraphToOpPerformanceData() for the cost graph of a profiled step. Each
+// factor is the robust geometric mean of the measured over the predicted
+// times of the op; op types with fewer than `min_samples` usable measurements
+// are left out. `estimator` should not be calibrated itself.
+//
+// The resulting calibration can be passed to
+// OpLevelCostEstimator::SetCalibration(), or written with WriteTextProto() or
+// WriteBinaryProto() to the file named by TF_GRAPPLER_COST_CALIBRATION_FILE.
+Status FitOpCostCalibration(const OpPerformanceList& measurements,
+                            const OpLevelCostEstimator& estimator,
+                            int min_samples, OpCostCalibration* calibration);
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
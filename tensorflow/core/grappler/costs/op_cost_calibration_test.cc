@@ -0,0 +1,111 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Returns an OpInfo for a MatMul of [m, k] by [k, n] float matrices on a CPU.
+OpInfo DescribeMatMul(int m, int k, int n) {
+  OpInfo op_info;
+  op_info.set_op("MatMul");
+  auto* device = op_info.mutable_device();
+  device->set_type("CPU");
+  device->set_num_cores(10);
+  device->set_bandwidth(10000000);  // 10000000 KB/s = 10 GB/s
+  device->set_frequency(1000);      // 1000 Mhz = 1 GHz
+  for (const auto& dims : {std::make_pair(m, k), std::make_pair(k, n)}) {
+    auto* input = op_info.add_inputs();
+    input->set_dtype(DT_FLOAT);
+    input->mutable_shape()->add_dim()->set_size(dims.first);
+    input->mutable_shape()->add_dim()->set_size(dims.second);
+  }
+  return op_info;
+}
+
+int64_t PredictedTime(const OpLevelCostEstimator& estimator,
+                      const OpInfo& op_info) {
+  OpContext op_context;
+  op_context.op_info = op_info;
+  return estimator.PredictCosts(op_context).execution_time.count();
+}
+
+TEST(OpCostCalibrationTest, FitsRobustScalePerOpType) {
+  OpLevelCostEstimator estimator;
+  estimator.SetCalibration(OpCostCalibration());
+
+  // Three measurements twice as slow as predicted and one outlier.
+  OpPerformanceList measurements;
+  const double scales[] = {2.0, 2.0, 2.0, 50.0};
+  int size = 64;
+  for (double scale : scales) {
+    OpPerformance* measurement = measurements.add_op_performance();
+    *measurement->mutable_op() = DescribeMatMul(size, size, size);
+    measurement->set_compute_cost(
+        scale * PredictedTime(estimator, measurement->op()));
+    size *= 2;
+  }
+
+  OpCostCalibration calibration;
+  TF_ASSERT_OK(FitOpCostCalibration(measurements, estimator,
+                                    /*min_samples=*/2, &calibration));
+  ASSERT_EQ(calibration.entry_size(), 1);
+  EXPECT_EQ(calibration.entry(0).op(), "MatMul");
+  EXPECT_EQ(calibration.entry(0).device_type(), "CPU");
+  EXPECT_EQ(calibration.entry(0).num_samples(), 4);
+  EXPECT_NEAR(calibration.entry(0).time_scale(), 2.0, 0.05);
+
+  const OpInfo op_info = DescribeMatMul(256, 256, 256);
+  const int64_t uncalibrated_time = PredictedTime(estimator, op_info);
+  estimator.SetCalibration(calibration);
+  EXPECT_NEAR(PredictedTime(estimator, op_info), 2 * uncalibrated_time,
+              0.05 * uncalibrated_time);
+
+  // Other device types keep the analytical costs.
+  OpInfo gpu_op_info = op_info;
+  gpu_op_info.mutable_device()->set_type("GPU");
+  estimator.SetCalibration(OpCostCalibration());
+  const int64_t uncalibrated_gpu_time = PredictedTime(estimator, gpu_op_info);
+  estimator.SetCalibration(calibration);
+  EXPECT_EQ(PredictedTime(estimator, gpu_op_info), uncalibrated_gpu_time);
+}
+
+TEST(OpCostCalibrationTest, SkipsOpsWithTooFewSamples) {
+  OpLevelCostEstimator estimator;
+  estimator.SetCalibration(OpCostCalibration());
+
+  OpPerformanceList measurements;
+  OpPerformance* measurement = measurements.add_op_performance();
+  *measurement->mutable_op() = DescribeMatMul(64, 64, 64);
+  measurement->set_compute_cost(1000);
+
+  OpCostCalibration calibration;
+  TF_ASSERT_OK(FitOpCostCalibration(measurements, estimator,
+                                    /*min_samples=*/2, &calibration));
+  EXPECT_EQ(calibration.entry_size(), 0);
+  EXPECT_TRUE(errors::IsInvalidArgument(FitOpCostCalibration(
+      measurements, estimator, /*min_samples=*/0, &calibration)));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
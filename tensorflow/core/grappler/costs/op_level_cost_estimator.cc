@@ -26,7 +26,9 @@ limitations under the License.
 #include "tensorflow/core/grappler/clusters/utils.h"
 #include "tensorflow/core/grappler/costs/op_context.h"
 #include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/overflow.h"
 
 namespace tensorflow {
@@ -316,6 +318,30 @@ bool IsEinsumCorrectlyFormed(const OpContext& einsum_context) {
   return true;
 }
 
+// Returns the calibration read from TF_GRAPPLER_COST_CALIBRATION_FILE, or
+// nullptr if the variable isn't set or the file can't be read. The file is
+// only read once per process.
+const OpCostCalibration* CalibrationFromEnv() {
+  static const OpCostCalibration* calibration = []() -> OpCostCalibration* {
+    string path;
+    TF_CHECK_OK(ReadStringFromEnvVar("TF_GRAPPLER_COST_CALIBRATION_FILE", "",
+                                     &path));
+    if (path.empty()) return nullptr;
+    auto* calibration = new OpCostCalibration();
+    Status status = ReadTextOrBinaryProto(Env::Default(), path, calibration);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to read the op cost calibration from " << path
+                   << ": " << status;
+      delete calibration;
+      return nullptr;
+    }
+    VLOG(1) << "Read " << calibration->entry_size()
+            << " op cost calibration entries from " << path;
+    return calibration;
+  }();
+  return calibration;
+}
+
 }  // namespace
 
 // Return a minimum shape if the shape is unknown. If known, return the original
@@ -646,6 +672,36 @@ OpLevelCostEstimator::OpLevelCostEstimator() {
 
   // By default, use sum of memory_time and compute_time for execution_time.
   compute_memory_overlap_ = false;
+
+  const OpCostCalibration* calibration = CalibrationFromEnv();
+  if (calibration != nullptr) SetCalibration(*calibration);
+}
+
+void OpLevelCostEstimator::SetCalibration(
+    const OpCostCalibration& calibration) {
+  time_scales_.clear();
+  for (const auto& entry : calibration.entry()) {
+    if (entry.time_scale() <= 0) continue;
+    time_scales_[{entry.op(), entry.device_type()}] = entry.time_scale();
+  }
+}
+
+void OpLevelCostEstimator::CalibrateCosts(const OpInfo& op_info,
+                                          Costs* costs) const {
+  if (time_scales_.empty()) return;
+  auto it = time_scales_.find({op_info.op(), op_info.device().type()});
+  if (it == time_scales_.end()) return;
+  const double scale = it->second;
+  auto scale_duration = [scale](Costs::Duration* duration) {
+    *duration = Costs::Duration(
+        static_cast<int64_t>(std::round(duration->count() * scale)));
+  };
+  scale_duration(&costs->execution_time);
+  scale_duration(&costs->compute_time);
+  scale_duration(&costs->memory_time);
+  scale_duration(&costs->intermediate_memory_time);
+  scale_duration(&costs->intermediate_memory_read_time);
+  scale_duration(&costs->intermediate_memory_write_time);
 }
 
 Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
@@ -653,7 +709,9 @@ Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
   NodeCosts node_costs;
   if (PredictNodeCosts(op_context, &node_costs).ok()) {
     if (node_costs.has_costs) {
-      return node_costs.costs;
+      costs = node_costs.costs;
+      CalibrateCosts(op_context.op_info, &costs);
+      return costs;
     }
     // Convert NodeCosts to Costs.
     if (node_costs.minimum_cost_op) {
@@ -684,6 +742,7 @@ Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
     costs.num_ops_with_unknown_shapes =
         node_costs.num_nodes_with_unknown_shapes;
     costs.num_ops_total = node_costs.num_nodes;
+    CalibrateCosts(op_context.op_info, &costs);
     return costs;
   }
   // Errors during node cost estimate.
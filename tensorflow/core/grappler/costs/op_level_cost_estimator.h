@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_OP_LEVEL_COST_ESTIMATOR_H_
 #define TENSORFLOW_CORE_GRAPPLER_COSTS_OP_LEVEL_COST_ESTIMATOR_H_
 
+#include <map>
 #include <numeric>
+#include <utility>
 
 #include "tensorflow/core/grappler/costs/cost_estimator.h"
 #include "tensorflow/core/grappler/costs/op_context.h"
@@ -98,6 +100,12 @@ class OpLevelCostEstimator {
   // Returns basic device performance info.
   virtual DeviceInfo GetDeviceInfo(const DeviceProperties& device) const;
 
+  // Scales the predicted times of the ops in `calibration` by their fitted
+  // correction factors, replacing any previous calibration. By default the
+  // calibration is read from the file named by the
+  // TF_GRAPPLER_COST_CALIBRATION_FILE environment variable, if set.
+  void SetCalibration(const OpCostCalibration& calibration);
+
  protected:
   // TODO(dyoon): Consider to remove PredictOpCountBasedCosts() with OpInfo.
   // Naive cost estimate based on the given operations count and total
@@ -320,8 +328,13 @@ class OpLevelCostEstimator {
   // compute_time and memory_time, instead of sum of those two.
   bool compute_memory_overlap_;
   std::set<string> persistent_ops_;
+  // Correction factors of the predicted times, keyed by op and device type.
+  std::map<std::pair<string, string>, double> time_scales_;
 
  private:
+  // Applies the calibrated correction factor of the op, if any, to `costs`.
+  void CalibrateCosts(const OpInfo& op_info, Costs* costs) const;
+
   friend class OpLevelCostEstimatorTest;
 };
 
@@ -55,6 +55,7 @@ limitations under the License.
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/strided_slice_op.h"
 
@@ -194,6 +195,18 @@ bool GetElementUnexhaustive(const Tensor& t, int i, const std::set<int>& dtypes,
   }
 }
 
+// Returns true if lossy round trips of casts, e.g. float -> bfloat16 -> float,
+// should be removed, which changes the values of the graph.
+bool FoldLossyRoundTripCasts() {
+  static const bool fold_lossy_round_trip_casts = [] {
+    bool fold = false;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_GRAPPLER_FOLD_LOSSY_ROUND_TRIP_CASTS",
+                                   /*default_val=*/false, &fold));
+    return fold;
+  }();
+  return fold_lossy_round_trip_casts;
+}
+
 bool NodeIsOnCpu(const NodeDef& node) {
   string task;
   string device;
@@ -1404,6 +1417,241 @@ class RemoveRedundantCastStage : public ArithmeticOptimizerStage {
   }
 };
 
+// Folds a Cast of a Cast, e.g. the bfloat16 -> float -> bfloat16 round trips
+// that the mixed precision rewrite leaves between ops. If the first Cast is
+// exact, i.e. all values of its source type are representable in its
+// destination type, the second Cast can read the source directly:
+//   Cast(Cast(x, mid_type), dst_type) => Cast(x, dst_type)
+// and a round trip back to the type of x is removed altogether. Lossy round
+// trips, e.g. float -> bfloat16 -> float, change the values, and are only
+// removed if `fold_lossy_round_trips` is set.
+class FoldCastChainStage : public ArithmeticOptimizerStage {
+ public:
+  explicit FoldCastChainStage(const GraphOptimizerContext& ctx,
+                              const ArithmeticOptimizerContext& ctx_ext,
+                              bool fold_lossy_round_trips)
+      : ArithmeticOptimizerStage("FoldCastChain", ctx, ctx_ext),
+        fold_lossy_round_trips_(fold_lossy_round_trips) {}
+  ~FoldCastChainStage() override = default;
+
+  bool IsSupported(const NodeDef* node) const override {
+    return IsCast(*node) && !IsInPreserveSet(*node);
+  }
+
+  Status TrySimplify(NodeDef* node, string* simplified_node_name) override {
+    TF_RETURN_IF_ERROR(EnsureNodeIsSupported(node));
+
+    NodeDef* producer;
+    TF_RETURN_IF_ERROR(GetInputNode(node->input(0), &producer));
+    if (!IsCast(*producer) || HasControlInputs(*producer) ||
+        producer->device() != node->device()) {
+      return Status::OK();
+    }
+    DataType src_type;
+    TF_RETURN_IF_ERROR(GetNodeAttr(*producer, "SrcT", &src_type));
+    DataType mid_type;
+    TF_RETURN_IF_ERROR(GetNodeAttr(*producer, "DstT", &mid_type));
+    DataType dst_type;
+    TF_RETURN_IF_ERROR(GetNodeAttr(*node, "DstT", &dst_type));
+
+    const bool is_exact = IsExactCast(src_type, mid_type);
+    if (dst_type == src_type && (is_exact || fold_lossy_round_trips_)) {
+      *simplified_node_name = producer->input(0);
+      return Status::OK();
+    }
+    if (!is_exact) return Status::OK();
+
+    // Make sure there is a kernel registered for the Cast from src_type.
+    AttrValueMap attrs = node->attr();
+    SetAttrValue(src_type, &attrs["SrcT"]);
+    if (!IsKernelRegisteredForNode(node->name(),
+                                   node->has_experimental_debug_info(),
+                                   node->experimental_debug_info(), node->op(),
+                                   node->device(), AttrSlice(&attrs))
+             .ok()) {
+      return Status::OK();
+    }
+    ctx().node_map->UpdateInput(node->name(), node->input(0),
+                                producer->input(0));
+    node->set_input(0, producer->input(0));
+    SetDataTypeToAttr(src_type, "SrcT", node);
+    *simplified_node_name = node->name();
+    return Status::OK();
+  }
+
+ private:
+  // Returns the number of significand bits of a floating point or complex
+  // type, or 0 for other types.
+  static int SignificandBits(DataType dtype) {
+    switch (dtype) {
+      case DT_BFLOAT16:
+        return 8;
+      case DT_HALF:
+        return 11;
+      case DT_FLOAT:
+      case DT_COMPLEX64:
+        return 24;
+      case DT_DOUBLE:
+      case DT_COMPLEX128:
+        return 53;
+      default:
+        return 0;
+    }
+  }
+
+  // Returns the number of exponent bits of a floating point or complex type.
+  static int ExponentBits(DataType dtype) {
+    switch (dtype) {
+      case DT_HALF:
+        return 5;
+      case DT_DOUBLE:
+      case DT_COMPLEX128:
+        return 11;
+      default:
+        return 8;
+    }
+  }
+
+  // Returns true if all values of `src` are representable in `dst`.
+  static bool IsExactCast(DataType src, DataType dst) {
+    if (src == dst) return true;
+    const bool dst_is_integer = DataTypeIsInteger(dst);
+    const bool dst_is_floating = SignificandBits(dst) > 0;
+    if (src == DT_BOOL) return dst_is_integer || dst_is_floating;
+    if (DataTypeIsInteger(src)) {
+      const bool src_is_signed = !DataTypeIsUnsigned(src);
+      const int src_bits = 8 * DataTypeSize(src) - (src_is_signed ? 1 : 0);
+      if (dst_is_floating) return SignificandBits(dst) >= src_bits;
+      if (!dst_is_integer) return false;
+      const bool dst_is_signed = !DataTypeIsUnsigned(dst);
+      const int dst_bits = 8 * DataTypeSize(dst) - (dst_is_signed ? 1 : 0);
+      return (dst_is_signed || !src_is_signed) && dst_bits >= src_bits;
+    }
+    if (SignificandBits(src) > 0 && dst_is_floating) {
+      // A complex number doesn't survive a cast to a real type.
+      return (!DataTypeIsComplex(src) || DataTypeIsComplex(dst)) &&
+             SignificandBits(dst) >= SignificandBits(src) &&
+             ExponentBits(dst) >= ExponentBits(src);
+    }
+    return false;
+  }
+
+  const bool fold_lossy_round_trips_;
+};
+
+// Runs an op that the mixed precision rewrite, or user code, sandwiched
+// between casts from and back to a 16-bit float type
+//   Cast(Op(Cast(x, float), Cast(y, float)), bfloat16)
+// directly on the 16-bit inputs
+//   Op(x, y)
+// which saves the memory passes of the casts. This is only done for the ops
+// whose 16-bit kernels compute in float and round the result once, so that
+// the values are unchanged: the elementwise ops, BiasAdd, the bfloat16 Sum on
+// CPU and the half Mean on GPU, which accumulate in float.
+class FoldCastsIntoComputeStage : public ArithmeticOptimizerStage {
+ public:
+  explicit FoldCastsIntoComputeStage(const GraphOptimizerContext& ctx,
+                                     const ArithmeticOptimizerContext& ctx_ext)
+      : ArithmeticOptimizerStage("FoldCastsIntoCompute", ctx, ctx_ext) {}
+  ~FoldCastsIntoComputeStage() override = default;
+
+  bool IsSupported(const NodeDef* node) const override {
+    return IsCast(*node) && !IsInPreserveSet(*node);
+  }
+
+  Status TrySimplify(NodeDef* node, string* simplified_node_name) override {
+    TF_RETURN_IF_ERROR(EnsureNodeIsSupported(node));
+
+    // Truncating casts to the 16-bit type round differently than the
+    // 16-bit kernels.
+    bool truncate = false;
+    DataType src_type;
+    TF_RETURN_IF_ERROR(GetNodeAttr(*node, "SrcT", &src_type));
+    DataType dst_type;
+    TF_RETURN_IF_ERROR(GetNodeAttr(*node, "DstT", &dst_type));
+    if (src_type != DT_FLOAT ||
+        (dst_type != DT_BFLOAT16 && dst_type != DT_HALF) ||
+        (TryGetNodeAttr(*node, "Truncate", &truncate) && truncate)) {
+      return Status::OK();
+    }
+
+    NodeDef* compute;
+    TF_RETURN_IF_ERROR(GetInputNode(node->input(0), &compute));
+    const int num_cast_inputs = NumCastInputs(*compute, dst_type);
+    if (num_cast_inputs == 0 || IsInPreserveSet(*compute) ||
+        compute->device() != node->device() ||
+        NumNonControlDataOutputs(*compute, *ctx().node_map) != 1) {
+      return Status::OK();
+    }
+    DataType compute_type;
+    if (!TryGetNodeAttr(*compute, "T", &compute_type) ||
+        compute_type != DT_FLOAT) {
+      return Status::OK();
+    }
+
+    std::vector<string> narrow_inputs;
+    for (int i = 0; i < num_cast_inputs; ++i) {
+      if (i >= compute->input_size() || IsControlInput(compute->input(i))) {
+        return Status::OK();
+      }
+      NodeDef* cast;
+      TF_RETURN_IF_ERROR(GetInputNode(compute->input(i), &cast));
+      DataType cast_src_type;
+      if (!IsCast(*cast) || cast->device() != node->device() ||
+          !TryGetNodeAttr(*cast, "SrcT", &cast_src_type) ||
+          cast_src_type != dst_type) {
+        return Status::OK();
+      }
+      narrow_inputs.push_back(cast->input(0));
+    }
+
+    const string optimized_node_name =
+        OptimizedNodeName(ParseNodeScopeAndName(compute->name()));
+    if (ctx().node_map->NodeExists(optimized_node_name)) {
+      return Status::OK();
+    }
+    AttrValueMap attrs = compute->attr();
+    SetAttrValue(dst_type, &attrs["T"]);
+    if (!IsKernelRegisteredForNode(compute->name(),
+                                   compute->has_experimental_debug_info(),
+                                   compute->experimental_debug_info(),
+                                   compute->op(), compute->device(),
+                                   AttrSlice(&attrs))
+             .ok()) {
+      return Status::OK();
+    }
+
+    NodeDef* new_compute = AddCopyNode(optimized_node_name, compute);
+    for (int i = 0; i < num_cast_inputs; ++i) {
+      new_compute->set_input(i, narrow_inputs[i]);
+    }
+    SetDataTypeToAttr(dst_type, "T", new_compute);
+    for (const string& input : new_compute->input()) {
+      ctx().node_map->AddOutput(NodeName(input), new_compute->name());
+    }
+    *simplified_node_name = new_compute->name();
+    return Status::OK();
+  }
+
+ private:
+  // Returns the number of leading inputs of `node` that can read tensors of
+  // `dtype` instead of float, or 0 if the op can't run on `dtype` without
+  // changing its values.
+  static int NumCastInputs(const NodeDef& node, DataType dtype) {
+    if (IsAdd(node) || IsSub(node) || IsMul(node) || IsBiasAdd(node) ||
+        IsMaximum(node) || IsMinimum(node)) {
+      return 2;
+    }
+    if (IsRelu(node) || IsRelu6(node) || IsNeg(node) ||
+        node.op() == "Abs") {
+      return 1;
+    }
+    if (IsSum(node) && dtype == DT_BFLOAT16 && NodeIsOnCpu(node)) return 1;
+    if (IsMean(node) && dtype == DT_HALF && NodeIsOnGpu(&node)) return 1;
+    return 0;
+  }
+};
+
 class RemoveNegationStage : public ArithmeticOptimizerStage {
  public:
   explicit RemoveNegationStage(const GraphOptimizerContext& ctx,
@@ -4325,6 +4573,12 @@ Status ArithmeticOptimizer::SimplifyArithmeticOps(bool can_use_shapes) {
     pipeline.AddStage<RemoveRedundantBitcastStage>(ctx, ctx_ext);
   if (options_.remove_redundant_cast)
     pipeline.AddStage<RemoveRedundantCastStage>(ctx, ctx_ext);
+  if (options_.fold_cast_chains)
+    pipeline.AddStage<FoldCastChainStage>(
+        ctx, ctx_ext,
+        options_.fold_lossy_round_trip_casts || FoldLossyRoundTripCasts());
+  if (options_.fold_casts_into_compute)
+    pipeline.AddStage<FoldCastsIntoComputeStage>(ctx, ctx_ext);
   if (options_.replace_pack_with_tile_reshape)
     pipeline.AddStage<ReplacePackWithTileReshape>(ctx, ctx_ext);
   if (options_.replace_mul_with_tile && can_use_shapes)
@@ -88,6 +88,11 @@ class ArithmeticOptimizer : public GraphOptimizer {
     bool simplify_aggregation = true;
     bool simplify_embedding_lookup = true;
     bool remove_cast_into_segment_reduction = true;
+    bool fold_cast_chains = true;
+    bool fold_casts_into_compute = true;
+    // Also remove round trips of casts that lose precision. Can be turned on
+    // with TF_GRAPPLER_FOLD_LOSSY_ROUND_TRIP_CASTS as well.
+    bool fold_lossy_round_trip_casts = false;
 
     // Choose which arithmetic optimizer stages will be enabled for a given
     // optimization level by default.
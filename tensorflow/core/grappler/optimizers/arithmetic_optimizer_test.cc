@@ -2342,6 +2342,148 @@ TEST_F(ArithmeticOptimizerTest, RemoveRedundantCast) {
   test::ExpectTensorEqual<int8>(tensors[0], tensors_expected[0]);
 }
 
+TEST_F(ArithmeticOptimizerTest, FoldCastChains) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/CPU:0");
+  Output bf16 = ops::Placeholder(s.WithOpName("bf16"), DT_BFLOAT16,
+                                 ops::Placeholder::Shape({4}));
+  Output int8 = ops::Placeholder(s.WithOpName("int8"), DT_INT8,
+                                 ops::Placeholder::Shape({4}));
+  Output fp32 = ops::Placeholder(s.WithOpName("fp32"), DT_FLOAT,
+                                 ops::Placeholder::Shape({4}));
+  // An exact round trip, removed.
+  Output round_trip = ops::Cast(
+      s.WithOpName("round_trip"),
+      ops::Cast(s.WithOpName("bf16_to_fp32"), bf16, DT_FLOAT), DT_BFLOAT16);
+  // An exact cast followed by another one, folded into a single cast.
+  Output widened = ops::Cast(
+      s.WithOpName("widened"),
+      ops::Cast(s.WithOpName("int8_to_int32"), int8, DT_INT32), DT_FLOAT);
+  // A lossy round trip, kept.
+  Output lossy = ops::Cast(
+      s.WithOpName("lossy"),
+      ops::Cast(s.WithOpName("fp32_to_bf16"), fp32, DT_BFLOAT16), DT_FLOAT);
+  Output out_round_trip =
+      ops::Identity(s.WithOpName("out_round_trip"), round_trip);
+  Output out_widened = ops::Identity(s.WithOpName("out_widened"), widened);
+  Output out_lossy = ops::Identity(s.WithOpName("out_lossy"), lossy);
+
+  GrapplerItem item;
+  item.fetch = {"out_round_trip", "out_widened", "out_lossy"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  auto bf16_tensor = test::AsTensor<bfloat16>(
+      {bfloat16(1.5f), bfloat16(-3.0f), bfloat16(0.1f), bfloat16(1e30f)});
+  auto int8_tensor = test::AsTensor<int8>({-128, -1, 0, 127});
+  auto fp32_tensor = test::AsTensor<float>({1.0f, 0.1f, -2.5f, 3.14159f});
+  item.feed = {
+      {"bf16", bf16_tensor}, {"int8", int8_tensor}, {"fp32", fp32_tensor}};
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 3);
+
+  GraphDef output;
+  ArithmeticOptimizer optimizer;
+  EnableOnlyFoldCastChains(&optimizer);
+  OptimizeAndPrune(&optimizer, &item, &output);
+  NodeMap node_map(&output);
+
+  EXPECT_TRUE(IsNodesDirectlyConnected(node_map, "bf16", "out_round_trip"));
+  const NodeDef* widened_node = node_map.GetNode("widened");
+  ASSERT_NE(widened_node, nullptr);
+  ASSERT_EQ(widened_node->input_size(), 1);
+  EXPECT_EQ(widened_node->input(0), "int8");
+  EXPECT_EQ(widened_node->attr().at("SrcT").type(), DT_INT8);
+  EXPECT_EQ(node_map.GetNode("int8_to_int32"), nullptr);
+  EXPECT_TRUE(IsNodesDirectlyConnected(node_map, "fp32_to_bf16", "lossy"));
+  EXPECT_EQ(CountOpNodes(output, "Cast"), 3);
+
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 3);
+  test::ExpectTensorEqual<bfloat16>(tensors[0], tensors_expected[0]);
+  test::ExpectTensorEqual<float>(tensors[1], tensors_expected[1]);
+  test::ExpectTensorEqual<float>(tensors[2], tensors_expected[2]);
+
+  // Lossy round trips are removed on request.
+  ArithmeticOptimizer lossy_optimizer;
+  EnableOnlyFoldCastChains(&lossy_optimizer,
+                           /*fold_lossy_round_trip_casts=*/true);
+  output.Clear();
+  OptimizeAndPrune(&lossy_optimizer, &item, &output);
+  NodeMap lossy_node_map(&output);
+  EXPECT_TRUE(IsNodesDirectlyConnected(lossy_node_map, "fp32", "out_lossy"));
+  EXPECT_EQ(CountOpNodes(output, "Cast"), 1);
+}
+
+TEST_F(ArithmeticOptimizerTest, FoldCastsIntoCompute) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/CPU:0");
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_BFLOAT16,
+                              ops::Placeholder::Shape({2, 3}));
+  Output y = ops::Placeholder(s.WithOpName("y"), DT_BFLOAT16,
+                              ops::Placeholder::Shape({2, 3}));
+  Output x_fp32 = ops::Cast(s.WithOpName("x_fp32"), x, DT_FLOAT);
+  Output y_fp32 = ops::Cast(s.WithOpName("y_fp32"), y, DT_FLOAT);
+  Output add = ops::AddV2(s.WithOpName("add"), x_fp32, y_fp32);
+  Output add_bf16 = ops::Cast(s.WithOpName("add_bf16"), add, DT_BFLOAT16);
+  Output axis = ops::Const(s.WithOpName("axis"), 1, {});
+  Output sum = ops::Sum(s.WithOpName("sum"), x_fp32, axis);
+  Output sum_bf16 = ops::Cast(s.WithOpName("sum_bf16"), sum, DT_BFLOAT16);
+  // The float result of Mul is used, so Mul keeps running in float.
+  Output mul = ops::Mul(s.WithOpName("mul"), x_fp32, y_fp32);
+  Output mul_bf16 = ops::Cast(s.WithOpName("mul_bf16"), mul, DT_BFLOAT16);
+  Output out_add = ops::Identity(s.WithOpName("out_add"), add_bf16);
+  Output out_sum = ops::Identity(s.WithOpName("out_sum"), sum_bf16);
+  Output out_mul = ops::Identity(s.WithOpName("out_mul"), mul_bf16);
+  Output out_mul_fp32 = ops::Identity(s.WithOpName("out_mul_fp32"), mul);
+
+  GrapplerItem item;
+  item.fetch = {"out_add", "out_sum", "out_mul", "out_mul_fp32"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  auto x_t = test::AsTensor<bfloat16>(
+      {bfloat16(1.5f), bfloat16(-3.0f), bfloat16(0.1f), bfloat16(7.0f),
+       bfloat16(1e3f), bfloat16(0.3f)},
+      TensorShape({2, 3}));
+  auto y_t = test::AsTensor<bfloat16>(
+      {bfloat16(2.0f), bfloat16(0.7f), bfloat16(-0.1f), bfloat16(1e-3f),
+       bfloat16(3.0f), bfloat16(0.9f)},
+      TensorShape({2, 3}));
+  item.feed = {{"x", x_t}, {"y", y_t}};
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 4);
+
+  GraphDef output;
+  ArithmeticOptimizer optimizer;
+  EnableOnlyFoldCastsIntoCompute(&optimizer);
+  OptimizeAndPrune(&optimizer, &item, &output);
+  NodeMap node_map(&output);
+
+  const string p = "ArithmeticOptimizer/FoldCastsIntoCompute_";
+  const NodeDef* new_add = node_map.GetNode(absl::StrCat(p, "add"));
+  ASSERT_NE(new_add, nullptr);
+  ASSERT_EQ(new_add->input_size(), 2);
+  EXPECT_EQ(new_add->input(0), "x");
+  EXPECT_EQ(new_add->input(1), "y");
+  EXPECT_EQ(new_add->attr().at("T").type(), DT_BFLOAT16);
+  EXPECT_TRUE(IsNodesDirectlyConnected(node_map, new_add->name(), "out_add"));
+
+  const NodeDef* new_sum = node_map.GetNode(absl::StrCat(p, "sum"));
+  ASSERT_NE(new_sum, nullptr);
+  ASSERT_EQ(new_sum->input_size(), 2);
+  EXPECT_EQ(new_sum->input(0), "x");
+  EXPECT_EQ(new_sum->input(1), "axis");
+  EXPECT_EQ(new_sum->attr().at("T").type(), DT_BFLOAT16);
+  EXPECT_TRUE(IsNodesDirectlyConnected(node_map, new_sum->name(), "out_sum"));
+
+  EXPECT_EQ(node_map.GetNode(absl::StrCat(p, "mul")), nullptr);
+  EXPECT_TRUE(IsNodesDirectlyConnected(node_map, "mul_bf16", "out_mul"));
+
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 4);
+  for (int i = 0; i < 3; ++i) {
+    test::ExpectTensorEqual<bfloat16>(tensors[i], tensors_expected[i]);
+  }
+  test::ExpectTensorEqual<float>(tensors[3], tensors_expected[3]);
+}
+
 TEST_F(ArithmeticOptimizerTest, AddOpsRewriteAddOpsOfIdenticalShape) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   tensorflow::Scope sx = s.NewSubScope("x");
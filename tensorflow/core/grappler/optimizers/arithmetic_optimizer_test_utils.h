@@ -249,6 +249,19 @@ class ArithmeticOptimizerTest : public GrapplerTest {
     optimizer->options_.remove_cast_into_segment_reduction = true;
   }
 
+  void EnableOnlyFoldCastChains(ArithmeticOptimizer* optimizer,
+                                bool fold_lossy_round_trip_casts = false) {
+    DisableAllStages(optimizer);
+    optimizer->options_.fold_cast_chains = true;
+    optimizer->options_.fold_lossy_round_trip_casts =
+        fold_lossy_round_trip_casts;
+  }
+
+  void EnableOnlyFoldCastsIntoCompute(ArithmeticOptimizer* optimizer) {
+    DisableAllStages(optimizer);
+    optimizer->options_.fold_casts_into_compute = true;
+  }
+
  private:
   void DisableAllStages(ArithmeticOptimizer* optimizer) {
     ArithmeticOptimizer::ArithmeticOptimizerOptions options;
@@ -279,6 +292,8 @@ class ArithmeticOptimizerTest : public GrapplerTest {
     options.unary_ops_composition = false;
     options.simplify_embedding_lookup = false;
     options.remove_cast_into_segment_reduction = false;
+    options.fold_cast_chains = false;
+    options.fold_casts_into_compute = false;
     optimizer->options_ = options;
   }
 };
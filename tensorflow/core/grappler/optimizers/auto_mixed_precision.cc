@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 
 #include <fstream>
+#include <map>
 #include <memory>
 
 #include "absl/container/flat_hash_map.h"
@@ -1010,6 +1011,8 @@ class AutoMixedPrecisionImpl {
                                                              cudnn_version_);
       case AutoMixedPrecisionMode::MKL:
         return std::make_unique<AutoMixedPrecisionListsMkl>();
+      case AutoMixedPrecisionMode::CPU_BF16:
+        return std::make_unique<AutoMixedPrecisionListsCpuBf16>();
       case AutoMixedPrecisionMode::CPU:
         // Note: this is not a typo here. AutoMixedPrecisionListsCuda is used
         // intentionally to make CPU and GPU have the same fp16 ops.
@@ -1316,12 +1319,13 @@ Status AutoMixedPrecisionImpl::Optimize() {
       "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_LEVEL", "", &optimization_level));
   optimization_level = absl::AsciiStrToUpper(optimization_level);
   force_all_fp16_ = optimization_level == "UNSAFE_FORCE_ALL";
-  if (force_all_fp16_ && mode_ == AutoMixedPrecisionMode::MKL) {
+  if (force_all_fp16_ && (mode_ == AutoMixedPrecisionMode::MKL ||
+                          mode_ == AutoMixedPrecisionMode::CPU_BF16)) {
     // Many ops do not support bfloat16 on the CPU so we disallowing forcing to
     // bfloat16.
     return errors::InvalidArgument(
         "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_LEVEL cannot be set to "
-        "UNSAFE_FORCE_ALL when MKL is used");
+        "UNSAFE_FORCE_ALL when converting to bfloat16 on CPU");
   }
 
   std::unique_ptr<AutoMixedPrecisionLists> mp_lists =
@@ -1347,6 +1351,7 @@ Status AutoMixedPrecisionImpl::Optimize() {
         break;
       case AutoMixedPrecisionMode::MKL:
       case AutoMixedPrecisionMode::CPU:
+      case AutoMixedPrecisionMode::CPU_BF16:
         should_process = !MustPreserve(node) && IsOnDevice(node, DEVICE_CPU);
         break;
     }
@@ -1774,15 +1779,20 @@ void AutoMixedPrecisionImpl::PropagateAllowThroughClear(
 void AutoMixedPrecisionImpl::AddInferToAllowIfFollowAllow(
     const absl::flat_hash_set<int>& deny_set,
     absl::flat_hash_set<int>* allow_set) const {
-  // Currently only target for MKL
-  if (mode_ != AutoMixedPrecisionMode::MKL) {
+  // Currently only target for bfloat16 on CPU, where it saves the pair of
+  // casts around the bias and activation following every allowlist op.
+  if (mode_ != AutoMixedPrecisionMode::MKL &&
+      mode_ != AutoMixedPrecisionMode::CPU_BF16) {
     return;
   }
+  // Without MKL, only the ops with a bfloat16 kernel can run in bfloat16.
+  const bool requires_kernel = mode_ == AutoMixedPrecisionMode::CPU_BF16;
   for (int item_idx = 0; item_idx < graph_type_view_.num_nodes(); ++item_idx) {
     const NodeTypeId& item = *graph_type_view_.GetNode(item_idx);
     if (!ShouldProcess(*item.node) || deny_set.count(item_idx) ||
         allow_set->count(item_idx) || !f16_inferlist_.count(item.node->op()) ||
-        !IsFloat32(item) || !SupportsF16DataType(item)) {
+        !IsFloat32(item) ||
+        !(requires_kernel ? SupportsF16(item) : SupportsF16DataType(item))) {
       continue;
     }
 
@@ -2094,6 +2104,10 @@ Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
 
   VLOG(1) << "Setting emulate_f16 = " << emulate_f16;
 
+  // Per op type: the number of float32 type attributes, and how many of them
+  // were painted allow. Only collected for the VLOG(1) report.
+  std::map<string, std::pair<int, int>> allow_painted_per_op;
+
   for (int node_idx = 0; node_idx < num_nodes_preop; ++node_idx) {
     NodeDef* node = graph_->mutable_node(node_idx);
     for (const TypeAttrId& type_attr : node_type_map_.GetTypeAttrs(*node)) {
@@ -2107,6 +2121,11 @@ Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
       int node_type_idx = maybe_node_type_idx.value();
       if (!IsFloat32(*graph_type_view_.GetNode(node_type_idx))) continue;
       bool src_is_allow = allow_set.count(node_type_idx);
+      if (VLOG_IS_ON(1)) {
+        auto& counts = allow_painted_per_op[node->op()];
+        ++counts.first;
+        if (src_is_allow) ++counts.second;
+      }
 
       // Include output ports of fp32 nodes, real fp16 nodes,
       // and the fp16 Cast nodes at the fanout of emulated fp16 ops.
@@ -2173,6 +2192,14 @@ Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
             << " nodes to " << type_str << " precision using "
             << num_nonvar_casts_to_f16_ << " cast(s) to " << type_str
             << " (excluding Const and Variable casts)";
+  if (VLOG_IS_ON(1)) {
+    VLOG(1) << "Type attributes painted " << type_str << " per op type:";
+    for (const auto& op_and_counts : allow_painted_per_op) {
+      VLOG(1) << "  " << op_and_counts.first << ": "
+              << op_and_counts.second.second << "/"
+              << op_and_counts.second.first;
+    }
+  }
   return Status::OK();
 }
 
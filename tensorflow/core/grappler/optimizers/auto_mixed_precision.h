@@ -26,7 +26,8 @@ namespace grappler {
 // CUDA: convert to float16 on GPU
 // MKL: convert to bfloat16 on CPU
 // CPU: emulate float16 on CPU without changing operator kernel
-enum class AutoMixedPrecisionMode { CUDA, MKL, CPU };
+// CPU_BF16: convert to bfloat16 on CPU using the default (non-MKL) kernels
+enum class AutoMixedPrecisionMode { CUDA, MKL, CPU, CPU_BF16 };
 
 // Convert data types to float16 or bfloat16 where appropriate to improve
 // performance on GPUs or CPUs.
@@ -34,7 +35,8 @@ class AutoMixedPrecision : public GraphOptimizer {
  public:
   // If 'mode' is CUDA, converts nodes to float16 on Nvidia GPUs. If MKL,
   // converts nodes to bfloat16 on CPUs in order to take advantage of MKL
-  // performance improvements with bfloat16.
+  // performance improvements with bfloat16. If CPU_BF16, converts nodes to
+  // bfloat16 on CPUs only where the default CPU kernels support it.
   explicit AutoMixedPrecision(
       AutoMixedPrecisionMode mode = AutoMixedPrecisionMode::CUDA)
       : mode_(mode) {}
@@ -49,6 +51,8 @@ class AutoMixedPrecision : public GraphOptimizer {
         return "auto_mixed_precision_mkl";
       case AutoMixedPrecisionMode::CPU:
         return "auto_mixed_precision_cpu";
+      case AutoMixedPrecisionMode::CPU_BF16:
+        return "auto_mixed_precision_cpu_bf16";
       default:
         LOG(FATAL) << "Invalid value for AutoMixedPrecisionMode: "  // Crash Ok
                    << static_cast<int>(mode_);
@@ -548,6 +548,59 @@ class AutoMixedPrecisionListsMkl : public AutoMixedPrecisionLists {
   }
 };
 
+// Lists for converting to bfloat16 on CPU without MKL. The deny list and the
+// clear list are shared with MKL; clear list ops without a bfloat16 CPU kernel
+// are skipped by the optimizer.
+class AutoMixedPrecisionListsCpuBf16 : public AutoMixedPrecisionListsMkl {
+ public:
+  AutoMixedPrecisionListsCpuBf16() {}
+
+  // Only ops whose default CPU kernels are registered for bfloat16 should be
+  // added to the allow list or infer list. Conv2D and its gradients have no
+  // such kernel without MKL.
+  gtl::FlatSet<string> AllowList() override {
+    auto list = gtl::FlatSet<string>{"BatchMatMul", "BatchMatMulV2", "Conv3D",
+                                     "MatMul"};
+    UpdateList("ALLOWLIST", &list);
+    return list;
+  }
+
+  gtl::FlatSet<string> InferList() override {
+    auto list = gtl::FlatSet<string>{"Add",
+                                     "AddV2",
+                                     "BiasAdd",
+                                     "BiasAddGrad",
+                                     "BiasAddV1",
+                                     "Elu",
+                                     "EluGrad",
+                                     "Erf",
+                                     "LeakyRelu",
+                                     "LeakyReluGrad",
+                                     "Log",
+                                     "Log1p",
+                                     "LogSoftmax",
+                                     "Mul",
+                                     "RealDiv",
+                                     "Reciprocal",
+                                     "Rsqrt",
+                                     "Selu",
+                                     "SeluGrad",
+                                     "Sigmoid",
+                                     "SigmoidGrad",
+                                     "Softmax",
+                                     "Softplus",
+                                     "SoftplusGrad",
+                                     "Softsign",
+                                     "SoftsignGrad",
+                                     "Sqrt",
+                                     "Sub",
+                                     "Tanh",
+                                     "TanhGrad"};
+    UpdateList("INFERLIST", &list);
+    return list;
+  }
+};
+
 }  // end namespace grappler
 }  // end namespace tensorflow
 
@@ -201,73 +201,103 @@ Status CommonSubgraphElimination::DedupComputations(GraphDef* optimized_graph) {
     }
   }
 
-  std::vector<bool> can_dedup(optimized_graph->node_size());
-  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+  const int num_nodes = optimized_graph->node_size();
+  std::vector<bool> can_dedup(num_nodes);
+  absl::flat_hash_map<const NodeDef*, int> node_to_idx;
+  node_to_idx.reserve(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
     const NodeDef& node = optimized_graph->node(i);
     can_dedup[i] = (feeds_inplace_op.find(&node) == feeds_inplace_op.end()) &&
                    CanDedup(node);
+    node_to_idx[&node] = i;
   }
 
-  bool stop = true;
-  std::set<int> duplicates;
+  // The nodes are visited once, in topological order, so the inputs of a
+  // node have been deduped when it is visited, and are renamed then. Only the
+  // fanouts visited before their inputs, through back edges, are renamed
+  // when their inputs are deduped and visited again. A node's signature is
+  // computed when it is visited and recomputed only if its inputs change, so
+  // the optimization takes linear time in the size of the graph.
+  std::vector<bool> visited(num_nodes);
+  std::vector<bool> is_duplicate(num_nodes);
+  std::vector<int> duplicates;
+  // Revisited in topological order, so that the choice of representatives
+  // doesn't depend on the order of the fanouts in the node map.
+  std::set<int> to_revisit;
+  // Maps the name of each duplicate to that of its representative.
+  absl::flat_hash_map<string, string> representatives;
   UniqueNodes nodes;
   NodeMap node_map(optimized_graph);
-  do {
-    stop = true;
-    for (int i = 0; i < optimized_graph->node_size(); ++i) {
-      if (!can_dedup[i] || duplicates.find(i) != duplicates.end()) {
-        continue;
+
+  // Renames the inputs of `node` that are duplicates to their
+  // representatives, and returns true if any was renamed.
+  const auto rename_inputs = [&](NodeDef* node) {
+    bool renamed = false;
+    for (int i = 0; i < node->input_size(); ++i) {
+      const TensorId input = ParseTensorName(node->input(i));
+      auto it = representatives.find(input.node());
+      if (it == representatives.end()) continue;
+      // The representative may itself have been deduped since.
+      const string* rep = &it->second;
+      for (it = representatives.find(*rep); it != representatives.end();
+           it = representatives.find(*rep)) {
+        rep = &it->second;
       }
-      NodeDef* node = optimized_graph->mutable_node(i);
-      NodeDef* rep = nodes.FindOrAddRepresentative(node);
-      if (rep == node) {
-        continue;
+      if (!renamed) {
+        // The signature of the node will change. Remove it from nodes.
+        nodes.RemoveRepresentative(node);
+        renamed = true;
       }
-      // Make a copy since we mutate the set below.
-      const auto fanouts = node_map.GetOutputs(node->name());
-      for (NodeDef* fanout : fanouts) {
-        // Update consumers of node.
-        bool updated_fanout = false;
-        for (int i = 0; i < fanout->input_size(); ++i) {
-          string* fanout_input = fanout->mutable_input(i);
-
-          const int position =
-              NodePositionIfSameNode(*fanout_input, node->name());
-          // Update name in-place.
-          if (position < -1) {
-            continue;
-          } else {
-            if (!updated_fanout) {
-              // The signature of the fanout node will change. Remove it from
-              // nodes.
-              nodes.RemoveRepresentative(fanout);
-            }
-            updated_fanout = true;
-            if (position > 0) {
-              *fanout_input = StrCat(rep->name(), ":", position);
-            } else if (position == 0) {
-              *fanout_input = rep->name();
-            } else {
-              *fanout_input = StrCat("^", rep->name());
-            }
-          }
-        }
-        if (updated_fanout) {
-          node_map.UpdateInput(fanout->name(), node->name(), rep->name());
-          CanonicalizeNode(fanout);
-        }
+      node_map.UpdateInput(node->name(), string(input.node()), *rep);
+      if (input.index() > 0) {
+        *node->mutable_input(i) = StrCat(*rep, ":", input.index());
+      } else if (input.index() == 0) {
+        *node->mutable_input(i) = *rep;
+      } else {
+        *node->mutable_input(i) = StrCat("^", *rep);
       }
-      if (fetch_nodes_known_) {
-        node->Clear();
+    }
+    if (renamed) CanonicalizeNode(node);
+    return renamed;
+  };
+
+  // Dedups the node at index `i`, whose inputs are up to date.
+  const auto dedup = [&](int i) {
+    if (!can_dedup[i] || is_duplicate[i]) return;
+    NodeDef* node = optimized_graph->mutable_node(i);
+    NodeDef* rep = nodes.FindOrAddRepresentative(node);
+    if (rep == node) return;
+    representatives[node->name()] = rep->name();
+    // Make a copy since renaming mutates the set.
+    const auto& fanout_set = node_map.GetOutputs(node->name());
+    const std::vector<NodeDef*> fanouts(fanout_set.begin(), fanout_set.end());
+    for (NodeDef* fanout : fanouts) {
+      const int fanout_idx = node_to_idx[fanout];
+      if (visited[fanout_idx] && rename_inputs(fanout)) {
+        to_revisit.insert(fanout_idx);
       }
-      duplicates.insert(i);
-      stop = false;
     }
-  } while (!stop);
+    if (fetch_nodes_known_) {
+      node->Clear();
+    }
+    is_duplicate[i] = true;
+    duplicates.push_back(i);
+  };
+
+  for (int i = 0; i < num_nodes; ++i) {
+    rename_inputs(optimized_graph->mutable_node(i));
+    visited[i] = true;
+    dedup(i);
+  }
+  while (!to_revisit.empty()) {
+    const int i = *to_revisit.begin();
+    to_revisit.erase(to_revisit.begin());
+    dedup(i);
+  }
 
   // Delete duplicates
   if (fetch_nodes_known_ && !duplicates.empty()) {
-    EraseNodesFromGraph(duplicates, optimized_graph);
+    EraseNodesFromGraph(std::move(duplicates), optimized_graph);
   }
 
   return Status::OK();
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -174,5 +175,119 @@ TEST_F(CommonSubgraphEliminationTest, OpDedupCommutative) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(CommonSubgraphEliminationTest, DedupsThroughBackEdges) {
+  // The two loop variables are equal, but their Merge nodes may be visited
+  // before the NextIteration nodes that make them equal.
+  GraphDef graph;
+  AttrValue type;
+  type.set_type(DT_FLOAT);
+  AttrValue frame_name;
+  frame_name.set_s("while/while_context");
+  AddNode("in", "Identity", {}, {{"T", type}}, &graph);
+  AddNode("enter", "Enter", {"in"}, {{"T", type}, {"frame_name", frame_name}},
+          &graph);
+  AddNode("merge1", "Merge", {"enter", "next1"}, {{"T", type}}, &graph);
+  AddNode("merge2", "Merge", {"enter", "next2"}, {{"T", type}}, &graph);
+  AddNode("add", "Add", {"enter", "enter"}, {{"T", type}}, &graph);
+  AddNode("next1", "NextIteration", {"add"}, {{"T", type}}, &graph);
+  AddNode("next2", "NextIteration", {"add"}, {{"T", type}}, &graph);
+  AddNode("out1", "Identity", {"merge1"}, {{"T", type}}, &graph);
+  AddNode("out2", "Identity", {"merge2"}, {{"T", type}}, &graph);
+  GrapplerItem item;
+  item.graph = graph;
+  item.fetch = {"out1", "out2"};
+
+  CommonSubgraphElimination optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(output.node_size(), 7);
+  EXPECT_EQ(node_map.GetNode("merge2"), nullptr);
+  EXPECT_EQ(node_map.GetNode("next2"), nullptr);
+  const NodeDef* out2 = node_map.GetNode("out2");
+  ASSERT_NE(out2, nullptr);
+  ASSERT_EQ(out2->input_size(), 1);
+  EXPECT_EQ(out2->input(0), "merge1");
+  const NodeDef* merge1 = node_map.GetNode("merge1");
+  ASSERT_NE(merge1, nullptr);
+  ASSERT_EQ(merge1->input_size(), 2);
+  EXPECT_EQ(merge1->input(1), "next1");
+}
+
+// Creates a graph of `num_nodes` identical nodes consumed by a single node.
+static GrapplerItem WideFanInItem(int num_nodes) {
+  GrapplerItem item;
+  AttrValue type;
+  type.set_type(DT_FLOAT);
+  NodeDef* c = item.graph.add_node();
+  c->set_name("c");
+  c->set_op("Placeholder");
+  (*c->mutable_attr())["dtype"] = type;
+  NodeDef* sum = item.graph.add_node();
+  sum->set_name("sum");
+  sum->set_op("AddN");
+  (*sum->mutable_attr())["T"] = type;
+  (*sum->mutable_attr())["N"].set_i(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = item.graph.add_node();
+    node->set_name(absl::StrCat("sqrt", i));
+    node->set_op("Sqrt");
+    node->add_input("c");
+    (*node->mutable_attr())["T"] = type;
+    sum->add_input(node->name());
+  }
+  item.fetch = {"sum"};
+  return item;
+}
+
+// Creates a graph of two identical chains of `num_nodes` nodes each.
+static GrapplerItem ChainsItem(int num_nodes) {
+  GrapplerItem item;
+  AttrValue type;
+  type.set_type(DT_FLOAT);
+  NodeDef* c = item.graph.add_node();
+  c->set_name("c");
+  c->set_op("Placeholder");
+  (*c->mutable_attr())["dtype"] = type;
+  for (const string& chain : {"a", "b"}) {
+    string input = "c";
+    for (int i = 0; i < num_nodes; ++i) {
+      NodeDef* node = item.graph.add_node();
+      node->set_name(absl::StrCat(chain, i));
+      node->set_op("Sqrt");
+      node->add_input(input);
+      (*node->mutable_attr())["T"] = type;
+      input = node->name();
+    }
+    item.fetch.push_back(input);
+  }
+  return item;
+}
+
+static void BM_DedupWideFanIn(::testing::benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  const GrapplerItem item = WideFanInItem(num_nodes);
+  for (auto s : state) {
+    CommonSubgraphElimination optimizer;
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  }
+  state.SetItemsProcessed(state.iterations() * num_nodes);
+}
+BENCHMARK(BM_DedupWideFanIn)->Arg(1000)->Arg(10000)->Arg(100000);
+
+static void BM_DedupChains(::testing::benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  const GrapplerItem item = ChainsItem(num_nodes);
+  for (auto s : state) {
+    CommonSubgraphElimination optimizer;
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * num_nodes);
+}
+BENCHMARK(BM_DedupChains)->Arg(1000)->Arg(10000)->Arg(100000);
+
 }  // namespace grappler
 }  // namespace tensorflow
@@ -23,6 +23,7 @@ limitations under the License.
 #include "absl/strings/substitute.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op.h"
@@ -40,15 +41,20 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/evaluation_utils.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/symbolic_shapes.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/setround.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/public/version.h"
@@ -61,8 +67,87 @@ using TensorVector = gtl::InlinedVector<TensorValue, 4>;
 
 // We only fold/materialize constants smaller than 100kB.
 const int64_t kMaxConstantSize = 100 * 1024;
+const int64_t kMaxFoldedConstantsSize = 256 * 1024 * 1024;
 
 namespace {
+// The number of foldable nodes evaluated at once, which bounds the memory
+// held by their outputs.
+const int kMaxNodesInFlight = 64;
+
+// Caches the constants that nodes fold to for the whole process, so that
+// identical subgraphs, e.g. in the functions of a generated graph, are only
+// evaluated once. The cache is cleared when it reaches its size limit.
+class FoldedNodeCache {
+ public:
+  static FoldedNodeCache* Global() {
+    static FoldedNodeCache* cache = new FoldedNodeCache();
+    return cache;
+  }
+
+  bool Lookup(const Fprint128& key, std::vector<NodeDef>* const_nodes) {
+    mutex_lock l(mu_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return false;
+    *const_nodes = it->second;
+    return true;
+  }
+
+  void Insert(const Fprint128& key, const std::vector<NodeDef>& const_nodes) {
+    int64_t num_bytes = 0;
+    for (const NodeDef& node : const_nodes) num_bytes += node.ByteSizeLong();
+    if (num_bytes > kMaxConstantSize) return;
+    mutex_lock l(mu_);
+    if (num_bytes_ + num_bytes > kMaxSize) {
+      entries_.clear();
+      num_bytes_ = 0;
+    }
+    if (entries_.emplace(key, const_nodes).second) num_bytes_ += num_bytes;
+  }
+
+ private:
+  static constexpr int64_t kMaxSize = 16 * 1024 * 1024;
+
+  mutex mu_;
+  absl::flat_hash_map<Fprint128, std::vector<NodeDef>, Fprint128Hasher>
+      entries_ TF_GUARDED_BY(mu_);
+  int64_t num_bytes_ TF_GUARDED_BY(mu_) = 0;
+};
+
+// Returns the pool that evaluates foldable nodes. It is shared by all the
+// optimizers of the process, so that those running concurrently, e.g. on the
+// functions of a library, don't each add threads. It is separate from the
+// threads of the CPU device, which the kernels themselves use.
+thread::ThreadPool* EvaluationPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "constant_folding", port::MaxParallelism());
+  return pool;
+}
+
+// Sets `key` to the fingerprint of the op, attributes and input values of
+// `node`. Returns false if the inputs are too large to be worth caching.
+bool FoldedNodeKey(const NodeDef& node,
+                   const std::vector<const TensorProto*>& input_values,
+                   Fprint128* key) {
+  NodeDef op_and_attrs;
+  op_and_attrs.set_op(node.op());
+  *op_and_attrs.mutable_attr() = node.attr();
+  string serialized;
+  if (!SerializeToStringDeterministic(op_and_attrs, &serialized)) {
+    return false;
+  }
+  string serialized_value;
+  for (const TensorProto* value : input_values) {
+    if (serialized.size() + value->ByteSizeLong() > kMaxConstantSize ||
+        !SerializeToStringDeterministic(*value, &serialized_value)) {
+      return false;
+    }
+    strings::StrAppend(&serialized, serialized_value.size(), ":",
+                       serialized_value);
+  }
+  *key = Fingerprint128(serialized);
+  return true;
+}
+
 template <typename T>
 bool AllValuesAre(const TensorProto& proto, const T& value) {
   Tensor tensor;
@@ -1346,7 +1431,7 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
     }
   });
 
-  size_t total_inputs_size = 0;
+  std::vector<const TensorProto*> input_values;
   for (const auto& input : node.input()) {
     const TensorId input_tensor = ParseTensorName(input);
     if (input_tensor.index() < 0) {
@@ -1373,12 +1458,39 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
           "Not allowed to construct a tensor with reference dtype, got ",
           DataTypeString(raw_val.dtype()));
     }
-    Tensor* value = new Tensor(raw_val.dtype(), raw_val.tensor_shape());
-    if (!value->FromProto(raw_val)) {
+    input_values.push_back(&raw_val);
+  }
+
+  const auto set_names = [this, &node, outputs]() {
+    for (size_t i = 0; i < outputs->size(); i++) {
+      // Dead outputs have no name.
+      if (outputs->at(i).name().empty()) continue;
+      string node_name = OptimizedNodeName(node, "-folded");
+      if (outputs->size() > 1) {
+        node_name = strings::StrCat(node_name, "-", i);
+      }
+      outputs->at(i).set_name(node_name);
+    }
+  };
+  Fprint128 key;
+  const bool cacheable = FoldedNodeKey(node, input_values, &key);
+  if (cacheable) {
+    const bool hit = FoldedNodeCache::Global()->Lookup(key, outputs);
+    metrics::RecordConstantFoldingCacheLookup(hit);
+    if (hit) {
+      set_names();
+      return Status::OK();
+    }
+  }
+
+  size_t total_inputs_size = 0;
+  for (const TensorProto* raw_val : input_values) {
+    Tensor* value = new Tensor(raw_val->dtype(), raw_val->tensor_shape());
+    if (!value->FromProto(*raw_val)) {
       delete (value);
       return errors::InvalidArgument("Unable to make Tensor from proto for ",
                                      node.name(), " with shape ",
-                                     raw_val.tensor_shape().DebugString());
+                                     raw_val->tensor_shape().DebugString());
     }
     inputs.emplace_back(value);
     total_inputs_size += value->TotalBytes();
@@ -1408,6 +1520,7 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
       outputs->at(i) = NodeDef();
     }
   }
+  if (cacheable) FoldedNodeCache::Global()->Insert(key, *outputs);
   return Status::OK();
 }
 
@@ -1503,16 +1616,58 @@ Status ConstantFolding::FoldMergeNode(NodeDef* node, GraphDef* output_graph) {
   return Status::OK();
 }
 
-Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph,
+void ConstantFolding::EvaluateFoldables(absl::Span<NodeDef* const> nodes,
+                                        std::vector<FoldedValues>* values) {
+  values->clear();
+  values->resize(nodes.size());
+  const auto evaluate = [this, nodes, values](int i) {
+    if (IsMerge(*nodes[i])) return;
+    FoldedValues& folded = values->at(i);
+    folded.status = EvaluateOneFoldable(*nodes[i], &folded.const_nodes,
+                                        &folded.result_too_large);
+    if (!folded.status.ok()) return;
+    for (const NodeDef& const_node : folded.const_nodes) {
+      if (const_node.name().empty()) continue;
+      folded.num_bytes += const_node.attr().at("value").tensor().ByteSizeLong();
+    }
+  };
+  if (nodes.size() == 1) {
+    evaluate(0);
+    return;
+  }
+  thread::ThreadPool* pool = EvaluationPool();
+  BlockingCounter counter(nodes.size());
+  for (int i = 0, end = nodes.size(); i < end; ++i) {
+    pool->Schedule([&evaluate, &counter, i]() {
+      evaluate(i);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+}
+
+Status ConstantFolding::FoldNode(NodeDef* node, FoldedValues* values,
+                                 GraphDef* output_graph,
                                  bool* result_too_large) {
   *result_too_large = false;
   if (IsMerge(*node)) {
     return FoldMergeNode(node, output_graph);
   }
 
-  std::vector<NodeDef> const_nodes;
-  TF_RETURN_IF_ERROR(
-      EvaluateOneFoldable(*node, &const_nodes, result_too_large));
+  if (!values->status.ok()) {
+    *result_too_large = values->result_too_large;
+    return values->status;
+  }
+  // Large constants are only created within the budget of the graph.
+  if (values->num_bytes > kMaxConstantSize &&
+      folded_bytes_ + values->num_bytes > max_folded_constants_size_) {
+    *result_too_large = true;
+    return errors::ResourceExhausted(
+        "Can't fold ", node->name(), ", the constants folded in the graph ",
+        "would exceed ", max_folded_constants_size_, " bytes");
+  }
+  folded_bytes_ += values->num_bytes;
+  std::vector<NodeDef>& const_nodes = values->const_nodes;
   VLOG(2) << "Folded node: " << SummarizeNodeDef(*node);
 
   NodeDef* constant_output = nullptr;
@@ -1643,30 +1798,48 @@ Status ConstantFolding::FoldGraph(
       queue.push_back(graph_->mutable_node(i));
     }
   }
+  std::vector<NodeDef*> nodes;
+  std::vector<FoldedValues> values;
   while (!queue.empty()) {
-    NodeDef* node = queue.front();
-    queue.pop_front();
-    if (processed_nodes.count(node->name())) {
-      continue;
-    }
-    // We need to record a copy of output nodes before FoldNode() modifies it.
-    // We also need to ensure that the fanout is sorted deterministically.
-    std::vector<NodeDef*> fanout =
-        node_map_->GetOutputsOrderedByNodeName(node->name());
-    bool result_too_large = false;
-    Status s = FoldNode(node, optimized_graph, &result_too_large);
-    processed_nodes.insert(node->name());
-    if (!s.ok()) {
-      VLOG(1) << "Failed to fold node " << node->DebugString()
-              << "\nError message: " << s;
-      if (result_too_large) {
-        nodes_to_not_simplify->emplace(node->name());
+    // The nodes in the queue have constant inputs, so they don't feed each
+    // other and can be evaluated in parallel. They are then folded in the
+    // order of the queue. At most kMaxNodesInFlight are evaluated at once to
+    // bound the memory held by their values.
+    nodes.clear();
+    absl::flat_hash_set<NodeDef*> nodes_in_flight;
+    while (!queue.empty() &&
+           static_cast<int>(nodes.size()) < kMaxNodesInFlight) {
+      NodeDef* node = queue.front();
+      queue.pop_front();
+      if (!processed_nodes.contains(node->name()) &&
+          nodes_in_flight.insert(node).second) {
+        nodes.push_back(node);
       }
-    } else {
-      for (auto& fanout_node : fanout) {
-        if (IsFoldable(*fanout_node, &properties) &&
-            !nodes_to_not_simplify->count(fanout_node->name())) {
-          queue.push_back(fanout_node);
+    }
+    EvaluateFoldables(nodes, &values);
+
+    for (int i = 0, end = nodes.size(); i < end; ++i) {
+      NodeDef* node = nodes[i];
+      // We need to record a copy of output nodes before FoldNode() modifies
+      // it. We also need to ensure that the fanout is sorted
+      // deterministically.
+      std::vector<NodeDef*> fanout =
+          node_map_->GetOutputsOrderedByNodeName(node->name());
+      bool result_too_large = false;
+      Status s = FoldNode(node, &values[i], optimized_graph, &result_too_large);
+      processed_nodes.insert(node->name());
+      if (!s.ok()) {
+        VLOG(1) << "Failed to fold node " << node->DebugString()
+                << "\nError message: " << s;
+        if (result_too_large) {
+          nodes_to_not_simplify->emplace(node->name());
+        }
+      } else {
+        for (auto& fanout_node : fanout) {
+          if (IsFoldable(*fanout_node, &properties) &&
+              !nodes_to_not_simplify->count(fanout_node->name())) {
+            queue.push_back(fanout_node);
+          }
         }
       }
     }
@@ -4028,6 +4201,7 @@ Status ConstantFolding::Optimize(Cluster* cluster, const GrapplerItem& item,
   port::ScopedFlushDenormal flush;
   port::ScopedSetRound round(FE_TONEAREST);
   nodes_to_preserve_ = item.NodesToPreserve();
+  folded_bytes_ = 0;
   for (const auto& feed : item.feed) {
     feed_nodes_.insert(NodeName(feed.first));
   }
@@ -34,6 +34,9 @@ namespace grappler {
 const char kConstantFoldingConst[] = "ConstantFolding";
 const char kConstantFoldingCtrl[] = "ConstantFoldingCtrl";
 extern const int64_t kMaxConstantSize;
+// Once the constants folded in a graph total this size, only those smaller
+// than kMaxConstantSize, such as shapes, are still folded.
+extern const int64_t kMaxFoldedConstantsSize;
 
 // Constant folding optimization for a graph.
 class ConstantFolding : public GraphOptimizer {
@@ -61,6 +64,12 @@ class ConstantFolding : public GraphOptimizer {
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* output) override;
 
+  // Sets the size of the constants larger than kMaxConstantSize that
+  // Optimize() may fold, kMaxFoldedConstantsSize by default. For testing.
+  void set_max_folded_constants_size(int64_t max_folded_constants_size) {
+    max_folded_constants_size_ = max_folded_constants_size;
+  }
+
  private:
   bool ForwardInputs(NodeDef* node, absl::Span<const int> inputs_to_forward);
   string OptimizedNodeName(const NodeDef& node, StringPiece suffix) const;
@@ -95,8 +104,22 @@ class ConstantFolding : public GraphOptimizer {
   Status EvaluateOneFoldable(const NodeDef& node, std::vector<NodeDef>* outputs,
                              bool* result_too_large);
 
+  // The constants that a foldable node evaluates to.
+  struct FoldedValues {
+    Status status;
+    bool result_too_large = false;
+    std::vector<NodeDef> const_nodes;
+    // The encoded size of the constants.
+    int64_t num_bytes = 0;
+  };
+  // Evaluates the foldable `nodes`, which must not feed each other, in
+  // parallel. Merge nodes are left to FoldNode().
+  void EvaluateFoldables(absl::Span<NodeDef* const> nodes,
+                         std::vector<FoldedValues>* values);
+
   Status FoldMergeNode(NodeDef* node, GraphDef* output_graph);
-  Status FoldNode(NodeDef* node, GraphDef* output_graph,
+  // Replaces `node` with the constants in `values`.
+  Status FoldNode(NodeDef* node, FoldedValues* values, GraphDef* output_graph,
                   bool* result_too_large);
 
   bool IsOnes(const NodeDef& node) const;
@@ -328,6 +351,10 @@ class ConstantFolding : public GraphOptimizer {
   std::unique_ptr<DeviceBase> owned_device_;
 
   std::unique_ptr<ResourceMgr> resource_mgr_;
+  // The size of the constants folded by Optimize() so far, and its limit for
+  // constants larger than kMaxConstantSize.
+  int64_t folded_bytes_ = 0;
+  int64_t max_folded_constants_size_ = kMaxFoldedConstantsSize;
   GraphDef* graph_;
   std::unique_ptr<NodeMap> node_map_;
   std::unordered_set<string> nodes_to_preserve_;
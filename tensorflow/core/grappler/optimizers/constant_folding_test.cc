@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/array_ops_internal.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -308,6 +309,138 @@ TEST_F(ConstantFoldingTest, SimpleFolding) {
   test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
 }
 
+TEST_F(ConstantFoldingTest, FoldsManyIndependentNodes) {
+  // More independent foldable nodes than are evaluated at once, many of which
+  // are identical.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  std::vector<Output> squares;
+  for (int i = 0; i < 200; ++i) {
+    Output c = ops::Const(s.WithOpName(strings::StrCat("c", i)),
+                          static_cast<float>(i % 10), {2});
+    Output add = ops::Add(s.WithOpName(strings::StrCat("add", i)), c, c);
+    squares.push_back(
+        ops::Mul(s.WithOpName(strings::StrCat("mul", i)), add, add));
+  }
+  Output sum = ops::AddN(s.WithOpName("sum"), squares);
+
+  GrapplerItem item;
+  item.fetch.push_back("sum");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ConstantFolding optimizer(/*cpu_device=*/nullptr);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+
+  ASSERT_EQ(output.node_size(), 1);
+  EXPECT_EQ(output.node(0).name(), "sum");
+  EXPECT_EQ(output.node(0).op(), "Const");
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
+TEST_F(ConstantFoldingTest, ReusesFoldedNodesAcrossOptimizers) {
+  // Values that no other test folds, so that they are not cached yet.
+  const auto make_item = [](const string& prefix) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    Output c = ops::Const(s.WithOpName(prefix + "c"), {1234.5f, -6.75f}, {2});
+    Output add = ops::Add(s.WithOpName(prefix + "add"), c, c);
+    ops::Mul(s.WithOpName(prefix + "mul"), add, add);
+    GrapplerItem item;
+    item.fetch.push_back(prefix + "mul");
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  };
+  monitoring::CounterCell* hits =
+      metrics::GetConstantFoldingCacheLookupsCounter("hit");
+  monitoring::CounterCell* misses =
+      metrics::GetConstantFoldingCacheLookupsCounter("miss");
+  const int64_t hits_before = hits->value();
+  const int64_t misses_before = misses->value();
+
+  GrapplerItem first = make_item("first_");
+  ConstantFolding first_optimizer(/*cpu_device=*/nullptr);
+  GraphDef first_output;
+  TF_EXPECT_OK(
+      first_optimizer.Optimize(/*cluster=*/nullptr, first, &first_output));
+  EXPECT_EQ(hits->value(), hits_before);
+  EXPECT_GT(misses->value(), misses_before);
+  const int64_t misses_after_first = misses->value();
+
+  // Another optimizer folds the identical nodes of another graph from the
+  // cache.
+  GrapplerItem second = make_item("second_");
+  ConstantFolding second_optimizer(/*cpu_device=*/nullptr);
+  GraphDef second_output;
+  TF_EXPECT_OK(
+      second_optimizer.Optimize(/*cluster=*/nullptr, second, &second_output));
+  EXPECT_GT(hits->value(), hits_before);
+  EXPECT_EQ(misses->value(), misses_after_first);
+
+  ASSERT_EQ(second_output.node_size(), 1);
+  EXPECT_EQ(second_output.node(0).name(), "second_mul");
+  EXPECT_EQ(second_output.node(0).op(), "Const");
+  auto tensors_expected = EvaluateNodes(second.graph, second.fetch);
+  auto tensors = EvaluateNodes(second_output, second.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
+TEST_F(ConstantFoldingTest, StopsFoldingLargeConstantsOverBudget) {
+  // Folding Add(c, c) creates a constant as large as c, which is larger than
+  // kMaxConstantSize.
+  constexpr int kNumElements = 50 * 1024;
+  constexpr int64_t kLargeConstantSize = kNumElements * sizeof(float);
+  ASSERT_GT(kLargeConstantSize, kMaxConstantSize);
+  Tensor large(DT_FLOAT, TensorShape({kNumElements}));
+  for (int i = 0; i < kNumElements; ++i) large.flat<float>()(i) = i;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output c = ops::Const(s.WithOpName("c"), Input::Initializer(large));
+  for (int i = 0; i < 3; ++i) {
+    ops::Add(s.WithOpName(strings::StrCat("large_add", i)), c, c);
+  }
+  Output small = ops::Const(s.WithOpName("small"), 2.0f, {2});
+  ops::Add(s.WithOpName("small_add"), small, small);
+
+  GrapplerItem item;
+  item.fetch = {"large_add0", "large_add1", "large_add2", "small_add"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ConstantFolding optimizer(/*cpu_device=*/nullptr);
+  // Leaves room for two of the large constants only.
+  optimizer.set_max_folded_constants_size(5 * kLargeConstantSize / 2);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+
+  int num_large_folded = 0;
+  for (const NodeDef& node : output.node()) {
+    if (absl::StartsWith(node.name(), "large_add")) {
+      if (node.op() == "Const") {
+        ++num_large_folded;
+      } else {
+        EXPECT_EQ(node.op(), "Add");
+      }
+    } else if (node.name() == "small_add") {
+      // Small constants are still folded once the budget is spent.
+      EXPECT_EQ(node.op(), "Const");
+    }
+  }
+  EXPECT_EQ(num_large_folded, 2);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 4);
+  ASSERT_EQ(tensors.size(), 4);
+  for (int i = 0; i < 4; ++i) {
+    test::ExpectTensorEqual<float>(tensors_expected[i], tensors[i]);
+  }
+}
+
 TEST_F(ConstantFoldingTest, AddTree) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
 
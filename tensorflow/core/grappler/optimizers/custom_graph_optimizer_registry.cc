@@ -66,11 +66,13 @@ const ConfigList& DefaultPluginConfigs() {
                       {"auto_mixed_precision", RewriterConfig::ON},
                       {"auto_mixed_precision_mkl", RewriterConfig::ON},
                       {"auto_mixed_precision_cpu", RewriterConfig::ON},
+                      {"auto_mixed_precision_cpu_bf16", RewriterConfig::ON},
                       {"pin_to_host_optimization", RewriterConfig::ON},
                       {"layout_optimizer", RewriterConfig::ON},
                       {"remapping", RewriterConfig::ON},
                       {"loop_optimization", RewriterConfig::ON},
                       {"dependency_optimization", RewriterConfig::ON},
+                      {"device_placement_optimization", RewriterConfig::ON},
                       {"auto_parallel", RewriterConfig::ON},
                       {"memory_optimization", RewriterConfig::ON},
                       {"scoped_allocator_optimization", RewriterConfig::ON}});
@@ -118,6 +120,10 @@ PluginGraphOptimizerRegistry::CreateOptimizers(
   return optimizer_list;
 }
 
+bool PluginGraphOptimizerRegistry::HasRegisteredOptimizers() {
+  return !GetPluginRegistrationMap()->empty();
+}
+
 void PluginGraphOptimizerRegistry::RegisterPluginOptimizerOrDie(
     const Creator& optimizer_creator, const std::string& device_type,
     ConfigList& configs) {
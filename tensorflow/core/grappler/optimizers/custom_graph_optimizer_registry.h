@@ -86,6 +86,9 @@ class PluginGraphOptimizerRegistry {
 
   typedef std::function<CustomGraphOptimizer*()> Creator;
 
+  // Returns whether any plug-in CustomGraphOptimizer is registered.
+  static bool HasRegisteredOptimizers();
+
   // Returns plugin's config. If any of the config is turned off, the returned
   // config will be turned off.
   static ConfigList GetPluginConfigs(bool use_plugin_optimizers,
@@ -0,0 +1,307 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/mutable_graph_view.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/data/function_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/grappler/utils.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kMapDataset[] = "MapDataset";
+constexpr char kParallelMapDataset[] = "ParallelMapDataset";
+constexpr char kParallelMapDatasetV2[] = "ParallelMapDatasetV2";
+constexpr char kVectorizedFunctionPrefix[] = "vectorized_";
+constexpr char kOutputShapesAttr[] = "_output_shapes";
+
+// Ops that compute each output element from the input elements at the same
+// position, and thus compute the same values on a batch of inputs as on each
+// input of the batch.
+const auto* kUnaryOps = new absl::flat_hash_set<string>(
+    {"Abs", "Cast", "Ceil", "Cos", "Exp", "Floor", "Identity", "IsNan", "Log",
+     "Log1p", "LogicalNot", "Neg", "Reciprocal", "Relu", "Rint", "Round",
+     "Rsqrt", "Sigmoid", "Sign", "Sin", "Sqrt", "Square", "Tanh"});
+const auto* kBinaryOps = new absl::flat_hash_set<string>(
+    {"Add", "AddV2", "Div", "DivNoNan", "Equal", "FloorDiv", "FloorMod",
+     "Greater", "GreaterEqual", "Less", "LessEqual", "LogicalAnd", "LogicalOr",
+     "Maximum", "Minimum", "Mul", "NotEqual", "Pow", "RealDiv",
+     "SquaredDifference", "Sub", "TruncateDiv"});
+
+bool IsMapNode(const NodeDef& node) {
+  return node.op() == kMapDataset || node.op() == kParallelMapDataset ||
+         node.op() == kParallelMapDatasetV2;
+}
+
+// Describes a value computed by a map function.
+struct Value {
+  // Whether the value is computed from the function arguments. Otherwise the
+  // value is a scalar computed from constants.
+  bool is_element;
+  // The shape of an element value for a single input element.
+  PartialTensorShape shape;
+};
+
+// Returns the node or argument name referenced by a `FunctionDef` input.
+string InputSource(const string& input) {
+  return std::vector<string>(absl::StrSplit(input, ':'))[0];
+}
+
+// Computes the value of `node` from its inputs, or returns false if the node
+// cannot be vectorized.
+bool ComputeValue(const NodeDef& node, const std::vector<Value>& inputs,
+                  Value* value) {
+  if (node.op() == "Const") {
+    const TensorProto& tensor = node.attr().at("value").tensor();
+    if (!inputs.empty() || tensor.tensor_shape().dim_size() != 0) {
+      // Non-scalar constants could broadcast differently against batched
+      // elements.
+      return false;
+    }
+    *value = {/*is_element=*/false, PartialTensorShape({})};
+    return true;
+  }
+  if (kUnaryOps->contains(node.op()) && inputs.size() == 1) {
+    *value = inputs[0];
+    return true;
+  }
+  if (kBinaryOps->contains(node.op()) && inputs.size() == 2) {
+    if (!inputs[0].is_element) {
+      *value = inputs[1];
+      return true;
+    }
+    if (!inputs[1].is_element) {
+      *value = inputs[0];
+      return true;
+    }
+    // Two element values only compute the same result on batched inputs when
+    // neither of them needs to be broadcast.
+    if (!inputs[0].shape.IsFullyDefined() ||
+        !inputs[0].shape.IsIdenticalTo(inputs[1].shape)) {
+      return false;
+    }
+    *value = inputs[0];
+    return true;
+  }
+  return false;
+}
+
+// Returns whether `function` only computes element-wise values of its
+// arguments, whose shapes are `arg_shapes`.
+bool IsVectorizable(const FunctionDef& function,
+                    const std::vector<PartialTensorShape>& arg_shapes) {
+  const OpDef& signature = function.signature();
+  if (signature.input_arg_size() != static_cast<int>(arg_shapes.size())) {
+    return false;
+  }
+  absl::flat_hash_map<string, Value> values;
+  for (int i = 0; i < signature.input_arg_size(); ++i) {
+    values[signature.input_arg(i).name()] = {/*is_element=*/true,
+                                             arg_shapes[i]};
+  }
+  // Function nodes are not topologically sorted, so values are computed until
+  // no more nodes can be computed.
+  absl::flat_hash_set<const NodeDef*> remaining;
+  for (const NodeDef& node : function.node_def()) {
+    remaining.insert(&node);
+  }
+  bool progress = true;
+  while (!remaining.empty() && progress) {
+    progress = false;
+    for (auto it = remaining.begin(); it != remaining.end();) {
+      const NodeDef* node = *it;
+      std::vector<Value> inputs;
+      bool ready = true;
+      for (const string& input : node->input()) {
+        if (IsControlInput(input)) continue;
+        auto value = values.find(InputSource(input));
+        if (value == values.end()) {
+          ready = false;
+          break;
+        }
+        inputs.push_back(value->second);
+      }
+      if (!ready) {
+        ++it;
+        continue;
+      }
+      Value value;
+      if (!ComputeValue(*node, inputs, &value)) {
+        VLOG(1) << "Cannot vectorize map function " << signature.name()
+                << " because of node " << node->name() << " with op "
+                << node->op();
+        return false;
+      }
+      values[node->name()] = value;
+      remaining.erase(it++);
+      progress = true;
+    }
+  }
+  if (!remaining.empty()) {
+    return false;
+  }
+  for (const auto& ret : function.ret()) {
+    auto value = values.find(InputSource(ret.second));
+    // Values computed from constants would not have a batch dimension.
+    if (value == values.end() || !value->second.is_element) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns a copy of `function` without the shape annotations that no longer
+// hold for batched inputs.
+FunctionDef MakeVectorizedFunction(const FunctionDef& function,
+                                   FunctionDefLibrary* library) {
+  FunctionDef vectorized = function;
+  graph_utils::SetUniqueGraphFunctionName(
+      strings::StrCat(kVectorizedFunctionPrefix, function.signature().name()),
+      library, &vectorized);
+  for (NodeDef& node : *vectorized.mutable_node_def()) {
+    node.mutable_attr()->erase(kOutputShapesAttr);
+  }
+  for (auto& arg_attr : *vectorized.mutable_arg_attr()) {
+    arg_attr.second.mutable_attr()->erase(kOutputShapesAttr);
+  }
+  return vectorized;
+}
+
+NodeDef MakeBatchNode(const NodeDef& input_node, const NodeDef& batch_node,
+                      MutableGraphView* graph) {
+  NodeDef new_batch = batch_node;
+  graph_utils::SetUniqueGraphNodeName(batch_node.op(), graph->graph(),
+                                      &new_batch);
+  new_batch.set_input(0, input_node.name());
+  // The batch dimension is the same as the one of the original batch.
+  int64_t batch_dim = -1;
+  const auto& batch_shapes = batch_node.attr().at("output_shapes").list();
+  if (batch_shapes.shape_size() > 0 && !batch_shapes.shape(0).unknown_rank() &&
+      batch_shapes.shape(0).dim_size() > 0) {
+    batch_dim = batch_shapes.shape(0).dim(0).size();
+  }
+  AttrValue output_shapes;
+  for (const auto& shape :
+       input_node.attr().at("output_shapes").list().shape()) {
+    PartialTensorShape batched_shape({batch_dim});
+    batched_shape.Concatenate(PartialTensorShape(shape)).AsProto(
+        output_shapes.mutable_list()->add_shape());
+  }
+  (*new_batch.mutable_attr())["output_shapes"] = output_shapes;
+  (*new_batch.mutable_attr())["output_types"] =
+      input_node.attr().at("output_types");
+  return new_batch;
+}
+
+NodeDef MakeMapNode(const NodeDef& map_node, const NodeDef& batch_node,
+                    const NodeDef& new_batch_node,
+                    const FunctionDef& vectorized_function,
+                    MutableGraphView* graph) {
+  NodeDef new_map = map_node;
+  graph_utils::SetUniqueGraphNodeName(map_node.op(), graph->graph(), &new_map);
+  new_map.set_input(0, new_batch_node.name());
+  (*new_map.mutable_attr())["f"].mutable_func()->set_name(
+      vectorized_function.signature().name());
+  graph_utils::CopyShapesAndTypesAttrs(batch_node, &new_map);
+  graph_utils::MaybeSetFusedMetadata(map_node, batch_node, &new_map);
+  return new_map;
+}
+
+}  // namespace
+
+Status MapVectorization::OptimizeAndCollectStats(Cluster* cluster,
+                                                 const GrapplerItem& item,
+                                                 GraphDef* output,
+                                                 OptimizationStats* stats) {
+  *output = item.graph;
+  MutableGraphView graph(output);
+  absl::flat_hash_set<string> nodes_to_delete;
+  FunctionLibraryDefinition function_library(OpRegistry::Global(),
+                                             item.graph.library());
+
+  for (const NodeDef& node : item.graph.node()) {
+    if (node.op() != "BatchDataset" && node.op() != "BatchDatasetV2") {
+      continue;
+    }
+
+    // Use a more descriptive variable name now that we know the node type.
+    const NodeDef& batch_node = node;
+    const NodeDef* map_node = graph_utils::GetInputNode(batch_node, graph);
+    // TODO(b/148614315): Support captured inputs.
+    if (!IsMapNode(*map_node) ||
+        !map_node->attr().at("Targuments").list().type().empty()) {
+      continue;
+    }
+    const NodeDef* input_node = graph_utils::GetInputNode(*map_node, graph);
+    if (!input_node->attr().count("output_shapes") ||
+        !input_node->attr().count("output_types")) {
+      continue;
+    }
+
+    const FunctionDef* function =
+        function_library.Find(map_node->attr().at("f").func().name());
+    if (function == nullptr ||
+        function_utils::IsFunctionStateful(function_library, *function)) {
+      continue;
+    }
+    std::vector<PartialTensorShape> arg_shapes;
+    for (const auto& shape :
+         input_node->attr().at("output_shapes").list().shape()) {
+      arg_shapes.emplace_back(shape);
+    }
+    if (!IsVectorizable(*function, arg_shapes)) {
+      continue;
+    }
+
+    FunctionDef vectorized_function =
+        MakeVectorizedFunction(*function, output->mutable_library());
+    *output->mutable_library()->add_function() = vectorized_function;
+    TF_RETURN_IF_ERROR(function_library.AddFunctionDef(vectorized_function));
+
+    auto* new_batch_node =
+        graph.AddNode(MakeBatchNode(*input_node, batch_node, &graph));
+    auto* new_map_node =
+        graph.AddNode(MakeMapNode(*map_node, batch_node, *new_batch_node,
+                                  vectorized_function, &graph));
+    TF_RETURN_IF_ERROR(
+        graph.UpdateFanouts(batch_node.name(), new_map_node->name()));
+
+    // Mark the `Map` and `Batch` nodes for removal.
+    nodes_to_delete.insert(map_node->name());
+    nodes_to_delete.insert(batch_node.name());
+    stats->num_changes++;
+  }
+
+  TF_RETURN_IF_ERROR(graph.DeleteNodes(nodes_to_delete));
+  return Status::OK();
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(MapVectorization, "map_vectorization");
+
+}  // namespace grappler
+}  // namespace tensorflow
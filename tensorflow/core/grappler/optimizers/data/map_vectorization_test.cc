@@ -0,0 +1,128 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_test_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using graph_tests_utils::MakeBatchV2Node;
+using graph_tests_utils::MakeMapNode;
+using test::function::NDef;
+
+// Returns a graph of `range.map(function_name).batch(10)`, where the elements
+// of `range` have the shape `element_shape`.
+GrapplerItem MakeMapAndBatchItem(const string& function_name,
+                                 const PartialTensorShape& element_shape) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("start", "Const", {}, {{"value", 0}, {"dtype", DT_INT64}}),
+       NDef("stop", "Const", {}, {{"value", 10}, {"dtype", DT_INT64}}),
+       NDef("step", "Const", {}, {{"value", 1}, {"dtype", DT_INT64}}),
+       NDef("range", "RangeDataset", {"start", "stop", "step"},
+            {{"output_shapes", gtl::ArraySlice<PartialTensorShape>{
+                                   element_shape}},
+             {"output_types", gtl::ArraySlice<DataType>{DT_INT64}}}),
+       MakeMapNode("map", "range", function_name),
+       NDef("batch_size", "Const", {}, {{"value", 10}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", false}, {"dtype", DT_BOOL}}),
+       MakeBatchV2Node("batch", "map", "batch_size", "drop_remainder",
+                       /*parallel_copy=*/false),
+       NDef("Sink", "Identity", {"batch"}, {})},
+      // FunctionLib
+      {
+          test::function::XTimesTwo(),
+          test::function::XAddX(),
+          test::function::XTimesFour(),
+      });
+  return item;
+}
+
+TEST(MapVectorizationTest, VectorizeElementWiseFunction) {
+  GrapplerItem item =
+      MakeMapAndBatchItem("XTimesTwo", PartialTensorShape({}));
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("batch", output));
+  ASSERT_TRUE(
+      graph_utils::ContainsGraphFunctionWithName("vectorized_XTimesTwo",
+                                                 output.library()));
+
+  // The map now follows the batch and uses the vectorized function.
+  const NodeDef& sink =
+      output.node(graph_utils::FindGraphNodeWithName("Sink", output));
+  const NodeDef& map_node =
+      output.node(graph_utils::FindGraphNodeWithName(sink.input(0), output));
+  EXPECT_EQ(map_node.op(), "MapDataset");
+  EXPECT_EQ(map_node.attr().at("f").func().name(), "vectorized_XTimesTwo");
+  const NodeDef& batch_node = output.node(
+      graph_utils::FindGraphNodeWithName(map_node.input(0), output));
+  EXPECT_EQ(batch_node.op(), "BatchDatasetV2");
+  EXPECT_EQ(batch_node.input(0), "range");
+  EXPECT_EQ(batch_node.input(1), "batch_size");
+  EXPECT_EQ(batch_node.input(2), "drop_remainder");
+  ASSERT_EQ(batch_node.attr().at("output_shapes").list().shape_size(), 1);
+  EXPECT_TRUE(PartialTensorShape(
+                  batch_node.attr().at("output_shapes").list().shape(0))
+                  .IsIdenticalTo(PartialTensorShape({-1})));
+}
+
+TEST(MapVectorizationTest, VectorizeBinaryOpOfElements) {
+  GrapplerItem item = MakeMapAndBatchItem("XAddX", PartialTensorShape({3}));
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphFunctionWithName("vectorized_XAddX",
+                                                         output.library()));
+}
+
+TEST(MapVectorizationTest, BinaryOpOfElementsWithUnknownShape) {
+  // Elements of unknown shape could broadcast differently once batched.
+  GrapplerItem item = MakeMapAndBatchItem("XAddX", PartialTensorShape({-1}));
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+TEST(MapVectorizationTest, NonVectorizableOp) {
+  // `XTimesFour` calls another function, which is not vectorized.
+  GrapplerItem item =
+      MakeMapAndBatchItem("XTimesFour", PartialTensorShape({}));
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
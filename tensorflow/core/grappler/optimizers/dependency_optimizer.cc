@@ -18,6 +18,7 @@ limitations under the License.
 #include <unordered_set>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
@@ -84,13 +85,16 @@ bool DependencyOptimizer::SafeToRemoveIdentity(const NodeDef& node) const {
   if (IsVariable(*input) || IsRecv(*input)) {
     return false;
   }
+  const bool follows_switch = IsSwitch(*input);
+  const string ctrl_dep =
+      follows_switch ? AsControlDependency(node.name()) : "";
   for (const auto& consumer : node_map_->GetOutputs(node.name())) {
     if (node.input_size() > 1 && (IsRetval(*consumer) || IsMerge(*consumer))) {
       return false;
     }
-    if (IsSwitch(*input)) {
+    if (follows_switch) {
       for (const string& consumer_input : consumer->input()) {
-        if (consumer_input == AsControlDependency(node.name())) {
+        if (consumer_input == ctrl_dep) {
           return false;
         }
       }
@@ -142,11 +146,12 @@ bool DependencyOptimizer::SafeToConvertToNoOp(const NodeDef& node) const {
   if (!status.ok() || op_def->output_arg_size() == 0) {
     return false;
   }
-  const std::unordered_set<string> do_not_rewrite_ops{
-      "Assert",     "CheckNumerics",         "_Retval",
-      "_Arg",       "_ParallelConcatUpdate", "TPUExecute",
-      "TPUCompile", "ControlTrigger"};
-  if (do_not_rewrite_ops.find(node.op()) != do_not_rewrite_ops.end()) {
+  static const absl::flat_hash_set<string>* do_not_rewrite_ops =
+      new absl::flat_hash_set<string>{
+          "Assert",     "CheckNumerics",         "_Retval",
+          "_Arg",       "_ParallelConcatUpdate", "TPUExecute",
+          "TPUCompile", "ControlTrigger"};
+  if (do_not_rewrite_ops->find(node.op()) != do_not_rewrite_ops->end()) {
     return false;
   }
   if (!SafeToRemoveIdentity(node)) {
@@ -482,10 +487,10 @@ Status DependencyOptimizer::OptimizeDependencies() {
     }
   }
   while (!nodes_to_simplify.Empty()) {
-    int node_to_simplify = nodes_to_simplify.PopBack();
+    const int node_to_simplify = nodes_to_simplify.PopBack();
     // Discard nodes that were marked for deletion already.
-    while (nodes_to_delete.find(node_to_simplify) != nodes_to_delete.end()) {
-      node_to_simplify = nodes_to_simplify.PopBack();
+    if (nodes_to_delete.find(node_to_simplify) != nodes_to_delete.end()) {
+      continue;
     }
     OptimizeNode(node_to_simplify, &nodes_to_simplify, &nodes_to_delete);
   }
@@ -493,8 +498,13 @@ Status DependencyOptimizer::OptimizeDependencies() {
   if (fetch_nodes_known_) {
     VLOG(1) << "Deleted " << nodes_to_delete.size() << " out of "
             << optimized_graph_->node_size() << " nodes.";
+    // The deleted nodes are disconnected from the rest of the graph, and
+    // erasing them doesn't move the others in memory, so the node map is
+    // kept up to date, instead of being rebuilt, by forgetting them.
+    for (const int node_idx : nodes_to_delete) {
+      node_map_->RemoveNode(optimized_graph_->node(node_idx).name());
+    }
     EraseNodesFromGraph(nodes_to_delete, optimized_graph_);
-    node_map_.reset(new NodeMap(optimized_graph_));
     BuildNodeToIdx();
   }
   return Status::OK();
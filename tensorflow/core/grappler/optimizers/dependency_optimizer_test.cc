@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -945,6 +946,46 @@ TEST_F(DependencyOptimizerTest, GroupCrossHostControlDeps) {
   EXPECT_EQ(tasks.size(), 4);
 }
 
+// Creates a chain of `num_nodes` Identity nodes, each of which also has a
+// control dependency on a NoOp that depends on the previous one.
+GrapplerItem IdentityChainItem(int num_nodes) {
+  GrapplerItem item;
+  AttrValue type;
+  type.set_type(DT_FLOAT);
+  NodeDef* x = item.graph.add_node();
+  x->set_name("x");
+  x->set_op("Placeholder");
+  (*x->mutable_attr())["dtype"] = type;
+  string input = "x";
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* noop = item.graph.add_node();
+    noop->set_name(absl::StrCat("noop", i));
+    noop->set_op("NoOp");
+    noop->add_input(AsControlDependency(input));
+    NodeDef* id = item.graph.add_node();
+    id->set_name(absl::StrCat("id", i));
+    id->set_op("Identity");
+    id->add_input(input);
+    id->add_input(AsControlDependency(noop->name()));
+    (*id->mutable_attr())["T"] = type;
+    input = id->name();
+  }
+  item.fetch = {input};
+  return item;
+}
+
+void BM_OptimizeIdentityChain(::testing::benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  const GrapplerItem item = IdentityChainItem(num_nodes);
+  for (auto s : state) {
+    DependencyOptimizer optimizer;
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * num_nodes);
+}
+BENCHMARK(BM_OptimizeIdentityChain)->Arg(1000)->Arg(10000)->Arg(100000);
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
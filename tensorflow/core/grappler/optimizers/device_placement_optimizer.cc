@@ -0,0 +1,387 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/device_placement_optimizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/analytical_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/graph_memory.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Assumed bandwidth between two local GPUs, in bytes per nanosecond. This is
+// roughly a PCIe 3.0 x16 link, and is only used to build the first placement:
+// every candidate placement is then evaluated with the VirtualScheduler.
+constexpr double kInterconnectBytesPerNs = 12.0;
+// Maximum number of passes of the refinement of the placement.
+constexpr int kMaxRefinementPasses = 4;
+// A group can be moved by the refinement to a device whose compute load stays
+// below (1 + kRefinementLoadSlack) times the average load of the devices.
+constexpr double kRefinementLoadSlack = 0.1;
+
+// A set of nodes that must be placed on the same device.
+struct Group {
+  std::vector<int> nodes;
+  // Predicted compute time of all the nodes, in nanoseconds.
+  double compute_ns = 0;
+  // Bytes of all the outputs plus the persistent memory of the nodes.
+  int64_t memory = 0;
+  // False if a node is already assigned to a device, or has no GPU kernel.
+  bool placeable = true;
+  // Index of the GPU the group is placed on, -1 if it isn't placed yet.
+  int device = -1;
+};
+
+struct Edge {
+  int src;
+  int dst;
+  int64_t bytes;
+};
+
+int FindRoot(int node, std::vector<int>* parents) {
+  while ((*parents)[node] != node) {
+    (*parents)[node] = (*parents)[(*parents)[node]];
+    node = (*parents)[node];
+  }
+  return node;
+}
+
+void Union(int a, int b, std::vector<int>* parents) {
+  a = FindRoot(a, parents);
+  b = FindRoot(b, parents);
+  if (a != b) (*parents)[std::max(a, b)] = std::min(a, b);
+}
+
+Status PredictStepTime(Cluster* cluster, const GrapplerItem& item,
+                       const GraphDef& graph, Costs::Duration* step_time) {
+  AnalyticalCostEstimator estimator(cluster, /*use_static_shapes=*/true,
+                                    /*use_aggressive_shape_inference=*/true);
+  TF_RETURN_IF_ERROR(estimator.Initialize(item));
+  Costs costs;
+  TF_RETURN_IF_ERROR(estimator.PredictCosts(graph, nullptr, &costs));
+  *step_time = costs.execution_time;
+  return Status::OK();
+}
+
+// Returns true if the peak memory usage of `graph` estimated by GraphMemory
+// fits on every device of the cluster.
+bool FitsInMemory(Cluster* cluster, const GrapplerItem& item,
+                  const GraphDef& graph) {
+  GraphDef graph_copy = graph;
+  GrapplerItem placed_item = item.WithGraph(std::move(graph_copy));
+  GraphMemory memory(placed_item);
+  if (!memory.InferStatically(cluster->GetDevices()).ok()) return false;
+  for (const auto& device : cluster->GetDevices()) {
+    const int64_t memory_size = device.second.memory_size();
+    if (memory_size <= 0) continue;
+    const int64_t used_memory =
+        memory.GetPeakMemoryUsage(device.first).used_memory;
+    if (used_memory > memory_size) {
+      VLOG(1) << "Placement needs " << used_memory << " bytes on "
+              << device.first << ", which only has " << memory_size;
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+Status DevicePlacementOptimizer::Optimize(Cluster* cluster,
+                                          const GrapplerItem& item,
+                                          GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  if (cluster == nullptr) return Status::OK();
+
+  const std::unordered_map<string, DeviceProperties>& devices =
+      cluster->GetDevices();
+  std::vector<string> gpus;
+  for (const auto& device : devices) {
+    if (device.second.type() == "GPU") gpus.push_back(device.first);
+  }
+  if (gpus.size() < 2) {
+    VLOG(2) << "Skipping device placement, the cluster has " << gpus.size()
+            << " GPUs";
+    return Status::OK();
+  }
+  std::sort(gpus.begin(), gpus.end());
+  const int num_gpus = gpus.size();
+
+  const GraphDef& graph = item.graph;
+  const int num_nodes = graph.node_size();
+  absl::flat_hash_map<string, int> node_index;
+  for (int i = 0; i < num_nodes; ++i) {
+    node_index[graph.node(i).name()] = i;
+  }
+
+  std::vector<const NodeDef*> topo_order;
+  TF_RETURN_IF_ERROR(ComputeTopologicalOrder(graph, &topo_order));
+
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/false, /*aggressive_shape_inference=*/false,
+      /*include_tensor_values=*/false));
+
+  // Collect the data edges with the bytes they transfer, and the nodes that
+  // must be colocated: the members of a colocation group, and the consumers of
+  // references and resources with their producer.
+  std::vector<int> parents(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) parents[i] = i;
+  std::vector<Edge> edges;
+  std::vector<std::vector<int>> fanin_edges(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& node = graph.node(i);
+    const auto& input_props = properties.GetInputProperties(node.name());
+    for (int j = 0; j < node.input_size(); ++j) {
+      const TensorId tensor = ParseTensorName(node.input(j));
+      auto it = node_index.find(tensor.node());
+      if (it == node_index.end()) continue;
+      int64_t bytes = 0;
+      if (tensor.index() >= 0) {
+        bytes = CalculateOutputSize(
+            properties.GetOutputProperties(string(tensor.node())),
+            tensor.index());
+        if (j < input_props.size() &&
+            (input_props[j].dtype() == DT_RESOURCE ||
+             IsRefType(input_props[j].dtype()))) {
+          Union(it->second, i, &parents);
+        }
+      }
+      fanin_edges[i].push_back(edges.size());
+      edges.push_back({it->second, i, bytes});
+    }
+    std::vector<string> colocation;
+    if (TryGetNodeAttr(node, kColocationAttrName, &colocation)) {
+      for (const string& loc : colocation) {
+        if (!absl::StartsWith(loc, kColocationGroupPrefix)) continue;
+        auto it = node_index.find(
+            loc.substr(strlen(kColocationGroupPrefix), string::npos));
+        if (it != node_index.end()) Union(it->second, i, &parents);
+      }
+    }
+  }
+
+  std::vector<Group> groups;
+  std::vector<int> node_group(num_nodes);
+  absl::flat_hash_map<int, int> root_to_group;
+  for (int i = 0; i < num_nodes; ++i) {
+    auto it = root_to_group.emplace(FindRoot(i, &parents), groups.size());
+    if (it.second) groups.emplace_back();
+    node_group[i] = it.first->second;
+    groups[node_group[i]].nodes.push_back(i);
+  }
+
+  // Nodes that are not placed by this pass keep their device, which only
+  // matters to cost the transfers if it is one of the GPUs.
+  std::vector<int> fixed_device(num_nodes, -1);
+  std::vector<double> compute_ns(num_nodes);
+  OpLevelCostEstimator node_estimator;
+  const DeviceProperties& gpu_properties = devices.at(gpus[0]);
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& node = graph.node(i);
+    Group& group = groups[node_group[i]];
+    if (!node.device().empty()) {
+      group.placeable = false;
+      auto it = std::find(gpus.begin(), gpus.end(), node.device());
+      if (it != gpus.end()) fixed_device[i] = it - gpus.begin();
+    } else {
+      NodeDef gpu_node = node;
+      gpu_node.set_device(gpus[0]);
+      if (!IsKernelRegisteredForNode(gpu_node).ok()) group.placeable = false;
+    }
+
+    OpContext op_context;
+    op_context.name = node.name();
+    op_context.device_name = gpus[0];
+    op_context.op_info.set_op(node.op());
+    *op_context.op_info.mutable_attr() = node.attr();
+    for (const auto& input : properties.GetInputProperties(node.name())) {
+      *op_context.op_info.add_inputs() = input;
+    }
+    int64_t output_bytes = 0;
+    for (const auto& output : properties.GetOutputProperties(node.name())) {
+      *op_context.op_info.add_outputs() = output;
+      output_bytes += CalculateTensorSize(output);
+    }
+    *op_context.op_info.mutable_device() = gpu_properties;
+    const Costs costs = node_estimator.PredictCosts(op_context);
+    compute_ns[i] = costs.execution_time.count();
+    group.compute_ns += compute_ns[i];
+    group.memory +=
+        output_bytes + std::max<int64_t>(costs.persistent_memory, 0);
+  }
+
+  std::vector<int64_t> memory_limit(num_gpus);
+  for (int d = 0; d < num_gpus; ++d) {
+    memory_limit[d] = devices.at(gpus[d]).memory_size();
+  }
+  auto device_of = [&](int node) {
+    const Group& group = groups[node_group[node]];
+    return group.placeable ? group.device : fixed_device[node];
+  };
+
+  // List schedule the groups in topological order onto the GPU that finishes
+  // their first node the earliest, and account their memory on it.
+  std::vector<double> finish_ns(num_nodes, 0);
+  std::vector<double> device_free_ns(num_gpus, 0);
+  std::vector<double> load_ns(num_gpus, 0);
+  std::vector<int64_t> memory_used(num_gpus, 0);
+  auto start_time = [&](int node, int device) {
+    double ready = 0;
+    for (int e : fanin_edges[node]) {
+      const Edge& edge = edges[e];
+      double arrival = finish_ns[edge.src];
+      if (device_of(edge.src) != device) {
+        arrival += edge.bytes / kInterconnectBytesPerNs;
+      }
+      ready = std::max(ready, arrival);
+    }
+    return device >= 0 ? std::max(ready, device_free_ns[device]) : ready;
+  };
+  bool placed_any = false;
+  for (const NodeDef* node_def : topo_order) {
+    const int node = node_index.at(node_def->name());
+    Group& group = groups[node_group[node]];
+    if (group.placeable && group.device < 0) {
+      double best_finish = std::numeric_limits<double>::max();
+      for (int d = 0; d < num_gpus; ++d) {
+        if (memory_limit[d] > 0 &&
+            memory_used[d] + group.memory > memory_limit[d]) {
+          continue;
+        }
+        const double finish = start_time(node, d) + compute_ns[node];
+        if (finish < best_finish) {
+          best_finish = finish;
+          group.device = d;
+        }
+      }
+      if (group.device < 0) {
+        VLOG(1) << "Skipping device placement, " << node_def->name()
+                << " doesn't fit in the memory of any GPU";
+        return Status::OK();
+      }
+      memory_used[group.device] += group.memory;
+      load_ns[group.device] += group.compute_ns;
+      placed_any = true;
+    }
+    const int device = device_of(node);
+    finish_ns[node] = start_time(node, device) + compute_ns[node];
+    if (device >= 0) device_free_ns[device] = finish_ns[node];
+  }
+  if (!placed_any) return Status::OK();
+
+  // Refine the placement: move the groups to the device that most of the
+  // bytes of their edges come from or go to, as long as the compute stays
+  // balanced and the memory fits.
+  std::vector<std::vector<int>> group_edges(groups.size());
+  for (int e = 0; e < edges.size(); ++e) {
+    const int src_group = node_group[edges[e].src];
+    const int dst_group = node_group[edges[e].dst];
+    if (src_group == dst_group || edges[e].bytes == 0) continue;
+    group_edges[src_group].push_back(e);
+    group_edges[dst_group].push_back(e);
+  }
+  double total_load_ns = 0;
+  for (double load : load_ns) total_load_ns += load;
+  const double max_load_ns =
+      (1 + kRefinementLoadSlack) * total_load_ns / num_gpus;
+  for (int pass = 0; pass < kMaxRefinementPasses; ++pass) {
+    int num_moves = 0;
+    for (int g = 0; g < groups.size(); ++g) {
+      Group& group = groups[g];
+      if (!group.placeable || group_edges[g].empty()) continue;
+      std::vector<int64_t> affinity(num_gpus, 0);
+      for (int e : group_edges[g]) {
+        const Edge& edge = edges[e];
+        const int other = node_group[edge.src] == g ? edge.dst : edge.src;
+        const int device = device_of(other);
+        if (device >= 0) affinity[device] += edge.bytes;
+      }
+      int best = group.device;
+      for (int d = 0; d < num_gpus; ++d) {
+        if (affinity[d] <= affinity[best]) continue;
+        if (load_ns[d] + group.compute_ns > max_load_ns) continue;
+        if (memory_limit[d] > 0 &&
+            memory_used[d] + group.memory > memory_limit[d]) {
+          continue;
+        }
+        best = d;
+      }
+      if (best == group.device) continue;
+      load_ns[group.device] -= group.compute_ns;
+      memory_used[group.device] -= group.memory;
+      group.device = best;
+      load_ns[best] += group.compute_ns;
+      memory_used[best] += group.memory;
+      ++num_moves;
+    }
+    VLOG(2) << "Refinement pass " << pass << " moved " << num_moves
+            << " groups";
+    if (num_moves == 0) break;
+  }
+
+  GraphDef baseline = graph;
+  GraphDef placed = graph;
+  for (const Group& group : groups) {
+    if (!group.placeable) continue;
+    for (int node : group.nodes) {
+      baseline.mutable_node(node)->set_device(gpus[0]);
+      placed.mutable_node(node)->set_device(gpus[group.device]);
+    }
+  }
+
+  // Only keep the placement if the cost model predicts it to be faster than
+  // running everything on a single GPU, and if it fits on the devices.
+  Costs::Duration baseline_time;
+  Costs::Duration placed_time;
+  Status status = PredictStepTime(cluster, item, baseline, &baseline_time);
+  if (status.ok()) {
+    status = PredictStepTime(cluster, item, placed, &placed_time);
+  }
+  if (!status.ok()) {
+    VLOG(1) << "Skipping device placement, failed to predict the step time: "
+            << status;
+    return Status::OK();
+  }
+  VLOG(1) << "Predicted step time on one GPU: " << baseline_time.count()
+          << "ns, across " << num_gpus << " GPUs: " << placed_time.count()
+          << "ns";
+  if (placed_time >= baseline_time) return Status::OK();
+  if (!FitsInMemory(cluster, item, placed)) return Status::OK();
+
+  *optimized_graph = std::move(placed);
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
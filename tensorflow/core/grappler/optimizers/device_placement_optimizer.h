@@ -0,0 +1,55 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DEVICE_PLACEMENT_OPTIMIZER_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DEVICE_PLACEMENT_OPTIMIZER_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Places the nodes that have no requested device across the local GPUs of the
+// cluster, using the analytical cost model to minimize the predicted step
+// time under the memory limit of every device.
+//
+// Colocation groups are placed as a unit. The first placement is built by
+// list scheduling the groups in topological order onto the GPU that finishes
+// them the earliest, accounting for the transfers of their inputs. It is then
+// refined by moving groups to the device of their neighbors when that reduces
+// the bytes transferred between devices without unbalancing the compute load.
+// The result is only kept if the VirtualScheduler predicts it to be faster
+// than running all the unplaced nodes on the first GPU, and if the peak memory
+// estimated by GraphMemory fits on every device.
+class DevicePlacementOptimizer : public GraphOptimizer {
+ public:
+  DevicePlacementOptimizer() {}
+  explicit DevicePlacementOptimizer(RewriterConfig::Toggle opt_level) {}
+
+  ~DevicePlacementOptimizer() override {}
+
+  string name() const override { return "device_placement_optimizer"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DEVICE_PLACEMENT_OPTIMIZER_H_
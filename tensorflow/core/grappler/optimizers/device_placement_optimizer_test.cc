@@ -0,0 +1,138 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/device_placement_optimizer.h"
+
+#include <memory>
+#include <unordered_map>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class DevicePlacementOptimizerTest : public GrapplerTest {
+ protected:
+  static std::unique_ptr<VirtualCluster> CreateVirtualCluster(int num_gpus) {
+    DeviceProperties cpu_device;
+    cpu_device.set_type("CPU");
+    cpu_device.set_frequency(1000);
+    cpu_device.set_num_cores(4);
+    cpu_device.set_bandwidth(32);
+    cpu_device.set_memory_size(1024 * 1024 * 1024);
+    DeviceProperties gpu_device;
+    gpu_device.set_type("GPU");
+    gpu_device.set_frequency(1000);
+    gpu_device.set_num_cores(24);
+    gpu_device.set_bandwidth(128);
+    gpu_device.set_memory_size(1024 * 1024 * 1024);
+    gpu_device.mutable_environment()->insert({"architecture", "6"});
+    std::unordered_map<string, DeviceProperties> devices;
+    devices["/job:localhost/replica:0/task:0/device:CPU:0"] = cpu_device;
+    for (int i = 0; i < num_gpus; ++i) {
+      devices[strings::StrCat("/job:localhost/replica:0/task:0/device:GPU:",
+                              i)] = gpu_device;
+    }
+    return absl::make_unique<VirtualCluster>(devices);
+  }
+
+  // Two independent chains of MatMuls whose results are added.
+  static GrapplerItem CreateTwoBranchItem() {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT,
+                                ops::Placeholder::Shape({1024, 1024}));
+    Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT,
+                                ops::Placeholder::Shape({1024, 1024}));
+    Output a1 = ops::MatMul(s.WithOpName("a1"), a, a);
+    Output a2 = ops::MatMul(s.WithOpName("a2"), a1, a1);
+    Output a3 = ops::MatMul(s.WithOpName("a3"), a2, a2);
+    Output b1 = ops::MatMul(s.WithOpName("b1"), b, b);
+    Output b2 = ops::MatMul(s.WithOpName("b2"), b1, b1);
+    Output b3 = ops::MatMul(s.WithOpName("b3"), b2, b2);
+    Output out = ops::Add(s.WithOpName("out"), a3, b3);
+
+    GrapplerItem item;
+    item.fetch = {"out"};
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  }
+};
+
+TEST_F(DevicePlacementOptimizerTest, NoClusterIsNoop) {
+  GrapplerItem item = CreateTwoBranchItem();
+  DevicePlacementOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  CompareGraphs(item.graph, output);
+}
+
+TEST_F(DevicePlacementOptimizerTest, SingleGpuIsNoop) {
+  GrapplerItem item = CreateTwoBranchItem();
+  std::unique_ptr<VirtualCluster> cluster = CreateVirtualCluster(1);
+  DevicePlacementOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+  CompareGraphs(item.graph, output);
+}
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+TEST_F(DevicePlacementOptimizerTest, IndependentBranchesAreSpread) {
+  GrapplerItem item = CreateTwoBranchItem();
+  std::unique_ptr<VirtualCluster> cluster = CreateVirtualCluster(2);
+  DevicePlacementOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  NodeMap node_map(&output);
+  const string& a_device = node_map.GetNode("a1")->device();
+  const string& b_device = node_map.GetNode("b1")->device();
+  EXPECT_FALSE(a_device.empty());
+  EXPECT_FALSE(b_device.empty());
+  EXPECT_NE(a_device, b_device);
+  EXPECT_EQ(node_map.GetNode("a2")->device(), a_device);
+  EXPECT_EQ(node_map.GetNode("a3")->device(), a_device);
+  EXPECT_EQ(node_map.GetNode("b2")->device(), b_device);
+  EXPECT_EQ(node_map.GetNode("b3")->device(), b_device);
+}
+
+TEST_F(DevicePlacementOptimizerTest, KeepsRequestedDevices) {
+  GrapplerItem item = CreateTwoBranchItem();
+  const string kCpu = "/job:localhost/replica:0/task:0/device:CPU:0";
+  for (NodeDef& node : *item.graph.mutable_node()) {
+    if (node.name() == "out") node.set_device(kCpu);
+  }
+  std::unique_ptr<VirtualCluster> cluster = CreateVirtualCluster(2);
+  DevicePlacementOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(node_map.GetNode("out")->device(), kCpu);
+}
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
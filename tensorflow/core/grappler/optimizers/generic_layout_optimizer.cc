@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_transposer.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_transposer_factory.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/util.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -117,12 +118,25 @@ inline std::pair<string, string> GetSrcAndDstDataFormats(
   return {src_format, dst_format};
 }
 
+// Returns true if the layout sensitive op has a CPU kernel in NCHW format. The
+// oneDNN kernels cover convolutions, pooling and batch normalization, while
+// the Eigen kernels of DepthToSpace and SpaceToDepth are NHWC only.
+inline bool HasNCHWCpuKernel(const NodeDef& node) {
+  return node.op() != "DepthToSpace" && node.op() != "SpaceToDepth" &&
+         node.op() != "FusedConv2DBiasActivation";
+}
+
 Status ExpandLayoutSensitiveOp(TransposeContext* context,
                                TransposerFactory* transposer_factory) {
+  const bool is_cpu_to_nchw =
+      context->target_device == kCPU && context->dst_format == kNCHW;
   const int num_nodes = context->num_nodes;
   for (int i = 0; i < num_nodes; ++i) {
     auto* node_view = context->graph_view->GetNode(i);
     auto* node_def = node_view->node();
+    if (is_cpu_to_nchw && !HasNCHWCpuKernel(*node_def)) {
+      continue;
+    }
     if (IsLayoutSensitiveOp(*node_def)) {
       std::shared_ptr<Transposer> transposer =
           transposer_factory->GetTransposer(*node_def);
@@ -398,8 +412,9 @@ Status EraseOutputShapeAttrs(TransposeContext* context) {
 
 // When there is a GPU, the computation graph is converted to NCHW format.
 // When there is only CPU, there will be no conversion by default, unless user
-// chose to convert the graph to a desired format. Currently, NCHW -> NHWC
-// format conversion is available on CPU.
+// chose to convert the graph to a desired format. NCHW -> NHWC format
+// conversion is always available on CPU, NHWC -> NCHW conversion only when the
+// oneDNN kernels are enabled, because most Eigen CPU kernels are NHWC only.
 Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
                                         const GrapplerItem& item,
                                         GraphDef* output) {
@@ -429,12 +444,17 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
       case RewriterConfig::NCHW_TO_NHWC:
         context.AssignDeviceAndDataFormats(kCPU, kNCHW, kNHWC);
         break;
-      // TODO(intel-tf): Add functionality for NHWC_TO_NCHW layout conversion on
-      // CPU.
+      // The MKL layout pass propagates the oneDNN blocked layouts between the
+      // NCHW ops of a region and reorders only at its boundaries, so this pass
+      // only has to move the region to NCHW.
       case RewriterConfig::NHWC_TO_NCHW:
-        return errors::Aborted(
-            "Conversion from NHWC to NCHW is currently not  available for "
-            "CPU.");
+        if (!IsMKLEnabled()) {
+          return errors::Aborted(
+              "Conversion from NHWC to NCHW is only available for CPU when "
+              "oneDNN is enabled.");
+        }
+        context.AssignDeviceAndDataFormats(kCPU, kNHWC, kNCHW);
+        break;
       default:
         *output = item.graph;
         VLOG(2) << "No layout conversion will take place for CPU.";
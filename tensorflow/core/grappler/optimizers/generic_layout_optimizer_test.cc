@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/util.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -357,6 +358,45 @@ TEST_F(GenericLayoutOptimizerTest, CPUDevice) {
 #endif  // (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
 }
 
+TEST_F(GenericLayoutOptimizerTest, CPUDeviceNHWCToNCHW) {
+#if (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+  GTEST_SKIP() << "CPU layout conversion only applies without GPUs.";
+#endif  // (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/CPU:0");
+  auto input =
+      ops::RandomUniform(s.WithOpName("Input"), {8, 5, 5, 3}, DT_FLOAT);
+  auto filter =
+      ops::RandomUniform(s.WithOpName("Filter"), {2, 2, 3, 2}, DT_FLOAT);
+  auto conv = ops::Conv2D(s.WithOpName("Conv2D"), input, filter, {1, 1, 1, 1},
+                          "VALID", ops::Conv2D::Attrs().DataFormat("NHWC"));
+  auto space_to_depth =
+      ops::SpaceToDepth(s.WithOpName("SpaceToDepth"), conv, 2,
+                        ops::SpaceToDepth::Attrs().DataFormat("NHWC"));
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {space_to_depth});
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GenericLayoutOptimizer optimizer(RewriterConfig::DEFAULT,
+                                   RewriterConfig::NHWC_TO_NCHW);
+  GraphDef output;
+  Status status = optimizer.Optimize(virtual_cluster_.get(), item, &output);
+  if (!IsMKLEnabled()) {
+    EXPECT_TRUE(errors::IsAborted(status));
+    return;
+  }
+  TF_ASSERT_OK(status);
+
+  utils::GraphView graph_view(&output, &status);
+  TF_ASSERT_OK(status);
+  auto* conv_node = graph_view.GetNode("Conv2D");
+  ASSERT_NE(conv_node, nullptr);
+  VerifyDataFormatAttributeMatch(conv_node, "NCHW");
+  // SpaceToDepth has no NCHW CPU kernel and must stay in NHWC.
+  auto* space_to_depth_node = graph_view.GetNode("SpaceToDepth");
+  ASSERT_NE(space_to_depth_node, nullptr);
+  VerifyDataFormatAttributeMatch(space_to_depth_node, "NHWC");
+}
+
 TEST_F(GenericLayoutOptimizerTest, NoOptimizeIntegerConvolution) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   auto conv = SimpleConv2D<int32>(&s, 4, 2, "VALID", "");
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 
 #include <algorithm>
+#include <map>
 #include <queue>
 #include <set>
 #include <unordered_map>
@@ -30,6 +31,8 @@ limitations under the License.
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
 #include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -440,6 +443,35 @@ void RecomputeSubgraph(
   }
 }
 
+// Returns true for nodes whose inputs we may want to recompute. This matches
+// node names that contain recomputation_targets_name_scope as a name scope,
+// meaning it either begins with or contains the name scope. Defaults to
+// "gradients/" which will match any node names that begins with "gradients/"
+// or contains "/gradients/".
+bool IsRecomputationTarget(const NodeDef& node,
+                           const string& recomputation_targets_name_scope) {
+  return absl::StartsWith(node.name(), recomputation_targets_name_scope) ||
+         static_cast<int>(
+             node.name().find("/" + recomputation_targets_name_scope)) != -1;
+}
+
+// Duplicates `subgraphs` in `graph`, which must be topologically sorted with
+// `node_map` built for it.
+void RecomputeSubgraphs(const std::vector<RecomputedSubGraph>& subgraphs,
+                        const NodeMap& node_map, GraphDef* graph) {
+  std::unordered_map<const NodeDef*, int> topological_numbering;
+  for (int node_number = 0; node_number < graph->node().size();
+       ++node_number) {
+    topological_numbering[graph->mutable_node(node_number)] =
+        graph->node().size() - node_number - 1;
+  }
+  // Duplicate the indicated sub-graphs and set up control dependencies
+  for (const RecomputedSubGraph& subgraph : subgraphs) {
+    RecomputeSubgraph(subgraph.recomputed_source_nodes, subgraph.target_nodes,
+                      node_map, topological_numbering, graph);
+  }
+}
+
 void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                                 const string& recomputation_targets_name_scope,
                                 GraphDef* graph, const GrapplerItem& item) {
@@ -461,15 +493,7 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
   }
   std::function<bool(const NodeDef&)> is_target =
       [&recomputation_targets_name_scope](const NodeDef& node) {
-        // Nodes whose inputs we may want to recompute. This matches node names
-        // that contain recomputation_targets_name_scope as a name scope,
-        // meaning it either begins with or contains the name scope.
-        // Defaults to "gradients/" which will match any node names that begins
-        // with "gradients/" or contains "/gradients/".
-        return absl::StartsWith(node.name(),
-                                recomputation_targets_name_scope) ||
-               static_cast<int>(node.name().find(
-                   "/" + recomputation_targets_name_scope)) != -1;
+        return IsRecomputationTarget(node, recomputation_targets_name_scope);
       };
 
   if (optimization_level == RewriterConfig::RECOMPUTATION_HEURISTICS ||
@@ -498,18 +522,211 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
         is_target);
   }
   if (!recomputed_subgraphs.empty()) {
-    std::unordered_map<const NodeDef*, int> topological_numbering;
-    for (int node_number = 0; node_number < graph->node().size();
-         ++node_number) {
-      topological_numbering[graph->mutable_node(node_number)] =
-          graph->node().size() - node_number - 1;
+    RecomputeSubgraphs(recomputed_subgraphs, node_map, graph);
+  }
+}
+
+// A forward node whose outputs are live at the peak memory usage of a device
+// because target nodes consume them later.
+struct RecomputationCandidate {
+  const NodeDef* node;
+  // The bytes of the node outputs that are live at the peak, minus the bytes
+  // of its inputs that would have to stay live to recompute it.
+  int64_t memory_saved;
+  // The predicted time to recompute the node.
+  Costs::NanoSeconds compute_time;
+  double savings_per_nanosecond;
+};
+
+// Returns true if `node` may be recomputed for the target nodes it feeds.
+bool IsRecomputable(const NodeDef& node, const NodeMap& node_map,
+                    const std::unordered_set<string>& feeds,
+                    const std::function<bool(const NodeDef&)>& is_target) {
+  if (is_target(node) || feeds.count(node.name()) > 0 ||
+      NumNonControlInputs(node) == 0 || IsControlFlow(node) ||
+      IsPersistent(node) || !IsFreeOfSideEffect(node)) {
+    return false;
+  }
+  for (const string& input_name : node.input()) {
+    const NodeDef* input_node = node_map.GetNode(input_name);
+    if (input_node == nullptr || is_target(*input_node)) return false;
+  }
+  for (const NodeDef* output : node_map.GetOutputs(node.name())) {
+    if (is_target(*output)) return true;
+  }
+  return false;
+}
+
+// Chooses the nodes to recompute with the memory and op cost models rather
+// than with op type patterns. For each device whose predicted peak memory
+// usage exceeds its memory, the recomputable nodes with outputs live at the
+// peak are picked in the order of the bytes they save per nanosecond of
+// recomputation, until the peak is predicted to fit. Connected picked nodes
+// are recomputed together, so that they read each other's recomputed outputs.
+// Returns true if the graph was changed.
+bool RecomputationPlanningPass(Cluster* cluster,
+                               const string& recomputation_targets_name_scope,
+                               GrapplerItem* item) {
+  // Sorting invalidates NodeDef pointers, so it needs to be done before we
+  // start collecting those.
+  if (!TopologicalSort(&item->graph).ok()) {
+    return false;
+  }
+  GraphMemory memory(*item);
+  Status s = memory.InferStatically(cluster->GetDevices());
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer memory usage: " << s.error_message();
+    return false;
+  }
+  GraphProperties properties(*item);
+  s = properties.InferStatically(/*assume_valid_feeds=*/true,
+                                 /*aggressive_shape_inference=*/false,
+                                 /*include_tensor_values=*/false);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer shapes: " << s.error_message();
+    return false;
+  }
+
+  NodeMap node_map(&item->graph);
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : item->graph.node()) {
+    name_to_node[node.name()] = &node;
+  }
+  // Fed nodes would not take on the fed value when recomputed.
+  std::unordered_set<string> feeds;
+  for (const auto& feed : item->feed) {
+    feeds.insert(NodeName(feed.first));
+  }
+  std::function<bool(const NodeDef&)> is_target =
+      [&recomputation_targets_name_scope](const NodeDef& node) {
+        return IsRecomputationTarget(node, recomputation_targets_name_scope);
+      };
+  OpLevelCostEstimator cost_estimator;
+
+  std::unordered_set<const NodeDef*> recomputed_nodes;
+  for (const auto& device : cluster->GetDevices()) {
+    const string& name = device.first;
+    const DeviceProperties& prop = device.second;
+    if (prop.memory_size() <= 0) {
+      VLOG(1) << "Peak memory usage unknown for device " << name;
+      continue;
+    }
+    const GraphMemory::MemoryUsage& mem_usage = memory.GetPeakMemoryUsage(name);
+    if (mem_usage.used_memory <= prop.memory_size()) {
+      continue;
+    }
+    const int64_t required_savings =
+        mem_usage.used_memory - prop.memory_size();
+
+    std::map<string, int64_t> live_bytes_per_node;
+    std::unordered_set<string> live_tensors;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      live_bytes_per_node[live_tensor.node] += live_tensor.memory_used;
+      live_tensors.insert(
+          strings::StrCat(live_tensor.node, ":", live_tensor.output_id));
+    }
+
+    std::vector<RecomputationCandidate> candidates;
+    for (const auto& live_bytes : live_bytes_per_node) {
+      const NodeDef* node = node_map.GetNode(live_bytes.first);
+      if (node == nullptr || recomputed_nodes.count(node) > 0 ||
+          !IsRecomputable(*node, node_map, feeds, is_target)) {
+        continue;
+      }
+      const std::vector<OpInfo::TensorProperties>& input_props =
+          properties.GetInputProperties(node->name());
+      int64_t memory_saved = live_bytes.second;
+      for (int i = 0; i < node->input_size() && i < input_props.size(); ++i) {
+        if (IsControlInput(node->input(i))) break;
+        const TensorId input = ParseTensorName(node->input(i));
+        if (live_tensors.count(strings::StrCat(input.node(), ":",
+                                               input.index())) == 0) {
+          memory_saved -= CalculateTensorSize(input_props[i]);
+        }
+      }
+      if (memory_saved <= 0) {
+        continue;
+      }
+
+      OpContext op_context;
+      op_context.name = node->name();
+      op_context.device_name = name;
+      op_context.op_info =
+          BuildOpInfoWithoutDevice(*node, name_to_node, input_props);
+      *op_context.op_info.mutable_device() = prop;
+      for (const auto& output : properties.GetOutputProperties(node->name())) {
+        *op_context.op_info.add_outputs() = output;
+      }
+      const Costs::NanoSeconds compute_time = std::max(
+          Costs::NanoSeconds(1),
+          cost_estimator.PredictCosts(op_context).compute_time);
+      candidates.push_back(
+          {node, memory_saved, compute_time,
+           static_cast<double>(memory_saved) / compute_time.count()});
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const RecomputationCandidate& first,
+                 const RecomputationCandidate& second) {
+                return first.savings_per_nanosecond >
+                           second.savings_per_nanosecond ||
+                       (first.savings_per_nanosecond ==
+                            second.savings_per_nanosecond &&
+                        first.node->name() < second.node->name());
+              });
+
+    int num_recomputed = 0;
+    int64_t predicted_savings = 0;
+    Costs::NanoSeconds added_compute_time(0);
+    for (const RecomputationCandidate& candidate : candidates) {
+      if (predicted_savings >= required_savings) {
+        break;
+      }
+      VLOG(1) << "Will recompute " << candidate.node->name() << " to save "
+              << candidate.memory_saved << " bytes for "
+              << candidate.compute_time.count() << "ns";
+      recomputed_nodes.insert(candidate.node);
+      ++num_recomputed;
+      predicted_savings += candidate.memory_saved;
+      added_compute_time += candidate.compute_time;
+    }
+    if (num_recomputed > 0) {
+      LOG(INFO) << "Recomputing " << num_recomputed << " nodes on " << name
+                << " is predicted to save " << predicted_savings << " of the "
+                << required_savings << " bytes over the device memory, for "
+                << added_compute_time.count() << "ns of recomputation.";
     }
-    // Duplicate the indicated sub-graphs and set up control dependencies
-    for (const RecomputedSubGraph& subgraph : recomputed_subgraphs) {
-      RecomputeSubgraph(subgraph.recomputed_source_nodes, subgraph.target_nodes,
-                        node_map, topological_numbering, graph);
+  }
+  if (recomputed_nodes.empty()) {
+    return false;
+  }
+
+  std::vector<RecomputedSubGraph> recomputed_subgraphs;
+  std::unordered_set<const NodeDef*> grouped_nodes;
+  for (const NodeDef& node : item->graph.node()) {
+    if (recomputed_nodes.count(&node) == 0 || grouped_nodes.count(&node) > 0) {
+      continue;
     }
+    RecomputedSubGraph subgraph;
+    subgraph.recomputed_source_nodes.insert(&node);
+    connected_subgraph(node_map,
+                       true,  // Collect inputs
+                       true,  // Collect outputs
+                       [&recomputed_nodes](const NodeDef& candidate) {
+                         return recomputed_nodes.count(&candidate) != 0;
+                       },
+                       &subgraph.recomputed_source_nodes);
+    for (const NodeDef* recomputed_node : subgraph.recomputed_source_nodes) {
+      grouped_nodes.insert(recomputed_node);
+      for (NodeDef* output : node_map.GetOutputs(recomputed_node->name())) {
+        if (is_target(*output)) {
+          subgraph.target_nodes.insert(output);
+        }
+      }
+    }
+    recomputed_subgraphs.push_back(std::move(subgraph));
   }
+  RecomputeSubgraphs(recomputed_subgraphs, node_map, &item->graph);
+  return true;
 }
 
 bool SchedulingPass(Cluster* cluster, std::unique_ptr<GraphMemory>* memory_ptr,
@@ -1387,7 +1604,13 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       (optimization_level_ == RewriterConfig::RECOMPUTATION_HEURISTICS ||
        optimization_level_ == RewriterConfig::HEURISTICS ||
        optimization_level_ == RewriterConfig::MANUAL);
-  if (!run_recomputation_pass && nodes_to_relax.empty() && item.fetch.empty()) {
+  // Planning recomputations needs the memory of the devices and the fetches
+  // to infer the memory usage.
+  bool run_recomputation_planning_pass =
+      optimization_level_ == RewriterConfig::RECOMPUTATION_COST_MODEL &&
+      !item.fetch.empty() && cluster != nullptr;
+  if (!run_recomputation_pass && !run_recomputation_planning_pass &&
+      nodes_to_relax.empty() && item.fetch.empty()) {
     return errors::Aborted("Nothing to do.");
   }
 
@@ -1399,6 +1622,11 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                recomputation_targets_name_scope_,
                                &optimized_item.graph, item);
   }
+  if (run_recomputation_planning_pass) {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    RecomputationPlanningPass(cluster, recomputation_targets_name_scope_,
+                              &optimized_item);
+  }
 
   std::unordered_set<string> skip_list;
   // Bound the number of rewrite passes to avoid long processing times on graphs
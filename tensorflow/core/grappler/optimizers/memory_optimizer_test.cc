@@ -20,6 +20,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/strings/match.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -346,6 +347,82 @@ TEST_F(MemoryOptimizerTest, SwappingHeuristics) {
 #endif
 }
 
+TEST_F(MemoryOptimizerTest, RecomputationCostModel) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  // Each activation takes 512KB, and several of them are live when the
+  // gradients start, which overflows the 1MB of the device.
+  Output v = ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  Output a = ops::Square(s.WithOpName("a").WithDevice("/gpu:0"), v);
+  Output b = ops::Sqrt(s.WithOpName("b").WithDevice("/gpu:0"), a);
+  Output c = ops::Exp(s.WithOpName("c").WithDevice("/gpu:0"), b);
+  Output d = ops::AddN(s.WithOpName("gradients/d").WithDevice("/gpu:0"), {c});
+  Output e =
+      ops::AddN(s.WithOpName("gradients/e").WithDevice("/gpu:0"), {d, b});
+  Output f =
+      ops::AddN(s.WithOpName("gradients/f").WithDevice("/gpu:0"), {e, a});
+
+  Output constant = ops::Const(s.WithOpName("constant"), 0.0f, {128, 128, 8});
+  Output init = ops::Assign(s.WithOpName("init"), v, constant);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/f"};
+  item.init_ops = {init.name()};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_COST_MODEL);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  // Some gradient must read a recomputed activation.
+  int num_recomputed_inputs = 0;
+  for (const NodeDef& node : output.node()) {
+    if (absl::StartsWith(node.name(), "Recomputed/")) {
+      EXPECT_FALSE(absl::StartsWith(node.name(), "Recomputed/gradients/"));
+    }
+    if (!absl::StartsWith(node.name(), "gradients/")) continue;
+    for (const string& input : node.input()) {
+      if (absl::StartsWith(input, "Recomputed/")) ++num_recomputed_inputs;
+    }
+  }
+  EXPECT_GT(num_recomputed_inputs, 0);
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized = item.WithGraph(std::move(output));
+  auto tensors = EvaluateFetchNodes(optimized);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+#endif
+}
+
+TEST_F(MemoryOptimizerTest, RecomputationCostModelKeepsGraphsThatFit) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v =
+      ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"), {10, 10}, DT_FLOAT);
+  Output a = ops::Square(s.WithOpName("a").WithDevice("/gpu:0"), v);
+  Output b = ops::Sqrt(s.WithOpName("b").WithDevice("/gpu:0"), a);
+  Output c = ops::AddN(s.WithOpName("gradients/c").WithDevice("/gpu:0"), {b});
+  Output d =
+      ops::AddN(s.WithOpName("gradients/d").WithDevice("/gpu:0"), {c, a});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/d"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_COST_MODEL);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  for (const NodeDef& node : output.node()) {
+    EXPECT_FALSE(absl::StartsWith(node.name(), "Recomputed/"));
+  }
+}
+
 TEST_F(MemoryOptimizerTest, UnswappableInputs) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output v = ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"),
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
@@ -35,11 +37,13 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
 #include "tensorflow/core/grappler/optimizers/debug_stripper.h"
 #include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/device_placement_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/function_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/implementation_selector.h"
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
 #include "tensorflow/core/grappler/optimizers/pin_to_host_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/remapper.h"
@@ -53,7 +57,10 @@ limitations under the License.
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
@@ -61,6 +68,10 @@ limitations under the License.
 // #TODO(b/200087693): LLVM does not build on Fuchsia.
 #ifndef __Fuchsia__
 #include "tensorflow/core/grappler/optimizers/tfg_optimizer_hook.h"
+#include "tensorflow/core/ir/ops.h"
+#include "tensorflow/core/transforms/cse/cse_pass.h"
+#include "tensorflow/core/transforms/dependency_optimizer/dependency_optimizer_pass.h"
+#include "tensorflow/core/transforms/toposort/toposort_pass.h"
 #endif
 
 namespace tensorflow {
@@ -161,6 +172,91 @@ bool MemoryOptimizerEnabled(RewriterConfig::MemOptType mem_opt_type,
   return mem_opt_type != RewriterConfig::NO_MEM_OPT;
 }
 
+// Returns the number of threads to optimize the functions of the library with.
+// Functions are optimized sequentially unless
+// TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS asks for more threads.
+int NumFunctionOptimizationThreads() {
+  int64_t num_threads;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS",
+                                  /*default_val=*/1, &num_threads));
+  return std::max<int64_t>(num_threads, 1);
+}
+
+// Returns whether `cfg` may run custom or plugin graph optimizers, which are
+// not required to be thread-safe.
+bool UsesCustomOrPluginOptimizers(const RewriterConfig& cfg) {
+  if (!cfg.custom_optimizers().empty()) return true;
+  if (cfg.use_plugin_optimizers() != RewriterConfig::OFF &&
+      PluginGraphOptimizerRegistry::HasRegisteredOptimizers()) {
+    return true;
+  }
+  const std::vector<string> custom_optimizers =
+      CustomGraphOptimizerRegistry::GetRegisteredOptimizers();
+  return absl::c_any_of(cfg.optimizers(), [&](const string& name) {
+    return absl::c_linear_search(custom_optimizers, name);
+  });
+}
+
+// Returns the names of the ops and functions that `func` calls, directly or
+// through function attributes.
+absl::flat_hash_set<string> CalledFunctions(const FunctionDef& func) {
+  absl::flat_hash_set<string> called;
+  for (const NodeDef& node : func.node_def()) {
+    called.insert(node.op());
+    for (const auto& attr : node.attr()) {
+      const AttrValue& attr_value = attr.second;
+      if (attr_value.has_func()) {
+        called.insert(attr_value.func().name());
+      }
+      for (const NameAttrList& list_func : attr_value.list().func()) {
+        called.insert(list_func.name());
+      }
+    }
+  }
+  return called;
+}
+
+// Splits `funcs` into waves, so that every function only calls functions of
+// earlier waves (or functions that are not in `funcs`). Functions that call
+// each other recursively end up in one wave. Keeps the order of `funcs`
+// within each wave.
+std::vector<std::vector<const FunctionDef*>> SplitIntoWaves(
+    const std::vector<const FunctionDef*>& funcs) {
+  std::vector<absl::flat_hash_set<string>> called_funcs;
+  called_funcs.reserve(funcs.size());
+  absl::flat_hash_set<string> pending;
+  for (const FunctionDef* func : funcs) {
+    called_funcs.push_back(CalledFunctions(*func));
+    pending.insert(func->signature().name());
+  }
+
+  std::vector<std::vector<const FunctionDef*>> waves;
+  while (!pending.empty()) {
+    std::vector<int> wave;
+    for (int i = 0; i < funcs.size(); ++i) {
+      const string& name = funcs[i]->signature().name();
+      if (!pending.contains(name)) continue;
+      const bool calls_pending = absl::c_any_of(
+          called_funcs[i], [&](const string& called) {
+            return called != name && pending.contains(called);
+          });
+      if (!calls_pending) wave.push_back(i);
+    }
+    if (wave.empty()) {
+      // The remaining functions call each other; optimize them together.
+      for (int i = 0; i < funcs.size(); ++i) {
+        if (pending.contains(funcs[i]->signature().name())) wave.push_back(i);
+      }
+    }
+    waves.emplace_back();
+    for (int i : wave) {
+      pending.erase(funcs[i]->signature().name());
+      waves.back().push_back(funcs[i]);
+    }
+  }
+  return waves;
+}
+
 Status GetGraphDevice(const GraphDef& g_def, std::set<std::string>* devices) {
   for (auto& node : g_def.node()) {
     DeviceNameUtils::ParsedName parsed_name;
@@ -224,6 +320,8 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
 #endif
   MK_OPT("auto_mixed_precision_cpu", "auto_mixed_precision_cpu",
          new AutoMixedPrecision(AutoMixedPrecisionMode::CPU));
+  MK_OPT("auto_mixed_precision_cpu_bf16", "auto_mixed_precision_cpu_bf16",
+         new AutoMixedPrecision(AutoMixedPrecisionMode::CPU_BF16));
   MK_OPT("memory", "memory_optimization",
          new MemoryOptimizer(RewriterConfig::MANUAL));
   MK_OPT("common_subgraph_elimination", "common_subgraph_elimination",
@@ -242,6 +340,8 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
                                       cfg_.scoped_allocator_opts()));
   MK_OPT("pin_to_host", "pin_to_host_optimization",
          new PinToHostOptimizer(cfg_.pin_to_host_optimization()));
+  MK_OPT("device_placement", "device_placement_optimization",
+         new DevicePlacementOptimizer(cfg_.device_placement_optimization()));
 
   return std::unique_ptr<GraphOptimizer>();
 }
@@ -257,6 +357,21 @@ MetaOptimizer::MetaOptimizer(DeviceBase* cpu_device, const ConfigProto& cfg)
   auto global_jit_level =
       cfg.graph_options().optimizer_options().global_jit_level();
   xla_auto_clustering_on_ = IsXlaGlobalJitOn(global_jit_level);
+  num_function_optimization_threads_ = NumFunctionOptimizationThreads();
+  if (num_function_optimization_threads_ > 1 &&
+      UsesCustomOrPluginOptimizers(cfg_)) {
+    VLOG(1) << "Optimizing library functions sequentially, since custom or "
+               "plugin optimizers are not required to be thread-safe.";
+    num_function_optimization_threads_ = 1;
+  }
+  TF_CHECK_OK(ReadStringFromEnvVar("TF_GRAPPLER_CACHE_DIR",
+                                   /*default_val=*/"", &graph_cache_dir_));
+#ifndef __Fuchsia__
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_GRAPPLER_USE_TFG_PIPELINE",
+                                 /*default_val=*/false, &use_tfg_pipeline_));
+#else
+  use_tfg_pipeline_ = false;
+#endif
 }
 
 Status MetaOptimizer::InitializeOptimizers(
@@ -272,12 +387,6 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(MakeUnique<ModelPruner>());
   }
 
-  // #TODO(b/200087693): LLVM does not build on Fuchsia.
-#ifndef __Fuchsia__
-  // Hooks the MLIR optimizer, it won't run any optimizations right now.
-  optimizers->push_back(MakeUnique<mlir::tfg::TfgGrapplerOptimizer>(""));
-#endif
-
 #define USER_IS_ON(CFG) cfg_.CFG() == RewriterConfig::ON
 #define USER_NOT_OFF(CFG) cfg_.CFG() != RewriterConfig::OFF
 #define PLUGIN_IS_ON(CFG) \
@@ -286,6 +395,43 @@ Status MetaOptimizer::InitializeOptimizers(
   plugin_configs.toggle_config[#CFG] != RewriterConfig::OFF
 #define BOTH_ARE_ON(CFG) USER_IS_ON(CFG) && PLUGIN_IS_ON(CFG)
 #define BOTH_NOT_OFF(CFG) USER_NOT_OFF(CFG) && PLUGIN_NOT_OFF(CFG)
+  const bool run_common_subgraph_elimination =
+      BOTH_NOT_OFF(common_subgraph_elimination) &&
+      BOTH_NOT_OFF(arithmetic_optimization);
+
+  // #TODO(b/200087693): LLVM does not build on Fuchsia.
+#ifndef __Fuchsia__
+  if (use_tfg_pipeline_) {
+    // Runs the TFG counterparts of the common subgraph elimination and of the
+    // removal of redundant control dependencies on the graph and, in
+    // parallel, on the functions of the library, without GraphDef copies in
+    // between.
+    const bool run_dependency_optimization =
+        BOTH_NOT_OFF(dependency_optimization);
+    optimizers->push_back(MakeUnique<mlir::tfg::TfgGrapplerOptimizer>(
+        "tfg_pipeline",
+        [run_common_subgraph_elimination, run_dependency_optimization](
+            mlir::OpPassManager& pm, const GrapplerItem& item) {
+          const std::unordered_set<string> nodes_to_preserve =
+              item.NodesToPreserve();
+          const std::vector<string> preserve(nodes_to_preserve.begin(),
+                                             nodes_to_preserve.end());
+          for (mlir::OpPassManager* nested :
+               {&pm.nest<mlir::tfg::GraphOp>(),
+                &pm.nest<mlir::tfg::GraphFuncOp>()}) {
+            nested->addPass(mlir::tfg::CreateTopoSortPass());
+            if (run_common_subgraph_elimination)
+              nested->addPass(mlir::tfg::CreateCSEPass(preserve));
+            if (run_dependency_optimization)
+              nested->addPass(mlir::tfg::CreateDependencyOptimizerPass());
+          }
+        }));
+  } else {
+    // Hooks the MLIR optimizer, it won't run any optimizations right now.
+    optimizers->push_back(MakeUnique<mlir::tfg::TfgGrapplerOptimizer>(""));
+  }
+#endif
+
   if (BOTH_NOT_OFF(implementation_selector)) {
     optimizers->push_back(MakeUnique<ImplementationSelector>());
   }
@@ -294,8 +440,7 @@ Status MetaOptimizer::InitializeOptimizers(
         cfg_.function_optimization(),
         /*lower_control_flow=*/LowerControlFlow()));
   }
-  if (BOTH_NOT_OFF(common_subgraph_elimination) &&
-      BOTH_NOT_OFF(arithmetic_optimization)) {
+  if (run_common_subgraph_elimination && !use_tfg_pipeline_) {
     optimizers->push_back(MakeUnique<CommonSubgraphElimination>(
         cfg_.common_subgraph_elimination()));
   }
@@ -332,6 +477,12 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(
         MakeUnique<AutoMixedPrecision>(AutoMixedPrecisionMode::CPU));
   }
+  if (AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_cpu_bf16()) &&
+      AutoMixedPrecisionEnabled(
+          plugin_configs.toggle_config["auto_mixed_precision_cpu_bf16"])) {
+    optimizers->push_back(
+        MakeUnique<AutoMixedPrecision>(AutoMixedPrecisionMode::CPU_BF16));
+  }
   if (BOTH_ARE_ON(pin_to_host_optimization)) {
     optimizers->push_back(MakeUnique<PinToHostOptimizer>());
   }
@@ -357,6 +508,10 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(
         MakeUnique<DependencyOptimizer>(cfg_.dependency_optimization()));
   }
+  if (BOTH_ARE_ON(device_placement_optimization)) {
+    optimizers->push_back(MakeUnique<DevicePlacementOptimizer>(
+        cfg_.device_placement_optimization()));
+  }
   if (MemoryOptimizerEnabled(cfg_.memory_optimization(),
                              xla_auto_clustering_on_) &&
       PLUGIN_NOT_OFF(memory_optimization)) {
@@ -521,6 +676,7 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
     PRINT_CFG(remapping)
     PRINT_CFG(loop_optimization)
     PRINT_CFG(dependency_optimization)
+    PRINT_CFG(device_placement_optimization)
     PRINT_CFG(scoped_allocator_optimization)
 #undef PRINT_CFG
     user_cfg.toggle_config["auto_mixed_precision"] =
@@ -535,6 +691,10 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
         AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_cpu())
             ? RewriterConfig::ON
             : RewriterConfig::OFF;
+    user_cfg.toggle_config["auto_mixed_precision_cpu_bf16"] =
+        AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_cpu_bf16())
+            ? RewriterConfig::ON
+            : RewriterConfig::OFF;
     user_cfg.toggle_config["memory_optimization"] =
         MemoryOptimizerEnabled(cfg_.memory_optimization(),
                                config_proto_.graph_options()
@@ -563,11 +723,14 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
       PRINT_CFG("auto_mixed_precision", "auto_mixed_precision")
       PRINT_CFG("auto_mixed_precision_mkl", "auto_mixed_precision_mkl")
       PRINT_CFG("auto_mixed_precision_cpu", "auto_mixed_precision_cpu")
+      PRINT_CFG("auto_mixed_precision_cpu_bf16",
+                "auto_mixed_precision_cpu_bf16")
       PRINT_CFG("pin_to_host", "pin_to_host_optimization")
       PRINT_CFG("layout", "layout_optimizer")
       PRINT_CFG("remap", "remapping")
       PRINT_CFG("loop", "loop_optimization")
       PRINT_CFG("dependency", "dependency_optimization")
+      PRINT_CFG("device_placement", "device_placement_optimization")
       PRINT_CFG("memory", "memory_optimization")
       PRINT_CFG("autoparallel", "auto_parallel")
       PRINT_CFG("scoped_allocator", "scoped_allocator_optimization")
@@ -603,7 +766,9 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
         pair.first == "auto_mixed_precision" ||
         pair.first == "auto_mixed_precision_mkl" ||
         pair.first == "auto_mixed_precision_cpu" ||
+        pair.first == "auto_mixed_precision_cpu_bf16" ||
         pair.first == "pin_to_host_optimization" ||
+        pair.first == "device_placement_optimization" ||
         pair.first == "scoped_allocator_optimization") {
       // These optimizers are turned off by default.
       strings::StrAppend(
@@ -624,8 +789,9 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
   LOG(WARNING) << logs;
 }
 
-Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
-                                    GraphDef* optimized_graph) {
+Status MetaOptimizer::OptimizeGraph(
+    Cluster* cluster, GrapplerItem&& item, GraphDef* optimized_graph,
+    std::vector<GraphOptimizationResult>* optimization_results) {
   int min_graph_nodes = cfg_.min_graph_nodes() == 0 ? kDefaultMinGraphNodes
                                                     : cfg_.min_graph_nodes();
   if (item.graph.node_size() < min_graph_nodes) {
@@ -767,7 +933,7 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
                                    }) != optimization_result.results.end();
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  optimization_results->push_back(optimization_result);
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -936,13 +1102,37 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       "Deleted $0 unreachable functions from the graph (library size = $1)",
       old_library_size - new_library_size, new_library_size);
 
+  // Another process might already have optimized an identical item.
+  std::unique_ptr<OptimizedGraphCache> graph_cache;
+  string graph_cache_key;
+  if (!graph_cache_dir_.empty()) {
+    std::vector<string> device_names;
+    if (cluster != nullptr) device_names = cluster->GetDeviceNames();
+    Status status = OptimizedGraphCache::ComputeKey(
+        item, config_proto_.graph_options(), device_names, &graph_cache_key);
+    if (status.ok()) {
+      graph_cache = MakeUnique<OptimizedGraphCache>(graph_cache_dir_);
+      status = graph_cache->Lookup(graph_cache_key, optimized_graph);
+      if (status.ok()) {
+        VLOG(1) << "Loaded optimized graph for grappler item " << item.id
+                << " from " << graph_cache_dir_;
+        return Status::OK();
+      }
+    }
+    if (!errors::IsNotFound(status)) {
+      LOG(WARNING) << "Failed to look up the optimized graph cache: "
+                   << status;
+    }
+  }
+
   // Save a few small fields from item before we move it.
   bool optimize_function_library =
       item.optimization_options().optimize_function_library;
   const auto producer = item.graph.versions().producer();
 
   // 1. Optimize main graph
-  TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(item), optimized_graph));
+  TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(item), optimized_graph,
+                                   &optimization_results_));
   VLOG(1) << "Optimized main graph.";
   GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
 
@@ -1019,9 +1209,11 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
 
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
+  std::unique_ptr<thread::ThreadPool> thread_pool;
   while (optimize_function_library) {
     optimize_function_library = false;
 
+    std::vector<const FunctionDef*> funcs_to_optimize;
     int function_idx = 0;
     for (const FunctionDef& func : optimized_graph->library().function()) {
       GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
@@ -1053,79 +1245,83 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       // have to reset the flag and do at least one more pass over the library.
       optimize_function_library = true;
       optimized_funcs.insert(func_name);
+      funcs_to_optimize.push_back(&func);
+    }
 
-      // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
-      TF_RETURN_IF_ERROR(
-          MakeGrapplerFunctionItem(func, flib, producer, &func_item));
-
-      // If we need to compute the gradient of optimized function at runtime, we
-      // can't perform non-differentiable rewrites.
-      func_item.optimization_options().allow_non_differentiable_rewrites =
-          !differentiable_functions.contains(func_name);
-
-      // Device set available to the function is defined only by the runtime,
-      // when we instantiate and execute the function. We can't use all devices
-      // available to the main graph, because after partitioning the function
-      // call node might execute on a remote worker.
-      if (!func_item.devices().empty()) {
-        return errors::Internal("GrapplerFunctionItem devices must be empty.");
-      }
+    const bool is_tpu_graph = IsTPUGraphDef(*optimized_graph);
+
+    // Function optimizer specializes function calls into copies of the called
+    // function bodies, so functions are optimized after the functions they
+    // call. The functions of a wave don't call each other, and are optimized
+    // in parallel against the same library. Their results are merged in the
+    // library order, which keeps the output independent of the threads.
+    for (const std::vector<const FunctionDef*>& wave :
+         SplitIntoWaves(funcs_to_optimize)) {
+      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
 
-      // We are not allowed to prune certain types of ops from the graph
-      // instantiated by the function definition, because we must guarantee
-      // function execution semantics wrt side effects (see
-      // function_optimizer.cc).
-      func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
-          false;
-
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (IsTPUGraphDef(*optimized_graph)) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        std::unique_ptr<FunctionDefLibrary> func_item_function_library(
-            func_item.graph.release_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(*func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
+      struct OptimizedFunction {
+        Status status;
+        GrapplerFunctionItem func_item;
+        GraphDef optimized_func_graph;
+        std::vector<GraphOptimizationResult> optimization_results;
+      };
+      std::vector<OptimizedFunction> optimized(wave.size());
+      const auto optimize_function = [&](int i) {
+        const string& func_name = wave[i]->signature().name();
+        // If we need to compute the gradient of optimized function at
+        // runtime, we can't perform non-differentiable rewrites.
+        optimized[i].status = OptimizeFunction(
+            cluster, *wave[i], flib, producer,
+            /*allow_non_differentiable_rewrites=*/
+            !differentiable_functions.contains(func_name), is_tpu_graph,
+            &optimized[i].func_item, &optimized[i].optimized_func_graph,
+            &optimized[i].optimization_results);
+      };
+
+      if (wave.size() > 1 && num_function_optimization_threads_ > 1) {
+        if (thread_pool == nullptr) {
+          thread_pool = MakeUnique<thread::ThreadPool>(
+              Env::Default(), "grappler_function_optimizer",
+              num_function_optimization_threads_);
+        }
+        BlockingCounter counter(wave.size());
+        for (int i = 0; i < wave.size(); ++i) {
+          thread_pool->Schedule([&optimize_function, &counter, i]() {
+            optimize_function(i);
+            counter.DecrementCount();
+          });
+        }
+        counter.Wait();
       } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
+        for (int i = 0; i < wave.size(); ++i) optimize_function(i);
       }
 
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
-      for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+      for (int i = 0; i < wave.size(); ++i) {
+        TF_RETURN_IF_ERROR(optimized[i].status);
+        const string& func_name = wave[i]->signature().name();
+        GrapplerFunctionItem& func_item = optimized[i].func_item;
+        GraphDef& optimized_func_graph = optimized[i].optimized_func_graph;
+
+        // Function body optimization might have created new specialized
+        // functions for each instantiation context. Add them to the library.
+        for (const FunctionDef& func_def :
+             optimized_func_graph.library().function()) {
+          if (flib.Find(func_def.signature().name()) == nullptr) {
+            TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+          }
         }
-      }
 
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
+        // Convert optimized graph back to FunctionDef.
+        FunctionDef optimized_func;
+        func_item.SwapFunctionBody(std::move(optimized_func_graph));
+        TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
 
-      // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+        // Replace optimized function with a new FunctionDef.
+        TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+
+        absl::c_move(optimized[i].optimization_results,
+                     std::back_inserter(optimization_results_));
+      }
     }
 
     // If optimized at least one function, update the graph library.
@@ -1144,9 +1340,77 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
         *optimized_graph);
   }
 
+  // Don't cache graphs that optimizers gave up on because of the deadline.
+  if (graph_cache != nullptr && !DeadlineExceeded()) {
+    Status status = graph_cache->Insert(graph_cache_key, *optimized_graph);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to store the optimized graph in cache: "
+                   << status;
+    }
+  }
+
   return Status::OK();
 }
 
+Status MetaOptimizer::OptimizeFunction(
+    Cluster* cluster, const FunctionDef& func,
+    const FunctionLibraryDefinition& flib, int producer,
+    bool allow_non_differentiable_rewrites, bool is_tpu_graph,
+    GrapplerFunctionItem* func_item, GraphDef* optimized_func_graph,
+    std::vector<GraphOptimizationResult>* optimization_results) {
+  GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+
+  // Make a GrapplerItem from a FunctionDef.
+  TF_RETURN_IF_ERROR(MakeGrapplerFunctionItem(func, flib, producer, func_item));
+
+  func_item->optimization_options().allow_non_differentiable_rewrites =
+      allow_non_differentiable_rewrites;
+
+  // Device set available to the function is defined only by the runtime,
+  // when we instantiate and execute the function. We can't use all devices
+  // available to the main graph, because after partitioning the function
+  // call node might execute on a remote worker.
+  if (!func_item->devices().empty()) {
+    return errors::Internal("GrapplerFunctionItem devices must be empty.");
+  }
+
+  // We are not allowed to prune certain types of ops from the graph
+  // instantiated by the function definition, because we must guarantee
+  // function execution semantics wrt side effects (see
+  // function_optimizer.cc).
+  func_item->optimization_options().allow_pruning_stateful_and_dataset_ops =
+      false;
+
+  // Optimize function body graph.
+  if (is_tpu_graph) {
+    // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+    // passes do not handle TPU functions correctly in a variety of ways
+    // (Note that due to the pre-placement TPU graph rewriting passes, the
+    // TPU-related ops are encapsulated away into functions). For example,
+    // TPU graphs contain TPUReplicateMetadata node that carries relevant
+    // TPU metadata and Grappler passes could prune that away. Grappler
+    // passes could also cause issues around shape inference. Since the
+    // desired and existing behavior is to not optimize TPU functions with
+    // Grappler, this check preserves that. The only exception is
+    // implementation selector what is required to swap in some TPU specific
+    // lowering code and is verified the work correctly on TPUs.
+    ImplementationSelector implementation_selector;
+
+    // Implementation selector needs to have access to valid function
+    // signature and attributes, and it doesn't need actual function body.
+    std::unique_ptr<FunctionDefLibrary> func_item_function_library(
+        func_item->graph.release_library());
+    *func_item->graph.mutable_library() =
+        GetFunctionDefLibraryStub(*func_item_function_library);
+
+    return implementation_selector.Optimize(cluster, *func_item,
+                                            optimized_func_graph);
+  }
+  GrapplerFunctionItem func_item_copy = *func_item;
+  return OptimizeGraph(cluster, std::move(func_item_copy),
+                       optimized_func_graph, optimization_results);
+}
+
 string MetaOptimizer::GetResultString() const {
   std::string result_string;
   for (const GraphOptimizationResult& graph_result : optimization_results_) {
@@ -1185,9 +1449,12 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
          rewrite_cfg.scoped_allocator_optimization() == RewriterConfig::ON ||
 #endif
          rewrite_cfg.pin_to_host_optimization() == RewriterConfig::ON ||
+         rewrite_cfg.device_placement_optimization() == RewriterConfig::ON ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision()) ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_mkl()) ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_cpu()) ||
+         AutoMixedPrecisionEnabled(
+             rewrite_cfg.auto_mixed_precision_cpu_bf16()) ||
          !rewrite_cfg.optimizers().empty() ||
          !rewrite_cfg.custom_optimizers().empty();
 }
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils/functions.h"
 #include "tensorflow/core/grappler/verifiers/graph_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -89,15 +90,17 @@ class MetaOptimizer : public GraphOptimizer {
 
   void PrintUserAndPluginConfigs(const std::set<string>& device_types) const;
 
-  // Run optimization pass over a single GrapplerItem. Meta optimizer might run
-  // multiple such passes: 1) for the main graph 2) for the function library
-  Status OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
-                       GraphDef* optimized_graph);
-
   DeviceBase* const cpu_device_;  // may be NULL
   ConfigProto config_proto_;
   RewriterConfig& cfg_;
   bool xla_auto_clustering_on_;
+  // The number of threads optimizing independent functions of the library. 1
+  // (sequential) by default, and whenever custom or plugin optimizers may run.
+  int num_function_optimization_threads_;
+  // The directory to persist optimized graphs in, or empty to not cache them.
+  string graph_cache_dir_;
+  // Whether the TFG pipeline replaces the classic optimizers it implements.
+  bool use_tfg_pipeline_;
 
   struct OptimizerResult {
     string optimizer_name;
@@ -115,6 +118,24 @@ class MetaOptimizer : public GraphOptimizer {
                       GrapplerItem* optimized_item, GraphDef* optimized_graph,
                       GraphOptimizationResult* optimization_result);
 
+  // Run optimization pass over a single GrapplerItem. Meta optimizer might run
+  // multiple such passes: 1) for the main graph 2) for the function library.
+  // Appends the results of the optimizers to `optimization_results`.
+  Status OptimizeGraph(
+      Cluster* cluster, GrapplerItem&& item, GraphDef* optimized_graph,
+      std::vector<GraphOptimizationResult>* optimization_results);
+
+  // Optimizes the body of `func` into `optimized_func_graph`, and returns the
+  // function item to convert it back into a FunctionDef in `func_item`. Does
+  // not modify `flib`, so that it can run concurrently for the functions of
+  // the library.
+  Status OptimizeFunction(
+      Cluster* cluster, const FunctionDef& func,
+      const FunctionLibraryDefinition& flib, int producer,
+      bool allow_non_differentiable_rewrites, bool is_tpu_graph,
+      GrapplerFunctionItem* func_item, GraphDef* optimized_func_graph,
+      std::vector<GraphOptimizationResult>* optimization_results);
+
   std::vector<GraphOptimizationResult> optimization_results_;
 };
 
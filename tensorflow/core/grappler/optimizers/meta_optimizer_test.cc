@@ -703,6 +703,154 @@ TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryWithRestrictions) {
       optimization_options_my_mul_2->allow_non_differentiable_rewrites);
 }
 
+// Returns an item that calls 8 functions, which don't call each other:
+//
+//   MySquare(x)   = x * x
+//  *MyQuartic_i(x) = MySquare(MySquare(x)) for i in [0, 8)
+//
+//  * - marked as noinline
+GrapplerItem MakeQuarticFunctionsItem() {
+  using test::function::NDef;
+
+  FunctionDef square_func = FunctionDefHelper::Create(
+      "MySquare", {"x:float"}, {"z:float"}, {},
+      {{{"mul"}, "Mul", {"x", "x"}, {{"T", DT_FLOAT}}}},
+      /*ret_def=*/
+      {{"z", "mul:z:0"}});
+
+  std::vector<FunctionDef> funcs = {square_func};
+  std::vector<NodeDef> nodes = {
+      NDef("a", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice)};
+  for (int i = 0; i < 8; ++i) {
+    const string name = absl::StrCat("MyQuartic_", i);
+    FunctionDef quartic_func = FunctionDefHelper::Create(
+        name, {"x:float"}, {"z:float"}, {},
+        {{{"square"}, "MySquare", {"x"}, {}},
+         {{"quartic"}, "MySquare", {"square:z"}, {}}},
+        /*ret_def=*/
+        {{"z", "quartic:z:0"}});
+    (*quartic_func.mutable_attr())["_noinline"].set_b(true);
+    funcs.push_back(quartic_func);
+    nodes.push_back(
+        NDef(absl::StrCat("quartic_", i), name, {"a"}, {}, kDevice));
+  }
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(nodes, funcs);
+  return item;
+}
+
+TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryInParallel) {
+  // Enable only function optimization.
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::TWO);
+  rewriter_config.set_function_optimization(RewriterConfig::ON);
+  rewriter_config.add_optimizers("function");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  const GrapplerItem item = MakeQuarticFunctionsItem();
+
+  // Optimize the library sequentially and in parallel.
+  const auto optimize = [&](const char* num_threads) {
+    setenv("TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS", num_threads, 1);
+    MetaOptimizer optimizer(nullptr, config_proto);
+    unsetenv("TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS");
+    GraphDef output;
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+    return output;
+  };
+  const GraphDef sequential = optimize("1");
+  const GraphDef parallel = optimize("4");
+
+  CompareGraphs(sequential, parallel);
+  FunctionLibraryDefinition sequential_flib(OpRegistry::Global(),
+                                            sequential.library());
+  FunctionLibraryDefinition parallel_flib(OpRegistry::Global(),
+                                          parallel.library());
+  ASSERT_EQ(sequential_flib.num_functions(), parallel_flib.num_functions());
+  for (const string& name : sequential_flib.ListFunctionNames()) {
+    const FunctionDef* parallel_func = parallel_flib.Find(name);
+    ASSERT_NE(parallel_func, nullptr) << name;
+    EXPECT_EQ(sequential_flib.Find(name)->DebugString(),
+              parallel_func->DebugString());
+  }
+
+  // MySquare should be inlined into all the optimized functions.
+  for (const FunctionDef& func : parallel.library().function()) {
+    for (const NodeDef& node : func.node_def()) {
+      EXPECT_NE(node.op(), "MySquare");
+    }
+  }
+}
+
+// Records the largest number of concurrent Optimize() calls.
+class ConcurrencyRecordingOptimizer : public CustomGraphOptimizer {
+ public:
+  static void Reset() { max_concurrent_calls_ = 0; }
+  static int MaxConcurrentCalls() { return max_concurrent_calls_; }
+
+  ConcurrencyRecordingOptimizer() {}
+  string name() const override { return "concurrency_recording_optimizer"; }
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Init(
+      const tensorflow::RewriterConfig_CustomGraphOptimizer* config) override {
+    return Status::OK();
+  }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override {
+    const int concurrent_calls = ++concurrent_calls_;
+    int max_concurrent_calls = max_concurrent_calls_;
+    while (concurrent_calls > max_concurrent_calls &&
+           !max_concurrent_calls_.compare_exchange_weak(max_concurrent_calls,
+                                                        concurrent_calls)) {
+    }
+    // Gives concurrent calls the time to overlap with this one.
+    Env::Default()->SleepForMicroseconds(10000);
+    --concurrent_calls_;
+    *optimized_graph = item.graph;
+    return Status::OK();
+  }
+
+ private:
+  static std::atomic<int> concurrent_calls_;
+  static std::atomic<int> max_concurrent_calls_;
+};
+
+std::atomic<int> ConcurrencyRecordingOptimizer::concurrent_calls_;
+std::atomic<int> ConcurrencyRecordingOptimizer::max_concurrent_calls_;
+
+REGISTER_GRAPH_OPTIMIZER(ConcurrencyRecordingOptimizer);
+
+TEST_F(MetaOptimizerTest, OptimizeFunctionLibrarySequentiallyWithCustomOpt) {
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::ONE);
+  rewriter_config.set_function_optimization(RewriterConfig::ON);
+  rewriter_config.add_optimizers("function");
+  rewriter_config.add_optimizers("ConcurrencyRecordingOptimizer");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  const GrapplerItem item = MakeQuarticFunctionsItem();
+
+  // Custom optimizers are not required to be thread-safe, so they never run
+  // concurrently, even if more threads are requested.
+  ConcurrencyRecordingOptimizer::Reset();
+  setenv("TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS", "4", 1);
+  MetaOptimizer optimizer(nullptr, config_proto);
+  unsetenv("TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS");
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(ConcurrencyRecordingOptimizer::MaxConcurrentCalls(), 1);
+}
+
 class SleepingOptimizer : public CustomGraphOptimizer {
  public:
   SleepingOptimizer() {}
@@ -0,0 +1,133 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include <algorithm>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Appends `piece` to `key_input`, prefixed with its length so that different
+// sequences of pieces never produce the same input.
+void AppendKeyPiece(absl::string_view piece, string* key_input) {
+  absl::StrAppend(key_input, piece.size(), ":", piece, ";");
+}
+
+Status AppendProto(const protobuf::MessageLite& proto, string* key_input) {
+  string serialized;
+  if (!SerializeToStringDeterministic(proto, &serialized)) {
+    return errors::InvalidArgument("Failed to serialize ",
+                                   proto.GetTypeName());
+  }
+  AppendKeyPiece(serialized, key_input);
+  return Status::OK();
+}
+
+void AppendStrings(const std::vector<string>& strings, string* key_input) {
+  AppendKeyPiece(absl::StrCat(strings.size()), key_input);
+  for (const string& s : strings) {
+    AppendKeyPiece(s, key_input);
+  }
+}
+
+}  // namespace
+
+OptimizedGraphCache::OptimizedGraphCache(const string& directory, Env* env)
+    : directory_(directory), env_(env) {}
+
+Status OptimizedGraphCache::ComputeKey(const GrapplerItem& item,
+                                       const GraphOptions& graph_options,
+                                       const std::vector<string>& device_names,
+                                       string* key) {
+  string key_input;
+  AppendKeyPiece(TF_VERSION_STRING, &key_input);
+  AppendKeyPiece(absl::StrCat(TF_GRAPH_DEF_VERSION), &key_input);
+  TF_RETURN_IF_ERROR(AppendProto(item.graph, &key_input));
+  TF_RETURN_IF_ERROR(AppendProto(graph_options, &key_input));
+
+  // The item id ends up in the names of specialized functions.
+  AppendKeyPiece(item.id, &key_input);
+  std::vector<string> feeds;
+  for (const auto& feed : item.feed) {
+    feeds.push_back(absl::StrCat(feed.first, " ",
+                                 DataTypeString(feed.second.dtype()), " ",
+                                 feed.second.shape().DebugString()));
+  }
+  AppendStrings(feeds, &key_input);
+  AppendStrings(item.fetch, &key_input);
+  AppendStrings(item.init_ops, &key_input);
+  AppendStrings(item.keep_ops, &key_input);
+  AppendStrings({item.save_op, item.restore_op, item.save_restore_loc_tensor},
+                &key_input);
+  const GrapplerItem::OptimizationOptions& options =
+      item.optimization_options();
+  AppendKeyPiece(absl::StrCat(options.allow_non_differentiable_rewrites,
+                              options.allow_pruning_stateful_and_dataset_ops,
+                              options.optimize_function_library,
+                              options.is_eager_mode),
+                 &key_input);
+
+  std::vector<string> devices(item.devices().begin(), item.devices().end());
+  devices.insert(devices.end(), device_names.begin(), device_names.end());
+  std::sort(devices.begin(), devices.end());
+  devices.erase(std::unique(devices.begin(), devices.end()), devices.end());
+  AppendStrings(devices, &key_input);
+
+  const Fprint128 fingerprint = Fingerprint128(key_input);
+  *key = absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+  return Status::OK();
+}
+
+Status OptimizedGraphCache::Lookup(const string& key,
+                                   GraphDef* optimized_graph) const {
+  const string path = EntryPath(key);
+  if (!env_->FileExists(path).ok()) {
+    return errors::NotFound("No optimized graph cached for ", key);
+  }
+  return ReadBinaryProto(env_, path, optimized_graph);
+}
+
+Status OptimizedGraphCache::Insert(const string& key,
+                                   const GraphDef& optimized_graph) const {
+  TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(directory_));
+  const string path = EntryPath(key);
+  string temp_path = path;
+  if (!env_->CreateUniqueFileName(&temp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file name for ",
+                            path);
+  }
+  Status status = WriteBinaryProto(env_, temp_path, optimized_graph);
+  if (status.ok()) status = env_->RenameFile(temp_path, path);
+  if (!status.ok()) env_->DeleteFile(temp_path).IgnoreError();
+  return status;
+}
+
+string OptimizedGraphCache::EntryPath(const string& key) const {
+  return io::JoinPath(directory_, absl::StrCat(key, ".pb"));
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,68 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// A directory of graphs optimized by the meta optimizer, which lets processes
+// that load the same model skip running the optimizers again. An entry is
+// keyed by a fingerprint of everything the optimization depends on: the
+// grappler item, the graph options, the available devices and the TensorFlow
+// version.
+//
+// The directory may be shared by concurrent processes: entries are written to
+// a temporary file first and then renamed into place.
+class OptimizedGraphCache {
+ public:
+  explicit OptimizedGraphCache(const string& directory,
+                               Env* env = Env::Default());
+
+  // Computes the key of optimizing `item` with `graph_options` for the
+  // devices named `device_names`.
+  static Status ComputeKey(const GrapplerItem& item,
+                           const GraphOptions& graph_options,
+                           const std::vector<string>& device_names,
+                           string* key);
+
+  // Reads the optimized graph stored for `key`. Returns NotFound if there is
+  // none.
+  Status Lookup(const string& key, GraphDef* optimized_graph) const;
+
+  // Stores `optimized_graph` for `key`, replacing any previous entry.
+  Status Insert(const string& key, const GraphDef& optimized_graph) const;
+
+ private:
+  string EntryPath(const string& key) const;
+
+  const string directory_;
+  Env* const env_;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
@@ -0,0 +1,108 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kDevice[] = "/job:localhost/replica:0/task:0/device:CPU:0";
+
+GrapplerItem CreateItem() {
+  using test::function::NDef;
+  GrapplerItem item;
+  item.id = "main";
+  item.graph = test::function::GDef(
+      {NDef("a", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("b", "Identity", {"a"}, {{"T", DT_FLOAT}}, kDevice)},
+      /*funcs=*/{});
+  item.fetch = {"b"};
+  return item;
+}
+
+string ComputeKey(const GrapplerItem& item, const GraphOptions& graph_options,
+                  const std::vector<string>& device_names) {
+  string key;
+  TF_CHECK_OK(OptimizedGraphCache::ComputeKey(item, graph_options,
+                                              device_names, &key));
+  return key;
+}
+
+TEST(OptimizedGraphCacheTest, KeyIsDeterministic) {
+  const GrapplerItem item = CreateItem();
+  EXPECT_EQ(ComputeKey(item, GraphOptions(), {kDevice}),
+            ComputeKey(CreateItem(), GraphOptions(), {kDevice}));
+}
+
+TEST(OptimizedGraphCacheTest, KeyDependsOnTheOptimizationInputs) {
+  const GrapplerItem item = CreateItem();
+  const string key = ComputeKey(item, GraphOptions(), {kDevice});
+
+  GrapplerItem other_graph = CreateItem();
+  other_graph.graph.mutable_node(1)->set_op("Neg");
+  EXPECT_NE(key, ComputeKey(other_graph, GraphOptions(), {kDevice}));
+
+  GrapplerItem other_fetch = CreateItem();
+  other_fetch.fetch = {"a"};
+  EXPECT_NE(key, ComputeKey(other_fetch, GraphOptions(), {kDevice}));
+
+  GrapplerItem other_options = CreateItem();
+  other_options.optimization_options().allow_non_differentiable_rewrites =
+      false;
+  EXPECT_NE(key, ComputeKey(other_options, GraphOptions(), {kDevice}));
+
+  GraphOptions graph_options;
+  graph_options.mutable_rewrite_options()->set_constant_folding(
+      RewriterConfig::OFF);
+  EXPECT_NE(key, ComputeKey(item, graph_options, {kDevice}));
+
+  EXPECT_NE(key, ComputeKey(item, GraphOptions(), {}));
+}
+
+TEST(OptimizedGraphCacheTest, LookupMissReturnsNotFound) {
+  OptimizedGraphCache cache(
+      io::JoinPath(testing::TmpDir(), "optimized_graph_cache_miss"));
+  GraphDef graph;
+  EXPECT_TRUE(errors::IsNotFound(cache.Lookup("0123", &graph)));
+}
+
+TEST(OptimizedGraphCacheTest, LookupReturnsInsertedGraph) {
+  OptimizedGraphCache cache(
+      io::JoinPath(testing::TmpDir(), "optimized_graph_cache_hit"));
+  const GrapplerItem item = CreateItem();
+  const string key = ComputeKey(item, GraphOptions(), {kDevice});
+  TF_ASSERT_OK(cache.Insert(key, item.graph));
+
+  GraphDef graph;
+  TF_ASSERT_OK(cache.Lookup(key, &graph));
+  EXPECT_EQ(graph.DebugString(), item.graph.DebugString());
+
+  // Inserting again replaces the entry.
+  GraphDef other_graph = item.graph;
+  other_graph.mutable_node(1)->set_op("Neg");
+  TF_ASSERT_OK(cache.Insert(key, other_graph));
+  TF_ASSERT_OK(cache.Lookup(key, &graph));
+  EXPECT_EQ(graph.node(1).op(), "Neg");
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
 #include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/graph_view.h"
@@ -70,6 +71,9 @@ constexpr char kFusedDepthwiseConv2dNative[] = "_FusedDepthwiseConv2dNative";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
 constexpr char kFusedBatchNormGradEx[] = "_FusedBatchNormGradEx";
 constexpr char kTensorToHashBucket[] = "_TensorToHashBucketFast";
+constexpr char kFusedLayerNorm[] = "_FusedLayerNorm";
+constexpr char kFusedScaledMaskedSoftmax[] = "_FusedScaledMaskedSoftmax";
+constexpr char kFusedGelu[] = "_FusedGelu";
 
 constexpr char kDataFormat[] = "data_format";
 constexpr char kIsTraining[] = "is_training";
@@ -140,6 +144,19 @@ struct TensorToHashBucket {
   int string_to_hash_bucket = kMissingIndex;
 };
 
+// SparseSegment reduction of the rows of a GatherV2 of `params`, which can
+// gather the rows from `params` directly: the reduction already reads its rows
+// through `indices`, so only the ids are gathered, saving the copy of the
+// embedding rows.
+struct GatherWithSparseSegmentReduction {
+  GatherWithSparseSegmentReduction() = default;
+  GatherWithSparseSegmentReduction(int gather, int sparse_segment_reduction)
+      : gather(gather), sparse_segment_reduction(sparse_segment_reduction) {}
+
+  int gather = kMissingIndex;
+  int sparse_segment_reduction = kMissingIndex;
+};
+
 // Contraction node followed by a BiasAdd.
 struct ContractionWithBiasAdd {
   ContractionWithBiasAdd() = default;
@@ -935,9 +952,6 @@ bool FindMatMulBiasAddAndGelu(RemapperContext* ctx, int node_index,
                               std::map<string, int>* matched_nodes_map,
                               std::set<int>* remove_node_indices,
                               bool* is_gelu_approximate) {
-  // Gelu fusion is enabled only with oneDNN library.
-  if (!IsMKLEnabled()) return false;
-
   using utils::MatchingDirection;
   using utils::NodeStatus;
   // clang-format off
@@ -1090,6 +1104,530 @@ bool FindMatMulBiasAddAndGelu(RemapperContext* ctx, int node_index,
   return (found_gelu_exact || found_gelu_approximate);
 }
 
+// Swish, also known as SiLU, is generated by the python api as
+// Mul(x, Sigmoid(x)). The Eigen output kernels of _FusedMatMul compute it in
+// the output blocks of the contraction, which oneDNN does not support yet.
+bool FindMatMulBiasAddAndSwish(RemapperContext* ctx, int node_index,
+                               std::map<string, int>* matched_nodes_map,
+                               std::set<int>* remove_node_indices) {
+  if (IsMKLEnabled()) return false;
+
+  using utils::MatchingDirection;
+  using utils::NodeStatus;
+  // clang-format off
+  utils::OpTypePattern swish_pattern =
+    {"Mul", "output", NodeStatus::kReplace,
+      {
+        {"Sigmoid", "sigmoid", NodeStatus::kRemove,
+          {
+            {"BiasAdd", "bias_add", NodeStatus::kRemove}
+          }
+        },
+        {"BiasAdd", "bias_add", NodeStatus::kRemove,
+          {
+            {"MatMul", "matmul", NodeStatus::kRemove},
+            {"*", "bias", NodeStatus::kRemain}
+          }
+        }
+      }
+    };
+  // clang-format on
+  utils::SubGraphMatcher<MatchingDirection::kFollowInputs> graph_matcher(
+      &(ctx->graph_view));
+  matched_nodes_map->clear();
+  remove_node_indices->clear();
+  if (!graph_matcher.GetMatchedNodes(swish_pattern, ctx->nodes_to_preserve,
+                                     ctx->graph_view.GetNode(node_index),
+                                     matched_nodes_map, remove_node_indices)) {
+    return false;
+  }
+
+  // The pattern matcher only checks the op types, so check that the MatMul
+  // can be fused on CPU and that the Mul computes in the same data type.
+  NodeDef* matmul_node =
+      ctx->graph_view.GetNode(matched_nodes_map->at("matmul"))->node();
+  NodeDef* output_node =
+      ctx->graph_view.GetNode(matched_nodes_map->at("output"))->node();
+  if (!IsCpuCompatibleMatMul(*ctx, matmul_node) ||
+      !HaveSameDataType(matmul_node, output_node)) {
+    matched_nodes_map->clear();
+    remove_node_indices->clear();
+    return false;
+  }
+  return true;
+}
+
+// _FusedLayerNorm, _FusedScaledMaskedSoftmax and _FusedGelu have Eigen kernels
+// on CPU and GPU. As for _FusedConv2D, avoid creating them on GPU when XLA
+// clusters the graph, because the TF->XLA bridge does not support them.
+bool IsTransformerFusionCompatible(const RemapperContext& ctx,
+                                   const NodeDef& node) {
+  const DataType dtype = GetDataTypeFromAttr(node, "T");
+  if (NodeIsOnCpu(&node)) {
+    return dtype == DT_FLOAT || dtype == DT_HALF || dtype == DT_BFLOAT16;
+  }
+  if (NodeIsOnGpu(&node)) {
+    return !ctx.xla_auto_clustering_on &&
+           (dtype == DT_FLOAT || dtype == DT_HALF);
+  }
+  return false;
+}
+
+// Returns the regular input of `node_view` produced by the node with index
+// `fanin_index`, or an empty string if there is none.
+string RegularInputFrom(const utils::MutableNodeView& node_view,
+                        int fanin_index) {
+  for (int i = 0; i < node_view.NumRegularFanins(); ++i) {
+    if (node_view.GetRegularFanin(i).node_index() == fanin_index) {
+      return node_view.node()->input(i);
+    }
+  }
+  return "";
+}
+
+// Returns the shape of the regular input of `node_view` produced by the node
+// with index `fanin_index`, or nullptr if it was not inferred.
+const TensorShapeProto* RegularInputShapeFrom(
+    const RemapperContext& ctx, const utils::MutableNodeView& node_view,
+    int fanin_index) {
+  const auto& props =
+      ctx.graph_properties.GetInputProperties(node_view.node()->name());
+  for (int i = 0; i < node_view.NumRegularFanins(); ++i) {
+    if (node_view.GetRegularFanin(i).node_index() == fanin_index &&
+        i < static_cast<int>(props.size())) {
+      return &props[i].shape();
+    }
+  }
+  return nullptr;
+}
+
+// Reads the value of a scalar floating point Const node.
+bool GetScalarConstValue(const NodeDef& node, float* value) {
+  if (!IsConstant(node)) return false;
+  Tensor tensor;
+  if (!tensor.FromProto(node.attr().at("value").tensor()) ||
+      tensor.NumElements() != 1) {
+    return false;
+  }
+  switch (tensor.dtype()) {
+    case DT_FLOAT:
+      *value = tensor.flat<float>()(0);
+      return true;
+    case DT_HALF:
+      *value = static_cast<float>(tensor.flat<Eigen::half>()(0));
+      return true;
+    case DT_BFLOAT16:
+      *value = static_cast<float>(tensor.flat<bfloat16>()(0));
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Checks that `mean` reduces the innermost dimension of a tensor of rank
+// `rank` and keeps it.
+bool IsMeanOverInnermostDim(const NodeDef& mean, const NodeDef& axes,
+                            int rank) {
+  bool keep_dims = false;
+  if (!TryGetNodeAttr(mean, "keep_dims", &keep_dims) || !keep_dims) {
+    return false;
+  }
+  if (!IsConstant(axes)) return false;
+  Tensor axes_tensor;
+  if (!axes_tensor.FromProto(axes.attr().at("value").tensor()) ||
+      axes_tensor.NumElements() != 1) {
+    return false;
+  }
+  int64_t axis;
+  if (axes_tensor.dtype() == DT_INT32) {
+    axis = axes_tensor.flat<int32>()(0);
+  } else if (axes_tensor.dtype() == DT_INT64) {
+    axis = axes_tensor.flat<int64_t>()(0);
+  } else {
+    return false;
+  }
+  return axis == -1 || axis == rank - 1;
+}
+
+// LayerNorm built from primitive ops, as in most Transformer implementations:
+//   mean = Mean(x, -1, keep_dims=True)
+//   variance = Mean(SquaredDifference(x, mean), -1, keep_dims=True)
+//   y = (x - mean) * Rsqrt(variance + epsilon) * scale + offset
+bool FindLayerNorm(RemapperContext* ctx, int node_index,
+                   std::map<string, int>* matched_nodes_map,
+                   std::set<int>* remove_node_indices) {
+  using utils::MatchingDirection;
+  using utils::NodeStatus;
+  // clang-format off
+  utils::OpTypePattern layer_norm_pattern =
+    {"AddV2", "output", NodeStatus::kReplace,
+      {
+        {"Mul", "scaled", NodeStatus::kRemove,
+          {
+            {"Mul", "normalized", NodeStatus::kRemove,
+              {
+                {"Sub", "centered", NodeStatus::kRemove,
+                  {
+                    {"*", "input", NodeStatus::kRemain},
+                    {"Mean", "mean", NodeStatus::kRemove,
+                      {
+                        {"*", "input", NodeStatus::kRemain},
+                        {"Const", "mean_axes", NodeStatus::kRemain}
+                      }
+                    }
+                  }
+                },
+                {"Rsqrt", "inv_stddev", NodeStatus::kRemove,
+                  {
+                    {"AddV2", "variance_plus_epsilon", NodeStatus::kRemove,
+                      {
+                        {"Mean", "variance", NodeStatus::kRemove,
+                          {
+                            {"SquaredDifference", "squared_difference", NodeStatus::kRemove,
+                              {
+                                {"*", "input", NodeStatus::kRemain},
+                                {"Mean", "mean", NodeStatus::kRemove}
+                              }
+                            },
+                            {"Const", "variance_axes", NodeStatus::kRemain}
+                          }
+                        },
+                        {"Const", "epsilon", NodeStatus::kRemain}
+                      }
+                    }
+                  }
+                }
+              }
+            },
+            {"*", "scale", NodeStatus::kRemain}
+          }
+        },
+        {"*", "offset", NodeStatus::kRemain}
+      }
+    };
+  // clang-format on
+  utils::SubGraphMatcher<MatchingDirection::kFollowInputs> graph_matcher(
+      &(ctx->graph_view));
+  matched_nodes_map->clear();
+  remove_node_indices->clear();
+  if (!graph_matcher.GetMatchedNodes(
+          layer_norm_pattern, ctx->nodes_to_preserve,
+          ctx->graph_view.GetNode(node_index), matched_nodes_map,
+          remove_node_indices)) {
+    return false;
+  }
+
+  // The pattern matcher only checks the op types, so check that the subgraph
+  // normalizes the innermost dimension of a single tensor, and that scale and
+  // offset are vectors of its size.
+  const auto fail = [&]() {
+    matched_nodes_map->clear();
+    remove_node_indices->clear();
+    return false;
+  };
+  const auto node_view_at = [&](const string& label) {
+    return ctx->graph_view.GetNode(matched_nodes_map->at(label));
+  };
+  const NodeDef* output_node = node_view_at("output")->node();
+  if (!IsTransformerFusionCompatible(*ctx, *output_node)) return fail();
+
+  // All uses of the input must read the same output port.
+  const int input_index = matched_nodes_map->at("input");
+  const string input = RegularInputFrom(*node_view_at("centered"), input_index);
+  if (RegularInputFrom(*node_view_at("mean"), input_index) != input ||
+      RegularInputFrom(*node_view_at("squared_difference"), input_index) !=
+          input) {
+    return fail();
+  }
+
+  const TensorShapeProto* input_shape =
+      RegularInputShapeFrom(*ctx, *node_view_at("centered"), input_index);
+  if (input_shape == nullptr || input_shape->unknown_rank() ||
+      input_shape->dim_size() < 1) {
+    return fail();
+  }
+  const int rank = input_shape->dim_size();
+  const auto& depth = input_shape->dim(rank - 1);
+  if (!IsKnown(depth)) return fail();
+
+  if (!IsMeanOverInnermostDim(*node_view_at("mean")->node(),
+                              *node_view_at("mean_axes")->node(), rank) ||
+      !IsMeanOverInnermostDim(*node_view_at("variance")->node(),
+                              *node_view_at("variance_axes")->node(), rank)) {
+    return fail();
+  }
+
+  float epsilon;
+  if (!GetScalarConstValue(*node_view_at("epsilon")->node(), &epsilon) ||
+      epsilon <= 0) {
+    return fail();
+  }
+
+  const auto is_depth_vector = [&](const string& node_label,
+                                   const string& fanin_label) {
+    const TensorShapeProto* shape = RegularInputShapeFrom(
+        *ctx, *node_view_at(node_label), matched_nodes_map->at(fanin_label));
+    return shape != nullptr && !shape->unknown_rank() &&
+           shape->dim_size() == 1 && IsKnown(shape->dim(0)) &&
+           shape->dim(0).size() == depth.size();
+  };
+  if (!is_depth_vector("scaled", "scale") ||
+      !is_depth_vector("output", "offset")) {
+    return fail();
+  }
+  return true;
+}
+
+// Attention softmax with a scaling factor and an additive mask:
+//   Softmax(logits * scale + mask)
+// where `scale` is a scalar constant and `mask` broadcasts to the logits, or
+// the same without the scaling factor, or with LogSoftmax.
+bool FindScaledMaskedSoftmax(RemapperContext* ctx, int node_index,
+                             std::map<string, int>* matched_nodes_map,
+                             std::set<int>* remove_node_indices) {
+  using utils::MatchingDirection;
+  using utils::NodeStatus;
+  // clang-format off
+  utils::OpTypePattern scaled_masked_softmax_pattern =
+    {"Softmax|LogSoftmax", "output", NodeStatus::kReplace,
+      {
+        {"AddV2", "masked_logits", NodeStatus::kRemove,
+          {
+            {"Mul", "scaled_logits", NodeStatus::kRemove,
+              {
+                {"Const", "scale", NodeStatus::kRemain},
+                {"*", "logits", NodeStatus::kRemain}
+              }
+            },
+            {"*", "mask", NodeStatus::kRemain}
+          }
+        }
+      }
+    };
+  utils::OpTypePattern masked_softmax_pattern =
+    {"Softmax|LogSoftmax", "output", NodeStatus::kReplace,
+      {
+        {"AddV2", "masked_logits", NodeStatus::kRemove,
+          {
+            {"*", "logits", NodeStatus::kRemain},
+            {"*", "mask", NodeStatus::kRemain}
+          }
+        }
+      }
+    };
+  // clang-format on
+  matched_nodes_map->clear();
+  remove_node_indices->clear();
+  utils::SubGraphMatcher<MatchingDirection::kFollowInputs> graph_matcher(
+      &(ctx->graph_view));
+  if (!graph_matcher.GetMatchedNodes(
+          scaled_masked_softmax_pattern, ctx->nodes_to_preserve,
+          ctx->graph_view.GetNode(node_index), matched_nodes_map,
+          remove_node_indices)) {
+    matched_nodes_map->clear();
+    remove_node_indices->clear();
+    utils::SubGraphMatcher<MatchingDirection::kFollowInputs> masked_matcher(
+        &(ctx->graph_view));
+    if (!masked_matcher.GetMatchedNodes(
+            masked_softmax_pattern, ctx->nodes_to_preserve,
+            ctx->graph_view.GetNode(node_index), matched_nodes_map,
+            remove_node_indices)) {
+      return false;
+    }
+  }
+
+  const auto fail = [&]() {
+    matched_nodes_map->clear();
+    remove_node_indices->clear();
+    return false;
+  };
+  const auto* output_node_view =
+      ctx->graph_view.GetNode(matched_nodes_map->at("output"));
+  if (!IsTransformerFusionCompatible(*ctx, *output_node_view->node())) {
+    return fail();
+  }
+
+  const bool is_scaled = matched_nodes_map->count("scale") > 0;
+  float scale;
+  if (is_scaled &&
+      !GetScalarConstValue(
+          *ctx->graph_view.GetNode(matched_nodes_map->at("scale"))->node(),
+          &scale)) {
+    return fail();
+  }
+
+  // The mask must broadcast to the logits and not the other way around. The
+  // kernel supports up to 5 dimensions. Without the scaling factor, either
+  // input of the AddV2 can be the logits.
+  const auto& softmax_props = ctx->graph_properties.GetInputProperties(
+      output_node_view->node()->name());
+  const auto* logits_consumer_view = ctx->graph_view.GetNode(
+      matched_nodes_map->at(is_scaled ? "scaled_logits" : "masked_logits"));
+  const TensorShapeProto* logits_shape = RegularInputShapeFrom(
+      *ctx, *logits_consumer_view, matched_nodes_map->at("logits"));
+  if (!is_scaled && !softmax_props.empty() && logits_shape != nullptr &&
+      !ShapesSymbolicallyEqual(*logits_shape, softmax_props[0].shape())) {
+    std::swap(matched_nodes_map->at("logits"), matched_nodes_map->at("mask"));
+    logits_shape = RegularInputShapeFrom(*ctx, *logits_consumer_view,
+                                         matched_nodes_map->at("logits"));
+  }
+  if (softmax_props.empty() || logits_shape == nullptr ||
+      logits_shape->unknown_rank() || logits_shape->dim_size() < 1 ||
+      logits_shape->dim_size() > 5 ||
+      !ShapesSymbolicallyEqual(*logits_shape, softmax_props[0].shape())) {
+    return fail();
+  }
+  return true;
+}
+
+// Gelu that does not follow a MatMul + BiasAdd, matched on the same subgraphs
+// as FindMatMulBiasAddAndGelu.
+bool FindGelu(RemapperContext* ctx, int node_index,
+              std::map<string, int>* matched_nodes_map,
+              std::set<int>* remove_node_indices, bool* is_gelu_approximate) {
+  using utils::MatchingDirection;
+  using utils::NodeStatus;
+  // clang-format off
+  utils::OpTypePattern gelu_exact_pattern =
+    {"Mul", "output", NodeStatus::kReplace,
+      {
+        {"Mul", "erf_plus_one_times_one_half", NodeStatus::kRemove,
+          {
+            {"AddV2", "erf_plus_one", NodeStatus::kRemove,
+              {
+                {"Erf", "erf", NodeStatus::kRemove,
+                  {
+                    {"Mul", "input_times_square_root_one_half", NodeStatus::kRemove,
+                      {
+                        {"Const", "square_root_one_half", NodeStatus::kRemain},
+                        {"*", "input", NodeStatus::kRemain}
+                      }
+                    }
+                  }
+                },
+                {"Const", "one", NodeStatus::kRemain}
+              }
+            },
+            {"Const", "one_half", NodeStatus::kRemain}
+          }
+        },
+        {"*", "input", NodeStatus::kRemain}
+      }
+    };
+
+  utils::OpTypePattern gelu_approximate_pattern =
+    {"Mul", "output", NodeStatus::kReplace,
+      {
+        {"Mul", "tanh_plus_one_times_one_half", NodeStatus::kRemove,
+          {
+            {"AddV2", "tanh_plus_one", NodeStatus::kRemove,
+              {
+                {"Tanh", "tanh", NodeStatus::kRemove,
+                  {
+                    {"Mul", "input_plus_mul_times_square_root_two_over_pi", NodeStatus::kRemove,
+                      {
+                        {"AddV2", "input_plus_mul", NodeStatus::kRemove,
+                          {
+                            {"*", "input", NodeStatus::kRemain},
+                            {"Mul", "mul", NodeStatus::kRemove,
+                              {
+                                {"Mul", "empirical_const_times_input", NodeStatus::kRemove,
+                                  {
+                                    {"Const", "empirical_const", NodeStatus::kRemain},
+                                    {"*", "input", NodeStatus::kRemain}
+                                  }
+                                },
+                                {"Square", "square", NodeStatus::kRemove,
+                                  {
+                                    {"*", "input", NodeStatus::kRemain}
+                                  }
+                                }
+                              }
+                            }
+                          }
+                        },
+                        {"Const", "square_root_two_over_pi", NodeStatus::kRemain}
+                      }
+                    }
+                  }
+                },
+                {"Const", "one", NodeStatus::kRemain}
+              }
+            },
+            {"Const", "one_half", NodeStatus::kRemain}
+          }
+        },
+        {"*", "input", NodeStatus::kRemain}
+      }
+    };
+  // clang-format on
+  utils::SubGraphMatcher<MatchingDirection::kFollowInputs> graph_matcher(
+      &(ctx->graph_view));
+  std::vector<string> input_consumers;
+  std::map<string, float> values_map;
+  matched_nodes_map->clear();
+  remove_node_indices->clear();
+  if (graph_matcher.GetMatchedNodes(gelu_exact_pattern, ctx->nodes_to_preserve,
+                                    ctx->graph_view.GetNode(node_index),
+                                    matched_nodes_map, remove_node_indices)) {
+    *is_gelu_approximate = false;
+    input_consumers = {"output", "input_times_square_root_one_half"};
+    values_map = {
+        {"square_root_one_half", 0.707106}, {"one", 1.0}, {"one_half", 0.5}};
+  } else {
+    matched_nodes_map->clear();
+    remove_node_indices->clear();
+    if (!graph_matcher.GetMatchedNodes(
+            gelu_approximate_pattern, ctx->nodes_to_preserve,
+            ctx->graph_view.GetNode(node_index), matched_nodes_map,
+            remove_node_indices)) {
+      return false;
+    }
+    *is_gelu_approximate = true;
+    input_consumers = {"output", "input_plus_mul",
+                       "empirical_const_times_input", "square"};
+    values_map = {{"square_root_two_over_pi", 0.797884},
+                  {"one", 1.0},
+                  {"one_half", 0.5},
+                  {"empirical_const", 0.044715}};
+  }
+
+  const auto fail = [&]() {
+    matched_nodes_map->clear();
+    remove_node_indices->clear();
+    return false;
+  };
+  const NodeDef* output_node =
+      ctx->graph_view.GetNode(matched_nodes_map->at("output"))->node();
+  if (!IsTransformerFusionCompatible(*ctx, *output_node)) return fail();
+
+  // On CPU a Gelu that follows MatMul + BiasAdd is fused into the _FusedMatMul
+  // by FindMatMulBiasAddAndGelu, in the first or second remapper pass.
+  const int input_index = matched_nodes_map->at("input");
+  const auto* input_node_view = ctx->graph_view.GetNode(input_index);
+  const auto is_matmul_with_bias = [&]() {
+    if (input_node_view->GetOp() == kFusedMatMul) return true;
+    return IsBiasAdd(*input_node_view->node()) &&
+           input_node_view->NumRegularFanins() > 0 &&
+           IsMatMul(*input_node_view->GetRegularFanin(0).node_view()->node());
+  };
+  if (NodeIsOnCpu(output_node) && is_matmul_with_bias()) return fail();
+
+  // All uses of the input must read the same output port.
+  const string input = RegularInputFrom(
+      *ctx->graph_view.GetNode(matched_nodes_map->at("output")), input_index);
+  for (const string& consumer : input_consumers) {
+    if (RegularInputFrom(
+            *ctx->graph_view.GetNode(matched_nodes_map->at(consumer)),
+            input_index) != input) {
+      return fail();
+    }
+  }
+
+  if (!VerifyConstants(ctx, matched_nodes_map, &values_map)) return fail();
+  return true;
+}
+
 bool FindFusedBatchNorm(const RemapperContext& ctx, int node_index,
                         FusedBatchNorm* matched) {
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -1164,8 +1702,16 @@ bool FindFusedBatchNormEx(const RemapperContext& ctx, int node_index,
     const auto* fused_batch_norm_node_def = fused_batch_norm.node();
     if (!IsFusedBatchNorm(*fused_batch_norm_node_def)) return false;
 
-    // We fuse FusedBatchNorm on GPU or oneDNN CPU.
-    if (!IsMKLEnabled() && !NodeIsOnGpu(fused_batch_norm_node_def))
+    // Get the FusedBatchNorm training mode.
+    bool is_training;
+    if (!GetNodeAttr(*fused_batch_norm_node_def, kIsTraining, &is_training)
+             .ok())
+      return false;
+
+    // We fuse FusedBatchNorm on GPU or oneDNN CPU, and on any CPU in inference
+    // mode.
+    if (!IsMKLEnabled() && !NodeIsOnGpu(fused_batch_norm_node_def) &&
+        is_training)
       return false;
 
     DataType t_dtype = GetDataTypeFromAttr(*fused_batch_norm_node_def, "T");
@@ -1180,13 +1726,8 @@ bool FindFusedBatchNormEx(const RemapperContext& ctx, int node_index,
       // Half is not available with oneDNN.
       if (IsMKLEnabled() && t_dtype != DT_FLOAT && t_dtype != DT_BFLOAT16)
         return false;
+      if (!IsMKLEnabled() && t_dtype != DT_FLOAT) return false;
     }
-
-    // Get the FusedBatchNorm training mode.
-    bool is_training;
-    if (!GetNodeAttr(*fused_batch_norm_node_def, kIsTraining, &is_training)
-             .ok())
-      return false;
     string data_format;
     if (!GetNodeAttr(*fused_batch_norm_node_def, kDataFormat, &data_format)
              .ok())
@@ -1475,6 +2016,68 @@ bool FindTensorToHashBucket(const RemapperContext& ctx, int node_index,
   return true;
 }
 
+// Returns true if `node_view` is a GatherV2 along axis 0 of rank 1 ids. Then
+// gathering `indices` from its output is gathering `ids[indices]` from its
+// params.
+bool IsGatherOfRank1Ids(const RemapperContext& ctx,
+                        const utils::MutableNodeView& node_view) {
+  const auto* node_def = node_view.node();
+  if (node_def->op() != "GatherV2" || node_view.NumRegularFanins() != 3) {
+    return false;
+  }
+  int batch_dims = 0;
+  if (TryGetNodeAttr(*node_def, "batch_dims", &batch_dims) &&
+      batch_dims != 0) {
+    return false;
+  }
+
+  const auto& props = ctx.graph_properties.GetInputProperties(node_def->name());
+  if (props.size() != 3) return false;
+  const auto& ids_shape = props[1].shape();
+  if (ids_shape.unknown_rank() || ids_shape.dim_size() != 1) return false;
+
+  const auto& axis = props[2];
+  Tensor axis_value;
+  if (!axis.has_value() || !axis_value.FromProto(axis.value()) ||
+      axis_value.NumElements() != 1) {
+    return false;
+  }
+  return (axis_value.dtype() == DT_INT32 &&
+          axis_value.flat<int32>()(0) == 0) ||
+         (axis_value.dtype() == DT_INT64 &&
+          axis_value.flat<int64_t>()(0) == 0);
+}
+
+bool FindGatherWithSparseSegmentReduction(
+    const RemapperContext& ctx, int node_index,
+    GatherWithSparseSegmentReduction* matched) {
+  // Root of the pattern must be a SparseSegment{Sum,Mean,SqrtN} on CPU.
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (!IsAnySparseSegmentReduction(*node_def) || !NodeIsOnCpu(node_def) ||
+      HasControlFaninOrFanout(*node_view) ||
+      node_view->NumRegularFanins() < 3) {
+    return false;
+  }
+
+  // Its data must be a GatherV2 whose only consumer is the reduction.
+  const auto& regular_fanin_0 = node_view->GetRegularFanin(0);
+  const auto* gather_node_view = regular_fanin_0.node_view();
+  const auto* gather_node_def = gather_node_view->node();
+  if (regular_fanin_0.index() != 0 ||
+      !IsGatherOfRank1Ids(ctx, *gather_node_view) ||
+      HasControlFaninOrFanout(*gather_node_view) ||
+      !HasAtMostOneFanoutAtPort0(*gather_node_view) ||
+      IsInPreserveSet(ctx, gather_node_def) ||
+      gather_node_def->device() != node_def->device()) {
+    return false;
+  }
+
+  *matched = GatherWithSparseSegmentReduction(gather_node_view->node_index(),
+                                              node_index);
+  return true;
+}
+
 void CopyConv2DAttributes(const NodeDef& conv2d, NodeDef* fused_conv2d,
                           const NodeDef* activation = nullptr) {
   DCHECK(IsConv2D(conv2d)) << "Input node must be a Conv2D";
@@ -1985,6 +2588,166 @@ Status AddFusedMatMulBiasAddAndGelu(RemapperContext* ctx,
   return Status::OK();
 }
 
+Status AddFusedMatMulBiasAddAndSwish(RemapperContext* ctx,
+                                     std::map<string, int>* matched_nodes_map,
+                                     std::set<int>* remove_node_indices,
+                                     std::vector<bool>* invalidated_nodes,
+                                     std::vector<bool>* nodes_to_delete) {
+  auto* output_node =
+      ctx->graph_view.GetNode(matched_nodes_map->at("output"))->node();
+  auto* matmul_node =
+      ctx->graph_view.GetNode(matched_nodes_map->at("matmul"))->node();
+  auto* bias_add_node =
+      ctx->graph_view.GetNode(matched_nodes_map->at("bias_add"))->node();
+
+  NodeDef fused_node;
+  // Fused node should have the name of terminal node of the fusion.
+  fused_node.set_name(output_node->name());
+  fused_node.set_op("_FusedMatMul");
+  fused_node.set_device(matmul_node->device());
+  fused_node.add_input(matmul_node->input(0));
+  fused_node.add_input(matmul_node->input(1));
+  fused_node.add_input(bias_add_node->input(1));
+  CopyMatMulAttributes(*matmul_node, &fused_node);
+  SetFusedOpAttributes(&fused_node, {"BiasAdd", "Swish"});
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_node), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+  (*invalidated_nodes)[matched_nodes_map->at("output")] = true;
+
+  for (const auto& node_idx : *remove_node_indices) {
+    (*nodes_to_delete)[node_idx] = true;
+  }
+  return Status::OK();
+}
+
+Status AddFusedLayerNorm(RemapperContext* ctx,
+                         std::map<string, int>* matched_nodes_map,
+                         std::set<int>* remove_node_indices,
+                         std::vector<bool>* invalidated_nodes,
+                         std::vector<bool>* nodes_to_delete) {
+  const auto node_view_at = [&](const string& label) {
+    return ctx->graph_view.GetNode(matched_nodes_map->at(label));
+  };
+  const NodeDef* output_node = node_view_at("output")->node();
+  float epsilon;
+  GetScalarConstValue(*node_view_at("epsilon")->node(), &epsilon);
+
+  VLOG(2) << "Fuse LayerNorm: output=" << output_node->name();
+
+  NodeDef fused_node;
+  // Fused node should have the name of terminal node of the fusion.
+  fused_node.set_name(output_node->name());
+  fused_node.set_op(kFusedLayerNorm);
+  fused_node.set_device(output_node->device());
+  fused_node.add_input(RegularInputFrom(*node_view_at("centered"),
+                                        matched_nodes_map->at("input")));
+  fused_node.add_input(RegularInputFrom(*node_view_at("scaled"),
+                                        matched_nodes_map->at("scale")));
+  fused_node.add_input(RegularInputFrom(*node_view_at("output"),
+                                        matched_nodes_map->at("offset")));
+  auto* attrs = fused_node.mutable_attr();
+  (*attrs)["T"] = output_node->attr().at("T");
+  SetAttrValue(epsilon, &(*attrs)["epsilon"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_node), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+  (*invalidated_nodes)[matched_nodes_map->at("output")] = true;
+
+  for (const auto& node_idx : *remove_node_indices) {
+    (*nodes_to_delete)[node_idx] = true;
+  }
+  return Status::OK();
+}
+
+Status AddFusedScaledMaskedSoftmax(RemapperContext* ctx,
+                                   std::map<string, int>* matched_nodes_map,
+                                   std::set<int>* remove_node_indices,
+                                   std::vector<bool>* invalidated_nodes,
+                                   std::vector<bool>* nodes_to_delete) {
+  const auto node_view_at = [&](const string& label) {
+    return ctx->graph_view.GetNode(matched_nodes_map->at(label));
+  };
+  const NodeDef* output_node = node_view_at("output")->node();
+  const bool is_scaled = matched_nodes_map->count("scale") > 0;
+  float scale = 1.0f;
+  if (is_scaled) GetScalarConstValue(*node_view_at("scale")->node(), &scale);
+
+  VLOG(2) << "Fuse scaled masked " << output_node->op()
+          << ": output=" << output_node->name();
+
+  NodeDef fused_node;
+  // Fused node should have the name of terminal node of the fusion.
+  fused_node.set_name(output_node->name());
+  fused_node.set_op(kFusedScaledMaskedSoftmax);
+  fused_node.set_device(output_node->device());
+  fused_node.add_input(
+      RegularInputFrom(*node_view_at(is_scaled ? "scaled_logits"
+                                               : "masked_logits"),
+                       matched_nodes_map->at("logits")));
+  fused_node.add_input(RegularInputFrom(*node_view_at("masked_logits"),
+                                        matched_nodes_map->at("mask")));
+  auto* attrs = fused_node.mutable_attr();
+  (*attrs)["T"] = output_node->attr().at("T");
+  SetAttrValue(scale, &(*attrs)["scale"]);
+  SetAttrValue(output_node->op() == "LogSoftmax", &(*attrs)["log"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_node), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+  (*invalidated_nodes)[matched_nodes_map->at("output")] = true;
+
+  for (const auto& node_idx : *remove_node_indices) {
+    (*nodes_to_delete)[node_idx] = true;
+  }
+  return Status::OK();
+}
+
+Status AddFusedGelu(RemapperContext* ctx,
+                    std::map<string, int>* matched_nodes_map,
+                    std::set<int>* remove_node_indices,
+                    std::vector<bool>* invalidated_nodes,
+                    std::vector<bool>* nodes_to_delete,
+                    bool is_gelu_approximate) {
+  const auto* output_node_view =
+      ctx->graph_view.GetNode(matched_nodes_map->at("output"));
+  const NodeDef* output_node = output_node_view->node();
+
+  VLOG(2) << "Fuse Gelu: output=" << output_node->name()
+          << " approximate=" << is_gelu_approximate;
+
+  NodeDef fused_node;
+  // Fused node should have the name of terminal node of the fusion.
+  fused_node.set_name(output_node->name());
+  fused_node.set_op(kFusedGelu);
+  fused_node.set_device(output_node->device());
+  fused_node.add_input(
+      RegularInputFrom(*output_node_view, matched_nodes_map->at("input")));
+  auto* attrs = fused_node.mutable_attr();
+  (*attrs)["T"] = output_node->attr().at("T");
+  SetAttrValue(is_gelu_approximate, &(*attrs)["approximate"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_node), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+  (*invalidated_nodes)[matched_nodes_map->at("output")] = true;
+
+  for (const auto& node_idx : *remove_node_indices) {
+    (*nodes_to_delete)[node_idx] = true;
+  }
+  return Status::OK();
+}
+
 Status AddFusedBatchNormExNode(RemapperContext* ctx,
                                const FusedBatchNormEx& matched,
                                std::vector<bool>* invalidated_nodes,
@@ -2360,6 +3123,53 @@ Status AddTensorToHashBucketNode(RemapperContext* ctx,
   return Status::OK();
 }
 
+// Rewrites SparseSegmentReduction(GatherV2(params, ids), indices, ...) into
+// SparseSegmentReduction(params, GatherV2(ids, indices), ...). The ids gather
+// keeps the name of the original gather.
+Status AddGatherWithSparseSegmentReductionNodes(
+    RemapperContext* ctx, const GatherWithSparseSegmentReduction& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& gather = graph->node(matched.gather);
+  const NodeDef& reduction = graph->node(matched.sparse_segment_reduction);
+  VLOG(2) << "Fuse GatherV2 with " << reduction.op() << ":"
+          << " gather=" << gather.name() << " reduction=" << reduction.name()
+          << " on device=" << reduction.device();
+
+  NodeDef ids_gather;
+  ids_gather.set_name(gather.name());
+  ids_gather.set_op(gather.op());
+  ids_gather.set_device(gather.device());
+  ids_gather.add_input(gather.input(1));     // 0: params (ids)
+  ids_gather.add_input(reduction.input(1));  // 1: indices
+  ids_gather.add_input(gather.input(2));     // 2: axis
+  auto* ids_gather_attr = ids_gather.mutable_attr();
+  (*ids_gather_attr)["Tparams"] = gather.attr().at("Tindices");
+  (*ids_gather_attr)["Tindices"] = reduction.attr().at("Tidx");
+  (*ids_gather_attr)["Taxis"] = gather.attr().at("Taxis");
+  if (gather.attr().count("batch_dims")) {
+    (*ids_gather_attr)["batch_dims"] = gather.attr().at("batch_dims");
+  }
+
+  NodeDef fused_reduction = reduction;
+  fused_reduction.set_input(0, gather.input(0));  // 0: data (params)
+  fused_reduction.set_input(1, gather.name());    // 1: indices (ids)
+  (*fused_reduction.mutable_attr())["Tidx"] = gather.attr().at("Tindices");
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(ids_gather), &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(std::move(fused_reduction), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.sparse_segment_reduction] = true;
+  (*invalidated_nodes)[matched.gather] = true;
+
+  return Status::OK();
+}
+
 bool IsContractionWithAdd(const RemapperContext& ctx, int node_index) {
   const auto* node_view = ctx.graph_view.GetNode(node_index);
 
@@ -2406,6 +3216,7 @@ bool IsContractionWithAdd(const RemapperContext& ctx, int node_index) {
 //   (3) Fusing Conv2D biasadd and relu on GPU
 //   (4) INTEL_MKL specific: Conv2D -> Add or Conv2D -> BiasAdd -> Add.
 //   (5) Fusing side output and/or activation into FusedBatchNormGrad.
+//   (6) Gathering the ids of a SparseSegment reduction of a GatherV2.
 bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
   // Candidate for a FusedBatchNorm splitting.
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -2495,13 +3306,48 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
     return false;
   };
 
+  // Candidate for a GatherV2 + SparseSegment reduction rewrite.
+  const auto is_gather_sparse_segment_candidate = [&]() -> bool {
+    if (!IsAnySparseSegmentReduction(*node_def)) return false;
+    if (node_view->NumRegularFanins() < 1) return false;
+    const auto& reduction_fanin_0 = node_view->GetRegularFanin(0);
+    return reduction_fanin_0.node_view()->node()->op() == "GatherV2";
+  };
+
+  // Candidate for a LayerNorm or a scaled masked Softmax fusion.
+  const auto is_transformer_fusion_candidate = [&]() -> bool {
+    if (node_view->NumRegularFanins() < 1) return false;
+    const auto has_fanin_op = [](const utils::MutableNodeView& view,
+                                 const string& op) {
+      for (const auto& fanin : view.GetRegularFanins()) {
+        if (fanin.node_view()->GetOp() == op) return true;
+      }
+      return false;
+    };
+    if (IsSoftmax(*node_def) || node_def->op() == "LogSoftmax") {
+      return has_fanin_op(*node_view, "AddV2");
+    }
+    if (node_def->op() != "AddV2") return false;
+    for (const auto& fanin : node_view->GetRegularFanins()) {
+      if (IsMul(*fanin.node_view()->node()) &&
+          has_fanin_op(*fanin.node_view(), "Mul")) {
+        return true;
+      }
+    }
+    return false;
+  };
+
   if (IsMKLEnabled())
     return is_batch_norm_candidate() || is_batch_norm_fusion_candidate() ||
-           IsContractionWithAdd(ctx, node_index);
+           IsContractionWithAdd(ctx, node_index) ||
+           is_gather_sparse_segment_candidate() ||
+           is_transformer_fusion_candidate();
 
   return is_relu_biasadd_conv_candidate() || is_batch_norm_candidate() ||
          is_batch_norm_fusion_candidate() ||
-         is_batch_norm_grad_fusion_candidate();
+         is_batch_norm_grad_fusion_candidate() ||
+         is_gather_sparse_segment_candidate() ||
+         is_transformer_fusion_candidate();
 }
 }  // namespace
 
@@ -2593,6 +3439,61 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       ctx.inferred_graph_properties = true;
     }
 
+    // Remap MatMul + BiasAdd + {gelu,swish}-subgraph into the _FusedMatMul
+    // computed by the Eigen output kernels. With oneDNN the Gelu subgraph is
+    // remapped above.
+    if (!IsMKLEnabled() && allow_non_differentiable_rewrites) {
+      std::map<string, int> matched_nodes_map;
+      std::set<int> remove_node_indices;
+      bool is_gelu_approximate = false;
+      if (FindMatMulBiasAddAndGelu(&ctx, i, &matched_nodes_map,
+                                   &remove_node_indices,
+                                   &is_gelu_approximate)) {
+        TF_RETURN_IF_ERROR(AddFusedMatMulBiasAddAndGelu(
+            &ctx, &matched_nodes_map, &remove_node_indices, &invalidated_nodes,
+            &nodes_to_delete, is_gelu_approximate));
+        continue;
+      }
+      if (FindMatMulBiasAddAndSwish(&ctx, i, &matched_nodes_map,
+                                    &remove_node_indices)) {
+        TF_RETURN_IF_ERROR(AddFusedMatMulBiasAddAndSwish(
+            &ctx, &matched_nodes_map, &remove_node_indices, &invalidated_nodes,
+            &nodes_to_delete));
+        continue;
+      }
+    }
+
+    // Remap LayerNorm, scaled masked Softmax and Gelu subgraphs of Transformer
+    // blocks into the _FusedLayerNorm, _FusedScaledMaskedSoftmax and
+    // _FusedGelu.
+    if (allow_non_differentiable_rewrites) {
+      std::map<string, int> matched_nodes_map;
+      std::set<int> remove_node_indices;
+      if (FindLayerNorm(&ctx, i, &matched_nodes_map, &remove_node_indices)) {
+        TF_RETURN_IF_ERROR(AddFusedLayerNorm(&ctx, &matched_nodes_map,
+                                             &remove_node_indices,
+                                             &invalidated_nodes,
+                                             &nodes_to_delete));
+        continue;
+      }
+      if (FindScaledMaskedSoftmax(&ctx, i, &matched_nodes_map,
+                                  &remove_node_indices)) {
+        TF_RETURN_IF_ERROR(AddFusedScaledMaskedSoftmax(
+            &ctx, &matched_nodes_map, &remove_node_indices, &invalidated_nodes,
+            &nodes_to_delete));
+        continue;
+      }
+      bool is_gelu_approximate = false;
+      if (FindGelu(&ctx, i, &matched_nodes_map, &remove_node_indices,
+                   &is_gelu_approximate)) {
+        TF_RETURN_IF_ERROR(AddFusedGelu(&ctx, &matched_nodes_map,
+                                        &remove_node_indices,
+                                        &invalidated_nodes, &nodes_to_delete,
+                                        is_gelu_approximate));
+        continue;
+      }
+    }
+
     // Remap {Conv2D,DepthwiseConv2D,MatMul}+BiasAdd into the
     // _Fused{Conv2D,DepthwiseConv2dNative,MatMul}
     ContractionWithBiasAdd contract_with_bias;
@@ -2678,6 +3579,19 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+    // Reducing the rows of an embedding lookup does not need to copy them:
+    // the reduction gathers the rows of the embedding table itself. The
+    // gradient of the table becomes a dense tensor instead of IndexedSlices.
+    GatherWithSparseSegmentReduction gather_with_sparse_segment_reduction;
+    if (allow_non_differentiable_rewrites &&
+        FindGatherWithSparseSegmentReduction(
+            ctx, i, &gather_with_sparse_segment_reduction)) {
+      TF_RETURN_IF_ERROR(AddGatherWithSparseSegmentReductionNodes(
+          &ctx, gather_with_sparse_segment_reduction, &invalidated_nodes,
+          &nodes_to_delete));
+      continue;
+    }
+
     // During inference, most of the inputs to FusedBatchNorm are constant, and
     // we can therefore replace the op with a much cheaper set of primitives.
     FusedBatchNorm fused_batch_norm;
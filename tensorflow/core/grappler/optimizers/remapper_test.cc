@@ -454,6 +454,93 @@ TEST_F(RemapperTest, FuseBatchNormWithAddAndRelu) {
   }
 }
 
+TEST_F(RemapperTest, FuseBatchNormWithAddAndReluOnCpu) {
+  if (IsMKLEnabled()) GTEST_SKIP() << "oneDNN has its own fusion.";
+  using ::tensorflow::ops::Placeholder;
+
+  for (bool with_side_input : {false, true}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    const int num_channels = 24;
+
+    TensorShape input_shape({2, 8, 8, num_channels});
+    TensorShape channel_shape({num_channels});
+
+    auto input = Placeholder(s.WithOpName("input"), DT_FLOAT,
+                             ops::Placeholder::Shape(input_shape));
+    auto scale = Placeholder(s.WithOpName("scale"), DT_FLOAT);
+    auto offset = Placeholder(s.WithOpName("offset"), DT_FLOAT);
+    auto mean = Placeholder(s.WithOpName("mean"), DT_FLOAT);
+    auto var = Placeholder(s.WithOpName("var"), DT_FLOAT);
+    auto side_input = Placeholder(s.WithOpName("side_input"), DT_FLOAT,
+                                  ops::Placeholder::Shape(input_shape));
+
+    auto fbn = ops::FusedBatchNormV3(
+        s.WithOpName("fused_batch_norm"), input, scale, offset, mean, var,
+        ops::FusedBatchNormV3::IsTraining(false).Epsilon(0.1f).DataFormat(
+            "NHWC"));
+    Output relu_input = fbn.y;
+    if (with_side_input) {
+      relu_input = ops::Add(s.WithOpName("add"), fbn.y, side_input);
+    }
+    auto relu = ops::Relu(s.WithOpName("relu"), relu_input);
+    auto fetch = ops::Identity(s.WithOpName("fetch"), relu);
+
+    auto input_t = GenerateRandomTensor<DT_FLOAT>(input_shape);
+    auto scale_t = GenerateRandomTensor<DT_FLOAT>(channel_shape);
+    auto offset_t = GenerateRandomTensor<DT_FLOAT>(channel_shape);
+    auto mean_t = GenerateRandomTensor<DT_FLOAT>(channel_shape);
+    auto var_t = GenerateRandomTensor<DT_FLOAT>(channel_shape);
+    // The variance must be positive.
+    var_t.flat<float>() = var_t.flat<float>().abs();
+    auto side_input_t = GenerateRandomTensor<DT_FLOAT>(input_shape);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"input", input_t},   {"scale", scale_t},
+                 {"offset", offset_t}, {"mean", mean_t},
+                 {"var", var_t},       {"side_input", side_input_t}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::AGGRESSIVE);  // trust placeholders shape
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == "relu") {
+        EXPECT_EQ(node.op(), "Identity");
+        ASSERT_EQ(node.input_size(), 1);
+        EXPECT_EQ(node.input(0), "fused_batch_norm");
+        found++;
+      }
+      if (node.name() == "fused_batch_norm") {
+        EXPECT_EQ(node.op(), "_FusedBatchNormEx");
+        ASSERT_EQ(node.input_size(), with_side_input ? 6 : 5);
+        EXPECT_EQ(node.input(0), "input");
+        if (with_side_input) EXPECT_EQ(node.input(5), "side_input");
+
+        auto attr = node.attr();
+        EXPECT_EQ(attr["num_side_inputs"].i(), with_side_input ? 1 : 0);
+        EXPECT_EQ(attr["activation_mode"].s(), "Relu");
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 2);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-5);
+  }
+}
+
 #if defined(GOOGLE_CUDA) && CUDNN_VERSION >= 7402
 TEST_F(RemapperTest, FuseBatchNormGradWithAddAndReluGrad) {
   if (IsMKLEnabled()) GTEST_SKIP() << "Fusion not available with oneDNN.";
@@ -1078,6 +1165,108 @@ TEST_F(RemapperTensorToHashBucketTest, I32) { RunTest<DT_INT32>(); }
 
 TEST_F(RemapperTensorToHashBucketTest, I64) { RunTest<DT_INT64>(); }
 
+class RemapperGatherWithSparseSegmentReductionTest : public RemapperTest {
+ public:
+  // Reduces embedding rows gathered from "params", which are also fetched
+  // when `fetch_gather` is true.
+  void RunTest(bool with_num_segments, bool fetch_gather) {
+    using ::tensorflow::ops::Placeholder;
+
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto params = Placeholder(s.WithOpName("params"), DT_FLOAT,
+                              ops::Placeholder::Shape({100, 16}));
+    auto ids = Placeholder(s.WithOpName("ids"), DT_INT64,
+                           ops::Placeholder::Shape({6}));
+    auto axis = ops::Const(s.WithOpName("axis"), 0, {});
+    auto gather = ops::GatherV2(s.WithOpName("gather"), params, ids, axis);
+
+    auto indices =
+        ops::Const(s.WithOpName("indices"), {0, 1, 2, 3, 4, 5, 1}, {7});
+    auto segment_ids =
+        ops::Const(s.WithOpName("segment_ids"), {0, 0, 0, 2, 2, 3, 3}, {7});
+    Output reduction;
+    if (with_num_segments) {
+      auto num_segments = ops::Const(s.WithOpName("num_segments"), 5, {});
+      reduction = ops::SparseSegmentMeanWithNumSegments(
+          s.WithOpName("reduction"), gather, indices, segment_ids,
+          num_segments);
+    } else {
+      reduction = ops::SparseSegmentSum(s.WithOpName("reduction"), gather,
+                                        indices, segment_ids);
+    }
+    auto fetch = ops::Identity(s.WithOpName("fetch"), reduction);
+
+    auto params_t = GenerateRandomTensor<DT_FLOAT>({100, 16});
+    auto ids_t = test::AsTensor<int64_t>({7, 42, 0, 99, 42, 13});
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    if (fetch_gather) item.fetch.push_back("gather");
+    item.feed = {{"params", params_t}, {"ids", ids_t}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == "reduction") {
+        ASSERT_GE(node.input_size(), 3);
+        if (fetch_gather) {
+          EXPECT_EQ(node.input(0), "gather");
+          EXPECT_EQ(node.input(1), "indices");
+        } else {
+          EXPECT_EQ(node.input(0), "params");
+          EXPECT_EQ(node.input(1), "gather");
+          EXPECT_EQ(node.attr().at("Tidx").type(), DT_INT64);
+        }
+        found++;
+      }
+      if (node.name() == "gather") {
+        EXPECT_EQ(node.op(), "GatherV2");
+        ASSERT_EQ(node.input_size(), 3);
+        if (fetch_gather) {
+          EXPECT_EQ(node.input(0), "params");
+        } else {
+          EXPECT_EQ(node.input(0), "ids");
+          EXPECT_EQ(node.input(1), "indices");
+          EXPECT_EQ(node.attr().at("Tparams").type(), DT_INT64);
+          EXPECT_EQ(node.attr().at("Tindices").type(), DT_INT32);
+        }
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 2);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), tensors_expected.size());
+    for (int i = 0; i < tensors.size(); ++i) {
+      test::ExpectTensorNear<float>(tensors[i], tensors_expected[i], 1e-6);
+    }
+  }
+};
+
+TEST_F(RemapperGatherWithSparseSegmentReductionTest, SparseSegmentSum) {
+  RunTest(/*with_num_segments=*/false, /*fetch_gather=*/false);
+}
+
+TEST_F(RemapperGatherWithSparseSegmentReductionTest,
+       SparseSegmentMeanWithNumSegments) {
+  RunTest(/*with_num_segments=*/true, /*fetch_gather=*/false);
+}
+
+TEST_F(RemapperGatherWithSparseSegmentReductionTest, GatherWithOtherFanouts) {
+  RunTest(/*with_num_segments=*/false, /*fetch_gather=*/true);
+}
+
 class RemapperFuseMatMulWithBiasTest : public RemapperTest {
  public:
   template <DataType DTYPE>
@@ -1347,6 +1536,437 @@ TEST_F(RemapperFuseMatMulWithBiasAndActivationTest, Bf16) {
   RunTest<DT_BFLOAT16>();  // NOLINT
 }
 
+TEST_F(RemapperTest, FuseMatMulWithBiasAndSwish) {
+  if (IsMKLEnabled()) GTEST_SKIP() << "Fusion not available with oneDNN.";
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs_shape = ops::Placeholder::Shape({8, 32});
+  auto rhs_shape = ops::Placeholder::Shape({32, 64});
+  auto bias_shape = ops::Placeholder::Shape({64});
+
+  auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+  auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT, rhs_shape);
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  auto sigmoid = ops::Sigmoid(s.WithOpName("sigmoid"), bias_add);
+  auto swish = ops::Mul(s.WithOpName("swish"), bias_add, sigmoid);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), swish);
+
+  auto lhs_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+  auto rhs_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+  auto bias_t = GenerateRandomTensor<DT_FLOAT>({64});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"lhs", lhs_t}, {"rhs", rhs_t}, {"bias", bias_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "sigmoid");
+    if (node.name() == "swish") {
+      EXPECT_EQ(node.op(), "_FusedMatMul");
+      ASSERT_GE(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "lhs");
+      EXPECT_EQ(node.input(1), "rhs");
+      EXPECT_EQ(node.input(2), "bias");
+      EXPECT_EQ(node.attr().at("num_args").i(), 1);
+
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 2);
+      EXPECT_EQ(fused_ops[0], "BiasAdd");
+      EXPECT_EQ(fused_ops[1], "Swish");
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectClose(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, FuseMatMulWithBiasAndGeluExact) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs_shape = ops::Placeholder::Shape({8, 32});
+  auto rhs_shape = ops::Placeholder::Shape({32, 64});
+  auto bias_shape = ops::Placeholder::Shape({64});
+
+  auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+  auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT, rhs_shape);
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+
+  // Gelu exact as generated by the python api.
+  auto square_root_one_half =
+      ops::Const(s.WithOpName("square_root_one_half"), {0.707106f}, {});
+  auto bias_add_times_square_root_one_half =
+      ops::Mul(s.WithOpName("bias_add_times_square_root_one_half"), bias_add,
+               square_root_one_half);
+  auto erf = ops::Erf(s.WithOpName("erf"), bias_add_times_square_root_one_half);
+  auto one = ops::Const(s.WithOpName("one"), {1.0f}, {});
+  auto erf_plus_one = ops::AddV2(s.WithOpName("one_plus_erf"), erf, one);
+  auto one_half = ops::Const(s.WithOpName("one_half"), {0.5f}, {});
+  auto erf_plus_one_times_one_half = ops::Mul(
+      s.WithOpName("erf_plus_one_times_one_half"), erf_plus_one, one_half);
+  auto gelu = ops::Mul(s.WithOpName("gelu"), erf_plus_one_times_one_half,
+                       bias_add);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), gelu);
+
+  auto lhs_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+  auto rhs_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+  auto bias_t = GenerateRandomTensor<DT_FLOAT>({64});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"lhs", lhs_t}, {"rhs", rhs_t}, {"bias", bias_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "gelu") {
+      EXPECT_EQ(node.op(), "_FusedMatMul");
+      ASSERT_GE(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "lhs");
+      EXPECT_EQ(node.input(1), "rhs");
+      EXPECT_EQ(node.input(2), "bias");
+      EXPECT_EQ(node.attr().at("num_args").i(), 1);
+
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 2);
+      EXPECT_EQ(fused_ops[0], "BiasAdd");
+      EXPECT_EQ(fused_ops[1], "GeluExact");
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  // The graph rounds sqrt(1/2) to 0.707106.
+  test::ExpectClose(tensors[0], tensors_expected[0], 1e-5);
+}
+
+TEST_F(RemapperTest, FuseLayerNorm) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                       ops::Placeholder::Shape({4, 8, 32}));
+  auto scale = Placeholder(s.WithOpName("scale"), DT_FLOAT,
+                           ops::Placeholder::Shape({32}));
+  auto offset = Placeholder(s.WithOpName("offset"), DT_FLOAT,
+                            ops::Placeholder::Shape({32}));
+
+  // LayerNorm over the innermost dimension built from primitive ops.
+  auto axes = ops::Const(s.WithOpName("axes"), {-1}, {1});
+  auto mean = ops::Mean(s.WithOpName("mean"), x, axes,
+                        ops::Mean::KeepDims(true));
+  auto squared_difference =
+      ops::SquaredDifference(s.WithOpName("squared_difference"), x, mean);
+  auto variance = ops::Mean(s.WithOpName("variance"), squared_difference, axes,
+                            ops::Mean::KeepDims(true));
+  auto epsilon = ops::Const(s.WithOpName("epsilon"), {1e-6f}, {});
+  auto variance_plus_epsilon =
+      ops::AddV2(s.WithOpName("variance_plus_epsilon"), variance, epsilon);
+  auto inv_stddev =
+      ops::Rsqrt(s.WithOpName("inv_stddev"), variance_plus_epsilon);
+  auto centered = ops::Sub(s.WithOpName("centered"), x, mean);
+  auto normalized = ops::Mul(s.WithOpName("normalized"), centered, inv_stddev);
+  auto scaled = ops::Mul(s.WithOpName("scaled"), normalized, scale);
+  auto layer_norm = ops::AddV2(s.WithOpName("layer_norm"), scaled, offset);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), layer_norm);
+
+  auto x_t = GenerateRandomTensor<DT_FLOAT>({4, 8, 32});
+  auto scale_t = GenerateRandomTensor<DT_FLOAT>({32});
+  auto offset_t = GenerateRandomTensor<DT_FLOAT>({32});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"x", x_t}, {"scale", scale_t}, {"offset", offset_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "mean");
+    EXPECT_NE(node.name(), "inv_stddev");
+    if (node.name() == "layer_norm") {
+      EXPECT_EQ(node.op(), "_FusedLayerNorm");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "scale");
+      EXPECT_EQ(node.input(2), "offset");
+      EXPECT_FLOAT_EQ(node.attr().at("epsilon").f(), 1e-6f);
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectClose(tensors[0], tensors_expected[0], 1e-5);
+}
+
+TEST_F(RemapperTest, DoNotFuseLayerNormOverOuterDimension) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                       ops::Placeholder::Shape({32, 8}));
+  auto scale = Placeholder(s.WithOpName("scale"), DT_FLOAT,
+                           ops::Placeholder::Shape({8}));
+  auto offset = Placeholder(s.WithOpName("offset"), DT_FLOAT,
+                            ops::Placeholder::Shape({8}));
+
+  auto axes = ops::Const(s.WithOpName("axes"), {0}, {1});
+  auto mean = ops::Mean(s.WithOpName("mean"), x, axes,
+                        ops::Mean::KeepDims(true));
+  auto squared_difference =
+      ops::SquaredDifference(s.WithOpName("squared_difference"), x, mean);
+  auto variance = ops::Mean(s.WithOpName("variance"), squared_difference, axes,
+                            ops::Mean::KeepDims(true));
+  auto epsilon = ops::Const(s.WithOpName("epsilon"), {1e-6f}, {});
+  auto inv_stddev = ops::Rsqrt(
+      s.WithOpName("inv_stddev"),
+      ops::AddV2(s.WithOpName("variance_plus_epsilon"), variance, epsilon));
+  auto normalized =
+      ops::Mul(s.WithOpName("normalized"),
+               ops::Sub(s.WithOpName("centered"), x, mean), inv_stddev);
+  auto scaled = ops::Mul(s.WithOpName("scaled"), normalized, scale);
+  auto layer_norm = ops::AddV2(s.WithOpName("layer_norm"), scaled, offset);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), layer_norm);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.op(), "_FusedLayerNorm");
+  }
+}
+
+TEST_F(RemapperTest, FuseScaledMaskedSoftmax) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // Attention scores of shape [batch, heads, queries, keys] with a padding
+  // mask of shape [batch, 1, 1, keys].
+  auto scores = Placeholder(s.WithOpName("scores"), DT_FLOAT,
+                            ops::Placeholder::Shape({2, 4, 8, 8}));
+  auto mask = Placeholder(s.WithOpName("mask"), DT_FLOAT,
+                          ops::Placeholder::Shape({2, 1, 1, 8}));
+
+  auto scale = ops::Const(s.WithOpName("scale"), {0.125f}, {});
+  auto scaled_scores = ops::Mul(s.WithOpName("scaled_scores"), scores, scale);
+  auto masked_scores =
+      ops::AddV2(s.WithOpName("masked_scores"), scaled_scores, mask);
+  auto softmax = ops::Softmax(s.WithOpName("softmax"), masked_scores);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), softmax);
+
+  auto scores_t = GenerateRandomTensor<DT_FLOAT>({2, 4, 8, 8});
+  Tensor mask_t(DT_FLOAT, {2, 1, 1, 8});
+  test::FillFn<float>(&mask_t,
+                      [](int i) { return i % 8 < 6 ? 0.0f : -10000.0f; });
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"scores", scores_t}, {"mask", mask_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "scaled_scores");
+    EXPECT_NE(node.name(), "masked_scores");
+    if (node.name() == "softmax") {
+      EXPECT_EQ(node.op(), "_FusedScaledMaskedSoftmax");
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "scores");
+      EXPECT_EQ(node.input(1), "mask");
+      EXPECT_FLOAT_EQ(node.attr().at("scale").f(), 0.125f);
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectClose(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, FuseMaskedLogSoftmax) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // An unscaled LogSoftmax, with the mask as the first input of the AddV2.
+  auto scores = Placeholder(s.WithOpName("scores"), DT_FLOAT,
+                            ops::Placeholder::Shape({2, 4, 8, 8}));
+  auto mask = Placeholder(s.WithOpName("mask"), DT_FLOAT,
+                          ops::Placeholder::Shape({2, 1, 1, 8}));
+  auto masked_scores = ops::AddV2(s.WithOpName("masked_scores"), mask, scores);
+  auto log_softmax = ops::LogSoftmax(s.WithOpName("log_softmax"),
+                                     masked_scores);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), log_softmax);
+
+  auto scores_t = GenerateRandomTensor<DT_FLOAT>({2, 4, 8, 8});
+  Tensor mask_t(DT_FLOAT, {2, 1, 1, 8});
+  test::FillFn<float>(&mask_t,
+                      [](int i) { return i % 8 < 6 ? 0.0f : -10000.0f; });
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"scores", scores_t}, {"mask", mask_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "masked_scores");
+    if (node.name() == "log_softmax") {
+      EXPECT_EQ(node.op(), "_FusedScaledMaskedSoftmax");
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "scores");
+      EXPECT_EQ(node.input(1), "mask");
+      EXPECT_FLOAT_EQ(node.attr().at("scale").f(), 1.0f);
+      EXPECT_TRUE(node.attr().at("log").b());
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectClose(tensors[0], tensors_expected[0], 1e-5);
+}
+
+TEST_F(RemapperTest, FuseGeluExact) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto a = Placeholder(s.WithOpName("a"), DT_FLOAT,
+                       ops::Placeholder::Shape({8, 64}));
+  auto b = Placeholder(s.WithOpName("b"), DT_FLOAT,
+                       ops::Placeholder::Shape({8, 64}));
+  auto x = ops::AddV2(s.WithOpName("x"), a, b);
+
+  // Gelu exact as generated by the python api.
+  auto square_root_one_half =
+      ops::Const(s.WithOpName("square_root_one_half"), {0.707106f}, {});
+  auto x_times_square_root_one_half = ops::Mul(
+      s.WithOpName("x_times_square_root_one_half"), x, square_root_one_half);
+  auto erf = ops::Erf(s.WithOpName("erf"), x_times_square_root_one_half);
+  auto one = ops::Const(s.WithOpName("one"), {1.0f}, {});
+  auto erf_plus_one = ops::AddV2(s.WithOpName("one_plus_erf"), erf, one);
+  auto one_half = ops::Const(s.WithOpName("one_half"), {0.5f}, {});
+  auto erf_plus_one_times_one_half = ops::Mul(
+      s.WithOpName("erf_plus_one_times_one_half"), erf_plus_one, one_half);
+  auto gelu = ops::Mul(s.WithOpName("gelu"), erf_plus_one_times_one_half, x);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), gelu);
+
+  auto a_t = GenerateRandomTensor<DT_FLOAT>({8, 64});
+  auto b_t = GenerateRandomTensor<DT_FLOAT>({8, 64});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"a", a_t}, {"b", b_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "erf");
+    if (node.name() == "gelu") {
+      EXPECT_EQ(node.op(), "_FusedGelu");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_FALSE(node.attr().at("approximate").b());
+      found++;
+    }
+  }
+  EXPECT_EQ(1, found);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  // The graph rounds sqrt(1/2) to 0.707106.
+  test::ExpectClose(tensors[0], tensors_expected[0], 1e-5);
+}
+
 TEST_F(RemapperTest, FuseConv2DWithBatchNorm) {
   using ops::Placeholder;
 
@@ -14,6 +14,11 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
 
+#include <deque>
+#include <map>
+#include <tuple>
+
+#include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/scoped_allocator.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -24,7 +29,9 @@ limitations under the License.
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/utils/frame.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/util/env_var.h"
 
 // Like TF_RETURN_IF_ERROR, but also logs a WARNING.
 #define LOG_WARNING_AND_RETURN_IF_ERROR(...)            \
@@ -42,6 +49,12 @@ namespace grappler {
 namespace {
 
 const char kScopedAllocatorAttrName[] = "_scoped_allocator";
+const char kCollectiveReduceV2[] = "CollectiveReduceV2";
+// Index of the instance_key input of CollectiveReduceV2.
+const int kCollectiveV2InstanceKeyInput = 3;
+// Default upper bound on the bytes of the inputs coalesced into one
+// CollectiveReduceV2.
+const int64_t kDefaultCollectiveBucketBytes = 25 << 20;
 
 // Node names often have some kind of name_scope prefix, with slashes,
 // and a _nn numeric suffix.  Returns true if the main part of the node_name
@@ -252,13 +265,15 @@ Status MaybeRewriteInput(ScopedAllocatorOptimizer* sa_opti,
   return Status::OK();
 }
 
-// Populates *inputs with all of the non-control inputs of ops.
+// Populates *inputs with all of the non-control inputs of ops, or only their
+// first one if first_data_input_only is true.
 // Returns error if it fails to find exactly one input for each op,
 // or if some input is not of type dtype.
 Status GetInputs(ScopedAllocatorOptimizer* sa_opti, int64_t invocation_count,
                  GraphDef* graph, const GraphProperties& graph_properties,
                  NodeMap* node_map, const std::vector<NodeDef*>& ops,
-                 DataType dtype, std::vector<InputDesc>* inputs) {
+                 DataType dtype, bool first_data_input_only,
+                 std::vector<InputDesc>* inputs) {
   VLOG(1) << "Getinputs";
   for (NodeDef* n : ops) {
     NodeDef* inode = nullptr;
@@ -289,6 +304,7 @@ Status GetInputs(ScopedAllocatorOptimizer* sa_opti, int64_t invocation_count,
         }
         VLOG(2) << "inode after rewrite " << inode->DebugString()
                 << " output_index " << output_index;
+        if (first_data_input_only) break;
       }
     }
     if (inode_dtype == DT_INVALID) {
@@ -455,7 +471,8 @@ class UnaryElementwiseRewriter : public ScopedAllocatorOptimizer::Rewriter {
         CheckTypesAndGetShapes(*graph_properties_, ops, dtype, input_shapes));
     LOG_WARNING_AND_RETURN_IF_ERROR(
         GetInputs(sa_opti, invocation_count, graph, *graph_properties_,
-                  sa_opti->node_map(), ops, *dtype, inputs));
+                  sa_opti->node_map(), ops, *dtype,
+                  coalesce_first_input_only_, inputs));
     LOG_WARNING_AND_RETURN_IF_ERROR(CheckUsesAllocatorAttributes(*inputs));
     LOG_WARNING_AND_RETURN_IF_ERROR(CheckExistingScopedAllocator(*inputs));
     LOG_WARNING_AND_RETURN_IF_ERROR(
@@ -606,6 +623,7 @@ class UnaryElementwiseRewriter : public ScopedAllocatorOptimizer::Rewriter {
     absl::flat_hash_map<string, string> sac_ctl_inputs;
     for (int i = 0, end = ops.size(); i < end; ++i) {
       NodeDef* old_op = ops[i];
+      bool found_data_input = false;
       for (const string& old_op_input : old_op->input()) {
         int position = 0;
         string input_name = ParseNodeName(old_op_input, &position);
@@ -614,7 +632,11 @@ class UnaryElementwiseRewriter : public ScopedAllocatorOptimizer::Rewriter {
           if (op_instance_names.find(old_op_input) == op_instance_names.end()) {
             sac_ctl_inputs.emplace(old_op_input, input_name);
           }
+        } else if (coalesce_first_input_only_ && found_data_input) {
+          // The other data inputs are forwarded by BuildReplacementOp.
+          continue;
         } else {
+          found_data_input = true;
           // TODO(tucker): remove redundant check.
           // A data input: illegal if from another member of the op set.
           if (op_instance_names.find(old_op_input) != op_instance_names.end()) {
@@ -657,11 +679,12 @@ class UnaryElementwiseRewriter : public ScopedAllocatorOptimizer::Rewriter {
     return Status::OK();
   }
 
-  Status BuildReplacementOp(GraphDef* graph, NodeMap* node_map,
-                            const std::vector<NodeDef*>& ops,
-                            const string& device_name, DataType dtype,
-                            const string& op_name, const string& sac_name,
-                            const string& sa_op_name) {
+  virtual Status BuildReplacementOp(GraphDef* graph, NodeMap* node_map,
+                                    const std::vector<NodeDef*>& ops,
+                                    const string& device_name, DataType dtype,
+                                    const string& op_name,
+                                    const string& sac_name,
+                                    const string& sa_op_name) {
     VLOG(2) << "BuildReplacementOp " << sa_op_name;
     NodeDefBuilder op_builder(sa_op_name, op_name);
     op_builder.Device(device_name);
@@ -884,6 +907,49 @@ class UnaryElementwiseRewriter : public ScopedAllocatorOptimizer::Rewriter {
     *applied = true;
     return Status::OK();
   }
+
+ protected:
+  // If true, only the first data input of each op is allocated from the
+  // ScopedAllocator, and the other data inputs are taken from the first op
+  // of the set by BuildReplacementOp.
+  bool coalesce_first_input_only_ = false;
+};
+
+// Coalesces a bucket of CollectiveReduceV2 ops into a single one. Only the
+// tensors to reduce are concatenated: the group_size, group_key and ordering
+// token inputs are identical within a bucket, and the instance_key of the
+// first op of the bucket is used for the fused collective. Every worker
+// builds the same buckets from the same graph, so they agree on it.
+class CollectiveReduceV2Rewriter : public UnaryElementwiseRewriter {
+ public:
+  CollectiveReduceV2Rewriter() { coalesce_first_input_only_ = true; }
+  ~CollectiveReduceV2Rewriter() override {}
+
+  Status BuildReplacementOp(GraphDef* graph, NodeMap* node_map,
+                            const std::vector<NodeDef*>& ops,
+                            const string& device_name, DataType dtype,
+                            const string& op_name, const string& sac_name,
+                            const string& sa_op_name) override {
+    VLOG(2) << "BuildReplacementOp " << sa_op_name;
+    NodeDef* sa_op_node = graph->add_node();
+    sa_op_node->set_name(sa_op_name);
+    sa_op_node->set_op(op_name);
+    sa_op_node->set_device(device_name);
+    *sa_op_node->mutable_attr() = ops[0]->attr();
+    sa_op_node->mutable_attr()->erase("_output_shapes");
+    AddNodeAttr("_forward_input", std::vector<int32>({0, 0}), sa_op_node);
+    sa_op_node->add_input(sac_name);
+    for (int i = 1; i < ops[0]->input_size(); ++i) {
+      const string& input = ops[0]->input(i);
+      if (IsControlInput(input)) break;
+      sa_op_node->add_input(input);
+    }
+    node_map->AddNode(sa_op_name, sa_op_node);
+    for (int i = 0; i < sa_op_node->input_size(); ++i) {
+      node_map->AddOutput(NodeName(sa_op_node->input(i)), sa_op_name);
+    }
+    return Status::OK();
+  }
 };
 
 ScopedAllocatorOptimizer::ScopedAllocatorOptimizer(
@@ -892,18 +958,29 @@ ScopedAllocatorOptimizer::ScopedAllocatorOptimizer(
   VLOG(1) << "ScopedAllocatorOptimizer::ScopedAllocatorOptimizer";
   Rewriter* r = new UnaryElementwiseRewriter();
   to_delete_.push_back(r);
+  Rewriter* collective_v2 = new CollectiveReduceV2Rewriter();
+  to_delete_.push_back(collective_v2);
+  auto add_op = [this, r, collective_v2](const string& op_name) {
+    op_name_set_.insert(op_name);
+    rewriters_[op_name] = op_name == kCollectiveReduceV2 ? collective_v2 : r;
+  };
   if (opts.enable_op_size() == 0) {
     // Opts handled by default:
-    for (const auto& op_name : {"CollectiveReduce"}) {
-      op_name_set_.insert(op_name);
-      rewriters_[op_name] = r;
+    for (const auto& op_name : {"CollectiveReduce", kCollectiveReduceV2}) {
+      add_op(op_name);
     }
   } else {
     for (const auto& op_name : opts.enable_op()) {
-      op_name_set_.insert(op_name);
-      rewriters_[op_name] = r;
+      add_op(op_name);
     }
   }
+  // The bucket size can be overridden from the environment, which lets an
+  // outer tuning loop sweep it without rebuilding the RewriterConfig.
+  TF_CHECK_OK(ReadInt64FromEnvVar(
+      "TF_SCOPED_ALLOCATOR_COLLECTIVE_BUCKET_BYTES",
+      opts.collective_bucket_bytes() > 0 ? opts.collective_bucket_bytes()
+                                         : kDefaultCollectiveBucketBytes,
+      &collective_bucket_bytes_));
 }
 
 Status ScopedAllocatorOptimizer::Optimize(Cluster* /*cluster*/,
@@ -1073,8 +1150,136 @@ void IdentifyRepeatedInputs(const std::vector<NodeDef*>& nodes,
   }
 }
 
+// Returns a key that is identical for the CollectiveReduceV2 ops that can be
+// coalesced: they have the same attributes, and the same inputs except for
+// the tensor to reduce and the instance key.
+string CollectiveReduceV2BucketKey(const NodeDef& node) {
+  std::map<string, string> attrs;
+  for (const auto& attr : node.attr()) {
+    // Skip the internal attributes, such as _output_shapes.
+    if (absl::StartsWith(attr.first, "_")) continue;
+    attrs[attr.first] = SummarizeAttrValue(attr.second);
+  }
+  string key;
+  for (const auto& attr : attrs) {
+    strings::StrAppend(&key, attr.first, "=", attr.second, ";");
+  }
+  for (int i = 1; i < node.input_size(); ++i) {
+    if (IsControlInput(node.input(i))) break;
+    if (i == kCollectiveV2InstanceKeyInput) continue;
+    strings::StrAppend(&key, node.input(i), ";");
+  }
+  return key;
+}
+
 }  // namespace
 
+Status ScopedAllocatorOptimizer::BucketCollectives(
+    const FrameView& frame_view, const GraphProperties& graph_properties,
+    const GraphDef& graph, const std::vector<NodeDef*>& nodes,
+    std::vector<std::vector<NodeDef*>>* buckets) {
+  // The production time of a collective is the topological position of the
+  // producer of its input, e.g. the order in which the backward pass computes
+  // the gradients.
+  std::vector<const NodeDef*> topo_order;
+  LOG_WARNING_AND_RETURN_IF_ERROR(ComputeTopologicalOrder(graph, &topo_order));
+  absl::flat_hash_map<const NodeDef*, int> topo_index;
+  for (int i = 0, end = topo_order.size(); i < end; ++i) {
+    topo_index[topo_order[i]] = i;
+  }
+
+  std::vector<std::vector<NodeDef*>> loop_groups;
+  PartitionByLoopStructure(frame_view, nodes, &loop_groups);
+  for (const auto& loop_group : loop_groups) {
+    // Candidates by bucket key, with their production time and size in bytes.
+    std::map<string, std::vector<std::tuple<int, int64_t, NodeDef*>>>
+        compatible;
+    for (NodeDef* node : loop_group) {
+      if (node->device().empty() ||
+          node->input_size() <= kCollectiveV2InstanceKeyInput ||
+          !graph_properties.HasOutputProperties(node->name())) {
+        continue;
+      }
+      const auto& output_props =
+          graph_properties.GetOutputProperties(node->name());
+      if (output_props.size() != 1 ||
+          !TensorShape::IsValid(output_props[0].shape()) ||
+          output_props[0].shape().unknown_rank()) {
+        continue;
+      }
+      const NodeDef* producer = node_map_->GetNode(node->input(0));
+      if (producer == nullptr) continue;
+      const int64_t bytes =
+          TensorShape(output_props[0].shape()).num_elements() *
+          DataTypeSize(output_props[0].dtype());
+      compatible[CollectiveReduceV2BucketKey(*node)].emplace_back(
+          topo_index[producer], bytes, node);
+    }
+
+    for (auto& it : compatible) {
+      auto& candidates = it.second;
+      std::sort(candidates.begin(), candidates.end(),
+                [](const std::tuple<int, int64_t, NodeDef*>& a,
+                   const std::tuple<int, int64_t, NodeDef*>& b) {
+                  if (std::get<0>(a) != std::get<0>(b)) {
+                    return std::get<0>(a) < std::get<0>(b);
+                  }
+                  return std::get<2>(a)->name() < std::get<2>(b)->name();
+                });
+      std::vector<NodeDef*> bucket;
+      int64_t bucket_bytes = 0;
+      // Nodes reachable from the collectives of the bucket. A collective whose
+      // input is in there can't join the bucket without creating a cycle.
+      absl::flat_hash_set<const NodeDef*> bucket_fanout;
+      auto close_bucket = [&]() {
+        if (bucket.size() > 1) {
+          VLOG(1) << "Bucket of " << bucket.size() << " " << kCollectiveReduceV2
+                  << " with " << bucket_bytes << " bytes";
+          buckets->push_back(bucket);
+        }
+        bucket.clear();
+        bucket_bytes = 0;
+        bucket_fanout.clear();
+      };
+      for (const auto& candidate : candidates) {
+        const int64_t bytes = std::get<1>(candidate);
+        NodeDef* node = std::get<2>(candidate);
+        if (!bucket.empty() &&
+            (bucket_bytes + bytes > collective_bucket_bytes_ ||
+             bucket_fanout.contains(node_map_->GetNode(node->input(0))))) {
+          close_bucket();
+        }
+        bucket.push_back(node);
+        bucket_bytes += bytes;
+        std::deque<const NodeDef*> queue = {node};
+        while (!queue.empty()) {
+          const NodeDef* fanout = queue.front();
+          queue.pop_front();
+          for (const NodeDef* output : node_map_->GetOutputs(fanout->name())) {
+            if (!ModifiesFrameInfo(*output) &&
+                bucket_fanout.insert(output).second) {
+              queue.push_back(output);
+            }
+          }
+        }
+      }
+      close_bucket();
+    }
+  }
+
+  // A tensor can only be allocated from one ScopedAllocator field, so the
+  // tensors that are reduced more than once get an Identity.
+  absl::flat_hash_set<string> seen_outputs;
+  for (const auto& bucket : *buckets) {
+    for (const NodeDef* node : bucket) {
+      if (!seen_outputs.insert(node->input(0)).second) {
+        repeated_outputs_.insert(node->input(0));
+      }
+    }
+  }
+  return Status::OK();
+}
+
 Status ScopedAllocatorOptimizer::ProcessGraphDef(
     GraphDef* graph, const GraphProperties& graph_properties) {
   // Nodes created by this optimizer have the IsStateful() property
@@ -1107,6 +1312,23 @@ Status ScopedAllocatorOptimizer::ProcessGraphDef(
           continue;
         }
         rewriter->SetGraphProperties(graph_properties);
+        if (op_name == kCollectiveReduceV2) {
+          // Gradients are reduced in size-bounded buckets ordered by their
+          // production time instead of by name scope, so that the fused
+          // collectives of the first gradients don't wait for the last ones.
+          std::vector<std::vector<NodeDef*>> buckets;
+          status = BucketCollectives(frame_view, graph_properties, *graph,
+                                     it.second, &buckets);
+          for (int i = 0, end = buckets.size(); status.ok() && i < end; ++i) {
+            bool applied = false;
+            status = rewriter->Rewrite(this, invocation_count, graph, op_name,
+                                       buckets[i], &applied);
+          }
+          if (!status.ok()) {
+            break;
+          }
+          continue;
+        }
         std::unique_ptr<Tree> root(ComputeScopeTree(it.first, it.second));
         // Record outputs that are inputs to multiple Tree nodes.
         absl::flat_hash_set<string> seen_outputs;
@@ -29,6 +29,7 @@ namespace tensorflow {
 class Graph;
 
 namespace grappler {
+class FrameView;
 class GraphProperties;
 class NodeMap;
 class ScopedAllocatorOptimizer;
@@ -107,6 +108,16 @@ class ScopedAllocatorOptimizer : public GraphOptimizer {
 
   Status OrderNodeSet(std::vector<NodeDef*>* nodes) const;
 
+  // Splits the CollectiveReduceV2 `nodes` of a device into buckets of
+  // compatible collectives whose inputs are at most collective_bucket_bytes_,
+  // in the order in which their inputs are produced. Only buckets of more than
+  // one node are returned.
+  Status BucketCollectives(const FrameView& frame_view,
+                           const GraphProperties& graph_properties,
+                           const GraphDef& graph,
+                           const std::vector<NodeDef*>& nodes,
+                           std::vector<std::vector<NodeDef*>>* buckets);
+
   RewriterConfig::Toggle opt_level_;
   std::unordered_set<string> nodes_to_preserve_;
   OpNameSet op_name_set_;
@@ -114,6 +125,7 @@ class ScopedAllocatorOptimizer : public GraphOptimizer {
   std::vector<Rewriter*> to_delete_;
   int next_sa_id_ = 1;
   int next_identity_id_ = 1;
+  int64_t collective_bucket_bytes_;
   std::unique_ptr<NodeMap> node_map_;
   // Keeps track of outputs, i.e. a node and an output index, that are inputs to
   // more than one op groups that are candidates for scoped allocator
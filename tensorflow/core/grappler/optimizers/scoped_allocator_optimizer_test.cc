@@ -14,10 +14,13 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
 
+#include <set>
 #include <unordered_set>
 
+#include "absl/strings/match.h"
 #include "tensorflow/cc/ops/array_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"  // NOLINT
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -279,6 +282,58 @@ class ScopedAllocatorOptimizerTest : public ::testing::Test {
     }
   }
 
+  // Constructs three CollectiveReduceV2 of the same group, whose inputs have
+  // the given number of elements.
+  /*
+      c0   c1   c2
+      |    |    |
+      g0   g1   g2
+      |    |    |
+      r0   r1   r2
+      |    |    |
+      o0   o1   o2
+  */
+  void BuildCollectiveReduceV2Graph(GraphDef* graph_def,
+                                    const std::vector<int>& sizes) {
+    using test::function::NDef;
+    const string kDevice = "/job:localhost/replica:0/task:0/device:CPU:0";
+    *graph_def->add_node() = NDef(
+        "group_size", "Const", {},
+        {{"dtype", DT_INT32}, {"value", test::AsScalar<int32>(1)}}, kDevice);
+    *graph_def->add_node() = NDef(
+        "group_key", "Const", {},
+        {{"dtype", DT_INT32}, {"value", test::AsScalar<int32>(1)}}, kDevice);
+    for (int i = 0; i < sizes.size(); ++i) {
+      const string c = strings::StrCat("c", i);
+      const string g = strings::StrCat("g", i);
+      const string ik = strings::StrCat("ik", i);
+      const string r = strings::StrCat("r", i);
+      *graph_def->add_node() = NDef(
+          c, "Const", {},
+          {{"dtype", DT_FLOAT},
+           {"value", test::AsTensor<float>(std::vector<float>(sizes[i], 1.0f),
+                                           TensorShape({sizes[i]}))}},
+          kDevice);
+      *graph_def->add_node() = NDef(g, "Neg", {c}, {{"T", DT_FLOAT}}, kDevice);
+      *graph_def->add_node() = NDef(
+          ik, "Const", {},
+          {{"dtype", DT_INT32}, {"value", test::AsScalar<int32>(i + 1)}},
+          kDevice);
+      *graph_def->add_node() =
+          NDef(r, "CollectiveReduceV2", {g, "group_size", "group_key", ik},
+               {{"T", DT_FLOAT},
+                {"merge_op", "Add"},
+                {"final_op", "Id"},
+                {"communication_hint", "auto"},
+                {"timeout_seconds", 0.0f},
+                {"Nordering_token", 0},
+                {"max_subdivs_per_device", -1}},
+               kDevice);
+      *graph_def->add_node() = NDef(strings::StrCat("o", i), "Identity", {r},
+                                    {{"T", DT_FLOAT}}, kDevice);
+    }
+  }
+
   // Invokes ScopedAllocatorOptimizer on `graph_def`, then executes it and
   // returns the outputs specified by `output_names` in `outputs`.
   void ExecuteGraph(const GraphDef& graph_def,
@@ -596,6 +651,60 @@ TEST_F(ScopedAllocatorOptimizerTest, ConstInput) {
   }
   EXPECT_EQ(num_identity_ops, 2);
 }
+TEST_F(ScopedAllocatorOptimizerTest, CollectiveReduceV2SingleBucket) {
+  GrapplerItem item;
+  BuildCollectiveReduceV2Graph(&item.graph, {4, 4, 16});
+
+  ScopedAllocatorOptions opts;
+  ScopedAllocatorOptimizer sao(RewriterConfig::ON, opts);
+  GraphDef optimized_graph;
+  TF_ASSERT_OK(sao.Optimize(nullptr /*cluster*/, item, &optimized_graph));
+
+  // The three collectives are replaced by one that reduces the concatenation
+  // of their inputs, and keeps the group inputs.
+  std::vector<const NodeDef*> collectives;
+  for (const NodeDef& node : optimized_graph.node()) {
+    if (node.op() == "CollectiveReduceV2") collectives.push_back(&node);
+  }
+  ASSERT_EQ(collectives.size(), 1);
+  const NodeDef* fused = collectives[0];
+  ASSERT_EQ(fused->input_size(), 4);
+  EXPECT_TRUE(absl::StartsWith(fused->input(0), "scoped_allocator_concat_"));
+  EXPECT_EQ(fused->input(1), "group_size");
+  EXPECT_EQ(fused->input(2), "group_key");
+  EXPECT_TRUE(absl::StartsWith(fused->input(3), "ik"));
+
+  NodeMap node_map(&optimized_graph);
+  for (const string& output : {"o0", "o1", "o2"}) {
+    const NodeDef* node = node_map.GetNode(output);
+    ASSERT_NE(node, nullptr);
+    EXPECT_TRUE(absl::StartsWith(node->input(0), "scoped_allocator_split_"));
+  }
+}
+
+TEST_F(ScopedAllocatorOptimizerTest, CollectiveReduceV2BucketSize) {
+  GrapplerItem item;
+  BuildCollectiveReduceV2Graph(&item.graph, {4, 4, 64});
+
+  // g0 and g1 take 32 bytes together, g2 doesn't fit in the same bucket.
+  ScopedAllocatorOptions opts;
+  opts.set_collective_bucket_bytes(64);
+  ScopedAllocatorOptimizer sao(RewriterConfig::ON, opts);
+  GraphDef optimized_graph;
+  TF_ASSERT_OK(sao.Optimize(nullptr /*cluster*/, item, &optimized_graph));
+
+  std::set<string> collectives;
+  for (const NodeDef& node : optimized_graph.node()) {
+    if (node.op() == "CollectiveReduceV2") collectives.insert(node.name());
+  }
+  ASSERT_EQ(collectives.size(), 2);
+  EXPECT_EQ(collectives.count("r0"), 0);
+  EXPECT_EQ(collectives.count("r1"), 0);
+  EXPECT_EQ(collectives.count("r2"), 1);
+
+  NodeMap node_map(&optimized_graph);
+  EXPECT_EQ(node_map.GetNode("o2")->input(0), "r2");
+}
 #endif  // ENABLE_MKL
 
 }  // namespace
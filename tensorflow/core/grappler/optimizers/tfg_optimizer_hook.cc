@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/tfg_optimizer_hook.h"
 
+#include <utility>
+
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/Pass/PassManager.h"  // from @llvm-project
 #include "mlir/Pass/PassRegistry.h"  // from @llvm-project
@@ -40,14 +42,25 @@ namespace tfg {
 TfgGrapplerOptimizer::TfgGrapplerOptimizer(const std::string& pass_pipeline)
     : pass_pipeline_(pass_pipeline) {}
 
+TfgGrapplerOptimizer::TfgGrapplerOptimizer(const std::string& name,
+                                           TfgPassPipelineBuilder builder,
+                                           bool enable_threading)
+    : pass_pipeline_(name),
+      builder_(std::move(builder)),
+      enable_threading_(enable_threading) {}
+
 Status TfgGrapplerOptimizer::Optimize(
     tensorflow::grappler::Cluster* cluster,
     const tensorflow::grappler::GrapplerItem& item,
     tensorflow::GraphDef* optimized_graph) {
   // The grappler passes operate on a single graph, there is no point in
-  // having MLIR threading. Also creating and destroying thread on every
-  // Grappler invocation has a non-trivial cost.
-  MLIRContext context(MLIRContext::Threading::DISABLED);
+  // having MLIR threading unless the functions are optimized in parallel. Also
+  // creating and destroying thread on every Grappler invocation has a
+  // non-trivial cost.
+  const bool threading = builder_ && enable_threading_ &&
+                         item.graph.library().function_size() > 1;
+  MLIRContext context(threading ? MLIRContext::Threading::ENABLED
+                                : MLIRContext::Threading::DISABLED);
 #ifndef NDEBUG
   if (VLOG_IS_ON(5))
     fprintf(stderr, "Before Graph: %s\n", item.graph.DebugString().c_str());
@@ -80,7 +93,16 @@ Status TfgGrapplerOptimizer::Optimize(
   if (!graph_op)
     return InvalidArgument("Invariant broken, missing graph op in Module");
 
-  if (!pass_pipeline_.empty()) {
+  if (builder_) {
+    // Run the pipeline on the module, the passes nested on the functions are
+    // scheduled on the MLIR thread pool.
+    PassManager pm(&context, ModuleOp::getOperationName());
+    builder_(pm, item);
+    StatusScopedDiagnosticHandler error_handler(&context);
+    if (failed(pm.run(module)))
+      return error_handler.Combine(
+          InvalidArgument("MLIR Graph Optimizer failed: "));
+  } else if (!pass_pipeline_.empty()) {
     // Parse the pipeline and run it on the graph.
     PassManager pm(&context, GraphOp::getOperationName());
     std::string error;
@@ -95,7 +117,8 @@ Status TfgGrapplerOptimizer::Optimize(
   }
 
   tensorflow::GraphDef graphdef;
-  *graphdef.mutable_library() = item.graph.library();
+  // The functions not optimized in the module are exported unchanged.
+  if (!builder_) *graphdef.mutable_library() = item.graph.library();
   metrics.Reset({"TfgOptimizer", "convert_tfg_to_graphdef"});
   TF_RETURN_WITH_CONTEXT_IF_ERROR(
       tensorflow::ExportMlirToGraphdef(module, &graphdef),
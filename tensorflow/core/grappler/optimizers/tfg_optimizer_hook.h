@@ -16,17 +16,34 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_MLIR_GRAPPLER_GRAPPLER_HOOK_H_
 #define TENSORFLOW_CORE_MLIR_GRAPPLER_GRAPPLER_HOOK_H_
 
+#include <functional>
+#include <string>
+
+#include "mlir/Pass/PassManager.h"  // from @llvm-project
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 
 namespace mlir {
 namespace tfg {
 
+// Populates the pass manager, which runs on the module holding the graph and
+// its functions, for a Grappler item, e.g. to preserve its fetch nodes.
+using TfgPassPipelineBuilder =
+    std::function<void(OpPassManager& pm,
+                        const tensorflow::grappler::GrapplerItem& item)>;
+
 // This class implements a grappler optimizer wrapping a pipeline of passes
 // implemented with TFG.
 class TfgGrapplerOptimizer : public tensorflow::grappler::GraphOptimizer {
  public:
+  // Runs the textual `pass_pipeline` on the graph only.
   explicit TfgGrapplerOptimizer(const std::string& pass_pipeline);
 
+  // Runs the pipeline built by `builder` on the graph and the functions of the
+  // library. The passes nested on the functions run in parallel, on the MLIR
+  // thread pool, if `enable_threading` is set and there are several of them.
+  TfgGrapplerOptimizer(const std::string& name, TfgPassPipelineBuilder builder,
+                       bool enable_threading = true);
+
   std::string name() const override {
     return "tfg_optimizer{" + pass_pipeline_ + "}";
   };
@@ -38,6 +55,8 @@ class TfgGrapplerOptimizer : public tensorflow::grappler::GraphOptimizer {
 
  private:
   std::string pass_pipeline_;
+  TfgPassPipelineBuilder builder_;
+  bool enable_threading_ = false;
 };
 
 }  // end namespace tfg
@@ -15,15 +15,23 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/tfg_optimizer_hook.h"
 
+#include "absl/strings/str_cat.h"
 #include "mlir/Pass/Pass.h"  // from @llvm-project
 #include "mlir/Pass/PassRegistry.h"  // from @llvm-project
 #include "tensorflow/cc/framework/scope.h"
 #include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/common_subgraph_elimination.h"
 #include "tensorflow/core/ir/ops.h"
 #include "tensorflow/core/ir/tf_op_wrapper.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/transforms/cse/cse_pass.h"
+#include "tensorflow/core/transforms/toposort/toposort_pass.h"
 
 namespace mlir {
 namespace tfg {
@@ -66,6 +74,165 @@ TEST(TfgOptimizerTest, Pipeline) {
   ASSERT_EQ("b_visited", output.node(1).name());
 }
 
+// Returns an item whose graph has two identical constants, `a` and `b`, and
+// whose library has two functions.
+GrapplerItem MakeItemWithDuplicates() {
+  Scope s = Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {10});
+  Output b = ops::Const(s.WithOpName("b"), 1.0f, {10});
+  Output add = ops::AddV2(s.WithOpName("add"), a, b);
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  *item.graph.mutable_library()->add_function() = test::function::XTimesTwo();
+  *item.graph.mutable_library()->add_function() = test::function::XAddX();
+  return item;
+}
+
+void AddCSEPasses(mlir::OpPassManager& pm, const GrapplerItem& item) {
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+  const std::vector<string> preserve(nodes_to_preserve.begin(),
+                                     nodes_to_preserve.end());
+  pm.nest<mlir::tfg::GraphOp>().addPass(mlir::tfg::CreateCSEPass(preserve));
+  pm.nest<mlir::tfg::GraphFuncOp>().addPass(
+      mlir::tfg::CreateCSEPass(preserve));
+}
+
+TEST(TfgOptimizerTest, PipelineBuilderOptimizesGraphAndFunctions) {
+  GrapplerItem item = MakeItemWithDuplicates();
+  mlir::tfg::TfgGrapplerOptimizer optimizer("cse", AddCSEPasses);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  ASSERT_EQ(output.node_size(), 2);
+  EXPECT_EQ(output.node(0).name(), "a");
+  EXPECT_EQ(output.node(1).name(), "add");
+  EXPECT_EQ(output.node(1).input(0), "a");
+  EXPECT_EQ(output.node(1).input(1), "a");
+  // The functions are exported from the module.
+  EXPECT_EQ(output.library().function_size(), 2);
+}
+
+TEST(TfgOptimizerTest, PipelineBuilderPreservesFetchNodes) {
+  GrapplerItem item = MakeItemWithDuplicates();
+  item.fetch = {"a", "b"};
+  mlir::tfg::TfgGrapplerOptimizer optimizer("cse", AddCSEPasses,
+                                            /*enable_threading=*/false);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(output.node_size(), 3);
+}
+
+// Adds to `nodes` two identical chains of `num_nodes` Sqrt nodes fed by
+// `input`, and returns their outputs. The outputs of the nodes are their
+// names followed by `output_suffix`.
+template <typename NodeDefs>
+std::vector<string> AddChains(const string& input, const string& output_suffix,
+                              int num_nodes, NodeDefs* nodes) {
+  AttrValue type;
+  type.set_type(DT_FLOAT);
+  std::vector<string> last_nodes;
+  for (const string& chain : {"a", "b"}) {
+    string previous = input;
+    for (int i = 0; i < num_nodes; ++i) {
+      NodeDef* node = nodes->Add();
+      node->set_name(absl::StrCat(chain, i));
+      node->set_op("Sqrt");
+      node->add_input(previous);
+      (*node->mutable_attr())["T"] = type;
+      previous = absl::StrCat(node->name(), output_suffix);
+    }
+    last_nodes.push_back(previous);
+  }
+  return last_nodes;
+}
+
+// Creates a graph of two identical chains of `num_nodes` nodes each, and a
+// library of `num_functions` functions with the same body.
+GrapplerItem ChainsItem(int num_nodes, int num_functions) {
+  GrapplerItem item;
+  NodeDef* c = item.graph.add_node();
+  c->set_name("c");
+  c->set_op("Placeholder");
+  (*c->mutable_attr())["dtype"].set_type(DT_FLOAT);
+  item.fetch = AddChains("c", "", num_nodes, item.graph.mutable_node());
+  for (int f = 0; f < num_functions; ++f) {
+    FunctionDef* func = item.graph.mutable_library()->add_function();
+    OpDef* signature = func->mutable_signature();
+    signature->set_name(absl::StrCat("Chains", f));
+    OpDef::ArgDef* arg = signature->add_input_arg();
+    arg->set_name("x");
+    arg->set_type(DT_FLOAT);
+    OpDef::ArgDef* ret = signature->add_output_arg();
+    ret->set_name("y");
+    ret->set_type(DT_FLOAT);
+    const std::vector<string> outputs =
+        AddChains("x", ":y:0", num_nodes, func->mutable_node_def());
+    (*func->mutable_ret())["y"] = outputs[0];
+  }
+  return item;
+}
+
+void AddTopoSortAndCSEPasses(mlir::OpPassManager& pm,
+                             const GrapplerItem& item) {
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+  const std::vector<string> preserve(nodes_to_preserve.begin(),
+                                     nodes_to_preserve.end());
+  for (mlir::OpPassManager* nested :
+       {&pm.nest<mlir::tfg::GraphOp>(), &pm.nest<mlir::tfg::GraphFuncOp>()}) {
+    nested->addPass(mlir::tfg::CreateTopoSortPass());
+    nested->addPass(mlir::tfg::CreateCSEPass(preserve));
+  }
+}
+
+// The classic common subgraph elimination only optimizes the graph, the
+// MetaOptimizer runs it again on each function of the library.
+static void BM_ClassicCSE(::testing::benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  const GrapplerItem item = ChainsItem(num_nodes, /*num_functions=*/0);
+  for (auto s : state) {
+    CommonSubgraphElimination optimizer;
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * num_nodes);
+}
+BENCHMARK(BM_ClassicCSE)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// Includes the import of the graph in TFG and its export.
+static void BM_TfgCSE(::testing::benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  const GrapplerItem item = ChainsItem(num_nodes, /*num_functions=*/0);
+  for (auto s : state) {
+    mlir::tfg::TfgGrapplerOptimizer optimizer("cse", AddTopoSortAndCSEPasses);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * num_nodes);
+}
+BENCHMARK(BM_TfgCSE)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// Optimizes the graph and 16 functions in one TFG module, with or without
+// threading.
+static void BM_TfgCSEWithFunctions(::testing::benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  const bool enable_threading = state.range(1);
+  constexpr int kNumFunctions = 16;
+  const GrapplerItem item = ChainsItem(num_nodes, kNumFunctions);
+  for (auto s : state) {
+    mlir::tfg::TfgGrapplerOptimizer optimizer("cse", AddTopoSortAndCSEPasses,
+                                              enable_threading);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * num_nodes *
+                          (kNumFunctions + 1));
+}
+BENCHMARK(BM_TfgCSEWithFunctions)
+    ->ArgPair(1000, false)
+    ->ArgPair(1000, true)
+    ->ArgPair(10000, false)
+    ->ArgPair(10000, true);
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
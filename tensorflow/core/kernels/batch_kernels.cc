@@ -47,6 +47,8 @@ constexpr char kMinInflightBatchesAttr[] = "_min_inflight_batches";
 constexpr char kInitialInflightBatchesAttr[] = "_initial_inflight_batches";
 constexpr char kMaxInflightBatchesAttr[] = "_max_inflight_batches";
 constexpr char kBatchesToAverageOverAttr[] = "_batches_to_average_over";
+constexpr char kEnableRaggedBatchingAttr[] = "_enable_ragged_batching";
+constexpr char kEnableZeroCopyBatchingAttr[] = "_enable_zero_copy_batching";
 
 // Default thread count in the per-process batching thread pool.
 constexpr int64_t kBatchThreadPoolSize = 128;
@@ -137,6 +139,8 @@ class BatchResource : public serving::BatchResourceBase {
                        FunctionLibraryRuntime::Handle fhandle,
                        FunctionLibraryRuntime* flib,
                        bool enable_large_batch_splitting,
+                       bool enable_ragged_batching,
+                       bool enable_zero_copy_batching,
                        std::unique_ptr<BatchResource>* resource) {
     BatcherT::Options batcher_options;
     batcher_options.num_batch_threads = num_batch_threads;
@@ -149,7 +153,8 @@ class BatchResource : public serving::BatchResourceBase {
                                batch_timeout_micros, max_enqueued_batches,
                                allowed_batch_sizes,
                                enable_large_batch_splitting),
-        allowed_batch_sizes));
+        allowed_batch_sizes, enable_ragged_batching,
+        enable_zero_copy_batching));
     return Status::OK();
   }
 
@@ -159,6 +164,7 @@ class BatchResource : public serving::BatchResourceBase {
       int32_t max_enqueued_batches,
       const std::vector<int32>& allowed_batch_sizes,
       FunctionLibraryRuntime::Handle fhandle, FunctionLibraryRuntime* flib,
+      bool enable_ragged_batching, bool enable_zero_copy_batching,
       std::unique_ptr<BatchResource>* resource) {
     std::shared_ptr<AdaptiveBatcherT> batcher;
     TF_RETURN_IF_ERROR(AdaptiveBatcherT::Create(
@@ -169,7 +175,8 @@ class BatchResource : public serving::BatchResourceBase {
         GetAdaptiveBatcherQueueOptions(
             max_batch_size, batch_timeout_micros, max_enqueued_batches,
             true /* enable large batch split */, allowed_batch_sizes),
-        allowed_batch_sizes));
+        allowed_batch_sizes, enable_ragged_batching,
+        enable_zero_copy_batching));
     return Status::OK();
   }
 
@@ -179,11 +186,13 @@ class BatchResource : public serving::BatchResourceBase {
   BatchResource(FunctionLibraryRuntime::Handle fhandle,
                 FunctionLibraryRuntime* flib, std::shared_ptr<BatcherT> batcher,
                 const BatcherT::QueueOptions& batcher_queue_options,
-                std::vector<int32> allowed_batch_sizes)
+                std::vector<int32> allowed_batch_sizes,
+                bool enable_ragged_batching, bool enable_zero_copy_batching)
       : BatchResourceBase(
             /*has_process_batch_function=*/fhandle != kInvalidHandle,
             std::move(batcher), batcher_queue_options,
-            std::move(allowed_batch_sizes)),
+            std::move(allowed_batch_sizes), enable_ragged_batching,
+            enable_zero_copy_batching),
         fhandle_(fhandle),
         flib_(flib) {}
 
@@ -191,17 +200,19 @@ class BatchResource : public serving::BatchResourceBase {
                 FunctionLibraryRuntime* flib,
                 std::shared_ptr<AdaptiveBatcherT> batcher,
                 const AdaptiveBatcherT::QueueOptions& batcher_queue_options,
-                std::vector<int32> allowed_batch_sizes)
+                std::vector<int32> allowed_batch_sizes,
+                bool enable_ragged_batching, bool enable_zero_copy_batching)
       : BatchResourceBase(
             /*has_process_batch_function=*/fhandle != kInvalidHandle,
             std::move(batcher), batcher_queue_options,
-            std::move(allowed_batch_sizes)),
+            std::move(allowed_batch_sizes), enable_ragged_batching,
+            enable_zero_copy_batching),
         fhandle_(fhandle),
         flib_(flib) {}
 
   void ProcessFuncBatchImpl(
       const BatchTask& last_task, absl::Span<const Tensor> inputs,
-      std::vector<Tensor>* combined_outputs,
+      std::vector<Tensor>* combined_outputs, RequestCost* batch_cost,
       std::function<void(const Status&)> done) const override {
     auto* last_task_context = last_task.context;
     FunctionLibraryRuntime::Options opts;
@@ -209,6 +220,7 @@ class BatchResource : public serving::BatchResourceBase {
     opts.cancellation_manager = last_task_context->cancellation_manager();
     opts.collective_executor = last_task_context->collective_executor();
     opts.stats_collector = last_task_context->stats_collector();
+    opts.request_cost = batch_cost;
     opts.runner = last_task_context->runner();
     opts.run_all_kernels_inline = last_task_context->run_all_kernels_inline();
     // We do not set 'opts.rendezvous', since if the function is run multiple
@@ -256,6 +268,15 @@ BatchFunctionKernel::BatchFunctionKernel(OpKernelConstruction* c)
     has_attribute_enable_large_batch_splitting_ = false;
   }
 
+  if (c->HasAttr(kEnableRaggedBatchingAttr)) {
+    OP_REQUIRES_OK(
+        c, c->GetAttr(kEnableRaggedBatchingAttr, &enable_ragged_batching_));
+  }
+  if (c->HasAttr(kEnableZeroCopyBatchingAttr)) {
+    OP_REQUIRES_OK(c, c->GetAttr(kEnableZeroCopyBatchingAttr,
+                                 &enable_zero_copy_batching_));
+  }
+
   // Helper function `SetAdaptiveBatchSchedulerOptions` calls
   // `OP_REQUIRES_OK`, which exits the current function upon error.
   // So validate status of `op-kernel-construction`.
@@ -331,7 +352,8 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
       TF_RETURN_IF_ERROR(BatchResource::Create(
           adaptive_shared_batch_scheduler_options, max_batch_size_,
           batch_timeout_micros_, max_enqueued_batches_, allowed_batch_sizes_,
-          handle, flib_, &new_resource));
+          handle, flib_, enable_ragged_batching_, enable_zero_copy_batching_,
+          &new_resource));
       *r = new_resource.release();
       return Status::OK();
     };
@@ -341,7 +363,8 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
       TF_RETURN_IF_ERROR(BatchResource::Create(
           num_batch_threads_, max_batch_size_, batch_timeout_micros_,
           max_enqueued_batches_, allowed_batch_sizes_, handle, flib_,
-          enable_large_batch_splitting_, &new_resource));
+          enable_large_batch_splitting_, enable_ragged_batching_,
+          enable_zero_copy_batching_, &new_resource));
       *r = new_resource.release();
       return Status::OK();
     };
@@ -557,7 +580,8 @@ class BatchKernel : public AsyncOpKernel {
       TF_RETURN_IF_ERROR(BatchResource::Create(
           num_batch_threads_, max_batch_size_, batch_timeout_micros_,
           max_enqueued_batches_, allowed_batch_sizes_, kInvalidHandle,
-          /*flib=*/nullptr, false, &new_resource));
+          /*flib=*/nullptr, false, /*enable_ragged_batching=*/false,
+          /*enable_zero_copy_batching=*/false, &new_resource));
       *r = new_resource.release();
       return Status::OK();
     };
@@ -95,6 +95,10 @@ class BatchFunctionKernel : public AsyncOpKernel {
   bool enable_large_batch_splitting_;
   bool has_attribute_enable_large_batch_splitting_;
   bool enable_adaptive_batch_threads_ = false;
+  // Set by attribute `_enable_ragged_batching`; see BatchResourceBase.
+  bool enable_ragged_batching_ = false;
+  // Set by attribute `_enable_zero_copy_batching`; see BatchResourceBase.
+  bool enable_zero_copy_batching_ = false;
 
   mutex mu_;
 
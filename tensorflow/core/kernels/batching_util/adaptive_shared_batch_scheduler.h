@@ -25,6 +25,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/types/optional.h"
+#include "tensorflow/core/kernels/batching_util/batch_latency_model.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -168,6 +169,15 @@ class AdaptiveSharedBatchScheduler
                          int max_batch_size,
                          std::vector<std::unique_ptr<TaskType>>* output_tasks)>
         split_input_task_func;
+    // If positive, the queue tunes its batch size and timeout instead of
+    // using `max_batch_size` and `batch_timeout_micros` as given. It learns
+    // how the processing latency of its batches grows with their size, and
+    // picks the largest batch size, up to `max_batch_size`, for which the time
+    // to fill a batch at the current arrival rate plus the predicted p99
+    // processing latency stays within this budget. The model keeps being
+    // refitted, so the choice follows changes of load and hardware. See
+    // internal::BatchLatencyModel.
+    int64_t latency_budget_micros = 0;
   };
 
   using BatchProcessor = std::function<void(std::unique_ptr<Batch<TaskType>>)>;
@@ -328,6 +338,13 @@ class ASBSQueue : public BatchScheduler<TaskType> {
 
   std::shared_ptr<AdaptiveSharedBatchScheduler<TaskType>> scheduler_;
   const QueueOptions options_;
+  // Tunes the batch size and timeout if `options_.latency_budget_micros` is
+  // positive; null otherwise. Shared with the batches, which record their
+  // processing latency after the queue may be gone.
+  std::shared_ptr<BatchLatencyModel> latency_model_;
+  // The batch size and timeout of the batches being formed.
+  int max_batch_size_ TF_GUARDED_BY(mu_);
+  int64_t batch_timeout_micros_ TF_GUARDED_BY(mu_);
   // Owned by scheduler_.
   ASBSBatch<TaskType>* current_batch_ TF_GUARDED_BY(mu_) = nullptr;
   int64_t num_enqueued_batches_ TF_GUARDED_BY(mu_) = 0;
@@ -341,11 +358,13 @@ template <typename TaskType>
 class ASBSBatch : public Batch<TaskType> {
  public:
   ASBSBatch(ASBSQueue<TaskType>* queue, int64_t creation_time_micros,
-            int64_t batch_timeout_micros, uint64 traceme_context_id)
+            int64_t batch_timeout_micros, uint64 traceme_context_id,
+            std::shared_ptr<BatchLatencyModel> latency_model = nullptr)
       : queue_(queue),
         creation_time_micros_(creation_time_micros),
         schedulable_time_micros_(creation_time_micros + batch_timeout_micros),
-        traceme_context_id_(traceme_context_id) {}
+        traceme_context_id_(traceme_context_id),
+        latency_model_(std::move(latency_model)) {}
 
   ~ASBSBatch() override {}
 
@@ -357,11 +376,17 @@ class ASBSBatch : public Batch<TaskType> {
 
   uint64 traceme_context_id() const { return traceme_context_id_; }
 
+  // The model to record the processing latency of the batch with, if any.
+  const std::shared_ptr<BatchLatencyModel>& latency_model() const {
+    return latency_model_;
+  }
+
  private:
   ASBSQueue<TaskType>* queue_;
   const int64_t creation_time_micros_;
   const int64_t schedulable_time_micros_;
   const uint64 traceme_context_id_;
+  const std::shared_ptr<BatchLatencyModel> latency_model_;
   TF_DISALLOW_COPY_AND_ASSIGN(ASBSBatch);
 };
 }  // namespace internal
@@ -452,6 +477,11 @@ Status AdaptiveSharedBatchScheduler<TaskType>::AddQueue(
         "max_enqueued_batches must be positive; was ",
         options.max_enqueued_batches);
   }
+  if (options.latency_budget_micros < 0) {
+    return errors::InvalidArgument(
+        "latency_budget_micros must be non-negative; was ",
+        options.latency_budget_micros);
+  }
   if (options.max_input_task_size.has_value()) {
     if (options.max_input_task_size.value() < options.max_batch_size) {
       return errors::InvalidArgument(
@@ -633,9 +663,17 @@ void AdaptiveSharedBatchScheduler<TaskType>::CallbackWrapper(
       profiler::ContextType::kAdaptiveSharedBatchScheduler,
       batch->traceme_context_id());
   const int64_t start_time = batch->creation_time_micros();
+  // The batch is deleted by the callback, and the queue may be too.
+  const std::shared_ptr<internal::BatchLatencyModel> latency_model =
+      batch->latency_model();
+  const int batch_size = batch->size();
+  const int64_t processing_start_time = GetEnv()->NowMicros();
   callback(std::unique_ptr<Batch<TaskType>>(
       const_cast<internal::ASBSBatch<TaskType>*>(batch)));
   int64_t end_time = GetEnv()->NowMicros();
+  if (latency_model != nullptr) {
+    latency_model->RecordBatch(batch_size, end_time - processing_start_time);
+  }
   mutex_lock l(mu_);
   if (is_express) {
     in_flight_express_batches_--;
@@ -701,7 +739,19 @@ template <typename TaskType>
 ASBSQueue<TaskType>::ASBSQueue(
     std::shared_ptr<AdaptiveSharedBatchScheduler<TaskType>> scheduler,
     const QueueOptions& options)
-    : scheduler_(scheduler), options_(options) {}
+    : scheduler_(scheduler),
+      options_(options),
+      max_batch_size_(options.max_batch_size),
+      batch_timeout_micros_(options.batch_timeout_micros) {
+  if (options.latency_budget_micros > 0) {
+    BatchLatencyModel::Options model_options;
+    model_options.latency_budget_micros = options.latency_budget_micros;
+    model_options.max_batch_size = options.max_batch_size;
+    model_options.initial_batch_size = options.max_batch_size;
+    model_options.initial_batch_timeout_micros = options.batch_timeout_micros;
+    latency_model_ = std::make_shared<BatchLatencyModel>(model_options);
+  }
+}
 
 template <typename TaskType>
 ASBSQueue<TaskType>::~ASBSQueue() {
@@ -740,14 +790,27 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
   bool closed_batch = false;
   {
     mutex_lock l(mu_);
+    if (latency_model_ != nullptr) {
+      latency_model_->RecordArrival(size, scheduler_->GetEnv()->NowMicros());
+      const BatchLatencyModel::Parameters parameters =
+          latency_model_->parameters();
+      max_batch_size_ = parameters.max_batch_size;
+      batch_timeout_micros_ = parameters.batch_timeout_micros;
+      // The batch size may have shrunk below the size of the current batch.
+      if (current_batch_ && current_batch_->size() >= max_batch_size_) {
+        current_batch_->Close();
+        closed_batch = true;
+        current_batch_ = nullptr;
+      }
+    }
     if (size > SchedulingCapacityLocked()) {
       return errors::Unavailable("The batch scheduling queue is full");
     }
 
     int remaining_batch_size =
         current_batch_ == nullptr
-            ? options_.max_batch_size
-            : options_.max_batch_size - current_batch_->size();
+            ? max_batch_size_
+            : max_batch_size_ - current_batch_->size();
     if (options_.split_input_task_func == nullptr ||
         size <= remaining_batch_size) {
       // Either we don't allow task splitting or task fits within the current
@@ -758,13 +821,13 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
       // Beyond this point Schedule should not fail, as the caller has been
       // promised that all of the split tasks will be scheduled.
       TF_RETURN_IF_ERROR(options_.split_input_task_func(
-          task, remaining_batch_size, options_.max_batch_size,
+          task, remaining_batch_size, max_batch_size_,
           &tasks_to_schedule));
     }
     for (auto& task : tasks_to_schedule) {
       // Can't fit within current batch, close it off and try to create another.
       if (current_batch_ &&
-          current_batch_->size() + task->size() > options_.max_batch_size) {
+          current_batch_->size() + task->size() > max_batch_size_) {
         current_batch_->Close();
         closed_batch = true;
         current_batch_ = nullptr;
@@ -777,7 +840,8 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
         // are processed in the same batch and should share traceme_context_id.
         current_batch_ = new ASBSBatch<TaskType>(
             this, scheduler_->GetEnv()->NowMicros(),
-            options_.batch_timeout_micros, NewTraceMeContextIdForBatch());
+            batch_timeout_micros_, NewTraceMeContextIdForBatch(),
+            latency_model_);
         new_batches.push_back(current_batch_);
       }
 
@@ -797,7 +861,7 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
       bool reached_max_tasks =
           (options_.max_tasks_per_batch.has_value() &&
            current_batch_->num_tasks() >= options_.max_tasks_per_batch.value());
-      if (current_batch_->size() == options_.max_batch_size ||
+      if (current_batch_->size() >= max_batch_size_ ||
           reached_max_tasks) {
         current_batch_->Close();
         closed_batch = true;
@@ -842,10 +906,10 @@ size_t ASBSQueue<TaskType>::SchedulingCapacity() const {
 template <typename TaskType>
 size_t ASBSQueue<TaskType>::SchedulingCapacityLocked() const {
   const int current_batch_capacity =
-      current_batch_ ? options_.max_batch_size - current_batch_->size() : 0;
+      current_batch_ ? max_batch_size_ - current_batch_->size() : 0;
   const int spare_batches =
       options_.max_enqueued_batches - num_enqueued_batches_;
-  return spare_batches * options_.max_batch_size + current_batch_capacity;
+  return spare_batches * max_batch_size_ + current_batch_capacity;
 }
 
 template <typename TaskType>
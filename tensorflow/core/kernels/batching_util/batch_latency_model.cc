@@ -0,0 +1,154 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_latency_model.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tensorflow {
+namespace serving {
+namespace internal {
+namespace {
+
+// The 99th percentile of the standard normal distribution.
+constexpr double kP99StandardScore = 2.326;
+
+// Moves the decayed average `mean` towards `value`.
+void UpdateMean(double value, double weight, double* mean) {
+  *mean += weight * (value - *mean);
+}
+
+// Returns the weight of the `n`th sample. The first samples are averaged with
+// equal weights, so that the averages don't start out biased towards zero.
+double SampleWeight(int64_t n, double decay) {
+  return std::max(decay, 1.0 / n);
+}
+
+}  // namespace
+
+BatchLatencyModel::BatchLatencyModel(const Options& options)
+    : options_(options) {
+  parameters_.max_batch_size =
+      std::min(options_.initial_batch_size, options_.max_batch_size);
+  parameters_.batch_timeout_micros = options_.initial_batch_timeout_micros;
+}
+
+void BatchLatencyModel::RecordArrival(int size, int64_t now_micros) {
+  mutex_lock l(mu_);
+  ++num_arrivals_;
+  UpdateMean(size, SampleWeight(num_arrivals_, options_.decay),
+             &mean_task_size_);
+  if (num_arrivals_ > 1) {
+    const double interarrival_micros =
+        std::max<int64_t>(now_micros - last_arrival_micros_, 0);
+    UpdateMean(interarrival_micros,
+               SampleWeight(num_arrivals_ - 1, options_.decay),
+               &mean_interarrival_micros_);
+  }
+  last_arrival_micros_ = now_micros;
+}
+
+void BatchLatencyModel::RecordBatch(int batch_size, int64_t latency_micros) {
+  mutex_lock l(mu_);
+  ++num_batches_;
+  const double weight = SampleWeight(num_batches_, options_.decay);
+  const double size = batch_size;
+  const double latency = latency_micros;
+  UpdateMean(size, weight, &mean_size_);
+  UpdateMean(latency, weight, &mean_latency_);
+  UpdateMean(size * size, weight, &mean_size_squared_);
+  UpdateMean(size * latency, weight, &mean_size_latency_);
+  UpdateMean(latency * latency, weight, &mean_latency_squared_);
+  if (num_batches_ >= options_.min_batches) {
+    PickParametersLocked();
+  }
+}
+
+BatchLatencyModel::Parameters BatchLatencyModel::parameters() const {
+  tf_shared_lock l(mu_);
+  return parameters_;
+}
+
+double BatchLatencyModel::PredictP99LatencyMicros(int batch_size) const {
+  tf_shared_lock l(mu_);
+  return PredictP99LatencyMicrosLocked(batch_size);
+}
+
+double BatchLatencyModel::PredictP99LatencyMicrosLocked(int batch_size) const {
+  if (num_batches_ == 0) return 0;
+  const double size_variance = mean_size_squared_ - mean_size_ * mean_size_;
+  double slope;
+  if (size_variance > 1e-6 * std::max(mean_size_squared_, 1.0)) {
+    slope = (mean_size_latency_ - mean_size_ * mean_latency_) / size_variance;
+  } else if (mean_size_ > 0) {
+    // All batches had the same size, so the slope can't be fitted. Assume
+    // the latency is proportional to the size, which errs on the safe side
+    // for larger batches.
+    slope = mean_latency_ / mean_size_;
+  } else {
+    slope = 0;
+  }
+  slope = std::max(slope, 0.0);
+  const double intercept = std::max(mean_latency_ - slope * mean_size_, 0.0);
+  // The mean squared residual of the (possibly clamped) fit.
+  const double residual_variance =
+      mean_latency_squared_ - 2 * intercept * mean_latency_ -
+      2 * slope * mean_size_latency_ + intercept * intercept +
+      2 * intercept * slope * mean_size_ + slope * slope * mean_size_squared_;
+  return intercept + slope * batch_size +
+         kP99StandardScore * std::sqrt(std::max(residual_variance, 0.0));
+}
+
+double BatchLatencyModel::FillTimeMicrosLocked(int batch_size) const {
+  if (num_arrivals_ < 2 || mean_task_size_ <= 0) return 0;
+  return std::max(batch_size - mean_task_size_, 0.0) *
+         mean_interarrival_micros_ / mean_task_size_;
+}
+
+void BatchLatencyModel::PickParametersLocked() {
+  const double budget = options_.latency_budget_micros;
+  auto fits_in_budget = [this, budget](int batch_size)
+                            TF_NO_THREAD_SAFETY_ANALYSIS {
+    return FillTimeMicrosLocked(batch_size) +
+               PredictP99LatencyMicrosLocked(batch_size) <=
+           budget;
+  };
+  if (!fits_in_budget(1)) {
+    // Even single requests overrun the budget; keep their latency minimal.
+    parameters_.max_batch_size = 1;
+    parameters_.batch_timeout_micros = 0;
+    return;
+  }
+  // Both terms grow with the batch size, so binary search for the largest
+  // batch size that fits.
+  int low = 1;
+  int high = options_.max_batch_size;
+  while (low < high) {
+    const int mid = low + (high - low + 1) / 2;
+    if (fits_in_budget(mid)) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+  parameters_.max_batch_size = low;
+  parameters_.batch_timeout_micros =
+      static_cast<int64_t>(std::ceil(FillTimeMicrosLocked(low)));
+}
+
+}  // namespace internal
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,114 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_MODEL_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_MODEL_H_
+
+#include <cstdint>
+
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+namespace internal {
+
+// Learns how the processing latency of a queue's batches grows with their
+// size, and picks the batch size and timeout that maximize throughput while
+// keeping the latency of requests within a budget.
+//
+// The latency of a batch of size s is modeled as a + b * s plus normally
+// distributed noise, fitted by least squares over exponentially decayed
+// samples so that the model follows changes of the hardware load. Since the
+// throughput s / (a + b * s) grows with s, the chosen batch size is the
+// largest one for which the time to fill the batch at the observed arrival
+// rate plus the predicted p99 processing latency fits in the budget. The
+// timeout is that fill time.
+//
+// Thread-safe.
+class BatchLatencyModel {
+ public:
+  struct Options {
+    // The budget for the time a request spends in its batch's timeout plus
+    // the p99 processing latency of the batch.
+    int64_t latency_budget_micros = 0;
+    // The largest batch size to pick.
+    int max_batch_size = 1000;
+    // The parameters to use until `min_batches` batches have been recorded.
+    int initial_batch_size = 1000;
+    int64_t initial_batch_timeout_micros = 0;
+    // The number of recorded batches the model needs before it is used.
+    int min_batches = 100;
+    // The weight of the newest sample in the decayed averages. Larger values
+    // follow load changes faster, and give noisier fits.
+    double decay = 0.01;
+  };
+
+  struct Parameters {
+    int max_batch_size;
+    int64_t batch_timeout_micros;
+  };
+
+  explicit BatchLatencyModel(const Options& options);
+
+  // Records that a task of `size` arrived at time `now_micros`.
+  void RecordArrival(int size, int64_t now_micros);
+
+  // Records that a batch of `batch_size` took `latency_micros` to process,
+  // and picks new parameters.
+  void RecordBatch(int batch_size, int64_t latency_micros);
+
+  // Returns the parameters to form batches with.
+  Parameters parameters() const;
+
+  // Returns the predicted p99 processing latency of a batch of `batch_size`.
+  double PredictP99LatencyMicros(int batch_size) const;
+
+ private:
+  double PredictP99LatencyMicrosLocked(int batch_size) const
+      TF_SHARED_LOCKS_REQUIRED(mu_);
+
+  // Returns the time it takes for tasks of total size `batch_size` to arrive.
+  double FillTimeMicrosLocked(int batch_size) const
+      TF_SHARED_LOCKS_REQUIRED(mu_);
+
+  void PickParametersLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const Options options_;
+
+  mutable mutex mu_;
+
+  // Decayed averages of batch sizes and latencies.
+  int64_t num_batches_ TF_GUARDED_BY(mu_) = 0;
+  double mean_size_ TF_GUARDED_BY(mu_) = 0;
+  double mean_latency_ TF_GUARDED_BY(mu_) = 0;
+  double mean_size_squared_ TF_GUARDED_BY(mu_) = 0;
+  double mean_size_latency_ TF_GUARDED_BY(mu_) = 0;
+  double mean_latency_squared_ TF_GUARDED_BY(mu_) = 0;
+
+  // Decayed averages of task sizes and the times between their arrivals.
+  int64_t num_arrivals_ TF_GUARDED_BY(mu_) = 0;
+  int64_t last_arrival_micros_ TF_GUARDED_BY(mu_) = 0;
+  double mean_task_size_ TF_GUARDED_BY(mu_) = 0;
+  double mean_interarrival_micros_ TF_GUARDED_BY(mu_) = 0;
+
+  Parameters parameters_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace internal
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_MODEL_H_
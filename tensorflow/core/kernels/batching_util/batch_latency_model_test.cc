@@ -0,0 +1,111 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_latency_model.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace internal {
+namespace {
+
+BatchLatencyModel::Options CreateOptions(int64_t latency_budget_micros) {
+  BatchLatencyModel::Options options;
+  options.latency_budget_micros = latency_budget_micros;
+  options.max_batch_size = 256;
+  options.initial_batch_size = 32;
+  options.initial_batch_timeout_micros = 500;
+  options.min_batches = 10;
+  return options;
+}
+
+// Records batches of sizes 1 to 64 whose latency is
+// `fixed_micros + per_item_micros * size`.
+void RecordLinearBatches(double fixed_micros, double per_item_micros,
+                         BatchLatencyModel* model) {
+  for (int i = 0; i < 200; ++i) {
+    const int size = 1 + i % 64;
+    model->RecordBatch(size, fixed_micros + per_item_micros * size);
+  }
+}
+
+// Records tasks of size 1 arriving every `interval_micros`.
+void RecordArrivals(int64_t interval_micros, BatchLatencyModel* model) {
+  for (int i = 0; i < 200; ++i) {
+    model->RecordArrival(1, i * interval_micros);
+  }
+}
+
+TEST(BatchLatencyModelTest, UsesInitialParametersUntilEnoughBatches) {
+  BatchLatencyModel model(CreateOptions(/*latency_budget_micros=*/10000));
+  for (int i = 0; i < 9; ++i) {
+    model.RecordBatch(8, 100);
+  }
+  EXPECT_EQ(model.parameters().max_batch_size, 32);
+  EXPECT_EQ(model.parameters().batch_timeout_micros, 500);
+}
+
+TEST(BatchLatencyModelTest, FitsLinearLatency) {
+  BatchLatencyModel model(CreateOptions(/*latency_budget_micros=*/10000));
+  RecordLinearBatches(/*fixed_micros=*/1000, /*per_item_micros=*/10, &model);
+  EXPECT_NEAR(model.PredictP99LatencyMicros(100), 2000, 1);
+  EXPECT_NEAR(model.PredictP99LatencyMicros(1), 1010, 1);
+}
+
+TEST(BatchLatencyModelTest, PicksLargestBatchWithinBudget) {
+  BatchLatencyModel model(CreateOptions(/*latency_budget_micros=*/3000));
+  RecordArrivals(/*interval_micros=*/10, &model);
+  RecordLinearBatches(/*fixed_micros=*/1000, /*per_item_micros=*/10, &model);
+  // A batch of size s takes 10 * (s - 1) to fill and 1000 + 10 * s to
+  // process, which fits in 3000 for s up to 100.
+  EXPECT_EQ(model.parameters().max_batch_size, 100);
+  EXPECT_EQ(model.parameters().batch_timeout_micros, 990);
+}
+
+TEST(BatchLatencyModelTest, CapsAtMaxBatchSize) {
+  BatchLatencyModel model(CreateOptions(/*latency_budget_micros=*/1000000));
+  RecordArrivals(/*interval_micros=*/10, &model);
+  RecordLinearBatches(/*fixed_micros=*/1000, /*per_item_micros=*/10, &model);
+  EXPECT_EQ(model.parameters().max_batch_size, 256);
+  EXPECT_EQ(model.parameters().batch_timeout_micros, 2550);
+}
+
+TEST(BatchLatencyModelTest, FallsBackToSingleTasksWhenOverBudget) {
+  BatchLatencyModel model(CreateOptions(/*latency_budget_micros=*/500));
+  RecordLinearBatches(/*fixed_micros=*/1000, /*per_item_micros=*/10, &model);
+  EXPECT_EQ(model.parameters().max_batch_size, 1);
+  EXPECT_EQ(model.parameters().batch_timeout_micros, 0);
+}
+
+TEST(BatchLatencyModelTest, FollowsSlowdown) {
+  BatchLatencyModel model(CreateOptions(/*latency_budget_micros=*/3000));
+  RecordArrivals(/*interval_micros=*/10, &model);
+  RecordLinearBatches(/*fixed_micros=*/1000, /*per_item_micros=*/10, &model);
+  EXPECT_EQ(model.parameters().max_batch_size, 100);
+  // The hardware gets twice as slow; the decayed fit forgets the old samples.
+  for (int i = 0; i < 10; ++i) {
+    RecordLinearBatches(/*fixed_micros=*/2000, /*per_item_micros=*/20,
+                        &model);
+  }
+  EXPECT_NEAR(model.PredictP99LatencyMicros(10), 2200, 10);
+  // Now 10 * (s - 1) + 2000 + 20 * s <= 3000 for s up to 33.
+  EXPECT_EQ(model.parameters().max_batch_size, 33);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace serving
+}  // namespace tensorflow
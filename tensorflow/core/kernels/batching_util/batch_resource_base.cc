@@ -247,6 +247,10 @@ Status BatchResourceBase::RegisterInput(
       return errors::InvalidArgument(
           "Batching input tensors must have at least one dimension");
     }
+    if (enable_ragged_batching_ && tensor.shape().dims() < 2) {
+      return errors::InvalidArgument(
+          "Ragged batching input tensors must have at least two dimensions");
+    }
     if (tensors.size() >= 2 &&
         tensor.shape().dim_size(0) != tensors[0].shape().dim_size(0)) {
       return errors::InvalidArgument(
@@ -434,6 +438,12 @@ Status BatchResourceBase::ConcatInputTensors(
 
   // Process each input one at a time (the typical case has just one).
   for (int i = 0; i < num_inputs; ++i) {
+    if (enable_ragged_batching_) {
+      TF_RETURN_IF_ERROR(ConcatRaggedInputTensor(
+          batch, context, i, padded_batch_size, concatenated_tensors));
+      continue;
+    }
+
     // Concatenate the tasks ith input tensors into a big output tensor.
     std::vector<Tensor> to_concatenate;
     to_concatenate.reserve(batch.num_tasks());
@@ -462,15 +472,73 @@ Status BatchResourceBase::ConcatInputTensors(
       }
     }
 
+    AllocatorAttributes output_attr;
+    output_attr.set_on_host(true);
+    output_attr.set_gpu_compatible(enable_zero_copy_batching_);
     Tensor concatenated_tensor;
     Status concat_status =
-        Concat(context, to_concatenate, &concatenated_tensor);
+        Concat(context, to_concatenate, output_attr, &concatenated_tensor);
     TF_RETURN_IF_ERROR(concat_status);
     concatenated_tensors->push_back(concatenated_tensor);
   }
   return Status::OK();
 }
 
+/*static*/ Status BatchResourceBase::ConcatRaggedInputTensor(
+    const BatchT& batch, OpKernelContext* context, int input_index,
+    int padded_batch_size, std::vector<Tensor>* concatenated_tensors) {
+  const TensorShape& first_shape = batch.task(0).inputs.at(input_index).shape();
+  TensorShape inner_shape = first_shape;
+  inner_shape.RemoveDimRange(0, 2);
+
+  Tensor row_splits;
+  AllocatorAttributes cpu_alloc;
+  cpu_alloc.set_on_host(true);
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DT_INT64, TensorShape({padded_batch_size + 1}), &row_splits, cpu_alloc));
+  auto splits = row_splits.vec<int64_t>();
+  splits(0) = 0;
+  int64_t row = 0;
+
+  // Each task's rows go to the values without the padding to a common length.
+  std::vector<Tensor> to_concatenate;
+  to_concatenate.reserve(batch.num_tasks());
+  for (int task_idx = 0; task_idx < batch.num_tasks(); ++task_idx) {
+    const Tensor& input = batch.task(task_idx).inputs.at(input_index);
+    TensorShape values_shape = input.shape();
+    values_shape.RemoveDimRange(0, 2);
+    if (values_shape != inner_shape) {
+      return errors::InvalidArgument(
+          "Ragged batching inputs must match after their second dimension. "
+          "(Input ",
+          input_index, " got shapes ", first_shape.DebugString(), " and ",
+          input.shape().DebugString(), ".)");
+    }
+    const int64_t num_rows = input.dim_size(0);
+    const int64_t row_length = input.dim_size(1);
+    for (int64_t i = 0; i < num_rows; ++i, ++row) {
+      splits(row + 1) = splits(row) + row_length;
+    }
+    values_shape.InsertDim(0, num_rows * row_length);
+    Tensor values;
+    if (!values.CopyFrom(input, values_shape)) {
+      return errors::Internal("Failed to reshape ragged batching input ",
+                              input_index, " to ",
+                              values_shape.DebugString());
+    }
+    to_concatenate.push_back(std::move(values));
+  }
+  for (; row < padded_batch_size; ++row) {
+    splits(row + 1) = splits(row);
+  }
+
+  Tensor concatenated_values;
+  TF_RETURN_IF_ERROR(Concat(context, to_concatenate, &concatenated_values));
+  concatenated_tensors->push_back(std::move(concatenated_values));
+  concatenated_tensors->push_back(std::move(row_splits));
+  return Status::OK();
+}
+
 /*static*/ Status BatchResourceBase::SplitInputTask(
     std::unique_ptr<BatchTask>* input_task_ptr, int open_batch_remaining_slot,
     int max_batch_size, std::vector<std::unique_ptr<BatchTask>>* output_tasks) {
@@ -588,40 +656,58 @@ Status BatchResourceBase::SplitOutputTensors(
   // For each output tensor name, a divided-up tensor with one entry per task.
   std::map<string, std::vector<Tensor>> split_tensors;
 
-  DCHECK_EQ(batch->task(0).context->num_outputs(), combined_outputs.size());
+  const int num_outputs = batch->task(0).context->num_outputs();
+  const int num_combined_outputs =
+      enable_ragged_batching_ ? 2 * num_outputs : num_outputs;
+  DCHECK_EQ(num_combined_outputs, combined_outputs.size());
   int combined_outputs_size = combined_outputs.size();
-  if (combined_outputs_size != batch->task(0).context->num_outputs()) {
+  if (combined_outputs_size != num_combined_outputs) {
     return errors::Internal("Wrong number of batched output tensors");
   }
 
   // Generate 'split_tensors' and populate the context outputs.
-  for (int i = 0, iter_limit = combined_outputs.size(); i < iter_limit; ++i) {
-    const Tensor& output_tensor = combined_outputs[i];
-    if (output_tensor.shape().dims() == 0) {
-      return errors::FailedPrecondition(
-          "Batched output tensor has 0 dimensions");
-    }
-    if (output_tensor.shape().dim_size(0) !=
-        static_cast<int64_t>(batch->size() + padding_size)) {
-      return errors::FailedPrecondition(
-          "Batched output tensor's 0th dimension does not equal the sum of "
-          "the 0th dimension sizes of the input tensors");
-    }
-
+  for (int i = 0; i < num_outputs; ++i) {
     std::vector<Tensor> split_tensor;
-    const Status split_status = tensor::Split(
-        output_tensor, task_sizes_plus_optional_padding, &split_tensor);
-    DCHECK(split_status.ok()) << split_status.ToString();
-    if (!split_status.ok()) {
-      return errors::Internal("Tensor split operation failed: ",
-                              split_status.error_message());
-    }
-    DCHECK_EQ(split_tensor.size(), task_sizes_plus_optional_padding.size());
-    if (split_tensor.size() != task_sizes_plus_optional_padding.size()) {
-      return errors::Internal(
-          "Tensor split operation did not work as expected; got ",
-          split_tensor.size(), " splits; expected ",
-          task_sizes_plus_optional_padding.size());
+    if (enable_ragged_batching_) {
+      std::vector<int64_t> task_sizes(task_sizes_plus_optional_padding.begin(),
+                                      task_sizes_plus_optional_padding.begin() +
+                                          batch->num_tasks());
+      TF_RETURN_IF_ERROR(SplitRaggedOutputTensor(combined_outputs[2 * i],
+                                                 combined_outputs[2 * i + 1],
+                                                 task_sizes, &split_tensor));
+    } else {
+      const Tensor& output_tensor = combined_outputs[i];
+      if (output_tensor.shape().dims() == 0) {
+        return errors::FailedPrecondition(
+            "Batched output tensor has 0 dimensions");
+      }
+      if (output_tensor.shape().dim_size(0) !=
+          static_cast<int64_t>(batch->size() + padding_size)) {
+        return errors::FailedPrecondition(
+            "Batched output tensor's 0th dimension does not equal the sum of "
+            "the 0th dimension sizes of the input tensors");
+      }
+
+      if (enable_zero_copy_batching_) {
+        SliceOutputTensor(output_tensor, task_sizes_plus_optional_padding,
+                          &split_tensor);
+      } else {
+        const Status split_status = tensor::Split(
+            output_tensor, task_sizes_plus_optional_padding, &split_tensor);
+        DCHECK(split_status.ok()) << split_status.ToString();
+        if (!split_status.ok()) {
+          return errors::Internal("Tensor split operation failed: ",
+                                  split_status.error_message());
+        }
+        DCHECK_EQ(split_tensor.size(),
+                  task_sizes_plus_optional_padding.size());
+        if (split_tensor.size() != task_sizes_plus_optional_padding.size()) {
+          return errors::Internal(
+              "Tensor split operation did not work as expected; got ",
+              split_tensor.size(), " splits; expected ",
+              task_sizes_plus_optional_padding.size());
+        }
+      }
     }
 
     // Ignore a possible final split_tensors entry containing the padding.
@@ -639,6 +725,108 @@ Status BatchResourceBase::SplitOutputTensors(
   return Status::OK();
 }
 
+/*static*/ void BatchResourceBase::SliceOutputTensor(
+    const Tensor& output, const std::vector<int64_t>& sizes,
+    std::vector<Tensor>* slices) {
+  slices->reserve(sizes.size());
+  int64_t position = 0;
+  for (const int64_t size : sizes) {
+    Tensor slice = output.Slice(position, position + size);
+    // Kernels may assume that their inputs are aligned.
+    if (slice.IsAligned()) {
+      slices->push_back(std::move(slice));
+    } else {
+      slices->push_back(tensor::DeepCopy(slice));
+    }
+    position += size;
+  }
+}
+
+/*static*/ Status BatchResourceBase::SplitRaggedOutputTensor(
+    const Tensor& values, const Tensor& row_splits,
+    const std::vector<int64_t>& task_sizes,
+    std::vector<Tensor>* split_tensors) {
+  if (values.shape().dims() == 0) {
+    return errors::FailedPrecondition(
+        "Batched ragged output values have 0 dimensions");
+  }
+  int64_t num_task_rows = 0;
+  for (int64_t task_size : task_sizes) {
+    num_task_rows += task_size;
+  }
+  if (row_splits.dtype() != DT_INT64 ||
+      !TensorShapeUtils::IsVector(row_splits.shape()) ||
+      row_splits.NumElements() <= num_task_rows) {
+    return errors::FailedPrecondition(
+        "Batched ragged output row splits must be an int64 vector with more "
+        "than ",
+        num_task_rows, " elements; got ", DataTypeString(row_splits.dtype()),
+        " tensor of shape ", row_splits.shape().DebugString());
+  }
+  const auto splits = row_splits.vec<int64_t>();
+  const int64_t num_rows = splits.size() - 1;
+  if (splits(0) != 0 || splits(num_rows) != values.dim_size(0)) {
+    return errors::FailedPrecondition(
+        "Batched ragged output row splits must start at 0 and end at the "
+        "number of values, ",
+        values.dim_size(0));
+  }
+
+  // The values of the tasks, then those of the padding rows.
+  std::vector<int64_t> values_sizes;
+  values_sizes.reserve(task_sizes.size() + 1);
+  std::vector<int64_t> row_lengths;
+  row_lengths.reserve(task_sizes.size());
+  int64_t row = 0;
+  for (int64_t task_size : task_sizes) {
+    const int64_t row_length = splits(row + 1) - splits(row);
+    for (int64_t i = row; i < row + task_size; ++i) {
+      if (splits(i + 1) - splits(i) != row_length) {
+        return errors::FailedPrecondition(
+            "Rows of a batched ragged output that belong to the same task "
+            "must have the same length; got lengths ",
+            row_length, " and ", splits(i + 1) - splits(i));
+      }
+    }
+    if (row_length < 0) {
+      return errors::FailedPrecondition(
+          "Batched ragged output row splits must not decrease");
+    }
+    values_sizes.push_back(task_size * row_length);
+    row_lengths.push_back(row_length);
+    row += task_size;
+  }
+  if (splits(num_rows) < splits(row)) {
+    return errors::FailedPrecondition(
+        "Batched ragged output row splits must not decrease");
+  }
+  if (row < num_rows) {
+    values_sizes.push_back(splits(num_rows) - splits(row));
+  }
+
+  std::vector<Tensor> split_values;
+  const Status split_status =
+      tensor::Split(values, values_sizes, &split_values);
+  if (!split_status.ok()) {
+    return errors::Internal("Tensor split operation failed: ",
+                            split_status.error_message());
+  }
+  split_tensors->reserve(task_sizes.size());
+  for (int j = 0; j < task_sizes.size(); ++j) {
+    TensorShape shape = values.shape();
+    shape.RemoveDim(0);
+    shape.InsertDim(0, row_lengths[j]);
+    shape.InsertDim(0, task_sizes[j]);
+    Tensor output;
+    if (!output.CopyFrom(split_values[j], shape)) {
+      return errors::Internal("Failed to reshape ragged batching output to ",
+                              shape.DebugString());
+    }
+    split_tensors->push_back(std::move(output));
+  }
+  return Status::OK();
+}
+
 void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
   if (batch->empty()) {
     return;
@@ -652,6 +840,8 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
   // Creates the CostMeasurements within the same context that runs the Session.
   std::vector<std::unique_ptr<CostMeasurement>> batch_cost_measurements =
       CreateCostMeasurements();
+  // The costs the batch function records, split to the tasks like the above.
+  RequestCost batch_cost;
 
   auto& last_task = batch->task(batch->num_tasks() - 1);
   OpKernelContext* last_task_context = last_task.context;
@@ -663,11 +853,13 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
   bool cleanup_done = false;
   int64_t processed_size = batch->size();
   auto cleanup_fn = [&cleanup_done, &batch, &processed_size,
-                     &batch_cost_measurements](const Status& status) {
+                     &batch_cost_measurements,
+                     &batch_cost](const Status& status) {
     if (cleanup_done) {
       return;
     }
     SplitBatchCosts(batch_cost_measurements, processed_size, *batch);
+    SplitBatchCosts(batch_cost, processed_size, *batch);
     for (int i = 0; i < batch->num_tasks(); ++i) {
       if (batch->task(i).is_partial) {
         batch->mutable_task(i)->status->Update(status);
@@ -715,7 +907,8 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
   // library runtime will handle it now.
   finally.release();
   ProcessFuncBatchImpl(
-      last_task, args, &combined_outputs, [&](const Status& run_status) {
+      last_task, args, &combined_outputs, &batch_cost,
+      [&](const Status& run_status) {
         Status final_status;
         auto run_finally = gtl::MakeCleanup([&]() {
           // We do the cleanup here as an optimization, so that
@@ -881,40 +1074,54 @@ void BatchResourceBase::SplitBatchCosts(
     std::vector<std::unique_ptr<CostMeasurement>>& batch_cost_measurements,
     const int64_t processed_size, BatchT& batch) {
   for (auto& batch_cost_measurement : batch_cost_measurements) {
-    if (batch_cost_measurement->GetTotalCost() <= absl::ZeroDuration()) {
-      return;
-    }
-    if (batch.size() == 0) {  // NOLINT: empty() checks the batch contains 0
-                              // tasks. size() gets the sum of task sizes.
-      LOG_EVERY_N_SEC(ERROR, 60)
-          << "Non-zero cost collected but the batch size is 0.";
-      return;
-    }
-    if (processed_size == 0) {
-      LOG_EVERY_N_SEC(ERROR, 60)
-          << "Non-zero cost collected but the processed size is 0.";
-      return;
-    }
-    const absl::string_view cost_type = batch_cost_measurement->GetCostType();
-    const absl::Duration total_cost = batch_cost_measurement->GetTotalCost();
-
-    for (int i = 0; i < batch.num_tasks(); i++) {
-      RequestCost* request_cost = batch.task(i).request_cost;
-      // Skip recording the cost if the request_cost is null.
-      if (!request_cost) continue;
-
-      // Smeared cost: cost of paddings are assigned to each task.
-      const auto cost_with_smear =
-          total_cost / batch.size() * batch.task(i).size();
+    SplitBatchCost(batch_cost_measurement->GetCostType(),
+                   batch_cost_measurement->GetTotalCost(), processed_size,
+                   batch);
+  }
+}
 
-      // Non-smeared cost: cost of paddings are not assigned to any tasks.
-      const auto cost_no_smear =
-          total_cost / processed_size * batch.task(i).size();
+void BatchResourceBase::SplitBatchCosts(const RequestCost& batch_cost,
+                                        const int64_t processed_size,
+                                        BatchT& batch) {
+  for (const auto& cost : batch_cost.GetCosts()) {
+    SplitBatchCost(cost.first, cost.second, processed_size, batch);
+  }
+}
 
-      request_cost->RecordCost(
-          {{absl::StrCat(cost_type, kWithSmearSuffix), cost_with_smear},
-           {absl::StrCat(cost_type, kNoSmearSuffix), cost_no_smear}});
-    }
+void BatchResourceBase::SplitBatchCost(absl::string_view cost_type,
+                                       const absl::Duration total_cost,
+                                       const int64_t processed_size,
+                                       BatchT& batch) {
+  if (total_cost <= absl::ZeroDuration()) {
+    return;
+  }
+  if (batch.size() == 0) {  // NOLINT: empty() checks the batch contains 0
+                            // tasks. size() gets the sum of task sizes.
+    LOG_EVERY_N_SEC(ERROR, 60)
+        << "Non-zero cost collected but the batch size is 0.";
+    return;
+  }
+  if (processed_size == 0) {
+    LOG_EVERY_N_SEC(ERROR, 60)
+        << "Non-zero cost collected but the processed size is 0.";
+    return;
+  }
+  for (int i = 0; i < batch.num_tasks(); i++) {
+    RequestCost* request_cost = batch.task(i).request_cost;
+    // Skip recording the cost if the request_cost is null.
+    if (!request_cost) continue;
+
+    // Smeared cost: cost of paddings are assigned to each task.
+    const auto cost_with_smear =
+        total_cost / batch.size() * batch.task(i).size();
+
+    // Non-smeared cost: cost of paddings are not assigned to any tasks.
+    const auto cost_no_smear =
+        total_cost / processed_size * batch.task(i).size();
+
+    request_cost->RecordCost(
+        {{absl::StrCat(cost_type, kWithSmearSuffix), cost_with_smear},
+         {absl::StrCat(cost_type, kNoSmearSuffix), cost_no_smear}});
   }
 }
 
@@ -126,11 +126,31 @@ class BatchResourceBase : public ResourceBase {
   using BatcherQueueT = BatchScheduler<BatchResourceBase::BatchTask>;
   using BatchT = Batch<BatchResourceBase::BatchTask>;
 
+  // With `enable_ragged_batching`, which requires a process batch function,
+  // every input of shape [n, l, ...] is taken as n rows of length l, and
+  // inputs of different lengths are batched without padding them: the batch
+  // function receives for each input its flat values, of shape
+  // [sum(n * l), ...], followed by its int64 row splits. It returns the
+  // outputs in the same form, and every task gets its rows back as a dense
+  // tensor of shape [n, l', ...], which requires its rows to have the same
+  // length l' in the output. Rows added to reach an allowed batch size are
+  // empty.
+  //
+  // With `enable_zero_copy_batching`, batched inputs are concatenated into
+  // host memory that the device can access directly (pinned memory on GPU),
+  // so that a batch function running there copies them without staging. The
+  // outputs of the tasks are slices of the batched outputs instead of copies,
+  // wherever the slices are aligned; this keeps each batched output alive as
+  // long as the output of any of its tasks.
   BatchResourceBase(bool has_process_batch_function,
                     std::shared_ptr<BatcherT> batcher,
                     const BatcherT::QueueOptions& batcher_queue_options,
-                    std::vector<int32> allowed_batch_sizes)
+                    std::vector<int32> allowed_batch_sizes,
+                    bool enable_ragged_batching = false,
+                    bool enable_zero_copy_batching = false)
       : has_process_batch_function_(has_process_batch_function),
+        enable_ragged_batching_(enable_ragged_batching),
+        enable_zero_copy_batching_(enable_zero_copy_batching),
         batcher_(std::move(batcher)),
         batcher_queue_options_(batcher_queue_options),
         allowed_batch_sizes_(std::move(allowed_batch_sizes)) {
@@ -140,8 +160,12 @@ class BatchResourceBase : public ResourceBase {
   BatchResourceBase(bool has_process_batch_function,
                     std::shared_ptr<AdaptiveBatcherT> batcher,
                     const AdaptiveBatcherT::QueueOptions& batcher_queue_options,
-                    std::vector<int32> allowed_batch_sizes)
+                    std::vector<int32> allowed_batch_sizes,
+                    bool enable_ragged_batching = false,
+                    bool enable_zero_copy_batching = false)
       : has_process_batch_function_(has_process_batch_function),
+        enable_ragged_batching_(enable_ragged_batching),
+        enable_zero_copy_batching_(enable_zero_copy_batching),
         adaptive_batcher_(std::move(batcher)),
         adaptive_batcher_queue_options_(batcher_queue_options),
         allowed_batch_sizes_(std::move(allowed_batch_sizes)) {}
@@ -196,13 +220,41 @@ class BatchResourceBase : public ResourceBase {
       std::vector<std::unique_ptr<CostMeasurement>>& batch_cost_measurements,
       const int64_t processed_size, BatchT& batch);
 
+  // Splits each type of cost recorded in `batch_cost`, such as the time spent
+  // in the kernels of the batch function, to each task in the same way.
+  static void SplitBatchCosts(const RequestCost& batch_cost,
+                              const int64_t processed_size, BatchT& batch);
+
+  // For ragged batching, splits an output given by its flat 'values' and
+  // 'row_splits' into one dense tensor per task, of 'task_sizes' rows.
+  // 'row_splits' may cover padding rows after those of the tasks.
+  static Status SplitRaggedOutputTensor(const Tensor& values,
+                                        const Tensor& row_splits,
+                                        const std::vector<int64_t>& task_sizes,
+                                        std::vector<Tensor>* split_tensors);
+
+  // Splits 'output' along its zeroth dimension into pieces of 'sizes' rows.
+  // The pieces that are aligned are slices sharing the buffer of 'output';
+  // the others are copies.
+  static void SliceOutputTensor(const Tensor& output,
+                                const std::vector<int64_t>& sizes,
+                                std::vector<Tensor>* slices);
+
  private:
-  // Implementation of calling the process batch function.
+  // Implementation of calling the process batch function. The costs of the
+  // function that are recorded in `batch_cost`, if any, are split to the
+  // tasks of the batch.
   virtual void ProcessFuncBatchImpl(
       const BatchResourceBase::BatchTask& last_task,
       absl::Span<const Tensor> inputs, std::vector<Tensor>* combined_outputs,
+      RequestCost* batch_cost,
       std::function<void(const Status&)> done) const = 0;
 
+  // Splits `total_cost` of `cost_type` to the tasks, see SplitBatchCosts().
+  static void SplitBatchCost(absl::string_view cost_type,
+                             const absl::Duration total_cost,
+                             const int64_t processed_size, BatchT& batch);
+
   // Factory method for creating a BatchTask, overridable by subclasses.
   virtual Status CreateBatchTask(
       OpKernelContext* context,
@@ -220,6 +272,12 @@ class BatchResourceBase : public ResourceBase {
   Status ConcatInputTensors(const BatchT& batch, OpKernelContext* context,
                             std::vector<Tensor>* concatenated_tensors) const;
 
+  // For ragged batching, appends the flat values and the row splits of input
+  // 'input_index' of the tasks in 'batch', padded to 'padded_batch_size' rows.
+  static Status ConcatRaggedInputTensor(
+      const BatchT& batch, OpKernelContext* context, int input_index,
+      int padded_batch_size, std::vector<Tensor>* concatenated_tensors);
+
   Status SplitOutputTensors(const std::vector<Tensor>& combined_outputs,
                             BatchT* batch) const;
 
@@ -245,6 +303,11 @@ class BatchResourceBase : public ResourceBase {
 
   // True if user specified a batch processing function for this resource.
   const bool has_process_batch_function_;
+  // True if inputs and outputs are batched as ragged tensors (see above).
+  const bool enable_ragged_batching_;
+  // True if inputs are concatenated into device accessible host memory and
+  // outputs are split into slices (see above).
+  const bool enable_zero_copy_batching_;
   // A batch scheduler, and options for creating queues.
   std::shared_ptr<BatcherT> batcher_;
   BatcherT::QueueOptions batcher_queue_options_;
@@ -18,6 +18,8 @@ limitations under the License.
 #include "absl/time/time.h"
 #include "tensorflow/core/common_runtime/cost_measurement_registry.h"
 #include "tensorflow/core/common_runtime/no_op_cost_measurement.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -154,6 +156,95 @@ TEST(SplitBatchCostTest, SplitMultiCostTypes) {
                            Pair("test_gcu_no_smear", absl::Milliseconds(90))));
 }
 
+TEST(SplitBatchCostTest, SplitRecordedCosts) {
+  BatchResourceBase::BatchT batch;
+  RequestCost cost1, cost2;
+  batch.AddTask(MakeBatchTask(/*task_size=*/1, &cost1));
+  batch.AddTask(MakeBatchTask(/*task_size=*/9, &cost2));
+  batch.Close();
+
+  RequestCost batch_cost;
+  batch_cost.RecordCost({{"cpu_kernel", absl::Milliseconds(100)},
+                         {"intra_op", absl::ZeroDuration()}});
+  BatchResourceBase::SplitBatchCosts(batch_cost, /*processed_size=*/20, batch);
+
+  EXPECT_THAT(batch.task(0).request_cost->GetCosts(),
+              UnorderedElementsAre(
+                  Pair("cpu_kernel_with_smear", absl::Milliseconds(10)),
+                  Pair("cpu_kernel_no_smear", absl::Milliseconds(5))));
+  EXPECT_THAT(batch.task(1).request_cost->GetCosts(),
+              UnorderedElementsAre(
+                  Pair("cpu_kernel_with_smear", absl::Milliseconds(90)),
+                  Pair("cpu_kernel_no_smear", absl::Milliseconds(45))));
+}
+
+TEST(SplitRaggedOutputTensorTest, SplitsRowsPerTask) {
+  // Two tasks with 2 rows of length 1 and 1 row of length 3, then a padding
+  // row of length 2.
+  const Tensor values =
+      test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13},
+                            TensorShape({7, 2}));
+  const Tensor row_splits = test::AsTensor<int64_t>({0, 1, 2, 5, 7});
+  std::vector<Tensor> split_tensors;
+  TF_ASSERT_OK(BatchResourceBase::SplitRaggedOutputTensor(
+      values, row_splits, /*task_sizes=*/{2, 1}, &split_tensors));
+  ASSERT_EQ(split_tensors.size(), 2);
+  test::ExpectTensorEqual<float>(
+      split_tensors[0],
+      test::AsTensor<float>({0, 1, 2, 3}, TensorShape({2, 1, 2})));
+  test::ExpectTensorEqual<float>(
+      split_tensors[1],
+      test::AsTensor<float>({4, 5, 6, 7, 8, 9}, TensorShape({1, 3, 2})));
+}
+
+TEST(SplitRaggedOutputTensorTest, RowsOfATaskMustHaveTheSameLength) {
+  const Tensor values = test::AsTensor<float>({0, 1, 2});
+  const Tensor row_splits = test::AsTensor<int64_t>({0, 1, 3});
+  std::vector<Tensor> split_tensors;
+  const Status status = BatchResourceBase::SplitRaggedOutputTensor(
+      values, row_splits, /*task_sizes=*/{2}, &split_tensors);
+  EXPECT_TRUE(errors::IsFailedPrecondition(status)) << status;
+}
+
+TEST(SplitRaggedOutputTensorTest, RowSplitsMustCoverTheValues) {
+  const Tensor values = test::AsTensor<float>({0, 1, 2});
+  std::vector<Tensor> split_tensors;
+  Status status = BatchResourceBase::SplitRaggedOutputTensor(
+      values, test::AsTensor<int64_t>({0, 2}), /*task_sizes=*/{1},
+      &split_tensors);
+  EXPECT_TRUE(errors::IsFailedPrecondition(status)) << status;
+  status = BatchResourceBase::SplitRaggedOutputTensor(
+      values, test::AsTensor<int64_t>({0, 3}), /*task_sizes=*/{2},
+      &split_tensors);
+  EXPECT_TRUE(errors::IsFailedPrecondition(status)) << status;
+}
+
+TEST(SliceOutputTensorTest, AlignedSlicesShareTheBuffer) {
+  // Rows of 16 floats keep every slice aligned.
+  Tensor output(DT_FLOAT, TensorShape({4, 16}));
+  test::FillIota<float>(&output, 0);
+  std::vector<Tensor> slices;
+  BatchResourceBase::SliceOutputTensor(output, /*sizes=*/{1, 3}, &slices);
+  ASSERT_EQ(slices.size(), 2);
+  for (const Tensor& slice : slices) {
+    EXPECT_TRUE(slice.SharesBufferWith(output));
+  }
+  test::ExpectTensorEqual<float>(slices[1], output.Slice(1, 4));
+}
+
+TEST(SliceOutputTensorTest, UnalignedSlicesAreCopied) {
+  const Tensor output =
+      test::AsTensor<float>({0, 1, 2, 3}, TensorShape({4, 1}));
+  std::vector<Tensor> slices;
+  BatchResourceBase::SliceOutputTensor(output, /*sizes=*/{1, 3}, &slices);
+  ASSERT_EQ(slices.size(), 2);
+  EXPECT_TRUE(slices[0].SharesBufferWith(output));
+  EXPECT_FALSE(slices[1].SharesBufferWith(output));
+  EXPECT_TRUE(slices[1].IsAligned());
+  test::ExpectTensorEqual<float>(
+      slices[1], test::AsTensor<float>({1, 2, 3}, TensorShape({3, 1})));
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
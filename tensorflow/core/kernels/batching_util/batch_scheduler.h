@@ -57,6 +57,16 @@ namespace serving {
 // Items (b), (c) and (d) are typically non-owned pointers to data homed
 // elsewhere, because a task's ownership gets transferred to a BatchScheduler
 // (see below) and it may be deleted as soon as it is done executing.
+// The priority of a BatchTask. See `SharedBatchScheduler::QueueOptions::
+// enable_priority_lanes` for how queues treat the two priorities.
+enum class BatchTaskPriority {
+  // Latency-critical tasks, e.g. online requests.
+  kHigh,
+  // Tasks that can wait, e.g. offline requests; they fill the batches of
+  // high-priority tasks.
+  kLow,
+};
+
 class BatchTask {
  public:
   virtual ~BatchTask() = default;
@@ -64,6 +74,16 @@ class BatchTask {
   // Returns the size of the task, in terms of how much it contributes to the
   // size of a batch. (A batch's size is the sum of its task sizes.)
   virtual size_t size() const = 0;
+
+  // Returns the priority of the task.
+  virtual BatchTaskPriority priority() const {
+    return BatchTaskPriority::kHigh;
+  }
+
+  // Returns the time (as given by Env::NowMicros()) by which the task must be
+  // processed, or 0 if it has no deadline. Only queues that have priority
+  // lanes enabled look at it.
+  virtual uint64 deadline_micros() const { return 0; }
 };
 
 // A thread-safe collection of BatchTasks, to be executed together in some
@@ -33,10 +33,10 @@ typedef Eigen::GpuDevice GPUDevice;
 // Concatenates 'inputs' into a single tensor along the zeroth dimension.
 // Requires that all elements of 'inputs' have element type T. Writes to
 // 'output' using 'context' for the allocation to ensure proper device
-// placement.
+// placement, with attributes 'output_attr'.
 template <typename T>
 Status Concat(OpKernelContext* context, const gtl::ArraySlice<Tensor> inputs,
-              Tensor* output) {
+              const AllocatorAttributes& output_attr, Tensor* output) {
   const int input_dims = inputs[0].dims();
   const TensorShape& input_shape = inputs[0].shape();
 
@@ -71,10 +71,8 @@ Status Concat(OpKernelContext* context, const gtl::ArraySlice<Tensor> inputs,
 
   TensorShape output_shape(input_shape);
   output_shape.set_dim(0, output_dim0);
-  AllocatorAttributes attr;
-  attr.set_on_host(true);
-  TF_RETURN_IF_ERROR(context->allocate_temp(DataTypeToEnum<T>::value,
-                                            output_shape, output, attr));
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataTypeToEnum<T>::value, output_shape, output, output_attr));
   if (output->NumElements() > 0) {
     auto output_flat = output->shaped<T, 2>({1, output->NumElements()});
 #if (defined(GOOGLE_CUDA) && GOOGLE_CUDA) || \
@@ -90,15 +88,25 @@ Status Concat(OpKernelContext* context, const gtl::ArraySlice<Tensor> inputs,
   return Status::OK();
 }
 
+// Same as 'Concat' above, allocating 'output' in host memory.
+template <typename T>
+Status Concat(OpKernelContext* context, const gtl::ArraySlice<Tensor> inputs,
+              Tensor* output) {
+  AllocatorAttributes attr;
+  attr.set_on_host(true);
+  return Concat<T>(context, inputs, attr, output);
+}
+
 // Same as 'Concat' above, but handles Tensor dtype deduction automatically.
 inline Status Concat(OpKernelContext* context,
-                     const gtl::ArraySlice<Tensor> inputs, Tensor* output) {
+                     const gtl::ArraySlice<Tensor> inputs,
+                     const AllocatorAttributes& output_attr, Tensor* output) {
   const DataType type = inputs[0].dtype();
   Status concat_status;
   switch (type) {
-#define CASE(type)                                         \
-  case DataTypeToEnum<type>::value:                        \
-    concat_status = Concat<type>(context, inputs, output); \
+#define CASE(type)                                                      \
+  case DataTypeToEnum<type>::value:                                     \
+    concat_status = Concat<type>(context, inputs, output_attr, output); \
     break;
     TF_CALL_ALL_TYPES(CASE);
 #undef CASE
@@ -109,6 +117,13 @@ inline Status Concat(OpKernelContext* context,
   return concat_status;
 }
 
+inline Status Concat(OpKernelContext* context,
+                     const gtl::ArraySlice<Tensor> inputs, Tensor* output) {
+  AllocatorAttributes attr;
+  attr.set_on_host(true);
+  return Concat(context, inputs, attr, output);
+}
+
 // The Split*() functions split 'input' with element type T into 'sizes.size()'
 // tensors along the zeroth dimension, with the ith split having zeroth-
 // dimension size 'sizes[i]'. They allocate the output tensors using 'context',
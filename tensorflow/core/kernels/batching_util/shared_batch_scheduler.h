@@ -18,8 +18,10 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <deque>
 #include <functional>
+#include <limits>
 #include <list>
 #include <memory>
 #include <string>
@@ -218,6 +220,33 @@ class SharedBatchScheduler
     // submit batches whose size is in a small set of allowed sizes, that can be
     // done by adding padding in the process-batch callback.
     size_t max_execution_batch_size = 1000;
+
+    // If true, the queue keeps tasks in two lanes by BatchTask::priority().
+    // Within a lane, tasks are ordered earliest deadline first; tasks without
+    // a deadline come last, in arrival order. Batches are formed when a batch
+    // thread asks for one, rather than at enqueue time:
+    //  - the high-priority lane is drained first, and the rest of the batch is
+    //    filled with low-priority tasks;
+    //  - a batch of only low-priority tasks is formed only when no
+    //    high-priority task is waiting;
+    //  - a batch is scheduled once it would be full, once the oldest task of
+    //    its lane has waited `batch_timeout_micros`, or once waiting that long
+    //    would overrun the earliest deadline of the lane.
+    // Schedule() rejects tasks whose deadline has already passed with a
+    // DEADLINE_EXCEEDED error. Each lane holds up to `max_enqueued_batches`
+    // full batches of tasks, and SchedulingCapacity() reports the room left
+    // in the high-priority lane.
+    //
+    // Must be false if `enable_lazy_split` is true.
+    bool enable_priority_lanes = false;
+
+    // Used iff `enable_priority_lanes` is true. Called with each task whose
+    // deadline passes while it is enqueued; such tasks are not processed. If
+    // null, they stay enqueued and are processed as usual.
+    //
+    // It runs while the scheduler looks for work, so it should only fail the
+    // task and return; in particular it must not schedule tasks.
+    std::function<void(std::unique_ptr<TaskType> task)> expired_task_callback;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -322,6 +351,9 @@ class Queue {
   // processed by `Queue<TaskType>::ProcessBatch`
   Status ScheduleWithoutOrEagerSplit(std::unique_ptr<TaskType>* task);
 
+  // Enqueue `task` in the priority lane it belongs to.
+  Status ScheduleWithPriorityLanes(std::unique_ptr<TaskType>* task);
+
   // Enqueue `task` along with the batch queue metadata.
   // Batches are formed by the time `ScheduleWithLazySplit` returns; and each
   // batch in the deque could evaluate to a batch to be processed after it's
@@ -354,6 +386,10 @@ class Queue {
   // Batches are guaranteed to form at task enqueue time.
   std::unique_ptr<Batch<TaskType>> ScheduleBatchWithEagerSplit();
 
+  // A variant of `ScheduleBatch`, used when `enable_priority_lanes` is true.
+  // Batches are formed from the priority lanes when they are scheduled.
+  std::unique_ptr<Batch<TaskType>> ScheduleBatchFromPriorityLanes();
+
   // Processes a batch that has been returned earlier by ScheduleBatch().
   void ProcessBatch(std::unique_ptr<Batch<TaskType>> batch);
 
@@ -383,6 +419,48 @@ class Queue {
     }
   }
 
+  // A task waiting in a priority lane.
+  struct LaneEntry {
+    std::unique_ptr<TaskType> task;
+    // The deadline of the task, or the maximum value if it has none.
+    uint64 deadline_micros;
+    // Orders the entries with the same deadline by arrival.
+    uint64 sequence;
+    uint64 enqueue_time_micros;
+  };
+
+  // The tasks of one priority, kept as a heap whose front is the entry with
+  // the earliest deadline.
+  struct Lane {
+    std::vector<LaneEntry> entries;
+    // The sum of the task sizes.
+    size_t size = 0;
+  };
+
+  // The heap order of lane entries: `a` comes after `b`.
+  static bool LaneEntryAfter(const LaneEntry& a, const LaneEntry& b) {
+    return a.deadline_micros != b.deadline_micros
+               ? a.deadline_micros > b.deadline_micros
+               : a.sequence > b.sequence;
+  }
+
+  static void PushToLane(LaneEntry entry, Lane* lane);
+  static std::unique_ptr<TaskType> PopFromLane(Lane* lane);
+
+  // Moves the tasks of `lane` whose deadline is at or before `now_micros` to
+  // `expired_tasks`.
+  static void RemoveExpiredTasks(
+      uint64 now_micros, Lane* lane,
+      std::vector<std::unique_ptr<TaskType>>* expired_tasks);
+
+  // Moves tasks from the front of `lane` to `batch` while they fit in it.
+  void FillBatchFromLane(Lane* lane, Batch<TaskType>* batch) const;
+
+  // Determines whether the priority lanes hold a batch that is schedulable at
+  // `now_micros`.
+  bool IsPriorityLaneBatchSchedulable(uint64 now_micros) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Same as IsEmpty(), but assumes the caller already holds a lock on 'mu_'.
   bool IsEmptyInternal() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
@@ -462,6 +540,16 @@ class Queue {
   std::deque<std::unique_ptr<Batch<BatchInputTaskHandle<TaskType>>>>
       task_handle_batches_ TF_GUARDED_BY(mu_);
 
+  // The tasks waiting to be batched, by priority.
+  //
+  // Used iff `QueueOptions.enable_priority_lanes` is true, in which case
+  // `batches_` only holds an empty open batch.
+  Lane high_priority_lane_ TF_GUARDED_BY(mu_);
+  Lane low_priority_lane_ TF_GUARDED_BY(mu_);
+
+  // The sequence number of the next task added to a priority lane.
+  uint64 next_lane_sequence_ TF_GUARDED_BY(mu_) = 0;
+
   // The counter of the TraceMe context ids.
   uint64 traceme_context_id_counter_ TF_GUARDED_BY(mu_) = 0;
 
@@ -603,6 +691,11 @@ Status SharedBatchScheduler<TaskType>::AddQueueAfterRewritingOptions(
         "enable_large_batch_splitting is enabled.");
   }
 
+  if (options.enable_priority_lanes && options.enable_lazy_split) {
+    return errors::InvalidArgument(
+        "enable_priority_lanes and enable_lazy_split cannot both be enabled.");
+  }
+
   if (options.enable_large_batch_splitting &&
       (options.input_batch_size_limit < options.max_execution_batch_size)) {
     return errors::InvalidArgument(
@@ -797,12 +890,81 @@ Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
                                    " is larger than maximum input batch size ",
                                    options_.input_batch_size_limit);
   }
+  if (options_.enable_priority_lanes) {
+    return ScheduleWithPriorityLanes(task);
+  }
   if (options_.enable_lazy_split) {
     return ScheduleWithLazySplit(std::move(task));
   }
   return ScheduleWithoutOrEagerSplit(std::move(task));
 }
 
+template <typename TaskType>
+Status Queue<TaskType>::ScheduleWithPriorityLanes(
+    std::unique_ptr<TaskType>* task) {
+  const BatchTaskPriority priority = (*task)->priority();
+  profiler::TraceMe trace_me([task, priority] {
+    return profiler::TraceMeEncode(
+        "ScheduleWithPriorityLanes",
+        {{"batching_input_task_size", (*task)->size()},
+         {"priority", static_cast<int>(priority)}});
+  });
+  const uint64 deadline_micros = (*task)->deadline_micros();
+
+  bool notify_of_schedulable_batch = false;
+  {
+    mutex_lock l(mu_);
+
+    DCHECK(!closed_);
+
+    const uint64 now_micros = env_->NowMicros();
+    if (deadline_micros != 0 && deadline_micros <= now_micros) {
+      return errors::DeadlineExceeded(
+          "The deadline of the task passed before it was scheduled");
+    }
+    Lane* lane = priority == BatchTaskPriority::kHigh ? &high_priority_lane_
+                                                      : &low_priority_lane_;
+    if (lane->size + (*task)->size() >
+        options_.max_enqueued_batches * max_execution_batch_size()) {
+      return errors::Unavailable(
+          "The batch scheduling queue to which this task was submitted is "
+          "full");
+    }
+
+    // With large batch splitting, every task is split up front into pieces
+    // that fit in a batch. The pieces keep the deadline of the task and stay
+    // together in the lane.
+    std::vector<std::unique_ptr<TaskType>> output_tasks;
+    if ((*task)->size() <= max_execution_batch_size() ||
+        !options_.enable_large_batch_splitting) {
+      output_tasks.push_back(std::move(*task));
+    } else {
+      TF_RETURN_IF_ERROR(SplitInputBatchIntoSubtasks(task, &output_tasks));
+    }
+    for (auto& output_task : output_tasks) {
+      LaneEntry entry;
+      entry.task = std::move(output_task);
+      entry.deadline_micros = deadline_micros == 0
+                                  ? std::numeric_limits<uint64>::max()
+                                  : deadline_micros;
+      entry.sequence = next_lane_sequence_++;
+      entry.enqueue_time_micros = now_micros;
+      PushToLane(std::move(entry), lane);
+    }
+
+    if (!schedulable_batch_ && IsPriorityLaneBatchSchedulable(now_micros)) {
+      schedulable_batch_ = true;
+      notify_of_schedulable_batch = true;
+    }
+  }
+
+  if (notify_of_schedulable_batch) {
+    schedulable_batch_callback_();
+  }
+
+  return Status::OK();
+}
+
 template <typename TaskType>
 Status Queue<TaskType>::ScheduleWithLazySplit(std::unique_ptr<TaskType>* task) {
   profiler::TraceMe trace_me([task] {
@@ -951,6 +1113,10 @@ template <typename TaskType>
 size_t Queue<TaskType>::NumEnqueuedTasks() const {
   size_t num_enqueued_tasks = 0;
   mutex_lock l(mu_);
+  if (options_.enable_priority_lanes) {
+    return high_priority_lane_.entries.size() +
+           low_priority_lane_.entries.size();
+  }
   if (options_.enable_lazy_split) {
     for (const auto& batch : task_handle_batches_) {
       num_enqueued_tasks += batch->num_tasks();
@@ -972,6 +1138,10 @@ size_t Queue<TaskType>::SchedulingCapacity() const {
 
 template <typename TaskType>
 size_t Queue<TaskType>::SchedulingCapacityInternal() const {
+  if (options_.enable_priority_lanes) {
+    return options_.max_enqueued_batches * max_execution_batch_size() -
+           high_priority_lane_.size;
+  }
   const int64 num_new_batches_schedulable =
       static_cast<int64_t>(options_.max_enqueued_batches) -
       this->num_enqueued_batches();
@@ -1039,9 +1209,55 @@ Queue<TaskType>::ScheduleBatchWithEagerSplit() {
   return batch_to_schedule;
 }
 
+template <typename TaskType>
+std::unique_ptr<Batch<TaskType>>
+Queue<TaskType>::ScheduleBatchFromPriorityLanes() {
+  std::unique_ptr<Batch<TaskType>> batch_to_schedule;
+  std::vector<std::unique_ptr<TaskType>> expired_tasks;
+
+  {
+    mutex_lock l(mu_);
+
+    const uint64 now_micros = env_->NowMicros();
+    if (options_.expired_task_callback != nullptr) {
+      RemoveExpiredTasks(now_micros, &high_priority_lane_, &expired_tasks);
+      RemoveExpiredTasks(now_micros, &low_priority_lane_, &expired_tasks);
+    }
+
+    if (IsPriorityLaneBatchSchedulable(now_micros)) {
+      ++num_batches_being_processed_;
+      batch_to_schedule =
+          std::make_unique<Batch<TaskType>>(++traceme_context_id_counter_);
+      FillBatchFromLane(&high_priority_lane_, batch_to_schedule.get());
+      FillBatchFromLane(&low_priority_lane_, batch_to_schedule.get());
+      batch_to_schedule->Close();
+    } else {
+      schedulable_batch_ = false;
+    }
+  }
+
+  if (!expired_tasks.empty()) {
+    for (auto& task : expired_tasks) {
+      options_.expired_task_callback(std::move(task));
+    }
+    // Dropping the expired tasks may have emptied the queue. The callbacks
+    // must have run before CloseAndWaitUntilEmpty() returns.
+    mutex_lock l(mu_);
+    if (empty_notification_ != nullptr && IsEmptyInternal()) {
+      empty_notification_->Notify();
+      empty_notification_ = nullptr;
+    }
+  }
+
+  return batch_to_schedule;
+}
+
 template <typename TaskType>
 typename SharedBatchScheduler<TaskType>::BatchUniquePtr
 Queue<TaskType>::ScheduleBatch() {
+  if (options_.enable_priority_lanes) {
+    return ScheduleBatchFromPriorityLanes();
+  }
   if (!options_.enable_lazy_split) {
     return ScheduleBatchWithEagerSplit();
   }
@@ -1114,8 +1330,85 @@ void Queue<TaskType>::CloseAndWaitUntilEmpty() {
   empty.WaitForNotification();
 }
 
+template <typename TaskType>
+void Queue<TaskType>::PushToLane(LaneEntry entry, Lane* lane) {
+  lane->size += entry.task->size();
+  lane->entries.push_back(std::move(entry));
+  std::push_heap(lane->entries.begin(), lane->entries.end(), LaneEntryAfter);
+}
+
+template <typename TaskType>
+std::unique_ptr<TaskType> Queue<TaskType>::PopFromLane(Lane* lane) {
+  std::pop_heap(lane->entries.begin(), lane->entries.end(), LaneEntryAfter);
+  std::unique_ptr<TaskType> task = std::move(lane->entries.back().task);
+  lane->entries.pop_back();
+  lane->size -= task->size();
+  return task;
+}
+
+template <typename TaskType>
+void Queue<TaskType>::RemoveExpiredTasks(
+    uint64 now_micros, Lane* lane,
+    std::vector<std::unique_ptr<TaskType>>* expired_tasks) {
+  const auto expired_begin = std::partition(
+      lane->entries.begin(), lane->entries.end(),
+      [now_micros](const LaneEntry& entry) {
+        return entry.deadline_micros > now_micros;
+      });
+  if (expired_begin == lane->entries.end()) return;
+  for (auto it = expired_begin; it != lane->entries.end(); ++it) {
+    lane->size -= it->task->size();
+    expired_tasks->push_back(std::move(it->task));
+  }
+  lane->entries.erase(expired_begin, lane->entries.end());
+  std::make_heap(lane->entries.begin(), lane->entries.end(), LaneEntryAfter);
+}
+
+template <typename TaskType>
+void Queue<TaskType>::FillBatchFromLane(Lane* lane,
+                                        Batch<TaskType>* batch) const {
+  // Stops at the first task that doesn't fit, so that no task is overtaken
+  // by one with a later deadline.
+  while (!lane->entries.empty() &&
+         batch->size() + lane->entries.front().task->size() <=
+             max_execution_batch_size()) {
+    batch->AddTask(PopFromLane(lane));
+  }
+}
+
+template <typename TaskType>
+bool Queue<TaskType>::IsPriorityLaneBatchSchedulable(
+    uint64 now_micros) const {
+  // Low-priority tasks are batched on their own only when no high-priority
+  // task waits.
+  const Lane& lane = high_priority_lane_.entries.empty() ? low_priority_lane_
+                                                         : high_priority_lane_;
+  if (lane.entries.empty()) {
+    return false;
+  }
+  if (closed_ || high_priority_lane_.size + low_priority_lane_.size >=
+                     max_execution_batch_size()) {
+    return true;
+  }
+  const uint64 timeout_micros = options_.batch_timeout_micros;
+  if (lane.entries.front().deadline_micros <= now_micros + timeout_micros) {
+    return true;
+  }
+  uint64 oldest_enqueue_time_micros = now_micros;
+  for (const LaneEntry& entry : lane.entries) {
+    oldest_enqueue_time_micros =
+        std::min(oldest_enqueue_time_micros, entry.enqueue_time_micros);
+  }
+  return now_micros >= oldest_enqueue_time_micros + timeout_micros;
+}
+
 template <typename TaskType>
 bool Queue<TaskType>::IsEmptyInternal() const {
+  if (options_.enable_priority_lanes) {
+    return num_batches_being_processed_ == 0 &&
+           high_priority_lane_.entries.empty() &&
+           low_priority_lane_.entries.empty();
+  }
   if (options_.enable_lazy_split) {
     return num_batches_being_processed_ == 0 &&
            task_handle_batches_.size() == 1 &&
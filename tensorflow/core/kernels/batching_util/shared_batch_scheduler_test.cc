@@ -802,6 +802,180 @@ INSTANTIATE_TEST_SUITE_P(
                       std::make_tuple(/*enable_input_batch_split=*/false,
                                       /*enable_lazy_split=*/false)));
 
+// A FakeTask with a priority and a deadline.
+class FakeTaskWithPriority : public FakeTask {
+ public:
+  FakeTaskWithPriority(size_t size, BatchTaskPriority priority,
+                       uint64 deadline_micros)
+      : FakeTask(size),
+        priority_(priority),
+        deadline_micros_(deadline_micros) {}
+
+  BatchTaskPriority priority() const override { return priority_; }
+  uint64 deadline_micros() const override { return deadline_micros_; }
+
+ private:
+  const BatchTaskPriority priority_;
+  const uint64 deadline_micros_;
+};
+
+Status ScheduleTaskWithPriority(size_t task_size, BatchTaskPriority priority,
+                                uint64 deadline_micros,
+                                BatchScheduler<FakeTask>* scheduler) {
+  std::unique_ptr<FakeTask> task(
+      new FakeTaskWithPriority(task_size, priority, deadline_micros));
+  Status status = scheduler->Schedule(&task);
+  CHECK_EQ(status.ok(), task == nullptr);
+  return status;
+}
+
+QueueOptions CreatePriorityLaneQueueOptions(size_t max_execution_batch_size,
+                                            size_t batch_timeout_micros,
+                                            size_t max_enqueued_batches) {
+  QueueOptions queue_options = CreateQueueOptions(
+      max_execution_batch_size, max_execution_batch_size, batch_timeout_micros,
+      max_enqueued_batches, /*enable_large_batch_splitting=*/false,
+      /*enable_lazy_split=*/false, /*split_func=*/nullptr);
+  queue_options.enable_priority_lanes = true;
+  return queue_options;
+}
+
+TEST(SharedBatchSchedulerPriorityLanesTest, EarliestDeadlineFirst) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    mutex mu;
+    std::vector<std::vector<uint64>> batch_deadlines;
+    Notification first_batch_processed, second_batch_processed;
+    auto callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      mutex_lock l(mu);
+      std::vector<uint64> deadlines;
+      for (int i = 0; i < batch->num_tasks(); ++i) {
+        deadlines.push_back(batch->task(i).deadline_micros());
+      }
+      batch_deadlines.push_back(deadlines);
+      if (batch_deadlines.size() == 1) {
+        first_batch_processed.Notify();
+      } else {
+        second_batch_processed.Notify();
+      }
+    };
+
+    auto scheduler = CreateSharedBatchScheduler(1, &env);
+    auto queue = CreateQueue(
+        scheduler,
+        CreatePriorityLaneQueueOptions(/*max_execution_batch_size=*/4,
+                                       /*batch_timeout_micros=*/10,
+                                       /*max_enqueued_batches=*/2),
+        callback);
+
+    // Neither lane is full and no task has timed out, so nothing is
+    // scheduled until the low-priority task brings the total size to 4.
+    TF_ASSERT_OK(ScheduleTaskWithPriority(1, BatchTaskPriority::kHigh,
+                                          /*deadline_micros=*/0, queue.get()));
+    TF_ASSERT_OK(ScheduleTaskWithPriority(1, BatchTaskPriority::kHigh,
+                                          /*deadline_micros=*/100,
+                                          queue.get()));
+    EXPECT_EQ(queue->NumEnqueuedTasks(), 2);
+    EXPECT_EQ(queue->SchedulingCapacity(), 6);
+    TF_ASSERT_OK(ScheduleTaskWithPriority(3, BatchTaskPriority::kLow,
+                                          /*deadline_micros=*/0, queue.get()));
+
+    // The high-priority tasks go first, by deadline. The low-priority task
+    // doesn't fit with them, and waits for its timeout on its own.
+    first_batch_processed.WaitForNotification();
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_FALSE(second_batch_processed.HasBeenNotified());
+    env.AdvanceByMicroseconds(10);
+    second_batch_processed.WaitForNotification();
+    {
+      mutex_lock l(mu);
+      ASSERT_EQ(batch_deadlines.size(), 2);
+      EXPECT_EQ(batch_deadlines[0], std::vector<uint64>({100, 0}));
+      EXPECT_EQ(batch_deadlines[1], std::vector<uint64>({0}));
+    }
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerPriorityLanesTest, DropsExpiredTasks) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification first_batch_started, finish_first_batch, task_expired;
+    int num_batches = 0;
+    auto callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      ++num_batches;
+      first_batch_started.Notify();
+      finish_first_batch.WaitForNotification();
+    };
+
+    auto scheduler = CreateSharedBatchScheduler(1, &env);
+    QueueOptions options =
+        CreatePriorityLaneQueueOptions(/*max_execution_batch_size=*/4,
+                                       /*batch_timeout_micros=*/10,
+                                       /*max_enqueued_batches=*/2);
+    options.expired_task_callback = [&](std::unique_ptr<FakeTask> task) {
+      EXPECT_EQ(task->deadline_micros(), 20);
+      task_expired.Notify();
+    };
+    auto queue = CreateQueue(scheduler, options, callback);
+
+    // Keeps the only batch thread busy while the next task expires.
+    TF_ASSERT_OK(ScheduleTaskWithPriority(4, BatchTaskPriority::kHigh,
+                                          /*deadline_micros=*/0, queue.get()));
+    first_batch_started.WaitForNotification();
+    TF_ASSERT_OK(ScheduleTaskWithPriority(1, BatchTaskPriority::kHigh,
+                                          /*deadline_micros=*/20,
+                                          queue.get()));
+    env.AdvanceByMicroseconds(20);
+    EXPECT_THAT(ScheduleTaskWithPriority(1, BatchTaskPriority::kLow,
+                                         /*deadline_micros=*/20, queue.get()),
+                testing::StatusIs(error::DEADLINE_EXCEEDED));
+    finish_first_batch.Notify();
+    task_expired.WaitForNotification();
+    queue.reset();
+    EXPECT_EQ(num_batches, 1);
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerPriorityLanesTest, InvalidWithLazySplit) {
+  auto callback = [](std::unique_ptr<Batch<FakeTask>> batch) {
+    // do nothing.
+  };
+
+  auto scheduler = CreateSharedBatchScheduler(2);
+  QueueOptions options = CreatePriorityLaneQueueOptions(
+      /*max_execution_batch_size=*/10, /*batch_timeout_micros=*/0,
+      /*max_enqueued_batches=*/2);
+  options.enable_large_batch_splitting = true;
+  options.enable_lazy_split = true;
+  options.split_input_task_func =
+      [](std::unique_ptr<FakeTask>* input_task, int open_batch_remaining_slot,
+         int max_batch_size,
+         std::vector<std::unique_ptr<FakeTask>>* output_tasks) -> Status {
+    output_tasks->push_back(std::move(*input_task));
+    return Status::OK();
+  };
+  std::unique_ptr<Queue> queue;
+  EXPECT_THAT(scheduler->AddQueue(options, callback, &queue),
+              testing::StatusIs(error::INVALID_ARGUMENT,
+                                "enable_priority_lanes and enable_lazy_split "
+                                "cannot both be enabled."));
+}
+
 #ifdef PLATFORM_GOOGLE
 // This benchmark relies on https://github.com/google/benchmark features,
 // (in particular, `Benchmark::ThreadRange`) not available in open-sourced TF
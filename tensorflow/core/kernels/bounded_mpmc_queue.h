@@ -0,0 +1,140 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BOUNDED_MPMC_QUEUE_H_
+#define TENSORFLOW_CORE_KERNELS_BOUNDED_MPMC_QUEUE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/base/optimization.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+
+// A bounded multi-producer multi-consumer FIFO queue that never blocks.
+// TryPush and TryPop are lock-free: every cell of the ring carries a sequence
+// number that tells producers and consumers whether it is free or full in the
+// current lap, so that a single compare-and-swap on the position claims it
+// (D. Vyukov's bounded MPMC queue).
+//
+// The capacity is exact and need not be a power of two.
+template <typename T>
+class BoundedMpmcQueue {
+ public:
+  explicit BoundedMpmcQueue(int64_t capacity)
+      : capacity_(capacity), cells_(new Cell[capacity]) {
+    CHECK_GT(capacity, 0);
+    for (uint64_t i = 0; i < capacity_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  // Appends a copy of `value` and returns true, or returns false if the queue
+  // is full.
+  bool TryPush(const T& value) {
+    uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos % capacity_];
+      const uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const int64_t diff =
+          static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          cell.value = value;
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Moves the oldest element to `*value` and returns true, or returns false
+  // if the queue is empty.
+  bool TryPop(T* value) {
+    uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos % capacity_];
+      const uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const int64_t diff =
+          static_cast<int64_t>(sequence) - static_cast<int64_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          *value = std::move(cell.value);
+          cell.value = T();
+          cell.sequence.store(pos + capacity_, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Returns the number of elements. It is only exact when no TryPush or
+  // TryPop runs concurrently.
+  int64_t size() const {
+    const uint64_t dequeue_pos = dequeue_pos_.load(std::memory_order_acquire);
+    const uint64_t enqueue_pos = enqueue_pos_.load(std::memory_order_acquire);
+    const int64_t size = static_cast<int64_t>(enqueue_pos - dequeue_pos);
+    return std::min(std::max<int64_t>(size, 0),
+                    static_cast<int64_t>(capacity_));
+  }
+
+  // Returns the oldest element, or nullptr if the queue is empty. Must not be
+  // called concurrently with TryPush or TryPop.
+  const T* front() const {
+    const uint64_t pos = dequeue_pos_.load(std::memory_order_acquire);
+    const Cell& cell = cells_[pos % capacity_];
+    if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+      return nullptr;
+    }
+    return &cell.value;
+  }
+
+  int64_t capacity() const { return capacity_; }
+
+ private:
+  struct Cell {
+    std::atomic<uint64_t> sequence;
+    T value;
+  };
+
+  const uint64_t capacity_;
+  const std::unique_ptr<Cell[]> cells_;
+  // Producers and consumers advance their positions on separate cache lines.
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<uint64_t> enqueue_pos_;
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<uint64_t> dequeue_pos_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BoundedMpmcQueue);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BOUNDED_MPMC_QUEUE_H_
@@ -0,0 +1,152 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/bounded_mpmc_queue.h"
+
+#include <atomic>
+#include <deque>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(BoundedMpmcQueueTest, FifoOrderAndCapacity) {
+  for (int capacity : {1, 3, 8}) {
+    BoundedMpmcQueue<int> queue(capacity);
+    int value = -1;
+    EXPECT_FALSE(queue.TryPop(&value));
+    EXPECT_EQ(queue.front(), nullptr);
+    // Goes around the ring several times.
+    for (int lap = 0; lap < 3; ++lap) {
+      for (int i = 0; i < capacity; ++i) {
+        EXPECT_TRUE(queue.TryPush(lap * 100 + i));
+      }
+      EXPECT_FALSE(queue.TryPush(-1));
+      EXPECT_EQ(queue.size(), capacity);
+      EXPECT_EQ(*queue.front(), lap * 100);
+      for (int i = 0; i < capacity; ++i) {
+        EXPECT_TRUE(queue.TryPop(&value));
+        EXPECT_EQ(value, lap * 100 + i);
+      }
+      EXPECT_FALSE(queue.TryPop(&value));
+      EXPECT_EQ(queue.size(), 0);
+    }
+  }
+}
+
+TEST(BoundedMpmcQueueTest, PopReleasesValue) {
+  BoundedMpmcQueue<std::vector<int>> queue(2);
+  EXPECT_TRUE(queue.TryPush(std::vector<int>(10, 1)));
+  std::vector<int> value;
+  EXPECT_TRUE(queue.TryPop(&value));
+  EXPECT_EQ(value.size(), 10);
+  EXPECT_EQ(queue.front(), nullptr);
+}
+
+TEST(BoundedMpmcQueueTest, ConcurrentProducersAndConsumers) {
+  constexpr int kNumProducers = 4;
+  constexpr int kNumConsumers = 4;
+  constexpr int64_t kValuesPerProducer = 20000;
+  BoundedMpmcQueue<int64_t> queue(64);
+  std::atomic<int64_t> sum(0);
+  std::atomic<int64_t> num_popped(0);
+  {
+    thread::ThreadPool pool(Env::Default(), "test",
+                            kNumProducers + kNumConsumers);
+    for (int p = 0; p < kNumProducers; ++p) {
+      pool.Schedule([&queue, p]() {
+        int64_t last = -1;
+        for (int64_t i = 0; i < kValuesPerProducer; ++i) {
+          const int64_t value = p * kValuesPerProducer + i;
+          while (!queue.TryPush(value)) {
+            std::this_thread::yield();
+          }
+          CHECK_GT(value, last);
+          last = value;
+        }
+      });
+    }
+    for (int c = 0; c < kNumConsumers; ++c) {
+      pool.Schedule([&]() {
+        // The values of every producer come out in the order it pushed them.
+        std::vector<int64_t> last(kNumProducers, -1);
+        while (num_popped.load() < kNumProducers * kValuesPerProducer) {
+          int64_t value;
+          if (!queue.TryPop(&value)) {
+            std::this_thread::yield();
+            continue;
+          }
+          const int producer = value / kValuesPerProducer;
+          CHECK_GT(value, last[producer]);
+          last[producer] = value;
+          sum.fetch_add(value);
+          num_popped.fetch_add(1);
+        }
+      });
+    }
+  }
+  const int64_t n = kNumProducers * kValuesPerProducer;
+  EXPECT_EQ(num_popped.load(), n);
+  EXPECT_EQ(sum.load(), n * (n - 1) / 2);
+  EXPECT_EQ(queue.size(), 0);
+}
+
+constexpr int kBenchmarkCapacity = 1024;
+
+// Pushes then pops an element from every thread, on the ring and on a deque
+// behind a mutex as the baseline.
+void BM_BoundedMpmcQueuePushPop(::testing::benchmark::State& state) {
+  static auto* queue = new BoundedMpmcQueue<int64_t>(kBenchmarkCapacity);
+  int64_t value = 0;
+  for (auto s : state) {
+    while (!queue->TryPush(value)) {
+    }
+    while (!queue->TryPop(&value)) {
+    }
+  }
+  testing::DoNotOptimize(value);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BoundedMpmcQueuePushPop)->ThreadRange(1, 32);
+
+void BM_MutexDequePushPop(::testing::benchmark::State& state) {
+  static mutex mu(LINKER_INITIALIZED);
+  static auto* queue = new std::deque<int64_t>;
+  int64_t value = 0;
+  for (auto s : state) {
+    {
+      mutex_lock l(mu);
+      queue->push_back(value);
+    }
+    {
+      mutex_lock l(mu);
+      value = queue->front();
+      queue->pop_front();
+    }
+  }
+  testing::DoNotOptimize(value);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MutexDequePushPop)->ThreadRange(1, 32);
+
+}  // namespace
+}  // namespace tensorflow
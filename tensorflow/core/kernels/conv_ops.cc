@@ -30,6 +30,7 @@ limitations under the License.
 #include <map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/synchronization/blocking_counter.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -48,9 +49,12 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/padding.h"
 #include "tensorflow/core/util/tensor_format.h"
 #include "tensorflow/core/util/use_cudnn.h"
@@ -373,6 +377,90 @@ class LaunchDeepConvOp {
   }
 };
 
+namespace {
+
+// The implementations of the CPU 3x3 stride 1 convolutions that autotuning
+// picks from.
+enum class CpuConv2DAlgorithm {
+  kSpatialConvolution,  // Eigen spatial convolution, as in LaunchGeneric.
+  kWinograd2x2,         // DeepConv2D with the F(2x2, 3x3) transform.
+  kWinograd4x4,         // DeepConv2D with the F(4x4, 3x3) transform.
+};
+
+// Returns true if the CPU implementation of the 3x3 stride 1 float
+// convolutions is picked per convolution shape by timing all of them the first
+// time the shape is seen. Winograd F(4x4, 3x3) is less precise than the other
+// implementations, so this has to be enabled with TF_CPU_CONV2D_AUTOTUNE.
+bool CpuConv2DAutotuneEnabled() {
+  static const bool enabled = [] {
+    bool enabled = false;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_CPU_CONV2D_AUTOTUNE",
+                                   /*default_val=*/false, &enabled));
+    return enabled;
+  }();
+  return enabled;
+}
+
+// The shape of a 3x3 stride 1 convolution, which is the key of the CPU
+// autotuning results.
+struct CpuConv2DShape {
+  int batch;
+  int input_rows;
+  int input_cols;
+  int in_depth;
+  int out_depth;
+  int pad_rows;
+  int pad_cols;
+  int out_rows;
+  int out_cols;
+
+  bool operator==(const CpuConv2DShape& other) const {
+    return batch == other.batch && input_rows == other.input_rows &&
+           input_cols == other.input_cols && in_depth == other.in_depth &&
+           out_depth == other.out_depth && pad_rows == other.pad_rows &&
+           pad_cols == other.pad_cols && out_rows == other.out_rows &&
+           out_cols == other.out_cols;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const CpuConv2DShape& shape) {
+    return H::combine(std::move(h), shape.batch, shape.input_rows,
+                      shape.input_cols, shape.in_depth, shape.out_depth,
+                      shape.pad_rows, shape.pad_cols, shape.out_rows,
+                      shape.out_cols);
+  }
+};
+
+// The fastest CPU implementation of every convolution shape autotuned so far,
+// shared by all the Conv2D kernels of the process.
+class CpuConv2DAutotuneMap {
+ public:
+  static CpuConv2DAutotuneMap* GetInstance() {
+    static CpuConv2DAutotuneMap* instance = new CpuConv2DAutotuneMap;
+    return instance;
+  }
+
+  bool Find(const CpuConv2DShape& shape, CpuConv2DAlgorithm* algorithm) const {
+    mutex_lock l(mu_);
+    auto it = algorithms_.find(shape);
+    if (it == algorithms_.end()) return false;
+    *algorithm = it->second;
+    return true;
+  }
+
+  void Insert(const CpuConv2DShape& shape, CpuConv2DAlgorithm algorithm) {
+    mutex_lock l(mu_);
+    algorithms_.emplace(shape, algorithm);
+  }
+
+ private:
+  mutable mutex mu_;
+  absl::flat_hash_map<CpuConv2DShape, CpuConv2DAlgorithm> algorithms_
+      TF_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
 // Conditionally launches DeepConv operation based on convolution parameters.
 template <>
 class LaunchDeepConvOp<CPUDevice, float> {
@@ -385,9 +473,37 @@ class LaunchDeepConvOp<CPUDevice, float> {
                   int dilation_cols, int stride_rows, int stride_cols,
                   Tensor* output, TensorFormat data_format) {
     if (data_format != FORMAT_NHWC || dilation_rows != 1 ||
-        dilation_cols != 1 ||
-        !CanUseDeepConv2D(stride_rows, stride_cols, filter_rows, filter_cols,
-                          in_depth, out_depth, out_rows, out_cols)) {
+        dilation_cols != 1) {
+      return false;
+    }
+    DeepConv2DTransformType transform_type =
+        DeepConv2DTransformType::kWinograd2x2;
+    if (CpuConv2DAutotuneEnabled() &&
+        IsDeepConv2DSupported(stride_rows, stride_cols, filter_rows,
+                              filter_cols)) {
+      const CpuConv2DShape shape{batch,    input_rows, input_cols,
+                                 in_depth, out_depth,  pad_rows,
+                                 pad_cols, out_rows,   out_cols};
+      CpuConv2DAlgorithm algorithm;
+      if (!CpuConv2DAutotuneMap::GetInstance()->Find(shape, &algorithm)) {
+        // All the implementations write the whole output, so the output of
+        // the last one timed is returned, whichever is the fastest.
+        algorithm = Autotune(ctx, input, filter, shape, output);
+        CpuConv2DAutotuneMap::GetInstance()->Insert(shape, algorithm);
+        return true;
+      }
+      switch (algorithm) {
+        case CpuConv2DAlgorithm::kSpatialConvolution:
+          return false;
+        case CpuConv2DAlgorithm::kWinograd2x2:
+          break;
+        case CpuConv2DAlgorithm::kWinograd4x4:
+          transform_type = DeepConv2DTransformType::kWinograd4x4;
+          break;
+      }
+    } else if (!CanUseDeepConv2D(stride_rows, stride_cols, filter_rows,
+                                 filter_cols, in_depth, out_depth, out_rows,
+                                 out_cols)) {
       return false;
     }
 
@@ -409,9 +525,77 @@ class LaunchDeepConvOp<CPUDevice, float> {
     auto output_ptr = output->template flat<float>().data();
 
     functor::DeepConv2D<CPUDevice, float>()(ctx, args, input_ptr, filter_ptr,
-                                            output_ptr);
+                                            output_ptr, transform_type);
     return true;
   }
+
+ private:
+  // Runs every implementation of the convolution once into 'output', and
+  // returns the fastest.
+  static CpuConv2DAlgorithm Autotune(OpKernelContext* ctx, const Tensor& input,
+                                     const Tensor& filter,
+                                     const CpuConv2DShape& shape,
+                                     Tensor* output) {
+    Conv2DArgs args;
+    args.batch = shape.batch;
+    args.in_rows = shape.input_rows;
+    args.in_cols = shape.input_cols;
+    args.in_depth = shape.in_depth;
+    args.filter_rows = 3;
+    args.filter_cols = 3;
+    args.pad_rows = shape.pad_rows;
+    args.pad_cols = shape.pad_cols;
+    args.out_rows = shape.out_rows;
+    args.out_cols = shape.out_cols;
+    args.out_depth = shape.out_depth;
+
+    const float* input_ptr = input.flat<float>().data();
+    const float* filter_ptr = filter.flat<float>().data();
+    float* output_ptr = output->flat<float>().data();
+    // The padding after the image, which makes the output of a stride 1
+    // convolution as large as 'out_rows' x 'out_cols'.
+    const int pad_bottom =
+        shape.out_rows + 2 - shape.input_rows - shape.pad_rows;
+    const int pad_right =
+        shape.out_cols + 2 - shape.input_cols - shape.pad_cols;
+
+    Env* env = Env::Default();
+    uint64 best_micros = std::numeric_limits<uint64>::max();
+    CpuConv2DAlgorithm best = CpuConv2DAlgorithm::kSpatialConvolution;
+    for (CpuConv2DAlgorithm algorithm :
+         {CpuConv2DAlgorithm::kWinograd4x4, CpuConv2DAlgorithm::kWinograd2x2,
+          CpuConv2DAlgorithm::kSpatialConvolution}) {
+      const uint64 start_micros = env->NowMicros();
+      switch (algorithm) {
+        case CpuConv2DAlgorithm::kSpatialConvolution:
+          functor::SpatialConvolution<CPUDevice, float>()(
+              ctx->eigen_device<CPUDevice>(), output->tensor<float, 4>(),
+              input.tensor<float, 4>(), filter.tensor<float, 4>(),
+              /*row_stride=*/1, /*col_stride=*/1, /*row_dilation=*/1,
+              /*col_dilation=*/1, shape.pad_rows, pad_bottom, shape.pad_cols,
+              pad_right);
+          break;
+        case CpuConv2DAlgorithm::kWinograd2x2:
+          functor::DeepConv2D<CPUDevice, float>()(
+              ctx, args, input_ptr, filter_ptr, output_ptr,
+              DeepConv2DTransformType::kWinograd2x2);
+          break;
+        case CpuConv2DAlgorithm::kWinograd4x4:
+          functor::DeepConv2D<CPUDevice, float>()(
+              ctx, args, input_ptr, filter_ptr, output_ptr,
+              DeepConv2DTransformType::kWinograd4x4);
+          break;
+      }
+      const uint64 micros = env->NowMicros() - start_micros;
+      VLOG(1) << "Conv2D autotuning: algorithm "
+              << static_cast<int>(algorithm) << " took " << micros << "us";
+      if (micros < best_micros) {
+        best_micros = micros;
+        best = algorithm;
+      }
+    }
+    return best;
+  }
 };
 
 #ifdef TENSORFLOW_USE_LIBXSMM_CONVOLUTIONS
@@ -0,0 +1,172 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/csv_tokenizer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/platform/byte_order.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr uint64 kOnes = 0x0101010101010101ULL;
+constexpr uint64 kHighBits = 0x8080808080808080ULL;
+
+// Returns the bytes of `word` equal to those of `pattern`, as their high bits.
+// Bytes above a matching byte may be reported too, but the lowest reported
+// byte always matches.
+inline uint64 MatchingBytes(uint64 word, uint64 pattern) {
+  const uint64 v = word ^ pattern;
+  return (v - kOnes) & ~v & kHighBits;
+}
+
+inline bool IsCsvSpecialChar(char c, char delim, bool use_quote_delim) {
+  return c == delim || c == '\n' || c == '\r' || (use_quote_delim && c == '"');
+}
+
+}  // namespace
+
+const char* FindCsvSpecialChar(const char* begin, const char* end, char delim,
+                               bool use_quote_delim) {
+  const char* p = begin;
+  if (port::kLittleEndian) {
+    const uint64 delims = kOnes * static_cast<uint8>(delim);
+    const uint64 quotes =
+        use_quote_delim ? kOnes * static_cast<uint8>('"') : delims;
+    const uint64 newlines = kOnes * static_cast<uint8>('\n');
+    const uint64 returns = kOnes * static_cast<uint8>('\r');
+    for (; end - p >= 8; p += 8) {
+      uint64 word;
+      memcpy(&word, p, sizeof(word));
+      const uint64 found =
+          MatchingBytes(word, delims) | MatchingBytes(word, quotes) |
+          MatchingBytes(word, newlines) | MatchingBytes(word, returns);
+      if (found != 0) {
+        return p + Log2Floor64(found & (~found + 1)) / 8;
+      }
+    }
+  }
+  for (; p < end; ++p) {
+    if (IsCsvSpecialChar(*p, delim, use_quote_delim)) {
+      return p;
+    }
+  }
+  return end;
+}
+
+void AppendCsvField(const CsvField& field, std::string* result) {
+  if (!field.escaped) {
+    result->append(field.value.data(), field.value.size());
+    return;
+  }
+  StringPiece value = field.value;
+  size_t quote;
+  while ((quote = value.find('"')) != StringPiece::npos) {
+    // Keeps the first quote of the pair.
+    result->append(value.data(), quote + 1);
+    value.remove_prefix(std::min(quote + 2, value.size()));
+  }
+  result->append(value.data(), value.size());
+}
+
+Status SplitCsvRecord(StringPiece record, char delim, bool use_quote_delim,
+                      const std::vector<int64_t>& select_cols,
+                      std::vector<CsvField>* fields) {
+  fields->clear();
+  if (record.empty()) {
+    return Status::OK();
+  }
+  const bool select_all_cols = select_cols.empty();
+  const char* const data = record.data();
+  const size_t size = record.size();
+  size_t current_idx = 0;
+  int64_t num_fields_parsed = 0;
+  size_t selector_idx = 0;  // Keep track of index into select_cols
+  while (current_idx < size) {
+    if (data[current_idx] == '\n' || data[current_idx] == '\r') {
+      current_idx++;
+      continue;
+    }
+
+    const bool include =
+        select_all_cols || select_cols[selector_idx] == num_fields_parsed;
+    CsvField field;
+    if (use_quote_delim && data[current_idx] == '"') {
+      const size_t start = ++current_idx;
+      // Quoted field needs to be ended with '"' and delim or end
+      while (current_idx < size - 1) {
+        const void* quote =
+            memchr(data + current_idx, '"', size - 1 - current_idx);
+        if (quote == nullptr) {
+          current_idx = size - 1;
+          break;
+        }
+        current_idx = static_cast<const char*>(quote) - data;
+        if (data[current_idx + 1] == delim) {
+          break;
+        }
+        if (data[current_idx + 1] != '"') {
+          return errors::InvalidArgument(
+              "Quote inside a string has to be escaped by another quote");
+        }
+        field.escaped = true;
+        current_idx += 2;
+      }
+      if (current_idx >= size || data[current_idx] != '"' ||
+          (current_idx != size - 1 && data[current_idx + 1] != delim)) {
+        return errors::InvalidArgument(
+            "Quoted field has to end with quote followed by delim or end");
+      }
+      field.value = StringPiece(data + start, current_idx - start);
+      current_idx += 2;
+    } else {
+      const size_t start = current_idx;
+      current_idx =
+          FindCsvSpecialChar(data + current_idx, data + size, delim,
+                             use_quote_delim) -
+          data;
+      if (current_idx < size && data[current_idx] != delim) {
+        return errors::InvalidArgument(
+            "Unquoted fields cannot have quotes/CRLFs inside");
+      }
+      field.value = StringPiece(data + start, current_idx - start);
+      // Go to next field or the end
+      current_idx++;
+    }
+
+    num_fields_parsed++;
+    if (include) {
+      fields->push_back(field);
+      selector_idx++;
+      if (selector_idx == select_cols.size()) {
+        return Status::OK();
+      }
+    }
+  }
+
+  const bool include =
+      select_all_cols || select_cols[selector_idx] == num_fields_parsed;
+  // Check if the last field is missing
+  if (include && data[size - 1] == delim) {
+    fields->push_back(CsvField());
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
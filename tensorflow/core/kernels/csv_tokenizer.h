@@ -0,0 +1,53 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_CSV_TOKENIZER_H_
+#define TENSORFLOW_CORE_KERNELS_CSV_TOKENIZER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/stringpiece.h"
+
+namespace tensorflow {
+
+// Returns the first character in [begin, end) which is `delim`, '\n', '\r' or,
+// if `use_quote_delim`, '"', or `end` if there is none. Compares 8 characters
+// at a time, so that fields are scanned without looking at each character.
+const char* FindCsvSpecialChar(const char* begin, const char* end, char delim,
+                               bool use_quote_delim);
+
+// A field of a CSV record.
+struct CsvField {
+  // The field, without its framing quotes if it is quoted.
+  StringPiece value;
+  // Whether `value` contains escaped quotes, which are '""' for '"'.
+  bool escaped = false;
+};
+
+// Appends `field` to `result`, unescaping its quotes if needed.
+void AppendCsvField(const CsvField& field, std::string* result);
+
+// Splits a CSV record into its fields, as in DecodeCSV. If `select_cols` is
+// not empty, only returns the fields at these strictly increasing indices.
+// The fields point into `record`.
+Status SplitCsvRecord(StringPiece record, char delim, bool use_quote_delim,
+                      const std::vector<int64_t>& select_cols,
+                      std::vector<CsvField>* fields);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_CSV_TOKENIZER_H_
@@ -0,0 +1,97 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/csv_tokenizer.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Splits `record` and returns its unescaped fields.
+std::vector<std::string> Split(StringPiece record,
+                               const std::vector<int64_t>& select_cols = {},
+                               bool use_quote_delim = true) {
+  std::vector<CsvField> fields;
+  TF_CHECK_OK(
+      SplitCsvRecord(record, ',', use_quote_delim, select_cols, &fields));
+  std::vector<std::string> result;
+  for (const CsvField& field : fields) {
+    result.emplace_back();
+    AppendCsvField(field, &result.back());
+  }
+  return result;
+}
+
+TEST(CsvTokenizerTest, FindCsvSpecialChar) {
+  const std::string s = "0123456789abcdef,0123456789\"\n";
+  const char* end = s.data() + s.size();
+  EXPECT_EQ(FindCsvSpecialChar(s.data(), end, ',', true), s.data() + 16);
+  EXPECT_EQ(FindCsvSpecialChar(s.data() + 17, end, ',', true),
+            s.data() + 27);
+  EXPECT_EQ(FindCsvSpecialChar(s.data() + 17, end, ',', false),
+            s.data() + 28);
+  EXPECT_EQ(FindCsvSpecialChar(s.data(), s.data() + 16, ',', true),
+            s.data() + 16);
+  for (size_t i = 0; i <= 16; ++i) {
+    EXPECT_EQ(FindCsvSpecialChar(s.data() + i, end, ',', true),
+              s.data() + 16);
+  }
+}
+
+TEST(CsvTokenizerTest, SplitsFields) {
+  EXPECT_EQ(Split("a,bc,,d"),
+            (std::vector<std::string>{"a", "bc", "", "d"}));
+  EXPECT_EQ(Split("a,"), (std::vector<std::string>{"a", ""}));
+  EXPECT_EQ(Split(""), std::vector<std::string>{});
+  // Line breaks before a field are skipped.
+  EXPECT_EQ(Split("\r\na,\nb"), (std::vector<std::string>{"a", "b"}));
+}
+
+TEST(CsvTokenizerTest, SplitsQuotedFields) {
+  EXPECT_EQ(Split("\"a,b\",\"c\"\"d\",\"\""),
+            (std::vector<std::string>{"a,b", "c\"d", ""}));
+  std::vector<CsvField> fields;
+  TF_ASSERT_OK(SplitCsvRecord("\"a\"\"\",\"b\"", ',', true, {}, &fields));
+  ASSERT_EQ(fields.size(), 2);
+  EXPECT_TRUE(fields[0].escaped);
+  EXPECT_EQ(fields[0].value, "a\"\"");
+  EXPECT_FALSE(fields[1].escaped);
+  EXPECT_EQ(fields[1].value, "b");
+  // Without quote delimiters, quotes are part of the fields.
+  EXPECT_EQ(Split("\"a\",b", {}, /*use_quote_delim=*/false),
+            (std::vector<std::string>{"\"a\"", "b"}));
+}
+
+TEST(CsvTokenizerTest, SelectsColumns) {
+  EXPECT_EQ(Split("a,\"b\",c,d", {1, 3}),
+            (std::vector<std::string>{"b", "d"}));
+  EXPECT_EQ(Split("a,b,", {2}), std::vector<std::string>{""});
+}
+
+TEST(CsvTokenizerTest, RejectsInvalidRecords) {
+  std::vector<CsvField> fields;
+  for (StringPiece record : {"a\"b,c", "\"a\"b,c", "\"ab", "a\nb"}) {
+    Status s = SplitCsvRecord(record, ',', true, {}, &fields);
+    EXPECT_TRUE(errors::IsInvalidArgument(s)) << record << ": " << s;
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
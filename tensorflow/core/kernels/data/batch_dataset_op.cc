@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/stringprintf.h"
@@ -43,6 +44,9 @@ namespace data {
 /* static */ constexpr const char* const BatchDatasetOp::kOutputShapes;
 
 constexpr char kInputImplEmpty[] = "input_impl_empty";
+// The maximum number of rows a batch is pre-allocated for by iterators without
+// `parallel_copy`.
+constexpr int64_t kMaxPreallocatedRows = 1 << 16;
 constexpr char kBatchDataset[] = "BatchDataset";
 
 class BatchDatasetOp::Dataset : public DatasetBase {
@@ -179,6 +183,9 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
+      if (!dataset()->parallel_copy_) {
+        return GetNextInPlace(ctx, out_tensors, end_of_sequence);
+      }
       // Each row of `batch_elements` is a tuple of tensors from the
       // input iterator.
       std::vector<std::vector<Tensor>> batch_elements;
@@ -237,6 +244,7 @@ class BatchDatasetOp::Dataset : public DatasetBase {
 
     Status SaveInternal(SerializationContext* ctx,
                         IteratorStateWriter* writer) override {
+      mutex_lock batch_lock(batch_mu_);
       mutex_lock l(mu_);
       if (!input_impl_) {
         TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kInputImplEmpty), ""));
@@ -248,6 +256,7 @@ class BatchDatasetOp::Dataset : public DatasetBase {
 
     Status RestoreInternal(IteratorContext* ctx,
                            IteratorStateReader* reader) override {
+      mutex_lock batch_lock(batch_mu_);
       mutex_lock l(mu_);
       if (!reader->Contains(full_name(kInputImplEmpty))) {
         TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
@@ -262,6 +271,164 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     }
 
    private:
+    // Copies every input element into the pre-allocated batch as soon as it is
+    // produced, instead of buffering the elements of the batch and copying
+    // them once the batch is complete. Each element is released before the
+    // next one is produced, so the elements and the batch are not held in
+    // memory at the same time, and each element is copied while it is likely
+    // still in cache.
+    //
+    // `mu_` is only held while an element is read, not while it is copied.
+    // `batch_mu_` keeps the elements of a batch consecutive, and keeps
+    // checkpoints from splitting a batch.
+    //
+    // Like `reserve_size_`, the batch is pre-allocated for at most 2**16
+    // rows, so that a very large `batch_size` over a short dataset doesn't
+    // allocate a batch of `batch_size` rows, and it grows geometrically past
+    // that. As in CopyBatch(), a shape mismatch is reported once the whole
+    // batch has been read.
+    Status GetNextInPlace(IteratorContext* ctx,
+                          std::vector<Tensor>* out_tensors,
+                          bool* end_of_sequence)
+        TF_LOCKS_EXCLUDED(batch_mu_, mu_) {
+      mutex_lock batch_lock(batch_mu_);
+      std::vector<Tensor> batch;
+      std::vector<TensorShape> first_element_shapes;
+      int64_t num_rows = 0;
+      int64_t num_elements = 0;
+      Status shape_status;
+      *end_of_sequence = false;
+      while (num_elements < dataset()->batch_size_) {
+        std::vector<Tensor> element;
+        {
+          mutex_lock l(mu_);
+          if (!input_impl_) {
+            *end_of_sequence = true;
+            break;
+          }
+          TF_RETURN_IF_ERROR(
+              input_impl_->GetNext(ctx, &element, end_of_sequence));
+          if (*end_of_sequence) {
+            input_impl_.reset();
+            break;
+          }
+        }
+        if (num_elements == 0) {
+          if (element.empty()) {
+            return errors::InvalidArgument(
+                "Cannot batch elements with no components.");
+          }
+          for (const Tensor& component : element) {
+            first_element_shapes.push_back(component.shape());
+          }
+          num_rows =
+              std::min<int64_t>(dataset()->batch_size_, kMaxPreallocatedRows);
+          TF_RETURN_IF_ERROR(AllocateBatch(ctx, first_element_shapes, element,
+                                           num_rows, /*num_elements=*/0,
+                                           &batch));
+        }
+        if (shape_status.ok()) {
+          shape_status =
+              CheckShapes(first_element_shapes, element, num_elements);
+        }
+        if (shape_status.ok()) {
+          if (num_elements == num_rows) {
+            num_rows = std::min(dataset()->batch_size_, 2 * num_elements);
+            TF_RETURN_IF_ERROR(AllocateBatch(ctx, first_element_shapes,
+                                             element, num_rows, num_elements,
+                                             &batch));
+          }
+          for (size_t i = 0; i < element.size(); ++i) {
+            TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+                std::move(element[i]), &batch[i], num_elements));
+          }
+        }
+        ++num_elements;
+      }
+
+      if (num_elements == 0) {
+        DCHECK(*end_of_sequence);
+        return Status::OK();
+      }
+      if (dataset()->drop_remainder_ &&
+          num_elements < dataset()->batch_size_) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(shape_status);
+      if (num_elements < num_rows) {
+        // The last batch is smaller than the pre-allocated one. It is copied
+        // into a batch of its size, unless it fills at least half of it, in
+        // which case a slice is returned without copying it.
+        if (2 * num_elements >= num_rows) {
+          for (Tensor& component : batch) {
+            component = component.Slice(0, num_elements);
+          }
+        } else {
+          TF_RETURN_IF_ERROR(AllocateBatch(ctx, first_element_shapes, batch,
+                                           num_elements, num_elements,
+                                           &batch));
+        }
+      }
+      *out_tensors = std::move(batch);
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+
+    // Returns an error if the number of components or the shapes of
+    // `element`, the index_th element of the batch, differ from those of the
+    // first element.
+    static Status CheckShapes(
+        const std::vector<TensorShape>& first_element_shapes,
+        const std::vector<Tensor>& element, int64_t index) {
+      if (element.size() != first_element_shapes.size()) {
+        return errors::InvalidArgument(
+            "Cannot batch elements with different numbers of components. "
+            "First element had ",
+            first_element_shapes.size(), " components and element ", index,
+            " had ", element.size(), " components.");
+      }
+      for (size_t i = 0; i < element.size(); ++i) {
+        if (element[i].shape() != first_element_shapes[i]) {
+          return errors::InvalidArgument(
+              "Cannot batch tensors with different shapes in component ", i,
+              ". First element had shape ",
+              first_element_shapes[i].DebugString(), " and element ", index,
+              " had shape ", element[i].shape().DebugString(), ".");
+        }
+      }
+      return Status::OK();
+    }
+
+    // Replaces `batch` with one tensor of `num_rows` rows of `element_shapes`
+    // per component of `element`, holding the first `num_elements` rows of
+    // `batch`.
+    Status AllocateBatch(IteratorContext* ctx,
+                         const std::vector<TensorShape>& element_shapes,
+                         const std::vector<Tensor>& element, int64_t num_rows,
+                         int64_t num_elements, std::vector<Tensor>* batch) {
+      std::vector<Tensor> new_batch;
+      new_batch.reserve(element.size());
+      for (size_t i = 0; i < element.size(); ++i) {
+        TensorShape batch_shape({num_rows});
+        batch_shape.AppendShape(element_shapes[i]);
+        new_batch.emplace_back(ctx->allocator({}), element[i].dtype(),
+                               batch_shape);
+        if (!new_batch.back().IsInitialized()) {
+          return errors::ResourceExhausted(
+              "Failed to allocate memory for the batch of component ", i);
+        }
+        if (num_elements > 0) {
+          TF_RETURN_IF_ERROR(batch_util::CopyContiguousSlices(
+              (*batch)[i], 0, 0, num_elements, &new_batch.back()));
+        }
+      }
+      *batch = std::move(new_batch);
+      return Status::OK();
+    }
+
+    // Held for the whole of GetNextInPlace(), and by Save and Restore.
+    mutex batch_mu_ TF_ACQUIRED_BEFORE(mu_);
     mutex mu_;
     std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
   };
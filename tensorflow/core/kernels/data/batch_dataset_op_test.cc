@@ -11,6 +11,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/batch_dataset_op.h"
 
+#include <limits>
+
 #include "tensorflow/core/data/dataset_test_base.h"
 
 namespace tensorflow {
@@ -105,7 +107,59 @@ BatchDatasetParams BatchDatasetParams7() {
                             /*node_name=*/kNodeName);
 }
 
-// Test Case 8: test BatchDatasetV2 with an invalid batch size
+// Test Case 8: test BatchDatasetV2 without `parallel_copy`, with
+// `drop_remainder` = false and a last batch that fills at least half of the
+// pre-allocated batch.
+BatchDatasetParams BatchDatasetParams8() {
+  return BatchDatasetParams(RangeDatasetParams(0, 10, 1),
+                            /*batch_size=*/4,
+                            /*drop_remainder=*/false,
+                            /*parallel_copy=*/false,
+                            /*output_dtypes=*/{DT_INT64},
+                            /*output_shapes=*/{PartialTensorShape({-1})},
+                            /*node_name=*/kNodeName);
+}
+
+// Test Case 9: test BatchDatasetV2 without `parallel_copy`, with
+// `drop_remainder` = false and a last batch that fills less than half of the
+// pre-allocated batch.
+BatchDatasetParams BatchDatasetParams9() {
+  return BatchDatasetParams(RangeDatasetParams(0, 10, 1),
+                            /*batch_size=*/8,
+                            /*drop_remainder=*/false,
+                            /*parallel_copy=*/false,
+                            /*output_dtypes=*/{DT_INT64},
+                            /*output_shapes=*/{PartialTensorShape({-1})},
+                            /*node_name=*/kNodeName);
+}
+
+// Test Case 10: test BatchDatasetV2 without `parallel_copy`, with
+// `drop_remainder` = true and a batch size that can not evenly split the input
+// dataset.
+BatchDatasetParams BatchDatasetParams10() {
+  return BatchDatasetParams(RangeDatasetParams(0, 10, 1),
+                            /*batch_size=*/4,
+                            /*drop_remainder=*/true,
+                            /*parallel_copy=*/false,
+                            /*output_dtypes=*/{DT_INT64},
+                            /*output_shapes=*/{PartialTensorShape({4})},
+                            /*node_name=*/kNodeName);
+}
+
+// Test Case 11: test BatchDatasetV2 without `parallel_copy`, with
+// a huge batch size, which must not be allocated.
+BatchDatasetParams HugeBatchSizeBatchDatasetParams(bool drop_remainder) {
+  return BatchDatasetParams(
+      RangeDatasetParams(0, 10, 1),
+      /*batch_size=*/std::numeric_limits<int64_t>::max(),
+      /*drop_remainder=*/drop_remainder,
+      /*parallel_copy=*/false,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+// Test Case 12: test BatchDatasetV2 with an invalid batch size
 BatchDatasetParams InvalidBatchSizeBatchDatasetParams() {
   return BatchDatasetParams(RangeDatasetParams(0, 10, 1),
                             /*batch_size=*/-1,
@@ -143,6 +197,27 @@ std::vector<GetNextTestCase<BatchDatasetParams>> GetNextTestCases() {
                                   {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}})},
 
           {/*dataset_params=*/BatchDatasetParams7(),
+           /*expected_outputs=*/{}},
+          {/*dataset_params=*/BatchDatasetParams8(),
+           /*expected_outputs=*/
+           {CreateTensor<int64_t>(TensorShape({4}), {0, 1, 2, 3}),
+            CreateTensor<int64_t>(TensorShape({4}), {4, 5, 6, 7}),
+            CreateTensor<int64_t>(TensorShape({2}), {8, 9})}},
+          {/*dataset_params=*/BatchDatasetParams9(),
+           /*expected_outputs=*/
+           {CreateTensor<int64_t>(TensorShape({8}), {0, 1, 2, 3, 4, 5, 6, 7}),
+            CreateTensor<int64_t>(TensorShape({2}), {8, 9})}},
+          {/*dataset_params=*/BatchDatasetParams10(),
+           /*expected_outputs=*/
+           CreateTensors<int64_t>(TensorShape({4}),
+                                  {{0, 1, 2, 3}, {4, 5, 6, 7}})},
+          {/*dataset_params=*/HugeBatchSizeBatchDatasetParams(
+               /*drop_remainder=*/false),
+           /*expected_outputs=*/
+           CreateTensors<int64_t>(TensorShape({10}),
+                                  {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}})},
+          {/*dataset_params=*/HugeBatchSizeBatchDatasetParams(
+               /*drop_remainder=*/true),
            /*expected_outputs=*/{}}};
 }
 
@@ -283,6 +358,79 @@ IteratorSaveAndRestoreTestCases() {
 ITERATOR_SAVE_AND_RESTORE_TEST_P(BatchDatasetOpTest, BatchDatasetParams,
                                  IteratorSaveAndRestoreTestCases())
 
+// Without `parallel_copy`, a batch that has elements of different shapes is
+// read entirely before the mismatch is reported, as with `parallel_copy`.
+TEST_F(BatchDatasetOpTest, DifferentShapesWithoutParallelCopy) {
+  auto tensor_slice_dataset_params_0 = TensorSliceDatasetParams(
+      /*components=*/CreateTensors<int64_t>(TensorShape{3, 2},
+                                            {{0, 1, 2, 3, 4, 5}}),
+      /*node_name=*/"tensor_slice_0");
+  auto tensor_slice_dataset_params_1 = TensorSliceDatasetParams(
+      /*components=*/CreateTensors<int64_t>(TensorShape{4, 1}, {{6, 7, 8, 9}}),
+      /*node_name=*/"tensor_slice_1");
+  auto concatenate_dataset_params =
+      ConcatenateDatasetParams(std::move(tensor_slice_dataset_params_0),
+                               std::move(tensor_slice_dataset_params_1),
+                               /*output_dtypes=*/{DT_INT64},
+                               /*output_shapes=*/{PartialTensorShape({-1})},
+                               /*node_name=*/"concatenate");
+  auto batch_dataset_params =
+      BatchDatasetParams(concatenate_dataset_params,
+                         /*batch_size=*/4,
+                         /*drop_remainder=*/false,
+                         /*parallel_copy=*/false,
+                         /*output_dtypes=*/{DT_INT64},
+                         /*output_shapes=*/{PartialTensorShape({-1, -1})},
+                         /*node_name=*/kNodeName);
+  TF_ASSERT_OK(Initialize(batch_dataset_params));
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  EXPECT_EQ(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence)
+          .code(),
+      tensorflow::error::INVALID_ARGUMENT);
+  out_tensors.clear();
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  ASSERT_FALSE(end_of_sequence);
+  TF_EXPECT_OK(ExpectEqual(
+      out_tensors, CreateTensors<int64_t>(TensorShape({3, 1}), {{7, 8, 9}}),
+      /*compare_order=*/true));
+  out_tensors.clear();
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+}
+
+// Without `parallel_copy`, a batch of more rows than are pre-allocated grows.
+TEST_F(BatchDatasetOpTest, BatchLargerThanPreallocatedWithoutParallelCopy) {
+  constexpr int64_t kNumElements = (1 << 16) + 100;
+  auto batch_dataset_params =
+      BatchDatasetParams(RangeDatasetParams(0, kNumElements, 1),
+                         /*batch_size=*/1 << 17,
+                         /*drop_remainder=*/false,
+                         /*parallel_copy=*/false,
+                         /*output_dtypes=*/{DT_INT64},
+                         /*output_shapes=*/{PartialTensorShape({-1})},
+                         /*node_name=*/kNodeName);
+  TF_ASSERT_OK(Initialize(batch_dataset_params));
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  ASSERT_FALSE(end_of_sequence);
+  ASSERT_EQ(out_tensors.size(), 1);
+  ASSERT_EQ(out_tensors[0].shape(), TensorShape({kNumElements}));
+  const auto values = out_tensors[0].vec<int64_t>();
+  for (int64_t i = 0; i < kNumElements; ++i) {
+    ASSERT_EQ(values(i), i);
+  }
+  out_tensors.clear();
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+}
+
 TEST_F(BatchDatasetOpTest, InvalidBatchSize) {
   auto batch_dataset_params = InvalidBatchSizeBatchDatasetParams();
   EXPECT_EQ(Initialize(batch_dataset_params).code(),
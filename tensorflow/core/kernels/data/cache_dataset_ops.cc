@@ -14,20 +14,27 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/cache_dataset_ops.h"
 
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/serialization_utils.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/cache_ops.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/protobuf/tensor_bundle.pb.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
@@ -65,6 +72,60 @@ constexpr char kIncompleteCacheErrorMessage[] =
     "contents of the dataset  will be discarded. This can happen if you have "
     "an input pipeline similar to `dataset.cache().take(k).repeat()`. You "
     "should use `dataset.take(k).cache().repeat()` instead.";
+constexpr char kMappedFileCacheAllocatorName[] = "mapped_file_cache";
+
+// Returns the options of the `BundleWriter`s of file caches. Tensor data is
+// aligned so that it can be used in place when the cache is memory-mapped.
+BundleWriter::Options CacheWriterOptions() {
+  BundleWriter::Options options;
+  options.data_alignment = Allocator::kAllocatorAlignment;
+  return options;
+}
+
+// Returns whether file caches are read by memory-mapping their data files,
+// which can be disabled by setting TF_DATA_MMAP_FILE_CACHE to false.
+bool UseMemoryMappedFileCache() {
+  static const bool use_mmap = [] {
+    bool value;
+    Status s = ReadBoolFromEnvVar("TF_DATA_MMAP_FILE_CACHE",
+                                  /*default_val=*/true, &value);
+    if (!s.ok()) {
+      LOG(WARNING) << s;
+      return true;
+    }
+    return value;
+  }();
+  return use_mmap;
+}
+
+// The buffer of a tensor whose data lives in a memory-mapped cache file. The
+// mapped pages are read-only, so the buffer is never forwarded to the outputs
+// of ops.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const void* data, size_t size)
+      : TensorBuffer(const_cast<void*>(data)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+
+  TensorBuffer* root_buffer() override { return this; }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(static_cast<int64_t>(size_));
+    proto->set_allocator_name(kMappedFileCacheAllocatorName);
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  // Keeps the file mapped for as long as the tensor is alive.
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
 
 }  // namespace
 
@@ -375,7 +436,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         }
         filename_ = strings::StrCat(dataset()->filename_, "_", shard_id_);
         lockfile_ = strings::StrCat(filename_, kLockFileSuffix);
-        writer_ = absl::make_unique<BundleWriter>(dataset()->env_, filename_);
+        writer_ = absl::make_unique<BundleWriter>(dataset()->env_, filename_,
+                                                  CacheWriterOptions());
         return Status::OK();
       }
 
@@ -437,7 +499,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         // conditions are not met since BundleWriter's constructor creates
         // new temp files which can delete the temp files created by a
         // BundleWriter in another Session.
-        writer_ = absl::make_unique<BundleWriter>(dataset()->env_, filename_);
+        writer_ = absl::make_unique<BundleWriter>(dataset()->env_, filename_,
+                                                  CacheWriterOptions());
         lockfile_created_ = true;
         return Status::OK();
       }
@@ -492,7 +555,9 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
           : DatasetIterator<FileDatasetBase>(params),
             cur_index_(0),
             reader_(dataset()->env_, dataset()->filename_),
-            iterator_restored_(false) {}
+            iterator_restored_(false) {
+        InitializeMapping();
+      }
 
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
@@ -523,7 +588,7 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
           }
           StringPiece key = reader_.key();
           DCHECK_EQ(key, dataset()->FormatName(cur_index_, i));
-          TF_RETURN_IF_ERROR(reader_.ReadCurrent(&(*out_tensors)[i]));
+          TF_RETURN_IF_ERROR(ReadCurrent(&(*out_tensors)[i]));
           TF_RETURN_IF_ERROR(reader_.status());
         }
         cur_index_++;
@@ -569,10 +634,118 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       }
 
      private:
+      // Prepares reading the tensors of the cache in place from its
+      // memory-mapped data files, unless the byte order of the cache differs
+      // from the one of this host.
+      void InitializeMapping() TF_NO_THREAD_SAFETY_ANALYSIS {
+        use_mmap_ = false;
+        if (!UseMemoryMappedFileCache() || !reader_.status().ok() ||
+            !reader_.Valid() || reader_.key() != kHeaderEntryKey) {
+          return;
+        }
+        BundleHeaderProto header;
+        if (!header.ParseFromArray(reader_.value().data(),
+                                   reader_.value().size())) {
+          return;
+        }
+        if ((header.endianness() == BundleHeaderProto::LITTLE) !=
+            port::kLittleEndian) {
+          return;
+        }
+        regions_.resize(header.num_shards());
+        use_mmap_ = true;
+      }
+
+      // Reads the tensor at the current position of `reader_`. Tensors of
+      // types that can be memcpy-ed are created over the memory-mapped data
+      // file when their data is suitably aligned, which is the case for
+      // caches written with `CacheWriterOptions()`; other tensors are
+      // deserialized. As with `BundleReader::ReadCurrent()`, the checksum of
+      // every tensor read is verified.
+      Status ReadCurrent(Tensor* val) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (use_mmap_) {
+          bool mapped = false;
+          TF_RETURN_IF_ERROR(ReadCurrentMapped(val, &mapped));
+          if (mapped) return Status::OK();
+        }
+        return reader_.ReadCurrent(val);
+      }
+
+      Status ReadCurrentMapped(Tensor* val, bool* mapped)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        BundleEntryProto entry;
+        if (!entry.ParseFromArray(reader_.value().data(),
+                                  reader_.value().size())) {
+          return errors::DataLoss("Unable to parse the cache entry of ",
+                                  reader_.key(), " in ", dataset()->filename_);
+        }
+        if (!DataTypeCanUseMemcpy(entry.dtype()) || entry.slices_size() > 0 ||
+            entry.shard_id() < 0 ||
+            static_cast<size_t>(entry.shard_id()) >= regions_.size()) {
+          return Status::OK();
+        }
+        TensorShape shape;
+        TF_RETURN_IF_ERROR(
+            TensorShape::BuildTensorShape(entry.shape(), &shape));
+        const uint64 num_bytes =
+            shape.num_elements() * DataTypeSize(entry.dtype());
+        if (num_bytes == 0 || entry.size() != num_bytes) {
+          return Status::OK();
+        }
+
+        std::shared_ptr<ReadOnlyMemoryRegion>& region =
+            regions_[entry.shard_id()];
+        if (!region) {
+          const string data_filename = DataFilename(
+              dataset()->filename_, entry.shard_id(), regions_.size());
+          std::unique_ptr<ReadOnlyMemoryRegion> new_region;
+          Status s = dataset()->env_->NewReadOnlyMemoryRegionFromFile(
+              data_filename, &new_region);
+          if (!s.ok()) {
+            VLOG(1) << "Reading the cache without memory-mapping "
+                    << data_filename << ": " << s;
+            use_mmap_ = false;
+            return Status::OK();
+          }
+          region = std::move(new_region);
+        }
+        if (entry.offset() < 0 ||
+            entry.offset() + num_bytes > region->length()) {
+          return errors::DataLoss("Cache entry of ", reader_.key(),
+                                  " is out of the bounds of its data file");
+        }
+
+        const char* data =
+            static_cast<const char*>(region->data()) + entry.offset();
+        auto* buf = new MappedTensorBuffer(region, data, num_bytes);
+        Tensor tensor(entry.dtype(), shape, buf);
+        buf->Unref();
+        if (!tensor.IsAligned()) {
+          // The cache was written without aligning the tensor data.
+          return Status::OK();
+        }
+        const uint32 actual_crc32c = crc32c::Value(data, num_bytes);
+        if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+          return errors::DataLoss(
+              "Cache entry of ", reader_.key(), " in ", dataset()->filename_,
+              " (", num_bytes, " bytes): Checksum does not match: stored ",
+              crc32c::Unmask(entry.crc32c()), " vs. calculated on the ",
+              "mapped bytes ", actual_crc32c);
+        }
+        *val = std::move(tensor);
+        *mapped = true;
+        return Status::OK();
+      }
+
       mutex mu_;
       size_t cur_index_ TF_GUARDED_BY(mu_);
       BundleReader reader_ TF_GUARDED_BY(mu_);
       bool iterator_restored_ TF_GUARDED_BY(mu_);
+      // Whether tensors are read from the memory-mapped data files.
+      bool use_mmap_ TF_GUARDED_BY(mu_);
+      // The mapped data files, indexed by shard id and mapped on first use.
+      std::vector<std::shared_ptr<ReadOnlyMemoryRegion>> regions_
+          TF_GUARDED_BY(mu_);
     };  // FileReaderIterator
 
     Status InitializeIterator(IteratorContext* ctx)
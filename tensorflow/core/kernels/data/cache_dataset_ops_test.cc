@@ -17,6 +17,8 @@ limitations under the License.
 #include "tensorflow/core/data/dataset_test_base.h"
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/serialization_utils.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/path.h"
 
 namespace tensorflow {
@@ -204,6 +206,75 @@ TEST_P(ParameterizedGetNextTest, GetNext) {
 INSTANTIATE_TEST_SUITE_P(CacheDatasetOpTest, ParameterizedGetNextTest,
                          ::testing::ValuesIn(GetNextTestCases()));
 
+TEST_F(CacheDatasetOpTest, FileCacheIsReadInPlace) {
+  auto dataset_params = CacheDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+  }
+
+  // The tensors read from the cache refer to its memory-mapped data file.
+  TF_ASSERT_OK(dataset_->MakeIterator(iterator_ctx_.get(), /*parent=*/nullptr,
+                                      dataset_params.iterator_prefix(),
+                                      &iterator_));
+  std::vector<Tensor> out_tensors;
+  end_of_sequence = false;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+  }
+  ASSERT_EQ(out_tensors.size(), 3);
+  for (const Tensor& t : out_tensors) {
+    TensorDescription description;
+    t.FillDescription(&description);
+    EXPECT_EQ(description.allocation_description().allocator_name(),
+              "mapped_file_cache");
+  }
+  // The tensors stay valid after the iterator is destroyed.
+  iterator_.reset();
+  TF_EXPECT_OK(ExpectEqual(
+      out_tensors,
+      CreateTensors<int64_t>(TensorShape({3, 1}),
+                             {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(CacheDatasetOpTest, MappedFileCacheChecksumIsVerified) {
+  auto dataset_params = CacheDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+  }
+
+  // Corrupts the data files of the cache, keeping their size.
+  std::vector<string> data_filenames;
+  TF_ASSERT_OK(Env::Default()->GetMatchingPaths(
+      strings::StrCat(cache_filename_, ".data-*"), &data_filenames));
+  ASSERT_FALSE(data_filenames.empty());
+  for (const string& data_filename : data_filenames) {
+    uint64 file_size;
+    TF_ASSERT_OK(Env::Default()->GetFileSize(data_filename, &file_size));
+    TF_ASSERT_OK(WriteStringToFile(Env::Default(), data_filename,
+                                   string(file_size, '\xff')));
+  }
+
+  TF_ASSERT_OK(dataset_->MakeIterator(iterator_ctx_.get(), /*parent=*/nullptr,
+                                      dataset_params.iterator_prefix(),
+                                      &iterator_));
+  std::vector<Tensor> next;
+  EXPECT_EQ(iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence)
+                .code(),
+            error::DATA_LOSS);
+}
+
 TEST_F(CacheDatasetOpTest, DatasetNodeName) {
   auto dataset_params = CacheDatasetParams1();
   TF_ASSERT_OK(Initialize(dataset_params));
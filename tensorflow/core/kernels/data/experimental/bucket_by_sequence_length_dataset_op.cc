@@ -0,0 +1,592 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/bucket_by_sequence_length_dataset_op.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/input_colocation_exemption_registry.h"
+#include "tensorflow/core/data/captured_function.h"
+#include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/serialization_utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Constants declared in bucket_by_sequence_length_dataset_op.h and used both
+// here and in test cases.
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kInputDataset;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kLengthFuncOtherArguments;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kBucketBoundaries;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kBucketBatchSizes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kPaddedShapes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kPaddingValues;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kMaxBufferedBytes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kFlushTimeoutMs;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kLengthFunc;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kTlengthFuncOtherArguments;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kParallelCopy;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kToutputTypes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kOutputShapes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kNumPaddedShapes;
+
+namespace {
+
+constexpr char kInputImplEmpty[] = "input_impl_empty";
+constexpr char kBucket[] = "bucket";
+
+}  // namespace
+
+// The dataset assigns each input element to the bucket of its length, as
+// computed by `length_func`: bucket `i` holds the elements whose length is in
+// `[bucket_boundaries[i - 1], bucket_boundaries[i])`. Every bucket buffers a
+// partial batch, which is produced as a padded batch once it holds
+// `bucket_batch_sizes[i]` elements. Partial batches are produced early when the
+// buffered elements of all buckets exceed `max_buffered_bytes` (the largest
+// bucket is flushed), when the oldest element of a bucket has been buffered for
+// `flush_timeout_ms` (checked whenever an input element is consumed), and at
+// the end of the input (in bucket order). The padding copies run outside of the
+// iterator lock and, if `parallel_copy` is set, in parallel.
+class BucketBySequenceLengthDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input,
+          std::unique_ptr<CapturedFunction> captured_func,
+          std::vector<int64_t> bucket_boundaries,
+          std::vector<int64_t> bucket_batch_sizes,
+          std::vector<PartialTensorShape> padded_shapes,
+          std::vector<Tensor> padding_values, int64_t max_buffered_bytes,
+          int64_t flush_timeout_ms, bool parallel_copy)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        captured_func_(std::move(captured_func)),
+        bucket_boundaries_(std::move(bucket_boundaries)),
+        bucket_batch_sizes_(std::move(bucket_batch_sizes)),
+        padded_shapes_(std::move(padded_shapes)),
+        padding_values_(std::move(padding_values)),
+        max_buffered_bytes_(max_buffered_bytes),
+        flush_timeout_ms_(flush_timeout_ms),
+        parallel_copy_(parallel_copy),
+        traceme_metadata_(
+            {{"num_buckets", strings::StrCat(bucket_batch_sizes_.size())},
+             {"max_buffered_bytes", strings::StrCat(max_buffered_bytes)},
+             {"flush_timeout_ms", strings::StrCat(flush_timeout_ms)},
+             {"parallel_copy", parallel_copy ? "true" : "false"}}) {
+    input_->Ref();
+    output_shapes_.reserve(padded_shapes_.size());
+    for (const PartialTensorShape& padded_shape : padded_shapes_) {
+      output_shapes_.push_back(
+          PartialTensorShape({-1}).Concatenate(padded_shape));
+    }
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  int64_t CardinalityInternal() const override {
+    int64_t n = input_->Cardinality();
+    if (n == kInfiniteCardinality || n == 0) {
+      return n;
+    }
+    return kUnknownCardinality;
+  }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    inputs->push_back(input_);
+    return Status::OK();
+  }
+
+  Status CheckExternalState() const override {
+    TF_RETURN_IF_ERROR(captured_func_->CheckExternalState());
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+
+    std::vector<Node*> other_arguments;
+    DataTypeVector other_arguments_types;
+    TF_RETURN_IF_ERROR(captured_func_->AddToGraph(ctx, b, &other_arguments,
+                                                  &other_arguments_types));
+
+    Node* bucket_boundaries = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(bucket_boundaries_, &bucket_boundaries));
+    Node* bucket_batch_sizes = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(bucket_batch_sizes_, &bucket_batch_sizes));
+
+    std::vector<Node*> padded_shapes;
+    padded_shapes.reserve(padded_shapes_.size());
+    for (const PartialTensorShape& padded_shape : padded_shapes_) {
+      Node* node;
+      Tensor t(DT_INT64, TensorShape({padded_shape.dims()}));
+      for (int j = 0; j < padded_shape.dims(); j++) {
+        t.vec<int64_t>()(j) = padded_shape.dim_size(j);
+      }
+      TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+      padded_shapes.emplace_back(node);
+    }
+
+    std::vector<Node*> padding_values;
+    padding_values.reserve(padding_values_.size());
+    for (const Tensor& t : padding_values_) {
+      Node* node;
+      TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+      padding_values.emplace_back(node);
+    }
+
+    Node* max_buffered_bytes = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(max_buffered_bytes_, &max_buffered_bytes));
+    Node* flush_timeout_ms = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(flush_timeout_ms_, &flush_timeout_ms));
+
+    AttrValue length_func;
+    b->BuildAttrValue(captured_func_->func(), &length_func);
+    AttrValue other_arguments_types_attr;
+    b->BuildAttrValue(other_arguments_types, &other_arguments_types_attr);
+    AttrValue parallel_copy;
+    b->BuildAttrValue(parallel_copy_, &parallel_copy);
+    AttrValue output_types;
+    b->BuildAttrValue(output_dtypes(), &output_types);
+    AttrValue N;
+    b->BuildAttrValue<int64_t>(padded_shapes_.size(), &N);
+
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this,
+        {{0, input_graph_node},
+         {2, bucket_boundaries},
+         {3, bucket_batch_sizes},
+         {6, max_buffered_bytes},
+         {7, flush_timeout_ms}},
+        {{1, other_arguments}, {4, padded_shapes}, {5, padding_values}},
+        {{kLengthFunc, length_func},
+         {kTlengthFuncOtherArguments, other_arguments_types_attr},
+         {kParallelCopy, parallel_copy},
+         {kToutputTypes, output_types},
+         {kNumPaddedShapes, N}},
+        output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params),
+          buckets_(params.dataset->bucket_batch_sizes_.size()) {}
+
+    Status Initialize(IteratorContext* ctx) override {
+      TF_RETURN_IF_ERROR(
+          dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_));
+      return dataset()->captured_func_->Instantiate(ctx,
+                                                    &instantiated_length_func_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      // Each row of `batch_elements` is a tuple of tensors from the
+      // input iterator.
+      std::vector<std::vector<Tensor>> batch_elements;
+      {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(GetNextBatch(ctx, &batch_elements));
+      }
+      if (batch_elements.empty()) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(CopyPaddedBatch(
+          CopyBatchParams(ctx), batch_elements, dataset()->padded_shapes_,
+          dataset()->padding_values_, dataset()->parallel_copy_, out_tensors));
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeUnknownRatioNode(std::move(args));
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      TF_RETURN_IF_ERROR(ctx->HandleCheckExternalStateStatus(
+          dataset()->captured_func_->CheckExternalState()));
+      mutex_lock l(mu_);
+      if (!input_impl_) {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kInputImplEmpty), ""));
+      } else {
+        TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+      }
+      for (size_t i = 0; i < buckets_.size(); ++i) {
+        TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(
+            writer, full_name(strings::StrCat(kBucket, "[", i, "]")),
+            buckets_[i].elements));
+      }
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      if (reader->Contains(full_name(kInputImplEmpty))) {
+        input_impl_.reset();
+      } else {
+        TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+      }
+      // The buffering time of the restored elements restarts at restore time.
+      const int64_t now_us = EnvTime::NowMicros();
+      buffered_bytes_ = 0;
+      for (size_t i = 0; i < buckets_.size(); ++i) {
+        Bucket& bucket = buckets_[i];
+        bucket = Bucket();
+        TF_RETURN_IF_ERROR(ReadElementsFromCheckpoint(
+            ctx, reader, full_name(strings::StrCat(kBucket, "[", i, "]")),
+            &bucket.elements));
+        for (const std::vector<Tensor>& element : bucket.elements) {
+          bucket.bytes += GetTotalBytes(element);
+        }
+        bucket.oldest_element_us = now_us;
+        buffered_bytes_ += bucket.bytes;
+      }
+      return Status::OK();
+    }
+
+    TraceMeMetadata GetTraceMeMetadata() const override {
+      return dataset()->traceme_metadata_;
+    }
+
+   private:
+    struct Bucket {
+      std::vector<std::vector<Tensor>> elements;
+      // The total size of `elements`.
+      int64_t bytes = 0;
+      // The time at which the oldest element in `elements` was buffered.
+      int64_t oldest_element_us = 0;
+    };
+
+    // Consumes input elements until a bucket needs to be flushed and moves the
+    // elements of that bucket to `batch_elements`. Leaves `batch_elements`
+    // empty when the input and all buckets are exhausted.
+    Status GetNextBatch(IteratorContext* ctx,
+                        std::vector<std::vector<Tensor>>* batch_elements)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      while (true) {
+        const int64_t timed_out_bucket = TimedOutBucket();
+        if (timed_out_bucket >= 0) {
+          FlushBucket(timed_out_bucket, batch_elements);
+          return Status::OK();
+        }
+        if (!input_impl_) {
+          for (size_t i = 0; i < buckets_.size(); ++i) {
+            if (!buckets_[i].elements.empty()) {
+              FlushBucket(i, batch_elements);
+              break;
+            }
+          }
+          return Status::OK();
+        }
+
+        std::vector<Tensor> element;
+        bool end_of_input = false;
+        TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &element, &end_of_input));
+        if (end_of_input) {
+          input_impl_.reset();
+          continue;
+        }
+
+        int64_t bucket_index;
+        TF_RETURN_IF_ERROR(GetBucketIndex(ctx, element, &bucket_index));
+        Bucket& bucket = buckets_[bucket_index];
+        if (bucket.elements.empty()) {
+          bucket.oldest_element_us = EnvTime::NowMicros();
+        }
+        const int64_t element_bytes = GetTotalBytes(element);
+        bucket.bytes += element_bytes;
+        buffered_bytes_ += element_bytes;
+        bucket.elements.push_back(std::move(element));
+
+        if (bucket.elements.size() ==
+            dataset()->bucket_batch_sizes_[bucket_index]) {
+          FlushBucket(bucket_index, batch_elements);
+          return Status::OK();
+        }
+        if (dataset()->max_buffered_bytes_ > 0 &&
+            buffered_bytes_ > dataset()->max_buffered_bytes_) {
+          FlushBucket(LargestBucket(), batch_elements);
+          return Status::OK();
+        }
+      }
+    }
+
+    // Runs `length_func` on `element` and looks up the bucket of the length.
+    Status GetBucketIndex(IteratorContext* ctx,
+                          const std::vector<Tensor>& element,
+                          int64_t* bucket_index)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      std::vector<Tensor> length_func_output;
+      TF_RETURN_IF_ERROR(instantiated_length_func_->RunWithBorrowedArgs(
+          ctx, element, &length_func_output, model_node()));
+      if (length_func_output.size() != 1 ||
+          !TensorShapeUtils::IsScalar(length_func_output[0].shape()) ||
+          (length_func_output[0].dtype() != DT_INT32 &&
+           length_func_output[0].dtype() != DT_INT64)) {
+        return errors::InvalidArgument(
+            "`length_func` must return a scalar int32 or int64.");
+      }
+      const int64_t length = length_func_output[0].dtype() == DT_INT32
+                                 ? length_func_output[0].scalar<int32>()()
+                                 : length_func_output[0].scalar<int64_t>()();
+      const std::vector<int64_t>& boundaries = dataset()->bucket_boundaries_;
+      *bucket_index =
+          std::upper_bound(boundaries.begin(), boundaries.end(), length) -
+          boundaries.begin();
+      return Status::OK();
+    }
+
+    // Returns the index of the bucket whose oldest element has been buffered
+    // for the longest time, if that time exceeds the flush timeout, and -1
+    // otherwise.
+    int64_t TimedOutBucket() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (dataset()->flush_timeout_ms_ <= 0) {
+        return -1;
+      }
+      int64_t oldest_bucket = -1;
+      for (size_t i = 0; i < buckets_.size(); ++i) {
+        if (buckets_[i].elements.empty()) {
+          continue;
+        }
+        if (oldest_bucket < 0 ||
+            buckets_[i].oldest_element_us <
+                buckets_[oldest_bucket].oldest_element_us) {
+          oldest_bucket = i;
+        }
+      }
+      if (oldest_bucket < 0) {
+        return -1;
+      }
+      const int64_t buffered_us =
+          EnvTime::NowMicros() - buckets_[oldest_bucket].oldest_element_us;
+      if (buffered_us < dataset()->flush_timeout_ms_ * 1000) {
+        return -1;
+      }
+      return oldest_bucket;
+    }
+
+    // Returns the index of the bucket with the most buffered bytes.
+    int64_t LargestBucket() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64_t largest_bucket = 0;
+      for (size_t i = 1; i < buckets_.size(); ++i) {
+        if (buckets_[i].bytes > buckets_[largest_bucket].bytes) {
+          largest_bucket = i;
+        }
+      }
+      return largest_bucket;
+    }
+
+    void FlushBucket(int64_t bucket_index,
+                     std::vector<std::vector<Tensor>>* batch_elements)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      Bucket& bucket = buckets_[bucket_index];
+      buffered_bytes_ -= bucket.bytes;
+      *batch_elements = std::move(bucket.elements);
+      bucket = Bucket();
+    }
+
+    mutex mu_;
+    std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
+    std::vector<Bucket> buckets_ TF_GUARDED_BY(mu_);
+    // The total size of the elements buffered in `buckets_`.
+    int64_t buffered_bytes_ TF_GUARDED_BY(mu_) = 0;
+    std::unique_ptr<InstantiatedCapturedFunction> instantiated_length_func_;
+  };
+
+  const DatasetBase* const input_;
+  const std::unique_ptr<CapturedFunction> captured_func_;
+  const std::vector<int64_t> bucket_boundaries_;
+  const std::vector<int64_t> bucket_batch_sizes_;
+  const std::vector<PartialTensorShape> padded_shapes_;
+  const std::vector<Tensor> padding_values_;
+  const int64_t max_buffered_bytes_;
+  const int64_t flush_timeout_ms_;
+  const bool parallel_copy_;
+  std::vector<PartialTensorShape> output_shapes_;
+  const TraceMeMetadata traceme_metadata_;
+};
+
+BucketBySequenceLengthDatasetOp::BucketBySequenceLengthDatasetOp(
+    OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, FunctionMetadata::Create(ctx, kLengthFunc, /*params=*/{},
+                                               &func_metadata_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kParallelCopy, &parallel_copy_));
+}
+
+void BucketBySequenceLengthDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                                  DatasetBase* input,
+                                                  DatasetBase** output) {
+  std::unique_ptr<CapturedFunction> captured_func;
+  OP_REQUIRES_OK(ctx,
+                 CapturedFunction::Create(ctx, func_metadata_,
+                                          kLengthFuncOtherArguments,
+                                          &captured_func));
+
+  std::vector<int64_t> bucket_boundaries;
+  OP_REQUIRES_OK(ctx, ParseVectorArgument<int64_t>(ctx, kBucketBoundaries,
+                                                   &bucket_boundaries));
+  for (size_t i = 1; i < bucket_boundaries.size(); ++i) {
+    OP_REQUIRES(ctx, bucket_boundaries[i - 1] < bucket_boundaries[i],
+                errors::InvalidArgument(
+                    "`bucket_boundaries` must be strictly increasing, but got ",
+                    bucket_boundaries[i - 1], " before ",
+                    bucket_boundaries[i], "."));
+  }
+  std::vector<int64_t> bucket_batch_sizes;
+  OP_REQUIRES_OK(ctx, ParseVectorArgument<int64_t>(ctx, kBucketBatchSizes,
+                                                   &bucket_batch_sizes));
+  OP_REQUIRES(ctx, bucket_batch_sizes.size() == bucket_boundaries.size() + 1,
+              errors::InvalidArgument(
+                  "`bucket_batch_sizes` must have one more element than "
+                  "`bucket_boundaries`, but got ",
+                  bucket_batch_sizes.size(), " batch sizes and ",
+                  bucket_boundaries.size(), " boundaries."));
+  for (int64_t batch_size : bucket_batch_sizes) {
+    OP_REQUIRES(
+        ctx, batch_size > 0,
+        errors::InvalidArgument("Batch sizes must be greater than zero."));
+  }
+
+  OpInputList padded_shape_tensors;
+  OP_REQUIRES_OK(ctx, ctx->input_list(kPaddedShapes, &padded_shape_tensors));
+  std::vector<PartialTensorShape> padded_shapes;
+  padded_shapes.reserve(padded_shape_tensors.size());
+  OP_REQUIRES(ctx, padded_shape_tensors.size() == input->output_shapes().size(),
+              errors::InvalidArgument("Number of padded shapes (",
+                                      padded_shape_tensors.size(),
+                                      ") must match the number of components "
+                                      "in the input dataset's elements (",
+                                      input->output_shapes().size(), ")"));
+  for (const Tensor& padded_shape_t : padded_shape_tensors) {
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(padded_shape_t.shape()),
+                errors::InvalidArgument("All padded shapes must be vectors"));
+    PartialTensorShape padded_shape;
+    OP_REQUIRES_OK(ctx, PartialTensorShape::MakePartialShape(
+                            padded_shape_t.vec<int64_t>().data(),
+                            padded_shape_t.NumElements(), &padded_shape));
+    padded_shapes.push_back(std::move(padded_shape));
+  }
+  OpInputList padding_values_list;
+  OP_REQUIRES_OK(ctx, ctx->input_list(kPaddingValues, &padding_values_list));
+  std::vector<Tensor> padding_values;
+  OP_REQUIRES(ctx, padding_values_list.size() == input->output_shapes().size(),
+              errors::InvalidArgument(
+                  "Number of padding values (", padding_values_list.size(),
+                  ") must match the number of components in the input "
+                  "dataset's elements (",
+                  input->output_shapes().size(), ")"));
+  for (int i = 0; i < padding_values_list.size(); ++i) {
+    const Tensor& padding_value_t = padding_values_list[i];
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(padding_value_t.shape()),
+                errors::InvalidArgument("All padding values must be scalars"));
+    OP_REQUIRES(ctx, padding_value_t.dtype() == input->output_dtypes()[i],
+                errors::InvalidArgument(
+                    "Mismatched type between padding value ", i,
+                    " and input dataset's component ", i, ": ",
+                    DataTypeString(padding_value_t.dtype()), " vs. ",
+                    DataTypeString(input->output_dtypes()[i])));
+    padding_values.push_back(tensor::DeepCopy(padding_value_t));
+  }
+
+  int64_t max_buffered_bytes;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kMaxBufferedBytes,
+                                                   &max_buffered_bytes));
+  OP_REQUIRES(ctx, max_buffered_bytes >= 0,
+              errors::InvalidArgument(
+                  "`max_buffered_bytes` must be non-negative, but got ",
+                  max_buffered_bytes, "."));
+  int64_t flush_timeout_ms;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kFlushTimeoutMs,
+                                                   &flush_timeout_ms));
+  OP_REQUIRES(ctx, flush_timeout_ms >= 0,
+              errors::InvalidArgument(
+                  "`flush_timeout_ms` must be non-negative, but got ",
+                  flush_timeout_ms, "."));
+
+  *output = new Dataset(ctx, input, std::move(captured_func),
+                        std::move(bucket_boundaries),
+                        std::move(bucket_batch_sizes), std::move(padded_shapes),
+                        std::move(padding_values), max_buffered_bytes,
+                        flush_timeout_ms, parallel_copy_);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(
+    Name("BucketBySequenceLengthDataset").Device(DEVICE_CPU),
+    BucketBySequenceLengthDatasetOp);
+
+REGISTER_INPUT_COLOCATION_EXEMPTION("BucketBySequenceLengthDataset");
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
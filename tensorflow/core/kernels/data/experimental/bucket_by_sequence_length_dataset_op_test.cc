@@ -0,0 +1,306 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/bucket_by_sequence_length_dataset_op.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/data/dataset_test_base.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "bucket_by_sequence_length_dataset";
+
+class BucketBySequenceLengthDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  BucketBySequenceLengthDatasetParams(
+      T input_dataset_params, std::vector<int64_t> bucket_boundaries,
+      std::vector<int64_t> bucket_batch_sizes, int64_t max_buffered_bytes,
+      int64_t flush_timeout_ms, DataTypeVector output_dtypes,
+      std::vector<PartialTensorShape> output_shapes, string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        bucket_boundaries_(std::move(bucket_boundaries)),
+        bucket_batch_sizes_(std::move(bucket_batch_sizes)),
+        max_buffered_bytes_(max_buffered_bytes),
+        flush_timeout_ms_(flush_timeout_ms) {
+    input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  // The elements of the test inputs are int64 scalars whose length is twice
+  // their value.
+  std::vector<Tensor> GetInputTensors() const override {
+    return {
+        CreateTensor<int64_t>(
+            TensorShape({static_cast<int64_t>(bucket_boundaries_.size())}),
+            bucket_boundaries_),
+        CreateTensor<int64_t>(
+            TensorShape({static_cast<int64_t>(bucket_batch_sizes_.size())}),
+            bucket_batch_sizes_),
+        CreateTensor<int64_t>(TensorShape({0}), {}),
+        CreateTensor<int64_t>(TensorShape({}), {0}),
+        CreateTensor<int64_t>(TensorShape({}), {max_buffered_bytes_}),
+        CreateTensor<int64_t>(TensorShape({}), {flush_timeout_ms_})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {
+        BucketBySequenceLengthDatasetOp::kInputDataset,
+        BucketBySequenceLengthDatasetOp::kBucketBoundaries,
+        BucketBySequenceLengthDatasetOp::kBucketBatchSizes,
+        strings::StrCat(BucketBySequenceLengthDatasetOp::kPaddedShapes, "_0"),
+        strings::StrCat(BucketBySequenceLengthDatasetOp::kPaddingValues, "_0"),
+        BucketBySequenceLengthDatasetOp::kMaxBufferedBytes,
+        BucketBySequenceLengthDatasetOp::kFlushTimeoutMs};
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {
+        {BucketBySequenceLengthDatasetOp::kLengthFunc,
+         FunctionDefHelper::FunctionRef("XTimesTwo", {{"T", DT_INT64}})},
+        {BucketBySequenceLengthDatasetOp::kTlengthFuncOtherArguments,
+         DataTypeVector{}},
+        {BucketBySequenceLengthDatasetOp::kParallelCopy, true},
+        {BucketBySequenceLengthDatasetOp::kToutputTypes, output_dtypes_},
+        {BucketBySequenceLengthDatasetOp::kOutputShapes, output_shapes_},
+        {BucketBySequenceLengthDatasetOp::kNumPaddedShapes, 1}};
+    return Status::OK();
+  }
+
+  std::vector<FunctionDef> func_lib() const override {
+    return {test::function::XTimesTwo()};
+  }
+
+  string dataset_type() const override {
+    return BucketBySequenceLengthDatasetOp::kDatasetType;
+  }
+
+ private:
+  std::vector<int64_t> bucket_boundaries_;
+  std::vector<int64_t> bucket_batch_sizes_;
+  int64_t max_buffered_bytes_;
+  int64_t flush_timeout_ms_;
+};
+
+class BucketBySequenceLengthDatasetOpTest : public DatasetOpsTestBase {};
+
+// Elements 0-2 fall in the first bucket, 3-5 in the second one, and 6-9 in
+// the third one.
+BucketBySequenceLengthDatasetParams BucketBatchSizeParams() {
+  return BucketBySequenceLengthDatasetParams(
+      RangeDatasetParams(0, 10, 1),
+      /*bucket_boundaries=*/{6, 12},
+      /*bucket_batch_sizes=*/{2, 2, 3},
+      /*max_buffered_bytes=*/0,
+      /*flush_timeout_ms=*/0,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+// The elements are 8-byte scalars, so a bucket is flushed every 3 elements.
+BucketBySequenceLengthDatasetParams MaxBufferedBytesParams() {
+  return BucketBySequenceLengthDatasetParams(
+      RangeDatasetParams(0, 10, 1),
+      /*bucket_boundaries=*/{6, 12},
+      /*bucket_batch_sizes=*/{10, 10, 10},
+      /*max_buffered_bytes=*/16,
+      /*flush_timeout_ms=*/0,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+BucketBySequenceLengthDatasetParams SingleBucketParams() {
+  return BucketBySequenceLengthDatasetParams(
+      RangeDatasetParams(0, 5, 1),
+      /*bucket_boundaries=*/{},
+      /*bucket_batch_sizes=*/{2},
+      /*max_buffered_bytes=*/0,
+      /*flush_timeout_ms=*/60 * 1000,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+BucketBySequenceLengthDatasetParams EmptyInputParams() {
+  return BucketBySequenceLengthDatasetParams(
+      RangeDatasetParams(0, 0, 1),
+      /*bucket_boundaries=*/{6, 12},
+      /*bucket_batch_sizes=*/{2, 2, 3},
+      /*max_buffered_bytes=*/0,
+      /*flush_timeout_ms=*/0,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+BucketBySequenceLengthDatasetParams UnsortedBoundariesParams() {
+  return BucketBySequenceLengthDatasetParams(
+      RangeDatasetParams(0, 10, 1),
+      /*bucket_boundaries=*/{12, 6},
+      /*bucket_batch_sizes=*/{2, 2, 3},
+      /*max_buffered_bytes=*/0,
+      /*flush_timeout_ms=*/0,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+BucketBySequenceLengthDatasetParams InvalidNumBatchSizesParams() {
+  return BucketBySequenceLengthDatasetParams(
+      RangeDatasetParams(0, 10, 1),
+      /*bucket_boundaries=*/{6, 12},
+      /*bucket_batch_sizes=*/{2, 2},
+      /*max_buffered_bytes=*/0,
+      /*flush_timeout_ms=*/0,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+BucketBySequenceLengthDatasetParams InvalidBatchSizeParams() {
+  return BucketBySequenceLengthDatasetParams(
+      RangeDatasetParams(0, 10, 1),
+      /*bucket_boundaries=*/{6, 12},
+      /*bucket_batch_sizes=*/{2, 0, 3},
+      /*max_buffered_bytes=*/0,
+      /*flush_timeout_ms=*/0,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+BucketBySequenceLengthDatasetParams InvalidMaxBufferedBytesParams() {
+  return BucketBySequenceLengthDatasetParams(
+      RangeDatasetParams(0, 10, 1),
+      /*bucket_boundaries=*/{6, 12},
+      /*bucket_batch_sizes=*/{2, 2, 3},
+      /*max_buffered_bytes=*/-1,
+      /*flush_timeout_ms=*/0,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+std::vector<Tensor> BucketBatchSizeOutputs() {
+  return {CreateTensor<int64_t>(TensorShape({2}), {0, 1}),
+          CreateTensor<int64_t>(TensorShape({2}), {3, 4}),
+          CreateTensor<int64_t>(TensorShape({3}), {6, 7, 8}),
+          CreateTensor<int64_t>(TensorShape({1}), {2}),
+          CreateTensor<int64_t>(TensorShape({1}), {5}),
+          CreateTensor<int64_t>(TensorShape({1}), {9})};
+}
+
+std::vector<GetNextTestCase<BucketBySequenceLengthDatasetParams>>
+GetNextTestCases() {
+  return {{/*dataset_params=*/BucketBatchSizeParams(),
+           /*expected_outputs=*/BucketBatchSizeOutputs()},
+          {/*dataset_params=*/MaxBufferedBytesParams(),
+           /*expected_outputs=*/
+           {CreateTensor<int64_t>(TensorShape({3}), {0, 1, 2}),
+            CreateTensor<int64_t>(TensorShape({3}), {3, 4, 5}),
+            CreateTensor<int64_t>(TensorShape({3}), {6, 7, 8}),
+            CreateTensor<int64_t>(TensorShape({1}), {9})}},
+          {/*dataset_params=*/SingleBucketParams(),
+           /*expected_outputs=*/
+           {CreateTensor<int64_t>(TensorShape({2}), {0, 1}),
+            CreateTensor<int64_t>(TensorShape({2}), {2, 3}),
+            CreateTensor<int64_t>(TensorShape({1}), {4})}},
+          {/*dataset_params=*/EmptyInputParams(),
+           /*expected_outputs=*/{}}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(BucketBySequenceLengthDatasetOpTest,
+                         BucketBySequenceLengthDatasetParams,
+                         GetNextTestCases())
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, DatasetNodeName) {
+  auto dataset_params = BucketBatchSizeParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetNodeName(dataset_params.node_name()));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, DatasetTypeString) {
+  auto dataset_params = BucketBatchSizeParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetTypeString(
+      name_utils::OpName(BucketBySequenceLengthDatasetOp::kDatasetType)));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, DatasetOutputDtypes) {
+  auto dataset_params = BucketBatchSizeParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputDtypes({DT_INT64}));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, DatasetOutputShapes) {
+  auto dataset_params = BucketBatchSizeParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputShapes({PartialTensorShape({-1})}));
+}
+
+std::vector<CardinalityTestCase<BucketBySequenceLengthDatasetParams>>
+CardinalityTestCases() {
+  return {{/*dataset_params=*/BucketBatchSizeParams(),
+           /*expected_cardinality=*/kUnknownCardinality},
+          {/*dataset_params=*/EmptyInputParams(),
+           /*expected_cardinality=*/0}};
+}
+
+DATASET_CARDINALITY_TEST_P(BucketBySequenceLengthDatasetOpTest,
+                           BucketBySequenceLengthDatasetParams,
+                           CardinalityTestCases())
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, IteratorPrefix) {
+  auto dataset_params = BucketBatchSizeParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorPrefix(name_utils::IteratorPrefix(
+      BucketBySequenceLengthDatasetOp::kDatasetType,
+      dataset_params.iterator_prefix())));
+}
+
+std::vector<
+    IteratorSaveAndRestoreTestCase<BucketBySequenceLengthDatasetParams>>
+IteratorSaveAndRestoreTestCases() {
+  return {{/*dataset_params=*/BucketBatchSizeParams(),
+           /*breakpoints=*/{0, 2, 4, 7},
+           /*expected_outputs=*/BucketBatchSizeOutputs()}};
+}
+
+ITERATOR_SAVE_AND_RESTORE_TEST_P(BucketBySequenceLengthDatasetOpTest,
+                                 BucketBySequenceLengthDatasetParams,
+                                 IteratorSaveAndRestoreTestCases())
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, InvalidArguments) {
+  std::vector<BucketBySequenceLengthDatasetParams> dataset_params_vec(
+      {UnsortedBoundariesParams(), InvalidNumBatchSizesParams(),
+       InvalidBatchSizeParams(), InvalidMaxBufferedBytesParams()});
+  for (const auto& dataset_params : dataset_params_vec) {
+    EXPECT_EQ(Initialize(dataset_params).code(),
+              tensorflow::error::INVALID_ARGUMENT);
+  }
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
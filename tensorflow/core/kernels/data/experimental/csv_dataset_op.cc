@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/kernels/csv_tokenizer.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
@@ -508,7 +509,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         pos_++;  // Starting quotation mark
 
         Status parse_result;
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        while (true) {  // Each iter checks 1 char, filling buffer if necessary
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             if (errors::IsOutOfRange(s)) {
@@ -520,6 +521,15 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
+          // Skip to the next quote, which may end the field.
+          const void* quote =
+              memchr(buffer_.data() + pos_, '"', buffer_.size() - pos_);
+          if (quote == nullptr) {
+            pos_ = buffer_.size();
+            continue;
+          }
+          pos_ = static_cast<const char*>(quote) - buffer_.data();
+
           char ch = buffer_[pos_];
           if (ch == '"') {
             // When we encounter a quote, we look ahead to the next character to
@@ -641,7 +651,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         size_t start = pos_;
         Status parse_result;
 
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        while (true) {  // Each iter checks 1 char, filling buffer if necessary
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             // Handle errors
@@ -657,6 +667,15 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
+          // Skip to the next delim, CRLF or quote.
+          const char* special = FindCsvSpecialChar(
+              buffer_.data() + pos_, buffer_.data() + buffer_.size(),
+              dataset()->delim_, dataset()->use_quote_delim_);
+          pos_ = special - buffer_.data();
+          if (pos_ >= buffer_.size()) {
+            continue;
+          }
+
           char ch = buffer_[pos_];
 
           if (ch == dataset()->delim_) {
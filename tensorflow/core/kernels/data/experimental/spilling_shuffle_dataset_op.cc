@@ -0,0 +1,514 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/spilling_shuffle_dataset_op.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/data/compression_utils.h"
+#include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/serialization_utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Constants declared in spilling_shuffle_dataset_op.h and used both here and
+// in test cases.
+/* static */ constexpr const char* const SpillingShuffleDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    SpillingShuffleDatasetOp::kInputDataset;
+/* static */ constexpr const char* const
+    SpillingShuffleDatasetOp::kSpillDirectory;
+/* static */ constexpr const char* const
+    SpillingShuffleDatasetOp::kMemoryBudgetBytes;
+/* static */ constexpr const char* const
+    SpillingShuffleDatasetOp::kReadaheadBytes;
+/* static */ constexpr const char* const SpillingShuffleDatasetOp::kSeed;
+/* static */ constexpr const char* const SpillingShuffleDatasetOp::kSeed2;
+/* static */ constexpr const char* const SpillingShuffleDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const
+    SpillingShuffleDatasetOp::kOutputShapes;
+
+namespace {
+
+constexpr char kNumRandomSamples[] = "num_random_samples";
+constexpr char kEndOfInputSequence[] = "end_of_input_sequence";
+constexpr char kNumRuns[] = "num_runs";
+constexpr char kRunFilename[] = "run_filename";
+constexpr char kRunNumElements[] = "run_num_elements";
+constexpr char kRunNumConsumed[] = "run_num_consumed";
+constexpr char kBuffer[] = "buffer";
+
+// The maximum number of records skipped by a single call to
+// `io::SequentialRecordReader::SkipRecords`.
+constexpr int kMaxRecordsPerSkip = 1 << 20;
+
+}  // namespace
+
+// The dataset produces a uniformly random permutation of its finite input in
+// two levels. The first `GetNext()` call reads the whole input: elements are
+// buffered in memory until their size reaches the memory budget, at which
+// point the buffer is shuffled and spilled to a file (a "run") of compressed
+// elements. The elements left in the buffer at the end of the input stay in
+// memory as the last run. Each element is then produced from a run chosen with
+// probability proportional to the number of elements left in it, which merges
+// the independently shuffled runs into a uniformly random permutation of all
+// elements, while only requiring a readahead buffer per spilled run.
+class SpillingShuffleDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input,
+          std::string spill_directory, int64_t memory_budget_bytes,
+          int64_t readahead_bytes, int64_t seed, int64_t seed2)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        spill_directory_(std::move(spill_directory)),
+        memory_budget_bytes_(memory_budget_bytes),
+        readahead_bytes_(readahead_bytes),
+        seeds_(seed, seed2) {
+    input_->Ref();
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(
+        Iterator::Params{this,
+                         name_utils::IteratorPrefix(kDatasetType, prefix)},
+        seeds_.first, seeds_.second);
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return input_->output_shapes();
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  int64_t CardinalityInternal() const override { return input_->Cardinality(); }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    inputs->push_back(input_);
+    return Status::OK();
+  }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+    Node* spill_directory = nullptr;
+    Node* memory_budget_bytes = nullptr;
+    Node* readahead_bytes = nullptr;
+    Node* seed = nullptr;
+    Node* seed2 = nullptr;
+    TF_RETURN_IF_ERROR(
+        b->AddScalar(tstring(spill_directory_), &spill_directory));
+    TF_RETURN_IF_ERROR(
+        b->AddScalar(memory_budget_bytes_, &memory_budget_bytes));
+    TF_RETURN_IF_ERROR(b->AddScalar(readahead_bytes_, &readahead_bytes));
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.first, &seed));
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.second, &seed2));
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this,
+        {input_graph_node, spill_directory, memory_budget_bytes,
+         readahead_bytes, seed, seed2},
+        output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    Iterator(const Params& params, int64_t seed, int64_t seed2)
+        : DatasetIterator<Dataset>(params),
+          seeds_(MaybeOverrideSeeds({seed, seed2})),
+          parent_generator_(seeds_.first, seeds_.second),
+          generator_(&parent_generator_),
+          file_prefix_(io::JoinPath(
+              params.dataset->spill_directory_,
+              strings::StrCat("spilling_shuffle_",
+                              strings::Hex(random::New64(),
+                                           strings::kZeroPad16)))) {}
+
+    ~Iterator() override {
+      mutex_lock l(mu_);
+      DeleteRunFiles();
+    }
+
+    Status Initialize(IteratorContext* ctx) override {
+      return dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      if (input_impl_) {
+        TF_RETURN_IF_ERROR(SpillInput(ctx));
+      }
+      int64_t num_remaining = buffer_.size();
+      for (const Run& run : runs_) {
+        num_remaining += run.num_elements - run.num_consumed;
+      }
+      if (num_remaining == 0) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      *end_of_sequence = false;
+
+      int64_t index = static_cast<int64_t>(Random() % num_remaining);
+      if (index < static_cast<int64_t>(buffer_.size())) {
+        // `buffer_` is shuffled, so its last element is as good as any.
+        *out_tensors = std::move(buffer_.back());
+        buffer_.pop_back();
+        return Status::OK();
+      }
+      index -= buffer_.size();
+      for (Run& run : runs_) {
+        const int64_t run_remaining = run.num_elements - run.num_consumed;
+        if (index < run_remaining) {
+          return ReadFromRun(ctx, &run, out_tensors);
+        }
+        index -= run_remaining;
+      }
+      return errors::Internal("Failed to choose a spill run.");
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeKnownRatioNode(std::move(args), /*ratio=*/1);
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      // Save state needed to restore the random number generators.
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(full_name(kNumRandomSamples),
+                              num_random_samples_));
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kSeed), seeds_.first));
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(full_name(kSeed2), seeds_.second));
+
+      if (input_impl_) {
+        TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+      } else {
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(full_name(kEndOfInputSequence), ""));
+      }
+
+      // The spilled runs are saved by reference, so their files are kept
+      // for as long as the saved state may be restored.
+      TF_RETURN_IF_ERROR(writer->WriteScalar(
+          full_name(kNumRuns), static_cast<int64_t>(runs_.size())));
+      for (size_t i = 0; i < runs_.size(); ++i) {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(strings::StrCat(kRunFilename, "_", i)),
+            tstring(runs_[i].filename)));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(strings::StrCat(kRunNumElements, "_", i)),
+            runs_[i].num_elements));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(strings::StrCat(kRunNumConsumed, "_", i)),
+            runs_[i].num_consumed));
+      }
+      TF_RETURN_IF_ERROR(
+          WriteElementsToCheckpoint(writer, full_name(kBuffer), buffer_));
+      keep_run_files_ = true;
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      // Restore the random number generators.
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kNumRandomSamples),
+                                            &num_random_samples_));
+      int64_t seed;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kSeed), &seed));
+      int64_t seed2;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kSeed2), &seed2));
+      seeds_ = {seed, seed2};
+      ResetRngs();
+
+      if (!reader->Contains(full_name(kEndOfInputSequence))) {
+        TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+      } else {
+        input_impl_.reset();
+      }
+
+      DeleteRunFiles();
+      runs_.clear();
+      int64_t num_runs;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kNumRuns), &num_runs));
+      runs_.resize(num_runs);
+      for (int64_t i = 0; i < num_runs; ++i) {
+        tstring filename;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            full_name(strings::StrCat(kRunFilename, "_", i)), &filename));
+        runs_[i].filename = filename;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            full_name(strings::StrCat(kRunNumElements, "_", i)),
+            &runs_[i].num_elements));
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            full_name(strings::StrCat(kRunNumConsumed, "_", i)),
+            &runs_[i].num_consumed));
+      }
+      buffer_.clear();
+      TF_RETURN_IF_ERROR(ReadElementsFromCheckpoint(ctx, reader,
+                                                    full_name(kBuffer),
+                                                    &buffer_));
+      // The restored runs belong to the saved state.
+      keep_run_files_ = true;
+      return Status::OK();
+    }
+
+   private:
+    // A shuffled sequence of elements spilled to a file.
+    struct Run {
+      std::string filename;
+      int64_t num_elements = 0;
+      int64_t num_consumed = 0;
+      // Opened when the first element is read from the run.
+      std::unique_ptr<RandomAccessFile> file;
+      std::unique_ptr<io::SequentialRecordReader> reader;
+    };
+
+    // Returns a 64-bit random number.
+    uint64 Random() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      num_random_samples_ += 2;
+      const uint64 high = generator_();
+      return (high << 32) | generator_();
+    }
+
+    void ResetRngs() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      // Reset the generators based on the current iterator seeds.
+      parent_generator_ = random::PhiloxRandom(seeds_.first, seeds_.second);
+      generator_ =
+          random::SingleSampleAdapter<random::PhiloxRandom>(&parent_generator_);
+      generator_.Skip(num_random_samples_);
+    }
+
+    // Shuffles `buffer_` in place.
+    void ShuffleBuffer() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      for (int64_t i = buffer_.size() - 1; i > 0; --i) {
+        std::swap(buffer_[i], buffer_[Random() % (i + 1)]);
+      }
+    }
+
+    // Reads the whole input, spilling shuffled runs whenever the buffered
+    // elements reach the memory budget, and shuffles the remaining ones.
+    Status SpillInput(IteratorContext* ctx) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64_t num_elements = 0;
+      int64_t buffer_bytes = 0;
+      bool end_of_input = false;
+      while (!end_of_input) {
+        std::vector<Tensor> element;
+        TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &element, &end_of_input));
+        if (end_of_input) break;
+        for (const Tensor& t : element) {
+          buffer_bytes += t.TotalBytes();
+        }
+        buffer_.push_back(std::move(element));
+        ++num_elements;
+        if (buffer_bytes >= dataset()->memory_budget_bytes_) {
+          TF_RETURN_IF_ERROR(SpillBuffer(ctx));
+          buffer_bytes = 0;
+        }
+      }
+      input_impl_.reset();
+      ShuffleBuffer();
+      if (!runs_.empty()) {
+        LOG(INFO) << "Spilled " << num_elements - buffer_.size() << " of "
+                  << num_elements << " elements to " << runs_.size()
+                  << " files in " << dataset()->spill_directory_;
+      }
+      return Status::OK();
+    }
+
+    // Shuffles `buffer_` and writes it to a new run.
+    Status SpillBuffer(IteratorContext* ctx) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      Env* env = ctx->env();
+      if (runs_.empty()) {
+        TF_RETURN_IF_ERROR(
+            env->RecursivelyCreateDir(dataset()->spill_directory_));
+      }
+      ShuffleBuffer();
+      runs_.emplace_back();
+      Run& run = runs_.back();
+      run.filename = strings::StrCat(file_prefix_, "_", runs_.size() - 1);
+      std::unique_ptr<WritableFile> file;
+      TF_RETURN_IF_ERROR(env->NewWritableFile(run.filename, &file));
+      io::RecordWriter writer(file.get());
+      for (const std::vector<Tensor>& element : buffer_) {
+        CompressedElement compressed;
+        TF_RETURN_IF_ERROR(CompressElement(element, &compressed));
+        TF_RETURN_IF_ERROR(writer.WriteRecord(compressed.SerializeAsString()));
+      }
+      TF_RETURN_IF_ERROR(writer.Close());
+      TF_RETURN_IF_ERROR(file->Close());
+      run.num_elements = buffer_.size();
+      buffer_.clear();
+      return Status::OK();
+    }
+
+    // Reads the next element of `run`, opening it if needed.
+    Status ReadFromRun(IteratorContext* ctx, Run* run,
+                       std::vector<Tensor>* out_tensors)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!run->reader) {
+        TF_RETURN_IF_ERROR(
+            ctx->env()->NewRandomAccessFile(run->filename, &run->file));
+        io::RecordReaderOptions options;
+        options.buffer_size = dataset()->readahead_bytes_;
+        run->reader = absl::make_unique<io::SequentialRecordReader>(
+            run->file.get(), options);
+        for (int64_t skipped = 0; skipped < run->num_consumed;) {
+          const int num_to_skip = static_cast<int>(
+              std::min<int64_t>(run->num_consumed - skipped,
+                                kMaxRecordsPerSkip));
+          int num_skipped;
+          TF_RETURN_IF_ERROR(run->reader->SkipRecords(num_to_skip,
+                                                      &num_skipped));
+          skipped += num_skipped;
+        }
+      }
+      tstring record;
+      TF_RETURN_IF_ERROR(run->reader->ReadRecord(&record));
+      CompressedElement compressed;
+      if (!compressed.ParseFromArray(record.data(), record.size())) {
+        return errors::DataLoss("Failed to parse an element of spill file ",
+                                run->filename);
+      }
+      TF_RETURN_IF_ERROR(UncompressElement(compressed, out_tensors));
+      if (++run->num_consumed == run->num_elements) {
+        run->reader.reset();
+        run->file.reset();
+      }
+      return Status::OK();
+    }
+
+    // Deletes the files of `runs_`, unless they may be needed to restore a
+    // saved state.
+    void DeleteRunFiles() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (keep_run_files_) return;
+      for (Run& run : runs_) {
+        run.reader.reset();
+        run.file.reset();
+        Status s = Env::Default()->DeleteFile(run.filename);
+        if (!s.ok()) {
+          LOG(WARNING) << "Failed to delete spill file " << run.filename
+                       << ": " << s;
+        }
+      }
+    }
+
+    mutex mu_;
+    std::pair<int64_t, int64_t> seeds_ TF_GUARDED_BY(mu_);
+    random::PhiloxRandom parent_generator_ TF_GUARDED_BY(mu_);
+    random::SingleSampleAdapter<random::PhiloxRandom> generator_
+        TF_GUARDED_BY(mu_);
+    int64_t num_random_samples_ TF_GUARDED_BY(mu_) = 0;
+
+    // Reset once the whole input has been read.
+    std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
+    // The elements of the last run, which stays in memory.
+    std::vector<std::vector<Tensor>> buffer_ TF_GUARDED_BY(mu_);
+    std::vector<Run> runs_ TF_GUARDED_BY(mu_);
+    // The prefix of the names of the files of the runs of this iterator.
+    const std::string file_prefix_;
+    // Whether the files of `runs_` are referenced by a saved state.
+    bool keep_run_files_ TF_GUARDED_BY(mu_) = false;
+  };
+
+  const DatasetBase* const input_;
+  const std::string spill_directory_;
+  const int64_t memory_budget_bytes_;
+  const int64_t readahead_bytes_;
+  const std::pair<int64_t, int64_t> seeds_;
+};
+
+SpillingShuffleDatasetOp::SpillingShuffleDatasetOp(OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {}
+
+void SpillingShuffleDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                           DatasetBase* input,
+                                           DatasetBase** output) {
+  tstring spill_directory;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<tstring>(ctx, kSpillDirectory,
+                                                   &spill_directory));
+  OP_REQUIRES(ctx, !spill_directory.empty(),
+              errors::InvalidArgument("`spill_directory` must not be empty."));
+  int64_t memory_budget_bytes;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kMemoryBudgetBytes,
+                                                   &memory_budget_bytes));
+  OP_REQUIRES(ctx, memory_budget_bytes > 0,
+              errors::InvalidArgument("`memory_budget_bytes` must be > 0, got ",
+                                      memory_budget_bytes));
+  int64_t readahead_bytes;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kReadaheadBytes,
+                                                   &readahead_bytes));
+  OP_REQUIRES(ctx, readahead_bytes >= 0,
+              errors::InvalidArgument("`readahead_bytes` must be >= 0, got ",
+                                      readahead_bytes));
+  int64_t seed;
+  int64_t seed2;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kSeed, &seed));
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kSeed2, &seed2));
+  OP_REQUIRES(ctx, input->Cardinality() != kInfiniteCardinality,
+              errors::InvalidArgument(
+                  "SpillingShuffleDataset requires a finite input dataset."));
+
+  *output = new Dataset(ctx, input, spill_directory, memory_budget_bytes,
+                        readahead_bytes, seed, seed2);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(Name("SpillingShuffleDataset").Device(DEVICE_CPU),
+                        SpillingShuffleDatasetOp);
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
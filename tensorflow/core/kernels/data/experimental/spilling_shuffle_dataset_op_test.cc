@@ -0,0 +1,291 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/spilling_shuffle_dataset_op.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/lib/io/path.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "spilling_shuffle_dataset";
+constexpr int64_t kRandomSeed = 42;
+constexpr int64_t kRandomSeed2 = 7;
+
+class SpillingShuffleDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  SpillingShuffleDatasetParams(T input_dataset_params,
+                               std::string spill_directory,
+                               int64_t memory_budget_bytes,
+                               int64_t readahead_bytes,
+                               DataTypeVector output_dtypes,
+                               std::vector<PartialTensorShape> output_shapes,
+                               string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        spill_directory_(std::move(spill_directory)),
+        memory_budget_bytes_(memory_budget_bytes),
+        readahead_bytes_(readahead_bytes) {
+    input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    return {CreateTensor<tstring>(TensorShape({}), {spill_directory_}),
+            CreateTensor<int64_t>(TensorShape({}), {memory_budget_bytes_}),
+            CreateTensor<int64_t>(TensorShape({}), {readahead_bytes_}),
+            CreateTensor<int64_t>(TensorShape({}), {kRandomSeed}),
+            CreateTensor<int64_t>(TensorShape({}), {kRandomSeed2})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {SpillingShuffleDatasetOp::kInputDataset,
+                    SpillingShuffleDatasetOp::kSpillDirectory,
+                    SpillingShuffleDatasetOp::kMemoryBudgetBytes,
+                    SpillingShuffleDatasetOp::kReadaheadBytes,
+                    SpillingShuffleDatasetOp::kSeed,
+                    SpillingShuffleDatasetOp::kSeed2};
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{SpillingShuffleDatasetOp::kOutputTypes, output_dtypes_},
+                    {SpillingShuffleDatasetOp::kOutputShapes, output_shapes_}};
+    return Status::OK();
+  }
+
+  string dataset_type() const override {
+    return SpillingShuffleDatasetOp::kDatasetType;
+  }
+
+  const std::string& spill_directory() const { return spill_directory_; }
+
+ private:
+  std::string spill_directory_;
+  int64_t memory_budget_bytes_;
+  int64_t readahead_bytes_;
+};
+
+class SpillingShuffleDatasetOpTest : public DatasetOpsTestBase {};
+
+// The elements are 8-byte scalars, so a run is spilled every 3 elements.
+SpillingShuffleDatasetParams SpillingParams() {
+  return SpillingShuffleDatasetParams(
+      RangeDatasetParams(0, 10, 1),
+      /*spill_directory=*/io::JoinPath(testing::TmpDir(), "spill_1"),
+      /*memory_budget_bytes=*/24,
+      /*readahead_bytes=*/16,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+}
+
+// The whole input fits in the memory budget.
+SpillingShuffleDatasetParams InMemoryParams() {
+  return SpillingShuffleDatasetParams(
+      RangeDatasetParams(0, 10, 1),
+      /*spill_directory=*/io::JoinPath(testing::TmpDir(), "spill_2"),
+      /*memory_budget_bytes=*/1 << 20,
+      /*readahead_bytes=*/0,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+}
+
+SpillingShuffleDatasetParams EmptyInputParams() {
+  return SpillingShuffleDatasetParams(
+      RangeDatasetParams(0, 0, 1),
+      /*spill_directory=*/io::JoinPath(testing::TmpDir(), "spill_3"),
+      /*memory_budget_bytes=*/24,
+      /*readahead_bytes=*/0,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+}
+
+SpillingShuffleDatasetParams InvalidMemoryBudgetParams() {
+  return SpillingShuffleDatasetParams(
+      RangeDatasetParams(0, 10, 1),
+      /*spill_directory=*/io::JoinPath(testing::TmpDir(), "spill_4"),
+      /*memory_budget_bytes=*/0,
+      /*readahead_bytes=*/0,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+}
+
+SpillingShuffleDatasetParams InvalidSpillDirectoryParams() {
+  return SpillingShuffleDatasetParams(
+      RangeDatasetParams(0, 10, 1),
+      /*spill_directory=*/"",
+      /*memory_budget_bytes=*/24,
+      /*readahead_bytes=*/0,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*node_name=*/kNodeName);
+}
+
+std::vector<Tensor> RangeOutputs() {
+  return CreateTensors<int64_t>(
+      TensorShape({}), {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}});
+}
+
+std::vector<GetNextTestCase<SpillingShuffleDatasetParams>> GetNextTestCases() {
+  return {{/*dataset_params=*/SpillingParams(),
+           /*expected_outputs=*/RangeOutputs(), /*compare_order=*/false},
+          {/*dataset_params=*/InMemoryParams(),
+           /*expected_outputs=*/RangeOutputs(), /*compare_order=*/false},
+          {/*dataset_params=*/EmptyInputParams(),
+           /*expected_outputs=*/{}, /*compare_order=*/false}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(SpillingShuffleDatasetOpTest,
+                         SpillingShuffleDatasetParams, GetNextTestCases())
+
+TEST_F(SpillingShuffleDatasetOpTest, OutputIsShuffled) {
+  auto dataset_params = SpillingParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+  }
+  EXPECT_FALSE(ExpectEqual(out_tensors, RangeOutputs(),
+                           /*compare_order=*/true)
+                   .ok());
+}
+
+TEST_F(SpillingShuffleDatasetOpTest, SpillFilesAreDeleted) {
+  auto dataset_params = SpillingParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> next;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+  std::vector<string> children;
+  TF_ASSERT_OK(
+      Env::Default()->GetChildren(dataset_params.spill_directory(), &children));
+  EXPECT_FALSE(children.empty());
+
+  // Destroying an iterator that was never saved deletes its spill files.
+  const size_t num_children = children.size();
+  iterator_.reset();
+  children.clear();
+  TF_ASSERT_OK(
+      Env::Default()->GetChildren(dataset_params.spill_directory(), &children));
+  EXPECT_LT(children.size(), num_children);
+}
+
+std::vector<DatasetNodeNameTestCase<SpillingShuffleDatasetParams>>
+DatasetNodeNameTestCases() {
+  return {{/*dataset_params=*/SpillingParams(),
+           /*expected_node_name=*/kNodeName}};
+}
+
+DATASET_NODE_NAME_TEST_P(SpillingShuffleDatasetOpTest,
+                         SpillingShuffleDatasetParams,
+                         DatasetNodeNameTestCases())
+
+std::vector<DatasetTypeStringTestCase<SpillingShuffleDatasetParams>>
+DatasetTypeStringTestCases() {
+  return {{/*dataset_params=*/SpillingParams(),
+           /*expected_dataset_type_string=*/name_utils::OpName(
+               SpillingShuffleDatasetOp::kDatasetType)}};
+}
+
+DATASET_TYPE_STRING_TEST_P(SpillingShuffleDatasetOpTest,
+                           SpillingShuffleDatasetParams,
+                           DatasetTypeStringTestCases())
+
+std::vector<DatasetOutputDtypesTestCase<SpillingShuffleDatasetParams>>
+DatasetOutputDtypesTestCases() {
+  return {{/*dataset_params=*/SpillingParams(),
+           /*expected_output_dtypes=*/{DT_INT64}}};
+}
+
+DATASET_OUTPUT_DTYPES_TEST_P(SpillingShuffleDatasetOpTest,
+                             SpillingShuffleDatasetParams,
+                             DatasetOutputDtypesTestCases())
+
+std::vector<DatasetOutputShapesTestCase<SpillingShuffleDatasetParams>>
+DatasetOutputShapesTestCases() {
+  return {{/*dataset_params=*/SpillingParams(),
+           /*expected_output_shapes=*/{PartialTensorShape({})}}};
+}
+
+DATASET_OUTPUT_SHAPES_TEST_P(SpillingShuffleDatasetOpTest,
+                             SpillingShuffleDatasetParams,
+                             DatasetOutputShapesTestCases())
+
+std::vector<CardinalityTestCase<SpillingShuffleDatasetParams>>
+CardinalityTestCases() {
+  return {{/*dataset_params=*/SpillingParams(),
+           /*expected_cardinality=*/10},
+          {/*dataset_params=*/EmptyInputParams(),
+           /*expected_cardinality=*/0}};
+}
+
+DATASET_CARDINALITY_TEST_P(SpillingShuffleDatasetOpTest,
+                           SpillingShuffleDatasetParams,
+                           CardinalityTestCases())
+
+std::vector<IteratorPrefixTestCase<SpillingShuffleDatasetParams>>
+IteratorOutputPrefixTestCases() {
+  return {{/*dataset_params=*/SpillingParams(),
+           /*expected_iterator_prefix=*/name_utils::IteratorPrefix(
+               SpillingShuffleDatasetOp::kDatasetType,
+               SpillingParams().iterator_prefix())}};
+}
+
+ITERATOR_PREFIX_TEST_P(SpillingShuffleDatasetOpTest,
+                       SpillingShuffleDatasetParams,
+                       IteratorOutputPrefixTestCases())
+
+std::vector<IteratorSaveAndRestoreTestCase<SpillingShuffleDatasetParams>>
+IteratorSaveAndRestoreTestCases() {
+  return {{/*dataset_params=*/SpillingParams(),
+           /*breakpoints=*/{0, 4, 11},
+           /*expected_outputs=*/RangeOutputs(), /*compare_order=*/false},
+          {/*dataset_params=*/InMemoryParams(),
+           /*breakpoints=*/{0, 4, 11},
+           /*expected_outputs=*/RangeOutputs(), /*compare_order=*/false}};
+}
+
+ITERATOR_SAVE_AND_RESTORE_TEST_P(SpillingShuffleDatasetOpTest,
+                                 SpillingShuffleDatasetParams,
+                                 IteratorSaveAndRestoreTestCases())
+
+TEST_F(SpillingShuffleDatasetOpTest, InvalidArguments) {
+  std::vector<SpillingShuffleDatasetParams> dataset_params_vec(
+      {InvalidMemoryBudgetParams(), InvalidSpillDirectoryParams()});
+  for (const auto& dataset_params : dataset_params_vec) {
+    EXPECT_EQ(Initialize(dataset_params).code(),
+              tensorflow::error::INVALID_ARGUMENT);
+  }
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -50,6 +50,12 @@ class QueryConnection {
   // to `Open()`.
   virtual Status Open(const string& data_source_name, const string& query,
                       const DataTypeVector& output_types) = 0;
+  // Like `Open()`, but opens the database read-only, so that any number of
+  // connections can read it concurrently. Fails if the database doesn't
+  // exist.
+  virtual Status OpenReadOnly(const string& data_source_name,
+                              const string& query,
+                              const DataTypeVector& output_types) = 0;
   // Closes an opened connection.
   virtual Status Close() = 0;
   // Retrieves the next row of the result set of the query from the most recent
@@ -63,6 +69,21 @@ class QueryConnection {
   // undefined.
   virtual Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                          bool* end_of_sequence) = 0;
+  // Binds the integer parameter named `parameter` (e.g. ":rowid_begin") of
+  // the query to `value`. Must be called before the first row is retrieved.
+  virtual Status BindInt(const string& parameter, int64_t value) = 0;
+  // Retrieves the next rows of the result set, up to `batch_size` of them.
+  //
+  // The rows are stored in `*out_tensors` as one vector per column, of the
+  // number of rows retrieved, which is stored in `*num_rows`. It is less than
+  // `batch_size` only at the end of the result set, and 0 if there are no more
+  // rows, in which case nothing is added to `*out_tensors`.
+  virtual Status GetNextBatch(IteratorContext* ctx, int64_t batch_size,
+                              std::vector<Tensor>* out_tensors,
+                              int64_t* num_rows) = 0;
+  // Skips the next rows of the result set, up to `num_rows` of them, without
+  // converting them, and stores the number of rows skipped in `*num_skipped`.
+  virtual Status SkipRows(int64_t num_rows, int64_t* num_skipped) = 0;
 };
 
 }  // namespace sql
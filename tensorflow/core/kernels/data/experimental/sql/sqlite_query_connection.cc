@@ -32,20 +32,36 @@ SqliteQueryConnection::~SqliteQueryConnection() {
 Status SqliteQueryConnection::Open(const string& data_source_name,
                                    const string& query,
                                    const DataTypeVector& output_types) {
+  return OpenWithFlags(data_source_name, query, output_types,
+                       SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+}
+
+Status SqliteQueryConnection::OpenReadOnly(const string& data_source_name,
+                                           const string& query,
+                                           const DataTypeVector& output_types) {
+  return OpenWithFlags(data_source_name, query, output_types,
+                       SQLITE_OPEN_READONLY);
+}
+
+Status SqliteQueryConnection::OpenWithFlags(const string& data_source_name,
+                                            const string& query,
+                                            const DataTypeVector& output_types,
+                                            int flags) {
   if (db_ != nullptr) {
     return errors::FailedPrecondition(
         "Failed to open query connection: Connection already opened.");
   }
-  TF_RETURN_IF_ERROR(Sqlite::Open(
-      data_source_name, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, &db_));
+  TF_RETURN_IF_ERROR(Sqlite::Open(data_source_name, flags, &db_));
   query_ = query;
   output_types_ = output_types;
+  done_ = false;
   return Status::OK();
 }
 
 Status SqliteQueryConnection::Close() {
   stmt_ = SqliteStatement();
-  db_->Unref();
+  // `db_` is null if `Open()` failed.
+  if (db_ != nullptr) db_->Unref();
   db_ = nullptr;
   return Status::OK();
 }
@@ -54,15 +70,79 @@ Status SqliteQueryConnection::GetNext(IteratorContext* ctx,
                                       std::vector<Tensor>* out_tensors,
                                       bool* end_of_sequence) {
   if (!stmt_) TF_RETURN_IF_ERROR(PrepareQuery());
-  TF_RETURN_IF_ERROR(stmt_.Step(end_of_sequence));
+  TF_RETURN_IF_ERROR(Step(end_of_sequence));
   if (!*end_of_sequence) {
     for (int i = 0; i < column_count_; i++) {
       DataType dt = output_types_[i];
       // TODO(mrry): Pass in the `IteratorContext::allocator()`.
       out_tensors->emplace_back(ctx->allocator({}), dt, TensorShape({}));
-      FillTensorWithResultSetEntry(dt, i, &out_tensors->back());
+      FillTensorWithResultSetEntry(dt, i, 0, &out_tensors->back());
+    }
+  }
+  return Status::OK();
+}
+
+Status SqliteQueryConnection::BindInt(const string& parameter,
+                                      int64_t value) {
+  if (!stmt_) TF_RETURN_IF_ERROR(PrepareQuery());
+  if (!stmt_.HasParameter(parameter.c_str())) {
+    return errors::InvalidArgument("The query has no parameter named ",
+                                   parameter, ": ", query_);
+  }
+  stmt_.BindInt(parameter.c_str(), value);
+  return Status::OK();
+}
+
+Status SqliteQueryConnection::GetNextBatch(IteratorContext* ctx,
+                                           int64_t batch_size,
+                                           std::vector<Tensor>* out_tensors,
+                                           int64_t* num_rows) {
+  if (!stmt_) TF_RETURN_IF_ERROR(PrepareQuery());
+  *num_rows = 0;
+  if (done_) return Status::OK();
+  std::vector<Tensor> columns;
+  columns.reserve(column_count_);
+  for (int i = 0; i < column_count_; i++) {
+    columns.emplace_back(ctx->allocator({}), output_types_[i],
+                         TensorShape({batch_size}));
+  }
+  bool end_of_sequence = false;
+  while (*num_rows < batch_size) {
+    TF_RETURN_IF_ERROR(Step(&end_of_sequence));
+    if (end_of_sequence) break;
+    for (int i = 0; i < column_count_; i++) {
+      FillTensorWithResultSetEntry(output_types_[i], i, *num_rows,
+                                   &columns[i]);
     }
+    ++*num_rows;
   }
+  if (*num_rows == 0) return Status::OK();
+  for (Tensor& column : columns) {
+    out_tensors->push_back(*num_rows == batch_size
+                               ? std::move(column)
+                               : column.Slice(0, *num_rows));
+  }
+  return Status::OK();
+}
+
+Status SqliteQueryConnection::SkipRows(int64_t num_rows,
+                                       int64_t* num_skipped) {
+  if (!stmt_) TF_RETURN_IF_ERROR(PrepareQuery());
+  bool end_of_sequence = false;
+  for (*num_skipped = 0; *num_skipped < num_rows; ++*num_skipped) {
+    TF_RETURN_IF_ERROR(Step(&end_of_sequence));
+    if (end_of_sequence) break;
+  }
+  return Status::OK();
+}
+
+Status SqliteQueryConnection::Step(bool* end_of_sequence) {
+  if (done_) {
+    *end_of_sequence = true;
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(stmt_.Step(end_of_sequence));
+  done_ = *end_of_sequence;
   return Status::OK();
 }
 
@@ -81,10 +161,11 @@ Status SqliteQueryConnection::PrepareQuery() {
 }
 
 void SqliteQueryConnection::FillTensorWithResultSetEntry(
-    const DataType& data_type, int column_index, Tensor* tensor) {
-#define CASE(T, M)                                                 \
-  case DataTypeToEnum<T>::value:                                   \
-    tensor->scalar<T>()() = static_cast<T>(stmt_.M(column_index)); \
+    const DataType& data_type, int column_index, int64_t index,
+    Tensor* tensor) {
+#define CASE(T, M)                                                     \
+  case DataTypeToEnum<T>::value:                                       \
+    tensor->flat<T>()(index) = static_cast<T>(stmt_.M(column_index)); \
     break;
 #define INT_CASE(T) CASE(T, ColumnInt)
 #define DOUBLE_CASE(T) CASE(T, ColumnDouble)
@@ -103,7 +184,7 @@ void SqliteQueryConnection::FillTensorWithResultSetEntry(
     TF_CALL_double(DOUBLE_CASE)
     TF_CALL_tstring(STRING_CASE)
     case DT_BOOL:
-      tensor->scalar<bool>()() = stmt_.ColumnInt(column_index) != 0;
+      tensor->flat<bool>()(index) = stmt_.ColumnInt(column_index) != 0;
       break;
     // Error preemptively thrown by SqlDatasetOp::MakeDataset in this case.
     default:
@@ -32,20 +32,35 @@ class SqliteQueryConnection : public QueryConnection {
   ~SqliteQueryConnection() override;
   Status Open(const string& data_source_name, const string& query,
               const DataTypeVector& output_types) override;
+  Status OpenReadOnly(const string& data_source_name, const string& query,
+                      const DataTypeVector& output_types) override;
   Status Close() override;
   Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                  bool* end_of_sequence) override;
+  Status BindInt(const string& parameter, int64_t value) override;
+  Status GetNextBatch(IteratorContext* ctx, int64_t batch_size,
+                      std::vector<Tensor>* out_tensors,
+                      int64_t* num_rows) override;
+  Status SkipRows(int64_t num_rows, int64_t* num_skipped) override;
 
  private:
+  // Opens the database with the SQLite open `flags`.
+  Status OpenWithFlags(const string& data_source_name, const string& query,
+                       const DataTypeVector& output_types, int flags);
   // Prepares the query string `query_`.
   Status PrepareQuery();
-  // Fills `tensor` with the column_index_th element of the current row of
-  // `stmt_`.
+  // Steps to the next row of `stmt_`, or stores `true` in `*end_of_sequence`
+  // once there are no more rows, without stepping past the end, which would
+  // restart the query.
+  Status Step(bool* end_of_sequence);
+  // Fills the index_th element of `tensor` with the column_index_th element
+  // of the current row of `stmt_`.
   void FillTensorWithResultSetEntry(const DataType& data_type, int column_index,
-                                    Tensor* tensor);
+                                    int64_t index, Tensor* tensor);
   Sqlite* db_ = nullptr;
   SqliteStatement stmt_;
   int column_count_ = 0;
+  bool done_ = false;
   string query_;
   DataTypeVector output_types_;
 };
@@ -12,8 +12,12 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <deque>
+#include <functional>
 #include <utility>
 
+#include "absl/strings/str_replace.h"
+#include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -28,11 +32,45 @@ namespace data {
 namespace experimental {
 namespace {
 
+constexpr char kBatchSize[] = "batch_size";
+constexpr char kNumParallelReads[] = "num_parallel_reads";
+constexpr char kRowidTable[] = "rowid_table";
+constexpr char kRowidBegin[] = ":rowid_begin";
+constexpr char kRowidEnd[] = ":rowid_end";
+// The number of batches each reader of a batched dataset fetches ahead.
+constexpr size_t kBatchesPerReader = 2;
+
+// Returns `name` quoted as an SQL identifier.
+string QuoteIdentifier(const string& name) {
+  return strings::StrCat("\"", absl::StrReplaceAll(name, {{"\"", "\"\""}}),
+                         "\"");
+}
+
 class SqlDatasetOp : public DatasetOpKernel {
  public:
   explicit SqlDatasetOp(OpKernelConstruction* ctx) : DatasetOpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    // ExperimentalSqlDataset has no batched mode.
+    if (ctx->HasAttr(kBatchSize)) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr(kBatchSize, &batch_size_));
+      OP_REQUIRES_OK(ctx,
+                     ctx->GetAttr(kNumParallelReads, &num_parallel_reads_));
+      OP_REQUIRES_OK(ctx, ctx->GetAttr(kRowidTable, &rowid_table_));
+    }
+    OP_REQUIRES(ctx, batch_size_ >= 0,
+                errors::InvalidArgument("`batch_size` must be >= 0."));
+    OP_REQUIRES(ctx, num_parallel_reads_ >= 1,
+                errors::InvalidArgument("`num_parallel_reads` must be >= 1."));
+    OP_REQUIRES(ctx,
+                batch_size_ > 0 ||
+                    (num_parallel_reads_ == 1 && rowid_table_.empty()),
+                errors::InvalidArgument(
+                    "`num_parallel_reads` and `rowid_table` require a "
+                    "positive `batch_size`."));
+    OP_REQUIRES(ctx, num_parallel_reads_ == 1 || !rowid_table_.empty(),
+                errors::InvalidArgument(
+                    "`num_parallel_reads` > 1 requires a `rowid_table`."));
     for (const DataType& dt : output_types_) {
       OP_REQUIRES(ctx,
                   dt == DT_STRING || dt == DT_INT8 || dt == DT_INT16 ||
@@ -44,9 +82,16 @@ class SqlDatasetOp : public DatasetOpKernel {
                       "DT_UINT8, DT_UINT16, DT_BOOL, DT_DOUBLE "));
     }
     for (const PartialTensorShape& pts : output_shapes_) {
-      OP_REQUIRES(ctx, pts.dims() == 0,
-                  errors::InvalidArgument(
-                      "Each element of `output_shapes_` must be a scalar."));
+      if (batch_size_ > 0) {
+        OP_REQUIRES(ctx, pts.dims() == 1,
+                    errors::InvalidArgument(
+                        "Each element of `output_shapes_` must be a vector "
+                        "when `batch_size` is positive."));
+      } else {
+        OP_REQUIRES(ctx, pts.dims() == 0,
+                    errors::InvalidArgument(
+                        "Each element of `output_shapes_` must be a scalar."));
+      }
     }
   }
   void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
@@ -70,25 +115,46 @@ class SqlDatasetOp : public DatasetOpKernel {
                     driver_name.c_str())));
 
     *output = new Dataset(ctx, driver_name, data_source_name, query,
-                          output_types_, output_shapes_);
+                          output_types_, output_shapes_, batch_size_,
+                          num_parallel_reads_, rowid_table_);
   }
 
  private:
+  // Without a `batch_size`, the rows of the result set are fetched one per
+  // GetNext() call, as scalars.
+  //
+  // With a `batch_size`, each element is a batch of up to `batch_size` rows,
+  // as one vector per column, and the rows are fetched ahead by
+  // `num_parallel_reads` background threads, each stepping through its own
+  // read-only connection. With a `rowid_table`, the rowids of the table are
+  // split into as many disjoint ranges as readers, and each reader binds its
+  // range, as [:rowid_begin, :rowid_end), to the parameters of the query of
+  // those names. The readers' batches are interleaved in a fixed round-robin
+  // order, so the order of the elements is deterministic.
   class Dataset : public DatasetBase {
    public:
     Dataset(OpKernelContext* ctx, const string& driver_name,
             const string& data_source_name, const string& query,
             const DataTypeVector& output_types,
-            const std::vector<PartialTensorShape>& output_shapes)
+            const std::vector<PartialTensorShape>& output_shapes,
+            int64_t batch_size, int64_t num_parallel_reads,
+            const string& rowid_table)
         : DatasetBase(DatasetContext(ctx)),
           driver_name_(driver_name),
           data_source_name_(data_source_name),
           query_(query),
           output_types_(output_types),
-          output_shapes_(output_shapes) {}
+          output_shapes_(output_shapes),
+          batch_size_(batch_size),
+          num_parallel_reads_(num_parallel_reads),
+          rowid_table_(rowid_table) {}
 
     std::unique_ptr<IteratorBase> MakeIteratorInternal(
         const string& prefix) const override {
+      if (batch_size_ > 0) {
+        return absl::make_unique<BatchedIterator>(
+            BatchedIterator::Params{this, strings::StrCat(prefix, "::Sql")});
+      }
       return absl::make_unique<Iterator>(
           Iterator::Params{this, strings::StrCat(prefix, "::Sql")});
     }
@@ -121,8 +187,23 @@ class SqlDatasetOp : public DatasetOpKernel {
           b->AddScalar(data_source_name_, &data_source_name_node));
       Node* query_node;
       TF_RETURN_IF_ERROR(b->AddScalar(query_, &query_node));
+      // The batched attrs are omitted otherwise, since ExperimentalSqlDataset
+      // doesn't have them.
+      std::vector<std::pair<StringPiece, AttrValue>> attrs;
+      if (batch_size_ > 0) {
+        AttrValue batch_size;
+        b->BuildAttrValue(batch_size_, &batch_size);
+        AttrValue num_parallel_reads;
+        b->BuildAttrValue(num_parallel_reads_, &num_parallel_reads);
+        AttrValue rowid_table;
+        b->BuildAttrValue(rowid_table_, &rowid_table);
+        attrs = {{kBatchSize, batch_size},
+                 {kNumParallelReads, num_parallel_reads},
+                 {kRowidTable, rowid_table}};
+      }
       TF_RETURN_IF_ERROR(b->AddDataset(
-          this, {driver_name_node, data_source_name_node, query_node}, output));
+          this, {driver_name_node, data_source_name_node, query_node}, attrs,
+          output));
       return Status::OK();
     }
 
@@ -220,14 +301,254 @@ class SqlDatasetOp : public DatasetOpKernel {
       bool query_connection_initialized_ TF_GUARDED_BY(mu_) = false;
       bool end_of_sequence_ TF_GUARDED_BY(mu_) = false;
     };
+
+    class BatchedIterator : public DatasetIterator<Dataset> {
+     public:
+      explicit BatchedIterator(const Params& params)
+          : DatasetIterator<Dataset>(params),
+            rows_consumed_(params.dataset->num_parallel_reads_, 0) {}
+
+      ~BatchedIterator() override {
+        StopReaders();
+        if (deregister_fn_) deregister_fn_();
+      }
+
+      Status Initialize(IteratorContext* ctx) override {
+        return RegisterCancellationCallback(
+            ctx->cancellation_manager(), [this]() { CancelThreads(); },
+            &deregister_fn_);
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(EnsureReadersStarted(ctx));
+        // Takes the next batch of the first reader in round-robin order that
+        // has one to come.
+        const int num_readers = readers_.size();
+        for (int i = 0; i < num_readers; ++i) {
+          Reader* reader = readers_[next_reader_].get();
+          while (!cancelled_ && reader->batches.empty() && !reader->finished) {
+            RecordStop(ctx);
+            cond_var_.wait(l);
+            RecordStart(ctx);
+          }
+          if (cancelled_) {
+            return errors::Cancelled("Iterator was cancelled");
+          }
+          if (reader->batches.empty()) {
+            next_reader_ = (next_reader_ + 1) % num_readers;
+            continue;
+          }
+          Batch batch = std::move(reader->batches.front());
+          reader->batches.pop_front();
+          cond_var_.notify_all();
+          TF_RETURN_IF_ERROR(batch.status);
+          rows_consumed_[next_reader_] += batch.tensors[0].dim_size(0);
+          next_reader_ = (next_reader_ + 1) % num_readers;
+          *out_tensors = std::move(batch.tensors);
+          *end_of_sequence = false;
+          return Status::OK();
+        }
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeSourceNode(std::move(args));
+      }
+
+      Status SaveInternal(SerializationContext* ctx,
+                          IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(full_name("next_reader"), next_reader_));
+        for (int64_t i = 0; i < dataset()->num_parallel_reads_; ++i) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              full_name(strings::StrCat("rows_consumed_", i)),
+              rows_consumed_[i]));
+        }
+        return Status::OK();
+      }
+
+      // The readers are restarted on the next GetNext() call, and skip the
+      // rows that were consumed.
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        StopReaders();
+        mutex_lock l(mu_);
+        cancelled_ = false;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(full_name("next_reader"), &next_reader_));
+        for (int64_t i = 0; i < dataset()->num_parallel_reads_; ++i) {
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              full_name(strings::StrCat("rows_consumed_", i)),
+              &rows_consumed_[i]));
+        }
+        return Status::OK();
+      }
+
+     private:
+      struct Batch {
+        Status status;
+        std::vector<Tensor> tensors;
+      };
+
+      struct Reader {
+        int64_t rowid_begin = 0;
+        int64_t rowid_end = 0;
+        // Guarded by `mu_`.
+        std::deque<Batch> batches;
+        bool finished = false;
+        // Last, so that the thread is joined before the rest is destroyed.
+        std::unique_ptr<Thread> thread;
+      };
+
+      void CancelThreads() TF_LOCKS_EXCLUDED(mu_) {
+        mutex_lock l(mu_);
+        cancelled_ = true;
+        cond_var_.notify_all();
+      }
+
+      // Cancels and joins the reader threads.
+      void StopReaders() TF_LOCKS_EXCLUDED(mu_) {
+        std::vector<std::unique_ptr<Reader>> readers;
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          cond_var_.notify_all();
+          std::swap(readers, readers_);
+        }
+        readers.clear();
+      }
+
+      Status EnsureReadersStarted(IteratorContext* ctx)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!readers_.empty()) return Status::OK();
+        const int64_t num_readers = dataset()->num_parallel_reads_;
+        int64_t rowid_begin = 0;
+        int64_t rows_per_reader = 0;
+        if (!dataset()->rowid_table_.empty()) {
+          int64_t rowid_end;
+          TF_RETURN_IF_ERROR(ReadRowidRange(ctx, &rowid_begin, &rowid_end));
+          rows_per_reader =
+              (rowid_end - rowid_begin + num_readers - 1) / num_readers;
+        }
+        std::shared_ptr<IteratorContext> new_ctx =
+            std::make_shared<IteratorContext>(*ctx);
+        for (int64_t i = 0; i < num_readers; ++i) {
+          readers_.push_back(absl::make_unique<Reader>());
+          Reader* reader = readers_.back().get();
+          reader->rowid_begin = rowid_begin + i * rows_per_reader;
+          reader->rowid_end = reader->rowid_begin + rows_per_reader;
+        }
+        for (int64_t i = 0; i < num_readers; ++i) {
+          Reader* reader = readers_[i].get();
+          const int64_t rows_to_skip = rows_consumed_[i];
+          reader->thread = ctx->StartThread(
+              "tf_data_sql_reader", [this, new_ctx, reader, rows_to_skip]() {
+                ReaderThread(new_ctx, reader, rows_to_skip);
+              });
+        }
+        return Status::OK();
+      }
+
+      // Reads the range [*rowid_begin, *rowid_end) of the rowids of the rowid
+      // table.
+      Status ReadRowidRange(IteratorContext* ctx, int64_t* rowid_begin,
+                            int64_t* rowid_end) {
+        std::unique_ptr<sql::QueryConnection> connection =
+            sql::DriverManager::CreateQueryConnection(dataset()->driver_name_);
+        std::vector<Tensor> range;
+        bool end_of_sequence = false;
+        Status s = connection->OpenReadOnly(
+            dataset()->data_source_name_,
+            strings::StrCat("SELECT min(rowid), max(rowid) FROM ",
+                            QuoteIdentifier(dataset()->rowid_table_)),
+            {DT_INT64, DT_INT64});
+        if (s.ok()) s = connection->GetNext(ctx, &range, &end_of_sequence);
+        connection->Close().IgnoreError();
+        TF_RETURN_IF_ERROR(s);
+        // An empty table has a range of NULLs, read as 0.
+        *rowid_begin = range[0].scalar<int64_t>()();
+        *rowid_end = range[1].scalar<int64_t>()() + 1;
+        return Status::OK();
+      }
+
+      // Opens a read-only connection for `reader`, skips the first
+      // `rows_to_skip` rows of its range and fetches the rest into its
+      // batches, until they are all fetched or the iterator is cancelled.
+      void ReaderThread(const std::shared_ptr<IteratorContext>& ctx,
+                        Reader* reader, int64_t rows_to_skip) {
+        std::unique_ptr<sql::QueryConnection> connection =
+            sql::DriverManager::CreateQueryConnection(dataset()->driver_name_);
+        Status s = connection->OpenReadOnly(dataset()->data_source_name_,
+                                            dataset()->query_,
+                                            dataset()->output_types_);
+        if (s.ok() && !dataset()->rowid_table_.empty()) {
+          s = connection->BindInt(kRowidBegin, reader->rowid_begin);
+          if (s.ok()) s = connection->BindInt(kRowidEnd, reader->rowid_end);
+        }
+        int64_t num_rows = 0;
+        if (s.ok() && rows_to_skip > 0) {
+          s = connection->SkipRows(rows_to_skip, &num_rows);
+        }
+        while (s.ok()) {
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ && reader->batches.size() >= kBatchesPerReader) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_) break;
+          }
+          Batch batch;
+          s = connection->GetNextBatch(ctx.get(), dataset()->batch_size_,
+                                       &batch.tensors, &num_rows);
+          if (!s.ok() || num_rows == 0) break;
+          mutex_lock l(mu_);
+          reader->batches.push_back(std::move(batch));
+          cond_var_.notify_all();
+          if (num_rows < dataset()->batch_size_) break;
+        }
+        Status close_status = connection->Close();
+        if (!close_status.ok()) {
+          LOG(WARNING) << "Failed to close query connection: " << close_status;
+        }
+        mutex_lock l(mu_);
+        if (!s.ok()) reader->batches.push_back({s, {}});
+        reader->finished = true;
+        cond_var_.notify_all();
+      }
+
+      mutex mu_;
+      condition_variable cond_var_;
+      std::vector<std::unique_ptr<Reader>> readers_ TF_GUARDED_BY(mu_);
+      // The reader of the next batch, and the number of rows of each reader
+      // consumed, which it skips when restored.
+      int64_t next_reader_ TF_GUARDED_BY(mu_) = 0;
+      std::vector<int64_t> rows_consumed_ TF_GUARDED_BY(mu_);
+      bool cancelled_ TF_GUARDED_BY(mu_) = false;
+      // Deregisters the cancellation callback.
+      std::function<void()> deregister_fn_;
+    };
+
     const tstring driver_name_;
     const tstring data_source_name_;
     const tstring query_;
     const DataTypeVector output_types_;
     const std::vector<PartialTensorShape> output_shapes_;
+    const int64_t batch_size_;
+    const int64_t num_parallel_reads_;
+    const string rowid_table_;
   };
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
+  int64_t batch_size_ = 0;
+  int64_t num_parallel_reads_ = 1;
+  string rowid_table_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("SqlDataset").Device(DEVICE_CPU), SqlDatasetOp);
@@ -0,0 +1,251 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Benchmarks of input pipelines that read TFRecord files from storage of
+// different latency and bandwidth, e.g.
+//
+//   bazel run -c opt :input_pipeline_benchmark_test -- --benchmark_filter=all
+//
+// Besides the elements per second, each benchmark reports the CPU time per
+// element and the time the pipeline took to reach 90% of its final rate,
+// which is mostly the time the autotuner took to converge when the
+// parallelism is autotuned.
+
+#include <algorithm>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/data/standalone.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/data/simulated_storage_file_system.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr int kNumFiles = 16;
+constexpr int kRecordsPerFile = 256;
+constexpr int kRecordBytes = 16 << 10;
+constexpr int kBatchSize = 32;
+// The number of batches over which the rate is measured for convergence.
+constexpr int kRateWindow = 20;
+
+enum Profile { kLocalNvme = 0, kRemoteObjectStore = 1 };
+
+// Writes the TFRecord files once, and returns their paths in the simulated
+// file system.
+const std::vector<std::string>& RecordFiles() {
+  static const std::vector<std::string>* const files = [] {
+    auto* files = new std::vector<std::string>();
+    const std::string record(kRecordBytes, 'x');
+    for (int i = 0; i < kNumFiles; ++i) {
+      const std::string path =
+          io::JoinPath(testing::TmpDir(),
+                       strings::StrCat("input_pipeline_", i, ".tfrecord"));
+      std::unique_ptr<WritableFile> file;
+      TF_CHECK_OK(Env::Default()->NewWritableFile(path, &file));
+      io::RecordWriter writer(file.get());
+      for (int j = 0; j < kRecordsPerFile; ++j) {
+        TF_CHECK_OK(writer.WriteRecord(record));
+      }
+      TF_CHECK_OK(writer.Close());
+      TF_CHECK_OK(file->Close());
+      files->push_back(SimulatedStorageFileSystem::Path(path));
+    }
+    return files;
+  }();
+  return *files;
+}
+
+// Parses a record into a vector of floats.
+FunctionDef DecodeRecord() {
+  return FunctionDefHelper::Create(
+      "DecodeRecord", {"record: string"}, {"output: float"}, {},
+      {{{"raw"}, "DecodeRaw", {"record"}, {{"out_type", DT_UINT8}}},
+       {{"cast"},
+        "Cast",
+        {"raw:output:0"},
+        {{"SrcT", DT_UINT8}, {"DstT", DT_FLOAT}}}},
+      {{"output", "cast:y:0"}});
+}
+
+Node* Int64(Graph* g, int64_t value) {
+  return test::graph::Constant(g, test::AsScalar<int64_t>(value));
+}
+
+// Returns the graph of
+//
+//   TFRecordDataset(files).repeat().map(DecodeRecord, parallelism)
+//       .batch(kBatchSize).prefetch(AUTOTUNE)
+GraphDef PipelineGraph(int64_t parallelism, int64_t readahead_depth) {
+  Graph g(OpRegistry::Global());
+  FunctionDefLibrary library;
+  *library.add_function() = DecodeRecord();
+  TF_CHECK_OK(g.AddFunctionLibrary(library));
+
+  const std::vector<std::string>& files = RecordFiles();
+  Tensor filenames(DT_STRING, TensorShape({kNumFiles}));
+  for (int i = 0; i < kNumFiles; ++i) filenames.vec<tstring>()(i) = files[i];
+
+  Node* records;
+  TF_CHECK_OK(NodeBuilder("records", "TFRecordDataset")
+                  .Input(test::graph::Constant(&g, filenames))
+                  .Input(test::graph::Constant(
+                      &g, test::AsScalar<tstring>(tstring(""))))
+                  .Input(Int64(&g, 256 << 10))
+                  .Attr("readahead_depth", readahead_depth)
+                  .Finalize(&g, &records));
+  Node* repeat;
+  TF_CHECK_OK(NodeBuilder("repeat", "RepeatDataset")
+                  .Input(records)
+                  .Input(Int64(&g, -1))
+                  .Attr("output_types", DataTypeVector{DT_STRING})
+                  .Attr("output_shapes",
+                        std::vector<PartialTensorShape>{TensorShape({})})
+                  .Finalize(&g, &repeat));
+  NameAttrList func;
+  func.set_name("DecodeRecord");
+  Node* map;
+  TF_CHECK_OK(NodeBuilder("map", "ParallelMapDatasetV2")
+                  .Input(repeat)
+                  .Input(std::vector<NodeBuilder::NodeOut>())
+                  .Input(Int64(&g, parallelism))
+                  .Attr("f", func)
+                  .Attr("Targuments", DataTypeVector())
+                  .Attr("output_types", DataTypeVector{DT_FLOAT})
+                  .Attr("output_shapes",
+                        std::vector<PartialTensorShape>{
+                            PartialTensorShape({-1})})
+                  .Finalize(&g, &map));
+  Node* batch;
+  TF_CHECK_OK(NodeBuilder("batch", "BatchDatasetV2")
+                  .Input(map)
+                  .Input(Int64(&g, kBatchSize))
+                  .Input(test::graph::Constant(&g, test::AsScalar<bool>(true)))
+                  .Attr("output_types", DataTypeVector{DT_FLOAT})
+                  .Attr("output_shapes",
+                        std::vector<PartialTensorShape>{
+                            PartialTensorShape({kBatchSize, -1})})
+                  .Finalize(&g, &batch));
+  Node* prefetch;
+  TF_CHECK_OK(NodeBuilder("prefetch", "PrefetchDataset")
+                  .Input(batch)
+                  .Input(Int64(&g, model::kAutotune))
+                  .Attr("output_types", DataTypeVector{DT_FLOAT})
+                  .Attr("output_shapes",
+                        std::vector<PartialTensorShape>{
+                            PartialTensorShape({kBatchSize, -1})})
+                  .Finalize(&g, &prefetch));
+  Node* retval;
+  TF_CHECK_OK(NodeBuilder("retval", "_Retval")
+                  .Input(prefetch)
+                  .Attr("T", DT_VARIANT)
+                  .Attr("index", 0)
+                  .Finalize(&g, &retval));
+  GraphDef graph_def;
+  g.ToGraphDef(&graph_def);
+  return graph_def;
+}
+
+// Returns the seconds from the first batch until the rate over a window of
+// batches first reached 90% of the rate over the second half of the run.
+double ConvergenceSeconds(const std::vector<uint64>& batch_times_us) {
+  const int n = batch_times_us.size();
+  if (n < 2 * kRateWindow) return 0;
+  const double final_rate =
+      (n - 1 - n / 2) / static_cast<double>(batch_times_us[n - 1] -
+                                            batch_times_us[n / 2] + 1);
+  for (int i = kRateWindow; i < n; ++i) {
+    const double rate =
+        kRateWindow / static_cast<double>(batch_times_us[i] -
+                                          batch_times_us[i - kRateWindow] + 1);
+    if (rate >= 0.9 * final_rate) {
+      return (batch_times_us[i] - batch_times_us[0]) / 1e6;
+    }
+  }
+  return (batch_times_us[n - 1] - batch_times_us[0]) / 1e6;
+}
+
+// Args: the storage profile, the map parallelism or -1 to autotune it, and
+// the readahead depth of the TFRecord reader.
+void BM_InputPipeline(::testing::benchmark::State& state) {
+  const int profile = state.range(0);
+  const int64_t parallelism = state.range(1);
+  const int64_t readahead_depth = state.range(2);
+  SimulatedStorageFileSystem::SetStorageProfile(
+      profile == kLocalNvme ? StorageProfile::LocalNvme()
+                            : StorageProfile::RemoteObjectStore());
+
+  std::unique_ptr<standalone::Dataset> dataset;
+  TF_CHECK_OK(standalone::Dataset::FromGraph(
+      {}, PipelineGraph(parallelism, readahead_depth), &dataset));
+  std::unique_ptr<standalone::Iterator> iterator;
+  TF_CHECK_OK(dataset->MakeIterator(&iterator));
+
+  std::vector<uint64> batch_times_us;
+  const std::clock_t start_cpu = std::clock();
+  for (auto s : state) {
+    std::vector<Tensor> outputs;
+    bool end_of_input;
+    TF_CHECK_OK(iterator->GetNext(&outputs, &end_of_input));
+    CHECK(!end_of_input);
+    batch_times_us.push_back(Env::Default()->NowMicros());
+  }
+  const double cpu_seconds =
+      static_cast<double>(std::clock() - start_cpu) / CLOCKS_PER_SEC;
+  // The CPU time of all threads of the process, most of which are the
+  // pipeline's.
+  const int64_t elements = state.iterations() * kBatchSize;
+  state.SetItemsProcessed(elements);
+  state.counters["cpu_us_per_element"] = cpu_seconds * 1e6 / elements;
+  state.counters["convergence_s"] = ConvergenceSeconds(batch_times_us);
+  state.SetLabel(profile == kLocalNvme ? "local_nvme" : "remote_object_store");
+
+  iterator.reset();
+  dataset.reset();
+  SimulatedStorageFileSystem::SetStorageProfile(StorageProfile());
+}
+
+BENCHMARK(BM_InputPipeline)
+    ->Args({kLocalNvme, 1, 0})
+    ->Args({kLocalNvme, 8, 0})
+    ->Args({kLocalNvme, -1, 0})
+    ->Args({kRemoteObjectStore, 8, 0})
+    ->Args({kRemoteObjectStore, -1, 0})
+    ->Args({kRemoteObjectStore, -1, 4})
+    ->Args({kRemoteObjectStore, -1, 16})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
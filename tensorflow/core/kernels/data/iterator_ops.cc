@@ -59,6 +59,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -76,6 +77,22 @@ const char kOutputTypes[] = "output_types";
 // Safely subtracts x from y avoiding underflow.
 inline uint64 safe_sub(uint64 x, uint64 y) { return x >= y ? x - y : 0; }
 
+// Returns the directory for incremental iterator checkpoints, which can be set
+// with TF_DATA_INCREMENTAL_CHECKPOINT_DIR. Returns an empty string, disabling
+// incremental checkpoints, by default.
+const std::string& IncrementalCheckpointDir() {
+  static const std::string* dir = [] {
+    std::string value;
+    Status s = ReadStringFromEnvVar("TF_DATA_INCREMENTAL_CHECKPOINT_DIR",
+                                    /*default_val=*/"", &value);
+    if (!s.ok()) {
+      LOG(WARNING) << s;
+    }
+    return new std::string(value);
+  }();
+  return *dir;
+}
+
 }  // namespace
 
 /* static */ constexpr const char* const
@@ -1078,6 +1095,7 @@ void SerializeIteratorOp::Compute(OpKernelContext* ctx) {
   IteratorVariantSerializer serializer;
   SerializationContext::Params params(ctx);
   params.external_state_policy = external_state_policy_;
+  params.incremental_checkpoint_dir = IncrementalCheckpointDir();
   SerializationContext serialization_ctx(params);
   OP_REQUIRES_OK(ctx, serializer.InitializeFromIterator(&serialization_ctx,
                                                         iterator_resource));
@@ -16,7 +16,9 @@ limitations under the License.
 
 #include <sys/types.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <deque>
 #include <memory>
 #include <utility>
@@ -43,6 +45,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
@@ -115,6 +118,16 @@ constexpr double kDefaultCyclePrefetchFactor = 2.0L;
 // match the behavior of the original implementation.
 constexpr double kDefaultPerIteratorPrefetchFactor = 2.0L;
 
+// When `num_parallel_calls` is autotuned, the number of prefetched future cycle
+// elements adapts to the latency of opening an input (up to `kMax...Factor`
+// times the configured number), so that inputs with high first-element latency,
+// e.g. remote files, are opened further ahead of the cycle.
+constexpr double kMaxAdaptiveCyclePrefetchFactor = 2.0L;
+
+// The weight of the most recent measurement in the moving averages of the
+// input latency and the interval between inputs entering the cycle.
+constexpr double kInputLatencyAverageWeight = 0.1;
+
 // Period between reporting dataset statistics.
 constexpr int kStatsReportingPeriodMillis = 1000;
 
@@ -315,7 +328,18 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
               params.dataset->num_parallel_calls_, mu_,
               num_parallel_calls_cond_var_)),
           deterministic_(deterministic),
-          current_elements_(params.dataset->cycle_length_) {}
+          adaptive_future_elements_prefetch_(
+              params.dataset->num_parallel_calls_ == model::kAutotune),
+          max_future_elements_prefetch_(
+              adaptive_future_elements_prefetch_
+                  ? std::max<int64_t>(
+                        kMaxAdaptiveCyclePrefetchFactor *
+                            params.dataset->prefetch_input_elements_,
+                        params.dataset->cycle_length_)
+                  : params.dataset->prefetch_input_elements_),
+          current_elements_(params.dataset->cycle_length_),
+          future_elements_prefetch_(params.dataset->prefetch_input_elements_) {
+    }
 
     ~ParallelInterleaveIterator() override { CancelThreads(/*wait=*/true); }
 
@@ -332,10 +356,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       //
       // Allocate one thread for the worker manager, one thread for stats
       // collection, `cycle_length_` threads for the current workers, and
-      // `future_elements_prefetch_` for the future workers.
+      // `max_future_elements_prefetch_` for the future workers.
       int max_current_workers = dataset()->cycle_length_;
       int future_workers =
-          dataset()->prefetch_input_elements_ + dataset()->cycle_length_;
+          max_future_elements_prefetch_ + dataset()->cycle_length_;
       int num_threads = 1 + max_current_workers + future_workers;
       if (ctx->stats_aggregator()) {
         num_threads++;
@@ -505,10 +529,12 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       int64_t parallelism = -1;
       int64_t results_ready = -1;
       int64_t active_elements = -1;
+      int64_t future_elements_prefetch = -1;
       // NOTE: We only set the parallelism value if the lock can be acquired
       // right away to avoid introducing tracing overhead.
       if (mu_->try_lock()) {
         parallelism = num_parallel_calls_->value;
+        future_elements_prefetch = future_elements_prefetch_;
         results_ready = 0;
         active_elements = 0;
         for (int i = 0; i < current_elements_.size(); ++i) {
@@ -537,6 +563,12 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           results_ready == -1 ? kTraceInfoUnavailable
                               : strings::Printf("%lld", static_cast<long long>(
                                                             active_elements))));
+      result.push_back(std::make_pair(
+          "future_elements_prefetch",
+          future_elements_prefetch == -1
+              ? kTraceInfoUnavailable
+              : strings::Printf("%lld", static_cast<long long>(
+                                            future_elements_prefetch))));
       result.push_back(std::make_pair(
           "interleave_depth",
           strings::Printf("%lld", static_cast<long long>(interleave_depth_))));
@@ -583,6 +615,11 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       // Whether we tried to initialize the element, but the input iterator
       // was exhausted so we could produce no inputs.
       bool no_input TF_GUARDED_BY(&ParallelInterleaveIterator::mu_) = false;
+      // When the element was created, in microseconds.
+      int64_t created_us TF_GUARDED_BY(&ParallelInterleaveIterator::mu_) = 0;
+      // Whether the element's iterator has produced a result.
+      bool produced_result TF_GUARDED_BY(&ParallelInterleaveIterator::mu_) =
+          false;
       // Condition variable for communicating between current worker threads
       // and GetNext.
       condition_variable cond_var;
@@ -735,6 +772,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           }
           future_element->cycle_index = cycle_index_;
           current_elements_[cycle_index_] = std::move(future_element);
+          RecordInputEnteredCycle();
           future_workers_cond_var_.notify_one();
           if (!current_elements_[cycle_index_]->active) {
             current_workers_cond_var_.notify_one();
@@ -770,10 +808,65 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       }
       auto element = std::make_shared<Element>();
       element->id = element_id_counter_++;
+      element->created_us = EnvTime::NowMicros();
       uninitialized_elements_.push_back(element);
       return element;
     }
 
+    // Updates the average latency between the creation of an element and its
+    // first result.
+    void RecordFirstResultLatency(const Element& element)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const double latency_us = EnvTime::NowMicros() - element.created_us;
+      input_latency_us_ =
+          input_latency_us_ == 0
+              ? latency_us
+              : kInputLatencyAverageWeight * latency_us +
+                    (1 - kInputLatencyAverageWeight) * input_latency_us_;
+      AdjustFutureElementsPrefetch();
+    }
+
+    // Updates the average interval between future elements entering the cycle.
+    void RecordInputEnteredCycle() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const int64_t now_us = EnvTime::NowMicros();
+      if (last_input_entered_cycle_us_ > 0) {
+        const double interval_us = now_us - last_input_entered_cycle_us_;
+        input_interval_us_ =
+            input_interval_us_ == 0
+                ? interval_us
+                : kInputLatencyAverageWeight * interval_us +
+                      (1 - kInputLatencyAverageWeight) * input_interval_us_;
+      }
+      last_input_entered_cycle_us_ = now_us;
+      AdjustFutureElementsPrefetch();
+    }
+
+    // Prefetches enough future elements for an input opened now to produce its
+    // first result by the time it enters the cycle, within
+    // `[prefetch_input_elements, max_future_elements_prefetch_]`. This only
+    // changes how far ahead inputs are opened, not the order of the outputs.
+    void AdjustFutureElementsPrefetch() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!adaptive_future_elements_prefetch_ || input_latency_us_ == 0 ||
+          input_interval_us_ == 0) {
+        return;
+      }
+      const int64_t needed =
+          std::ceil(input_latency_us_ / input_interval_us_) + 1;
+      const int64_t prefetch =
+          std::min(std::max(needed, dataset()->prefetch_input_elements_),
+                   max_future_elements_prefetch_);
+      if (prefetch != future_elements_prefetch_) {
+        VLOG(2) << "Prefetching " << prefetch << " future elements, "
+                << "input latency: " << input_latency_us_
+                << "us, interval between inputs: " << input_interval_us_
+                << "us";
+        if (prefetch > future_elements_prefetch_) {
+          future_workers_cond_var_.notify_all();
+        }
+        future_elements_prefetch_ = prefetch;
+      }
+    }
+
     // Thread responsible for launching all worker threads. The thread stays
     // around after startup in case autotuning increases num_parallel_calls.
     void WorkerManagerThread() TF_LOCKS_EXCLUDED(mu_) {
@@ -791,7 +884,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       // `future_element_.size() < future_elements_prefetch_`, there will be a
       // future worker available to create a new future element.
       int future_workers =
-          dataset()->prefetch_input_elements_ + dataset()->cycle_length_;
+          max_future_elements_prefetch_ + dataset()->cycle_length_;
       {
         mutex_lock l(*mu_);
         initial_current_workers = num_parallel_calls_->value;
@@ -934,9 +1027,9 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
               current_workers_cond_var_.notify_one();
             }
           }
-          while (!cancelled_ && (future_elements_.size() >=
-                                     dataset()->prefetch_input_elements_ ||
-                                 wait_for_checkpoint_)) {
+          while (!cancelled_ &&
+                 (future_elements_.size() >= future_elements_prefetch_ ||
+                  wait_for_checkpoint_)) {
             WaitWorkerThread(&future_workers_cond_var_, &l);
           }
           if (cancelled_) {
@@ -1002,6 +1095,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         }
         RecordBufferEnqueue(ctx_.get(), result->return_values);
         mutex_lock l(*mu_);
+        if (!element->produced_result) {
+          element->produced_result = true;
+          RecordFirstResultLatency(*element);
+        }
         element->results.push_back(std::move(result));
         NotifyElementUpdate(element);
         if (element->results.size() == dataset()->buffer_output_elements_) {
@@ -1295,6 +1392,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       auto element = std::make_shared<Element>();
       {
         mutex_lock l(*mu_);
+        element->created_us = EnvTime::NowMicros();
         const auto& iterator_name =
             absl::StrCat(prefix(), "::", key_prefix, "::", idx);
         if (!reader->Contains(iterator_name,
@@ -1549,6 +1647,11 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // Determines whether outputs can be produced in deterministic order.
     const bool deterministic_;
 
+    // Whether the number of prefetched future elements adapts to the input
+    // latency, and up to which number.
+    const bool adaptive_future_elements_prefetch_;
+    const int64_t max_future_elements_prefetch_;
+
     // Controls cancellation of `input_impl_`. Must be ordered before
     // `input_impl_` so that `input_impl_` is destroyed first.
     std::unique_ptr<CancellationManager> cancellation_manager_;
@@ -1575,6 +1678,15 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // current element is exhausted.
     std::deque<std::shared_ptr<Element>> future_elements_ TF_GUARDED_BY(mu_);
 
+    // The number of future elements to prefetch.
+    int64_t future_elements_prefetch_ TF_GUARDED_BY(mu_);
+    // Moving averages of the latency between the creation of an element and
+    // its first result, and of the interval between future elements entering
+    // the cycle.
+    double input_latency_us_ TF_GUARDED_BY(mu_) = 0;
+    double input_interval_us_ TF_GUARDED_BY(mu_) = 0;
+    int64_t last_input_entered_cycle_us_ TF_GUARDED_BY(mu_) = 0;
+
     // Identifies whether the global end of input has been reached.
     bool end_of_input_ TF_GUARDED_BY(mu_) = false;
 
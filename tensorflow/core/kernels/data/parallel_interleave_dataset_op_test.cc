@@ -399,6 +399,34 @@ ParallelInterleaveDatasetParams LongCycleDeterministicParams() {
       /*node_name=*/kNodeName);
 }
 
+// With an autotuned `num_parallel_calls`, the number of prefetched inputs
+// adapts to the input latency, which must not change the deterministic order.
+ParallelInterleaveDatasetParams AutotuneDeterministicParams() {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<tstring>(
+          TensorShape{6, 2, 1},
+          {"a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l"})},
+      /*node_name=*/"tensor_slice");
+  return ParallelInterleaveDatasetParams(
+      tensor_slice_dataset_params,
+      /*other_arguments=*/{},
+      /*cycle_length=*/2,
+      /*block_length=*/1,
+      /*buffer_output_elements=*/model::kAutotune,
+      /*prefetch_input_elements=*/model::kAutotune,
+      /*num_parallel_calls=*/model::kAutotune,
+      /*func=*/
+      MakeTensorSliceDatasetFunc(
+          DataTypeVector({DT_STRING}),
+          std::vector<PartialTensorShape>({PartialTensorShape({1})})),
+      /*func_lib=*/{test::function::MakeTensorSliceDataset()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_STRING},
+      /*output_shapes=*/{PartialTensorShape({1})},
+      /*deterministic=*/DeterminismPolicy::kDeterministic,
+      /*node_name=*/kNodeName);
+}
+
 ParallelInterleaveDatasetParams
 ParallelInterleaveDatasetParamsWithInvalidCycleLength() {
   auto tensor_slice_dataset_params = TensorSliceDatasetParams(
@@ -598,6 +626,22 @@ GetNextTestCases() {
            CreateTensors<tstring>(
                TensorShape{1},
                {{"a"}, {"d"}, {"g"}, {"b"}, {"e"}, {"h"}, {"c"}, {"f"}, {"i"}}),
+           /*compare_order=*/true},
+          {/*dataset_params=*/
+           AutotuneDeterministicParams(),
+           /*expected_outputs=*/
+           CreateTensors<tstring>(TensorShape{1}, {{"a"},
+                                                   {"c"},
+                                                   {"b"},
+                                                   {"d"},
+                                                   {"e"},
+                                                   {"g"},
+                                                   {"f"},
+                                                   {"h"},
+                                                   {"i"},
+                                                   {"k"},
+                                                   {"j"},
+                                                   {"l"}}),
            /*compare_order=*/true}};
 }
 
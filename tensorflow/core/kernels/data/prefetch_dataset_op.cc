@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/prefetch_dataset_op.h"
 
+#include <cstring>
 #include <deque>
 
 #include "tensorflow/core/data/dataset_utils.h"
@@ -25,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/stats_aggregator.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
@@ -47,6 +49,7 @@ namespace data {
 /* static */ constexpr const char* const PrefetchDatasetOp::kSlackPeriod;
 /* static */ constexpr const char* const PrefetchDatasetOp::kLegacyAutotune;
 /* static */ constexpr const char* const PrefetchDatasetOp::kBufferSizeMin;
+/* static */ constexpr const char* const PrefetchDatasetOp::kPinHostMemory;
 
 namespace {
 
@@ -58,18 +61,28 @@ constexpr char kSizeSuffix[] = ".size";
 constexpr char kCodeSuffix[] = ".code";
 constexpr char kErrorMessageSuffix[] = ".error_message";
 
+// Returns whether the buffer of `tensor` was allocated by `allocator`.
+bool IsAllocatedBy(const Tensor& tensor, Allocator* allocator) {
+  TensorDescription description;
+  tensor.FillDescription(&description);
+  return description.allocation_description().allocator_name() ==
+         allocator->Name();
+}
+
 }  // namespace
 
 class PrefetchDatasetOp::Dataset : public DatasetBase {
  public:
   Dataset(OpKernelContext* ctx, const DatasetBase* input, int64_t buffer_size,
-          int64_t slack_period, bool legacy_autotune, int64_t buffer_size_min)
+          int64_t slack_period, bool legacy_autotune, int64_t buffer_size_min,
+          bool pin_host_memory)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         buffer_size_(buffer_size),
         slack_period_(slack_period),
         legacy_autotune_(legacy_autotune),
-        buffer_size_min_(buffer_size_min) {
+        buffer_size_min_(buffer_size_min),
+        pin_host_memory_(pin_host_memory) {
     input_->Ref();
   }
 
@@ -125,12 +138,19 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     AttrValue buffer_size_min_attr;
     b->BuildAttrValue(buffer_size_min_, &buffer_size_min_attr);
 
-    TF_RETURN_IF_ERROR(
-        b->AddDataset(this, {input_graph_node, buffer_size},
-                      {std::make_pair(kSlackPeriod, slack_period_attr),
-                       std::make_pair(kLegacyAutotune, legacy_autotune_attr),
-                       std::make_pair(kBufferSizeMin, buffer_size_min_attr)},
-                      output));
+    std::vector<std::pair<StringPiece, AttrValue>> attrs = {
+        std::make_pair(kSlackPeriod, slack_period_attr),
+        std::make_pair(kLegacyAutotune, legacy_autotune_attr),
+        std::make_pair(kBufferSizeMin, buffer_size_min_attr)};
+    // The attribute is only serialized when set, so that the graphs of other
+    // prefetch datasets can still be read by binaries which do not know it.
+    if (pin_host_memory_) {
+      AttrValue pin_host_memory_attr;
+      b->BuildAttrValue(pin_host_memory_, &pin_host_memory_attr);
+      attrs.push_back(std::make_pair(kPinHostMemory, pin_host_memory_attr));
+    }
+    TF_RETURN_IF_ERROR(b->AddDataset(this, {input_graph_node, buffer_size},
+                                     attrs, output));
     return Status::OK();
   }
 
@@ -169,6 +189,18 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       TF_RETURN_IF_ERROR(RegisterCancellationCallback(
           ctx->cancellation_manager(), [this]() { CancelThreads(); },
           &deregister_fn_));
+      if (dataset()->pin_host_memory_) {
+        AllocatorAttributes attr;
+        attr.set_on_host(true);
+        attr.set_gpu_compatible(true);
+        pinned_allocator_ = ctx->allocator(attr);
+        AllocatorAttributes host_attr;
+        host_attr.set_on_host(true);
+        if (pinned_allocator_ == ctx->allocator(host_attr)) {
+          // There is no GPU to pin memory for.
+          pinned_allocator_ = nullptr;
+        }
+      }
       IteratorContext::Params params(ctx);
       params.cancellation_manager = cancellation_manager_.get();
       return dataset()->input_->MakeIterator(IteratorContext(params), this,
@@ -514,6 +546,9 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
           cond_var_->notify_all();
           return;
         }
+        if (buffer_element.status.ok() && pinned_allocator_ != nullptr) {
+          buffer_element.status = CopyToPinnedMemory(&buffer_element.value);
+        }
 
         // 3. Signal that the element has been produced.
         {
@@ -527,6 +562,32 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       }
     }
 
+    // Copies the memcpy-able tensors of `element` into pinned host memory, so
+    // that the copies of the prefetched element to a GPU are direct transfers
+    // which do not need to stage the tensors on the consumer's critical path.
+    Status CopyToPinnedMemory(std::vector<Tensor>* element) {
+      profiler::TraceMe traceme("PrefetchPinHostMemory", profiler::kInfo);
+      for (Tensor& tensor : *element) {
+        if (!DataTypeCanUseMemcpy(tensor.dtype()) ||
+            tensor.TotalBytes() == 0) {
+          continue;
+        }
+        if (IsAllocatedBy(tensor, pinned_allocator_)) {
+          continue;
+        }
+        Tensor pinned(pinned_allocator_, tensor.dtype(), tensor.shape());
+        if (!pinned.IsInitialized()) {
+          return errors::ResourceExhausted(
+              "Failed to allocate ", tensor.TotalBytes(),
+              " bytes of pinned host memory for a prefetched element.");
+        }
+        std::memcpy(const_cast<char*>(pinned.tensor_data().data()),
+                    tensor.tensor_data().data(), tensor.TotalBytes());
+        tensor = std::move(pinned);
+      }
+      return Status::OK();
+    }
+
     Status WriteStatus(IteratorStateWriter* writer, size_t index,
                        const Status& status) TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
       TF_RETURN_IF_ERROR(
@@ -600,6 +661,10 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     // tree. We record the interleave depth so that it can be included in the
     // trace metadata.
     int64 interleave_depth_ = -1;
+
+    // If `pin_host_memory` is set and a GPU is available, the allocator of
+    // the pinned host memory the prefetched tensors are copied to.
+    Allocator* pinned_allocator_ = nullptr;
   };
 
   const DatasetBase* const input_;
@@ -616,6 +681,9 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
   // parameter.
   const int64_t buffer_size_min_ = 0;
 
+  // Determines whether prefetched tensors are copied to pinned host memory.
+  const bool pin_host_memory_ = false;
+
   TraceMeMetadata traceme_metadata_;
 };
 
@@ -630,6 +698,9 @@ PrefetchDatasetOp::PrefetchDatasetOp(OpKernelConstruction* ctx)
   if (ctx->HasAttr(kBufferSizeMin)) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr(kBufferSizeMin, &buffer_size_min_));
   }
+  if (ctx->HasAttr(kPinHostMemory)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kPinHostMemory, &pin_host_memory_));
+  }
 }
 
 void PrefetchDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -647,7 +718,7 @@ void PrefetchDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
   }
 
   *output = new Dataset(ctx, input, buffer_size, slack_period_,
-                        legacy_autotune_, buffer_size_min_);
+                        legacy_autotune_, buffer_size_min_, pin_host_memory_);
 }
 
 namespace {
@@ -29,13 +29,15 @@ class PrefetchDatasetParams : public DatasetParams {
                         DataTypeVector output_dtypes,
                         std::vector<PartialTensorShape> output_shapes,
                         int64_t slack_period, bool legacy_autotune,
-                        int64_t buffer_size_min, string node_name)
+                        int64_t buffer_size_min, string node_name,
+                        bool pin_host_memory = false)
       : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
                       std::move(node_name)),
         buffer_size_(buffer_size),
         slack_period_(slack_period),
         legacy_autotune_(legacy_autotune),
-        buffer_size_min_(buffer_size_min) {
+        buffer_size_min_(buffer_size_min),
+        pin_host_memory_(pin_host_memory) {
     input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
     iterator_prefix_ =
         name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
@@ -61,6 +63,7 @@ class PrefetchDatasetParams : public DatasetParams {
     attr_vector->emplace_back("legacy_autotune", legacy_autotune_);
     attr_vector->emplace_back("buffer_size_min", buffer_size_min_);
     attr_vector->emplace_back("metadata", "");
+    attr_vector->emplace_back("pin_host_memory", pin_host_memory_);
     return Status::OK();
   }
 
@@ -73,6 +76,7 @@ class PrefetchDatasetParams : public DatasetParams {
   int64_t slack_period_;
   bool legacy_autotune_;
   int64_t buffer_size_min_;
+  bool pin_host_memory_;
 };
 
 // Test case 1: positive buffer size.
@@ -177,6 +181,60 @@ PrefetchDatasetParams PrefetchDatasetParams6() {
       /*node_name=*/kNodeName);
 }
 
+// Test case 7: pin_host_memory = true. The tensors are only copied into pinned
+// host memory if a GPU is available.
+PrefetchDatasetParams PrefetchDatasetParams7() {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<int64_t>(TensorShape{10, 1},
+                                            {0, 1, 2, 3, 4, 5, 6, 7, 8, 9})},
+      /*node_name=*/"tensor_slice");
+  return PrefetchDatasetParams(
+      /*input_dataset_params=*/tensor_slice_dataset_params,
+      /*buffer_size=*/-1,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({1})},
+      /*slack_period=*/0,
+      /*legacy_autotune=*/true,
+      /*buffer_size_min=*/0,
+      /*node_name=*/kNodeName,
+      /*pin_host_memory=*/true);
+}
+
+// Test case 8: pin_host_memory = true, with components that are not copied:
+// strings, which can not be copied with memcpy, and empty tensors.
+PrefetchDatasetParams PrefetchDatasetParams8() {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<int64_t>(TensorShape{3, 2},
+                                            {0, 1, 2, 3, 4, 5}),
+                      CreateTensor<tstring>(TensorShape{3}, {"a", "b", "c"}),
+                      CreateTensor<float>(TensorShape{3, 0}, {})},
+      /*node_name=*/"tensor_slice");
+  return PrefetchDatasetParams(
+      /*input_dataset_params=*/tensor_slice_dataset_params,
+      /*buffer_size=*/2,
+      /*output_dtypes=*/{DT_INT64, DT_STRING, DT_FLOAT},
+      /*output_shapes=*/
+      {PartialTensorShape({2}), PartialTensorShape({}),
+       PartialTensorShape({0})},
+      /*slack_period=*/0,
+      /*legacy_autotune=*/true,
+      /*buffer_size_min=*/0,
+      /*node_name=*/kNodeName,
+      /*pin_host_memory=*/true);
+}
+
+std::vector<Tensor> PrefetchDatasetParams8Outputs() {
+  const std::vector<tstring> strings = {"a", "b", "c"};
+  std::vector<Tensor> outputs;
+  for (int64_t i = 0; i < 3; ++i) {
+    outputs.push_back(
+        CreateTensor<int64_t>(TensorShape{2}, {2 * i, 2 * i + 1}));
+    outputs.push_back(CreateTensor<tstring>(TensorShape{}, {strings[i]}));
+    outputs.push_back(CreateTensor<float>(TensorShape{0}, {}));
+  }
+  return outputs;
+}
+
 PrefetchDatasetParams InvalidBufferSizePrefetchDatasetParams() {
   auto tensor_slice_dataset_params = TensorSliceDatasetParams(
       /*components=*/{CreateTensor<int64_t>(TensorShape{10, 1},
@@ -223,7 +281,14 @@ std::vector<GetNextTestCase<PrefetchDatasetParams>> GetNextTestCases() {
        /*expected_outputs=*/
        CreateTensors<int64_t>(
            TensorShape{1},
-           {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}})}};
+           {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}})},
+      {/*dataset_params=*/
+       PrefetchDatasetParams7(),
+       /*expected_outputs=*/
+       CreateTensors<int64_t>(
+           TensorShape{1}, {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}})},
+      {/*dataset_params=*/PrefetchDatasetParams8(),
+       /*expected_outputs=*/PrefetchDatasetParams8Outputs()}};
 }
 
 ITERATOR_GET_NEXT_TEST_P(PrefetchDatasetOpTest, PrefetchDatasetParams,
@@ -320,7 +385,16 @@ IteratorSaveAndRestoreTestCases() {
        /*expected_outputs=*/
        CreateTensors<int64_t>(
            TensorShape{1},
-           {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}})}};
+           {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}})},
+      {/*dataset_params=*/
+       PrefetchDatasetParams7(),
+       /*breakpoints=*/{0, 4, 11},
+       /*expected_outputs=*/
+       CreateTensors<int64_t>(
+           TensorShape{1}, {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}})},
+      {/*dataset_params=*/PrefetchDatasetParams8(),
+       /*breakpoints=*/{0, 2, 4},
+       /*expected_outputs=*/PrefetchDatasetParams8Outputs()}};
 }
 
 ITERATOR_SAVE_AND_RESTORE_TEST_P(PrefetchDatasetOpTest, PrefetchDatasetParams,
@@ -14,13 +14,16 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/shuffle_dataset_op.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <deque>
+#include <numeric>
 #include <string>
 #include <tuple>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/serialization_utils.h"
@@ -28,12 +31,19 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/kernels/data/random_seed_ops.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/raw_coding.h"
 #include "tensorflow/core/platform/stringprintf.h"
 
 namespace tensorflow {
@@ -70,6 +80,9 @@ constexpr char kSlicesStart[] = "slices_start";
 constexpr char kSlicesEnd[] = "slices_end";
 constexpr char kSeedGenerator[] = "SeedGenerator";
 constexpr char kEpochNumRandomSamples[] = "epoch_num_random_samples";
+constexpr char kBufferFilesSize[] = "buffer_files_size";
+constexpr char kBufferFiles[] = "buffer_files";
+constexpr char kNumDeltaSlots[] = "num_delta_slots";
 constexpr char kShuffleDatasetV1[] = "ShuffleDataset";
 constexpr char kShuffleDatasetV2[] = "ShuffleDatasetV2";
 constexpr char kShuffleDatasetV3[] = "ShuffleDatasetV3";
@@ -185,7 +198,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         : DatasetIterator<ShuffleDatasetBase>(params),
           seed_generator_(seed_generator),
           parent_generator_(seed_generator->seed(), seed_generator->seed2()),
-          generator_(&parent_generator_) {
+          generator_(&parent_generator_),
+          buffer_file_prefix_(
+              strings::StrCat("shuffle_", strings::Hex(random::New64(),
+                                                       strings::kZeroPad16))) {
       buffer_ = absl::make_unique<std::vector<std::vector<Tensor>>>(
           params.dataset->buffer_size_);
     }
@@ -218,8 +234,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       int64_t index = (slices_.front()->start + offset) % buffer_->size();
       *out_tensors = std::move(buffer_->at(index));
       this->RecordBufferDequeue(ctx, *out_tensors);
-      std::swap(buffer_->at(index),
-                buffer_->at(slices_.front()->start % buffer_->size()));
+      const int64_t start_index = slices_.front()->start % buffer_->size();
+      std::swap(buffer_->at(index), buffer_->at(start_index));
+      MarkSlotModified(index);
+      MarkSlotModified(start_index);
       slices_.front()->start++;
       num_elements_--;
       return Status::OK();
@@ -265,7 +283,12 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       TF_RETURN_IF_ERROR(writer->WriteScalar(this->full_name(kEpoch), epoch_));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(this->full_name(kNumElements), num_elements_));
-      TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(writer, prefix(), *buffer_));
+      if (ctx->incremental_checkpoint_dir().empty()) {
+        TF_RETURN_IF_ERROR(
+            WriteElementsToCheckpoint(writer, prefix(), *buffer_));
+      } else {
+        TF_RETURN_IF_ERROR(SaveBufferIncrementally(ctx, writer));
+      }
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(this->full_name(kSlicesSize), slices_.size()));
       for (size_t i = 0; i < slices_.size(); ++i) {
@@ -321,8 +344,14 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         slices_size = static_cast<size_t>(temp);
       }
       buffer_ = absl::make_unique<std::vector<std::vector<Tensor>>>();
-      TF_RETURN_IF_ERROR(
-          ReadElementsFromCheckpoint(ctx, reader, prefix(), buffer_.get()));
+      if (reader->Contains(this->full_name(kBufferFilesSize))) {
+        TF_RETURN_IF_ERROR(RestoreBufferIncrementally(ctx, reader));
+      } else {
+        TF_RETURN_IF_ERROR(
+            ReadElementsFromCheckpoint(ctx, reader, prefix(), buffer_.get()));
+        buffer_files_.clear();
+      }
+      dirty_slots_.clear();
       for (const auto& element : *buffer_) {
         RecordBufferEnqueue(ctx, element);
       }
@@ -450,6 +479,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       this->RecordBufferEnqueue(ctx, element);
       size_t index = slices_.back()->end % buffer_->size();
       buffer_->at(index) = std::move(element);
+      MarkSlotModified(index);
       num_elements_++;
       slices_.back()->end++;
     }
@@ -469,6 +499,135 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       return absl::StrCat(dataset()->buffer_size_);
     }
 
+    // Records that the slot `index` of `buffer_` changed since the last
+    // incremental save. Slots are only tracked once a base file exists.
+    void MarkSlotModified(int64_t index) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (!buffer_files_.empty()) {
+        dirty_slots_.insert(index);
+      }
+    }
+
+    // Saves `buffer_` to the incremental checkpoint directory. The first save
+    // writes a base file with every slot of `buffer_`; later saves write a
+    // delta file with only the slots modified since the previous save. Once
+    // the deltas hold more slots than `buffer_`, a new base file is written.
+    // The checkpoint itself only stores the list of files to replay.
+    //
+    // Each record of a file is the fixed64 slot index, followed by the
+    // varint64 length-prefixed `TensorProto` of each component of the slot.
+    Status SaveBufferIncrementally(SerializationContext* ctx,
+                                   IteratorStateWriter* writer)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      std::vector<int64_t> slots;
+      if (buffer_files_.empty() ||
+          num_delta_slots_ + static_cast<int64_t>(dirty_slots_.size()) >
+              static_cast<int64_t>(buffer_->size())) {
+        buffer_files_.clear();
+        num_delta_slots_ = 0;
+        slots.resize(buffer_->size());
+        std::iota(slots.begin(), slots.end(), 0);
+      } else {
+        slots.assign(dirty_slots_.begin(), dirty_slots_.end());
+        std::sort(slots.begin(), slots.end());
+        num_delta_slots_ += slots.size();
+      }
+      if (!slots.empty()) {
+        Env* env = Env::Default();
+        TF_RETURN_IF_ERROR(
+            env->RecursivelyCreateDir(ctx->incremental_checkpoint_dir()));
+        std::string filename = io::JoinPath(
+            ctx->incremental_checkpoint_dir(),
+            strings::StrCat(buffer_file_prefix_, "_", num_buffer_files_++));
+        std::unique_ptr<WritableFile> file;
+        TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+        io::RecordWriter record_writer(file.get());
+        for (int64_t slot : slots) {
+          std::string record;
+          core::PutFixed64(&record, slot);
+          for (const Tensor& component : buffer_->at(slot)) {
+            TensorProto proto;
+            component.AsProtoTensorContent(&proto);
+            std::string serialized = proto.SerializeAsString();
+            core::PutVarint64(&record, serialized.size());
+            record.append(serialized);
+          }
+          TF_RETURN_IF_ERROR(record_writer.WriteRecord(record));
+        }
+        TF_RETURN_IF_ERROR(record_writer.Close());
+        TF_RETURN_IF_ERROR(file->Close());
+        buffer_files_.push_back(std::move(filename));
+      }
+      dirty_slots_.clear();
+      TF_RETURN_IF_ERROR(writer->WriteScalar(this->full_name(kBufferFilesSize),
+                                             buffer_files_.size()));
+      for (size_t i = 0; i < buffer_files_.size(); ++i) {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            this->full_name(absl::StrCat(kBufferFiles, "_", i)),
+            buffer_files_[i]));
+      }
+      return writer->WriteScalar(this->full_name(kNumDeltaSlots),
+                                 num_delta_slots_);
+    }
+
+    // Restores `buffer_` by replaying the base and delta files written by
+    // `SaveBufferIncrementally`.
+    Status RestoreBufferIncrementally(IteratorContext* ctx,
+                                      IteratorStateReader* reader)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64_t num_files;
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(this->full_name(kBufferFilesSize), &num_files));
+      TF_RETURN_IF_ERROR(reader->ReadScalar(this->full_name(kNumDeltaSlots),
+                                            &num_delta_slots_));
+      buffer_->resize(dataset()->buffer_size_);
+      buffer_files_.clear();
+      for (int64_t i = 0; i < num_files; ++i) {
+        tstring filename;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            this->full_name(absl::StrCat(kBufferFiles, "_", i)), &filename));
+        std::unique_ptr<RandomAccessFile> file;
+        TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(filename, &file));
+        io::SequentialRecordReader record_reader(file.get());
+        while (true) {
+          tstring record;
+          Status s = record_reader.ReadRecord(&record);
+          if (errors::IsOutOfRange(s)) {
+            break;
+          }
+          TF_RETURN_IF_ERROR(s);
+          if (record.size() < sizeof(uint64)) {
+            return errors::DataLoss("Truncated record in shuffle buffer file ",
+                                    filename);
+          }
+          const uint64 slot = core::DecodeFixed64(record.data());
+          if (slot >= buffer_->size()) {
+            return errors::DataLoss("Invalid slot ", slot,
+                                    " in shuffle buffer file ", filename);
+          }
+          std::vector<Tensor>& element = buffer_->at(slot);
+          element.clear();
+          StringPiece input(record.data() + sizeof(uint64),
+                            record.size() - sizeof(uint64));
+          while (!input.empty()) {
+            uint64 size;
+            TensorProto proto;
+            Tensor component;
+            if (!core::GetVarint64(&input, &size) || size > input.size() ||
+                !proto.ParseFromArray(input.data(), size) ||
+                !component.FromProto(proto)) {
+              return errors::DataLoss(
+                  "Failed to parse an element of shuffle buffer file ",
+                  filename);
+            }
+            input.remove_prefix(size);
+            element.push_back(std::move(component));
+          }
+        }
+        buffer_files_.push_back(std::string(filename));
+      }
+      return Status::OK();
+    }
+
     mutex mu_;
     SeedGenerator* const seed_generator_ TF_GUARDED_BY(mu_);  // Not owned.
     std::unique_ptr<std::vector<std::vector<Tensor>>> buffer_
@@ -488,6 +647,17 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         TF_GUARDED_BY(mu_);
     int64_t num_random_samples_ TF_GUARDED_BY(mu_) = 0;
     bool data_produced_ TF_GUARDED_BY(mu_) = false;
+    // The prefix of the files written by `SaveBufferIncrementally`, unique to
+    // this iterator so that restored iterators do not overwrite the files of
+    // the checkpoints they were restored from.
+    const std::string buffer_file_prefix_;
+    // The base and delta files that reconstruct `buffer_` as of the last
+    // incremental save, the number of slots in the delta files, and the
+    // slots modified since then.
+    std::vector<std::string> buffer_files_ TF_GUARDED_BY(mu_);
+    int64_t num_delta_slots_ TF_GUARDED_BY(mu_) = 0;
+    int64_t num_buffer_files_ TF_GUARDED_BY(mu_) = 0;
+    absl::flat_hash_set<int64_t> dirty_slots_ TF_GUARDED_BY(mu_);
   };
 
   const DatasetBase* const input_;
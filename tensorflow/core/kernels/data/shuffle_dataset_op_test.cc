@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/core/data/dataset_test_base.h"
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/serialization_utils.h"
+#include "tensorflow/core/lib/io/path.h"
 
 namespace tensorflow {
 namespace data {
@@ -550,6 +551,47 @@ TEST_P(ParameterizedIteratorSaveAndRestoreTest, IteratorSaveAndRestore) {
                            /*compare_order=*/true));
 }
 
+TEST_P(ParameterizedIteratorSaveAndRestoreTest,
+       IncrementalIteratorSaveAndRestore) {
+  auto test_case = GetParam();
+  TF_ASSERT_OK(Initialize(test_case.dataset_params));
+
+  SerializationContext::Params params;
+  params.incremental_checkpoint_dir =
+      io::JoinPath(testing::TmpDir(), "incremental_shuffle_checkpoint");
+  SerializationContext serialization_ctx(params);
+
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  int cur_iteration = 0;
+  const std::vector<int>& breakpoints = test_case.breakpoints;
+  for (int breakpoint : breakpoints) {
+    // Restored iterators continue the chain of buffer files, so saves after
+    // the first one write delta files, or no file if nothing changed.
+    for (int i = 0; i < 2; ++i) {
+      VariantTensorDataWriter writer;
+      TF_EXPECT_OK(iterator_->Save(&serialization_ctx, &writer));
+      std::vector<const VariantTensorData*> data;
+      writer.GetData(&data);
+      VariantTensorDataReader reader(data);
+      TF_EXPECT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
+                                   test_case.dataset_params.iterator_prefix(),
+                                   *dataset_, &iterator_));
+    }
+
+    while (cur_iteration <= breakpoint) {
+      std::vector<Tensor> next;
+      TF_EXPECT_OK(
+          iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+      out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+      cur_iteration++;
+    }
+  }
+
+  TF_EXPECT_OK(ExpectEqual(out_tensors, test_case.expected_shuffle_outputs,
+                           /*compare_order=*/true));
+}
+
 INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpTest,
                         ParameterizedIteratorSaveAndRestoreTest,
                         ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
@@ -0,0 +1,124 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/simulated_storage_file_system.h"
+
+#include <utility>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+mutex profile_mu(LINKER_INITIALIZED);
+StorageProfile* current_profile TF_GUARDED_BY(profile_mu) = nullptr;
+
+StorageProfile GetStorageProfile() {
+  tf_shared_lock l(profile_mu);
+  return current_profile ? *current_profile : StorageProfile();
+}
+
+FileSystem* LocalFileSystem() {
+  FileSystem* file_system;
+  TF_CHECK_OK(Env::Default()->GetFileSystemForFile("/", &file_system));
+  return file_system;
+}
+
+void Wait(int64_t micros) {
+  if (micros > 0) {
+    Env::Default()->SleepForMicroseconds(micros);
+  }
+}
+
+class SimulatedRandomAccessFile : public RandomAccessFile {
+ public:
+  SimulatedRandomAccessFile(std::unique_ptr<RandomAccessFile> base_file,
+                            const StorageProfile& profile)
+      : base_file_(std::move(base_file)), profile_(profile) {}
+
+  Status Name(StringPiece* result) const override {
+    return base_file_->Name(result);
+  }
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    int64_t micros = profile_.read_latency_us;
+    if (profile_.read_bytes_per_sec > 0) {
+      micros += n * 1e6 / profile_.read_bytes_per_sec;
+    }
+    Wait(micros);
+    return base_file_->Read(offset, n, result, scratch);
+  }
+
+ private:
+  const std::unique_ptr<RandomAccessFile> base_file_;
+  const StorageProfile profile_;
+};
+
+}  // namespace
+
+StorageProfile StorageProfile::LocalNvme() {
+  StorageProfile profile;
+  profile.open_latency_us = 20;
+  profile.read_latency_us = 100;
+  profile.read_bytes_per_sec = 2.5e9;
+  return profile;
+}
+
+StorageProfile StorageProfile::RemoteObjectStore() {
+  StorageProfile profile;
+  profile.open_latency_us = 40 * 1000;
+  profile.read_latency_us = 20 * 1000;
+  profile.read_bytes_per_sec = 100e6;
+  return profile;
+}
+
+constexpr char SimulatedStorageFileSystem::kScheme[];
+
+SimulatedStorageFileSystem::SimulatedStorageFileSystem()
+    : WrappedFileSystem(LocalFileSystem(), /*token=*/nullptr) {}
+
+void SimulatedStorageFileSystem::SetStorageProfile(
+    const StorageProfile& profile) {
+  mutex_lock l(profile_mu);
+  delete current_profile;
+  current_profile = new StorageProfile(profile);
+}
+
+std::string SimulatedStorageFileSystem::Path(const std::string& local_path) {
+  return strings::StrCat(kScheme, "://", local_path);
+}
+
+Status SimulatedStorageFileSystem::NewRandomAccessFile(
+    const std::string& fname, TransactionToken* token,
+    std::unique_ptr<RandomAccessFile>* result) {
+  const StorageProfile profile = GetStorageProfile();
+  Wait(profile.open_latency_us);
+  std::unique_ptr<RandomAccessFile> base_file;
+  TF_RETURN_IF_ERROR(
+      WrappedFileSystem::NewRandomAccessFile(fname, token, &base_file));
+  *result = absl::make_unique<SimulatedRandomAccessFile>(std::move(base_file),
+                                                         profile);
+  return Status::OK();
+}
+
+REGISTER_FILE_SYSTEM(SimulatedStorageFileSystem::kScheme,
+                     SimulatedStorageFileSystem);
+
+}  // namespace data
+}  // namespace tensorflow
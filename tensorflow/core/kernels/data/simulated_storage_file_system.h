@@ -0,0 +1,68 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_SIMULATED_STORAGE_FILE_SYSTEM_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_SIMULATED_STORAGE_FILE_SYSTEM_H_
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data {
+
+// The latency and bandwidth of a storage system.
+struct StorageProfile {
+  // The time to open a file.
+  int64_t open_latency_us = 0;
+  // The time to the first byte of a read.
+  int64_t read_latency_us = 0;
+  // The bytes per second of a read after its first byte, or 0 for no limit.
+  double read_bytes_per_sec = 0;
+
+  // Rough figures of a local NVMe SSD.
+  static StorageProfile LocalNvme();
+
+  // Rough figures of a single stream from a remote object store like GCS.
+  static StorageProfile RemoteObjectStore();
+};
+
+// A file system of scheme `kScheme`, whose files are the local files of the
+// same path, e.g. "simulated:///tmp/file" for "/tmp/file". Opening and
+// reading them takes the time of the current storage profile, so that input
+// pipelines can be benchmarked against remote storage without a network.
+class SimulatedStorageFileSystem : public WrappedFileSystem {
+ public:
+  static constexpr char kScheme[] = "simulated";
+
+  SimulatedStorageFileSystem();
+
+  // Sets the profile of opening and reading files from now on.
+  static void SetStorageProfile(const StorageProfile& profile);
+
+  // Returns the path of `local_path` in this file system.
+  static std::string Path(const std::string& local_path);
+
+  Status NewRandomAccessFile(
+      const std::string& fname, TransactionToken* token,
+      std::unique_ptr<RandomAccessFile>* result) override;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_SIMULATED_STORAGE_FILE_SYSTEM_H_
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/tf_record_dataset_op.h"
 
 #include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/readahead_file.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 namespace data {
@@ -35,6 +37,7 @@ namespace data {
 /* static */ constexpr const char* const TFRecordDatasetOp::kFileNames;
 /* static */ constexpr const char* const TFRecordDatasetOp::kCompressionType;
 /* static */ constexpr const char* const TFRecordDatasetOp::kBufferSize;
+/* static */ constexpr const char* const TFRecordDatasetOp::kReadaheadDepth;
 
 constexpr char kCurrentFileIndex[] = "current_file_index";
 constexpr char kOffset[] = "offset";
@@ -42,6 +45,9 @@ constexpr char kGcsFsPrefix[] = "gs://";
 constexpr char kS3FsPrefix[] = "s3://";
 constexpr int64_t kCloudTpuBlockSize = 127LL << 20;  // 127MB.
 constexpr int64_t kS3BlockSize = kCloudTpuBlockSize;
+// The size of the blocks read ahead when `buffer_size` is 0.
+constexpr int64_t kDefaultReadaheadBlockSize = 256 << 10;  // 256KB.
+constexpr int kNumReadaheadThreads = 16;
 
 bool is_cloud_tpu_gcs_fs() {
 #if (defined(PLATFORM_CLOUD_TPU) && defined(TPU_GCS_FS)) || \
@@ -51,15 +57,25 @@ bool is_cloud_tpu_gcs_fs() {
   return false;
 }
 
+// Returns the thread pool that reads files ahead of their readers, which is
+// shared by all TFRecord datasets.
+thread::ThreadPool* ReadaheadThreadPool() {
+  static thread::ThreadPool* thread_pool = new thread::ThreadPool(
+      Env::Default(), "tf_record_readahead", kNumReadaheadThreads);
+  return thread_pool;
+}
+
 class TFRecordDatasetOp::Dataset : public DatasetBase {
  public:
   explicit Dataset(OpKernelContext* ctx, std::vector<string> filenames,
-                   const string& compression_type, int64_t buffer_size)
+                   const string& compression_type, int64_t buffer_size,
+                   int64_t readahead_depth)
       : DatasetBase(DatasetContext(ctx)),
         filenames_(std::move(filenames)),
         compression_type_(compression_type),
         options_(io::RecordReaderOptions::CreateRecordReaderOptions(
-            compression_type)) {
+            compression_type)),
+        readahead_depth_(readahead_depth) {
     if (buffer_size > 0) {
       options_.buffer_size = buffer_size;
     }
@@ -102,8 +118,11 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(compression_type_, &compression_type));
     Node* buffer_size = nullptr;
     TF_RETURN_IF_ERROR(b->AddScalar(options_.buffer_size, &buffer_size));
-    TF_RETURN_IF_ERROR(b->AddDataset(
-        this, {filenames, compression_type, buffer_size}, output));
+    AttrValue readahead_depth;
+    b->BuildAttrValue(readahead_depth_, &readahead_depth);
+    TF_RETURN_IF_ERROR(
+        b->AddDataset(this, {filenames, compression_type, buffer_size},
+                      {{kReadaheadDepth, readahead_depth}}, output));
     return Status::OK();
   }
 
@@ -248,6 +267,14 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       // Actually move on to next file.
       const string& next_filename = dataset()->filenames_[current_file_index_];
       TF_RETURN_IF_ERROR(env->NewRandomAccessFile(next_filename, &file_));
+      if (dataset()->readahead_depth_ > 0) {
+        const int64_t block_size = dataset()->options_.buffer_size > 0
+                                       ? dataset()->options_.buffer_size
+                                       : kDefaultReadaheadBlockSize;
+        file_ = absl::make_unique<ReadaheadRandomAccessFile>(
+            std::move(file_), block_size, dataset()->readahead_depth_,
+            ReadaheadThreadPool());
+      }
       reader_ = absl::make_unique<io::SequentialRecordReader>(
           file_.get(), dataset()->options_);
       return Status::OK();
@@ -271,10 +298,18 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
   const std::vector<string> filenames_;
   const tstring compression_type_;
   io::RecordReaderOptions options_;
+  // The number of blocks of each file read ahead, or 0 to read files
+  // synchronously.
+  const int64_t readahead_depth_;
 };
 
 TFRecordDatasetOp::TFRecordDatasetOp(OpKernelConstruction* ctx)
-    : DatasetOpKernel(ctx) {}
+    : DatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kReadaheadDepth, &readahead_depth_));
+  OP_REQUIRES(ctx, readahead_depth_ >= 0,
+              errors::InvalidArgument("`readahead_depth` must be >= 0, got ",
+                                      readahead_depth_));
+}
 
 void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
                                     DatasetBase** output) {
@@ -322,8 +357,8 @@ void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
     buffer_size = kS3BlockSize;
   }
 
-  *output =
-      new Dataset(ctx, std::move(filenames), compression_type, buffer_size);
+  *output = new Dataset(ctx, std::move(filenames), compression_type,
+                        buffer_size, readahead_depth_);
 }
 
 namespace {
@@ -91,17 +91,23 @@ static bool ReadBoolFromEnvVar(const char* env_var_name, bool default_val) {
   return default_val;
 }
 
+// TODO(andydavis) Add support for other filter sizes and strides.
+bool IsDeepConv2DSupported(int stride_rows, int stride_cols, int filter_rows,
+                           int filter_cols) {
+  return stride_rows == 1 && stride_cols == 1 && filter_rows == 3 &&
+         filter_cols == 3;
+}
+
 // Returns true if convolution can be computed efficiently by DeepConv2D,
 // returns false otherwise.
-// TODO(andydavis) Add support for other filter sizes and strides.
-// TODO(andydavis) Add support for autotuning.
+// NOTE: The cost model only considers the F(2x2, 3x3) transform, F(4x4, 3x3)
+// is picked by the autotuning of the Conv2D kernel (see conv_ops.cc).
 bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
                       int filter_cols, int in_depth, int out_depth,
                       int out_rows, int out_cols) {
   // Check if convolution parameters are supported.
-  // TODO(andydavis) Add support for multiple filter sizes and strides.
-  if (stride_rows > 1 || stride_cols > 1 || filter_rows != 3 ||
-      filter_cols != 3) {
+  if (!IsDeepConv2DSupported(stride_rows, stride_cols, filter_rows,
+                             filter_cols)) {
     return false;
   }
 
@@ -950,9 +956,17 @@ namespace functor {
 template <typename T>
 struct DeepConv2D<CPUDevice, T> {
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
-                  const T* filter, T* output) {
-    // TODO(andydavis) Add function to select transform based on conv params.
-    std::unique_ptr<DeepConv2DTransform<T>> transform(new WinogradTransform<T>);
+                  const T* filter, T* output,
+                  DeepConv2DTransformType transform_type) {
+    std::unique_ptr<DeepConv2DTransform<T>> transform;
+    switch (transform_type) {
+      case DeepConv2DTransformType::kWinograd2x2:
+        transform.reset(new WinogradTransform<T>);
+        break;
+      case DeepConv2DTransformType::kWinograd4x4:
+        transform.reset(new Winograd4x4Transform<T>);
+        break;
+    }
 
     const int64_t in_depth = args.in_depth;
     const int64_t out_depth = args.out_depth;
@@ -94,6 +94,20 @@ struct Conv2DArgs {
         out_depth(0) {}
 };
 
+// The transforms DeepConv2D can compute 3x3 convolutions with.
+enum class DeepConv2DTransformType {
+  // Winograd F(2x2, 3x3): 2x2 output tiles from 4x4 input tiles.
+  kWinograd2x2,
+  // Winograd F(4x4, 3x3): 4x4 output tiles from 6x6 input tiles. Fewer
+  // multiplications than F(2x2, 3x3) on deep convolutions, but less precise.
+  kWinograd4x4,
+};
+
+// Returns true if DeepConv2D implements the convolution specified by function
+// arguments, whatever its cost and whether the feature is enabled.
+bool IsDeepConv2DSupported(int stride_rows, int stride_cols, int filter_rows,
+                           int filter_cols);
+
 // Returns true if convolution operation specified by function arguments
 // can use DeepConv2D implementation, and false otherwise.
 // May return false based on parameters, cost, or whether feature is disabled.
@@ -107,7 +121,9 @@ namespace functor {
 template <typename Device, typename T>
 struct DeepConv2D {
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
-                  const T* filter, T* output);
+                  const T* filter, T* output,
+                  DeepConv2DTransformType transform_type =
+                      DeepConv2DTransformType::kWinograd2x2);
 };
 
 }  // namespace functor
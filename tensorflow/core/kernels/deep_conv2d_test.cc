@@ -155,5 +155,81 @@ TEST(DeepConv2DTransformTest, WingradOutputTransformMatrix) {
   }
 }
 
+TEST(DeepConv2DTransformTest, Winograd4x4TransformMatrices) {
+  // Test that the transform matrices returned are the kronecker products of the
+  // F(4x4, 3x3) filter, input and output transform matrices with themselves.
+  float filter[] = {1.f / 4,  0,        0,       -1.f / 6, -1.f / 6, -1.f / 6,
+                    -1.f / 6, 1.f / 6,  -1.f / 6, 1.f / 24, 1.f / 12, 1.f / 6,
+                    1.f / 24, -1.f / 12, 1.f / 6, 0,        0,        1};
+  float input[] = {4, 0,  -5, 0,  1, 0, 0, -4, -4, 1,  1, 0,
+                   0, 4,  -4, -1, 1, 0, 0, -2, -1, 2,  1, 0,
+                   0, 2,  -1, -2, 1, 0, 0, 4,  0,  -5, 0, 1};
+  float output[] = {1, 1, 1, 1, 1, 0, 0, 1, -1, 2, -2, 0,
+                    0, 1, 1, 4, 4, 0, 0, 1, -1, 8, -8, 1};
+
+  Winograd4x4Transform<float> t;
+  float kron[36 * 36];
+  float transform_matrix[36 * 36];
+
+  ComputeKroneckerProduct(6, 3, filter, kron);
+  t.GetFilterTransformMatrix(36, 9, transform_matrix);
+  for (int i = 0; i < 36 * 9; ++i) {
+    EXPECT_FLOAT_EQ(kron[i], transform_matrix[i]);
+  }
+
+  ComputeKroneckerProduct(6, 6, input, kron);
+  t.GetInputTransformMatrix(36, 36, transform_matrix);
+  for (int i = 0; i < 36 * 36; ++i) {
+    EXPECT_FLOAT_EQ(kron[i], transform_matrix[i]);
+  }
+
+  ComputeKroneckerProduct(4, 6, output, kron);
+  t.GetOutputTransformMatrix(16, 36, transform_matrix);
+  for (int i = 0; i < 16 * 36; ++i) {
+    EXPECT_FLOAT_EQ(kron[i], transform_matrix[i]);
+  }
+}
+
+TEST(DeepConv2DTransformTest, Winograd4x4ComputesConvolution) {
+  // Test that y = C[Ad * Bg] is the 3x3 convolution of a 6x6 input tile.
+  Winograd4x4Transform<float> t;
+  float filter_transform[36 * 9];
+  float input_transform[36 * 36];
+  float output_transform[16 * 36];
+  t.GetFilterTransformMatrix(36, 9, filter_transform);
+  t.GetInputTransformMatrix(36, 36, input_transform);
+  t.GetOutputTransformMatrix(16, 36, output_transform);
+
+  float d[36];
+  float g[9];
+  for (int i = 0; i < 36; ++i) d[i] = (i * 7) % 11 - 5;
+  for (int i = 0; i < 9; ++i) g[i] = (i * 5) % 7 - 3;
+
+  float product[36];
+  for (int i = 0; i < 36; ++i) {
+    float ad = 0;
+    float bg = 0;
+    for (int j = 0; j < 36; ++j) ad += input_transform[i * 36 + j] * d[j];
+    for (int j = 0; j < 9; ++j) bg += filter_transform[i * 9 + j] * g[j];
+    product[i] = ad * bg;
+  }
+
+  for (int r = 0; r < 4; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      float y = 0;
+      for (int j = 0; j < 36; ++j) {
+        y += output_transform[(r * 4 + c) * 36 + j] * product[j];
+      }
+      float expected = 0;
+      for (int fr = 0; fr < 3; ++fr) {
+        for (int fc = 0; fc < 3; ++fc) {
+          expected += d[(r + fr) * 6 + c + fc] * g[fr * 3 + fc];
+        }
+      }
+      EXPECT_NEAR(expected, y, 1e-3);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
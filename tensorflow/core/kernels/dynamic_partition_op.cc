@@ -15,7 +15,10 @@ limitations under the License.
 
 // See docs in ../ops/data_flow_ops.cc.
 
+#include <algorithm>
+#include <functional>
 #include <vector>
+
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -23,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -39,9 +43,17 @@ class DynamicPartitionOp_Shared : public OpKernel {
     //   in the graph?
   }
 
+  // Splits the N entries of `partitions` into `*num_blocks` contiguous blocks
+  // of `*block_size` entries and counts the entries of each partition in every
+  // block, with one thread per block. Sets
+  // `(*block_offsets)[b * num_partitions_ + p]` to the row of output p at
+  // which the entries of block b start, so that the blocks can be scattered
+  // concurrently in the order of the input.
   void ValidateAndAllocateOutputs(OpKernelContext* c, const Tensor** data,
                                   const Tensor** partitions,
-                                  OpOutputList* Tout) {
+                                  OpOutputList* Tout, int64_t* num_blocks,
+                                  int64_t* block_size,
+                                  std::vector<int64_t>* block_offsets) {
     OP_REQUIRES_OK(c, c->input("data", data));
     OP_REQUIRES_OK(c, c->input("partitions", partitions));
     OP_REQUIRES(
@@ -53,23 +65,51 @@ class DynamicPartitionOp_Shared : public OpKernel {
             ", partitions.shape = ", (*partitions)->shape().DebugString()));
 
     // Count how many occurrences of each partition id we have in partitions
-    gtl::InlinedVector<int, 32> partition_count(num_partitions_);
     auto e_partitions = (*partitions)->flat<int32>();
     const int64_t N = e_partitions.dimension(0);
-    for (int64_t i = 0; i < N; i++) {
-      const int32_t p = internal::SubtleMustCopy(e_partitions(i));
-      OP_REQUIRES(c, FastBoundsCheck(p, num_partitions_),
+    const int64_t slice_size = N > 0 ? (*data)->NumElements() / N : 0;
+    *num_blocks = NumBlocks(c, N, slice_size);
+    *block_size = Eigen::divup(std::max<int64_t>(N, 1), *num_blocks);
+    block_offsets->assign(*num_blocks * num_partitions_, 0);
+    // The first invalid entry of each block, or N.
+    std::vector<int64_t> first_invalid(*num_blocks, N);
+    auto count_blocks = [&](int64_t begin_block, int64_t end_block) {
+      for (int64_t b = begin_block; b < end_block; ++b) {
+        int64_t* counts = block_offsets->data() + b * num_partitions_;
+        const int64_t end = std::min(N, (b + 1) * *block_size);
+        for (int64_t i = b * *block_size; i < end; ++i) {
+          const int32_t p = internal::SubtleMustCopy(e_partitions(i));
+          if (!FastBoundsCheck(p, num_partitions_)) {
+            first_invalid[b] = i;
+            break;
+          }
+          ++counts[p];
+        }
+      }
+    };
+    ForEachBlock(c, *num_blocks, *block_size * 5, count_blocks);
+    for (int64_t b = 0; b < *num_blocks; ++b) {
+      const int64_t i = first_invalid[b];
+      OP_REQUIRES(c, i == N,
                   errors::InvalidArgument(
                       "partitions", SliceDebugString((*partitions)->shape(), i),
-                      " = ", p, " is not in [0, ", num_partitions_, ")"));
-      partition_count[p]++;
+                      " = ", e_partitions(i), " is not in [0, ",
+                      num_partitions_, ")"));
     }
 
-    // Allocate output tensors of the right size
+    // Turn the counts into offsets and allocate output tensors of the right
+    // size.
     OP_REQUIRES_OK(c, c->output_list("outputs", Tout));
     for (int p = 0; p < num_partitions_; p++) {
+      int64_t partition_count = 0;
+      for (int64_t b = 0; b < *num_blocks; ++b) {
+        int64_t& offset = (*block_offsets)[b * num_partitions_ + p];
+        const int64_t count = offset;
+        offset = partition_count;
+        partition_count += count;
+      }
       TensorShape shape;
-      shape.AddDim(partition_count[p]);
+      shape.AddDim(partition_count);
       for (int i = (*partitions)->dims(); i < (*data)->dims(); i++) {
         shape.AddDim((*data)->dim_size(i));
       }
@@ -79,7 +119,36 @@ class DynamicPartitionOp_Shared : public OpKernel {
   }
 
  protected:
+  // Runs `fn` on ranges of [0, num_blocks) in the worker threads. Every block
+  // costs about `block_cost` cycles.
+  static void ForEachBlock(OpKernelContext* c, int64_t num_blocks,
+                           int64_t block_cost,
+                           const std::function<void(int64_t, int64_t)>& fn) {
+    if (num_blocks == 1) {
+      fn(0, 1);
+      return;
+    }
+    auto worker_threads = c->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+          block_cost, fn);
+  }
+
   int num_partitions_;
+
+ private:
+  // One block per worker thread, unless that leaves blocks of fewer than
+  // kMinBlockElements elements of data, or takes more memory for the counts
+  // than the partitions themselves.
+  static constexpr int64_t kMinBlockElements = 32 * 1024;
+
+  int64_t NumBlocks(OpKernelContext* c, int64_t N, int64_t slice_size) const {
+    const int64_t num_threads =
+        c->device()->tensorflow_cpu_worker_threads()->num_threads;
+    const int64_t num_elements = N * std::max<int64_t>(slice_size, 1);
+    return std::max<int64_t>(
+        1, std::min({num_threads, num_elements / kMinBlockElements,
+                     N / std::max(num_partitions_, 1)}));
+  }
 };
 
 template <class T>
@@ -91,69 +160,66 @@ class DynamicPartitionOp : public DynamicPartitionOp_Shared {
     const Tensor* data;
     const Tensor* partitions;
     OpOutputList outputs;
-    ValidateAndAllocateOutputs(c, &data, &partitions, &outputs);
+    int64_t num_blocks;
+    int64_t block_size;
+    std::vector<int64_t> block_offsets;
+    ValidateAndAllocateOutputs(c, &data, &partitions, &outputs, &num_blocks,
+                               &block_size, &block_offsets);
     if (!c->status().ok()) return;
     if (num_partitions_ == 0 || data->NumElements() == 0) return;
 
     auto e_partitions = partitions->flat<int32>();
     const int64_t N = e_partitions.dimension(0);
-    gtl::InlinedVector<int, 32> output_index(num_partitions_);
-
-    if (partitions->dims() == data->dims()) {
-      // Walk through data and copy the data to the appropriate output tensor
-      const auto data_flat = data->flat<T>();
-      std::vector<Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
-                                   Eigen::Aligned> >
-          out_vec;
-      out_vec.reserve(num_partitions_);
-      for (int p = 0; p < num_partitions_; p++) {
-        out_vec.push_back(outputs[p]->vec<T>());
-      }
-      for (int64_t i = 0; i < N; i++) {
-        const int32_t p = internal::SubtleMustCopy(e_partitions(i));
-        OP_REQUIRES(
-            c, FastBoundsCheck(p, num_partitions_),
-            errors::InvalidArgument("indices[", i, "] is out of range"));
-        auto oi = output_index[p];
-        OP_REQUIRES(c, FastBoundsCheck(oi, out_vec[p].size()),
-                    errors::InvalidArgument(
-                        "out_vec[", p, "] size: ", out_vec[p].size(),
-                        " is not LTE output_index[", p, "] : ", oi));
-        out_vec[p](oi) = data_flat(i);
-        output_index[p]++;
-      }
-    } else {
-      // If data has extra dimensions, use Eigen slices
-      std::vector<Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
-                                   Eigen::Aligned> >
-          out_flat;
-      out_flat.reserve(num_partitions_);
-      for (int p = 0; p < num_partitions_; p++) {
-        out_flat.push_back(outputs[p]->flat_outer_dims<T>());
-      }
+    const int64_t slice_size = data->NumElements() / N;
+    const T* data_base = data->flat<T>().data();
+    gtl::InlinedVector<T*, 32> out_base(num_partitions_);
+    for (int p = 0; p < num_partitions_; p++) {
+      out_base[p] = outputs[p]->flat<T>().data();
+    }
 
-      // Walk through data and copy the data to the appropriate output tensor
-      const int64_t slice_size = data->NumElements() / N;
-      const auto data_flat = data->shaped<T, 2>({N, slice_size});
-      Eigen::DSizes<Eigen::DenseIndex, 2> sizes(1, slice_size);
-      for (int64_t i = 0; i < N; i++) {
-        // outputs[p][output_index[p]++] = data[i]
-        const int32_t p = internal::SubtleMustCopy(e_partitions(i));
-        OP_REQUIRES(
-            c, FastBoundsCheck(p, num_partitions_),
-            errors::InvalidArgument("indices[", i,
-                                    "] has been asynchronously overwritten and "
-                                    "is no longer in range!"));
-        auto oi = output_index[p];
-        OP_REQUIRES(c, FastBoundsCheck(oi, out_flat[p].dimension(0)),
-                    errors::InvalidArgument("Size of output_index: ", oi,
-                                            " is no longer in range."));
-        Eigen::DSizes<Eigen::DenseIndex, 2> out_indices(oi, 0);
-        Eigen::DSizes<Eigen::DenseIndex, 2> data_indices(i, 0);
-        out_flat[p].slice(out_indices, sizes) =
-            data_flat.slice(data_indices, sizes);
-        output_index[p]++;
+    // Walk through the blocks of data and copy each row to the appropriate
+    // output tensor: outputs[p][output_index[p]++] = data[i].
+    std::vector<int64_t> overwritten(num_blocks, N);
+    auto scatter_blocks = [&](int64_t begin_block, int64_t end_block) {
+      for (int64_t b = begin_block; b < end_block; ++b) {
+        const int64_t* begin_index = block_offsets.data() + b * num_partitions_;
+        gtl::InlinedVector<int64_t, 32> output_index(
+            begin_index, begin_index + num_partitions_);
+        const int64_t end = std::min(N, (b + 1) * block_size);
+        for (int64_t i = b * block_size; i < end; ++i) {
+          // The partitions were counted before, but may have been
+          // asynchronously overwritten since.
+          const int32_t p = internal::SubtleMustCopy(e_partitions(i));
+          if (!FastBoundsCheck(p, num_partitions_) ||
+              !FastBoundsCheck(output_index[p], outputs[p]->dim_size(0))) {
+            overwritten[b] = i;
+            break;
+          }
+          CopyRow(data_base + i * slice_size,
+                  out_base[p] + output_index[p] * slice_size, slice_size);
+          output_index[p]++;
+        }
       }
+    };
+    ForEachBlock(c, num_blocks, block_size * (slice_size + 1) * sizeof(T),
+                 scatter_blocks);
+    for (int64_t b = 0; b < num_blocks; ++b) {
+      OP_REQUIRES(
+          c, overwritten[b] == N,
+          errors::InvalidArgument("indices[", overwritten[b],
+                                  "] has been asynchronously overwritten and "
+                                  "is no longer in range!"));
+    }
+  }
+
+ private:
+  static void CopyRow(const T* src, T* dst, int64_t slice_size) {
+    if (slice_size == 1) {
+      *dst = *src;
+    } else if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
+      memcpy(dst, src, slice_size * sizeof(T));
+    } else {
+      std::copy_n(src, slice_size, dst);
     }
   }
 };
@@ -16,6 +16,7 @@ limitations under the License.
 #include <functional>
 #include <memory>
 
+#include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
 namespace {
@@ -47,6 +49,13 @@ class DynamicPartitionOpTest : public OpsTestBase {
                      .Finalize(node_def()));
     TF_ASSERT_OK(InitOp());
   }
+
+  void UseIntraOpThreads(int num_threads) {
+    SessionOptions options;
+    options.config.set_intra_op_parallelism_threads(num_threads);
+    SetDevice(DEVICE_CPU, DeviceFactory::NewDevice("CPU", options,
+                                                   "/job:a/replica:0/task:0"));
+  }
 };
 
 TEST_F(DynamicPartitionOpTest, Simple_OneD) {
@@ -159,6 +168,54 @@ TEST_F(DynamicPartitionOpTest, Error_IndexOutOfRange) {
       << s;
 }
 
+TEST_F(DynamicPartitionOpTest, ManyRowsKeepInputOrder) {
+  // Enough rows to be counted and scattered by several threads.
+  UseIntraOpThreads(4);
+  MakeOp();
+
+  constexpr int kRows = 200000;
+  std::vector<float> data(kRows * 2);
+  std::vector<int32> partitions(kRows);
+  for (int i = 0; i < kRows; i++) {
+    data[2 * i] = i;
+    data[2 * i + 1] = -i;
+    partitions[i] = (i * 7 + i / 1000) % 4;
+  }
+  AddInputFromArray<float>(TensorShape({kRows, 2}), data);
+  AddInputFromArray<int32>(TensorShape({kRows}), partitions);
+  TF_ASSERT_OK(RunOpKernel());
+
+  for (int p = 0; p < 4; p++) {
+    std::vector<float> expected_values;
+    for (int i = 0; i < kRows; i++) {
+      if (partitions[i] == p) {
+        expected_values.push_back(i);
+        expected_values.push_back(-i);
+      }
+    }
+    const int64_t rows = expected_values.size() / 2;
+    Tensor expected(allocator(), DT_FLOAT, TensorShape({rows, 2}));
+    test::FillValues<float>(&expected, expected_values);
+    test::ExpectTensorEqual<float>(expected, *GetOutput(p));
+  }
+}
+
+TEST_F(DynamicPartitionOpTest, ManyRowsIndexOutOfRange) {
+  UseIntraOpThreads(4);
+  MakeOp();
+
+  constexpr int kRows = 200000;
+  std::vector<int32> partitions(kRows, 1);
+  partitions[150000] = -1;
+  partitions[170000] = 4;
+  AddInputFromArray<float>(TensorShape({kRows}), std::vector<float>(kRows));
+  AddInputFromArray<int32>(TensorShape({kRows}), partitions);
+  Status s = RunOpKernel();
+  EXPECT_TRUE(absl::StrContains(s.ToString(),
+                                "partitions[150000] = -1 is not in [0, 4)"))
+      << s;
+}
+
 Node* DynamicPartitionNode(Graph* g, Node* in0, Node* in1, int num_partitions) {
   Node* ret;
   TF_CHECK_OK(NodeBuilder(g->NewName("n"), "DynamicPartition")
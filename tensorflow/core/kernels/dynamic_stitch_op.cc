@@ -15,11 +15,18 @@ limitations under the License.
 
 // See docs in ../ops/data_flow_ops.cc.
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 #include "tensorflow/core/kernels/gpu_device_array.h"
@@ -286,25 +293,14 @@ class DynamicStitchOpImplCPU : public DynamicStitchOpImplBase<T> {
           }
         }
       };
-      if (Parallel &&
-          c->device()->tensorflow_cpu_worker_threads()->num_threads > 1) {
-        auto thread_pool =
-            c->device()->tensorflow_cpu_worker_threads()->workers;
-        size_t total_indices_size = 0;
-        for (int input_num = 0; input_num < indices_inputs.size();
-             ++input_num) {
-          total_indices_size += indices_inputs[input_num].NumElements();
-        }
-        const double avg_indices_size =
-            static_cast<double>(total_indices_size) / indices_inputs.size();
-        auto bytes_processed = slice_bytes * avg_indices_size;
-        auto LoopBody = [&](int first, int last) {
-          for (int input_num = first; input_num < last; ++input_num) {
-            OnInputNumber(input_num);
-          }
-        };
-        thread_pool->ParallelFor(indices_inputs.size(), bytes_processed,
-                                 LoopBody);
+      int64_t total_indices_size = 0;
+      for (int input_num = 0; input_num < indices_inputs.size(); ++input_num) {
+        total_indices_size += indices_inputs[input_num].NumElements();
+      }
+      if (c->device()->tensorflow_cpu_worker_threads()->num_threads > 1 &&
+          total_indices_size * slice_size >= kMinParallelElements) {
+        StitchInParallel(c, indices_inputs, data_inputs, first_dim_size,
+                         merged);
       } else {
         for (int input_num = 0; input_num < indices_inputs.size();
              input_num++) {
@@ -313,6 +309,109 @@ class DynamicStitchOpImplCPU : public DynamicStitchOpImplBase<T> {
       }
     }
   }
+
+ private:
+  // Inputs with fewer elements in total are stitched in the calling thread.
+  static constexpr int64_t kMinParallelElements = 32 * 1024;
+
+  // Stitches the inputs with all the worker threads, splitting them by rows
+  // of data rather than by input. Rows are numbered across the inputs, in
+  // their order. For DynamicStitch, where the last row with a given index
+  // wins, the first pass records the last row of every index and the second
+  // one copies the recorded rows; ParallelDynamicStitch copies every row
+  // directly.
+  void StitchInParallel(OpKernelContext* c, const OpInputList& indices_inputs,
+                        const OpInputList& data_inputs, int first_dim_size,
+                        Tensor* merged) {
+    auto merged_flat = merged->flat_outer_dims<T>();
+    const int64_t slice_size = merged_flat.dimension(1);
+    const int num_inputs = indices_inputs.size();
+    // Input i holds rows [input_begin[i], input_begin[i + 1]).
+    std::vector<int64_t> input_begin(num_inputs + 1, 0);
+    std::vector<const int32*> indices_base(num_inputs);
+    std::vector<const T*> data_base(num_inputs);
+    for (int i = 0; i < num_inputs; ++i) {
+      input_begin[i + 1] = input_begin[i] + indices_inputs[i].NumElements();
+      indices_base[i] = indices_inputs[i].flat<int32>().data();
+      data_base[i] = data_inputs[i].template flat<T>().data();
+    }
+    const int64_t num_rows = input_begin[num_inputs];
+    auto input_of_row = [&input_begin](int64_t row) {
+      return static_cast<int>(std::upper_bound(input_begin.begin(),
+                                               input_begin.end(), row) -
+                              input_begin.begin() - 1);
+    };
+
+    mutex mu;
+    Status status;
+    // Calls fn(row, index) for the rows in [begin, end), until an index is out
+    // of range.
+    auto for_each_row = [&](int64_t begin, int64_t end, const auto& fn) {
+      int input_num = input_of_row(begin);
+      for (int64_t row = begin; row < end; ++row) {
+        while (row >= input_begin[input_num + 1]) ++input_num;
+        const int64_t i = row - input_begin[input_num];
+        const int32_t index =
+            internal::SubtleMustCopy(indices_base[input_num][i]);
+        if (!FastBoundsCheck(index, first_dim_size)) {
+          mutex_lock l(mu);
+          status.Update(
+              errors::InvalidArgument("indices[", i, "] is out of range"));
+          return;
+        }
+        fn(row, index);
+      }
+    };
+    auto copy_row = [&](int64_t row, int32_t index) {
+      const int input_num = input_of_row(row);
+      CopyRow(data_base[input_num] +
+                  (row - input_begin[input_num]) * slice_size,
+              merged_flat.data() + index * slice_size, slice_size);
+    };
+
+    auto worker_threads = c->device()->tensorflow_cpu_worker_threads();
+    const int64_t copy_cost = slice_size * sizeof(T) + 20;
+    if (Parallel) {
+      Shard(worker_threads->num_threads, worker_threads->workers, num_rows,
+            copy_cost, [&](int64_t begin, int64_t end) {
+              for_each_row(begin, end, copy_row);
+            });
+      OP_REQUIRES_OK(c, status);
+      return;
+    }
+
+    std::unique_ptr<std::atomic<int64_t>[]> last_row(
+        new std::atomic<int64_t>[first_dim_size]);
+    for (int index = 0; index < first_dim_size; ++index) {
+      last_row[index].store(-1, std::memory_order_relaxed);
+    }
+    Shard(worker_threads->num_threads, worker_threads->workers, num_rows,
+          /*cost_per_unit=*/20, [&](int64_t begin, int64_t end) {
+            for_each_row(begin, end, [&last_row](int64_t row, int32_t index) {
+              int64_t last = last_row[index].load(std::memory_order_relaxed);
+              while (last < row && !last_row[index].compare_exchange_weak(
+                                       last, row, std::memory_order_relaxed)) {
+              }
+            });
+          });
+    OP_REQUIRES_OK(c, status);
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          first_dim_size, copy_cost, [&](int64_t begin, int64_t end) {
+            for (int64_t index = begin; index < end; ++index) {
+              const int64_t row =
+                  last_row[index].load(std::memory_order_relaxed);
+              if (row >= 0) copy_row(row, index);
+            }
+          });
+  }
+
+  static void CopyRow(const T* src, T* dst, int64_t slice_size) {
+    if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
+      memcpy(dst, src, slice_size * sizeof(T));
+    } else {
+      std::copy_n(src, slice_size, dst);
+    }
+  }
 };
 
 // Using inheritance rather than a typedef so that these classes might have more
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include <functional>
 #include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
 
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -30,19 +33,60 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
 namespace {
 
 class DynamicStitchOpTest : public OpsTestBase {
  protected:
-  void MakeOp(int n, DataType dt) {
-    TF_ASSERT_OK(NodeDefBuilder("myop", "DynamicStitch")
+  void MakeOp(int n, DataType dt, const string& op = "DynamicStitch") {
+    TF_ASSERT_OK(NodeDefBuilder("myop", op)
                      .Input(FakeInput(n, DT_INT32))
                      .Input(FakeInput(n, dt))
                      .Finalize(node_def()));
     TF_ASSERT_OK(InitOp());
   }
+
+  void UseIntraOpThreads(int num_threads) {
+    SessionOptions options;
+    options.config.set_intra_op_parallelism_threads(num_threads);
+    SetDevice(DEVICE_CPU, DeviceFactory::NewDevice("CPU", options,
+                                                   "/job:a/replica:0/task:0"));
+  }
+
+  // Stitches `num_inputs` inputs of `rows_per_input` rows of two elements,
+  // with a row for every index in [0, num_indices), which is smaller than the
+  // number of rows when there are duplicates. Checks that each index gets the
+  // last row with it.
+  void StitchManyRows(const string& op, int num_inputs, int rows_per_input,
+                      int num_indices) {
+    // Enough rows to be stitched by several threads.
+    UseIntraOpThreads(4);
+    MakeOp(num_inputs, DT_FLOAT, op);
+    std::vector<float> expected_values(num_indices * 2);
+    std::vector<std::vector<float>> data(num_inputs);
+    for (int input = 0; input < num_inputs; input++) {
+      std::vector<int32> indices(rows_per_input);
+      for (int i = 0; i < rows_per_input; i++) {
+        const int row = input * rows_per_input + i;
+        indices[i] = (row * 7919) % num_indices;
+        data[input].push_back(row);
+        data[input].push_back(-row);
+        expected_values[indices[i] * 2] = row;
+        expected_values[indices[i] * 2 + 1] = -row;
+      }
+      AddInputFromArray<int32>(TensorShape({rows_per_input}), indices);
+    }
+    for (int input = 0; input < num_inputs; input++) {
+      AddInputFromArray<float>(TensorShape({rows_per_input, 2}), data[input]);
+    }
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected(allocator(), DT_FLOAT, TensorShape({num_indices, 2}));
+    test::FillValues<float>(&expected, expected_values);
+    test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+  }
 };
 
 TEST_F(DynamicStitchOpTest, Simple_OneD) {
@@ -142,5 +186,36 @@ TEST_F(DynamicStitchOpTest, Error_DataAndIndicesSizeMismatch) {
       << s;
 }
 
+TEST_F(DynamicStitchOpTest, ManyRows) {
+  StitchManyRows("DynamicStitch", 3, 50000, 150000);
+}
+
+TEST_F(DynamicStitchOpTest, ManyRowsLastDuplicateWins) {
+  StitchManyRows("DynamicStitch", 3, 50000, 40000);
+}
+
+TEST_F(DynamicStitchOpTest, ParallelManyRows) {
+  StitchManyRows("ParallelDynamicStitch", 3, 50000, 150000);
+}
+
+TEST_F(DynamicStitchOpTest, ManyRowsIndexOutOfRange) {
+  UseIntraOpThreads(4);
+  MakeOp(2, DT_FLOAT);
+
+  constexpr int kRows = 100000;
+  std::vector<int32> indices(kRows);
+  for (int i = 0; i < kRows; i++) {
+    indices[i] = i;
+  }
+  AddInputFromArray<int32>(TensorShape({kRows}), indices);
+  indices[60000] = -1;
+  AddInputFromArray<int32>(TensorShape({kRows}), indices);
+  AddInputFromArray<float>(TensorShape({kRows}), std::vector<float>(kRows));
+  AddInputFromArray<float>(TensorShape({kRows}), std::vector<float>(kRows));
+  Status s = RunOpKernel();
+  EXPECT_TRUE(absl::StrContains(s.ToString(), "indices[60000] is out of range"))
+      << s;
+}
+
 }  // namespace
 }  // namespace tensorflow
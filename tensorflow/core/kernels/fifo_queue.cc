@@ -19,6 +19,8 @@ limitations under the License.
 
 #include <algorithm>
 #include <deque>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
 #include <vector>
 
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -37,20 +39,125 @@ namespace tensorflow {
 FIFOQueue::FIFOQueue(int capacity, const DataTypeVector& component_dtypes,
                      const std::vector<TensorShape>& component_shapes,
                      const string& name)
-    : TypedQueue(capacity, component_dtypes, component_shapes, name) {}
+    : TypedQueue(capacity, component_dtypes, component_shapes, name),
+      ring_(capacity > 0 && capacity <= kMaxRingCapacity
+                ? new BoundedMpmcQueue<Tuple>(capacity)
+                : nullptr),
+      fast_path_enabled_(ring_ != nullptr) {}
+
+int32 FIFOQueue::size() const {
+  mutex_lock lock(mu_);
+  if (ring_ == nullptr) return queues_[0].size();
+  // The ring is not exact while the fast path runs, which is fine for a
+  // queue that may change concurrently anyway.
+  return restored_.size() + ring_->size();
+}
+
+int64_t FIFOQueue::MemoryUsed() const {
+  if (ring_ == nullptr) return TypedQueue::MemoryUsed();
+  int64_t memory_size = 0;
+  {
+    mutex_lock lock(mu_);
+    StopFastPathLocked();
+    const Tuple* front =
+        restored_.empty() ? ring_->front() : &restored_.front();
+    if (front != nullptr) {
+      for (const Tensor& component : *front) {
+        memory_size += SizeLocked() * component.AllocatedBytes();
+      }
+    }
+  }
+  MaybeRestartFastPath();
+  return memory_size;
+}
+
+void FIFOQueue::StopFastPathLocked() const {
+  if (ring_ == nullptr) return;
+  fast_path_enabled_.store(false);
+  // The operations that saw the fast path enabled finish without blocking.
+  while (fast_path_users_.load() != 0) {
+    std::this_thread::yield();
+  }
+}
+
+void FIFOQueue::MaybeRestartFastPath() const {
+  if (ring_ == nullptr) return;
+  mutex_lock lock(mu_);
+  if (!closed_ && !closing_ && enqueue_attempts_.empty() &&
+      dequeue_attempts_.empty() && restored_.empty()) {
+    fast_path_enabled_.store(true);
+  }
+}
+
+bool FIFOQueue::TryEnqueueFast(const Tuple& tuple) {
+  if (ring_ == nullptr) return false;
+  // Pairs with StopFastPathLocked: either it sees this operation in
+  // fast_path_users_, or this operation sees the fast path disabled.
+  fast_path_users_.fetch_add(1);
+  const bool done = fast_path_enabled_.load() && ring_->TryPush(tuple);
+  fast_path_users_.fetch_sub(1);
+  return done;
+}
+
+bool FIFOQueue::TryDequeueFast(Tuple* tuple) {
+  if (ring_ == nullptr) return false;
+  fast_path_users_.fetch_add(1);
+  const bool done = fast_path_enabled_.load() && ring_->TryPop(tuple);
+  fast_path_users_.fetch_sub(1);
+  return done;
+}
+
+int64_t FIFOQueue::SizeLocked() const {
+  if (ring_ == nullptr) return queues_[0].size();
+  return restored_.size() + ring_->size();
+}
+
+void FIFOQueue::EnqueueLocked(const Tuple& tuple) {
+  if (ring_ == nullptr) {
+    for (int i = 0; i < num_components(); ++i) {
+      queues_[i].push_back(tuple[i]);
+    }
+    return;
+  }
+  const bool pushed = ring_->TryPush(tuple);
+  DCHECK(pushed) << "FIFOQueue '" << name_ << "' is full.";
+}
 
 void FIFOQueue::DequeueLocked(OpKernelContext* ctx, Tuple* tuple) {
-  DCHECK_GT(queues_[0].size(), size_t{0});
-  (*tuple).reserve(num_components());
-  for (int i = 0; i < num_components(); ++i) {
-    (*tuple).push_back(queues_[i][0]);
-    queues_[i].pop_front();
+  DCHECK_GT(SizeLocked(), 0);
+  if (ring_ == nullptr) {
+    (*tuple).reserve(num_components());
+    for (int i = 0; i < num_components(); ++i) {
+      (*tuple).push_back(queues_[i][0]);
+      queues_[i].pop_front();
+    }
+    return;
+  }
+  if (!restored_.empty()) {
+    *tuple = std::move(restored_.front());
+    restored_.pop_front();
+    return;
+  }
+  ring_->TryPop(tuple);
+}
+
+void FIFOQueue::RestoreLocked(const Tuple& tuple) {
+  if (ring_ == nullptr) {
+    for (int i = 0; i < num_components(); ++i) {
+      queues_[i].push_front(tuple[i]);
+    }
+    return;
   }
+  restored_.push_front(tuple);
 }
 
 void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
                            DoneCallback callback) {
   CancellationManager* cm = ctx->cancellation_manager();
+  if (!cm->IsCancelled() && TryEnqueueFast(tuple)) {
+    callback();
+    return;
+  }
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -58,6 +165,7 @@ void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
     already_cancelled = !cm->RegisterCallback(
         token, [this, cm, token]() { Cancel(kEnqueue, cm, token); });
     if (!already_cancelled) {
+      StopFastPathLocked();
       enqueue_attempts_.emplace_back(
           1, callback, ctx, cm, token,
           [tuple, this](Attempt* attempt) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -66,10 +174,8 @@ void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
                   errors::Cancelled("FIFOQueue '", name_, "' is closed."));
               return kComplete;
             }
-            if (queues_[0].size() < static_cast<size_t>(capacity_)) {
-              for (int i = 0; i < num_components(); ++i) {
-                queues_[i].push_back(tuple[i]);
-              }
+            if (SizeLocked() < capacity_) {
+              EnqueueLocked(tuple);
               return kComplete;
             } else {
               return kNoProgress;
@@ -79,6 +185,7 @@ void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
   }
   if (!already_cancelled) {
     FlushUnlocked();
+    MaybeRestartFastPath();
   } else {
     ctx->SetStatus(errors::Cancelled("Enqueue operation was cancelled"));
     callback();
@@ -115,6 +222,7 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
     already_cancelled = !cm->RegisterCallback(
         token, [this, cm, token]() { Cancel(kEnqueue, cm, token); });
     if (!already_cancelled) {
+      StopFastPathLocked();
       enqueue_attempts_.emplace_back(
           batch_size, callback, ctx, cm, token,
           [tuple, this](Attempt* attempt) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -124,17 +232,20 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
               return kComplete;
             }
             RunResult result = kNoProgress;
-            while (queues_[0].size() < static_cast<size_t>(capacity_)) {
+            while (SizeLocked() < capacity_) {
               result = kProgress;
               const int64_t index =
                   tuple[0].dim_size(0) - attempt->elements_requested;
+              Tuple element_tuple;
+              element_tuple.reserve(num_components());
               for (int i = 0; i < num_components(); ++i) {
                 Tensor element;
                 attempt->context->SetStatus(GetElementComponentFromBatch(
                     tuple, index, i, attempt->context, &element));
                 if (!attempt->context->status().ok()) return kComplete;
-                queues_[i].push_back(element);
+                element_tuple.push_back(std::move(element));
               }
+              EnqueueLocked(element_tuple);
               --attempt->elements_requested;
               if (attempt->elements_requested == 0) {
                 return kComplete;
@@ -146,6 +257,7 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
   }
   if (!already_cancelled) {
     FlushUnlocked();
+    MaybeRestartFastPath();
   } else {
     ctx->SetStatus(errors::Cancelled("Enqueue operation was cancelled"));
     callback();
@@ -154,6 +266,13 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
 
 void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
   CancellationManager* cm = ctx->cancellation_manager();
+  if (!cm->IsCancelled()) {
+    Tuple tuple;
+    if (TryDequeueFast(&tuple)) {
+      callback(tuple);
+      return;
+    }
+  }
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
   {
@@ -161,11 +280,12 @@ void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
     already_cancelled = !cm->RegisterCallback(
         token, [this, cm, token]() { Cancel(kDequeue, cm, token); });
     if (!already_cancelled) {
+      StopFastPathLocked();
       // TODO(josh11b): This makes two copies of callback, avoid this if possible.
       dequeue_attempts_.emplace_back(
           1, [callback]() { callback(Tuple()); }, ctx, cm, token,
           [callback, this](Attempt* attempt) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-            const int64_t queue_size = queues_[0].size();
+            const int64_t queue_size = SizeLocked();
             if (closed_ && queue_size == 0) {
               attempt->context->SetStatus(errors::OutOfRange(
                   "FIFOQueue '", name_, "' is closed and has ",
@@ -186,6 +306,7 @@ void FIFOQueue::TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) {
   }
   if (!already_cancelled) {
     FlushUnlocked();
+    MaybeRestartFastPath();
   } else {
     ctx->SetStatus(errors::Cancelled("Dequeue operation was cancelled"));
     callback(Tuple());
@@ -252,12 +373,13 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
     already_cancelled = !cm->RegisterCallback(
         token, [this, cm, token]() { Cancel(kDequeue, cm, token); });
     if (!already_cancelled) {
+      StopFastPathLocked();
       // TODO(josh11b): This makes two copies of callback, avoid this if possible.
       dequeue_attempts_.emplace_back(
           num_elements, [callback]() { callback(Tuple()); }, ctx, cm, token,
           [callback, allow_small_batch,
            this](Attempt* attempt) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-            int64_t queue_size = queues_[0].size();
+            int64_t queue_size = SizeLocked();
 
             if (closed_ && queue_size < attempt->elements_requested) {
               // If we don't have enough for a full dequeue, we have
@@ -268,6 +390,8 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
                 for (int64_t i = attempt->tuple[0].dim_size(0) -
                                  attempt->elements_requested - 1;
                      i >= 0; --i) {
+                  Tuple element_tuple;
+                  element_tuple.reserve(num_components());
                   for (int j = 0; j < num_components(); ++j) {
                     Tensor element;
                     Status s = GetElementComponentFromBatch(
@@ -279,13 +403,14 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
                                            "to FIFOQueue: ",
                                            s.error_message()));
                     }
-                    queues_[j].push_front(element);
+                    element_tuple.push_back(std::move(element));
                   }
+                  RestoreLocked(element_tuple);
                 }
               }
-              if (allow_small_batch && !queues_[0].empty()) {
+              if (allow_small_batch && SizeLocked() > 0) {
                 // Request all remaining elements in the queue.
-                queue_size = queues_[0].size();
+                queue_size = SizeLocked();
                 attempt->tuple.clear();
                 attempt->elements_requested = queue_size;
               } else {
@@ -349,12 +474,23 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
   }
   if (!already_cancelled) {
     FlushUnlocked();
+    MaybeRestartFastPath();
   } else {
     ctx->SetStatus(errors::Cancelled("Dequeue operation was cancelled"));
     callback(Tuple());
   }
 }
 
+void FIFOQueue::Close(OpKernelContext* ctx, bool cancel_pending_enqueues,
+                      DoneCallback callback) {
+  {
+    mutex_lock lock(mu_);
+    closing_ = true;
+    StopFastPathLocked();
+  }
+  QueueBase::Close(ctx, cancel_pending_enqueues, std::move(callback));
+}
+
 Status FIFOQueue::MatchesNodeDef(const NodeDef& node_def) {
   if (!MatchesNodeDefOp(node_def, "FIFOQueue").ok() &&
       !MatchesNodeDefOp(node_def, "FIFOQueueV2").ok()) {
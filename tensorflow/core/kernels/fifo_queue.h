@@ -16,13 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_FIFO_QUEUE_H_
 #define TENSORFLOW_CORE_KERNELS_FIFO_QUEUE_H_
 
+#include <atomic>
 #include <deque>
+#include <memory>
 #include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/bounded_mpmc_queue.h"
 #include "tensorflow/core/kernels/queue_op.h"
 #include "tensorflow/core/kernels/typed_queue.h"
 #include "tensorflow/core/platform/macros.h"
@@ -31,8 +34,16 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Bounded queues keep their elements in a lock-free ring, so that an Enqueue
+// that finds room and a Dequeue that finds an element complete without
+// taking mu_. Every other operation (blocking ones, EnqueueMany, DequeueMany,
+// Close) stops this fast path first and then runs on the attempt queues of
+// QueueBase, with exclusive access to the ring, as for unbounded queues.
 class FIFOQueue : public TypedQueue<std::deque<Tensor> > {
  public:
+  // The largest capacity for which the elements are kept in a ring.
+  static constexpr int32_t kMaxRingCapacity = 1 << 16;
+
   FIFOQueue(int32_t capacity, const DataTypeVector& component_dtypes,
             const std::vector<TensorShape>& component_shapes,
             const string& name);
@@ -47,26 +58,64 @@ class FIFOQueue : public TypedQueue<std::deque<Tensor> > {
   void TryDequeueMany(int num_elements, OpKernelContext* ctx,
                       bool allow_small_batch,
                       CallbackWithTuple callback) override;
+  void Close(OpKernelContext* ctx, bool cancel_pending_enqueues,
+             DoneCallback callback) override;
   Status MatchesNodeDef(const NodeDef& node_def) override;
 
-  int32 size() const override {
-    mutex_lock lock(mu_);
-    return queues_[0].size();
-  }
+  int32 size() const override;
+
+  int64_t MemoryUsed() const override;
 
  protected:
   ~FIFOQueue() override {}
 
-  // Helper for dequeuing a single element from queues_.
+  // Stops the fast path and waits for the operations running on it, after
+  // which the elements may be accessed under mu_. Must be called in the same
+  // critical section that adds an attempt.
+  void StopFastPathLocked() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Restarts the fast path, unless an attempt or the state of the queue still
+  // needs the slow one.
+  void MaybeRestartFastPath() const;
+
+  // The helpers below access the elements, and require the fast path to be
+  // stopped.
+
+  // Returns the number of elements.
+  int64_t SizeLocked() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Appends an element.
+  void EnqueueLocked(const Tuple& tuple) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Helper for dequeuing a single element.
   void DequeueLocked(OpKernelContext* ctx, Tuple* tuple)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Puts an element back at the front.
+  void RestoreLocked(const Tuple& tuple) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   static Status GetElementComponentFromBatch(const Tuple& tuple, int64_t index,
                                              int component,
                                              OpKernelContext* ctx,
                                              Tensor* out_tensor);
 
  private:
+  // Tries to enqueue or dequeue on the fast path. Returns false if the fast
+  // path is stopped, or if the queue is full or empty respectively.
+  bool TryEnqueueFast(const Tuple& tuple);
+  bool TryDequeueFast(Tuple* tuple);
+
+  // The elements of a bounded queue, or nullptr if they are in queues_.
+  const std::unique_ptr<BoundedMpmcQueue<Tuple>> ring_;
+  // Elements that a partial DequeueMany puts back in front of ring_.
+  std::deque<Tuple> restored_ TF_GUARDED_BY(mu_);
+  // Set once Close has been called, after which only the slow path runs.
+  bool closing_ TF_GUARDED_BY(mu_) = false;
+  // Whether Enqueue and Dequeue may use ring_ without holding mu_, and the
+  // number of them that currently do.
+  mutable std::atomic<bool> fast_path_enabled_;
+  mutable std::atomic<int> fast_path_users_{0};
+
   TF_DISALLOW_COPY_AND_ASSIGN(FIFOQueue);
 };
 
@@ -0,0 +1,197 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace {
+
+Node* Queue(Graph* g, int capacity) {
+  Node* node;
+  TF_CHECK_OK(NodeBuilder("queue", "FIFOQueueV2")
+                  .Attr("component_types", DataTypeVector({DT_INT32}))
+                  .Attr("shapes", std::vector<TensorShape>({TensorShape()}))
+                  .Attr("capacity", capacity)
+                  .Finalize(g, &node));
+  return node;
+}
+
+Node* Enqueue(Graph* g, const string& name, Node* queue, Node* value,
+              const string& op) {
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(name, op)
+                  .Input(queue)
+                  .Input(std::vector<NodeBuilder::NodeOut>({value}))
+                  .Finalize(g, &node));
+  return node;
+}
+
+Node* Dequeue(Graph* g, const string& name, Node* queue) {
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(name, "QueueDequeueV2")
+                  .Input(queue)
+                  .Attr("component_types", DataTypeVector({DT_INT32}))
+                  .Finalize(g, &node));
+  return node;
+}
+
+Node* DequeueMany(Graph* g, const string& name, Node* queue, int n) {
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(name, "QueueDequeueManyV2")
+                  .Input(queue)
+                  .Input(test::graph::Constant(g, test::AsScalar<int32>(n)))
+                  .Attr("component_types", DataTypeVector({DT_INT32}))
+                  .Finalize(g, &node));
+  return node;
+}
+
+Node* QueueOp(Graph* g, const string& name, Node* queue, const string& op) {
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(name, op).Input(queue).Finalize(g, &node));
+  return node;
+}
+
+// Runs the operations of a single queue in separate steps of a session.
+class FIFOQueueTest : public ::testing::TestWithParam<int> {
+ protected:
+  void SetUp() override {
+    Graph g(OpRegistry::Global());
+    Node* queue = Queue(&g, GetParam());
+    Enqueue(&g, "enqueue_1", queue,
+            test::graph::Constant(&g, test::AsScalar<int32>(1)),
+            "QueueEnqueueV2");
+    Enqueue(&g, "enqueue_2", queue,
+            test::graph::Constant(&g, test::AsScalar<int32>(2)),
+            "QueueEnqueueV2");
+    Enqueue(&g, "enqueue_3_4", queue,
+            test::graph::Constant(&g, test::AsTensor<int32>({3, 4})),
+            "QueueEnqueueManyV2");
+    Dequeue(&g, "dequeue", queue);
+    DequeueMany(&g, "dequeue_2", queue, 2);
+    QueueOp(&g, "size", queue, "QueueSizeV2");
+    QueueOp(&g, "close", queue, "QueueCloseV2");
+    GraphDef graph_def;
+    g.ToGraphDef(&graph_def);
+    session_.reset(NewSession(SessionOptions()));
+    TF_ASSERT_OK(session_->Create(graph_def));
+  }
+
+  Status RunTarget(const string& target) {
+    return session_->Run({}, {}, {target}, nullptr);
+  }
+
+  Status Fetch(const string& output, Tensor* value) {
+    std::vector<Tensor> outputs;
+    TF_RETURN_IF_ERROR(session_->Run({}, {output}, {}, &outputs));
+    *value = outputs[0];
+    return Status::OK();
+  }
+
+  std::unique_ptr<Session> session_;
+};
+
+TEST_P(FIFOQueueTest, KeepsOrderAcrossEnqueueManyAndDequeueMany) {
+  TF_ASSERT_OK(RunTarget("enqueue_1"));
+  TF_ASSERT_OK(RunTarget("enqueue_2"));
+  TF_ASSERT_OK(RunTarget("enqueue_3_4"));
+  Tensor value;
+  TF_ASSERT_OK(Fetch("size", &value));
+  test::ExpectTensorEqual<int32>(value, test::AsScalar<int32>(4));
+  TF_ASSERT_OK(Fetch("dequeue", &value));
+  test::ExpectTensorEqual<int32>(value, test::AsScalar<int32>(1));
+  TF_ASSERT_OK(Fetch("dequeue_2", &value));
+  test::ExpectTensorEqual<int32>(value, test::AsTensor<int32>({2, 3}));
+  TF_ASSERT_OK(RunTarget("enqueue_1"));
+  TF_ASSERT_OK(Fetch("dequeue", &value));
+  test::ExpectTensorEqual<int32>(value, test::AsScalar<int32>(4));
+  TF_ASSERT_OK(Fetch("dequeue", &value));
+  test::ExpectTensorEqual<int32>(value, test::AsScalar<int32>(1));
+  TF_ASSERT_OK(Fetch("size", &value));
+  test::ExpectTensorEqual<int32>(value, test::AsScalar<int32>(0));
+}
+
+TEST_P(FIFOQueueTest, BlockedDequeueSeesLaterEnqueue) {
+  Tensor value;
+  std::unique_ptr<Thread> consumer(
+      Env::Default()->StartThread({}, "consumer", [this, &value]() {
+        TF_CHECK_OK(Fetch("dequeue", &value));
+      }));
+  Env::Default()->SleepForMicroseconds(100000);
+  TF_ASSERT_OK(RunTarget("enqueue_2"));
+  consumer.reset();
+  test::ExpectTensorEqual<int32>(value, test::AsScalar<int32>(2));
+  // The queue goes back to the fast path once the waiting dequeue is done.
+  TF_ASSERT_OK(RunTarget("enqueue_1"));
+  TF_ASSERT_OK(Fetch("dequeue", &value));
+  test::ExpectTensorEqual<int32>(value, test::AsScalar<int32>(1));
+}
+
+TEST_P(FIFOQueueTest, Close) {
+  TF_ASSERT_OK(RunTarget("enqueue_1"));
+  TF_ASSERT_OK(RunTarget("close"));
+  EXPECT_TRUE(errors::IsCancelled(RunTarget("enqueue_2")));
+  Tensor value;
+  EXPECT_TRUE(errors::IsOutOfRange(Fetch("dequeue_2", &value)));
+  TF_ASSERT_OK(Fetch("dequeue", &value));
+  test::ExpectTensorEqual<int32>(value, test::AsScalar<int32>(1));
+  EXPECT_TRUE(errors::IsOutOfRange(Fetch("dequeue", &value)));
+}
+
+// A bounded queue keeps its elements in a ring, an unbounded one in deques.
+INSTANTIATE_TEST_SUITE_P(Capacities, FIFOQueueTest, ::testing::Values(4, -1));
+
+// Enqueues and dequeues an element in each of `num_pairs` independent pairs
+// of ops per step, which the executor runs concurrently.
+void BM_FIFOQueueEnqueueDequeue(::testing::benchmark::State& state) {
+  const int capacity = state.range(0);
+  const int num_pairs = state.range(1);
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* queue = Queue(g, capacity);
+  for (int i = 0; i < num_pairs; ++i) {
+    Node* enqueue = Enqueue(
+        g, g->NewName("enqueue"), queue,
+        test::graph::Constant(g, test::AsScalar<int32>(i)), "QueueEnqueueV2");
+    Node* dequeue = Dequeue(g, g->NewName("dequeue"), queue);
+    g->AddControlEdge(enqueue, dequeue);
+  }
+  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  state.SetItemsProcessed(state.iterations() * num_pairs);
+}
+BENCHMARK(BM_FIFOQueueEnqueueDequeue)
+    ->UseRealTime()
+    ->ArgPair(1024, 1)
+    ->ArgPair(1024, 16)
+    ->ArgPair(1024, 256)
+    ->ArgPair(-1, 1)
+    ->ArgPair(-1, 16)
+    ->ArgPair(-1, 256);
+
+}  // namespace
+}  // namespace tensorflow
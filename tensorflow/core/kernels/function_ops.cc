@@ -239,6 +239,7 @@ class SymbolicGradientOp : public AsyncOpKernel {
     opts.runner = ctx->runner();
     opts.run_all_kernels_inline = ctx->run_all_kernels_inline();
     opts.stats_collector = ctx->stats_collector();
+    opts.request_cost = ctx->request_cost();
     opts.step_container = ctx->step_container();
     std::vector<Tensor> args;
     args.reserve(ctx->num_inputs());
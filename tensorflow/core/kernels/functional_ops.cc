@@ -115,6 +115,7 @@ void SetRunOptions(OpKernelContext* ctx, FunctionLibraryRuntime::Options* opts,
   opts->collective_executor = ctx->collective_executor();
   if (always_collect_stats) {
     opts->stats_collector = ctx->stats_collector();
+    opts->request_cost = ctx->request_cost();
   }
   opts->runner = ctx->runner();
   opts->run_all_kernels_inline = ctx->run_all_kernels_inline();
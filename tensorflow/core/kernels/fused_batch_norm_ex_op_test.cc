@@ -522,7 +522,6 @@ INSTANTIATE_TYPED_TEST_SUITE_P(Test, FusedBatchNormExOpTrainingTest,
 // -------------------------------------------------------------------------- //
 // FusedBatchNormEx[is_training=false].
 
-#if defined(GOOGLE_CUDA)
 template <typename T>
 using FusedBatchNormExOpInferenceTest =
     FusedBatchNormExOpTestBase<T, float>;  // scale is always float
@@ -545,15 +544,21 @@ TYPED_TEST_P(FusedBatchNormExOpInferenceTest,
                                kWithSideInput, "Relu");
 }
 
-REGISTER_TYPED_TEST_SUITE_P(FusedBatchNormExOpInferenceTest,  //
-                            InferenceInNHWCTest,              //
-                            InferenceWithReluInNHWCTest,      //
-                            InferenceWithSideInputAndReluInNHWCTest);
+TYPED_TEST_P(FusedBatchNormExOpInferenceTest,
+             InferenceWithSideInputAndReluInNCHWTest) {
+  this->VerifyFusedBatchNormEx(4, 28, 28, 256, FORMAT_NCHW, kInInference,
+                               kWithSideInput, "Relu");
+}
+
+REGISTER_TYPED_TEST_SUITE_P(FusedBatchNormExOpInferenceTest,          //
+                            InferenceInNHWCTest,                      //
+                            InferenceWithReluInNHWCTest,              //
+                            InferenceWithSideInputAndReluInNHWCTest,  //
+                            InferenceWithSideInputAndReluInNCHWTest);
 
 using FusedBatchNormExInferenceDataTypes = ::testing::Types<Eigen::half, float>;
 INSTANTIATE_TYPED_TEST_SUITE_P(Test, FusedBatchNormExOpInferenceTest,
                                FusedBatchNormExInferenceDataTypes);
-#endif  // defined(GOOGLE_CUDA)
 
 // -------------------------------------------------------------------------- //
 // Performance benchmarks are below.                                          //
@@ -661,4 +666,8 @@ BM_FusedBatchNorm(64, 14, 14, 256, fp32, NCHW, false, Relu, gpu);
 BM_FusedBatchNorm(64, 14, 14, 256, fp32, NCHW, false, AddAndRelu, gpu);
 #endif  // defined(GOOGLE_CUDA)
 
+BM_FusedBatchNorm(64, 14, 14, 256, fp32, NHWC, false, Identity, cpu);
+BM_FusedBatchNorm(64, 14, 14, 256, fp32, NHWC, false, Relu, cpu);
+BM_FusedBatchNorm(64, 14, 14, 256, fp32, NHWC, false, AddAndRelu, cpu);
+
 }  // namespace tensorflow
@@ -247,15 +247,6 @@ struct FusedBatchNorm<CPUDevice, T, U, /* is_training= */ false> {
                   Tensor* batch_var_output, Tensor* saved_mean_output,
                   Tensor* saved_var_output, TensorFormat tensor_format,
                   bool use_reserved_space) {
-    OP_REQUIRES(context, side_input == nullptr,
-                errors::Internal(
-                    "The CPU implementation of FusedBatchNorm does not support "
-                    "side input."));
-    OP_REQUIRES(context,
-                activation_mode == FusedBatchNormActivationMode::kIdentity,
-                errors::Internal("The CPU implementation of FusedBatchNorm "
-                                 "does not support activations."));
-
     if (use_reserved_space) {
       Tensor* dummy_reserve_space = nullptr;
       OP_REQUIRES_OK(context,
@@ -274,6 +265,7 @@ struct FusedBatchNorm<CPUDevice, T, U, /* is_training= */ false> {
 
     Tensor transformed_x;
     Tensor transformed_y;
+    Tensor transformed_side_input;
     if (tensor_format == FORMAT_NCHW) {
       const int64_t in_batch = GetTensorDim(x_input, tensor_format, 'N');
       const int64_t in_rows = GetTensorDim(x_input, tensor_format, 'H');
@@ -294,9 +286,20 @@ struct FusedBatchNorm<CPUDevice, T, U, /* is_training= */ false> {
       OP_REQUIRES_OK(
           context, ::tensorflow::DoTranspose(context->eigen_device<CPUDevice>(),
                                              x_input, perm, &transformed_x));
+      if (side_input != nullptr) {
+        OP_REQUIRES_OK(context, context->allocate_temp(
+                                    DataTypeToEnum<T>::value,
+                                    transformed_x.shape(),
+                                    &transformed_side_input));
+        OP_REQUIRES_OK(context, ::tensorflow::DoTranspose(
+                                    context->eigen_device<CPUDevice>(),
+                                    *side_input, perm,
+                                    &transformed_side_input));
+      }
     } else {
       transformed_x = x_input;
       transformed_y = *y_output;
+      if (side_input != nullptr) transformed_side_input = *side_input;
     }
     typename TTypes<T, 4>::Tensor x(transformed_x.tensor<T, 4>());
     typename TTypes<U>::ConstVec scale(scale_input.vec<U>());
@@ -329,20 +332,46 @@ struct FusedBatchNorm<CPUDevice, T, U, /* is_training= */ false> {
     bcast_spec.set(0, rest_size);
 #endif
 
-    auto x_rest_by_depth = x.reshape(rest_by_depth).template cast<U>();
-    auto x_centered =
-        x_rest_by_depth -
-        estimated_mean.reshape(one_by_depth).broadcast(bcast_spec);
-    auto scaling_factor = ((estimated_variance + epsilon).rsqrt() * scale)
-                              .eval()
-                              .reshape(one_by_depth)
-                              .broadcast(bcast_spec);
-    auto x_scaled = x_centered * scaling_factor;
-    auto x_shifted =
-        (x_scaled + offset.reshape(one_by_depth).broadcast(bcast_spec))
-            .template cast<T>();
+    // Fold the mean and variance into a per-channel scale and offset, so that
+    // normalizing x, adding the side input and applying the activation all
+    // happen in a single pass over the input:
+    //   y = activation(x * folded_scale + folded_offset + side_input)
+    Tensor folded_scale_tensor;
+    Tensor folded_offset_tensor;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<U>::value,
+                                          TensorShape({depth}),
+                                          &folded_scale_tensor));
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<U>::value,
+                                          TensorShape({depth}),
+                                          &folded_offset_tensor));
+    typename TTypes<U>::Vec folded_scale(folded_scale_tensor.vec<U>());
+    typename TTypes<U>::Vec folded_offset(folded_offset_tensor.vec<U>());
+    folded_scale = (estimated_variance + epsilon).rsqrt() * scale;
+    folded_offset = offset - estimated_mean * folded_scale;
 
-    y.reshape(rest_by_depth).device(d) = x_shifted;
+    auto x_shifted =
+        x.reshape(rest_by_depth).template cast<U>() *
+            folded_scale.reshape(one_by_depth).broadcast(bcast_spec) +
+        folded_offset.reshape(one_by_depth).broadcast(bcast_spec);
+    const bool use_relu =
+        activation_mode == FusedBatchNormActivationMode::kRelu;
+    auto y_rest_by_depth = y.reshape(rest_by_depth);
+    if (side_input != nullptr) {
+      auto side = transformed_side_input.shaped<T, 2>({rest_size, depth})
+                      .template cast<U>();
+      if (use_relu) {
+        y_rest_by_depth.device(d) =
+            (x_shifted + side).cwiseMax(U(0)).template cast<T>();
+      } else {
+        y_rest_by_depth.device(d) = (x_shifted + side).template cast<T>();
+      }
+    } else if (use_relu) {
+      y_rest_by_depth.device(d) = x_shifted.cwiseMax(U(0)).template cast<T>();
+    } else {
+      y_rest_by_depth.device(d) = x_shifted.template cast<T>();
+    }
     batch_mean.device(d) = estimated_mean;
     batch_variance.device(d) = estimated_variance;
 
@@ -1762,6 +1791,18 @@ REGISTER_KERNEL_BUILDER(Name("FusedBatchNormGradV3")
                             .TypeConstraint<float>("U"),
                         FusedBatchNormGradOpV3<CPUDevice, Eigen::half, float>);
 
+REGISTER_KERNEL_BUILDER(Name("_FusedBatchNormEx")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("T")
+                            .TypeConstraint<float>("U"),
+                        FusedBatchNormOpEx<CPUDevice, float, float>);
+
+REGISTER_KERNEL_BUILDER(Name("_FusedBatchNormEx")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<Eigen::half>("T")
+                            .TypeConstraint<float>("U"),
+                        FusedBatchNormOpEx<CPUDevice, Eigen::half, float>);
+
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
 REGISTER_KERNEL_BUILDER(
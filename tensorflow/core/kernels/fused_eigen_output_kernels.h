@@ -40,6 +40,9 @@ enum class FusedComputationType {
   kBiasAddWithRelu6,
   kBiasAddWithElu,
   kBiasAddWithLeakyRelu,
+  kBiasAddWithGeluApproximate,
+  kBiasAddWithGeluExact,
+  kBiasAddWithSwish,
   kFusedBatchNorm,
   kFusedBatchNormWithRelu,
   kFusedBatchNormWithRelu6,
@@ -129,6 +132,40 @@ struct LeakyRelu {
   };
 };
 
+// Applies `Gelu` with the tanh approximation to the passed input expression:
+//   0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+struct GeluApproximate {
+  template <typename XprType>
+  static auto apply(XprType expr) {
+    using Scalar = typename XprType::Scalar;
+    const Scalar kSqrtTwoOverPi(0.7978845608028654);
+    const Scalar kCoefficient(0.044715);
+    return (expr * Scalar(0.5)) *
+           (((expr + expr.cube() * kCoefficient) * kSqrtTwoOverPi).tanh() +
+            Scalar(1));
+  };
+};
+
+// Applies the exact `Gelu` to the passed input expression:
+//   0.5 * x * (1 + erf(x / sqrt(2)))
+struct GeluExact {
+  template <typename XprType>
+  static auto apply(XprType expr) {
+    using Scalar = typename XprType::Scalar;
+    const Scalar kSqrtOneHalf(0.7071067811865476);
+    return (expr * Scalar(0.5)) * ((expr * kSqrtOneHalf).erf() + Scalar(1));
+  };
+};
+
+// Applies `Swish` (also known as SiLU) to the passed input expression:
+//   x * sigmoid(x)
+struct Swish {
+  template <typename XprType>
+  static auto apply(XprType expr) {
+    return expr * expr.sigmoid();
+  };
+};
+
 template <typename T>
 struct BiasAddArgs {
   const T* bias_add_data = nullptr;
@@ -139,7 +176,10 @@ struct BiasAddArgs {
            fusion == FusedComputationType::kBiasAddWithRelu ||
            fusion == FusedComputationType::kBiasAddWithRelu6 ||
            fusion == FusedComputationType::kBiasAddWithElu ||
-           fusion == FusedComputationType::kBiasAddWithLeakyRelu;
+           fusion == FusedComputationType::kBiasAddWithLeakyRelu ||
+           fusion == FusedComputationType::kBiasAddWithGeluApproximate ||
+           fusion == FusedComputationType::kBiasAddWithGeluExact ||
+           fusion == FusedComputationType::kBiasAddWithSwish;
   }
 };
 
@@ -356,6 +396,12 @@ using WithBiasAddAndElu = BiasAddOutputKernel<T, Elu>;
 template <typename T>
 using WithBiasAddAndLeakyRelu = BiasAddOutputKernel<T, LeakyRelu>;
 template <typename T>
+using WithBiasAddAndGeluApproximate = BiasAddOutputKernel<T, GeluApproximate>;
+template <typename T>
+using WithBiasAddAndGeluExact = BiasAddOutputKernel<T, GeluExact>;
+template <typename T>
+using WithBiasAddAndSwish = BiasAddOutputKernel<T, Swish>;
+template <typename T>
 using WithFusedBatchNorm = FusedBatchNormOutputKernel<T>;
 template <typename T>
 using WithFusedBatchNormAndRelu = FusedBatchNormOutputKernel<T, Relu>;
@@ -0,0 +1,245 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Kernels for the transformer building blocks that the Grappler remapper
+// fuses from primitive ops: LayerNorm, scaled masked Softmax and Gelu.
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/fused_transformer_ops.h"
+
+#include <type_traits>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/softmax_op_cpu_impl.h"
+#include "tensorflow/core/util/bcast.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+template <typename Device, typename T>
+class FusedLayerNormOp : public OpKernel {
+ public:
+  // Statistics of half and bfloat16 inputs are accumulated in float.
+  using U = float;
+
+  explicit FusedLayerNormOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    const Tensor& scale = context->input(1);
+    const Tensor& offset = context->input(2);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(x.shape()),
+                errors::InvalidArgument("x must have >= 1 dimension, got ",
+                                        x.shape().DebugString()));
+    const int64_t depth = x.dim_size(x.dims() - 1);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(scale.shape()) &&
+                    scale.NumElements() == depth,
+                errors::InvalidArgument("scale must be a vector of size ",
+                                        depth, ", got ",
+                                        scale.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(offset.shape()) &&
+                    offset.NumElements() == depth,
+                errors::InvalidArgument("offset must be a vector of size ",
+                                        depth, ", got ",
+                                        offset.shape().DebugString()));
+
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, x.shape(), &y));
+    if (x.NumElements() == 0) return;
+
+    const int64_t rows = x.NumElements() / depth;
+    Tensor mean;
+    OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<U>::value,
+                                                   TensorShape({rows}), &mean));
+    Tensor inv_stddev;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(DataTypeToEnum<U>::value,
+                                          TensorShape({rows}), &inv_stddev));
+
+    functor::FusedLayerNorm<Device, T, U> functor;
+    functor(context->eigen_device<Device>(), x.flat_inner_dims<T>(),
+            scale.vec<T>(), offset.vec<T>(), static_cast<U>(epsilon_),
+            mean.vec<U>(), inv_stddev.vec<U>(), y->flat_inner_dims<T>());
+  }
+
+ private:
+  float epsilon_;
+};
+
+template <typename Device, typename T>
+class FusedScaledMaskedSoftmaxOp : public OpKernel {
+ public:
+  explicit FusedScaledMaskedSoftmaxOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("scale", &scale_));
+    OP_REQUIRES_OK(context, context->GetAttr("log", &log_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& logits = context->input(0);
+    const Tensor& mask = context->input(1);
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(logits.shape()),
+                errors::InvalidArgument("logits must have >= 1 dimension, got ",
+                                        logits.shape().DebugString()));
+
+    BCast bcast(BCast::FromShape(logits.shape()),
+                BCast::FromShape(mask.shape()),
+                /*fewer_dims_optimization=*/true);
+    OP_REQUIRES(context,
+                bcast.IsValid() &&
+                    BCast::ToShape(bcast.output_shape()) == logits.shape(),
+                errors::InvalidArgument(
+                    "mask must be broadcastable to the shape of logits, got ",
+                    mask.shape().DebugString(), " and ",
+                    logits.shape().DebugString()));
+
+    Tensor* softmax = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, logits.shape(), &softmax));
+    if (logits.NumElements() == 0) return;
+
+    if (std::is_same<Device, CPUDevice>::value) {
+      // Normalizes the rows without materializing the masked logits.
+      const functor::SoftmaxMask<T> softmax_mask(mask, logits.shape());
+      functor::SoftmaxRowsCpu<T>(context->eigen_device<CPUDevice>(),
+                                 logits.flat_inner_dims<T>(), scale_,
+                                 &softmax_mask, log_,
+                                 softmax->flat_inner_dims<T>());
+      return;
+    }
+
+    const int ndims = static_cast<int>(bcast.x_reshape().size());
+    switch (ndims) {
+#define NDIMS_CASE(N)                                  \
+  case N:                                              \
+    Compute<N>(context, logits, mask, bcast, softmax); \
+    break;
+      NDIMS_CASE(1);
+      NDIMS_CASE(2);
+      NDIMS_CASE(3);
+      NDIMS_CASE(4);
+      NDIMS_CASE(5);
+#undef NDIMS_CASE
+      default:
+        context->SetStatus(errors::Unimplemented(
+            "Masks that need a broadcast of more than 5 dimensions are not "
+            "supported, got ",
+            mask.shape().DebugString(), " and ", logits.shape().DebugString()));
+    }
+  }
+
+ private:
+  template <int NDIMS>
+  void Compute(OpKernelContext* context, const Tensor& logits,
+               const Tensor& mask, const BCast& bcast, Tensor* softmax) {
+    functor::FusedScaledMaskedSoftmax<Device, T, NDIMS> functor;
+    functor(context->eigen_device<Device>(),
+            logits.shaped<T, NDIMS>(bcast.x_reshape()), static_cast<T>(scale_),
+            mask.shaped<T, NDIMS>(bcast.y_reshape()),
+            BCast::ToIndexArray<NDIMS>(bcast.y_bcast()), log_,
+            softmax->flat_inner_dims<T>());
+  }
+
+  float scale_;
+  bool log_;
+};
+
+template <typename Device, typename T>
+class FusedGeluOp : public OpKernel {
+ public:
+  explicit FusedGeluOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("approximate", &approximate_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& features = context->input(0);
+    Tensor* activations = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, features.shape(), &activations));
+    functor::FusedGelu<Device, T> functor;
+    functor(context->eigen_device<Device>(), features.flat<T>(), approximate_,
+            activations->flat<T>());
+  }
+
+ private:
+  bool approximate_;
+};
+
+#define REGISTER_CPU(T)                                                       \
+  REGISTER_KERNEL_BUILDER(                                                    \
+      Name("_FusedLayerNorm").Device(DEVICE_CPU).TypeConstraint<T>("T"),      \
+      FusedLayerNormOp<CPUDevice, T>);                                        \
+  REGISTER_KERNEL_BUILDER(Name("_FusedScaledMaskedSoftmax")                   \
+                              .Device(DEVICE_CPU)                             \
+                              .TypeConstraint<T>("T"),                        \
+                          FusedScaledMaskedSoftmaxOp<CPUDevice, T>);          \
+  REGISTER_KERNEL_BUILDER(                                                    \
+      Name("_FusedGelu").Device(DEVICE_CPU).TypeConstraint<T>("T"),           \
+      FusedGeluOp<CPUDevice, T>);
+
+TF_CALL_half(REGISTER_CPU);
+TF_CALL_float(REGISTER_CPU);
+TF_CALL_bfloat16(REGISTER_CPU);
+#undef REGISTER_CPU
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                         \
+  extern template struct FusedLayerNorm<GPUDevice, T, float>;       \
+  extern template struct FusedScaledMaskedSoftmax<GPUDevice, T, 1>; \
+  extern template struct FusedScaledMaskedSoftmax<GPUDevice, T, 2>; \
+  extern template struct FusedScaledMaskedSoftmax<GPUDevice, T, 3>; \
+  extern template struct FusedScaledMaskedSoftmax<GPUDevice, T, 4>; \
+  extern template struct FusedScaledMaskedSoftmax<GPUDevice, T, 5>; \
+  extern template struct FusedGelu<GPUDevice, T>;
+
+TF_CALL_half(DECLARE_GPU_SPEC);
+TF_CALL_float(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+#define REGISTER_GPU(T)                                                       \
+  REGISTER_KERNEL_BUILDER(                                                    \
+      Name("_FusedLayerNorm").Device(DEVICE_GPU).TypeConstraint<T>("T"),      \
+      FusedLayerNormOp<GPUDevice, T>);                                        \
+  REGISTER_KERNEL_BUILDER(Name("_FusedScaledMaskedSoftmax")                   \
+                              .Device(DEVICE_GPU)                             \
+                              .TypeConstraint<T>("T"),                        \
+                          FusedScaledMaskedSoftmaxOp<GPUDevice, T>);          \
+  REGISTER_KERNEL_BUILDER(                                                    \
+      Name("_FusedGelu").Device(DEVICE_GPU).TypeConstraint<T>("T"),           \
+      FusedGeluOp<GPUDevice, T>);
+
+TF_CALL_half(REGISTER_GPU);
+TF_CALL_float(REGISTER_GPU);
+#undef REGISTER_GPU
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+}  // namespace tensorflow
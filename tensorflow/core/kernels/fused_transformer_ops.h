@@ -0,0 +1,128 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_FUSED_TRANSFORMER_OPS_H_
+#define TENSORFLOW_CORE_KERNELS_FUSED_TRANSFORMER_OPS_H_
+// Functor definitions for the _FusedLayerNorm, _FusedScaledMaskedSoftmax and
+// _FusedGelu ops created by the Grappler remapper, must be compilable by nvcc.
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/softmax_op_functor.h"
+
+namespace tensorflow {
+namespace functor {
+
+// Functor used by FusedLayerNormOp to do the computations.
+template <typename Device, typename T, typename U>
+struct FusedLayerNorm {
+  // Normalizes every row of `x` and applies `scale` and `offset`. The
+  // statistics are accumulated in `U`, which is float for half and bfloat16.
+  //
+  // x: dims: rows, depth.
+  // scale, offset: dims: depth.
+  // mean, inv_stddev: dims: rows, scratch space for the statistics.
+  // y: dims: rows, depth.
+  void operator()(const Device& d, typename TTypes<T>::ConstMatrix x,
+                  typename TTypes<T>::ConstVec scale,
+                  typename TTypes<T>::ConstVec offset, const U epsilon,
+                  typename TTypes<U>::Vec mean,
+                  typename TTypes<U>::Vec inv_stddev,
+                  typename TTypes<T>::Matrix y) {
+    const Eigen::Index rows = x.dimension(0);
+    const Eigen::Index depth = x.dimension(1);
+
+    Eigen::IndexList<Eigen::type2index<1>> along_depth;
+    Eigen::IndexList<Eigen::Index, Eigen::type2index<1>> rows_by_one;
+    rows_by_one.set(0, rows);
+    Eigen::IndexList<Eigen::type2index<1>, Eigen::Index> one_by_depth;
+    one_by_depth.set(1, depth);
+
+    auto x_u = x.template cast<U>();
+    mean.device(d) = x_u.mean(along_depth);
+    auto centered = x_u - mean.reshape(rows_by_one).broadcast(one_by_depth);
+    inv_stddev.device(d) = (centered.square().mean(along_depth) + epsilon)
+                               .rsqrt();
+
+    auto scale_u = scale.template cast<U>().reshape(one_by_depth).broadcast(
+        rows_by_one);
+    auto offset_u = offset.template cast<U>().reshape(one_by_depth).broadcast(
+        rows_by_one);
+    y.device(d) =
+        (centered * inv_stddev.reshape(rows_by_one).broadcast(one_by_depth) *
+             scale_u +
+         offset_u)
+            .template cast<T>();
+  }
+};
+
+// Functor used by FusedScaledMaskedSoftmaxOp to do the computations.
+template <typename Device, typename T, int NDIMS>
+struct FusedScaledMaskedSoftmax {
+  // Computes Softmax(logits * scale + mask), or its log if `log` is true,
+  // along the innermost dimension. The masked logits are written to `softmax`
+  // and normalized in place, so the op reads the logits once instead of
+  // materializing the Mul and Add. SoftmaxRowsCpu is used on CPU instead.
+  //
+  // logits: logits reshaped to NDIMS (see BCast::x_reshape).
+  // mask: mask reshaped to NDIMS (see BCast::y_reshape).
+  // mask_bcast: broadcast of the mask to the shape of the logits.
+  // softmax: dims: batch_size, num_classes; same buffer size as the logits.
+  void operator()(const Device& d,
+                  typename TTypes<T, NDIMS>::ConstTensor logits, const T scale,
+                  typename TTypes<T, NDIMS>::ConstTensor mask,
+                  const Eigen::array<Eigen::Index, NDIMS>& mask_bcast,
+                  const bool log, typename TTypes<T>::Matrix softmax) {
+    typename TTypes<T, NDIMS>::Tensor masked_logits(softmax.data(),
+                                                    logits.dimensions());
+    masked_logits.device(d) = logits * scale + mask.broadcast(mask_bcast);
+    typename TTypes<T>::ConstMatrix masked_logits_matrix(softmax.data(),
+                                                         softmax.dimensions());
+    SoftmaxEigenImpl<Device, T>::Compute(d, masked_logits_matrix, softmax,
+                                         log);
+  }
+};
+
+// Functor used by FusedGeluOp to do the computations. Matches the `GeluExact`
+// and `GeluApproximate` output kernels of _FusedMatMul.
+template <typename Device, typename T>
+struct FusedGelu {
+  // features: any shape.
+  // activations: same shape as "features".
+  void operator()(const Device& d, typename TTypes<T>::ConstFlat features,
+                  const bool approximate,
+                  typename TTypes<T>::Flat activations) {
+    if (approximate) {
+      // 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+      const T kSqrtTwoOverPi(0.7978845608028654);
+      const T kCoefficient(0.044715);
+      activations.device(d) =
+          (features * T(0.5)) *
+          (((features + features.cube() * kCoefficient) * kSqrtTwoOverPi)
+               .tanh() +
+           T(1));
+    } else {
+      // 0.5 * x * (1 + erf(x / sqrt(2)))
+      const T kSqrtOneHalf(0.7071067811865476);
+      activations.device(d) =
+          (features * T(0.5)) * ((features * kSqrtOneHalf).erf() + T(1));
+    }
+  }
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_FUSED_TRANSFORMER_OPS_H_
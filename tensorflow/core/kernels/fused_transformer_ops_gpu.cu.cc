@@ -0,0 +1,43 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/fused_transformer_ops.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+// Definition of the GPU implementations declared in fused_transformer_ops.cc.
+#define DEFINE_GPU_KERNELS(T)                                         \
+  template struct functor::FusedLayerNorm<GPUDevice, T, float>;       \
+  template struct functor::FusedScaledMaskedSoftmax<GPUDevice, T, 1>; \
+  template struct functor::FusedScaledMaskedSoftmax<GPUDevice, T, 2>; \
+  template struct functor::FusedScaledMaskedSoftmax<GPUDevice, T, 3>; \
+  template struct functor::FusedScaledMaskedSoftmax<GPUDevice, T, 4>; \
+  template struct functor::FusedScaledMaskedSoftmax<GPUDevice, T, 5>; \
+  template struct functor::FusedGelu<GPUDevice, T>;
+
+TF_CALL_half(DEFINE_GPU_KERNELS);
+TF_CALL_float(DEFINE_GPU_KERNELS);
+#undef DEFINE_GPU_KERNELS
+
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -0,0 +1,246 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedTransformerOpsTest : public OpsTestBase {};
+
+TEST_F(FusedTransformerOpsTest, LayerNorm) {
+  TF_ASSERT_OK(NodeDefBuilder("layer_norm", "_FusedLayerNorm")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("epsilon", 0.001f)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+
+  const std::vector<float> x = {1, 2, 3, 4, -2, 0, 2, 8};
+  const std::vector<float> scale = {1, 2, 0.5, -1};
+  const std::vector<float> offset = {0, 1, -1, 0.5};
+  AddInputFromArray<float>(TensorShape({2, 4}), x);
+  AddInputFromArray<float>(TensorShape({4}), scale);
+  AddInputFromArray<float>(TensorShape({4}), offset);
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<float> expected(x.size());
+  for (int row = 0; row < 2; ++row) {
+    float mean = 0;
+    for (int i = 0; i < 4; ++i) mean += x[row * 4 + i] / 4;
+    float variance = 0;
+    for (int i = 0; i < 4; ++i) {
+      const float centered = x[row * 4 + i] - mean;
+      variance += centered * centered / 4;
+    }
+    for (int i = 0; i < 4; ++i) {
+      expected[row * 4 + i] = (x[row * 4 + i] - mean) /
+                                  std::sqrt(variance + 0.001f) * scale[i] +
+                              offset[i];
+    }
+  }
+  Tensor expected_tensor(allocator(), DT_FLOAT, TensorShape({2, 4}));
+  test::FillValues<float>(&expected_tensor, expected);
+  test::ExpectClose(expected_tensor, *GetOutput(0), /*atol=*/1e-5);
+}
+
+TEST_F(FusedTransformerOpsTest, LayerNormRejectsMismatchedScale) {
+  TF_ASSERT_OK(NodeDefBuilder("layer_norm", "_FusedLayerNorm")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({3}), {1, 1, 1});
+  AddInputFromArray<float>(TensorShape({2}), {0, 0});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+TEST_F(FusedTransformerOpsTest, ScaledMaskedSoftmaxBroadcastsTheMask) {
+  TF_ASSERT_OK(NodeDefBuilder("softmax", "_FusedScaledMaskedSoftmax")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("scale", 0.5f)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+
+  // Attention scores of shape [batch, heads, queries, keys] and a padding
+  // mask of shape [batch, 1, 1, keys].
+  const std::vector<float> logits = {1, 2, 3, 4, 5, 6, 7, 8,
+                                     8, 7, 6, 5, 4, 3, 2, 1};
+  const std::vector<float> mask = {0, -1e9, 0, 0};
+  AddInputFromArray<float>(TensorShape({2, 2, 2, 2}), logits);
+  AddInputFromArray<float>(TensorShape({2, 1, 1, 2}), mask);
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<float> expected(logits.size());
+  for (int row = 0; row < 8; ++row) {
+    const int batch = row / 4;
+    float masked[2];
+    for (int i = 0; i < 2; ++i) {
+      masked[i] = logits[row * 2 + i] * 0.5f + mask[batch * 2 + i];
+    }
+    const float max = std::max(masked[0], masked[1]);
+    const float sum = std::exp(masked[0] - max) + std::exp(masked[1] - max);
+    for (int i = 0; i < 2; ++i) {
+      expected[row * 2 + i] = std::exp(masked[i] - max) / sum;
+    }
+  }
+  Tensor expected_tensor(allocator(), DT_FLOAT, TensorShape({2, 2, 2, 2}));
+  test::FillValues<float>(&expected_tensor, expected);
+  test::ExpectClose(expected_tensor, *GetOutput(0), /*atol=*/1e-6);
+}
+
+TEST_F(FusedTransformerOpsTest, ScaledMaskedSoftmaxRejectsBroadcastLogits) {
+  TF_ASSERT_OK(NodeDefBuilder("softmax", "_FusedScaledMaskedSoftmax")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+
+  AddInputFromArray<float>(TensorShape({1, 2}), {1, 2});
+  AddInputFromArray<float>(TensorShape({2, 2}), {0, 0, 0, 0});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+// Reference Softmax or LogSoftmax of the rows of `masked_logits`.
+std::vector<float> ReferenceSoftmax(const std::vector<float>& masked_logits,
+                                    int num_classes, bool log) {
+  std::vector<float> softmax(masked_logits.size());
+  for (size_t begin = 0; begin < masked_logits.size(); begin += num_classes) {
+    double max = -INFINITY;
+    for (int i = 0; i < num_classes; ++i) {
+      max = std::max<double>(max, masked_logits[begin + i]);
+    }
+    double sum = 0;
+    for (int i = 0; i < num_classes; ++i) {
+      sum += std::exp(masked_logits[begin + i] - max);
+    }
+    for (int i = 0; i < num_classes; ++i) {
+      const double shifted = masked_logits[begin + i] - max;
+      softmax[begin + i] = log ? shifted - std::log(sum)
+                               : std::exp(shifted) / sum;
+    }
+  }
+  return softmax;
+}
+
+TEST_F(FusedTransformerOpsTest, MaskedLogSoftmaxOfLongRows) {
+  TF_ASSERT_OK(NodeDefBuilder("softmax", "_FusedScaledMaskedSoftmax")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("log", true)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+
+  // Rows of several chunks of the CPU kernel, and a mask of the classes.
+  const int num_classes = 1000;
+  std::vector<float> logits(3 * num_classes);
+  std::vector<float> mask(num_classes);
+  for (size_t i = 0; i < logits.size(); ++i) logits[i] = (i * 37 % 101) * 0.25f;
+  for (int i = 0; i < num_classes; ++i) mask[i] = i % 7 == 0 ? -1e4f : 0.0f;
+  AddInputFromArray<float>(TensorShape({3, num_classes}), logits);
+  AddInputFromArray<float>(TensorShape({num_classes}), mask);
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<float> masked_logits(logits.size());
+  for (size_t i = 0; i < logits.size(); ++i) {
+    masked_logits[i] = logits[i] + mask[i % num_classes];
+  }
+  Tensor expected_tensor(allocator(), DT_FLOAT, TensorShape({3, num_classes}));
+  test::FillValues<float>(
+      &expected_tensor,
+      ReferenceSoftmax(masked_logits, num_classes, /*log=*/true));
+  test::ExpectClose(expected_tensor, *GetOutput(0), /*atol=*/1e-4);
+}
+
+TEST_F(FusedTransformerOpsTest, SoftmaxOfRowsStartingWithInfinities) {
+  TF_ASSERT_OK(NodeDefBuilder("softmax", "_FusedScaledMaskedSoftmax")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+
+  // The first row is -inf up to its last chunk, and the mask is a scalar per
+  // row.
+  const int num_classes = 600;
+  std::vector<float> logits(2 * num_classes);
+  for (size_t i = 0; i < logits.size(); ++i) {
+    logits[i] = i < 550 ? -INFINITY : (i % 13) * 0.5f;
+  }
+  const std::vector<float> mask = {1, -2};
+  AddInputFromArray<float>(TensorShape({2, num_classes}), logits);
+  AddInputFromArray<float>(TensorShape({2, 1}), mask);
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<float> masked_logits(logits.size());
+  for (size_t i = 0; i < logits.size(); ++i) {
+    masked_logits[i] = logits[i] + mask[i / num_classes];
+  }
+  Tensor expected_tensor(allocator(), DT_FLOAT, TensorShape({2, num_classes}));
+  test::FillValues<float>(
+      &expected_tensor,
+      ReferenceSoftmax(masked_logits, num_classes, /*log=*/false));
+  test::ExpectClose(expected_tensor, *GetOutput(0), /*atol=*/1e-6);
+}
+
+class FusedGeluOpTest : public OpsTestBase,
+                        public ::testing::WithParamInterface<bool> {};
+
+TEST_P(FusedGeluOpTest, Gelu) {
+  const bool approximate = GetParam();
+  TF_ASSERT_OK(NodeDefBuilder("gelu", "_FusedGelu")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("approximate", approximate)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+
+  const std::vector<float> features = {-3, -1, -0.5, 0, 0.5, 1, 3};
+  AddInputFromArray<float>(TensorShape({7}), features);
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<float> expected;
+  for (float x : features) {
+    if (approximate) {
+      expected.push_back(
+          0.5f * x *
+          (1 + std::tanh(std::sqrt(2 / M_PI) * (x + 0.044715f * x * x * x))));
+    } else {
+      expected.push_back(0.5f * x * (1 + std::erf(x / std::sqrt(2.0f))));
+    }
+  }
+  Tensor expected_tensor(allocator(), DT_FLOAT, TensorShape({7}));
+  test::FillValues<float>(&expected_tensor, expected);
+  test::ExpectClose(expected_tensor, *GetOutput(0), /*atol=*/1e-6);
+}
+
+INSTANTIATE_TEST_SUITE_P(ExactAndApproximate, FusedGeluOpTest,
+                         ::testing::Bool());
+
+}  // namespace
+}  // namespace tensorflow
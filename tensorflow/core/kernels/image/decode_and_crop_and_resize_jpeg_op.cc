@@ -0,0 +1,289 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace {
+
+// The scale denominators libjpeg can decode with, from the smallest output.
+constexpr int kDecodeRatios[] = {8, 4, 2, 1};
+
+// Rough cost of decoding and resizing an image, high enough for the images of
+// a batch to be decoded in parallel.
+constexpr int64_t kCostPerImage = 1 << 20;
+
+// Where an output row (or column) is bilinearly sampled from in the input.
+struct Interpolation {
+  bool valid;
+  int64_t lower;
+  int64_t upper;
+  float lerp;
+};
+
+// Computes the sample positions of the `output_size` rows (or columns) of the
+// crop of [begin, end) from an image of `input_size` rows, as CropAndResize
+// does. Returns the smallest window of input rows [*window_begin, *window_end)
+// that contains all the samples, or an empty one.
+std::vector<Interpolation> ComputeInterpolation(float begin, float end,
+                                                int64_t input_size,
+                                                int64_t output_size,
+                                                int64_t* window_begin,
+                                                int64_t* window_end) {
+  const float scale =
+      output_size > 1 ? (end - begin) * (input_size - 1) / (output_size - 1)
+                      : 0;
+  std::vector<Interpolation> interpolation(output_size);
+  *window_begin = input_size;
+  *window_end = 0;
+  for (int64_t i = 0; i < output_size; ++i) {
+    const float in = output_size > 1 ? begin * (input_size - 1) + i * scale
+                                     : 0.5f * (begin + end) * (input_size - 1);
+    Interpolation& sample = interpolation[i];
+    sample.valid = in >= 0 && in <= input_size - 1;
+    if (!sample.valid) continue;
+    sample.lower = static_cast<int64_t>(std::floor(in));
+    sample.upper = static_cast<int64_t>(std::ceil(in));
+    sample.lerp = in - sample.lower;
+    *window_begin = std::min(*window_begin, sample.lower);
+    *window_end = std::max(*window_end, sample.upper + 1);
+  }
+  return interpolation;
+}
+
+// Samples `crops`, of shape [crop_height, crop_width, channels], from the
+// decoded window of an image.
+void BilinearSample(const std::vector<Interpolation>& ys,
+                    const std::vector<Interpolation>& xs,
+                    const uint8* window, int64_t window_y, int64_t window_x,
+                    int64_t window_width, int channels,
+                    float extrapolation_value, float* crops) {
+  const int64_t window_stride = window_width * channels;
+  for (const Interpolation& y : ys) {
+    const uint8* top = window + (y.lower - window_y) * window_stride;
+    const uint8* bottom = window + (y.upper - window_y) * window_stride;
+    for (const Interpolation& x : xs) {
+      if (!y.valid || !x.valid) {
+        std::fill_n(crops, channels, extrapolation_value);
+        crops += channels;
+        continue;
+      }
+      const int64_t left = (x.lower - window_x) * channels;
+      const int64_t right = (x.upper - window_x) * channels;
+      for (int c = 0; c < channels; ++c) {
+        const float top_left(top[left + c]);
+        const float top_right(top[right + c]);
+        const float bottom_left(bottom[left + c]);
+        const float bottom_right(bottom[right + c]);
+        const float top_value = top_left + (top_right - top_left) * x.lerp;
+        const float bottom_value =
+            bottom_left + (bottom_right - bottom_left) * x.lerp;
+        *crops++ = top_value + (bottom_value - top_value) * y.lerp;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+// Decodes a batch of JPEG images, and crops and resizes each of them into its
+// slot of the output batch. Every image is decoded at the smallest scale that
+// keeps its crop at least as large as the output, which lets libjpeg skip
+// most of the inverse DCT of large images, and only the rows and columns of
+// the crop are decoded.
+class DecodeAndCropAndResizeJpegOp : public OpKernel {
+ public:
+  explicit DecodeAndCropAndResizeJpegOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels_));
+    OP_REQUIRES(context, channels_ == 1 || channels_ == 3,
+                errors::InvalidArgument("channels must be 1 or 3, got ",
+                                        channels_));
+    string dct_method;
+    OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
+    OP_REQUIRES(
+        context,
+        (dct_method.empty() || dct_method == "INTEGER_FAST" ||
+         dct_method == "INTEGER_ACCURATE"),
+        errors::InvalidArgument("dct_method must be one of "
+                                "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
+    OP_REQUIRES_OK(context, context->GetAttr("extrapolation_value",
+                                             &extrapolation_value_));
+    flags_.components = channels_;
+    // As in DecodeJpeg, the default is IFAST, sacrificing image quality for
+    // speed.
+    flags_.dct_method =
+        dct_method == "INTEGER_ACCURATE" ? JDCT_ISLOW : JDCT_IFAST;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    const Tensor& boxes = context->input(1);
+    const Tensor& crop_size = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(contents.shape()),
+                errors::InvalidArgument("contents must be a vector, got shape ",
+                                        contents.shape().DebugString()));
+    const int64_t batch_size = contents.dim_size(0);
+    OP_REQUIRES(context,
+                boxes.dims() == 2 && boxes.dim_size(0) == batch_size &&
+                    boxes.dim_size(1) == 4,
+                errors::InvalidArgument("boxes must have shape [", batch_size,
+                                        ", 4], got ",
+                                        boxes.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(crop_size.shape()) &&
+                    crop_size.dim_size(0) == 2,
+                errors::InvalidArgument("crop_size must be a vector of 2 "
+                                        "elements, got shape ",
+                                        crop_size.shape().DebugString()));
+    const int64_t crop_height = crop_size.vec<int32>()(0);
+    const int64_t crop_width = crop_size.vec<int32>()(1);
+    OP_REQUIRES(context, crop_height > 0 && crop_width > 0,
+                errors::InvalidArgument("crop dimensions must be positive, "
+                                        "got ",
+                                        crop_height, "x", crop_width));
+
+    Tensor* crops = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0,
+                       TensorShape({batch_size, crop_height, crop_width,
+                                    static_cast<int64_t>(channels_)}),
+                       &crops));
+    if (batch_size == 0) return;
+
+    const auto contents_vec = contents.vec<tstring>();
+    const auto boxes_matrix = boxes.matrix<float>();
+    float* crops_data = crops->flat<float>().data();
+    const int64_t crop_elements = crop_height * crop_width * channels_;
+
+    // The error of the first image that fails, whatever the shard order.
+    mutex mu;
+    int64_t error_index = batch_size;
+    Status status;
+    auto decode_images = [&](int64_t start, int64_t limit) {
+      for (int64_t i = start; i < limit; ++i) {
+        Status image_status = DecodeAndCropAndResize(
+            contents_vec(i), boxes_matrix(i, 0), boxes_matrix(i, 1),
+            boxes_matrix(i, 2), boxes_matrix(i, 3), crop_height, crop_width,
+            crops_data + i * crop_elements);
+        if (!image_status.ok()) {
+          mutex_lock l(mu);
+          if (i < error_index) {
+            error_index = i;
+            status = errors::InvalidArgument("Image ", i, ": ",
+                                             image_status.error_message());
+          }
+          return;
+        }
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          kCostPerImage, decode_images);
+    OP_REQUIRES_OK(context, status);
+  }
+
+ private:
+  Status DecodeAndCropAndResize(StringPiece input, float y1, float x1,
+                                float y2, float x2, int64_t crop_height,
+                                int64_t crop_width, float* crops) const {
+    if (input.size() > std::numeric_limits<int>::max()) {
+      return errors::InvalidArgument("JPEG contents are too large for int: ",
+                                     input.size());
+    }
+    int width, height, components;
+    if (!jpeg::GetImageInfo(input.data(), input.size(), &width, &height,
+                            &components)) {
+      return errors::InvalidArgument("Invalid JPEG data, size ",
+                                     input.size());
+    }
+
+    // The largest scale denominator that keeps the crop at least as large as
+    // the output in both dimensions.
+    int ratio = 1;
+    for (int r : kDecodeRatios) {
+      if (std::abs(y2 - y1) * height >= crop_height * r &&
+          std::abs(x2 - x1) * width >= crop_width * r) {
+        ratio = r;
+        break;
+      }
+    }
+    // libjpeg rounds the scaled dimensions up.
+    const int64_t scaled_height = (height + ratio - 1) / ratio;
+    const int64_t scaled_width = (width + ratio - 1) / ratio;
+
+    int64_t window_y, window_y_end, window_x, window_x_end;
+    const std::vector<Interpolation> ys = ComputeInterpolation(
+        y1, y2, scaled_height, crop_height, &window_y, &window_y_end);
+    const std::vector<Interpolation> xs = ComputeInterpolation(
+        x1, x2, scaled_width, crop_width, &window_x, &window_x_end);
+    if (window_y >= window_y_end || window_x >= window_x_end) {
+      // The crop is entirely outside of the image.
+      std::fill_n(crops, crop_height * crop_width * channels_,
+                  extrapolation_value_);
+      return Status::OK();
+    }
+
+    jpeg::UncompressFlags flags = flags_;
+    flags.ratio = ratio;
+    flags.crop = true;
+    flags.crop_y = window_y;
+    flags.crop_x = window_x;
+    flags.crop_height = window_y_end - window_y;
+    flags.crop_width = window_x_end - window_x;
+    std::vector<uint8> window;
+    const uint8* decoded = jpeg::Uncompress(
+        input.data(), input.size(), flags, nullptr /* nwarn */,
+        [&window](int width, int height, int components) {
+          window.resize(static_cast<size_t>(width) * height * components);
+          return window.data();
+        });
+    if (decoded == nullptr) {
+      return errors::InvalidArgument("jpeg::Uncompress failed. Invalid JPEG "
+                                     "data.");
+    }
+    BilinearSample(ys, xs, decoded, window_y, window_x, flags.crop_width,
+                   channels_, extrapolation_value_, crops);
+    return Status::OK();
+  }
+
+  int channels_;
+  float extrapolation_value_;
+  jpeg::UncompressFlags flags_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("DecodeAndCropAndResizeJpeg")
+                            .Device(DEVICE_CPU)
+                            .HostMemory("crop_size"),
+                        DecodeAndCropAndResizeJpegOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,137 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class DecodeAndCropAndResizeJpegOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(int channels, float extrapolation_value = 0) {
+    TF_ASSERT_OK(NodeDefBuilder("op", "DecodeAndCropAndResizeJpeg")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("channels", channels)
+                     .Attr("dct_method", "INTEGER_ACCURATE")
+                     .Attr("extrapolation_value", extrapolation_value)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Encodes a `width` x `height` image whose pixels are given by `pixel_fn`.
+  template <typename PixelFn>
+  static tstring Encode(int width, int height, jpeg::Format format,
+                        PixelFn pixel_fn) {
+    const int components = format & 0xff;
+    std::vector<uint8> pixels(width * height * components);
+    for (int i = 0; i < pixels.size(); ++i) {
+      pixels[i] = pixel_fn(i / components / width, i / components % width,
+                           i % components);
+    }
+    jpeg::CompressFlags flags;
+    flags.format = format;
+    flags.quality = 100;
+    return jpeg::Compress(pixels.data(), width, height, flags);
+  }
+};
+
+TEST_F(DecodeAndCropAndResizeJpegOpTest, FullImageAtFullScale) {
+  MakeOp(3);
+  const tstring image =
+      Encode(16, 24, jpeg::FORMAT_RGB,
+             [](int y, int x, int c) { return 10 * y + 5 * x + 40 * c; });
+  AddInputFromArray<tstring>(TensorShape({1}), {image});
+  AddInputFromArray<float>(TensorShape({1, 4}), {0, 0, 1, 1});
+  AddInputFromArray<int32>(TensorShape({2}), {24, 16});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Sampling every pixel of the image is a plain decode.
+  jpeg::UncompressFlags flags;
+  flags.components = 3;
+  flags.dct_method = JDCT_ISLOW;
+  std::vector<uint8> decoded;
+  ASSERT_NE(jpeg::Uncompress(image.data(), image.size(), flags, nullptr,
+                             [&](int width, int height, int components) {
+                               decoded.resize(width * height * components);
+                               return decoded.data();
+                             }),
+            nullptr);
+  Tensor expected(DT_FLOAT, TensorShape({1, 24, 16, 3}));
+  for (int i = 0; i < decoded.size(); ++i) {
+    expected.flat<float>()(i) = decoded[i];
+  }
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(DecodeAndCropAndResizeJpegOpTest, DownscaledCrops) {
+  MakeOp(1, -1);
+  const tstring image = Encode(256, 128, jpeg::FORMAT_GRAYSCALE,
+                               [](int y, int x, int c) { return 100; });
+  AddInputFromArray<tstring>(TensorShape({3}), {image, image, image});
+  // A crop decoded at 1/8 scale, one at 1/4 scale and one outside the image.
+  AddInputFromArray<float>(TensorShape({3, 4}),
+                           {0, 0, 1, 1, 0.25, 0.5, 0.5, 0.75, 2, 2, 3, 3});
+  AddInputFromArray<int32>(TensorShape({2}), {8, 12});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_FLOAT, TensorShape({3, 8, 12, 1}));
+  auto expected_flat = expected.flat<float>();
+  for (int i = 0; i < expected_flat.size(); ++i) {
+    expected_flat(i) = i < 2 * 8 * 12 ? 100 : -1;
+  }
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1);
+}
+
+TEST_F(DecodeAndCropAndResizeJpegOpTest, InvalidImage) {
+  MakeOp(3);
+  const tstring image = Encode(8, 8, jpeg::FORMAT_RGB,
+                               [](int y, int x, int c) { return 0; });
+  AddInputFromArray<tstring>(TensorShape({2}), {image, "not a jpeg"});
+  AddInputFromArray<float>(TensorShape({2, 4}), {0, 0, 1, 1, 0, 0, 1, 1});
+  AddInputFromArray<int32>(TensorShape({2}), {4, 4});
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_TRUE(absl::StartsWith(status.error_message(), "Image 1: "))
+      << status;
+}
+
+TEST_F(DecodeAndCropAndResizeJpegOpTest, InvalidCropSize) {
+  MakeOp(3);
+  AddInputFromArray<tstring>(TensorShape({1}), {""});
+  AddInputFromArray<float>(TensorShape({1, 4}), {0, 0, 1, 1});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 4});
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_TRUE(absl::StrContains(status.error_message(),
+                                "crop dimensions must be positive"))
+      << status;
+}
+
+}  // namespace
+}  // namespace tensorflow
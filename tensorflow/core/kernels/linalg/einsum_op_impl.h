@@ -21,8 +21,14 @@ limitations under the License.
 #define EIGEN_USE_GPU
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#include <memory>
+#include <vector>
+
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
+#include "absl/types/span.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/kernel_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -39,6 +45,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/math/math_util.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/util/einsum_op_util.h"
@@ -182,6 +189,27 @@ struct EinsumHelper {
     return Status::OK();
   }
 
+  // An equation with one or two operands, in the form produced by
+  // ParseEquation.
+  struct ParsedEquation {
+    OperandLabels input_labels;
+    Labels output_labels;
+    std::vector<DimensionType> label_types;
+    OperandLabelCounts input_label_counts;
+    LabelCounts output_label_counts;
+    gtl::InlinedVector<bool, 2> input_has_ellipsis;
+    bool output_has_ellipsis = false;
+  };
+
+  static Status ParseEquation(const string& equation, ParsedEquation* parsed) {
+    return ParseEquation(equation, &parsed->input_labels,
+                         &parsed->output_labels, &parsed->label_types,
+                         &parsed->input_label_counts,
+                         &parsed->output_label_counts,
+                         &parsed->input_has_ellipsis,
+                         &parsed->output_has_ellipsis);
+  }
+
   // Insert new (unnamed) broadcasting labels at the location of ellipsis.
   static void InsertBroadcastLabels(int num_bcast_dims, int num_named_labels,
                                     int ellipsis_axis, Labels* labels,
@@ -218,7 +246,7 @@ struct EinsumHelper {
   // Validate input dimensions and populate unnamed labels and their label
   // counts.
   static Status ProcessDimensions(
-      const OpInputList& inputs,
+      absl::Span<const Tensor> inputs,
       const gtl::InlinedVector<bool, 2>& input_has_ellipsis,
       const bool output_has_ellipsis, OperandLabels* input_labels,
       Labels* output_labels, std::vector<DimensionType>* label_types,
@@ -586,36 +614,22 @@ struct EinsumHelper {
                                          bcast, &output_reshaped);
     return Status::OK();
   }
-};
-
-template <typename Device, typename T>
-class EinsumOp : public OpKernel {
- public:
-  explicit EinsumOp(OpKernelConstruction* c) : OpKernel(c) {
-    OP_REQUIRES_OK(c, c->GetAttr("equation", &equation_));
-    OP_REQUIRES_OK(
-        c, EinsumHelper::ParseEquation(
-               equation_, &input_labels_, &output_labels_, &label_types_,
-               &input_label_counts_, &output_label_counts_,
-               &input_has_ellipsis_, &output_has_ellipsis_));
-  }
-
-  void Compute(OpKernelContext* ctx) override {
-    OpInputList inputs;
-    OP_REQUIRES_OK(ctx, ctx->input_list("inputs", &inputs));
 
-    OperandLabels input_labels(input_labels_);
-    Labels output_labels(output_labels_);
-    std::vector<EinsumHelper::DimensionType> label_types(label_types_);
-    OperandLabelCounts input_label_counts(input_label_counts_);
-    LabelCounts output_label_counts(output_label_counts_);
+  // Evaluates the parsed equation of one or two operands on the inputs.
+  template <typename Device, typename T>
+  static Status Evaluate(OpKernelContext* ctx, const ParsedEquation& equation,
+                         absl::Span<const Tensor> inputs, Tensor* output) {
+    OperandLabels input_labels(equation.input_labels);
+    Labels output_labels(equation.output_labels);
+    std::vector<DimensionType> label_types(equation.label_types);
+    OperandLabelCounts input_label_counts(equation.input_label_counts);
+    LabelCounts output_label_counts(equation.output_label_counts);
     LabelToDimSizes label_to_dim_sizes;
 
-    OP_REQUIRES_OK(ctx, EinsumHelper::ProcessDimensions(
-                            inputs, input_has_ellipsis_, output_has_ellipsis_,
-                            &input_labels, &output_labels, &label_types,
-                            &input_label_counts, &output_label_counts,
-                            &label_to_dim_sizes));
+    TF_RETURN_IF_ERROR(ProcessDimensions(
+        inputs, equation.input_has_ellipsis, equation.output_has_ellipsis,
+        &input_labels, &output_labels, &label_types, &input_label_counts,
+        &output_label_counts, &label_to_dim_sizes));
 
     // The reduction phase (a) sums across reduction dimensions, (b) takes
     // generalized diagonals, and (c) reshapes it into shape
@@ -627,20 +641,18 @@ class EinsumOp : public OpKernel {
     gtl::InlinedVector<Tensor, 2> inputs_reduced(num_inputs);
     gtl::InlinedVector<bool, 2> swap_free_and_contract(num_inputs);
     for (int i = 0; i < num_inputs; ++i) {
-      OP_REQUIRES_OK(ctx,
-                     EinsumHelper::ReduceOperand<Device, T>(
-                         ctx, inputs[i], label_types, input_label_counts[i],
-                         &input_labels[i], &free_labels[i],
-                         &swap_free_and_contract[i], &inputs_reduced[i]));
+      TF_RETURN_IF_ERROR(ReduceOperand<Device, T>(
+          ctx, inputs[i], label_types, input_label_counts[i], &input_labels[i],
+          &free_labels[i], &swap_free_and_contract[i], &inputs_reduced[i]));
     }
 
     // After reduction, the inputs should be reshaped to Tensors suitable for
     // contraction. If num_inputs is 1, the reduced input is simply forwarded to
     // the output.
     Tensor contraction_output_reshaped;
-    OP_REQUIRES_OK(ctx, EinsumHelper::ContractOperands<Device, T>(
-                            ctx, inputs_reduced, swap_free_and_contract,
-                            &contraction_output_reshaped));
+    TF_RETURN_IF_ERROR(ContractOperands<Device, T>(
+        ctx, inputs_reduced, swap_free_and_contract,
+        &contraction_output_reshaped));
 
     // Copy the batch labels from the contraction output. Recover the batch
     // shape, which may have been broadcasted.
@@ -652,12 +664,10 @@ class EinsumOp : public OpKernel {
     // All batch dimensions should be present in the contracted result. First
     // the broadcasting dimensions, then the named batch dimensions.
     for (int label = 0; label < num_labels; ++label) {
-      if (label_types[label] == EinsumHelper::kBroadcasting)
-        result_labels.push_back(label);
+      if (label_types[label] == kBroadcasting) result_labels.push_back(label);
     }
     for (int label = 0; label < num_labels; ++label) {
-      if (label_types[label] == EinsumHelper::kBatch)
-        result_labels.push_back(label);
+      if (label_types[label] == kBatch) result_labels.push_back(label);
     }
     for (int i = 0; i < num_inputs; ++i) {
       for (int label : free_labels[i]) {
@@ -669,19 +679,17 @@ class EinsumOp : public OpKernel {
     // Reshape the contraction (or reduction) result to its expanded shape:
     // [(broadcasted) batch shape] + [free shape 0] + [free shape 1].
     Tensor contraction_output;
-    OP_REQUIRES_OK(
-        ctx, EinsumHelper::CopyFrom(contraction_output_reshaped, result_shape,
-                                    &contraction_output));
+    TF_RETURN_IF_ERROR(CopyFrom(contraction_output_reshaped, result_shape,
+                                &contraction_output));
 
     // Inflate the output if necessary. (E.g. for the equation 'i->iii' which
     // may arise while computing gradient of a regular Einsum).
     // TODO(anudhyan): It's possible that Eigen's contract and inflate can be
     // chained here to avoid materializing an intermediate.
     Tensor output_inflated;
-    OP_REQUIRES_OK(
-        ctx, EinsumHelper::StrideOrInflate<Device, T>(
-                 ctx, contraction_output, result_labels, output_label_counts,
-                 true /* should_inflate */, &output_inflated));
+    TF_RETURN_IF_ERROR(StrideOrInflate<Device, T>(
+        ctx, contraction_output, result_labels, output_label_counts,
+        true /* should_inflate */, &output_inflated));
     if (output_inflated.dims() > contraction_output.dims()) {
       // We inflated the output. Modify result labels accordingly.
       Labels inflated_labels;
@@ -710,10 +718,53 @@ class EinsumOp : public OpKernel {
       // We have found the leftmost occurrence. The next one would be adjacent.
       label_to_position[output_labels[i]] += 1;
     }
-    Tensor output;
-    OP_REQUIRES_OK(ctx, EinsumHelper::TransposeOperand<Device, T>(
-                            ctx, output_inflated, output_permutation, &output));
-    ctx->set_output(0, output);
+    return TransposeOperand<Device, T>(ctx, output_inflated,
+                                       output_permutation, output);
+  }
+};
+
+template <typename Device, typename T>
+class EinsumOp : public OpKernel {
+ public:
+  explicit EinsumOp(OpKernelConstruction* c) : OpKernel(c) {
+    OP_REQUIRES_OK(c, c->GetAttr("equation", &equation_));
+    OP_REQUIRES_OK(c, ParseEinsumEquation(equation_, &input_subscripts_,
+                                          &output_subscript_));
+    // Equations of more than two operands are parsed per contraction.
+    if (input_subscripts_.size() <= 2) {
+      OP_REQUIRES_OK(c, EinsumHelper::ParseEquation(equation_, &parsed_));
+    }
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    OpInputList inputs;
+    OP_REQUIRES_OK(ctx, ctx->input_list("inputs", &inputs));
+    gtl::InlinedVector<Tensor, 2> operands(inputs.begin(), inputs.end());
+    OP_REQUIRES(ctx, operands.size() == input_subscripts_.size(),
+                errors::InvalidArgument("Expected ", input_subscripts_.size(),
+                                        " inputs but got: ", operands.size()));
+    if (operands.size() <= 2) {
+      Tensor output;
+      OP_REQUIRES_OK(ctx, EinsumHelper::Evaluate<Device, T>(ctx, parsed_,
+                                                            operands, &output));
+      ctx->set_output(0, output);
+      return;
+    }
+
+    // Contracts the operands pairwise, in the planned order.
+    std::shared_ptr<const ContractionPath> path;
+    OP_REQUIRES_OK(ctx, GetContractionPath(operands, &path));
+    for (const Contraction& contraction : *path) {
+      const Tensor pair[] = {operands[contraction.lhs],
+                             operands[contraction.rhs]};
+      Tensor result;
+      OP_REQUIRES_OK(ctx, EinsumHelper::Evaluate<Device, T>(
+                              ctx, contraction.equation, pair, &result));
+      operands.erase(operands.begin() + contraction.rhs);
+      operands.erase(operands.begin() + contraction.lhs);
+      operands.push_back(std::move(result));
+    }
+    ctx->set_output(0, operands[0]);
   }
 
   string TraceString(const OpKernelContext& ctx, bool verbose) const override {
@@ -730,14 +781,68 @@ class EinsumOp : public OpKernel {
   }
 
  private:
+  // A step of the contraction path of an equation with more than two
+  // operands, as planned by PlanEinsumContractions.
+  struct Contraction {
+    int lhs;
+    int rhs;
+    EinsumHelper::ParsedEquation equation;
+  };
+  using ContractionPath = std::vector<Contraction>;
+
+  // Past this many input shapes, the planned paths are all dropped.
+  static constexpr int kMaxCachedPaths = 64;
+
+  // Returns the contraction path for the shapes of the operands, planning it
+  // if they weren't seen before.
+  Status GetContractionPath(absl::Span<const Tensor> operands,
+                            std::shared_ptr<const ContractionPath>* path) {
+    std::vector<int64_t> key;
+    std::vector<gtl::InlinedVector<int64_t, 4>> shapes;
+    for (const Tensor& operand : operands) {
+      shapes.push_back(operand.shape().dim_sizes());
+      key.push_back(operand.dims());
+      key.insert(key.end(), shapes.back().begin(), shapes.back().end());
+    }
+    {
+      mutex_lock l(mu_);
+      auto it = paths_.find(key);
+      if (it != paths_.end()) {
+        *path = it->second;
+        return Status::OK();
+      }
+    }
+    std::vector<EinsumContraction> contractions;
+    TF_RETURN_IF_ERROR(PlanEinsumContractions(
+        input_subscripts_, output_subscript_, shapes, &contractions));
+    auto new_path = std::make_shared<ContractionPath>(contractions.size());
+    for (int i = 0; i < contractions.size(); ++i) {
+      (*new_path)[i].lhs = contractions[i].lhs;
+      (*new_path)[i].rhs = contractions[i].rhs;
+      TF_RETURN_IF_ERROR(EinsumHelper::ParseEquation(
+          contractions[i].equation, &(*new_path)[i].equation));
+    }
+    VLOG(2) << "Contraction path of einsum " << equation_ << ": "
+            << absl::StrJoin(contractions, "; ",
+                             [](string* out, const EinsumContraction& c) {
+                               absl::StrAppend(out, c.equation);
+                             });
+    mutex_lock l(mu_);
+    if (paths_.size() >= kMaxCachedPaths) paths_.clear();
+    paths_[key] = new_path;
+    *path = std::move(new_path);
+    return Status::OK();
+  }
+
   string equation_;
-  OperandLabels input_labels_;
-  Labels output_labels_;
-  std::vector<EinsumHelper::DimensionType> label_types_;
-  OperandLabelCounts input_label_counts_;
-  LabelCounts output_label_counts_;
-  gtl::InlinedVector<bool, 2> input_has_ellipsis_;
-  bool output_has_ellipsis_ = false;
+  gtl::InlinedVector<string, 2> input_subscripts_;
+  string output_subscript_;
+  EinsumHelper::ParsedEquation parsed_;
+
+  mutex mu_;
+  absl::flat_hash_map<std::vector<int64_t>,
+                      std::shared_ptr<const ContractionPath>>
+      paths_ TF_GUARDED_BY(mu_);
 };
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
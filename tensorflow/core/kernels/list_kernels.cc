@@ -21,10 +21,12 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/list_kernels.h"
 
+#include <algorithm>
 #include <limits>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor_types.h"
@@ -115,7 +117,13 @@ Status ForwardInputOrCreateNewList(OpKernelContext* c, int32_t input_index,
   }
 
   // If forwarding is not possible allocate a new output tensor and copy
-  // the `input_list` to it.
+  // the `input_list` to it. In a loop this makes every step linear in the
+  // length of the list, so the copies are counted and logged per op.
+  metrics::RecordTensorListCopy(c->op_kernel().type_string(),
+                                input_list.tensors().size());
+  VLOG(2) << c->op_kernel().name() << " copies a TensorList of "
+          << input_list.tensors().size()
+          << " elements because its input is not uniquely owned.";
   AllocatorAttributes attr;
   attr.set_on_host(true);
   TF_RETURN_IF_ERROR(
@@ -385,6 +393,9 @@ class TensorListResize : public OpKernel {
     }
 
     // We were not able to forward the input.  Will have to resize from scratch.
+    metrics::RecordTensorListCopy(
+        type_string(),
+        std::min<int64_t>(size, input_list->tensors().size()));
     Tensor* result;
     AllocatorAttributes attr;
     attr.set_on_host(true);
@@ -575,6 +586,7 @@ class TensorListConcatLists : public OpKernel {
         std::copy(l_b->tensors().begin(), l_b->tensors().end(),
                   std::back_inserter(out->tensors()));
       } else {
+        metrics::RecordTensorListCopy(type_string(), l_a->tensors().size());
         TensorList out = l_a->Copy();
         std::copy(l_b->tensors().begin(), l_b->tensors().end(),
                   std::back_inserter(out.tensors()));
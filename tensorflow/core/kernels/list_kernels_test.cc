@@ -0,0 +1,113 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/tensor_list.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kSetItem[] = "TensorListSetItem";
+
+class TensorListSetItemTest : public OpsTestBase {
+ protected:
+  void MakeOp() {
+    TF_ASSERT_OK(NodeDefBuilder("set_item", kSetItem)
+                     .Input(FakeInput(DT_VARIANT))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("element_dtype", DT_FLOAT)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Returns a list of `num_elements` scalars 0, 1, ...
+  static TensorList MakeList(int num_elements) {
+    TensorList list;
+    list.element_dtype = DT_FLOAT;
+    list.element_shape = PartialTensorShape({});
+    for (int i = 0; i < num_elements; ++i) {
+      list.tensors().push_back(test::AsScalar<float>(i));
+    }
+    return list;
+  }
+
+  // Sets element 1 of `list` to 42.
+  void AddInputs(TensorList list) {
+    AddInput(DT_VARIANT, TensorShape({}))->scalar<Variant>()() =
+        std::move(list);
+    AddInputFromArray<int32>(TensorShape({}), {1});
+    AddInputFromArray<float>(TensorShape({}), {42});
+  }
+
+  const TensorList& OutputList() {
+    return *GetOutput(0)->scalar<Variant>()().get<TensorList>();
+  }
+};
+
+TEST_F(TensorListSetItemTest, ForwardsUniquelyOwnedList) {
+  MakeOp();
+  const int64_t copies =
+      metrics::GetTensorListCopiesCounter(kSetItem)->value();
+  const int64_t copied_elements =
+      metrics::GetTensorListCopiedElementsCounter(kSetItem)->value();
+
+  AddInputs(MakeList(3));
+  TF_ASSERT_OK(RunOpKernel());
+
+  const TensorList& output = OutputList();
+  ASSERT_EQ(output.tensors().size(), 3);
+  test::ExpectTensorEqual<float>(output.tensors()[1],
+                                 test::AsScalar<float>(42));
+  EXPECT_EQ(metrics::GetTensorListCopiesCounter(kSetItem)->value(), copies);
+  EXPECT_EQ(metrics::GetTensorListCopiedElementsCounter(kSetItem)->value(),
+            copied_elements);
+}
+
+TEST_F(TensorListSetItemTest, CopiesSharedList) {
+  MakeOp();
+  const int64_t copies =
+      metrics::GetTensorListCopiesCounter(kSetItem)->value();
+  const int64_t copied_elements =
+      metrics::GetTensorListCopiedElementsCounter(kSetItem)->value();
+
+  // `shared` shares the elements of the input list, which therefore can not
+  // be updated in place.
+  TensorList shared = MakeList(3);
+  AddInputs(shared);
+  TF_ASSERT_OK(RunOpKernel());
+
+  const TensorList& output = OutputList();
+  ASSERT_EQ(output.tensors().size(), 3);
+  test::ExpectTensorEqual<float>(output.tensors()[1],
+                                 test::AsScalar<float>(42));
+  test::ExpectTensorEqual<float>(shared.tensors()[1],
+                                 test::AsScalar<float>(1));
+  EXPECT_EQ(metrics::GetTensorListCopiesCounter(kSetItem)->value(),
+            copies + 1);
+  EXPECT_EQ(metrics::GetTensorListCopiedElementsCounter(kSetItem)->value(),
+            copied_elements + 3);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -19,14 +19,26 @@ limitations under the License.
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/kernels/sharded_hash_map.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/raw_coding.h"
+
+#if defined(__SSE2__) ||   \
+    (defined(_MSC_VER) &&  \
+     (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)))
+#define TF_LOOKUP_TABLE_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
 
 namespace tensorflow {
 namespace lookup {
@@ -36,11 +48,13 @@ std::string UniqueNodeName(const std::string& base) {
   return strings::StrCat(base, "/", counter.fetch_add(1), "/", random::New64());
 }
 
-// Lookup table that wraps an unordered_map, where the key and value data type
+// Lookup table that wraps a ShardedHashMap, where the key and value data type
 // is specified. Each individual value must be a scalar. If vector values are
 // required, use MutableHashTableOfTensors.
 //
 // This table is mutable and thread safe - Insert can be called at any time.
+// The table is split into shards with their own lock, so that concurrent
+// lookups and inserts of different keys rarely contend.
 //
 // Sample use case:
 //
@@ -55,10 +69,7 @@ class MutableHashTableOfScalars final : public LookupInterface {
  public:
   MutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {}
 
-  size_t size() const override {
-    tf_shared_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -70,18 +81,20 @@ class MutableHashTableOfScalars final : public LookupInterface {
     int64_t default_total = default_flat.size();
     bool is_full_size_default = (total == default_total);
 
-    tf_shared_lock l(mu_);
-    for (int64_t i = 0; i < key_values.size(); ++i) {
-      // is_full_size_default is true:
-      //   Each key has an independent default value, key_values(i)
-      //   corresponding uses default_flat(i) as its default value.
-      //
-      // is_full_size_default is false:
-      //   All keys will share the default_flat(0) as default value.
-      value_values(i) = gtl::FindWithDefault(
-          table_, SubtleMustCopyIfIntegral(key_values(i)),
-          is_full_size_default ? default_flat(i) : default_flat(0));
-    }
+    table_.FindBatch(
+        key_values.size(),
+        [&](int64_t i) { return SubtleMustCopyIfIntegral(key_values(i)); },
+        [&](int64_t i, const V& v) { value_values(i) = v; },
+        [&](int64_t i) {
+          // is_full_size_default is true:
+          //   Each key has an independent default value, key_values(i)
+          //   corresponding uses default_flat(i) as its default value.
+          //
+          // is_full_size_default is false:
+          //   All keys will share the default_flat(0) as default value.
+          value_values(i) =
+              is_full_size_default ? default_flat(i) : default_flat(0);
+        });
 
     return Status::OK();
   }
@@ -90,13 +103,16 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = keys.flat<K>();
     const auto value_values = values.flat<V>();
 
-    mutex_lock l(mu_);
+    auto key_fn = [&](int64_t i) {
+      return SubtleMustCopyIfIntegral(key_values(i));
+    };
+    auto value_fn = [&](int64_t i) {
+      return SubtleMustCopyIfIntegral(value_values(i));
+    };
     if (clear) {
-      table_.clear();
-    }
-    for (int64_t i = 0; i < key_values.size(); ++i) {
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
-                          SubtleMustCopyIfIntegral(value_values(i)));
+      table_.Assign(key_values.size(), key_fn, value_fn);
+    } else {
+      table_.InsertBatch(key_values.size(), key_fn, value_fn);
     }
     return Status::OK();
   }
@@ -109,10 +125,9 @@ class MutableHashTableOfScalars final : public LookupInterface {
   Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
     const auto key_values = keys.flat<K>();
 
-    mutex_lock l(mu_);
-    for (int64_t i = 0; i < key_values.size(); ++i) {
-      table_.erase(SubtleMustCopyIfIntegral(key_values(i)));
-    }
+    table_.RemoveBatch(key_values.size(), [&](int64_t i) {
+      return SubtleMustCopyIfIntegral(key_values(i));
+    });
     return Status::OK();
   }
 
@@ -122,17 +137,12 @@ class MutableHashTableOfScalars final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    tf_shared_lock l(mu_);
-    int64_t size = table_.size();
-
-    Tensor* keys;
-    Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("values", TensorShape({size}), &values));
-    ExportKeysAndValues(keys, values);
-    return Status::OK();
+    return ExportKeysAndValues(
+        [ctx](int64_t size, Tensor** keys, Tensor** values) -> Status {
+          TF_RETURN_IF_ERROR(
+              ctx->allocate_output("keys", TensorShape({size}), keys));
+          return ctx->allocate_output("values", TensorShape({size}), values);
+        });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -144,25 +154,20 @@ class MutableHashTableOfScalars final : public LookupInterface {
   TensorShape value_shape() const override { return TensorShape(); }
 
   int64_t MemoryUsed() const override {
-    int64_t ret = 0;
-    tf_shared_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
-    return sizeof(MutableHashTableOfScalars) + ret;
+    return sizeof(MutableHashTableOfScalars) + table_.bucket_count();
   }
 
   Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override {
-    tf_shared_lock l(mu_);
-    int64_t size = table_.size();
-    Tensor keys(key_dtype(), TensorShape({size}));
-    Tensor values(value_dtype(), TensorShape({size}));
-    ExportKeysAndValues(&keys, &values);
+    Tensor keys;
+    Tensor values;
+    TF_RETURN_IF_ERROR(ExportKeysAndValues(
+        [&](int64_t size, Tensor** keys_out, Tensor** values_out) {
+          keys = Tensor(key_dtype(), TensorShape({size}));
+          values = Tensor(value_dtype(), TensorShape({size}));
+          *keys_out = &keys;
+          *values_out = &values;
+          return Status::OK();
+        }));
 
     // We set use_node_name_sharing with a unique node name so that the resource
     // can outlive the MutableHashTableV2 kernel. This means that the lifetime
@@ -195,24 +200,32 @@ class MutableHashTableOfScalars final : public LookupInterface {
   }
 
  private:
-  // Writes all keys and values into `keys` and `values`. `keys` and `values`
-  // must point to tensors of size `table_.size()`.
-  void ExportKeysAndValues(Tensor* keys, Tensor* values) const
-      TF_SHARED_LOCKS_REQUIRED(mu_) {
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->flat<V>();
-    int64_t i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      keys_data(i) = it->first;
-      values_data(i) = it->second;
-    }
+  // Creates the `keys` and `values` tensors for a snapshot of the table with
+  // `allocate(size, &keys, &values)`, and writes all keys and values into
+  // them.
+  template <typename AllocateFn>
+  Status ExportKeysAndValues(AllocateFn allocate) const {
+    K* keys_data = nullptr;
+    V* values_data = nullptr;
+    return table_.Export(
+        [&](int64_t size) -> Status {
+          Tensor* keys;
+          Tensor* values;
+          TF_RETURN_IF_ERROR(allocate(size, &keys, &values));
+          keys_data = keys->flat<K>().data();
+          values_data = values->flat<V>().data();
+          return Status::OK();
+        },
+        [&](int64_t i, const K& key, const V& value) {
+          keys_data[i] = key;
+          values_data[i] = value;
+        });
   }
 
-  mutable mutex mu_;
-  std::unordered_map<K, V> table_ TF_GUARDED_BY(mu_);
+  ShardedHashMap<K, V> table_;
 };
 
-// Lookup table that wraps an unordered_map. Behaves identical to
+// Lookup table that wraps a ShardedHashMap. Behaves identical to
 // MutableHashTableOfScalars except that each value must be a vector.
 template <class K, class V>
 class MutableHashTableOfTensors final : public LookupInterface {
@@ -226,10 +239,7 @@ class MutableHashTableOfTensors final : public LookupInterface {
                                 value_shape_.DebugString()));
   }
 
-  size_t size() const override {
-    tf_shared_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -242,27 +252,26 @@ class MutableHashTableOfTensors final : public LookupInterface {
     int64_t default_total = default_flat.size();
     bool is_full_size_default = (total == default_total);
 
-    tf_shared_lock l(mu_);
-    for (int64_t i = 0; i < key_values.size(); ++i) {
-      ValueArray* value_vec =
-          gtl::FindOrNull(table_, SubtleMustCopyIfIntegral(key_values(i)));
-      if (value_vec != nullptr) {
-        for (int64_t j = 0; j < value_dim; j++) {
-          value_values(i, j) = value_vec->at(j);
-        }
-      } else {
-        // is_full_size_default is true:
-        //   Each key has an independent default value, key_values(i)
-        //   corresponding uses default_flat(i) as its default value.
-        //
-        // is_full_size_default is false:
-        //   All keys will share the default_flat(0) as default value.
-        for (int64_t j = 0; j < value_dim; j++) {
-          value_values(i, j) =
-              is_full_size_default ? default_flat(i, j) : default_flat(0, j);
-        }
-      }
-    }
+    table_.FindBatch(
+        key_values.size(),
+        [&](int64_t i) { return SubtleMustCopyIfIntegral(key_values(i)); },
+        [&](int64_t i, const ValueArray& value_vec) {
+          for (int64_t j = 0; j < value_dim; j++) {
+            value_values(i, j) = value_vec.at(j);
+          }
+        },
+        [&](int64_t i) {
+          // is_full_size_default is true:
+          //   Each key has an independent default value, key_values(i)
+          //   corresponding uses default_flat(i) as its default value.
+          //
+          // is_full_size_default is false:
+          //   All keys will share the default_flat(0) as default value.
+          for (int64_t j = 0; j < value_dim; j++) {
+            value_values(i, j) =
+                is_full_size_default ? default_flat(i, j) : default_flat(0, j);
+          }
+        });
 
     return Status::OK();
   }
@@ -272,18 +281,21 @@ class MutableHashTableOfTensors final : public LookupInterface {
     const auto value_values = values.flat_inner_dims<V, 2>();
     int64_t value_dim = value_shape_.dim_size(0);
 
-    mutex_lock l(mu_);
-    if (clear) {
-      table_.clear();
-    }
-    for (int64_t i = 0; i < key_values.size(); ++i) {
+    auto key_fn = [&](int64_t i) {
+      return SubtleMustCopyIfIntegral(key_values(i));
+    };
+    auto value_fn = [&](int64_t i) {
       ValueArray value_vec;
       for (int64_t j = 0; j < value_dim; j++) {
         V value = value_values(i, j);
         value_vec.push_back(value);
       }
-      gtl::InsertOrUpdate(&table_, SubtleMustCopyIfIntegral(key_values(i)),
-                          value_vec);
+      return value_vec;
+    };
+    if (clear) {
+      table_.Assign(key_values.size(), key_fn, value_fn);
+    } else {
+      table_.InsertBatch(key_values.size(), key_fn, value_fn);
     }
     return Status::OK();
   }
@@ -296,10 +308,9 @@ class MutableHashTableOfTensors final : public LookupInterface {
   Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
     const auto key_values = keys.flat<K>();
 
-    mutex_lock l(mu_);
-    for (int64_t i = 0; i < key_values.size(); ++i) {
-      table_.erase(SubtleMustCopyIfIntegral(key_values(i)));
-    }
+    table_.RemoveBatch(key_values.size(), [&](int64_t i) {
+      return SubtleMustCopyIfIntegral(key_values(i));
+    });
     return Status::OK();
   }
 
@@ -309,18 +320,15 @@ class MutableHashTableOfTensors final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    tf_shared_lock l(mu_);
-    int64_t size = table_.size();
     int64_t value_dim = value_shape_.dim_size(0);
-
-    Tensor* keys;
-    Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(ctx->allocate_output(
-        "values", TensorShape({size, value_dim}), &values));
-    ExportKeysAndValues(keys, values);
-    return Status::OK();
+    return ExportKeysAndValues(
+        [ctx, value_dim](int64_t size, Tensor** keys,
+                         Tensor** values) -> Status {
+          TF_RETURN_IF_ERROR(
+              ctx->allocate_output("keys", TensorShape({size}), keys));
+          return ctx->allocate_output(
+              "values", TensorShape({size, value_dim}), values);
+        });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -332,25 +340,22 @@ class MutableHashTableOfTensors final : public LookupInterface {
   TensorShape value_shape() const override { return value_shape_; }
 
   int64_t MemoryUsed() const override {
-    int64_t ret = 0;
-    tf_shared_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
-    return sizeof(MutableHashTableOfTensors) + ret;
+    return sizeof(MutableHashTableOfTensors) + table_.bucket_count();
   }
 
   Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override {
-    tf_shared_lock l(mu_);
-    int64_t size = table_.size();
-    Tensor keys(key_dtype(), TensorShape({size}));
-    Tensor values(value_dtype(), TensorShape({size, value_shape_.dim_size(0)}));
-    ExportKeysAndValues(&keys, &values);
+    Tensor keys;
+    Tensor values;
+    TF_RETURN_IF_ERROR(ExportKeysAndValues(
+        [&](int64_t size, Tensor** keys_out, Tensor** values_out) {
+          keys = Tensor(key_dtype(), TensorShape({size}));
+          values = Tensor(value_dtype(),
+                          TensorShape({size, value_shape_.dim_size(0)}));
+          *keys_out = &keys;
+          *values_out = &values;
+          return Status::OK();
+        }));
+
 
     // We set use_node_name_sharing with a unique node name so that the resource
     // can outlive the MutableHashTableOfTensorsV2 kernel. This means that the
@@ -384,28 +389,34 @@ class MutableHashTableOfTensors final : public LookupInterface {
   }
 
  private:
-  // Writes all keys and values into `keys` and `values`. `keys` and `values`
-  // must point to tensors of size `table_.size()`.
-  void ExportKeysAndValues(Tensor* keys, Tensor* values) const
-      TF_SHARED_LOCKS_REQUIRED(mu_) {
+  // Creates the `keys` and `values` tensors for a snapshot of the table with
+  // `allocate(size, &keys, &values)`, and writes all keys and values into
+  // them.
+  template <typename AllocateFn>
+  Status ExportKeysAndValues(AllocateFn allocate) const {
     int64_t value_dim = value_shape_.dim_size(0);
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->matrix<V>();
-    int64_t i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      K key = it->first;
-      ValueArray value = it->second;
-      keys_data(i) = key;
-      for (int64_t j = 0; j < value_dim; j++) {
-        values_data(i, j) = value[j];
-      }
-    }
+    K* keys_data = nullptr;
+    V* values_data = nullptr;
+    return table_.Export(
+        [&](int64_t size) -> Status {
+          Tensor* keys;
+          Tensor* values;
+          TF_RETURN_IF_ERROR(allocate(size, &keys, &values));
+          keys_data = keys->flat<K>().data();
+          values_data = values->flat<V>().data();
+          return Status::OK();
+        },
+        [&](int64_t i, const K& key, const ValueArray& value) {
+          keys_data[i] = key;
+          for (int64_t j = 0; j < value_dim; j++) {
+            values_data[i * value_dim + j] = value[j];
+          }
+        });
   }
 
   TensorShape value_shape_;
-  mutable mutex mu_;
   typedef gtl::InlinedVector<V, 4> ValueArray;
-  std::unordered_map<K, ValueArray> table_ TF_GUARDED_BY(mu_);
+  ShardedHashMap<K, ValueArray> table_;
 };
 
 namespace {
@@ -417,6 +428,81 @@ inline uint64 HashScalar(const T& key) {
 
 inline uint64 HashScalar(const tstring& key) { return Hash64(key); }
 
+// Control bytes of the buckets of a MutableDenseHashTable: kEmptyBucket,
+// kDeletedBucket, or 7 bits of the hash of the key in the bucket.
+constexpr uint8 kEmptyBucket = 0x80;
+constexpr uint8 kDeletedBucket = 0xFE;
+
+#ifdef TF_LOOKUP_TABLE_HAVE_SSE2
+
+// A group of consecutive control bytes, matched against a byte at once with
+// SSE2. Bit i of the returned masks corresponds to byte i of the group.
+class ControlGroup {
+ public:
+  static constexpr int kWidth = 16;
+
+  explicit ControlGroup(const uint8* ctrl)
+      : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+  uint64 Match(uint8 h2) const {
+    return static_cast<uint32>(_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(h2)), ctrl_)));
+  }
+
+  uint64 MatchEmpty() const { return Match(kEmptyBucket); }
+
+  // Empty and deleted buckets are the ones with the high bit set.
+  uint64 MatchEmptyOrDeleted() const {
+    return static_cast<uint32>(_mm_movemask_epi8(ctrl_));
+  }
+
+  // The bit of the masks for byte `index` of the group.
+  static uint64 Bit(int index) { return uint64{1} << index; }
+
+  // Index in the group of the lowest bit set in `mask`.
+  static int LowestIndex(uint64 mask) { return Log2Floor64(mask & -mask); }
+
+ private:
+  __m128i ctrl_;
+};
+
+#else
+
+// A group of consecutive control bytes, matched against a byte at once with
+// 64-bit integer arithmetic. The high bit of byte i of the returned masks
+// corresponds to byte i of the group. Match() may return false positives
+// next to a true positive, which are weeded out by comparing the keys.
+class ControlGroup {
+ public:
+  static constexpr int kWidth = 8;
+
+  explicit ControlGroup(const uint8* ctrl)
+      : ctrl_(core::DecodeFixed64(reinterpret_cast<const char*>(ctrl))) {}
+
+  uint64 Match(uint8 h2) const {
+    const uint64 x = ctrl_ ^ (kLsbs * h2);
+    return (x - kLsbs) & ~x & kMsbs;
+  }
+
+  uint64 MatchEmpty() const { return ctrl_ & (~ctrl_ << 6) & kMsbs; }
+
+  uint64 MatchEmptyOrDeleted() const { return ctrl_ & kMsbs; }
+
+  static uint64 Bit(int index) { return uint64{0x80} << (index * 8); }
+
+  static int LowestIndex(uint64 mask) {
+    return Log2Floor64(mask & -mask) >> 3;
+  }
+
+ private:
+  static constexpr uint64 kLsbs = 0x0101010101010101ULL;
+  static constexpr uint64 kMsbs = 0x8080808080808080ULL;
+
+  uint64 ctrl_;
+};
+
+#endif
+
 // If the given shape is a scalar return {1} instead. Otherwise leave it alone.
 TensorShape MaybeVectorizeShape(const TensorShape& shape) {
   if (shape.dims() == 0) {
@@ -428,6 +514,15 @@ TensorShape MaybeVectorizeShape(const TensorShape& shape) {
 }  // namespace
 
 // Modeled after densehashtable in https://github.com/sparsehash/sparsehash
+//
+// The keys and values are stored in the key_buckets_ and value_buckets_
+// tensors, which are what ExportValues() returns. Next to them, a control byte
+// per bucket tells whether the bucket is empty, deleted, or holds a key with
+// some given 7 bits of hash, in the style of SwissTable: a probe matches the
+// control bytes of the buckets it visits within ControlGroup::kWidth buckets
+// at once, and only compares the keys of the buckets whose control byte
+// matches. The buckets are visited in the quadratic probing order of earlier
+// releases, which can therefore look up the keys of exported tables.
 template <class K, class V>
 class MutableDenseHashTable final : public LookupInterface {
  public:
@@ -519,8 +614,9 @@ class MutableDenseHashTable final : public LookupInterface {
         empty_key_.template shaped<K, 2>({1, key_size});
     const auto deleted_key_matrix =
         deleted_key_.template shaped<K, 2>({1, key_size});
-    const int64_t bit_mask = num_buckets_ - 1;
-    // TODO(andreasst): parallelize using work_sharder
+    // Hash all the keys first, so that the buckets of the keys to look up
+    // next can be prefetched while probing for a key.
+    std::vector<uint64> key_hashes(num_elements);
     for (int64_t i = 0; i < num_elements; ++i) {
       const uint64 key_hash = HashKey(key_matrix, i);
       if (empty_key_hash_ == key_hash &&
@@ -533,30 +629,29 @@ class MutableDenseHashTable final : public LookupInterface {
         return errors::InvalidArgument(
             "Using the deleted_key as a table key is not allowed");
       }
-      int64_t bucket_index = key_hash & bit_mask;
-      int64_t num_probes = 0;
-      while (true) {
-        if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i)) {
-          for (int64_t j = 0; j < value_size; ++j) {
-            // TODO(andreasst): check if we can get rid of SubtleMustCopy
-            // here and elsewhere in this file.
-            value_matrix(i, j) =
-                SubtleMustCopyIfIntegral(value_buckets_matrix(bucket_index, j));
-          }
-          break;
-        }
-        if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_matrix, 0)) {
-          for (int64_t j = 0; j < value_size; ++j) {
-            value_matrix(i, j) = SubtleMustCopyIfIntegral(default_flat(j));
-          }
-          break;
+      key_hashes[i] = key_hash;
+    }
+    // TODO(andreasst): parallelize using work_sharder
+    for (int64_t i = 0; i < num_elements; ++i) {
+      if (i + kPrefetchDistance < num_elements) {
+        PrefetchBuckets(key_hashes[i + kPrefetchDistance]);
+      }
+      int64_t bucket_index;
+      if (!ProbeKey(key_buckets_matrix, key_matrix, i, key_hashes[i],
+                    &bucket_index, nullptr)) {
+        return errors::Internal(
+            "Internal error in MutableDenseHashTable lookup");
+      }
+      if (bucket_index >= 0) {
+        for (int64_t j = 0; j < value_size; ++j) {
+          // TODO(andreasst): check if we can get rid of SubtleMustCopy
+          // here and elsewhere in this file.
+          value_matrix(i, j) =
+              SubtleMustCopyIfIntegral(value_buckets_matrix(bucket_index, j));
         }
-        ++num_probes;
-        bucket_index =
-            (bucket_index + num_probes) & bit_mask;  // quadratic probing
-        if (num_probes >= num_buckets_) {
-          return errors::Internal(
-              "Internal error in MutableDenseHashTable lookup");
+      } else {
+        for (int64_t j = 0; j < value_size; ++j) {
+          value_matrix(i, j) = SubtleMustCopyIfIntegral(default_flat(j));
         }
       }
     }
@@ -605,25 +700,13 @@ class MutableDenseHashTable final : public LookupInterface {
   Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
                       const Tensor& values) override TF_LOCKS_EXCLUDED(mu_) {
     mutex_lock l(mu_);
-    num_buckets_ = keys.dim_size(0);
-    key_buckets_ = keys;
-    value_buckets_ = values;
-    // Count the number of keys that are not the empty_key or deleted_key.
-    // This requires iterating through the whole table but that is OK as we
-    // only execute it during checkpoint restore.
-    num_entries_ = 0;
-    const auto empty_key_tensor =
-        empty_key_.template shaped<K, 2>({1, key_shape_.num_elements()});
-    const auto deleted_key_tensor =
-        deleted_key_.template shaped<K, 2>({1, key_shape_.num_elements()});
-    const auto key_buckets_tensor = key_buckets_.template matrix<K>();
-    for (int64_t i = 0; i < num_buckets_; ++i) {
-      if (!IsEqualKey(key_buckets_tensor, i, empty_key_tensor, 0) &&
-          !IsEqualKey(key_buckets_tensor, i, deleted_key_tensor, 0)) {
-        ++num_entries_;
-      }
-    }
-    return Status::OK();
+    // The keys are reinserted in buckets of the same number, so that their
+    // control bytes are computed and they are laid out for the probing of
+    // this table whichever way they were laid out when exported. This
+    // requires iterating through the whole table but that is OK as we only
+    // execute it during checkpoint restore.
+    TF_RETURN_IF_ERROR(AllocateBuckets(ctx, keys.dim_size(0)));
+    return DoInsert(ctx, keys, values, true);
   }
 
   Status ExportValues(OpKernelContext* ctx) override TF_LOCKS_EXCLUDED(mu_) {
@@ -669,7 +752,8 @@ class MutableDenseHashTable final : public LookupInterface {
   int64_t MemoryUsed() const override TF_LOCKS_EXCLUDED(mu_) {
     tf_shared_lock l(mu_);
     return sizeof(MutableDenseHashTable) + key_buckets_.AllocatedBytes() +
-           value_buckets_.AllocatedBytes() + empty_key_.AllocatedBytes();
+           value_buckets_.AllocatedBytes() + empty_key_.AllocatedBytes() +
+           ctrl_.size();
   }
 
  private:
@@ -688,7 +772,6 @@ class MutableDenseHashTable final : public LookupInterface {
         empty_key_.template shaped<K, 2>({1, key_size});
     const auto deleted_key_tensor =
         deleted_key_.template shaped<K, 2>({1, key_size});
-    const int64_t bit_mask = num_buckets_ - 1;
     for (int64_t i = 0; i < num_elements; ++i) {
       const uint64 key_hash = HashKey(key_matrix, i);
       if (empty_key_hash_ == key_hash &&
@@ -707,37 +790,26 @@ class MutableDenseHashTable final : public LookupInterface {
         return errors::InvalidArgument(
             "Using the deleted_key as a table key is not allowed");
       }
-      int64_t bucket_index = key_hash & bit_mask;
-      int64_t num_probes = 0;
-      while (true) {
-        if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i)) {
-          for (int64_t j = 0; j < value_size; ++j) {
-            value_buckets_matrix(bucket_index, j) =
-                SubtleMustCopyIfIntegral(value_matrix(i, j));
-          }
-          break;
-        }
-        if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_tensor, 0) ||
-            IsEqualKey(key_buckets_matrix, bucket_index, deleted_key_tensor,
-                       0)) {
-          ++num_entries_;
-          for (int64_t j = 0; j < key_size; ++j) {
-            key_buckets_matrix(bucket_index, j) =
-                SubtleMustCopyIfIntegral(key_matrix(i, j));
-          }
-          for (int64_t j = 0; j < value_size; ++j) {
-            value_buckets_matrix(bucket_index, j) =
-                SubtleMustCopyIfIntegral(value_matrix(i, j));
-          }
-          break;
-        }
-        ++num_probes;
-        bucket_index =
-            (bucket_index + num_probes) & bit_mask;  // quadratic probing
-        if (num_probes >= num_buckets_) {
+      int64_t bucket_index;
+      int64_t insert_bucket_index;
+      ProbeKey(key_buckets_matrix, key_matrix, i, key_hash, &bucket_index,
+               &insert_bucket_index);
+      if (bucket_index < 0) {
+        if (insert_bucket_index < 0) {
           return errors::Internal(
               "Internal error in MutableDenseHashTable insert");
         }
+        bucket_index = insert_bucket_index;
+        ++num_entries_;
+        for (int64_t j = 0; j < key_size; ++j) {
+          key_buckets_matrix(bucket_index, j) =
+              SubtleMustCopyIfIntegral(key_matrix(i, j));
+        }
+        SetControlByte(bucket_index, ControlByte(key_hash));
+      }
+      for (int64_t j = 0; j < value_size; ++j) {
+        value_buckets_matrix(bucket_index, j) =
+            SubtleMustCopyIfIntegral(value_matrix(i, j));
       }
     }
     return Status::OK();
@@ -755,7 +827,6 @@ class MutableDenseHashTable final : public LookupInterface {
     const auto deleted_key_tensor =
         deleted_key_.template shaped<K, 2>({1, key_size});
     const auto deleted_key_flat = deleted_key_.template flat<K>();
-    const int64_t bit_mask = num_buckets_ - 1;
     for (int64_t i = 0; i < num_elements; ++i) {
       const uint64 key_hash = HashKey(key_matrix, i);
       if (empty_key_hash_ == key_hash &&
@@ -768,27 +839,19 @@ class MutableDenseHashTable final : public LookupInterface {
         return errors::InvalidArgument(
             "Using the deleted_key as a table key is not allowed");
       }
-      int64_t bucket_index = key_hash & bit_mask;
-      int64_t num_probes = 0;
-      while (true) {
-        if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i)) {
-          --num_entries_;
-          for (int64_t j = 0; j < key_size; ++j) {
-            key_buckets_matrix(bucket_index, j) =
-                SubtleMustCopyIfIntegral(deleted_key_flat(j));
-          }
-          break;
-        }
-        if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_tensor, 0)) {
-          break;
-        }
-        ++num_probes;
-        bucket_index =
-            (bucket_index + num_probes) & bit_mask;  // quadratic probing
-        if (num_probes >= num_buckets_) {
-          return errors::Internal(
-              "Internal error in MutableDenseHashTable remove");
+      int64_t bucket_index;
+      if (!ProbeKey(key_buckets_matrix, key_matrix, i, key_hash,
+                    &bucket_index, nullptr)) {
+        return errors::Internal(
+            "Internal error in MutableDenseHashTable remove");
+      }
+      if (bucket_index >= 0) {
+        --num_entries_;
+        for (int64_t j = 0; j < key_size; ++j) {
+          key_buckets_matrix(bucket_index, j) =
+              SubtleMustCopyIfIntegral(deleted_key_flat(j));
         }
+        SetControlByte(bucket_index, kDeletedBucket);
       }
     }
     return Status::OK();
@@ -804,6 +867,9 @@ class MutableDenseHashTable final : public LookupInterface {
     }
     num_buckets_ = new_num_buckets;
     num_entries_ = 0;
+    // The control bytes of the first buckets are repeated after the last
+    // one, so that a group starting at any bucket can be loaded at once.
+    ctrl_.assign(num_buckets_ + ControlGroup::kWidth - 1, kEmptyBucket);
 
     const int64_t key_size = key_shape_.num_elements();
     TF_RETURN_IF_ERROR(ctx->allocate_temp(
@@ -840,6 +906,95 @@ class MutableDenseHashTable final : public LookupInterface {
     return DoInsert(ctx, old_key_buckets, old_value_buckets, true);
   }
 
+  // The top 7 bits of `key_hash` once spread, as `key_hash` is the identity
+  // for integer keys.
+  static uint8 ControlByte(uint64 key_hash) {
+    return (key_hash * 0x9E3779B97F4A7C15ULL) >> 57;
+  }
+
+  int64_t FirstBucket(uint64 key_hash) const TF_SHARED_LOCKS_REQUIRED(mu_) {
+    return key_hash & (num_buckets_ - 1);
+  }
+
+  void SetControlByte(int64_t bucket_index, uint8 ctrl)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const int64_t ctrl_size = ctrl_.size();
+    for (int64_t i = bucket_index; i < ctrl_size; i += num_buckets_) {
+      ctrl_[i] = ctrl;
+    }
+  }
+
+  void PrefetchBuckets(uint64 key_hash) const TF_SHARED_LOCKS_REQUIRED(mu_) {
+    const int64_t bucket_index = FirstBucket(key_hash);
+    port::prefetch<port::PREFETCH_HINT_T0>(&ctrl_[bucket_index]);
+    port::prefetch<port::PREFETCH_HINT_T0>(
+        key_buckets_.template flat<K>().data() +
+        bucket_index * key_shape_.num_elements());
+  }
+
+  // Probes the buckets for the key at `index` in `key_matrix`, whose hash is
+  // `key_hash`. The buckets probed are FirstBucket(key_hash), then 1, 3, 6,
+  // 10... buckets further, as in earlier releases. Each group of
+  // ControlGroup::kWidth buckets starts at the next bucket to probe, and
+  // matches all the buckets it contains that are probed next at once.
+  //
+  // Sets `*bucket_index` to the bucket holding the key, or to -1 if the table
+  // does not contain it. If `insert_bucket_index` is not null, also sets it to
+  // the first empty or deleted bucket probed, or to -1 if there is none.
+  // Returns false if all the buckets were probed without finding the key or
+  // an empty bucket.
+  template <typename MT>
+  bool ProbeKey(typename TTypes<K>::Matrix key_buckets_matrix, MT key_matrix,
+                int64_t index, uint64 key_hash, int64_t* bucket_index,
+                int64_t* insert_bucket_index) const
+      TF_SHARED_LOCKS_REQUIRED(mu_) {
+    const int64_t bit_mask = num_buckets_ - 1;
+    const uint8 ctrl = ControlByte(key_hash);
+    *bucket_index = -1;
+    if (insert_bucket_index != nullptr) {
+      *insert_bucket_index = -1;
+    }
+    int64_t group_index = FirstBucket(key_hash);
+    int64_t num_probes = 0;
+    while (num_probes < num_buckets_) {
+      // The buckets of the group to probe, in increasing order, and the
+      // distance from the start of the group to the next bucket to probe.
+      uint64 probed = 0;
+      int64_t offset = 0;
+      do {
+        probed |= ControlGroup::Bit(offset);
+        ++num_probes;
+        offset += num_probes;  // quadratic probing
+      } while (offset < ControlGroup::kWidth && num_probes < num_buckets_);
+      const ControlGroup group(&ctrl_[group_index]);
+      const uint64 empty = group.MatchEmpty() & probed;
+      // The probe stops at the first empty bucket.
+      const uint64 before_empty =
+          empty == 0 ? probed : probed & ((empty & -empty) - 1);
+      for (uint64 match = group.Match(ctrl) & before_empty; match != 0;
+           match &= match - 1) {
+        const int64_t candidate =
+            (group_index + ControlGroup::LowestIndex(match)) & bit_mask;
+        if (IsEqualKey(key_buckets_matrix, candidate, key_matrix, index)) {
+          *bucket_index = candidate;
+          return true;
+        }
+      }
+      if (insert_bucket_index != nullptr && *insert_bucket_index < 0) {
+        const uint64 free = group.MatchEmptyOrDeleted() & probed;
+        if (free != 0) {
+          *insert_bucket_index =
+              (group_index + ControlGroup::LowestIndex(free)) & bit_mask;
+        }
+      }
+      if (empty != 0) {
+        return true;
+      }
+      group_index = (group_index + offset) & bit_mask;
+    }
+    return false;
+  }
+
   uint64 HashKey(typename TTypes<K>::ConstMatrix key, int64_t index) const {
     if (key_shape_.num_elements() == 1) {
       return HashScalar(key(index, 0));
@@ -864,6 +1019,10 @@ class MutableDenseHashTable final : public LookupInterface {
     return true;
   }
 
+  // Number of keys ahead of the one being looked up whose buckets Find()
+  // prefetches.
+  static constexpr int64_t kPrefetchDistance = 8;
+
   TensorShape key_shape_;
   TensorShape value_shape_;
   float max_load_factor_;
@@ -872,6 +1031,9 @@ class MutableDenseHashTable final : public LookupInterface {
   int64_t num_buckets_ TF_GUARDED_BY(mu_);
   Tensor key_buckets_ TF_GUARDED_BY(mu_);
   Tensor value_buckets_ TF_GUARDED_BY(mu_);
+  // The control byte of each bucket, followed by a copy of the first
+  // ControlGroup::kWidth - 1 ones.
+  std::vector<uint8> ctrl_ TF_GUARDED_BY(mu_);
   Tensor empty_key_;
   uint64 empty_key_hash_;
   Tensor deleted_key_;
@@ -140,6 +140,26 @@ class FusedMatMulOpTest : public OpsTestBase {
       ops::Elu(root.WithOpName("with_activation"), with_bias);
     } else if (activation_type == "LeakyRelu") {
       ops::internal::LeakyRelu(root.WithOpName("with_activation"), with_bias);
+    } else if (activation_type == "GeluApproximate") {
+      // 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+      auto cube = ops::Mul(root, with_bias, ops::Square(root, with_bias));
+      auto inner = ops::Mul(
+          root, static_cast<T>(0.7978845608028654),
+          ops::AddV2(root, with_bias,
+                     ops::Mul(root, static_cast<T>(0.044715), cube)));
+      auto half_x = ops::Mul(root, static_cast<T>(0.5), with_bias);
+      ops::Mul(root.WithOpName("with_activation"), half_x,
+               ops::AddV2(root, static_cast<T>(1), ops::Tanh(root, inner)));
+    } else if (activation_type == "GeluExact") {
+      // 0.5 * x * (1 + erf(x / sqrt(2)))
+      auto erf = ops::Erf(
+          root, ops::Mul(root, static_cast<T>(0.7071067811865476), with_bias));
+      auto half_x = ops::Mul(root, static_cast<T>(0.5), with_bias);
+      ops::Mul(root.WithOpName("with_activation"), half_x,
+               ops::AddV2(root, static_cast<T>(1), erf));
+    } else if (activation_type == "Swish") {
+      ops::Mul(root.WithOpName("with_activation"), with_bias,
+               ops::Sigmoid(root, with_bias));
     } else {
       ops::Identity(root.WithOpName("with_activation"), with_bias);
     }
@@ -294,7 +314,8 @@ TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1) {
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu",
+                                    "GeluApproximate", "GeluExact", "Swish"}) {
     this->VerifyConv2DWithBiasAndActivation(256, 256, 256, false, false,
                                             activation);
     this->VerifyConv2DWithBiasAndActivation(256, 256, 256, true, false,
@@ -307,21 +328,24 @@ TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithActivation) {
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x256WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu",
+                                    "GeluApproximate", "GeluExact", "Swish"}) {
     this->VerifyConv2DWithBiasAndActivation(1, 256, 256, false, false,
                                             activation);
   }
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x1WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu",
+                                    "GeluApproximate", "GeluExact", "Swish"}) {
     this->VerifyConv2DWithBiasAndActivation(256, 256, 1, false, false,
                                             activation);
   }
 }
 
 TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1WithActivation) {
-  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu"}) {
+  for (const string& activation : {"Relu", "Relu6", "Elu", "LeakyRelu",
+                                    "GeluApproximate", "GeluExact", "Swish"}) {
     this->VerifyConv2DWithBiasAndActivation(1, 256, 1, false, false,
                                             activation);
   }
@@ -372,6 +396,7 @@ static Graph* Matmul(int m, int k, int n, bool transpose_a, bool transpose_b,
 
 #define BM_Matmul(M, K, N, TA, TB)                                       \
   BM_MatmulDev(M, K, N, TA, TB, float, DT_FLOAT, cpu);                   \
+  BM_MatmulDev(M, K, N, TA, TB, bfloat16, DT_BFLOAT16, cpu);             \
   BM_MatmulDev(M, K, N, TA, TB, std::complex<float>, DT_COMPLEX64, cpu); \
   BM_MatmulDev(M, K, N, TA, TB, float, DT_FLOAT, gpu);                   \
   BM_MatmulDev(M, K, N, TA, TB, std::complex<float>, DT_COMPLEX64, gpu); \
@@ -383,8 +408,9 @@ static Graph* Matmul(int m, int k, int n, bool transpose_a, bool transpose_b,
 
 #else
 
-#define BM_Matmul(M, K, N, TA, TB)                     \
-  BM_MatmulDev(M, K, N, TA, TB, float, DT_FLOAT, cpu); \
+#define BM_Matmul(M, K, N, TA, TB)                           \
+  BM_MatmulDev(M, K, N, TA, TB, float, DT_FLOAT, cpu);       \
+  BM_MatmulDev(M, K, N, TA, TB, bfloat16, DT_BFLOAT16, cpu); \
   BM_MatmulDev(M, K, N, TA, TB, std::complex<float>, DT_COMPLEX64, cpu);
 
 #endif  // GOOGLE_CUDA
@@ -137,6 +137,10 @@ class MklEinsum : public OpKernel {
                           &mkl_output_labels_, &mkl_label_types_,
                           &mkl_input_label_counts_, &mkl_output_label_counts_,
                           &mkl_input_has_ellipsis_, &mkl_output_has_ellipsis_));
+    OP_REQUIRES(c, mkl_input_labels_.size() <= 2,
+                errors::Unimplemented(
+                    "oneDNN Einsum supports at most 2 operands, got equation: ",
+                    mkl_equation_));
   }
 
   virtual ~MklEinsum() {}
@@ -152,8 +156,10 @@ class MklEinsum : public OpKernel {
     LabelCounts output_label_counts(mkl_output_label_counts_);
     LabelToDimSizes label_to_dim_sizes;
 
+    const gtl::InlinedVector<Tensor, 2> input_tensors(inputs.begin(),
+                                                      inputs.end());
     OP_REQUIRES_OK(ctx, EinsumHelper::ProcessDimensions(
-                            inputs, mkl_input_has_ellipsis_,
+                            input_tensors, mkl_input_has_ellipsis_,
                             mkl_output_has_ellipsis_, &input_labels,
                             &output_labels, &label_types, &input_label_counts,
                             &output_label_counts, &label_to_dim_sizes));
@@ -1573,11 +1573,8 @@ REGISTER_MKL_FUSED_BATCHNORM_V3_CPU(float, float);
 REGISTER_MKL_FUSED_BATCHNORM_V3_CPU(bfloat16, float);
 #undef REGISTER_MKL_FUSED_BATCHNORM_V3_CPU
 
-REGISTER_KERNEL_BUILDER(Name("_FusedBatchNormEx")
-                            .Device(DEVICE_CPU)
-                            .TypeConstraint<float>("T")
-                            .TypeConstraint<float>("U"),
-                        NoOp);
+// The float kernel of _FusedBatchNormEx is the Eigen one, which runs when
+// oneDNN is disabled at runtime.
 REGISTER_KERNEL_BUILDER(Name("_FusedBatchNormEx")
                             .Device(DEVICE_CPU)
                             .TypeConstraint<bfloat16>("T")
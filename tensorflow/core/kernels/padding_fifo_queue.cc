@@ -94,18 +94,21 @@ void PaddingFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
     already_cancelled = !cm->RegisterCallback(
         token, [this, cm, token]() { Cancel(kDequeue, cm, token); });
     if (!already_cancelled) {
+      StopFastPathLocked();
       // TODO(josh11b): This makes two copies of callback, avoid this if possible.
       dequeue_attempts_.emplace_back(
           num_elements, [callback]() { callback(Tuple()); }, ctx, cm, token,
           [callback, allow_small_batch,
            this](Attempt* attempt) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-            int32_t queue_size = queues_[0].size();
+            int32_t queue_size = SizeLocked();
             if (closed_ && queue_size < attempt->elements_requested) {
               // If we don't have enough for a full dequeue, we have
               // to reset the attempt tuple.
               if (!attempt->tuples.empty()) {
                 // Restore already-dequeued elements to the front of the queue.
                 for (int64_t i = attempt->tuples.size() - 1; i >= 0; --i) {
+                  Tuple element_tuple;
+                  element_tuple.reserve(num_components());
                   for (int j = 0; j < num_components(); ++j) {
                     Tensor element;
                     Status s = GetElementComponent(attempt->tuples[i], j,
@@ -117,13 +120,14 @@ void PaddingFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
                                            "to PaddingFIFOQueue: ",
                                            s.error_message()));
                     }
-                    queues_[j].push_front(element);
+                    element_tuple.push_back(std::move(element));
                   }
+                  RestoreLocked(element_tuple);
                 }
               }
-              if (allow_small_batch && !queues_[0].empty()) {
+              if (allow_small_batch && SizeLocked() > 0) {
                 // Request all remaining elements in the queue.
-                queue_size = queues_[0].size();
+                queue_size = SizeLocked();
                 attempt->tuples.clear();
                 attempt->elements_requested = queue_size;
               } else {
@@ -227,6 +231,7 @@ void PaddingFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
   }
   if (!already_cancelled) {
     FlushUnlocked();
+    MaybeRestartFastPath();
   } else {
     ctx->SetStatus(errors::Cancelled("Dequeue operation was cancelled"));
     callback(Tuple());
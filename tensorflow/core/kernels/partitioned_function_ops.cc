@@ -40,12 +40,68 @@ limitations under the License.
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
 namespace tensorflow {
+namespace {
+
+// A call frame whose arguments are the inputs of the kernel, and whose return
+// values become the outputs of the kernel when SetOutputs() is called.
+class KernelCallFrame : public CallFrameInterface {
+ public:
+  explicit KernelCallFrame(OpKernelContext* ctx)
+      : ctx_(ctx), rets_(ctx->num_outputs()) {}
+
+  size_t num_args() const override { return ctx_->num_inputs(); }
+  size_t num_retvals() const override { return rets_.size(); }
+
+  Status GetArg(int index, const Tensor** val) override {
+    if (index < 0 || index >= ctx_->num_inputs()) {
+      return errors::InvalidArgument("GetArg ", index, " is not within [0, ",
+                                     ctx_->num_inputs(), ")");
+    }
+    *val = &ctx_->input(index);
+    return Status::OK();
+  }
+
+  Status SetRetval(int index, const Tensor& val) override {
+    if (index < 0 || static_cast<size_t>(index) >= rets_.size()) {
+      return errors::InvalidArgument("SetRetval ", index, " is not within [0, ",
+                                     rets_.size(), ")");
+    }
+    if (val.dtype() != ctx_->expected_output_dtype(index)) {
+      return errors::InvalidArgument(
+          "Expects ret[", index, "] to be ",
+          DataTypeString(ctx_->expected_output_dtype(index)), ", but ",
+          DataTypeString(val.dtype()), " is provided.");
+    }
+    rets_[index] = val;
+    return Status::OK();
+  }
+
+  // Sets the return values as the outputs of the kernel. The return values of
+  // dead tensors are left empty.
+  void SetOutputs() {
+    for (int i = 0; i < rets_.size(); ++i) {
+      ctx_->set_output(i, std::move(rets_[i]));
+    }
+  }
+
+ private:
+  OpKernelContext* const ctx_;
+  std::vector<Tensor> rets_;
+};
+
+bool IsSendOrRecv(const string& op) {
+  return op == "_Send" || op == "_Recv" || op == "_HostSend" ||
+         op == "_HostRecv";
+}
+
+}  // namespace
 
 PartitionedCallOp::PartitionedCallOp(OpKernelConstruction* ctx)
     : AsyncOpKernel(ctx),
       func_(new NameAttrList),
       config_proto_(new ConfigProto),
-      shared_rendezvous_(false) {
+      shared_rendezvous_(false),
+      has_send_or_recv_(false) {
   OP_REQUIRES_OK(
       ctx, ctx->GetAttr(FunctionLibraryDefinition::kFuncAttr, func_.get()));
   string deprecated_config_serialized;
@@ -76,7 +132,7 @@ PartitionedCallOp::PartitionedCallOp(OpKernelConstruction* ctx)
 
 PartitionedCallOp::~PartitionedCallOp() {
   for (const auto& it : handles_) {
-    Status status = it.first->ReleaseHandle(it.second);
+    Status status = it.first->ReleaseHandle(it.second.handle);
     if (!status.ok()) {
       LOG(INFO) << "Ignoring error while destructing PartitionedCallOp: "
                 << status.ToString();
@@ -100,10 +156,7 @@ void PartitionedCallOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
   // TODO(akshayka): Support re-sharding the function on subsequent calls,
   // via, e.g., virtual device annotations and a list of device names
   // supplied through an attribute.
-  //
-  // TODO(akshayka): Add a fastpath for functions that execute on a single
-  // device.
-  FunctionLibraryRuntime::Handle handle;
+  FunctionHandle handle;
   // If we are instantiating the function, we can efficiently extract the
   // inputs while instantiating. Else, we extract them separately below.
   std::vector<Tensor> inputs;
@@ -112,14 +165,22 @@ void PartitionedCallOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
     mutex_lock l(mu_);
     auto it = handles_.find(lib);
     if (it == handles_.end()) {
-      OP_REQUIRES_OK_ASYNC(ctx, Instantiate(lib, ctx, &inputs, &handle), done);
+      OP_REQUIRES_OK_ASYNC(
+          ctx, Instantiate(lib, ctx, &inputs, &handle.handle), done);
       inputs_extracted = true;
+      handle.is_single_component =
+          lib->IsSingleComponentOnDevice(handle.handle);
       handles_[lib] = handle;
     } else {
       handle = it->second;
     }
   }
 
+  if (handle.is_single_component) {
+    RunSingleComponentFunction(handle.handle, lib, ctx, std::move(done));
+    return;
+  }
+
   if (!inputs_extracted) {
     OpInputList args;
     OP_REQUIRES_OK_ASYNC(ctx, ctx->input_list("args", &args), done);
@@ -129,7 +190,7 @@ void PartitionedCallOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
     }
   }
 
-  RunFunction(handle, inputs, lib, ctx, done);
+  RunFunction(handle.handle, inputs, lib, ctx, done);
 }
 
 Status PartitionedCallOp::FillOutputDevices(
@@ -146,6 +207,12 @@ Status PartitionedCallOp::FillOutputDevices(
   if (attr != func_attrs.end() && attr->second.b()) {
     shared_rendezvous_ = true;
   }
+  for (const NodeDef& node : fdef->node_def()) {
+    if (IsSendOrRecv(node.op())) {
+      has_send_or_recv_ = true;
+      break;
+    }
+  }
 
   bool is_type_list;
   for (const OpDef::ArgDef& ret_def : fdef->signature().output_arg()) {
@@ -231,19 +298,18 @@ Status PartitionedCallOp::Instantiate(FunctionLibraryRuntime* lib,
   return Status::OK();
 }
 
-void PartitionedCallOp::RunFunction(FunctionLibraryRuntime::Handle handle,
-                                    const std::vector<Tensor>& inputs,
-                                    FunctionLibraryRuntime* lib,
-                                    OpKernelContext* ctx, DoneCallback done) {
-  FunctionLibraryRuntime::Options run_opts;
+void PartitionedCallOp::FillRunOptions(
+    FunctionLibraryRuntime* lib, OpKernelContext* ctx,
+    FunctionLibraryRuntime::Options* run_opts_ptr) {
+  FunctionLibraryRuntime::Options& run_opts = *run_opts_ptr;
   ResourceMgr* resource_mgr = lib->device()->resource_manager();
-  ScopedStepContainer* step_container = new ScopedStepContainer(
+  run_opts.step_container = new ScopedStepContainer(
       run_opts.step_id, [resource_mgr](const string& name) {
         resource_mgr->Cleanup(name).IgnoreError();
       });
-  run_opts.step_container = step_container;
   run_opts.cancellation_manager = ctx->cancellation_manager();
   run_opts.stats_collector = ctx->stats_collector();
+  run_opts.request_cost = ctx->request_cost();
   run_opts.collective_executor = ctx->collective_executor();
   // TODO(akshayka): Consider selecting a runner on a per-device basis,
   // i.e., using device-specific threadpools when available.
@@ -255,6 +321,15 @@ void PartitionedCallOp::RunFunction(FunctionLibraryRuntime::Handle handle,
   if (shared_rendezvous_) {
     run_opts.rendezvous = ctx->rendezvous();
   }
+}
+
+void PartitionedCallOp::RunFunction(FunctionLibraryRuntime::Handle handle,
+                                    const std::vector<Tensor>& inputs,
+                                    FunctionLibraryRuntime* lib,
+                                    OpKernelContext* ctx, DoneCallback done) {
+  FunctionLibraryRuntime::Options run_opts;
+  FillRunOptions(lib, ctx, &run_opts);
+  ScopedStepContainer* step_container = run_opts.step_container;
 
   std::vector<Tensor>* rets = new std::vector<Tensor>;
   const string& func_name = func_->name();
@@ -279,6 +354,37 @@ void PartitionedCallOp::RunFunction(FunctionLibraryRuntime::Handle handle,
            });
 }
 
+void PartitionedCallOp::RunSingleComponentFunction(
+    FunctionLibraryRuntime::Handle handle, FunctionLibraryRuntime* lib,
+    OpKernelContext* ctx, DoneCallback done) {
+  FunctionLibraryRuntime::Options run_opts;
+  FillRunOptions(lib, ctx, &run_opts);
+  ScopedStepContainer* step_container = run_opts.step_container;
+  // A function on a single device sends no tensors across devices, so it
+  // only needs a rendezvous for its own sends and receives.
+  run_opts.create_rendezvous = !shared_rendezvous_ && has_send_or_recv_;
+
+  KernelCallFrame* frame = new KernelCallFrame(ctx);
+  const string& func_name = func_->name();
+  profiler::TraceMe trace_me("PartitionedCallOp");
+  lib->Run(run_opts, handle, frame,
+           [frame, done = std::move(done), ctx, func_name,
+            step_container](const Status& status) {
+             if (!status.ok()) {
+               const string function_and_msg =
+                   strings::StrCat(errors::FormatFunctionForError(func_name),
+                                   " ", status.error_message());
+               ctx->SetStatus(
+                   errors::CreateWithUpdatedMessage(status, function_and_msg));
+             } else {
+               frame->SetOutputs();
+             }
+             delete frame;
+             delete step_container;
+             done();
+           });
+}
+
 REGISTER_KERNEL_BUILDER(Name("PartitionedCall").Device(DEVICE_CPU),
                         PartitionedCallOp);
 REGISTER_KERNEL_BUILDER(Name("StatefulPartitionedCall").Device(DEVICE_CPU),
@@ -31,6 +31,10 @@ class ConfigProto;
 // partitions a given function's underlying graph, and executes each of the
 // partitioned subgraphs as a function.
 //
+// A function whose partitioning yields a single subgraph on the device of the
+// kernel is called directly, through a call frame over the inputs and outputs
+// of the kernel.
+//
 // TODO(akshayka): Support distributed execution.
 class PartitionedCallOp : public AsyncOpKernel {
  public:
@@ -54,17 +58,37 @@ class PartitionedCallOp : public AsyncOpKernel {
                    FunctionLibraryRuntime* lib, OpKernelContext* ctx,
                    DoneCallback done);
 
+  // Runs a function that runs entirely on the device of `lib`.
+  void RunSingleComponentFunction(FunctionLibraryRuntime::Handle handle,
+                                  FunctionLibraryRuntime* lib,
+                                  OpKernelContext* ctx, DoneCallback done);
+
+  // Sets the options of a run of the function in `run_opts`. The caller owns
+  // the step container of `run_opts`, and should delete it once the run is
+  // done.
+  void FillRunOptions(FunctionLibraryRuntime* lib, OpKernelContext* ctx,
+                      FunctionLibraryRuntime::Options* run_opts);
+
+  struct FunctionHandle {
+    FunctionLibraryRuntime::Handle handle;
+    // Whether the function runs entirely on the device of its runtime.
+    bool is_single_component;
+  };
+
   // Using unique pointers to avoid including proto headers in kernel headers
   std::unique_ptr<NameAttrList> func_;
   std::unique_ptr<ConfigProto> config_proto_;
   string executor_type_;
   bool shared_rendezvous_;
+  // Whether the body of the function sends or receives tensors itself, and so
+  // needs a rendezvous even if it runs on a single device.
+  bool has_send_or_recv_;
   mutex mu_;
   // Cache the handle per FLR because this kernel may be instantiated for
   // a stateful op, different invocations of it may use different FLRs.
   // Different device placements of PartitionedCallOp also use
   // different FLRs.
-  gtl::FlatMap<FunctionLibraryRuntime*, FunctionLibraryRuntime::Handle> handles_
+  gtl::FlatMap<FunctionLibraryRuntime*, FunctionHandle> handles_
       TF_GUARDED_BY(mu_);
 };
 
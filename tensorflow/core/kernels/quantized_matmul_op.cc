@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/meta_support.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
 #include "tensorflow/core/kernels/reference_gemm.h"
+#include "tensorflow/core/kernels/ruy_support.h"
 #include "tensorflow/core/lib/core/errors.h"
 
 namespace tensorflow {
@@ -140,6 +141,17 @@ class QuantizedMatMulOp : public OpKernel {
       // allows optimized quantized 8bit to 32bit gemm.
       meta::QuantizedGemm(context, transpose_a_, transpose_b_, a_data, b_data,
                           c_data, m, n, k, -offset_a, -offset_b, lda, ldb, ldc);
+    } else if (ruy_support::IsSupportedAndEnabled() &&
+               std::is_same<T1, quint8>() && std::is_same<T2, quint8>() &&
+               std::is_same<Toutput, qint32>() && (offset_c == 0) &&
+               (mult_c == 1) && (shift_c == 0) && (transpose_c == false) &&
+               ruy_support::IsValidZeroPoint(offset_a) &&
+               ruy_support::IsValidZeroPoint(offset_b)) {
+      // Ruy dispatches at runtime to its AVX2, AVX-512 or NEON kernels, which
+      // are much faster than the gemmlowp ones on x86.
+      ruy_support::QuantizedGemm(context, transpose_a_, transpose_b_, a_data,
+                                 b_data, c_data, m, n, k, offset_a, offset_b,
+                                 lda, ldb, ldc);
     } else if (std::is_same<T1, quint8>() && std::is_same<T2, quint8>() &&
                std::is_same<Toutput, qint32>() && (offset_c == 0) &&
                (mult_c == 1) && (shift_c == 0) && (transpose_c == false)) {
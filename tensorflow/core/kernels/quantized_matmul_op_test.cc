@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/kernels/ruy_support.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -37,6 +38,67 @@ namespace tensorflow {
 
 class QuantizedMatMulTest : public OpsTestBase {
  protected:
+  // Multiplies quantized matrices large enough to be split across threads,
+  // with non-zero offsets, and checks the result against a plain loop.
+  void RunLargeAndCompare(bool transpose_a, bool transpose_b) {
+    TF_ASSERT_OK(NodeDefBuilder("quantized_mat_mul_op", "QuantizedMatMul")
+                     .Input(FakeInput(DT_QUINT8))
+                     .Input(FakeInput(DT_QUINT8))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("Toutput", DataTypeToEnum<qint32>::v())
+                     .Attr("transpose_a", transpose_a)
+                     .Attr("transpose_b", transpose_b)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    const int m = 131;
+    const int n = 67;
+    const int k = 300;
+    const float a_min = -1.0f;
+    const float a_max = 3.0f;
+    const float b_min = -2.0f;
+    const float b_max = 1.0f;
+    Tensor a(DT_QUINT8,
+             transpose_a ? TensorShape({k, m}) : TensorShape({m, k}));
+    Tensor b(DT_QUINT8,
+             transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+    for (int i = 0; i < a.NumElements(); ++i) {
+      a.flat<quint8>()(i) = (i * 37 + 11) % 256;
+    }
+    for (int i = 0; i < b.NumElements(); ++i) {
+      b.flat<quint8>()(i) = (i * 101 + 7) % 256;
+    }
+    AddInputFromArray<quint8>(a.shape(), a.flat<quint8>());
+    AddInputFromArray<quint8>(b.shape(), b.flat<quint8>());
+    AddInputFromArray<float>(TensorShape({1}), {a_min});
+    AddInputFromArray<float>(TensorShape({1}), {a_max});
+    AddInputFromArray<float>(TensorShape({1}), {b_min});
+    AddInputFromArray<float>(TensorShape({1}), {b_max});
+    TF_ASSERT_OK(RunOpKernel());
+
+    const int offset_a = FloatToQuantizedUnclamped<quint8>(0.0f, a_min, a_max);
+    const int offset_b = FloatToQuantizedUnclamped<quint8>(0.0f, b_min, b_max);
+    const auto a_matrix = a.matrix<quint8>();
+    const auto b_matrix = b.matrix<quint8>();
+    Tensor expected(DT_QINT32, TensorShape({m, n}));
+    for (int i = 0; i < m; ++i) {
+      for (int j = 0; j < n; ++j) {
+        int32 total = 0;
+        for (int l = 0; l < k; ++l) {
+          const int a_value =
+              transpose_a ? a_matrix(l, i).value : a_matrix(i, l).value;
+          const int b_value =
+              transpose_b ? b_matrix(j, l).value : b_matrix(l, j).value;
+          total += (a_value - offset_a) * (b_value - offset_b);
+        }
+        expected.matrix<qint32>()(i, j) = total;
+      }
+    }
+    test::ExpectTensorEqual<qint32>(expected, *GetOutput(0));
+  }
 };
 
 // Runs two small matrices through the operator, and leaves all the parameters
@@ -355,4 +417,27 @@ TEST_F(QuantizedMatMulTest, Medium_WithParams) {
   test::ExpectTensorNear<float>(expected_float, output_float, 15.0);
 }
 
+TEST_F(QuantizedMatMulTest, Large_NoTranspose) {
+  RunLargeAndCompare(false, false);
+}
+
+TEST_F(QuantizedMatMulTest, Large_TransposeA) {
+  RunLargeAndCompare(true, false);
+}
+
+TEST_F(QuantizedMatMulTest, Large_TransposeB) {
+  RunLargeAndCompare(false, true);
+}
+
+TEST_F(QuantizedMatMulTest, Large_TransposeBoth) {
+  RunLargeAndCompare(true, true);
+}
+
+TEST_F(QuantizedMatMulTest, Large_WithoutRuy) {
+  // The gemmlowp fallback computes the same values.
+  ruy_support::SetEnabled(false);
+  RunLargeAndCompare(false, true);
+  ruy_support::SetEnabled(true);
+}
+
 }  // namespace tensorflow
@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/bcast.h"
 #include "tensorflow/core/util/ragged_to_dense_util.h"
@@ -207,35 +208,65 @@ class RaggedTensorToTensorBaseOp : public OpKernel {
     DCHECK_EQ(result->size(), first_dimension);
   }
 
+  // Checks that row_split starts at 0, is sorted, and has no more rows than
+  // the parent dimension, so that row_split(i) is the index in the next
+  // dimension of the first element of row i.
+  static Status ValidateRowSplit(const RowPartitionTensor& row_split,
+                                 size_t parent_size) {
+    const INDEX_TYPE row_split_size = row_split.size();
+    if (row_split_size == 0) {
+      return Status::OK();
+    }
+    if (static_cast<size_t>(row_split_size - 1) > parent_size) {
+      return errors::InvalidArgument(
+          "Row partition size is greater than output size: ",
+          row_split_size - 1, " > ", parent_size);
+    }
+    if (row_split(0) != 0) {
+      return errors::InvalidArgument("Invalid row split size.");
+    }
+    for (INDEX_TYPE i = 1; i < row_split_size; ++i) {
+      if (row_split(i) < row_split(i - 1)) {
+        return errors::InvalidArgument("Invalid row split size.");
+      }
+    }
+    return Status::OK();
+  }
+
+  // Rows are independent, since row_split(i) is the index in result of the
+  // first element of row i, so they are computed in parallel.
   Status CalculateOutputIndexRowSplit(
-      const RowPartitionTensor& row_split,
+      OpKernelContext* context, const RowPartitionTensor& row_split,
       const vector<INDEX_TYPE>& parent_output_index,
       INDEX_TYPE output_index_multiplier, INDEX_TYPE output_size,
       vector<INDEX_TYPE>* result) {
-    INDEX_TYPE row_split_size = row_split.size();
-    if (row_split_size > 0) {
-      result->reserve(row_split(row_split_size - 1));
+    TF_RETURN_IF_ERROR(
+        ValidateRowSplit(row_split, parent_output_index.size()));
+    const INDEX_TYPE num_rows = row_split.size() - 1;
+    if (num_rows <= 0) {
+      return Status::OK();
     }
-    for (INDEX_TYPE i = 0; i < row_split_size - 1; ++i) {
-      INDEX_TYPE row_length = row_split(i + 1) - row_split(i);
-      INDEX_TYPE real_length = std::min(output_size, row_length);
-      INDEX_TYPE parent_output_index_current = parent_output_index[i];
-
-      if (parent_output_index_current == -1) {
-        real_length = 0;
-      }
-      for (INDEX_TYPE j = 0; j < real_length; ++j) {
-        result->push_back(parent_output_index_current);
-        parent_output_index_current += output_index_multiplier;
-      }
-      for (INDEX_TYPE j = 0; j < row_length - real_length; ++j) {
-        result->push_back(-1);
+    result->resize(row_split(num_rows));
+    INDEX_TYPE* result_base = result->data();
+    auto work = [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        INDEX_TYPE* dst = result_base + row_split(i);
+        const INDEX_TYPE row_length = row_split(i + 1) - row_split(i);
+        INDEX_TYPE parent_output_index_current = parent_output_index[i];
+        const INDEX_TYPE real_length =
+            parent_output_index_current == -1
+                ? 0
+                : std::min(output_size, row_length);
+        for (INDEX_TYPE j = 0; j < real_length; ++j) {
+          dst[j] = parent_output_index_current;
+          parent_output_index_current += output_index_multiplier;
+        }
+        std::fill(dst + real_length, dst + row_length, -1);
       }
-    }
-    if (row_split_size > 0 && result->size() != row_split(row_split_size - 1)) {
-      return errors::InvalidArgument("Invalid row split size.");
-    }
-
+    };
+    const int64_t cost_per_row = 1 + row_split(num_rows) / num_rows;
+    context->device()->tensorflow_cpu_worker_threads()->workers->ParallelFor(
+        num_rows, cost_per_row, work);
     return Status::OK();
   }
 
@@ -329,15 +360,9 @@ class RaggedTensorToTensorBaseOp : public OpKernel {
             row_partition_tensor, parent_output_index, output_index_multiplier,
             output_size, result);
       case RowPartitionType::ROW_SPLITS:
-        if (row_partition_tensor.size() - 1 > parent_output_index.size()) {
-          return errors::InvalidArgument(
-              "Row partition size is greater than output size: ",
-              row_partition_tensor.size() - 1, " > ",
-              parent_output_index.size());
-        }
         return CalculateOutputIndexRowSplit(
-            row_partition_tensor, parent_output_index, output_index_multiplier,
-            output_size, result);
+            context, row_partition_tensor, parent_output_index,
+            output_index_multiplier, output_size, result);
       default:
         return errors::InvalidArgument(
             "Unsupported partition type:",
@@ -397,8 +422,26 @@ class RaggedTensorToTensorBaseOp : public OpKernel {
                    context->allocate_output(0, output_shape, &output_tensor));
     const INDEX_TYPE full_size = multiplier[0] * output_size[0];
     if (full_size > 0) {
-      vector<INDEX_TYPE> output_index, new_output_index;
       int nvals = context->input(kValueInputIndex).shape().dim_size(0);
+      if (ragged_rank_ == 1 &&
+          GetRowPartitionTypeByDimension(0) == RowPartitionType::ROW_SPLITS) {
+        // Fast path for a single ragged dimension: each output row is a
+        // prefix of one row of values, so no output index is needed.
+        const RowPartitionTensor row_splits =
+            GetRowPartitionTensor(context, 0);
+        OP_REQUIRES_OK(context, ValidateRowSplit(row_splits, first_dimension));
+        OP_REQUIRES(
+            context,
+            row_splits.size() == 0 ||
+                row_splits(row_splits.size() - 1) <= nvals,
+            errors::InvalidArgument("Row splits end at ",
+                                    row_splits(row_splits.size() - 1),
+                                    " but there are only ", nvals, " values."));
+        SetOutputFromRowSplits(context, row_splits, output_tensor);
+        return;
+      }
+
+      vector<INDEX_TYPE> output_index, new_output_index;
       output_index.reserve(nvals);
       new_output_index.reserve(nvals);
 
@@ -419,6 +462,12 @@ class RaggedTensorToTensorBaseOp : public OpKernel {
                          const vector<INDEX_TYPE>& output_index,
                          Tensor* output_tensor) = 0;
 
+  // Sets the output when there is a single ragged dimension, partitioned by
+  // the validated `row_splits`.
+  virtual void SetOutputFromRowSplits(OpKernelContext* context,
+                                      const RowPartitionTensor& row_splits,
+                                      Tensor* output_tensor) = 0;
+
  private:
   vector<RowPartitionType> row_partition_types_;
   int ragged_rank_;
@@ -463,6 +512,20 @@ void copy_array<Eigen::half, int32>(Eigen::half* dst, const Eigen::half* src,
   slow_copy_array(dst, src, size);
 }
 
+// Fills dst[0, size) with copies of pattern[0, pattern_size), where size is a
+// multiple of pattern_size, doubling the filled prefix with each copy.
+template <typename VALUE_TYPE, typename INDEX_TYPE>
+void fill_array(VALUE_TYPE* dst, INDEX_TYPE size, const VALUE_TYPE* pattern,
+                INDEX_TYPE pattern_size) {
+  if (size == 0) return;
+  copy_array<VALUE_TYPE, INDEX_TYPE>(dst, pattern, pattern_size);
+  for (INDEX_TYPE filled = pattern_size; filled < size;) {
+    const INDEX_TYPE n = std::min(filled, size - filled);
+    copy_array<VALUE_TYPE, INDEX_TYPE>(dst + filled, dst, n);
+    filled += n;
+  }
+}
+
 template <typename VALUE_TYPE, typename INDEX_TYPE>
 class RaggedTensorToTensorOp : public RaggedTensorToTensorBaseOp<INDEX_TYPE> {
  public:
@@ -488,30 +551,10 @@ class RaggedTensorToTensorOp : public RaggedTensorToTensorBaseOp<INDEX_TYPE> {
     int value_element_size = element_shape.num_elements();
     size_t output_index_size = output_index.size();
 
-    // Broadcast the default value to value_element_size.  (We can skip this
-    // if default_value_tensor.NumElements() == 1, since we use std::fill
-    // when that's true.)
-    const VALUE_TYPE* default_value =
-        default_value_tensor.flat<VALUE_TYPE>().data();
+    const VALUE_TYPE* default_value;
     Tensor bcast_default;  // Temporary tensor for result of broadcast
-    if (default_value_tensor.NumElements() != value_element_size &&
-        default_value_tensor.NumElements() != 1) {
-      const auto& src_shape = default_value_tensor.shape();
-      BCast bcast(BCast::FromShape(src_shape), BCast::FromShape(element_shape),
-                  /*fewer_dims_optimization=*/true);
-      // Note: bcast should always be valid, since we rejected any incompatible
-      // shapes when we called ValidateDefaultValueShape().
-      OP_REQUIRES(context, bcast.IsValid(),
-                  errors::InvalidArgument("Error broadcasting default_value"));
-      OP_REQUIRES_OK(context,
-                     context->allocate_temp(default_value_tensor.dtype(),
-                                            element_shape, &bcast_default));
-      const CPUDevice& device = context->eigen_device<CPUDevice>();
-      functor::BroadcastTo<CPUDevice, VALUE_TYPE>()(
-          device, context, bcast_default, element_shape, default_value_tensor,
-          src_shape, bcast);
-      default_value = bcast_default.flat<VALUE_TYPE>().data();
-    }
+    OP_REQUIRES_OK(context, GetDefaultValue(context, element_shape,
+                                            &bcast_default, &default_value));
 
     // Loop through the output_index vector, finding contiguous regions that
     // should be copied.  Once we find the end of a contiguous region, copy it
@@ -554,12 +597,11 @@ class RaggedTensorToTensorOp : public RaggedTensorToTensorBaseOp<INDEX_TYPE> {
                     output_base + dst_i * value_element_size, *default_value);
           dst_end = dst_i;
         } else {
-          while (dst_i > dst_end) {
-            VALUE_TYPE* dst = output_base + dst_end * value_element_size;
-            copy_array<VALUE_TYPE, INDEX_TYPE>(dst, default_value,
-                                               value_element_size);
-            ++dst_end;
-          }
+          fill_array<VALUE_TYPE, INDEX_TYPE>(
+              output_base + dst_end * value_element_size,
+              (dst_i - dst_end) * value_element_size, default_value,
+              value_element_size);
+          dst_end = dst_i;
         }
       }
 
@@ -576,6 +618,91 @@ class RaggedTensorToTensorOp : public RaggedTensorToTensorBaseOp<INDEX_TYPE> {
       }
     }
   }
+
+  void SetOutputFromRowSplits(
+      OpKernelContext* context,
+      const typename RaggedTensorToTensorBaseOp<INDEX_TYPE>::RowPartitionTensor&
+          row_splits,
+      Tensor* output_tensor) override {
+    if (output_tensor->NumElements() == 0) return;
+
+    const VALUE_TYPE* values_base =
+        context->input(kValueInputIndex).flat<VALUE_TYPE>().data();
+    const bool scalar_default =
+        context->input(kDefaultValueInputIndex).NumElements() == 1;
+    VALUE_TYPE* output_base = output_tensor->flat<VALUE_TYPE>().data();
+
+    TensorShape element_shape = output_tensor->shape();
+    element_shape.RemoveDimRange(0, 2);
+    const INDEX_TYPE value_element_size = element_shape.num_elements();
+    const INDEX_TYPE num_value_rows =
+        row_splits.size() > 0 ? row_splits.size() - 1 : 0;
+    const INDEX_TYPE width = output_tensor->dim_size(1);
+    const INDEX_TYPE output_row_size = width * value_element_size;
+
+    const VALUE_TYPE* default_value;
+    Tensor bcast_default;  // Temporary tensor for result of broadcast
+    OP_REQUIRES_OK(context, GetDefaultValue(context, element_shape,
+                                            &bcast_default, &default_value));
+
+    // Each output row is the prefix of its row of values that fits in the
+    // output, followed by the default value.  Rows past the last row of
+    // values are all default value.
+    auto work = [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        VALUE_TYPE* dst = output_base + i * output_row_size;
+        INDEX_TYPE copied = 0;
+        if (i < num_value_rows) {
+          const INDEX_TYPE row_start = row_splits(i);
+          copied = std::min(row_splits(i + 1) - row_start, width) *
+                   value_element_size;
+          copy_array<VALUE_TYPE, INDEX_TYPE>(
+              dst, values_base + row_start * value_element_size, copied);
+        }
+        if (scalar_default) {
+          std::fill(dst + copied, dst + output_row_size, *default_value);
+        } else {
+          fill_array<VALUE_TYPE, INDEX_TYPE>(dst + copied,
+                                             output_row_size - copied,
+                                             default_value, value_element_size);
+        }
+      }
+    };
+    context->device()->tensorflow_cpu_worker_threads()->workers->ParallelFor(
+        output_tensor->dim_size(0), 1 + output_row_size, work);
+  }
+
+ private:
+  // Sets *default_value to the default value, broadcast to element_shape
+  // into *bcast_default if needed.  (We skip the broadcast if the default
+  // value has a single element, since we use std::fill when that's true.)
+  Status GetDefaultValue(OpKernelContext* context,
+                         const TensorShape& element_shape,
+                         Tensor* bcast_default,
+                         const VALUE_TYPE** default_value) {
+    const auto& default_value_tensor = context->input(kDefaultValueInputIndex);
+    *default_value = default_value_tensor.flat<VALUE_TYPE>().data();
+    if (default_value_tensor.NumElements() == element_shape.num_elements() ||
+        default_value_tensor.NumElements() == 1) {
+      return Status::OK();
+    }
+    const auto& src_shape = default_value_tensor.shape();
+    BCast bcast(BCast::FromShape(src_shape), BCast::FromShape(element_shape),
+                /*fewer_dims_optimization=*/true);
+    // Note: bcast should always be valid, since we rejected any incompatible
+    // shapes when we called ValidateDefaultValueShape().
+    if (!bcast.IsValid()) {
+      return errors::InvalidArgument("Error broadcasting default_value");
+    }
+    TF_RETURN_IF_ERROR(context->allocate_temp(default_value_tensor.dtype(),
+                                              element_shape, bcast_default));
+    const CPUDevice& device = context->eigen_device<CPUDevice>();
+    functor::BroadcastTo<CPUDevice, VALUE_TYPE>()(
+        device, context, *bcast_default, element_shape, default_value_tensor,
+        src_shape, bcast);
+    *default_value = bcast_default->flat<VALUE_TYPE>().data();
+    return Status::OK();
+  }
 };
 
 #define REGISTER_CPU_KERNEL_INDEX_TYPE(value_type, index_type)       \
@@ -490,6 +490,75 @@ TEST_F(RaggedTensorToTensorOpTest, RaggedTensorToTensor_4DParamsConstrained) {
                                                     TensorShape({2, 2, 2, 2})));
 }
 
+TEST_F(RaggedTensorToTensorOpTest, RowSplitsConstrainedVectorDefault) {
+  // params = [[[1, 2], [3, 4], [5, 6]], [], [[7, 8], [9, 10]]]
+  // The output drops the third element of the first row, and pads the
+  // other rows, and a fourth row, with the default value.
+  BuildRaggedTensorToTensorGraph<int32, int32>(
+      TensorShape({4, 2, 2}),  // shape
+      {"ROW_SPLITS"},          // row_partition_types
+      {TensorShape({5, 2}), {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}},  // values
+      createVector<int32>({-1, -2}),       // default_value
+      {createVector<int32>({0, 3, 3, 5})}  // row_partition_tensors
+  );
+
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<int32>(
+      *GetOutput(0), test::AsTensor<int32>({1, 2, 3, 4, -1, -2, -1, -2, 7, 8,
+                                            9, 10, -1, -2, -1, -2},
+                                           TensorShape({4, 2, 2})));
+}
+
+TEST_F(RaggedTensorToTensorOpTest, RowSplitsManyRows) {
+  // Row i has i % 7 values, all equal to i, in an output of width 4.
+  std::vector<int64_t> row_splits = {0};
+  std::vector<float> values;
+  std::vector<float> expected;
+  const int num_rows = 10000;
+  for (int i = 0; i < num_rows; ++i) {
+    const int length = i % 7;
+    for (int j = 0; j < length; ++j) values.push_back(i);
+    row_splits.push_back(values.size());
+    for (int j = 0; j < 4; ++j) expected.push_back(j < length ? i : -1);
+  }
+  BuildRaggedTensorToTensorGraph<float, int64_t>(
+      TensorShape({num_rows, 4}),           // shape
+      {"ROW_SPLITS"},                       // row_partition_types
+      createVector<float>(values),          // values
+      createScalar<float>(-1),              // default_value
+      {createVector<int64_t>(row_splits)}  // row_partition_tensors
+  );
+
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<float>(
+      *GetOutput(0),
+      test::AsTensor<float>(expected, TensorShape({num_rows, 4})));
+}
+
+TEST_F(RaggedTensorToTensorOpTest, RowSplitsInvalid) {
+  BuildRaggedTensorToTensorGraph<int32, int32>(
+      TensorShape({3, 3}),                   // shape
+      {"ROW_SPLITS"},                        // row_partition_types
+      createVector<int32>({1, 2, 3, 4, 5}),  // values
+      createScalar<int32>(0),                // default_value
+      {createVector<int32>({0, 3, 2, 5})}    // row_partition_tensors
+  );
+  EXPECT_EQ(RunOpKernel().code(), errors::Code::INVALID_ARGUMENT);
+}
+
+TEST_F(RaggedTensorToTensorOpTest, RowSplitsPastValues) {
+  BuildRaggedTensorToTensorGraph<int32, int32>(
+      TensorShape({2, 6}),                   // shape
+      {"ROW_SPLITS"},                        // row_partition_types
+      createVector<int32>({1, 2, 3, 4, 5}),  // values
+      createScalar<int32>(0),                // default_value
+      {createVector<int32>({0, 3, 9})}       // row_partition_tensors
+  );
+  EXPECT_EQ(RunOpKernel().code(), errors::Code::INVALID_ARGUMENT);
+}
+
 TEST_F(RaggedTensorToTensorOpTest, ShapeWrongDimensions) {
   BuildRaggedTensorToTensorGraph<int32, int32>(
       TensorShape({10, 7, 10, 20}),  // shape
@@ -21,6 +21,7 @@ limitations under the License.
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <type_traits>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/random_op.h"
 #include "tensorflow/core/kernels/random_ops_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/random/philox_random_batch.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/logging.h"
@@ -52,6 +54,8 @@ typedef Eigen::GpuDevice GPUDevice;
 
 namespace functor {
 using random::PhiloxRandom;
+using random::PhiloxRandomBatch;
+using random::PrefetchedPhiloxRandom;
 using random::SingleSampleAdapter;
 
 // The default implementation of the functor, which should never be invoked
@@ -72,14 +76,55 @@ struct FillPhiloxRandom {
   }
 };
 
+// Maps a distribution to the same distribution reading its samples from a
+// PrefetchedPhiloxRandom, for the distributions that have no state of their
+// own. Their samples can then be generated ahead of time, a batch of output
+// groups at once, by PhiloxRandomBatch.
+template <class Distribution>
+struct PrefetchedDistribution {
+  static constexpr bool kSupported = false;
+};
+
+template <typename T>
+struct PrefetchedDistribution<random::UniformDistribution<PhiloxRandom, T>> {
+  static constexpr bool kSupported =
+      std::is_empty<random::UniformDistribution<PhiloxRandom, T>>::value;
+  using type = random::UniformDistribution<PrefetchedPhiloxRandom, T>;
+};
+
+template <typename T>
+struct PrefetchedDistribution<
+    random::UniformFullIntDistribution<PhiloxRandom, T>> {
+  static constexpr bool kSupported = true;
+  using type = random::UniformFullIntDistribution<PrefetchedPhiloxRandom, T>;
+};
+
+template <typename T>
+struct PrefetchedDistribution<random::NormalDistribution<PhiloxRandom, T>> {
+  static constexpr bool kSupported = true;
+  using type = random::NormalDistribution<PrefetchedPhiloxRandom, T>;
+};
+
+template <typename T>
+struct PrefetchedDistribution<random::TruncatedNormalDistribution<
+    SingleSampleAdapter<PhiloxRandom>, T>> {
+  static constexpr bool kSupported = true;
+  using type = random::TruncatedNormalDistribution<
+      SingleSampleAdapter<PrefetchedPhiloxRandom>, T>;
+};
+
+// The number of output groups whose samples are generated together.
+constexpr int kPrefetchedGroups = 64;
+
 // A class to fill a specified range of random groups
-template <class Distribution, bool VariableSamplesPerOutput>
+template <class Distribution, bool VariableSamplesPerOutput,
+          bool Prefetched = PrefetchedDistribution<Distribution>::kSupported>
 struct FillPhiloxRandomTask;
 
 // Specialization for distribution that takes a fixed number of samples for
 // each output.
 template <class Distribution>
-struct FillPhiloxRandomTask<Distribution, false> {
+struct FillPhiloxRandomTask<Distribution, false, false> {
   typedef typename Distribution::ResultElementType T;
   static void Run(random::PhiloxRandom gen, T* data, int64_t size,
                   int64_t start_group, int64_t limit_group, Distribution dist) {
@@ -105,10 +150,42 @@ struct FillPhiloxRandomTask<Distribution, false> {
   }
 };
 
+// Specialization for distribution that takes a fixed number of samples, one
+// generator output, for each output group, and whose samples are generated a
+// batch of groups at once.
+template <class Distribution>
+struct FillPhiloxRandomTask<Distribution, false, true> {
+  typedef typename Distribution::ResultElementType T;
+  static void Run(random::PhiloxRandom gen, T* data, int64_t size,
+                  int64_t start_group, int64_t limit_group, Distribution) {
+    const int kGroupSize = Distribution::kResultElementCount;
+    typename PrefetchedDistribution<Distribution>::type dist;
+
+    gen.Skip(start_group);
+    PhiloxRandom::ResultType samples[kPrefetchedGroups];
+    for (int64_t batch_start = start_group; batch_start < limit_group;
+         batch_start += kPrefetchedGroups) {
+      const int num_groups = static_cast<int>(
+          std::min<int64_t>(kPrefetchedGroups, limit_group - batch_start));
+      PhiloxRandomBatch::Generate(gen, /*stride=*/1, num_groups, samples);
+      gen.Skip(num_groups);
+      PrefetchedPhiloxRandom prefetched(samples, num_groups, gen);
+      for (int64_t index = batch_start; index < batch_start + num_groups;
+           ++index) {
+        const int64_t offset = index * kGroupSize;
+        auto results = dist(&prefetched);
+        std::copy(&results[0],
+                  &results[0] + std::min<int64_t>(kGroupSize, size - offset),
+                  data + offset);
+      }
+    }
+  }
+};
+
 // Specialization for distribution that takes a variable number of samples for
 // each output. This will be slower due to the generality.
 template <class Distribution>
-struct FillPhiloxRandomTask<Distribution, true> {
+struct FillPhiloxRandomTask<Distribution, true, false> {
   typedef typename Distribution::ResultElementType T;
   static constexpr int64_t kReservedSamplesPerOutput = 256;
 
@@ -152,6 +229,65 @@ struct FillPhiloxRandomTask<Distribution, true> {
   }
 };
 
+// Specialization for distribution that takes a variable number of samples for
+// each output, with the first samples of a batch of groups generated at once.
+// The rejection sampling of a group rarely needs more than these, and takes
+// the rest from the generator of the group otherwise.
+template <class Distribution>
+struct FillPhiloxRandomTask<Distribution, true, true> {
+  typedef typename Distribution::ResultElementType T;
+  static constexpr int64_t kReservedSamplesPerOutput = 256;
+  // The number of generator outputs prefetched for each group.
+  static constexpr int kPrefetchedSamplesPerGroup = 2;
+
+  static void Run(random::PhiloxRandom base_gen, T* data, int64_t size,
+                  int64_t start_group, int64_t limit_group, Distribution) {
+    const int kGroupSize = Distribution::kResultElementCount;
+    typename PrefetchedDistribution<Distribution>::type dist;
+
+    static const int kGeneratorSkipPerOutputGroup =
+        kGroupSize * kReservedSamplesPerOutput /
+        PhiloxRandom::kResultElementCount;
+
+    PhiloxRandom::ResultType batch[kPrefetchedSamplesPerGroup]
+                                  [kPrefetchedGroups];
+    for (int64_t batch_start = start_group; batch_start < limit_group;
+         batch_start += kPrefetchedGroups) {
+      const int num_groups = static_cast<int>(
+          std::min<int64_t>(kPrefetchedGroups, limit_group - batch_start));
+      for (int i = 0; i < kPrefetchedSamplesPerGroup; ++i) {
+        PhiloxRandom gen = base_gen;
+        gen.Skip(batch_start * kGeneratorSkipPerOutputGroup + i);
+        PhiloxRandomBatch::Generate(gen, kGeneratorSkipPerOutputGroup,
+                                    num_groups, batch[i]);
+      }
+      for (int g = 0; g < num_groups; ++g) {
+        // Reset the generator to the beginning of the output group region
+        // This is necessary if we want the results to be independent of order
+        // of work
+        const int64_t group_index = batch_start + g;
+        PhiloxRandom::ResultType samples[kPrefetchedSamplesPerGroup];
+        for (int i = 0; i < kPrefetchedSamplesPerGroup; ++i) {
+          samples[i] = batch[i][g];
+        }
+        PhiloxRandom gen = base_gen;
+        gen.Skip(group_index * kGeneratorSkipPerOutputGroup +
+                 kPrefetchedSamplesPerGroup);
+        PrefetchedPhiloxRandom prefetched(samples, kPrefetchedSamplesPerGroup,
+                                          gen);
+        SingleSampleAdapter<PrefetchedPhiloxRandom> single_samples(
+            &prefetched);
+
+        const int64_t offset = group_index * kGroupSize;
+        auto results = dist(&single_samples);
+        std::copy(&results[0],
+                  &results[0] + std::min<int64_t>(kGroupSize, size - offset),
+                  data + offset);
+      }
+    }
+  }
+};
+
 // Partial specialization for CPU to fill the entire region with randoms
 // It splits the work into several tasks and run them in parallel
 template <class Distribution>
@@ -23,6 +23,10 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
@@ -253,6 +257,179 @@ class ReductionOp : public OpKernel {
 
 namespace functor {
 
+// Sums and means of float and double matrices along one dimension on CPU.
+//
+// Eigen parallelizes reductions of the inner dimension over the rows only, and
+// reductions of the outer dimension poorly. Instead, the reduced dimension is
+// split into blocks, whose partial sums are computed in parallel with SIMD and
+// then summed pairwise. The blocks only depend on the shape of the input, so
+// the results are the same for any number of threads.
+namespace matrix_reduction {
+
+// The reduced dimension is split into at most this many blocks.
+constexpr int64_t kMaxBlocks = 64;
+// Blocks of a row hold at least this many elements.
+constexpr int64_t kMinRowBlockSize = 16384;
+// Blocks of columns hold at least this many rows.
+constexpr int64_t kMinColumnBlockRows = 64;
+// Columns are summed in chunks of this width, to keep their sums in cache.
+constexpr int64_t kColumnChunkSize = 512;
+
+// Returns the number of blocks of at least `min_size` of `n` elements.
+inline int64_t NumBlocks(int64_t n, int64_t min_size) {
+  return std::min(kMaxBlocks, std::max<int64_t>(1, n / min_size));
+}
+
+// Sums `n` values with the given `stride` pairwise.
+template <typename T>
+T PairwiseSum(const T* values, int64_t n, int64_t stride) {
+  if (n == 1) return values[0];
+  const int64_t half = n / 2;
+  return PairwiseSum(values, half, stride) +
+         PairwiseSum(values + half * stride, n - half, stride);
+}
+
+// Sets `out` to the sums of the `rows` rows of `cols` elements of `in`.
+template <typename T>
+void SumRows(const CPUDevice& d, const T* in, int64_t rows, int64_t cols,
+             T* out) {
+  using Vector = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+  const int64_t num_blocks = NumBlocks(cols, kMinRowBlockSize);
+  const int64_t block_size = (cols + num_blocks - 1) / num_blocks;
+  std::vector<T> partials(num_blocks > 1 ? rows * num_blocks : 0);
+  T* sums = num_blocks > 1 ? partials.data() : out;
+  d.parallelFor(rows * num_blocks,
+                Eigen::TensorOpCost(block_size * sizeof(T), sizeof(T),
+                                    block_size),
+                [&](int64_t start, int64_t limit) {
+                  for (int64_t i = start; i < limit; ++i) {
+                    const int64_t begin = (i % num_blocks) * block_size;
+                    const int64_t size = std::max<int64_t>(
+                        0, std::min(block_size, cols - begin));
+                    sums[i] =
+                        Vector(in + (i / num_blocks) * cols + begin, size)
+                            .sum();
+                  }
+                });
+  if (num_blocks > 1) {
+    for (int64_t row = 0; row < rows; ++row) {
+      out[row] = PairwiseSum(&partials[row * num_blocks], num_blocks, 1);
+    }
+  }
+}
+
+// Sets `out` to the sums of the `cols` columns of `rows` elements of `in`.
+template <typename T>
+void SumColumns(const CPUDevice& d, const T* in, int64_t rows, int64_t cols,
+                T* out) {
+  using Vector = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+  using ConstVector = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+  const int64_t num_blocks = NumBlocks(rows, kMinColumnBlockRows);
+  const int64_t block_rows = (rows + num_blocks - 1) / num_blocks;
+  const int64_t num_chunks = (cols + kColumnChunkSize - 1) / kColumnChunkSize;
+  std::vector<T> partials(num_blocks > 1 ? num_blocks * cols : 0);
+  T* sums = num_blocks > 1 ? partials.data() : out;
+  d.parallelFor(
+      num_blocks * num_chunks,
+      Eigen::TensorOpCost(block_rows * kColumnChunkSize * sizeof(T),
+                          kColumnChunkSize * sizeof(T),
+                          block_rows * kColumnChunkSize),
+      [&](int64_t start, int64_t limit) {
+        for (int64_t i = start; i < limit; ++i) {
+          const int64_t block = i / num_chunks;
+          const int64_t begin = (i % num_chunks) * kColumnChunkSize;
+          const int64_t size = std::min(kColumnChunkSize, cols - begin);
+          const int64_t end_row = std::min(rows, (block + 1) * block_rows);
+          Vector sum(sums + block * cols + begin, size);
+          sum.setZero();
+          for (int64_t row = block * block_rows; row < end_row; ++row) {
+            sum += ConstVector(in + row * cols + begin, size);
+          }
+        }
+      });
+  if (num_blocks == 1) return;
+  // Adds the sums of the blocks pairwise, in the order of PairwiseSum.
+  d.parallelFor(
+      num_chunks,
+      Eigen::TensorOpCost(num_blocks * kColumnChunkSize * sizeof(T),
+                          kColumnChunkSize * sizeof(T),
+                          num_blocks * kColumnChunkSize),
+      [&](int64_t start, int64_t limit) {
+        for (int64_t chunk = start; chunk < limit; ++chunk) {
+          const int64_t begin = chunk * kColumnChunkSize;
+          const int64_t size = std::min(kColumnChunkSize, cols - begin);
+          std::function<void(int64_t, int64_t)> add_blocks =
+              [&](int64_t first, int64_t n) {
+                if (n == 1) return;
+                const int64_t half = n / 2;
+                add_blocks(first, half);
+                add_blocks(first + half, n - half);
+                Vector(&partials[first * cols + begin], size) +=
+                    ConstVector(&partials[(first + half) * cols + begin], size);
+              };
+          add_blocks(0, num_blocks);
+          ConstVector sum(&partials[begin], size);
+          Vector(out + begin, size) = sum;
+        }
+      });
+}
+
+// Reduces a matrix along `reduction_axes`, or a vector to a scalar.
+template <typename T, bool kMean>
+struct MatrixReduceImpl {
+  template <typename OUT_T, typename IN_T, typename ReductionAxes>
+  void operator()(const CPUDevice& d, OUT_T out, IN_T in,
+                  const ReductionAxes& reduction_axes) {
+    const int64_t outer = IN_T::NumDimensions == 2 ? in.dimension(0) : 1;
+    const int64_t inner = in.dimension(IN_T::NumDimensions - 1);
+    int64_t reduced;
+    if (IN_T::NumDimensions == 2 && reduction_axes[0] == 0) {
+      SumColumns(d, in.data(), outer, inner, out.data());
+      reduced = outer;
+    } else if (outer > 1 && NumBlocks(inner, kMinRowBlockSize) == 1) {
+      // Eigen sums each short row in order, and in parallel over the rows.
+      out.device(d) =
+          in.reduce(reduction_axes, Eigen::internal::SumReducer<T>());
+      reduced = inner;
+    } else {
+      SumRows(d, in.data(), outer, inner, out.data());
+      reduced = inner;
+    }
+    if (kMean) {
+      out.device(d) = out / static_cast<T>(reduced);
+    }
+  }
+};
+
+}  // namespace matrix_reduction
+
+#define MATRIX_REDUCTION_SPECIALIZATION(Reducer, T, kMean, NDIMS)             \
+  template <typename Index, typename ReductionAxes>                           \
+  struct ReduceEigenImpl<                                                     \
+      CPUDevice,                                                              \
+      Eigen::TensorMap<Eigen::Tensor<T, NDIMS - 1, Eigen::RowMajor, Index>,   \
+                       Eigen::Aligned>,                                       \
+      Eigen::TensorMap<Eigen::Tensor<const T, NDIMS, Eigen::RowMajor, Index>, \
+                       Eigen::Aligned>,                                       \
+      ReductionAxes, Reducer<T>> {                                            \
+    template <typename OUT_T, typename IN_T>                                  \
+    void operator()(const CPUDevice& d, OUT_T out, IN_T in,                   \
+                    const ReductionAxes& reduction_axes,                      \
+                    const Reducer<T>& reducer) {                              \
+      matrix_reduction::MatrixReduceImpl<T, kMean>()(d, out, in,              \
+                                                      reduction_axes);        \
+    }                                                                         \
+  };
+#define MATRIX_REDUCTION_SPECIALIZATIONS(T)                                   \
+  MATRIX_REDUCTION_SPECIALIZATION(Eigen::internal::SumReducer, T, false, 1)   \
+  MATRIX_REDUCTION_SPECIALIZATION(Eigen::internal::SumReducer, T, false, 2)   \
+  MATRIX_REDUCTION_SPECIALIZATION(functor::MeanReducer, T, true, 1)           \
+  MATRIX_REDUCTION_SPECIALIZATION(functor::MeanReducer, T, true, 2)
+MATRIX_REDUCTION_SPECIALIZATIONS(float)
+MATRIX_REDUCTION_SPECIALIZATIONS(double)
+#undef MATRIX_REDUCTION_SPECIALIZATIONS
+#undef MATRIX_REDUCTION_SPECIALIZATION
+
 template <typename Device, typename Reducer>
 struct ReduceFunctorBase {
   template <typename OUT_T, typename IN_T, typename ReductionAxes>
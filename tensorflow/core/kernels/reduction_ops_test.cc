@@ -144,6 +144,36 @@ static void Do3DXZReduce(::testing::benchmark::State& state,
                           num_y * sizeof(float));
 }
 
+static void BM_Sum2DRowReduceCPU(::testing::benchmark::State& state) {
+  const int num_x = state.range(0);
+  const int num_y = state.range(1);
+
+  DoRowReduce(state, "cpu", "Sum", num_x, num_y);
+}
+BENCHMARK(BM_Sum2DRowReduceCPU)
+    ->ArgPair(64, 1 << 20)
+    ->ArgPair(1 << 14, 4096)
+    ->ArgPair(1 << 18, 16);
+
+static void BM_Sum2DColumnReduceCPU(::testing::benchmark::State& state) {
+  const int num_x = state.range(0);
+  const int num_y = state.range(1);
+
+  DoColReduce(state, "cpu", "Sum", num_x, num_y);
+}
+BENCHMARK(BM_Sum2DColumnReduceCPU)
+    ->ArgPair(1 << 20, 16)
+    ->ArgPair(100000, 100)
+    ->ArgPair(4096, 4096);
+
+static void BM_Mean2DColumnReduceCPU(::testing::benchmark::State& state) {
+  const int num_x = state.range(0);
+  const int num_y = state.range(1);
+
+  DoColReduce(state, "cpu", "Mean", num_x, num_y);
+}
+BENCHMARK(BM_Mean2DColumnReduceCPU)->ArgPair(100000, 100);
+
 static void BM_Sum2DToScalarGPU(::testing::benchmark::State& state) {
   const int num_x = state.range(0);
   const int num_y = state.range(1);
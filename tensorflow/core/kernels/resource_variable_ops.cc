@@ -78,7 +78,6 @@ limitations under the License.
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
-#include "tensorflow/core/util/determinism.h"
 #include "tensorflow/core/util/util.h"
 
 namespace tensorflow {
@@ -144,11 +143,23 @@ void ReadVariableOp::Compute(OpKernelContext* ctx) {
                   "Debug info: container=", handle.container(),
                   ", status error message=", status.error_message()));
 
+  Tensor snapshot;
+  if (!variable->copy_on_read_mode.load() &&
+      variable->ReadSnapshot(&snapshot)) {
+    OP_REQUIRES(ctx, dtype_ == snapshot.dtype(),
+                errors::InvalidArgument(
+                    "Trying to read variable with wrong dtype. Expected ",
+                    DataTypeString(dtype_), " got ",
+                    DataTypeString(snapshot.dtype())));
+    ctx->set_output(0, snapshot);
+    return;
+  }
+
   tf_shared_lock ml(*variable->mu());
   // We're acquiring a reference to the underlying buffer while
   // holding a shared lock to guarantee ordering of reads and
   // writes when in copy-on-write mode.
-  const Tensor* t = variable->tensor();
+  const Tensor* t = variable->tensor_keeping_snapshot();
   if (!variable->copy_on_read_mode.load()) {
     OP_REQUIRES(
         ctx, dtype_ == t->dtype(),
@@ -156,6 +167,7 @@ void ReadVariableOp::Compute(OpKernelContext* ctx) {
             "Trying to read variable with wrong dtype. Expected ",
             DataTypeString(dtype_), " got ", DataTypeString(t->dtype())));
     ctx->set_output(0, *t);
+    variable->PublishSnapshot();
   } else {
     OP_REQUIRES_OK(ctx, CopyVariable(0, ctx, t));
   }
@@ -194,21 +206,35 @@ void ReadVariablesOp::Compute(OpKernelContext* ctx) {
                   absl::StrJoin(uninitialized_vars, ", ")));
 
   for (size_t i = 0; i < dtypes_.size(); ++i) {
+    Tensor snapshot;
+    if (!variables[i]->copy_on_read_mode.load() &&
+        variables[i]->ReadSnapshot(&snapshot)) {
+      OP_REQUIRES(ctx, dtypes_[i] == snapshot.dtype(),
+                  errors::InvalidArgument(
+                      "Trying to read variable ", handles[i]->name(),
+                      " from Container: ", handles[i]->container(),
+                      " with wrong dtype. Expected ",
+                      DataTypeString(dtypes_[i]), " got ",
+                      DataTypeString(snapshot.dtype())));
+      ctx->set_output(i, snapshot);
+      continue;
+    }
     // We're acquiring a reference to the underlying buffer while
     // holding a shared lock to guarantee ordering of reads and
     // writes.
     tf_shared_lock ml(*variables[i]->mu());
-    OP_REQUIRES(ctx, dtypes_[i] == variables[i]->tensor()->dtype(),
+    const Tensor* t = variables[i]->tensor_keeping_snapshot();
+    OP_REQUIRES(ctx, dtypes_[i] == t->dtype(),
                 errors::InvalidArgument(
                     "Trying to read variable ", handles[i]->name(),
                     " from Container: ", handles[i]->container(),
                     " with wrong dtype. Expected ", DataTypeString(dtypes_[i]),
-                    " got ", DataTypeString(variables[i]->tensor()->dtype())));
+                    " got ", DataTypeString(t->dtype())));
     if (variables[i]->copy_on_read_mode.load()) {
-      OP_REQUIRES_OK(ctx, CopyVariable(i, ctx, variables[i]->tensor()));
+      OP_REQUIRES_OK(ctx, CopyVariable(i, ctx, t));
     } else {
-      const Tensor& t = *variables[i]->tensor();
-      ctx->set_output(i, t);
+      ctx->set_output(i, *t);
+      variables[i]->PublishSnapshot();
     }
   }
 }
@@ -397,6 +423,8 @@ class AssignVariableOp : public OpKernel {
                                   return Status::OK();
                                 }));
     mutex_lock ml(*variable->mu());
+    // The snapshot stays valid until the new value is published below.
+    Tensor* var_tensor = variable->tensor_keeping_snapshot();
     // (variable->tensor()->dtype() == DT_INVALID && !variable->is_initialized)
     // check below is to allow an XLA specific situation wherein update can
     // happen first by the AssignVariableOp,
@@ -405,38 +433,39 @@ class AssignVariableOp : public OpKernel {
     // 'fallback' path (which essentially invokes Tensorflow ops via
     // partitioned_call).
     OP_REQUIRES(context,
-                (variable->tensor()->dtype() == DT_INVALID &&
+                (var_tensor->dtype() == DT_INVALID &&
                  !variable->is_initialized) ||
-                    variable->tensor()->dtype() == dtype_,
+                    var_tensor->dtype() == dtype_,
                 errors::InvalidArgument(
                     "Trying to assign variable with wrong dtype. Expected ",
-                    DataTypeString(variable->tensor()->dtype()), " got ",
+                    DataTypeString(var_tensor->dtype()), " got ",
                     DataTypeString(dtype_)));
     if (validate_shape_) {
       OP_REQUIRES(
           context,
           (!variable->is_initialized ||
-           variable->tensor()->shape().IsSameSize(value.shape())),
+           var_tensor->shape().IsSameSize(value.shape())),
           errors::InvalidArgument(
               "Trying to assign to variable with tensor with wrong shape."
               " Expected ",
-              variable->tensor()->shape().DebugString(), " got ",
+              var_tensor->shape().DebugString(), " got ",
               value.shape().DebugString()));
     }
     if (variable->copy_on_read_mode.load()) {
       AllocatorAttributes attr;
       attr.set_gpu_compatible(true);
       attr.set_nic_compatible(true);
-      OP_REQUIRES_OK(context,
-                     context->allocate_temp(value.dtype(), value.shape(),
-                                            variable->tensor(), attr));
+      OP_REQUIRES_OK(context, context->allocate_temp(value.dtype(),
+                                                     value.shape(), var_tensor,
+                                                     attr));
       functor::DenseUpdate<Device, T, ASSIGN> copy_functor;
-      copy_functor(context->eigen_device<Device>(),
-                   variable->tensor()->flat<T>(), value.flat<T>());
+      copy_functor(context->eigen_device<Device>(), var_tensor->flat<T>(),
+                   value.flat<T>());
     } else {
-      *variable->tensor() = value;
+      *var_tensor = value;
     }
     variable->is_initialized = true;
+    variable->PublishSnapshot();
   }
 
  private:
@@ -559,7 +588,7 @@ class AssignUpdateVariableOp : public OpKernel {
     // PrepareToUpdateVariable() for commutative operations like Op ==
     // ADD if value's refcount was 1.
     mutex_lock ml(*variable->mu());
-    Tensor* var_tensor = variable->tensor();
+    Tensor* var_tensor = variable->tensor_keeping_snapshot();
     OP_REQUIRES(context, var_tensor->shape().IsSameSize(value.shape()),
                 errors::InvalidArgument("Cannot update variable with shape ",
                                         var_tensor->shape().DebugString(),
@@ -572,6 +601,7 @@ class AssignUpdateVariableOp : public OpKernel {
     functor::DenseUpdate<Device, T, Op> update_functor;
     update_functor(context->eigen_device<Device>(), var_tensor->flat<T>(),
                    value.flat<T>());
+    variable->PublishSnapshot();
   }
 };
 
@@ -899,85 +929,9 @@ bool ValidateInput<Variant>(const Tensor& updates) {
   return true;
 }
 
-template <typename Device, typename T, typename Index, scatter_op::UpdateOp op>
-Status DoScatter(OpKernelContext* c, Tensor* params, const Tensor& indices,
-                 const Tensor& updates, Index num_indices);
-
-#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
-
-template <typename T>
-Status CopyTensorToHost(OpKernelContext* c, const Tensor& device_tensor,
-                        Tensor* host_tensor) {
-  AllocatorAttributes alloc_attr;
-  alloc_attr.set_on_host(true);
-  alloc_attr.set_gpu_compatible(true);
-  auto stream = c->op_device_context()->stream();
-  TF_RETURN_IF_ERROR(c->allocate_temp(
-      device_tensor.dtype(), device_tensor.shape(), host_tensor, alloc_attr));
-  se::DeviceMemoryBase device_ptr(
-      const_cast<Tensor&>(device_tensor).flat<T>().data(),
-      device_tensor.flat<T>().size() * sizeof(T));
-  stream->ThenMemcpy(host_tensor->flat<T>().data(), device_ptr,
-                     device_tensor.NumElements() * sizeof(T));
-  if (!stream) {
-    return errors::Internal("Failed to copy indices to host");
-  }
-  return Status::OK();
-}
-
-// Copies inputs to the CPU, runs DoScatter on the CPU, then copies output
-// back to GPU. This is useful because the CPU implementation is deterministic
-// and the GPU implementation is not. Tensor inputs to this function must be on
-// the GPU.
-template <typename T, typename Index, scatter_op::UpdateOp Op>
-Status DoScatterOnCpu(OpKernelContext* c, Tensor* params, const Tensor& indices,
-                      const Tensor& updates, Index num_indices) {
-  auto stream = c->op_device_context()->stream();
-
-  Tensor host_indices;
-  TF_RETURN_IF_ERROR(CopyTensorToHost<Index>(c, indices, &host_indices));
-  Tensor host_updates;
-  TF_RETURN_IF_ERROR(CopyTensorToHost<T>(c, updates, &host_updates));
-  Tensor host_params;
-  TF_RETURN_IF_ERROR(CopyTensorToHost<T>(c, *params, &host_params));
-
-  TF_RETURN_IF_ERROR(stream->BlockHostUntilDone());
-  TF_RETURN_IF_ERROR(DoScatter<CPUDevice, T, Index, Op>(
-      c, &host_params, host_indices, host_updates, num_indices));
-
-  // Copy 'host_params' to device.
-  se::DeviceMemoryBase params_ptr(params->flat<T>().data(),
-                                  params->flat<T>().size() * sizeof(T));
-  stream->ThenMemcpy(&params_ptr, host_params.flat<T>().data(),
-                     host_params.NumElements() * sizeof(T));
-  if (!stream) {
-    return errors::Internal("Failed to copy params to device");
-  }
-  // Deallocate host_params' buffer once the host-to-device copy is complete.
-  // host_params is captured by value in the lambda so that its buffer is only
-  // destructed once the lambda is destructed.
-  c->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
-      stream, [host_params] {});
-  return Status::OK();
-}
-
-#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
-
 template <typename Device, typename T, typename Index, scatter_op::UpdateOp op>
 Status DoScatter(OpKernelContext* c, Tensor* params, const Tensor& indices,
                  const Tensor& updates, Index num_indices) {
-#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
-  if (std::is_same<Device, GPUDevice>::value &&
-      tensorflow::OpDeterminismRequired()) {
-    if (!DataTypeCanUseMemcpy(params->dtype())) {
-      return errors::Unimplemented(
-          "GPU Scatter ops for dtype ", DataTypeString(params->dtype()),
-          " do not yet have a deterministic implementation");
-    }
-    return DoScatterOnCpu<T, Index, op>(c, params, indices, updates,
-                                        num_indices);
-  }
-#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
   auto indices_flat = indices.flat<Index>();
   auto params_flat = params->flat_outer_dims<T>();
   int64_t num_updates = updates.NumElements();
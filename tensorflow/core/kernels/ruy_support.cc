@@ -0,0 +1,142 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/ruy_support.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#include "ruy/context.h"
+#include "ruy/matrix.h"
+#include "ruy/mul_params.h"
+#include "ruy/path.h"
+#include "ruy/ruy.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace ruy_support {
+namespace {
+
+std::atomic<bool>& Enabled() {
+  static std::atomic<bool>* enabled = [] {
+    bool value = true;
+    Status status =
+        ReadBoolFromEnvVar("TF_USE_RUY_QUANTIZED_GEMM", true, &value);
+    if (!status.ok()) {
+      LOG(ERROR) << status.error_message();
+    }
+    return new std::atomic<bool>(value);
+  }();
+  return *enabled;
+}
+
+bool IsSupported() {
+  static const bool supported = [] {
+    ruy::Context context;
+    return (context.get_runtime_enabled_paths() & ~ruy::Path::kStandardCpp) !=
+           ruy::Path::kNone;
+  }();
+  return supported;
+}
+
+// Every thread runs its own blocks of the multiplication, so a single
+// threaded ruy context per thread avoids both locking and a second thread
+// pool next to the TensorFlow one.
+ruy::Context* GetThreadLocalContext() {
+  static thread_local ruy::Context* context = [] {
+    ruy::Context* context = new ruy::Context;
+    context->set_max_num_threads(1);
+    return context;
+  }();
+  return context;
+}
+
+void MakeMatrix(const quint8* data, int rows, int cols, bool col_major,
+                int stride, int zero_point, ruy::Matrix<std::uint8_t>* matrix) {
+  ruy::MakeSimpleLayout(rows, cols,
+                        col_major ? ruy::Order::kColMajor
+                                  : ruy::Order::kRowMajor,
+                        matrix->mutable_layout());
+  matrix->mutable_layout()->set_stride(stride);
+  matrix->set_data(&data->value);
+  matrix->set_zero_point(static_cast<std::uint8_t>(zero_point));
+}
+
+}  // namespace
+
+void SetEnabled(bool enabled) { Enabled().store(enabled); }
+
+bool IsSupportedAndEnabled() { return Enabled().load() && IsSupported(); }
+
+bool IsValidZeroPoint(int zero_point) {
+  return zero_point >= 0 && zero_point <= 255;
+}
+
+void QuantizedGemm(OpKernelContext* context, bool transpose_a, bool transpose_b,
+                   const quint8* a_data, const quint8* b_data, qint32* c_data,
+                   int m, int n, int k, int zero_point_a, int zero_point_b,
+                   int lda, int ldb, int ldc) {
+  DCHECK(IsValidZeroPoint(zero_point_a));
+  DCHECK(IsValidZeroPoint(zero_point_b));
+  if (k == 0) {
+    for (int i = 0; i < m; ++i) {
+      std::fill_n(c_data + i * ldc, n, qint32(0));
+    }
+    return;
+  }
+  // The output is split into blocks of rows, or of columns when it is wider
+  // than it is tall, and each block is a smaller multiplication of its own.
+  const bool split_rows = m >= n;
+  auto multiply_block = [&](int64_t begin, int64_t end) {
+    const int block_size = static_cast<int>(end - begin);
+    const int block_m = split_rows ? block_size : m;
+    const int block_n = split_rows ? n : block_size;
+    const quint8* block_a = a_data;
+    const quint8* block_b = b_data;
+    qint32* block_c = c_data;
+    if (split_rows) {
+      block_a += transpose_a ? begin : begin * lda;
+      block_c += begin * ldc;
+    } else {
+      block_b += transpose_b ? begin * ldb : begin;
+      block_c += begin;
+    }
+    ruy::Matrix<std::uint8_t> lhs;
+    MakeMatrix(block_a, block_m, k, transpose_a, lda, zero_point_a, &lhs);
+    ruy::Matrix<std::uint8_t> rhs;
+    MakeMatrix(block_b, k, block_n, transpose_b, ldb, zero_point_b, &rhs);
+    ruy::Matrix<std::int32_t> dst;
+    ruy::MakeSimpleLayout(block_m, block_n, ruy::Order::kRowMajor,
+                          dst.mutable_layout());
+    dst.mutable_layout()->set_stride(ldc);
+    dst.set_data(&block_c->value);
+    // With int32 destinations ruy stores the raw accumulators.
+    ruy::MulParams<std::int32_t, std::int32_t> mul_params;
+    ruy::Mul(lhs, rhs, mul_params, GetThreadLocalContext(), &dst);
+  };
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *(context->device()->tensorflow_cpu_worker_threads());
+  const int64_t cost_per_unit =
+      static_cast<int64_t>(split_rows ? n : m) * k;
+  Shard(worker_threads.num_threads, worker_threads.workers, split_rows ? m : n,
+        cost_per_unit, multiply_block);
+}
+
+}  // namespace ruy_support
+}  // namespace tensorflow
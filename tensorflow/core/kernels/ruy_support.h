@@ -0,0 +1,63 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_RUY_SUPPORT_H_
+#define TENSORFLOW_CORE_KERNELS_RUY_SUPPORT_H_
+
+#include "tensorflow/core/framework/numeric_types.h"
+
+namespace tensorflow {
+
+class OpKernelContext;
+
+namespace ruy_support {
+
+// Ruy is a matrix multiplication library that picks the fastest of its
+// kernels for the CPU it runs on at runtime (AVX2 and AVX-512 on x86, NEON on
+// Arm), so the quantized ops get an optimized eight-bit GEMM without having
+// to be built with MKL.
+
+// Toggles the codepath. Enabled by default (true), unless the environment
+// variable TF_USE_RUY_QUANTIZED_GEMM is set to false.
+void SetEnabled(bool enabled);
+
+// Returns true if ruy has an optimized kernel for the current CPU and the
+// codepath is enabled. Use this call before calling QuantizedGemm.
+bool IsSupportedAndEnabled();
+
+// Returns true if `zero_point` can be used as the zero point of a quint8
+// operand of QuantizedGemm, i.e. if it is in [0, 255].
+bool IsValidZeroPoint(int zero_point);
+
+// Calculate the quantized matrix multiplication:
+//
+// for (i, j) in [0, m) x [0, n) do
+//   c_data[i, j] :=
+//     sum((a_data[i, l] - zero_point_a) * (b_data[l, j] - zero_point_b)) :
+//       l in [0, k)
+//
+// If transpose_a is false the lhs operand has row major layout, otherwise
+// column major. Similarly transpose_b describes the layout of the rhs operand.
+// lda, ldb, and ldc are the strides of the lhs operand, rhs operand and the
+// result arrays. The work is split over the worker threads of `context`.
+void QuantizedGemm(OpKernelContext* context, bool transpose_a, bool transpose_b,
+                   const quint8* a_data, const quint8* b_data, qint32* c_data,
+                   int m, int n, int k, int zero_point_a, int zero_point_b,
+                   int lda, int ldb, int ldc);
+
+}  // namespace ruy_support
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_RUY_SUPPORT_H_
@@ -15,6 +15,7 @@ limitations under the License.
 
 // See docs in ../ops/io_ops.cc.
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
@@ -85,12 +87,27 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// Returns the options of the BundleWriter of SaveV2.  By default, the tensors
+// are written to a single data file by the calling thread.
+BundleWriter::Options SaveV2WriterOptions() {
+  int64_t num_shards, num_threads;
+  TF_CHECK_OK(
+      ReadInt64FromEnvVar("TF_SAVE_V2_NUM_DATA_SHARDS", 1, &num_shards));
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_SAVE_V2_NUM_WRITER_THREADS", 0,
+                                  &num_threads));
+  BundleWriter::Options options;
+  options.num_shards = std::max<int64_t>(num_shards, 1);
+  options.num_threads = std::max<int64_t>(num_threads, 0);
+  return options;
+}
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
 class SaveV2 : public OpKernel {
  public:
-  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit SaveV2(OpKernelConstruction* context)
+      : OpKernel(context), writer_options_(SaveV2WriterOptions()) {}
 
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
@@ -106,7 +123,7 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<tstring>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
+    BundleWriter writer(Env::Default(), prefix_string, writer_options_);
     OP_REQUIRES_OK(context, writer.status());
     VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
 
@@ -158,6 +175,9 @@ class SaveV2 : public OpKernel {
     OP_REQUIRES_OK(context, writer.Finish());
     VLOG(1) << "Done BundleWriter, prefix_string: " << prefix_string;
   }
+
+ private:
+  const BundleWriter::Options writer_options_;
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_SCATTER_FUNCTOR_H_
 #define TENSORFLOW_CORE_KERNELS_SCATTER_FUNCTOR_H_
 
+#include <algorithm>
 #include <type_traits>
+#include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -26,7 +28,6 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/kernels/dense_update_functor.h"
 #include "tensorflow/core/platform/types.h"
-#include "tensorflow/core/util/determinism.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -123,6 +124,70 @@ struct Assign<scatter_op::UpdateOp::MAX> {
   }
 };
 
+// Returns true if `num_updates` updates are worth applying in parallel with
+// ParallelScatterByRows().
+inline bool ShouldScatterInParallel(OpKernelContext* c, int64_t num_updates) {
+  const int64_t kMinParallelUpdates = 1024;
+  return num_updates >= kMinParallelUpdates &&
+         c->device()->tensorflow_cpu_worker_threads()->num_threads > 1;
+}
+
+// Calls `apply(i, index)` for each update i in [0, N), with `index` the
+// validated value of indices(i), in parallel on the CPU worker threads.
+//
+// The rows of params, [0, limit), are split into contiguous ranges and the
+// updates are bucketed by range with a stable counting sort. Each range is
+// then updated by a single thread, in the order of the updates, so no locks
+// are needed and the result, duplicate indices included, is the same as the
+// one of a serial loop for any number of threads.
+//
+// Returns the position of the first out of range index, in which case no
+// update is applied, or -1.
+template <typename Index, typename ApplyFn>
+Index ParallelScatterByRows(OpKernelContext* c,
+                            typename TTypes<Index>::ConstFlat indices,
+                            Index limit, float cost_per_update,
+                            ApplyFn apply) {
+  const int64_t N = indices.size();
+  if (N == 0 || limit == 0) return N == 0 ? -1 : 0;
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *(c->device()->tensorflow_cpu_worker_threads());
+  // A few ranges per thread balance the load of skewed indices.
+  const int64_t kRangesPerThread = 4;
+  const int64_t num_ranges = std::min<int64_t>(
+      limit, kRangesPerThread * worker_threads.num_threads);
+  const int64_t rows_per_range = (limit + num_ranges - 1) / num_ranges;
+
+  // Grab each index once and check its validity, so that it cannot change
+  // between being checked and being used.
+  std::vector<Index> row(N);
+  std::vector<int64_t> range_begin(num_ranges + 1, 0);
+  for (int64_t i = 0; i < N; ++i) {
+    const Index index = ::tensorflow::internal::SubtleMustCopy(indices(i));
+    if (!FastBoundsCheck(index, limit)) return i;
+    row[i] = index;
+    ++range_begin[index / rows_per_range + 1];
+  }
+  for (int64_t r = 1; r <= num_ranges; ++r) {
+    range_begin[r] += range_begin[r - 1];
+  }
+  std::vector<Index> order(N);
+  {
+    std::vector<int64_t> next(range_begin.begin(), range_begin.end() - 1);
+    for (int64_t i = 0; i < N; ++i) {
+      order[next[row[i] / rows_per_range]++] = i;
+    }
+  }
+
+  auto scatter_ranges = [&](int64_t begin, int64_t end) {
+    for (int64_t j = range_begin[begin]; j < range_begin[end]; ++j) {
+      apply(order[j], row[order[j]]);
+    }
+  };
+  Shard(worker_threads.num_threads, worker_threads.workers, num_ranges,
+        cost_per_update * N / num_ranges, scatter_ranges);
+  return -1;
+}
 
 }  // namespace internal
 }  // namespace scatter_op
@@ -142,42 +207,14 @@ struct ScatterFunctorBase {
                         typename TTypes<T>::Matrix params,
                         typename TTypes<T>::ConstMatrix updates,
                         typename TTypes<Index>::ConstFlat indices) {
-    const Index N = static_cast<Index>(indices.size());
-    const Index limit = static_cast<Index>(params.dimension(0));
-    const Index kMaxLocks = 1024;
-    const Index entries_per_lock = (limit + kMaxLocks - 1) / kMaxLocks;
-    // To reduce the number of locks and the memory usage, we divide the whole
-    // index space into kMaxLocks regions with each lock serializing access to
-    // a region.
-    mutex accessed[kMaxLocks];
-    std::atomic<Index> bad_index(-1);
-    auto ParallelScatter = [&](Index start, Index end) {
-      for (Index i = start; i < end; ++i) {
-        // Grab the index and check its validity.  Do this carefully,
-        // to avoid checking the value and grabbing it again from
-        // memory a second time (a security risk since it may change in
-        // between).
-        const Index index = ::tensorflow::internal::SubtleMustCopy(indices(i));
-        if (!FastBoundsCheck(index, limit)) {
-          bad_index = i;
-          return;
-        }
-        const Index lock_id = index / entries_per_lock;
-        // Copy last Ndim-1 dimensions of updates[i] to params[index]
-        {
-          mutex_lock l(accessed[lock_id]);
+    const float kMovingCost = 2.5f;
+    return scatter_op::internal::ParallelScatterByRows<Index>(
+        c, indices, static_cast<Index>(params.dimension(0)),
+        kMovingCost * params.dimension(1), [&](Index i, Index index) {
+          // Copy last Ndim-1 dimensions of updates[i] to params[index]
           scatter_op::internal::Assign<op>::Run(params.template chip<0>(index),
                                                 updates.template chip<0>(i));
-        }
-      }
-    };
-    const float kMovingCost = 2.5f;
-    float shard_cost = kMovingCost * params.dimension(1);
-    const DeviceBase::CpuWorkerThreads& worker_threads =
-        *(c->device()->tensorflow_cpu_worker_threads());
-    Shard(worker_threads.num_threads, worker_threads.workers, N, shard_cost,
-          ParallelScatter);  // TODO: Come up with a good cost estimate.
-    return bad_index;
+        });
   }
   Index SerialExecute(OpKernelContext* c, const Device& d,
                       typename TTypes<T>::Matrix params,
@@ -203,32 +240,11 @@ struct ScatterFunctorBase {
                    typename TTypes<T>::Matrix params,
                    typename TTypes<T>::ConstMatrix updates,
                    typename TTypes<Index>::ConstFlat indices) {
-#ifdef PLATFORM_GOOGLE
-    // The parallel version is significantly slower internally. Only call the
-    // serial version for now.
-    // TODO(penporn): Avoid locking in parallelization (sort beforehand).
-    return SerialExecute(c, d, params, updates, indices);
-#else
     // indices and params sizes were validated in DoCompute().
-    const Index N = static_cast<Index>(indices.size());
-    const Index limit = static_cast<Index>(params.dimension(0));
-    const Index min_n_threshold = 1024;
-    const Index ser_par_ratio = 10000;
-    // For parallelizing the updates, duplicate entries need to be handled
-    // correctly. Multiple updates to the same index has to be serialized.
-    // This can lead to lock contention which may nullify the benefits of
-    // parallelization. Assuming uniform random distribution of the indices, we
-    // come up with a rough heuristic and determine whether the updates execute
-    // serially or parallelly. Also if 'N' is small, overheads of parallel
-    // execution outweigh its benefits and hence we check the value of N.
-    const bool execute_serial = N < min_n_threshold ||
-                                (N / limit) > ser_par_ratio ||
-                                OpDeterminismRequired();
-    if (execute_serial)
-      return SerialExecute(c, d, params, updates, indices);
-    else
+    if (scatter_op::internal::ShouldScatterInParallel(c, indices.size()))
       return ParallelExecute(c, d, params, updates, indices);
-#endif  // PLATFORM_GOOGLE
+    else
+      return SerialExecute(c, d, params, updates, indices);
   }
 };
 
@@ -278,6 +294,17 @@ struct ScatterFunctorBase<CPUDevice, T, Index, scatter_op::UpdateOp::ASSIGN> {
     // indices and params sizes were validated in DoCompute().
     const Index N = static_cast<Index>(indices.size());
     const Index limit = static_cast<Index>(params.dimension(0));
+    if (!std::is_same<T, tstring>::value &&
+        scatter_op::internal::ShouldScatterInParallel(c, N)) {
+      const float kMovingCost = 1.0f;
+      return scatter_op::internal::ParallelScatterByRows<Index>(
+          c, indices, limit, kMovingCost * params.dimension(1),
+          [&](Index i, Index index) {
+            memmove(params.data() + index * params.dimension(1),
+                    updates.data() + i * updates.dimension(1),
+                    updates.dimension(1) * sizeof(T));
+          });
+    }
     if (!std::is_same<T, tstring>::value) {
       for (Index i = 0; i < N; i++) {
         // Grab the index and check its validity.  Do this carefully,
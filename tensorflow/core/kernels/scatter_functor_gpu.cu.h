@@ -20,9 +20,13 @@ limitations under the License.
 
 #define EIGEN_USE_GPU
 
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/gpu_prim_helpers.h"
 #include "tensorflow/core/kernels/scatter_functor.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/determinism.h"
 #include "tensorflow/core/util/gpu_kernel_helper.h"
 
 namespace tensorflow {
@@ -124,6 +128,123 @@ __global__ void ScatterScalarOpCustomKernel(T* __restrict__ params,
   }
 }
 
+// Non-atomic versions of ScatterOpKernelBody, for threads that own their
+// destination.
+template <typename T, scatter_op::UpdateOp op>
+struct SequentialScatterOpBody;
+
+template <typename T>
+struct SequentialScatterOpBody<T, scatter_op::UpdateOp::ASSIGN> {
+  __device__ void operator()(T* dest, T src) const { *dest = src; }
+};
+
+template <typename T>
+struct SequentialScatterOpBody<T, scatter_op::UpdateOp::ADD> {
+  __device__ void operator()(T* dest, T src) const { *dest = *dest + src; }
+};
+
+template <typename T>
+struct SequentialScatterOpBody<T, scatter_op::UpdateOp::SUB> {
+  __device__ void operator()(T* dest, T src) const { *dest = *dest - src; }
+};
+
+template <typename T>
+struct SequentialScatterOpBody<T, scatter_op::UpdateOp::MUL> {
+  __device__ void operator()(T* dest, T src) const { *dest = *dest * src; }
+};
+
+template <typename T>
+struct SequentialScatterOpBody<T, scatter_op::UpdateOp::DIV> {
+  __device__ void operator()(T* dest, T src) const { *dest = *dest / src; }
+};
+
+template <typename T>
+struct SequentialScatterOpBody<T, scatter_op::UpdateOp::MIN> {
+  __device__ void operator()(T* dest, T src) const {
+    if (src < *dest) *dest = src;
+  }
+};
+
+template <typename T>
+struct SequentialScatterOpBody<T, scatter_op::UpdateOp::MAX> {
+  __device__ void operator()(T* dest, T src) const {
+    if (src > *dest) *dest = src;
+  }
+};
+
+// Applies the updates of sorted_indices, which are stably sorted so that
+// update_order[i] is the position of sorted_indices[i] in the unsorted
+// indices. A single thread applies all the updates of a run of equal indices
+// to an element of params, in the order of the unsorted indices, so that the
+// result doesn't depend on the scheduling of threads.
+template <typename T, typename Index, scatter_op::UpdateOp op,
+          bool scalar_update>
+__global__ void SortedScatterOpKernel(T* __restrict__ params,
+                                      const T* __restrict__ updates,
+                                      const Index* __restrict__ sorted_indices,
+                                      const Index* __restrict__ update_order,
+                                      Index first_dim_size, Index update_block,
+                                      Index indices_size) {
+  SequentialScatterOpBody<T, op> body;
+  GPU_1D_KERNEL_LOOP(i, indices_size * update_block) {
+    const Index run_start = i / update_block;
+    const Index param_first_index = sorted_indices[run_start];
+    if (run_start > 0 && sorted_indices[run_start - 1] == param_first_index) {
+      // Applied by the thread of the first index of the run.
+      continue;
+    }
+    if (!(param_first_index >= 0 && param_first_index < first_dim_size)) {
+      // Ignore indices that are out of range.
+      continue;
+    }
+    const Index column = i % update_block;
+    T* dest = params + int64{param_first_index} * update_block + column;
+    T value = *dest;
+    for (Index j = run_start;
+         j < indices_size && sorted_indices[j] == param_first_index; ++j) {
+      body(&value,
+           scalar_update
+               ? ldg(updates)
+               : ldg(updates + int64{update_order[j]} * update_block + column));
+    }
+    *dest = value;
+  }
+}
+
+// Scatters deterministically by sorting the indices, which is used instead of
+// atomic updates when op determinism is required. The updates are the
+// [indices_size, update_block] matrix `updates`, or the single update
+// `updates` if scalar_update is true.
+template <typename T, typename Index, scatter_op::UpdateOp op,
+          bool scalar_update>
+Status DeterministicScatter(OpKernelContext* c, const GPUDevice& d, T* params,
+                            const T* updates, const Index* indices,
+                            Index first_dim_size, Index update_block,
+                            Index indices_size) {
+  if (indices_size == 0 || update_block == 0) return Status::OK();
+  Tensor sorted_indices;
+  TF_RETURN_IF_ERROR(c->allocate_temp(DataTypeToEnum<Index>::value,
+                                      TensorShape({indices_size}),
+                                      &sorted_indices));
+  Tensor update_order;
+  TF_RETURN_IF_ERROR(c->allocate_temp(DataTypeToEnum<Index>::value,
+                                      TensorShape({indices_size}),
+                                      &update_order));
+  // All bits are sorted, because out of range indices may be negative. The
+  // radix sort is stable, which keeps the updates of an index in order.
+  TF_RETURN_IF_ERROR(GpuRadixSort(
+      c, indices_size, /*keys_in=*/indices,
+      /*keys_out=*/sorted_indices.flat<Index>().data(),
+      /*indices_in=*/static_cast<const Index*>(nullptr),
+      /*indices_out=*/update_order.flat<Index>().data()));
+  GpuLaunchConfig config = GetGpuLaunchConfig(indices_size * update_block, d);
+  return GpuLaunchKernel(
+      SortedScatterOpKernel<T, Index, op, scalar_update>, config.block_count,
+      config.thread_per_block, 0, d.stream(), params, updates,
+      sorted_indices.flat<Index>().data(), update_order.flat<Index>().data(),
+      first_dim_size, update_block, indices_size);
+}
+
 }  // namespace scatter_op_gpu
 
 namespace functor {
@@ -140,6 +261,15 @@ struct ScatterFunctor<GPUDevice, T, Index, op> {
     const Index first_dim_size = params.dimension(0);
     const Index indices_size = indices.size();
     const Index updates_size = updates.size();
+    if (OpDeterminismRequired()) {
+      Status s = scatter_op_gpu::DeterministicScatter<T, Index, op,
+                                                      /*scalar_update=*/false>(
+          c, d, params.data(), updates.data(), indices.data(), first_dim_size,
+          /*update_block=*/indices_size ? updates_size / indices_size : 0,
+          indices_size);
+      if (!s.ok()) c->SetStatus(s);
+      return -1;
+    }
     GpuLaunchConfig config = GetGpuLaunchConfig(updates_size, d);
     TF_CHECK_OK(GpuLaunchKernel(
         scatter_op_gpu::ScatterOpCustomKernel<T, Index, op>, config.block_count,
@@ -161,6 +291,14 @@ struct ScatterScalarFunctor<GPUDevice, T, Index, op> {
     const Index first_dim_size = params.dimension(0);
     const Index indices_size = indices.size();
     const Index synthesized_updates_size = indices_size * params.dimension(1);
+    if (OpDeterminismRequired()) {
+      Status s = scatter_op_gpu::DeterministicScatter<T, Index, op,
+                                                      /*scalar_update=*/true>(
+          c, d, params.data(), update.data(), indices.data(), first_dim_size,
+          /*update_block=*/params.dimension(1), indices_size);
+      if (!s.ok()) c->SetStatus(s);
+      return -1;
+    }
     GpuLaunchConfig config = GetGpuLaunchConfig(synthesized_updates_size, d);
     TF_CHECK_OK(GpuLaunchKernel(
         scatter_op_gpu::ScatterScalarOpCustomKernel<T, Index, op>,
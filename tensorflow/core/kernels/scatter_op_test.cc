@@ -217,6 +217,77 @@ TEST_F(ScatterSubOpTest, StressIndexTest) {
   test::ExpectTensorEqual<int32>(expected, params_tensor);
 }
 
+TEST_F(ScatterSubOpTest, StressIndexTestManyRows) {
+  MakeOp(DT_INT32_REF, DT_INT32);
+  // Feed and run enough updates to be applied in parallel: each row is
+  // updated by a single thread, in the order of the updates.
+  const int kRows = 1000;
+  const int kNumUpdates = 100000;
+  std::vector<int32> values(kRows, 0);
+  std::vector<int32> indices(kNumUpdates);
+  std::vector<int32> updates(kNumUpdates);
+  std::vector<int32> expected_values(kRows, 0);
+  for (int i = 0; i < kNumUpdates; ++i) {
+    indices[i] = (i * 7919) % kRows;
+    updates[i] = i % 13;
+    expected_values[indices[i]] -= updates[i];
+  }
+  AddInputFromArray<int32>(TensorShape({kRows}), values);
+  AddInputFromArray<int32>(TensorShape({kNumUpdates}), indices);
+  AddInputFromArray<int32>(TensorShape({kNumUpdates}), updates);
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor params_tensor = *mutable_input(0).tensor;
+  Tensor expected(allocator(), DT_INT32, TensorShape({kRows}));
+  test::FillValues<int32>(&expected, expected_values);
+  test::ExpectTensorEqual<int32>(expected, params_tensor);
+}
+
+TEST_F(ScatterSubOpTest, Error_IndexOutOfRangeManyUpdates) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+  // Feed and run
+  const int kNumUpdates = 4096;
+  std::vector<int32> indices(kNumUpdates, 1);
+  indices[1000] = 99;
+  indices[2000] = -1;
+  AddInputFromArray<float>(TensorShape({14}),
+                           {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+  AddInputFromArray<int32>(TensorShape({kNumUpdates}), indices);
+  AddInputFromArray<float>(TensorShape({kNumUpdates}),
+                           std::vector<float>(kNumUpdates, 1));
+  Status s = RunOpKernel();
+  EXPECT_TRUE(
+      absl::StrContains(s.ToString(), "indices[1000] = 99 is not in [0, 14)"))
+      << s;
+}
+
+TEST_F(ScatterUpdateOpTest, LastDuplicateUpdateWins) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+
+  // Feed and run enough updates to be applied in parallel.
+  const int kRows = 10;
+  const int kNumUpdates = 4096;
+  std::vector<int32> indices(kNumUpdates);
+  std::vector<float> updates(2 * kNumUpdates);
+  std::vector<float> expected_values(2 * kRows, 0);
+  for (int i = 0; i < kNumUpdates; ++i) {
+    indices[i] = (i * 3) % kRows;
+    updates[2 * i] = i;
+    updates[2 * i + 1] = -i;
+    expected_values[2 * indices[i]] = i;
+    expected_values[2 * indices[i] + 1] = -i;
+  }
+  AddInputFromArray<float>(TensorShape({kRows, 2}),
+                           std::vector<float>(2 * kRows, 0));
+  AddInputFromArray<int32>(TensorShape({kNumUpdates}), indices);
+  AddInputFromArray<float>(TensorShape({kNumUpdates, 2}), updates);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor params_tensor = *mutable_input(0).tensor;
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows, 2}));
+  test::FillValues<float>(&expected, expected_values);
+  test::ExpectTensorEqual<float>(expected, params_tensor);
+}
+
 TEST_F(ScatterUpdateOpTest, Error_WrongDimsIndices) {
   MakeOp(DT_FLOAT_REF, DT_INT32);
 
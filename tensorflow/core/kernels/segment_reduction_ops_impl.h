@@ -23,6 +23,7 @@ limitations under the License.
 #define EIGEN_USE_GPU
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#include <algorithm>
 #include <vector>
 
 #include "third_party/eigen3/Eigen/Core"
@@ -38,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/util/determinism.h"
 #include "tensorflow/core/util/util.h"
 
@@ -544,6 +546,8 @@ class SparseSegmentReductionOpBase : public OpKernel {
     // Index from which the output is not initialized.
     SegmentId uninitialized_index = 0;
     SegmentId out_index = internal::SubtleMustCopy(segment_vec(start));
+    // Index up to which the rows of the input have been prefetched.
+    int64_t prefetched = 0;
 
     while (true) {
       // We initialize next_index to 0 to avoid "warning: 'next_index' may be
@@ -577,6 +581,13 @@ class SparseSegmentReductionOpBase : public OpKernel {
         gap_slice.setConstant(default_value_);
       }
 
+      // Brings the rows of the next segments into the cache while this one is
+      // reduced.
+      const int64_t prefetch_end =
+          std::min<int64_t>(num_indices, end + kNumPrefetchedRows);
+      PrefetchRows(input_flat, indices_vec, prefetched, prefetch_end);
+      prefetched = std::max(prefetched, prefetch_end);
+
       auto out = output_flat.template chip<0>(out_index);
       auto temp = temp_flat.template chip<0>(out_index);
       const int bad_offset = Reduce<T, Index>(input_flat, indices_vec, start,
@@ -605,6 +616,29 @@ class SparseSegmentReductionOpBase : public OpKernel {
   }
 
  private:
+  // Number of rows gathered ahead of the reduced ones and number of bytes
+  // prefetched per row. The hardware prefetcher streams the rest of longer
+  // rows once their first cache lines are loaded.
+  static constexpr int64_t kNumPrefetchedRows = 16;
+  static constexpr int64_t kMaxPrefetchedRowBytes = 512;
+
+  // Prefetches the rows of `input_flat` at indices_vec(i) for i in
+  // [begin, end). The indices are read again, and checked, when reducing.
+  void PrefetchRows(const typename TTypes<T>::ConstMatrix& input_flat,
+                    const typename TTypes<Index>::ConstVec& indices_vec,
+                    int64_t begin, int64_t end) {
+    const int64_t row_bytes = std::min<int64_t>(
+        input_flat.dimension(1) * sizeof(T), kMaxPrefetchedRowBytes);
+    for (int64_t i = begin; i < end; ++i) {
+      const Index index = indices_vec(i);
+      if (!FastBoundsCheck(index, input_flat.dimension(0))) continue;
+      const char* row = reinterpret_cast<const char*>(&input_flat(index, 0));
+      for (int64_t offset = 0; offset < row_bytes; offset += 64) {
+        port::prefetch<port::PREFETCH_HINT_T0>(row + offset);
+      }
+    }
+  }
+
   template <typename Tin>
   using EnableIfBfloat16OrHalf =
       typename std::enable_if<std::is_same<Tin, bfloat16>::value ||
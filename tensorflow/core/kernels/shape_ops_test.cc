@@ -59,5 +59,75 @@ static void BM_ExpandDims(::testing::benchmark::State& state) {
 
 BENCHMARK(BM_ExpandDims)->UseRealTime();
 
+// Shape and Size produce, and Reshape takes, small int32 tensors whose
+// buffers are embedded in the tensor rather than allocated.
+static void BM_Shape(::testing::benchmark::State& state) {
+  Graph* g = new Graph(OpRegistry::Global());
+
+  Tensor input(DT_FLOAT, TensorShape({2, 3, 4, 5}));
+  input.flat<float>().setZero();
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Shape")
+                  .Input(test::graph::Constant(g, input))
+                  .Attr("T", DT_FLOAT)
+                  .Attr("out_type", DT_INT32)
+                  .Finalize(g, &node));
+  FixupSourceAndSinkEdges(g);
+
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr,
+                  "SINGLE_THREADED_EXECUTOR", /*old_benchmark_api*/ false)
+      .Run(state);
+}
+
+BENCHMARK(BM_Shape)->UseRealTime();
+
+static void BM_Size(::testing::benchmark::State& state) {
+  Graph* g = new Graph(OpRegistry::Global());
+
+  Tensor input(DT_FLOAT, TensorShape({2, 3, 4, 5}));
+  input.flat<float>().setZero();
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Size")
+                  .Input(test::graph::Constant(g, input))
+                  .Attr("T", DT_FLOAT)
+                  .Attr("out_type", DT_INT32)
+                  .Finalize(g, &node));
+  FixupSourceAndSinkEdges(g);
+
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr,
+                  "SINGLE_THREADED_EXECUTOR", /*old_benchmark_api*/ false)
+      .Run(state);
+}
+
+BENCHMARK(BM_Size)->UseRealTime();
+
+static void BM_Reshape(::testing::benchmark::State& state) {
+  Graph* g = new Graph(OpRegistry::Global());
+
+  Tensor input(DT_FLOAT, TensorShape({2, 3, 4, 5}));
+  input.flat<float>().setZero();
+
+  Tensor shape(DT_INT32, TensorShape({2}));
+  shape.flat<int32>()(0) = 6;
+  shape.flat<int32>()(1) = -1;
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Reshape")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, shape))
+                  .Attr("T", DT_FLOAT)
+                  .Attr("Tshape", DT_INT32)
+                  .Finalize(g, &node));
+  FixupSourceAndSinkEdges(g);
+
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr,
+                  "SINGLE_THREADED_EXECUTOR", /*old_benchmark_api*/ false)
+      .Run(state);
+}
+
+BENCHMARK(BM_Reshape)->UseRealTime();
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,300 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_SHARDED_HASH_MAP_H_
+#define TENSORFLOW_CORE_KERNELS_SHARDED_HASH_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// A thread safe hash map from K to V, split into shards which are each an
+// absl::flat_hash_map behind its own reader-writer lock, so that concurrent
+// lookups and updates of different keys rarely contend.
+//
+// The map is accessed in batches: keys are given by a `key_fn(i)` callback
+// for i in [0, n). A batch is hashed first and grouped by shard, then each
+// shard is locked once for all of its keys, whose slots are prefetched
+// before being probed so that their cache misses overlap.
+//
+// Operations on a single shard are atomic. Batched lookups, inserts and
+// removals are not atomic across shards, while Assign() and Export() lock
+// all the shards and are.
+template <class K, class V>
+class ShardedHashMap {
+ public:
+  static constexpr int kDefaultNumShards = 16;
+
+  // Number of keys hashed and grouped by shard at a time.
+  static constexpr int kBatchSize = 64;
+
+  // `num_shards` is rounded up to a power of 2.
+  explicit ShardedHashMap(int num_shards = kDefaultNumShards) {
+    CHECK_GT(num_shards, 0);
+    while ((1 << shard_bits_) < num_shards) {
+      ++shard_bits_;
+    }
+    shards_.reset(new Shard[this->num_shards()]);
+  }
+
+  int num_shards() const { return 1 << shard_bits_; }
+
+  size_t size() const {
+    size_t size = 0;
+    for (int s = 0; s < num_shards(); ++s) {
+      tf_shared_lock l(shards_[s].mu);
+      size += shards_[s].map.size();
+    }
+    return size;
+  }
+
+  // Number of slots of the underlying hash maps.
+  size_t bucket_count() const {
+    size_t bucket_count = 0;
+    for (int s = 0; s < num_shards(); ++s) {
+      tf_shared_lock l(shards_[s].mu);
+      bucket_count += shards_[s].map.bucket_count();
+    }
+    return bucket_count;
+  }
+
+  // Looks up the keys `key_fn(i)` for i in [0, n), and calls
+  // `found_fn(i, value)` for the keys in the map and `missing_fn(i)` for the
+  // others, in no particular order. The callbacks run with a shard lock held
+  // and must not access the map.
+  template <typename KeyFn, typename FoundFn, typename MissingFn>
+  void FindBatch(int64_t n, KeyFn key_fn, FoundFn found_fn,
+                 MissingFn missing_fn) const {
+    Batch batch(num_shards());
+    for (int64_t start = 0; start < n; start += kBatchSize) {
+      GroupByShard(start, std::min<int64_t>(n, start + kBatchSize), key_fn,
+                   &batch);
+      for (int s = 0; s < num_shards(); ++s) {
+        const int begin = batch.shard_begin[s];
+        const int end = batch.shard_begin[s + 1];
+        if (begin == end) continue;
+        const Shard& shard = shards_[s];
+        tf_shared_lock l(shard.mu);
+        for (int j = begin; j < end; ++j) {
+          shard.map.prefetch(batch.keys[j]);
+        }
+        for (int j = begin; j < end; ++j) {
+          auto it = shard.map.find(batch.keys[j], batch.hashes[j]);
+          if (it == shard.map.end()) {
+            missing_fn(batch.indices[j]);
+          } else {
+            found_fn(batch.indices[j], it->second);
+          }
+        }
+      }
+    }
+  }
+
+  // Maps the keys `key_fn(i)` to the values `value_fn(i)` for i in [0, n),
+  // replacing the values of the keys already in the map. If a key appears
+  // several times, the last value wins.
+  template <typename KeyFn, typename ValueFn>
+  void InsertBatch(int64_t n, KeyFn key_fn, ValueFn value_fn) {
+    Batch batch(num_shards());
+    for (int64_t start = 0; start < n; start += kBatchSize) {
+      GroupByShard(start, std::min<int64_t>(n, start + kBatchSize), key_fn,
+                   &batch);
+      for (int s = 0; s < num_shards(); ++s) {
+        const int begin = batch.shard_begin[s];
+        const int end = batch.shard_begin[s + 1];
+        if (begin == end) continue;
+        Shard& shard = shards_[s];
+        mutex_lock l(shard.mu);
+        for (int j = begin; j < end; ++j) {
+          shard.map.prefetch(batch.keys[j]);
+        }
+        for (int j = begin; j < end; ++j) {
+          shard.map.insert_or_assign(std::move(batch.keys[j]),
+                                     value_fn(batch.indices[j]));
+        }
+      }
+    }
+  }
+
+  // Removes the keys `key_fn(i)` for i in [0, n) from the map.
+  template <typename KeyFn>
+  void RemoveBatch(int64_t n, KeyFn key_fn) {
+    Batch batch(num_shards());
+    for (int64_t start = 0; start < n; start += kBatchSize) {
+      GroupByShard(start, std::min<int64_t>(n, start + kBatchSize), key_fn,
+                   &batch);
+      for (int s = 0; s < num_shards(); ++s) {
+        const int begin = batch.shard_begin[s];
+        const int end = batch.shard_begin[s + 1];
+        if (begin == end) continue;
+        Shard& shard = shards_[s];
+        mutex_lock l(shard.mu);
+        for (int j = begin; j < end; ++j) {
+          shard.map.erase(batch.keys[j]);
+        }
+      }
+    }
+  }
+
+  // Atomically replaces the contents of the map with the keys `key_fn(i)`
+  // mapped to the values `value_fn(i)` for i in [0, n).
+  template <typename KeyFn, typename ValueFn>
+  void Assign(int64_t n, KeyFn key_fn, ValueFn value_fn) {
+    LockAll();
+    for (int s = 0; s < num_shards(); ++s) {
+      shards_[s].map.clear();
+    }
+    for (int64_t i = 0; i < n; ++i) {
+      auto key = key_fn(i);
+      const size_t hash = hasher_(key);
+      shards_[ShardOf(hash)].map.insert_or_assign(std::move(key),
+                                                  value_fn(i));
+    }
+    UnlockAll();
+  }
+
+  // Atomically exports the contents of the map: calls `allocate_fn(size)`
+  // with the number of entries, then, if it returns OK,
+  // `visit_fn(i, key, value)` for each entry with i in [0, size).
+  template <typename AllocateFn, typename VisitFn>
+  Status Export(AllocateFn allocate_fn, VisitFn visit_fn) const {
+    LockAllShared();
+    int64_t size = 0;
+    for (int s = 0; s < num_shards(); ++s) {
+      size += shards_[s].map.size();
+    }
+    Status status = allocate_fn(size);
+    if (status.ok()) {
+      int64_t i = 0;
+      for (int s = 0; s < num_shards(); ++s) {
+        for (const auto& entry : shards_[s].map) {
+          visit_fn(i++, entry.first, entry.second);
+        }
+      }
+    }
+    UnlockAllShared();
+    return status;
+  }
+
+ private:
+  struct Shard {
+    mutable mutex mu;
+    absl::flat_hash_map<K, V> map TF_GUARDED_BY(mu);
+    // Keeps the locks of neighbouring shards on different cache lines.
+    char padding[64];
+  };
+
+  // The keys of a batch, their hashes and their index in the batch, sorted
+  // by shard. The keys of shard s are in [shard_begin[s], shard_begin[s+1]).
+  struct Batch {
+    explicit Batch(int num_shards)
+        : keys(kBatchSize),
+          hashes(kBatchSize),
+          indices(kBatchSize),
+          unsorted_keys(kBatchSize),
+          unsorted_hashes(kBatchSize),
+          shard_begin(num_shards + 1) {}
+
+    std::vector<K> keys;
+    std::vector<size_t> hashes;
+    std::vector<int64_t> indices;
+    std::vector<K> unsorted_keys;
+    std::vector<size_t> unsorted_hashes;
+    std::vector<int> shard_begin;
+  };
+
+  // Reads and hashes the keys in [start, end), and sorts them by shard into
+  // `batch`. Each key is read once, so that it cannot change between being
+  // hashed and being probed.
+  template <typename KeyFn>
+  void GroupByShard(int64_t start, int64_t end, KeyFn key_fn,
+                    Batch* batch) const {
+    const int count = end - start;
+    std::fill(batch->shard_begin.begin(), batch->shard_begin.end(), 0);
+    for (int j = 0; j < count; ++j) {
+      batch->unsorted_keys[j] = key_fn(start + j);
+      batch->unsorted_hashes[j] = hasher_(batch->unsorted_keys[j]);
+      ++batch->shard_begin[ShardOf(batch->unsorted_hashes[j])];
+    }
+    // After the prefix sum, shard_begin[s] is the end of shard s. Filling the
+    // shards from their end moves it to their beginning.
+    for (int s = 1; s <= num_shards(); ++s) {
+      batch->shard_begin[s] += batch->shard_begin[s - 1];
+    }
+    for (int j = count - 1; j >= 0; --j) {
+      const size_t hash = batch->unsorted_hashes[j];
+      const int pos = --batch->shard_begin[ShardOf(hash)];
+      batch->keys[pos] = std::move(batch->unsorted_keys[j]);
+      batch->hashes[pos] = hash;
+      batch->indices[pos] = start + j;
+    }
+  }
+
+  // The top bits of the hash pick the shard: the hash maps probe their slots
+  // with the bottom bits.
+  int ShardOf(size_t hash) const {
+    if (shard_bits_ == 0) return 0;
+    return hash >> (std::numeric_limits<size_t>::digits - shard_bits_);
+  }
+
+  void LockAll() TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (int s = 0; s < num_shards(); ++s) {
+      shards_[s].mu.lock();
+    }
+  }
+
+  void UnlockAll() TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (int s = num_shards() - 1; s >= 0; --s) {
+      shards_[s].mu.unlock();
+    }
+  }
+
+  void LockAllShared() const TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (int s = 0; s < num_shards(); ++s) {
+      shards_[s].mu.lock_shared();
+    }
+  }
+
+  void UnlockAllShared() const TF_NO_THREAD_SAFETY_ANALYSIS {
+    for (int s = num_shards() - 1; s >= 0; --s) {
+      shards_[s].mu.unlock_shared();
+    }
+  }
+
+  int shard_bits_ = 0;
+  std::unique_ptr<Shard[]> shards_;
+  typename absl::flat_hash_map<K, V>::hasher hasher_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardedHashMap);
+};
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_SHARDED_HASH_MAP_H_
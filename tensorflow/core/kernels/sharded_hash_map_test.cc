@@ -0,0 +1,242 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/sharded_hash_map.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+// Looks up `keys`, returning `default_value` for the missing ones.
+template <class K, class V>
+std::vector<V> Find(const ShardedHashMap<K, V>& map, const std::vector<K>& keys,
+                    const V& default_value) {
+  std::vector<V> values(keys.size());
+  map.FindBatch(
+      keys.size(), [&](int64_t i) { return keys[i]; },
+      [&](int64_t i, const V& value) { values[i] = value; },
+      [&](int64_t i) { values[i] = default_value; });
+  return values;
+}
+
+template <class K, class V>
+std::vector<std::pair<K, V>> Export(const ShardedHashMap<K, V>& map) {
+  std::vector<std::pair<K, V>> entries;
+  TF_CHECK_OK(map.Export(
+      [&](int64_t size) {
+        entries.resize(size);
+        return Status::OK();
+      },
+      [&](int64_t i, const K& key, const V& value) {
+        entries[i] = {key, value};
+      }));
+  std::sort(entries.begin(), entries.end());
+  return entries;
+}
+
+TEST(ShardedHashMapTest, NumShardsIsRoundedUpToPowerOfTwo) {
+  EXPECT_EQ(ShardedHashMap<int64_t, int64_t>(1).num_shards(), 1);
+  EXPECT_EQ(ShardedHashMap<int64_t, int64_t>(5).num_shards(), 8);
+  EXPECT_EQ(ShardedHashMap<int64_t, int64_t>(16).num_shards(), 16);
+}
+
+TEST(ShardedHashMapTest, InsertFindRemove) {
+  for (int num_shards : {1, 3, 16}) {
+    ShardedHashMap<int64_t, int64_t> map(num_shards);
+    std::vector<int64_t> keys;
+    for (int64_t i = 0; i < 1000; ++i) {
+      keys.push_back(i * 7);
+    }
+    map.InsertBatch(
+        keys.size(), [&](int64_t i) { return keys[i]; },
+        [&](int64_t i) { return keys[i] + 1; });
+    EXPECT_EQ(map.size(), keys.size());
+    EXPECT_GE(map.bucket_count(), keys.size());
+
+    std::vector<int64_t> lookups = {0, 1, 7, 6993, 7000};
+    EXPECT_EQ(Find(map, lookups, int64_t{-1}),
+              std::vector<int64_t>({1, -1, 8, 6994, -1}));
+
+    map.RemoveBatch(2, [](int64_t i) { return i * 7; });
+    EXPECT_EQ(map.size(), keys.size() - 2);
+    EXPECT_EQ(Find(map, lookups, int64_t{-1}),
+              std::vector<int64_t>({-1, -1, -1, 6994, -1}));
+  }
+}
+
+TEST(ShardedHashMapTest, LastValueOfDuplicateKeysWins) {
+  ShardedHashMap<int64_t, int64_t> map;
+  const std::vector<int64_t> keys = {3, 5, 3, 3, 5};
+  map.InsertBatch(
+      keys.size(), [&](int64_t i) { return keys[i]; },
+      [](int64_t i) { return i; });
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(Find(map, {3, 5}, int64_t{-1}), std::vector<int64_t>({3, 4}));
+}
+
+TEST(ShardedHashMapTest, AssignAndExport) {
+  ShardedHashMap<tstring, int32> map;
+  map.InsertBatch(
+      100, [](int64_t i) { return tstring(strings::StrCat("old", i)); },
+      [](int64_t i) { return static_cast<int32>(i); });
+  map.Assign(
+      3, [](int64_t i) { return tstring(strings::StrCat("key", i)); },
+      [](int64_t i) { return static_cast<int32>(10 * i); });
+  EXPECT_EQ(map.size(), 3);
+  std::vector<std::pair<tstring, int32>> expected = {
+      {"key0", 0}, {"key1", 10}, {"key2", 20}};
+  EXPECT_EQ(Export(map), expected);
+  EXPECT_EQ(Find(map, {"old0", "key1"}, -1), std::vector<int32>({-1, 10}));
+}
+
+TEST(ShardedHashMapTest, ExportStopsOnAllocationError) {
+  ShardedHashMap<int64_t, int64_t> map;
+  map.InsertBatch(
+      10, [](int64_t i) { return i; }, [](int64_t i) { return i; });
+  int64_t visited = 0;
+  Status status = map.Export(
+      [](int64_t size) { return errors::ResourceExhausted("Too large"); },
+      [&](int64_t i, int64_t key, int64_t value) { ++visited; });
+  EXPECT_TRUE(errors::IsResourceExhausted(status));
+  EXPECT_EQ(visited, 0);
+}
+
+TEST(ShardedHashMapTest, ConcurrentInsertsAndLookups) {
+  constexpr int kNumThreads = 8;
+  constexpr int64_t kKeysPerThread = 10000;
+  ShardedHashMap<int64_t, int64_t> map;
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&map, t]() {
+        const int64_t offset = t * kKeysPerThread;
+        for (int64_t start = 0; start < kKeysPerThread; start += 100) {
+          map.InsertBatch(
+              100, [&](int64_t i) { return offset + start + i; },
+              [&](int64_t i) { return -(offset + start + i); });
+          // The keys a thread inserted are visible to it.
+          int64_t found = 0;
+          map.FindBatch(
+              start + 100, [&](int64_t i) { return offset + i; },
+              [&](int64_t i, int64_t value) {
+                found += value == -(offset + i);
+              },
+              [](int64_t i) {});
+          CHECK_EQ(found, start + 100);
+        }
+      });
+    }
+  }
+  EXPECT_EQ(map.size(), kNumThreads * kKeysPerThread);
+}
+
+constexpr int64_t kBenchmarkMapSize = 1 << 20;
+constexpr int64_t kBenchmarkBatchSize = 256;
+
+// The maps shared by the threads of a benchmark, by number of shards.
+ShardedHashMap<int64_t, int64_t>* BenchmarkMap(int num_shards) {
+  static mutex mu(LINKER_INITIALIZED);
+  static auto* maps = new std::map<int, ShardedHashMap<int64_t, int64_t>*>;
+  mutex_lock l(mu);
+  auto*& map = (*maps)[num_shards];
+  if (map == nullptr) {
+    map = new ShardedHashMap<int64_t, int64_t>(num_shards);
+    map->InsertBatch(
+        kBenchmarkMapSize, [](int64_t i) { return i * 997; },
+        [](int64_t i) { return i; });
+  }
+  return map;
+}
+
+// Looks up batches of random keys, half of which are in the map, from
+// several threads. The single-shard map is the baseline: a table behind a
+// single lock.
+void BM_FindBatch(::testing::benchmark::State& state) {
+  const int num_shards = state.range(0);
+  const ShardedHashMap<int64_t, int64_t>& map = *BenchmarkMap(num_shards);
+  random::PhiloxRandom philox(random::New64(), random::New64());
+  random::SimplePhilox rnd(&philox);
+  std::vector<int64_t> keys(kBenchmarkBatchSize);
+  int64_t found = 0;
+  for (auto s : state) {
+    for (int64_t& key : keys) {
+      key = rnd.Uniform64(2 * kBenchmarkMapSize) * 997;
+    }
+    map.FindBatch(
+        keys.size(), [&](int64_t i) { return keys[i]; },
+        [&](int64_t i, int64_t value) { found += value; },
+        [](int64_t i) {});
+  }
+  testing::DoNotOptimize(found);
+  state.SetItemsProcessed(state.iterations() * kBenchmarkBatchSize);
+}
+BENCHMARK(BM_FindBatch)
+    ->Arg(1)
+    ->Arg(ShardedHashMap<int64_t, int64_t>::kDefaultNumShards)
+    ->ThreadRange(1, 32);
+
+// Updates batches of random keys while other threads look keys up.
+void BM_InsertBatch(::testing::benchmark::State& state) {
+  const int num_shards = state.range(0);
+  ShardedHashMap<int64_t, int64_t>& map = *BenchmarkMap(num_shards);
+  random::PhiloxRandom philox(random::New64(), random::New64());
+  random::SimplePhilox rnd(&philox);
+  std::vector<int64_t> keys(kBenchmarkBatchSize);
+  // One thread out of four is a writer.
+  static std::atomic<int64_t> num_threads(0);
+  const bool is_writer = num_threads.fetch_add(1) % 4 == 0;
+  int64_t found = 0;
+  for (auto s : state) {
+    for (int64_t& key : keys) {
+      key = rnd.Uniform64(kBenchmarkMapSize) * 997;
+    }
+    if (is_writer) {
+      map.InsertBatch(
+          keys.size(), [&](int64_t i) { return keys[i]; },
+          [&](int64_t i) { return keys[i] / 997; });
+    } else {
+      map.FindBatch(
+          keys.size(), [&](int64_t i) { return keys[i]; },
+          [&](int64_t i, int64_t value) { found += value; },
+          [](int64_t i) {});
+    }
+  }
+  testing::DoNotOptimize(found);
+  state.SetItemsProcessed(state.iterations() * kBenchmarkBatchSize);
+}
+BENCHMARK(BM_InsertBatch)
+    ->Arg(1)
+    ->Arg(ShardedHashMap<int64_t, int64_t>::kDefaultNumShards)
+    ->ThreadRange(1, 32);
+
+}  // namespace
+}  // namespace lookup
+}  // namespace tensorflow
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/softmax_op_cpu_impl.h"
 #include "tensorflow/core/kernels/softmax_op_functor.h"
 
 namespace tensorflow {
@@ -30,18 +31,17 @@ namespace tensorflow {
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
-// Partial specialization for a CPUDevice, that uses the Eigen implementation
-// from SoftmaxEigenImpl.
+// Partial specialization for a CPUDevice, that normalizes the rows in parallel
+// with SoftmaxRowsCpu.
 namespace functor {
-template <typename Device, typename T>
-struct SoftmaxFunctorBase {
-  void operator()(const Device& d, typename TTypes<T>::ConstMatrix logits,
+template <typename T>
+struct SoftmaxFunctor<CPUDevice, T> {
+  void operator()(const CPUDevice& d, typename TTypes<T>::ConstMatrix logits,
                   typename TTypes<T>::Matrix softmax, const bool log) {
-    SoftmaxEigenImpl<Device, T>::Compute(d, logits, softmax, log);
+    SoftmaxRowsCpu<T>(d, logits, /*scale=*/1.0f, /*mask=*/nullptr, log,
+                      softmax);
   }
 };
-template <typename T>
-struct SoftmaxFunctor<CPUDevice, T> : SoftmaxFunctorBase<CPUDevice, T> {};
 
 }  // namespace functor
 
@@ -0,0 +1,187 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_SOFTMAX_OP_CPU_IMPL_H_
+#define TENSORFLOW_CORE_KERNELS_SOFTMAX_OP_CPU_IMPL_H_
+// CPU implementation of Softmax and LogSoftmax shared by SoftmaxOp and the
+// fused softmax ops. Requires EIGEN_USE_THREADS.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+
+namespace tensorflow {
+namespace functor {
+
+// An additive mask of the logits, broadcast along some of their dimensions.
+template <typename T>
+struct SoftmaxMask {
+  // Describes `mask`, which must be broadcastable to `logits_shape` without
+  // broadcasting the logits.
+  SoftmaxMask(const Tensor& mask, const TensorShape& logits_shape)
+      : data(mask.flat<T>().data()) {
+    const int rank = logits_shape.dims();
+    gtl::InlinedVector<int64_t, 8> strides(rank, 0);
+    int64_t stride = 1;
+    for (int i = 1; i <= mask.dims(); ++i) {
+      const int64_t dim = mask.dim_size(mask.dims() - i);
+      if (dim != 1) strides[rank - i] = stride;
+      stride *= dim;
+    }
+    for (int i = 0; i < rank - 1; ++i) {
+      outer_dims.push_back(logits_shape.dim_size(i));
+    }
+    outer_strides.assign(strides.begin(), strides.end() - 1);
+    class_stride = strides[rank - 1];
+  }
+
+  // Returns the offset of the mask of row `row` of the logits.
+  int64_t RowOffset(int64_t row) const {
+    int64_t offset = 0;
+    for (int i = static_cast<int>(outer_dims.size()) - 1; i >= 0 && row > 0;
+         --i) {
+      offset += (row % outer_dims[i]) * outer_strides[i];
+      row /= outer_dims[i];
+    }
+    return offset;
+  }
+
+  const T* data;
+  // The outer dimensions of the logits, and the strides of the mask along
+  // them and along the classes, which are 0 where the mask is broadcast.
+  gtl::InlinedVector<int64_t, 8> outer_dims;
+  gtl::InlinedVector<int64_t, 8> outer_strides;
+  int64_t class_stride;
+};
+
+// Computes Softmax(logits * scale + mask), or its log if `log` is true, along
+// the classes. `mask` may be nullptr, and `softmax` may alias `logits`.
+//
+// Every row is normalized with the online softmax: a single pass over the
+// logits keeps a running maximum and the sum of the exponentials rescaled to
+// it, one chunk at a time, and writes the exponentials of every chunk
+// relative to the running maximum of the time. A last pass over the output,
+// which is still in cache for the rows of attention scores, rescales every
+// chunk to the final maximum and sum. So the logits are read once, the
+// masked logits are never materialized, and the exponentials are computed
+// once with the vectorized Eigen exp. LogSoftmax reads the logits twice
+// instead. The rows are split over the threads of `d`. Half and bfloat16 are
+// computed in float.
+template <typename T>
+void SoftmaxRowsCpu(const Eigen::ThreadPoolDevice& d,
+                    typename TTypes<T>::ConstMatrix logits, const float scale,
+                    const SoftmaxMask<T>* mask, const bool log,
+                    typename TTypes<T>::Matrix softmax) {
+  using U = typename std::conditional<std::is_same<T, Eigen::half>::value ||
+                                          std::is_same<T, bfloat16>::value,
+                                      float, T>::type;
+  using Chunk = Eigen::Array<U, Eigen::Dynamic, 1>;
+  using ConstRow = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+  using Row = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+  constexpr Eigen::Index kChunkSize = 256;
+  constexpr U kInfinity = std::numeric_limits<U>::infinity();
+
+  const Eigen::Index num_rows = logits.dimension(0);
+  const Eigen::Index num_classes = logits.dimension(1);
+  const Eigen::Index num_chunks = (num_classes + kChunkSize - 1) / kChunkSize;
+  const U scale_u = static_cast<U>(scale);
+
+  const auto compute_rows = [&](Eigen::Index first, Eigen::Index last) {
+    U buffer[kChunkSize];
+    gtl::InlinedVector<U, 16> chunk_max(num_chunks);
+    for (Eigen::Index row = first; row < last; ++row) {
+      const T* row_logits = &logits(row, 0);
+      const T* row_mask =
+          mask == nullptr ? nullptr : mask->data + mask->RowOffset(row);
+      T* row_softmax = &softmax(row, 0);
+      // Loads the masked logits of the classes [begin, begin + size).
+      const auto load = [&](Eigen::Index begin, Eigen::Index size) {
+        Eigen::Map<Chunk> chunk(buffer, size);
+        chunk = ConstRow(row_logits + begin, size).template cast<U>();
+        if (scale_u != U(1)) chunk *= scale_u;
+        if (row_mask == nullptr) return chunk;
+        if (mask->class_stride == 0) {
+          chunk += static_cast<U>(*row_mask);
+        } else {
+          chunk += ConstRow(row_mask + begin, size).template cast<U>();
+        }
+        return chunk;
+      };
+
+      U max = -kInfinity;
+      U sum = 0;
+      for (Eigen::Index c = 0; c < num_chunks; ++c) {
+        const Eigen::Index begin = c * kChunkSize;
+        const Eigen::Index size = std::min(kChunkSize, num_classes - begin);
+        Eigen::Map<Chunk> chunk = load(begin, size);
+        const U max_of_chunk = chunk.maxCoeff();
+        if (max_of_chunk > max) {
+          sum *= std::exp(max - max_of_chunk);
+          max = max_of_chunk;
+        }
+        chunk_max[c] = max;
+        // Rows of -inf are left to the last pass, which makes them NaN as
+        // SoftmaxEigenImpl does, and leading chunks of -inf are 0.
+        if (max == -kInfinity) {
+          if (!log) Row(row_softmax + begin, size).setZero();
+          continue;
+        }
+        if (log) {
+          sum += (chunk - max).exp().sum();
+        } else {
+          chunk = (chunk - max).exp();
+          sum += chunk.sum();
+          Row(row_softmax + begin, size) = chunk.template cast<T>();
+        }
+      }
+
+      const U log_sum = std::log(sum);
+      for (Eigen::Index c = 0; c < num_chunks; ++c) {
+        const Eigen::Index begin = c * kChunkSize;
+        const Eigen::Index size = std::min(kChunkSize, num_classes - begin);
+        Row output(row_softmax + begin, size);
+        if (log) {
+          output = ((load(begin, size) - max) - log_sum).template cast<T>();
+        } else if (max == -kInfinity) {
+          output.setConstant(static_cast<T>(std::nan("")));
+        } else {
+          const U factor = std::exp(chunk_max[c] - max) / sum;
+          output = (output.template cast<U>() * factor).template cast<T>();
+        }
+      }
+    }
+  };
+
+  const double exp_cycles =
+      Eigen::internal::functor_traits<Eigen::internal::scalar_exp_op<U>>::Cost;
+  const Eigen::TensorOpCost cost(
+      /*bytes_loaded=*/(mask == nullptr ? 2 : 3) * num_classes * sizeof(T),
+      /*bytes_stored=*/2 * num_classes * sizeof(T),
+      /*compute_cycles=*/num_classes * (exp_cycles + 6));
+  d.parallelFor(num_rows, cost, compute_rows);
+}
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_SOFTMAX_OP_CPU_IMPL_H_
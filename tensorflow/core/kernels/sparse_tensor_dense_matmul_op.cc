@@ -19,11 +19,16 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -264,10 +269,6 @@ Status SparseTensorDenseMatMulImpl(
   const int lhs_index_a = ADJ_A ? 1 : 0;
   const int rhs_index_a = ADJ_A ? 0 : 1;
 
-  // TODO(ebrevdo): After many failed experiments, can't find a multi-threaded
-  // approach that achieves the performance of the single threaded
-  // one.  Perhaps Eigen threadpool implementation is just too slow?
-
   if (rhs_right < kNumVectorize) {
     // Disable vectorization if the RHS of output is too small
     auto maybe_adjoint_b = MaybeAdjoint<decltype(b), ADJ_B>(b);
@@ -321,6 +322,135 @@ Status SparseTensorDenseMatMulImpl(
   }
   return Status::OK();
 }
+
+// Returns true if the product is worth computing on several threads.
+bool ShouldMatMulInParallel(OpKernelContext* ctx, std::size_t nnz,
+                            std::size_t rhs_right, int64_t out_rows) {
+  static constexpr std::size_t kMinParallelMultiplyAdds = 1 << 16;
+  return out_rows > 1 && nnz * rhs_right >= kMinParallelMultiplyAdds &&
+         ctx->device()->tensorflow_cpu_worker_threads()->num_threads > 1;
+}
+
+// Computes the same product as SparseTensorDenseMatMulImpl on the CPU worker
+// threads. The rows of `out` are split into contiguous ranges, and the
+// nonzeros of `a` are copied, grouped by range with a stable counting sort,
+// so that each range of rows is accumulated by a single thread, in the order
+// of the nonzeros. The result is the same as the single threaded one.
+template <typename T, typename Tsum, typename Tindices, bool ADJ_A, bool ADJ_B>
+Status ParallelSparseTensorDenseMatMulImpl(
+    OpKernelContext* ctx, typename TTypes<Tsum>::Matrix out,
+    typename TTypes<Tindices>::ConstMatrix a_indices,
+    typename TTypes<T>::ConstVec a_values, typename TTypes<T>::ConstMatrix b) {
+  const std::size_t nnz = a_values.size();
+  const std::size_t rhs_right = (ADJ_B ? b.dimension(0) : b.dimension(1));
+  const std::size_t lhs_right = (ADJ_B ? b.dimension(1) : b.dimension(0));
+  const int lhs_index_a = ADJ_A ? 1 : 0;
+  const int rhs_index_a = ADJ_A ? 0 : 1;
+  const int64_t out_rows = out.dimension(0);
+
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *(ctx->device()->tensorflow_cpu_worker_threads());
+  // A few ranges per thread balance the load of skewed rows.
+  static constexpr int64_t kRangesPerThread = 4;
+  const int64_t num_ranges = std::min<int64_t>(
+      out_rows, kRangesPerThread * worker_threads.num_threads);
+  const int64_t rows_per_range = (out_rows + num_ranges - 1) / num_ranges;
+
+  // Check the indices in the order of the single threaded implementation, so
+  // that the same error is reported, and count the nonzeros of each range.
+  std::vector<Tindices> rows(nnz);
+  std::vector<Tindices> cols(nnz);
+  std::vector<int64_t> range_begin(num_ranges + 1, 0);
+  for (std::size_t i = 0; i < nnz; ++i) {
+    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+    if (!FastBoundsCheck(k, lhs_right)) {
+      return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
+    }
+    if (!FastBoundsCheck(m, out_rows)) {
+      return MOutOfBoundsError(m, i, lhs_index_a, out_rows);
+    }
+    rows[i] = m;
+    cols[i] = k;
+    ++range_begin[m / rows_per_range + 1];
+  }
+  for (int64_t r = 1; r <= num_ranges; ++r) {
+    range_begin[r] += range_begin[r - 1];
+  }
+
+  // The nonzeros grouped by range, with the indices that were checked.
+  Tensor sorted_indices_t;
+  Tensor sorted_values_t;
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(
+      DataTypeToEnum<Tindices>::value,
+      TensorShape({static_cast<int64_t>(nnz), 2}), &sorted_indices_t));
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(
+      DataTypeToEnum<T>::value, TensorShape({static_cast<int64_t>(nnz)}),
+      &sorted_values_t));
+  auto sorted_indices = sorted_indices_t.matrix<Tindices>();
+  auto sorted_values = sorted_values_t.vec<T>();
+  {
+    std::vector<int64_t> next(range_begin.begin(), range_begin.end() - 1);
+    for (std::size_t i = 0; i < nnz; ++i) {
+      const int64_t j = next[rows[i] / rows_per_range]++;
+      sorted_indices(j, lhs_index_a) = rows[i];
+      sorted_indices(j, rhs_index_a) = cols[i];
+      sorted_values(j) = a_values(i);
+    }
+  }
+
+  // Take the adjoint of B once rather than in each range.
+  Tensor b_adjoint_t;
+  if (ADJ_B) {
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DataTypeToEnum<T>::value,
+        TensorShape({b.dimension(1), b.dimension(0)}), &b_adjoint_t));
+    Eigen::array<int, 2> shuffle(1, 0);
+    b_adjoint_t.matrix<T>().device(ctx->eigen_device<CPUDevice>()) =
+        b.shuffle(shuffle).conjugate();
+  }
+  const typename TTypes<T>::ConstMatrix b_adjoint =
+      ADJ_B ? static_cast<const Tensor&>(b_adjoint_t).matrix<T>() : b;
+
+  mutex mu;
+  Status status;
+  auto multiply_ranges = [&](int64_t begin, int64_t end) {
+    const int64_t first = range_begin[begin];
+    const int64_t num_nonzeros = range_begin[end] - first;
+    if (num_nonzeros == 0) return;
+    typename TTypes<Tindices>::ConstMatrix range_indices(
+        &sorted_indices(first, 0), num_nonzeros, 2);
+    typename TTypes<T>::ConstVec range_values(&sorted_values(first),
+                                              num_nonzeros);
+    Status range_status =
+        SparseTensorDenseMatMulImpl<T, Tsum, Tindices, ADJ_A, false>(
+            out, range_indices, range_values, b_adjoint);
+    if (!range_status.ok()) {
+      mutex_lock l(mu);
+      status.Update(range_status);
+    }
+  };
+  const int64_t cost_per_range = 2 * (nnz / num_ranges + 1) * rhs_right;
+  Shard(worker_threads.num_threads, worker_threads.workers, num_ranges,
+        cost_per_range, multiply_ranges);
+  return status;
+}
+
+template <typename T, typename Tsum, typename Tindices, bool ADJ_A, bool ADJ_B>
+Status SparseTensorDenseMatMulOnCpu(
+    OpKernelContext* ctx, typename TTypes<Tsum>::Matrix out,
+    typename TTypes<Tindices>::ConstMatrix a_indices,
+    typename TTypes<T>::ConstVec a_values, typename TTypes<T>::ConstMatrix b) {
+  const std::size_t rhs_right = (ADJ_B ? b.dimension(0) : b.dimension(1));
+  if (ShouldMatMulInParallel(ctx, a_values.size(), rhs_right,
+                             out.dimension(0))) {
+    return ParallelSparseTensorDenseMatMulImpl<T, Tsum, Tindices, ADJ_A,
+                                               ADJ_B>(ctx, out, a_indices,
+                                                      a_values, b);
+  }
+  return SparseTensorDenseMatMulImpl<T, Tsum, Tindices, ADJ_A, ADJ_B>(
+      out, a_indices, a_values, b);
+}
 }  // namespace
 
 template <typename T, typename Tindices, bool ADJ_A, bool ADJ_B>
@@ -338,8 +468,8 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
       auto temp_out = temp_out_t.matrix<Tsum>();
       temp_out.setZero();
       TF_RETURN_IF_ERROR(
-          SparseTensorDenseMatMulImpl<T, Tsum, Tindices, ADJ_A, ADJ_B>(
-              temp_out, a_indices, a_values, b));
+          SparseTensorDenseMatMulOnCpu<T, Tsum, Tindices, ADJ_A, ADJ_B>(
+              ctx, temp_out, a_indices, a_values, b));
       out = temp_out.template cast<T>();
     } else {
       out.setZero();
@@ -348,8 +478,8 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
       auto out_workaround =
           *reinterpret_cast<typename TTypes<Tsum>::Matrix*>(&out);
       TF_RETURN_IF_ERROR(
-          SparseTensorDenseMatMulImpl<T, Tsum, Tindices, ADJ_A, ADJ_B>(
-              out_workaround, a_indices, a_values, b));
+          SparseTensorDenseMatMulOnCpu<T, Tsum, Tindices, ADJ_A, ADJ_B>(
+              ctx, out_workaround, a_indices, a_values, b));
     }
     return Status::OK();
   }
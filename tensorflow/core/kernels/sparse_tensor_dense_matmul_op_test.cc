@@ -120,4 +120,11 @@ BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, false, true);
 BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, true, false);
 BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, true, true);
 
+// Wide and deep shapes: a batch of multi-hot rows of a large vocabulary.
+BM_SparseTensorDenseMatmul(65536, 512, 65536, 64, false, false);
+BM_SparseTensorDenseMatmul(65536, 512, 65536, 64, true, false);
+BM_SparseTensorDenseMatmul(65536, 512, 65536, 64, false, true);
+BM_SparseTensorDenseMatmul(262144, 2048, 65536, 16, false, false);
+BM_SparseTensorDenseMatmul(262144, 2048, 65536, 128, false, false);
+
 }  // end namespace tensorflow
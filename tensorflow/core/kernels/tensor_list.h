@@ -62,6 +62,11 @@ namespace tensorflow {
 //       }
 //     }
 //
+// Kernels that cannot alias their input list copy it instead, which is linear
+// in its length. These copies are counted per op type by the
+// /tensorflow/core/tensor_list_copies and
+// /tensorflow/core/tensor_list_copied_elements metrics.
+//
 class TensorList {
  public:
   TensorList() : tensors_(new Tensors) {}
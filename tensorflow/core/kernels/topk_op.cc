@@ -107,6 +107,48 @@ class TopK : public OpKernel {
   bool sorted_;
 };
 
+namespace internal {
+
+// Rows with fewer than this many columns per selected element are selected
+// with std::nth_element, whose cost does not grow with k, rather than by
+// pushing every column to a gtl::TopN heap.
+constexpr int64_t kMaxColsPerKForTopN = 8;
+
+// Rows split across threads are cut into chunks of at least this many columns.
+constexpr int64_t kMinColsPerChunk = 1 << 15;
+
+// Keeps the k first elements of `candidates` under `comp`, in no particular
+// order.
+template <typename Comp>
+void SelectTopK(int k, const Comp& comp, std::vector<int32>* candidates) {
+  if (candidates->size() <= static_cast<size_t>(k)) return;
+  std::nth_element(candidates->begin(), candidates->begin() + k - 1,
+                   candidates->end(), comp);
+  candidates->resize(k);
+}
+
+// Sets `top_k` to the k first columns of [begin, end) under `comp`, in no
+// particular order.
+template <typename Comp>
+void FindTopK(int k, int32_t begin, int32_t end, const Comp& comp,
+              std::vector<int32>* top_k) {
+  top_k->clear();
+  if (end - begin <= kMaxColsPerKForTopN * k) {
+    top_k->resize(end - begin);
+    std::iota(top_k->begin(), top_k->end(), begin);
+    SelectTopK(k, comp, top_k);
+    return;
+  }
+  gtl::TopN<int32, Comp> filter(k, comp);
+  filter.reserve(end - begin);
+  for (int32_t c = begin; c < end; ++c) {
+    filter.push(c);
+  }
+  top_k->assign(filter.unsorted_begin(), filter.unsorted_end());
+}
+
+}  // namespace internal
+
 namespace functor {
 
 template <typename T>
@@ -146,27 +188,39 @@ struct TopKFunctor<CPUDevice, T> {
       return Status::OK();
     }
 
+    const auto stable_comp_for = [](const T* input_data) {
+      return [input_data](const int32_t a, const int32_t b) {
+        if (input_data[b] < input_data[a]) {
+          return true;
+        } else if (input_data[b] > input_data[a]) {
+          return false;
+        } else {
+          return a < b;
+        }
+      };
+    };
+
+    // Writes the top k `top_k` of row b out, by decreasing value if `sorted`
+    // or else by increasing index, which keeps equal values in index order.
+    const auto write_row = [&](int64_t b, std::vector<int32>* top_k) {
+      if (sorted) {
+        std::sort(top_k->begin(), top_k->end(), stable_comp_for(&input(b, 0)));
+      } else {
+        std::sort(top_k->begin(), top_k->end());
+      }
+      std::copy(top_k->begin(), top_k->end(), &indices(b, 0));
+      std::transform(
+          &indices(b, 0), &indices(b, k), &values(b, 0),
+          [b, &input](const int32_t loc) { return input(b, loc); });
+    };
+
     auto SortIndices = [&](int64_t start_batch, int64_t limit_batch) {
+      std::vector<int32> top_k;
       for (int32_t b = start_batch; b < limit_batch; ++b) {
         const T* input_data = &input(b, 0);
-        const auto stable_comp = [input_data](const int32_t a,
-                                              const int32_t b) {
-          if (input_data[b] < input_data[a]) {
-            return true;
-          } else if (input_data[b] > input_data[a]) {
-            return false;
-          } else {
-            return a < b;
-          }
-        };
         const auto comp = [input_data](const int32_t a, const int32_t b) {
           return input_data[b] < input_data[a];
         };
-        // TODO(ebrevdo): For large k < num_cols, instead of using
-        // TopN, it may be faster to create a temporary vector of
-        // values 0..num_cols - 1 and then use std::partial_sort_copy
-        // of this into indices. Choosing the appropriate minimum k or
-        // ratio of k/num_cols will require some experimentation.
         if (k == num_cols) {
           auto* begin = &indices(b, 0);
           auto* end = &indices(b, k);
@@ -189,33 +243,16 @@ struct TopKFunctor<CPUDevice, T> {
             }
             run_begin = run_end;
           }
+          // Now that the indices are sorted, copy the values over in
+          // sorted order.
+          std::transform(
+              &indices(b, 0), &indices(b, k), &values(b, 0),
+              [b, &input](const int32_t loc) { return input(b, loc); });
         } else {
-          // Use the TopN heap object to sort.
-          gtl::TopN<int32, decltype(stable_comp)> filter(k, stable_comp);
-          filter.reserve(num_cols);
-          for (int32_t c = 0; c < num_cols; ++c) {
-            filter.push(c);
-          }
-
-          int32_t i = 0;
-          if (sorted) {
-            std::unique_ptr<std::vector<int32>> top_k(filter.Extract());
-            for (auto top_k_it = top_k->begin(); top_k_it != top_k->end();
-                 ++top_k_it, ++i) {
-              indices(b, i) = *top_k_it;
-            }
-          } else {
-            for (auto top_k_it = filter.unsorted_begin();
-                 top_k_it != filter.unsorted_end(); ++top_k_it, ++i) {
-              indices(b, i) = *top_k_it;
-            }
-          }
+          internal::FindTopK(k, 0, num_cols, stable_comp_for(input_data),
+                             &top_k);
+          write_row(b, &top_k);
         }
-        // Now that the indices are sorted, copy the values over in
-        // sorted order.
-        std::transform(
-            &indices(b, 0), &indices(b, k), &values(b, 0),
-            [b, &input](const int32_t loc) { return input(b, loc); });
       }  // for (int32 b = ...
     };
 
@@ -234,8 +271,55 @@ struct TopKFunctor<CPUDevice, T> {
                                    ? kint64max
                                    : static_cast<int64_t>(total_cost);
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+
+    // With fewer rows than threads, long rows are also split into chunks
+    // whose top k are found in parallel, then merged into the top k of the
+    // row. Each chunk is kept several times longer than k, so that the
+    // merge is cheap.
+    int64_t num_chunks = 1;
+    if (k < num_cols && num_rows < worker_threads.num_threads) {
+      const int64_t threads_per_row =
+          (worker_threads.num_threads + num_rows - 1) / num_rows;
+      num_chunks = std::min({threads_per_row,
+                             num_cols / internal::kMinColsPerChunk,
+                             num_cols / (4 * static_cast<int64_t>(k))});
+    }
+    if (num_chunks <= 1) {
+      Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+            final_cost, SortIndices);
+      return Status::OK();
+    }
+
+    std::vector<std::vector<int32>> candidates(num_rows * num_chunks);
+    auto FindChunksTopK = [&](int64_t start, int64_t limit) {
+      for (int64_t i = start; i < limit; ++i) {
+        const int64_t b = i / num_chunks;
+        const int64_t chunk = i % num_chunks;
+        internal::FindTopK(k, num_cols * chunk / num_chunks,
+                           num_cols * (chunk + 1) / num_chunks,
+                           stable_comp_for(&input(b, 0)), &candidates[i]);
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_rows * num_chunks, final_cost / num_chunks, FindChunksTopK);
+
+    auto MergeChunks = [&](int64_t start_batch, int64_t limit_batch) {
+      for (int64_t b = start_batch; b < limit_batch; ++b) {
+        std::vector<int32>& top_k = candidates[b * num_chunks];
+        for (int64_t chunk = 1; chunk < num_chunks; ++chunk) {
+          const std::vector<int32>& chunk_top_k =
+              candidates[b * num_chunks + chunk];
+          top_k.insert(top_k.end(), chunk_top_k.begin(), chunk_top_k.end());
+        }
+        internal::SelectTopK(k, stable_comp_for(&input(b, 0)), &top_k);
+        write_row(b, &top_k);
+      }
+    };
+    const double merge_cost =
+        cmp_cost * k *
+        (num_chunks + Eigen::numext::log2(static_cast<float>(k + 1)));
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
-          final_cost, SortIndices);
+          static_cast<int64_t>(merge_cost), MergeChunks);
 
     return Status::OK();
   }
@@ -85,6 +85,14 @@ struct VariableInputLockHolder {
         shared_locks_(std::move(other.shared_locks_)) {}
 
   ~VariableInputLockHolder() {
+    // Dense updates hold exclusive locks, and leave the new values for
+    // snapshot reads to see.
+    if (locks_ != nullptr && !locks_->empty() &&
+        (shared_locks_ == nullptr || shared_locks_->empty())) {
+      for (Var* var : vars_) {
+        var->PublishSnapshot();
+      }
+    }
     // Release the locks before unreffing the Vars, because each lock
     // is potentially borrowed from a Var in vars_.
     locks_.reset();
@@ -243,9 +251,12 @@ Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
       *out = *var->tensor();
       return Status::OK();
     }
+    // The caller holds the lock through a VariableInputLockHolder, which
+    // publishes the updated value when it releases the lock.
+    Tensor* var_tensor = var->tensor_keeping_snapshot();
     TF_RETURN_IF_ERROR(PrepareToUpdateVariable<Device, T>(
-        ctx, var->tensor(), var->copy_on_read_mode.load()));
-    *out = *var->tensor();
+        ctx, var_tensor, var->copy_on_read_mode.load()));
+    *out = *var_tensor;
     return Status::OK();
   }
   *out = ctx->mutable_input(input, lock_held);
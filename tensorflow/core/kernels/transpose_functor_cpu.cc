@@ -16,6 +16,9 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include <complex>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -25,6 +28,12 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/platform.h"
+
+#if !defined(IS_MOBILE_PLATFORM)
+#include "tensorflow/compiler/xla/pjrt/transpose.h"
+#endif  // !defined(IS_MOBILE_PLATFORM)
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
@@ -68,12 +77,73 @@ void TransposeSimple(const CPUDevice& device, const Tensor& in,
   device.parallelFor(in.NumElements(), cost, std::move(transpose_fn));
 }
 
+#if !defined(IS_MOBILE_PLATFORM)
+
+// Tensors with fewer elements are transposed by Eigen, for which there is no
+// plan to build or look up.
+constexpr int64_t kMinTransposePlanElements = 1024;
+
+// The plans of the shapes and permutations transposed recently. A graph
+// usually transposes tensors of a few shapes, over and over.
+struct SharedTransposePlanCache {
+  static constexpr int kCapacity = 64;
+
+  SharedTransposePlanCache() : cache(kCapacity) {}
+
+  mutex mu;
+  xla::TransposePlanCache cache TF_GUARDED_BY(mu);
+};
+
+SharedTransposePlanCache* GetTransposePlanCache() {
+  static SharedTransposePlanCache* cache = new SharedTransposePlanCache;
+  return cache;
+}
+
+// Transposes `in` into `out` with a cache-blocked xla::TransposePlan run on
+// the threads of `d`. Returns false, leaving `out` untouched, if there is no
+// plan for the transpose.
+bool TransposeUsingPlan(const CPUDevice& d, const Tensor& in,
+                        const gtl::ArraySlice<int32> perm, size_t elem_size,
+                        Tensor* out) {
+  gtl::InlinedVector<int64_t, 8> dims(in.shape().dim_sizes().begin(),
+                                      in.shape().dim_sizes().end());
+  gtl::InlinedVector<int64_t, 8> permutation(perm.begin(), perm.end());
+  std::shared_ptr<xla::TransposePlan> plan;
+  {
+    SharedTransposePlanCache* cache = GetTransposePlanCache();
+    mutex_lock l(cache->mu);
+    auto plan_or = cache->cache.GetOrCreate(
+        elem_size, dims, permutation,
+        /*input_layout=*/xla::TransposePlan::Tiling{},
+        /*output_tiling=*/xla::TransposePlan::Tiling{},
+        xla::TransposePlan::Transformation::kNone, d.numThreads());
+    if (!plan_or.ok()) return false;
+    plan = std::move(plan_or).ValueOrDie();
+  }
+  plan->Execute(in.tensor_data().data(),
+                const_cast<char*>(out->tensor_data().data()),
+                [&d](std::function<void()> fn) {
+                  d.enqueueNoNotification(std::move(fn));
+                });
+  return true;
+}
+
+#endif  // !defined(IS_MOBILE_PLATFORM)
+
 }  // namespace
 
 template <typename T, bool conjugate>
 struct Transpose<CPUDevice, T, conjugate> {
   static void run(const CPUDevice& d, const Tensor& in,
                   const gtl::ArraySlice<int32> perm, Tensor* out) {
+#if !defined(IS_MOBILE_PLATFORM)
+    // The plans move plain bytes, which rules out conjugation and strings.
+    if (!conjugate && std::is_trivially_copyable<T>::value &&
+        in.NumElements() >= kMinTransposePlanElements &&
+        TransposeUsingPlan(d, in, perm, sizeof(T), out)) {
+      return;
+    }
+#endif  // !defined(IS_MOBILE_PLATFORM)
     switch (in.dims()) {
       case 2:
         internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in, perm, conjugate,
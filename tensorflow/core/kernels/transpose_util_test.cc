@@ -13,9 +13,16 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#define EIGEN_USE_THREADS
+
+#include <utility>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -130,4 +137,60 @@ TEST_F(TransposeUtilTest, NonSingletonDimensionAlignment) {
                                                      {0, 1, 2, 5, 4, 3}));
 }
 
+// Transposes `in` by `perm` one element at a time.
+template <typename T>
+Tensor ElementwiseTranspose(const Tensor& in, const std::vector<int32>& perm) {
+  const int ndims = in.dims();
+  TensorShape out_shape;
+  for (int32 p : perm) {
+    out_shape.AddDim(in.dim_size(p));
+  }
+  std::vector<int64_t> in_strides(ndims, 1);
+  for (int d = ndims - 2; d >= 0; --d) {
+    in_strides[d] = in_strides[d + 1] * in.dim_size(d + 1);
+  }
+  Tensor out(in.dtype(), out_shape);
+  auto in_flat = in.flat<T>();
+  auto out_flat = out.flat<T>();
+  for (int64_t o = 0; o < out.NumElements(); ++o) {
+    int64_t i = 0;
+    int64_t rest = o;
+    for (int d = ndims - 1; d >= 0; --d) {
+      i += rest % out_shape.dim_size(d) * in_strides[perm[d]];
+      rest /= out_shape.dim_size(d);
+    }
+    out_flat(o) = in_flat(i);
+  }
+  return out;
+}
+
+template <typename T>
+void TestTransposeMatchesElementwise(const Eigen::ThreadPoolDevice& device) {
+  const std::vector<std::pair<TensorShape, std::vector<int32>>> cases = {
+      {TensorShape({257, 129}), {1, 0}},
+      {TensorShape({8, 33, 17, 5}), {0, 3, 1, 2}},
+      {TensorShape({8, 5, 33, 17}), {0, 2, 3, 1}},
+      {TensorShape({9, 10, 11}), {2, 0, 1}},
+      {TensorShape({3, 4, 5, 6, 7}), {4, 2, 0, 3, 1}},
+      {TensorShape({4, 3}), {1, 0}},
+  };
+  for (const auto& c : cases) {
+    Tensor in(DataTypeToEnum<T>::value, c.first);
+    in.flat<T>().setRandom();
+    const Tensor expected = ElementwiseTranspose<T>(in, c.second);
+    Tensor out(in.dtype(), expected.shape());
+    TF_ASSERT_OK(DoTranspose(device, in, c.second, &out));
+    test::ExpectTensorEqual<T>(expected, out);
+  }
+}
+
+TEST(TransposeFunctorTest, MatchesElementwiseTranspose) {
+  Eigen::ThreadPool pool(4);
+  Eigen::ThreadPoolDevice device(&pool, 4);
+  TestTransposeMatchesElementwise<uint8>(device);
+  TestTransposeMatchesElementwise<float>(device);
+  TestTransposeMatchesElementwise<int64_t>(device);
+  TestTransposeMatchesElementwise<complex128>(device);
+}
+
 }  // namespace tensorflow
@@ -13,9 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
+#include <numeric>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -26,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -68,6 +72,212 @@ struct UniqueOpHashMap<bfloat16, TIndex> {
   using map_type = std::unordered_map<bfloat16, TIndex>;
 };
 
+// Inputs with at least this many elements are uniquified in parallel.
+constexpr int64_t kMinParallelUniqueSize = 1 << 16;
+
+// Rough cost of hashing an element and looking it up.
+constexpr int64_t kUniqueCostPerElement = 100;
+
+bool ShouldUniqueInParallel(OpKernelContext* context, int64_t num_elements) {
+  return num_elements >= kMinParallelUniqueSize &&
+         context->device()->tensorflow_cpu_worker_threads()->num_threads > 1;
+}
+
+// Computes the unique elements of `input` along `axis`, where all the other
+// dimensions of `input` have size 1, with the CPU worker threads. The outputs
+// are the ones of the serial implementation: the unique elements are
+// numbered in order of first occurrence.
+//
+// Sorted inputs, common for ids, are deduplicated by comparing neighbours.
+// Other inputs are partitioned by hash, every thread builds the hash map of a
+// partition, then the unique elements of all partitions are numbered
+// together.
+template <typename T, typename TIndex>
+void ParallelUnique(OpKernelContext* context, const Tensor& input,
+                    int64_t axis, typename TTypes<TIndex>::Vec idx_vec) {
+  using MapType = typename UniqueOpHashMap<T, TIndex>::map_type;
+  using KeyType = typename MapType::key_type;
+
+  const auto Tin = input.flat<T>();
+  const int64_t N = Tin.size();
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *context->device()->tensorflow_cpu_worker_threads();
+  // The input is cut into blocks, and the hashed input into as many
+  // partitions, which are processed by one thread each.
+  const int num_blocks = std::min(worker_threads.num_threads, 256);
+  const auto block_begin = [N, num_blocks](int64_t b) {
+    return N * b / num_blocks;
+  };
+  const auto for_each_block = [&](const std::function<void(int64_t)>& fn) {
+    Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+          N / num_blocks * kUniqueCostPerElement,
+          [&fn](int64_t start, int64_t limit) {
+            for (int64_t b = start; b < limit; ++b) {
+              fn(b);
+            }
+          });
+  };
+
+  const bool with_counts = context->num_outputs() > 2;
+  Tensor* output = nullptr;
+  Tensor* count_output = nullptr;
+  const auto allocate_outputs = [&](int64_t uniq_size) -> Status {
+    TensorShape output_shape(input.shape());
+    output_shape.set_dim(axis, uniq_size);
+    TF_RETURN_IF_ERROR(context->allocate_output(0, output_shape, &output));
+    if (with_counts) {
+      TF_RETURN_IF_ERROR(context->allocate_output(
+          2, TensorShape({uniq_size}), &count_output));
+    }
+    return Status::OK();
+  };
+
+  // block_offsets[b + 1] is first set to the number of unique elements
+  // appearing first in block b, then summed into the number of unique
+  // elements before block b + 1.
+  std::vector<int64_t> block_offsets(num_blocks + 1, 0);
+
+  // Equal elements of a sorted input are adjacent. NaNs are not sorted.
+  const auto is_first_in_sorted = [&Tin](int64_t i) {
+    return i == 0 || !(Tin(i) == Tin(i - 1));
+  };
+  std::vector<uint8> block_is_sorted(num_blocks);
+  for_each_block([&](int64_t b) {
+    block_is_sorted[b] = true;
+    for (int64_t i = std::max<int64_t>(block_begin(b), 1);
+         i < block_begin(b + 1); ++i) {
+      if (!(Tin(i - 1) < Tin(i) || Tin(i - 1) == Tin(i))) {
+        block_is_sorted[b] = false;
+        return;
+      }
+    }
+    for (int64_t i = block_begin(b); i < block_begin(b + 1); ++i) {
+      block_offsets[b + 1] += is_first_in_sorted(i);
+    }
+  });
+  if (std::all_of(block_is_sorted.begin(), block_is_sorted.end(),
+                  [](uint8 is_sorted) { return is_sorted; })) {
+    std::partial_sum(block_offsets.begin(), block_offsets.end(),
+                     block_offsets.begin());
+    OP_REQUIRES_OK(context, allocate_outputs(block_offsets[num_blocks]));
+    auto Tout = output->flat<T>();
+    TIndex* counts = with_counts ? count_output->vec<TIndex>().data() : nullptr;
+    for_each_block([&](int64_t b) {
+      int64_t j = block_offsets[b] - 1;
+      for (int64_t i = block_begin(b); i < block_begin(b + 1); ++i) {
+        if (is_first_in_sorted(i)) {
+          Tout(++j) = Tin(i);
+          if (with_counts) {
+            int64_t next = i + 1;
+            while (next < N && Tin(next) == Tin(i)) ++next;
+            counts[j] = next - i;
+          }
+        }
+        idx_vec(i) = j;
+      }
+    });
+    return;
+  }
+
+  // Sorts the positions of the elements by partition, keeping them in
+  // increasing order in each partition.
+  const int num_partitions = num_blocks;
+  const typename MapType::hasher hasher;
+  std::vector<uint8> partitions(N);
+  // The number of elements of a partition in a block, then its offset in
+  // `positions`, indexed by block then partition.
+  std::vector<int64_t> offsets(num_blocks * num_partitions, 0);
+  for_each_block([&](int64_t b) {
+    int64_t* block_counts = &offsets[b * num_partitions];
+    for (int64_t i = block_begin(b); i < block_begin(b + 1); ++i) {
+      const uint64 hash = hasher(KeyType(Tin(i)));
+      // Remixes the hash, since std::hash is the identity for some types.
+      const uint64 p =
+          ((hash * 0x9E3779B97F4A7C15ull) >> 32) * num_partitions >> 32;
+      partitions[i] = p;
+      ++block_counts[p];
+    }
+  });
+  std::vector<int64_t> partition_begin(num_partitions + 1);
+  int64_t offset = 0;
+  for (int p = 0; p < num_partitions; ++p) {
+    partition_begin[p] = offset;
+    for (int b = 0; b < num_blocks; ++b) {
+      const int64_t count = offsets[b * num_partitions + p];
+      offsets[b * num_partitions + p] = offset;
+      offset += count;
+    }
+  }
+  partition_begin[num_partitions] = N;
+  std::vector<int32> positions(N);
+  for_each_block([&](int64_t b) {
+    int64_t* next = &offsets[b * num_partitions];
+    for (int64_t i = block_begin(b); i < block_begin(b + 1); ++i) {
+      positions[next[partitions[i]]++] = i;
+    }
+  });
+
+  // Deduplicates each partition. The index of an element is first set to
+  // the index of its value in its partition.
+  std::vector<std::vector<int32>> partition_firsts(num_partitions);
+  std::vector<std::vector<TIndex>> partition_counts(num_partitions);
+  std::vector<uint8> is_first(N, 0);
+  for_each_block([&](int64_t p) {
+    std::vector<int32>& firsts = partition_firsts[p];
+    std::vector<TIndex>& counts = partition_counts[p];
+    MapType uniq;
+    uniq.reserve(partition_begin[p + 1] - partition_begin[p]);
+    for (int64_t k = partition_begin[p]; k < partition_begin[p + 1]; ++k) {
+      const int32 i = positions[k];
+      auto it = uniq.emplace(Tin(i), static_cast<TIndex>(firsts.size()));
+      if (it.second) {
+        firsts.push_back(i);
+        is_first[i] = 1;
+        if (with_counts) counts.push_back(0);
+      }
+      idx_vec(i) = it.first->second;
+      if (with_counts) ++counts[it.first->second];
+    }
+  });
+
+  // Numbers the unique elements in order of first occurrence.
+  std::fill(block_offsets.begin(), block_offsets.end(), 0);
+  for_each_block([&](int64_t b) {
+    for (int64_t i = block_begin(b); i < block_begin(b + 1); ++i) {
+      block_offsets[b + 1] += is_first[i];
+    }
+  });
+  std::partial_sum(block_offsets.begin(), block_offsets.end(),
+                   block_offsets.begin());
+  OP_REQUIRES_OK(context, allocate_outputs(block_offsets[num_blocks]));
+  auto Tout = output->flat<T>();
+  TIndex* counts = with_counts ? count_output->vec<TIndex>().data() : nullptr;
+  // The positions are no longer needed, and hold the number of the unique
+  // element first appearing there instead.
+  std::vector<int32>& numbers = positions;
+  for_each_block([&](int64_t b) {
+    int64_t j = block_offsets[b];
+    for (int64_t i = block_begin(b); i < block_begin(b + 1); ++i) {
+      if (is_first[i]) {
+        numbers[i] = j;
+        Tout(j++) = Tin(i);
+      }
+    }
+  });
+  for_each_block([&](int64_t p) {
+    std::vector<int32>& firsts = partition_firsts[p];
+    for (size_t l = 0; l < firsts.size(); ++l) {
+      firsts[l] = numbers[firsts[l]];
+      if (with_counts) counts[firsts[l]] = partition_counts[p][l];
+    }
+  });
+  for_each_block([&](int64_t b) {
+    for (int64_t i = block_begin(b); i < block_begin(b + 1); ++i) {
+      idx_vec(i) = partition_firsts[partitions[i]][idx_vec(i)];
+    }
+  });
+}
+
 // `UniqueOp` computes the unique elements in the input tensor.
 //
 // * `T` is the element type.
@@ -142,6 +352,12 @@ class UniqueOp : public OpKernel {
                                 1, TensorShape({new_sizes[1]}), &idx));
     auto idx_vec = idx->template vec<TIndex>();
 
+    if (new_sizes[0] == 1 && new_sizes[2] == 1 &&
+        ShouldUniqueInParallel(context, new_sizes[1])) {
+      ParallelUnique<T, TIndex>(context, input, axis, idx_vec);
+      return;
+    }
+
     int64_t uniq_size;
     if (new_sizes[0] == 1 && new_sizes[2] == 1) {
       // Specialized and faster implementation when unique is run over single
@@ -202,6 +202,11 @@ class SqliteStatement {
   /// super compelling reason yet to call them independently.
   void Reset();
 
+  /// \brief Returns true if the query has a parameter named <parameter>.
+  bool HasParameter(const char* parameter) const TF_MUST_USE_RESULT {
+    return sqlite3_bind_parameter_index(stmt_, parameter) > 0;
+  }
+
   /// \brief Binds signed 64-bit integer to 1-indexed query parameter.
   void BindInt(int parameter, int64_t value) {
     Update(sqlite3_bind_int64(stmt_, parameter, value), parameter);
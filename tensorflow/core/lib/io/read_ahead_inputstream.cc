@@ -0,0 +1,154 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace io {
+
+ReadAheadInputStream::ReadAheadInputStream(InputStreamInterface* input_stream,
+                                           size_t chunk_size,
+                                           size_t max_buffered_chunks,
+                                           bool owns_input_stream, Env* env)
+    : input_stream_(input_stream),
+      chunk_size_(std::max<size_t>(chunk_size, 1)),
+      max_buffered_chunks_(std::max<size_t>(max_buffered_chunks, 1)),
+      owns_input_stream_(owns_input_stream),
+      env_(env) {
+  StartReadAhead();
+}
+
+ReadAheadInputStream::~ReadAheadInputStream() {
+  StopReadAhead();
+  if (owns_input_stream_) {
+    delete input_stream_;
+  }
+}
+
+void ReadAheadInputStream::StartReadAhead() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = false;
+  }
+  thread_.reset(env_->StartThread(ThreadOptions(), "read_ahead_input_stream",
+                                  [this]() { ReadAhead(); }));
+}
+
+void ReadAheadInputStream::StopReadAhead() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    space_available_.notify_all();
+  }
+  // Joins the thread.
+  thread_.reset();
+}
+
+void ReadAheadInputStream::ReadAhead() {
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      while (!cancelled_ && chunks_.size() >= max_buffered_chunks_) {
+        space_available_.wait(l);
+      }
+      if (cancelled_) return;
+    }
+    tstring chunk;
+    Status s = input_stream_->ReadNBytes(chunk_size_, &chunk);
+    mutex_lock l(mu_);
+    if (!chunk.empty()) {
+      chunks_.push_back(std::move(chunk));
+    }
+    if (!s.ok()) {
+      done_ = true;
+      status_ = s;
+    }
+    data_available_.notify_all();
+    if (done_) return;
+  }
+}
+
+Status ReadAheadInputStream::Consume(int64_t n, tstring* result) {
+  mutex_lock l(mu_);
+  while (n > 0) {
+    while (chunks_.empty() && !done_) {
+      data_available_.wait(l);
+    }
+    if (chunks_.empty()) return status_;
+    const tstring& front = chunks_.front();
+    const size_t bytes =
+        std::min<size_t>(front.size() - front_offset_, static_cast<size_t>(n));
+    if (result != nullptr) {
+      result->append(front.data() + front_offset_, bytes);
+    }
+    front_offset_ += bytes;
+    position_ += bytes;
+    n -= bytes;
+    if (front_offset_ == front.size()) {
+      chunks_.pop_front();
+      front_offset_ = 0;
+      space_available_.notify_all();
+    }
+  }
+  return Status::OK();
+}
+
+Status ReadAheadInputStream::ReadNBytes(int64_t bytes_to_read,
+                                        tstring* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  result->clear();
+  result->reserve(bytes_to_read);
+  return Consume(bytes_to_read, result);
+}
+
+Status ReadAheadInputStream::SkipNBytes(int64_t bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes: ",
+                                   bytes_to_skip);
+  }
+  return Consume(bytes_to_skip, nullptr);
+}
+
+int64_t ReadAheadInputStream::Tell() const {
+  mutex_lock l(mu_);
+  return position_;
+}
+
+Status ReadAheadInputStream::Reset() {
+  StopReadAhead();
+  Status s = input_stream_->Reset();
+  {
+    mutex_lock l(mu_);
+    chunks_.clear();
+    front_offset_ = 0;
+    position_ = 0;
+    done_ = !s.ok();
+    status_ = s;
+  }
+  if (s.ok()) {
+    StartReadAhead();
+  }
+  return s;
+}
+
+}  // namespace io
+}  // namespace tensorflow
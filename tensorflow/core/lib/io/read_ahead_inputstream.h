@@ -0,0 +1,109 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads an input stream ahead of its consumer on a background thread.
+//
+// The background thread reads `chunk_size` bytes at a time from the input
+// stream, and buffers up to `max_buffered_chunks` chunks. Wrapping a
+// ZlibInputStream or SnappyInputStream moves the decompression (and the
+// reads of the compressed file) off the consumer thread, so that they
+// overlap with the processing of the data.
+//
+// A single instance of ReadAheadInputStream is NOT safe for concurrent use by
+// multiple threads.
+class ReadAheadInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of input_stream unless owns_input_stream is set
+  // to true. input_stream must outlive *this then. input_stream must not be
+  // used by other callers while *this exists.
+  ReadAheadInputStream(InputStreamInterface* input_stream, size_t chunk_size,
+                       size_t max_buffered_chunks,
+                       bool owns_input_stream = false,
+                       Env* env = Env::Default());
+
+  // Stops the background thread.
+  ~ReadAheadInputStream() override;
+
+  // Returns the buffered data, waiting for the background thread if needed.
+  // Errors of the input stream (including OUT_OF_RANGE at the end of the
+  // stream) are returned once the data read before them is consumed.
+  Status ReadNBytes(int64_t bytes_to_read, tstring* result) override;
+
+  Status SkipNBytes(int64_t bytes_to_skip) override;
+
+  int64_t Tell() const override;
+
+  // Stops the background thread, resets the input stream and starts reading
+  // it again from the beginning.
+  Status Reset() override;
+
+ private:
+  // Consumes up to `n` buffered bytes, appending them to `*result` unless it
+  // is null.
+  Status Consume(int64_t n, tstring* result) TF_LOCKS_EXCLUDED(mu_);
+
+  // The body of the background thread.
+  void ReadAhead() TF_LOCKS_EXCLUDED(mu_);
+
+  void StartReadAhead() TF_LOCKS_EXCLUDED(mu_);
+  void StopReadAhead() TF_LOCKS_EXCLUDED(mu_);
+
+  InputStreamInterface* input_stream_;
+  const size_t chunk_size_;
+  const size_t max_buffered_chunks_;
+  const bool owns_input_stream_;
+  Env* const env_;
+
+  mutable mutex mu_;
+  // Signaled when a chunk is buffered or the stream ends.
+  condition_variable data_available_;
+  // Signaled when a chunk is consumed or the thread is cancelled.
+  condition_variable space_available_;
+
+  std::deque<tstring> chunks_ TF_GUARDED_BY(mu_);
+  // Number of bytes of chunks_.front() already consumed.
+  size_t front_offset_ TF_GUARDED_BY(mu_) = 0;
+  // The position of the consumer in the stream.
+  int64_t position_ TF_GUARDED_BY(mu_) = 0;
+  // Set when the input stream returned `status_`, after the buffered chunks.
+  bool done_ TF_GUARDED_BY(mu_) = false;
+  Status status_ TF_GUARDED_BY(mu_);
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReadAheadInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
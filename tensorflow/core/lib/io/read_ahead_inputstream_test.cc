@@ -0,0 +1,136 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+static std::vector<int> ChunkSizes() { return {1, 2, 3, 7, 10, 65536}; }
+
+static std::vector<int> MaxBufferedChunks() { return {1, 2, 16}; }
+
+string CreateFile(Env* env, const string& contents) {
+  string fname;
+  CHECK(env->LocalTempFilename(&fname));
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+  return fname;
+}
+
+TEST(ReadAheadInputStream, ReadNBytes) {
+  Env* env = Env::Default();
+  const string fname = CreateFile(env, "0123456789");
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (int chunk_size : ChunkSizes()) {
+    for (int max_buffered_chunks : MaxBufferedChunks()) {
+      ReadAheadInputStream in(new RandomAccessInputStream(file.get()),
+                              chunk_size, max_buffered_chunks, true);
+      tstring read;
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "012");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(0, &read));
+      EXPECT_EQ(read, "");
+      TF_ASSERT_OK(in.ReadNBytes(4, &read));
+      EXPECT_EQ(read, "3456");
+      EXPECT_EQ(7, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(5, &read)));
+      EXPECT_EQ(read, "789");
+      EXPECT_EQ(10, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+      EXPECT_EQ(read, "");
+    }
+  }
+}
+
+TEST(ReadAheadInputStream, SkipNBytes) {
+  Env* env = Env::Default();
+  const string fname = CreateFile(env, "0123456789");
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (int chunk_size : ChunkSizes()) {
+    std::unique_ptr<RandomAccessInputStream> input_stream(
+        new RandomAccessInputStream(file.get()));
+    ReadAheadInputStream in(input_stream.get(), chunk_size, 2);
+    tstring read;
+    TF_ASSERT_OK(in.SkipNBytes(3));
+    EXPECT_EQ(3, in.Tell());
+    TF_ASSERT_OK(in.ReadNBytes(2, &read));
+    EXPECT_EQ(read, "34");
+    TF_ASSERT_OK(in.SkipNBytes(4));
+    EXPECT_EQ(9, in.Tell());
+    EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(2)));
+    EXPECT_EQ(10, in.Tell());
+  }
+}
+
+TEST(ReadAheadInputStream, Reset) {
+  Env* env = Env::Default();
+  const string fname = CreateFile(env, "0123456789");
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (int chunk_size : ChunkSizes()) {
+    ReadAheadInputStream in(new RandomAccessInputStream(file.get()),
+                            chunk_size, 1, true);
+    tstring read;
+    EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(20, &read)));
+    EXPECT_EQ(read, "0123456789");
+    TF_ASSERT_OK(in.Reset());
+    EXPECT_EQ(0, in.Tell());
+    TF_ASSERT_OK(in.ReadNBytes(4, &read));
+    EXPECT_EQ(read, "0123");
+    // Resets while the background thread is reading ahead.
+    TF_ASSERT_OK(in.Reset());
+    TF_ASSERT_OK(in.ReadNBytes(10, &read));
+    EXPECT_EQ(read, "0123456789");
+  }
+}
+
+TEST(ReadAheadInputStream, LargeInput) {
+  Env* env = Env::Default();
+  string contents;
+  for (int i = 0; i < 100000; ++i) {
+    contents.push_back(static_cast<char>(i % 251));
+  }
+  const string fname = CreateFile(env, contents);
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  ReadAheadInputStream in(new RandomAccessInputStream(file.get()), 1000, 4,
+                          true);
+  string result;
+  tstring read;
+  Status s;
+  while (s.ok()) {
+    s = in.ReadNBytes(777, &read);
+    result.append(read.data(), read.size());
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(s));
+  EXPECT_EQ(result, contents);
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace tensorflow
@@ -17,12 +17,15 @@ limitations under the License.
 
 #include <limits.h>
 
+#include <algorithm>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
@@ -82,7 +85,15 @@ RecordReader::RecordReader(RandomAccessFile* file,
   } else {
     LOG(FATAL) << "Unrecognized compression type :" << options.compression_type;
   }
-#endif
+#endif  if (options.read_ahead_bytes > 0) {
+    // Read ahead in chunks of at most 1MB, so that the consumer does not wait
+    // for a whole chunk when starting to read.
+    const int64_t chunk_size =
+        std::min<int64_t>(options.read_ahead_bytes, 1 << 20);
+    input_stream_.reset(new ReadAheadInputStream(
+        input_stream_.release(), chunk_size,
+        (options.read_ahead_bytes + chunk_size - 1) / chunk_size, true));
+  }
 }
 
 // Read n+4 bytes from file, verify that checksum of first n bytes is
@@ -245,5 +256,109 @@ SequentialRecordReader::SequentialRecordReader(
     RandomAccessFile* file, const RecordReaderOptions& options)
     : underlying_(file, options), offset_(0) {}
 
+Status RecordReader::ReadIndexBlock(int64_t block) {
+  if (cached_index_block_number_ == block) return Status::OK();
+  cached_index_block_number_ = -1;
+  cached_index_block_.clear();
+
+  const uint64 block_offset = static_cast<uint64>(block) * kIndexBlockBytes;
+  std::unique_ptr<char[]> scratch(new char[kIndexBlockBytes]);
+  StringPiece data;
+  Status s = options_.index_file->Read(block_offset, kIndexBlockBytes, &data,
+                                       scratch.get());
+  if (!s.ok() && !errors::IsOutOfRange(s)) return s;
+  if (data.empty()) {
+    return errors::OutOfRange("index block ", block, " is past the end");
+  }
+  if (data.size() < sizeof(uint32)) {
+    return errors::DataLoss("truncated index block ", block);
+  }
+  const uint32 n = core::DecodeFixed32(data.data());
+  if (n > kIndexBlockSize) {
+    return errors::DataLoss("corrupted index block ", block);
+  }
+  const size_t size = sizeof(uint32) + n * sizeof(uint64);
+  if (data.size() < size + sizeof(uint32)) {
+    return errors::DataLoss("truncated index block ", block);
+  }
+  const uint32 masked_crc = core::DecodeFixed32(data.data() + size);
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(data.data(), size)) {
+    return errors::DataLoss("corrupted index block ", block);
+  }
+  cached_index_block_.resize(n);
+  for (uint32 i = 0; i < n; ++i) {
+    cached_index_block_[i] =
+        core::DecodeFixed64(data.data() + sizeof(uint32) + i * sizeof(uint64));
+  }
+  cached_index_block_number_ = block;
+  return Status::OK();
+}
+
+Status RecordReader::ReadRecordByNumber(int64_t record_number,
+                                        tstring* record) {
+  if (options_.index_file == nullptr) {
+    return errors::FailedPrecondition(
+        "Reading records by number requires an index file");
+  }
+  if (record_number < 0) {
+    return errors::InvalidArgument("Invalid record number: ", record_number);
+  }
+  const int64_t block = record_number / kIndexBlockSize;
+  const size_t i = record_number % kIndexBlockSize;
+  TF_RETURN_IF_ERROR(ReadIndexBlock(block));
+  if (i >= cached_index_block_.size()) {
+    return errors::OutOfRange("record ", record_number, " is past the end");
+  }
+  uint64 offset = cached_index_block_[i];
+  return ReadRecord(&offset, record);
+}
+
+Status RecordReader::GetNumIndexedRecords(int64_t* num_records) {
+  if (options_.index_file == nullptr) {
+    return errors::FailedPrecondition(
+        "Counting indexed records requires an index file");
+  }
+  // All blocks but the last one are full, so the last block is found by an
+  // exponential search followed by a binary search over the block numbers.
+  auto is_full = [this](int64_t block, bool* full) -> Status {
+    Status s = ReadIndexBlock(block);
+    if (errors::IsOutOfRange(s)) {
+      *full = false;
+      return Status::OK();
+    }
+    TF_RETURN_IF_ERROR(s);
+    *full = cached_index_block_.size() == kIndexBlockSize;
+    return Status::OK();
+  };
+  int64_t last_full = -1;
+  int64_t first_partial = 0;
+  bool full;
+  TF_RETURN_IF_ERROR(is_full(first_partial, &full));
+  while (full) {
+    last_full = first_partial;
+    first_partial = 2 * first_partial + 1;
+    TF_RETURN_IF_ERROR(is_full(first_partial, &full));
+  }
+  while (first_partial - last_full > 1) {
+    const int64_t mid = last_full + (first_partial - last_full) / 2;
+    TF_RETURN_IF_ERROR(is_full(mid, &full));
+    if (full) {
+      last_full = mid;
+    } else {
+      first_partial = mid;
+    }
+  }
+  Status s = ReadIndexBlock(first_partial);
+  if (errors::IsOutOfRange(s)) {
+    // The index was not completed by RecordWriter::Close().
+    *num_records = first_partial * kIndexBlockSize;
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(s);
+  *num_records =
+      first_partial * kIndexBlockSize + cached_index_block_.size();
+  return Status::OK();
+}
+
 }  // namespace io
 }  // namespace tensorflow
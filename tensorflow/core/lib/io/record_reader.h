@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_LIB_IO_RECORD_READER_H_
 #define TENSORFLOW_CORE_LIB_IO_RECORD_READER_H_
 
+#include <vector>
+
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
@@ -47,6 +49,11 @@ struct RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64_t buffer_size = 0;
 
+  // If read_ahead_bytes is non-zero, the (decompressed) input stream is read
+  // ahead by up to read_ahead_bytes on a background thread, so that reading
+  // the file and decompressing it overlap with the processing of the records.
+  int64_t read_ahead_bytes = 0;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
@@ -55,6 +62,12 @@ struct RecordReaderOptions {
   ZlibCompressionOptions zlib_options;
   SnappyCompressionOptions snappy_options;
 #endif  // IS_SLIM_BUILD
+
+  // If non-null, the record-offset index written alongside the file by
+  // RecordWriter (see RecordWriterOptions::index_file), which enables
+  // RecordReader::ReadRecordByNumber(). "*index_file" must remain live while
+  // the reader is in use.
+  RandomAccessFile* index_file = nullptr;
 };
 
 // Low-level interface to read TFRecord files.
@@ -72,6 +85,14 @@ class RecordReader {
   static constexpr size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
   static constexpr size_t kFooterSize = sizeof(uint32);
 
+  // Format of the index file, see RecordWriter for details:
+  //  uint32    number of offsets n, at most kIndexBlockSize
+  //  uint64    offsets[n]
+  //  uint32    masked crc of the preceding 4 + 8 * n bytes
+  static constexpr size_t kIndexBlockSize = 1024;
+  static constexpr size_t kIndexBlockBytes =
+      sizeof(uint32) + kIndexBlockSize * sizeof(uint64) + sizeof(uint32);
+
   // Statistics (sizes are in units of bytes)
   struct Stats {
     int64_t file_size = -1;
@@ -104,6 +125,21 @@ class RecordReader {
   // are actually skipped. It should be equal to num_to_skip on success.
   Status SkipRecords(uint64* offset, int num_to_skip, int* num_skipped);
 
+  // Read the record numbered "record_number" (counting from 0) into *record,
+  // locating it through options.index_file. Only the index block holding the
+  // record is read and verified; the most recently read block is cached.
+  // Returns OK on success, FAILED_PRECONDITION if the reader has no index,
+  // OUT_OF_RANGE if the index holds fewer records, or something else for an
+  // error.
+  //
+  // Reading compressed files this way is supported but not efficient, as the
+  // input stream has to be decompressed up to the record.
+  Status ReadRecordByNumber(int64_t record_number, tstring* record);
+
+  // Sets *num_records to the number of records in options.index_file. Reads
+  // O(log(number of index blocks)) index blocks.
+  Status GetNumIndexedRecords(int64_t* num_records);
+
   // Return the metadata of the Record file.
   //
   // The current implementation scans the file to completion,
@@ -118,6 +154,9 @@ class RecordReader {
  private:
   Status ReadChecksummed(uint64 offset, size_t n, tstring* result);
   Status PositionInputStream(uint64 offset);
+  // Reads and verifies index block "block" into cached_index_block_. Returns
+  // OUT_OF_RANGE if the index ends before the block.
+  Status ReadIndexBlock(int64_t block);
 
   RecordReaderOptions options_;
   std::unique_ptr<InputStreamInterface> input_stream_;
@@ -125,6 +164,10 @@ class RecordReader {
 
   std::unique_ptr<Metadata> cached_metadata_;
 
+  // Number and offsets of the most recently read index block, -1 if none.
+  int64_t cached_index_block_number_ = -1;
+  std::vector<uint64> cached_index_block_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RecordReader);
 };
 
@@ -98,6 +98,53 @@ void VerifyFlush(const io::RecordWriterOptions& options) {
   }
 }
 
+// Writes "num_records" records "0", "1", ... to "fname" and their index to
+// "fname.tfrindex".
+void WriteIndexedRecords(const string& fname, int num_records,
+                         io::RecordWriterOptions options) {
+  Env* env = Env::Default();
+  std::unique_ptr<WritableFile> file;
+  TF_CHECK_OK(env->NewWritableFile(fname, &file));
+  std::unique_ptr<WritableFile> index_file;
+  TF_CHECK_OK(env->NewWritableFile(fname + ".tfrindex", &index_file));
+  options.index_file = index_file.get();
+  io::RecordWriter writer(file.get(), options);
+  for (int i = 0; i < num_records; ++i) {
+    TF_CHECK_OK(writer.WriteRecord(strings::StrCat(i)));
+  }
+  TF_CHECK_OK(writer.Close());
+  TF_CHECK_OK(file->Close());
+  TF_CHECK_OK(index_file->Close());
+}
+
+void VerifyIndexedRecords(const string& fname, int num_records,
+                          const io::RecordReaderOptions& options) {
+  Env* env = Env::Default();
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+  std::unique_ptr<RandomAccessFile> index_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname + ".tfrindex", &index_file));
+  io::RecordReaderOptions read_options = options;
+  read_options.index_file = index_file.get();
+  io::RecordReader reader(file.get(), read_options);
+
+  int64_t num_indexed_records;
+  TF_ASSERT_OK(reader.GetNumIndexedRecords(&num_indexed_records));
+  EXPECT_EQ(num_indexed_records, num_records);
+
+  // Read the records backwards, so that each index block is read more than
+  // once and out of order.
+  tstring record;
+  for (int i = num_records - 1; i >= 0; i -= 7) {
+    TF_ASSERT_OK(reader.ReadRecordByNumber(i, &record));
+    EXPECT_EQ(record, strings::StrCat(i));
+  }
+  EXPECT_EQ(reader.ReadRecordByNumber(num_records, &record).code(),
+            error::OUT_OF_RANGE);
+  EXPECT_EQ(reader.ReadRecordByNumber(-1, &record).code(),
+            error::INVALID_ARGUMENT);
+}
+
 }  // namespace
 
 TEST(RecordReaderWriterTest, TestFlush) {
@@ -305,6 +352,90 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestParallelZlibSyncFlush) {
+  io::RecordWriterOptions options;
+  options.compression_type = io::RecordWriterOptions::ZLIB_COMPRESSION;
+  options.zlib_options.num_compression_threads = 2;
+  VerifyFlush(options);
+}
+
+void VerifyParallelCompression(const string& compression_type) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_parallel_test";
+  std::vector<string> records;
+  for (int i = 0; i < 1000; ++i) {
+    records.push_back(string(i % 97, 'a' + i % 26));
+  }
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriterOptions options =
+        io::RecordWriterOptions::CreateRecordWriterOptions(compression_type);
+    options.zlib_options.num_compression_threads = 4;
+    options.zlib_options.parallel_block_size = 1000;
+    io::RecordWriter writer(file.get(), options);
+    for (const string& record : records) {
+      TF_EXPECT_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(writer.Close());
+    TF_CHECK_OK(file->Close());
+  }
+
+  for (int64_t read_ahead_bytes : {0, 1, 100, 1 << 20}) {
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+    io::RecordReaderOptions options =
+        io::RecordReaderOptions::CreateRecordReaderOptions(compression_type);
+    options.read_ahead_bytes = read_ahead_bytes;
+    io::SequentialRecordReader reader(read_file.get(), options);
+    tstring record;
+    for (const string& expected : records) {
+      TF_CHECK_OK(reader.ReadRecord(&record));
+      EXPECT_EQ(record, expected);
+    }
+    EXPECT_EQ(reader.ReadRecord(&record).code(), error::OUT_OF_RANGE);
+  }
+}
+
+TEST(RecordReaderWriterTest, TestParallelZlib) {
+  VerifyParallelCompression("ZLIB");
+}
+
+TEST(RecordReaderWriterTest, TestParallelGzip) {
+  VerifyParallelCompression("GZIP");
+}
+
+TEST(RecordReaderWriterTest, TestReadAheadSeek) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_read_ahead_test";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord("defg"));
+    TF_CHECK_OK(writer.Close());
+  }
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordReaderOptions options;
+  options.read_ahead_bytes = 5;
+  io::RecordReader reader(read_file.get(), options);
+  uint64 offset = 0;
+  tstring record;
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("abc", record);
+  const uint64 second_offset = offset;
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("defg", record);
+  // Reading backwards resets the stream.
+  offset = 0;
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("abc", record);
+  EXPECT_EQ(offset, second_offset);
+}
+
 TEST(RecordReaderWriterTest, TestUseAfterClose) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_flush_close_test";
@@ -328,4 +459,55 @@ TEST(RecordReaderWriterTest, TestUseAfterClose) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestReadRecordByNumber) {
+  string fname = testing::TmpDir() + "/record_reader_writer_index_test";
+  // Cover an empty index, a partial first block, a full last block and
+  // several blocks.
+  for (int num_records : {0, 10, 1024, 2048, 2500}) {
+    WriteIndexedRecords(fname, num_records, io::RecordWriterOptions());
+    VerifyIndexedRecords(fname, num_records, io::RecordReaderOptions());
+  }
+}
+
+TEST(RecordReaderWriterTest, TestReadRecordByNumberZlib) {
+  string fname = testing::TmpDir() + "/record_reader_writer_index_zlib_test";
+  WriteIndexedRecords(
+      fname, 1500, io::RecordWriterOptions::CreateRecordWriterOptions("ZLIB"));
+  VerifyIndexedRecords(
+      fname, 1500, io::RecordReaderOptions::CreateRecordReaderOptions("ZLIB"));
+}
+
+TEST(RecordReaderWriterTest, TestReadRecordByNumberWithoutIndex) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_no_index_test";
+  WriteIndexedRecords(fname, 3, io::RecordWriterOptions());
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+  io::RecordReader reader(file.get());
+  tstring record;
+  EXPECT_EQ(reader.ReadRecordByNumber(0, &record).code(),
+            error::FAILED_PRECONDITION);
+}
+
+TEST(RecordReaderWriterTest, TestReadRecordByNumberCorruptedIndex) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_bad_index_test";
+  WriteIndexedRecords(fname, 3, io::RecordWriterOptions());
+  string index;
+  TF_CHECK_OK(ReadFileToString(env, fname + ".tfrindex", &index));
+  // Flip a bit of the offset of the second record.
+  index[sizeof(uint32) + sizeof(uint64)] ^= 1;
+  TF_CHECK_OK(WriteStringToFile(env, fname + ".tfrindex", index));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+  std::unique_ptr<RandomAccessFile> index_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname + ".tfrindex", &index_file));
+  io::RecordReaderOptions options;
+  options.index_file = index_file.get();
+  io::RecordReader reader(file.get(), options);
+  tstring record;
+  EXPECT_EQ(reader.ReadRecordByNumber(0, &record).code(), error::DATA_LOSS);
+}
+
 }  // namespace tensorflow
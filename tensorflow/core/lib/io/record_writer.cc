@@ -59,13 +59,24 @@ RecordWriterOptions RecordWriterOptions::CreateRecordWriterOptions(
 
 RecordWriter::RecordWriter(WritableFile* dest,
                            const RecordWriterOptions& options)
-    : dest_(dest), options_(options) {
+    : dest_(dest), options_(options), index_dest_(options.index_file) {
+  if (index_dest_ != nullptr) index_block_.reserve(kIndexBlockSize);
 #if defined(IS_SLIM_BUILD)
   if (options.compression_type != RecordWriterOptions::NONE) {
     LOG(FATAL) << "Compression is unsupported on mobile platforms.";
   }
 #else
-  if (IsZlibCompressed(options)) {
+  if (IsZlibCompressed(options) &&
+      options.zlib_options.num_compression_threads > 1) {
+    ParallelZlibOutputBuffer* zlib_output_buffer =
+        new ParallelZlibOutputBuffer(dest, options.zlib_options);
+    Status s = zlib_output_buffer->Init();
+    if (!s.ok()) {
+      LOG(FATAL) << "Failed to initialize parallel Zlib outputbuffer. Error: "
+                 << s.ToString();
+    }
+    dest_ = zlib_output_buffer;
+  } else if (IsZlibCompressed(options)) {
     ZlibOutputBuffer* zlib_output_buffer = new ZlibOutputBuffer(
         dest, options.zlib_options.input_buffer_size,
         options.zlib_options.output_buffer_size, options.zlib_options);
@@ -112,7 +123,8 @@ Status RecordWriter::WriteRecord(StringPiece data) {
   PopulateFooter(footer, data.data(), data.size());
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
   TF_RETURN_IF_ERROR(dest_->Append(data));
-  return dest_->Append(StringPiece(footer, sizeof(footer)));
+  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(footer, sizeof(footer))));
+  return IndexRecord(data.size());
 }
 
 #if defined(TF_CORD_SUPPORT)
@@ -132,11 +144,39 @@ Status RecordWriter::WriteRecord(const absl::Cord& data) {
   PopulateFooter(footer, data);
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
   TF_RETURN_IF_ERROR(dest_->Append(data));
-  return dest_->Append(StringPiece(footer, sizeof(footer)));
+  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(footer, sizeof(footer))));
+  return IndexRecord(data.size());
 }
 #endif
 
+Status RecordWriter::IndexRecord(size_t n) {
+  if (index_dest_ == nullptr) return Status::OK();
+  index_block_.push_back(index_offset_);
+  index_offset_ += kHeaderSize + n + kFooterSize;
+  if (index_block_.size() < kIndexBlockSize) return Status::OK();
+  return WriteIndexBlock();
+}
+
+Status RecordWriter::WriteIndexBlock() {
+  std::string block;
+  block.reserve(kIndexBlockBytes);
+  core::PutFixed32(&block, index_block_.size());
+  for (uint64 offset : index_block_) {
+    core::PutFixed64(&block, offset);
+  }
+  core::PutFixed32(&block, MaskedCrc(block.data(), block.size()));
+  index_block_.clear();
+  return index_dest_->Append(block);
+}
+
 Status RecordWriter::Close() {
+  if (index_dest_ != nullptr) {
+    // The last block is written even when it is empty, so that a reader can
+    // tell a complete index from one whose writer did not finish.
+    Status s = WriteIndexBlock();
+    index_dest_ = nullptr;
+    TF_RETURN_IF_ERROR(s);
+  }
   if (dest_ == nullptr) return Status::OK();
   if (IsZlibCompressed(options_) || IsSnappyCompressed(options_)) {
     Status s = dest_->Close();
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_LIB_IO_RECORD_WRITER_H_
 #define TENSORFLOW_CORE_LIB_IO_RECORD_WRITER_H_
 
+#include <vector>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
@@ -53,6 +55,13 @@ struct RecordWriterOptions {
   tensorflow::io::ZlibCompressionOptions zlib_options;
   tensorflow::io::SnappyCompressionOptions snappy_options;
 #endif  // IS_SLIM_BUILD
+
+  // If non-null, the writer also appends a record-offset index to
+  // "*index_file" so that RecordReader::ReadRecordByNumber() can read any
+  // record without scanning the file. See RecordWriter for its format.
+  // "*index_file" must be initially empty and must remain live while the
+  // writer is in use.
+  WritableFile* index_file = nullptr;
 };
 
 class RecordWriter {
@@ -65,6 +74,24 @@ class RecordWriter {
   static constexpr size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
   static constexpr size_t kFooterSize = sizeof(uint32);
 
+  // Format of the index file (conventionally named "<file>.tfrindex"):
+  //  block     blocks[...]
+  //
+  // Format of a single index block:
+  //  uint32    number of offsets n, at most kIndexBlockSize
+  //  uint64    offsets[n]
+  //  uint32    masked crc of the preceding 4 + 8 * n bytes
+  //
+  // The offsets are those accepted by RecordReader::ReadRecord(), i.e. they
+  // refer to the uncompressed record stream. All blocks but the last one hold
+  // kIndexBlockSize offsets, so record i is indexed by block
+  // i / kIndexBlockSize, which starts at byte i / kIndexBlockSize *
+  // kIndexBlockBytes. Close() always writes a last block holding fewer than
+  // kIndexBlockSize offsets (possibly none) to mark the index as complete.
+  static constexpr size_t kIndexBlockSize = 1024;
+  static constexpr size_t kIndexBlockBytes =
+      sizeof(uint32) + kIndexBlockSize * sizeof(uint64) + sizeof(uint32);
+
   // Create a writer that will append data to "*dest".
   // "*dest" must be initially empty.
   // "*dest" must remain live while this Writer is in use.
@@ -88,7 +115,9 @@ class RecordWriter {
   // WritableFile.
   Status Flush();
 
-  // Writes all output to the file. Does *not* close the WritableFile.
+  // Writes all output to the file, and the last block of the index if
+  // options.index_file is set. Does *not* close the WritableFile nor the
+  // index file.
   //
   // After calling Close(), any further calls to `WriteRecord()` or `Flush()`
   // are invalid.
@@ -111,9 +140,22 @@ class RecordWriter {
 #endif
 
  private:
+  // Adds the record just written, which starts at index_offset_ and holds
+  // "n" bytes of data, to the index.
+  Status IndexRecord(size_t n);
+  // Appends the offsets in index_block_ to the index file as one block.
+  Status WriteIndexBlock();
+
   WritableFile* dest_;
   RecordWriterOptions options_;
 
+  // Set to nullptr once the last index block has been written by Close().
+  WritableFile* index_dest_;
+  // Offset of the next record in the uncompressed record stream.
+  uint64 index_offset_ = 0;
+  // Offsets of the records indexed by the block being built.
+  std::vector<uint64> index_block_;
+
   inline static uint32 MaskedCrc(const char* data, size_t n) {
     return crc32c::Mask(crc32c::Value(data, n));
   }
@@ -26,6 +26,7 @@ class RandomAccessFile;
 
 namespace table {
 
+class Footer;
 struct Options;
 
 // A Table is a sorted map from strings to strings.  Tables are
@@ -61,6 +62,12 @@ class Table {
   // be close to the file length.
   uint64 ApproximateOffsetOf(const StringPiece& key) const;
 
+  // Returns false if the table certainly does not contain "key", according to
+  // the filter of the data block that would hold it.  Returns true if the
+  // table may contain "key", or if it has no filter for the filter policy of
+  // its options.  Only reads the in-memory index and filter blocks.
+  bool KeyMayMatch(const StringPiece& key) const;
+
  private:
   struct Rep;
   Rep* rep_;
@@ -68,6 +75,11 @@ class Table {
   explicit Table(Rep* rep) { rep_ = rep; }
   static Iterator* BlockReader(void*, const StringPiece&);
 
+  // Reads the filter block of the table, if any, ignoring errors since it is
+  // only an optimization.
+  void ReadMeta(const Footer& footer);
+  void ReadFilter(const StringPiece& filter_handle_value);
+
   // Calls (*handle_result)(arg, ...) with the entry found after a call
   // to Seek(key).  May not make such a call if filter policy says
   // that key is not present.
@@ -17,11 +17,13 @@ limitations under the License.
 #define TENSORFLOW_CORE_LIB_IO_TABLE_OPTIONS_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
 namespace tensorflow {
 namespace table {
 
 class Cache;
+class FilterPolicy;
 
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
@@ -68,6 +70,17 @@ struct Options {
 
   // If non-null, use the specified cache for blocks.
   Cache* block_cache = nullptr;
+
+  // If non-zero, the blocks of the table are cached in block_cache under this
+  // id, e.g. to share them between the tables opened from the same file.
+  // Otherwise the table gets a new id from block_cache->NewId().
+  uint64_t block_cache_id = 0;
+
+  // If non-null, use the specified filter policy to reduce disk reads.
+  // TableBuilder writes a filter block for the keys of each data block, and
+  // Table::KeyMayMatch() consults it when the table was built with a policy of
+  // the same name.
+  const FilterPolicy* filter_policy = nullptr;
 };
 
 }  // namespace table
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,10 +25,12 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/block.h"
 #include "tensorflow/core/lib/io/block_builder.h"
+#include "tensorflow/core/lib/io/filter_policy.h"
 #include "tensorflow/core/lib/io/format.h"
 #include "tensorflow/core/lib/io/iterator.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/test.h"
@@ -236,9 +239,14 @@ class TableConstructor : public Constructor {
     // Open the table
     source_ = new StringSource(sink.contents());
     Options table_options;
+    table_options.filter_policy = options.filter_policy;
     return Table::Open(table_options, source_, sink.contents().size(), &table_);
   }
 
+  bool KeyMayMatch(const StringPiece& key) const {
+    return table_->KeyMayMatch(key);
+  }
+
   Iterator* NewIterator() const override { return table_->NewIterator(); }
 
   uint64 ApproximateOffsetOf(const StringPiece& key) const {
@@ -633,5 +641,52 @@ TEST(TableTest, SeekToFirstKeyDoesNotReadTooMuch) {
   EXPECT_LT(c.BytesRead(), 200);
 }
 
+TEST(TableTest, BloomFilter) {
+  std::unique_ptr<const FilterPolicy> policy(NewBloomFilterPolicy(10));
+  TableConstructor c;
+  for (int i = 0; i < 1000; ++i) {
+    c.Add(strings::Printf("key%06d", i), "value");
+  }
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.block_size = 1024;
+  options.compression = kNoCompression;
+  options.filter_policy = policy.get();
+  c.Finish(options, &keys, &kvmap);
+
+  for (const string& key : keys) {
+    EXPECT_TRUE(c.KeyMayMatch(key)) << key;
+  }
+  int false_positives = 0;
+  for (int i = 0; i < 10000; ++i) {
+    if (c.KeyMayMatch(strings::Printf("key%06d.absent", i))) {
+      ++false_positives;
+    }
+  }
+  // About 1% of false positives are expected with 10 bits per key.
+  EXPECT_LT(false_positives, 300);
+
+  // The iterator ignores the filter.
+  Iterator* iter = c.NewIterator();
+  iter->Seek("key000500");
+  ASSERT_TRUE(iter->Valid());
+  EXPECT_EQ(iter->key(), "key000500");
+  delete iter;
+}
+
+TEST(TableTest, NoFilter) {
+  TableConstructor c;
+  c.Add("k01", "hello");
+  std::vector<string> keys;
+  KVMap kvmap;
+  Options options;
+  options.compression = kNoCompression;
+  c.Finish(options, &keys, &kvmap);
+  // Without filter, any key may match.
+  EXPECT_TRUE(c.KeyMayMatch("k01"));
+  EXPECT_TRUE(c.KeyMayMatch("k02"));
+}
+
 }  // namespace table
 }  // namespace tensorflow
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
@@ -162,6 +164,92 @@ TEST(ZlibBuffers, MultipleWriteCallsWithFlush) {
   TestMultipleWrites(200, 200, 10, true);
 }
 
+void TestParallelOutputBuffer(CompressionOptions options) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  string data = GenTestString(500);
+  for (int64_t block_size : {1, 100, 1000, 1 << 20}) {
+    std::unique_ptr<WritableFile> file_writer;
+    TF_ASSERT_OK(env->NewWritableFile(fname, &file_writer));
+    options.num_compression_threads = 4;
+    options.parallel_block_size = block_size;
+    ParallelZlibOutputBuffer out(file_writer.get(), options);
+    TF_ASSERT_OK(out.Init());
+    // Appends of various sizes, with a flush in the middle.
+    StringPiece remaining(data);
+    for (size_t n = 1; !remaining.empty(); n *= 3) {
+      const size_t size = std::min(n, remaining.size());
+      TF_ASSERT_OK(out.Append(remaining.substr(0, size)));
+      remaining.remove_prefix(size);
+      if (n == 243) TF_ASSERT_OK(out.Flush());
+    }
+    TF_ASSERT_OK(out.Close());
+    TF_ASSERT_OK(file_writer->Close());
+
+    std::unique_ptr<RandomAccessFile> file_reader;
+    TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file_reader));
+    std::unique_ptr<RandomAccessInputStream> input_stream(
+        new RandomAccessInputStream(file_reader.get()));
+    ZlibInputStream in(input_stream.get(), 1000, 1000, options);
+    tstring result;
+    TF_ASSERT_OK(in.ReadNBytes(data.size(), &result));
+    EXPECT_EQ(result, data);
+    EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &result)));
+  }
+}
+
+TEST(ZlibBuffers, ParallelDefaultOptions) {
+  TestParallelOutputBuffer(CompressionOptions::DEFAULT());
+}
+
+TEST(ZlibBuffers, ParallelRawDeflate) {
+  TestParallelOutputBuffer(CompressionOptions::RAW());
+}
+
+TEST(ZlibBuffers, ParallelGzip) {
+  TestParallelOutputBuffer(CompressionOptions::GZIP());
+}
+
+TEST(ZlibBuffers, ParallelOutputIsReadableByZlib) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  string data = GenTestString(100);
+  std::unique_ptr<WritableFile> file_writer;
+  TF_ASSERT_OK(env->NewWritableFile(fname, &file_writer));
+  CompressionOptions options = CompressionOptions::DEFAULT();
+  options.num_compression_threads = 2;
+  options.parallel_block_size = 4096;
+  ParallelZlibOutputBuffer out(file_writer.get(), options);
+  TF_ASSERT_OK(out.Init());
+  TF_ASSERT_OK(out.Append(data));
+  TF_ASSERT_OK(out.Close());
+  TF_ASSERT_OK(file_writer->Close());
+
+  string compressed;
+  TF_ASSERT_OK(ReadFileToString(env, fname, &compressed));
+  // Priming each block with the previous window keeps the output small.
+  EXPECT_LT(compressed.size(), data.size() / 10);
+  string uncompressed(data.size(), '\0');
+  uLongf uncompressed_size = uncompressed.size();
+  ASSERT_EQ(uncompress(reinterpret_cast<Bytef*>(&uncompressed[0]),
+                       &uncompressed_size,
+                       reinterpret_cast<const Bytef*>(compressed.data()),
+                       compressed.size()),
+            Z_OK);
+  EXPECT_EQ(uncompressed_size, data.size());
+  EXPECT_EQ(uncompressed, data);
+}
+
+TEST(ZlibBuffers, ParallelUnsupportedWindowBits) {
+  std::unique_ptr<WritableFile> file_writer;
+  CompressionOptions options = CompressionOptions::RAW();
+  options.window_bits = -8;
+  ParallelZlibOutputBuffer out(file_writer.get(), options);
+  EXPECT_TRUE(errors::IsInvalidArgument(out.Init()));
+}
+
 TEST(ZlibInputStream, FailsToReadIfWindowBitsAreIncompatible) {
   Env* env = Env::Default();
   string fname;
@@ -117,6 +117,15 @@ class ZlibCompressionOptions {
   //
   // This option is ignored for `ZlibOutputBuffer`.
   bool soft_fail_on_error = false;  // NOLINT
+
+  // Number of threads compressing the output. If greater than 1, writers use
+  // a `ParallelZlibOutputBuffer`, which deflates blocks of
+  // `parallel_block_size` input bytes concurrently. Its output is a single
+  // deflate stream, readable by any zlib or gzip reader.
+  //
+  // This option is ignored when reading.
+  int32 num_compression_threads = 1;
+  int64_t parallel_block_size = 128 << 10;
 };
 
 inline ZlibCompressionOptions ZlibCompressionOptions::DEFAULT() {
@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/strcat.h"
 
 namespace tensorflow {
 namespace io {
@@ -242,5 +245,271 @@ Status ZlibOutputBuffer::Tell(int64_t* position) {
   return file_->Tell(position);
 }
 
+namespace {
+
+// Returns the FLEVEL field of the zlib header, as deflate() computes it.
+int HeaderLevel(const ZlibCompressionOptions& zlib_options) {
+  const int level = zlib_options.compression_level == Z_DEFAULT_COMPRESSION
+                        ? 6
+                        : zlib_options.compression_level;
+  if (zlib_options.compression_strategy >= Z_HUFFMAN_ONLY || level < 2) {
+    return 0;
+  }
+  if (level < 6) return 1;
+  if (level == 6) return 2;
+  return 3;
+}
+
+void AppendBigEndian32(uint32 value, string* out) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out->push_back(static_cast<char>((value >> shift) & 0xff));
+  }
+}
+
+void AppendLittleEndian32(uint32 value, string* out) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    out->push_back(static_cast<char>((value >> shift) & 0xff));
+  }
+}
+
+}  // namespace
+
+ParallelZlibOutputBuffer::ParallelZlibOutputBuffer(
+    WritableFile* file, const ZlibCompressionOptions& zlib_options, Env* env)
+    : file_(file),
+      zlib_options_(zlib_options),
+      env_(env),
+      block_size_(zlib_options.parallel_block_size) {}
+
+ParallelZlibOutputBuffer::~ParallelZlibOutputBuffer() {
+  if (thread_pool_ != nullptr && !closed_) {
+    LOG(WARNING) << "ParallelZlibOutputBuffer::Close() not called. Possible "
+                    "data loss";
+  }
+}
+
+Status ParallelZlibOutputBuffer::Init() {
+  const int window_bits = zlib_options_.window_bits;
+  if (window_bits < 0) {
+    format_ = RAW;
+    window_bits_ = -window_bits;
+  } else if (window_bits > MAX_WBITS) {
+    format_ = GZIP;
+    window_bits_ = window_bits - 16;
+  } else {
+    format_ = ZLIB;
+    window_bits_ = window_bits;
+  }
+  // deflate() does not support a window of 256 bytes for raw streams.
+  if (window_bits_ < 9 || window_bits_ > MAX_WBITS) {
+    return errors::InvalidArgument(
+        "Unsupported window_bits for parallel compression: ", window_bits);
+  }
+  if (zlib_options_.compression_method != Z_DEFLATED) {
+    return errors::InvalidArgument("Unsupported compression_method: ",
+                                   zlib_options_.compression_method);
+  }
+  if (zlib_options_.num_compression_threads < 1 || block_size_ < 1) {
+    return errors::InvalidArgument(
+        "num_compression_threads and parallel_block_size must be positive");
+  }
+
+  string header;
+  if (format_ == ZLIB) {
+    // CMF holds the method and the window size, FLG the level and a check
+    // making the 16-bit header a multiple of 31.
+    uint32 cmf_flg = (((window_bits_ - 8) << 4 | Z_DEFLATED) << 8) |
+                     (HeaderLevel(zlib_options_) << 6);
+    cmf_flg += 31 - cmf_flg % 31;
+    header.push_back(static_cast<char>(cmf_flg >> 8));
+    header.push_back(static_cast<char>(cmf_flg & 0xff));
+    check_ = adler32(0L, Z_NULL, 0);
+  } else if (format_ == GZIP) {
+    // Magic number, method, no flags, no modification time, no extra flags
+    // and unknown operating system.
+    header.assign("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+    check_ = crc32(0L, Z_NULL, 0);
+  }
+  TF_RETURN_IF_ERROR(file_->Append(header));
+  input_.reserve(block_size_);
+  thread_pool_.reset(new thread::ThreadPool(
+      env_, ThreadOptions(), "parallel_zlib_output_buffer",
+      zlib_options_.num_compression_threads));
+  return Status::OK();
+}
+
+void ParallelZlibOutputBuffer::CompressBlock(Block* block) const {
+  if (format_ == ZLIB) {
+    block->check = adler32(adler32(0L, Z_NULL, 0),
+                           reinterpret_cast<const Bytef*>(block->input.data()),
+                           block->input.size());
+  } else if (format_ == GZIP) {
+    block->check = crc32(crc32(0L, Z_NULL, 0),
+                         reinterpret_cast<const Bytef*>(block->input.data()),
+                         block->input.size());
+  }
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  int error = deflateInit2(&stream, zlib_options_.compression_level,
+                           Z_DEFLATED, -window_bits_, zlib_options_.mem_level,
+                           zlib_options_.compression_strategy);
+  if (error != Z_OK) {
+    block->status =
+        errors::InvalidArgument("deflateInit failed with status ", error);
+    return;
+  }
+  if (!block->dictionary.empty()) {
+    deflateSetDictionary(
+        &stream, reinterpret_cast<const Bytef*>(block->dictionary.data()),
+        block->dictionary.size());
+  }
+  // deflateBound() does not account for the sync flush marker.
+  block->output.resize(deflateBound(&stream, block->input.size()) + 16);
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(block->input.data()));
+  stream.avail_in = block->input.size();
+  const int flush = block->last ? Z_FINISH : Z_SYNC_FLUSH;
+  size_t output_size = 0;
+  while (true) {
+    stream.next_out = reinterpret_cast<Bytef*>(&block->output[output_size]);
+    stream.avail_out = block->output.size() - output_size;
+    error = deflate(&stream, flush);
+    output_size = block->output.size() - stream.avail_out;
+    if (error == Z_STREAM_END ||
+        (error == Z_OK && flush == Z_SYNC_FLUSH && stream.avail_out > 0)) {
+      break;
+    }
+    if (error != Z_OK && error != Z_BUF_ERROR) {
+      block->status = errors::DataLoss("deflate() failed with error ", error);
+      break;
+    }
+    block->output.resize(2 * block->output.size());
+  }
+  deflateEnd(&stream);
+  block->output.resize(output_size);
+  string().swap(block->dictionary);
+}
+
+Status ParallelZlibOutputBuffer::ScheduleBlock(bool last) {
+  const size_t window_size = size_t{1} << window_bits_;
+  std::unique_ptr<Block> block(new Block);
+  block->dictionary = dictionary_;
+  block->last = last;
+  block->input.swap(input_);
+  input_.reserve(block_size_);
+  if (block->input.size() >= window_size) {
+    dictionary_.assign(block->input, block->input.size() - window_size,
+                       window_size);
+  } else {
+    dictionary_.append(block->input);
+    if (dictionary_.size() > window_size) {
+      dictionary_.erase(0, dictionary_.size() - window_size);
+    }
+  }
+
+  Block* scheduled = block.get();
+  {
+    mutex_lock l(mu_);
+    pending_.push_back(std::move(block));
+  }
+  thread_pool_->Schedule([this, scheduled]() {
+    CompressBlock(scheduled);
+    mutex_lock l(mu_);
+    scheduled->done = true;
+    block_done_.notify_all();
+  });
+  // Bounds the memory held by pending blocks while keeping all threads busy.
+  return WriteBlocks(2 * zlib_options_.num_compression_threads);
+}
+
+Status ParallelZlibOutputBuffer::WriteBlocks(size_t max_pending) {
+  while (true) {
+    std::unique_ptr<Block> block;
+    {
+      mutex_lock l(mu_);
+      if (pending_.empty()) return Status::OK();
+      if (!pending_.front()->done) {
+        if (pending_.size() <= max_pending) return Status::OK();
+        block_done_.wait(l);
+        continue;
+      }
+      block = std::move(pending_.front());
+      pending_.pop_front();
+    }
+    TF_RETURN_IF_ERROR(block->status);
+    if (format_ == ZLIB) {
+      check_ = adler32_combine(check_, block->check, block->input.size());
+    } else if (format_ == GZIP) {
+      check_ = crc32_combine(check_, block->check, block->input.size());
+    }
+    input_bytes_ += block->input.size();
+    TF_RETURN_IF_ERROR(file_->Append(block->output));
+  }
+}
+
+Status ParallelZlibOutputBuffer::Append(StringPiece data) {
+  if (closed_) {
+    return errors::FailedPrecondition("Append() called after Close()");
+  }
+  while (!data.empty()) {
+    const size_t n = std::min(block_size_ - input_.size(), data.size());
+    input_.append(data.data(), n);
+    data.remove_prefix(n);
+    if (input_.size() == block_size_) {
+      TF_RETURN_IF_ERROR(ScheduleBlock(/*last=*/false));
+    }
+  }
+  return Status::OK();
+}
+
+#if defined(TF_CORD_SUPPORT)
+Status ParallelZlibOutputBuffer::Append(const absl::Cord& cord) {
+  for (absl::string_view fragment : cord.Chunks()) {
+    TF_RETURN_IF_ERROR(Append(fragment));
+  }
+  return Status::OK();
+}
+#endif
+
+Status ParallelZlibOutputBuffer::Flush() {
+  if (closed_) {
+    return errors::FailedPrecondition("Flush() called after Close()");
+  }
+  if (!input_.empty()) {
+    TF_RETURN_IF_ERROR(ScheduleBlock(/*last=*/false));
+  }
+  TF_RETURN_IF_ERROR(WriteBlocks(0));
+  return file_->Flush();
+}
+
+Status ParallelZlibOutputBuffer::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+Status ParallelZlibOutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+Status ParallelZlibOutputBuffer::Close() {
+  if (closed_) return Status::OK();
+  closed_ = true;
+  TF_RETURN_IF_ERROR(ScheduleBlock(/*last=*/true));
+  TF_RETURN_IF_ERROR(WriteBlocks(0));
+  string trailer;
+  if (format_ == ZLIB) {
+    AppendBigEndian32(check_, &trailer);
+  } else if (format_ == GZIP) {
+    AppendLittleEndian32(check_, &trailer);
+    AppendLittleEndian32(static_cast<uint32>(input_bytes_), &trailer);
+  }
+  return file_->Append(trailer);
+}
+
+Status ParallelZlibOutputBuffer::Tell(int64_t* position) {
+  return file_->Tell(position);
+}
+
 }  // namespace io
 }  // namespace tensorflow
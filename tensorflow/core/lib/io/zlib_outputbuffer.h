@@ -18,6 +18,8 @@ limitations under the License.
 
 #include <zlib.h>
 
+#include <deque>
+#include <memory>
 #include <string>
 
 #include "tensorflow/core/lib/core/status.h"
@@ -26,6 +28,9 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -152,6 +157,116 @@ class ZlibOutputBuffer : public WritableFile {
   TF_DISALLOW_COPY_AND_ASSIGN(ZlibOutputBuffer);
 };
 
+// A WritableFile that compresses its input with zlib on several threads, in
+// the manner of pigz (https://zlib.net/pigz/).
+//
+// The input is split into blocks of `zlib_options.parallel_block_size`
+// bytes, which are raw-deflated concurrently on
+// `zlib_options.num_compression_threads` threads. Each block is primed with
+// the last window of input of the previous block, so the compression ratio
+// is close to the one of ZlibOutputBuffer, and ends with a sync flush so
+// that the compressed blocks can be concatenated. The zlib or gzip header
+// and trailer selected by `zlib_options.window_bits` are written around the
+// blocks, and the checksums of the blocks are combined. The output is thus a
+// single deflate stream, which ZlibInputStream (or any other zlib reader)
+// decompresses.
+//
+// `zlib_options.flush_mode` and the buffer sizes are ignored.
+//
+// A given instance of a ParallelZlibOutputBuffer is NOT safe for concurrent
+// use by multiple threads.
+class ParallelZlibOutputBuffer : public WritableFile {
+ public:
+  // Does not take ownership of `file`.
+  ParallelZlibOutputBuffer(WritableFile* file,
+                           const ZlibCompressionOptions& zlib_options,
+                           Env* env = Env::Default());
+
+  // Waits for the blocks being compressed.
+  ~ParallelZlibOutputBuffer() override;
+
+  // Checks the options and writes the stream header. This call is required
+  // before any other operation on the buffer.
+  Status Init();
+
+  // Adds `data` to the current block, and schedules the compression of the
+  // block once it is full. Blocks only when too many blocks are pending.
+  Status Append(StringPiece data) override;
+
+#if defined(TF_CORD_SUPPORT)
+  Status Append(const absl::Cord& cord) override;
+#endif
+
+  // Compresses the current block, and writes all compressed blocks to file.
+  Status Flush() override;
+
+  // Compresses the last block and writes it to file with the stream trailer.
+  // This must be called before the destructor to avoid any data loss. Any
+  // further call to `Append()` or `Flush()` will fail.
+  Status Close() override;
+
+  // Returns the name of the underlying file.
+  Status Name(StringPiece* result) const override;
+
+  // Flushes the buffer and syncs the underlying file.
+  Status Sync() override;
+
+  // Returns the write position in the underlying file. The position does not
+  // reflect pending blocks.
+  Status Tell(int64_t* position) override;
+
+ private:
+  enum Format { RAW, ZLIB, GZIP };
+
+  struct Block {
+    string input;
+    // The window of input preceding this block.
+    string dictionary;
+    bool last = false;
+    string output;
+    // The crc32 (for gzip) or adler32 (for zlib) of `input`.
+    uLong check = 0;
+    Status status;
+    bool done = false;
+  };
+
+  // Raw-deflates `block->input` into `block->output`.
+  void CompressBlock(Block* block) const;
+
+  // Schedules the compression of the current block.
+  Status ScheduleBlock(bool last);
+
+  // Writes the compressed blocks to file, in order, waiting for blocks until
+  // at most `max_pending` are left.
+  Status WriteBlocks(size_t max_pending);
+
+  WritableFile* file_;  // Not owned
+  const ZlibCompressionOptions zlib_options_;
+  Env* const env_;
+  Format format_ = ZLIB;
+  int window_bits_ = MAX_WBITS;
+  size_t block_size_;
+  bool closed_ = false;
+
+  // The input of the current block, and the window preceding it.
+  string input_;
+  string dictionary_;
+
+  // The combined checksum and size of the input written so far.
+  uLong check_ = 0;
+  uint64 input_bytes_ = 0;
+
+  mutex mu_;
+  condition_variable block_done_;
+  // The blocks scheduled and not yet written, in order.
+  std::deque<std::unique_ptr<Block>> pending_ TF_GUARDED_BY(mu_);
+
+  // Declared last so that it is destroyed, waiting for its closures, first.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ParallelZlibOutputBuffer);
+};
+
 }  // namespace io
 }  // namespace tensorflow
 
@@ -191,6 +191,8 @@ class PhiloxRandom {
   }
 
  private:
+  friend class PhiloxRandomBatch;
+
   // We use the same constants as recommended by the original paper.
   static constexpr uint32_t kPhiloxW32A = 0x9E3779B9;
   static constexpr uint32_t kPhiloxW32B = 0xBB67AE85;
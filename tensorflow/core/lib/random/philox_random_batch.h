@@ -0,0 +1,135 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Generates the outputs of PhiloxRandom for many counters at once on CPU.
+
+#ifndef TENSORFLOW_CORE_LIB_RANDOM_PHILOX_RANDOM_BATCH_H_
+#define TENSORFLOW_CORE_LIB_RANDOM_PHILOX_RANDOM_BATCH_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "tensorflow/core/lib/random/philox_random.h"
+
+namespace tensorflow {
+namespace random {
+
+// Runs the rounds of philox_4x32_10 for kLanes counters side by side. The
+// state of every word is kept in its own array of lanes, so that each step of
+// a round is a loop over the lanes that the compiler turns into SIMD code
+// (the 32x32->64 bit multiplications map to pmuludq on SSE, AVX2 and
+// AVX-512). The results are bit-exact with PhiloxRandom.
+//
+// For example, the following two loops fill `blocks` with the same values:
+//
+//   PhiloxRandom::ResultType blocks[n];
+//   PhiloxRandom copy = gen;
+//   for (int i = 0; i < n; ++i) blocks[i] = copy();
+//
+//   PhiloxRandomBatch::Generate(gen, /*stride=*/1, n, blocks);
+class PhiloxRandomBatch {
+ public:
+  using ResultType = PhiloxRandom::ResultType;
+
+  // The number of counters that are processed together.
+  static constexpr int kLanes = 16;
+
+  // Writes to `output[i]`, for i in [0, count), the block that `gen` returns
+  // after skipping `i * stride` blocks. `gen` itself is not advanced.
+  static void Generate(const PhiloxRandom& gen, uint64_t stride, int64_t count,
+                       ResultType* output) {
+    for (int64_t begin = 0; begin < count; begin += kLanes) {
+      const int lanes =
+          static_cast<int>(std::min<int64_t>(kLanes, count - begin));
+      GenerateLanes(gen, stride, begin, lanes, output + begin);
+    }
+  }
+
+ private:
+  static void GenerateLanes(const PhiloxRandom& gen, uint64_t stride,
+                            int64_t begin, int lanes, ResultType* output) {
+    alignas(64) uint32_t c0[kLanes], c1[kLanes], c2[kLanes], c3[kLanes];
+    for (int i = 0; i < kLanes; ++i) {
+      // Unused lanes repeat the last counter, their results are dropped.
+      PhiloxRandom lane = gen;
+      lane.Skip((begin + std::min(i, lanes - 1)) * stride);
+      const ResultType& counter = lane.counter();
+      c0[i] = counter[0];
+      c1[i] = counter[1];
+      c2[i] = counter[2];
+      c3[i] = counter[3];
+    }
+
+    uint32_t key0 = gen.key()[0];
+    uint32_t key1 = gen.key()[1];
+    for (int round = 0; round < 10; ++round) {
+      for (int i = 0; i < kLanes; ++i) {
+        const uint64_t product0 =
+            static_cast<uint64_t>(PhiloxRandom::kPhiloxM4x32A) * c0[i];
+        const uint64_t product1 =
+            static_cast<uint64_t>(PhiloxRandom::kPhiloxM4x32B) * c2[i];
+        const uint32_t next0 =
+            static_cast<uint32_t>(product1 >> 32) ^ c1[i] ^ key0;
+        const uint32_t next2 =
+            static_cast<uint32_t>(product0 >> 32) ^ c3[i] ^ key1;
+        c1[i] = static_cast<uint32_t>(product1);
+        c3[i] = static_cast<uint32_t>(product0);
+        c0[i] = next0;
+        c2[i] = next2;
+      }
+      key0 += PhiloxRandom::kPhiloxW32A;
+      key1 += PhiloxRandom::kPhiloxW32B;
+    }
+
+    for (int i = 0; i < lanes; ++i) {
+      output[i][0] = c0[i];
+      output[i][1] = c1[i];
+      output[i][2] = c2[i];
+      output[i][3] = c3[i];
+    }
+  }
+};
+
+// Returns blocks that were generated ahead of time by PhiloxRandomBatch, and
+// then those of `gen` once they run out, with the interface of PhiloxRandom.
+// It lets the distributions, which are templated on their generator, consume
+// batch generated blocks unchanged.
+class PrefetchedPhiloxRandom {
+ public:
+  using ResultType = PhiloxRandom::ResultType;
+  using ResultElementType = PhiloxRandom::ResultElementType;
+  static constexpr int kResultElementCount = PhiloxRandom::kResultElementCount;
+  static constexpr int kElementCost = PhiloxRandom::kElementCost;
+
+  // `gen` must already be positioned after the `count` blocks of `blocks`.
+  PrefetchedPhiloxRandom(const ResultType* blocks, int count,
+                         const PhiloxRandom& gen)
+      : next_(blocks), end_(blocks + count), gen_(gen) {}
+
+  ResultType operator()() {
+    if (next_ != end_) return *next_++;
+    return gen_();
+  }
+
+ private:
+  const ResultType* next_;
+  const ResultType* end_;
+  PhiloxRandom gen_;
+};
+
+}  // namespace random
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_RANDOM_PHILOX_RANDOM_BATCH_H_
@@ -21,6 +21,7 @@ limitations under the License.
 #include <unordered_map>
 #include <vector>
 
+#include "tensorflow/core/lib/random/philox_random_batch.h"
 #include "tensorflow/core/lib/random/philox_random_test_utils.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
@@ -68,6 +69,61 @@ TEST(PhiloxRandomTest, SkipMatchTest) {
   }
 }
 
+// Checks that the blocks of the batch generator are those of PhiloxRandom,
+// including for counts that do not fill the last set of lanes.
+TEST(PhiloxRandomBatchTest, MatchesSequentialGeneration) {
+  uint64 test_seed = GetTestSeed();
+  for (int count : {1, 5, PhiloxRandomBatch::kLanes, 37, 256}) {
+    PhiloxRandom gen(test_seed);
+    gen.Skip(test_seed % 1000);
+    std::vector<PhiloxRandom::ResultType> blocks(count);
+    PhiloxRandomBatch::Generate(gen, /*stride=*/1, count, blocks.data());
+    for (int i = 0; i < count; ++i) {
+      PhiloxRandom::ResultType expected = gen();
+      for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+        ASSERT_EQ(expected[j], blocks[i][j]) << count << " " << i;
+      }
+    }
+  }
+}
+
+TEST(PhiloxRandomBatchTest, MatchesSkip) {
+  uint64 test_seed = GetTestSeed();
+  constexpr int count = 45;
+  // Strides that carry into the upper words of the counter.
+  for (uint64 stride : {3ULL, 1024ULL, 1ULL << 40}) {
+    PhiloxRandom gen(test_seed);
+    std::vector<PhiloxRandom::ResultType> blocks(count);
+    PhiloxRandomBatch::Generate(gen, stride, count, blocks.data());
+    for (int i = 0; i < count; ++i) {
+      PhiloxRandom skipped = gen;
+      skipped.Skip(i * stride);
+      PhiloxRandom::ResultType expected = skipped();
+      for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+        ASSERT_EQ(expected[j], blocks[i][j]) << stride << " " << i;
+      }
+    }
+  }
+}
+
+TEST(PrefetchedPhiloxRandomTest, ContinuesWithGenerator) {
+  uint64 test_seed = GetTestSeed();
+  constexpr int prefetched = 3;
+  PhiloxRandom gen(test_seed);
+  PhiloxRandom::ResultType blocks[prefetched];
+  PhiloxRandomBatch::Generate(gen, /*stride=*/1, prefetched, blocks);
+  PhiloxRandom rest = gen;
+  rest.Skip(prefetched);
+  PrefetchedPhiloxRandom prefetched_gen(blocks, prefetched, rest);
+  for (int i = 0; i < 2 * prefetched; ++i) {
+    PhiloxRandom::ResultType expected = gen();
+    PhiloxRandom::ResultType actual = prefetched_gen();
+    for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+      ASSERT_EQ(expected[j], actual[j]) << i;
+    }
+  }
+}
+
 }  // namespace
 }  // namespace random
 }  // namespace tensorflow
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/nccl/nccl_manager.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <limits>
 #include <utility>
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -22,12 +25,14 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/unbounded_work_queue.h"
 #include "tensorflow/core/profiler/lib/annotated_traceme.h"
 #include "tensorflow/core/profiler/lib/connected_traceme.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/env_var.h"
 #if GOOGLE_CUDA
 #include "tensorflow/stream_executor/cuda/cuda_activation.h"
 #elif TENSORFLOW_USE_ROCM
@@ -91,8 +96,10 @@ struct NcclManager::NcclStream : public core::RefCounted {
   // signals `cv` to unblock the thread waiting on more collectives.
   mutex mu;
   condition_variable cv;
-  // Has (collective, participant_idx) pairs.
-  std::deque<std::pair<Collective*, int>> pending_launches_ TF_GUARDED_BY(mu);
+  // Has (collectives, participant_idx) pairs. The kernels of the collectives
+  // of one entry, which share a communicator, are launched in one NCCL group.
+  std::deque<std::pair<std::vector<Collective*>, int>> pending_launches_
+      TF_GUARDED_BY(mu);
   bool shutdown_requested TF_GUARDED_BY(mu) = false;
 };
 
@@ -121,6 +128,34 @@ struct NcclManager::Communicator {
 
 namespace {
 
+auto* nccl_collectives = monitoring::Counter<0>::New(
+    "/tensorflow/core/nccl/collectives",
+    "The number of collectives launched by NcclManagers.");
+
+auto* nccl_launches = monitoring::Counter<0>::New(
+    "/tensorflow/core/nccl/launches",
+    "The number of groups of collectives whose kernels were launched together "
+    "by NcclManagers, one per collective when they are not fused.");
+
+auto* nccl_communicators_created = monitoring::Counter<0>::New(
+    "/tensorflow/core/nccl/communicators_created",
+    "The number of NCCL communicators created by NcclManagers. The "
+    "communicators are reused by the collectives on the same devices or with "
+    "the same communicator key.");
+
+NcclManager::Options OptionsFromEnv() {
+  NcclManager::Options options;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_NCCL_FUSION_WINDOW_US",
+                                  options.fusion_window_us,
+                                  &options.fusion_window_us));
+  int64_t max_fused_collectives;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_NCCL_MAX_FUSED_COLLECTIVES",
+                                  options.max_fused_collectives,
+                                  &max_fused_collectives));
+  options.max_fused_collectives = max_fused_collectives;
+  return options;
+}
+
 static constexpr DataTypeSet kValidDataTypes =
     ToSet(DT_HALF) | ToSet(DT_FLOAT) | ToSet(DT_DOUBLE) | ToSet(DT_INT32) |
     ToSet(DT_INT64);
@@ -225,8 +260,11 @@ struct NcclManager::Collective : public core::RefCounted {
   Status status;
 };
 
-NcclManager::NcclManager() {
-  VLOG(2) << "New NcclManager " << this;
+NcclManager::NcclManager() : NcclManager(OptionsFromEnv()) {}
+
+NcclManager::NcclManager(const Options& options) : options_(options) {
+  VLOG(2) << "New NcclManager " << this << " with fusion window "
+          << options_.fusion_window_us << "us";
 #if TENSORFLOW_USE_ROCM
   ++instance_count;
 #endif
@@ -236,6 +274,15 @@ NcclManager::~NcclManager() {
 #if TENSORFLOW_USE_ROCM
   --instance_count;
 #endif
+  // Launches the fused collectives still waiting, before the streams stop.
+  std::unique_ptr<Thread> fusion_thread;
+  {
+    mutex_lock l(fusion_mu_);
+    fusion_shutdown_ = true;
+    fusion_cv_.notify_all();
+    fusion_thread = std::move(fusion_thread_);
+  }
+  fusion_thread.reset();
   for (auto& it : device_to_comm_streams_) {
     for (NcclStream* nccl_stream : it.second) {
       {
@@ -423,6 +470,7 @@ Status NcclManager::GetCommunicator(NcclManager::Collective* collective,
   for (int i = 0; i < collective->num_local_devices; ++i) {
     members[i].nccl_comm = nccl_comms[i];
   }
+  nccl_communicators_created->GetCell()->IncrementBy(1);
   communicators_.emplace_back(
       new Communicator(std::move(members), collective->communicator_key));
   *communicator = communicators_.back().get();
@@ -615,8 +663,6 @@ void NcclManager::RunCollective(Collective* collective) {
   tensorflow::profiler::TraceMeProducer traceme("Schedule Collective");
   collective->trace_context = traceme.GetContextId();
 
-  static mutex collective_mu(LINKER_INITIALIZED);
-
   Status status = collective->status;
   if (status.ok()) {
     status = GetCommunicator(collective, &collective->communicator);
@@ -661,24 +707,102 @@ void NcclManager::RunCollective(Collective* collective) {
     return;
   }
 
+#if NCCL_MAJOR >= 2
+  // Multi-node collectives are not fused, as the other nodes could group
+  // them differently.
+  if (options_.fusion_window_us > 0 && options_.max_fused_collectives > 1 &&
+      collective->single_node) {
+    AddToFusedLaunch(collective);
+    return;
+  }
+#endif
+  EnqueueLaunches({collective});
+}
+
+void NcclManager::EnqueueLaunches(std::vector<Collective*> collectives) {
+  static mutex collective_mu(LINKER_INITIALIZED);
+  Communicator* communicator = collectives.front()->communicator;
+  nccl_collectives->GetCell()->IncrementBy(collectives.size());
+  nccl_launches->GetCell()->IncrementBy(1);
   {
     // Allow only one collective at a time to queue kernels for launching. This
     // is to prevent collectives from deadlocking each other.
     // Note that it would be possible to run multiple collectives at once, if
     // they have non-intersecting sets of devices.
     mutex_lock l(collective_mu);
-    for (int i = 0; i < collective->num_local_devices; ++i) {
-      NcclStream* nccl_stream =
-          collective->communicator->members[i].nccl_stream;
+    for (int i = 0; i < communicator->num_devices; ++i) {
+      NcclStream* nccl_stream = communicator->members[i].nccl_stream;
       mutex_lock l(nccl_stream->mu);
-      nccl_stream->pending_launches_.push_front(std::make_pair(collective, i));
+      nccl_stream->pending_launches_.push_front(std::make_pair(collectives, i));
       // Ownership is shared between LoopKernelLaunches for each stream in this
       // collective.
-      collective->Ref();
+      for (Collective* collective : collectives) collective->Ref();
       nccl_stream->cv.notify_all();
     }
   }
-  collective->Unref();
+  for (Collective* collective : collectives) collective->Unref();
+}
+
+void NcclManager::AddToFusedLaunch(Collective* collective) {
+  std::vector<Collective*> full_launch;
+  {
+    mutex_lock l(fusion_mu_);
+    if (fusion_thread_ == nullptr) {
+      fusion_thread_.reset(Env::Default()->StartThread(
+          ThreadOptions(), "nccl_fusion", [this]() { LoopFusedLaunches(); }));
+    }
+    VLOG(2) << "Fusing collective " << collective->collective_key;
+    FusedLaunch& launch = fused_launches_[collective->communicator];
+    if (launch.collectives.empty()) {
+      launch.deadline_micros =
+          Env::Default()->NowMicros() + options_.fusion_window_us;
+      fusion_cv_.notify_all();
+    }
+    launch.collectives.push_back(collective);
+    if (launch.collectives.size() >=
+        static_cast<size_t>(options_.max_fused_collectives)) {
+      full_launch = std::move(launch.collectives);
+      fused_launches_.erase(collective->communicator);
+    }
+  }
+  if (!full_launch.empty()) EnqueueLaunches(std::move(full_launch));
+}
+
+void NcclManager::LoopFusedLaunches() {
+  while (true) {
+    std::vector<std::vector<Collective*>> ready_launches;
+    {
+      mutex_lock l(fusion_mu_);
+      if (fused_launches_.empty()) {
+        if (fusion_shutdown_) return;
+        fusion_cv_.wait(l);
+        continue;
+      }
+      const uint64 now_micros = Env::Default()->NowMicros();
+      uint64 next_deadline_micros = std::numeric_limits<uint64>::max();
+      for (auto it = fused_launches_.begin(); it != fused_launches_.end();) {
+        if (fusion_shutdown_ || it->second.deadline_micros <= now_micros) {
+          ready_launches.push_back(std::move(it->second.collectives));
+          fused_launches_.erase(it++);
+        } else {
+          next_deadline_micros =
+              std::min(next_deadline_micros, it->second.deadline_micros);
+          ++it;
+        }
+      }
+      if (ready_launches.empty()) {
+        fusion_cv_.wait_for(l, std::chrono::microseconds(next_deadline_micros -
+                                                         now_micros));
+        continue;
+      }
+    }
+    // Each group is queued on all of its streams at once, so the groups of
+    // different communicators are launched in the same order on the streams
+    // they share.
+    for (std::vector<Collective*>& collectives : ready_launches) {
+      EnqueueLaunches(std::move(collectives));
+    }
+  }
 }
 
 namespace {
@@ -705,30 +829,12 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
   const cudaStream_t* cu_stream = reinterpret_cast<const cudaStream_t*>(
       comm_stream->implementation()->GpuStreamMemberHack());
 
-  while (true) {
-    // Find collective to run.
-    std::pair<Collective*, int> next_launch;
-    {
-      VLOG(3) << "Locking mutex nccl_stream " << nccl_stream;
-      mutex_lock l(nccl_stream->mu);
-      while (nccl_stream->pending_launches_.empty()) {
-        if (nccl_stream->shutdown_requested) {
-          // No work and shutdown requested, exit.
-          return;
-        }
-        nccl_stream->cv.wait(l);
-      }
-      next_launch = nccl_stream->pending_launches_.back();
-      nccl_stream->pending_launches_.pop_back();
-    }
-
-    // Launch the nccl kernel.
-    Collective* collective = next_launch.first;
+  // Launches the nccl kernel of participant `p_idx` of `collective`.
+  auto launch_kernel = [&](Collective* collective, int p_idx) -> Status {
     tensorflow::profiler::TraceMeConsumer traceme("Run Collective",
                                                   collective->trace_context);
 
     ncclDataType_t data_type = ToNcclType(collective->data_type);
-    int p_idx = next_launch.second;
     Participant* p = collective->participants[p_idx].get();
     auto nccl_comm = collective->communicator->members[p_idx].nccl_comm;
     ncclResult_t nccl_result = ncclSuccess;
@@ -770,10 +876,8 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
           recvbuff = const_cast<void*>(sendbuff);
         }
         if (num_elements < 0) {
-          p->done_callback(errors::Internal(
-              "Both input and output are null in ncclBroadcast"));
-          collective->Unref();
-          continue;
+          return errors::Internal(
+              "Both input and output are null in ncclBroadcast");
         }
         VLOG(2) << "call NcclBroadcast collective_key "
                 << collective->collective_key << " participant " << p_idx
@@ -830,22 +934,70 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
       }
     }
 
-    // Run the done_callback when the nccl kernel finishes running.
-    auto done_callback = [collective, p_idx, nccl_result]() {
-      VLOG(2) << "done Nccl kernel collective_key "
-              << collective->collective_key << " participant " << p_idx
-              << " ncclResult " << nccl_result;
-      if (nccl_result == ncclSuccess) {
-        collective->participants[p_idx]->done_callback(Status::OK());
-      } else {
-        // Propagate the error, but note that if other members of the collective
-        // did launch their kernels, then they are hanging.
-        collective->participants[p_idx]->done_callback(errors::Unknown(
-            "Error invoking NCCL: ", ncclGetErrorString(nccl_result)));
+    if (nccl_result != ncclSuccess) {
+      return errors::Unknown("Error invoking NCCL: ",
+                             ncclGetErrorString(nccl_result));
+    }
+    return Status::OK();
+  };
+
+  while (true) {
+    // Find collectives to run.
+    std::pair<std::vector<Collective*>, int> next_launch;
+    {
+      VLOG(3) << "Locking mutex nccl_stream " << nccl_stream;
+      mutex_lock l(nccl_stream->mu);
+      while (nccl_stream->pending_launches_.empty()) {
+        if (nccl_stream->shutdown_requested) {
+          // No work and shutdown requested, exit.
+          return;
+        }
+        nccl_stream->cv.wait(l);
       }
-      collective->Unref();
-    };
-    p->event_mgr->ThenExecute(comm_stream, done_callback);
+      next_launch = std::move(nccl_stream->pending_launches_.back());
+      nccl_stream->pending_launches_.pop_back();
+    }
+
+    // Launch the nccl kernels, in one group if there are several of them.
+    const std::vector<Collective*>& collectives = next_launch.first;
+    const int p_idx = next_launch.second;
+    const bool grouped = collectives.size() > 1;
+    std::vector<Status> statuses(collectives.size());
+    ncclResult_t group_result = ncclSuccess;
+#if NCCL_MAJOR >= 2
+    if (grouped) group_result = ncclGroupStart();
+#endif
+    if (group_result == ncclSuccess) {
+      for (int i = 0; i < collectives.size(); ++i) {
+        statuses[i] = launch_kernel(collectives[i], p_idx);
+      }
+#if NCCL_MAJOR >= 2
+      if (grouped) group_result = ncclGroupEnd();
+#endif
+    }
+    if (group_result != ncclSuccess) {
+      for (Status& status : statuses) {
+        status.Update(errors::Unknown("Error invoking NCCL group: ",
+                                      ncclGetErrorString(group_result)));
+      }
+    }
+
+    for (int i = 0; i < collectives.size(); ++i) {
+      Collective* collective = collectives[i];
+      const Status& status = statuses[i];
+      // Run the done_callback when the nccl kernel finishes running.
+      auto done_callback = [collective, p_idx, status]() {
+        VLOG(2) << "done Nccl kernel collective_key "
+                << collective->collective_key << " participant " << p_idx
+                << " status " << status;
+        // On error, note that if other members of the collective did launch
+        // their kernels, then they are hanging.
+        collective->participants[p_idx]->done_callback(status);
+        collective->Unref();
+      };
+      collective->participants[p_idx]->event_mgr->ThenExecute(comm_stream,
+                                                              done_callback);
+    }
   }
 }
 
@@ -864,6 +1016,24 @@ void NcclManager::StartAbort(const Status& s) {
     collectives.swap(collectives_);
     communicators.swap(communicators_);
   }
+  // The fused collectives waiting for their window, which use the aborted
+  // communicators, are not launched either.
+  std::vector<Collective*> fused_collectives;
+  {
+    mutex_lock l(fusion_mu_);
+    for (auto& it : fused_launches_) {
+      fused_collectives.insert(fused_collectives.end(),
+                               it.second.collectives.begin(),
+                               it.second.collectives.end());
+    }
+    fused_launches_.clear();
+  }
+  for (Collective* collective : fused_collectives) {
+    for (const std::unique_ptr<Participant>& p : collective->participants) {
+      p->done_callback(s);
+    }
+    collective->Unref();
+  }
   VLOG(2) << "Aborted NcclManager " << this << " with " << collectives.size()
           << " collectives and " << communicators.size()
           << " comms with status " << s;
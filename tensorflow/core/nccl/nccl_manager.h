@@ -17,6 +17,8 @@ limitations under the License.
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#include <memory>
+#include <utility>
 #include <vector>
 
 // TODO(rmlarsen): Get rid of this workaround. "gpu_assert" is defined when
@@ -36,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 
@@ -49,7 +52,22 @@ namespace tensorflow {
 class NcclManager {
  public:
   typedef std::function<void(Status)> DoneCallback;
+
+  struct Options {
+    // How long a ready single-node collective waits for other collectives on
+    // the same communicator, so that their kernels are launched together
+    // between ncclGroupStart and ncclGroupEnd. Many small collectives, e.g.
+    // the all-reduces of gradients, then pay the launch and synchronization
+    // costs once. 0 disables the fusion.
+    int64_t fusion_window_us = 0;
+    // A fused group is launched as soon as it has this many collectives.
+    int max_fused_collectives = 32;
+  };
+
+  // Reads the options from the TF_NCCL_FUSION_WINDOW_US and
+  // TF_NCCL_MAX_FUSED_COLLECTIVES environment variables.
   NcclManager();
+  explicit NcclManager(const Options& options);
   ~NcclManager();
 
   static NcclManager* instance();
@@ -241,6 +259,21 @@ class NcclManager {
   void RunCollective(Collective* collective);
   void LoopKernelLaunches(NcclStream* stream);
 
+  // Queues the kernels of `collectives`, which share a communicator, to be
+  // launched together on its streams. Takes ownership of `collectives`.
+  void EnqueueLaunches(std::vector<Collective*> collectives);
+
+  // Adds `collective` to the group of collectives of its communicator waiting
+  // for the fusion window, and launches the group if it is full. Takes
+  // ownership of `collective`.
+  void AddToFusedLaunch(Collective* collective);
+
+  // Launches the groups whose fusion window has elapsed, until the
+  // NcclManager is destroyed.
+  void LoopFusedLaunches();
+
+  const Options options_;
+
   mutex mu_;
 
   // Maps key to collectives currently being assembled or run.
@@ -256,6 +289,19 @@ class NcclManager {
 
   Status status_ TF_GUARDED_BY(mu_);
 
+  struct FusedLaunch {
+    std::vector<Collective*> collectives;
+    uint64 deadline_micros = 0;
+  };
+  mutex fusion_mu_;
+  condition_variable fusion_cv_;
+  // The collectives waiting for the fusion window, by communicator.
+  absl::flat_hash_map<Communicator*, FusedLaunch> fused_launches_
+      TF_GUARDED_BY(fusion_mu_);
+  bool fusion_shutdown_ TF_GUARDED_BY(fusion_mu_) = false;
+  // Started with the first fused launch.
+  std::unique_ptr<Thread> fusion_thread_ TF_GUARDED_BY(fusion_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(NcclManager);
 };
 
@@ -573,6 +573,44 @@ TYPED_TEST(NcclManagerTest, MultipleCallers) {
   }
 }
 
+// Many small reductions issued at once, whose kernels are launched in NCCL
+// groups of up to 4 collectives.
+TYPED_TEST(NcclManagerTest, FusedReductions) {
+  const int num_ranks = this->NumGPUs();
+  const int num_collectives = 10;
+  NcclManager::Options options;
+  options.fusion_window_us = 10 * 1000;
+  options.max_fused_collectives = 4;
+  NcclManager nccl_manager(options);
+
+  std::vector<std::unique_ptr<typename TestFixture::TestCase>> test_cases;
+  for (int i = 0; i < num_collectives; ++i) {
+    test_cases.emplace_back(this->MakeReductionTestCase(
+        /*num_nodes=*/1, num_ranks, ncclSum, TensorShape({i + 1}), 1.1f * i));
+  }
+  for (int i = 0; i < num_collectives; ++i) {
+    typename TestFixture::TestCase* test_case = test_cases[i].get();
+    for (int rank = 0; rank < num_ranks; ++rank) {
+      auto* device = this->GetDevice(num_ranks, /*node=*/0, rank);
+      auto* info = device->tensorflow_gpu_device_info();
+      auto* stream = device->tensorflow_gpu_device_info()->stream;
+      auto participant = absl::make_unique<NcclManager::Participant>(
+          device->executor(), stream, info, &test_case->ins[rank],
+          &test_case->outs[rank], /*global_rank=*/-1,
+          this->CreateDoneCallback(test_case));
+      nccl_manager.AddToAllReduce(
+          std::move(participant),
+          {strings::StrCat("allreduce", i), /*num_local_devices=*/num_ranks,
+           /*num_global_devices=*/num_ranks, /*communicator_key=*/"",
+           /*source_rank=*/-1},
+          ncclSum);
+    }
+  }
+  for (int i = 0; i < num_collectives; ++i) {
+    this->VerifyResults(test_cases[i].get());
+  }
+}
+
 // Test basic all-gather.
 TYPED_TEST(NcclManagerTest, BasicAllGather) {
   const int num_ranks = this->NumGPUs();
@@ -82,6 +82,39 @@ REGISTER_OP("ExperimentalAutoShardDataset")
     .SetTypeConstructor(full_type::Unary(TFT_DATASET, "output_types"))
     .SetShapeFn(shape_inference::ScalarShape);
 
+REGISTER_OP("BucketBySequenceLengthDataset")
+    .Input("input_dataset: variant")
+    .Input("length_func_other_arguments: Tlength_func_other_arguments")
+    .Input("bucket_boundaries: int64")
+    .Input("bucket_batch_sizes: int64")
+    .Input("padded_shapes: N * int64")
+    .Input("padding_values: Toutput_types")
+    .Input("max_buffered_bytes: int64")
+    .Input("flush_timeout_ms: int64")
+    .Output("handle: variant")
+    .Attr("length_func: func")
+    .Attr("Tlength_func_other_arguments: list(type) >= 0")
+    .Attr("parallel_copy: bool = false")
+    .Attr("Toutput_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .Attr("N: int >= 1")
+    .SetTypeConstructor(full_type::Unary(TFT_DATASET, "Toutput_types"))
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      std::vector<shape_inference::ShapeHandle> input_shapes;
+      // bucket_boundaries and bucket_batch_sizes should be vectors.
+      TF_RETURN_IF_ERROR(c->input("bucket_boundaries", &input_shapes));
+      TF_RETURN_IF_ERROR(c->WithRank(input_shapes[0], 1, &unused));
+      TF_RETURN_IF_ERROR(c->input("bucket_batch_sizes", &input_shapes));
+      TF_RETURN_IF_ERROR(c->WithRank(input_shapes[0], 1, &unused));
+      // max_buffered_bytes and flush_timeout_ms should be scalars.
+      TF_RETURN_IF_ERROR(
+          c->WithRank(c->input(c->num_inputs() - 2), 0, &unused));
+      TF_RETURN_IF_ERROR(
+          c->WithRank(c->input(c->num_inputs() - 1), 0, &unused));
+      return shape_inference::ScalarShape(c);
+    });
+
 REGISTER_OP("BytesProducedStatsDataset")
     .Input("input_dataset: variant")
     .Input("tag: string")
@@ -1133,6 +1166,27 @@ REGISTER_OP("SnapshotNestedDatasetReader")
     .SetTypeConstructor(full_type::Unary(TFT_DATASET, "output_types"))
     .SetShapeFn(shape_inference::ScalarShape);
 
+REGISTER_OP("SpillingShuffleDataset")
+    .Input("input_dataset: variant")
+    .Input("spill_directory: string")
+    .Input("memory_budget_bytes: int64")
+    .Input("readahead_bytes: int64")
+    .Input("seed: int64")
+    .Input("seed2: int64")
+    .Output("handle: variant")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetTypeConstructor(full_type::Unary(TFT_DATASET, "output_types"))
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      // spill_directory, memory_budget_bytes, readahead_bytes, seed, and seed2
+      // should be scalars.
+      for (int i = 1; i <= 5; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      return shape_inference::ScalarShape(c);
+    });
+
 REGISTER_OP("SqlDataset")
     .Input("driver_name: string")
     .Input("data_source_name: string")
@@ -1140,6 +1194,9 @@ REGISTER_OP("SqlDataset")
     .Output("handle: variant")
     .Attr("output_types: list(type) >= 1")
     .Attr("output_shapes: list(shape) >= 1")
+    .Attr("batch_size: int = 0")
+    .Attr("num_parallel_reads: int = 1")
+    .Attr("rowid_table: string = ''")
     .SetDoNotOptimize()  // TODO(b/123753214): See comment in dataset_ops.cc.
     .SetTypeConstructor(full_type::Unary(TFT_DATASET, "output_types"))
     .SetShapeFn([](shape_inference::InferenceContext* c) {
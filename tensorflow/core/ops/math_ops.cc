@@ -991,7 +991,9 @@ names specified as strings (e.g. "Relu"). They are performed in order, where the
 the output of each fused_op must be of type T.
 
 Currently supported fused_op combinations are: ["BiasAdd"] and ["BiasAdd",A],
-where A is one of {"Elu","Relu","Relu6"}.
+where A is one of {"Elu","Relu","Relu6","LeakyRelu","GeluApproximate",
+"GeluExact","Swish"}. "GeluApproximate" is the tanh approximation of Gelu, and
+"Swish" computes x * sigmoid(x).
 
 * The first input to BiasAdd is the Conv2D result, and the additional BiasAdd
 input is specified by `args`.
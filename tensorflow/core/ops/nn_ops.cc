@@ -249,6 +249,37 @@ Do not invoke this operator directly in Python. A fusion optimization is
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_FusedLayerNorm")
+    .Input("x: T")
+    .Input("scale: T")
+    .Input("offset: T")
+    .Output("y: T")
+    .Attr("T: {half, float, bfloat16}")
+    .Attr("epsilon: float = 0.001")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &x));
+      DimensionHandle depth = c->Dim(x, -1);
+      for (int i = 1; i < 3; ++i) {
+        ShapeHandle vec;
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &vec));
+        TF_RETURN_IF_ERROR(c->Merge(depth, c->Dim(vec, 0), &depth));
+      }
+      ShapeHandle y;
+      TF_RETURN_IF_ERROR(c->ReplaceDim(x, -1, depth, &y));
+      c->set_output(0, y);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Internal LayerNorm operation: reserved for internal use.
+
+Normalizes `x` over its innermost dimension and applies `scale` and `offset`:
+  y = (x - mean(x)) * rsqrt(variance(x) + epsilon) * scale + offset
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("FusedBatchNormGrad")
     .Input("y_backprop: T")
     .Input("x: T")
@@ -1177,6 +1208,22 @@ REGISTER_OP("SeluGrad")
     .Attr("T: {half, bfloat16, float, double}")
     .SetShapeFn(shape_inference::MergeBothInputsShapeFn);
 
+REGISTER_OP("_FusedGelu")
+    .Input("features: T")
+    .Output("activations: T")
+    .Attr("T: {half, float, bfloat16}")
+    .Attr("approximate: bool = false")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Internal Gelu operation: reserved for internal use.
+
+Computes `0.5 * x * (1 + erf(x / sqrt(2)))`, or its tanh approximation
+`0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))` if `approximate`.
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("Softplus")
     .Input("features: T")
     .Output("activations: T")
@@ -1223,6 +1270,26 @@ REGISTER_OP("LogSoftmax")
       return shape_inference::UnchangedShapeWithRankAtLeast(c, 1);
     });
 
+REGISTER_OP("_FusedScaledMaskedSoftmax")
+    .Input("logits: T")
+    .Input("mask: T")
+    .Output("softmax: T")
+    .Attr("T: {half, float, bfloat16}")
+    .Attr("scale: float = 1.0")
+    .Attr("log: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      return shape_inference::UnchangedShapeWithRankAtLeast(c, 1);
+    })
+    .Doc(R"doc(
+Internal Softmax operation: reserved for internal use.
+
+Computes `Softmax(logits * scale + mask)`, or `LogSoftmax(logits * scale +
+mask)` if `log` is true, where `mask` is broadcast to the shape of `logits`.
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
+
 // --------------------------------------------------------------------------
 
 REGISTER_OP("SoftmaxCrossEntropyWithLogits")
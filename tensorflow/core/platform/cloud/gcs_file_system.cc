@@ -146,6 +146,55 @@ constexpr char kAppendMode[] = "GCS_APPEND_MODE";
 // objects.
 constexpr char kComposeAppend[] = "compose";
 
+// The environment variables that configure the parallel transfers, see
+// GcsFileSystem::ParallelTransferConfig. Sizes are specified in MB.
+constexpr char kParallelReadChunkSize[] = "GCS_PARALLEL_READ_CHUNK_SIZE_MB";
+constexpr char kParallelReadWindow[] = "GCS_PARALLEL_READ_WINDOW";
+constexpr char kParallelUploadThreshold[] = "GCS_PARALLEL_UPLOAD_THRESHOLD_MB";
+constexpr char kParallelUploadPartSize[] = "GCS_PARALLEL_UPLOAD_PART_SIZE_MB";
+constexpr char kParallelUploadWindow[] = "GCS_PARALLEL_UPLOAD_WINDOW";
+// The maximum number of source objects of a single compose request.
+constexpr size_t kMaxComposeSources = 32;
+
+// Calls fn(0), ..., fn(n - 1), running up to `parallelism` calls concurrently,
+// and returns the first error. No call is started after an error.
+Status ParallelFor(int64_t n, int32 parallelism,
+                   const std::function<Status(int64_t)>& fn) {
+  if (parallelism <= 1 || n <= 1) {
+    for (int64_t i = 0; i < n; ++i) {
+      TF_RETURN_IF_ERROR(fn(i));
+    }
+    return Status::OK();
+  }
+  mutex mu;
+  int64_t next = 0;
+  Status status;
+  auto worker = [&]() {
+    while (true) {
+      int64_t i;
+      {
+        mutex_lock l(mu);
+        if (next == n || !status.ok()) return;
+        i = next++;
+      }
+      Status s = fn(i);
+      if (!s.ok()) {
+        mutex_lock l(mu);
+        status.Update(s);
+      }
+    }
+  };
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    const int64_t num_threads = std::min<int64_t>(parallelism, n);
+    for (int64_t i = 0; i < num_threads; ++i) {
+      threads.emplace_back(Env::Default()->StartThread(
+          ThreadOptions(), "gcs_parallel_transfer", worker));
+    }
+  }
+  return status;
+}
+
 Status GetTmpFilename(string* filename) {
   *filename = io::GetTempFilename("");
   return Status::OK();
@@ -553,6 +602,20 @@ class GcsWritableFile : public WritableFile {
       return errors::Internal(
           "Could not write to the internal temporary file.");
     }
+    const GcsFileSystem::ParallelTransferConfig& parallel_config =
+        filesystem_->parallel_transfer_config();
+    uint64 file_size;
+    TF_RETURN_IF_ERROR(GetCurrentFileSize(&file_size));
+    if (parallel_config.upload_threshold > 0 &&
+        parallel_config.upload_part_size > 0 &&
+        file_size >= parallel_config.upload_threshold &&
+        !(compose_append_ && start_offset_ > 0)) {
+      TF_RETURN_IF_ERROR(ParallelCompositeUpload(file_size, parallel_config));
+      // Erase the file from the file cache on every successful write.
+      file_cache_erase_();
+      start_offset_ = file_size;
+      return Status::OK();
+    }
     UploadSessionHandle session_handle;
     uint64 start_offset = 0;
     string object_to_upload = object_;
@@ -680,6 +743,109 @@ class GcsWritableFile : public WritableFile {
         retry_config_);
   }
 
+  /// \brief Uploads the file as parts of config.upload_part_size bytes.
+  ///
+  /// The parts are uploaded concurrently as temporary objects, composed into
+  /// the object and deleted, even if the upload failed.
+  Status ParallelCompositeUpload(
+      uint64 file_size, const GcsFileSystem::ParallelTransferConfig& config) {
+    const uint64 part_size = config.upload_part_size;
+    const int64_t num_parts = (file_size + part_size - 1) / part_size;
+    VLOG(3) << "ParallelCompositeUpload: " << GetGcsPath() << " in "
+            << num_parts << " parts";
+    std::vector<string> parts(num_parts);
+    for (int64_t i = 0; i < num_parts; ++i) {
+      parts[i] = strings::StrCat(io::Dirname(object_), "/.tmpcompose/",
+                                 io::Basename(object_), ".part", i);
+    }
+    Status status = ParallelFor(
+        num_parts, config.upload_window,
+        [&parts, part_size, file_size, this](int64_t i) {
+          const uint64 offset = i * part_size;
+          return UploadPart(parts[i], offset,
+                            std::min(part_size, file_size - offset));
+        });
+    if (status.ok()) {
+      status = ComposeParts(parts);
+    }
+    // Parts which were never uploaded are not found, which is fine.
+    Status delete_status = ParallelFor(
+        num_parts, config.upload_window, [&parts, this](int64_t i) {
+          Status s = RetryingUtils::DeleteWithRetries(
+              [&parts, i, this]() {
+                return filesystem_->DeleteFile(GetGcsPathWithObject(parts[i]),
+                                               nullptr);
+              },
+              retry_config_);
+          return errors::IsNotFound(s) ? Status::OK() : s;
+        });
+    status.Update(delete_status);
+    return status;
+  }
+
+  /// Uploads bytes [offset, offset + size) of the file as object `part`.
+  Status UploadPart(const string& part, uint64 offset, uint64 size) {
+    string data(size, '\0');
+    std::ifstream input(tmp_content_filename_, std::ifstream::binary);
+    input.seekg(offset);
+    input.read(&data[0], size);
+    if (!input.good()) {
+      return errors::Internal(
+          "Could not read from the internal temporary file.");
+    }
+    return RetryingUtils::CallWithRetries(
+        [&part, &data, this]() {
+          std::unique_ptr<HttpRequest> request;
+          TF_RETURN_IF_ERROR(filesystem_->CreateHttpRequest(&request));
+          request->SetUri(strings::StrCat(kGcsUploadUriBase, "b/", bucket_,
+                                          "/o?uploadType=media&name=",
+                                          request->EscapeString(part)));
+          request->SetTimeouts(timeouts_->connect, timeouts_->idle,
+                               timeouts_->write);
+          request->SetPostFromBuffer(data.data(), data.size());
+          TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when uploading ",
+                                          GetGcsPathWithObject(part));
+          return Status::OK();
+        },
+        retry_config_);
+  }
+
+  /// Composes `parts` into the object. As a compose request takes at most
+  /// kMaxComposeSources sources, the parts are composed in groups, each of
+  /// which is appended to the result of the previous ones.
+  Status ComposeParts(const std::vector<string>& parts) {
+    size_t next = 0;
+    while (next < parts.size()) {
+      std::vector<string> sources;
+      if (next > 0) {
+        sources.push_back(strings::StrCat("{'name': '", object_, "'}"));
+      }
+      while (sources.size() < kMaxComposeSources && next < parts.size()) {
+        sources.push_back(strings::StrCat("{'name': '", parts[next++], "'}"));
+      }
+      const string request_body = strings::StrCat(
+          "{'sourceObjects': [", str_util::Join(sources, ","), "]}");
+      TF_RETURN_IF_ERROR(RetryingUtils::CallWithRetries(
+          [&request_body, this]() {
+            std::unique_ptr<HttpRequest> request;
+            TF_RETURN_IF_ERROR(filesystem_->CreateHttpRequest(&request));
+            request->SetUri(strings::StrCat(kGcsUriBase, "b/", bucket_, "/o/",
+                                            request->EscapeString(object_),
+                                            "/compose"));
+            request->SetTimeouts(timeouts_->connect, timeouts_->idle,
+                                 timeouts_->metadata);
+            request->AddHeader("content-type", "application/json");
+            request->SetPostFromBuffer(request_body.c_str(),
+                                       request_body.size());
+            TF_RETURN_WITH_CONTEXT_IF_ERROR(
+                request->Send(), " when composing to ", GetGcsPath());
+            return Status::OK();
+          },
+          retry_config_));
+    }
+    return Status::OK();
+  }
+
   /// \brief Requests status of a previously initiated upload session.
   ///
   /// If the upload has already succeeded, sets 'completed' to true.
@@ -803,6 +969,19 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   if (!make_default_cache) {
     max_bytes = 0;
   }
+  StringPiece disk_cache_dir;
+  if (max_bytes > 0 &&
+      GetEnvVar(kDiskCacheDir, StringPieceIdentity, &disk_cache_dir) &&
+      !disk_cache_dir.empty()) {
+    if (GetEnvVar(kDiskCacheMaxSize, strings::safe_strtou64, &value) &&
+        value > 0) {
+      local_disk_block_cache_.reset(new LocalDiskBlockCache(
+          string(disk_cache_dir), value * 1024 * 1024));
+    } else {
+      LOG(WARNING) << "Ignoring " << kDiskCacheDir << " because "
+                   << kDiskCacheMaxSize << " is not set to a positive value.";
+    }
+  }
   VLOG(1) << "GCS cache max size = " << max_bytes << " ; "
           << "block size = " << block_size_ << " ; "
           << "max staleness = " << max_staleness;
@@ -926,6 +1105,31 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   } else {
     compose_append_ = false;
   }
+
+  int32 window_value;
+  if (GetEnvVar(kParallelReadChunkSize, strings::safe_strtou64, &value)) {
+    parallel_transfer_config_.read_chunk_size = value * 1024 * 1024;
+  }
+  if (GetEnvVar(kParallelReadWindow, strings::safe_strto32, &window_value)) {
+    parallel_transfer_config_.read_window = window_value;
+  }
+  if (GetEnvVar(kParallelUploadThreshold, strings::safe_strtou64, &value)) {
+    parallel_transfer_config_.upload_threshold = value * 1024 * 1024;
+  }
+  if (GetEnvVar(kParallelUploadPartSize, strings::safe_strtou64, &value)) {
+    parallel_transfer_config_.upload_part_size = value * 1024 * 1024;
+  }
+  if (GetEnvVar(kParallelUploadWindow, strings::safe_strto32, &window_value)) {
+    parallel_transfer_config_.upload_window = window_value;
+  }
+  VLOG(1) << "GCS parallel read chunk size = "
+          << parallel_transfer_config_.read_chunk_size << " ; "
+          << "read window = " << parallel_transfer_config_.read_window << " ; "
+          << "upload threshold = "
+          << parallel_transfer_config_.upload_threshold << " ; "
+          << "upload part size = "
+          << parallel_transfer_config_.upload_part_size << " ; "
+          << "upload window = " << parallel_transfer_config_.upload_window;
 }
 
 GcsFileSystem::GcsFileSystem(
@@ -1031,8 +1235,7 @@ std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
       block_size, max_bytes, max_staleness,
       [this](const string& filename, size_t offset, size_t n, char* buffer,
              size_t* bytes_transferred) {
-        return LoadBufferFromGCS(filename, offset, n, buffer,
-                                 bytes_transferred);
+        return LoadBlock(filename, offset, n, buffer, bytes_transferred);
       }));
 
   // Check if cache is enabled here to avoid unnecessary mutex contention.
@@ -1040,10 +1243,71 @@ std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
   return file_block_cache;
 }
 
+Status GcsFileSystem::LoadBlock(const string& fname, size_t offset, size_t n,
+                                char* buffer, size_t* bytes_transferred) {
+  // Blocks are cached on disk under the generation of their object, which is
+  // in the stat cache while the object is read (unless the stat cache is
+  // disabled).
+  GcsFileStat stat;
+  if (local_disk_block_cache_ == nullptr ||
+      !stat_cache_->Lookup(fname, &stat)) {
+    return LoadBufferFromGCS(fname, offset, n, buffer, bytes_transferred);
+  }
+  if (local_disk_block_cache_
+          ->Lookup(fname, stat.generation_number, offset, n, buffer,
+                   bytes_transferred)
+          .ok()) {
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(
+      LoadBufferFromGCS(fname, offset, n, buffer, bytes_transferred));
+  Status status = local_disk_block_cache_->Insert(
+      fname, stat.generation_number, offset,
+      StringPiece(buffer, *bytes_transferred));
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not cache block " << offset << " of " << fname
+                 << " on local disk: " << status;
+  }
+  return Status::OK();
+}
+
 // A helper function to actually read the data from GCS.
 Status GcsFileSystem::LoadBufferFromGCS(const string& fname, size_t offset,
                                         size_t n, char* buffer,
                                         size_t* bytes_transferred) {
+  const uint64 chunk_size = parallel_transfer_config_.read_chunk_size;
+  if (chunk_size == 0 || n <= chunk_size) {
+    return LoadRangeFromGCS(fname, offset, n, buffer, bytes_transferred);
+  }
+  *bytes_transferred = 0;
+  const int64_t num_chunks = (n + chunk_size - 1) / chunk_size;
+  std::vector<size_t> chunk_bytes(num_chunks, 0);
+  TF_RETURN_IF_ERROR(ParallelFor(
+      num_chunks, parallel_transfer_config_.read_window,
+      [&](int64_t i) {
+        const size_t chunk_offset = i * chunk_size;
+        return LoadRangeFromGCS(
+            fname, offset + chunk_offset,
+            std::min<size_t>(chunk_size, n - chunk_offset),
+            buffer + chunk_offset, &chunk_bytes[i]);
+      }));
+  // Only the chunks past the end of the file may be short.
+  size_t bytes_read = 0;
+  for (int64_t i = 0; i < num_chunks; ++i) {
+    if (bytes_read < i * chunk_size && chunk_bytes[i] > 0) {
+      return errors::Internal(strings::Printf(
+          "File contents are inconsistent for file: %s @ %lu.", fname.c_str(),
+          offset));
+    }
+    bytes_read += chunk_bytes[i];
+  }
+  *bytes_transferred = bytes_read;
+  return Status::OK();
+}
+
+Status GcsFileSystem::LoadRangeFromGCS(const string& fname, size_t offset,
+                                       size_t n, char* buffer,
+                                       size_t* bytes_transferred) {
   *bytes_transferred = 0;
 
   string bucket, object;
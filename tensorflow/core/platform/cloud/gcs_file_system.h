@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cloud/gcs_dns_cache.h"
 #include "tensorflow/core/platform/cloud/gcs_throttle.h"
 #include "tensorflow/core/platform/cloud/http_request.h"
+#include "tensorflow/core/platform/cloud/local_disk_block_cache.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/retrying_file_system.h"
 #include "tensorflow/core/platform/status.h"
@@ -62,6 +63,12 @@ constexpr size_t kDefaultMaxCacheSize = 0;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variables that enable a second tier of the block cache on
+// local disk, holding blocks of up to GCS_READ_CACHE_DISK_MAX_SIZE_MB in
+// GCS_READ_CACHE_DISK_DIR. The directory can be shared by the processes of a
+// host. Only used when the RAM block cache is enabled.
+constexpr char kDiskCacheDir[] = "GCS_READ_CACHE_DISK_DIR";
+constexpr char kDiskCacheMaxSize[] = "GCS_READ_CACHE_DISK_MAX_SIZE_MB";
 
 // Helper function to extract an environment variable and convert it into a
 // value of type T.
@@ -125,6 +132,7 @@ struct UploadSessionHandle {
 class GcsFileSystem : public FileSystem {
  public:
   struct TimeoutConfig;
+  struct ParallelTransferConfig;
 
   // Main constructor used (via RetryingFileSystem) throughout Tensorflow
   explicit GcsFileSystem(bool make_default_cache = true);
@@ -215,6 +223,9 @@ class GcsFileSystem : public FileSystem {
   }
 
   bool compose_append() const { return compose_append_; }
+  const ParallelTransferConfig& parallel_transfer_config() const {
+    return parallel_transfer_config_;
+  }
   string additional_header_name() const {
     return additional_header_ ? additional_header_->first : "";
   }
@@ -267,6 +278,28 @@ class GcsFileSystem : public FileSystem {
           write(write) {}
   };
 
+  /// Structure containing the configuration of the concurrent requests used
+  /// for large transfers, which a single stream to GCS cannot run at full
+  /// bandwidth.
+  struct ParallelTransferConfig {
+    // Reads of more than `read_chunk_size` bytes (e.g. the fetch of a block or
+    // of a read buffer) are split into ranged reads of `read_chunk_size`
+    // bytes, at most `read_window` of which are in flight. 0 disables
+    // splitting reads.
+    uint64 read_chunk_size = 0;
+    int32 read_window = 8;
+
+    // Files of at least `upload_threshold` bytes are uploaded as temporary
+    // objects of `upload_part_size` bytes, at most `upload_window` of which
+    // are in flight, which are then composed into the destination object and
+    // deleted. 0 disables parallel composite uploads.
+    uint64 upload_threshold = 0;
+    uint64 upload_part_size = 64 * 1024 * 1024;
+    int32 upload_window = 8;
+
+    ParallelTransferConfig() {}
+  };
+
   Status CreateHttpRequest(std::unique_ptr<HttpRequest>* request);
 
   /// \brief Sets a new AuthProvider on the GCS FileSystem.
@@ -274,6 +307,22 @@ class GcsFileSystem : public FileSystem {
   /// The new auth provider will be used for all subsequent requests.
   void SetAuthProvider(std::unique_ptr<AuthProvider> auth_provider);
 
+  /// \brief Sets the configuration of the parallel transfers.
+  ///
+  /// Must be called before any file of the file system is opened.
+  void SetParallelTransferConfig(const ParallelTransferConfig& config) {
+    parallel_transfer_config_ = config;
+  }
+
+  /// \brief Sets the local disk tier of the block cache, nullptr to disable
+  /// it.
+  ///
+  /// Must be called before any file of the file system is opened.
+  void SetLocalDiskBlockCache(
+      std::unique_ptr<LocalDiskBlockCache> local_disk_block_cache) {
+    local_disk_block_cache_ = std::move(local_disk_block_cache);
+  }
+
   /// \brief Resets the block cache and re-instantiates it with the new values.
   ///
   /// This method can be used to clear the existing block cache and/or to
@@ -407,6 +456,14 @@ class GcsFileSystem : public FileSystem {
   // Clear all the caches related to the file with name `filename`.
   void ClearFileCaches(const string& fname);
 
+  /// Loads a block cache block from the local disk block cache or from GCS.
+  Status LoadBlock(const string& fname, size_t offset, size_t n, char* buffer,
+                   size_t* bytes_transferred);
+
+  /// Loads file contents from GCS with a single ranged read.
+  Status LoadRangeFromGCS(const string& fname, size_t offset, size_t n,
+                          char* buffer, size_t* bytes_transferred);
+
   mutex mu_;
   std::unique_ptr<AuthProvider> auth_provider_ TF_GUARDED_BY(mu_);
   std::shared_ptr<HttpRequest::Factory> http_request_factory_;
@@ -422,6 +479,8 @@ class GcsFileSystem : public FileSystem {
       TF_GUARDED_BY(block_cache_lock_);
 
   bool cache_enabled_;
+  // The optional second tier of file_block_cache_.
+  std::unique_ptr<LocalDiskBlockCache> local_disk_block_cache_;
   std::unique_ptr<GcsDnsCache> dns_cache_;
   GcsThrottle throttle_;
 
@@ -435,6 +494,7 @@ class GcsFileSystem : public FileSystem {
   std::unique_ptr<BucketLocationCache> bucket_location_cache_;
   std::unordered_set<string> allowed_locations_;
   bool compose_append_;
+  ParallelTransferConfig parallel_transfer_config_;
 
   GcsStatsInterface* stats_ = nullptr;  // Not owned.
 
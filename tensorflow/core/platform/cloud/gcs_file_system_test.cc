@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/cloud/http_request_fake.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/str_util.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/test.h"
@@ -595,6 +596,100 @@ TEST(GcsFileSystemTest, NewRandomAccessFile_NoBlockCache_DifferentN) {
   EXPECT_EQ("3456789", result);
 }
 
+TEST(GcsFileSystemTest, NewRandomAccessFile_NoBlockCache_ParallelRead) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-3\n"
+           "Timeouts: 5 1 20\n",
+           "0123"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 4-7\n"
+           "Timeouts: 5 1 20\n",
+           "4567"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 8-11\n"
+           "Timeouts: 5 1 20\n",
+           "89")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 0 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  GcsFileSystem::ParallelTransferConfig parallel_config;
+  parallel_config.read_chunk_size = 4;
+  // A single request in flight keeps the order of the requests deterministic.
+  parallel_config.read_window = 1;
+  fs.SetParallelTransferConfig(parallel_config);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_EXPECT_OK(
+      fs.NewRandomAccessFile("gs://bucket/random_access.txt", nullptr, &file));
+
+  // The read is split into three ranged reads, the last of which reaches EOF.
+  char scratch[12];
+  StringPiece result;
+  EXPECT_EQ(errors::Code::OUT_OF_RANGE,
+            file->Read(0, sizeof(scratch), &result, scratch).code());
+  EXPECT_EQ("0123456789", result);
+}
+
+TEST(GcsFileSystemTest, NewRandomAccessFile_NoBlockCache_ParallelReadGap) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-3\n"
+           "Timeouts: 5 1 20\n",
+           "0123"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 4-7\n"
+           "Timeouts: 5 1 20\n",
+           "45"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 8-11\n"
+           "Timeouts: 5 1 20\n",
+           "89")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 0 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  GcsFileSystem::ParallelTransferConfig parallel_config;
+  parallel_config.read_chunk_size = 4;
+  parallel_config.read_window = 1;
+  fs.SetParallelTransferConfig(parallel_config);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_EXPECT_OK(
+      fs.NewRandomAccessFile("gs://bucket/random_access.txt", nullptr, &file));
+
+  // The second chunk is short although the third one is not.
+  char scratch[12];
+  StringPiece result;
+  EXPECT_EQ(errors::Code::INTERNAL,
+            file->Read(0, sizeof(scratch), &result, scratch).code());
+}
+
 TEST(GcsFileSystemTest, NewRandomAccessFile_WithBlockCache) {
   // Our underlying file in this test is a 15 byte file with contents
   // "0123456789abcde".
@@ -683,6 +778,84 @@ TEST(GcsFileSystemTest, NewRandomAccessFile_WithBlockCache) {
   EXPECT_EQ("0123", result);
 }
 
+TEST(GcsFileSystemTest, NewRandomAccessFile_WithLocalDiskBlockCache) {
+  const string disk_cache_dir =
+      io::JoinPath(testing::TmpDir(), "gcs_local_disk_block_cache");
+  int64_t undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(disk_cache_dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+
+  // The first file system reads the block from GCS.
+  std::vector<HttpRequest*> requests1({
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+          "random_access.txt?fields=size%2Cgeneration%2Cupdated\n"
+          "Auth Token: fake_token\n"
+          "Timeouts: 5 1 10\n",
+          strings::StrCat("{\"size\": \"8\",\"generation\": \"1\","
+                          "\"updated\": \"2016-04-29T23:15:24.896Z\"}")),
+      new FakeHttpRequest(
+          "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+          "Auth Token: fake_token\n"
+          "Range: 0-7\n"
+          "Timeouts: 5 1 20\n",
+          "01234567"),
+  });
+  GcsFileSystem fs1(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests1)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 8 /* block size */,
+      16 /* max bytes */, 0 /* max staleness */, 3600 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  fs1.SetLocalDiskBlockCache(
+      std::unique_ptr<LocalDiskBlockCache>(
+          new LocalDiskBlockCache(disk_cache_dir, 1 << 20)));
+
+  // The second one, e.g. of another process of the host, only stats the
+  // object and reads the block from local disk.
+  std::vector<HttpRequest*> requests2({
+      new FakeHttpRequest(
+          "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+          "random_access.txt?fields=size%2Cgeneration%2Cupdated\n"
+          "Auth Token: fake_token\n"
+          "Timeouts: 5 1 10\n",
+          strings::StrCat("{\"size\": \"8\",\"generation\": \"1\","
+                          "\"updated\": \"2016-04-29T23:15:24.896Z\"}")),
+  });
+  GcsFileSystem fs2(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests2)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 8 /* block size */,
+      16 /* max bytes */, 0 /* max staleness */, 3600 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  fs2.SetLocalDiskBlockCache(
+      std::unique_ptr<LocalDiskBlockCache>(
+          new LocalDiskBlockCache(disk_cache_dir, 1 << 20)));
+
+  char scratch[8];
+  StringPiece result;
+  std::unique_ptr<RandomAccessFile> file1;
+  TF_EXPECT_OK(fs1.NewRandomAccessFile("gs://bucket/random_access.txt",
+                                      nullptr, &file1));
+  TF_EXPECT_OK(file1->Read(0, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("01234567", result);
+
+  std::unique_ptr<RandomAccessFile> file2;
+  TF_EXPECT_OK(fs2.NewRandomAccessFile("gs://bucket/random_access.txt",
+                                      nullptr, &file2));
+  TF_EXPECT_OK(file2->Read(0, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("01234567", result);
+}
+
 TEST(GcsFileSystemTest, NewRandomAccessFile_WithBlockCache_Flush) {
   // Our underlying file in this test is a 15 byte file with contents
   // "0123456789abcde".
@@ -1341,6 +1514,88 @@ TEST(GcsFileSystemTest, NewWritableFile_NoObjectName) {
             fs.NewWritableFile("gs://bucket/", nullptr, &file).code());
 }
 
+TEST(GcsFileSystemTest, NewWritableFile_ParallelCompositeUpload) {
+  std::vector<HttpRequest*> requests(
+      {// Upload the parts.
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=path%2F.tmpcompose%2Fwriteable.part0\n"
+           "Auth Token: fake_token\n"
+           "Timeouts: 5 1 30\n"
+           "Post body: content1\n",
+           ""),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=path%2F.tmpcompose%2Fwriteable.part1\n"
+           "Auth Token: fake_token\n"
+           "Timeouts: 5 1 30\n"
+           "Post body: ,content\n",
+           ""),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=path%2F.tmpcompose%2Fwriteable.part2\n"
+           "Auth Token: fake_token\n"
+           "Timeouts: 5 1 30\n"
+           "Post body: 2\n",
+           ""),
+       // Compose them into the object.
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+           "path%2Fwriteable/compose\n"
+           "Auth Token: fake_token\n"
+           "Timeouts: 5 1 10\n"
+           "Header content-type: application/json\n"
+           "Post body: {'sourceObjects': ["
+           "{'name': 'path/.tmpcompose/writeable.part0'},"
+           "{'name': 'path/.tmpcompose/writeable.part1'},"
+           "{'name': 'path/.tmpcompose/writeable.part2'}]}\n",
+           ""),
+       // Delete the parts.
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+           "path%2F.tmpcompose%2Fwriteable.part0\n"
+           "Auth Token: fake_token\n"
+           "Timeouts: 5 1 10\n"
+           "Delete: yes\n",
+           ""),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+           "path%2F.tmpcompose%2Fwriteable.part1\n"
+           "Auth Token: fake_token\n"
+           "Timeouts: 5 1 10\n"
+           "Delete: yes\n",
+           ""),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+           "path%2F.tmpcompose%2Fwriteable.part2\n"
+           "Auth Token: fake_token\n"
+           "Timeouts: 5 1 10\n"
+           "Delete: yes\n",
+           "")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 0 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  GcsFileSystem::ParallelTransferConfig parallel_config;
+  parallel_config.upload_threshold = 16;
+  parallel_config.upload_part_size = 8;
+  // A single request in flight keeps the order of the requests deterministic.
+  parallel_config.upload_window = 1;
+  fs.SetParallelTransferConfig(parallel_config);
+
+  std::unique_ptr<WritableFile> wfile;
+  TF_EXPECT_OK(
+      fs.NewWritableFile("gs://bucket/path/writeable", nullptr, &wfile));
+  TF_EXPECT_OK(wfile->Append("content1,content2"));
+  TF_EXPECT_OK(wfile->Close());
+}
+
 TEST(GcsFileSystemTest, NewAppendableFile) {
   std::vector<HttpRequest*> requests(
       {new FakeHttpRequest(
@@ -4094,5 +4349,26 @@ TEST(GcsFileSystemTest, AppendModeDefault) {
   EXPECT_EQ(false, fs1.compose_append());
 }
 
+TEST(GcsFileSystemTest, OverrideParallelTransferConfig) {
+  setenv("GCS_PARALLEL_READ_CHUNK_SIZE_MB", "8", 1);
+  setenv("GCS_PARALLEL_READ_WINDOW", "16", 1);
+  setenv("GCS_PARALLEL_UPLOAD_THRESHOLD_MB", "256", 1);
+  setenv("GCS_PARALLEL_UPLOAD_PART_SIZE_MB", "32", 1);
+  setenv("GCS_PARALLEL_UPLOAD_WINDOW", "4", 1);
+  GcsFileSystem fs;
+  const GcsFileSystem::ParallelTransferConfig& config =
+      fs.parallel_transfer_config();
+  EXPECT_EQ(8 * 1024 * 1024, config.read_chunk_size);
+  EXPECT_EQ(16, config.read_window);
+  EXPECT_EQ(256 * 1024 * 1024, config.upload_threshold);
+  EXPECT_EQ(32 * 1024 * 1024, config.upload_part_size);
+  EXPECT_EQ(4, config.upload_window);
+  unsetenv("GCS_PARALLEL_READ_CHUNK_SIZE_MB");
+  unsetenv("GCS_PARALLEL_READ_WINDOW");
+  unsetenv("GCS_PARALLEL_UPLOAD_THRESHOLD_MB");
+  unsetenv("GCS_PARALLEL_UPLOAD_PART_SIZE_MB");
+  unsetenv("GCS_PARALLEL_UPLOAD_WINDOW");
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,286 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/local_disk_block_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/str_util.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/stringprintf.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr uint64 kBlockMagic = 0x6b636f6c426b7344ULL;
+// Size of the fixed part of the block file header: the magic number, offset,
+// file signature and filename length.
+constexpr size_t kFixedHeaderSize = 3 * sizeof(uint64) + sizeof(uint32);
+constexpr char kBlockFileSuffix[] = ".block";
+constexpr char kTmpFileInfix[] = ".tmp.";
+// Temporary files older than this were left behind by a crashed writer.
+constexpr int64_t kStaleTmpFileNanos = 3600LL * 1000 * 1000 * 1000;
+
+string Hex(uint64 value) {
+  return strings::Printf("%016llx", static_cast<unsigned long long>(value));
+}
+
+size_t HeaderSize(const string& filename) {
+  return kFixedHeaderSize + filename.size() + sizeof(uint32);
+}
+
+string BlockFileName(const string& filename, int64_t file_signature,
+                     size_t offset) {
+  return strings::StrCat(Hex(Fingerprint64(strings::StrCat(
+                             filename, "@", file_signature, "@", offset))),
+                         kBlockFileSuffix);
+}
+
+}  // namespace
+
+LocalDiskBlockCache::LocalDiskBlockCache(const string& directory,
+                                         size_t max_bytes, Env* env)
+    : directory_(directory), max_bytes_(max_bytes), env_(env) {
+  Status status = env_->RecursivelyCreateDir(directory_);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not create the local disk block cache directory "
+                 << directory_ << ": " << status;
+  }
+  mutex_lock l(mu_);
+  Rescan();
+  VLOG(1) << "Local disk block cache in " << directory_ << " holds "
+          << cache_size_ << " bytes out of " << max_bytes_;
+}
+
+Status LocalDiskBlockCache::Lookup(const string& filename,
+                                   int64_t file_signature, size_t offset,
+                                   size_t n, char* buffer,
+                                   size_t* bytes_transferred) {
+  *bytes_transferred = 0;
+  const string name = BlockFileName(filename, file_signature, offset);
+  const string path = io::JoinPath(directory_, name);
+  uint64 file_size = 0;
+  Status status = ReadBlockFile(path, filename, file_signature, offset, n,
+                                buffer, bytes_transferred, &file_size);
+  mutex_lock l(mu_);
+  if (status.ok()) {
+    Touch(name, file_size);
+    return Status::OK();
+  }
+  *bytes_transferred = 0;
+  Forget(name);
+  if (errors::IsNotFound(status)) {
+    return status;
+  }
+  LOG(WARNING) << "Deleting unreadable block file " << path << ": " << status;
+  env_->DeleteFile(path).IgnoreError();
+  return errors::NotFound("Block ", offset, " of ", filename, " is not cached");
+}
+
+Status LocalDiskBlockCache::Insert(const string& filename,
+                                   int64_t file_signature, size_t offset,
+                                   StringPiece data) {
+  const size_t header_size = HeaderSize(filename);
+  if (data.empty() || header_size + data.size() > max_bytes_) {
+    return Status::OK();
+  }
+  const string name = BlockFileName(filename, file_signature, offset);
+  {
+    mutex_lock l(mu_);
+    if (index_.find(name) != index_.end()) {
+      return Status::OK();
+    }
+  }
+  const string path = io::JoinPath(directory_, name);
+  // Write to a temporary file which is renamed into place, so that readers
+  // (possibly in other processes) never see a partial block.
+  const string tmp_path =
+      strings::StrCat(path, kTmpFileInfix, Hex(random::New64()));
+  string header;
+  header.reserve(header_size);
+  core::PutFixed64(&header, kBlockMagic);
+  core::PutFixed64(&header, offset);
+  core::PutFixed64(&header, static_cast<uint64>(file_signature));
+  core::PutFixed32(&header, filename.size());
+  header.append(filename);
+  core::PutFixed32(&header,
+                   crc32c::Mask(crc32c::Value(data.data(), data.size())));
+  Status status = [&]() {
+    std::unique_ptr<WritableFile> file;
+    TF_RETURN_IF_ERROR(env_->NewWritableFile(tmp_path, &file));
+    TF_RETURN_IF_ERROR(file->Append(header));
+    TF_RETURN_IF_ERROR(file->Append(data));
+    TF_RETURN_IF_ERROR(file->Close());
+    return env_->RenameFile(tmp_path, path);
+  }();
+  if (!status.ok()) {
+    env_->DeleteFile(tmp_path).IgnoreError();
+    return status;
+  }
+
+  std::vector<string> evicted;
+  {
+    mutex_lock l(mu_);
+    Touch(name, header_size + data.size());
+    if (cache_size_ > max_bytes_) {
+      // Other processes may have added or evicted blocks since the last scan.
+      Rescan();
+      Trim(&evicted);
+    }
+  }
+  for (const string& evicted_name : evicted) {
+    env_->DeleteFile(io::JoinPath(directory_, evicted_name)).IgnoreError();
+  }
+  return Status::OK();
+}
+
+size_t LocalDiskBlockCache::CacheSize() const {
+  mutex_lock l(mu_);
+  return cache_size_;
+}
+
+Status LocalDiskBlockCache::ReadBlockFile(const string& path,
+                                          const string& filename,
+                                          int64_t file_signature,
+                                          size_t offset, size_t n,
+                                          char* buffer,
+                                          size_t* bytes_transferred,
+                                          uint64* file_size) {
+  TF_RETURN_IF_ERROR(env_->GetFileSize(path, file_size));
+  const size_t header_size = HeaderSize(filename);
+  if (*file_size <= header_size || *file_size - header_size > n) {
+    return errors::DataLoss("Unexpected size ", *file_size, " of block file");
+  }
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(path, &file));
+  string header(header_size, '\0');
+  StringPiece result;
+  TF_RETURN_IF_ERROR(file->Read(0, header_size, &result, &header[0]));
+  const char* p = result.data();
+  if (result.size() != header_size || core::DecodeFixed64(p) != kBlockMagic ||
+      core::DecodeFixed64(p + sizeof(uint64)) != offset ||
+      core::DecodeFixed64(p + 2 * sizeof(uint64)) !=
+          static_cast<uint64>(file_signature) ||
+      core::DecodeFixed32(p + 3 * sizeof(uint64)) != filename.size() ||
+      StringPiece(p + kFixedHeaderSize, filename.size()) != filename) {
+    return errors::DataLoss("Block file holds another block");
+  }
+  const uint32 masked_crc =
+      core::DecodeFixed32(p + kFixedHeaderSize + filename.size());
+
+  const size_t data_size = *file_size - header_size;
+  TF_RETURN_IF_ERROR(file->Read(header_size, data_size, &result, buffer));
+  if (result.size() != data_size) {
+    return errors::DataLoss("Truncated block file");
+  }
+  if (result.data() != buffer) {
+    memmove(buffer, result.data(), data_size);
+  }
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(buffer, data_size)) {
+    return errors::DataLoss("Corrupted block file");
+  }
+  *bytes_transferred = data_size;
+  return Status::OK();
+}
+
+void LocalDiskBlockCache::Touch(const string& name, uint64 size) {
+  auto it = index_.find(name);
+  if (it == index_.end()) {
+    lru_list_.push_front(name);
+    index_[name] = Entry{size, lru_list_.begin()};
+    cache_size_ += size;
+    return;
+  }
+  if (it->second.lru_iterator != lru_list_.begin()) {
+    lru_list_.erase(it->second.lru_iterator);
+    lru_list_.push_front(name);
+    it->second.lru_iterator = lru_list_.begin();
+  }
+}
+
+void LocalDiskBlockCache::Forget(const string& name) {
+  auto it = index_.find(name);
+  if (it == index_.end()) return;
+  cache_size_ -= it->second.size;
+  lru_list_.erase(it->second.lru_iterator);
+  index_.erase(it);
+}
+
+void LocalDiskBlockCache::Rescan() {
+  std::vector<string> children;
+  Status status = env_->GetChildren(directory_, &children);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not list the local disk block cache directory "
+                 << directory_ << ": " << status;
+    return;
+  }
+  const int64_t now_nanos = env_->NowNanos();
+  // The block files on disk, by name, with their size and modification time.
+  std::unordered_map<string, FileStatistics> block_files;
+  for (const string& child : children) {
+    const string path = io::JoinPath(directory_, child);
+    FileStatistics stat;
+    if (!env_->Stat(path, &stat).ok() || stat.is_directory) continue;
+    if (str_util::StrContains(child, kTmpFileInfix)) {
+      if (now_nanos - stat.mtime_nsec > kStaleTmpFileNanos) {
+        env_->DeleteFile(path).IgnoreError();
+      }
+      continue;
+    }
+    if (str_util::EndsWith(child, kBlockFileSuffix)) {
+      block_files[child] = stat;
+    }
+  }
+
+  // Forget the blocks evicted by other processes, and keep the position of the
+  // other known blocks in the LRU list.
+  for (auto it = lru_list_.begin(); it != lru_list_.end();) {
+    const string name = *it++;
+    auto block_file = block_files.find(name);
+    if (block_file == block_files.end()) {
+      Forget(name);
+    } else {
+      block_files.erase(block_file);
+    }
+  }
+  // The blocks added by other processes are more recent than the known ones,
+  // and ordered by modification time.
+  std::vector<std::pair<int64_t, string>> added;
+  added.reserve(block_files.size());
+  for (const auto& block_file : block_files) {
+    added.emplace_back(block_file.second.mtime_nsec, block_file.first);
+  }
+  std::sort(added.begin(), added.end());
+  for (const auto& block_file : added) {
+    Touch(block_file.second, block_files[block_file.second].length);
+  }
+}
+
+void LocalDiskBlockCache::Trim(std::vector<string>* evicted) {
+  while (!lru_list_.empty() && cache_size_ > max_bytes_) {
+    evicted->push_back(lru_list_.back());
+    Forget(evicted->back());
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,134 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_LOCAL_DISK_BLOCK_CACHE_H_
+#define TENSORFLOW_CORE_PLATFORM_CLOUD_LOCAL_DISK_BLOCK_CACHE_H_
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+/// \brief An LRU cache of file blocks on a local disk, keyed by {filename,
+/// file signature, offset}.
+///
+/// This is the second tier of a remote filesystem's RamFileBlockCache: blocks
+/// fetched from the remote filesystem are also written to `directory`, so
+/// that they can be read from local disk once the RAM cache evicted them, or
+/// by another process of the host sharing the directory.
+///
+/// Each block is stored in its own file, whose name is a fingerprint of the
+/// key, and which is written to a temporary file and renamed into place so
+/// that readers never see partial blocks. The block files are the on-disk
+/// index of the cache: a cache scans the directory when it is created and
+/// whenever it exceeds `max_bytes`, to account for the blocks added and
+/// evicted by other processes. Blocks this process has not accessed are
+/// ordered by modification time in the LRU list.
+///
+/// Format of a block file:
+///  uint64    magic number
+///  uint64    offset of the block
+///  uint64    file signature
+///  uint32    filename length
+///  byte      filename[filename length]
+///  uint32    masked crc of the data
+///  byte      data[...]
+///
+/// This class is thread safe, and processes sharing the directory only
+/// coordinate through the file system: a block evicted by another process is
+/// a cache miss, and a corrupted block file is deleted.
+class LocalDiskBlockCache {
+ public:
+  LocalDiskBlockCache(const string& directory, size_t max_bytes,
+                      Env* env = Env::Default());
+
+  /// Reads the block of `filename` with signature `file_signature` at
+  /// `offset`, of at most `n` bytes, into `buffer`. Returns NOT_FOUND if the
+  /// block is not cached.
+  Status Lookup(const string& filename, int64_t file_signature, size_t offset,
+                size_t n, char* buffer, size_t* bytes_transferred)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  /// Adds the block of `filename` with signature `file_signature` at `offset`
+  /// to the cache, evicting the least recently used blocks to stay within
+  /// `max_bytes`.
+  Status Insert(const string& filename, int64_t file_signature, size_t offset,
+                StringPiece data) TF_LOCKS_EXCLUDED(mu_);
+
+  const string& directory() const { return directory_; }
+  size_t max_bytes() const { return max_bytes_; }
+
+  /// The size (in bytes) of the block files known to this cache.
+  size_t CacheSize() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Entry {
+    uint64 size;
+    std::list<string>::iterator lru_iterator;
+  };
+
+  /// Reads the block file at `path` and checks that it holds the block at
+  /// `offset` of `filename`.
+  Status ReadBlockFile(const string& path, const string& filename,
+                       int64_t file_signature, size_t offset, size_t n,
+                       char* buffer, size_t* bytes_transferred,
+                       uint64* file_size);
+
+  /// Moves the block file `name` to the front of the LRU list, adding it if
+  /// needed.
+  void Touch(const string& name, uint64 size) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Removes the block file `name` from the index.
+  void Forget(const string& name) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Synchronizes the index with the block files in the directory.
+  void Rescan() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Removes least recently used blocks from the index until the cache fits
+  /// in max_bytes_, and returns the names of their files in `evicted`.
+  void Trim(std::vector<string>* evicted) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const string directory_;
+  const size_t max_bytes_;
+  Env* const env_;  // not owned
+
+  mutable mutex mu_;
+
+  /// The LRU list of block file names. The front of the list identifies the
+  /// most recently accessed block.
+  std::list<string> lru_list_ TF_GUARDED_BY(mu_);
+
+  /// A block file name->entry map.
+  std::unordered_map<string, Entry> index_ TF_GUARDED_BY(mu_);
+
+  /// The combined size of the block files in the index.
+  uint64 cache_size_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LocalDiskBlockCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_CLOUD_LOCAL_DISK_BLOCK_CACHE_H_
@@ -0,0 +1,123 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/local_disk_block_cache.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Size of a block file for the filename "file": 28 bytes of fixed header,
+// the filename, the crc of the data and the data.
+constexpr size_t kBlockFileOverhead = 28 + 4 + 4;
+
+string CacheDir(const string& name) {
+  const string dir = io::JoinPath(testing::TmpDir(), name);
+  int64_t undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  return dir;
+}
+
+Status Lookup(LocalDiskBlockCache* cache, int64_t signature, size_t offset,
+              string* out) {
+  out->assign(64, '\0');
+  size_t bytes_transferred;
+  Status status = cache->Lookup("file", signature, offset, out->size(),
+                                &(*out)[0], &bytes_transferred);
+  out->resize(bytes_transferred);
+  return status;
+}
+
+TEST(LocalDiskBlockCacheTest, InsertAndLookup) {
+  LocalDiskBlockCache cache(CacheDir("insert_and_lookup"), 1 << 20);
+  const string block(64, 'x');
+  TF_ASSERT_OK(cache.Insert("file", 1, 0, block));
+  EXPECT_EQ(cache.CacheSize(), kBlockFileOverhead + block.size());
+
+  string out;
+  TF_EXPECT_OK(Lookup(&cache, 1, 0, &out));
+  EXPECT_EQ(out, block);
+  // Another offset or file signature is not cached.
+  EXPECT_TRUE(errors::IsNotFound(Lookup(&cache, 1, 64, &out)));
+  EXPECT_TRUE(errors::IsNotFound(Lookup(&cache, 2, 0, &out)));
+}
+
+TEST(LocalDiskBlockCacheTest, SharedByCachesOfTheSameDirectory) {
+  const string dir = CacheDir("shared");
+  LocalDiskBlockCache cache1(dir, 1 << 20);
+  TF_ASSERT_OK(cache1.Insert("file", 1, 0, "0123456789"));
+
+  // A cache created later finds the block when scanning the directory, and
+  // an existing one when looking it up.
+  LocalDiskBlockCache cache2(dir, 1 << 20);
+  EXPECT_EQ(cache2.CacheSize(), kBlockFileOverhead + 10);
+  string out;
+  TF_EXPECT_OK(Lookup(&cache2, 1, 0, &out));
+  EXPECT_EQ(out, "0123456789");
+
+  TF_ASSERT_OK(cache2.Insert("file", 1, 64, "abc"));
+  TF_EXPECT_OK(Lookup(&cache1, 1, 64, &out));
+  EXPECT_EQ(out, "abc");
+}
+
+TEST(LocalDiskBlockCacheTest, EvictsLeastRecentlyUsedBlocks) {
+  const string block(64, 'x');
+  const size_t block_file_size = kBlockFileOverhead + block.size();
+  LocalDiskBlockCache cache(CacheDir("evict"), 2 * block_file_size);
+  TF_ASSERT_OK(cache.Insert("file", 1, 0, block));
+  TF_ASSERT_OK(cache.Insert("file", 1, 64, block));
+  string out;
+  TF_ASSERT_OK(Lookup(&cache, 1, 0, &out));
+
+  // The block at offset 64 is the least recently used one.
+  TF_ASSERT_OK(cache.Insert("file", 1, 128, block));
+  EXPECT_EQ(cache.CacheSize(), 2 * block_file_size);
+  TF_EXPECT_OK(Lookup(&cache, 1, 0, &out));
+  EXPECT_TRUE(errors::IsNotFound(Lookup(&cache, 1, 64, &out)));
+  TF_EXPECT_OK(Lookup(&cache, 1, 128, &out));
+}
+
+TEST(LocalDiskBlockCacheTest, CorruptedBlockIsDeleted) {
+  Env* env = Env::Default();
+  const string dir = CacheDir("corrupted");
+  LocalDiskBlockCache cache(dir, 1 << 20);
+  TF_ASSERT_OK(cache.Insert("file", 1, 0, "0123456789"));
+
+  std::vector<string> children;
+  TF_ASSERT_OK(env->GetChildren(dir, &children));
+  ASSERT_EQ(children.size(), 1);
+  const string path = io::JoinPath(dir, children[0]);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(env, path, &contents));
+  contents.back() ^= 1;
+  TF_ASSERT_OK(WriteStringToFile(env, path, contents));
+
+  string out;
+  EXPECT_TRUE(errors::IsNotFound(Lookup(&cache, 1, 0, &out)));
+  EXPECT_TRUE(errors::IsNotFound(env->FileExists(path)));
+  EXPECT_EQ(cache.CacheSize(), 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -305,6 +305,21 @@ int NUMAGetMemAffinity(const void* addr) {
   return node;
 }
 
+bool NUMAInterleaveMemory(void* ptr, size_t size) {
+#ifdef TENSORFLOW_USE_NUMA
+  if (HaveHWLocTopology() && NUMAEnabled()) {
+    if (!hwloc_set_area_membind(
+            hwloc_topology_handle, ptr, size,
+            hwloc_topology_get_topology_nodeset(hwloc_topology_handle),
+            HWLOC_MEMBIND_INTERLEAVE, HWLOC_MEMBIND_BYNODESET)) {
+      return true;
+    }
+    LOG(ERROR) << "Failed call to hwloc_set_area_membind.";
+  }
+#endif  // TENSORFLOW_USE_NUMA
+  return false;
+}
+
 void MallocExtension_ReleaseToSystem(std::size_t num_bytes) {
   // No-op.
 }
@@ -18,6 +18,8 @@ limitations under the License.
 #include <fcntl.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
 #include <sys/mman.h>
 
 #if defined(__linux__)
@@ -29,11 +31,15 @@ limitations under the License.
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <fstream>
+
 #include "tensorflow/core/platform/default/posix_file_system.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
@@ -208,10 +214,13 @@ class PosixWritableFile : public WritableFile {
 
 class PosixReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
  public:
-  PosixReadOnlyMemoryRegion(const void* address, uint64 length)
-      : address_(address), length_(length) {}
+  // `mapped_length` is the length of the mapping at `address`, which may be
+  // rounded up to a multiple of the page size.
+  PosixReadOnlyMemoryRegion(const void* address, uint64 length,
+                            uint64 mapped_length)
+      : address_(address), length_(length), mapped_length_(mapped_length) {}
   ~PosixReadOnlyMemoryRegion() override {
-    munmap(const_cast<void*>(address_), length_);
+    munmap(const_cast<void*>(address_), mapped_length_);
   }
   const void* data() override { return address_; }
   uint64 length() override { return length_; }
@@ -219,8 +228,114 @@ class PosixReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
  private:
   const void* const address_;
   const uint64 length_;
+  const uint64 mapped_length_;
 };
 
+namespace {
+
+// Largest read when copying a file into memory.
+constexpr size_t kPosixMaxReadSize = 64 << 20;
+
+bool ReadBoolFromEnv(const char* name) {
+  const char* value = getenv(name);
+  return value != nullptr &&
+         (strcmp(value, "1") == 0 || strcasecmp(value, "true") == 0);
+}
+
+// Returns the size of the default hugetlb pages.
+uint64 HugePageSize() {
+  static const uint64 huge_page_size = []() -> uint64 {
+    std::ifstream meminfo("/proc/meminfo");
+    string line;
+    while (std::getline(meminfo, line)) {
+      unsigned long long size_kb;
+      if (sscanf(line.c_str(), "Hugepagesize: %llu kB", &size_kb) == 1) {
+        return size_kb << 10;
+      }
+    }
+    return 2 << 20;
+  }();
+  return huge_page_size;
+}
+
+// Reads the `length` bytes of file `fd` into new anonymous memory.
+Status ReadFileToAnonymousMemory(
+    const string& fname, int fd, uint64 length,
+    const PosixMemoryRegionOptions& options,
+    std::unique_ptr<ReadOnlyMemoryRegion>* result) {
+  void* address = MAP_FAILED;
+  uint64 mapped_length = length;
+#if defined(MAP_HUGETLB)
+  if (options.huge_pages == PosixMemoryRegionOptions::kExplicit) {
+    const uint64 huge_page_size = HugePageSize();
+    mapped_length = (length + huge_page_size - 1) / huge_page_size *
+                    huge_page_size;
+    address = mmap(nullptr, mapped_length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (address == MAP_FAILED) {
+      VLOG(1) << "Could not allocate hugetlb pages for " << fname << ": "
+              << strerror(errno) << ". Using transparent hugepages.";
+      mapped_length = length;
+    }
+  }
+#endif
+  if (address == MAP_FAILED) {
+    address = mmap(nullptr, mapped_length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (address == MAP_FAILED) {
+      return IOError(fname, errno);
+    }
+#if defined(MADV_HUGEPAGE)
+    if (options.huge_pages != PosixMemoryRegionOptions::kNone) {
+      madvise(address, mapped_length, MADV_HUGEPAGE);
+    }
+#endif
+  }
+  // The policy applies to the pages faulted in by the reads below.
+  if (options.numa_interleave &&
+      !port::NUMAInterleaveMemory(address, mapped_length)) {
+    VLOG(1) << "Could not interleave " << fname << " over NUMA nodes";
+  }
+
+  char* dst = static_cast<char*>(address);
+  uint64 offset = 0;
+  while (offset < length) {
+    const size_t n = std::min<uint64>(length - offset, kPosixMaxReadSize);
+    ssize_t r = pread(fd, dst + offset, n, static_cast<off_t>(offset));
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) {
+      Status s = r < 0 ? IOError(fname, errno)
+                       : errors::DataLoss(fname, " was truncated while read");
+      munmap(address, mapped_length);
+      return s;
+    }
+    offset += r;
+  }
+  mprotect(address, mapped_length, PROT_READ);
+  result->reset(new PosixReadOnlyMemoryRegion(address, length, mapped_length));
+  return Status::OK();
+}
+
+}  // namespace
+
+PosixMemoryRegionOptions PosixMemoryRegionOptions::FromEnv() {
+  PosixMemoryRegionOptions options;
+  options.populate = ReadBoolFromEnv("TF_MMAP_POPULATE");
+  options.numa_interleave = ReadBoolFromEnv("TF_MMAP_NUMA_INTERLEAVE");
+  const char* huge_pages = getenv("TF_MMAP_HUGE_PAGES");
+  if (huge_pages != nullptr && *huge_pages != '\0') {
+    if (strcasecmp(huge_pages, "transparent") == 0) {
+      options.huge_pages = kTransparent;
+    } else if (strcasecmp(huge_pages, "explicit") == 0) {
+      options.huge_pages = kExplicit;
+    } else {
+      LOG(WARNING) << "Ignoring unknown TF_MMAP_HUGE_PAGES value "
+                   << huge_pages;
+    }
+  }
+  return options;
+}
+
 Status PosixFileSystem::NewRandomAccessFile(
     const string& fname, TransactionToken* token,
     std::unique_ptr<RandomAccessFile>* result) {
@@ -266,6 +381,13 @@ Status PosixFileSystem::NewAppendableFile(
 Status PosixFileSystem::NewReadOnlyMemoryRegionFromFile(
     const string& fname, TransactionToken* token,
     std::unique_ptr<ReadOnlyMemoryRegion>* result) {
+  return NewReadOnlyMemoryRegionFromFileWithOptions(
+      fname, PosixMemoryRegionOptions::FromEnv(), result);
+}
+
+Status PosixFileSystem::NewReadOnlyMemoryRegionFromFileWithOptions(
+    const string& fname, const PosixMemoryRegionOptions& options,
+    std::unique_ptr<ReadOnlyMemoryRegion>* result) {
   string translated_fname = TranslateName(fname);
   Status s = Status::OK();
   int fd = open(translated_fname.c_str(), O_RDONLY);
@@ -274,12 +396,28 @@ Status PosixFileSystem::NewReadOnlyMemoryRegionFromFile(
   } else {
     struct stat st;
     ::fstat(fd, &st);
-    const void* address =
-        mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
-    if (address == MAP_FAILED) {
-      s = IOError(fname, errno);
+    if (st.st_size > 0 &&
+        (options.numa_interleave ||
+         options.huge_pages == PosixMemoryRegionOptions::kExplicit)) {
+      s = ReadFileToAnonymousMemory(fname, fd, st.st_size, options, result);
     } else {
-      result->reset(new PosixReadOnlyMemoryRegion(address, st.st_size));
+      int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+      if (options.populate) flags |= MAP_POPULATE;
+#endif
+      void* address = mmap(nullptr, st.st_size, PROT_READ, flags, fd, 0);
+      if (address == MAP_FAILED) {
+        s = IOError(fname, errno);
+      } else {
+#if defined(MADV_HUGEPAGE)
+        // Fails on kernels which do not support hugepages for files.
+        if (options.huge_pages == PosixMemoryRegionOptions::kTransparent) {
+          madvise(address, st.st_size, MADV_HUGEPAGE);
+        }
+#endif
+        result->reset(
+            new PosixReadOnlyMemoryRegion(address, st.st_size, st.st_size));
+      }
     }
     if (close(fd) < 0) {
       s = IOError(fname, errno);
@@ -21,6 +21,40 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Options of the memory regions returned by
+// PosixFileSystem::NewReadOnlyMemoryRegionFromFile(). Large models and
+// memmapped weights accessed at random suffer from TLB misses and page faults
+// with the default mapping, which these options avoid.
+struct PosixMemoryRegionOptions {
+  enum HugePages {
+    // The file is mapped with the default page size.
+    kNone,
+    // The mapping is advised to use transparent hugepages (MADV_HUGEPAGE).
+    // This needs a kernel able to back read-only file mappings with
+    // hugepages (CONFIG_READ_ONLY_THP_FOR_FS).
+    kTransparent,
+    // The file is copied into anonymous memory backed by hugetlb pages
+    // (MAP_HUGETLB), or by transparent hugepages if none are reserved.
+    kExplicit,
+  };
+
+  // Prefaults the pages of the region when mapping it (MAP_POPULATE).
+  bool populate = false;
+
+  HugePages huge_pages = kNone;
+
+  // Interleaves the pages of the region over the NUMA nodes. The page cache
+  // does not follow the memory policy of a mapping, so the file is copied
+  // into anonymous memory.
+  bool numa_interleave = false;
+
+  // Returns the options set by the environment variables:
+  //   TF_MMAP_POPULATE=1
+  //   TF_MMAP_HUGE_PAGES=transparent|explicit
+  //   TF_MMAP_NUMA_INTERLEAVE=1
+  static PosixMemoryRegionOptions FromEnv();
+};
+
 class PosixFileSystem : public FileSystem {
  public:
   PosixFileSystem() {}
@@ -39,10 +73,15 @@ class PosixFileSystem : public FileSystem {
   Status NewAppendableFile(const string& fname, TransactionToken* token,
                            std::unique_ptr<WritableFile>* result) override;
 
+  // Maps the file with the options of PosixMemoryRegionOptions::FromEnv().
   Status NewReadOnlyMemoryRegionFromFile(
       const string& filename, TransactionToken* token,
       std::unique_ptr<ReadOnlyMemoryRegion>* result) override;
 
+  Status NewReadOnlyMemoryRegionFromFileWithOptions(
+      const string& filename, const PosixMemoryRegionOptions& options,
+      std::unique_ptr<ReadOnlyMemoryRegion>* result);
+
   Status FileExists(const string& fname, TransactionToken* token) override;
 
   Status GetChildren(const string& dir, TransactionToken* token,
@@ -174,6 +174,30 @@ TEST_F(DefaultEnvTest, FileToReadonlyMemoryRegion) {
   }
 }
 
+#if !defined(PLATFORM_WINDOWS)
+TEST_F(DefaultEnvTest, ReadOnlyMemoryRegionWithMappingOptions) {
+  const string filename = io::JoinPath(BaseDir(), "mapped_file");
+  const string input = CreateTestFile(env_, filename, 100000);
+  // The mapping options are read from the environment for each region.
+  const std::vector<std::pair<string, string>> options = {
+      {"TF_MMAP_POPULATE", "1"},
+      {"TF_MMAP_HUGE_PAGES", "transparent"},
+      {"TF_MMAP_HUGE_PAGES", "explicit"},
+      {"TF_MMAP_NUMA_INTERLEAVE", "1"},
+  };
+  for (const auto& option : options) {
+    setenv(option.first.c_str(), option.second.c_str(), 1);
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    TF_EXPECT_OK(env_->NewReadOnlyMemoryRegionFromFile(filename, &region));
+    unsetenv(option.first.c_str());
+    ASSERT_NE(region, nullptr);
+    EXPECT_EQ(input.size(), region->length());
+    EXPECT_EQ(input, string(reinterpret_cast<const char*>(region->data()),
+                            region->length()));
+  }
+}
+#endif
+
 TEST_F(DefaultEnvTest, DeleteRecursively) {
   // Build a directory structure rooted at root_dir.
   // root_dir -> dirs: child_dir1, child_dir2; files: root_file1, root_file2
@@ -57,6 +57,11 @@ void NUMAFree(void* ptr, size_t size);
 // Returns NUMA node affinity of memory address, kNUMANoAffinity if none.
 int NUMAGetMemAffinity(const void* ptr);
 
+// If possible sets the memory policy of the pages of [ptr, ptr + size) to
+// interleave them over all NUMA nodes. ptr must be page-aligned, and the
+// policy only applies to the pages not yet touched. Returns true on success.
+bool NUMAInterleaveMemory(void* ptr, size_t size);
+
 }  // namespace port
 }  // namespace tensorflow
 #endif  // TENSORFLOW_CORE_PLATFORM_NUMA_H_
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/platform/numa.h"
 
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -42,6 +43,16 @@ TEST(Numa, Malloc) {
   }
 }
 
+TEST(Numa, InterleaveMemory) {
+  if (port::NUMAEnabled()) {
+    const size_t size = 1 << 20;
+    void* ptr = port::AlignedMalloc(size, 4096);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_TRUE(port::NUMAInterleaveMemory(ptr, size));
+    port::AlignedFree(ptr);
+  }
+}
+
 TEST(Numa, SetNodeAffinity) {
   // NOTE(tucker): This test is not reliable when executed under tap because
   // the virtual machine may not have access to all of the available NUMA
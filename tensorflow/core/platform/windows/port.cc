@@ -130,6 +130,8 @@ void NUMAFree(void* ptr, size_t size) { Free(ptr); }
 
 int NUMAGetMemAffinity(const void* addr) { return kNUMANoAffinity; }
 
+bool NUMAInterleaveMemory(void* ptr, size_t size) { return false; }
+
 void MallocExtension_ReleaseToSystem(std::size_t num_bytes) {
   // No-op.
 }
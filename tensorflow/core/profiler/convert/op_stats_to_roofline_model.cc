@@ -0,0 +1,112 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/convert/op_stats_to_roofline_model.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/convert/op_metrics_to_record.h"
+#include "tensorflow/core/profiler/protobuf/hardware_types.pb.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+#include "tensorflow/core/profiler/protobuf/op_stats.pb.h"
+#include "tensorflow/core/profiler/protobuf/roofline_model.pb.h"
+#include "tensorflow/core/profiler/utils/kernel_stats_utils.h"
+#include "tensorflow/core/profiler/utils/math_utils.h"
+#include "tensorflow/core/profiler/utils/op_metrics_db_utils.h"
+#include "tensorflow/core/profiler/utils/time_utils.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+// The maximum number of TF-ops in the roofline model, as in TF stats.
+const int kMaxNumOfOps = 500;
+
+RooflineModelRecord ConvertOpMetricsToRooflineModelRecord(
+    const OpMetrics& metrics, const RooflineModelDatabase& db) {
+  RooflineModelRecord record;
+  record.set_op_type(metrics.category());
+  record.set_op_name(metrics.name());
+  record.set_is_eager(metrics.is_eager());
+  record.set_occurrences(metrics.occurrences());
+  record.set_total_self_time_in_us(PicosToMicros(metrics.self_time_ps()));
+  record.set_flops(metrics.flops());
+  record.set_bytes_accessed(metrics.bytes_accessed());
+  SetRooflineMetrics(metrics, db.ridge_point(), &record);
+  record.set_flop_rate_utilization(
+      SafeDivide(record.measured_flop_rate(), db.peak_flop_rate()));
+  record.set_memory_bw_utilization(
+      SafeDivide(record.measured_memory_bw(), db.peak_memory_bw()));
+  record.set_roofline_flop_rate(
+      metrics.bytes_accessed() != 0
+          ? std::min(db.peak_flop_rate(),
+                     record.operational_intensity() * db.peak_memory_bw())
+          : db.peak_flop_rate());
+  if (record.bound_by() == "Memory") {
+    record.set_roofline_utilization(record.memory_bw_utilization());
+  } else if (record.bound_by() == "Compute") {
+    record.set_roofline_utilization(record.flop_rate_utilization());
+  }
+  return record;
+}
+
+}  // namespace
+
+RooflineModelDatabase ConvertOpStatsToRooflineModel(const OpStats& op_stats) {
+  RooflineModelDatabase db;
+  db.set_device_type(op_stats.run_environment().device_type());
+  const PerfEnv& perf_env = op_stats.perf_env();
+  db.set_peak_flop_rate(perf_env.peak_tera_flops_per_second() * 1000);
+  db.set_peak_memory_bw(perf_env.peak_hbm_bw_giga_bytes_per_second());
+  db.set_ridge_point(perf_env.ridge_point());
+
+  OpMetricsDb device_tf_metrics_db = CreateTfMetricsDbFromDeviceOpMetricsDb(
+      op_stats.device_op_metrics_db(), /*with_idle=*/false);
+  OpMetrics total;
+  for (const OpMetrics& metrics : device_tf_metrics_db.metrics_db()) {
+    if (IsIdleOp(metrics)) continue;
+    total.set_occurrences(total.occurrences() + metrics.occurrences());
+    total.set_time_ps(total.time_ps() + metrics.time_ps());
+    total.set_self_time_ps(total.self_time_ps() + metrics.self_time_ps());
+    total.set_flops(total.flops() + metrics.flops());
+    total.set_bytes_accessed(total.bytes_accessed() + metrics.bytes_accessed());
+  }
+  *db.mutable_total() = ConvertOpMetricsToRooflineModelRecord(total, db);
+  db.mutable_total()->set_total_self_time_as_fraction(1.0);
+
+  KernelStatsByOpName kernel_stats_by_op_name =
+      GroupKernelReportsByOpName(op_stats.kernel_stats_db());
+  const double total_self_time_us = db.total().total_self_time_in_us();
+  for (const OpMetrics* metrics :
+       SortedOpMetricsDb(device_tf_metrics_db, kMaxNumOfOps)) {
+    if (IsIdleOp(*metrics)) continue;
+    RooflineModelRecord* record = db.add_roofline_model_record();
+    *record = ConvertOpMetricsToRooflineModelRecord(*metrics, db);
+    record->set_rank(db.roofline_model_record_size());
+    record->set_total_self_time_as_fraction(
+        SafeDivide(record->total_self_time_in_us(), total_self_time_us));
+    auto iter = kernel_stats_by_op_name.find(record->op_name());
+    if (iter != kernel_stats_by_op_name.end()) {
+      record->set_gpu_tensorcore_utilization(
+          SafeDivide(iter->second.tensor_core_duration_ns,
+                     iter->second.total_duration_ns));
+    }
+  }
+  return db;
+}
+
+}  // namespace profiler
+}  // namespace tensorflow
@@ -0,0 +1,107 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/convert/op_stats_to_roofline_model.h"
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/convert/xplane_to_op_stats.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+#include "tensorflow/core/profiler/protobuf/op_stats.pb.h"
+#include "tensorflow/core/profiler/protobuf/roofline_model.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+void AddDeviceOpMetrics(absl::string_view tf_op_fullname, uint64 time_ps,
+                        uint64 flops, uint64 bytes_accessed,
+                        OpMetricsDb* db) {
+  OpMetrics* metrics = db->add_metrics_db();
+  metrics->set_name(std::string(tf_op_fullname));
+  metrics->set_provenance(std::string(tf_op_fullname));
+  metrics->set_occurrences(1);
+  metrics->set_time_ps(time_ps);
+  metrics->set_self_time_ps(time_ps);
+  metrics->set_flops(flops);
+  metrics->set_bytes_accessed(bytes_accessed);
+}
+
+TEST(OpStatsToRooflineModel, ClassifiesOps) {
+  OpStats op_stats;
+  // 10 TFLOP/s and 1000 GB/s, i.e. a ridge point of 10 FLOP/byte.
+  *op_stats.mutable_perf_env() =
+      MakePerfEnv(/*peak_tera_flops_per_second=*/10,
+                  /*peak_hbm_bw_giga_bytes_per_second=*/1000);
+  OpMetricsDb* db = op_stats.mutable_device_op_metrics_db();
+  // 5000 GFLOP/s at 50 FLOP/byte.
+  AddDeviceOpMetrics("matmul:MatMul", /*time_ps=*/1000000, /*flops=*/5000000,
+                     /*bytes_accessed=*/100000, db);
+  // 500 GB/s at 1 FLOP/byte.
+  AddDeviceOpMetrics("relu:Relu", /*time_ps=*/2000000, /*flops=*/1000000,
+                     /*bytes_accessed=*/1000000, db);
+
+  RooflineModelDatabase roofline = ConvertOpStatsToRooflineModel(op_stats);
+  EXPECT_DOUBLE_EQ(roofline.peak_flop_rate(), 10000);
+  EXPECT_DOUBLE_EQ(roofline.peak_memory_bw(), 1000);
+  EXPECT_DOUBLE_EQ(roofline.ridge_point(), 10);
+  ASSERT_EQ(roofline.roofline_model_record_size(), 2);
+
+  const RooflineModelRecord& relu = roofline.roofline_model_record(0);
+  EXPECT_EQ(relu.rank(), 1);
+  EXPECT_EQ(relu.op_name(), "relu");
+  EXPECT_EQ(relu.op_type(), "Relu");
+  EXPECT_EQ(relu.bound_by(), "Memory");
+  EXPECT_DOUBLE_EQ(relu.total_self_time_as_fraction(), 2.0 / 3);
+  EXPECT_DOUBLE_EQ(relu.measured_memory_bw(), 500);
+  EXPECT_DOUBLE_EQ(relu.memory_bw_utilization(), 0.5);
+  EXPECT_DOUBLE_EQ(relu.roofline_flop_rate(), 1000);
+  EXPECT_DOUBLE_EQ(relu.roofline_utilization(), 0.5);
+
+  const RooflineModelRecord& matmul = roofline.roofline_model_record(1);
+  EXPECT_EQ(matmul.rank(), 2);
+  EXPECT_EQ(matmul.bound_by(), "Compute");
+  EXPECT_DOUBLE_EQ(matmul.measured_flop_rate(), 5000);
+  EXPECT_DOUBLE_EQ(matmul.flop_rate_utilization(), 0.5);
+  EXPECT_DOUBLE_EQ(matmul.memory_bw_utilization(), 0.1);
+  EXPECT_DOUBLE_EQ(matmul.roofline_flop_rate(), 10000);
+  EXPECT_DOUBLE_EQ(matmul.roofline_utilization(), 0.5);
+
+  EXPECT_EQ(roofline.total().flops(), 6000000);
+  EXPECT_DOUBLE_EQ(roofline.total().measured_flop_rate(), 2000);
+  EXPECT_EQ(roofline.total().bound_by(), "Memory");
+}
+
+TEST(OpStatsToRooflineModel, UnknownWithoutEstimates) {
+  OpStats op_stats;
+  *op_stats.mutable_perf_env() =
+      MakePerfEnv(/*peak_tera_flops_per_second=*/10,
+                  /*peak_hbm_bw_giga_bytes_per_second=*/1000);
+  AddDeviceOpMetrics("custom:Custom", /*time_ps=*/1000, /*flops=*/0,
+                     /*bytes_accessed=*/0,
+                     op_stats.mutable_device_op_metrics_db());
+
+  RooflineModelDatabase roofline = ConvertOpStatsToRooflineModel(op_stats);
+  ASSERT_EQ(roofline.roofline_model_record_size(), 1);
+  EXPECT_EQ(roofline.roofline_model_record(0).bound_by(), "Unknown");
+  EXPECT_EQ(roofline.roofline_model_record(0).roofline_utilization(), 0);
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
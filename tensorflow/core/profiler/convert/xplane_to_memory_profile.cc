@@ -25,7 +25,9 @@ limitations under the License.
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/framework/types.h"
@@ -47,6 +49,10 @@ namespace {
 
 constexpr int64_t kInvalidStepId = -1;
 
+// The number of the largest allocations alive at the peak memory usage that
+// are kept in the profile.
+constexpr int64_t kMaxNumPeakAllocations = 100;
+
 // Index of the time-sorted memory_profile_snapshots list, and the
 // MemoryActivityMetadata proto it contains.
 using IndexMetaPair =
@@ -80,6 +86,62 @@ void UpdateProfileSummary(const MemoryAggregationStats& stats,
   }
 }
 
+// Adds the bin occupancy and fragmentation recorded by a MemoryMapSnapshot
+// event of the BFC allocator to the profile of the allocator.
+void AddMemoryMapSnapshot(const XEventVisitor& event,
+                          MemoryProfile* memory_profile) {
+  MemoryMapSnapshot snapshot;
+  snapshot.set_time_offset_ps(event.OffsetPs());
+  MemoryAggregationStats* stats = snapshot.mutable_aggregation_stats();
+  std::string memory_id;
+  event.ForEachStat([&](const XStatVisitor& stat) {
+    if (!stat.Type().has_value()) return;
+    switch (stat.Type().value()) {
+      case StatType::kAllocatorName:
+        memory_id = std::string(stat.StrOrRefValue());
+        break;
+      case StatType::kBytesReserved:
+        stats->set_stack_reserved_bytes(stat.IntValue());
+        break;
+      case StatType::kBytesAllocated:
+        stats->set_heap_allocated_bytes(stat.IntValue());
+        break;
+      case StatType::kBytesAvailable:
+        stats->set_free_memory_bytes(stat.IntValue());
+        break;
+      case StatType::kFragmentation:
+        stats->set_fragmentation(stat.DoubleValue());
+        break;
+      case StatType::kBinSummary:
+        // "bin:bytes_in_use:bytes_in_bin:chunks_in_use:chunks_in_bin;"
+        // for each non-empty bin.
+        for (absl::string_view bin :
+             absl::StrSplit(stat.StrOrRefValue(), ';', absl::SkipEmpty())) {
+          std::vector<absl::string_view> fields = absl::StrSplit(bin, ':');
+          int32_t bin_num;
+          int64_t values[4];
+          if (fields.size() != 5 || !absl::SimpleAtoi(fields[0], &bin_num) ||
+              !absl::SimpleAtoi(fields[1], &values[0]) ||
+              !absl::SimpleAtoi(fields[2], &values[1]) ||
+              !absl::SimpleAtoi(fields[3], &values[2]) ||
+              !absl::SimpleAtoi(fields[4], &values[3])) {
+            VLOG(2) << "Invalid bin summary: " << bin;
+            continue;
+          }
+          BinOccupancy* occupancy = snapshot.add_bins();
+          occupancy->set_bin(bin_num);
+          occupancy->set_bytes_in_use(values[0]);
+          occupancy->set_bytes_in_bin(values[1]);
+          occupancy->set_chunks_in_use(values[2]);
+          occupancy->set_chunks_in_bin(values[3]);
+        }
+        break;
+    }
+  });
+  *(*memory_profile->mutable_memory_profile_per_allocator())[memory_id]
+       .add_memory_map_snapshots() = std::move(snapshot);
+}
+
 // Generate memory profile proto by processing host trace XPlane.
 MemoryProfile GenerateMemoryProfile(const XPlane* host_trace) {
   XPlaneVisitor plane = CreateTfXPlaneVisitor(host_trace);
@@ -90,6 +152,10 @@ MemoryProfile GenerateMemoryProfile(const XPlane* host_trace) {
   plane.ForEachLine([&](const XLineVisitor& line) {
     line.ForEachEvent([&](const XEventVisitor& event) {
       int64_t event_type = event.Type().value_or(kUnknownHostEventType);
+      if (event_type == HostEventType::kMemoryMapSnapshot) {
+        AddMemoryMapSnapshot(event, &memory_profile);
+        return;
+      }
       if (!(IsMemoryAllocation(event_type) ||
             IsMemoryDeallocation(event_type))) {
         return;
@@ -191,6 +257,115 @@ void UpdateStepId(PerAllocatorMemoryProfile* memory_profile) {
   }
 }
 
+// An allocation matched with its deallocation, if any.
+struct AllocationLifetime {
+  int64_t allocation_time_ps;
+  const MemoryActivityMetadata* allocation;
+  int64_t deallocation_time_ps = -1;
+  absl::string_view deallocation_tf_op_name;
+};
+
+// Generate the allocation lifetimes per op, and the largest allocations alive
+// at the peak memory usage. Must be called before UpdateDeallocation() as it
+// needs the ops running at the deallocations. Allocations are matched with
+// deallocations based on address, as in UpdateDeallocation().
+void ProcessAllocationLifetimes(PerAllocatorMemoryProfile* memory_profile) {
+  const auto& snapshots = memory_profile->memory_profile_snapshots();
+  if (snapshots.empty()) return;
+  std::vector<AllocationLifetime> lifetimes;
+  absl::flat_hash_map<uint64 /*address*/, size_t /*index*/> live_allocations;
+  for (const auto& snapshot : snapshots) {
+    const MemoryActivityMetadata& metadata = snapshot.activity_metadata();
+    if (metadata.memory_activity() == ALLOCATION) {
+      if (live_allocations.emplace(metadata.address(), lifetimes.size())
+              .second) {
+        lifetimes.push_back({snapshot.time_offset_ps(), &metadata});
+      }
+    } else if (metadata.memory_activity() == DEALLOCATION) {
+      auto it = live_allocations.find(metadata.address());
+      // Skip the memory allocated before the profile.
+      if (it == live_allocations.end()) continue;
+      AllocationLifetime& lifetime = lifetimes[it->second];
+      lifetime.deallocation_time_ps = snapshot.time_offset_ps();
+      lifetime.deallocation_tf_op_name = metadata.tf_op_name();
+      live_allocations.erase(it);
+    }
+  }
+
+  // The allocations that are not deallocated are alive until the end of the
+  // profile.
+  const int64_t end_time_ps = snapshots[snapshots.size() - 1].time_offset_ps();
+  absl::flat_hash_map<absl::string_view, OpAllocationLifetimes> lifetimes_by_op;
+  for (const AllocationLifetime& lifetime : lifetimes) {
+    const int64_t deallocation_time_ps = lifetime.deallocation_time_ps >= 0
+                                             ? lifetime.deallocation_time_ps
+                                             : end_time_ps;
+    const int64_t lifetime_ps =
+        deallocation_time_ps - lifetime.allocation_time_ps;
+    const int64_t bytes = lifetime.allocation->allocation_bytes();
+    OpAllocationLifetimes& op =
+        lifetimes_by_op[lifetime.allocation->tf_op_name()];
+    if (op.num_allocations() == 0) {
+      op.set_tf_op_name(lifetime.allocation->tf_op_name());
+      op.set_first_allocation_time_ps(lifetime.allocation_time_ps);
+    }
+    op.set_num_allocations(op.num_allocations() + 1);
+    op.set_allocation_bytes(op.allocation_bytes() + bytes);
+    op.set_total_lifetime_ps(op.total_lifetime_ps() + lifetime_ps);
+    op.set_max_lifetime_ps(std::max(op.max_lifetime_ps(), lifetime_ps));
+    op.set_byte_seconds(op.byte_seconds() + bytes * (lifetime_ps / 1e12));
+    op.set_last_deallocation_time_ps(
+        std::max(op.last_deallocation_time_ps(), deallocation_time_ps));
+  }
+  std::vector<OpAllocationLifetimes*> ops;
+  ops.reserve(lifetimes_by_op.size());
+  for (auto& name_and_op : lifetimes_by_op) ops.push_back(&name_and_op.second);
+  absl::c_sort(ops, [](const OpAllocationLifetimes* a,
+                       const OpAllocationLifetimes* b) {
+    return std::make_tuple(-a->byte_seconds(), a->tf_op_name()) <
+           std::make_tuple(-b->byte_seconds(), b->tf_op_name());
+  });
+  for (OpAllocationLifetimes* op : ops) {
+    *memory_profile->add_op_allocation_lifetimes() = std::move(*op);
+  }
+
+  const int64_t peak_time_ps =
+      memory_profile->profile_summary().peak_stats_time_ps();
+  std::vector<const AllocationLifetime*> peak_lifetimes;
+  for (const AllocationLifetime& lifetime : lifetimes) {
+    if (lifetime.allocation_time_ps <= peak_time_ps &&
+        (lifetime.deallocation_time_ps < 0 ||
+         lifetime.deallocation_time_ps > peak_time_ps)) {
+      peak_lifetimes.push_back(&lifetime);
+    }
+  }
+  const size_t num_peak_allocations = std::min<size_t>(
+      peak_lifetimes.size(), kMaxNumPeakAllocations);
+  absl::c_partial_sort(
+      peak_lifetimes, peak_lifetimes.begin() + num_peak_allocations,
+      [](const AllocationLifetime* a, const AllocationLifetime* b) {
+        return std::make_tuple(-a->allocation->allocation_bytes(),
+                               a->allocation_time_ps) <
+               std::make_tuple(-b->allocation->allocation_bytes(),
+                               b->allocation_time_ps);
+      });
+  for (size_t i = 0; i < num_peak_allocations; ++i) {
+    const AllocationLifetime& lifetime = *peak_lifetimes[i];
+    const MemoryActivityMetadata& allocation = *lifetime.allocation;
+    PeakAllocation* peak_allocation = memory_profile->add_peak_allocations();
+    peak_allocation->set_allocation_bytes(allocation.allocation_bytes());
+    peak_allocation->set_requested_bytes(allocation.requested_bytes());
+    peak_allocation->set_tf_op_name(allocation.tf_op_name());
+    peak_allocation->set_deallocation_tf_op_name(
+        std::string(lifetime.deallocation_tf_op_name));
+    peak_allocation->set_region_type(allocation.region_type());
+    peak_allocation->set_data_type(allocation.data_type());
+    peak_allocation->set_tensor_shape(allocation.tensor_shape());
+    peak_allocation->set_allocation_time_ps(lifetime.allocation_time_ps);
+    peak_allocation->set_deallocation_time_ps(lifetime.deallocation_time_ps);
+  }
+}
+
 // Update the MemoryActivityMetadata for each deallocation event by copying from
 // matching allocation.
 void UpdateDeallocation(PerAllocatorMemoryProfile* memory_profile) {
@@ -503,7 +678,14 @@ void ProcessMemoryProfileProto(int64_t max_num_snapshots,
       return a.time_offset_ps() < b.time_offset_ps();
     });
 
+    absl::c_sort(
+        *allocator_memory_profile->mutable_memory_map_snapshots(),
+        [](const MemoryMapSnapshot& a, const MemoryMapSnapshot& b) {
+          return a.time_offset_ps() < b.time_offset_ps();
+        });
+
     UpdateStepId(allocator_memory_profile);
+    ProcessAllocationLifetimes(allocator_memory_profile);
     UpdateDeallocation(allocator_memory_profile);
 
     int64_t peak_step_id =
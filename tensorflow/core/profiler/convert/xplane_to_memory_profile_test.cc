@@ -115,6 +115,80 @@ TEST(ConvertXPlaneToMemoryProfile, OneAllocatorMultiActivitiesTest) {
       2000);
 }
 
+// Tests the allocation lifetimes per op, the allocations alive at peak, and
+// the bin occupancy snapshots.
+TEST(ConvertXPlaneToMemoryProfile, AllocationLifetimesAndMemoryMapTest) {
+  XSpace space;
+  XPlane* host_plane = GetOrCreateHostXPlane(&space);
+  XPlaneBuilder host_plane_builder(host_plane);
+  host_plane_builder.ReserveLines(1);
+
+  auto tf_executor_thread = host_plane_builder.GetOrCreateLine(0);
+  auto add_activity = [&](absl::string_view name, int64_t offset_ps,
+                          int64_t bytes_allocated, int64_t allocation_bytes,
+                          int64_t address, absl::string_view tf_op) {
+    CreateXEvent(&host_plane_builder, &tf_executor_thread, name, offset_ps,
+                 1000,
+                 {{StatType::kBytesReserved, int64_t{0}},
+                  {StatType::kBytesAllocated, bytes_allocated},
+                  {StatType::kBytesAvailable, 10000 - bytes_allocated},
+                  {StatType::kPeakBytesInUse, int64_t{3000}},
+                  {StatType::kRequestedBytes, allocation_bytes},
+                  {StatType::kAllocationBytes, allocation_bytes},
+                  {StatType::kAddress, address},
+                  {StatType::kAllocatorName, "GPU_0_bfc"},
+                  {StatType::kTfOp, tf_op}});
+  };
+  add_activity("MemoryAllocation", 10000, 1000, 1000, 1, "producer");
+  add_activity("MemoryAllocation", 20000, 3000, 2000, 2, "producer");
+  add_activity("MemoryDeallocation", 40000, 1000, 2000, 2, "consumer");
+  add_activity("MemoryAllocation", 50000, 1500, 500, 3, "other");
+  CreateXEvent(&host_plane_builder, &tf_executor_thread, "MemoryMapSnapshot",
+               30000, 0,
+               {{StatType::kAllocatorName, "GPU_0_bfc"},
+                {StatType::kBytesAllocated, int64_t{3000}},
+                {StatType::kBinSummary, "2:1024:2048:1:2;7:2000:2000:1:1;"}});
+
+  tensorflow::profiler::GroupTfEvents(&space);
+  MemoryProfile memory_profile = ConvertXPlaneToMemoryProfile(*host_plane);
+  const auto& allocator_memory_profile =
+      memory_profile.memory_profile_per_allocator().at("GPU_0_bfc");
+  EXPECT_EQ(allocator_memory_profile.profile_summary().peak_stats_time_ps(),
+            20000);
+
+  // "producer" allocated 1000 bytes for 40000 ps and 2000 bytes for 20000 ps.
+  ASSERT_EQ(allocator_memory_profile.op_allocation_lifetimes_size(), 2);
+  const auto& producer = allocator_memory_profile.op_allocation_lifetimes(0);
+  EXPECT_EQ(producer.tf_op_name(), "producer");
+  EXPECT_EQ(producer.num_allocations(), 2);
+  EXPECT_EQ(producer.allocation_bytes(), 3000);
+  EXPECT_EQ(producer.total_lifetime_ps(), 60000);
+  EXPECT_EQ(producer.max_lifetime_ps(), 40000);
+  EXPECT_DOUBLE_EQ(producer.byte_seconds(), 8e-5);
+  EXPECT_EQ(producer.first_allocation_time_ps(), 10000);
+  EXPECT_EQ(producer.last_deallocation_time_ps(), 50000);
+  EXPECT_EQ(allocator_memory_profile.op_allocation_lifetimes(1).tf_op_name(),
+            "other");
+
+  ASSERT_EQ(allocator_memory_profile.peak_allocations_size(), 2);
+  const auto& largest = allocator_memory_profile.peak_allocations(0);
+  EXPECT_EQ(largest.allocation_bytes(), 2000);
+  EXPECT_EQ(largest.tf_op_name(), "producer");
+  EXPECT_EQ(largest.deallocation_tf_op_name(), "consumer");
+  EXPECT_EQ(largest.deallocation_time_ps(), 40000);
+  EXPECT_EQ(allocator_memory_profile.peak_allocations(1).deallocation_time_ps(),
+            -1);
+
+  ASSERT_EQ(allocator_memory_profile.memory_map_snapshots_size(), 1);
+  const auto& memory_map = allocator_memory_profile.memory_map_snapshots(0);
+  EXPECT_EQ(memory_map.time_offset_ps(), 30000);
+  EXPECT_EQ(memory_map.aggregation_stats().heap_allocated_bytes(), 3000);
+  ASSERT_EQ(memory_map.bins_size(), 2);
+  EXPECT_EQ(memory_map.bins(0).bin(), 2);
+  EXPECT_EQ(memory_map.bins(0).bytes_in_bin(), 2048);
+  EXPECT_EQ(memory_map.bins(1).chunks_in_use(), 1);
+}
+
 }  // namespace
 }  // namespace profiler
 }  // namespace tensorflow
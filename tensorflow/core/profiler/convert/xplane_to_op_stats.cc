@@ -15,12 +15,19 @@ limitations under the License.
 
 #include "tensorflow/core/profiler/convert/xplane_to_op_stats.h"
 
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/convert/op_metrics_db_combiner.h"
 #include "tensorflow/core/profiler/convert/op_stats_combiner.h"
@@ -82,6 +89,51 @@ void SetRunEnvironment(const XSpace& space, int32_t accelerator_count,
   env->set_device_core_count(accelerator_count);
 }
 
+// Runs fn(i) for each i in [0, n) on a process-wide pool, and returns when all
+// calls have returned. Runs them inline when called from the pool, so that a
+// conversion nested in another one doesn't wait for threads of its own pool.
+void ParallelFor(int64_t n, const std::function<void(int64_t)>& fn) {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "xplane_to_op_stats", port::MaxParallelism());
+  if (n <= 1 || pool->CurrentThreadId() >= 0) {
+    for (int64_t i = 0; i < n; ++i) fn(i);
+    return;
+  }
+  BlockingCounter counter(n);
+  for (int64_t i = 0; i < n; ++i) {
+    pool->Schedule([&fn, &counter, i]() {
+      fn(i);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+}
+
+// What is converted from a device plane, before it is combined with the
+// other planes.
+struct DevicePlaneStats {
+  OpMetricsDb op_metrics_db;
+  StepEvents step_events;
+  KernelReportMap reports;
+};
+
+// Combines the OpStats of several hosts into <combined_op_stats>.
+void CombineMultiHostOpStats(std::vector<OpStats>& all_op_stats,
+                             OpStats* combined_op_stats) {
+  std::vector<OpStatsInfo> all_op_stats_info;
+  all_op_stats_info.reserve(all_op_stats.size());
+  for (int i = 0; i < all_op_stats.size(); i++) {
+    all_op_stats_info.emplace_back(
+        &all_op_stats[i],
+        ParseHardwareType(all_op_stats[i].run_environment().device_type()), i);
+  }
+
+  // Do not limit the maximum number of steps during the merge of OpStats.
+  StepIntersection step_intersection =
+      ComputeStepIntersectionToMergeOpStats(all_op_stats_info, kuint32max);
+  CombineAllOpStats(all_op_stats_info, step_intersection, combined_op_stats);
+}
+
 }  // namespace
 
 void PropagateXSpaceDiagnosticsToOpStats(const XSpace& space,
@@ -117,29 +169,56 @@ OpStats ConvertXSpaceToOpStats(const XSpace& space,
   KernelReportMap reports;
   absl::string_view gpu_model = "";
 
-  // TODO(b/161942993) parallelize XPlane processing per thread.
-  for (const XPlane* device_trace : device_planes) {
+  // Converts the device planes, and the op metrics of the host plane, which
+  // don't depend on each other, in parallel. They are combined in the order
+  // of the planes, so that the result doesn't depend on the scheduling.
+  std::vector<DevicePlaneStats> device_plane_stats(device_planes.size());
+  const bool convert_host_op_metrics_db =
+      host_plane != nullptr && options.generate_op_metrics_db;
+  ParallelFor(
+      device_planes.size() + (convert_host_op_metrics_db ? 1 : 0),
+      [&](int64_t i) {
+        if (i == device_planes.size()) {
+          *op_stats.mutable_host_op_metrics_db() =
+              ConvertHostThreadsXPlaneToOpMetricsDb(*host_plane);
+          return;
+        }
+        const XPlane& device_trace = *device_planes[i];
+        DevicePlaneStats& stats = device_plane_stats[i];
+        if (options.generate_op_metrics_db) {
+          stats.op_metrics_db =
+              ConvertDeviceTraceXPlaneToOpMetricsDb(device_trace);
+        }
+        if (options.generate_step_db) {
+          stats.step_events =
+              ConvertDeviceTraceXPlaneToStepEvents(device_trace);
+        }
+        if (options.generate_kernel_stats_db) {
+          ConvertDeviceTraceXPlaneToKernelReports(
+              device_trace, /*on_kernel_fn=*/{}, &stats.reports);
+        }
+      });
+
+  for (int i = 0; i < device_planes.size(); ++i) {
+    const XPlane* device_trace = device_planes[i];
+    const DevicePlaneStats& stats = device_plane_stats[i];
     if (options.generate_op_metrics_db) {
       if (!op_stats.has_perf_env()) {
         *op_stats.mutable_perf_env() = GetPerfEnvFromXPlane(*device_trace);
       }
-      OpMetricsDb device_op_metrics_db =
-          ConvertDeviceTraceXPlaneToOpMetricsDb(*device_trace);
-      op_metrics_db_combiner.Combine(device_op_metrics_db);
+      op_metrics_db_combiner.Combine(stats.op_metrics_db);
     }
     if (gpu_model.empty()) {
       gpu_model = GpuModelName(GetDeviceCaps(*device_trace));
     }
     if (options.generate_step_db) {
-      StepEvents device_step_events =
-          ConvertDeviceTraceXPlaneToStepEvents(*device_trace);
-      CombineStepEvents(device_step_events, &step_events);
+      CombineStepEvents(stats.step_events, &step_events);
     }
     if (options.generate_kernel_stats_db) {
-      ConvertDeviceTraceXPlaneToKernelReports(*device_trace,
-                                              /*on_kernel_fn=*/{}, &reports);
+      MergeKernelReports(stats.reports, &reports);
     }
   }
+  device_plane_stats.clear();
 
   if (!gpu_model.empty()) {
     // Overwrites the device type with the more specific GPU model name.
@@ -155,10 +234,6 @@ OpStats ConvertXSpaceToOpStats(const XSpace& space,
   bool has_device = !device_planes.empty();
   // Convert a host plane.
   if (host_plane) {
-    if (options.generate_op_metrics_db) {
-      *op_stats.mutable_host_op_metrics_db() =
-          ConvertHostThreadsXPlaneToOpMetricsDb(*host_plane);
-    }
     if (options.generate_step_db) {
       const StepEvents* device_step_events =
           has_device ? &step_events : nullptr;
@@ -194,27 +269,43 @@ Status ConvertMultiXSpacesToCombinedOpStats(const std::vector<XSpace>& xspaces,
     return Status::OK();
   }
 
-  // Read multiple XSpaces and convert to multiple OpStats.
-  std::vector<OpStats> all_op_stats;
-  all_op_stats.reserve(xspaces.size());
-  for (const XSpace& xspace : xspaces) {
-    all_op_stats.push_back(ConvertXSpaceToOpStats(xspace, options));
-  }
+  // Convert multiple XSpaces to multiple OpStats, one host per thread.
+  std::vector<OpStats> all_op_stats(xspaces.size());
+  ParallelFor(xspaces.size(), [&](int64_t i) {
+    all_op_stats[i] = ConvertXSpaceToOpStats(xspaces[i], options);
+  });
 
-  // Combine OpStats.
-  std::vector<OpStatsInfo> all_op_stats_info;
-  all_op_stats_info.reserve(all_op_stats.size());
-  for (int i = 0; i < all_op_stats.size(); i++) {
-    all_op_stats_info.emplace_back(
-        &all_op_stats[i],
-        ParseHardwareType(all_op_stats[i].run_environment().device_type()), i);
-  }
+  CombineMultiHostOpStats(all_op_stats, combined_op_stats);
+  return Status::OK();
+}
 
-  // Do not limit the maximum number of steps during the merge of OpStats.
-  StepIntersection step_intersection =
-      ComputeStepIntersectionToMergeOpStats(all_op_stats_info, kuint32max);
-  CombineAllOpStats(all_op_stats_info, step_intersection, combined_op_stats);
+Status ConvertMultiXSpacePathsToCombinedOpStats(
+    const std::vector<std::string>& xspace_paths,
+    const OpStatsOptions& options, OpStats* combined_op_stats) {
+  // Each XSpace is read, converted and dropped by the same thread, so that at
+  // most one XSpace per thread is in memory at once.
+  std::vector<OpStats> all_op_stats(xspace_paths.size());
+  std::vector<Status> statuses(xspace_paths.size());
+  ParallelFor(xspace_paths.size(), [&](int64_t i) {
+    XSpace xspace;
+    statuses[i] = ReadBinaryProto(Env::Default(), xspace_paths[i], &xspace);
+    if (!statuses[i].ok()) return;
+    all_op_stats[i] = ConvertXSpaceToOpStats(xspace, options);
+  });
+  for (int i = 0; i < statuses.size(); ++i) {
+    if (!statuses[i].ok()) {
+      return errors::CreateWithUpdatedMessage(
+          statuses[i], absl::StrCat("Failed to read XSpace from ",
+                                    xspace_paths[i], ": ",
+                                    statuses[i].error_message()));
+    }
+  }
 
+  if (all_op_stats.size() == 1) {
+    *combined_op_stats = std::move(all_op_stats[0]);
+    return Status::OK();
+  }
+  CombineMultiHostOpStats(all_op_stats, combined_op_stats);
   return Status::OK();
 }
 
@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PROFILER_CONVERT_XPLANE_TO_OP_STATS_H_
 #define TENSORFLOW_CORE_PROFILER_CONVERT_XPLANE_TO_OP_STATS_H_
 
+#include <string>
+#include <vector>
+
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/profiler/protobuf/hardware_types.pb.h"
@@ -47,7 +50,7 @@ PerfEnv MakePerfEnv(double peak_tera_flops_per_second,
 // Extracts PerfEnv from XPlane stats.
 PerfEnv GetPerfEnvFromXPlane(const XPlane& device_plane);
 
-// Takes an XSpace proto message, converts to OpStats, and
+// Takes XSpace proto messages, converts them to OpStats in parallel, and
 // combine them to a single OpStats in <combined_op_stats>.
 // Return the first error status during conversion, or return Status::OK() if
 // there is no error.
@@ -55,6 +58,13 @@ Status ConvertMultiXSpacesToCombinedOpStats(const std::vector<XSpace>& xspaces,
                                             const OpStatsOptions& options,
                                             OpStats* combined_op_stats);
 
+// Same as above, but reads the XSpaces from <xspace_paths>. Each XSpace is
+// dropped once it is converted, so that only a few of them are in memory at
+// once, whatever the number of hosts.
+Status ConvertMultiXSpacePathsToCombinedOpStats(
+    const std::vector<std::string>& xspace_paths,
+    const OpStatsOptions& options, OpStats* combined_op_stats);
+
 }  // namespace profiler
 }  // namespace tensorflow
 
@@ -15,11 +15,18 @@ limitations under the License.
 
 #include "tensorflow/core/profiler/convert/xplane_to_op_stats.h"
 
+#include <string>
+#include <vector>
+
 #include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/convert/step_events_to_steps_db.h"
 #include "tensorflow/core/profiler/protobuf/diagnostics.pb.h"
@@ -37,6 +44,8 @@ namespace tensorflow {
 namespace profiler {
 namespace {
 
+using ::tensorflow::protobuf::util::MessageDifferencer;
+
 static constexpr char kXPlanePb[] = "xplane.pb";
 
 TEST(ConvertXPlaneToOpStats, PerfEnv) {
@@ -200,6 +209,40 @@ TEST(ConvertXPlaneToOpStats, Hostnames) {
       op_stats.core_id_to_details().at(kDefaultGpuLocalCoreId).hostname());
 }
 
+// Adds <num_planes> GPU planes of <num_events> "matmul" events of 40 ps each.
+void AddGpuPlanes(int num_planes, int num_events, XSpace* space) {
+  for (int device = 0; device < num_planes; ++device) {
+    XPlaneBuilder device_plane_builder(GetOrCreateGpuXPlane(space, device));
+    auto stream = device_plane_builder.GetOrCreateLine(0);
+    for (int i = 0; i < num_events; ++i) {
+      CreateXEvent(&device_plane_builder, &stream, "matmul", 50 * i, 40,
+                   {{StatType::kCorrelationId, int64_t{i}}});
+    }
+  }
+}
+
+TEST(ConvertXPlaneToOpStats, CombinesDevicePlanes) {
+  OpStatsOptions options;
+  options.generate_op_metrics_db = true;
+  options.generate_kernel_stats_db = true;
+  XSpace one_device;
+  AddGpuPlanes(/*num_planes=*/1, /*num_events=*/10, &one_device);
+  XSpace eight_devices;
+  AddGpuPlanes(/*num_planes=*/8, /*num_events=*/10, &eight_devices);
+
+  OpStats one_device_op_stats = ConvertXSpaceToOpStats(one_device, options);
+  OpStats op_stats = ConvertXSpaceToOpStats(eight_devices, options);
+  EXPECT_EQ(op_stats.run_environment().device_core_count(), 8);
+  EXPECT_GT(one_device_op_stats.device_op_metrics_db().total_op_time_ps(), 0);
+  EXPECT_EQ(op_stats.device_op_metrics_db().total_op_time_ps(),
+            8 * one_device_op_stats.device_op_metrics_db().total_op_time_ps());
+  // The conversion doesn't depend on the scheduling of the planes.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(MessageDifferencer::Equals(
+        ConvertXSpaceToOpStats(eight_devices, options), op_stats));
+  }
+}
+
 void BuildXSpaceForTest(XSpace& xspace, absl::string_view hostname) {
   constexpr int64_t kStepNum = 123;
   constexpr int64_t kStepId = 456;
@@ -272,6 +315,55 @@ TEST(ConvertXPlaneToOpStats, TestConvertMultiXSpacesToCombinedOpStats) {
             core_details_map.at(1000 + kDefaultGpuLocalCoreId).hostname());
 }
 
+TEST(ConvertXPlaneToOpStats, TestConvertMultiXSpacePathsToCombinedOpStats) {
+  std::vector<XSpace> xspaces(3);
+  std::vector<std::string> paths;
+  for (int i = 0; i < xspaces.size(); ++i) {
+    BuildXSpaceForTest(xspaces[i], absl::StrCat("host", i));
+    paths.push_back(
+        io::JoinPath(testing::TmpDir(), absl::StrCat("host", i, ".xplane.pb")));
+    TF_ASSERT_OK(WriteBinaryProto(Env::Default(), paths.back(), xspaces[i]));
+  }
+  OpStatsOptions options;
+  options.generate_op_metrics_db = true;
+  options.generate_step_db = true;
+
+  OpStats from_xspaces;
+  TF_ASSERT_OK(
+      ConvertMultiXSpacesToCombinedOpStats(xspaces, options, &from_xspaces));
+  OpStats from_paths;
+  TF_ASSERT_OK(
+      ConvertMultiXSpacePathsToCombinedOpStats(paths, options, &from_paths));
+  EXPECT_TRUE(MessageDifferencer::Equals(from_paths, from_xspaces));
+  EXPECT_EQ(from_paths.core_id_to_details().size(), 3);
+
+  paths.push_back(io::JoinPath(testing::TmpDir(), "missing.xplane.pb"));
+  Status status =
+      ConvertMultiXSpacePathsToCombinedOpStats(paths, options, &from_paths);
+  EXPECT_TRUE(errors::IsNotFound(status)) << status;
+}
+
+// Converts the XSpaces of state.range(0) hosts of 8 GPUs each.
+void BM_ConvertMultiXSpacesToCombinedOpStats(
+    ::testing::benchmark::State& state) {
+  std::vector<XSpace> xspaces(state.range(0));
+  for (int i = 0; i < xspaces.size(); ++i) {
+    BuildXSpaceForTest(xspaces[i], absl::StrCat("host", i));
+    AddGpuPlanes(/*num_planes=*/8, /*num_events=*/10000, &xspaces[i]);
+  }
+  OpStatsOptions options;
+  options.generate_op_metrics_db = true;
+  options.generate_step_db = true;
+  options.generate_kernel_stats_db = true;
+  for (auto s : state) {
+    OpStats combined_op_stats;
+    TF_CHECK_OK(ConvertMultiXSpacesToCombinedOpStats(xspaces, options,
+                                                     &combined_op_stats));
+  }
+}
+
+BENCHMARK(BM_ConvertMultiXSpacesToCombinedOpStats)->Arg(1)->Arg(8)->Arg(32);
+
 }  // namespace
 }  // namespace profiler
 }  // namespace tensorflow
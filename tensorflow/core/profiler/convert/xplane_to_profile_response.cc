@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/convert/op_stats_to_input_pipeline_analysis.h"
 #include "tensorflow/core/profiler/convert/op_stats_to_overview_page.h"
+#include "tensorflow/core/profiler/convert/op_stats_to_roofline_model.h"
 #include "tensorflow/core/profiler/convert/op_stats_to_tf_stats.h"
 #include "tensorflow/core/profiler/convert/trace_events_to_json.h"
 #include "tensorflow/core/profiler/convert/xplane_to_memory_profile.h"
@@ -34,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/protobuf/kernel_stats.pb.h"
 #include "tensorflow/core/profiler/protobuf/memory_profile.pb.h"
 #include "tensorflow/core/profiler/protobuf/overview_page.pb.h"
+#include "tensorflow/core/profiler/protobuf/roofline_model.pb.h"
 #include "tensorflow/core/profiler/protobuf/tf_stats.pb.h"
 #include "tensorflow/core/profiler/protobuf/trace_events.pb.h"
 #include "tensorflow/core/profiler/protobuf/xplane.pb.h"
@@ -49,6 +51,7 @@ const absl::string_view kTensorflowStats = "tensorflow_stats";
 const absl::string_view kInputPipeline = "input_pipeline";
 const absl::string_view kOverviewPage = "overview_page";
 const absl::string_view kKernelStats = "kernel_stats";
+const absl::string_view kRooflineModel = "roofline_model";
 const absl::string_view kMemoryProfile = "memory_profile";
 const absl::string_view kXPlanePb = "xplane.pb";
 
@@ -116,6 +119,10 @@ Status ConvertXSpaceToProfileResponse(const XSpace& xspace,
   if (tools.contains(kKernelStats)) {
     AddToolData(ToolName(kKernelStats), op_stats.kernel_stats_db(), response);
   }
+  if (tools.contains(kRooflineModel)) {
+    AddToolData(ToolName(kRooflineModel),
+                ConvertOpStatsToRooflineModel(op_stats), response);
+  }
   if (tools.contains(kMemoryProfile)) {
     std::string json_output;
     TF_RETURN_IF_ERROR(ConvertXSpaceToMemoryProfileJson(xspace, &json_output));
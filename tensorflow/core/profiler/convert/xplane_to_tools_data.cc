@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/convert/op_stats_to_input_pipeline_analysis.h"
 #include "tensorflow/core/profiler/convert/op_stats_to_overview_page.h"
 #include "tensorflow/core/profiler/convert/op_stats_to_pod_viewer.h"
+#include "tensorflow/core/profiler/convert/op_stats_to_roofline_model.h"
 #include "tensorflow/core/profiler/convert/op_stats_to_tf_stats.h"
 #include "tensorflow/core/profiler/convert/xplane_to_memory_profile.h"
 #include "tensorflow/core/profiler/convert/xplane_to_op_stats.h"
@@ -36,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/protobuf/op_stats.pb.h"
 #include "tensorflow/core/profiler/protobuf/overview_page.pb.h"
 #include "tensorflow/core/profiler/protobuf/pod_viewer.pb.h"
+#include "tensorflow/core/profiler/protobuf/roofline_model.pb.h"
 #include "tensorflow/core/profiler/protobuf/tf_data_stats.pb.h"
 #include "tensorflow/core/profiler/protobuf/tf_stats.pb.h"
 #include "tensorflow/core/profiler/protobuf/xplane.pb.h"
@@ -115,6 +117,24 @@ std::pair<std::string, bool> ConvertMultiXSpacesToTfStats(
       ConvertOpStatsToTfStats(combined_op_stats).SerializeAsString(), true);
 }
 
+std::pair<std::string, bool> ConvertMultiXSpacesToRooflineModel(
+    const std::vector<XSpace>& xspaces) {
+  OpStatsOptions options;
+  options.generate_op_metrics_db = true;
+  options.generate_kernel_stats_db = true;
+  OpStats combined_op_stats;
+  Status status = ConvertMultiXSpacesToCombinedOpStats(xspaces, options,
+                                                       &combined_op_stats);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not generate OpStats for roofline model. Error: "
+                 << status.error_message();
+    return std::make_pair("", false);
+  }
+  return std::make_pair(
+      ConvertOpStatsToRooflineModel(combined_op_stats).SerializeAsString(),
+      true);
+}
+
 std::pair<std::string, bool> ConvertMultiXSpacesToKernelStats(
     const std::vector<XSpace>& xspaces) {
   OpStatsOptions options;
@@ -216,6 +236,8 @@ std::pair<std::string, bool> ConvertMultiXSpacesToToolData(
     return ConvertMultiXSpacesToTfStats(xspaces);
   } else if (tool_name == "kernel_stats") {
     return ConvertMultiXSpacesToKernelStats(xspaces);
+  } else if (tool_name == "roofline_model") {
+    return ConvertMultiXSpacesToRooflineModel(xspaces);
   } else if (tool_name == "memory_profile") {
     return ConvertXSpaceToMemoryProfile(xspaces);
   } else if (tool_name == "pod_viewer") {
@@ -0,0 +1,185 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/internal/cpu/continuous_profiler.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/hash.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/internal/cpu/host_tracer_utils.h"
+#include "tensorflow/core/profiler/lib/profiler_lock.h"
+#include "tensorflow/core/profiler/utils/xplane_schema.h"
+#include "tensorflow/core/profiler/utils/xplane_utils.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+// Returns the name of a TraceMe event without its encoded metadata.
+absl::string_view OpName(const std::string& event_name) {
+  absl::string_view name = event_name;
+  return name.substr(0, name.find('#'));
+}
+
+}  // namespace
+
+ContinuousProfiler::ContinuousProfiler(const Options& options)
+    : options_(options) {
+  thread_.reset(Env::Default()->StartThread(
+      ThreadOptions(), "continuous_profiler", [this]() { Run(); }));
+}
+
+ContinuousProfiler::~ContinuousProfiler() {
+  mutex_lock l(mu_);
+  stop_ = true;
+  stop_cv_.notify_all();
+}
+
+void ContinuousProfiler::Run() {
+  for (int64_t window = 0;; ++window) {
+    {
+      mutex_lock l(mu_);
+      if (stop_) return;
+    }
+    bool recording =
+        window % std::max(options_.window_sample_one_in, 1) == 0 &&
+        AcquireProfilerLock();
+    if (recording && !TraceMeRecorder::Start(options_.trace_level)) {
+      ReleaseProfilerLock();
+      recording = false;
+    }
+    {
+      mutex_lock l(mu_);
+      if (!stop_) {
+        stop_cv_.wait_for(l, std::chrono::milliseconds(options_.window_ms));
+      }
+    }
+    if (recording) {
+      TraceMeRecorder::Events events = TraceMeRecorder::Stop();
+      ReleaseProfilerLock();
+      AddWindow(std::move(events));
+    }
+  }
+}
+
+bool ContinuousProfiler::IsSampled(absl::string_view name) const {
+  return options_.op_sample_one_in <= 1 ||
+         Hash64(name.data(), name.size()) % options_.op_sample_one_in == 0;
+}
+
+void ContinuousProfiler::AddWindow(TraceMeRecorder::Events events) {
+  struct Span {
+    TraceMeRecorder::Event* event;
+    int64_t self_time_ns;
+  };
+  mutex_lock l(mu_);
+  for (TraceMeRecorder::ThreadEvents& thread_events : events) {
+    // Complete events, ordered so that each one comes after the events that
+    // enclose it.
+    std::vector<Span> spans;
+    for (TraceMeRecorder::Event& event : thread_events.events) {
+      if (!event.IsComplete()) continue;
+      spans.push_back({&event, event.end_time - event.start_time});
+    }
+    std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b) {
+      return a.event->start_time != b.event->start_time
+                 ? a.event->start_time < b.event->start_time
+                 : a.event->end_time > b.event->end_time;
+    });
+    std::vector<Span*> enclosing;
+    for (Span& span : spans) {
+      while (!enclosing.empty() &&
+             enclosing.back()->event->end_time <= span.event->start_time) {
+        enclosing.pop_back();
+      }
+      if (!enclosing.empty() &&
+          span.event->end_time <= enclosing.back()->event->end_time) {
+        enclosing.back()->self_time_ns -=
+            span.event->end_time - span.event->start_time;
+      }
+      enclosing.push_back(&span);
+    }
+
+    for (const Span& span : spans) {
+      const TraceMeRecorder::Event& event = *span.event;
+      const uint64 time_ps = (event.end_time - event.start_time) * 1000;
+      const absl::string_view name = OpName(event.name);
+      OpMetrics& metrics = op_metrics_[name];
+      if (metrics.occurrences() == 0) {
+        metrics.set_name(std::string(name));
+        metrics.set_min_time_ps(std::numeric_limits<uint64>::max());
+      }
+      metrics.set_occurrences(metrics.occurrences() + 1);
+      metrics.set_time_ps(metrics.time_ps() + time_ps);
+      metrics.set_min_time_ps(std::min(metrics.min_time_ps(), time_ps));
+      metrics.set_self_time_ps(metrics.self_time_ps() +
+                               std::max<int64_t>(span.self_time_ns, 0) * 1000);
+    }
+
+    ThreadHistory& history = history_[thread_events.thread.tid];
+    history.thread = thread_events.thread;
+    for (TraceMeRecorder::Event& event : thread_events.events) {
+      if (!event.IsComplete() || !IsSampled(OpName(event.name))) continue;
+      history.events.push_back(std::move(event));
+      if (static_cast<int64_t>(history.events.size()) >
+          options_.max_events_per_thread) {
+        history.events.pop_front();
+      }
+    }
+  }
+}
+
+OpMetricsDb ContinuousProfiler::TakeOpMetrics() {
+  absl::flat_hash_map<std::string, OpMetrics> op_metrics;
+  {
+    mutex_lock l(mu_);
+    std::swap(op_metrics, op_metrics_);
+  }
+  OpMetricsDb db;
+  for (auto& name_and_metrics : op_metrics) {
+    db.set_total_op_time_ps(db.total_op_time_ps() +
+                            name_and_metrics.second.self_time_ps());
+    *db.add_metrics_db() = std::move(name_and_metrics.second);
+  }
+  return db;
+}
+
+Status ContinuousProfiler::DumpRecentHistory(XSpace* space) {
+  TraceMeRecorder::Events events;
+  int64_t start_timestamp_ns = std::numeric_limits<int64_t>::max();
+  {
+    mutex_lock l(mu_);
+    for (const auto& tid_and_history : history_) {
+      const ThreadHistory& history = tid_and_history.second;
+      if (history.events.empty()) continue;
+      events.push_back({history.thread, history.events});
+      for (const TraceMeRecorder::Event& event : history.events) {
+        start_timestamp_ns = std::min(start_timestamp_ns, event.start_time);
+      }
+    }
+  }
+  if (events.empty()) start_timestamp_ns = 0;
+  XPlane* plane = FindOrAddMutablePlaneWithName(space, kHostThreadsPlaneName);
+  ConvertCompleteEventsToXPlane(start_timestamp_ns, std::move(events), plane);
+  return Status::OK();
+}
+
+}  // namespace profiler
+}  // namespace tensorflow
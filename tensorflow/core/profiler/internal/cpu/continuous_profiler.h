@@ -0,0 +1,108 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_CONTINUOUS_PROFILER_H_
+#define TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_CONTINUOUS_PROFILER_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/internal/cpu/traceme_recorder.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+
+namespace tensorflow {
+namespace profiler {
+
+// Records TraceMe events continuously at a low level, for production jobs
+// whose rare slow steps can't be caught by on-demand profiling.
+//
+// A background thread records the host TraceMe events in windows of
+// `window_ms`, of which only one in `window_sample_one_in` is recorded. After
+// each window, the events are aggregated by name into op metrics, and the
+// events of one in `op_sample_one_in` names, chosen by the hash of the name
+// so that sampled ops keep all of their events, are kept in a ring of at
+// most `max_events_per_thread` events per thread. TakeOpMetrics() returns
+// the aggregated metrics, and DumpRecentHistory() the events in the rings,
+// e.g. when a step is found to be slow.
+//
+// A window is recorded only if no ProfilerSession is active, and a
+// ProfilerSession can't start while a window is recorded, so on-demand
+// captures should be retried after a window.
+class ContinuousProfiler {
+ public:
+  struct Options {
+    // The TraceMe level to record, 1 for the critical events only.
+    int trace_level = 1;
+    int64_t window_ms = 1000;
+    int window_sample_one_in = 1;
+    int op_sample_one_in = 1;
+    int64_t max_events_per_thread = 10000;
+  };
+
+  // Starts recording in the background.
+  explicit ContinuousProfiler(const Options& options);
+
+  // Stops recording, after the current window.
+  ~ContinuousProfiler();
+
+  // Returns the metrics of the ops recorded since the previous call, whose
+  // times are the total and self times of their events, and resets them.
+  OpMetricsDb TakeOpMetrics();
+
+  // Adds a host plane with the events in the rings to `space`.
+  Status DumpRecentHistory(XSpace* space);
+
+ private:
+  struct ThreadHistory {
+    TraceMeRecorder::ThreadInfo thread;
+    std::deque<TraceMeRecorder::Event> events;
+  };
+
+  // Records windows until the profiler is destroyed.
+  void Run();
+
+  // Adds the events of a window to the op metrics and the history.
+  void AddWindow(TraceMeRecorder::Events events);
+
+  // Returns true if the events of `name` are kept in the history.
+  bool IsSampled(absl::string_view name) const;
+
+  const Options options_;
+
+  mutex mu_;
+  condition_variable stop_cv_;
+  bool stop_ TF_GUARDED_BY(mu_) = false;
+  absl::flat_hash_map<std::string, OpMetrics> op_metrics_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<uint32, ThreadHistory> history_ TF_GUARDED_BY(mu_);
+
+  // Last, so that it is joined before the rest is destroyed.
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ContinuousProfiler);
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_INTERNAL_CPU_CONTINUOUS_PROFILER_H_
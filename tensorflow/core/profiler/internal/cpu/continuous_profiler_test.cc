@@ -0,0 +1,116 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/internal/cpu/continuous_profiler.h"
+
+#include <algorithm>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/profiler/lib/profiler_lock.h"
+#include "tensorflow/core/profiler/protobuf/op_metrics.pb.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+#include "tensorflow/core/profiler/utils/time_utils.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+constexpr int64_t kMaxWaitMicros = 10 * 1000 * 1000;
+
+ContinuousProfiler::Options FastOptions() {
+  ContinuousProfiler::Options options;
+  options.window_ms = 10;
+  return options;
+}
+
+// Records an "Outer" event enclosing two "Inner" events of 1us each, until
+// the profiler has aggregated both names, and returns their metrics by name.
+absl::flat_hash_map<std::string, OpMetrics> RecordUntilAggregated(
+    ContinuousProfiler* profiler) {
+  absl::flat_hash_map<std::string, OpMetrics> metrics_by_name;
+  for (int64_t waited = 0; waited < kMaxWaitMicros; waited += 1000) {
+    const int64_t start = GetCurrentTimeNanos();
+    TraceMeRecorder::Record({"Outer#step=1#", start, start + 3000});
+    TraceMeRecorder::Record({"Inner", start + 500, start + 1500});
+    TraceMeRecorder::Record({"Inner", start + 1500, start + 2500});
+    Env::Default()->SleepForMicroseconds(1000);
+    for (const OpMetrics& metrics : profiler->TakeOpMetrics().metrics_db()) {
+      OpMetrics& total = metrics_by_name[metrics.name()];
+      total.set_name(metrics.name());
+      total.set_min_time_ps(total.occurrences() == 0
+                                ? metrics.min_time_ps()
+                                : std::min(total.min_time_ps(),
+                                           metrics.min_time_ps()));
+      total.set_occurrences(total.occurrences() + metrics.occurrences());
+      total.set_time_ps(total.time_ps() + metrics.time_ps());
+      total.set_self_time_ps(total.self_time_ps() + metrics.self_time_ps());
+    }
+    if (metrics_by_name.size() == 2) break;
+  }
+  return metrics_by_name;
+}
+
+TEST(ContinuousProfilerTest, AggregatesOpMetrics) {
+  ContinuousProfiler profiler(FastOptions());
+  auto metrics_by_name = RecordUntilAggregated(&profiler);
+  ASSERT_EQ(metrics_by_name.size(), 2);
+
+  const OpMetrics& outer = metrics_by_name["Outer"];
+  EXPECT_EQ(outer.time_ps(), uint64{outer.occurrences()} * 3000 * 1000);
+  // Each event has 1us of self time, or the whole 3us if a window ended
+  // between it and its children.
+  EXPECT_GE(outer.self_time_ps(), uint64{outer.occurrences()} * 1000 * 1000);
+  EXPECT_LT(outer.self_time_ps(), outer.time_ps());
+
+  const OpMetrics& inner = metrics_by_name["Inner"];
+  EXPECT_EQ(inner.min_time_ps(), 1000 * 1000);
+  EXPECT_EQ(inner.self_time_ps(), inner.time_ps());
+}
+
+TEST(ContinuousProfilerTest, DumpsSampledHistory) {
+  ContinuousProfiler::Options options = FastOptions();
+  options.max_events_per_thread = 2;
+  ContinuousProfiler profiler(options);
+  RecordUntilAggregated(&profiler);
+
+  XSpace space;
+  TF_ASSERT_OK(profiler.DumpRecentHistory(&space));
+  ASSERT_EQ(space.planes_size(), 1);
+  int num_events = 0;
+  for (const XLine& line : space.planes(0).lines()) {
+    num_events += line.events_size();
+  }
+  EXPECT_EQ(num_events, 2);
+}
+
+TEST(ContinuousProfilerTest, YieldsToProfilerSessions) {
+  ASSERT_TRUE(AcquireProfilerLock());
+  {
+    ContinuousProfiler profiler(FastOptions());
+    Env::Default()->SleepForMicroseconds(50 * 1000);
+    const int64_t start = GetCurrentTimeNanos();
+    TraceMeRecorder::Record({"Op", start, start + 1000});
+    Env::Default()->SleepForMicroseconds(50 * 1000);
+    EXPECT_EQ(profiler.TakeOpMetrics().metrics_db_size(), 0);
+  }
+  ReleaseProfilerLock();
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
@@ -79,6 +79,7 @@ const HostEventTypeMap& GetHostEventTypeMap() {
       {"ExecutorDoneCallback", kExecutorDoneCallback},
       {"MemoryAllocation", kMemoryAllocation},
       {"MemoryDeallocation", kMemoryDeallocation},
+      {"MemoryMapSnapshot", kMemoryMapSnapshot},
       // Performance counter related.
       {"RemotePerfCounter", kRemotePerf},
       // tf data captured function events.
@@ -175,6 +176,7 @@ const StatTypeMap& GetStatTypeMap() {
       {"region_type", kRegionType},
       {"data_type", kDataType},
       {"shape", kTensorShapes},
+      {"bin_summary", kBinSummary},
       {"layout", kTensorLayout},
       {"kpi_name", kKpiName},
       {"kpi_value", kKpiValue},
@@ -303,6 +305,7 @@ bool IsInternalEvent(absl::optional<int64_t> event_type) {
   switch (*event_type) {
     case HostEventType::kMemoryAllocation:
     case HostEventType::kMemoryDeallocation:
+    case HostEventType::kMemoryMapSnapshot:
     case HostEventType::kPrefetchProduce:
     case HostEventType::kPrefetchConsume:
     case HostEventType::kParallelInterleaveProduce:
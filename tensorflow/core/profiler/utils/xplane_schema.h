@@ -76,6 +76,7 @@ enum HostEventType {
   kExecutorDoneCallback,
   kMemoryAllocation,
   kMemoryDeallocation,
+  kMemoryMapSnapshot,
   // Performance counter related.
   kRemotePerf,
   // tf.data captured function events.
@@ -166,6 +167,7 @@ enum StatType {
   kRegionType,
   kDataType,
   kTensorShapes,
+  kBinSummary,
   kTensorLayout,
   kKpiName,
   kKpiValue,
@@ -126,7 +126,7 @@ class FallbackBatchResource : public tensorflow::serving::BatchResourceBase {
 
   void ProcessFuncBatchImpl(
       const BatchTask& last_task, absl::Span<const Tensor> inputs,
-      std::vector<Tensor>* combined_outputs,
+      std::vector<Tensor>* combined_outputs, RequestCost* batch_cost,
       std::function<void(const Status&)> done) const override;
 
   Status CreateBatchTask(OpKernelContext* c,
@@ -313,7 +313,7 @@ StatusOr<RCReference<tfrt::RequestContext>> SetUpRequestContext(
 
 void FallbackBatchResource::ProcessFuncBatchImpl(
     const BatchTask& last_task, absl::Span<const Tensor> inputs,
-    std::vector<Tensor>* combined_outputs,
+    std::vector<Tensor>* combined_outputs, RequestCost* batch_cost,
     std::function<void(const Status&)> done) const {
   SmallVector<AsyncValue*, 8> arguments;
   arguments.reserve(inputs.size() + 1);
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/summary/summary_file_writer.h"
 
+#include <algorithm>
+
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -23,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/summary/summary_converter.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/events_writer.h"
 #include "tensorflow/core/util/ptr_util.h"
 
@@ -54,9 +57,17 @@ class SummaryFileWriter : public SummaryWriterInterface {
     string sep = absl::StartsWith(filename_suffix, ".") ? "" : ".";
     const string uniquified_filename_suffix = absl::StrCat(
         ".", pid, ".", file_id_counter.fetch_add(1), sep, filename_suffix);
+    // With TF_SUMMARY_WRITER_ASYNC, the events are written and flushed by a
+    // background thread, and only explicit flushes wait for them.
+    TF_RETURN_IF_ERROR(
+        ReadBoolFromEnvVar("TF_SUMMARY_WRITER_ASYNC", false, &async_));
+    EventsWriter::Options options;
+    if (async_) {
+      options.max_queued_events = std::max(max_queue_, 1) * 2;
+    }
     mutex_lock ml(mu_);
-    events_writer_ =
-        tensorflow::MakeUnique<EventsWriter>(io::JoinPath(logdir, "events"));
+    events_writer_ = tensorflow::MakeUnique<EventsWriter>(
+        io::JoinPath(logdir, "events"), options);
     TF_RETURN_WITH_CONTEXT_IF_ERROR(
         events_writer_->InitWithSuffix(uniquified_filename_suffix),
         "Could not initialize events writer.");
@@ -70,7 +81,7 @@ class SummaryFileWriter : public SummaryWriterInterface {
     if (!is_initialized_) {
       return errors::FailedPrecondition("Class was not properly initialized.");
     }
-    return InternalFlush();
+    return InternalFlush(/*wait=*/true);
   }
 
   ~SummaryFileWriter() override {
@@ -154,7 +165,7 @@ class SummaryFileWriter : public SummaryWriterInterface {
     queue_.emplace_back(std::move(event));
     if (queue_.size() > max_queue_ ||
         env_->NowMicros() - last_flush_ > 1000 * flush_millis_) {
-      return InternalFlush();
+      return InternalFlush(/*wait=*/!async_);
     }
     return Status::OK();
   }
@@ -166,18 +177,22 @@ class SummaryFileWriter : public SummaryWriterInterface {
     return static_cast<double>(env_->NowMicros()) / 1.0e6;
   }
 
-  Status InternalFlush() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  // Unless `wait` is set, only requests the asynchronous events writer to
+  // flush, and reports the errors of its previous flush.
+  Status InternalFlush(bool wait) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     for (const std::unique_ptr<Event>& e : queue_) {
       events_writer_->WriteEvent(*e);
     }
     queue_.clear();
-    TF_RETURN_WITH_CONTEXT_IF_ERROR(events_writer_->Flush(),
-                                    "Could not flush events file.");
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(
+        wait ? events_writer_->Flush() : events_writer_->RequestFlush(),
+        "Could not flush events file.");
     last_flush_ = env_->NowMicros();
     return Status::OK();
   }
 
   bool is_initialized_;
+  bool async_ = false;
   const int max_queue_;
   const int flush_millis_;
   uint64 last_flush_;
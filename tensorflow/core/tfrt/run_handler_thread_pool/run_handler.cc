@@ -13,7 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <atomic>
+#include <limits>
 #define EIGEN_USE_THREADS
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -40,6 +42,15 @@ namespace {
 typedef typename internal::RunHandlerEnvironment::Task Task;
 typedef Eigen::RunQueue<Task, 1024> Queue;
 
+auto* run_handler_queueing_delay_usecs =
+    tensorflow::monitoring::Sampler<1>::New(
+        {"/tensorflow/tfrt/run_handler/queueing_delay",
+         "Record the time in microseconds tasks wait in the run handler queues "
+         "before being executed.",
+         "priority"},
+        // Scale of 10, power of 1.8 with bucket count 33 (~20 minutes).
+        tensorflow::monitoring::Buckets::Exponential(10, 1.8, 33));
+
 }  // namespace
 
 namespace internal {
@@ -74,6 +85,7 @@ RunHandlerEnvironment::Task RunHandlerEnvironment::CreateTask(TaskFunction f) {
           std::move(f),
           tensorflow::Context(tensorflow::ContextKind::kThread),
           id,
+          /*enqueue_time_us=*/0,
       }),
   };
 }
@@ -133,6 +145,7 @@ ThreadWorkSource::ThreadWorkSource()
       non_blocking_inflight_(0),
       pending_tasks_(0),
       traceme_id_(0),
+      queueing_delay_cell_(run_handler_queueing_delay_usecs->GetCell("0")),
       version_(0),
       sub_thread_pool_waiter_(nullptr) {
   queue_waiters_.next = &queue_waiters_;
@@ -267,6 +280,16 @@ int64_t ThreadWorkSource::GetTracemeId() {
 
 void ThreadWorkSource::SetTracemeId(int64_t value) { traceme_id_ = value; }
 
+void ThreadWorkSource::SetPriority(int64_t value) {
+  queueing_delay_cell_.store(run_handler_queueing_delay_usecs->GetCell(
+                                 tensorflow::strings::StrCat(value)),
+                             std::memory_order_relaxed);
+}
+
+void ThreadWorkSource::RecordQueueingDelay(uint64_t delay_us) {
+  queueing_delay_cell_.load(std::memory_order_relaxed)->Add(delay_us);
+}
+
 void ThreadWorkSource::SetWaiter(uint64_t version, Waiter* waiter,
                                  tensorflow::mutex* mutex) {
   {
@@ -348,6 +371,8 @@ RunHandlerThreadPool::RunHandlerThreadPool(
       blocking_thread_max_waiting_time_(
           options.blocking_threads_max_sleep_time_micro_sec),
       enable_wake_up_(options.enable_wake_up),
+      preempt_lower_priority_work_(options.preempt_lower_priority_work),
+      queueing_delay_sampling_period_(options.queueing_delay_sampling_period),
       thread_data_(num_threads_),
       env_(env, thread_options, name),
       name_(name),
@@ -412,6 +437,13 @@ void RunHandlerThreadPool::StartOneThreadForTesting() {
 void RunHandlerThreadPool::AddWorkToQueue(ThreadWorkSource* tws,
                                           bool is_blocking, TaskFunction fn) {
   Task t = env_.CreateTask(std::move(fn));
+  if (queueing_delay_sampling_period_ > 0) {
+    // Counted per thread, so that sampling doesn't contend between threads.
+    static thread_local int64_t num_tasks = 0;
+    if (++num_tasks % queueing_delay_sampling_period_ == 0) {
+      t.f->enqueue_time_us = env_.env_->NowMicros();
+    }
+  }
   t = tws->EnqueueTask(std::move(t), is_blocking, enable_wake_up_);
   if (t.f) {
     VLOG(3) << "Running " << (is_blocking ? "inter" : "intra") << " work for "
@@ -476,7 +508,11 @@ Task RunHandlerThreadPool::FindTask(
     const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources,
     bool* task_from_blocking_queue, ThreadWorkSource** tws) {
   Task t;
-  int current_index = thread_data_[thread_id].current_index;
+  // Searching from the start lets a thread pick the work of a higher priority
+  // request as soon as it has finished a task of a lower priority one.
+  int current_index = preempt_lower_priority_work_
+                          ? searching_range_start
+                          : thread_data_[thread_id].current_index;
   *task_from_blocking_queue = false;
 
   for (int i = 0; i < searching_range_end - searching_range_start; ++i) {
@@ -573,6 +609,10 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
     if (t.f) {
       VLOG(2) << "Running " << (task_from_blocking_queue ? "inter" : "intra")
               << " work from " << tws->GetTracemeId();
+      if (t.f->enqueue_time_us != 0) {
+        tws->RecordQueueingDelay(env_.env_->NowMicros() -
+                                 t.f->enqueue_time_us);
+      }
       tws->IncrementInflightTaskCount(task_from_blocking_queue);
       env_.ExecuteTask(t);
       tws->DecrementInflightTaskCount(task_from_blocking_queue);
@@ -675,7 +715,16 @@ class RunHandler::Impl {
 
   internal::ThreadWorkSource* tws() { return &tws_; }
 
-  int64_t priority() const { return options_.priority; }
+  // The priority of the request, or the one it inherited if higher.
+  int64_t priority() const { return priority_; }
+
+  // Sets the priority inherited from a request blocked on this one. Only
+  // called by RunHandlerPool::Impl, under its lock.
+  void set_priority(int64_t priority) { priority_ = priority; }
+
+  // Time in microseconds since unix epoch when the latency budget of the
+  // request runs out, or the max value if it has no budget.
+  uint64_t deadline_us() const { return deadline_us_; }
 
  private:
   class RunHandlerEigenThreadPool
@@ -701,7 +750,9 @@ class RunHandler::Impl {
   RunHandlerPool::Impl* pool_impl_;  // NOT OWNED.
   RunHandlerEigenThreadPool eigen_thread_pool_;
   uint64_t start_time_us_;
+  uint64_t deadline_us_;
   int64_t step_id_;
+  int64_t priority_;
   internal::ThreadWorkSource tws_;
   RunHandlerOptions options_;
 };
@@ -724,7 +775,9 @@ class RunHandlerPool::Impl {
                 options.use_adaptive_waiting_time, options.enable_wake_up,
                 options.max_concurrent_handler,
                 options.num_threads_in_sub_thread_pool,
-                options.sub_thread_request_percentage),
+                options.sub_thread_request_percentage,
+                options.preempt_lower_priority_work,
+                options.queueing_delay_sampling_period),
             tensorflow::Env::Default(), tensorflow::ThreadOptions(),
             "tf_run_handler_pool", &waiters_mu_, &queue_waiters_)),
         iterations_(0),
@@ -804,28 +857,36 @@ class RunHandlerPool::Impl {
       handler_impl->Reset(step_id, options);
       free_handlers_.pop_back();
 
-      num_active_requests = sorted_active_handlers_.size() + 1;
-      thread_work_sources->resize(num_active_requests);
-      int priority = options.priority;
-      auto it = sorted_active_handlers_.cbegin();
-      bool new_handler_inserted = false;
-      for (int i = 0; i < num_active_requests; ++i) {
-        if (!new_handler_inserted && (it == sorted_active_handlers_.cend() ||
-                                      priority > (*it)->priority())) {
-          sorted_active_handlers_.insert(it, handler_impl);
-          new_handler_inserted = true;
-          // Point to the newly added handler.
-          --it;
-        }
-        (*thread_work_sources)[i] = (*it)->tws();
-        ++it;
-      }
+      InsertActiveHandler(handler_impl);
+      num_active_requests = GetThreadWorkSources(thread_work_sources.get());
       version = ++version_;
     }
     RecomputePoolStats(num_active_requests, version, *thread_work_sources);
     return tensorflow::WrapUnique<RunHandler>(new RunHandler(handler_impl));
   }
 
+  void InheritPriority(RunHandler::Impl* handler, int priority)
+      TF_LOCKS_EXCLUDED(mu_) {
+    thread_local auto thread_work_sources =
+        absl::make_unique<Eigen::MaxSizeVector<internal::ThreadWorkSource*>>(
+            max_handlers_);
+    uint64_t version;
+    int num_active_requests;
+    {
+      tensorflow::mutex_lock l(mu_);
+      if (priority <= handler->priority()) {
+        return;
+      }
+      // Move the handler to its place in the order of the new priority.
+      sorted_active_handlers_.remove(handler);
+      handler->set_priority(priority);
+      InsertActiveHandler(handler);
+      num_active_requests = GetThreadWorkSources(thread_work_sources.get());
+      version = ++version_;
+    }
+    RecomputePoolStats(num_active_requests, version, *thread_work_sources);
+  }
+
   void ReleaseHandler(RunHandler::Impl* handler) TF_LOCKS_EXCLUDED(mu_) {
     tensorflow::mutex_lock l(mu_);
     DCHECK_GT(sorted_active_handlers_.size(), 0);
@@ -875,6 +936,16 @@ class RunHandlerPool::Impl {
     return ret;
   }
 
+  std::vector<int64_t> GetActiveHandlerStepIdsForTesting()
+      TF_LOCKS_EXCLUDED(mu_) {
+    tensorflow::mutex_lock l(mu_);
+    std::vector<int64_t> ret;
+    for (const auto& handler_impl : sorted_active_handlers_) {
+      ret.push_back(handler_impl->step_id());
+    }
+    return ret;
+  }
+
   void Quiesce() TF_LOCKS_EXCLUDED(mu_) {
     while (true) {
       {
@@ -904,6 +975,17 @@ class RunHandlerPool::Impl {
 
   void LogInfo() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Inserts `handler` in sorted_active_handlers_ after the handlers of higher
+  // priority, and of the same priority with an earlier or the same deadline.
+  void InsertActiveHandler(RunHandler::Impl* handler)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Sets `thread_work_sources` to those of sorted_active_handlers_, in order,
+  // and returns their number.
+  int GetThreadWorkSources(
+      Eigen::MaxSizeVector<internal::ThreadWorkSource*>* thread_work_sources)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Maximum number of handlers pre-created during pool construction time. The
   // number has been chosen expecting each handler might at least want 1
   // inter-op thread for execution (during compute intensive workloads like
@@ -915,8 +997,7 @@ class RunHandlerPool::Impl {
 
   std::unique_ptr<internal::RunHandlerThreadPool> run_handler_thread_pool_;
   // Thread compatible part used only by lock under RunHandlerPool.
-  // Handlers are sorted by start time.
-  // TODO(azaks): sort by the remaining latency budget.
+  // Handlers are sorted by priority, then by deadline, then by start time.
   // TODO(chaox): Consider other data structure for maintaining the sorted
   // active handlers if the searching overhead(currently O(n)) becomes the
   // bottleneck.
@@ -962,6 +1043,27 @@ void RunHandlerPool::Impl::RecomputePoolStats(
   }
 }
 
+void RunHandlerPool::Impl::InsertActiveHandler(RunHandler::Impl* handler) {
+  auto it = std::find_if(
+      sorted_active_handlers_.begin(), sorted_active_handlers_.end(),
+      [handler](const RunHandler::Impl* other) {
+        if (handler->priority() != other->priority()) {
+          return handler->priority() > other->priority();
+        }
+        return handler->deadline_us() < other->deadline_us();
+      });
+  sorted_active_handlers_.insert(it, handler);
+}
+
+int RunHandlerPool::Impl::GetThreadWorkSources(
+    Eigen::MaxSizeVector<internal::ThreadWorkSource*>* thread_work_sources) {
+  thread_work_sources->resize(0);
+  for (RunHandler::Impl* handler : sorted_active_handlers_) {
+    thread_work_sources->push_back(handler->tws());
+  }
+  return thread_work_sources->size();
+}
+
 void RunHandlerPool::Impl::LogInfo() {
   if (iterations_++ % 50000 == 10 && VLOG_IS_ON(1)) {
     int num_active_requests = sorted_active_handlers_.size();
@@ -1007,9 +1109,14 @@ void RunHandler::Impl::ScheduleIntraOpClosure(TaskFunction fn) {
 void RunHandler::Impl::Reset(int64_t step_id,
                              const RunHandlerOptions& options) {
   start_time_us_ = tensorflow::Env::Default()->NowMicros();
+  deadline_us_ = options.latency_budget_in_ms > 0
+                     ? start_time_us_ + options.latency_budget_in_ms * 1000
+                     : std::numeric_limits<uint64_t>::max();
   step_id_ = step_id;
+  priority_ = options.priority;
   options_ = options;
   tws_.SetTracemeId(step_id);
+  tws_.SetPriority(options.priority);
 }
 
 int RunHandler::Impl::RunHandlerEigenThreadPool::NumThreads() const {
@@ -1034,6 +1141,11 @@ std::vector<int64_t> RunHandlerPool::GetActiveHandlerPrioritiesForTesting()
   return impl_->GetActiveHandlerPrioritiesForTesting();
 }
 
+std::vector<int64_t> RunHandlerPool::GetActiveHandlerStepIdsForTesting()
+    const {
+  return impl_->GetActiveHandlerStepIdsForTesting();
+}
+
 void RunHandlerPool::Quiesce() const { impl_->Quiesce(); }
 
 RunHandler::RunHandler(Impl* impl) : impl_(impl) {}
@@ -1052,6 +1164,10 @@ int RunHandler::NumThreads() const {
 
 int64_t RunHandler::step_id() const { return impl_->step_id(); }
 
+void RunHandler::InheritPriority(int priority) {
+  impl_->pool_impl()->InheritPriority(impl_, priority);
+}
+
 tensorflow::thread::ThreadPoolInterface*
 RunHandler::AsIntraThreadPoolInterface() const {
   return impl_->thread_pool_interface();
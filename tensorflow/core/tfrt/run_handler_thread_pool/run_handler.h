@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/histogram/histogram.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -37,10 +38,15 @@ class RunHandler;
 
 // Options for RunHanler.
 struct RunHandlerOptions {
-  RunHandlerOptions() : priority(0) {}
+  RunHandlerOptions() : priority(0), latency_budget_in_ms(0) {}
 
   // Request priority.
   int priority;
+
+  // Latency budget of the request, counted from RunHandlerPool::Get(). Among
+  // requests of the same priority, the one whose budget runs out first is
+  // scheduled first. 0 means no budget, which comes after all budgets.
+  int64_t latency_budget_in_ms;
 };
 
 // RunHandlerPool is a fixed size pool of pre-allocated RunHandlers
@@ -101,6 +107,17 @@ class RunHandlerPool {
 
     // If true, threads will be waken up by new tasks.
     bool enable_wake_up = true;
+
+    // If true, threads search for tasks from the first request in the
+    // priority order after every task, instead of in a round robin fashion,
+    // so that lower priority requests are preempted between their kernels.
+    bool preempt_lower_priority_work = false;
+
+    // If positive, the queueing delay of one in every
+    // `queueing_delay_sampling_period` tasks scheduled by a thread is recorded
+    // in /tensorflow/tfrt/run_handler/queueing_delay. 0 disables the metric,
+    // which costs two clock reads and a histogram update per sampled task.
+    int queueing_delay_sampling_period = 0;
   };
   explicit RunHandlerPool(Options options);
   ~RunHandlerPool();
@@ -121,6 +138,10 @@ class RunHandlerPool {
   // order of the active handler list.
   std::vector<int64_t> GetActiveHandlerPrioritiesForTesting() const;
 
+  // Get the step ids for active handlers, in the order of the active handler
+  // list.
+  std::vector<int64_t> GetActiveHandlerStepIdsForTesting() const;
+
   // Block until the system is quiescent (no pending work and no inflight work).
   void Quiesce() const;
 
@@ -154,6 +175,12 @@ class RunHandler {
 
   int64_t step_id() const;
 
+  // Raises the priority of this handler to `priority`, if it is higher, until
+  // the handler is released. To be called when a request of `priority` blocks
+  // on work of this handler, e.g. a shared resource it is initializing, so
+  // that the work isn't starved by requests of lower priority.
+  void InheritPriority(int priority);
+
   ~RunHandler();
 
  private:
@@ -175,6 +202,9 @@ class RunHandlerEnvironment {
     TaskFunction f;
     tensorflow::Context context;
     uint64_t trace_id;
+    // Time in microseconds when the task was enqueued, or 0 if its queueing
+    // delay is not sampled.
+    uint64_t enqueue_time_us;
   };
   tensorflow::Env* const env_;
   const tensorflow::ThreadOptions thread_options_;
@@ -232,6 +262,13 @@ class ThreadWorkSource {
 
   void SetTracemeId(int64_t value);
 
+  // Sets the priority of the request the work belongs to, under which the
+  // queueing delays of its tasks are recorded.
+  void SetPriority(int64_t value);
+
+  // Records that a task of this source waited `delay_us` to be executed.
+  void RecordQueueingDelay(uint64_t delay_us);
+
   void SetWaiter(uint64_t version, Waiter* waiter, tensorflow::mutex* mutex);
 
   int64_t GetInflightTaskCount(bool is_blocking);
@@ -273,6 +310,7 @@ class ThreadWorkSource {
   tensorflow::mutex waiters_mu_;
   Waiter queue_waiters_ TF_GUARDED_BY(waiters_mu_);
   std::atomic<int64_t> traceme_id_;
+  std::atomic<tensorflow::monitoring::SamplerCell*> queueing_delay_cell_;
 
   tensorflow::mutex run_handler_waiter_mu_;
   uint64_t version_ TF_GUARDED_BY(run_handler_waiter_mu_);
@@ -294,6 +332,8 @@ class RunHandlerThreadPool {
     int max_concurrent_handler;
     std::vector<int> num_threads_in_sub_thread_pool;
     std::vector<double> sub_thread_request_percentage;
+    bool preempt_lower_priority_work;
+    int queueing_delay_sampling_period;
     Options(int num_blocking_threads, int num_non_blocking_threads,
             bool wait_if_no_active_request,
             int non_blocking_threads_sleep_time_micro_sec,
@@ -301,7 +341,9 @@ class RunHandlerThreadPool {
             bool use_adaptive_waiting_time, bool enable_wake_up,
             int max_concurrent_handler,
             const std::vector<int>& num_threads_in_sub_thread_pool,
-            const std::vector<double>& sub_thread_request_percentage)
+            const std::vector<double>& sub_thread_request_percentage,
+            bool preempt_lower_priority_work = false,
+            int queueing_delay_sampling_period = 0)
         : num_blocking_threads(num_blocking_threads),
           num_non_blocking_threads(num_non_blocking_threads),
           wait_if_no_active_request(wait_if_no_active_request),
@@ -313,7 +355,9 @@ class RunHandlerThreadPool {
           enable_wake_up(enable_wake_up),
           max_concurrent_handler(max_concurrent_handler),
           num_threads_in_sub_thread_pool(num_threads_in_sub_thread_pool),
-          sub_thread_request_percentage(sub_thread_request_percentage) {}
+          sub_thread_request_percentage(sub_thread_request_percentage),
+          preempt_lower_priority_work(preempt_lower_priority_work),
+          queueing_delay_sampling_period(queueing_delay_sampling_period) {}
   };
   struct PerThread {
     constexpr PerThread() : pool(nullptr), thread_id(-1) {}
@@ -354,7 +398,9 @@ class RunHandlerThreadPool {
 
   // Search tasks from Requets range searching_range_start to
   // searching_range_end. If there is no tasks in the search range and
-  // may_steal_blocking_work is true, then search from all requests.
+  // may_steal_blocking_work is true, then search from all requests. The
+  // search starts from searching_range_start if lower priority work is
+  // preempted, and after the last request searched otherwise.
   Task FindTask(
       int searching_range_start, int searching_range_end, int thread_id,
       int sub_thread_pool_id, int max_blocking_inflight,
@@ -392,6 +438,8 @@ class RunHandlerThreadPool {
   const int non_blocking_thread_sleep_time_;
   const int blocking_thread_max_waiting_time_;
   const bool enable_wake_up_;
+  const bool preempt_lower_priority_work_;
+  const int queueing_delay_sampling_period_;
   Eigen::MaxSizeVector<ThreadData> thread_data_;
   internal::RunHandlerEnvironment env_;
   std::atomic<bool> cancelled_;
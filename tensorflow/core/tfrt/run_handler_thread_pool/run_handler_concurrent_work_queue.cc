@@ -53,6 +53,10 @@ RunHandlerThreadWorkQueue::RunHandlerThreadWorkQueue(const Options& options)
   pool_options.enable_wake_up = options.enable_wake_up;
   pool_options.wait_if_no_active_request = options.wait_if_no_active_request;
   pool_options.use_adaptive_waiting_time = options.use_adaptive_waiting_time;
+  pool_options.preempt_lower_priority_work =
+      options.preempt_lower_priority_work;
+  pool_options.queueing_delay_sampling_period =
+      options.queueing_delay_sampling_period;
   handler_pool_ = absl::make_unique<RunHandlerPool>(pool_options);
 }
 
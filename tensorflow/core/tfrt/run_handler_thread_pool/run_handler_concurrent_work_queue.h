@@ -74,6 +74,13 @@ class RunHandlerThreadWorkQueue
 
     // If true, threads will be waken up by new tasks.
     bool enable_wake_up = true;
+
+    // If true, lower priority requests are preempted between their kernels.
+    bool preempt_lower_priority_work = false;
+
+    // If positive, the queueing delay of one in every so many tasks is
+    // recorded. 0 disables the metric.
+    int queueing_delay_sampling_period = 0;
   };
 
   explicit RunHandlerThreadWorkQueue(const Options& options);
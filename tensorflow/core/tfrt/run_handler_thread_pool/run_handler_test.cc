@@ -117,6 +117,62 @@ TEST(RunHandlerUtilTest, PrioritySchedulingTest) {
   EXPECT_EQ(sorted_active_list[3], 1);
 }
 
+TEST(RunHandlerUtilTest, DeadlineSchedulingTest) {
+  RunHandlerPool::Options pool_options;
+  pool_options.num_threads_in_sub_thread_pool = {2};
+  std::unique_ptr<RunHandlerPool> pool(new RunHandlerPool(pool_options));
+
+  RunHandlerOptions options = RunHandlerOptions();
+  options.priority = 1;
+  auto handler1 = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  options.latency_budget_in_ms = 1000 * 1000;
+  auto handler2 = pool->Get(/*step_id=*/2, /*timeout_in_ms=*/0, options);
+  options.latency_budget_in_ms = 10 * 1000;
+  auto handler3 = pool->Get(/*step_id=*/3, /*timeout_in_ms=*/0, options);
+  options.priority = 2;
+  options.latency_budget_in_ms = 0;
+  auto handler4 = pool->Get(/*step_id=*/4, /*timeout_in_ms=*/0, options);
+
+  // Requests of the same priority are ordered by deadline, and those without
+  // a budget come last.
+  EXPECT_EQ(pool->GetActiveHandlerStepIdsForTesting(),
+            (std::vector<int64_t>{4, 3, 2, 1}));
+}
+
+TEST(RunHandlerUtilTest, PriorityInheritanceTest) {
+  RunHandlerPool::Options pool_options;
+  pool_options.num_threads_in_sub_thread_pool = {2};
+  std::unique_ptr<RunHandlerPool> pool(new RunHandlerPool(pool_options));
+
+  RunHandlerOptions options = RunHandlerOptions();
+  options.priority = 1;
+  auto handler1 = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  options.priority = 2;
+  auto handler2 = pool->Get(/*step_id=*/2, /*timeout_in_ms=*/0, options);
+  options.priority = 3;
+  auto handler3 = pool->Get(/*step_id=*/3, /*timeout_in_ms=*/0, options);
+
+  // The request blocking the one of priority 3 is scheduled before the one of
+  // priority 2.
+  handler1->InheritPriority(3);
+  EXPECT_EQ(pool->GetActiveHandlerPrioritiesForTesting(),
+            (std::vector<int64_t>{3, 3, 2}));
+  EXPECT_EQ(pool->GetActiveHandlerStepIdsForTesting(),
+            (std::vector<int64_t>{3, 1, 2}));
+
+  // A lower priority is not inherited.
+  handler2->InheritPriority(1);
+  EXPECT_EQ(pool->GetActiveHandlerStepIdsForTesting(),
+            (std::vector<int64_t>{3, 1, 2}));
+
+  // The inherited priority is dropped with the handler.
+  handler1.reset();
+  options.priority = 1;
+  handler1 = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  EXPECT_EQ(pool->GetActiveHandlerPrioritiesForTesting(),
+            (std::vector<int64_t>{3, 2, 1}));
+}
+
 TEST(RunHandlerUtilTest, IntraOpThreadPool) {
   int num_threads = 2;
   RunHandlerPool::Options pool_options;
@@ -477,6 +533,109 @@ TEST_P(RunHandlerThreadPoolTest, FindTask) {
   }
 }
 
+TEST_P(RunHandlerThreadPoolTest, PreemptLowerPriorityWork) {
+  Eigen::MaxSizeVector<tensorflow::mutex> waiters_mu(1);
+  waiters_mu.resize(1);
+  Eigen::MaxSizeVector<internal::Waiter> waiters(1);
+  waiters.resize(1);
+  internal::RunHandlerThreadPool run_handler_thread_pool(
+      internal::RunHandlerThreadPool::Options(
+          /*num_blocking_threads=*/1, /*num_non_blocking_threads=*/0,
+          /*wait_if_no_active_request=*/true,
+          /*non_blocking_threads_sleep_time_micro_sec=*/250,
+          /*blocking_threads_max_sleep_time_micro_sec=*/250,
+          /*use_adaptive_waiting_time=*/true, /*enable_wake_up=*/true,
+          /*max_concurrent_handler=*/128,
+          /*num_threads_in_sub_thread_pool=*/{1},
+          /*sub_thread_request_percentage=*/{1},
+          /*preempt_lower_priority_work=*/true),
+      tensorflow::Env::Default(), tensorflow::ThreadOptions(),
+      "tf_run_handler_pool", &waiters_mu, &waiters);
+  Eigen::MaxSizeVector<internal::ThreadWorkSource*> thread_work_sources(3);
+  thread_work_sources.resize(3);
+  internal::ThreadWorkSource tws[3];
+  int result = -1;
+  for (int i = 0; i < 3; ++i) {
+    tws[i].SetWaiter(1, &waiters[0], &waiters_mu[0]);
+    thread_work_sources[i] = &tws[i];
+    for (int j = 0; j < 2; ++j) {
+      run_handler_thread_pool.AddWorkToQueue(
+          &tws[i], /*is_blocking=*/true,
+          TaskFunction([&result, i] { result = i; }));
+    }
+  }
+
+  // The tasks are found in the order of the requests, rather than in a round
+  // robin fashion.
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      bool task_from_blocking_queue;
+      internal::ThreadWorkSource* found_tws;
+      internal::Task t = run_handler_thread_pool.FindTask(
+          /*searching_range_start=*/0, /*searching_range_end=*/3,
+          /*thread_id=*/0,
+          /*sub_thread_pool_id=*/0, /*max_blocking_inflight=*/10,
+          /*may_steal_blocking_work=*/true, thread_work_sources,
+          &task_from_blocking_queue, &found_tws);
+      ASSERT_TRUE(t.f);
+      EXPECT_TRUE(task_from_blocking_queue);
+      EXPECT_EQ(found_tws, &tws[i]);
+      t.f->f();
+      EXPECT_EQ(result, i);
+    }
+  }
+}
+
+TEST_P(RunHandlerThreadPoolTest, SampleQueueingDelay) {
+  Eigen::MaxSizeVector<tensorflow::mutex> waiters_mu(1);
+  waiters_mu.resize(1);
+  Eigen::MaxSizeVector<internal::Waiter> waiters(1);
+  waiters.resize(1);
+  for (int sampling_period : {0, 1, 3}) {
+    internal::RunHandlerThreadPool run_handler_thread_pool(
+        internal::RunHandlerThreadPool::Options(
+            /*num_blocking_threads=*/1, /*num_non_blocking_threads=*/0,
+            /*wait_if_no_active_request=*/true,
+            /*non_blocking_threads_sleep_time_micro_sec=*/250,
+            /*blocking_threads_max_sleep_time_micro_sec=*/250,
+            /*use_adaptive_waiting_time=*/true, /*enable_wake_up=*/true,
+            /*max_concurrent_handler=*/128,
+            /*num_threads_in_sub_thread_pool=*/{1},
+            /*sub_thread_request_percentage=*/{1},
+            /*preempt_lower_priority_work=*/false,
+            /*queueing_delay_sampling_period=*/sampling_period),
+        tensorflow::Env::Default(), tensorflow::ThreadOptions(),
+        "tf_run_handler_pool", &waiters_mu, &waiters);
+    internal::ThreadWorkSource tws;
+    tws.SetWaiter(1, &waiters[0], &waiters_mu[0]);
+    Eigen::MaxSizeVector<internal::ThreadWorkSource*> thread_work_sources(1);
+    thread_work_sources.push_back(&tws);
+    // The tasks are counted per thread, so the count of this thread is not
+    // reset between the pools.
+    constexpr int kNumTasks = 6;
+    for (int i = 0; i < kNumTasks; ++i) {
+      run_handler_thread_pool.AddWorkToQueue(&tws, /*is_blocking=*/true,
+                                             TaskFunction([] {}));
+    }
+
+    int num_sampled = 0;
+    for (int i = 0; i < kNumTasks; ++i) {
+      bool task_from_blocking_queue;
+      internal::ThreadWorkSource* found_tws;
+      internal::Task t = run_handler_thread_pool.FindTask(
+          /*searching_range_start=*/0, /*searching_range_end=*/1,
+          /*thread_id=*/0,
+          /*sub_thread_pool_id=*/0, /*max_blocking_inflight=*/10,
+          /*may_steal_blocking_work=*/true, thread_work_sources,
+          &task_from_blocking_queue, &found_tws);
+      ASSERT_TRUE(t.f);
+      if (t.f->enqueue_time_us != 0) ++num_sampled;
+    }
+    EXPECT_EQ(num_sampled,
+              sampling_period == 0 ? 0 : kNumTasks / sampling_period);
+  }
+}
+
 TEST_P(RunHandlerThreadPoolTest, RoundRobinExecution) {
   Eigen::MaxSizeVector<tensorflow::mutex> waiters_mu(1);
   waiters_mu.resize(1);
@@ -0,0 +1,162 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/transforms/cse/cse_pass.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringSet.h"
+#include "mlir/IR/BuiltinAttributes.h"  // from @llvm-project
+#include "mlir/IR/OpDefinition.h"  // from @llvm-project
+#include "mlir/IR/OperationSupport.h"  // from @llvm-project
+#include "mlir/Pass/Pass.h"  // from @llvm-project
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_def.pb.h"
+#include "tensorflow/core/ir/dialect.h"
+#include "tensorflow/core/ir/ops.h"
+#include "tensorflow/core/ir/tf_op_wrapper.h"
+
+namespace mlir {
+namespace tfg {
+
+namespace {
+
+#define GEN_PASS_CLASSES
+#include "tensorflow/core/transforms/passes.h.inc"
+
+// Returns true if the TensorFlow node `op` can be replaced by an identical
+// node, following the rules of the Grappler CommonSubgraphElimination. The
+// TensorFlow nodes are the unregistered operations of the dialect.
+bool CanDeduplicate(Operation *op) {
+  if (op->isRegistered() || op->getNumRegions()) return false;
+  StringRef op_name = op->getName().stripDialect();
+  // Placeholders are the feeds of the graph, and Enter and Exit nodes define
+  // the frames of the loops.
+  if (op_name.startswith("Placeholder") || op_name.endswith("Enter") ||
+      op_name.endswith("Exit"))
+    return false;
+  const tensorflow::OpRegistrationData *op_reg_data = nullptr;
+  // Function calls and unknown ops may have side effects.
+  if (!tensorflow::OpRegistry::Global()
+           ->LookUp(op_name.str(), &op_reg_data)
+           .ok())
+    return false;
+  const tensorflow::OpDef &op_def = op_reg_data->op_def;
+  if (op_def.is_stateful()) return false;
+  auto is_ref = [](const tensorflow::OpDef::ArgDef &arg) {
+    return arg.is_ref();
+  };
+  return llvm::none_of(op_def.input_arg(), is_ref) &&
+         llvm::none_of(op_def.output_arg(), is_ref);
+}
+
+// A node and its attributes, without its name, which identify the nodes that
+// compute the same values. The hash is computed once, as replacing the uses of
+// a removed node may update the operands of a node already in the map.
+struct NodeKey {
+  Operation *op;
+  DictionaryAttr attrs;
+  unsigned hash;
+};
+
+unsigned HashNode(Operation *op, DictionaryAttr attrs) {
+  return llvm::hash_combine(
+      op->getName().getAsOpaquePointer(), attrs.getAsOpaquePointer(),
+      llvm::hash_combine_range(op->operand_begin(), op->operand_end()),
+      llvm::hash_combine_range(op->result_type_begin(),
+                               op->result_type_end()));
+}
+
+struct NodeKeyInfo {
+  static NodeKey getEmptyKey() {
+    return {llvm::DenseMapInfo<Operation *>::getEmptyKey(), nullptr, 0};
+  }
+  static NodeKey getTombstoneKey() {
+    return {llvm::DenseMapInfo<Operation *>::getTombstoneKey(), nullptr, 0};
+  }
+  static bool isSentinel(const NodeKey &key) {
+    return key.op == getEmptyKey().op || key.op == getTombstoneKey().op;
+  }
+  static unsigned getHashValue(const NodeKey &key) { return key.hash; }
+  static bool isEqual(const NodeKey &lhs, const NodeKey &rhs) {
+    if (isSentinel(lhs) || isSentinel(rhs)) return lhs.op == rhs.op;
+    return lhs.op->getName() == rhs.op->getName() && lhs.attrs == rhs.attrs &&
+           llvm::equal(lhs.op->getOperands(), rhs.op->getOperands()) &&
+           llvm::equal(lhs.op->getResultTypes(), rhs.op->getResultTypes());
+  }
+};
+
+// Replaces the nodes of `block` by the identical nodes that come before them,
+// unless they are named in `preserve`. Returns the number of removed nodes.
+int EliminateCommonSubexpressions(Block &block,
+                                  const llvm::StringSet<> &preserve,
+                                  TFGraphDialect *dialect) {
+  llvm::DenseMap<NodeKey, Operation *, NodeKeyInfo> known_nodes;
+  int num_removed = 0;
+  for (Operation &op : llvm::make_early_inc_range(block)) {
+    if (!CanDeduplicate(&op)) continue;
+    NamedAttrList attrs(op.getAttrDictionary());
+    attrs.erase(dialect->getNameAttrIdentifier());
+    DictionaryAttr key_attrs = attrs.getDictionary(op.getContext());
+    NodeKey key{&op, key_attrs, HashNode(&op, key_attrs)};
+    auto inserted = known_nodes.try_emplace(key, &op);
+    if (inserted.second) continue;
+    Operation *existing = inserted.first->second;
+    Operation *removed = &op;
+    if (preserve.contains(TFOp(op).name())) {
+      // Keep this node instead, unless both are preserved.
+      if (preserve.contains(TFOp(existing).name())) continue;
+      std::swap(existing, removed);
+      // The key in the map refers to the node about to be erased.
+      known_nodes.erase(inserted.first);
+      known_nodes.try_emplace(key, existing);
+    }
+    removed->replaceAllUsesWith(existing);
+    removed->erase();
+    ++num_removed;
+  }
+  return num_removed;
+}
+
+// A pass that eliminates the common subexpressions of graph and function
+// regions.
+struct CSEPass : CSEBase<CSEPass> {
+  explicit CSEPass(ArrayRef<std::string> preserve) { preserve_ = preserve; }
+
+  void runOnOperation() override {
+    Operation *op = getOperation();
+    if (!isa<GraphOp, GraphFuncOp>(op)) return;
+    auto *dialect = op->getContext()->getLoadedDialect<TFGraphDialect>();
+    llvm::StringSet<> preserve;
+    for (const std::string &name : preserve_) preserve.insert(name);
+    int num_removed = 0;
+    for (Region &region : op->getRegions()) {
+      if (region.empty()) continue;
+      num_removed +=
+          EliminateCommonSubexpressions(region.front(), preserve, dialect);
+    }
+    if (!num_removed) markAllAnalysesPreserved();
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> CreateCSEPass(ArrayRef<std::string> preserve) {
+  return std::make_unique<CSEPass>(preserve);
+}
+
+}  // namespace tfg
+}  // namespace mlir
@@ -0,0 +1,62 @@
+// RUN: tfg-transforms-opt %s --pass-pipeline="tfg.graph(tfg-cse{preserve=kept}), tfg.func(tfg-cse{preserve=kept})" | FileCheck %s
+
+// Identical stateless nodes are deduplicated, as well as their users.
+
+// CHECK-LABEL: tfg.graph
+tfg.graph #tf_type.version<producer = 42, min_consumer = 33> {
+  // CHECK: %[[A:[^,]*]], {{.*}} = Const {{.*}} name("a")
+  // CHECK-NOT: name("b")
+  %a, %ctl = Const name("a") {dtype = i32, value = dense<1> : tensor<i32>} : () -> (tensor<i32>)
+  %b, %ctl_0 = Const name("b") {dtype = i32, value = dense<1> : tensor<i32>} : () -> (tensor<i32>)
+  // CHECK: %[[ADD:[^,]*]], {{.*}} = AddV2(%[[A]], %[[A]]) name("add1")
+  // CHECK-NOT: name("add2")
+  %add1, %ctl_1 = AddV2(%a, %a) name("add1") {T = i32} : (tensor<i32>, tensor<i32>) -> (tensor<i32>)
+  %add2, %ctl_2 = AddV2(%b, %b) name("add2") {T = i32} : (tensor<i32>, tensor<i32>) -> (tensor<i32>)
+  // CHECK: Identity(%[[ADD]]) name("id")
+  %id, %ctl_3 = Identity(%add2) name("id") {T = i32} : (tensor<i32>) -> (tensor<i32>)
+}
+
+// Nodes with different attributes or devices, stateful nodes and placeholders
+// are kept.
+
+// CHECK-LABEL: tfg.graph
+tfg.graph #tf_type.version<producer = 42, min_consumer = 33> {
+  // CHECK: name("c1")
+  // CHECK: name("c2")
+  // CHECK: name("c3")
+  %c1, %ctl = Const name("c1") {dtype = i32, value = dense<1> : tensor<i32>} : () -> (tensor<i32>)
+  %c2, %ctl_0 = Const name("c2") {dtype = i32, value = dense<2> : tensor<i32>} : () -> (tensor<i32>)
+  %c3, %ctl_1 = Const device("/CPU:1") name("c3") {dtype = i32, value = dense<1> : tensor<i32>} : () -> (tensor<i32>)
+  // CHECK: name("r1")
+  // CHECK: name("r2")
+  %r1, %ctl_2 = RandomUniform(%c1) name("r1") {T = i32, dtype = f32, seed = 0 : i64, seed2 = 0 : i64} : (tensor<i32>) -> (tensor<*xf32>)
+  %r2, %ctl_3 = RandomUniform(%c1) name("r2") {T = i32, dtype = f32, seed = 0 : i64, seed2 = 0 : i64} : (tensor<i32>) -> (tensor<*xf32>)
+  // CHECK: name("p1")
+  // CHECK: name("p2")
+  %p1, %ctl_4 = Placeholder name("p1") {dtype = f32} : () -> (tensor<*xf32>)
+  %p2, %ctl_5 = Placeholder name("p2") {dtype = f32} : () -> (tensor<*xf32>)
+}
+
+// A preserved node is kept, and replaces the identical unpreserved ones.
+
+// CHECK-LABEL: tfg.graph
+tfg.graph #tf_type.version<producer = 42, min_consumer = 33> {
+  // CHECK-NOT: name("first")
+  // CHECK: Identity(%[[KEPT:[^)]*]]) name("id")
+  // CHECK: %[[KEPT]], {{.*}} = Const {{.*}} name("kept")
+  %first, %ctl = Const name("first") {dtype = i32, value = dense<1> : tensor<i32>} : () -> (tensor<i32>)
+  %id, %ctl_0 = Identity(%first) name("id") {T = i32} : (tensor<i32>) -> (tensor<i32>)
+  %kept, %ctl_1 = Const name("kept") {dtype = i32, value = dense<1> : tensor<i32>} : () -> (tensor<i32>)
+}
+
+// Function bodies are deduplicated as well.
+
+// CHECK-LABEL: tfg.func @foo
+tfg.func @foo(%arg0: tensor<i32> {tfg.name = "arg0"}) -> (tensor<i32> {tfg.name = "ret"}) {
+  // CHECK: %[[NEG:[^,]*]], {{.*}} = Neg(%arg0) name("neg1")
+  // CHECK-NOT: name("neg2")
+  %neg1, %ctl = Neg(%arg0) name("neg1") {T = i32} : (tensor<i32>) -> (tensor<i32>)
+  %neg2, %ctl_0 = Neg(%arg0) name("neg2") {T = i32} : (tensor<i32>) -> (tensor<i32>)
+  // CHECK: return(%[[NEG]])
+  return(%neg2) : tensor<i32>
+}
@@ -0,0 +1,115 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/transforms/dependency_optimizer/dependency_optimizer_pass.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Pass/Pass.h"  // from @llvm-project
+#include "tensorflow/core/ir/ops.h"
+#include "tensorflow/core/ir/tf_op_wrapper.h"
+
+namespace mlir {
+namespace tfg {
+
+namespace {
+
+#define GEN_PASS_CLASSES
+#include "tensorflow/core/transforms/passes.h.inc"
+
+// Returns true if a control operand from the node `producer` is implied by a
+// data operand from it. A control dependency on a Switch is only satisfied
+// once both of its outputs are known, unlike a data dependency on one of them.
+bool ControlImpliedByData(Operation *producer) {
+  StringRef op_name = producer->getName().stripDialect();
+  return !op_name.endswith("Switch") && !op_name.endswith("SwitchN");
+}
+
+// Removes the redundant control operands of `op`. Returns true if any was
+// removed.
+bool RemoveRedundantControlOperands(Operation &op) {
+  TFOp tf_op(op);
+  ValueRange control_operands = tf_op.getControlOperands();
+  if (control_operands.empty()) return false;
+  const unsigned num_data_operands =
+      op.getNumOperands() - control_operands.size();
+
+  // The producers of the data operands.
+  SmallPtrSet<Operation *, 8> data_producers;
+  SmallPtrSet<Value, 8> data_block_args;
+  for (Value operand : op.getOperands().take_front(num_data_operands)) {
+    if (Operation *producer = operand.getDefiningOp())
+      data_producers.insert(producer);
+    else
+      data_block_args.insert(operand);
+  }
+
+  SmallVector<Value> new_control_operands;
+  SmallPtrSet<Value, 8> seen_control_operands;
+  for (Value control : control_operands) {
+    if (!seen_control_operands.insert(control).second) continue;
+    Operation *producer = control.getDefiningOp();
+    if (producer) {
+      if (data_producers.contains(producer) && ControlImpliedByData(producer))
+        continue;
+    } else if (auto arg = control.dyn_cast<BlockArgument>()) {
+      // In functions, the control token of an argument follows its value.
+      if (arg.getArgNumber() > 0 &&
+          data_block_args.contains(
+              arg.getOwner()->getArgument(arg.getArgNumber() - 1)))
+        continue;
+    }
+    new_control_operands.push_back(control);
+  }
+  if (new_control_operands.size() == control_operands.size()) return false;
+
+  SmallVector<Value> new_operands(
+      op.getOperands().take_front(num_data_operands));
+  new_operands.append(new_control_operands.begin(),
+                      new_control_operands.end());
+  op.setOperands(new_operands);
+  return true;
+}
+
+// A pass that removes the redundant control dependencies of graph and function
+// regions.
+struct DependencyOptimizerPass
+    : DependencyOptimizerBase<DependencyOptimizerPass> {
+  void runOnOperation() override {
+    Operation *op = getOperation();
+    if (!isa<GraphOp, GraphFuncOp>(op)) return;
+    bool changed = false;
+    for (Region &region : op->getRegions()) {
+      if (region.empty()) continue;
+      // The TensorFlow nodes are the unregistered operations; the terminator
+      // of a function names its control results, which must stay as they are.
+      for (Operation &node : region.front()) {
+        if (node.isRegistered()) continue;
+        changed |= RemoveRedundantControlOperands(node);
+      }
+    }
+    if (!changed) markAllAnalysesPreserved();
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> CreateDependencyOptimizerPass() {
+  return std::make_unique<DependencyOptimizerPass>();
+}
+
+}  // namespace tfg
+}  // namespace mlir
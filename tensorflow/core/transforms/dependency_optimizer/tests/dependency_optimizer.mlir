@@ -0,0 +1,30 @@
+// RUN: tfg-transforms-opt %s --pass-pipeline="tfg.graph(tfg-dependency-optimizer), tfg.func(tfg-dependency-optimizer)" | FileCheck %s
+
+// CHECK-LABEL: tfg.graph
+tfg.graph #tf_type.version<producer = 42, min_consumer = 33> {
+  %a, %ctl = Const name("a") {dtype = i32, value = dense<1> : tensor<i32>} : () -> (tensor<i32>)
+  %b, %ctl_0 = Const name("b") {dtype = i32, value = dense<2> : tensor<i32>} : () -> (tensor<i32>)
+  // Duplicated control operands and the ones implied by data operands are
+  // removed.
+  // CHECK: AddV2(%{{[^)]*}}) [%{{[^],]*}}] name("add")
+  %add, %ctl_1 = AddV2(%a, %a) [%ctl, %ctl_0, %ctl_0] name("add") {T = i32} : (tensor<i32>, tensor<i32>) -> (tensor<i32>)
+  // CHECK: Identity(%{{[^)]*}}) name("id")
+  %id, %ctl_2 = Identity(%add) [%ctl_1] name("id") {T = i32} : (tensor<i32>) -> (tensor<i32>)
+  // Control operands from a Switch are kept.
+  // CHECK: Switch
+  %s:2, %ctl_3 = Switch(%a, %p) name("switch") {T = i32} : (tensor<i32>, tensor<i1>) -> (tensor<i32>, tensor<i32>)
+  // CHECK: Identity(%{{[^)]*}}) [%{{[^]]*}}] name("id_true")
+  %t, %ctl_4 = Identity(%s#1) [%ctl_3] name("id_true") {T = i32} : (tensor<i32>) -> (tensor<i32>)
+  %p, %ctl_5 = Placeholder name("p") {dtype = i1} : () -> (tensor<i1>)
+}
+
+// The control token of a function argument is implied by its value, and the
+// control results of the function are kept.
+
+// CHECK-LABEL: tfg.func @foo
+tfg.func @foo(%arg0: tensor<i32> {tfg.name = "arg0"}) -> (tensor<i32> {tfg.name = "ret"}) {
+  // CHECK: Neg(%arg0) name("neg")
+  %neg, %ctl = Neg(%arg0) [%arg0.ctl] name("neg") {T = i32} : (tensor<i32>) -> (tensor<i32>)
+  // CHECK: return(%{{[^)]*}}) [%{{[^]]*}}]
+  return(%neg) [%ctl] : tensor<i32>
+}
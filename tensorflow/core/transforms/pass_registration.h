@@ -18,6 +18,8 @@ limitations under the License.
 
 #include <memory>
 
+#include "tensorflow/core/transforms/cse/cse_pass.h"
+#include "tensorflow/core/transforms/dependency_optimizer/dependency_optimizer_pass.h"
 #include "tensorflow/core/transforms/graph_to_func/graph_to_func_pass.h"
 #include "tensorflow/core/transforms/toposort/toposort_pass.h"
 
@@ -15,9 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/util/einsum_op_util.h"
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
 #include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
@@ -36,10 +42,145 @@ Status ParseEinsumEquation(const string& equation,
   *output_subscript = std::move(inputs_and_output_subscripts[1]);
   *input_subscripts =
       absl::StrSplit(std::move(inputs_and_output_subscripts[0]), ',');
-  if (input_subscripts->size() != 1 && input_subscripts->size() != 2) {
-    return errors::InvalidArgument(
-        "Expecting 1 or 2 input subscripts in equation '", equation,
-        "' but got: ", input_subscripts->size());
+  return Status::OK();
+}
+
+namespace {
+
+// The labels of a subscript, with '.' standing for the whole ellipsis.
+string SubscriptLabels(absl::string_view subscript) {
+  string labels;
+  for (int i = 0; i < subscript.size(); ++i) {
+    labels.push_back(subscript[i]);
+    if (subscript[i] == '.') i += 2;
+  }
+  return labels;
+}
+
+// Returns the number of elements of an operand with the given labels.
+double NumElements(absl::string_view labels,
+                   const absl::flat_hash_map<char, double>& label_sizes) {
+  double num_elements = 1;
+  for (const char label : labels) num_elements *= label_sizes.at(label);
+  return num_elements;
+}
+
+}  // namespace
+
+Status PlanEinsumContractions(
+    absl::Span<const string> input_subscripts, const string& output_subscript,
+    absl::Span<const gtl::InlinedVector<int64_t, 4>> input_shapes,
+    std::vector<EinsumContraction>* path) {
+  if (input_subscripts.size() != input_shapes.size()) {
+    return errors::InvalidArgument("Expected ", input_subscripts.size(),
+                                   " inputs but got: ", input_shapes.size());
+  }
+  // The size of each label, and that of the broadcast ellipsis.
+  absl::flat_hash_map<char, double> label_sizes;
+  std::vector<string> operands;
+  for (int i = 0; i < input_subscripts.size(); ++i) {
+    const string labels = SubscriptLabels(input_subscripts[i]);
+    const auto& shape = input_shapes[i];
+    const bool has_ellipsis = labels.find('.') != string::npos;
+    const int num_bcast_dims =
+        static_cast<int>(shape.size()) - static_cast<int>(labels.size()) + 1;
+    if (has_ellipsis ? num_bcast_dims < 0 : shape.size() != labels.size()) {
+      return errors::InvalidArgument("Input ", i, " of rank ", shape.size(),
+                                     " doesn't match subscript '",
+                                     input_subscripts[i], "'");
+    }
+    double bcast_size = 1;
+    for (int label_idx = 0, axis = 0; label_idx < labels.size(); ++label_idx) {
+      if (labels[label_idx] == '.') {
+        for (int j = 0; j < num_bcast_dims; ++j) bcast_size *= shape[axis++];
+        double& size = label_sizes['.'];
+        size = std::max(size, bcast_size);
+        continue;
+      }
+      label_sizes[labels[label_idx]] = shape[axis++];
+    }
+    operands.push_back(labels);
+  }
+  const string output_labels = SubscriptLabels(output_subscript);
+  label_sizes.try_emplace('.', 1);
+  for (const char label : output_labels) {
+    if (!label_sizes.contains(label)) {
+      return errors::InvalidArgument("Output label '", string(1, label),
+                                     "' doesn't appear in the inputs");
+    }
+  }
+
+  // Returns the labels of the result of contracting operands i and j, i.e.
+  // the labels of either that appear in the other operands or the output.
+  auto result_labels = [&](int i, int j) {
+    string labels;
+    for (const char label : absl::StrCat(operands[i], operands[j])) {
+      if (labels.find(label) != string::npos) continue;
+      bool kept = output_labels.find(label) != string::npos;
+      for (int k = 0; !kept && k < operands.size(); ++k) {
+        kept = k != i && k != j && operands[k].find(label) != string::npos;
+      }
+      if (kept) labels.push_back(label);
+    }
+    return labels;
+  };
+  auto to_subscript = [](absl::string_view labels) {
+    return absl::StrReplaceAll(labels, {{".", "..."}});
+  };
+
+  path->clear();
+  while (operands.size() > 1) {
+    int best_i = -1, best_j = -1;
+    string best_labels;
+    bool best_outer = false;
+    double best_cost = 0, best_flops = 0;
+    for (int i = 0; i < operands.size(); ++i) {
+      for (int j = i + 1; j < operands.size(); ++j) {
+        string labels = operands.size() == 2 ? output_labels
+                                             : result_labels(i, j);
+        bool outer = true;
+        for (const char label : operands[i]) {
+          if (label != '.' && operands[j].find(label) != string::npos) {
+            outer = false;
+          }
+        }
+        const double cost = NumElements(labels, label_sizes) -
+                            NumElements(operands[i], label_sizes) -
+                            NumElements(operands[j], label_sizes);
+        string all_labels = operands[i];
+        for (const char label : operands[j]) {
+          if (all_labels.find(label) == string::npos) all_labels += label;
+        }
+        const double flops = NumElements(all_labels, label_sizes);
+        bool is_best;
+        if (best_i == -1) {
+          is_best = true;
+        } else if (outer != best_outer) {
+          is_best = !outer;
+        } else if (cost != best_cost) {
+          is_best = cost < best_cost;
+        } else {
+          is_best = flops < best_flops;
+        }
+        if (is_best) {
+          best_i = i;
+          best_j = j;
+          best_labels = std::move(labels);
+          best_outer = outer;
+          best_cost = cost;
+          best_flops = flops;
+        }
+      }
+    }
+    path->push_back({best_i, best_j,
+                     absl::StrCat(to_subscript(operands[best_i]), ",",
+                                  to_subscript(operands[best_j]), "->",
+                                  operands.size() == 2
+                                      ? output_subscript
+                                      : to_subscript(best_labels))});
+    operands.erase(operands.begin() + best_j);
+    operands.erase(operands.begin() + best_i);
+    operands.push_back(std::move(best_labels));
   }
   return Status::OK();
 }
@@ -15,6 +15,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_EINSUM_OP_UTIL_H_
 #define TENSORFLOW_CORE_UTIL_EINSUM_OP_UTIL_H_
 
+#include <vector>
+
+#include "absl/types/span.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 
@@ -24,6 +27,27 @@ namespace tensorflow {
 Status ParseEinsumEquation(const string& equation,
                            gtl::InlinedVector<string, 2>* input_subscripts,
                            string* output_subscript);
+
+// One step of the contraction path of an einsum with more than two operands.
+// The operands at positions `lhs` < `rhs` of the list of remaining operands
+// are removed from it, and the result of the binary einsum `equation` on them
+// is appended to it.
+struct EinsumContraction {
+  int lhs;
+  int rhs;
+  string equation;
+};
+
+// Plans the pairwise contractions of the operands of an einsum equation, with
+// the given input shapes, such that the last one computes the output. Greedily
+// contracts the pair of operands whose result is the smallest relative to the
+// operands, as in opt_einsum, and only contracts operands without common
+// labels (outer products) when no other pair is left.
+Status PlanEinsumContractions(
+    absl::Span<const string> input_subscripts, const string& output_subscript,
+    absl::Span<const gtl::InlinedVector<int64_t, 4>> input_shapes,
+    std::vector<EinsumContraction>* path);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_UTIL_EINSUM_OP_UTIL_H_
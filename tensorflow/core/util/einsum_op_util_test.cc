@@ -0,0 +1,76 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/einsum_op_util.h"
+
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns the planned path as "lhs,rhs:equation" steps separated by ";".
+string PlanToStr(std::vector<string> subscripts, const string& output,
+                 std::vector<gtl::InlinedVector<int64_t, 4>> shapes) {
+  std::vector<EinsumContraction> path;
+  Status status = PlanEinsumContractions(subscripts, output, shapes, &path);
+  if (!status.ok()) return status.error_message();
+  return absl::StrJoin(path, ";", [](string* out, const EinsumContraction& c) {
+    absl::StrAppend(out, c.lhs, ",", c.rhs, ":", c.equation);
+  });
+}
+
+TEST(PlanEinsumContractionsTest, ContractsSmallestIntermediateFirst) {
+  // Left to right, the first intermediate would have 1000 x 1000 elements.
+  EXPECT_EQ(PlanToStr({"ab", "bc", "cd"}, "ad",
+                      {{1000, 2}, {2, 1000}, {1000, 3}}),
+            "1,2:bc,cd->bd;0,1:ab,bd->ad");
+  EXPECT_EQ(PlanToStr({"ab", "bc", "cd"}, "ad",
+                      {{2, 1000}, {1000, 3}, {3, 1000}}),
+            "0,1:ab,bc->ac;0,1:cd,ac->ad");
+}
+
+TEST(PlanEinsumContractionsTest, KeepsLabelsOfOtherOperandsAndOutput) {
+  EXPECT_EQ(PlanToStr({"ij", "jk", "kl", "li"}, "",
+                      {{10, 20}, {20, 30}, {30, 40}, {40, 10}}),
+            "2,3:kl,li->ki;1,2:jk,ki->ji;0,1:ij,ji->");
+  EXPECT_EQ(PlanToStr({"ij", "j", "jk"}, "ijk", {{5, 6}, {6}, {6, 7}}),
+            "0,1:ij,j->ij;0,1:jk,ij->ijk");
+}
+
+TEST(PlanEinsumContractionsTest, AvoidsOuterProducts) {
+  EXPECT_EQ(PlanToStr({"a", "b", "ab"}, "", {{3}, {4}, {3, 4}}),
+            "1,2:b,ab->a;0,1:a,a->");
+}
+
+TEST(PlanEinsumContractionsTest, Ellipsis) {
+  EXPECT_EQ(PlanToStr({"...ab", "...bc", "c"}, "...a",
+                      {{5, 4, 3}, {5, 3, 7}, {7}}),
+            "1,2:...bc,c->...b;0,1:...ab,...b->...a");
+}
+
+TEST(PlanEinsumContractionsTest, InvalidShapes) {
+  EXPECT_EQ(PlanToStr({"ab", "bc", "cd"}, "ad", {{1000, 2}, {2}, {1000, 3}}),
+            "Input 1 of rank 1 doesn't match subscript 'bc'");
+  EXPECT_EQ(PlanToStr({"ab", "bc", "cd"}, "ae", {{2, 2}, {2, 2}, {2, 2}}),
+            "Output label 'e' doesn't appear in the inputs");
+}
+
+}  // namespace
+}  // namespace tensorflow
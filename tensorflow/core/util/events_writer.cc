@@ -17,9 +17,12 @@ limitations under the License.
 
 #include <stddef.h>  // for NULL
 
+#include <algorithm>
+
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
@@ -30,19 +33,51 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+auto* queue_full_waits = monitoring::Counter<0>::New(
+    "/tensorflow/core/util/events_writer/queue_full_waits",
+    "The number of events whose write waited for space in the queue of an "
+    "asynchronous EventsWriter.");
+
+auto* queue_full_wait_usecs = monitoring::Counter<0>::New(
+    "/tensorflow/core/util/events_writer/queue_full_wait_usecs",
+    "The time spent waiting for space in the queue of asynchronous "
+    "EventsWriters, in microseconds.");
+
+}  // namespace
+
 EventsWriter::EventsWriter(const string& file_prefix)
+    : EventsWriter(file_prefix, Options()) {}
+
+EventsWriter::EventsWriter(const string& file_prefix, const Options& options)
     // TODO(jeff,sanjay): Pass in env and use that here instead of Env::Default
     : env_(Env::Default()),
       file_prefix_(file_prefix),
-      num_outstanding_events_(0) {}
+      options_(options),
+      num_outstanding_events_(0) {
+  if (IsAsync()) {
+    writer_thread_.reset(env_->StartThread(ThreadOptions(), "events_writer",
+                                           [this]() { WriteQueuedEvents(); }));
+  }
+}
 
 EventsWriter::~EventsWriter() {
   Close().IgnoreError();  // Autoclose in destructor.
+  if (writer_thread_ != nullptr) {
+    {
+      mutex_lock l(queue_mu_);
+      stop_ = true;
+      queue_cv_.notify_all();
+    }
+    writer_thread_.reset();
+  }
 }
 
 Status EventsWriter::Init() { return InitWithSuffix(""); }
 
 Status EventsWriter::InitWithSuffix(const string& suffix) {
+  mutex_lock l(file_mu_);
   file_suffix_ = suffix;
   return InitIfNeeded();
 }
@@ -76,7 +111,9 @@ Status EventsWriter::InitIfNeeded() {
   TF_RETURN_WITH_CONTEXT_IF_ERROR(
       env_->NewWritableFile(filename_, &recordio_file_),
       "Creating writable file ", filename_);
-  recordio_writer_.reset(new io::RecordWriter(recordio_file_.get()));
+  recordio_writer_.reset(new io::RecordWriter(
+      recordio_file_.get(), io::RecordWriterOptions::CreateRecordWriterOptions(
+                                options_.compression_type)));
   if (recordio_writer_ == nullptr) {
     return errors::Unknown("Could not create record writer");
   }
@@ -89,13 +126,16 @@ Status EventsWriter::InitIfNeeded() {
     Event event;
     event.set_wall_time(time_in_seconds);
     event.set_file_version(strings::StrCat(kVersionPrefix, kCurrentVersion));
-    WriteEvent(event);
-    TF_RETURN_WITH_CONTEXT_IF_ERROR(Flush(), "Flushing first event.");
+    string record;
+    event.AppendToString(&record);
+    WriteSerializedEventToFile(record);
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(FlushFile(), "Flushing first event.");
   }
   return Status::OK();
 }
 
 string EventsWriter::FileName() {
+  mutex_lock l(file_mu_);
   if (filename_.empty()) {
     InitIfNeeded().IgnoreError();
   }
@@ -103,6 +143,27 @@ string EventsWriter::FileName() {
 }
 
 void EventsWriter::WriteSerializedEvent(StringPiece event_str) {
+  if (!IsAsync()) {
+    mutex_lock l(file_mu_);
+    WriteSerializedEventToFile(event_str);
+    return;
+  }
+  mutex_lock l(queue_mu_);
+  if (static_cast<int64_t>(queue_.size()) >= options_.max_queued_events) {
+    queue_full_waits->GetCell()->IncrementBy(1);
+    const uint64 start_micros = env_->NowMicros();
+    while (static_cast<int64_t>(queue_.size()) >= options_.max_queued_events) {
+      space_cv_.wait(l);
+    }
+    queue_full_wait_usecs->GetCell()->IncrementBy(env_->NowMicros() -
+                                                  start_micros);
+  }
+  queue_.emplace_back(event_str.data(), event_str.size());
+  ++num_queued_;
+  queue_cv_.notify_all();
+}
+
+void EventsWriter::WriteSerializedEventToFile(StringPiece event_str) {
   if (recordio_writer_ == nullptr) {
     if (!InitIfNeeded().ok()) {
       LOG(ERROR) << "Write failed because file could not be opened.";
@@ -121,7 +182,70 @@ void EventsWriter::WriteEvent(const Event& event) {
   WriteSerializedEvent(record);
 }
 
+void EventsWriter::WriteQueuedEvents() {
+  std::deque<string> batch;
+  while (true) {
+    int64_t num_written;
+    bool flush;
+    {
+      mutex_lock l(queue_mu_);
+      while (queue_.empty() && flush_requested_ <= num_flushed_ && !stop_) {
+        queue_cv_.wait(l);
+      }
+      if (queue_.empty() && flush_requested_ <= num_flushed_) return;
+      batch.swap(queue_);
+      space_cv_.notify_all();
+      num_written = num_written_ + batch.size();
+      // The queue is written in order, so the batch holds all the events to
+      // flush which are not written yet.
+      flush = flush_requested_ > num_flushed_;
+    }
+    Status s;
+    {
+      mutex_lock l(file_mu_);
+      for (const string& event_str : batch) {
+        WriteSerializedEventToFile(event_str);
+      }
+      if (flush) s = FlushFile();
+    }
+    batch.clear();
+    mutex_lock l(queue_mu_);
+    num_written_ = num_written;
+    if (flush) {
+      num_flushed_ = num_written;
+      last_flush_status_ = s;
+      flushed_cv_.notify_all();
+    }
+  }
+}
+
 Status EventsWriter::Flush() {
+  if (!IsAsync()) {
+    mutex_lock l(file_mu_);
+    return FlushFile();
+  }
+  mutex_lock l(queue_mu_);
+  const int64_t target = num_queued_;
+  if (num_flushed_ >= target) return Status::OK();
+  flush_requested_ = std::max(flush_requested_, target);
+  queue_cv_.notify_all();
+  while (num_flushed_ < target) {
+    flushed_cv_.wait(l);
+  }
+  return last_flush_status_;
+}
+
+Status EventsWriter::RequestFlush() {
+  if (!IsAsync()) return Flush();
+  mutex_lock l(queue_mu_);
+  if (num_queued_ > flush_requested_) {
+    flush_requested_ = num_queued_;
+    queue_cv_.notify_all();
+  }
+  return last_flush_status_;
+}
+
+Status EventsWriter::FlushFile() {
   if (num_outstanding_events_ == 0) return Status::OK();
   CHECK(recordio_file_ != nullptr) << "Unexpected NULL file";
 
@@ -138,7 +262,21 @@ Status EventsWriter::Flush() {
 
 Status EventsWriter::Close() {
   Status status = Flush();
+  mutex_lock l(file_mu_);
+  Status close_status = CloseFile();
+  if (!close_status.ok()) {
+    status = close_status;
+  }
+  return status;
+}
+
+Status EventsWriter::CloseFile() {
+  Status status;
   if (recordio_file_ != nullptr) {
+    if (recordio_writer_ != nullptr) {
+      // Writes the trailer of compressed files.
+      status = recordio_writer_->Close();
+    }
     Status close_status = recordio_file_->Close();
     if (!close_status.ok()) {
       status = close_status;
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_EVENTS_WRITER_H_
 #define TENSORFLOW_CORE_UTIL_EVENTS_WRITER_H_
 
+#include <deque>
 #include <memory>
 #include <string>
 
@@ -23,6 +24,8 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/event.pb.h"
 
@@ -36,6 +39,17 @@ class EventsWriter {
   static constexpr const int kCurrentVersion = 2;
 #endif
 
+  struct Options {
+    // If positive, events are written and flushed by a background thread,
+    // which writes the queued events in batches. Up to max_queued_events
+    // events are queued; WriteEvent() blocks while the queue is full.
+    int64_t max_queued_events = 0;
+
+    // The compression of the events file: "" (none), "ZLIB" or "GZIP".
+    // Note that TensorBoard only reads uncompressed events files.
+    std::string compression_type;
+  };
+
   // Events files typically have a name of the form
   //   '/some/file/path/my.file.out.events.[timestamp].[hostname][suffix]'
   // To create and EventWriter, the user should provide file_prefix =
@@ -45,6 +59,7 @@ class EventsWriter {
   // Note that it is not recommended to simultaneously have two
   // EventWriters writing to the same file_prefix.
   explicit EventsWriter(const std::string& file_prefix);
+  EventsWriter(const std::string& file_prefix, const Options& options);
   ~EventsWriter();
 
   // Sets the event file filename and opens file for writing.  If not called by
@@ -76,20 +91,61 @@ class EventsWriter {
   // be written too.
   //   Close() calls Flush() and then closes the current events file.
   // Returns true only if both the flush and the closure were successful.
+  // With a background writer, Flush() waits for the events written before
+  // the call to be flushed.
   Status Flush();
   Status Close();
 
+  // Like Flush(), but with a background writer only asks it to flush the
+  // events written so far, and returns the status of the previous flush.
+  Status RequestFlush();
+
  private:
+  bool IsAsync() const { return options_.max_queued_events > 0; }
+
+  // These require file_mu_.
   Status FileStillExists();  // OK if event_file_path_ exists.
   Status InitIfNeeded();
+  void WriteSerializedEventToFile(StringPiece event_str);
+  Status FlushFile();
+  Status CloseFile();
+
+  // The body of the background writer thread.
+  void WriteQueuedEvents();
 
   Env* env_;
   const std::string file_prefix_;
+  const Options options_;
+
+  // Serializes the file operations of the callers and of the background
+  // writer.
+  mutex file_mu_;
   std::string file_suffix_;
   std::string filename_;
   std::unique_ptr<WritableFile> recordio_file_;
   std::unique_ptr<io::RecordWriter> recordio_writer_;
   int num_outstanding_events_;
+
+  mutex queue_mu_;
+  // Signaled when events are queued, a flush is requested or the writer is
+  // stopped.
+  condition_variable queue_cv_;
+  // Signaled when the background writer takes the queued events.
+  condition_variable space_cv_;
+  // Signaled when the background writer flushed events.
+  condition_variable flushed_cv_;
+  std::deque<std::string> queue_ TF_GUARDED_BY(queue_mu_);
+  // The events queued, written by the background writer, and flushed, since
+  // the creation of the writer.
+  int64_t num_queued_ TF_GUARDED_BY(queue_mu_) = 0;
+  int64_t num_written_ TF_GUARDED_BY(queue_mu_) = 0;
+  int64_t num_flushed_ TF_GUARDED_BY(queue_mu_) = 0;
+  // The number of queued events to flush.
+  int64_t flush_requested_ TF_GUARDED_BY(queue_mu_) = 0;
+  Status last_flush_status_ TF_GUARDED_BY(queue_mu_);
+  bool stop_ TF_GUARDED_BY(queue_mu_) = false;
+  std::unique_ptr<Thread> writer_thread_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(EventsWriter);
 };
 
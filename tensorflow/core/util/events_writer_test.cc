@@ -203,5 +203,85 @@ TEST(EventWriter, FileDeletionBeforeWriting) {
   VerifyFile(filename1);
 }
 
+EventsWriter::Options AsyncOptions(int64_t max_queued_events) {
+  EventsWriter::Options options;
+  options.max_queued_events = max_queued_events;
+  return options;
+}
+
+// Returns the number of events in `filename`, including the version event.
+int CountEvents(const string& filename, const string& compression_type = "") {
+  std::unique_ptr<RandomAccessFile> event_file;
+  TF_CHECK_OK(env()->NewRandomAccessFile(filename, &event_file));
+  io::RecordReader reader(
+      event_file.get(),
+      io::RecordReaderOptions::CreateRecordReaderOptions(compression_type));
+  uint64 offset = 0;
+  int count = 0;
+  Event event;
+  while (ReadEventProto(&reader, &offset, &event)) {
+    ++count;
+  }
+  return count;
+}
+
+TEST(EventWriter, AsyncWriteFlush) {
+  string file_prefix = GetDirName("/asyncwriteflush_test");
+  EventsWriter writer(file_prefix, AsyncOptions(100));
+  WriteFile(&writer);
+  TF_EXPECT_OK(writer.Flush());
+  string filename = writer.FileName();
+  VerifyFile(filename);
+}
+
+TEST(EventWriter, AsyncWriteClose) {
+  string file_prefix = GetDirName("/asyncwriteclose_test");
+  EventsWriter writer(file_prefix, AsyncOptions(100));
+  WriteFile(&writer);
+  TF_EXPECT_OK(writer.Close());
+  string filename = writer.FileName();
+  VerifyFile(filename);
+}
+
+TEST(EventWriter, AsyncWriteDelete) {
+  string file_prefix = GetDirName("/asyncwritedelete_test");
+  EventsWriter* writer = new EventsWriter(file_prefix, AsyncOptions(100));
+  WriteFile(writer);
+  string filename = writer->FileName();
+  delete writer;
+  VerifyFile(filename);
+}
+
+TEST(EventWriter, AsyncFullQueue) {
+  string file_prefix = GetDirName("/asyncfullqueue_test");
+  // Writes wait for the background writer to take each event.
+  EventsWriter writer(file_prefix, AsyncOptions(1));
+  string filename = writer.FileName();
+  for (int i = 0; i < 1000; ++i) {
+    WriteSimpleValue(&writer, 1234, i, "foo", i);
+    if (i % 100 == 0) TF_EXPECT_OK(writer.RequestFlush());
+  }
+  TF_EXPECT_OK(writer.Flush());
+  EXPECT_EQ(CountEvents(filename), 1001);
+  TF_EXPECT_OK(writer.Close());
+  TF_ASSERT_OK(env()->DeleteFile(filename));
+}
+
+TEST(EventWriter, CompressedWriteClose) {
+  for (const string compression_type : {"ZLIB", "GZIP"}) {
+    for (int64_t max_queued_events : {0, 10}) {
+      string file_prefix = GetDirName("/compressedwriteclose_test");
+      EventsWriter::Options options = AsyncOptions(max_queued_events);
+      options.compression_type = compression_type;
+      EventsWriter writer(file_prefix, options);
+      string filename = writer.FileName();
+      WriteFile(&writer);
+      TF_EXPECT_OK(writer.Close());
+      EXPECT_EQ(CountEvents(filename, compression_type), 3);
+      TF_ASSERT_OK(env()->DeleteFile(filename));
+    }
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -93,6 +93,46 @@ class LimitedArraySlice {
   T* end_;
 };
 
+// Returns the number of varints in `[begin, end)`, i.e. the number of bytes
+// without the continuation bit. Eight bytes are counted at a time.
+inline int64_t CountVarints(const uint8* begin, const uint8* end) {
+  int64_t count = 0;
+  const uint8* p = begin;
+  for (; end - p >= 8; p += 8) {
+    uint64 word;
+    memcpy(&word, p, sizeof(word));
+    // One bit per byte without the continuation bit, summed in the top byte.
+    const uint64 last_bytes = (~word & 0x8080808080808080ULL) >> 7;
+    count += (last_bytes * 0x0101010101010101ULL) >> 56;
+  }
+  for (; p < end; ++p) {
+    count += *p < 0x80;
+  }
+  return count;
+}
+
+// Decodes the varint at `*p` and advances `*p` past it. Returns false if the
+// varint is longer than 10 bytes or does not end before `end`.
+inline bool DecodeVarint64(const uint8** p, const uint8* end, uint64* value) {
+  const uint8* ptr = *p;
+  if (ptr < end && *ptr < 0x80) {
+    *value = *ptr;
+    *p = ptr + 1;
+    return true;
+  }
+  uint64 result = 0;
+  for (int shift = 0; shift < 64 && ptr < end; shift += 7) {
+    const uint8 byte = *ptr++;
+    result |= static_cast<uint64>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      *value = result;
+      *p = ptr;
+      return true;
+    }
+  }
+  return false;
+}
+
 template <typename A>
 auto EnableAliasing(A* a) -> decltype(a->EnableAliasing(true), void()) {
   a->EnableAliasing(true);
@@ -301,10 +341,34 @@ class Feature {
         if (!stream.ReadVarint32(&packed_length)) return false;
         auto packed_limit = stream.PushLimit(packed_length);
 
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64_t>(n));
+        // The serialized feature is a flat buffer, so the packed values can be
+        // decoded in place: count them to size the output once, then decode
+        // them without going through the stream for every value.
+        const void* data;
+        int size;
+        if (stream.GetDirectBufferPointer(&data, &size) &&
+            static_cast<uint32>(size) == packed_length) {
+          const uint8* begin = static_cast<const uint8*>(data);
+          const uint8* end = begin + packed_length;
+          const size_t initial_size = int64_list->size();
+          int64_list->resize(initial_size + CountVarints(begin, end));
+          // The space available can be less than requested in resize in case
+          // of a LimitedArraySlice.
+          const size_t capacity = int64_list->size() - initial_size;
+          auto* values = int64_list->data() + initial_size;
+          size_t index = 0;
+          for (const uint8* p = begin; p < end; ++index) {
+            uint64 n;
+            if (!DecodeVarint64(&p, end, &n)) return false;
+            if (index < capacity) values[index] = static_cast<int64_t>(n);
+          }
+          if (!stream.Skip(packed_length)) return false;
+        } else {
+          while (!stream.ExpectAtEnd()) {
+            protobuf_uint64 n;  // There is no API for int64
+            if (!stream.ReadVarint64(&n)) return false;
+            int64_list->push_back(static_cast<int64_t>(n));
+          }
         }
 
         stream.PopLimit(packed_limit);
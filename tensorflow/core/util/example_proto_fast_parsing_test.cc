@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <limits>
 #include <utility>
 
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
@@ -213,6 +214,25 @@ TEST(FastParse, SingleInt64) {
   TestCorrectness(Serialize(example));
 }
 
+TEST(FastParse, PackedInt64Varints) {
+  Example example;
+  Int64List* int64_list =
+      (*example.mutable_features()->mutable_feature())["int64_list"]
+          .mutable_int64_list();
+  // Values of every varint length, with runs longer than eight bytes.
+  for (int64_t value :
+       {int64_t{0}, int64_t{1}, int64_t{127}, int64_t{128}, int64_t{300},
+        int64_t{16383}, int64_t{16384}, int64_t{1} << 35, int64_t{-1},
+        std::numeric_limits<int64_t>::min(),
+        std::numeric_limits<int64_t>::max()}) {
+    int64_list->add_value(value);
+  }
+  for (int i = 0; i < 100; ++i) {
+    int64_list->add_value(i * i * i);
+  }
+  TestCorrectness(Serialize(example));
+}
+
 static string ExampleWithSomeFeatures() {
   Example example;
 
@@ -94,7 +94,9 @@ class MemmappedFileSystem : public FileSystem {
   Status Stat(const string& fname, TransactionToken* token,
               FileStatistics* stat) override;
 
-  // Initializes filesystem from a file in memmapped format.
+  // Initializes filesystem from a file in memmapped format. With the POSIX
+  // Env, the TF_MMAP_* environment variables select how the file is mapped,
+  // e.g. with hugepages (see PosixMemoryRegionOptions).
   Status InitializeFromFile(Env* env, const string& filename);
 
   // Checks if the filename has a correct prefix.
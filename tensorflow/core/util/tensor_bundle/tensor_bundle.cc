@@ -21,8 +21,10 @@ limitations under the License.
 #include <memory>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -35,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/filter_policy.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/random.h"
@@ -383,6 +386,14 @@ Status CorruptFileError(const Status& in_status, const string& filename,
                       detail, "): ", in_status.error_message()));
 }
 
+// The filter policy of the metadata tables: a bloom filter of 10 bits per key,
+// i.e. about 1% of false positives.  Readers of tables written without filter
+// ignore it.
+const table::FilterPolicy* MetadataFilterPolicy() {
+  static const table::FilterPolicy* policy = table::NewBloomFilterPolicy(10);
+  return policy;
+}
+
 table::Options TableBuilderOptions() {
   table::Options o;
   // Compressed tables cannot be read by TensorFlow releases prior to 1.1.
@@ -390,9 +401,65 @@ table::Options TableBuilderOptions() {
   // (version 1.2) with the intention that they will be enabled again at
   // some point (perhaps the 1.3 release?).
   o.compression = table::kNoCompression;
+  o.filter_policy = MetadataFilterPolicy();
   return o;
 }
 
+// Returns the block cache of the metadata tables, shared by all the
+// BundleReaders of the process, or nullptr if TF_TABLE_INDEX_CACHE_SIZE_IN_MB
+// is not set.
+table::Cache* SharedMetadataCache() {
+  static table::Cache* cache = []() -> table::Cache* {
+    int64_t cache_size;
+    Status s =
+        ReadInt64FromEnvVar("TF_TABLE_INDEX_CACHE_SIZE_IN_MB", 0, &cache_size);
+    if (!s.ok() || cache_size <= 0) return nullptr;
+    return table::NewLRUCache(cache_size << 20);
+  }();
+  return cache;
+}
+
+// Returns the id of the blocks of the metadata table "filename" in "cache", so
+// that the BundleReaders of the same bundle share them.  The size and
+// modification time of the file distinguish bundles written to the same path.
+uint64 MetadataCacheId(table::Cache* cache, const string& filename,
+                       const FileStatistics& stat) {
+  static mutex* mu = new mutex;
+  static auto* cache_ids = new std::unordered_map<string, uint64>;
+  const string key =
+      strings::StrCat(filename, ":", stat.length, ":", stat.mtime_nsec);
+  mutex_lock l(*mu);
+  auto it = cache_ids->find(key);
+  if (it == cache_ids->end()) {
+    it = cache_ids->emplace(key, cache->NewId()).first;
+  }
+  return it->second;
+}
+
+// The buffer of a tensor backed by a memory mapped data file, which it keeps
+// mapped.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("BundleReaderMmap");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
 // Writes zeros to output buffer to align the next write to the requested
 // alignment. "size" is the current size of the buffer and is updated to the
 // new size.
@@ -412,14 +479,18 @@ Status PadAlignment(FileOutputBuffer* out, int alignment, int64_t* size) {
 }  // namespace
 
 BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
-    : env_(env), options_(options), prefix_(prefix), out_(nullptr), size_(0) {
+    : env_(env), options_(options), prefix_(prefix) {
+  if (options_.num_shards < 1) {
+    status_ = errors::InvalidArgument(
+        "BundleWriter requires at least one data file, got num_shards = ",
+        options_.num_shards);
+    return;
+  }
   status_ = env_->HasAtomicMove(prefix_, &use_temp_file_);
   if (!status_.ok()) return;
 
-  data_path_ = DataFilename(prefix_, 0, 1);
   metadata_path_ = MetaFilename(prefix_);
   if (use_temp_file_) {
-    data_path_ = strings::StrCat(data_path_, ".tempstate", random::New64());
     metadata_path_ =
         strings::StrCat(metadata_path_, ".tempstate", random::New64());
   }
@@ -429,13 +500,41 @@ BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
     return;
   }
 
-  std::unique_ptr<WritableFile> wrapper;
-  status_ = env_->NewWritableFile(data_path_, &wrapper);
-  if (!status_.ok()) return;
-  out_ = std::unique_ptr<FileOutputBuffer>(
-      new FileOutputBuffer(wrapper.release(), 8 << 20 /* 8MB write buffer */));
+  for (int i = 0; i < options_.num_shards; ++i) {
+    std::unique_ptr<Shard> shard(new Shard);
+    shard->id = i;
+    shard->data_path = DataFilename(prefix_, i, options_.num_shards);
+    if (use_temp_file_) {
+      shard->data_path =
+          strings::StrCat(shard->data_path, ".tempstate", random::New64());
+    }
+    std::unique_ptr<WritableFile> wrapper;
+    status_ = env_->NewWritableFile(shard->data_path, &wrapper);
+    if (!status_.ok()) return;
+    shard->out = std::unique_ptr<FileOutputBuffer>(new FileOutputBuffer(
+        wrapper.release(), 8 << 20 /* 8MB write buffer */));
+    VLOG(1) << "Writing to file " << shard->data_path;
+    shards_.push_back(std::move(shard));
+  }
 
-  VLOG(1) << "Writing to file " << data_path_;
+  if (options_.num_threads > 0) {
+    // Each data file is written by at most one thread at a time.
+    thread_pool_.reset(
+        new thread::ThreadPool(env_, "bundle_writer",
+                               std::min(options_.num_threads,
+                                        options_.num_shards)));
+  }
+}
+
+BundleWriter::~BundleWriter() {
+  if (thread_pool_) {
+    {
+      mutex_lock l(mu_);
+      write_status_.Update(errors::Cancelled("BundleWriter is destroyed"));
+    }
+    // Waits for the tensors being written.
+    thread_pool_.reset();
+  }
 }
 
 Status BundleWriter::Add(StringPiece key, const Tensor& val) {
@@ -446,33 +545,99 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
     status_ = errors::InvalidArgument("Adding duplicate key: ", key);
     return status_;
   }
+  if (thread_pool_) {
+    mutex_lock l(mu_);
+    if (!write_status_.ok()) {
+      status_ = write_status_;
+      return status_;
+    }
+  }
 
   BundleEntryProto* entry = &entries_[key_string];
   entry->set_dtype(val.dtype());
   val.shape().AsProto(entry->mutable_shape());
-  entry->set_shard_id(0);
-  entry->set_offset(size_);
+
+  Shard* shard = shards_[0].get();
+  for (const auto& other_shard : shards_) {
+    if (other_shard->added_bytes < shard->added_bytes) {
+      shard = other_shard.get();
+    }
+  }
+  shard->added_bytes += val.TotalBytes();
+  entry->set_shard_id(shard->id);
+
+  if (!thread_pool_) {
+    status_ = WriteTensorToShard(val, shard, entry);
+    return status_;
+  }
+  Shard::PendingTensor pending;
+  pending.val = options_.copy_tensors ? tensor::DeepCopy(val) : val;
+  pending.entry = entry;
+  mutex_lock l(mu_);
+  shard->pending.push_back(std::move(pending));
+  if (!shard->scheduled) {
+    shard->scheduled = true;
+    ++num_scheduled_shards_;
+    thread_pool_->Schedule([this, shard]() { WritePendingTensors(shard); });
+  }
+  return Status::OK();
+}
+
+Status BundleWriter::WriteTensorToShard(const Tensor& val, Shard* shard,
+                                        BundleEntryProto* entry) {
+  entry->set_offset(shard->size);
 
   // Updates the data file.
+  FileOutputBuffer* out = shard->out.get();
   size_t data_bytes_written = 0;
   uint32 crc32c = 0;
-  out_->clear_crc32c();
+  out->clear_crc32c();
   if (val.dtype() == DT_STRING) {
-    status_ = WriteStringTensor(val, out_.get(), &data_bytes_written, &crc32c);
+    TF_RETURN_IF_ERROR(
+        WriteStringTensor(val, out, &data_bytes_written, &crc32c));
   } else if (val.dtype() == DT_VARIANT) {
-    status_ = WriteVariantTensor(val, out_.get(), &data_bytes_written, &crc32c);
+    TF_RETURN_IF_ERROR(
+        WriteVariantTensor(val, out, &data_bytes_written, &crc32c));
   } else {
-    status_ = WriteTensor(val, out_.get(), &data_bytes_written);
-    crc32c = out_->crc32c();
+    TF_RETURN_IF_ERROR(WriteTensor(val, out, &data_bytes_written));
+    crc32c = out->crc32c();
+  }
+
+  entry->set_size(data_bytes_written);
+  entry->set_crc32c(crc32c::Mask(crc32c));
+  shard->size += data_bytes_written;
+  return PadAlignment(out, options_.data_alignment, &shard->size);
+}
+
+void BundleWriter::WritePendingTensors(Shard* shard) {
+  while (true) {
+    Shard::PendingTensor pending;
+    {
+      mutex_lock l(mu_);
+      if (shard->pending.empty() || !write_status_.ok()) {
+        shard->pending.clear();
+        shard->scheduled = false;
+        if (--num_scheduled_shards_ == 0) {
+          pending_tensors_written_.notify_all();
+        }
+        return;
+      }
+      pending = std::move(shard->pending.front());
+      shard->pending.pop_front();
+    }
+    Status status = WriteTensorToShard(pending.val, shard, pending.entry);
+    if (!status.ok()) {
+      mutex_lock l(mu_);
+      write_status_.Update(status);
+    }
   }
+}
 
-  if (status_.ok()) {
-    entry->set_size(data_bytes_written);
-    entry->set_crc32c(crc32c::Mask(crc32c));
-    size_ += data_bytes_written;
-    status_ = PadAlignment(out_.get(), options_.data_alignment, &size_);
+void BundleWriter::WaitForPendingTensors() {
+  mutex_lock l(mu_);
+  while (num_scheduled_shards_ > 0) {
+    pending_tensors_written_.wait(l);
   }
-  return status_;
 }
 
 Status BundleWriter::AddSlice(StringPiece full_tensor_key,
@@ -519,18 +684,26 @@ Status BundleWriter::AddSlice(StringPiece full_tensor_key,
 // TODO(zongheng): on metadata write failure or !status_.ok(), consider removing
 // the orphaned data file.
 Status BundleWriter::Finish() {
-  if (out_) {
-    status_.Update(out_->Close());
-    out_ = nullptr;
+  if (thread_pool_) {
+    WaitForPendingTensors();
+    mutex_lock l(mu_);
+    status_.Update(write_status_);
+  }
+  for (const auto& shard : shards_) {
+    status_.Update(shard->out->Close());
+  }
+  for (const auto& shard : shards_) {
     if (status_.ok()) {
       if (use_temp_file_) {
-        status_ =
-            Env::Default()->RenameFile(data_path_, DataFilename(prefix_, 0, 1));
+        status_ = Env::Default()->RenameFile(
+            shard->data_path,
+            DataFilename(prefix_, shard->id, options_.num_shards));
       }
     } else {
-      Env::Default()->DeleteFile(data_path_).IgnoreError();
+      Env::Default()->DeleteFile(shard->data_path).IgnoreError();
     }
   }
+  shards_.clear();
   if (!status_.ok()) return status_;
   // Build key -> BundleEntryProto table.
   std::unique_ptr<WritableFile> file;
@@ -541,10 +714,11 @@ Status BundleWriter::Finish() {
     // platforms (e.g. Android).  The metadata file is small, so this is fine.
     table::Options options;
     options.compression = table::kNoCompression;
+    options.filter_policy = MetadataFilterPolicy();
     table::TableBuilder builder(options, file.get());
     // Header entry.
     BundleHeaderProto header;
-    header.set_num_shards(1);
+    header.set_num_shards(options_.num_shards);
     header.set_endianness(BundleHeaderProto::LITTLE);
     if (!port::kLittleEndian) header.set_endianness(BundleHeaderProto::BIG);
     VersionDef* version = header.mutable_version();
@@ -743,18 +917,21 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
 
 // Interface for reading a tensor bundle.
 
-BundleReader::BundleReader(Env* env, StringPiece prefix)
+BundleReader::BundleReader(Env* env, StringPiece prefix,
+                           const Options& options)
     : env_(env),
       prefix_(prefix),
+      options_(options),
       metadata_(nullptr),
       table_(nullptr),
-      index_cache_(nullptr),
+      metadata_cache_(SharedMetadataCache()),
       iter_(nullptr),
       need_to_swap_bytes_(false) {
   const string filename = MetaFilename(prefix_);
-  uint64 file_size;
-  status_ = env_->GetFileSize(filename, &file_size);
+  FileStatistics stat;
+  status_ = env_->Stat(filename, &stat);
   if (!status_.ok()) return;
+  const uint64 file_size = stat.length;
 
   // Opens the metadata table.
   std::unique_ptr<RandomAccessFile> wrapper;
@@ -763,12 +940,10 @@ BundleReader::BundleReader(Env* env, StringPiece prefix)
   metadata_ = wrapper.release();
 
   table::Options o;
-  int64_t cache_size;
-  Status s =
-      ReadInt64FromEnvVar("TF_TABLE_INDEX_CACHE_SIZE_IN_MB", 0, &cache_size);
-  if (s.ok() && cache_size > 0) {
-    index_cache_ = table::NewLRUCache(cache_size << 20);
-    o.block_cache = index_cache_;
+  o.filter_policy = MetadataFilterPolicy();
+  if (metadata_cache_ != nullptr) {
+    o.block_cache = metadata_cache_;
+    o.block_cache_id = MetadataCacheId(metadata_cache_, filename, stat);
   }
 
   status_ = table::Table::Open(o, metadata_, file_size, &table_);
@@ -802,9 +977,6 @@ BundleReader::~BundleReader() {
   delete metadata_;
   delete iter_;
   delete table_;
-  if (index_cache_) {
-    delete index_cache_;
-  }
   // InputBuffer does not own the underlying RandomAccessFile.
   for (auto pair : data_) {
     if (pair.second != nullptr && pair.second->file() != nullptr) {
@@ -825,6 +997,9 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
                                          BundleEntryProto* entry) {
   entry->Clear();
   TF_CHECK_OK(status_);
+  if (!table_->KeyMayMatch(key)) {
+    return errors::NotFound("Key ", key, " not found in checkpoint");
+  }
   Seek(key);
   if (!iter_->Valid() || iter_->key() != key) {
     return errors::NotFound("Key ", key, " not found in checkpoint");
@@ -871,6 +1046,31 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     }
   }
 
+  if (options_.use_mmap && DataTypeCanUseMemcpy(entry.dtype()) &&
+      !need_to_swap_bytes_ && entry.size() > 0) {
+    std::shared_ptr<ReadOnlyMemoryRegion> region;
+    TF_RETURN_IF_ERROR(GetMappedDataFile(entry.shard_id(), &region));
+    if (region != nullptr) {
+      if (entry.offset() + entry.size() > region->length()) {
+        return errors::DataLoss("TensorBundle at ", prefix_, " shard ",
+                                entry.shard_id(), " (", region->length(),
+                                " bytes) is truncated: key ", key(),
+                                " ends at ", entry.offset() + entry.size());
+      }
+      Tensor mapped(
+          entry.dtype(), ret->shape(),
+          core::RefCountPtr<TensorBuffer>(new MappedTensorBuffer(
+              region, static_cast<const char*>(region->data()) + entry.offset(),
+              entry.size())));
+      if (mapped.IsAligned()) {
+        *val = std::move(mapped);
+        if (ret != val) delete ret;
+        return Status::OK();
+      }
+      VLOG(1) << "Reading unaligned tensor " << key() << " of " << prefix_;
+    }
+  }
+
   // Open the data file if it has not been opened.
   io::InputBuffer* buffered_file = data_[entry.shard_id()];
   if (buffered_file == nullptr) {
@@ -938,6 +1138,26 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   return Status::OK();
 }
 
+Status BundleReader::GetMappedDataFile(
+    int32_t shard_id, std::shared_ptr<ReadOnlyMemoryRegion>* region) {
+  auto it = mapped_data_.find(shard_id);
+  if (it == mapped_data_.end()) {
+    const string filename = DataFilename(prefix_, shard_id, num_shards_);
+    std::unique_ptr<ReadOnlyMemoryRegion> new_region;
+    Status status =
+        env_->NewReadOnlyMemoryRegionFromFile(filename, &new_region);
+    if (errors::IsUnimplemented(status)) {
+      VLOG(1) << "Reading " << filename << " which cannot be memory mapped: "
+              << status;
+    } else {
+      TF_RETURN_IF_ERROR(status);
+    }
+    it = mapped_data_.emplace(shard_id, std::move(new_region)).first;
+  }
+  *region = it->second;
+  return Status::OK();
+}
+
 Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -1106,6 +1326,7 @@ Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
 }
 
 bool BundleReader::Contains(StringPiece key) {
+  if (!table_->KeyMayMatch(key)) return false;
   Seek(key);
   return Valid() && (this->key() == key);
 }
@@ -61,9 +61,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_BUNDLE_H_
 #define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_BUNDLE_H_
 
+#include <deque>
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
@@ -80,6 +83,9 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
@@ -108,6 +114,11 @@ extern const char* const kHeaderEntryKey;
 // On construction, attempts to create a directory given by the dirname of
 // "prefix", so "status()" must be checked before calling any member functions.
 //
+// The tensors can be spread over several data files ("num_shards"), and
+// serialized and written by a pool of threads ("num_threads"): Add() then only
+// enqueues the tensor for its data file, and Finish() waits for all the data
+// to be written.
+//
 // All threads accessing the same BundleWriter must synchronize.
 class BundleWriter {
  public:
@@ -116,9 +127,22 @@ class BundleWriter {
     // Alignment, in bytes, for tensor data.
     // Must be >= 1. The default size of 1 densely packs tensors.
     int data_alignment{1};
+    // Number of data files the tensors are spread over.  Each tensor goes to
+    // the data file with the fewest bytes added so far.
+    // Must be >= 1.
+    int num_shards{1};
+    // Number of threads serializing and writing the data files, each of which
+    // is written by at most one thread at a time.  If 0, tensors are written
+    // on the calling thread by Add().
+    int num_threads{0};
+    // Only used if num_threads > 0.  If true, Add() copies the tensor to host
+    // memory, so that the caller may modify it as soon as Add() returns.
+    // Otherwise the caller must not modify the tensors until Finish() returns.
+    bool copy_tensors{false};
   };
   BundleWriter(Env* env, StringPiece prefix,
                const Options& options = Options());
+  ~BundleWriter();
 
   // Adds the tensor "val" under key "key".
   // Across calls "key" must be unique but can be added in any order.
@@ -150,17 +174,59 @@ class BundleWriter {
   Status status() const { return status_; }
 
  private:
+  // A data file being written.
+  struct Shard {
+    struct PendingTensor {
+      Tensor val;
+      BundleEntryProto* entry = nullptr;  // Points into entries_.
+    };
+
+    int32 id;
+    string data_path;
+    std::unique_ptr<FileOutputBuffer> out;
+    int64_t size = 0;  // Number of bytes written into out.
+    // Number of bytes of the tensors added to this shard.  Only accessed by
+    // Add().
+    int64_t added_bytes = 0;
+
+    // The tensors waiting to be written by the thread pool, and whether a
+    // thread is writing them.  Guarded by BundleWriter::mu_.
+    std::deque<PendingTensor> pending;
+    bool scheduled = false;
+  };
+
+  // Appends "val" to "shard", and fills the offset, size and checksum of its
+  // "entry".
+  Status WriteTensorToShard(const Tensor& val, Shard* shard,
+                            BundleEntryProto* entry);
+
+  // Writes the pending tensors of "shard" until there are none left.  Runs on
+  // the thread pool.
+  void WritePendingTensors(Shard* shard);
+
+  // Waits until the thread pool wrote all the pending tensors.
+  void WaitForPendingTensors();
+
   Env* const env_;  // Not owned.
   const Options options_;
   const string prefix_;
   string metadata_path_;
-  string data_path_;
   bool use_temp_file_;
-  std::unique_ptr<FileOutputBuffer> out_;
-  int64_t size_;  // Number of bytes written into out_.
+  std::vector<std::unique_ptr<Shard>> shards_;
   std::map<string, BundleEntryProto> entries_;
   Status status_;
 
+  // Guards the pending tensors of the shards and the status of the thread
+  // pool.  The entries of the pending tensors are written by the thread pool
+  // without it, as entries_ only grows until Finish() waits for the pool.
+  mutex mu_;
+  condition_variable pending_tensors_written_;
+  int num_scheduled_shards_ TF_GUARDED_BY(mu_) = 0;
+  Status write_status_ TF_GUARDED_BY(mu_);
+  // Declared last, so that it waits for the scheduled writes before the other
+  // members are destroyed.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(BundleWriter);
 };
 
@@ -186,7 +252,20 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
 // All threads accessing the same BundleReader must synchronize.
 class BundleReader {
  public:
-  BundleReader(Env* const env, StringPiece prefix);
+  struct Options {
+    Options() {}
+    // If true, the data files are memory mapped when their file system
+    // supports it, and the non-string tensors whose data is suitably aligned
+    // in the data file (see BundleWriter::Options::data_alignment) are
+    // returned backed by the mapped pages instead of being copied: their data
+    // is only read from the file when first accessed, and is shared by all
+    // the tensors looked up.  Such tensors are read-only, may outlive the
+    // reader, and their checksum is not validated, as it would read all their
+    // data.
+    bool use_mmap{false};
+  };
+  BundleReader(Env* const env, StringPiece prefix,
+               const Options& options = Options());
   ~BundleReader();
 
   // Is ok() iff the reader construction is successful (completed the read of
@@ -231,7 +310,9 @@ class BundleReader {
   // On error, "val" may contain nonsense data.  Returns a NotFound error if
   // tensor keyed by "key" does not exist in this bundle.
   //
-  // Validates the stored crc32c checksum against the restored bytes.
+  // Validates the stored crc32c checksum against the restored bytes, unless
+  // "val" is memory mapped (see Options::use_mmap), in which case it is
+  // replaced by a tensor backed by the data file.
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
 
@@ -291,6 +372,12 @@ class BundleReader {
   Status GetValue(const BundleEntryProto& entry,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Sets "region" to the memory mapped data file "shard_id", or to nullptr if
+  // its file system does not support memory mapping.
+  Status GetMappedDataFile(int32_t shard_id,
+                           std::shared_ptr<ReadOnlyMemoryRegion>* region)
+      TF_MUST_USE_RESULT;
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -301,14 +388,19 @@ class BundleReader {
 
   Env* env_;  // Not owned.
   const string prefix_;
+  const Options options_;
 
   Status status_;
   RandomAccessFile* metadata_;  // Owned.
   table::Table* table_;
-  table::Cache* index_cache_;
+  table::Cache* metadata_cache_;  // Not owned, shared by the process.
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // The memory mapped data files, which are also owned by the tensors backed
+  // by them.  Only populated if options_.use_mmap.
+  std::unordered_map<int32, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
@@ -926,6 +926,109 @@ TEST(TensorBundleTest, SortForSequentialAccess) {
                           "tensor-1-2", "tensor-1-1", "tensor-1-0"));
 }
 
+TEST(TensorBundleTest, ShardedParallelWrite) {
+  Env* env = Env::Default();
+  const string kPrefix = Prefix("sharded");
+  BundleWriter::Options options;
+  options.num_shards = 3;
+  options.num_threads = 2;
+  options.data_alignment = 8;
+  {
+    BundleWriter writer(env, kPrefix, options);
+    TF_ASSERT_OK(writer.status());
+    for (int i = 0; i < 20; ++i) {
+      TF_EXPECT_OK(writer.Add(strings::StrCat("float", i),
+                              Constant(static_cast<float>(i),
+                                       TensorShape({i + 1, 3}))));
+      TF_EXPECT_OK(writer.Add(strings::StrCat("string", i),
+                              Constant(tstring(strings::StrCat("s", i)),
+                                       TensorShape({2}))));
+    }
+    TF_EXPECT_OK(writer.AddSlice("partitioned", TensorShape({4, 3}),
+                                 TensorSlice::ParseOrDie("0,2:-"),
+                                 Constant_2x3<float>(100.)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    TF_EXPECT_OK(env->FileExists(DataFilename(kPrefix, i, 3)));
+  }
+  BundleReader reader(env, kPrefix);
+  TF_ASSERT_OK(reader.status());
+  for (int i = 0; i < 20; ++i) {
+    Expect<float>(
+        &reader, strings::StrCat("float", i),
+        Constant(static_cast<float>(i), TensorShape({i + 1, 3})));
+    Expect<tstring>(
+        &reader, strings::StrCat("string", i),
+        Constant(tstring(strings::StrCat("s", i)), TensorShape({2})));
+  }
+  Tensor slice(DT_FLOAT, TensorShape({2, 3}));
+  TF_ASSERT_OK(reader.LookupSlice(
+      "partitioned", TensorSlice::ParseOrDie("0,2:-"), &slice));
+  test::ExpectTensorEqual<float>(slice, Constant_2x3<float>(100.));
+
+  // The sharded bundle can be merged with others.
+  const string kMerged = Prefix("sharded_merged");
+  TF_ASSERT_OK(MergeBundles(env, {kPrefix}, kMerged));
+  BundleReader merged_reader(env, kMerged);
+  TF_ASSERT_OK(merged_reader.status());
+  Expect<float>(&merged_reader, "float19",
+                Constant(19.f, TensorShape({20, 3})));
+}
+
+TEST(TensorBundleTest, ParallelWriteCopiesTensors) {
+  BundleWriter::Options options;
+  options.num_threads = 1;
+  options.copy_tensors = true;
+  BundleWriter writer(Env::Default(), Prefix("copied"), options);
+  Tensor val = Constant_2x3<float>(1.);
+  TF_EXPECT_OK(writer.Add("foo", val));
+  // The tensor may be modified as soon as it is added.
+  val.flat<float>().setConstant(2.);
+  TF_ASSERT_OK(writer.Finish());
+
+  BundleReader reader(Env::Default(), Prefix("copied"));
+  TF_ASSERT_OK(reader.status());
+  Expect<float>(&reader, "foo", Constant_2x3<float>(1.));
+}
+
+TEST(TensorBundleTest, MemoryMappedRead) {
+  Env* env = Env::Default();
+  const string kPrefix = Prefix("mmap");
+  BundleWriter::Options writer_options;
+  writer_options.data_alignment = 64;
+  {
+    BundleWriter writer(env, kPrefix, writer_options);
+    TF_EXPECT_OK(writer.Add("float", Constant_2x3<float>(1.)));
+    TF_EXPECT_OK(writer.Add("int8", Constant(int8(2), TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("string", Constant_2x3<tstring>("foo")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  BundleReader::Options options;
+  options.use_mmap = true;
+  Tensor mapped_float(DT_FLOAT, TensorShape({2, 3}));
+  Tensor mapped_int8(DT_INT8, TensorShape({3}));
+  Tensor string_tensor(DT_STRING, TensorShape({2, 3}));
+  const char* float_buffer = mapped_float.tensor_data().data();
+  {
+    BundleReader reader(env, kPrefix, options);
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(reader.Lookup("float", &mapped_float));
+    TF_ASSERT_OK(reader.Lookup("int8", &mapped_int8));
+    TF_ASSERT_OK(reader.Lookup("string", &string_tensor));
+  }
+  // The tensors are backed by the data file, and outlive the reader.
+  EXPECT_NE(mapped_float.tensor_data().data(), float_buffer);
+  EXPECT_TRUE(mapped_float.IsAligned());
+  test::ExpectTensorEqual<float>(mapped_float, Constant_2x3<float>(1.));
+  test::ExpectTensorEqual<int8>(mapped_int8,
+                                Constant(int8(2), TensorShape({3})));
+  test::ExpectTensorEqual<tstring>(string_tensor,
+                                   Constant_2x3<tstring>("foo"));
+}
+
 TEST(TensorBundleTest, Error) {
   {  // Dup keys.
     BundleWriter writer(Env::Default(), Prefix("dup"));
@@ -939,6 +1042,13 @@ TEST(TensorBundleTest, Error) {
     EXPECT_TRUE(writer.Finish().ok());
     EXPECT_FALSE(writer.Finish().ok());
   }
+  {  // No data file.
+    BundleWriter::Options options;
+    options.num_shards = 0;
+    BundleWriter writer(Env::Default(), Prefix("no_shards"), options);
+    EXPECT_EQ(writer.status().code(), error::INVALID_ARGUMENT);
+    EXPECT_FALSE(writer.Finish().ok());
+  }
   {  // Not found.
     BundleReader reader(Env::Default(), Prefix("nonexist"));
     EXPECT_EQ(reader.status().code(), error::NOT_FOUND);
@@ -82,6 +82,17 @@ class MMAPAllocation : public Allocation {
 
   int fd() const { return mmap_fd_; }
 
+  // Returns how many bytes of [data, data + size), a region of this
+  // allocation, are currently in memory rather than only in the file. The OS
+  // reads the pages of the file into memory when they are first accessed, and
+  // may drop them under memory pressure.
+  size_t GetResidentBytes(const void* data, size_t size) const;
+
+  // Tells the OS that [data, data + size), a region of this allocation, isn't
+  // needed for now so that its memory can be reclaimed. The data remains
+  // valid: it is read again from the file when next accessed.
+  void ReleaseResidentPages(const void* data, size_t size) const;
+
   static bool IsSupported();
 
  protected:
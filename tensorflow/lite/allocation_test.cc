@@ -139,6 +139,42 @@ TEST(MMAPAllocation, TestValidFileDescriptorWithOffset) {
 
   close(fd);
 }
+
+TEST(MMAPAllocation, TestResidentPages) {
+  if (!MMAPAllocation::IsSupported()) {
+    return;
+  }
+
+  int fd =
+      open("tensorflow/lite/testdata/empty_model.bin", O_RDONLY);
+  ASSERT_GT(fd, 0);
+
+  struct stat fd_stat;
+  ASSERT_EQ(fstat(fd, &fd_stat), 0);
+  size_t file_size = fd_stat.st_size;
+
+  TestErrorReporter error_reporter;
+  MMAPAllocation allocation(fd, /*offset=*/10, /*length=*/file_size - 10,
+                            &error_reporter);
+  ASSERT_TRUE(allocation.valid());
+  const char* data = static_cast<const char*>(allocation.base());
+  const std::string contents(data, allocation.bytes());
+
+  // Reading the data brings its pages in memory.
+  EXPECT_EQ(std::string(data, allocation.bytes()), contents);
+  EXPECT_EQ(allocation.GetResidentBytes(data, allocation.bytes()),
+            allocation.bytes());
+  EXPECT_EQ(allocation.GetResidentBytes(data + 1, 2), 2);
+  EXPECT_EQ(allocation.GetResidentBytes(data, 0), 0);
+
+  // The data can still be read after its pages are released.
+  allocation.ReleaseResidentPages(data, allocation.bytes());
+  EXPECT_LE(allocation.GetResidentBytes(data, allocation.bytes()),
+            allocation.bytes());
+  EXPECT_EQ(std::string(data, allocation.bytes()), contents);
+
+  close(fd);
+}
 #endif  // defined(__linux__)
 
 }  // namespace tflite
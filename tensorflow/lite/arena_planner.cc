@@ -205,6 +205,24 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
     }
   }
 
+  // Nodes of a concurrent group may run at the same time, so a tensor used by
+  // any of them must not share memory with a tensor used by another one.
+  // Extend the lifetime of such tensors to cover the whole group.
+  if (!group_first_node_.empty()) {
+    const int num_grouped_nodes = group_first_node_.size();
+    for (int i = 0; i < static_cast<int>(graph_info_->num_tensors()); ++i) {
+      if (alloc_node_[i] < first_node || alloc_node_[i] > last_node ||
+          alloc_node_[i] >= num_grouped_nodes) {
+        continue;
+      }
+      alloc_node_[i] = std::max(first_node, group_first_node_[alloc_node_[i]]);
+      if (dealloc_node_[i] != kNodeNotAssigned &&
+          dealloc_node_[i] < num_grouped_nodes) {
+        dealloc_node_[i] = group_last_node_[dealloc_node_[i]];
+      }
+    }
+  }
+
   TF_LITE_ENSURE_STATUS(CalculateAllocations(first_node, last_node));
   TF_LITE_ENSURE_STATUS(Commit());
 
@@ -245,6 +263,31 @@ bool ArenaPlanner::HasNonPersistentMemory() {
   return arena_.GetBufferSize() != 0;
 }
 
+TfLiteStatus ArenaPlanner::SetConcurrentNodeGroups(
+    const std::vector<int>& group_first_nodes) {
+  group_first_node_.clear();
+  group_last_node_.clear();
+  if (group_first_nodes.empty()) return kTfLiteOk;
+  const int num_nodes = graph_info_->num_execution_nodes();
+  TF_LITE_ENSURE(context_, group_first_nodes[0] == 0);
+  std::vector<int32_t> group_first_node(num_nodes);
+  std::vector<int32_t> group_last_node(num_nodes);
+  for (int group = 0; group < group_first_nodes.size(); ++group) {
+    const int first = group_first_nodes[group];
+    const int last = group + 1 < group_first_nodes.size()
+                         ? group_first_nodes[group + 1] - 1
+                         : num_nodes - 1;
+    TF_LITE_ENSURE(context_, first <= last && last < num_nodes);
+    for (int node = first; node <= last; ++node) {
+      group_first_node[node] = first;
+      group_last_node[node] = last;
+    }
+  }
+  group_first_node_ = std::move(group_first_node);
+  group_last_node_ = std::move(group_last_node);
+  return kTfLiteOk;
+}
+
 void ArenaPlanner::DumpDebugInfo(const std::vector<int>& execution_plan) const {
   arena_.DumpDebugInfo("kTfLiteArenaRw Dump:", execution_plan);
   persistent_arena_.DumpDebugInfo("kTfLiteArenaRwPersistent Dump:",
@@ -312,10 +355,20 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
     }
   }
 
+  // When planning from the first node the arena is empty at this point, so a
+  // failed attempt to follow the offline plan can simply be cleared.
+  bool offline_plan_used = false;
+  if (first_node == 0 && !offline_plan_.offsets.empty()) {
+    offline_plan_used = AllocateFromOfflinePlan(tensor_order) == kTfLiteOk;
+    if (!offline_plan_used) {
+      TF_LITE_ENSURE_STATUS(arena_.ClearPlan());
+    }
+  }
+
   // Vector of ids of already allocated tensors, ordered by offset.
   for (const auto& tensor_index : tensor_order) {
     TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
-    if (tensor.allocation_type == kTfLiteArenaRw) {
+    if (tensor.allocation_type == kTfLiteArenaRw && !offline_plan_used) {
       TF_LITE_ENSURE_STATUS(
           arena_.Allocate(context_, tensor_alignment_, tensor.bytes,
                           tensor_index, alloc_node_[tensor_index],
@@ -334,6 +387,33 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
   return kTfLiteOk;
 }
 
+TfLiteStatus ArenaPlanner::AllocateFromOfflinePlan(
+    const std::vector<int32_t>& tensor_order) {
+  const int num_planned_tensors = offline_plan_.offsets.size();
+  if (offline_plan_.sizes.size() != num_planned_tensors) return kTfLiteError;
+  // Check that the plan covers all the tensors before allocating any of them.
+  for (const auto& tensor_index : tensor_order) {
+    const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+    if (tensor.allocation_type != kTfLiteArenaRw) continue;
+    if (tensor_index >= num_planned_tensors ||
+        offline_plan_.offsets[tensor_index] < 0 ||
+        offline_plan_.sizes[tensor_index] < 0 ||
+        static_cast<size_t>(offline_plan_.sizes[tensor_index]) !=
+            tensor.bytes) {
+      return kTfLiteError;
+    }
+  }
+  for (const auto& tensor_index : tensor_order) {
+    const TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
+    if (tensor.allocation_type != kTfLiteArenaRw) continue;
+    TF_LITE_ENSURE_STATUS(arena_.AllocateAt(
+        context_, tensor_alignment_, offline_plan_.offsets[tensor_index],
+        tensor.bytes, tensor_index, alloc_node_[tensor_index],
+        dealloc_node_[tensor_index], &allocs_[tensor_index]));
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus ArenaPlanner::ResolveTensorAllocation(int tensor_index) {
   TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
   if (tensor.allocation_type == kTfLiteArenaRw) {
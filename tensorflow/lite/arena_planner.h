@@ -17,11 +17,13 @@ limitations under the License.
 
 #include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/memory_planner.h"
+#include "tensorflow/lite/offline_arena_plan.h"
 #include "tensorflow/lite/simple_memory_arena.h"
 #include "tensorflow/lite/util.h"
 
@@ -62,11 +64,22 @@ class ArenaPlanner : public MemoryPlanner {
   TfLiteStatus ReleaseNonPersistentMemory() override;
   TfLiteStatus AcquireNonPersistentMemory() override;
   bool HasNonPersistentMemory() override;
+  TfLiteStatus SetConcurrentNodeGroups(
+      const std::vector<int>& group_first_nodes) override;
   void DumpDebugInfo(const std::vector<int>& execution_plan) const override;
 
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
 
+  // Places the kTfLiteArenaRw tensors at the offsets of a plan computed ahead
+  // of time rather than computing them. The plan is only used when every
+  // tensor to allocate is part of it with its current size, and when tensors
+  // in use at the same time don't overlap; the offsets are computed as usual
+  // otherwise.
+  void SetOfflinePlan(OfflineArenaPlan plan) {
+    offline_plan_ = std::move(plan);
+  }
+
  private:
   // Make sure all the arenas have reserved enough memory to store all their
   // tensors.
@@ -86,6 +99,12 @@ class ArenaPlanner : public MemoryPlanner {
   // for all tensors affected by ops in the interval [first_node, last_node].
   TfLiteStatus CalculateAllocations(int first_node, int last_node);
 
+  // Reserves space in the kTfLiteArenaRw arena for the tensors of
+  // 'tensor_order' at the offsets of the offline plan. Fails if the plan
+  // doesn't apply to them.
+  TfLiteStatus AllocateFromOfflinePlan(
+      const std::vector<int32_t>& tensor_order);
+
   // Assign absolute memory location to a tensor, based on its relative
   // position inside the corresponding arena buffer.
   TfLiteStatus ResolveTensorAllocation(int tensor_index);
@@ -112,6 +131,11 @@ class ArenaPlanner : public MemoryPlanner {
   // the node's operation.
   std::vector<int32_t> dealloc_node_;
 
+  // First and last node of the concurrent group each node belongs to, see
+  // SetConcurrentNodeGroups(). Empty if nodes are executed one at a time.
+  std::vector<int32_t> group_first_node_;
+  std::vector<int32_t> group_last_node_;
+
   // Raw memory buffer that is allocated for all temporary and graph outputs
   // that are declared kTfLiteArenaRw.
   SimpleMemoryArena arena_;
@@ -127,6 +151,9 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Number of bytes that tensor buffers should be aligned to.
   int tensor_alignment_;
+
+  // Offsets of the kTfLiteArenaRw tensors computed ahead of time, if any.
+  OfflineArenaPlan offline_plan_;
 };
 
 }  // namespace tflite
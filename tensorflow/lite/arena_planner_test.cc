@@ -688,6 +688,105 @@ TEST_F(ArenaPlannerTest, ComplexGraph) {
   EXPECT_EQ(GetOffset(8), 32);
 }
 
+TEST_F(ArenaPlannerTest, ConcurrentNodeGroups) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {2}, {4}},
+                      {{1}, {3}, {5}},
+                      {{2, 3}, {6}, {}},
+                  },
+                  {6});
+  SetGraph(&graph);
+  // The first two ops may run at the same time.
+  ASSERT_EQ(planner_->SetConcurrentNodeGroups({0, 2}), kTfLiteOk);
+  Execute(0, 10);
+
+  // None of the tensors used by the first two ops can share memory, not even
+  // their temporaries.
+  const std::vector<int> concurrent_tensors = {0, 1, 2, 3, 4, 5};
+  for (int a : concurrent_tensors) {
+    for (int b : concurrent_tensors) {
+      if (a == b) continue;
+      EXPECT_TRUE(GetOffsetAfter(a) <= GetOffset(b) ||
+                  GetOffsetAfter(b) <= GetOffset(a))
+          << "tensors " << a << " and " << b << " overlap";
+    }
+  }
+}
+
+TEST_F(ArenaPlannerTest, InvalidConcurrentNodeGroups) {
+  TestGraph graph({0}, {{{0}, {1}, {}}, {{1}, {2}, {}}}, {2});
+  SetGraph(&graph);
+  EXPECT_NE(planner_->SetConcurrentNodeGroups({1}), kTfLiteOk);
+  EXPECT_NE(planner_->SetConcurrentNodeGroups({0, 1, 1}), kTfLiteOk);
+  EXPECT_NE(planner_->SetConcurrentNodeGroups({0, 2}), kTfLiteOk);
+  EXPECT_EQ(planner_->SetConcurrentNodeGroups({}), kTfLiteOk);
+}
+
+TEST_F(ArenaPlannerTest, OfflinePlan) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},
+                      {{1}, {2}, {}},
+                      {{2}, {3}, {}},
+                  },
+                  {3});
+  SetGraph(&graph);
+  OfflineArenaPlan plan;
+  plan.offsets = {100, 0, 8, 20};
+  plan.sizes = {3, 6, 9, 12};
+  plan.arena_size = 103;
+  planner_->SetOfflinePlan(plan);
+  Execute(0, 10);
+
+  EXPECT_EQ(GetOffset(0), 100);
+  EXPECT_EQ(GetOffset(1), 0);
+  EXPECT_EQ(GetOffset(2), 8);
+  EXPECT_EQ(GetOffset(3), 20);
+}
+
+TEST_F(ArenaPlannerTest, InvalidOfflinePlan) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},
+                      {{1}, {2}, {}},
+                      {{2}, {3}, {}},
+                  },
+                  {3});
+  SetGraph(&graph);
+  Execute(0, 10);
+  std::vector<std::ptrdiff_t> offsets;
+  for (int i = 0; i < 4; ++i) offsets.push_back(GetOffset(i));
+
+  OfflineArenaPlan overlapping_plan;
+  // Tensors 2 and 3 are both in use during the last op.
+  overlapping_plan.offsets = {100, 0, 8, 12};
+  overlapping_plan.sizes = {3, 6, 9, 12};
+  OfflineArenaPlan misaligned_plan;
+  misaligned_plan.offsets = {100, 0, 8, 22};
+  misaligned_plan.sizes = {3, 6, 9, 12};
+  OfflineArenaPlan stale_plan;
+  stale_plan.offsets = {100, 0, 8, 20};
+  stale_plan.sizes = {3, 6, 9, 8};
+  OfflineArenaPlan partial_plan;
+  partial_plan.offsets = {100, 0, 8};
+  partial_plan.sizes = {3, 6, 9};
+
+  // The planner falls back to computing the offsets.
+  for (const OfflineArenaPlan& plan :
+       {overlapping_plan, misaligned_plan, stale_plan, partial_plan}) {
+    SetGraph(&graph);
+    planner_->SetOfflinePlan(plan);
+    Execute(0, 10);
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(GetOffset(i), offsets[i]) << "tensor " << i;
+    }
+  }
+}
+
 TEST_F(ArenaPlannerTest, GraphWithIntermediates) {
   TestGraph graph({0, 1},
                   {
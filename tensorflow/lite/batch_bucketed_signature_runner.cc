@@ -0,0 +1,119 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/batch_bucketed_signature_runner.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+
+namespace tflite {
+namespace {
+
+// Sets dimension 0 of every input of `runner` to `batch_size` and allocates
+// its tensors.
+TfLiteStatus ResizeToBatchSize(SignatureRunner* runner, int batch_size,
+                               ErrorReporter* error_reporter) {
+  for (const char* name : runner->input_names()) {
+    const TfLiteTensor* input = runner->input_tensor(name);
+    if (input->dims->size == 0) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Input '%s' has no batch dimension.", name);
+      return kTfLiteError;
+    }
+    std::vector<int> dims(input->dims->data,
+                          input->dims->data + input->dims->size);
+    dims[0] = batch_size;
+    if (runner->ResizeInputTensor(name, dims) != kTfLiteOk) {
+      return kTfLiteError;
+    }
+  }
+  return runner->AllocateTensors();
+}
+
+}  // namespace
+
+std::unique_ptr<BatchBucketedSignatureRunner>
+BatchBucketedSignatureRunner::Create(const FlatBufferModel& model,
+                                     const OpResolver& op_resolver,
+                                     const char* signature_key,
+                                     const Options& options) {
+  ErrorReporter* error_reporter = model.error_reporter();
+  std::vector<int> batch_sizes = options.batch_sizes;
+  std::sort(batch_sizes.begin(), batch_sizes.end());
+  batch_sizes.erase(std::unique(batch_sizes.begin(), batch_sizes.end()),
+                    batch_sizes.end());
+  if (batch_sizes.empty() || batch_sizes[0] < 1) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Batch sizes must be given and positive.");
+    return nullptr;
+  }
+
+  std::unique_ptr<BatchBucketedSignatureRunner> runner(
+      new BatchBucketedSignatureRunner);
+  for (int batch_size : batch_sizes) {
+    InterpreterBuilder builder(model, op_resolver);
+    std::unique_ptr<Interpreter> interpreter;
+    if (builder.SetNumThreads(options.num_threads) != kTfLiteOk ||
+        builder(&interpreter) != kTfLiteOk || interpreter == nullptr) {
+      return nullptr;
+    }
+    if (options.configure_interpreter &&
+        options.configure_interpreter(interpreter.get()) != kTfLiteOk) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Failed to configure the interpreter of batch "
+                           "size %d.",
+                           batch_size);
+      return nullptr;
+    }
+    SignatureRunner* signature_runner =
+        interpreter->GetSignatureRunner(signature_key);
+    if (signature_runner == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter, "Signature '%s' not found.",
+                           signature_key);
+      return nullptr;
+    }
+    if (ResizeToBatchSize(signature_runner, batch_size, error_reporter) !=
+        kTfLiteOk) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Failed to prepare signature '%s' for batch size "
+                           "%d.",
+                           signature_key, batch_size);
+      return nullptr;
+    }
+    runner->runners_.push_back(signature_runner);
+    runner->interpreters_.push_back(std::move(interpreter));
+  }
+  runner->batch_sizes_ = std::move(batch_sizes);
+  return runner;
+}
+
+int BatchBucketedSignatureRunner::GetBucketBatchSize(int batch_size) const {
+  auto it =
+      std::lower_bound(batch_sizes_.begin(), batch_sizes_.end(), batch_size);
+  return it == batch_sizes_.end() ? -1 : *it;
+}
+
+SignatureRunner* BatchBucketedSignatureRunner::GetRunner(int batch_size) {
+  auto it =
+      std::lower_bound(batch_sizes_.begin(), batch_sizes_.end(), batch_size);
+  if (it == batch_sizes_.end()) return nullptr;
+  return runners_[it - batch_sizes_.begin()];
+}
+
+}  // namespace tflite
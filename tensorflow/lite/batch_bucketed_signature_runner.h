@@ -0,0 +1,109 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_BATCH_BUCKETED_SIGNATURE_RUNNER_H_
+#define TENSORFLOW_LITE_BATCH_BUCKETED_SIGNATURE_RUNNER_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace tflite {
+
+/// WARNING: Experimental interface, subject to change
+///
+/// Runs a signature of a model with a batch size that changes between calls
+/// without resizing and re-preparing the model on every change.
+///
+/// Resizing the inputs of a SignatureRunner and allocating its tensors again
+/// runs `Prepare` on every node and plans the arena again. Instead, this class
+/// prepares the signature ahead of time for a fixed set of batch sizes, the
+/// buckets, each in its own Interpreter built from the same FlatBufferModel.
+/// The constant tensors point into the shared model, so each bucket only adds
+/// its own arena. Picking the runner of a batch size is then a lookup:
+///
+/// <pre><code>
+/// BatchBucketedSignatureRunner::Options options;
+/// options.batch_sizes = {1, 8, 32};
+/// auto runner = BatchBucketedSignatureRunner::Create(
+///     *model, resolver, "serving_default", options);
+/// ...
+/// // The runner of the smallest bucket holding 5 examples, i.e. 8.
+/// SignatureRunner* bucket = runner->GetRunner(5);
+/// // Fill the first 5 examples of the inputs, and pad the other 3.
+/// bucket->Invoke();
+/// </code></pre>
+///
+/// Dimension 0 of every input of the signature is taken to be the batch
+/// dimension. Delegates applied with `Options::configure_interpreter` see
+/// static shapes, so no delegate support is needed.
+///
+/// WARNING: This class is *not* thread-safe, like SignatureRunner.
+class BatchBucketedSignatureRunner {
+ public:
+  struct Options {
+    /// The batch sizes to prepare the signature for. Must not be empty.
+    std::vector<int> batch_sizes;
+    /// Number of threads used by each interpreter, see
+    /// InterpreterBuilder::SetNumThreads().
+    int num_threads = 1;
+    /// If set, called on each interpreter once it's built and before its
+    /// inputs are resized, e.g. to apply delegates. The interpreter should
+    /// take ownership of the delegates applied to it.
+    std::function<TfLiteStatus(Interpreter*)> configure_interpreter;
+  };
+
+  /// Builds an interpreter of `model` for each of `options.batch_sizes` and
+  /// allocates the tensors of its `signature_key` runner with that batch
+  /// size. Returns null on failure, reporting the error to the error reporter
+  /// of `model`. The model must outlive the returned object.
+  static std::unique_ptr<BatchBucketedSignatureRunner> Create(
+      const FlatBufferModel& model, const OpResolver& op_resolver,
+      const char* signature_key, const Options& options);
+
+  BatchBucketedSignatureRunner(const BatchBucketedSignatureRunner&) = delete;
+  BatchBucketedSignatureRunner& operator=(const BatchBucketedSignatureRunner&) =
+      delete;
+
+  /// The batch sizes of the buckets, in increasing order.
+  const std::vector<int>& batch_sizes() const { return batch_sizes_; }
+
+  /// Returns the batch size of the smallest bucket holding `batch_size`
+  /// examples, or -1 if `batch_size` is larger than every bucket.
+  int GetBucketBatchSize(int batch_size) const;
+
+  /// Returns the runner of the smallest bucket holding `batch_size` examples,
+  /// whose inputs and outputs have the batch size of the bucket, or null if
+  /// `batch_size` is larger than every bucket. The runner remains owned by
+  /// this object.
+  SignatureRunner* GetRunner(int batch_size);
+
+ private:
+  BatchBucketedSignatureRunner() = default;
+
+  // Sorted and without duplicates, matching `interpreters_` and `runners_`.
+  std::vector<int> batch_sizes_;
+  std::vector<std::unique_ptr<Interpreter>> interpreters_;
+  std::vector<SignatureRunner*> runners_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_BATCH_BUCKETED_SIGNATURE_RUNNER_H_
@@ -0,0 +1,95 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/batch_bucketed_signature_runner.h"
+
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAre;
+
+class BatchBucketedSignatureRunnerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    model_ = FlatBufferModel::BuildFromFile(
+        "tensorflow/lite/testdata/multi_signatures.bin", &reporter_);
+    ASSERT_TRUE(model_);
+  }
+
+  std::unique_ptr<BatchBucketedSignatureRunner> Create(
+      const std::vector<int>& batch_sizes) {
+    BatchBucketedSignatureRunner::Options options;
+    options.batch_sizes = batch_sizes;
+    return BatchBucketedSignatureRunner::Create(*model_, resolver_, "add",
+                                                options);
+  }
+
+  TestErrorReporter reporter_;
+  std::unique_ptr<FlatBufferModel> model_;
+  ops::builtin::BuiltinOpResolver resolver_;
+};
+
+TEST_F(BatchBucketedSignatureRunnerTest, InvalidOptions) {
+  EXPECT_EQ(Create({}), nullptr);
+  EXPECT_EQ(Create({0, 4}), nullptr);
+  BatchBucketedSignatureRunner::Options options;
+  options.batch_sizes = {1};
+  EXPECT_EQ(BatchBucketedSignatureRunner::Create(*model_, resolver_, "dummy",
+                                                 options),
+            nullptr);
+}
+
+TEST_F(BatchBucketedSignatureRunnerTest, PicksSmallestBucket) {
+  std::unique_ptr<BatchBucketedSignatureRunner> runner = Create({8, 1, 4, 4});
+  ASSERT_NE(runner, nullptr);
+  EXPECT_THAT(runner->batch_sizes(), ElementsAre(1, 4, 8));
+  EXPECT_EQ(runner->GetBucketBatchSize(1), 1);
+  EXPECT_EQ(runner->GetBucketBatchSize(2), 4);
+  EXPECT_EQ(runner->GetBucketBatchSize(8), 8);
+  EXPECT_EQ(runner->GetBucketBatchSize(9), -1);
+  EXPECT_EQ(runner->GetRunner(9), nullptr);
+  EXPECT_EQ(runner->GetRunner(2), runner->GetRunner(4));
+  EXPECT_NE(runner->GetRunner(4), runner->GetRunner(5));
+}
+
+TEST_F(BatchBucketedSignatureRunnerTest, RunsEachBucket) {
+  std::unique_ptr<BatchBucketedSignatureRunner> runner = Create({1, 4, 8});
+  ASSERT_NE(runner, nullptr);
+  // Switching between buckets back and forth needs no new allocation.
+  for (int batch_size : {3, 1, 8, 3}) {
+    SignatureRunner* bucket = runner->GetRunner(batch_size);
+    ASSERT_NE(bucket, nullptr);
+    TfLiteTensor* input = bucket->input_tensor("x");
+    const TfLiteTensor* output = bucket->output_tensor("output_0");
+    ASSERT_EQ(input->dims->data[0], runner->GetBucketBatchSize(batch_size));
+    ASSERT_EQ(output->dims->data[0], input->dims->data[0]);
+    for (int i = 0; i < batch_size; ++i) input->data.f[i] = i;
+    ASSERT_EQ(bucket->Invoke(), kTfLiteOk);
+    for (int i = 0; i < batch_size; ++i) {
+      EXPECT_EQ(output->data.f[i], i + 2);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace tflite
@@ -38,9 +38,11 @@ limitations under the License.
 #include "tensorflow/lite/core/api/tensor_utils.h"
 #include "tensorflow/lite/core/macros.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/memory_planner.h"
 #include "tensorflow/lite/minimal_logging.h"
+#include "tensorflow/lite/offline_arena_plan.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/util.h"
 #ifdef TFLITE_USE_SIMPLE_MEMORY_PLANNER
@@ -84,6 +86,12 @@ TfLiteStatus ReportOpError(TfLiteContext* context, const TfLiteNode& node,
   return kTfLiteError;
 }
 
+// While a stage of nodes runs in parallel, the subgraph running it and the CPU
+// backend context that the kernels run by the current thread must use.
+thread_local const Subgraph* parallel_worker_subgraph = nullptr;
+thread_local TfLiteExternalContext* parallel_worker_cpu_backend_context =
+    nullptr;
+
 // Stub method which returns kTfLiteError when the function is forbidden.
 // We're registering this function to several different function to save
 // compiled binary size. Please note the restrictions:
@@ -476,6 +484,9 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
 
 TfLiteExternalContext* Subgraph::GetExternalContext(
     TfLiteExternalContextType type) {
+  if (type == kTfLiteCpuBackendContext && parallel_worker_subgraph == this) {
+    return parallel_worker_cpu_backend_context;
+  }
   if (static_cast<int>(type) >= 0 && type < kTfLiteMaxExternalContexts) {
     return external_contexts_[type];
   }
@@ -1051,10 +1062,16 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
 #ifdef TFLITE_USE_SIMPLE_MEMORY_PLANNER
     memory_planner_.reset(new SimplePlanner(&context_, CreateGraphInfo()));
 #else
-    memory_planner_.reset(new ArenaPlanner(&context_, CreateGraphInfo(),
-                                           preserve_all_tensors_,
-                                           kDefaultTensorAlignment));
+    auto* arena_planner =
+        new ArenaPlanner(&context_, CreateGraphInfo(), preserve_all_tensors_,
+                         kDefaultTensorAlignment);
+    memory_planner_.reset(arena_planner);
+    OfflineArenaPlan offline_plan;
+    if (GetOfflineArenaPlan(&offline_plan)) {
+      arena_planner->SetOfflinePlan(std::move(offline_plan));
+    }
 #endif
+    TF_LITE_ENSURE_STATUS(PlanParallelExecution());
     memory_planner_->PlanAllocations();
   }
 
@@ -1123,6 +1140,18 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   return kTfLiteOk;
 }
 
+bool Subgraph::GetOfflineArenaPlan(OfflineArenaPlan* plan) const {
+  if (!metadata_ || !subgraphs_) return false;
+  auto it = metadata_->find(kOfflineArenaPlanMetadataName);
+  if (it == metadata_->end()) return false;
+  for (int i = 0; i < subgraphs_->size(); ++i) {
+    if ((*subgraphs_)[i].get() == this) {
+      return ParseOfflineArenaPlan(it->second, i, plan);
+    }
+  }
+  return false;
+}
+
 TfLiteStatus Subgraph::RemoveUnusedInputs() {
   auto graph_info = CreateGraphInfo();
   std::vector<int> refcounts(graph_info->num_tensors(), 0);
@@ -1168,6 +1197,10 @@ TfLiteStatus Subgraph::Invoke() {
   }
   TFLITE_SCOPED_TAGGED_DEFAULT_PROFILE(profiler_.get(), "Invoke");
 
+  if (CanInvokeInParallel()) {
+    return InvokeInParallel();
+  }
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -1188,37 +1221,7 @@ TfLiteStatus Subgraph::Invoke() {
     if (profiler_) op_name = GetTFLiteOpName(registration);
     TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(profiler_.get(), op_name, node_index);
 
-    for (int i = 0; i < node.inputs->size; ++i) {
-      int tensor_index = node.inputs->data[i];
-      if (tensor_index == kTfLiteOptionalTensor) {
-        continue;
-      }
-      TfLiteTensor* tensor = &tensors_[tensor_index];
-      if (tensor->delegate && tensor->delegate != node.delegate &&
-          tensor->data_is_stale) {
-        TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
-      }
-      if (tensor->data.raw == nullptr && tensor->bytes > 0) {
-        if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
-            tensor->dims->size != 1) {
-          // In general, having a tensor here with no buffer will be an error.
-          // However, for the reshape operator, the second input tensor is
-          // sometimes only used for the shape, not for the data. Thus, null
-          // buffer is ok in this situation.
-          // The situation where null buffer is not ok for reshape operator is
-          // only when there are 2 inputs given to the node and the one
-          // corresponding to the shape (i == 1) is a vector that contains all
-          // dimensions. See `GetOutputShape()` function in
-          // `tensorflow/lite/kernels/reshape.cc`
-          continue;
-        } else {
-          // In all other cases, we need to return an error as otherwise we will
-          // trigger a null pointer dereference (likely).
-          ReportError("Input tensor %d lacks data", tensor_index);
-          return kTfLiteError;
-        }
-      }
-    }
+    TF_LITE_ENSURE_STATUS(EnsureNodeInputsAreReadable(node_index));
 
     if (check_cancelled_func_ != nullptr &&
         check_cancelled_func_(cancellation_data_)) {
@@ -1259,6 +1262,226 @@ TfLiteStatus Subgraph::Invoke() {
   return status;
 }
 
+TfLiteStatus Subgraph::EnsureNodeInputsAreReadable(int node_index) {
+  const TfLiteNode& node = nodes_and_registration_[node_index].first;
+  const TfLiteRegistration& registration =
+      nodes_and_registration_[node_index].second;
+  for (int i = 0; i < node.inputs->size; ++i) {
+    int tensor_index = node.inputs->data[i];
+    if (tensor_index == kTfLiteOptionalTensor) {
+      continue;
+    }
+    TfLiteTensor* tensor = &tensors_[tensor_index];
+    if (tensor->delegate && tensor->delegate != node.delegate &&
+        tensor->data_is_stale) {
+      TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
+    }
+    if (tensor->data.raw == nullptr && tensor->bytes > 0) {
+      if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
+          tensor->dims->size != 1) {
+        // In general, having a tensor here with no buffer will be an error.
+        // However, for the reshape operator, the second input tensor is
+        // sometimes only used for the shape, not for the data. Thus, null
+        // buffer is ok in this situation.
+        // The situation where null buffer is not ok for reshape operator is
+        // only when there are 2 inputs given to the node and the one
+        // corresponding to the shape (i == 1) is a vector that contains all
+        // dimensions. See `GetOutputShape()` function in
+        // `tensorflow/lite/kernels/reshape.cc`
+        continue;
+      } else {
+        // In all other cases, we need to return an error as otherwise we will
+        // trigger a null pointer dereference (likely).
+        ReportError("Input tensor %d lacks data", tensor_index);
+        return kTfLiteError;
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+bool Subgraph::CanRunConcurrently(
+    const TfLiteNode& node, const TfLiteRegistration& registration) const {
+  if (node.delegate != nullptr || node.might_have_side_effect ||
+      registration.builtin_code == kTfLiteBuiltinCustom) {
+    return false;
+  }
+  // Variable tensors are updated in place, and tensors owned by a delegate
+  // may have to be copied back to the CPU before being read.
+  for (const TfLiteIntArray* tensor_indices : {node.inputs, node.outputs}) {
+    for (int i = 0; i < tensor_indices->size; ++i) {
+      const int tensor_index = tensor_indices->data[i];
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      const TfLiteTensor& tensor = tensors_[tensor_index];
+      if (tensor.is_variable || tensor.delegate != nullptr) return false;
+    }
+  }
+  return true;
+}
+
+TfLiteStatus Subgraph::PlanParallelExecution() {
+  parallel_stage_first_nodes_.clear();
+  max_parallel_stage_size_ = 0;
+  if (!parallel_execution_ || !memory_planner_) return kTfLiteOk;
+
+  // Nodes that can't run concurrently split the execution plan into segments.
+  // The nodes of a segment are ordered by stage, the stage of a node being one
+  // past the latest stage of the nodes of the segment producing its inputs, so
+  // that the nodes of a stage never depend on each other. A node that can't
+  // run concurrently forms a stage on its own.
+  std::vector<int> new_plan;
+  new_plan.reserve(execution_plan_.size());
+  std::vector<int> stage_first_nodes;
+  std::vector<int> producer_segment(tensors_.size(), -1);
+  std::vector<int> producer_stage(tensors_.size(), 0);
+  // Pairs of (stage, node index) of the nodes in the current segment.
+  std::vector<std::pair<int, int>> segment;
+  int segment_index = 0;
+  auto add_stage = [&]() { stage_first_nodes.push_back(new_plan.size()); };
+  auto end_segment = [&]() {
+    std::stable_sort(
+        segment.begin(), segment.end(),
+        [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+          return a.first < b.first;
+        });
+    for (int i = 0; i < segment.size(); ++i) {
+      if (i == 0 || segment[i].first != segment[i - 1].first) add_stage();
+      new_plan.push_back(segment[i].second);
+    }
+    segment.clear();
+    ++segment_index;
+  };
+  for (int node_index : execution_plan_) {
+    const TfLiteNode& node = nodes_and_registration_[node_index].first;
+    const TfLiteRegistration& registration =
+        nodes_and_registration_[node_index].second;
+    if (!CanRunConcurrently(node, registration)) {
+      end_segment();
+      add_stage();
+      new_plan.push_back(node_index);
+      continue;
+    }
+    int stage = 0;
+    for (int i = 0; i < node.inputs->size; ++i) {
+      const int tensor_index = node.inputs->data[i];
+      if (tensor_index != kTfLiteOptionalTensor &&
+          producer_segment[tensor_index] == segment_index) {
+        stage = std::max(stage, producer_stage[tensor_index] + 1);
+      }
+    }
+    for (int i = 0; i < node.outputs->size; ++i) {
+      const int tensor_index = node.outputs->data[i];
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      producer_segment[tensor_index] = segment_index;
+      producer_stage[tensor_index] = stage;
+    }
+    segment.emplace_back(stage, node_index);
+  }
+  end_segment();
+
+  int max_stage_size = 0;
+  for (int stage = 0; stage < stage_first_nodes.size(); ++stage) {
+    const int end = stage + 1 < stage_first_nodes.size()
+                        ? stage_first_nodes[stage + 1]
+                        : new_plan.size();
+    max_stage_size = std::max(max_stage_size, end - stage_first_nodes[stage]);
+  }
+
+  if (max_stage_size <= 1) {
+    // No two nodes can run at the same time, keep the original plan.
+    memory_planner_->SetConcurrentNodeGroups({});
+    return kTfLiteOk;
+  }
+  if (memory_planner_->SetConcurrentNodeGroups(stage_first_nodes) !=
+      kTfLiteOk) {
+    TFLITE_LOG(TFLITE_LOG_WARNING,
+               "The memory planner does not support parallel execution, nodes "
+               "will be invoked one at a time.");
+    return kTfLiteOk;
+  }
+  execution_plan_.swap(new_plan);
+  parallel_stage_first_nodes_ = std::move(stage_first_nodes);
+  max_parallel_stage_size_ = max_stage_size;
+  return kTfLiteOk;
+}
+
+bool Subgraph::CanInvokeInParallel() const {
+  // Kernels producing dynamic tensors resize them during Invoke(), and
+  // profilers aren't expected to be called from several threads.
+  return !parallel_stage_first_nodes_.empty() && !has_dynamic_tensors_ &&
+         next_execution_plan_index_to_prepare_ >= execution_plan_.size() &&
+         profiler_ == nullptr && context_.recommended_num_threads > 1;
+}
+
+TfLiteStatus Subgraph::InvokeInParallel() {
+  const int num_threads =
+      std::min(context_.recommended_num_threads, max_parallel_stage_size_);
+  if (!worker_pool_ || worker_pool_->num_threads() != num_threads) {
+    worker_pool_.reset(new WorkerPool(num_threads));
+  }
+  while (worker_cpu_backend_contexts_.size() < num_threads) {
+    worker_cpu_backend_contexts_.emplace_back(new ExternalCpuBackendContext());
+  }
+  // Nodes running at the same time share the threads of the subgraph, so that
+  // their kernels don't oversubscribe the CPU.
+  const int num_threads_per_node =
+      std::max(1, context_.recommended_num_threads / num_threads);
+
+  std::vector<TfLiteStatus> statuses(max_parallel_stage_size_);
+  const int num_stages = parallel_stage_first_nodes_.size();
+  for (int stage = 0; stage < num_stages; ++stage) {
+    const int first = parallel_stage_first_nodes_[stage];
+    const int end = stage + 1 < num_stages
+                        ? parallel_stage_first_nodes_[stage + 1]
+                        : execution_plan_.size();
+    for (int i = first; i < end; ++i) {
+      TF_LITE_ENSURE_STATUS(EnsureNodeInputsAreReadable(execution_plan_[i]));
+    }
+
+    if (check_cancelled_func_ != nullptr &&
+        check_cancelled_func_(cancellation_data_)) {
+      ReportError("Client requested cancel during Invoke()");
+      return kTfLiteError;
+    }
+
+    EnsureTensorsVectorCapacity();
+    if (end - first == 1) {
+      auto& node_and_reg = nodes_and_registration_[execution_plan_[first]];
+      statuses[0] = OpInvoke(node_and_reg.second, &node_and_reg.first);
+    } else {
+      for (auto& cpu_backend_context : worker_cpu_backend_contexts_) {
+        // The backend contexts are lazily created by the kernels.
+        if (cpu_backend_context->internal_backend_context()) {
+          cpu_backend_context->internal_backend_context()->SetMaxNumThreads(
+              num_threads_per_node);
+        }
+      }
+      worker_pool_->Run(end - first, [&](int task, int thread) {
+        parallel_worker_subgraph = this;
+        parallel_worker_cpu_backend_context =
+            worker_cpu_backend_contexts_[thread].get();
+        auto& node_and_reg =
+            nodes_and_registration_[execution_plan_[first + task]];
+        statuses[task] = OpInvoke(node_and_reg.second, &node_and_reg.first);
+        parallel_worker_subgraph = nullptr;
+        parallel_worker_cpu_backend_context = nullptr;
+      });
+    }
+
+    for (int i = first; i < end; ++i) {
+      const int node_index = execution_plan_[i];
+      const TfLiteNode& node = nodes_and_registration_[node_index].first;
+      if (statuses[i - first] != kTfLiteOk) {
+        return ReportOpError(&context_, node,
+                             nodes_and_registration_[node_index].second,
+                             node_index, "failed to invoke");
+      }
+      MaybeReleaseDynamicInputs(node, node_index);
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::ResizeTensor(TfLiteContext* context,
                                     TfLiteTensor* tensor,
                                     TfLiteIntArray* new_size) {
@@ -1668,6 +1891,7 @@ void Subgraph::EnsureTensorsVectorCapacity() {
 TfLiteStatus Subgraph::EnsureMemoryAllocations() {
   if (memory_planner_) {
     state_ = kStateUninvokable;
+    TF_LITE_ENSURE_OK(&context_, PlanParallelExecution());
     TF_LITE_ENSURE_OK(&context_, memory_planner_->PlanAllocations());
   }
   TF_LITE_ENSURE_OK(&context_, AllocateTensors());
@@ -1830,6 +2054,16 @@ void Subgraph::DumpMemoryPlannerDebugInfo() const {
   memory_planner_->DumpDebugInfo(execution_plan());
 }
 
+TfLiteStatus Subgraph::EnableParallelExecutionExperimental() {
+  if (memory_planner_) {
+    ReportError(
+        "EnableParallelExecutionExperimental called after memory was planned.");
+    return kTfLiteError;
+  }
+  parallel_execution_ = true;
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::PreserveAllTensorsExperimental() {
   if (memory_planner_) {
     ReportError(
@@ -32,9 +32,12 @@ limitations under the License.
 #include "tensorflow/lite/core/macros.h"
 #include "tensorflow/lite/experimental/resource/initialization_status.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/memory_planner.h"
+#include "tensorflow/lite/offline_arena_plan.h"
 #include "tensorflow/lite/util.h"
+#include "tensorflow/lite/worker_pool.h"
 
 namespace tflite {
 
@@ -377,6 +380,17 @@ class Subgraph {
     release_dynamic_tensors_if_unused_ = true;
   }
 
+  // WARNING: This is an experimental API and subject to change.
+  // Runs independent nodes of the execution plan concurrently in Invoke(),
+  // using up to `context()->recommended_num_threads` threads. The execution
+  // plan is reordered so that nodes which don't depend on each other are
+  // adjacent, and those nodes are then run at the same time. Delegated nodes,
+  // custom ops and ops with side effects always run alone, and the subgraph
+  // falls back to running one node at a time if it has dynamic tensors or a
+  // profiler. Running more nodes at once may increase the arena size. This API
+  // needs to be called before calling `AllocateTensors`.
+  TfLiteStatus EnableParallelExecutionExperimental();
+
   // WARNING: This is an experimental API and subject to change.
   // Remove unused inputs of the subgraph. It checks usage of inputs and mark it
   // as kTfLiteOptionalTensor if the input is not used in graph execution.
@@ -471,6 +485,31 @@ class Subgraph {
     return op_reg.invoke(&context_, node);
   }
 
+  // Returns true if the given node may run concurrently with other nodes.
+  bool CanRunConcurrently(const TfLiteNode& node,
+                          const TfLiteRegistration& registration) const;
+
+  // Reorders the execution plan into stages of nodes that don't depend on each
+  // other and declares the stages to the memory planner, if parallel execution
+  // is enabled. Must be called before the memory planner plans allocations.
+  TfLiteStatus PlanParallelExecution();
+
+  // Returns true if the next Invoke() can run the stages of the execution plan
+  // in parallel.
+  bool CanInvokeInParallel() const;
+
+  // Invokes the execution plan one stage at a time, running the nodes of each
+  // stage concurrently.
+  TfLiteStatus InvokeInParallel();
+
+  // Makes sure the inputs of the node at 'node_index' can be read by its
+  // kernel.
+  TfLiteStatus EnsureNodeInputsAreReadable(int node_index);
+
+  // Reads the offline plan of the kTfLiteArenaRw arena of this subgraph from
+  // the model metadata. Returns false if the model has no such plan.
+  bool GetOfflineArenaPlan(OfflineArenaPlan* plan) const;
+
   // Call OpPrepare() for as many ops as possible, allocating memory for their
   // tensors. If an op containing dynamic tensors is found, preparation will be
   // postponed until this function is called again. This allows the interpreter
@@ -860,6 +899,26 @@ class Subgraph {
   // Mapping between tensor index to the last index of the execution plan that
   // uses this tensor.
   std::map<int, int> tensor_to_last_op_index_;
+
+  // Whether independent nodes are run concurrently, see
+  // EnableParallelExecutionExperimental().
+  bool parallel_execution_ = false;
+
+  // Execution plan indices of the first node of each stage of nodes that can
+  // run concurrently. Empty if the plan is run one node at a time.
+  std::vector<int> parallel_stage_first_nodes_;
+
+  // Number of nodes of the largest stage in `parallel_stage_first_nodes_`.
+  int max_parallel_stage_size_ = 0;
+
+  // Threads running the nodes of a stage.
+  std::unique_ptr<WorkerPool> worker_pool_;
+
+  // CPU backend contexts used by the nodes running on each thread of
+  // `worker_pool_`, since a backend context can't be shared by concurrent
+  // kernels.
+  std::vector<std::unique_ptr<ExternalCpuBackendContext>>
+      worker_cpu_backend_contexts_;
 };
 
 }  // namespace tflite
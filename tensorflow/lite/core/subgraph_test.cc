@@ -60,5 +60,56 @@ TEST(RemoveUnusedInputs, HasUnusedInputs) {
   ASSERT_EQ(subgraph.inputs(), std::vector<int>({-1, -1, 2}));
 }
 
+TEST(ParallelExecution, RunsIndependentNodesInTheSameStage) {
+  Interpreter interpreter;
+  auto& subgraph = interpreter.primary_subgraph();
+  subgraph.AddTensors(4);
+  subgraph.SetInputs({0});
+  subgraph.SetOutputs({2, 3});
+  for (int i = 0; i < 4; ++i) {
+    subgraph.SetTensorParametersReadWrite(i, kTfLiteFloat32, "", {2},
+                                          TfLiteQuantization());
+  }
+  TfLiteRegistration* neg_op = tflite::ops::builtin::Register_NEG();
+  // Nodes 0 and 2 only depend on the input, node 1 depends on node 0.
+  subgraph.AddNodeWithParameters({0}, {1}, {}, nullptr, 0, nullptr, neg_op);
+  subgraph.AddNodeWithParameters({1}, {2}, {}, nullptr, 0, nullptr, neg_op);
+  subgraph.AddNodeWithParameters({0}, {3}, {}, nullptr, 0, nullptr, neg_op);
+
+  ASSERT_EQ(interpreter.SetNumThreads(2), kTfLiteOk);
+  ASSERT_EQ(interpreter.EnableParallelExecutionExperimental(), kTfLiteOk);
+  ASSERT_EQ(subgraph.AllocateTensors(), kTfLiteOk);
+  // The independent nodes are scheduled next to each other.
+  EXPECT_EQ(subgraph.execution_plan(), std::vector<int>({0, 2, 1}));
+  // Tensors used by nodes 0 and 2 can't share memory.
+  EXPECT_NE(subgraph.tensor(1)->data.raw, subgraph.tensor(3)->data.raw);
+
+  subgraph.tensor(0)->data.f[0] = 1.0f;
+  subgraph.tensor(0)->data.f[1] = -2.0f;
+  ASSERT_EQ(subgraph.Invoke(), kTfLiteOk);
+  EXPECT_THAT(std::vector<float>(subgraph.tensor(2)->data.f,
+                                 subgraph.tensor(2)->data.f + 2),
+              ::testing::ElementsAre(1.0f, -2.0f));
+  EXPECT_THAT(std::vector<float>(subgraph.tensor(3)->data.f,
+                                 subgraph.tensor(3)->data.f + 2),
+              ::testing::ElementsAre(-1.0f, 2.0f));
+}
+
+TEST(ParallelExecution, MustBeEnabledBeforeAllocation) {
+  Interpreter interpreter;
+  auto& subgraph = interpreter.primary_subgraph();
+  subgraph.AddTensors(2);
+  subgraph.SetInputs({0});
+  subgraph.SetOutputs({1});
+  for (int i = 0; i < 2; ++i) {
+    subgraph.SetTensorParametersReadWrite(i, kTfLiteFloat32, "", {2},
+                                          TfLiteQuantization());
+  }
+  TfLiteRegistration* neg_op = tflite::ops::builtin::Register_NEG();
+  subgraph.AddNodeWithParameters({0}, {1}, {}, nullptr, 0, nullptr, neg_op);
+  ASSERT_EQ(subgraph.AllocateTensors(), kTfLiteOk);
+  EXPECT_NE(subgraph.EnableParallelExecutionExperimental(), kTfLiteOk);
+}
+
 }  // namespace
 }  // namespace tflite
@@ -23,6 +23,7 @@ limitations under the License.
 #include <cstring>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "tensorflow/lite/delegates/gpu/cl/cl_command_queue.h"
 #include "tensorflow/lite/delegates/gpu/cl/cl_errors.h"
@@ -989,6 +990,14 @@ class InferenceEnvironmentImpl : public InferenceEnvironment {
     return data;
   }
 
+  std::string GetDeviceSignature() const final {
+    const OpenClInfo& info = environment_.device().GetInfo().opencl_info;
+    // The platform version carries the driver version, as in ProgramCache.
+    return absl::StrCat(info.vendor_name, ";", info.device_name, ";",
+                        info.opencl_c_version, ";",
+                        environment_.device().GetPlatformVersion());
+  }
+
   const InferenceEnvironmentProperties& properties() const {
     return properties_;
   }
@@ -24,6 +24,7 @@ limitations under the License.
 
 #include <cstdint>
 #include <memory>
+#include <string>
 
 #include "absl/types/span.h"
 #include "tensorflow/lite/delegates/gpu/api.h"
@@ -106,6 +107,12 @@ class InferenceEnvironment {
   // Returned data is valid only if used on the same device, otherwise it will
   // not be compatible and will be discarded.
   virtual std::vector<uint8_t> GetSerializedBinaryCache() const = 0;
+
+  // Returns a string that identifies the device and driver this environment
+  // runs on. Data produced by BuildSerializedModel and
+  // GetSerializedBinaryCache should only be reused by an environment with the
+  // same signature, so clients persisting such data should key it on this.
+  virtual std::string GetDeviceSignature() const = 0;
 };
 
 struct InferenceEnvironmentOptions {
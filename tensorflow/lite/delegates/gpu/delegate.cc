@@ -17,12 +17,14 @@ limitations under the License.
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/common.h"
@@ -52,6 +54,9 @@ using delegates::Serialization;
 using delegates::SerializationParams;
 
 constexpr char kSerializedDataPrefix[] = "gpuv2_data_";
+// Bump whenever the layout of the serialized data changes, so that entries
+// written by older versions of the delegate are not read back.
+constexpr int kSerializedDataVersion = 1;
 
 InferencePriority ToPriority(int32_t priority) {
   switch (priority) {
@@ -100,6 +105,10 @@ class Delegate {
       SerializationParams params;
       params.model_token = options->model_token;
       params.cache_dir = options->serialization_dir;
+      params.max_cache_size_bytes =
+          options->serialization_max_size_bytes > 0
+              ? options->serialization_max_size_bytes
+              : 0;
       serialization_.reset(new Serialization(params));
     }
   }
@@ -339,16 +348,18 @@ class DelegateKernel {
       RETURN_IF_ERROR(cl_environment_->NewInferenceBuilder(
           options, std::move(*graph), builder));
     } else {
+      // The environment is needed first, as serialized data is keyed on the
+      // device it runs on.
+      RETURN_IF_ERROR(cl::NewInferenceEnvironment(env_options, &cl_environment_,
+                                                  &properties));
       // If serialization data is found, initialize CL from it & return early.
+      // Data that fails to load (e.g. is corrupted) gets rebuilt below.
       if (MaybeInitializeSerializedOpenCL(context, delegate_params, builder,
-                                          &options, &env_options, &properties,
-                                          serialization)
+                                          options, serialization)
               .ok()) {
         return absl::OkStatus();
       }
 
-      RETURN_IF_ERROR(cl::NewInferenceEnvironment(env_options, &cl_environment_,
-                                                  &properties));
       *graph_is_destroyed = true;
       std::vector<uint8_t> serialized_model;
       RETURN_IF_ERROR(cl_environment_->BuildSerializedModel(
@@ -356,7 +367,7 @@ class DelegateKernel {
       RETURN_IF_ERROR(
           cl_environment_->NewInferenceBuilder(serialized_model, builder));
 
-      RETURN_IF_ERROR(SaveSerializedOpenCL(context, delegate_params, &options,
+      RETURN_IF_ERROR(SaveSerializedOpenCL(context, delegate_params, options,
                                            serialization, serialized_model));
     }
 
@@ -365,20 +376,29 @@ class DelegateKernel {
     return absl::OkStatus();
   }
 
-  // Returns Ok only if serialized data is successsfully found.
+  // Key for the serialized data of this kernel. Besides the model token &
+  // partition that Serialization accounts for, the data is only valid for the
+  // same data version, InferenceOptions, and device & driver.
+  std::string GetSerializationKey(const cl::InferenceOptions& options) const {
+    const std::string options_fingerprint =
+        delegates::StrFingerprint(&options, sizeof(cl::InferenceOptions));
+    const std::string device_signature =
+        cl_environment_->GetDeviceSignature();
+    return absl::StrCat(kSerializedDataPrefix, kSerializedDataVersion, "_",
+                        options_fingerprint, "_",
+                        delegates::StrFingerprint(device_signature.data(),
+                                                  device_signature.size()));
+  }
+
+  // Returns Ok only if serialized data is successsfully found & loaded into
+  // cl_environment_.
   absl::Status MaybeInitializeSerializedOpenCL(
       TfLiteContext* context, const TfLiteDelegateParams* delegate_params,
-      std::unique_ptr<InferenceBuilder>* builder, cl::InferenceOptions* options,
-      cl::InferenceEnvironmentOptions* env_options,
-      cl::InferenceEnvironmentProperties* properties,
-      Serialization* serialization) {
+      std::unique_ptr<InferenceBuilder>* builder,
+      const cl::InferenceOptions& options, Serialization* serialization) {
     if (!serialization) return absl::InvalidArgumentError("No serialization");
-    // We use a fingerprint of the options to ensure compatibility.
-    std::string options_fingerprint =
-        delegates::StrFingerprint(options, sizeof(cl::InferenceOptions));
     auto data_key = serialization->GetEntryForKernel(
-        std::string(kSerializedDataPrefix) + options_fingerprint, context,
-        delegate_params);
+        GetSerializationKey(options), context, delegate_params);
 
     std::string model_data;
     auto model_data_status = data_key.GetData(context, &model_data);
@@ -386,8 +406,6 @@ class DelegateKernel {
       absl::Span<const uint8_t> model_span = absl::Span<const uint8_t>{
           reinterpret_cast<const uint8_t*>(model_data.data()),
           model_data.size()};
-      RETURN_IF_ERROR(cl::NewInferenceEnvironment(
-          *env_options, &cl_environment_, properties));
       RETURN_IF_ERROR(
           cl_environment_->NewInferenceBuilder(model_span, builder));
       TFLITE_LOG_PROD_ONCE(
@@ -402,17 +420,11 @@ class DelegateKernel {
   // Returns Ok only if serialization happens successfully.
   absl::Status SaveSerializedOpenCL(
       TfLiteContext* context, const TfLiteDelegateParams* delegate_params,
-      cl::InferenceOptions* options, Serialization* serialization,
+      const cl::InferenceOptions& options, Serialization* serialization,
       const std::vector<uint8_t>& serialized_model) {
     if (!serialization) return absl::InvalidArgumentError("No serialization");
-    // We use a fingerprint of the options to ensure compatibility.
-    std::string options_fingerprint =
-        delegates::StrFingerprint(options, sizeof(cl::InferenceOptions));
-
-    // Save data.
     auto data_key = serialization->GetEntryForKernel(
-        std::string(kSerializedDataPrefix) + options_fingerprint, context,
-        delegate_params);
+        GetSerializationKey(options), context, delegate_params);
     auto save_status = data_key.SetData(
         context, reinterpret_cast<const char*>(serialized_model.data()),
         serialized_model.size());
@@ -565,6 +577,7 @@ TfLiteGpuDelegateOptionsV2 TfLiteGpuDelegateOptionsV2Default() {
   options.max_delegated_partitions = 1;
   options.model_token = nullptr;
   options.serialization_dir = nullptr;
+  options.serialization_max_size_bytes = 0;
   return options;
 }
 
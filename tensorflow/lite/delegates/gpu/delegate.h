@@ -131,6 +131,14 @@ typedef struct {
   // Set to nullptr in TfLiteGpuDelegateOptionsV2Default(), which implies the
   // delegate will not try serialization.
   const char* model_token;
+
+  // Upper bound on the disk space used by serialized data in
+  // serialization_dir, across all model tokens. When it is exceeded, the least
+  // recently used entries are removed. Entries are keyed on the model token,
+  // the delegate options and the GPU & driver version, so stale entries of
+  // e.g. a previous driver are the ones evicted first.
+  // Set to 0 in TfLiteGpuDelegateOptionsV2Default(), which implies no bound.
+  int64_t serialization_max_size_bytes;
 } TfLiteGpuDelegateOptionsV2;
 
 // Populates TfLiteGpuDelegateOptionsV2 as follows:
@@ -141,6 +149,7 @@ typedef struct {
 //   priority3 = TFLITE_GPU_INFERENCE_PRIORITY_AUTO
 //   experimental_flags = TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_QUANT
 //   max_delegated_partitions = 1
+//   serialization_max_size_bytes = 0
 TFL_CAPI_EXPORT TfLiteGpuDelegateOptionsV2 TfLiteGpuDelegateOptionsV2Default();
 
 // Creates a new delegate instance that need to be destroyed with
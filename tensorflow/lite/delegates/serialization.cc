@@ -18,9 +18,11 @@ limitations under the License.
 #include <fstream>
 #include <iostream>
 #else
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <sys/file.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <cstring>
@@ -70,6 +72,62 @@ inline std::string GetFilePath(const std::string& cache_dir,
   return JoinPath(cache_dir, file_name);
 }
 
+#if !defined(_WIN32)
+// Removes the least recently modified entries of `cache_dir` until the total
+// size of the entries is at most `max_size_bytes`. The entry at `keep_path` is
+// never removed, even if it alone exceeds the bound.
+void TrimCacheDir(const std::string& cache_dir, const std::string& keep_path,
+                  const size_t max_size_bytes) {
+  DIR* dir = opendir(cache_dir.c_str());
+  if (!dir) return;
+  struct CacheFile {
+    std::string path;
+    time_t mtime;
+    size_t size;
+  };
+  std::vector<CacheFile> files;
+  size_t total_size = 0;
+  static const char kSuffix[] = ".bin";
+  const size_t suffix_len = sizeof(kSuffix) - 1;
+  while (struct dirent* dir_entry = readdir(dir)) {
+    // Only consider files named like GetFilePath() outputs; temp files of
+    // in-flight writes don't have the suffix.
+    const std::string name = dir_entry->d_name;
+    if (name.size() <= suffix_len ||
+        name.compare(name.size() - suffix_len, suffix_len, kSuffix) != 0 ||
+        name.find('_') == std::string::npos) {
+      continue;
+    }
+    CacheFile file;
+    file.path = JoinPath(cache_dir, name);
+    struct stat file_stat;
+    if (stat(file.path.c_str(), &file_stat) != 0 ||
+        !S_ISREG(file_stat.st_mode)) {
+      continue;
+    }
+    file.mtime = file_stat.st_mtime;
+    file.size = file_stat.st_size;
+    total_size += file.size;
+    if (file.path != keep_path) files.push_back(std::move(file));
+  }
+  closedir(dir);
+  if (total_size <= max_size_bytes) return;
+
+  std::sort(files.begin(), files.end(),
+            [](const CacheFile& a, const CacheFile& b) {
+              return a.mtime != b.mtime ? a.mtime < b.mtime : a.path < b.path;
+            });
+  for (const CacheFile& file : files) {
+    if (total_size <= max_size_bytes) break;
+    if (unlink(file.path.c_str()) == 0) {
+      total_size -= file.size;
+      TFLITE_LOG(TFLITE_LOG_INFO, "Evicted serialized data %s (%d B)",
+                 file.path.c_str(), file.size);
+    }
+  }
+}
+#endif  // !defined(_WIN32)
+
 }  // namespace
 
 std::string StrFingerprint(const void* data, const size_t num_bytes) {
@@ -79,10 +137,12 @@ std::string StrFingerprint(const void* data, const size_t num_bytes) {
 
 SerializationEntry::SerializationEntry(const std::string& cache_dir,
                                        const std::string& model_token,
-                                       const uint64_t fingerprint)
+                                       const uint64_t fingerprint,
+                                       const size_t max_cache_size_bytes)
     : cache_dir_(cache_dir),
       model_token_(model_token),
-      fingerprint_(fingerprint) {}
+      fingerprint_(fingerprint),
+      max_cache_size_bytes_(max_cache_size_bytes) {}
 
 TfLiteStatus SerializationEntry::SetData(TfLiteContext* context,
                                          const char* data,
@@ -149,6 +209,9 @@ TfLiteStatus SerializationEntry::SetData(TfLiteContext* context,
                        filepath.c_str(), std::strerror(errno));
     return kTfLiteDelegateDataWriteError;
   }
+  if (max_cache_size_bytes_ > 0) {
+    TrimCacheDir(cache_dir_, filepath, max_cache_size_bytes_);
+  }
 #endif  // defined(_WIN32)
 
   TFLITE_LOG(TFLITE_LOG_INFO, "Wrote serialized data for model %s (%d B) to %s",
@@ -198,6 +261,9 @@ TfLiteStatus SerializationEntry::GetData(TfLiteContext* context,
     int bytes_read = read(fd, buffer, 512);
     if (bytes_read == 0) {
       // EOF
+      // Refresh the modification time, which TrimCacheDir uses to track how
+      // recently an entry was used.
+      if (max_cache_size_bytes_ > 0) futimens(fd, nullptr);
       close(fd);
       return kTfLiteOk;
     } else if (bytes_read < 0) {
@@ -288,7 +354,8 @@ SerializationEntry Serialization::GetEntryImpl(
 
   // Get a fingerprint-specific lock that is passed to the SerializationKey, to
   // ensure noone else gets access to an equivalent SerializationKey.
-  return SerializationEntry(cache_dir_, model_token_, fingerprint);
+  return SerializationEntry(cache_dir_, model_token_, fingerprint,
+                            max_cache_size_bytes_);
 }
 
 TfLiteStatus SaveDelegatedNodes(TfLiteContext* context,
@@ -36,6 +36,8 @@ limitations under the License.
 // params.model_token = options->model_token;
 // // Location where data is stored, should be private to the app using this.
 // params.serialization_dir = options->serialization_dir;
+// // Optional: bounds the disk space used by all entries in the directory.
+// params.max_cache_size_bytes = options->serialization_max_size_bytes;
 // Serialization serialization(params);
 //
 // Writing data
@@ -127,7 +129,8 @@ class SerializationEntry {
  protected:
   SerializationEntry(const std::string& cache_dir,
                      const std::string& model_token,
-                     const uint64_t fingerprint_64);
+                     const uint64_t fingerprint_64,
+                     const size_t max_cache_size_bytes = 0);
 
   // Caching directory.
   const std::string cache_dir_;
@@ -135,6 +138,8 @@ class SerializationEntry {
   const std::string model_token_;
   // For most applications, 64-bit fingerprints are enough.
   const uint64_t fingerprint_ = 0;
+  // See SerializationParams::max_cache_size_bytes.
+  const size_t max_cache_size_bytes_ = 0;
 };
 
 // Encapsulates all the data that clients can use to parametrize a Serialization
@@ -154,6 +159,14 @@ typedef struct SerializationParams {
   // On Android, `getCodeCacheDir()` is recommended.
   // Required.
   const char* cache_dir;
+  // Upper bound on the total size of the data stored in `cache_dir`.
+  // Whenever an entry is written, the least recently used entries of the
+  // directory (for any model token) are removed until the remaining ones fit.
+  // Entries count as used when they are written or successfully read.
+  // 0 implies no bound.
+  //
+  // NOTE: Only enforced on POSIX systems.
+  size_t max_cache_size_bytes = 0;
 } SerializationParams;
 
 // Utility to enable caching abilities for delegates.
@@ -164,7 +177,9 @@ class Serialization {
  public:
   // Initialize a Serialization interface for applicable delegates.
   explicit Serialization(const SerializationParams& params)
-      : cache_dir_(params.cache_dir), model_token_(params.model_token) {}
+      : cache_dir_(params.cache_dir),
+        model_token_(params.model_token),
+        max_cache_size_bytes_(params.max_cache_size_bytes) {}
 
   // Generate a SerializationEntry that incorporates both `custom_key` &
   // `context` into its unique fingerprint.
@@ -199,6 +214,7 @@ class Serialization {
 
   const std::string cache_dir_;
   const std::string model_token_;
+  const size_t max_cache_size_bytes_;
 };
 
 // Helper for delegates to save their delegation decisions (which nodes to
@@ -14,6 +14,11 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/delegates/serialization.h"
 
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <utime.h>
+#endif  // !defined(_WIN32)
+
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -367,6 +372,57 @@ TEST_F(SerializationTest, CachingDelegatedNodes) {
   TfLiteIntArrayFree(empty_nodes_array);
 }
 
+#if !defined(_WIN32)
+TEST_F(SerializationTest, BoundedCacheSize) {
+  const float value = 789.12;
+  const std::string model_token = "model2";
+  // Use a dedicated directory, since eviction considers all of its entries.
+  const std::string test_dir = getSerializationDir() + "/bounded_cache";
+  mkdir(test_dir.c_str(), 0700);
+  TfLiteContext context = GenerateTfLiteContext(/*num_tensors*/ 10);
+
+  SerializationParams serialization_params = {model_token.c_str(),
+                                              test_dir.c_str()};
+  // Room for three entries.
+  serialization_params.max_cache_size_bytes = 3 * sizeof(value);
+  Serialization serialization(serialization_params);
+  auto set_mtime = [&](const SerializationEntry& entry, time_t mtime) {
+    const std::string path = test_dir + "/" + model_token + "_" +
+                             std::to_string(entry.GetFingerprint()) + ".bin";
+    struct utimbuf times = {mtime, mtime};
+    ASSERT_EQ(utime(path.c_str(), &times), 0);
+  };
+
+  auto entry1 = serialization.GetEntryForDelegate("entry1", &context);
+  auto entry2 = serialization.GetEntryForDelegate("entry2", &context);
+  auto entry3 = serialization.GetEntryForDelegate("entry3", &context);
+  auto entry4 = serialization.GetEntryForDelegate("entry4", &context);
+  for (const auto* entry : {&entry1, &entry2, &entry3}) {
+    ASSERT_EQ(entry->SetData(&context, reinterpret_cast<const char*>(&value),
+                             sizeof(value)),
+              kTfLiteOk);
+  }
+  set_mtime(entry1, 100);
+  set_mtime(entry2, 200);
+  set_mtime(entry3, 300);
+
+  // Reading entry1 makes entry2 the least recently used one, which gets evicted
+  // to make room for entry4.
+  std::string read_back;
+  ASSERT_EQ(entry1.GetData(&context, &read_back), kTfLiteOk);
+  ASSERT_EQ(entry4.SetData(&context, reinterpret_cast<const char*>(&value),
+                           sizeof(value)),
+            kTfLiteOk);
+
+  EXPECT_EQ(entry1.GetData(&context, &read_back), kTfLiteOk);
+  EXPECT_EQ(entry2.GetData(&context, &read_back), kTfLiteDelegateDataNotFound);
+  EXPECT_EQ(entry3.GetData(&context, &read_back), kTfLiteOk);
+  EXPECT_EQ(entry4.GetData(&context, &read_back), kTfLiteOk);
+  ASSERT_EQ(read_back.size(), sizeof(value));
+  EXPECT_FLOAT_EQ(*reinterpret_cast<const float*>(read_back.data()), value);
+}
+#endif  // !defined(_WIN32)
+
 }  // namespace
 }  // namespace delegates
 }  // namespace tflite
@@ -19,8 +19,10 @@ limitations under the License.
 #include <array>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <numeric>
 #include <random>
+#include <utility>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -52,6 +54,11 @@ std::vector<int32_t> FullyConnectedTester::OutputShape() const {
 }
 
 void FullyConnectedTester::Test(TfLiteDelegate* delegate) const {
+  Test(std::vector<TfLiteDelegate*>{delegate});
+}
+
+void FullyConnectedTester::Test(
+    const std::vector<TfLiteDelegate*>& delegates) const {
   std::random_device random_device;
   auto rng = std::mt19937(random_device());
   auto input_rng =
@@ -60,13 +67,6 @@ void FullyConnectedTester::Test(TfLiteDelegate* delegate) const {
   std::vector<char> buffer = CreateTfLiteModel();
   const Model* model = GetModel(buffer.data());
 
-  std::unique_ptr<Interpreter> delegate_interpreter;
-  ASSERT_EQ(
-      InterpreterBuilder(
-          model,
-          ::tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates())(
-          &delegate_interpreter),
-      kTfLiteOk);
   std::unique_ptr<Interpreter> default_interpreter;
   ASSERT_EQ(
       InterpreterBuilder(
@@ -74,42 +74,54 @@ void FullyConnectedTester::Test(TfLiteDelegate* delegate) const {
           ::tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates())(
           &default_interpreter),
       kTfLiteOk);
-
-  ASSERT_TRUE(delegate_interpreter);
   ASSERT_TRUE(default_interpreter);
-
-  ASSERT_EQ(delegate_interpreter->inputs().size(), 1);
   ASSERT_EQ(default_interpreter->inputs().size(), 1);
-
-  ASSERT_EQ(delegate_interpreter->outputs().size(), 1);
   ASSERT_EQ(default_interpreter->outputs().size(), 1);
-
-  ASSERT_EQ(delegate_interpreter->AllocateTensors(), kTfLiteOk);
   ASSERT_EQ(default_interpreter->AllocateTensors(), kTfLiteOk);
 
-  ASSERT_EQ(delegate_interpreter->ModifyGraphWithDelegate(delegate), kTfLiteOk);
+  // All the delegate interpreters are alive at the same time, as they would be
+  // when sharing the weights of the model.
+  std::vector<std::unique_ptr<Interpreter>> delegate_interpreters;
+  for (TfLiteDelegate* delegate : delegates) {
+    std::unique_ptr<Interpreter> delegate_interpreter;
+    ASSERT_EQ(
+        InterpreterBuilder(
+            model,
+            ::tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates())(
+            &delegate_interpreter),
+        kTfLiteOk);
+    ASSERT_TRUE(delegate_interpreter);
+    ASSERT_EQ(delegate_interpreter->inputs().size(), 1);
+    ASSERT_EQ(delegate_interpreter->outputs().size(), 1);
+    ASSERT_EQ(delegate_interpreter->AllocateTensors(), kTfLiteOk);
+    ASSERT_EQ(delegate_interpreter->ModifyGraphWithDelegate(delegate),
+              kTfLiteOk);
+    delegate_interpreters.push_back(std::move(delegate_interpreter));
+  }
 
   float* default_input_data = default_interpreter->typed_input_tensor<float>(0);
   std::generate(default_input_data, default_input_data + InputSize(),
                 std::ref(input_rng));
-
-  float* delegate_input_data =
-      delegate_interpreter->typed_input_tensor<float>(0);
-  std::copy(default_input_data, default_input_data + InputSize(),
-            delegate_input_data);
-
   ASSERT_EQ(default_interpreter->Invoke(), kTfLiteOk);
-  ASSERT_EQ(delegate_interpreter->Invoke(), kTfLiteOk);
-
   float* default_output_data =
       default_interpreter->typed_output_tensor<float>(0);
-  float* delegate_output_data =
-      delegate_interpreter->typed_output_tensor<float>(0);
 
-  for (size_t i = 0; i < ComputeSize(OutputShape()); i++) {
-    ASSERT_NEAR(default_output_data[i], delegate_output_data[i],
-                std::numeric_limits<float>::epsilon() *
-                    std::max(std::abs(default_output_data[i]) * 10.0f, 1.0f));
+  for (const auto& delegate_interpreter : delegate_interpreters) {
+    float* delegate_input_data =
+        delegate_interpreter->typed_input_tensor<float>(0);
+    std::copy(default_input_data, default_input_data + InputSize(),
+              delegate_input_data);
+
+    ASSERT_EQ(delegate_interpreter->Invoke(), kTfLiteOk);
+
+    float* delegate_output_data =
+        delegate_interpreter->typed_output_tensor<float>(0);
+
+    for (size_t i = 0; i < ComputeSize(OutputShape()); i++) {
+      ASSERT_NEAR(default_output_data[i], delegate_output_data[i],
+                  std::numeric_limits<float>::epsilon() *
+                      std::max(std::abs(default_output_data[i]) * 10.0f, 1.0f));
+    }
   }
 }
 
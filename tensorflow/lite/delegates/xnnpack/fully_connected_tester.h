@@ -112,6 +112,10 @@ class FullyConnectedTester {
 
   void Test(TfLiteDelegate* delegate) const;
 
+  // Same as above but applies each delegate to a different interpreter of the
+  // same model.
+  void Test(const std::vector<TfLiteDelegate*>& delegates) const;
+
  private:
   std::vector<char> CreateTfLiteModel() const;
 
@@ -19,9 +19,13 @@ limitations under the License.
 #include <array>
 #include <cstdint>
 #include <cstring>
+#include <iterator>
 #include <limits>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -38,6 +42,33 @@ limitations under the License.
 #include "tensorflow/lite/kernels/padding.h"
 #include "tensorflow/lite/minimal_logging.h"
 
+struct TfLiteXNNPackDelegateWeightsCache {
+  // Identifies the data unpacked from a static buffer, e.g. by dequantizing it.
+  struct Key {
+    const void* packed_data;
+    size_t packed_bytes;
+    size_t unpacked_bytes;
+    int32_t builtin_code;
+    TfLiteType packed_type;
+    TfLiteType unpacked_type;
+    float scale;
+    int32_t zero_point;
+
+    bool operator<(const Key& other) const {
+      return std::tie(packed_data, packed_bytes, unpacked_bytes, builtin_code,
+                      packed_type, unpacked_type, scale, zero_point) <
+             std::tie(other.packed_data, other.packed_bytes,
+                      other.unpacked_bytes, other.builtin_code,
+                      other.packed_type, other.unpacked_type, other.scale,
+                      other.zero_point);
+    }
+  };
+
+  std::mutex mutex;
+  // Unpacked data, owned by the delegates using it.
+  std::map<Key, std::weak_ptr<const std::vector<char>>> unpacked_data;
+};
+
 namespace tflite {
 namespace xnnpack {
 namespace {
@@ -73,6 +104,16 @@ class Delegate {
   TfLiteIntArray* PrepareOpsToDelegate(TfLiteContext* context);
   TfLiteDelegate* tflite_delegate() { return &delegate_; }
 
+  // Drops the references to the unpacked data of quasi-static tensors once
+  // the delegate kernels, which keep the data they use, have been created.
+  // Unused data is then freed with the interpreter, and expires in the weights
+  // cache.
+  void ReleaseStaticUnpackedData() { static_unpacked_data_.clear(); }
+
+  TfLiteXNNPackDelegateWeightsCache* weights_cache() const {
+    return options_.weights_cache;
+  }
+
   pthreadpool_t threadpool() const {
 #if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
     return nullptr;
@@ -92,11 +133,13 @@ class Delegate {
   };
 
   // Unpacked data for quasi-static tensors, i.e. tensors produced by
-  // dequantizing or unpacking static buffers.
-  std::vector<char> static_unpacked_data_;
-  // Mapping from a tensor index for a quasi-static tensor to the offset to
-  // its unpacked data within static_unpacked_data_.
-  std::unordered_map<int, size_t> static_unpacked_data_map_;
+  // dequantizing or unpacking static buffers, until it is handed over to the
+  // delegate kernels. The buffers are shared with other delegates through the
+  // weights cache, if any.
+  std::vector<std::shared_ptr<const std::vector<char>>> static_unpacked_data_;
+  // Mapping from a tensor index for a quasi-static tensor to its unpacked data
+  // within static_unpacked_data_.
+  std::unordered_map<int, const char*> static_unpacked_data_map_;
   // Set of indices of nodes which unpack static data, e.g. Dequantize
   // operators which convert FP16 static weights to FP32. These nodes are simply
   // ignored in the delegate implementation, because their outputs are
@@ -440,7 +483,7 @@ class Subgraph {
         // Check for quasi-static data.
         const auto it = delegate->static_unpacked_data_map_.find(t);
         if (it != delegate->static_unpacked_data_map_.end()) {
-          data = delegate->static_unpacked_data_.data() + it->second;
+          data = it->second;
         }
       }
       if (inputs.count(t) != 0) {
@@ -502,7 +545,7 @@ class Subgraph {
 
     // Create a set of quasi-static tensors for VisitNode function
     std::unordered_set<int> quasi_static_tensors;
-    for (const std::pair<const int, size_t>& entry :
+    for (const std::pair<const int, const char*>& entry :
          delegate->static_unpacked_data_map_) {
       quasi_static_tensors.insert(entry.first);
     }
@@ -541,7 +584,8 @@ class Subgraph {
       return nullptr;
     }
 
-    return new Subgraph(runtime_ptr, std::move(externals));
+    return new Subgraph(runtime_ptr, std::move(externals),
+                        delegate->static_unpacked_data_);
   }
 
   TfLiteStatus Prepare(TfLiteContext* context) { return kTfLiteOk; }
@@ -1447,6 +1491,15 @@ class Subgraph {
         return VisitCeilNode(subgraph, logging_context, node_index, node,
                              context->tensors, xnnpack_tensors);
       case kTfLiteBuiltinConv2d: {
+        // Conv2D with sparse filter has version 6, which cannot be delegated
+        // to XNNPack.
+        if (registration->version == 6) {
+          TF_LITE_MAYBE_KERNEL_LOG(logging_context,
+                                   "Unsupported version %d of Conv2D.",
+                                   registration->version);
+          return kTfLiteError;
+        }
+
         const TfLiteConvParams* conv_params =
             static_cast<const TfLiteConvParams*>(node->builtin_data);
 
@@ -3720,8 +3773,12 @@ class Subgraph {
   }
 
  private:
-  Subgraph(xnn_runtime_t runtime, std::unordered_set<int>&& externals)
-      : runtime_(runtime, &xnn_delete_runtime), externals_(externals) {}
+  Subgraph(xnn_runtime_t runtime, std::unordered_set<int>&& externals,
+           std::vector<std::shared_ptr<const std::vector<char>>>
+               static_unpacked_data)
+      : runtime_(runtime, &xnn_delete_runtime),
+        externals_(externals),
+        static_unpacked_data_(std::move(static_unpacked_data)) {}
 
   // XNNPACK Runtime (subgraph + workspace) with smart-pointer for lifetime
   // management.
@@ -3730,18 +3787,133 @@ class Subgraph {
   // TFLite Tensor IDs == XNNPACK Value IDs of input/output tensors for the
   // delegated subgraph.
   std::unordered_set<int> externals_;
+  // Unpacked data for quasi-static tensors, which the runtime may reference.
+  std::vector<std::shared_ptr<const std::vector<char>>> static_unpacked_data_;
   // Memory location to use for 0-size extenal tensors, as TFLite init their
   // data pointer to nullptr, and XNNPACK requires valid data pointers.
   char dummy_data_{0};
   bool first_run_{true};
 };
 
+// Unpacks `packed_data`, the data of the input of the Dequantize or Densify
+// node at `producer_index`, into `unpacked_data`.
+TfLiteStatus UnpackStaticData(TfLiteContext* context,
+                              const TfLiteRegistration* registration,
+                              int producer_index,
+                              const TfLiteTensor& input_tensor,
+                              const TfLiteTensor& output_tensor,
+                              size_t tensor_elements, const char* packed_data,
+                              char* unpacked_data) {
+  switch (registration->builtin_code) {
+    case kTfLiteBuiltinDequantize: {
+      // Such a condition has been checked when preparing to unpack FP16/INT8
+      // tensors.
+      TFLITE_DCHECK(input_tensor.sparsity == nullptr);
+      // Actual data unpacking
+      switch (input_tensor.type) {
+        case kTfLiteFloat16:
+          DequantizeFloat16(reinterpret_cast<const uint16_t*>(packed_data),
+                            reinterpret_cast<float*>(unpacked_data),
+                            tensor_elements);
+          break;
+        case kTfLiteInt8: {
+          TfLiteAffineQuantization* quant_params =
+              static_cast<TfLiteAffineQuantization*>(
+                  input_tensor.quantization.params);
+          // Such conditions have been checked when preparing to unpack INT8
+          // tensors.
+          TFLITE_DCHECK(quant_params != nullptr &&
+                        quant_params->scale->size == 1);
+
+          DequantizeInt8(reinterpret_cast<const int8_t*>(packed_data),
+                         reinterpret_cast<float*>(unpacked_data),
+                         GetTensorShape(&input_tensor),
+                         input_tensor.params.zero_point,
+                         input_tensor.params.scale);
+          break;
+        }
+        default:
+          // This should not happen as we only allow FP16/INT8 input_tensor
+          // when preparing the unpacking.
+          TFLITE_DCHECK(false);
+      }
+      break;
+    }
+    case kTfLiteBuiltinDensify: {
+      // Such a condition has been checked when preparing to unpack FP16/INT8
+      // tensors.
+      TFLITE_DCHECK(input_tensor.sparsity != nullptr);
+      const int dims_count = output_tensor.dims->size;
+      std::vector<int> vector_shape(dims_count);
+      for (int i = 0; i < dims_count; i++) {
+        vector_shape[i] = output_tensor.dims->data[i];
+      }
+
+      switch (input_tensor.type) {
+        case kTfLiteFloat32: {
+          const size_t dense_size = output_tensor.bytes / sizeof(float);
+          float* unpacked_fp32_data = reinterpret_cast<float*>(unpacked_data);
+          tflite::internal::sparsity::FormatConverter<float> converter(
+              vector_shape, *input_tensor.sparsity);
+          converter.SparseToDense(
+              static_cast<const float*>(input_tensor.data.data), dense_size,
+              unpacked_fp32_data, context);
+          break;
+        }
+        case kTfLiteFloat16: {
+          const size_t dense_size =
+              output_tensor.bytes / sizeof(Eigen::half);
+          Eigen::half* unpacked_fp16_data =
+              reinterpret_cast<Eigen::half*>(unpacked_data);
+          tflite::internal::sparsity::FormatConverter<Eigen::half> converter(
+              vector_shape, *input_tensor.sparsity);
+          converter.SparseToDense(
+              static_cast<const Eigen::half*>(input_tensor.data.data),
+              dense_size, unpacked_fp16_data, context);
+          break;
+        }
+        case kTfLiteInt8: {
+          const size_t dense_size =
+              output_tensor.bytes / sizeof(int8_t);
+          int8_t* unpacked_int8_data =
+              reinterpret_cast<int8_t*>(unpacked_data);
+          tflite::internal::sparsity::FormatConverter<int8_t> converter(
+              vector_shape, *input_tensor.sparsity);
+          converter.SparseToDense(
+              static_cast<const int8_t*>(input_tensor.data.data), dense_size,
+              unpacked_int8_data, context);
+          break;
+        }
+        default: {
+          // This should not happen as we only allow FP16/INT8 input_tensor
+          // when preparing the unpacking.
+          TFLITE_DCHECK(false);
+        }
+      }
+      break;
+    }
+    default:
+      TF_LITE_KERNEL_LOG(context, "unexpected op registration %d at node %d",
+                         registration->builtin_code, producer_index);
+      return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
 TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
   // Clear previous data, in case the delegate is reused without re-creation.
   static_unpacked_data_map_.clear();
   static_unpacked_data_.clear();
   static_unpack_nodes_.clear();
   static_sparse_weights_.clear();
+  if (weights_cache() != nullptr) {
+    // Forget the data no delegate uses anymore, its buffer may be reused.
+    std::lock_guard<std::mutex> cache_lock(weights_cache()->mutex);
+    auto& unpacked_data = weights_cache()->unpacked_data;
+    for (auto it = unpacked_data.begin(); it != unpacked_data.end();) {
+      it = it->second.expired() ? unpacked_data.erase(it) : std::next(it);
+    }
+  }
 
   TfLiteIntArray* execution_plan = nullptr;
   if (context->GetExecutionPlan(context, &execution_plan) != kTfLiteOk) {
@@ -3952,114 +4124,46 @@ TfLiteIntArray* Delegate::PrepareOpsToDelegate(TfLiteContext* context) {
       }
     }
 
-    // Align to XNN_EXTRA_BYTES bytes
-    while (static_unpacked_data_.size() % XNN_EXTRA_BYTES != 0) {
-      static_unpacked_data_.push_back(0);
-    }
-    const size_t tensor_offset = static_unpacked_data_.size();
-    static_unpacked_data_.resize(tensor_offset + context->tensors[t].bytes);
-
-    char* unpacked_data = static_unpacked_data_.data() + tensor_offset;
     const char* packed_data =
         static_unpacked_input_it_ != static_unpacked_data_map_.end()
-            ? static_unpacked_data_.data() + static_unpacked_input_it_->second
+            ? static_unpacked_input_it_->second
             : static_cast<const char*>(input_tensor.data.data);
-    switch (registration->builtin_code) {
-      case kTfLiteBuiltinDequantize: {
-        // Such a condition has been checked when preparing to unpack FP16/INT8
-        // tensors.
-        TFLITE_DCHECK(input_tensor.sparsity == nullptr);
-        // Actual data unpacking
-        switch (input_tensor.type) {
-          case kTfLiteFloat16:
-            DequantizeFloat16(reinterpret_cast<const uint16_t*>(packed_data),
-                              reinterpret_cast<float*>(unpacked_data),
-                              tensor_elements);
-            break;
-          case kTfLiteInt8: {
-            TfLiteAffineQuantization* quant_params =
-                static_cast<TfLiteAffineQuantization*>(
-                    input_tensor.quantization.params);
-            // Such conditions have been checked when preparing to unpack INT8
-            // tensors.
-            TFLITE_DCHECK(quant_params != nullptr &&
-                          quant_params->scale->size == 1);
-
-            DequantizeInt8(reinterpret_cast<const int8_t*>(packed_data),
-                           reinterpret_cast<float*>(unpacked_data),
-                           GetTensorShape(&input_tensor),
-                           input_tensor.params.zero_point,
-                           input_tensor.params.scale);
-            break;
-          }
-          default:
-            // This should not happen as we only allow FP16/INT8 input_tensor
-            // when preparing the unpacking.
-            TFLITE_DCHECK(false);
-        }
-        break;
-      }
-      case kTfLiteBuiltinDensify: {
-        // Such a condition has been checked when preparing to unpack FP16/INT8
-        // tensors.
-        TFLITE_DCHECK(input_tensor.sparsity != nullptr);
-        const int dims_count = output_tensor.dims->size;
-        std::vector<int> vector_shape(dims_count);
-        for (int i = 0; i < dims_count; i++) {
-          vector_shape[i] = output_tensor.dims->data[i];
-        }
-
-        switch (input_tensor.type) {
-          case kTfLiteFloat32: {
-            const size_t dense_size = context->tensors[t].bytes / sizeof(float);
-            float* unpacked_fp32_data = reinterpret_cast<float*>(unpacked_data);
-            tflite::internal::sparsity::FormatConverter<float> converter(
-                vector_shape, *input_tensor.sparsity);
-            converter.SparseToDense(
-                static_cast<const float*>(input_tensor.data.data), dense_size,
-                unpacked_fp32_data, context);
-            break;
-          }
-          case kTfLiteFloat16: {
-            const size_t dense_size =
-                context->tensors[t].bytes / sizeof(Eigen::half);
-            Eigen::half* unpacked_fp16_data =
-                reinterpret_cast<Eigen::half*>(unpacked_data);
-            tflite::internal::sparsity::FormatConverter<Eigen::half> converter(
-                vector_shape, *input_tensor.sparsity);
-            converter.SparseToDense(
-                static_cast<const Eigen::half*>(input_tensor.data.data),
-                dense_size, unpacked_fp16_data, context);
-            break;
-          }
-          case kTfLiteInt8: {
-            const size_t dense_size =
-                context->tensors[t].bytes / sizeof(int8_t);
-            int8_t* unpacked_int8_data =
-                reinterpret_cast<int8_t*>(unpacked_data);
-            tflite::internal::sparsity::FormatConverter<int8_t> converter(
-                vector_shape, *input_tensor.sparsity);
-            converter.SparseToDense(
-                static_cast<const int8_t*>(input_tensor.data.data), dense_size,
-                unpacked_int8_data, context);
-            break;
-          }
-          default: {
-            // This should not happen as we only allow FP16/INT8 input_tensor
-            // when preparing the unpacking.
-            TFLITE_DCHECK(false);
-          }
-        }
-        break;
+    const TfLiteXNNPackDelegateWeightsCache::Key key = {
+        packed_data,
+        input_tensor.bytes,
+        output_tensor.bytes,
+        registration->builtin_code,
+        input_tensor.type,
+        output_tensor.type,
+        input_tensor.params.scale,
+        input_tensor.params.zero_point};
+    std::shared_ptr<const std::vector<char>> unpacked_buffer;
+    std::unique_lock<std::mutex> cache_lock;
+    if (weights_cache() != nullptr) {
+      cache_lock = std::unique_lock<std::mutex>(weights_cache()->mutex);
+      const auto cached_it = weights_cache()->unpacked_data.find(key);
+      if (cached_it != weights_cache()->unpacked_data.end()) {
+        unpacked_buffer = cached_it->second.lock();
       }
-      default:
-        TF_LITE_KERNEL_LOG(context, "unexpected op registration %d at node %d",
-                           registration->builtin_code, producer_index);
+    }
+    if (unpacked_buffer == nullptr) {
+      // XNNPACK may read up to XNN_EXTRA_BYTES bytes past the end of the data.
+      auto buffer = std::make_shared<std::vector<char>>(output_tensor.bytes +
+                                                        XNN_EXTRA_BYTES);
+      if (UnpackStaticData(context, registration, producer_index,
+                           input_tensor, output_tensor, tensor_elements,
+                           packed_data, buffer->data()) != kTfLiteOk) {
         TfLiteIntArrayFree(nodes_to_delegate);
         return nullptr;  // Hard error.
+      }
+      unpacked_buffer = std::move(buffer);
+      if (weights_cache() != nullptr) {
+        weights_cache()->unpacked_data[key] = unpacked_buffer;
+      }
     }
 
-    static_unpacked_data_map_[t] = tensor_offset;
+    static_unpacked_data_map_[t] = unpacked_buffer->data();
+    static_unpacked_data_.push_back(std::move(unpacked_buffer));
   }
 
   // Add nodes that unpack static data consumed by delegated nodes.
@@ -4142,6 +4246,8 @@ TfLiteStatus DelegatePrepare(TfLiteContext* context, TfLiteDelegate* delegate) {
   const TfLiteStatus status = context->ReplaceNodeSubsetsWithDelegateKernels(
       context, kSubgraphRegistration, ops_to_replace, delegate);
   TfLiteIntArrayFree(ops_to_replace);
+  static_cast<::tflite::xnnpack::Delegate*>(delegate->data_)
+      ->ReleaseStaticUnpackedData();
   return status;
 }
 
@@ -4149,6 +4255,15 @@ TfLiteStatus DelegatePrepare(TfLiteContext* context, TfLiteDelegate* delegate) {
 }  // namespace xnnpack
 }  // namespace tflite
 
+TfLiteXNNPackDelegateWeightsCache* TfLiteXNNPackDelegateWeightsCacheCreate() {
+  return new TfLiteXNNPackDelegateWeightsCache();
+}
+
+void TfLiteXNNPackDelegateWeightsCacheDelete(
+    TfLiteXNNPackDelegateWeightsCache* cache) {
+  delete cache;
+}
+
 TfLiteXNNPackDelegateOptions TfLiteXNNPackDelegateOptionsDefault() {
   TfLiteXNNPackDelegateOptions options = {0};
   return options;
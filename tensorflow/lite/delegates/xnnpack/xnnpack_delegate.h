@@ -22,10 +22,21 @@ limitations under the License.
 extern "C" {
 #endif  // __cplusplus
 
+// A cache of the weights prepared by XNNPACK delegates, which can be shared
+// by the delegates of all the interpreters of a model so that its weights are
+// only prepared once and stored once in memory.
+//
+// WARNING: This API is experimental and subject to change.
+typedef struct TfLiteXNNPackDelegateWeightsCache
+    TfLiteXNNPackDelegateWeightsCache;
+
 typedef struct {
   // Number of threads to use in the thread pool.
   // 0 or negative value means no thread pool used.
   int32_t num_threads;
+  // Cache of the prepared weights to share with other delegates, or nullptr
+  // to not share them. The cache must outlive the delegate.
+  TfLiteXNNPackDelegateWeightsCache* weights_cache;
 } TfLiteXNNPackDelegateOptions;
 
 // Returns a structure with the default XNNPack delegate options.
@@ -48,6 +59,25 @@ TFL_CAPI_EXPORT void* TfLiteXNNPackDelegateGetThreadPool(
 // Destroys a delegate created with `TfLiteXNNPackDelegateCreate` call.
 TFL_CAPI_EXPORT void TfLiteXNNPackDelegateDelete(TfLiteDelegate* delegate);
 
+// Creates a weights cache that needs to be destroyed with
+// `TfLiteXNNPackDelegateWeightsCacheDelete` after all the delegates using it.
+//
+// Weights are identified by the address of their buffer in the model, so the
+// cache is meant to be shared by the interpreters of the same model, e.g. of
+// the same `FlatBufferModel`. Weights stay in the cache while a delegate uses
+// them.
+//
+// WARNING: This API is experimental and subject to change.
+TFL_CAPI_EXPORT TfLiteXNNPackDelegateWeightsCache*
+TfLiteXNNPackDelegateWeightsCacheCreate();
+
+// Destroys a weights cache created with
+// `TfLiteXNNPackDelegateWeightsCacheCreate` call.
+//
+// WARNING: This API is experimental and subject to change.
+TFL_CAPI_EXPORT void TfLiteXNNPackDelegateWeightsCacheDelete(
+    TfLiteXNNPackDelegateWeightsCache* cache);
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
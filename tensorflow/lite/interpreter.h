@@ -528,6 +528,29 @@ class Interpreter {
   /// WARNING: This is an experimental API and subject to change.
   void SetCancellationFunction(void* data, bool (*check_cancelled_func)(void*));
 
+  /// Runs operators that don't depend on each other concurrently during
+  /// Invoke(), sharing the threads set with `SetNumThreads()` between the
+  /// operators and their kernels. Delegated and stateful operators are always
+  /// run alone, and graphs with dynamic tensors or a profiler are run one
+  /// operator at a time. Must be called before `AllocateTensors()`.
+  /// WARNING: This is an experimental API and subject to change.
+  TfLiteStatus EnableParallelExecutionExperimental();
+
+  /// Returns how many bytes of the read-only tensors memory-mapped from the
+  /// model file, e.g. the weights, are currently in memory. These tensors are
+  /// never copied: the OS reads their pages from the file when they are first
+  /// used and may drop them under memory pressure. Tensors computed from
+  /// them by kernels, e.g. dequantized weights, aren't counted.
+  /// WARNING: This is an experimental API and subject to change.
+  size_t GetResidentMappedTensorBytes() const;
+
+  /// Lets the OS reclaim the memory of the read-only tensors memory-mapped
+  /// from the model file, e.g. when the interpreter is idle. Their pages are
+  /// read again from the file when next used, so the next `Invoke()` may be
+  /// slower but behaves the same.
+  /// WARNING: This is an experimental API and subject to change.
+  void ReleaseMappedTensorMemory();
+
   /// Allow a delegate to look at the graph and modify the graph to handle
   /// parts of the graph themselves. After this is called, the graph may
   /// contain new nodes that replace 1 more nodes.
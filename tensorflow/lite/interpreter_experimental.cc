@@ -16,8 +16,10 @@ limitations under the License.
 #include <stddef.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <map>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -35,6 +37,50 @@ limitations under the License.
 
 namespace tflite {
 
+namespace {
+
+// Calls `fn(allocation, data, size)` for each region of the memory-mapped
+// allocations holding the data of kTfLiteMmapRo tensors of `subgraphs`,
+// merging regions shared by several tensors.
+template <typename Fn>
+void ForEachMappedTensorRegion(
+    const std::vector<std::unique_ptr<Subgraph>>& subgraphs, Fn fn) {
+  std::map<const MMAPAllocation*, std::vector<std::pair<uintptr_t, uintptr_t>>>
+      regions;
+  for (const auto& subgraph : subgraphs) {
+    for (int i = 0; i < subgraph->tensors_size(); ++i) {
+      const TfLiteTensor* tensor = subgraph->tensor(i);
+      if (tensor->allocation_type != kTfLiteMmapRo ||
+          tensor->allocation == nullptr || tensor->data.raw == nullptr ||
+          tensor->bytes == 0) {
+        continue;
+      }
+      const auto* allocation =
+          static_cast<const Allocation*>(tensor->allocation);
+      if (allocation->type() != Allocation::Type::kMMap) continue;
+      const uintptr_t begin = reinterpret_cast<uintptr_t>(tensor->data.raw);
+      regions[static_cast<const MMAPAllocation*>(allocation)].emplace_back(
+          begin, begin + tensor->bytes);
+    }
+  }
+  for (auto& entry : regions) {
+    std::vector<std::pair<uintptr_t, uintptr_t>>& ranges = entry.second;
+    std::sort(ranges.begin(), ranges.end());
+    uintptr_t begin = ranges[0].first;
+    uintptr_t end = ranges[0].second;
+    for (const auto& range : ranges) {
+      if (range.first > end) {
+        fn(entry.first, reinterpret_cast<const void*>(begin), end - begin);
+        begin = range.first;
+      }
+      end = std::max(end, range.second);
+    }
+    fn(entry.first, reinterpret_cast<const void*>(begin), end - begin);
+  }
+}
+
+}  // namespace
+
 TfLiteStatus Interpreter::SetCustomAllocationForTensor(
     int tensor_index, const TfLiteCustomAllocation& allocation, int64_t flags) {
   return primary_subgraph().SetCustomAllocationForTensor(tensor_index,
@@ -167,6 +213,32 @@ Profiler* Interpreter::GetProfiler() {
   return primary_subgraph().GetProfiler();
 }
 
+TfLiteStatus Interpreter::EnableParallelExecutionExperimental() {
+  for (int subgraph_index = 0; subgraph_index < subgraphs_.size();
+       ++subgraph_index) {
+    TF_LITE_ENSURE_STATUS(
+        subgraphs_[subgraph_index]->EnableParallelExecutionExperimental());
+  }
+  return kTfLiteOk;
+}
+
+size_t Interpreter::GetResidentMappedTensorBytes() const {
+  size_t resident_bytes = 0;
+  ForEachMappedTensorRegion(
+      subgraphs_, [&resident_bytes](const MMAPAllocation* allocation,
+                                    const void* data, size_t size) {
+        resident_bytes += allocation->GetResidentBytes(data, size);
+      });
+  return resident_bytes;
+}
+
+void Interpreter::ReleaseMappedTensorMemory() {
+  ForEachMappedTensorRegion(subgraphs_, [](const MMAPAllocation* allocation,
+                                           const void* data, size_t size) {
+    allocation->ReleaseResidentPages(data, size);
+  });
+}
+
 TfLiteStatus Interpreter::PreserveAllTensorsExperimental() {
   for (int subgraph_index = 0; subgraph_index < subgraphs_.size();
        ++subgraph_index) {
@@ -17,6 +17,7 @@ limitations under the License.
 #include <stddef.h>
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 // Only use multi-threaded Eigen if ruy is disabled.
@@ -37,9 +38,11 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/optimized/multithreaded_conv.h"
 #endif
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
+#include "tensorflow/lite/kernels/internal/optimized/sparse_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
 #include "tensorflow/lite/kernels/internal/reference/conv.h"
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/sparse_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
@@ -117,6 +120,18 @@ struct OpData {
   bool supports_multithreaded_kernel = false;
   bool is_hybrid_per_channel = false;
   bool compute_hybrid_row_sums = true;
+
+  // Set when the filter is sparse, see PrepareSparseFilter(). The sparsity of
+  // the [output_depth, 1, 1, input_depth] filter is then viewed as that of an
+  // [output_depth, input_depth] fully-connected weights matrix, whose
+  // segments and indices point into the filter sparsity.
+  bool is_sparse = false;
+  TfLiteSparsity fc_sparsity = {};
+  TfLiteDimensionMetadata fc_dim_metadata[3] = {};
+  std::unique_ptr<TfLiteIntArray, TfLiteIntArrayDeleter> fc_traversal_order;
+  std::unique_ptr<TfLiteIntArray, TfLiteIntArrayDeleter> fc_block_map;
+  // The sparse int8 kernel takes 32-bit shifts.
+  std::vector<int32_t> per_channel_output_shift_int32;
 };
 
 inline PaddingType RuntimePaddingType(TfLitePadding padding) {
@@ -326,6 +341,71 @@ static TfLiteStatus AllocateTemporaryTensorsIfRequired(
   return kTfLiteOk;
 }
 
+// Sparse filters are only supported for 1x1 convolutions with unit strides
+// and dilations, which are fully-connected layers applied to every input
+// pixel. The filter must be in the block sparse format the converter emits
+// for fully-connected weights: dimensions 0 to 2 dense, dimension 3 sparse in
+// CSR format and split in blocks of 4 (float) or 16 (int8) input channels.
+TfLiteStatus PrepareSparseFilter(TfLiteContext* context,
+                                 const TfLiteConvParams* params,
+                                 const TfLiteTensor* input,
+                                 const TfLiteTensor* filter, OpData* data) {
+  const TfLiteSparsity& sparsity = *filter->sparsity;
+  if (input->type != kTfLiteFloat32 && input->type != kTfLiteInt8) {
+    TF_LITE_KERNEL_LOG(context, "Sparse filters are not supported for %s.",
+                       TfLiteTypeGetName(input->type));
+    return kTfLiteError;
+  }
+  if (filter->type != input->type) {
+    TF_LITE_KERNEL_LOG(context,
+                       "Hybrid convolutions with sparse filters are not "
+                       "supported.");
+    return kTfLiteError;
+  }
+  if (filter->dims->data[1] != 1 || filter->dims->data[2] != 1 ||
+      params->stride_height != 1 || params->stride_width != 1 ||
+      params->dilation_height_factor != 1 ||
+      params->dilation_width_factor != 1) {
+    TF_LITE_KERNEL_LOG(context,
+                       "Sparse filters are only supported for 1x1 "
+                       "convolutions with unit strides and dilations.");
+    return kTfLiteError;
+  }
+  const int block_size = input->type == kTfLiteFloat32 ? 4 : 16;
+  const int identity_order[] = {0, 1, 2, 3, 4};
+  const int block_map[] = {3};
+  if (sparsity.dim_metadata_size != 5 ||
+      !EqualArrayAndTfLiteIntArray(sparsity.traversal_order, 5,
+                                   identity_order) ||
+      !EqualArrayAndTfLiteIntArray(sparsity.block_map, 1, block_map) ||
+      sparsity.dim_metadata[0].format != kTfLiteDimDense ||
+      sparsity.dim_metadata[1].format != kTfLiteDimDense ||
+      sparsity.dim_metadata[2].format != kTfLiteDimDense ||
+      sparsity.dim_metadata[3].format != kTfLiteDimSparseCSR ||
+      sparsity.dim_metadata[4].format != kTfLiteDimDense ||
+      sparsity.dim_metadata[4].dense_size != block_size) {
+    TF_LITE_KERNEL_LOG(context, "Unsupported sparse filter format.");
+    return kTfLiteError;
+  }
+  if (input->type == kTfLiteInt8) {
+    TF_LITE_ENSURE_EQ(context, filter->params.zero_point, 0);
+  }
+
+  data->fc_traversal_order = BuildTfLiteIntArray({0, 1, 2});
+  data->fc_block_map = BuildTfLiteIntArray({1});
+  data->fc_dim_metadata[0] = TfLiteDimensionMetadata();
+  data->fc_dim_metadata[0].format = kTfLiteDimDense;
+  data->fc_dim_metadata[0].dense_size = filter->dims->data[0];
+  data->fc_dim_metadata[1] = sparsity.dim_metadata[3];
+  data->fc_dim_metadata[2] = sparsity.dim_metadata[4];
+  data->fc_sparsity.traversal_order = data->fc_traversal_order.get();
+  data->fc_sparsity.block_map = data->fc_block_map.get();
+  data->fc_sparsity.dim_metadata = data->fc_dim_metadata;
+  data->fc_sparsity.dim_metadata_size = 3;
+  data->is_sparse = true;
+  return kTfLiteOk;
+}
+
 TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
                      TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteConvParams*>(node->builtin_data);
@@ -380,6 +460,12 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     TF_LITE_ENSURE_EQ(context, NumElements(bias), SizeOfDimension(filter, 0));
   }
 
+  data->is_sparse = false;
+  if (filter->sparsity != nullptr) {
+    TF_LITE_ENSURE_OK(
+        context, PrepareSparseFilter(context, params, input, filter, data));
+  }
+
   const bool is_hybrid =
       (input->type == kTfLiteFloat32 &&
        (filter->type == kTfLiteUInt8 || filter->type == kTfLiteInt8));
@@ -403,11 +489,13 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
     }
   }
 
-  // The multi-threaded kernel supports neither dilation nor hybrid kernels, and
-  // is incompatible with mutable input filters that might change between evals.
+  // The multi-threaded kernel supports neither dilation, hybrid kernels nor
+  // sparse filters, and is incompatible with mutable input filters that might
+  // change between evals.
   data->supports_multithreaded_kernel =
       (kernel_type == kMultithreadOptimized) &&
       (context->recommended_num_threads != 1) && !is_hybrid &&
+      !data->is_sparse &&
       (params->dilation_width_factor == 1) &&
       (params->dilation_height_factor == 1) &&
       (filter->allocation_type != kTfLiteArenaRw) && !IsDynamicTensor(filter);
@@ -463,6 +551,11 @@ TfLiteStatus Prepare(KernelType kernel_type, TfLiteContext* context,
         &data->output_activation_min, &data->output_activation_max,
         data->per_channel_output_multiplier.data(),
         data->per_channel_output_shift.data(), channels_out));
+    if (data->is_sparse) {
+      data->per_channel_output_shift_int32.assign(
+          data->per_channel_output_shift.begin(),
+          data->per_channel_output_shift.end());
+    }
   }
 
   TfLiteIntArray* output_size = TfLiteIntArrayCreate(4);
@@ -1057,6 +1150,90 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
   return kTfLiteOk;
 }
 
+// Runs a 1x1 convolution with a sparse filter as a sparse fully-connected
+// layer from the [batches * height * width, input_depth] input matrix to the
+// [batches * height * width, output_depth] output matrix.
+template <KernelType kernel_type>
+void EvalSparse(TfLiteContext* context, TfLiteConvParams* params,
+                OpData* data, const TfLiteTensor* input,
+                const TfLiteTensor* filter, const TfLiteTensor* bias,
+                TfLiteTensor* output) {
+  const int input_depth = SizeOfDimension(filter, 3);
+  const int output_depth = SizeOfDimension(filter, 0);
+  const int pixels = NumElements(input) / input_depth;
+  const RuntimeShape input_shape({pixels, input_depth});
+  const RuntimeShape filter_shape({output_depth, input_depth});
+  const RuntimeShape output_shape({pixels, output_depth});
+
+  FullyConnectedParams op_params;
+  if (input->type == kTfLiteFloat32) {
+    CalculateActivationRange(params->activation,
+                             &op_params.float_activation_min,
+                             &op_params.float_activation_max);
+    if (kernel_type == kReference) {
+      reference_ops::FullyConnectedSparseWeight(
+          data->fc_sparsity, op_params, input_shape,
+          GetTensorData<float>(input), filter_shape,
+          GetTensorData<float>(filter), GetTensorShape(bias),
+          GetTensorData<float>(bias), output_shape,
+          GetTensorData<float>(output));
+    } else {
+      optimized_ops::FullyConnectedSparseWeight1x4(
+          data->fc_sparsity, op_params, input_shape,
+          GetTensorData<float>(input), filter_shape,
+          GetTensorData<float>(filter), GetTensorShape(bias),
+          GetTensorData<float>(bias), output_shape,
+          GetTensorData<float>(output),
+          CpuBackendContext::GetFromContext(context));
+    }
+    return;
+  }
+
+  op_params.input_offset = -input->params.zero_point;
+  op_params.weights_offset = 0;
+  op_params.output_offset = output->params.zero_point;
+  op_params.output_multiplier = data->output_multiplier;
+  op_params.output_shift = data->output_shift;
+  op_params.quantized_activation_min = data->output_activation_min;
+  op_params.quantized_activation_max = data->output_activation_max;
+  if (kernel_type == kReference) {
+    // The reference kernel densifies the filter, and then runs the dense
+    // per-channel convolution on it.
+    std::vector<int> filter_dims(filter->dims->data,
+                                 filter->dims->data + filter->dims->size);
+    tflite::internal::sparsity::FormatConverter<int8_t> converter(
+        filter_dims, *filter->sparsity);
+    converter.SparseToDense(GetTensorData<int8_t>(filter));
+    ConvParams conv_params;
+    conv_params.input_offset = op_params.input_offset;
+    conv_params.output_offset = op_params.output_offset;
+    conv_params.stride_height = 1;
+    conv_params.stride_width = 1;
+    conv_params.dilation_height_factor = 1;
+    conv_params.dilation_width_factor = 1;
+    conv_params.padding_values.height = data->padding.height;
+    conv_params.padding_values.width = data->padding.width;
+    conv_params.quantized_activation_min = data->output_activation_min;
+    conv_params.quantized_activation_max = data->output_activation_max;
+    reference_integer_ops::ConvPerChannel(
+        conv_params, data->per_channel_output_multiplier.data(),
+        data->per_channel_output_shift.data(), GetTensorShape(input),
+        GetTensorData<int8_t>(input), GetTensorShape(filter),
+        converter.GetData().data(), GetTensorShape(bias),
+        GetTensorData<int32_t>(bias), GetTensorShape(output),
+        GetTensorData<int8_t>(output));
+    return;
+  }
+  optimized_ops::FullyConnectedSparseWeight1x16(
+      data->fc_sparsity, op_params, input_shape, GetTensorData<int8_t>(input),
+      filter_shape, GetTensorData<int8_t>(filter),
+      data->per_channel_output_multiplier.data(),
+      data->per_channel_output_shift_int32.data(), GetTensorShape(bias),
+      GetTensorData<int32_t>(bias), output_shape,
+      GetTensorData<int8_t>(output),
+      CpuBackendContext::GetFromContext(context));
+}
+
 template <KernelType kernel_type, TfLiteType input_type>
 TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteConvParams*>(node->builtin_data);
@@ -1085,6 +1262,11 @@ TfLiteStatus EvalImpl(TfLiteContext* context, TfLiteNode* node) {
   }
 
   TFLITE_DCHECK_EQ(input_type, input->type);
+  if (data->is_sparse) {
+    EvalSparse<kernel_type>(context, params, data, input, filter, bias,
+                            output);
+    return kTfLiteOk;
+  }
   switch (input_type) {  // Already know in/outtypes are same.
     case kTfLiteFloat32:
       if (filter->type == kTfLiteUInt8 || filter->type == kTfLiteInt8) {
@@ -1804,6 +1804,136 @@ TEST_P(ConvolutionOpTest, SimpleTestHybridWithDilationPerChannel) {
                                  0.16)));
 }
 
+// 1x1 convolution whose filter is sparse, with the dimensions 0 to 2 dense and
+// the input channels in CSR format. For quantized filters the quantization
+// parameters of `filter` are used as is.
+template <typename T>
+class SparseConvolutionOpModel : public SingleOpModel {
+ public:
+  SparseConvolutionOpModel(TfLiteRegistration* registration,
+                           const TensorData& input, const TensorData& filter,
+                           const std::vector<T>& filter_data,
+                           const TensorData& output, int num_threads = -1) {
+    input_ = AddInput(input);
+    filter_ = AddConstSparseInput(filter, filter_data);
+    const int bias_size = filter.shape[0];
+    if (input.type == TensorType_FLOAT32) {
+      bias_ = AddInput({TensorType_FLOAT32, {bias_size}});
+    } else {
+      std::vector<float> bias_scale;
+      for (float filter_scale : filter.per_channel_quantization_scales) {
+        bias_scale.push_back(input.scale * filter_scale);
+      }
+      bias_ = AddInput({TensorType_INT32, {bias_size}, 0, 0, 0, 0, true,
+                        bias_scale, std::vector<int64_t>(bias_size, 0), 0});
+    }
+    output_ = AddOutput(output);
+    SetBuiltinOp(BuiltinOperator_CONV_2D, BuiltinOptions_Conv2DOptions,
+                 CreateConv2DOptions(builder_, Padding_VALID, 1, 1,
+                                     ActivationFunctionType_NONE, 1, 1)
+                     .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(BuiltinOperator_CONV_2D,
+                                                    registration);
+    BuildInterpreter({GetShape(input_), GetShape(filter_), GetShape(bias_)},
+                     num_threads, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+  }
+
+  int input() { return input_; }
+  int bias() { return bias_; }
+  int output() { return output_; }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ protected:
+  int input_;
+  int filter_;
+  int bias_;
+  int output_;
+};
+
+TEST_P(ConvolutionOpTest, SparsePointwiseFloat32) {
+  TensorData filter = {TensorType_FLOAT32, {3, 1, 1, 8}};
+  filter.traversal_order = {0, 1, 2, 3, 4};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  filter.block_map = {3};
+  filter.block_size = {4};
+  const std::vector<float> filter_data = {
+      1, 2, 3, 4, -1, -2, -3, -4,  // o = 0
+      0, 0, 0, 0, 1,  1,  1,  1,   // o = 1
+      0, 0, 0, 0, 0,  0,  0,  0,   // o = 2
+  };
+  SparseConvolutionOpModel<float> m(GetRegistration(),
+                                    {TensorType_FLOAT32, {1, 2, 2, 8}}, filter,
+                                    filter_data, {TensorType_FLOAT32, {}});
+  m.PopulateTensor<float>(m.input(), {
+                                         1, 2, 3, 4, 5, 6, 7, 8,          //
+                                         1, -1, 1, -1, 1, -1, 1, -1,      //
+                                         0.5, 0.5, 0.5, 0.5, 2, 2, 2, 2,  //
+                                         -1, -2, -3, -4, 1, 2, 3, 4,      //
+                                     });
+  m.PopulateTensor<float>(m.bias(), {1, 2, 3});
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({1, 2, 2, 3}));
+  EXPECT_THAT(m.ExtractVector<float>(m.output()),
+              ElementsAreArray(ArrayFloatNear({
+                  -39, 28, 3,  //
+                  1, 2, 3,     //
+                  -14, 10, 3,  //
+                  -59, 12, 3,  //
+              })));
+}
+
+TEST_P(ConvolutionOpTest, SparsePointwisePerChannel) {
+  TensorData filter = {TensorType_INT8,
+                       {2, 1, 1, 32},
+                       0,
+                       0,
+                       0,
+                       0,
+                       /*per_channel_quantization=*/true,
+                       /*per_channel_quantization_scales=*/{0.5, 2},
+                       /*per_channel_quantization_offsets=*/{0, 0},
+                       /*channel_index=*/0};
+  filter.traversal_order = {0, 1, 2, 3, 4};
+  filter.format = {kTfLiteDimDense, kTfLiteDimDense, kTfLiteDimDense,
+                   kTfLiteDimSparseCSR};
+  filter.block_map = {3};
+  filter.block_size = {16};
+  // The first block of output channel 1 is empty.
+  const std::vector<int8_t> filter_data = {
+      -3, 2, 0, -2, 3, 1, -1, -3, 2, 0, -2, 3, 1, -1, -3, 2,  // o = 0
+      0, -2, 3, 1, -1, -3, 2, 0, -2, 3, 1, -1, -3, 2, 0, -2,  // o = 0
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,         // o = 1
+      3, 1, -1, -3, 2, 0, -2, 3, 1, -1, -3, 2, 0, -2, 3, 1,   // o = 1
+  };
+  SparseConvolutionOpModel<int8_t> m(
+      GetRegistration(), {TensorType_INT8, {1, 1, 2, 32}, -63.5, 64, 0.5, -1},
+      filter, filter_data, {TensorType_INT8, {}, -63.5, 64, 0.5, -1});
+  m.QuantizeAndPopulate<int8_t>(
+      m.input(),
+      {
+          // x = 0
+          -2, 0.5, -1.5, 1, -1, 1.5, -0.5, 2, 0, -2, 0.5, -1.5, 1, -1, 1.5,
+          -0.5, 2, 0, -2, 0.5, -1.5, 1, -1, 1.5, -0.5, 2, 0, -2, 0.5, -1.5,
+          1, -1,
+          // x = 1
+          -1, 1.5, -0.5, 2, 0, -2, 0.5, -1.5, 1, -1, 1.5, -0.5, 2, 0, -2,
+          0.5, -1.5, 1, -1, 1.5, -0.5, 2, 0, -2, 0.5, -1.5, 1, -1, 1.5, -0.5,
+          2, 0,
+      });
+  m.PerChannelQuantizeBias(m.bias(), {1.25, -2});
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({1, 1, 2, 2}));
+  EXPECT_THAT(
+      Dequantize<int8_t>(m.ExtractVector<int8_t>(m.output()), 0.5, -1),
+      ElementsAreArray(ArrayFloatNear({-5.5, 15, -2.5, -22})));
+}
+
 const auto kQuantizedKernelMap = new std::map<string, TfLiteRegistration*>({
     {"GenericOptimized", ops::builtin::Register_CONV_2D_UINT8()},
 });
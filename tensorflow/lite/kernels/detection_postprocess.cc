@@ -23,6 +23,8 @@ limitations under the License.
 
 #include "flatbuffers/flexbuffers.h"  // from @flatbuffers
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/optimized/optimized_ops.h"
 #include "tensorflow/lite/kernels/internal/reference/reference_ops.h"
@@ -268,56 +270,41 @@ T ReInterpretTensor(TfLiteTensor* tensor) {
   return reinterpret_cast<T>(tensor_base);
 }
 
-TfLiteStatus DecodeCenterSizeBoxes(TfLiteContext* context, TfLiteNode* node,
-                                   OpData* op_data) {
-  // Parse input tensor boxencodings
-  const TfLiteTensor* input_box_encodings;
-  TF_LITE_ENSURE_OK(context,
-                    GetInputSafe(context, node, kInputTensorBoxEncodings,
-                                 &input_box_encodings));
-  TF_LITE_ENSURE_EQ(context, input_box_encodings->dims->data[0], kBatchSize);
-  const int num_boxes = input_box_encodings->dims->data[1];
-  TF_LITE_ENSURE(context, input_box_encodings->dims->data[2] >= kNumCoordBox);
-  const TfLiteTensor* input_anchors;
-  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kInputTensorAnchors,
-                                          &input_anchors));
-
-  // Decode the boxes to get (ymin, xmin, ymax, xmax) based on the anchors
+// Decodes the boxes of anchors [begin, end) to get (ymin, xmin, ymax, xmax)
+// based on the anchors.
+void DecodeCenterSizeBoxRange(const TfLiteTensor* input_box_encodings,
+                              const TfLiteTensor* input_anchors,
+                              const CenterSizeEncoding& scale_values,
+                              int begin, int end,
+                              TfLiteTensor* decoded_boxes) {
+  const int length_box_encoding = input_box_encodings->dims->data[2];
+  BoxCornerEncoding* boxes =
+      ReInterpretTensor<BoxCornerEncoding*>(decoded_boxes);
   CenterSizeEncoding box_centersize;
-  CenterSizeEncoding scale_values = op_data->scale_values;
   CenterSizeEncoding anchor;
-  for (int idx = 0; idx < num_boxes; ++idx) {
-    switch (input_box_encodings->type) {
-        // Quantized
-      case kTfLiteUInt8:
-        DequantizeBoxEncodings(
-            input_box_encodings, idx,
-            static_cast<float>(input_box_encodings->params.zero_point),
-            static_cast<float>(input_box_encodings->params.scale),
-            input_box_encodings->dims->data[2], &box_centersize);
-        DequantizeBoxEncodings(
-            input_anchors, idx,
-            static_cast<float>(input_anchors->params.zero_point),
-            static_cast<float>(input_anchors->params.scale), kNumCoordBox,
-            &anchor);
-        break;
-        // Float
-      case kTfLiteFloat32: {
-        // Please see DequantizeBoxEncodings function for the support detail.
-        const int box_encoding_idx = idx * input_box_encodings->dims->data[2];
-        const float* boxes =
-            &(GetTensorData<float>(input_box_encodings)[box_encoding_idx]);
-        box_centersize = *reinterpret_cast<const CenterSizeEncoding*>(boxes);
-        TF_LITE_ENSURE_EQ(context, input_anchors->type, kTfLiteFloat32);
-        anchor =
-            ReInterpretTensor<const CenterSizeEncoding*>(input_anchors)[idx];
-        break;
-      }
-      default:
-        // Unsupported type.
-        return kTfLiteError;
+  for (int idx = begin; idx < end; ++idx) {
+    if (input_box_encodings->type == kTfLiteUInt8) {
+      DequantizeBoxEncodings(
+          input_box_encodings, idx,
+          static_cast<float>(input_box_encodings->params.zero_point),
+          static_cast<float>(input_box_encodings->params.scale),
+          length_box_encoding, &box_centersize);
+      DequantizeBoxEncodings(
+          input_anchors, idx,
+          static_cast<float>(input_anchors->params.zero_point),
+          static_cast<float>(input_anchors->params.scale), kNumCoordBox,
+          &anchor);
+    } else {
+      // Please see DequantizeBoxEncodings function for the support detail.
+      const float* encoding = GetTensorData<float>(input_box_encodings) +
+                              idx * length_box_encoding;
+      box_centersize = *reinterpret_cast<const CenterSizeEncoding*>(encoding);
+      anchor =
+          ReInterpretTensor<const CenterSizeEncoding*>(input_anchors)[idx];
     }
 
+    // The decoding is done in double precision, so that TFL and TFLM are
+    // bit-exact.
     float ycenter = static_cast<float>(static_cast<double>(box_centersize.y) /
                                            static_cast<double>(scale_values.y) *
                                            static_cast<double>(anchor.h) +
@@ -339,15 +326,88 @@ TfLiteStatus DecodeCenterSizeBoxes(TfLiteContext* context, TfLiteNode* node,
                                      static_cast<double>(scale_values.w))) *
                            static_cast<double>(anchor.w));
 
-    TfLiteTensor* decoded_boxes =
-        &context->tensors[op_data->decoded_boxes_index];
-    TF_LITE_ENSURE_EQ(context, decoded_boxes->type, kTfLiteFloat32);
-    auto& box = ReInterpretTensor<BoxCornerEncoding*>(decoded_boxes)[idx];
+    auto& box = boxes[idx];
     box.ymin = ycenter - half_h;
     box.xmin = xcenter - half_w;
     box.ymax = ycenter + half_h;
     box.xmax = xcenter + half_w;
   }
+}
+
+struct DecodeBoxesTask : cpu_backend_threadpool::Task {
+  DecodeBoxesTask(const TfLiteTensor* input_box_encodings,
+                  const TfLiteTensor* input_anchors,
+                  const CenterSizeEncoding& scale_values, int begin, int end,
+                  TfLiteTensor* decoded_boxes)
+      : input_box_encodings(input_box_encodings),
+        input_anchors(input_anchors),
+        scale_values(scale_values),
+        begin(begin),
+        end(end),
+        decoded_boxes(decoded_boxes) {}
+  void Run() override {
+    DecodeCenterSizeBoxRange(input_box_encodings, input_anchors, scale_values,
+                             begin, end, decoded_boxes);
+  }
+  const TfLiteTensor* input_box_encodings;
+  const TfLiteTensor* input_anchors;
+  const CenterSizeEncoding scale_values;
+  const int begin;
+  const int end;
+  TfLiteTensor* decoded_boxes;
+};
+
+TfLiteStatus DecodeCenterSizeBoxes(TfLiteContext* context, TfLiteNode* node,
+                                   OpData* op_data) {
+  // Parse input tensor boxencodings
+  const TfLiteTensor* input_box_encodings;
+  TF_LITE_ENSURE_OK(context,
+                    GetInputSafe(context, node, kInputTensorBoxEncodings,
+                                 &input_box_encodings));
+  TF_LITE_ENSURE_EQ(context, input_box_encodings->dims->data[0], kBatchSize);
+  const int num_boxes = input_box_encodings->dims->data[1];
+  TF_LITE_ENSURE(context, input_box_encodings->dims->data[2] >= kNumCoordBox);
+  const TfLiteTensor* input_anchors;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kInputTensorAnchors,
+                                          &input_anchors));
+  switch (input_box_encodings->type) {
+    case kTfLiteUInt8:
+      break;
+    case kTfLiteFloat32:
+      TF_LITE_ENSURE_EQ(context, input_anchors->type, kTfLiteFloat32);
+      break;
+    default:
+      // Unsupported type.
+      return kTfLiteError;
+  }
+  TfLiteTensor* decoded_boxes = &context->tensors[op_data->decoded_boxes_index];
+  TF_LITE_ENSURE_EQ(context, decoded_boxes->type, kTfLiteFloat32);
+
+  // The boxes are decoded in ranges of at least kMinBoxesPerDecodeTask, so
+  // that each task outweighs its scheduling.
+  constexpr int kMinBoxesPerDecodeTask = 256;
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(context);
+  const int num_tasks =
+      std::max(1, std::min(cpu_backend_context->max_num_threads(),
+                           num_boxes / kMinBoxesPerDecodeTask));
+  if (num_tasks == 1) {
+    DecodeCenterSizeBoxRange(input_box_encodings, input_anchors,
+                             op_data->scale_values, 0, num_boxes,
+                             decoded_boxes);
+    return kTfLiteOk;
+  }
+  std::vector<DecodeBoxesTask> tasks;
+  tasks.reserve(num_tasks);
+  for (int i = 0; i < num_tasks; ++i) {
+    tasks.emplace_back(input_box_encodings, input_anchors,
+                       op_data->scale_values,
+                       static_cast<int64_t>(num_boxes) * i / num_tasks,
+                       static_cast<int64_t>(num_boxes) * (i + 1) / num_tasks,
+                       decoded_boxes);
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
   return kTfLiteOk;
 }
 
@@ -398,42 +458,53 @@ bool ValidateBoxes(const TfLiteTensor* decoded_boxes, const int num_boxes) {
   return true;
 }
 
-float ComputeIntersectionOverUnion(const TfLiteTensor* decoded_boxes,
-                                   const int i, const int j) {
-  auto& box_i = ReInterpretTensor<const BoxCornerEncoding*>(decoded_boxes)[i];
-  auto& box_j = ReInterpretTensor<const BoxCornerEncoding*>(decoded_boxes)[j];
-  const float area_i = (box_i.ymax - box_i.ymin) * (box_i.xmax - box_i.xmin);
-  const float area_j = (box_j.ymax - box_j.ymin) * (box_j.xmax - box_j.xmin);
+float ComputeIntersectionOverUnion(const BoxCornerEncoding& box_i,
+                                   float area_i, const BoxCornerEncoding& box_j,
+                                   float area_j) {
   if (area_i <= 0 || area_j <= 0) return 0.0;
   const float intersection_ymin = std::max<float>(box_i.ymin, box_j.ymin);
   const float intersection_xmin = std::max<float>(box_i.xmin, box_j.xmin);
   const float intersection_ymax = std::min<float>(box_i.ymax, box_j.ymax);
   const float intersection_xmax = std::min<float>(box_i.xmax, box_j.xmax);
-  const float intersection_area =
-      std::max<float>(intersection_ymax - intersection_ymin, 0.0) *
-      std::max<float>(intersection_xmax - intersection_xmin, 0.0);
+  // Most pairs of boxes don't overlap.
+  if (intersection_ymax <= intersection_ymin ||
+      intersection_xmax <= intersection_xmin) {
+    return 0.0;
+  }
+  const float intersection_area = (intersection_ymax - intersection_ymin) *
+                                  (intersection_xmax - intersection_xmin);
   return intersection_area / (area_i + area_j - intersection_area);
 }
 
+// Buffers of NonMaxSuppressionSingleClass(), reused across classes.
+struct NMSScratch {
+  // The scores above the threshold, and the indices of their boxes.
+  std::vector<float> keep_scores;
+  std::vector<int> keep_indices;
+
+  std::vector<int> sorted_indices;
+  std::vector<BoxCornerEncoding> boxes;
+  std::vector<float> areas;
+  std::vector<uint8_t> active_box_candidate;
+};
+
 // NonMaxSuppressionSingleClass() prunes out the box locations with high overlap
 // before selecting the highest scoring boxes (max_detections in number)
 // It assumes all boxes are good in beginning and sorts based on the scores.
 // If lower-scoring box has too much overlap with a higher-scoring box,
 // we get rid of the lower-scoring box.
-// Complexity is O(N^2) pairwise comparison between boxes
-TfLiteStatus NonMaxSuppressionSingleClassHelper(
-    TfLiteContext* context, TfLiteNode* node, OpData* op_data,
-    const std::vector<float>& scores, int max_detections,
-    std::vector<int>* selected) {
-  const TfLiteTensor* input_box_encodings;
-  TF_LITE_ENSURE_OK(context,
-                    GetInputSafe(context, node, kInputTensorBoxEncodings,
-                                 &input_box_encodings));
+// Complexity is O(N^2) pairwise comparison between boxes, in the worst case:
+// the candidates are only compared to the boxes selected before them, and
+// the comparisons stop once max_detections boxes are selected.
+//
+// The candidates are the boxes of scratch->keep_indices, whose scores are
+// scratch->keep_scores, and whose validity was checked by ValidateBoxes().
+TfLiteStatus NonMaxSuppressionSingleClass(TfLiteContext* context,
+                                          OpData* op_data, int max_detections,
+                                          NMSScratch* scratch,
+                                          std::vector<int>* selected) {
   const TfLiteTensor* decoded_boxes =
       &context->tensors[op_data->decoded_boxes_index];
-  const int num_boxes = input_box_encodings->dims->data[1];
-  const float non_max_suppression_score_threshold =
-      op_data->non_max_suppression_score_threshold;
   const float intersection_over_union_threshold =
       op_data->intersection_over_union_threshold;
   // Maximum detections should be positive.
@@ -442,49 +513,47 @@ TfLiteStatus NonMaxSuppressionSingleClassHelper(
   // and should be less than 1.
   TF_LITE_ENSURE(context, (intersection_over_union_threshold > 0.0f) &&
                               (intersection_over_union_threshold <= 1.0f));
-  // Validate boxes
   TF_LITE_ENSURE_EQ(context, decoded_boxes->type, kTfLiteFloat32);
-  TF_LITE_ENSURE(context, ValidateBoxes(decoded_boxes, num_boxes));
-
-  // threshold scores
-  std::vector<int> keep_indices;
-  // TODO(b/177068807): Remove the dynamic allocation and replace it
-  // with temporaries, esp for std::vector<float>
-  std::vector<float> keep_scores;
-  SelectDetectionsAboveScoreThreshold(
-      scores, non_max_suppression_score_threshold, &keep_scores, &keep_indices);
 
-  int num_scores_kept = keep_scores.size();
-  std::vector<int> sorted_indices;
-  sorted_indices.resize(num_scores_kept);
-  DecreasingArgSort(keep_scores.data(), num_scores_kept, sorted_indices.data());
+  const int num_boxes_kept = scratch->keep_scores.size();
+  std::vector<int>& sorted_indices = scratch->sorted_indices;
+  sorted_indices.resize(num_boxes_kept);
+  DecreasingArgSort(scratch->keep_scores.data(), num_boxes_kept,
+                    sorted_indices.data());
 
-  const int num_boxes_kept = num_scores_kept;
   const int output_size = std::min(num_boxes_kept, max_detections);
   selected->clear();
-  int num_active_candidate = num_boxes_kept;
-  std::vector<uint8_t> active_box_candidate(num_boxes_kept, 1);
+  if (output_size == 0) return kTfLiteOk;
+
+  // The candidate boxes and their areas, in the order of their scores, so
+  // that the comparisons below read them sequentially.
+  const BoxCornerEncoding* all_boxes =
+      ReInterpretTensor<const BoxCornerEncoding*>(decoded_boxes);
+  std::vector<BoxCornerEncoding>& boxes = scratch->boxes;
+  std::vector<float>& areas = scratch->areas;
+  boxes.resize(num_boxes_kept);
+  areas.resize(num_boxes_kept);
+  for (int i = 0; i < num_boxes_kept; ++i) {
+    const BoxCornerEncoding& box =
+        all_boxes[scratch->keep_indices[sorted_indices[i]]];
+    boxes[i] = box;
+    areas[i] = (box.ymax - box.ymin) * (box.xmax - box.xmin);
+  }
 
+  std::vector<uint8_t>& active_box_candidate = scratch->active_box_candidate;
+  active_box_candidate.assign(num_boxes_kept, 1);
   for (int i = 0; i < num_boxes_kept; ++i) {
-    if (num_active_candidate == 0 || selected->size() >= output_size) break;
-    if (active_box_candidate[i] == 1) {
-      selected->push_back(keep_indices[sorted_indices[i]]);
-      active_box_candidate[i] = 0;
-      num_active_candidate--;
-    } else {
-      continue;
-    }
+    if (active_box_candidate[i] == 0) continue;
+    selected->push_back(scratch->keep_indices[sorted_indices[i]]);
+    if (selected->size() >= output_size) break;
+    // A degenerated box overlaps with no other box.
+    if (areas[i] <= 0) continue;
     for (int j = i + 1; j < num_boxes_kept; ++j) {
-      if (active_box_candidate[j] == 1) {
-        TF_LITE_ENSURE_EQ(context, decoded_boxes->type, kTfLiteFloat32);
-        float intersection_over_union = ComputeIntersectionOverUnion(
-            decoded_boxes, keep_indices[sorted_indices[i]],
-            keep_indices[sorted_indices[j]]);
-
-        if (intersection_over_union > intersection_over_union_threshold) {
-          active_box_candidate[j] = 0;
-          num_active_candidate--;
-        }
+      if (active_box_candidate[j] == 1 &&
+          ComputeIntersectionOverUnion(boxes[i], areas[i], boxes[j],
+                                       areas[j]) >
+              intersection_over_union_threshold) {
+        active_box_candidate[j] = 0;
       }
     }
   }
@@ -523,36 +592,44 @@ void InplaceMergeBoxInfo(std::vector<BoxInfo>& boxes, int mid_index,
 TfLiteStatus ComputeNMSResult(const NMSTaskParam& nms_task_param, int col_begin,
                               int col_end, int& sorted_indices_size,
                               std::vector<BoxInfo>& resulted_sorted_box_info) {
-  std::vector<float> class_scores(nms_task_param.num_boxes);
+  const float non_max_suppression_score_threshold =
+      nms_task_param.op_data->non_max_suppression_score_threshold;
+  NMSScratch scratch;
   std::vector<int> selected;
   selected.reserve(nms_task_param.num_detections_per_class);
 
   for (int col = col_begin; col <= col_end; ++col) {
+    // Get scores above the threshold of boxes corresponding to all anchors
+    // for single class
+    scratch.keep_scores.clear();
+    scratch.keep_indices.clear();
     const float* scores_base =
         nms_task_param.scores + col + nms_task_param.label_offset;
     for (int row = 0; row < nms_task_param.num_boxes; row++) {
-      // Get scores of boxes corresponding to all anchors for single class
-      class_scores[row] = *scores_base;
+      if (*scores_base >= non_max_suppression_score_threshold) {
+        scratch.keep_scores.push_back(*scores_base);
+        scratch.keep_indices.push_back(row);
+      }
       scores_base += nms_task_param.num_classes_with_background;
     }
 
     // Perform non-maximal suppression on single class
-    selected.clear();
-    TF_LITE_ENSURE_OK(
-        nms_task_param.context,
-        NonMaxSuppressionSingleClassHelper(
-            nms_task_param.context, nms_task_param.node, nms_task_param.op_data,
-            class_scores, nms_task_param.num_detections_per_class, &selected));
+    TF_LITE_ENSURE_OK(nms_task_param.context,
+                      NonMaxSuppressionSingleClass(
+                          nms_task_param.context, nms_task_param.op_data,
+                          nms_task_param.num_detections_per_class, &scratch,
+                          &selected));
     if (selected.empty()) {
       continue;
     }
 
     for (int i = 0; i < selected.size(); ++i) {
+      const int index =
+          selected[i] * nms_task_param.num_classes_with_background + col +
+          nms_task_param.label_offset;
       resulted_sorted_box_info[sorted_indices_size + i].score =
-          class_scores[selected[i]];
-      resulted_sorted_box_info[sorted_indices_size + i].index =
-          (selected[i] * nms_task_param.num_classes_with_background + col +
-           nms_task_param.label_offset);
+          nms_task_param.scores[index];
+      resulted_sorted_box_info[sorted_indices_size + i].index = index;
     }
 
     // In-place merge the original boxes and new selected boxes which are both
@@ -795,9 +872,13 @@ TfLiteStatus NonMaxSuppressionMultiClassFastHelper(TfLiteContext* context,
     max_scores[row] = box_scores[class_indices[0]];
   }
   // Perform non-maximal suppression on max scores
+  NMSScratch scratch;
+  SelectDetectionsAboveScoreThreshold(
+      max_scores, op_data->non_max_suppression_score_threshold,
+      &scratch.keep_scores, &scratch.keep_indices);
   std::vector<int> selected;
-  TF_LITE_ENSURE_STATUS(NonMaxSuppressionSingleClassHelper(
-      context, node, op_data, max_scores, op_data->max_detections, &selected));
+  TF_LITE_ENSURE_STATUS(NonMaxSuppressionSingleClass(
+      context, op_data, op_data->max_detections, &scratch, &selected));
   // Allocate output tensors
   int output_box_index = 0;
   for (const auto& selected_index : selected) {
@@ -879,6 +960,12 @@ TfLiteStatus NonMaxSuppressionMultiClass(TfLiteContext* context,
       // Unsupported type.
       return kTfLiteError;
   }
+  // Validate boxes
+  const TfLiteTensor* decoded_boxes =
+      &context->tensors[op_data->decoded_boxes_index];
+  TF_LITE_ENSURE_EQ(context, decoded_boxes->type, kTfLiteFloat32);
+  TF_LITE_ENSURE(context, ValidateBoxes(decoded_boxes, num_boxes));
+
   if (op_data->use_regular_non_max_suppression)
     TF_LITE_ENSURE_STATUS(NonMaxSuppressionMultiClassRegularHelper(
         context, node, op_data, GetTensorData<float>(scores)));
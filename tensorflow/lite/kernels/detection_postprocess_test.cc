@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include <stdint.h>
 
+#include <cmath>
 #include <initializer_list>
 #include <vector>
 
@@ -24,6 +25,10 @@ limitations under the License.
 #include "tensorflow/lite/kernels/test_util.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
+#ifdef DETECTION_POSTPROCESS_BENCHMARKS
+#include "testing/base/public/benchmark.h"
+#endif  // DETECTION_POSTPROCESS_BENCHMARKS
+
 namespace tflite {
 namespace ops {
 namespace custom {
@@ -989,6 +994,145 @@ TEST(DetectionPostprocessOpTest,
   EXPECT_THAT(m.GetOutput4<float>(),
               ElementsAreArray(ArrayFloatNear({3.0}, 1e-1)));
 }
+
+// A model over num_boxes anchors on a grid, with pseudo-random box encodings
+// and class scores, as the many anchors of detection models.
+class ManyAnchorsDetectionPostprocessOpModel : public SingleOpModel {
+ public:
+  ManyAnchorsDetectionPostprocessOpModel(int num_boxes, int num_classes,
+                                         bool use_regular_nms,
+                                         int num_threads) {
+    box_encodings_ = AddInput({TensorType_FLOAT32, {1, num_boxes, 4}});
+    class_predictions_ =
+        AddInput({TensorType_FLOAT32, {1, num_boxes, num_classes + 1}});
+    anchors_ = AddInput({TensorType_FLOAT32, {num_boxes, 4}});
+    detection_boxes_ = AddOutput({TensorType_FLOAT32, {}});
+    detection_classes_ = AddOutput({TensorType_FLOAT32, {}});
+    detection_scores_ = AddOutput({TensorType_FLOAT32, {}});
+    num_detections_ = AddOutput({TensorType_FLOAT32, {}});
+
+    flexbuffers::Builder fbb;
+    fbb.Map([&]() {
+      fbb.Int("max_detections", 100);
+      fbb.Int("max_classes_per_detection", 1);
+      fbb.Int("detections_per_class", 100);
+      fbb.Bool("use_regular_nms", use_regular_nms);
+      fbb.Float("nms_score_threshold", 0.3);
+      fbb.Float("nms_iou_threshold", 0.6);
+      fbb.Int("num_classes", num_classes);
+      fbb.Float("y_scale", 10.0);
+      fbb.Float("x_scale", 10.0);
+      fbb.Float("h_scale", 5.0);
+      fbb.Float("w_scale", 5.0);
+    });
+    fbb.Finish();
+    SetCustomOp("TFLite_Detection_PostProcess", fbb.GetBuffer(),
+                Register_DETECTION_POSTPROCESS);
+    BuildInterpreter({GetShape(box_encodings_), GetShape(class_predictions_),
+                      GetShape(anchors_)},
+                     num_threads, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/true);
+
+    uint32_t seed = 1;
+    auto next = [&seed]() {
+      seed = seed * 1664525 + 1013904223;
+      return static_cast<float>(seed >> 8) / (1 << 24);
+    };
+    const int grid_size = std::ceil(std::sqrt(num_boxes));
+    std::vector<float> box_encodings, class_predictions, anchors;
+    for (int i = 0; i < num_boxes; ++i) {
+      for (int j = 0; j < 4; ++j) box_encodings.push_back(next() - 0.5f);
+      for (int j = 0; j <= num_classes; ++j) {
+        class_predictions.push_back(next());
+      }
+      anchors.insert(anchors.end(), {static_cast<float>(i / grid_size),
+                                     static_cast<float>(i % grid_size), 2.0f,
+                                     2.0f});
+    }
+    PopulateTensor(box_encodings_, box_encodings);
+    PopulateTensor(class_predictions_, class_predictions);
+    PopulateTensor(anchors_, anchors);
+  }
+
+  std::vector<float> GetDetectionBoxes() {
+    return ExtractVector<float>(detection_boxes_);
+  }
+  std::vector<float> GetDetectionClasses() {
+    return ExtractVector<float>(detection_classes_);
+  }
+  std::vector<float> GetDetectionScores() {
+    return ExtractVector<float>(detection_scores_);
+  }
+  std::vector<float> GetNumDetections() {
+    return ExtractVector<float>(num_detections_);
+  }
+
+ private:
+  int box_encodings_;
+  int class_predictions_;
+  int anchors_;
+  int detection_boxes_;
+  int detection_classes_;
+  int detection_scores_;
+  int num_detections_;
+};
+
+class DetectionPostprocessOpManyAnchorsTest
+    : public ::testing::TestWithParam<bool> {};
+
+INSTANTIATE_TEST_SUITE_P(DetectionPostprocessOpManyAnchorsTest,
+                         DetectionPostprocessOpManyAnchorsTest,
+                         ::testing::Bool());
+
+TEST_P(DetectionPostprocessOpManyAnchorsTest, ThreadsGiveSameDetections) {
+  const bool use_regular_nms = GetParam();
+  ManyAnchorsDetectionPostprocessOpModel single_thread(
+      /*num_boxes=*/1917, /*num_classes=*/5, use_regular_nms,
+      /*num_threads=*/1);
+  ManyAnchorsDetectionPostprocessOpModel multi_thread(
+      /*num_boxes=*/1917, /*num_classes=*/5, use_regular_nms,
+      /*num_threads=*/4);
+  ASSERT_EQ(single_thread.InvokeUnchecked(), kTfLiteOk);
+  ASSERT_EQ(multi_thread.InvokeUnchecked(), kTfLiteOk);
+
+  EXPECT_THAT(single_thread.GetNumDetections(), ElementsAre(100.0));
+  EXPECT_EQ(multi_thread.GetNumDetections(),
+            single_thread.GetNumDetections());
+  EXPECT_EQ(multi_thread.GetDetectionBoxes(),
+            single_thread.GetDetectionBoxes());
+  EXPECT_EQ(multi_thread.GetDetectionClasses(),
+            single_thread.GetDetectionClasses());
+  EXPECT_EQ(multi_thread.GetDetectionScores(),
+            single_thread.GetDetectionScores());
+}
+
+#ifdef DETECTION_POSTPROCESS_BENCHMARKS
+
+// Compile with --copt="-DDETECTION_POSTPROCESS_BENCHMARKS"
+// Run with --benchmarks=all
+// The arguments are the number of anchors, of SSD MobileNet at 300x300 and
+// of a 320x320 FPN model, whether to use regular NMS and the number of
+// threads.
+void BM_DetectionPostprocess(benchmark::State& state) {
+  ManyAnchorsDetectionPostprocessOpModel m(
+      /*num_boxes=*/state.range(0), /*num_classes=*/90,
+      /*use_regular_nms=*/state.range(1), /*num_threads=*/state.range(2));
+  for (auto _ : state) {
+    m.Invoke();
+  }
+}
+BENCHMARK(BM_DetectionPostprocess)
+    ->Args({1917, 0, 1})
+    ->Args({1917, 0, 4})
+    ->Args({1917, 1, 1})
+    ->Args({1917, 1, 4})
+    ->Args({12804, 0, 1})
+    ->Args({12804, 0, 4})
+    ->Args({12804, 1, 1})
+    ->Args({12804, 1, 4});
+
+#endif  // DETECTION_POSTPROCESS_BENCHMARKS
+
 }  // namespace
 }  // namespace custom
 }  // namespace ops
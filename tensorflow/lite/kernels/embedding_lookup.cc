@@ -26,6 +26,8 @@ limitations under the License.
 //   Output.dim[1] == Tensor[1].dim[1],  num of items per row
 //   Each item in output is a raw bytes copy of the corresponding item in input,
 //   or a dequantized value in the case of a uint8 input.
+//   A quantized input can have a scale and a zero point per row, i.e.
+//   per-channel quantization along dimension 0, with a float output.
 //   When indices are out of bound, the ops will not succeed.
 //
 
@@ -35,6 +37,7 @@ limitations under the License.
 
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 
 namespace tflite {
@@ -57,6 +60,24 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   TfLiteTensor* output;
   TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, 0, &output));
+
+  if (value->quantization.type == kTfLiteAffineQuantization) {
+    const auto* params = static_cast<const TfLiteAffineQuantization*>(
+        value->quantization.params);
+    TF_LITE_ENSURE(context, params != nullptr && params->scale != nullptr);
+    if (params->scale->size > 1) {
+      // Per-row quantization, which is only dequantized.
+      TF_LITE_ENSURE_TYPES_EQ(context, value->type, kTfLiteInt8);
+      TF_LITE_ENSURE_EQ(context, params->quantized_dimension, 0);
+      TF_LITE_ENSURE_EQ(context, params->scale->size,
+                        SizeOfDimension(value, 0));
+      TF_LITE_ENSURE(context, params->zero_point != nullptr);
+      TF_LITE_ENSURE_EQ(context, params->zero_point->size,
+                        params->scale->size);
+      TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteFloat32);
+    }
+  }
+
   TfLiteIntArray* outputSize = TfLiteIntArrayCreate(NumDimensions(value));
 
   outputSize->data[0] = SizeOfDimension(lookup, 0);
@@ -101,7 +122,13 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
                         const TfLiteTensor* lookup, const TfLiteTensor* value,
                         TfLiteTensor* output) {
   const int row_size = SizeOfDimension(value, 0);
-  const double scaling_factor = value->params.scale;
+  const float scaling_factor = value->params.scale;
+  const TfLiteAffineQuantization* per_row_params = nullptr;
+  if (value->quantization.type == kTfLiteAffineQuantization) {
+    per_row_params = static_cast<const TfLiteAffineQuantization*>(
+        value->quantization.params);
+    if (per_row_params->scale->size <= 1) per_row_params = nullptr;
+  }
 
   // col_size after we flatten tensor into 2D.
   int col_size = 1;
@@ -121,14 +148,18 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
                            "Got %d, and bounds are [0, %d]",
                            idx, row_size - 1);
       return kTfLiteError;
+    } else if (per_row_params != nullptr) {
+      // Dequantize embedding values with the scale and zero point of the row.
+      tensor_utils::VectorScalarMultiply(
+          value_ptr + idx * col_size, col_size,
+          per_row_params->zero_point->data[idx],
+          per_row_params->scale->data[idx], output_ptr + i * col_size);
     } else {
-      // Dequantize embedding values.
-      // TODO(alanchiao): refactor scalar multiply into separate function
-      // for ease of adding a neon equivalent if ever necessary.
-      for (int j = 0; j < col_size; j++) {
-        output_ptr[j + i * col_size] =
-            value_ptr[j + idx * col_size] * scaling_factor;
-      }
+      // Dequantize embedding values. Rows may be unaligned, which only the
+      // zero point version allows.
+      tensor_utils::VectorScalarMultiply(value_ptr + idx * col_size, col_size,
+                                         /*zero_point=*/0, scaling_factor,
+                                         output_ptr + i * col_size);
     }
   }
 
@@ -101,6 +101,38 @@ class HybridEmbeddingLookupOpModel : public BaseEmbeddingLookupOpModel {
   }
 };
 
+// A table of int8 rows, each with its own scale and zero point.
+class PerRowEmbeddingLookupOpModel : public SingleOpModel {
+ public:
+  PerRowEmbeddingLookupOpModel(std::initializer_list<int> index_shape,
+                               std::initializer_list<int> weight_shape,
+                               const std::vector<float>& scales,
+                               const std::vector<int64_t>& zero_points) {
+    input_ = AddInput(TensorType_INT32);
+    weight_ = AddInput(TensorData(TensorType_INT8, weight_shape, 0, 0, 0, 0,
+                                  /*per_channel_quantization=*/true, scales,
+                                  zero_points, /*channel_index=*/0));
+    output_ = AddOutput(TensorType_FLOAT32);
+    SetBuiltinOp(BuiltinOperator_EMBEDDING_LOOKUP, BuiltinOptions_NONE, 0);
+    BuildInterpreter({index_shape, weight_shape});
+  }
+
+  void SetInput(std::initializer_list<int> data) {
+    PopulateTensor(input_, data);
+  }
+
+  void SetWeight(std::initializer_list<int8_t> data) {
+    PopulateTensor(weight_, data);
+  }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int input_;
+  int weight_;
+  int output_;
+};
+
 // TODO(ahentz): write more tests that exercise the details of the op, such as
 // lookup errors and variable input shapes.
 TEST(EmbeddingLookupOpTest, SimpleTest) {
@@ -261,5 +293,25 @@ TEST(EmbeddingLookupHybridOpTest, Simple3DTestQuantized) {
               }));
 }
 
+TEST(EmbeddingLookupHybridOpTest, PerRowQuantizedInt8) {
+  // Rows of 9 values, to exercise the vectorized loops and their tails.
+  PerRowEmbeddingLookupOpModel m({3}, {3, 9}, {0.5f, 0.25f, 2.0f}, {0, -4, 10});
+  m.SetInput({1, 0, 2});
+  m.SetWeight({
+      0,   1,   2,   3,   4,  5,  6,  7,    -128,  // Row 0
+      -4,  0,   4,   8,   12, 16, 20, 24,   127,   // Row 1
+      10,  11,  9,   20,  0,  10, 10, -118, 10,    // Row 2
+  });
+
+  m.Invoke();
+
+  EXPECT_THAT(m.GetOutput(),
+              ElementsAreArray(ArrayFloatNear({
+                  0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 32.75,      // Row 1
+                  0.0, 0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, -64.0,      // Row 0
+                  0.0, 2.0, -2.0, 20.0, -20.0, 0.0, 0.0, -256.0, 0.0  // Row 2
+              })));
+}
+
 }  // namespace
 }  // namespace tflite
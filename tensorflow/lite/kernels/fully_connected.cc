@@ -742,6 +742,52 @@ void FullyConnectedInt8(const OpData* data, const TfLiteTensor* input,
         cpu_backend_context);
   }
 }
+
+// Full integer fully connected with sparse weights. The optimized kernels
+// only support weights with 1x16 blocks, which the converter emits for int8
+// weights.
+template <KernelType kernel_type>
+TfLiteStatus FullyConnectedSparseInt8(TfLiteContext* context,
+                                      const OpData* data,
+                                      const TfLiteTensor* input,
+                                      const TfLiteTensor* filter,
+                                      const TfLiteTensor* bias,
+                                      TfLiteTensor* output) {
+  const auto& sparsity = *filter->sparsity;
+  FullyConnectedParams op_params;
+  op_params.input_offset = -input->params.zero_point;
+  op_params.weights_offset = -filter->params.zero_point;
+  op_params.output_offset = output->params.zero_point;
+  op_params.output_multiplier = data->output_multiplier;
+  op_params.output_shift = data->output_shift;
+  op_params.quantized_activation_min = data->output_activation_min;
+  op_params.quantized_activation_max = data->output_activation_max;
+  if (kernel_type == kReference) {
+    reference_ops::FullyConnectedSparseWeight(
+        sparsity, op_params, GetTensorShape(input),
+        GetTensorData<int8_t>(input), GetTensorShape(filter),
+        GetTensorData<int8_t>(filter), GetTensorShape(bias),
+        GetTensorData<int32_t>(bias), GetTensorShape(output),
+        GetTensorData<int8_t>(output));
+    return kTfLiteOk;
+  }
+  if (!SupportedSparsityFormat(sparsity) ||
+      sparsity.dim_metadata_size != kDimMetadataSizeBlockSparse ||
+      sparsity.dim_metadata[2].dense_size != 16 ||
+      filter->params.zero_point != 0) {
+    TF_LITE_KERNEL_LOG(context,
+                       "Unsupported sparse fully-connected weight format.");
+    return kTfLiteError;
+  }
+  optimized_ops::FullyConnectedSparseWeight1x16(
+      sparsity, op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
+      GetTensorShape(filter), GetTensorData<int8_t>(filter),
+      /*per_channel_multiplier=*/nullptr, /*per_channel_shift=*/nullptr,
+      GetTensorShape(bias), GetTensorData<int32_t>(bias),
+      GetTensorShape(output), GetTensorData<int8_t>(output),
+      CpuBackendContext::GetFromContext(context));
+  return kTfLiteOk;
+}
 }  // namespace
 
 namespace {
@@ -821,9 +867,15 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
         }
         break;
       case kTfLiteInt8:
-        FullyConnectedInt8<kernel_type>(
-            data, input, filter, bias, output,
-            CpuBackendContext::GetFromContext(context));
+        if (filter->sparsity != nullptr) {
+          TF_LITE_ENSURE_OK(context, FullyConnectedSparseInt8<kernel_type>(
+                                         context, data, input, filter, bias,
+                                         output));
+        } else {
+          FullyConnectedInt8<kernel_type>(
+              data, input, filter, bias, output,
+              CpuBackendContext::GetFromContext(context));
+        }
         break;
       case kTfLiteInt16:
         if (input->type == kTfLiteInt16) {
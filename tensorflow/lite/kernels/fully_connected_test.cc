@@ -1686,6 +1686,93 @@ TEST_P(SparseHybridFullyConnectedOpTest, SparseHybrid1x16TestMultiThreaded) {
                 ElementsAreArray(ArrayFloatNear(expected, 1e-3)));
   }
 }
+
+// Full integer fully connected with int8 sparse weights, whose quantization
+// parameters are those of `weights`.
+class SparseQuantizedFullyConnectedOpModel : public SingleOpModel {
+ public:
+  SparseQuantizedFullyConnectedOpModel(TfLiteRegistration* registration,
+                                       int units, const TensorData& input,
+                                       const TensorData& weights,
+                                       const std::vector<int8_t>& weights_data,
+                                       const TensorData& output,
+                                       int num_threads = 1) {
+    input_ = AddInput(input);
+    weights_ = AddConstSparseInput(weights, weights_data);
+    bias_ = AddInput({TensorType_INT32, {units}, 0, 0,
+                      GetScale(input_) * weights.scale});
+    output_ = AddOutput(output);
+    SetBuiltinOp(
+        BuiltinOperator_FULLY_CONNECTED, BuiltinOptions_FullyConnectedOptions,
+        CreateFullyConnectedOptions(builder_, ActivationFunctionType_NONE)
+            .Union());
+    resolver_ = absl::make_unique<SingleOpResolver>(
+        BuiltinOperator_FULLY_CONNECTED, registration);
+    BuildInterpreter({GetShape(input_), GetShape(weights_), GetShape(bias_)},
+                     num_threads, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false);
+  }
+  void SetBias(const std::vector<float>& data) {
+    QuantizeAndPopulate<int32_t>(bias_, data);
+  }
+  void SetInput(const std::vector<float>& data) {
+    QuantizeAndPopulate<int8_t>(input_, data);
+  }
+  std::vector<float> GetDequantizedOutput() {
+    return Dequantize<int8_t>(ExtractVector<int8_t>(output_),
+                              GetScale(output_), GetZeroPoint(output_));
+  }
+  std::vector<int> GetOutputShape() { return GetTensorShape(output_); }
+
+ protected:
+  int input_;
+  int weights_;
+  int bias_;
+  int output_;
+};
+
+TEST_P(SparseFullyConnectedOpTest, Simple1x16Int8Test) {
+  // Row 1 has an empty first block and row 2 an empty second block.
+  std::vector<int8_t> weight_data = {
+      -3, 2, 0, -2, 3, 1, -1, -3, 2, 0, -2, 3, 1, -1, -3, 2,  // u = 0
+      0, -2, 3, 1, -1, -3, 2, 0, -2, 3, 1, -1, -3, 2, 0, -2,  // u = 0
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,         // u = 1
+      3, 1, -1, -3, 2, 0, -2, 3, 1, -1, -3, 2, 0, -2, 3, 1,   // u = 1
+      3, 1, -1, -3, 2, 0, -2, 3, 1, -1, -3, 2, 0, -2, 3, 1,   // u = 2
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,         // u = 2
+  };
+  TensorData weight = {};
+  weight.type = TensorType_INT8;
+  weight.shape = {3, 32};
+  weight.scale = 1.0f;
+  weight.traversal_order = {0, 1, 2};
+  weight.format = {kTfLiteDimDense, kTfLiteDimSparseCSR};
+  weight.block_map = {1};
+  weight.block_size = {16};
+  for (int num_threads : {1, 2}) {
+    SparseQuantizedFullyConnectedOpModel m(
+        GetRegistration(), /*units=*/3,
+        /*input=*/{TensorType_INT8, {2, 32}, -63.5, 64}, weight, weight_data,
+        /*output=*/{TensorType_INT8, {}, -63.5, 64}, num_threads);
+    m.SetBias({1.5, -2, 3});
+    m.SetInput({
+        // b = 0
+        -2, 0.5, -1.5, 1, -1, 1.5, -0.5, 2, 0, -2, 0.5, -1.5, 1, -1, 1.5, -0.5,
+        2, 0, -2, 0.5, -1.5, 1, -1, 1.5, -0.5, 2, 0, -2, 0.5, -1.5, 1, -1,
+        // b = 1
+        -1, 1.5, -0.5, 2, 0, -2, 0.5, -1.5, 1, -1, 1.5, -0.5, 2, 0, -2, 0.5,
+        -1.5, 1, -1, 1.5, -0.5, 2, 0, -2, 0.5, -1.5, 1, -1, 1.5, -0.5, 2, 0,
+    });
+
+    m.Invoke();
+
+    EXPECT_THAT(m.GetOutputShape(), ElementsAre(2, 3));
+    EXPECT_THAT(m.GetDequantizedOutput(),
+                ElementsAreArray(ArrayFloatNear({-12, 6.5, 4.5,  //
+                                                 -6, -12, -18.5})));
+  }
+}
+
 // TODO(b/148391360): Add tests for unsupported sparsity format.
 // TEST_P(SparseFullyConnectedOpTest, TestUnsupportedSparsityFormat)
 
@@ -1039,6 +1039,33 @@ void NeonMatrixBatchVectorMultiplyAccumulate(
                                       output_zp, scratch, output);
 }
 
+void NeonMatrixBatchVectorMultiplyAccumulate(
+    const int8_t* input, const int32_t* bias,
+    const int8_t* input_to_gate_weights, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_gates, int32_t n_batch, int32_t n_input,
+    int32_t n_output, int32_t* scratch, int16_t* const* outputs,
+    CpuBackendContext* context) {
+  // One matmul of all the gates, whose products of a batch are adjacent in
+  // scratch.
+  const int n_fused_output = n_gates * n_output;
+#ifdef TFLITE_WITH_RUY_GEMV
+  NeonCpuBackendGemm(input, bias, input_to_gate_weights, n_batch, n_input,
+                     n_fused_output, /*output_zp=*/0, scratch, context);
+#else
+  NeonMatrixBatchVectorMultiplyImpl(input, bias, input_to_gate_weights, n_batch,
+                                    n_input, n_fused_output, /*output_zp=*/0,
+                                    scratch);
+#endif
+  for (int batch = 0; batch < n_batch; ++batch) {
+    for (int gate = 0; gate < n_gates; ++gate) {
+      NeonMatrixBatchVectorAccumulateImpl(
+          multipliers[gate], shifts[gate], /*n_batch=*/1, n_output,
+          /*output_zp=*/0, scratch + batch * n_fused_output + gate * n_output,
+          outputs[gate] + batch * n_output);
+    }
+  }
+}
+
 void NeonMatrixBatchVectorMultiplyAccumulate(const int8_t* __restrict__ matrix,
                                              const int m_rows, const int m_cols,
                                              const int8_t* __restrict__ vectors,
@@ -1929,6 +1956,61 @@ void NeonSparseMatrixBatchVectorMultiplyAccumulate1x4(
   }
 }
 
+void NeonSparseMatrixBatchVectorMultiplyAccumulate1x16(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, int32_t input_offset, int32_t output_multiplier,
+    int32_t output_shift, const int32_t* per_channel_multiplier,
+    const int32_t* per_channel_shift, int32_t output_offset,
+    int32_t output_activation_min, int32_t output_activation_max,
+    int8_t* __restrict__ result) {
+  constexpr int kBlockSize = kInt8ValuesPerNeonVector;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+
+  for (int batch = 0; batch < n_batch; ++batch) {
+    const int8_t* matrix_ptr = matrix;
+    const int8_t* vector_in_batch = vector + batch * m_cols;
+    for (int row = 0; row < m_rows; ++row) {
+      int32x4_t dotprod_32x4 = vmovq_n_s32(0);
+      // Sum of the matrix values of the row, to add the input offset.
+      int32x4_t row_sum_32x4 = vmovq_n_s32(0);
+      for (int i = segments[row]; i < segments[row + 1]; ++i) {
+        const int block_start_index = indices[i] * kBlockSize;
+        const int8x16_t vector_8x16 =
+            vld1q_s8(vector_in_batch + block_start_index);
+        const int8x16_t matrix_8x16 = vld1q_s8(matrix_ptr);
+        // The products of one half can't overflow 16 bits but their sum can,
+        // as the vector values are in [-128, 127].
+        const int16x8_t prod_low_16x8 =
+            vmull_s8(vget_low_s8(vector_8x16), vget_low_s8(matrix_8x16));
+        const int16x8_t prod_high_16x8 =
+            vmull_s8(vget_high_s8(vector_8x16), vget_high_s8(matrix_8x16));
+        dotprod_32x4 = vpadalq_s16(dotprod_32x4, prod_low_16x8);
+        dotprod_32x4 = vpadalq_s16(dotprod_32x4, prod_high_16x8);
+        row_sum_32x4 = vpadalq_s16(row_sum_32x4, vpaddlq_s8(matrix_8x16));
+        matrix_ptr += kBlockSize;
+      }
+      int32_t dot_prod = AccumulateNeonLane(dotprod_32x4) +
+                         input_offset * AccumulateNeonLane(row_sum_32x4);
+      if (bias_vector != nullptr) {
+        dot_prod += bias_vector[row];
+      }
+      if (per_channel_multiplier != nullptr) {
+        dot_prod = MultiplyByQuantizedMultiplier(
+            dot_prod, per_channel_multiplier[row], per_channel_shift[row]);
+      } else {
+        dot_prod = MultiplyByQuantizedMultiplier(dot_prod, output_multiplier,
+                                                 output_shift);
+      }
+      dot_prod += output_offset;
+      result[batch * m_rows + row] = static_cast<int8_t>(
+          std::min(std::max(dot_prod, output_activation_min),
+                   output_activation_max));
+    }
+  }
+}
+
 void NeonSparseMatrixBatchVectorMultiplyAccumulate(
     const float* __restrict__ matrix, const uint8_t* __restrict__ ledger,
     int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
@@ -2226,6 +2308,34 @@ void NeonVectorScalarMultiply(const int8_t* vector, const int v_size,
   }
 }
 
+void NeonVectorScalarMultiply(const int8_t* vector, const int v_size,
+                              const int32_t zero_point, const float scale,
+                              float* result) {
+  const int postamble_start =
+      RoundDownVectors<(kInt8ValuesPerNeonVector >> 1)>(v_size);
+  const int16x8_t zero_point_i16x8 = vdupq_n_s16(zero_point);
+  const float32x4_t scale_f32x4 = vdupq_n_f32(scale);
+  int v = 0;
+  for (; v < postamble_start; v += (kInt8ValuesPerNeonVector >> 1)) {
+    // Load eight int8 values, and subtract the zero point in int16, which
+    // can't overflow.
+    const int16x8_t v_i16x8 =
+        vsubq_s16(vmovl_s8(vld1_s8(vector + v)), zero_point_i16x8);
+    // Convert the two halves to floats and scale them.
+    const float32x4_t v0_f32x4 =
+        vcvtq_f32_s32(vmovl_s16(vget_low_s16(v_i16x8)));
+    const float32x4_t v1_f32x4 =
+        vcvtq_f32_s32(vmovl_s16(vget_high_s16(v_i16x8)));
+    vst1q_f32(result + v, vmulq_f32(v0_f32x4, scale_f32x4));
+    vst1q_f32(result + v + 4, vmulq_f32(v1_f32x4, scale_f32x4));
+  }
+
+  // Postamble loop.
+  for (; TFLITE_UNLIKELY(v < v_size); v++) {
+    result[v] = scale * (vector[v] - zero_point);
+  }
+}
+
 // TODO(b/185850916): Consider changing the rounding stragey from "ties to away"
 // to "ties to even" since vcvtnq_s32_f32 is generally more available.
 inline int32x4_t RoundToNearest(const float32x4_t input) {
@@ -99,6 +99,13 @@ void NeonMatrixBatchVectorMultiplyAccumulate(
     int32_t n_batch, int32_t n_input, int32_t n_output, int32_t output_zp,
     int32_t* scratch, int16_t* output, CpuBackendContext* context);
 
+void NeonMatrixBatchVectorMultiplyAccumulate(
+    const int8_t* input, const int32_t* bias,
+    const int8_t* input_to_gate_weights, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_gates, int32_t n_batch, int32_t n_input,
+    int32_t n_output, int32_t* scratch, int16_t* const* outputs,
+    CpuBackendContext* context);
+
 void NeonMatrixScalarMultiplyAccumulate(const int8_t* matrix, int32_t scalar,
                                         int32_t n_row, int32_t n_col,
                                         int32_t* output);
@@ -108,6 +115,16 @@ void NeonSparseMatrixBatchVectorMultiplyAccumulate1x4(
     const int32_t* __restrict__ indices, int m_rows, int m_cols,
     const float* __restrict__ vector, int n_batch, float* __restrict__ result);
 
+void NeonSparseMatrixBatchVectorMultiplyAccumulate1x16(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, int32_t input_offset, int32_t output_multiplier,
+    int32_t output_shift, const int32_t* per_channel_multiplier,
+    const int32_t* per_channel_shift, int32_t output_offset,
+    int32_t output_activation_min, int32_t output_activation_max,
+    int8_t* __restrict__ result);
+
 // Multiply a matrix by a batch vector, and store results in a batch-size
 // vector. Sparse version.
 void NeonSparseMatrixBatchVectorMultiplyAccumulate(
@@ -135,6 +152,10 @@ void NeonSub1Vector(const int16_t* vector, int v_size, int16_t* result);
 void NeonVectorScalarMultiply(const int8_t* vector, int v_size, float scale,
                               float* result);
 
+// Multiply all elements of vector, minus zero_point, with a scalar.
+void NeonVectorScalarMultiply(const int8_t* vector, int v_size,
+                              int32_t zero_point, float scale, float* result);
+
 // Check if all entries of a vector are zero.
 bool NeonIsZeroVector(const float* vector, int v_size);
 
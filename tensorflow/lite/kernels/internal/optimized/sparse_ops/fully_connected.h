@@ -201,6 +201,123 @@ inline void FullyConnectedSparseWeight1x4(
                                   cpu_backend_context);
 }
 
+inline void FullyConnectedSparseWeight1x16Impl(
+    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const int8_t* input_data,
+    const RuntimeShape& weights_shape, const int8_t* weights_data,
+    const int32_t* per_channel_multiplier, const int32_t* per_channel_shift,
+    const RuntimeShape& bias_shape, const int32_t* bias_data,
+    const RuntimeShape& output_shape, int8_t* output_data, int thread_start,
+    int thread_end) {
+  ruy::profiler::ScopeLabel label("FullyConnectedInt8");
+  ruy::profiler::ScopeLabel inner_label("1x16 Block Sparse");
+  const int input_dims_count = input_shape.DimensionsCount();
+  const int output_dims_count = output_shape.DimensionsCount();
+  const int weights_dims_count = weights_shape.DimensionsCount();
+  const int batches = thread_end - thread_start;
+  const int input_depth = MatchingDim(weights_shape, weights_dims_count - 1,
+                                      input_shape, input_dims_count - 1);
+  const int output_depth = MatchingDim(weights_shape, weights_dims_count - 2,
+                                       output_shape, output_dims_count - 1);
+  const int* w1_segments = sparsity.dim_metadata[1].array_segments->data;
+  const int* w1_indices = sparsity.dim_metadata[1].array_indices->data;
+
+  tensor_utils::SparseMatrixBatchVectorMultiplyAccumulate1x16(
+      weights_data, w1_segments, w1_indices, output_depth, input_depth,
+      input_data + thread_start * input_depth, bias_data, batches,
+      params.input_offset, params.output_multiplier, params.output_shift,
+      per_channel_multiplier, per_channel_shift, params.output_offset,
+      params.quantized_activation_min, params.quantized_activation_max,
+      output_data + thread_start * output_depth);
+}
+
+struct FullyConnectedSparseWeight1x16Task : cpu_backend_threadpool::Task {
+  FullyConnectedSparseWeight1x16Task(
+      const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+      const RuntimeShape& input_shape, const int8_t* input_data,
+      const RuntimeShape& weights_shape, const int8_t* weights_data,
+      const int32_t* per_channel_multiplier, const int32_t* per_channel_shift,
+      const RuntimeShape& bias_shape, const int32_t* bias_data,
+      const RuntimeShape& output_shape, int8_t* output_data, int thread_start,
+      int thread_end)
+      : sparsity(sparsity),
+        params(params),
+        input_shape(input_shape),
+        input_data(input_data),
+        weights_shape(weights_shape),
+        weights_data(weights_data),
+        per_channel_multiplier(per_channel_multiplier),
+        per_channel_shift(per_channel_shift),
+        bias_shape(bias_shape),
+        bias_data(bias_data),
+        output_shape(output_shape),
+        output_data(output_data),
+        thread_start(thread_start),
+        thread_end(thread_end) {}
+
+  void Run() override {
+    FullyConnectedSparseWeight1x16Impl(
+        sparsity, params, input_shape, input_data, weights_shape, weights_data,
+        per_channel_multiplier, per_channel_shift, bias_shape, bias_data,
+        output_shape, output_data, thread_start, thread_end);
+  }
+
+ private:
+  const TfLiteSparsity& sparsity;
+  const FullyConnectedParams& params;
+  const RuntimeShape& input_shape;
+  const int8_t* input_data;
+  const RuntimeShape& weights_shape;
+  const int8_t* weights_data;
+  const int32_t* per_channel_multiplier;
+  const int32_t* per_channel_shift;
+  const RuntimeShape& bias_shape;
+  const int32_t* bias_data;
+  const RuntimeShape& output_shape;
+  int8_t* output_data;
+  int thread_start;
+  int thread_end;
+};
+
+// Full integer fully connected with int8 weights stored with 1x16 blocks,
+// per-tensor quantized or, if `per_channel_multiplier` and `per_channel_shift`
+// are not null, per output channel. Sliced along the batch dimension for
+// multi-threading like FullyConnectedSparseWeight1x4.
+inline void FullyConnectedSparseWeight1x16(
+    const TfLiteSparsity& sparsity, const FullyConnectedParams& params,
+    const RuntimeShape& input_shape, const int8_t* input_data,
+    const RuntimeShape& weights_shape, const int8_t* weights_data,
+    const int32_t* per_channel_multiplier, const int32_t* per_channel_shift,
+    const RuntimeShape& bias_shape, const int32_t* bias_data,
+    const RuntimeShape& output_shape, int8_t* output_data,
+    CpuBackendContext* cpu_backend_context) {
+  const int max_threads = cpu_backend_context->max_num_threads();
+  const int batches =
+      FlatSizeSkipDim(output_shape, output_shape.DimensionsCount() - 1);
+  const int thread_count = std::max(1, std::min(batches, max_threads));
+  if (thread_count == 1) {
+    return FullyConnectedSparseWeight1x16Impl(
+        sparsity, params, input_shape, input_data, weights_shape, weights_data,
+        per_channel_multiplier, per_channel_shift, bias_shape, bias_data,
+        output_shape, output_data, 0, batches);
+  }
+  std::vector<FullyConnectedSparseWeight1x16Task> tasks;
+  tasks.reserve(thread_count);
+  int thread_start = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    int thread_end = thread_start + batches / thread_count;
+    if (i < batches % thread_count) thread_end++;
+
+    tasks.emplace_back(sparsity, params, input_shape, input_data, weights_shape,
+                       weights_data, per_channel_multiplier, per_channel_shift,
+                       bias_shape, bias_data, output_shape, output_data,
+                       thread_start, thread_end);
+    thread_start = thread_end;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
+}
+
 }  // namespace optimized_ops
 }  // namespace tflite
 #endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_SPARSE_OPS_FULLY_CONNECTED_H_
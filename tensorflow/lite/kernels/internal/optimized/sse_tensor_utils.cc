@@ -25,12 +25,14 @@ limitations under the License.
 #include <immintrin.h>
 #endif
 
+#include <algorithm>
 #include <cstdint>
 
 #include "ruy/profiler/instrumentation.h"  // from @ruy
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm.h"
 #include "tensorflow/lite/kernels/cpu_backend_gemm_params.h"
+#include "tensorflow/lite/kernels/internal/common.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 
 namespace tflite {
@@ -506,6 +508,60 @@ void SseSparseMatrixBatchVectorMultiplyAccumulate(
   }  // for batch
 }
 
+void SseSparseMatrixBatchVectorMultiplyAccumulate1x16(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, int32_t input_offset, int32_t output_multiplier,
+    int32_t output_shift, const int32_t* per_channel_multiplier,
+    const int32_t* per_channel_shift, int32_t output_offset,
+    int32_t output_activation_min, int32_t output_activation_max,
+    int8_t* __restrict__ result) {
+  static const std::intptr_t kBlockSize = 16;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  const __m128i ones_8x16 = _mm_set1_epi8(1);
+
+  for (int batch = 0; batch < n_batch; ++batch) {
+    const int8_t* __restrict__ matrix_ptr = matrix;
+    const int8_t* __restrict__ vector_in_batch = vector + batch * m_cols;
+    for (std::intptr_t row = 0; row < m_rows; ++row) {
+      __m128i dotprod_32x4 = _mm_setzero_si128();
+      // Sum of the matrix values of the row, to add the input offset.
+      __m128i row_sum_32x4 = _mm_setzero_si128();
+      for (std::intptr_t i = segments[row]; i < segments[row + 1]; ++i) {
+        const std::intptr_t col_index = indices[i] * kBlockSize;
+        const __m128i vec_8x16 = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(vector_in_batch + col_index));
+        const __m128i row_8x16 =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(matrix_ptr));
+        // DotProdInt8x4x4 negates its second argument where the first one is
+        // negative, so the vector, which may hold -128, goes first.
+        dotprod_32x4 =
+            _mm_add_epi32(dotprod_32x4, DotProdInt8x4x4(vec_8x16, row_8x16));
+        row_sum_32x4 =
+            _mm_add_epi32(row_sum_32x4, DotProdInt8x4x4(ones_8x16, row_8x16));
+        matrix_ptr += kBlockSize;
+      }
+      int32_t dot_prod = ReduceInt32x4(dotprod_32x4) +
+                         input_offset * ReduceInt32x4(row_sum_32x4);
+      if (bias_vector != nullptr) {
+        dot_prod += bias_vector[row];
+      }
+      if (per_channel_multiplier != nullptr) {
+        dot_prod = MultiplyByQuantizedMultiplier(
+            dot_prod, per_channel_multiplier[row], per_channel_shift[row]);
+      } else {
+        dot_prod = MultiplyByQuantizedMultiplier(dot_prod, output_multiplier,
+                                                 output_shift);
+      }
+      dot_prod += output_offset;
+      result[batch * m_rows + row] = static_cast<int8_t>(
+          std::min(std::max(dot_prod, output_activation_min),
+                   output_activation_max));
+    }
+  }
+}
+
 void SseReductionSumVector(const int8_t* input_vector, int32_t* output_vector,
                            const int output_size, const int reduction_size) {
   static constexpr std::intptr_t kBlockSize = 16;
@@ -544,6 +600,36 @@ void SseReductionSumVector(const int8_t* input_vector, int32_t* output_vector,
   }
 }
 
+void SseVectorScalarMultiply(const int8_t* vector, const int v_size,
+                             const int32_t zero_point, const float scale,
+                             float* result) {
+  int v = 0;
+#ifdef __AVX2__
+  const __m256i zero_point_32x8 = _mm256_set1_epi32(zero_point);
+  const __m256 scale_f32x8 = _mm256_set1_ps(scale);
+  for (; v <= v_size - 8; v += 8) {
+    const __m256i v_32x8 = _mm256_cvtepi8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(vector + v)));
+    const __m256 v_f32x8 =
+        _mm256_cvtepi32_ps(_mm256_sub_epi32(v_32x8, zero_point_32x8));
+    _mm256_storeu_ps(result + v, _mm256_mul_ps(v_f32x8, scale_f32x8));
+  }
+#endif
+#ifdef __SSE4_1__
+  const __m128i zero_point_32x4 = _mm_set1_epi32(zero_point);
+  const __m128 scale_f32x4 = _mm_set1_ps(scale);
+  for (; v <= v_size - 4; v += 4) {
+    const __m128i v_32x4 = _mm_cvtepi8_epi32(_mm_loadu_si32(vector + v));
+    const __m128 v_f32x4 =
+        _mm_cvtepi32_ps(_mm_sub_epi32(v_32x4, zero_point_32x4));
+    _mm_storeu_ps(result + v, _mm_mul_ps(v_f32x4, scale_f32x4));
+  }
+#endif
+  for (; v < v_size; ++v) {
+    result[v] = scale * (vector[v] - zero_point);
+  }
+}
+
 }  // namespace tensor_utils
 }  // namespace tflite
 
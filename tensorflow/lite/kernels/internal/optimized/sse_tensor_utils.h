@@ -101,6 +101,22 @@ void SparseMatrixBatchVectorMultiplyAccumulate(
                   m_rows, m_cols, vectors, scaling_factors, n_batch, result);
 }
 
+void SparseMatrixBatchVectorMultiplyAccumulate1x16(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, int32_t input_offset, int32_t output_multiplier,
+    int32_t output_shift, const int32_t* per_channel_multiplier,
+    const int32_t* per_channel_shift, int32_t output_offset,
+    int32_t output_activation_min, int32_t output_activation_max,
+    int8_t* __restrict__ result) {
+  SSE_OR_PORTABLE(SparseMatrixBatchVectorMultiplyAccumulate1x16,
+                  matrix, segments, indices, m_rows, m_cols, vector, bias_vector, n_batch,
+                  input_offset, output_multiplier, output_shift, per_channel_multiplier,
+                  per_channel_shift, output_offset, output_activation_min,
+                  output_activation_max, result);
+}
+
 void MatrixBatchVectorMultiplyAccumulate(
     const int8_t* input, const int32_t* input_zeropoint_times_weights,
     const int8_t* input_to_gate_weights, int32_t multiplier, int32_t shift,
@@ -121,6 +137,17 @@ void MatrixBatchVectorMultiplyAccumulate(
       shift, n_batch, n_input, n_output, output_zp, scratch, output, context);
 }
 
+void MatrixBatchVectorMultiplyAccumulate(
+    const int8_t* input, const int32_t* bias,
+    const int8_t* input_to_gate_weights, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_gates, int32_t n_batch, int32_t n_input,
+    int32_t n_output, int32_t* scratch, int16_t* const* outputs,
+    CpuBackendContext* context) {
+  PortableMatrixBatchVectorMultiplyAccumulate(
+      input, bias, input_to_gate_weights, multipliers, shifts, n_gates, n_batch,
+      n_input, n_output, scratch, outputs, context);
+}
+
 void MatrixBatchVectorMultiply(const int8_t* input, int32_t input_zeropoint,
                                const int8_t* input_to_gate_weights,
                                int32_t input_to_gate_effective_scale_a,
@@ -266,6 +293,12 @@ void VectorScalarMultiply(const int8_t* vector, int v_size, float scale,
   NEON_OR_PORTABLE(VectorScalarMultiply, vector, v_size, scale, result);
 }
 
+void VectorScalarMultiply(const int8_t* vector, int v_size, int32_t zero_point,
+                          float scale, float* result) {
+  SSE_OR_PORTABLE(VectorScalarMultiply, vector, v_size, zero_point, scale,
+                  result);
+}
+
 void SymmetricQuantizeFloats(const float* values, const int size,
                              int8_t* quantized_values, float* min_value,
                              float* max_value, float* scaling_factor) {
@@ -227,6 +227,49 @@ void PortableSparseMatrixBatchVectorMultiplyAccumulate1x4(
   }
 }
 
+void PortableSparseMatrixBatchVectorMultiplyAccumulate1x16(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, int32_t input_offset, int32_t output_multiplier,
+    int32_t output_shift, const int32_t* per_channel_multiplier,
+    const int32_t* per_channel_shift, int32_t output_offset,
+    int32_t output_activation_min, int32_t output_activation_max,
+    int8_t* __restrict__ result) {
+  const int kBlockSize = 16;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+  for (int batch = 0; batch < n_batch; ++batch) {
+    const int8_t* matrix_ptr = matrix;
+    const int8_t* vector_in_batch = vector + batch * m_cols;
+    for (int row = 0; row < m_rows; ++row) {
+      int32_t dot_prod = 0;
+      for (int i = segments[row]; i < segments[row + 1]; ++i) {
+        const int block_start_index = indices[i] * kBlockSize;
+        const int8_t* vector_block_in_batch_ptr =
+            vector_in_batch + block_start_index;
+        for (int c = 0; c < kBlockSize; c++) {
+          dot_prod += *matrix_ptr++ * (*vector_block_in_batch_ptr++ +
+                                       input_offset);
+        }
+      }
+      if (bias_vector != nullptr) {
+        dot_prod += bias_vector[row];
+      }
+      if (per_channel_multiplier != nullptr) {
+        dot_prod = MultiplyByQuantizedMultiplier(
+            dot_prod, per_channel_multiplier[row], per_channel_shift[row]);
+      } else {
+        dot_prod = MultiplyByQuantizedMultiplier(dot_prod, output_multiplier,
+                                                 output_shift);
+      }
+      dot_prod += output_offset;
+      result[batch * m_rows + row] = static_cast<int8_t>(
+          std::min(std::max(dot_prod, output_activation_min),
+                   output_activation_max));
+    }
+  }
+}
+
 void PortableSparseMatrixBatchVectorMultiplyAccumulate(
     const float* __restrict__ matrix, const uint8_t* __restrict__ ledger,
     int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
@@ -339,6 +382,21 @@ void PortableMatrixBatchVectorMultiplyAccumulate(
       n_output, output_zp, output);
 }
 
+void PortableMatrixBatchVectorMultiplyAccumulate(
+    const int8_t* input, const int32_t* bias,
+    const int8_t* input_to_gate_weights, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_gates, int32_t n_batch, int32_t n_input,
+    int32_t n_output, int32_t* scratch, int16_t* const* outputs,
+    CpuBackendContext* context) {
+  for (int gate = 0; gate < n_gates; ++gate) {
+    PortableMatrixBatchVectorMultiplyAccumulateImpl(
+        input, bias + gate * n_output,
+        input_to_gate_weights + gate * n_output * n_input, multipliers[gate],
+        shifts[gate], n_batch, n_input, n_output, /*output_zp=*/0,
+        outputs[gate]);
+  }
+}
+
 void PortableMatrixBatchVectorMultiply(const int8_t* input,
                                        int32_t input_zeropoint,
                                        const int8_t* input_to_gate_weights,
@@ -715,6 +773,14 @@ void PortableVectorScalarMultiply(const int8_t* vector, const int v_size,
   }
 }
 
+void PortableVectorScalarMultiply(const int8_t* vector, const int v_size,
+                                  const int32_t zero_point, const float scale,
+                                  float* result) {
+  for (int v = 0; v < v_size; ++v) {
+    *result++ = scale * (*vector++ - zero_point);
+  }
+}
+
 void PortableMeanStddevNormalization(const float* __restrict__ input_vector,
                                      float* __restrict__ output_vector,
                                      int v_size, int n_batch) {
@@ -138,6 +138,32 @@ void MatrixBatchVectorMultiplyAccumulate(
     int32_t n_batch, int32_t n_input, int32_t n_output, int32_t output_zp,
     int32_t* scratch, int8_t* output, CpuBackendContext* context);
 
+// Same as the 16 bit output MatrixBatchVectorMultiplyAccumulate above, but for
+// the matmuls of several gates at once, which reads each input vector only
+// once for all of them.
+// Parameters:
+//     - input: batch vector of size n_batch * n_input
+//     - bias: vector of size n_gates * n_output, the biases of all gates
+//     - input_to_gate_weights: matrix of size (n_gates * n_output) * n_input,
+//       the weights of all gates stacked on top of each other
+//     - multipliers, shifts: vectors of size n_gates, the scale of each gate
+//     - n_gates: the number of gates
+//     - n_batch: the batch size
+//     - n_input: the input size
+//     - n_output: the output size of each gate
+//     - scratch: batch vector of size n_batch * n_gates * n_output
+//     - outputs: n_gates 16 bit outputs, of size n_batch * n_output each
+// Notes:
+//     - the output zero point is 0, as for all gates.
+//     - accumulates into each output exactly like one call of the function
+//       above per gate would.
+void MatrixBatchVectorMultiplyAccumulate(
+    const int8_t* input, const int32_t* bias,
+    const int8_t* input_to_gate_weights, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_gates, int32_t n_batch, int32_t n_input,
+    int32_t n_output, int32_t* scratch, int16_t* const* outputs,
+    CpuBackendContext* context);
+
 // Apply Rectified Linear to elements of a vector.
 inline void ApplyReluToVector(const float* __restrict__ vector, int v_size,
                               float* __restrict__ result) {
@@ -154,6 +154,26 @@ void SparseMatrixBatchVectorMultiplyAccumulate(
     const float* __restrict__ scaling_factors, int n_batch,
     float* __restrict__ result);
 
+// Multiplies a matrix of int8 values stored in block compressed sparse row
+// format with block pattern 1x16, the layout of the `segments` and `indices`
+// arrays of a TfLiteSparsity, by a batch of int8 vectors with `input_offset`
+// added to them, adds `bias_vector` (if not null) and requantizes the results
+// to int8 like the full integer fully connected kernels. The rows are rescaled
+// by `per_channel_multiplier` and `per_channel_shift` if they are not null,
+// and by `output_multiplier` and `output_shift` otherwise. The results are
+// written to `result`, of shape [n_batch, m_rows], not accumulated.
+// This function assumes that m_cols is a multiple of 16 so that there's no
+// incomplete block, and that the matrix values are in [-127, 127].
+void SparseMatrixBatchVectorMultiplyAccumulate1x16(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, int32_t input_offset, int32_t output_multiplier,
+    int32_t output_shift, const int32_t* per_channel_multiplier,
+    const int32_t* per_channel_shift, int32_t output_offset,
+    int32_t output_activation_min, int32_t output_activation_max,
+    int8_t* __restrict__ result);
+
 // Same as the above 8, 8, 8 integer matmul except for the presence of zero
 // point and non-accumulative.
 // TODO(b/148688698): remove this function by folding zero point calculation in
@@ -347,6 +367,12 @@ void Sub1Vector(const int16_t* vector, int v_size, int16_t* result);
 void VectorScalarMultiply(const int8_t* vector, int v_size, float scale,
                           float* result);
 
+// Multiply all elements of vector, minus zero_point, with a scalar, i.e.
+// dequantize an asymmetrically quantized vector. Unlike the symmetric version
+// above, vector needs no alignment.
+void VectorScalarMultiply(const int8_t* vector, int v_size, int32_t zero_point,
+                          float scale, float* result);
+
 // Reduce-sum on a float input vector:
 // input_vector: float pointer to input vector.
 // output_vector: float pointer to vector.
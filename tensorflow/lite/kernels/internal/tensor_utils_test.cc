@@ -76,6 +76,25 @@ TEST(uKernels, VectorScalarMultiply) {
                    0.6,  0.7,  0.8,  0.9,  1.0,  1.1,  1.2,  1.3,  1.4})));
 }
 
+TEST(uKernels, VectorScalarMultiplyWithZeroPoint) {
+  constexpr int kVectorSize = 29;
+  // Starts at an odd address, as the rows of a table can.
+  static int8_t buffer[kVectorSize + 1];
+  int8_t* input = buffer + 1;
+  for (int i = 0; i < kVectorSize; ++i) {
+    input[i] = static_cast<int8_t>(i - 10);
+  }
+  const float scale = 0.1f;
+  std::vector<float> output(kVectorSize, 0.0f);
+  VectorScalarMultiply(input, kVectorSize, /*zero_point=*/4, scale,
+                       output.data());
+  EXPECT_THAT(output,
+              ElementsAreArray(ArrayFloatNear(
+                  {-1.4, -1.3, -1.2, -1.1, -1.0, -0.9, -0.8, -0.7, -0.6, -0.5,
+                   -0.4, -0.3, -0.2, -0.1, 0,    0.1,  0.2,  0.3,  0.4,  0.5,
+                   0.6,  0.7,  0.8,  0.9,  1.0,  1.1,  1.2,  1.3,  1.4})));
+}
+
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
 
 // Test if a float array if full of zero values.
@@ -409,6 +428,49 @@ TEST(uKernels, QuantMatrixBatchVectorMultiplyAccumulate8x8_16Test) {
   EXPECT_THAT(output, testing::ElementsAreArray(expected_output));
 }
 
+TEST(uKernels, QuantMatrixBatchVectorMultiplyAccumulate8x8_16GatesTest) {
+  CpuBackendContext context;
+  const int n_gates = 3;
+  const int n_batch = 2;
+  const int n_input = 20;
+  const int n_output = 5;
+  std::vector<int8_t> input(n_batch * n_input);
+  std::vector<int32_t> bias(n_gates * n_output);
+  std::vector<int8_t> weights(n_gates * n_output * n_input);
+  for (int i = 0; i < input.size(); ++i) input[i] = (i * 37) % 101 - 50;
+  for (int i = 0; i < bias.size(); ++i) bias[i] = (i * 71) % 301 - 150;
+  for (int i = 0; i < weights.size(); ++i) weights[i] = (i * 13) % 51 - 25;
+  const std::vector<int32_t> multipliers = {2080364544, 1374389535, 1717986918};
+  const std::vector<int32_t> shifts = {-2, -1, -4};
+
+  // Each gate starts from different values and is rescaled differently.
+  std::vector<std::vector<int16_t>> expected_outputs;
+  std::vector<std::vector<int16_t>> outputs;
+  std::vector<int32_t> scratch(n_batch * n_gates * n_output);
+  for (int gate = 0; gate < n_gates; ++gate) {
+    std::vector<int16_t> output(n_batch * n_output);
+    for (int i = 0; i < output.size(); ++i) output[i] = gate * 100 - i * 7;
+    outputs.push_back(output);
+    MatrixBatchVectorMultiplyAccumulate(
+        input.data(), bias.data() + gate * n_output,
+        weights.data() + gate * n_output * n_input, multipliers[gate],
+        shifts[gate], n_batch, n_input, n_output, /*output_zp=*/0,
+        scratch.data(), output.data(), &context);
+    expected_outputs.push_back(output);
+  }
+
+  std::vector<int16_t*> output_ptrs;
+  for (auto& output : outputs) output_ptrs.push_back(output.data());
+  MatrixBatchVectorMultiplyAccumulate(
+      input.data(), bias.data(), weights.data(), multipliers.data(),
+      shifts.data(), n_gates, n_batch, n_input, n_output, scratch.data(),
+      output_ptrs.data(), &context);
+  for (int gate = 0; gate < n_gates; ++gate) {
+    EXPECT_THAT(outputs[gate],
+                testing::ElementsAreArray(expected_outputs[gate]));
+  }
+}
+
 TEST(uKernels, HybridMatrixBatchVectorMultiplyAccumulate8x8_16Test) {
   CpuBackendContext context;
   const std::vector<int8_t> input = {
@@ -1552,6 +1614,82 @@ TEST(uKernels, SparseMatrixBatchVectorMultiplyAccumulateTest) {
               ElementsAreArray(ArrayFloatNear(dense_output, 1e-4)));
 }
 
+TEST(uKernels, SparseMatrixBatchVectorMultiplyAccumulate1x16Test) {
+  const int kRow = 4;
+  const int kCol = 48;
+  const int kBatch = 3;
+  const int kBlockSize = 16;
+  const int32_t kInputOffset = 3;
+  const int32_t kOutputOffset = -5;
+  // Non-zero blocks of each row, as block column indices.
+  const std::vector<std::vector<int32_t>> kBlocks = {{0, 2}, {1}, {}, {0, 1, 2}};
+
+  std::vector<int8_t> matrix(kRow * kCol, 0);
+  std::vector<int8_t> matrix_values;
+  std::vector<int32_t> segments = {0};
+  std::vector<int32_t> indices;
+  for (int row = 0; row < kRow; ++row) {
+    for (int32_t block : kBlocks[row]) {
+      for (int c = 0; c < kBlockSize; ++c) {
+        const int8_t value = ((row * 37 + block * 11 + c * 13) % 255) - 127;
+        matrix[row * kCol + block * kBlockSize + c] = value;
+        matrix_values.push_back(value);
+      }
+      indices.push_back(block);
+    }
+    segments.push_back(indices.size());
+  }
+  std::vector<int8_t> vector(kBatch * kCol);
+  for (int i = 0; i < vector.size(); ++i) {
+    vector[i] = (i * 29 % 256) - 128;
+  }
+  const std::vector<int32_t> bias = {100, -2000, 30, 4000};
+  const std::vector<int32_t> multipliers = {1 << 30, 1 << 29, 1 << 30,
+                                            1518500250};
+  const std::vector<int32_t> shifts = {-8, -7, 0, -9};
+
+  // Computes the expected result with the dense matrix.
+  auto expected = [&](const int32_t* per_channel_multiplier,
+                      const int32_t* per_channel_shift) {
+    std::vector<int8_t> result(kBatch * kRow);
+    for (int batch = 0; batch < kBatch; ++batch) {
+      for (int row = 0; row < kRow; ++row) {
+        int32_t acc = bias[row];
+        for (int col = 0; col < kCol; ++col) {
+          acc += matrix[row * kCol + col] *
+                 (vector[batch * kCol + col] + kInputOffset);
+        }
+        acc = MultiplyByQuantizedMultiplier(
+            acc, per_channel_multiplier ? per_channel_multiplier[row]
+                                        : multipliers[0],
+            per_channel_shift ? per_channel_shift[row] : shifts[0]);
+        acc = std::min(std::max(acc + kOutputOffset, -100), 120);
+        result[batch * kRow + row] = static_cast<int8_t>(acc);
+      }
+    }
+    return result;
+  };
+
+  std::vector<int8_t> result(kBatch * kRow);
+  SparseMatrixBatchVectorMultiplyAccumulate1x16(
+      matrix_values.data(), segments.data(), indices.data(), kRow, kCol,
+      vector.data(), bias.data(), kBatch, kInputOffset, multipliers[0],
+      shifts[0], /*per_channel_multiplier=*/nullptr,
+      /*per_channel_shift=*/nullptr, kOutputOffset,
+      /*output_activation_min=*/-100, /*output_activation_max=*/120,
+      result.data());
+  EXPECT_THAT(result, ElementsAreArray(expected(nullptr, nullptr)));
+
+  SparseMatrixBatchVectorMultiplyAccumulate1x16(
+      matrix_values.data(), segments.data(), indices.data(), kRow, kCol,
+      vector.data(), bias.data(), kBatch, kInputOffset, 0, 0,
+      multipliers.data(), shifts.data(), kOutputOffset,
+      /*output_activation_min=*/-100, /*output_activation_max=*/120,
+      result.data());
+  EXPECT_THAT(result,
+              ElementsAreArray(expected(multipliers.data(), shifts.data())));
+}
+
 #ifdef __ANDROID__
 TEST(uKernels,
      SparseMatrixBatchVectorMultiplyAccumulateSymmetricQuantizedTest) {
@@ -2307,4 +2445,52 @@ BENCHMARK(BM_DotprodFloatMultiply)
     ->Args({2048, 2048, 5})
     ->Args({2048, 2048, 8});
 
+// Compares the input matmuls of the gates of an 8x8_16 integer LSTM step, done
+// gate by gate or for all gates at once.
+void BM_QuantMultiplyAccumulateLstmGates(benchmark::State& state) {
+  const int n_cell = state.range(0);
+  const int n_input = state.range(1);
+  const int n_batch = state.range(2);
+  const bool fused = state.range(3);
+  const int n_gates = 4;
+  CpuBackendContext context;
+  std::vector<int8_t> input(n_batch * n_input, 3);
+  std::vector<int32_t> bias(n_gates * n_cell, 7);
+  std::vector<int8_t> weights(n_gates * n_cell * n_input, 1);
+  std::vector<int32_t> multipliers(n_gates, 1 << 30);
+  std::vector<int32_t> shifts(n_gates, -8);
+  std::vector<int32_t> scratch(n_batch * n_gates * n_cell);
+  std::vector<std::vector<int16_t>> outputs(
+      n_gates, std::vector<int16_t>(n_batch * n_cell));
+  std::vector<int16_t*> output_ptrs;
+  for (auto& output : outputs) output_ptrs.push_back(output.data());
+  for (auto _ : state) {
+    if (fused) {
+      tflite::tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+          input.data(), bias.data(), weights.data(), multipliers.data(),
+          shifts.data(), n_gates, n_batch, n_input, n_cell, scratch.data(),
+          output_ptrs.data(), &context);
+    } else {
+      for (int gate = 0; gate < n_gates; ++gate) {
+        tflite::tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+            input.data(), bias.data() + gate * n_cell,
+            weights.data() + gate * n_cell * n_input, multipliers[gate],
+            shifts[gate], n_batch, n_input, n_cell, /*output_zp=*/0,
+            scratch.data(), output_ptrs[gate], &context);
+      }
+    }
+    testing::DoNotOptimize(outputs[n_gates - 1][0]);
+  }
+}
+
+BENCHMARK(BM_QuantMultiplyAccumulateLstmGates)
+    ->Args({256, 256, 1, 0})
+    ->Args({256, 256, 1, 1})
+    ->Args({256, 256, 8, 0})
+    ->Args({256, 256, 8, 1})
+    ->Args({1024, 512, 1, 0})
+    ->Args({1024, 512, 1, 1})
+    ->Args({1024, 512, 8, 0})
+    ->Args({1024, 512, 8, 1});
+
 #endif  // DOTPROD_BENCHMARKS
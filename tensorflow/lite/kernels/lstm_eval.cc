@@ -482,6 +482,53 @@ void CalculateLstmOutputHybrid(
   }
 }
 
+// Completes a single LSTM gate, int8x8_16 version, once the products of its
+// input and recurrent weights are accumulated into `gate`: adds the peephole
+// term, normalizes and applies the activation.
+void FinishLstmGateInteger8x8_16(
+    // Cell state and weights
+    const int16_t* cell_state, const int16_t* cell_to_gate_weights,
+    const int32_t cell_to_gate_scale_a, const int32_t cell_to_gate_scale_b,
+    // Layer normalization parameters (layer norm LSTM)
+    const int16_t* layer_norm_coefficients, const int32_t* layer_norm_bias,
+    const int32_t layer_norm_input_scale_a,
+    const int32_t layer_norm_input_scale_b,
+    const int32_t layer_norm_variance_guard,
+    // Array sizes
+    const int n_batch, const int n_output, const int n_cell,
+    const TfLiteFusedActivation activation,
+    // Output
+    int16_t* gate) {
+  const bool use_peephole = (cell_to_gate_weights != nullptr);
+  const bool use_layer_norm = (layer_norm_coefficients != nullptr);
+
+  // For each batch and cell: compute cell_weight * cell_state (peephole LSTM)
+  if (use_peephole) {
+    tensor_utils::VectorBatchVectorCwiseProductAccumulate(
+        cell_to_gate_weights, n_output, cell_state, n_batch,
+        cell_to_gate_scale_a, cell_to_gate_scale_b, gate);
+  }
+  // Do layer normalization (if layer norm LSTM)
+  if (use_layer_norm) {
+    tensor_utils::ApplyLayerNorm(
+        gate, layer_norm_coefficients, layer_norm_bias,
+        layer_norm_input_scale_a, layer_norm_input_scale_b,
+        layer_norm_variance_guard, n_batch, n_cell, gate);
+  }
+  // Apply activation
+  switch (activation) {
+    case kTfLiteActSigmoid:
+      tensor_utils::ApplySigmoid(gate, n_batch, n_cell, gate);
+      break;
+    case kTfLiteActTanh:
+      tensor_utils::ApplyTanh(3, gate, n_batch, n_cell, gate);
+      break;
+    default:
+      // Only Sigmoid or Tanh is used.
+      TFLITE_ASSERT_FALSE;
+  }
+}
+
 // Calculates a single LSTM gate, int8x8_16 version.
 // Implements the same functionality as CalculateLstmGateFloat.
 void CalculateLstmGateInteger8x8_16(
@@ -511,9 +558,6 @@ void CalculateLstmGateInteger8x8_16(
     CpuBackendContext* context,
     // Scratch arrays
     int32_t* scratch5) {
-  const bool use_peephole = (cell_to_gate_weights != nullptr);
-  const bool use_layer_norm = (layer_norm_coefficients != nullptr);
-
   // Initialize scratch buffers with zeros. Note that unlike float and hybrid
   // versions, bias is only used in layer normalization.
   std::fill_n(gate, n_batch * n_cell, 0);
@@ -529,31 +573,11 @@ void CalculateLstmGateInteger8x8_16(
       output_state, recurrent_to_gate_bias, recurrent_to_gate_weights,
       recurrent_to_gate_scale_a, recurrent_to_gate_scale_b, n_batch, n_output,
       n_cell, 0, scratch5, gate, context);
-  // For each batch and cell: compute cell_weight * cell_state (peephole LSTM)
-  if (use_peephole) {
-    tensor_utils::VectorBatchVectorCwiseProductAccumulate(
-        cell_to_gate_weights, n_output, cell_state, n_batch,
-        cell_to_gate_scale_a, cell_to_gate_scale_b, gate);
-  }
-  // Do layer normalization (if layer norm LSTM)
-  if (use_layer_norm) {
-    tensor_utils::ApplyLayerNorm(
-        gate, layer_norm_coefficients, layer_norm_bias,
-        layer_norm_input_scale_a, layer_norm_input_scale_b,
-        layer_norm_variance_guard, n_batch, n_cell, gate);
-  }
-  // Apply activation
-  switch (activation) {
-    case kTfLiteActSigmoid:
-      tensor_utils::ApplySigmoid(gate, n_batch, n_cell, gate);
-      break;
-    case kTfLiteActTanh:
-      tensor_utils::ApplyTanh(3, gate, n_batch, n_cell, gate);
-      break;
-    default:
-      // Only Sigmoid or Tanh is used.
-      TFLITE_ASSERT_FALSE;
-  }
+  FinishLstmGateInteger8x8_16(
+      cell_state, cell_to_gate_weights, cell_to_gate_scale_a,
+      cell_to_gate_scale_b, layer_norm_coefficients, layer_norm_bias,
+      layer_norm_input_scale_a, layer_norm_input_scale_b,
+      layer_norm_variance_guard, n_batch, n_output, n_cell, activation, gate);
 }
 
 // Updates the LSTM cell state, used by both integer LSTM versions.
@@ -1298,6 +1322,12 @@ inline void LstmStepHybrid(
 //   output_state_zp: zero point of output state
 //   hidden_zp: zero point for hidden state.
 //
+// Stacked weights and effective biases of all gates, see IntegerLstmParameter:
+//   fused_input_to_gate_weights             - optional
+//   fused_input_to_gate_effective_bias      - optional
+//   fused_recurrent_to_gate_weights         - optional
+//   fused_recurrent_to_gate_effective_bias  - optional
+//
 // Temporary pre-allocated storage for the calculation. Each is of size n_cell *
 // n_batch.
 //   scratch0
@@ -1306,7 +1336,8 @@ inline void LstmStepHybrid(
 //   scratch3
 //   scratch4
 //   scratch5: this scratch buffer is created purely for optimizing the
-//              MatrixBatchVectorMultiplyAccumulate.
+//              MatrixBatchVectorMultiplyAccumulate. With stacked weights, it
+//              is of size n_gates * n_cell * n_batch instead.
 //
 // Outputs:
 //   output_state_ptr - size 'n_batch * n_output'
@@ -1372,8 +1403,12 @@ inline void LstmStepInteger8x8_16(
     const int32_t* recurrent_to_output_effective_bias,
     const int32_t* input_to_input_effective_bias,
     const int32_t* recurrent_to_input_effective_bias,
-    const int32_t* projection_effective_bias, int n_batch, int n_cell,
-    int n_input, int n_output, int8_t* output_state_ptr,
+    const int32_t* projection_effective_bias,
+    const int8_t* fused_input_to_gate_weights,
+    const int32_t* fused_input_to_gate_effective_bias,
+    const int8_t* fused_recurrent_to_gate_weights,
+    const int32_t* fused_recurrent_to_gate_effective_bias, int n_batch,
+    int n_cell, int n_input, int n_output, int8_t* output_state_ptr,
     int32_t output_state_zp, int16_t* cell_state_ptr, int8_t* output_ptr,
     int16_t* scratch0, int16_t* scratch1, int16_t* scratch2, int16_t* scratch3,
     int8_t* scratch4, int32_t* scratch5, CpuBackendContext* context) {
@@ -1403,6 +1438,103 @@ inline void LstmStepInteger8x8_16(
   if (use_projection) {
     TFLITE_DCHECK(projection_effective_bias);
   }
+  const bool use_fused_gates = (fused_input_to_gate_weights != nullptr);
+  if (use_fused_gates) {
+    TFLITE_DCHECK(fused_input_to_gate_effective_bias);
+    TFLITE_DCHECK(fused_recurrent_to_gate_weights);
+    TFLITE_DCHECK(fused_recurrent_to_gate_effective_bias);
+
+    // The matmuls of all gates only depend on the input and the previous
+    // output state, so they are done up front, in one pass over the stacked
+    // weights of the gates for each of them.
+    int16_t* gates[4];
+    int32_t input_multipliers[4];
+    int32_t input_shifts[4];
+    int32_t recurrent_multipliers[4];
+    int32_t recurrent_shifts[4];
+    int n_gates = 0;
+    auto add_gate = [&](int16_t* gate, int32_t input_scale_a,
+                        int32_t input_scale_b, int32_t recurrent_scale_a,
+                        int32_t recurrent_scale_b) {
+      gates[n_gates] = gate;
+      input_multipliers[n_gates] = input_scale_a;
+      input_shifts[n_gates] = input_scale_b;
+      recurrent_multipliers[n_gates] = recurrent_scale_a;
+      recurrent_shifts[n_gates] = recurrent_scale_b;
+      std::fill_n(gate, n_batch * n_cell, 0);
+      ++n_gates;
+    };
+    if (!use_cifg) {
+      add_gate(input_gate_scratch, effective_input_to_input_scale_a,
+               effective_input_to_input_scale_b,
+               effective_recurrent_to_input_scale_a,
+               effective_recurrent_to_input_scale_b);
+    }
+    add_gate(forget_gate_scratch, effective_input_to_forget_scale_a,
+             effective_input_to_forget_scale_b,
+             effective_recurrent_to_forget_scale_a,
+             effective_recurrent_to_forget_scale_b);
+    add_gate(cell_gate_scratch, effective_input_to_cell_scale_a,
+             effective_input_to_cell_scale_b,
+             effective_recurrent_to_cell_scale_a,
+             effective_recurrent_to_cell_scale_b);
+    add_gate(output_gate_scratch, effective_input_to_output_scale_a,
+             effective_input_to_output_scale_b,
+             effective_recurrent_to_output_scale_a,
+             effective_recurrent_to_output_scale_b);
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        input_ptr, fused_input_to_gate_effective_bias,
+        fused_input_to_gate_weights, input_multipliers, input_shifts, n_gates,
+        n_batch, n_input, n_cell, scratch5, gates, context);
+    tensor_utils::MatrixBatchVectorMultiplyAccumulate(
+        output_state_ptr, fused_recurrent_to_gate_effective_bias,
+        fused_recurrent_to_gate_weights, recurrent_multipliers,
+        recurrent_shifts, n_gates, n_batch, n_output, n_cell, scratch5, gates,
+        context);
+
+    if (!use_cifg) {
+      FinishLstmGateInteger8x8_16(
+          cell_state_ptr, cell_to_input_weight_ptr,
+          effective_cell_to_input_scale_a, effective_cell_to_input_scale_b,
+          layer_norm_input_weight_ptr, input_gate_bias_ptr,
+          layer_norm_input_scale_a, layer_norm_input_scale_b,
+          input_variance_guard, n_batch, n_output, n_cell, kTfLiteActSigmoid,
+          input_gate_scratch);
+    }
+    FinishLstmGateInteger8x8_16(
+        cell_state_ptr, cell_to_forget_weight_ptr,
+        effective_cell_to_forget_scale_a, effective_cell_to_forget_scale_b,
+        layer_norm_forget_weight_ptr, forget_gate_bias_ptr,
+        layer_norm_forget_scale_a, layer_norm_forget_scale_b,
+        forget_variance_guard, n_batch, n_output, n_cell, kTfLiteActSigmoid,
+        forget_gate_scratch);
+    FinishLstmGateInteger8x8_16(
+        cell_state_ptr, /*cell_to_gate_weights=*/nullptr,
+        /*cell_to_gate_scale_a=*/0, /*cell_to_gate_scale_b=*/0,
+        layer_norm_cell_weight_ptr, cell_gate_bias_ptr,
+        layer_norm_cell_scale_a, layer_norm_cell_scale_b, cell_variance_guard,
+        n_batch, n_output, n_cell, kTfLiteActTanh, cell_gate_scratch);
+    UpdateLstmCellInteger(n_batch, n_cell, cell_state_ptr, cell_state_scale,
+                          input_gate_scratch, forget_gate_scratch,
+                          cell_gate_scratch, use_cifg, quantized_cell_clip);
+    // The peephole of the output gate uses the updated cell state.
+    FinishLstmGateInteger8x8_16(
+        cell_state_ptr, cell_to_output_weight_ptr,
+        effective_cell_to_output_scale_a, effective_cell_to_output_scale_b,
+        layer_norm_output_weight_ptr, output_gate_bias_ptr,
+        layer_norm_output_scale_a, layer_norm_output_scale_b,
+        output_variance_guard, n_batch, n_output, n_cell, kTfLiteActSigmoid,
+        output_gate_scratch);
+    CalculateLstmOutputInteger8x8_16(
+        n_batch, n_cell, n_output, cell_state_ptr, cell_state_scale,
+        output_gate_scratch, effective_hidden_scale_a, effective_hidden_scale_b,
+        hidden_zp, projection_weight_ptr, effective_proj_scale_a,
+        effective_proj_scale_b, projection_effective_bias, output_state_zp,
+        quantized_proj_clip, output_state_ptr, context, scratch0, scratch4,
+        scratch5);
+    std::copy_n(output_state_ptr, n_batch * n_output, output_ptr);
+    return;
+  }
   if (!use_cifg) {
     // Calculate the input gate. (If not CIFG.)
     CalculateLstmGateInteger8x8_16(
@@ -1685,6 +1817,68 @@ inline void LstmStepInteger8x8_8(
 
 }  // namespace
 
+int PopulateFusedGateWeightsInteger8x8_16(
+    const TfLiteTensor* input_to_input_weights,
+    const TfLiteTensor* input_to_forget_weights,
+    const TfLiteTensor* input_to_cell_weights,
+    const TfLiteTensor* input_to_output_weights,
+    const TfLiteTensor* recurrent_to_input_weights,
+    const TfLiteTensor* recurrent_to_forget_weights,
+    const TfLiteTensor* recurrent_to_cell_weights,
+    const TfLiteTensor* recurrent_to_output_weights,
+    IntegerLstmParameter* integer_lstm_param) {
+  const int n_cell = input_to_output_weights->dims->data[0];
+  const int n_input = input_to_output_weights->dims->data[1];
+  const int n_output = recurrent_to_output_weights->dims->data[1];
+  const bool use_cifg = (input_to_input_weights == nullptr);
+
+  const TfLiteTensor* input_weights[] = {
+      input_to_input_weights, input_to_forget_weights, input_to_cell_weights,
+      input_to_output_weights};
+  const TfLiteTensor* recurrent_weights[] = {
+      recurrent_to_input_weights, recurrent_to_forget_weights,
+      recurrent_to_cell_weights, recurrent_to_output_weights};
+  const int32_t* input_biases[] = {
+      integer_lstm_param->input_to_input_effective_bias.get(),
+      integer_lstm_param->input_to_forget_effective_bias.get(),
+      integer_lstm_param->input_to_cell_effective_bias.get(),
+      integer_lstm_param->input_to_output_effective_bias.get()};
+  const int32_t* recurrent_biases[] = {
+      integer_lstm_param->recurrent_to_input_effective_bias.get(),
+      integer_lstm_param->recurrent_to_forget_effective_bias.get(),
+      integer_lstm_param->recurrent_to_cell_effective_bias.get(),
+      integer_lstm_param->recurrent_to_output_effective_bias.get()};
+
+  const int first_gate = use_cifg ? 1 : 0;
+  const int n_gates = 4 - first_gate;
+  integer_lstm_param->fused_input_to_gate_weights.reset(
+      new int8_t[n_gates * n_cell * n_input]);
+  integer_lstm_param->fused_input_to_gate_effective_bias.reset(
+      new int32_t[n_gates * n_cell]);
+  integer_lstm_param->fused_recurrent_to_gate_weights.reset(
+      new int8_t[n_gates * n_cell * n_output]);
+  integer_lstm_param->fused_recurrent_to_gate_effective_bias.reset(
+      new int32_t[n_gates * n_cell]);
+  for (int gate = first_gate; gate < 4; ++gate) {
+    const int offset = gate - first_gate;
+    std::copy_n(GetTensorData<int8_t>(input_weights[gate]), n_cell * n_input,
+                integer_lstm_param->fused_input_to_gate_weights.get() +
+                    offset * n_cell * n_input);
+    std::copy_n(input_biases[gate], n_cell,
+                integer_lstm_param->fused_input_to_gate_effective_bias.get() +
+                    offset * n_cell);
+    std::copy_n(GetTensorData<int8_t>(recurrent_weights[gate]),
+                n_cell * n_output,
+                integer_lstm_param->fused_recurrent_to_gate_weights.get() +
+                    offset * n_cell * n_output);
+    std::copy_n(
+        recurrent_biases[gate], n_cell,
+        integer_lstm_param->fused_recurrent_to_gate_effective_bias.get() +
+            offset * n_cell);
+  }
+  return n_gates;
+}
+
 // LINT.IfChange
 TfLiteStatus EvalFloat(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
@@ -2275,8 +2469,13 @@ TfLiteStatus EvalInteger8x8_16(
           integer_lstm_param->recurrent_to_output_effective_bias.get(),
           integer_lstm_param->input_to_input_effective_bias.get(),
           integer_lstm_param->recurrent_to_input_effective_bias.get(),
-          integer_lstm_param->projection_effective_bias.get(), n_batch, n_cell,
-          n_input, n_output, GetTensorData<int8_t>(output_state),
+          integer_lstm_param->projection_effective_bias.get(),
+          integer_lstm_param->fused_input_to_gate_weights.get(),
+          integer_lstm_param->fused_input_to_gate_effective_bias.get(),
+          integer_lstm_param->fused_recurrent_to_gate_weights.get(),
+          integer_lstm_param->fused_recurrent_to_gate_effective_bias.get(),
+          n_batch, n_cell, n_input, n_output,
+          GetTensorData<int8_t>(output_state),
           output_state_zp, GetTensorData<int16_t>(cell_state), output_ptr,
           GetTensorData<int16_t>(scratch0), GetTensorData<int16_t>(scratch1),
           GetTensorData<int16_t>(scratch2), GetTensorData<int16_t>(scratch3),
@@ -2374,8 +2573,13 @@ TfLiteStatus EvalInteger8x8_16(
             integer_lstm_param->recurrent_to_output_effective_bias.get(),
             integer_lstm_param->input_to_input_effective_bias.get(),
             integer_lstm_param->recurrent_to_input_effective_bias.get(),
-            integer_lstm_param->projection_effective_bias.get(), /*n_batch=*/1,
-            n_cell, n_input, n_output, output_state_ptr, output_state_zp,
+            integer_lstm_param->projection_effective_bias.get(),
+            integer_lstm_param->fused_input_to_gate_weights.get(),
+            integer_lstm_param->fused_input_to_gate_effective_bias.get(),
+            integer_lstm_param->fused_recurrent_to_gate_weights.get(),
+            integer_lstm_param->fused_recurrent_to_gate_effective_bias.get(),
+            /*n_batch=*/1, n_cell, n_input, n_output, output_state_ptr,
+            output_state_zp,
             cell_state_ptr, output_ptr, GetTensorData<int16_t>(scratch0),
             GetTensorData<int16_t>(scratch1), GetTensorData<int16_t>(scratch2),
             GetTensorData<int16_t>(scratch3), GetTensorData<int8_t>(scratch4),
@@ -88,6 +88,15 @@ struct IntegerLstmParameter {
   std::unique_ptr<int32_t[]> recurrent_to_input_effective_bias;
   std::unique_ptr<int32_t[]> projection_effective_bias;
 
+  // Weights and effective biases of all gates, stacked in input (unless CIFG),
+  // forget, cell and output gate order, so that the input and the recurrent
+  // matmuls of a step are done for all gates at once. Only used in the 8x8_16
+  // case, and only if set by PopulateFusedGateWeightsInteger8x8_16().
+  std::unique_ptr<int8_t[]> fused_input_to_gate_weights;
+  std::unique_ptr<int32_t[]> fused_input_to_gate_effective_bias;
+  std::unique_ptr<int8_t[]> fused_recurrent_to_gate_weights;
+  std::unique_ptr<int32_t[]> fused_recurrent_to_gate_effective_bias;
+
   // Scale and zero point for intermediate tensors.
   // Used only in the 8x8_8 case.
   int32_t intermediate_scale_a[8];
@@ -95,6 +104,22 @@ struct IntegerLstmParameter {
   int32_t intermediate_zp[12];
 };
 
+// Stacks the gate weights and effective biases of an 8x8_16 integer LSTM into
+// the fused_* fields of `integer_lstm_param`, whose per-gate effective biases
+// must already be computed. The input to input and recurrent to input weights
+// are null with CIFG. Returns the number of stacked gates, i.e. the factor by
+// which scratch5 of EvalInteger8x8_16() has to be larger than n_batch * n_cell.
+int PopulateFusedGateWeightsInteger8x8_16(
+    const TfLiteTensor* input_to_input_weights,
+    const TfLiteTensor* input_to_forget_weights,
+    const TfLiteTensor* input_to_cell_weights,
+    const TfLiteTensor* input_to_output_weights,
+    const TfLiteTensor* recurrent_to_input_weights,
+    const TfLiteTensor* recurrent_to_forget_weights,
+    const TfLiteTensor* recurrent_to_cell_weights,
+    const TfLiteTensor* recurrent_to_output_weights,
+    IntegerLstmParameter* integer_lstm_param);
+
 TfLiteStatus EvalFloat(
     const TfLiteTensor* input, const TfLiteTensor* input_to_input_weights,
     const TfLiteTensor* input_to_forget_weights,
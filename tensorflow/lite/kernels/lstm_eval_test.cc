@@ -596,11 +596,43 @@ class QuantizedLstmParam : public BaseLstmParam {
   std::vector<int8_t> scratch4_;
   std::vector<int32_t> scratch4_size_ = {n_batch_, n_cell_};
   TfLiteTensor scratch4_tensor_;
+  // Large enough for the matmuls of all four gates at once.
   std::vector<int32_t> scratch5_;
-  std::vector<int32_t> scratch5_size_ = {n_batch_, n_cell_};
+  std::vector<int32_t> scratch5_size_ = {n_batch_, 4 * n_cell_};
   TfLiteTensor scratch5_tensor_;
 };
 
+void EvalOneFullyQuantizedLSTM(QuantizedLstmParam* one_parameter,
+                               bool fuse_gates, CpuBackendContext* context) {
+  auto i2i = one_parameter->Geti2i();
+  auto i2f = one_parameter->Geti2f();
+  auto i2c = one_parameter->Geti2c();
+  auto i2o = one_parameter->Geti2o();
+  auto r2i = one_parameter->Getr2i();
+  auto r2f = one_parameter->Getr2f();
+  auto r2c = one_parameter->Getr2c();
+  auto r2o = one_parameter->Getr2o();
+  auto param = one_parameter->GetQuantParam();
+  if (fuse_gates) {
+    EXPECT_EQ(ops::builtin::lstm_eval::PopulateFusedGateWeightsInteger8x8_16(
+                  i2i, i2f, i2c, i2o, r2i, r2f, r2c, r2o, param),
+              4);
+  }
+  ops::builtin::lstm_eval::EvalInteger8x8_16(
+      one_parameter->GetInput(), i2i, i2f, i2c, i2o, r2i, r2f, r2c, r2o,
+      nullptr, nullptr, nullptr, one_parameter->GetInputLayerNorm(),
+      one_parameter->GetForgetLayerNorm(), one_parameter->GetCellLayerNorm(),
+      one_parameter->GetOutputLayerNorm(), one_parameter->GetInputBias(),
+      one_parameter->GetForgetBias(), one_parameter->GetCellBias(),
+      one_parameter->GetOutputBias(), one_parameter->GetProjection(),
+      one_parameter->GetProjectionBias(), nullptr, /*forward_sequence=*/true,
+      /*time_major=*/true, param, one_parameter->GetActivation(),
+      one_parameter->GetCell(), one_parameter->GetOutput(),
+      one_parameter->GetScratch0(), one_parameter->GetScratch1(),
+      one_parameter->GetScratch2(), one_parameter->GetScratch3(),
+      one_parameter->GetScratch4(), one_parameter->GetScratch5(), context);
+}
+
 void TestOneFullyQuantizedLSTM() {
   CpuBackendContext context;
   QuantizedLstmParam one_parameter;
@@ -639,6 +671,22 @@ TEST(TestOneFullyQuantizedLSTM, TestOneFullyQuantizedLSTM) {
   TestOneFullyQuantizedLSTM();
 }
 
+TEST(TestOneFullyQuantizedLSTM, FusedGatesMatchPerGateMatmuls) {
+  CpuBackendContext context;
+  QuantizedLstmParam per_gate_parameter;
+  QuantizedLstmParam fused_parameter;
+  EvalOneFullyQuantizedLSTM(&per_gate_parameter, /*fuse_gates=*/false,
+                            &context);
+  EvalOneFullyQuantizedLSTM(&fused_parameter, /*fuse_gates=*/true, &context);
+
+  EXPECT_TRUE(ArrayEq(fused_parameter.GetCell()->data.i16,
+                      per_gate_parameter.GetCell()->data.i16, 20));
+  EXPECT_TRUE(ArrayEq(fused_parameter.GetActivation()->data.int8,
+                      per_gate_parameter.GetActivation()->data.int8, 12));
+  EXPECT_TRUE(ArrayEq(fused_parameter.GetOutput()->data.int8,
+                      per_gate_parameter.GetOutput()->data.int8, 12));
+}
+
 class HybridLstmParam : public BaseLstmParam {
  public:
   TfLiteTensor* GetFloatOutput() {
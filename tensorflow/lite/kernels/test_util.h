@@ -283,10 +283,26 @@ class SingleOpModel {
       buffers_.push_back(CreateBuffer(builder_, data_buffer));
     }
 
+    // The quantization parameters of quantized weights are given as is, per
+    // channel or per tensor.
+    flatbuffers::Offset<QuantizationParameters> q_params = 0;
+    if (t.per_channel_quantization) {
+      q_params = CreateQuantizationParameters(
+          builder_, /*min=*/0, /*max=*/0,
+          builder_.CreateVector<float>(t.per_channel_quantization_scales),
+          builder_.CreateVector<int64_t>(t.per_channel_quantization_offsets),
+          QuantizationDetails_NONE, 0, t.channel_index);
+    } else if (t.scale != 0) {
+      q_params = CreateQuantizationParameters(
+          builder_, /*min=*/0, /*max=*/0,
+          builder_.CreateVector<float>({t.scale}),
+          builder_.CreateVector<int64_t>({t.zero_point}));
+    }
+
     tensors_.push_back(CreateTensor(
         builder_, builder_.CreateVector<int>(t.shape), t.type,
         /*buffer=*/buffer_id,
-        /*name=*/0, /*quantization=*/0, /*is_variable=*/false, s_param));
+        /*name=*/0, q_params, /*is_variable=*/false, s_param));
 
     inputs_.push_back(id);
     tensor_data_[id] = t;
@@ -709,6 +709,55 @@ TfLiteStatus PrecomputeZeroPointTimesWeightWithBias(
   return kTfLiteOk;
 }
 
+// Stacks the gate weights of the 8x8_16 integer LSTM, so that each step does
+// the input and the recurrent matmuls of all gates at once. Needs the
+// effective biases of PopulatePrecomputedZPTimesWeightsWithBias().
+TfLiteStatus PopulateFusedGateWeights(TfLiteContext* context, OpData* op_data,
+                                      TfLiteNode* node, int n_gates) {
+  const TfLiteTensor* input_to_forget_weights;
+  TF_LITE_ENSURE_OK(
+      context,
+      GetInputSafe(context, node, lstm::full::kInputToForgetWeightsTensor,
+                   &input_to_forget_weights));
+  const TfLiteTensor* input_to_cell_weights;
+  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node,
+                                          lstm::full::kInputToCellWeightsTensor,
+                                          &input_to_cell_weights));
+  const TfLiteTensor* input_to_output_weights;
+  TF_LITE_ENSURE_OK(
+      context,
+      GetInputSafe(context, node, lstm::full::kInputToOutputWeightsTensor,
+                   &input_to_output_weights));
+  const TfLiteTensor* recurrent_to_forget_weights;
+  TF_LITE_ENSURE_OK(
+      context,
+      GetInputSafe(context, node, lstm::full::kRecurrentToForgetWeightsTensor,
+                   &recurrent_to_forget_weights));
+  const TfLiteTensor* recurrent_to_cell_weights;
+  TF_LITE_ENSURE_OK(
+      context,
+      GetInputSafe(context, node, lstm::full::kRecurrentToCellWeightsTensor,
+                   &recurrent_to_cell_weights));
+  const TfLiteTensor* recurrent_to_output_weights;
+  TF_LITE_ENSURE_OK(
+      context,
+      GetInputSafe(context, node, lstm::full::kRecurrentToOutputWeightsTensor,
+                   &recurrent_to_output_weights));
+
+  const int num_stacked_gates =
+      lstm_eval::PopulateFusedGateWeightsInteger8x8_16(
+          GetOptionalInputTensor(context, node,
+                                 lstm::full::kInputToInputWeightsTensor),
+          input_to_forget_weights, input_to_cell_weights,
+          input_to_output_weights,
+          GetOptionalInputTensor(context, node,
+                                 lstm::full::kRecurrentToInputWeightsTensor),
+          recurrent_to_forget_weights, recurrent_to_cell_weights,
+          recurrent_to_output_weights, &op_data->integer_lstm_param);
+  TF_LITE_ENSURE_EQ(context, num_stacked_gates, n_gates);
+  return kTfLiteOk;
+}
+
 TfLiteStatus PopulatePrecomputedZPTimesWeightsWithBias(TfLiteContext* context,
                                                        OpData* op_data,
                                                        TfLiteNode* node) {
@@ -1171,9 +1220,16 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     // Populate quantization parameters.
     PopulateQuantizedLstmParams8x8_16(context, node,
                                       &op_data->integer_lstm_param);
+    const bool use_cifg =
+        GetOptionalInputTensor(context, node,
+                               lstm::full::kInputToInputWeightsTensor) ==
+        nullptr;
+    // The gate matmuls are done for all gates at once, see
+    // PopulateFusedGateWeights().
+    const int n_gates = use_cifg ? 3 : 4;
     // Allocate scratch buffer. Need 6 16bit buffer with size n_batch * n_cell
     // and 1 8bit buffer with size n_batch * n_cell. We also need 1 32 bit
-    // buffer with size n_batch * n_cell.
+    // buffer with size n_batch * n_gates * n_cell.
     //
     // Handle cifg case as well, which might save one buffer.
     for (int scratch_index = 0; scratch_index < 6; ++scratch_index) {
@@ -1191,12 +1247,13 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       }
 
       scratch_tensor->allocation_type = kTfLiteArenaRw;
-      const int scratch_dimension[2] = {n_batch, n_cell};
+      const int scratch_cols = scratch_index == 5 ? n_gates * n_cell : n_cell;
+      const int scratch_dimension[2] = {n_batch, scratch_cols};
       if (!TfLiteIntArrayEqualsArray(scratch_tensor->dims, 2,
                                      scratch_dimension)) {
         TfLiteIntArray* scratch_buffer_size = TfLiteIntArrayCreate(2);
         scratch_buffer_size->data[0] = n_batch;
-        scratch_buffer_size->data[1] = n_cell;
+        scratch_buffer_size->data[1] = scratch_cols;
         TF_LITE_ENSURE_OK(context,
                           context->ResizeTensor(context, scratch_tensor,
                                                 scratch_buffer_size));
@@ -1206,6 +1263,8 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     // Populate precomputed zp * weight.
     TF_LITE_ENSURE_OK(context, PopulatePrecomputedZPTimesWeightsWithBias(
                                    context, op_data, node));
+    TF_LITE_ENSURE_OK(context, PopulateFusedGateWeights(context, op_data, node,
+                                                        n_gates));
   }
 
   return kTfLiteOk;
@@ -62,6 +62,17 @@ class MemoryPlanner {
   // Returns true if the non-persistent memory is available.
   virtual bool HasNonPersistentMemory() = 0;
 
+  // Declares that the nodes of the execution plan are partitioned into groups
+  // of consecutive nodes, the i-th group starting at `group_first_nodes[i]`,
+  // and that the nodes of a group may be executed concurrently. Tensors used
+  // by a group must then remain allocated while any node of the group runs.
+  // An empty vector removes the grouping. Planners that can't honour the
+  // grouping return kTfLiteError, and nodes must then be run one at a time.
+  virtual TfLiteStatus SetConcurrentNodeGroups(
+      const std::vector<int>& group_first_nodes) {
+    return kTfLiteError;
+  }
+
   // Dumps the memory planning information against the specified op node
   // execution plan (i.e. `execution_plan`) for the purpose of debugging.
   virtual void DumpDebugInfo(const std::vector<int>& execution_plan) const = 0;
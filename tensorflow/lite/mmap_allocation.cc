@@ -19,7 +19,10 @@ limitations under the License.
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cerrno>
+#include <cstdint>
+#include <vector>
 
 #include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
@@ -40,6 +43,15 @@ size_t GetFdSizeBytes(int fd) {
   return fd_stat.st_size;
 }
 
+size_t GetPageSize() {
+#ifdef __ANDROID__
+  static int pagesize = getpagesize();
+#else
+  static int pagesize = sysconf(_SC_PAGE_SIZE);
+#endif
+  return pagesize;
+}
+
 }  // namespace
 
 MMAPAllocation::MMAPAllocation(const char* filename,
@@ -81,13 +93,7 @@ MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
     return;
   }
 
-#ifdef __ANDROID__
-  static int pagesize = getpagesize();
-#else
-  static int pagesize = sysconf(_SC_PAGE_SIZE);
-#endif
-
-  offset_in_buffer_ = offset % pagesize;
+  offset_in_buffer_ = offset % GetPageSize();
 
   size_t file_size = GetFdSizeBytes(mmap_fd_);
   if (length + offset > file_size) {
@@ -128,6 +134,45 @@ size_t MMAPAllocation::bytes() const { return buffer_size_bytes_; }
 
 bool MMAPAllocation::valid() const { return mmapped_buffer_ != MAP_FAILED; }
 
+size_t MMAPAllocation::GetResidentBytes(const void* data, size_t size) const {
+  if (!valid() || size == 0) return 0;
+  const size_t page_size = GetPageSize();
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+  const uintptr_t end = begin + size;
+  // The mapping starts on a page boundary.
+  const uintptr_t first_page = begin - begin % page_size;
+  const size_t num_pages = (end - first_page + page_size - 1) / page_size;
+#ifdef __APPLE__
+  std::vector<char> residency(num_pages);
+#else
+  std::vector<unsigned char> residency(num_pages);
+#endif
+  if (mincore(reinterpret_cast<void*>(first_page), end - first_page,
+              residency.data()) != 0) {
+    return 0;
+  }
+  size_t resident_bytes = 0;
+  for (size_t i = 0; i < num_pages; ++i) {
+    if ((residency[i] & 1) == 0) continue;
+    const uintptr_t page_begin = std::max(first_page + i * page_size, begin);
+    const uintptr_t page_end = std::min(first_page + (i + 1) * page_size, end);
+    resident_bytes += page_end - page_begin;
+  }
+  return resident_bytes;
+}
+
+void MMAPAllocation::ReleaseResidentPages(const void* data,
+                                          size_t size) const {
+  if (!valid() || size == 0) return;
+  // The pages are read-only copies of the file, other data sharing the first
+  // and last pages is read again from the file as well.
+  const size_t page_size = GetPageSize();
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+  const uintptr_t first_page = begin - begin % page_size;
+  madvise(reinterpret_cast<void*>(first_page), begin + size - first_page,
+          MADV_DONTNEED);
+}
+
 bool MMAPAllocation::IsSupported() { return true; }
 
 }  // namespace tflite
@@ -41,6 +41,13 @@ size_t MMAPAllocation::bytes() const { return 0; }
 
 bool MMAPAllocation::valid() const { return false; }
 
+size_t MMAPAllocation::GetResidentBytes(const void* data, size_t size) const {
+  return 0;
+}
+
+void MMAPAllocation::ReleaseResidentPages(const void* data,
+                                          size_t size) const {}
+
 bool MMAPAllocation::IsSupported() { return false; }
 
 }  // namespace tflite
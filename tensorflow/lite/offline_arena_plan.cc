@@ -0,0 +1,98 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/offline_arena_plan.h"
+
+#include <cstring>
+
+namespace tflite {
+namespace {
+
+void AppendInt32(int32_t value, std::string* out) {
+  char bytes[sizeof(int32_t)];
+  for (int i = 0; i < sizeof(int32_t); ++i) {
+    bytes[i] = static_cast<char>((static_cast<uint32_t>(value) >> (8 * i)));
+  }
+  out->append(bytes, sizeof(bytes));
+}
+
+// Reads the int32 at `*position` and advances it. Returns false if the
+// metadata is too short.
+bool ReadInt32(const std::string& metadata, size_t* position, int32_t* value) {
+  if (*position + sizeof(int32_t) > metadata.size()) return false;
+  uint32_t bits = 0;
+  for (int i = 0; i < sizeof(int32_t); ++i) {
+    bits |= static_cast<uint32_t>(
+                static_cast<unsigned char>(metadata[*position + i]))
+            << (8 * i);
+  }
+  *position += sizeof(int32_t);
+  std::memcpy(value, &bits, sizeof(bits));
+  return true;
+}
+
+}  // namespace
+
+std::string SerializeOfflineArenaPlans(
+    const std::vector<OfflineArenaPlan>& plans) {
+  std::string metadata;
+  AppendInt32(kOfflineArenaPlanVersion, &metadata);
+  AppendInt32(plans.size(), &metadata);
+  for (const OfflineArenaPlan& plan : plans) {
+    AppendInt32(plan.offsets.size(), &metadata);
+    AppendInt32(plan.arena_size, &metadata);
+    for (int i = 0; i < plan.offsets.size(); ++i) {
+      AppendInt32(plan.offsets[i], &metadata);
+      AppendInt32(i < plan.sizes.size() ? plan.sizes[i] : 0, &metadata);
+    }
+  }
+  return metadata;
+}
+
+bool ParseOfflineArenaPlan(const std::string& metadata, int subgraph_index,
+                           OfflineArenaPlan* plan) {
+  size_t position = 0;
+  int32_t version;
+  int32_t num_subgraphs;
+  if (!ReadInt32(metadata, &position, &version) ||
+      version != kOfflineArenaPlanVersion ||
+      !ReadInt32(metadata, &position, &num_subgraphs) || subgraph_index < 0 ||
+      subgraph_index >= num_subgraphs) {
+    return false;
+  }
+  for (int subgraph = 0; subgraph <= subgraph_index; ++subgraph) {
+    int32_t num_tensors;
+    int32_t arena_size;
+    if (!ReadInt32(metadata, &position, &num_tensors) ||
+        !ReadInt32(metadata, &position, &arena_size) || num_tensors < 0 ||
+        (metadata.size() - position) / (2 * sizeof(int32_t)) <
+            static_cast<size_t>(num_tensors)) {
+      return false;
+    }
+    if (subgraph < subgraph_index) {
+      position += num_tensors * 2 * sizeof(int32_t);
+      continue;
+    }
+    plan->arena_size = arena_size;
+    plan->offsets.resize(num_tensors);
+    plan->sizes.resize(num_tensors);
+    for (int i = 0; i < num_tensors; ++i) {
+      ReadInt32(metadata, &position, &plan->offsets[i]);
+      ReadInt32(metadata, &position, &plan->sizes[i]);
+    }
+  }
+  return true;
+}
+
+}  // namespace tflite
@@ -0,0 +1,63 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_OFFLINE_ARENA_PLAN_H_
+#define TENSORFLOW_LITE_OFFLINE_ARENA_PLAN_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tflite {
+
+// Name of the model metadata holding the offline arena plans of the model, as
+// produced by tensorflow/lite/tools/optimize:offline_arena_planner.
+//
+// The metadata is a sequence of little-endian int32 values:
+//   [version, num_subgraphs,
+//    For each subgraph:
+//      num_tensors, arena_size,
+//      For each tensor:
+//        offset, size]
+// where `offset` is the offset of the tensor in the kTfLiteArenaRw arena, or
+// -1 if the tensor is not allocated in that arena, and `size` is the size in
+// bytes the tensor had when the plan was computed.
+constexpr char kOfflineArenaPlanMetadataName[] = "offline_arena_plan";
+constexpr int32_t kOfflineArenaPlanVersion = 1;
+
+// Offsets of the kTfLiteArenaRw tensors of a subgraph, computed ahead of time.
+struct OfflineArenaPlan {
+  // Offset of each tensor in the arena, or -1 if the tensor isn't planned.
+  std::vector<int32_t> offsets;
+  // Size in bytes of each tensor when the plan was computed. The plan only
+  // applies to tensors that still have this size.
+  std::vector<int32_t> sizes;
+  // Size of the arena needed by the plan.
+  int32_t arena_size = 0;
+};
+
+// Serializes the plans of all the subgraphs of a model into the format of the
+// kOfflineArenaPlanMetadataName metadata.
+std::string SerializeOfflineArenaPlans(
+    const std::vector<OfflineArenaPlan>& plans);
+
+// Reads the plan of the subgraph at `subgraph_index` from the contents of the
+// kOfflineArenaPlanMetadataName metadata. Returns false if the metadata is
+// malformed, has an unsupported version or has no plan for that subgraph.
+bool ParseOfflineArenaPlan(const std::string& metadata, int subgraph_index,
+                           OfflineArenaPlan* plan);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_OFFLINE_ARENA_PLAN_H_
@@ -0,0 +1,82 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/offline_arena_plan.h"
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(OfflineArenaPlanTest, RoundTrip) {
+  OfflineArenaPlan first;
+  first.offsets = {0, -1, 64};
+  first.sizes = {12, 0, 1000};
+  first.arena_size = 1064;
+  OfflineArenaPlan second;
+  second.arena_size = 0;
+  OfflineArenaPlan third;
+  third.offsets = {128};
+  third.sizes = {4};
+  third.arena_size = 132;
+  const std::string metadata =
+      SerializeOfflineArenaPlans({first, second, third});
+
+  OfflineArenaPlan plan;
+  ASSERT_TRUE(ParseOfflineArenaPlan(metadata, 0, &plan));
+  EXPECT_THAT(plan.offsets, ElementsAre(0, -1, 64));
+  EXPECT_THAT(plan.sizes, ElementsAre(12, 0, 1000));
+  EXPECT_EQ(plan.arena_size, 1064);
+
+  ASSERT_TRUE(ParseOfflineArenaPlan(metadata, 1, &plan));
+  EXPECT_THAT(plan.offsets, IsEmpty());
+  EXPECT_THAT(plan.sizes, IsEmpty());
+  EXPECT_EQ(plan.arena_size, 0);
+
+  ASSERT_TRUE(ParseOfflineArenaPlan(metadata, 2, &plan));
+  EXPECT_THAT(plan.offsets, ElementsAre(128));
+  EXPECT_THAT(plan.sizes, ElementsAre(4));
+  EXPECT_EQ(plan.arena_size, 132);
+
+  EXPECT_FALSE(ParseOfflineArenaPlan(metadata, 3, &plan));
+  EXPECT_FALSE(ParseOfflineArenaPlan(metadata, -1, &plan));
+}
+
+TEST(OfflineArenaPlanTest, Malformed) {
+  OfflineArenaPlan first;
+  first.offsets = {0, 64};
+  first.sizes = {12, 10};
+  const std::string metadata = SerializeOfflineArenaPlans({first});
+
+  OfflineArenaPlan plan;
+  EXPECT_FALSE(ParseOfflineArenaPlan("", 0, &plan));
+  for (int size = 0; size < metadata.size(); ++size) {
+    EXPECT_FALSE(ParseOfflineArenaPlan(metadata.substr(0, size), 0, &plan))
+        << "size " << size;
+  }
+
+  std::string unsupported_version = metadata;
+  unsupported_version[0] = kOfflineArenaPlanVersion + 1;
+  EXPECT_FALSE(ParseOfflineArenaPlan(unsupported_version, 0, &plan));
+}
+
+}  // namespace
+}  // namespace tflite
@@ -0,0 +1,277 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/perf_event_profiler.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // defined(__linux__)
+
+#include <cstring>
+#include <utility>
+
+#include "tensorflow/lite/profiling/time.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+struct CounterSpec {
+  const char* name;
+  uint32_t type;
+  uint64_t config;
+};
+
+#if defined(__linux__)
+constexpr uint64_t HwCacheConfig(uint64_t cache, uint64_t op,
+                                 uint64_t result) {
+  return cache | (op << 8) | (result << 16);
+}
+
+// Generic hardware events, which the kernel maps to the PMU of the CPU, and
+// software events, which are available without a PMU too.
+constexpr CounterSpec kCounterSpecs[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+    {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"stalled-cycles-frontend", PERF_TYPE_HARDWARE,
+     PERF_COUNT_HW_STALLED_CYCLES_FRONTEND},
+    {"stalled-cycles-backend", PERF_TYPE_HARDWARE,
+     PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+    {"l1d-read-misses", PERF_TYPE_HW_CACHE,
+     HwCacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                   PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"llc-read-misses", PERF_TYPE_HW_CACHE,
+     HwCacheConfig(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                   PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"dtlb-read-misses", PERF_TYPE_HW_CACHE,
+     HwCacheConfig(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                   PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"task-clock-ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+    {"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+const CounterSpec* FindCounterSpec(const std::string& name) {
+  for (const CounterSpec& spec : kCounterSpecs) {
+    if (name == spec.name) return &spec;
+  }
+  return nullptr;
+}
+
+int OpenPerfEvent(const CounterSpec& spec, int group_fd) {
+  struct perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = spec.type;
+  attr.config = spec.config;
+  // The group is enabled as a whole once all counters are open.
+  attr.disabled = group_fd == -1 ? 1 : 0;
+  // Kernel and hypervisor events need privileges that apps usually lack.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1, group_fd,
+                 /*flags=*/0);
+}
+#endif  // defined(__linux__)
+
+bool IsOperatorEvent(Profiler::EventType event_type) {
+  return event_type == Profiler::EventType::OPERATOR_INVOKE_EVENT ||
+         event_type == Profiler::EventType::DELEGATE_OPERATOR_INVOKE_EVENT;
+}
+
+}  // namespace
+
+std::vector<std::string> PerfEventProfiler::GetKnownCounterNames() {
+  std::vector<std::string> names;
+#if defined(__linux__)
+  for (const CounterSpec& spec : kCounterSpecs) names.push_back(spec.name);
+#endif  // defined(__linux__)
+  return names;
+}
+
+std::unique_ptr<PerfEventProfiler> PerfEventProfiler::Create(
+    const std::vector<std::string>& counter_names, Profiler* forward_to,
+    uint32_t max_num_events) {
+  if (counter_names.empty()) return nullptr;
+  std::unique_ptr<PerfEventProfiler> profiler(
+      new PerfEventProfiler(counter_names, forward_to, max_num_events));
+  if (!profiler->OpenCounters()) return nullptr;
+  return profiler;
+}
+
+PerfEventProfiler::PerfEventProfiler(std::vector<std::string> counter_names,
+                                     Profiler* forward_to,
+                                     uint32_t max_num_events)
+    : counter_names_(std::move(counter_names)),
+      forward_to_(forward_to),
+      max_num_events_(max_num_events),
+      read_buffer_(1 + counter_names_.size()) {}
+
+PerfEventProfiler::~PerfEventProfiler() { CloseCounters(); }
+
+bool PerfEventProfiler::OpenCounters() {
+  CloseCounters();
+#if defined(__linux__)
+  for (const std::string& name : counter_names_) {
+    const CounterSpec* spec = FindCounterSpec(name);
+    if (spec == nullptr) {
+      CloseCounters();
+      return false;
+    }
+    const int fd = OpenPerfEvent(*spec, fds_.empty() ? -1 : fds_[0]);
+    if (fd < 0) {
+      CloseCounters();
+      return false;
+    }
+    fds_.push_back(fd);
+  }
+  if (ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) != 0) {
+    CloseCounters();
+    return false;
+  }
+  counters_thread_ = std::this_thread::get_id();
+  return true;
+#else
+  return false;
+#endif  // defined(__linux__)
+}
+
+void PerfEventProfiler::CloseCounters() {
+#if defined(__linux__)
+  // Members go before the leader of the group.
+  for (auto it = fds_.rbegin(); it != fds_.rend(); ++it) close(*it);
+#endif  // defined(__linux__)
+  fds_.clear();
+}
+
+bool PerfEventProfiler::ReadCounters(std::vector<uint64_t>* values) {
+#if defined(__linux__)
+  // With PERF_FORMAT_GROUP, the number of counters precedes their values.
+  const size_t size = read_buffer_.size() * sizeof(uint64_t);
+  if (fds_.empty() ||
+      read(fds_[0], read_buffer_.data(), size) != static_cast<ssize_t>(size) ||
+      read_buffer_[0] != counter_names_.size()) {
+    return false;
+  }
+  values->assign(read_buffer_.begin() + 1, read_buffer_.end());
+  return true;
+#else
+  return false;
+#endif  // defined(__linux__)
+}
+
+uint32_t PerfEventProfiler::BeginEvent(const char* tag, EventType event_type,
+                                       int64_t event_metadata1,
+                                       int64_t event_metadata2) {
+  OpenEvent open_event;
+  open_event.forwarded_handle =
+      forward_to_ ? forward_to_->BeginEvent(tag, event_type, event_metadata1,
+                                            event_metadata2)
+                  : 0;
+  open_event.has_counters = false;
+  if (enabled_ && IsOperatorEvent(event_type)) {
+    if (counters_thread_ != std::this_thread::get_id()) OpenCounters();
+    open_event.event.tag = tag;
+    open_event.event.node_index = event_metadata1;
+    open_event.event.subgraph_index = event_metadata2;
+    open_event.event.begin_timestamp_us = time::NowMicros();
+    open_event.has_counters = ReadCounters(&open_event.event.counter_values);
+  }
+  open_events_.push_back(std::move(open_event));
+  ++num_open_events_;
+  return open_events_.size() - 1;
+}
+
+void PerfEventProfiler::EndEvent(uint32_t event_handle) {
+  EndEventImpl(event_handle, nullptr, nullptr);
+}
+
+void PerfEventProfiler::EndEvent(uint32_t event_handle,
+                                 int64_t event_metadata1,
+                                 int64_t event_metadata2) {
+  EndEventImpl(event_handle, &event_metadata1, &event_metadata2);
+}
+
+void PerfEventProfiler::EndEventImpl(uint32_t event_handle,
+                                     const int64_t* event_metadata1,
+                                     const int64_t* event_metadata2) {
+  if (event_handle >= open_events_.size()) return;
+  OpenEvent& open_event = open_events_[event_handle];
+  std::vector<uint64_t> end_values;
+  // Read before forwarding, to leave out the work of the other profiler.
+  if (open_event.has_counters && ReadCounters(&end_values)) {
+    Event& event = open_event.event;
+    event.end_timestamp_us = time::NowMicros();
+    if (event_metadata1) event.node_index = *event_metadata1;
+    if (event_metadata2) event.subgraph_index = *event_metadata2;
+    for (int i = 0; i < end_values.size(); ++i) {
+      event.counter_values[i] = end_values[i] - event.counter_values[i];
+    }
+    OpCounters& op =
+        op_counters_[std::make_pair(event.subgraph_index, event.node_index)];
+    if (op.num_invocations == 0) {
+      op.tag = event.tag;
+      op.node_index = event.node_index;
+      op.subgraph_index = event.subgraph_index;
+      op.counter_totals.assign(counter_names_.size(), 0);
+    }
+    ++op.num_invocations;
+    for (int i = 0; i < event.counter_values.size(); ++i) {
+      op.counter_totals[i] += event.counter_values[i];
+    }
+    if (events_.size() < max_num_events_) events_.push_back(std::move(event));
+  }
+  if (forward_to_) {
+    if (event_metadata1 && event_metadata2) {
+      forward_to_->EndEvent(open_event.forwarded_handle, *event_metadata1,
+                            *event_metadata2);
+    } else {
+      forward_to_->EndEvent(open_event.forwarded_handle);
+    }
+  }
+  if (--num_open_events_ == 0) open_events_.clear();
+}
+
+void PerfEventProfiler::AddEvent(const char* tag, EventType event_type,
+                                 uint64_t start, uint64_t end,
+                                 int64_t event_metadata1,
+                                 int64_t event_metadata2) {
+  // Counters can't be attributed after the fact.
+  if (forward_to_) {
+    forward_to_->AddEvent(tag, event_type, start, end, event_metadata1,
+                          event_metadata2);
+  }
+}
+
+void PerfEventProfiler::Reset() {
+  events_.clear();
+  op_counters_.clear();
+}
+
+std::vector<PerfEventProfiler::OpCounters> PerfEventProfiler::GetOpCounters()
+    const {
+  std::vector<OpCounters> result;
+  result.reserve(op_counters_.size());
+  for (const auto& op : op_counters_) result.push_back(op.second);
+  return result;
+}
+
+}  // namespace profiling
+}  // namespace tflite
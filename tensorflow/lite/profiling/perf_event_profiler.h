@@ -0,0 +1,143 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_PERF_EVENT_PROFILER_H_
+#define TENSORFLOW_LITE_PROFILING_PERF_EVENT_PROFILER_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/api/profiler.h"
+
+namespace tflite {
+namespace profiling {
+
+// A profiler that reads hardware performance counters around each operator
+// invocation, using the perf_event interface of Linux and Android, and
+// forwards all events to another profiler, e.g. a BufferedProfiler recording
+// their timing.
+//
+// Counters are read through one perf_event group, so all counters of an
+// operator cover the same interval. They are opened for the thread that
+// invokes the operators, and reopened if invocations move to another thread.
+// Work that operators hand to other threads, e.g. the CPU backend thread pool,
+// isn't counted.
+//
+// Like BufferedProfiler, this is meant to be used from a single thread at a
+// time.
+class PerfEventProfiler : public tflite::Profiler {
+ public:
+  // Counter values of one operator invocation.
+  struct Event {
+    std::string tag;
+    int64_t node_index;
+    int64_t subgraph_index;
+    uint64_t begin_timestamp_us;
+    uint64_t end_timestamp_us;
+    // In the order of counter_names().
+    std::vector<uint64_t> counter_values;
+  };
+
+  // Totals of all profiled invocations of one operator.
+  struct OpCounters {
+    std::string tag;
+    int64_t node_index = 0;
+    int64_t subgraph_index = 0;
+    int64_t num_invocations = 0;
+    // In the order of counter_names().
+    std::vector<uint64_t> counter_totals;
+  };
+
+  // Returns the counter names that Create() accepts, e.g. "cycles",
+  // "instructions" or "cache-misses".
+  static std::vector<std::string> GetKnownCounterNames();
+
+  // Creates a profiler of the given counters that forwards all events to
+  // `forward_to`, which may be null and otherwise must outlive the profiler.
+  // Up to `max_num_events` invocations are kept for events().
+  // Returns nullptr if a counter is unknown, or perf_event or one of the
+  // counters isn't available, e.g. because of the platform, its
+  // perf_event_paranoid setting or the PMU of the CPU.
+  static std::unique_ptr<PerfEventProfiler> Create(
+      const std::vector<std::string>& counter_names, Profiler* forward_to,
+      uint32_t max_num_events);
+
+  ~PerfEventProfiler() override;
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override;
+  void EndEvent(uint32_t event_handle) override;
+  void EndEvent(uint32_t event_handle, int64_t event_metadata1,
+                int64_t event_metadata2) override;
+  void AddEvent(const char* tag, EventType event_type, uint64_t start,
+                uint64_t end, int64_t event_metadata1,
+                int64_t event_metadata2) override;
+
+  // Counters are only recorded while profiling is started; events are
+  // forwarded regardless.
+  void StartProfiling() { enabled_ = true; }
+  void StopProfiling() { enabled_ = false; }
+  // Clears all recorded counters.
+  void Reset();
+
+  const std::vector<std::string>& counter_names() const {
+    return counter_names_;
+  }
+  // Per-operator totals, ordered by subgraph and node index.
+  std::vector<OpCounters> GetOpCounters() const;
+  // The first recorded invocations, in the order they ended.
+  const std::vector<Event>& events() const { return events_; }
+
+ private:
+  struct OpenEvent {
+    uint32_t forwarded_handle;
+    bool has_counters;
+    Event event;
+  };
+
+  PerfEventProfiler(std::vector<std::string> counter_names,
+                    Profiler* forward_to, uint32_t max_num_events);
+
+  // (Re)opens the counters for the calling thread.
+  bool OpenCounters();
+  void CloseCounters();
+  bool ReadCounters(std::vector<uint64_t>* values);
+  void EndEventImpl(uint32_t event_handle, const int64_t* event_metadata1,
+                    const int64_t* event_metadata2);
+
+  const std::vector<std::string> counter_names_;
+  Profiler* const forward_to_;
+  const uint32_t max_num_events_;
+  std::vector<int> fds_;
+  std::thread::id counters_thread_;
+  bool enabled_ = false;
+  // Begun but not ended events, indexed by their handle. Cleared once all of
+  // them have ended.
+  std::vector<OpenEvent> open_events_;
+  int num_open_events_ = 0;
+  std::vector<Event> events_;
+  std::map<std::pair<int64_t, int64_t>, OpCounters> op_counters_;
+  std::vector<uint64_t> read_buffer_;
+};
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_PERF_EVENT_PROFILER_H_
@@ -0,0 +1,92 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/perf_event_profiler.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/profiling/buffered_profiler.h"
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+volatile int g_sink = 0;
+
+void DoWork() {
+  for (int i = 0; i < 100000; ++i) g_sink = g_sink + i;
+}
+
+TEST(PerfEventProfilerTest, UnknownCounters) {
+  EXPECT_EQ(PerfEventProfiler::Create({}, nullptr, 10), nullptr);
+  EXPECT_EQ(PerfEventProfiler::Create({"no-such-counter"}, nullptr, 10),
+            nullptr);
+}
+
+TEST(PerfEventProfilerTest, CountsOperatorEvents) {
+  BufferedProfiler buffered_profiler(10);
+  // A software counter, as hardware ones are missing on e.g. many VMs.
+  std::unique_ptr<PerfEventProfiler> profiler = PerfEventProfiler::Create(
+      {"task-clock-ns"}, &buffered_profiler, /*max_num_events=*/1);
+  if (profiler == nullptr) {
+    GTEST_SKIP() << "perf_event is not available.";
+  }
+  EXPECT_THAT(profiler->counter_names(),
+              testing::ElementsAre("task-clock-ns"));
+  buffered_profiler.StartProfiling();
+  profiler->StartProfiling();
+  for (int i = 0; i < 2; ++i) {
+    ScopedOperatorProfile op_profile(profiler.get(), "Op", /*node_index=*/3);
+    DoWork();
+  }
+  {
+    ScopedProfile profile(profiler.get(), "NotAnOp");
+    DoWork();
+  }
+  profiler->StopProfiling();
+  {
+    ScopedOperatorProfile op_profile(profiler.get(), "Op", /*node_index=*/4);
+    DoWork();
+  }
+
+  // All events are forwarded.
+  EXPECT_EQ(buffered_profiler.GetProfileEvents().size(), 4);
+
+  // Each invocation of the loop takes well over 10us.
+  const std::vector<PerfEventProfiler::OpCounters> op_counters =
+      profiler->GetOpCounters();
+  ASSERT_EQ(op_counters.size(), 1);
+  EXPECT_EQ(op_counters[0].tag, "Op");
+  EXPECT_EQ(op_counters[0].node_index, 3);
+  EXPECT_EQ(op_counters[0].num_invocations, 2);
+  ASSERT_EQ(op_counters[0].counter_totals.size(), 1);
+  EXPECT_GT(op_counters[0].counter_totals[0], 20000);
+
+  ASSERT_EQ(profiler->events().size(), 1);
+  EXPECT_GT(profiler->events()[0].counter_values[0], 10000);
+  EXPECT_GE(profiler->events()[0].end_timestamp_us,
+            profiler->events()[0].begin_timestamp_us);
+
+  profiler->Reset();
+  EXPECT_TRUE(profiler->GetOpCounters().empty());
+  EXPECT_TRUE(profiler->events().empty());
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
@@ -0,0 +1,140 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/signature_runner_pool.h"
+
+#include <memory>
+#include <utility>
+
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+
+namespace tflite {
+
+SignatureRunnerPool::Lease& SignatureRunnerPool::Lease::operator=(
+    Lease&& other) noexcept {
+  if (this != &other) {
+    Reset();
+    pool_ = other.pool_;
+    index_ = other.index_;
+    runner_ = other.runner_;
+    other.pool_ = nullptr;
+    other.index_ = -1;
+    other.runner_ = nullptr;
+  }
+  return *this;
+}
+
+void SignatureRunnerPool::Lease::Reset() {
+  if (pool_ == nullptr) return;
+  pool_->Release(index_);
+  pool_ = nullptr;
+  index_ = -1;
+  runner_ = nullptr;
+}
+
+SignatureRunnerPool::SignatureRunnerPool(int max_waiting)
+    : max_waiting_(max_waiting) {}
+
+SignatureRunnerPool::~SignatureRunnerPool() = default;
+
+std::unique_ptr<SignatureRunnerPool> SignatureRunnerPool::Create(
+    const FlatBufferModel& model, const OpResolver& op_resolver,
+    const char* signature_key, const Options& options) {
+  ErrorReporter* error_reporter = model.error_reporter();
+  if (options.num_runners < 1) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "A SignatureRunnerPool needs at least one runner.");
+    return nullptr;
+  }
+
+  std::unique_ptr<SignatureRunnerPool> pool(
+      new SignatureRunnerPool(options.max_waiting));
+  pool->interpreters_.reserve(options.num_runners);
+  pool->runners_.reserve(options.num_runners);
+  for (int i = 0; i < options.num_runners; ++i) {
+    InterpreterBuilder builder(model, op_resolver);
+    std::unique_ptr<Interpreter> interpreter;
+    if (builder.SetNumThreads(options.num_threads) != kTfLiteOk ||
+        builder(&interpreter) != kTfLiteOk || interpreter == nullptr) {
+      return nullptr;
+    }
+    if (options.configure_interpreter &&
+        options.configure_interpreter(interpreter.get()) != kTfLiteOk) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Failed to configure the interpreter of runner %d.",
+                           i);
+      return nullptr;
+    }
+    SignatureRunner* runner = interpreter->GetSignatureRunner(signature_key);
+    if (runner == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter, "Signature '%s' not found.",
+                           signature_key);
+      return nullptr;
+    }
+    if (runner->AllocateTensors() != kTfLiteOk) return nullptr;
+    pool->runners_.push_back(runner);
+    pool->interpreters_.push_back(std::move(interpreter));
+  }
+
+  pool->in_use_.reset(new std::atomic<bool>[options.num_runners]);
+  for (int i = 0; i < options.num_runners; ++i) {
+    pool->in_use_[i].store(false);
+  }
+  return pool;
+}
+
+SignatureRunnerPool::Lease SignatureRunnerPool::TryAcquire() {
+  const int num_runners = size();
+  const unsigned start = next_runner_.fetch_add(1, std::memory_order_relaxed);
+  for (int i = 0; i < num_runners; ++i) {
+    const int index = (start + i) % num_runners;
+    // Skip the runners in use without writing to their flag.
+    if (in_use_[index].load(std::memory_order_relaxed)) continue;
+    if (!in_use_[index].exchange(true)) {
+      return Lease(this, index, runners_[index]);
+    }
+  }
+  return Lease();
+}
+
+SignatureRunnerPool::Lease SignatureRunnerPool::Acquire() {
+  Lease lease = TryAcquire();
+  if (lease) return lease;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (max_waiting_ >= 0 && num_waiting_.load() >= max_waiting_) {
+    return Lease();
+  }
+  // Release() only notifies when a thread is waiting, so the count must be
+  // visible before looking for a free runner again.
+  num_waiting_.fetch_add(1);
+  while (!(lease = TryAcquire())) {
+    runner_released_.wait(lock);
+  }
+  num_waiting_.fetch_sub(1);
+  return lease;
+}
+
+void SignatureRunnerPool::Release(int index) {
+  in_use_[index].store(false);
+  if (num_waiting_.load() > 0) {
+    // Taking the lock ensures that a thread which didn't find the runner free
+    // is waiting by now, so it doesn't miss the notification.
+    std::lock_guard<std::mutex> lock(mutex_);
+    runner_released_.notify_one();
+  }
+}
+
+}  // namespace tflite
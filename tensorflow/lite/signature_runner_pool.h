@@ -0,0 +1,164 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_SIGNATURE_RUNNER_POOL_H_
+#define TENSORFLOW_LITE_SIGNATURE_RUNNER_POOL_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace tflite {
+
+/// WARNING: Experimental interface, subject to change
+///
+/// A fixed set of SignatureRunner instances of the same signature of a model,
+/// for running the model from several threads at once.
+///
+/// Each runner belongs to its own Interpreter, with its own tensors and arena,
+/// built from the same FlatBufferModel. The constant tensors of the model
+/// aren't copied: they point into the model buffer, or the memory-mapped file,
+/// shared by all the runners. Delegates that pack the weights can share them
+/// too, e.g. XNNPACK delegates created with the same weights cache.
+///
+/// A thread checks out a runner, uses it like any SignatureRunner and hands it
+/// back when the lease is destroyed:
+///
+/// <pre><code>
+/// SignatureRunnerPool::Options options;
+/// options.num_runners = 4;
+/// auto pool = SignatureRunnerPool::Create(*model, resolver, "serving_default",
+///                                         options);
+/// ...
+/// // From any thread:
+/// SignatureRunnerPool::Lease lease = pool->Acquire();
+/// if (!lease) {
+///   // Too many requests are waiting, return an overloaded error.
+/// }
+/// lease->input_tensor("x")->data.f[0] = ...;
+/// if (lease->Invoke() != kTfLiteOk) {
+///   // Return failure.
+/// }
+/// </code></pre>
+///
+/// The pool is thread-safe. A leased runner is only used by the thread holding
+/// the lease, so it needs no synchronization. The model must outlive the pool,
+/// and the pool must outlive its leases.
+class SignatureRunnerPool {
+ public:
+  struct Options {
+    /// Number of runners, i.e. of requests that can run at the same time.
+    int num_runners = 1;
+    /// Maximum number of threads blocked in Acquire() waiting for a runner;
+    /// Acquire() fails immediately once this many threads are waiting. -1
+    /// means no limit.
+    int max_waiting = -1;
+    /// Number of threads used by each interpreter, see
+    /// InterpreterBuilder::SetNumThreads().
+    int num_threads = 1;
+    /// If set, called on each interpreter once it's built and before its
+    /// tensors are allocated, e.g. to apply delegates. The interpreter should
+    /// take ownership of the delegates applied to it, see
+    /// Interpreter::ModifyGraphWithDelegate(TfLiteDelegatePtr).
+    std::function<TfLiteStatus(Interpreter*)> configure_interpreter;
+  };
+
+  /// A runner checked out of the pool, which is handed back to the pool when
+  /// the lease is destroyed. An empty lease converts to false.
+  class Lease {
+   public:
+    Lease() = default;
+    ~Lease() { Reset(); }
+    Lease(Lease&& other) noexcept { *this = std::move(other); }
+    Lease& operator=(Lease&& other) noexcept;
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    explicit operator bool() const { return pool_ != nullptr; }
+    SignatureRunner* get() const { return runner_; }
+    SignatureRunner* operator->() const { return runner_; }
+    SignatureRunner& operator*() const { return *runner_; }
+
+    /// Hands the runner back to the pool early, leaving the lease empty.
+    void Reset();
+
+   private:
+    friend class SignatureRunnerPool;
+    Lease(SignatureRunnerPool* pool, int index, SignatureRunner* runner)
+        : pool_(pool), index_(index), runner_(runner) {}
+
+    SignatureRunnerPool* pool_ = nullptr;
+    int index_ = -1;
+    SignatureRunner* runner_ = nullptr;
+  };
+
+  /// Builds `options.num_runners` interpreters of `model` with `op_resolver`
+  /// and allocates the tensors of their `signature_key` runners. Returns null
+  /// on failure, reporting the error to the error reporter of `model`.
+  static std::unique_ptr<SignatureRunnerPool> Create(
+      const FlatBufferModel& model, const OpResolver& op_resolver,
+      const char* signature_key, const Options& options);
+
+  ~SignatureRunnerPool();
+  SignatureRunnerPool(const SignatureRunnerPool&) = delete;
+  SignatureRunnerPool& operator=(const SignatureRunnerPool&) = delete;
+
+  /// Checks out a free runner without blocking or taking a lock. Returns an
+  /// empty lease if all the runners are in use.
+  Lease TryAcquire();
+
+  /// Checks out a free runner, blocking until one is handed back if all of
+  /// them are in use. Returns an empty lease without blocking if
+  /// `Options::max_waiting` threads are already waiting.
+  Lease Acquire();
+
+  /// Number of runners of the pool.
+  int size() const { return static_cast<int>(runners_.size()); }
+
+  /// Number of threads currently blocked in Acquire().
+  int num_waiting() const { return num_waiting_.load(); }
+
+ private:
+  explicit SignatureRunnerPool(int max_waiting);
+
+  void Release(int index);
+
+  const int max_waiting_;
+  std::vector<std::unique_ptr<Interpreter>> interpreters_;
+  std::vector<SignatureRunner*> runners_;
+  // Whether each runner is leased. A runner is checked out by the thread that
+  // flips its flag from false to true.
+  std::unique_ptr<std::atomic<bool>[]> in_use_;
+  // Where the next checkout starts looking for a free runner, to spread the
+  // checkouts over the runners.
+  std::atomic<unsigned> next_runner_{0};
+
+  std::atomic<int> num_waiting_{0};
+  std::mutex mutex_;
+  std::condition_variable runner_released_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_SIGNATURE_RUNNER_POOL_H_
@@ -0,0 +1,137 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/signature_runner_pool.h"
+
+#include <atomic>
+#include <memory>
+#include <set>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/testing/util.h"
+
+namespace tflite {
+namespace {
+
+class SignatureRunnerPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    model_ = FlatBufferModel::BuildFromFile(
+        "tensorflow/lite/testdata/multi_signatures.bin", &reporter_);
+    ASSERT_TRUE(model_);
+  }
+
+  std::unique_ptr<SignatureRunnerPool> CreatePool(int num_runners,
+                                                  int max_waiting = -1) {
+    SignatureRunnerPool::Options options;
+    options.num_runners = num_runners;
+    options.max_waiting = max_waiting;
+    return SignatureRunnerPool::Create(*model_, resolver_, "add", options);
+  }
+
+  TestErrorReporter reporter_;
+  std::unique_ptr<FlatBufferModel> model_;
+  ops::builtin::BuiltinOpResolver resolver_;
+};
+
+TEST_F(SignatureRunnerPoolTest, InvalidOptions) {
+  EXPECT_EQ(CreatePool(/*num_runners=*/0), nullptr);
+  SignatureRunnerPool::Options options;
+  EXPECT_EQ(SignatureRunnerPool::Create(*model_, resolver_, "dummy", options),
+            nullptr);
+  options.configure_interpreter = [](Interpreter*) { return kTfLiteError; };
+  EXPECT_EQ(SignatureRunnerPool::Create(*model_, resolver_, "add", options),
+            nullptr);
+}
+
+TEST_F(SignatureRunnerPoolTest, LeasesDistinctRunners) {
+  std::unique_ptr<SignatureRunnerPool> pool = CreatePool(/*num_runners=*/3);
+  ASSERT_NE(pool, nullptr);
+  EXPECT_EQ(pool->size(), 3);
+
+  std::vector<SignatureRunnerPool::Lease> leases;
+  std::set<SignatureRunner*> runners;
+  for (int i = 0; i < pool->size(); ++i) {
+    leases.push_back(pool->TryAcquire());
+    ASSERT_TRUE(leases.back());
+    EXPECT_EQ(leases.back()->signature_key(), "add");
+    runners.insert(leases.back().get());
+  }
+  EXPECT_EQ(runners.size(), 3);
+  EXPECT_FALSE(pool->TryAcquire());
+
+  // A runner handed back can be leased again.
+  SignatureRunner* released = leases[1].get();
+  leases[1].Reset();
+  EXPECT_FALSE(leases[1]);
+  SignatureRunnerPool::Lease lease = pool->Acquire();
+  ASSERT_TRUE(lease);
+  EXPECT_EQ(lease.get(), released);
+
+  // Moving a lease keeps a single owner.
+  SignatureRunnerPool::Lease moved = std::move(lease);
+  EXPECT_FALSE(lease);  // NOLINT(bugprone-use-after-move)
+  EXPECT_EQ(moved.get(), released);
+  EXPECT_FALSE(pool->TryAcquire());
+}
+
+TEST_F(SignatureRunnerPoolTest, AcquireFailsWhenTooManyWaiting) {
+  std::unique_ptr<SignatureRunnerPool> pool =
+      CreatePool(/*num_runners=*/1, /*max_waiting=*/1);
+  ASSERT_NE(pool, nullptr);
+  SignatureRunnerPool::Lease lease = pool->Acquire();
+  ASSERT_TRUE(lease);
+
+  std::thread waiter([&pool]() { EXPECT_TRUE(pool->Acquire()); });
+  while (pool->num_waiting() == 0) std::this_thread::yield();
+  // The queue is full.
+  EXPECT_FALSE(pool->Acquire());
+
+  lease.Reset();
+  waiter.join();
+  EXPECT_EQ(pool->num_waiting(), 0);
+}
+
+TEST_F(SignatureRunnerPoolTest, ConcurrentInvocations) {
+  std::unique_ptr<SignatureRunnerPool> pool = CreatePool(/*num_runners=*/2);
+  ASSERT_NE(pool, nullptr);
+
+  constexpr int kNumThreads = 8;
+  constexpr int kNumInvocations = 100;
+  std::atomic<int> num_failures{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&pool, &num_failures, t]() {
+      for (int i = 0; i < kNumInvocations; ++i) {
+        SignatureRunnerPool::Lease lease = pool->Acquire();
+        const float value = t * kNumInvocations + i;
+        lease->input_tensor("x")->data.f[0] = value;
+        if (lease->Invoke() != kTfLiteOk ||
+            lease->output_tensor("output_0")->data.f[0] != value + 2) {
+          ++num_failures;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(num_failures.load(), 0);
+}
+
+}  // namespace
+}  // namespace tflite
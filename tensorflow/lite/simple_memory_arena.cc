@@ -91,6 +91,40 @@ TfLiteStatus SimpleMemoryArena::Allocate(
   return kTfLiteOk;
 }
 
+TfLiteStatus SimpleMemoryArena::AllocateAt(
+    TfLiteContext* context, size_t alignment, size_t offset, size_t size,
+    int32_t tensor, int32_t first_node, int32_t last_node,
+    ArenaAllocWithUsageInterval* new_alloc) {
+  TF_LITE_ENSURE(context, alignment <= arena_alignment_);
+  if (size != 0) {
+    if (offset % alignment != 0) return kTfLiteError;
+    for (const auto& alloc : ordered_allocs_) {
+      // The allocs are sorted by offset, none of the remaining ones overlaps.
+      if (alloc.offset >= offset + size) break;
+      if (alloc.last_node < first_node || alloc.first_node > last_node) {
+        continue;
+      }
+      if (alloc.offset + alloc.size > offset) return kTfLiteError;
+    }
+  }
+  new_alloc->tensor = tensor;
+  new_alloc->first_node = first_node;
+  new_alloc->last_node = last_node;
+  new_alloc->size = size;
+  if (size == 0) {
+    new_alloc->offset = 0;
+    return kTfLiteOk;
+  }
+
+  high_water_mark_ = std::max(high_water_mark_, offset + size);
+  new_alloc->offset = offset;
+
+  auto insertion_it = std::upper_bound(ordered_allocs_.begin(),
+                                       ordered_allocs_.end(), *new_alloc);
+  ordered_allocs_.insert(insertion_it, *new_alloc);
+  return kTfLiteOk;
+}
+
 TfLiteStatus SimpleMemoryArena::Deallocate(
     TfLiteContext* context, const ArenaAllocWithUsageInterval& alloc) {
   if (alloc.size == 0) {
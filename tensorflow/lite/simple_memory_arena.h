@@ -76,6 +76,15 @@ class SimpleMemoryArena {
                         int32_t tensor, int32_t first_node, int32_t last_node,
                         ArenaAllocWithUsageInterval* new_alloc);
 
+  // Same as Allocate(), but places the allocation at the given offset instead
+  // of searching for one. Fails without reporting an error if the offset isn't
+  // aligned, or if the allocation would overlap another one whose usage
+  // interval intersects with [first_node, last_node].
+  TfLiteStatus AllocateAt(TfLiteContext* context, size_t alignment,
+                          size_t offset, size_t size, int32_t tensor,
+                          int32_t first_node, int32_t last_node,
+                          ArenaAllocWithUsageInterval* new_alloc);
+
   TfLiteStatus Deallocate(TfLiteContext* context,
                           const ArenaAllocWithUsageInterval& alloc);
 
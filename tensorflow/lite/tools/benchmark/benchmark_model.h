@@ -231,6 +231,10 @@ class BenchmarkModel {
 
   BenchmarkParams params_;
   BenchmarkListeners listeners_;
+
+ private:
+  // Drives the initialization and single runs of many instances at once.
+  friend class BenchmarkMultiModel;
 };
 
 }  // namespace benchmark
@@ -0,0 +1,453 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/benchmark_multi_model.h"
+
+#if !defined(_WIN32)
+#include <time.h>
+#endif  // !defined(_WIN32)
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <random>
+#include <sstream>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "tensorflow/lite/profiling/time.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_utils.h"
+#include "tensorflow/lite/tools/logging.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+using tensorflow::Stat;
+
+// Requests of a model that wait for a free stream, as their arrival times.
+class RequestQueue {
+ public:
+  void Push(int64_t arrival_us) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      arrivals_us_.push_back(arrival_us);
+    }
+    cond_.notify_one();
+  }
+
+  // Blocks until a request is available and returns true, or returns false
+  // once the queue is closed.
+  bool Pop(int64_t* arrival_us) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return closed_ || !arrivals_us_.empty(); });
+    if (closed_) return false;
+    *arrival_us = arrivals_us_.front();
+    arrivals_us_.pop_front();
+    return true;
+  }
+
+  // Wakes up all waiting streams and returns the number of requests that are
+  // left unserved.
+  int64_t Close() {
+    int64_t num_unserved;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+      num_unserved = arrivals_us_.size();
+      arrivals_us_.clear();
+    }
+    cond_.notify_all();
+    return num_unserved;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<int64_t> arrivals_us_;
+  bool closed_ = false;
+};
+
+struct Stream {
+  std::unique_ptr<BenchmarkModel> model;
+  int64_t startup_latency_us = 0;
+  uint64_t input_bytes = 0;
+  profiling::memory::MemoryUsage init_mem_usage;
+  Stat<int64_t> warmup_time_us;
+  Stat<int64_t> inference_time_us;
+  std::vector<int64_t> latencies_us;
+  int64_t num_failed_requests = 0;
+  int64_t cpu_time_us = 0;
+};
+
+struct ModelStreams {
+  std::string graph;
+  float target_qps = 0.0f;
+  std::vector<Stream> streams;
+  RequestQueue queue;
+  int64_t num_unserved_requests = 0;
+};
+
+// Returns the CPU time consumed by the calling thread, or 0 where it can't be
+// measured.
+int64_t ThreadCpuTimeMicros() {
+#if defined(_WIN32)
+  return 0;
+#else
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+  return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#endif  // defined(_WIN32)
+}
+
+// Returns the nearest-rank percentile of sorted |values|.
+int64_t Percentile(const std::vector<int64_t>& values, double percentile) {
+  if (values.empty()) return 0;
+  const int64_t rank =
+      static_cast<int64_t>(std::ceil(percentile / 100.0 * values.size()));
+  return values[std::min<int64_t>(std::max<int64_t>(rank, 1), values.size()) -
+                1];
+}
+
+// Returns the i-th element of |values|, or its only element if there is just
+// one, so that a single value applies to all models.
+template <typename T>
+T PerModelValue(const std::vector<T>& values, int i) {
+  return values.size() == 1 ? values[0] : values[i];
+}
+
+}  // namespace
+
+void MultiModelLoggingListener::OnModelStreamsEnd(
+    const ModelStreamsResult& result) {
+  std::stringstream stream;
+  stream << result.graph << ": " << result.num_streams << " stream(s), ";
+  if (result.target_qps > 0) {
+    stream << "target QPS " << result.target_qps << ", ";
+  } else {
+    stream << "closed loop, ";
+  }
+  stream << "achieved QPS " << result.achieved_qps << ", "
+         << result.num_requests << " requests (" << result.num_failed_requests
+         << " failed, " << result.num_unserved_requests << " unserved)";
+  TFLITE_LOG(INFO) << stream.str();
+  TFLITE_LOG(INFO) << "  Latency in us: p50=" << result.p50_latency_us
+                   << " p99=" << result.p99_latency_us
+                   << " p999=" << result.p999_latency_us
+                   << " avg=" << result.latency_us.avg()
+                   << " max=" << result.latency_us.max();
+  for (int i = 0; i < result.num_streams; ++i) {
+    std::stringstream stream_info;
+    stream_info << "  Stream " << i << ": CPU utilization "
+                << result.stream_cpu_utilization[i] * 100 << "%";
+    const auto& init_mem_usage = result.stream_init_mem_usage[i];
+    if (init_mem_usage.IsSupported()) {
+      stream_info << ", init memory footprint delta (MB) "
+                  << init_mem_usage.max_rss_kb / 1024.0;
+    }
+    TFLITE_LOG(INFO) << stream_info.str();
+  }
+  if (result.peak_mem_mb > 0) {
+    TFLITE_LOG(INFO) << "  Overall peak memory footprint (MB) via periodic "
+                        "monitoring: "
+                     << result.peak_mem_mb;
+  }
+}
+
+BenchmarkMultiModel::BenchmarkMultiModel(StreamFactory create_stream)
+    : BenchmarkMultiModel(DefaultParams(), std::move(create_stream)) {}
+
+BenchmarkMultiModel::BenchmarkMultiModel(BenchmarkParams params,
+                                         StreamFactory create_stream)
+    : params_(std::move(params)), create_stream_(std::move(create_stream)) {
+  AddListener(&log_output_);
+}
+
+BenchmarkParams BenchmarkMultiModel::DefaultParams() {
+  BenchmarkParams params;
+  params.AddParam("graphs", BenchmarkParam::Create<std::string>(""));
+  params.AddParam("num_streams", BenchmarkParam::Create<std::string>("1"));
+  params.AddParam("target_qps", BenchmarkParam::Create<std::string>("0"));
+  params.AddParam("duration_secs", BenchmarkParam::Create<float>(10.0f));
+  params.AddParam("warmup_runs_per_stream",
+                  BenchmarkParam::Create<int32_t>(1));
+  params.AddParam("arrival_seed", BenchmarkParam::Create<int32_t>(0));
+  return params;
+}
+
+std::vector<Flag> BenchmarkMultiModel::GetFlags() {
+  return {
+      CreateFlag<std::string>(
+          "graphs", &params_,
+          "A comma-separated list of models to run concurrently."),
+      CreateFlag<std::string>(
+          "num_streams", &params_,
+          "A comma-separated list of the number of streams, i.e. interpreters "
+          "each invoked from a thread of its own, of each model in --graphs. "
+          "A single value applies to all models."),
+      CreateFlag<std::string>(
+          "target_qps", &params_,
+          "A comma-separated list of the mean rate of requests of each model "
+          "in --graphs. Requests arrive as a Poisson process regardless of "
+          "whether a stream is free (open loop). 0 for streams that run back "
+          "to back instead (closed loop). A single value applies to all "
+          "models."),
+      CreateFlag<float>("duration_secs", &params_,
+                        "Duration of the concurrent run in seconds."),
+      CreateFlag<int32_t>(
+          "warmup_runs_per_stream", &params_,
+          "Number of runs of each stream before the concurrent run starts."),
+      CreateFlag<int32_t>("arrival_seed", &params_,
+                          "Seed of the request arrival times."),
+  };
+}
+
+bool BenchmarkMultiModel::ParseFlags(int* argc, char** argv) {
+  auto flag_list = GetFlags();
+  const bool parse_result =
+      Flags::Parse(argc, const_cast<const char**>(argv), flag_list);
+  if (!parse_result) {
+    std::string usage = Flags::Usage(argv[0], flag_list);
+    TFLITE_LOG(ERROR) << usage;
+    return false;
+  }
+  return true;
+}
+
+TfLiteStatus BenchmarkMultiModel::Run(int argc, char** argv) {
+  // Parse flags that are supported by this particular binary first, the
+  // remaining ones are for the streams.
+  if (!ParseFlags(&argc, argv)) return kTfLiteError;
+  stream_args_.assign(argv, argv + argc);
+  return Run();
+}
+
+TfLiteStatus BenchmarkMultiModel::Run() {
+  std::vector<std::string> graphs;
+  std::vector<int> num_streams;
+  std::vector<float> target_qps;
+  if (!util::SplitAndParse(params_.Get<std::string>("graphs"), ',', &graphs) ||
+      graphs.empty()) {
+    TFLITE_LOG(ERROR) << "Please specify the models with --graphs.";
+    return kTfLiteError;
+  }
+  if (!util::SplitAndParse(params_.Get<std::string>("num_streams"), ',',
+                           &num_streams) ||
+      (num_streams.size() != 1 && num_streams.size() != graphs.size()) ||
+      *std::min_element(num_streams.begin(), num_streams.end()) < 1) {
+    TFLITE_LOG(ERROR) << "--num_streams must have a positive value, or one per "
+                         "model of --graphs.";
+    return kTfLiteError;
+  }
+  if (!util::SplitAndParse(params_.Get<std::string>("target_qps"), ',',
+                           &target_qps) ||
+      (target_qps.size() != 1 && target_qps.size() != graphs.size()) ||
+      *std::min_element(target_qps.begin(), target_qps.end()) < 0) {
+    TFLITE_LOG(ERROR) << "--target_qps must have a non-negative value, or one "
+                         "per model of --graphs.";
+    return kTfLiteError;
+  }
+  const float duration_secs = params_.Get<float>("duration_secs");
+  if (duration_secs <= 0) {
+    TFLITE_LOG(ERROR) << "--duration_secs must be positive.";
+    return kTfLiteError;
+  }
+
+  // Create and initialize all streams one after another, so that the memory
+  // footprint added by each one can be told apart.
+  std::vector<std::unique_ptr<ModelStreams>> models;
+  for (int i = 0; i < graphs.size(); ++i) {
+    models.emplace_back(new ModelStreams);
+    ModelStreams& model = *models.back();
+    model.graph = graphs[i];
+    model.target_qps = PerModelValue(target_qps, i);
+    model.streams.resize(PerModelValue(num_streams, i));
+    for (int s = 0; s < model.streams.size(); ++s) {
+      Stream& stream = model.streams[s];
+      stream.model = create_stream_();
+      if (!stream_args_.empty()) {
+        // Parsing consumes the flags, so each stream gets a copy of them.
+        std::vector<std::string> args(stream_args_);
+        std::vector<char*> argv;
+        for (auto& arg : args) argv.push_back(&arg[0]);
+        int argc = argv.size();
+        TF_LITE_ENSURE_STATUS(stream.model->ParseFlags(&argc, argv.data()));
+      }
+      stream.model->mutable_params()->Set<std::string>("graph", model.graph);
+      TF_LITE_ENSURE_STATUS(stream.model->ValidateParams());
+      if (s == 0) stream.model->LogParams();
+
+      const auto start_mem_usage = profiling::memory::GetMemoryUsage();
+      const int64_t init_start_us = profiling::time::NowMicros();
+      TF_LITE_ENSURE_STATUS(stream.model->Init());
+      stream.startup_latency_us = profiling::time::NowMicros() - init_start_us;
+      stream.init_mem_usage =
+          profiling::memory::GetMemoryUsage() - start_mem_usage;
+      TF_LITE_ENSURE_STATUS(stream.model->PrepareInputData());
+      stream.input_bytes = stream.model->ComputeInputBytes();
+
+      stream.model->listeners_.OnBenchmarkStart(stream.model->params_);
+      for (int r = 0; r < params_.Get<int32_t>("warmup_runs_per_stream"); ++r) {
+        stream.model->ResetInputsAndOutputs();
+        stream.model->listeners_.OnSingleRunStart(WARMUP);
+        const int64_t start_us = profiling::time::NowMicros();
+        TF_LITE_ENSURE_STATUS(stream.model->RunImpl());
+        stream.warmup_time_us.UpdateStat(profiling::time::NowMicros() -
+                                         start_us);
+        stream.model->listeners_.OnSingleRunEnd();
+      }
+    }
+    for (auto* listener : listeners_) {
+      listener->OnBenchmarkStart(model.streams[0].model->params_);
+    }
+  }
+
+  // Streams share the process, so peak memory is only monitored as a whole,
+  // as requested by the flags of the streams.
+  auto peak_memory_reporter =
+      models[0]->streams[0].model->MayCreateMemoryUsageMonitor();
+  if (peak_memory_reporter != nullptr) peak_memory_reporter->Start();
+
+  TFLITE_LOG(INFO) << "Running " << graphs.size() << " model(s) concurrently "
+                   << "for " << duration_secs << " seconds.";
+  const int64_t start_us = profiling::time::NowMicros();
+  const int64_t end_us =
+      start_us + static_cast<int64_t>(duration_secs * 1.e6f);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < models.size(); ++i) {
+    ModelStreams* model = models[i].get();
+    const bool open_loop = model->target_qps > 0;
+    for (Stream& stream_ref : model->streams) {
+      Stream* stream = &stream_ref;
+      threads.emplace_back([model, stream, open_loop, end_us] {
+        const int64_t cpu_start_us = ThreadCpuTimeMicros();
+        BenchmarkModel* benchmark = stream->model.get();
+        while (true) {
+          int64_t arrival_us;
+          if (open_loop) {
+            if (!model->queue.Pop(&arrival_us)) break;
+          } else {
+            arrival_us = profiling::time::NowMicros();
+            if (arrival_us >= end_us) break;
+          }
+          benchmark->ResetInputsAndOutputs();
+          benchmark->listeners_.OnSingleRunStart(REGULAR);
+          const int64_t run_start_us = profiling::time::NowMicros();
+          const TfLiteStatus status = benchmark->RunImpl();
+          const int64_t run_end_us = profiling::time::NowMicros();
+          benchmark->listeners_.OnSingleRunEnd();
+          stream->inference_time_us.UpdateStat(run_end_us - run_start_us);
+          stream->latencies_us.push_back(run_end_us - arrival_us);
+          if (status != kTfLiteOk) ++stream->num_failed_requests;
+        }
+        stream->cpu_time_us = ThreadCpuTimeMicros() - cpu_start_us;
+      });
+    }
+    if (open_loop) {
+      // Arrival times are the scheduled ones, so that a late wake-up of this
+      // thread doesn't hide any queueing delay.
+      const int seed = params_.Get<int32_t>("arrival_seed") + i;
+      threads.emplace_back([model, start_us, end_us, seed] {
+        std::mt19937 random_engine(seed);
+        std::exponential_distribution<double> interval_secs(model->target_qps);
+        double arrival_us = start_us;
+        while (true) {
+          arrival_us += interval_secs(random_engine) * 1e6;
+          if (arrival_us >= end_us) break;
+          const int64_t now_us = profiling::time::NowMicros();
+          if (arrival_us > now_us) {
+            profiling::time::SleepForMicros(arrival_us - now_us);
+          }
+          model->queue.Push(static_cast<int64_t>(arrival_us));
+        }
+        const int64_t now_us = profiling::time::NowMicros();
+        if (end_us > now_us) profiling::time::SleepForMicros(end_us - now_us);
+        model->num_unserved_requests = model->queue.Close();
+      });
+    }
+  }
+  for (auto& thread : threads) thread.join();
+  // Includes the time streams took to finish their last requests.
+  const int64_t run_us = profiling::time::NowMicros() - start_us;
+
+  float peak_mem_mb = profiling::memory::MemoryUsageMonitor::kInvalidMemUsageMB;
+  if (peak_memory_reporter != nullptr) {
+    peak_memory_reporter->Stop();
+    peak_mem_mb = peak_memory_reporter->GetPeakMemUsageInMB();
+  }
+
+  TfLiteStatus status = kTfLiteOk;
+  for (const auto& model : models) {
+    ModelStreamsResult result;
+    result.graph = model->graph;
+    result.num_streams = model->streams.size();
+    result.target_qps = model->target_qps;
+    result.num_unserved_requests = model->num_unserved_requests;
+    result.peak_mem_mb = peak_mem_mb;
+    std::vector<int64_t> latencies_us;
+    int64_t startup_latency_us = 0;
+    profiling::memory::MemoryUsage init_mem_usage;
+    init_mem_usage.max_rss_kb = 0;
+    init_mem_usage.total_allocated_bytes = 0;
+    init_mem_usage.in_use_allocated_bytes = 0;
+    for (Stream& stream : model->streams) {
+      BenchmarkModel* benchmark = stream.model.get();
+      // Each stream reports its own results, e.g. to the listeners the
+      // BenchmarkModel added for itself.
+      benchmark->listeners_.OnBenchmarkEnd(
+          {benchmark->MayGetModelFileSize() / 1e6, stream.startup_latency_us,
+           stream.input_bytes, stream.warmup_time_us, stream.inference_time_us,
+           stream.init_mem_usage, stream.init_mem_usage, peak_mem_mb});
+      latencies_us.insert(latencies_us.end(), stream.latencies_us.begin(),
+                          stream.latencies_us.end());
+      startup_latency_us += stream.startup_latency_us;
+      init_mem_usage = init_mem_usage + stream.init_mem_usage;
+      result.num_failed_requests += stream.num_failed_requests;
+      result.stream_cpu_utilization.push_back(
+          static_cast<float>(stream.cpu_time_us) / run_us);
+      result.stream_init_mem_usage.push_back(stream.init_mem_usage);
+    }
+    if (result.num_failed_requests > 0) status = kTfLiteError;
+
+    std::sort(latencies_us.begin(), latencies_us.end());
+    for (int64_t latency_us : latencies_us) {
+      result.latency_us.UpdateStat(latency_us);
+    }
+    result.num_requests = latencies_us.size();
+    result.achieved_qps = result.num_requests * 1e6 / run_us;
+    result.p50_latency_us = Percentile(latencies_us, 50);
+    result.p99_latency_us = Percentile(latencies_us, 99);
+    result.p999_latency_us = Percentile(latencies_us, 99.9);
+
+    // Aggregates over the streams of the model, with the warmup runs of its
+    // first stream.
+    Stream& first_stream = model->streams[0];
+    const BenchmarkResults results(
+        first_stream.model->MayGetModelFileSize() / 1e6, startup_latency_us,
+        first_stream.input_bytes, first_stream.warmup_time_us,
+        result.latency_us, init_mem_usage, init_mem_usage, peak_mem_mb);
+    for (auto* listener : listeners_) {
+      listener->OnBenchmarkEnd(results);
+      listener->OnModelStreamsEnd(result);
+    }
+  }
+  return status;
+}
+
+}  // namespace benchmark
+}  // namespace tflite
@@ -0,0 +1,132 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_TOOLS_BENCHMARK_BENCHMARK_MULTI_MODEL_H_
+#define TENSORFLOW_LITE_TOOLS_BENCHMARK_BENCHMARK_MULTI_MODEL_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/util/stats_calculator.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/profiling/memory_info.h"
+#include "tensorflow/lite/profiling/memory_usage_monitor.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_model.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_params.h"
+#include "tensorflow/lite/tools/command_line_flags.h"
+
+namespace tflite {
+namespace benchmark {
+
+// Results of one model of a BenchmarkMultiModel run, over all of its streams.
+struct ModelStreamsResult {
+  std::string graph;
+  int num_streams = 0;
+  // Requested mean arrival rate, 0 for closed-loop runs.
+  float target_qps = 0.0f;
+  // Completed requests per second of the run.
+  double achieved_qps = 0.0;
+  int64_t num_requests = 0;
+  int64_t num_failed_requests = 0;
+  // Requests that had arrived but found no free stream by the end of the run.
+  int64_t num_unserved_requests = 0;
+  // Latencies from the arrival of a request to the end of its inference, so
+  // they include the time spent waiting for a free stream.
+  tensorflow::Stat<int64_t> latency_us;
+  int64_t p50_latency_us = 0;
+  int64_t p99_latency_us = 0;
+  int64_t p999_latency_us = 0;
+  // CPU time of each stream's thread over the duration of the run. Threads
+  // owned by the interpreter of the stream, e.g. its CPU backend thread pool,
+  // aren't accounted for.
+  std::vector<float> stream_cpu_utilization;
+  // Memory footprint added by initializing each stream. Streams are
+  // initialized one after another, so these are deltas of the process-wide
+  // usage.
+  std::vector<profiling::memory::MemoryUsage> stream_init_mem_usage;
+  // Peak memory footprint of the whole process during the run, or
+  // MemoryUsageMonitor::kInvalidMemUsageMB if not monitored.
+  float peak_mem_mb = profiling::memory::MemoryUsageMonitor::kInvalidMemUsageMB;
+};
+
+// Listener of a BenchmarkMultiModel run. For each model, OnBenchmarkStart is
+// called with the parameters of its first stream once all streams are
+// initialized, and OnBenchmarkEnd with the results of all its streams, then
+// OnModelStreamsEnd. Single runs aren't reported, as they happen on many
+// threads at once; each stream reports them to its own listeners instead.
+class MultiModelBenchmarkListener : public BenchmarkListener {
+ public:
+  virtual void OnModelStreamsEnd(const ModelStreamsResult& result) {}
+};
+
+// Listener that logs the per-model results of a BenchmarkMultiModel run.
+class MultiModelLoggingListener : public MultiModelBenchmarkListener {
+ public:
+  void OnModelStreamsEnd(const ModelStreamsResult& result) override;
+};
+
+// Benchmarks several models running at once, for capacity planning of hosts
+// serving more than one interpreter.
+//
+// Each model is served by a number of streams, i.e. BenchmarkModel instances
+// each with a thread of its own. With a target rate, requests of a model
+// arrive as an open-loop Poisson process and queue up until one of its
+// streams is free. Otherwise streams run back to back (closed loop).
+//
+// Flags that aren't specific to this class are passed on to every stream, so
+// e.g. --num_threads or delegate flags apply to all models alike.
+class BenchmarkMultiModel {
+ public:
+  // Creates the BenchmarkModel of a single stream, with its default
+  // parameters. The "graph" parameter of the stream is set afterwards.
+  using StreamFactory = std::function<std::unique_ptr<BenchmarkModel>()>;
+
+  explicit BenchmarkMultiModel(StreamFactory create_stream);
+  BenchmarkMultiModel(BenchmarkParams params, StreamFactory create_stream);
+  virtual ~BenchmarkMultiModel() {}
+
+  // |listener| is not owned and should outlast this instance.
+  void AddListener(MultiModelBenchmarkListener* listener) {
+    listeners_.push_back(listener);
+  }
+
+  BenchmarkParams* mutable_params() { return &params_; }
+
+  TfLiteStatus Run(int argc, char** argv);
+  TfLiteStatus Run();
+
+  static BenchmarkParams DefaultParams();
+
+ protected:
+  // Unparsable flags will remain in 'argv' in the original order and 'argc'
+  // will be updated accordingly.
+  bool ParseFlags(int* argc, char** argv);
+  virtual std::vector<Flag> GetFlags();
+
+  BenchmarkParams params_;
+  const StreamFactory create_stream_;
+  // Flags forwarded to each stream, starting with the program name.
+  std::vector<std::string> stream_args_;
+  std::vector<MultiModelBenchmarkListener*> listeners_;
+  MultiModelLoggingListener log_output_;
+};
+
+}  // namespace benchmark
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_BENCHMARK_BENCHMARK_MULTI_MODEL_H_
@@ -0,0 +1,120 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/tools/benchmark/benchmark_multi_model.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/profiling/time.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+std::atomic<int> g_num_runs;
+
+// Model whose inference takes 1ms and that counts all its runs.
+class FakeBenchmarkModel : public BenchmarkModel {
+ public:
+  FakeBenchmarkModel() : BenchmarkModel(DefaultParams()) {
+    params_.AddParam("graph", BenchmarkParam::Create<std::string>(""));
+  }
+  TfLiteStatus Init() override {
+    return params_.Get<std::string>("graph").empty() ? kTfLiteError
+                                                     : kTfLiteOk;
+  }
+  uint64_t ComputeInputBytes() override { return 4; }
+  TfLiteStatus RunImpl() override {
+    profiling::time::SleepForMicros(1000);
+    ++g_num_runs;
+    return kTfLiteOk;
+  }
+};
+
+class RecordingListener : public MultiModelBenchmarkListener {
+ public:
+  void OnBenchmarkStart(const BenchmarkParams& params) override {
+    graphs.push_back(params.Get<std::string>("graph"));
+  }
+  void OnModelStreamsEnd(const ModelStreamsResult& result) override {
+    results.push_back(result);
+  }
+  std::vector<std::string> graphs;
+  std::vector<ModelStreamsResult> results;
+};
+
+std::unique_ptr<BenchmarkMultiModel> CreateBenchmark(
+    const std::string& graphs, const std::string& num_streams,
+    const std::string& target_qps) {
+  auto benchmark = std::make_unique<BenchmarkMultiModel>(
+      [] { return std::make_unique<FakeBenchmarkModel>(); });
+  BenchmarkParams* params = benchmark->mutable_params();
+  params->Set<std::string>("graphs", graphs);
+  params->Set<std::string>("num_streams", num_streams);
+  params->Set<std::string>("target_qps", target_qps);
+  params->Set<float>("duration_secs", 0.5f);
+  return benchmark;
+}
+
+TEST(BenchmarkMultiModelTest, InvalidParams) {
+  EXPECT_EQ(CreateBenchmark("", "1", "0")->Run(), kTfLiteError);
+  EXPECT_EQ(CreateBenchmark("a,b", "1,2,3", "0")->Run(), kTfLiteError);
+  EXPECT_EQ(CreateBenchmark("a,b", "0", "0")->Run(), kTfLiteError);
+  EXPECT_EQ(CreateBenchmark("a,b", "1", "-1,1")->Run(), kTfLiteError);
+}
+
+TEST(BenchmarkMultiModelTest, RunsAllStreams) {
+  g_num_runs = 0;
+  auto benchmark = CreateBenchmark("open,closed", "2,1", "100,0");
+  RecordingListener listener;
+  benchmark->AddListener(&listener);
+  ASSERT_EQ(benchmark->Run(), kTfLiteOk);
+
+  EXPECT_THAT(listener.graphs, testing::ElementsAre("open", "closed"));
+  ASSERT_EQ(listener.results.size(), 2);
+  const ModelStreamsResult& open_loop = listener.results[0];
+  const ModelStreamsResult& closed_loop = listener.results[1];
+  EXPECT_EQ(open_loop.num_streams, 2);
+  EXPECT_EQ(closed_loop.num_streams, 1);
+  EXPECT_EQ(open_loop.stream_cpu_utilization.size(), 2);
+  EXPECT_EQ(open_loop.stream_init_mem_usage.size(), 2);
+  EXPECT_EQ(open_loop.num_failed_requests, 0);
+
+  // Two streams of 1ms runs easily keep up with 100 QPS, so about 50 requests
+  // arrive in 0.5s and none of them wait long.
+  EXPECT_GT(open_loop.num_requests, 20);
+  EXPECT_LT(open_loop.num_requests, 100);
+  EXPECT_LE(open_loop.p50_latency_us, open_loop.p99_latency_us);
+  EXPECT_LE(open_loop.p99_latency_us, open_loop.p999_latency_us);
+  EXPECT_GE(open_loop.p50_latency_us, 1000);
+
+  // The closed-loop stream runs back to back.
+  EXPECT_GT(closed_loop.num_requests, open_loop.num_requests);
+  EXPECT_EQ(closed_loop.num_unserved_requests, 0);
+  EXPECT_GT(closed_loop.achieved_qps, 100);
+
+  // One warmup run per stream.
+  EXPECT_EQ(g_num_runs,
+            3 + open_loop.num_requests + closed_loop.num_requests);
+}
+
+}  // namespace
+}  // namespace benchmark
+}  // namespace tflite
@@ -287,6 +287,10 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<int32_t>(1024));
   default_params.AddParam("profiling_output_csv_file",
                           BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("perf_event_counters",
+                          BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("perf_event_trace_file",
+                          BenchmarkParam::Create<std::string>(""));
 
   default_params.AddParam("print_preinvoke_state",
                           BenchmarkParam::Create<bool>(false));
@@ -353,6 +357,15 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
           "profiling_output_csv_file", &params_,
           "File path to export profile data as CSV, if not set "
           "prints to stdout."),
+      CreateFlag<std::string>(
+          "perf_event_counters", &params_,
+          "Comma-separated hardware counters to read around each op with "
+          "perf_event on Linux and Android, e.g. cycles,instructions,"
+          "cache-references,cache-misses. Requires enable_op_profiling."),
+      CreateFlag<std::string>(
+          "perf_event_trace_file", &params_,
+          "File path to export the hardware counters of each op invocation "
+          "to as a Chrome trace."),
       CreateFlag<bool>(
           "print_preinvoke_state", &params_,
           "print out the interpreter internals just before calling Invoke. The "
@@ -396,6 +409,11 @@ void BenchmarkTfLiteModel::LogParams() {
                       "Max profiling buffer entries", verbose);
   LOG_BENCHMARK_PARAM(std::string, "profiling_output_csv_file",
                       "CSV File to export profiling data to", verbose);
+  LOG_BENCHMARK_PARAM(std::string, "perf_event_counters",
+                      "Hardware counters to profile", verbose);
+  LOG_BENCHMARK_PARAM(std::string, "perf_event_trace_file",
+                      "Chrome trace file to export hardware counters to",
+                      verbose);
   LOG_BENCHMARK_PARAM(bool, "print_preinvoke_state",
                       "Print pre-invoke interpreter state", verbose);
   LOG_BENCHMARK_PARAM(bool, "print_postinvoke_state",
@@ -851,7 +869,9 @@ BenchmarkTfLiteModel::MayCreateProfilingListener() const {
       interpreter_.get(), params_.Get<int32_t>("max_profiling_buffer_entries"),
       params_.Get<std::string>("profiling_output_csv_file"),
       CreateProfileSummaryFormatter(
-          !params_.Get<std::string>("profiling_output_csv_file").empty())));
+          !params_.Get<std::string>("profiling_output_csv_file").empty()),
+      Split(params_.Get<std::string>("perf_event_counters"), ','),
+      params_.Get<std::string>("perf_event_trace_file")));
 }
 
 TfLiteStatus BenchmarkTfLiteModel::RunImpl() { return interpreter_->Invoke(); }
@@ -16,23 +16,71 @@ limitations under the License.
 #include "tensorflow/lite/tools/benchmark/profiling_listener.h"
 
 #include <fstream>
+#include <iomanip>
+#include <sstream>
 
 #include "tensorflow/lite/tools/logging.h"
 
 namespace tflite {
 namespace benchmark {
+namespace {
+
+int FindCounter(const std::vector<std::string>& counter_names,
+                const std::string& name) {
+  for (int i = 0; i < counter_names.size(); ++i) {
+    if (counter_names[i] == name) return i;
+  }
+  return -1;
+}
+
+// Returns scale * a / b of the given counter values as a string, or "-" if
+// either of them isn't profiled or b is 0.
+std::string FormatRatio(const std::vector<uint64_t>& values, int a, int b,
+                        double scale) {
+  if (a < 0 || b < 0 || values[b] == 0) return "-";
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(2)
+         << scale * values[a] / values[b];
+  return stream.str();
+}
+
+std::string EscapeJson(const std::string& str) {
+  std::string escaped;
+  for (char c : str) {
+    if (c == '"' || c == '\\') escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+}  // namespace
 
 ProfilingListener::ProfilingListener(
     Interpreter* interpreter, uint32_t max_num_entries,
     const std::string& csv_file_path,
-    std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter)
+    std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter,
+    const std::vector<std::string>& perf_event_counters,
+    const std::string& perf_event_trace_file)
     : run_summarizer_(summarizer_formatter),
       init_summarizer_(summarizer_formatter),
       csv_file_path_(csv_file_path),
       interpreter_(interpreter),
-      profiler_(max_num_entries) {
+      profiler_(max_num_entries),
+      perf_event_trace_file_(perf_event_trace_file) {
   TFLITE_TOOLS_CHECK(interpreter);
-  interpreter_->SetProfiler(&profiler_);
+  if (!perf_event_counters.empty()) {
+    perf_event_profiler_ = profiling::PerfEventProfiler::Create(
+        perf_event_counters, &profiler_, max_num_entries);
+    if (perf_event_profiler_ == nullptr) {
+      TFLITE_LOG(WARN) << "Hardware counters aren't available, so they won't "
+                          "be profiled.";
+    }
+  }
+  if (perf_event_profiler_) {
+    interpreter_->SetProfiler(perf_event_profiler_.get());
+  } else {
+    interpreter_->SetProfiler(&profiler_);
+  }
 
   // We start profiling here in order to catch events that are recorded during
   // the benchmark run preparation stage where TFLite interpreter is
@@ -55,11 +103,13 @@ void ProfilingListener::OnSingleRunStart(RunType run_type) {
   if (run_type == REGULAR) {
     profiler_.Reset();
     profiler_.StartProfiling();
+    if (perf_event_profiler_) perf_event_profiler_->StartProfiling();
   }
 }
 
 void ProfilingListener::OnSingleRunEnd() {
   profiler_.StopProfiling();
+  if (perf_event_profiler_) perf_event_profiler_->StopProfiling();
   auto profile_events = profiler_.GetProfileEvents();
   run_summarizer_.ProcessProfiles(profile_events, *interpreter_);
 }
@@ -80,6 +130,76 @@ void ProfilingListener::OnBenchmarkEnd(const BenchmarkResults& results) {
                 run_summarizer_.GetOutputString(),
                 output_stream == nullptr ? &TFLITE_LOG(INFO) : output_stream);
   }
+  if (perf_event_profiler_ && !perf_event_profiler_->events().empty()) {
+    WriteOutput("Operator-wise Hardware Counters for Regular Benchmark Runs:",
+                GetPerfEventSummary(),
+                output_stream == nullptr ? &TFLITE_LOG(INFO) : output_stream);
+    if (!perf_event_trace_file_.empty()) WritePerfEventTrace();
+  }
+}
+
+std::string ProfilingListener::GetPerfEventSummary() const {
+  const std::vector<std::string>& names = perf_event_profiler_->counter_names();
+  const int cycles = FindCounter(names, "cycles");
+  const int instructions = FindCounter(names, "instructions");
+  const int cache_references = FindCounter(names, "cache-references");
+  const int cache_misses = FindCounter(names, "cache-misses");
+  const int backend_stalls = FindCounter(names, "stalled-cycles-backend");
+
+  // Averages per invocation, followed by the ratios derived from them.
+  std::ostringstream stream;
+  stream << std::left << std::setw(8) << "subgraph" << std::setw(8) << "node"
+         << std::setw(24) << "op" << std::right;
+  for (const std::string& name : names) stream << std::setw(24) << name;
+  stream << std::setw(8) << "IPC" << std::setw(16) << "cache-miss-%"
+         << std::setw(16) << "backend-stall-%" << std::endl;
+  for (const auto& op : perf_event_profiler_->GetOpCounters()) {
+    std::vector<uint64_t> averages;
+    for (uint64_t total : op.counter_totals) {
+      averages.push_back(total / op.num_invocations);
+    }
+    stream << std::left << std::setw(8) << op.subgraph_index << std::setw(8)
+           << op.node_index << std::setw(24) << op.tag << std::right;
+    for (uint64_t average : averages) stream << std::setw(24) << average;
+    stream << std::setw(8) << FormatRatio(averages, instructions, cycles, 1)
+           << std::setw(16)
+           << FormatRatio(averages, cache_misses, cache_references, 100)
+           << std::setw(16)
+           << FormatRatio(averages, backend_stalls, cycles, 100) << std::endl;
+  }
+  return stream.str();
+}
+
+void ProfilingListener::WritePerfEventTrace() const {
+  std::ofstream trace_file(perf_event_trace_file_);
+  if (!trace_file.good()) {
+    TFLITE_LOG(ERROR) << "Failed to open " << perf_event_trace_file_;
+    return;
+  }
+  const std::vector<std::string>& names = perf_event_profiler_->counter_names();
+  const int cycles = FindCounter(names, "cycles");
+  const int instructions = FindCounter(names, "instructions");
+  // Complete events of the Trace Event Format, which chrome://tracing and
+  // Perfetto load.
+  trace_file << "{\"traceEvents\":[";
+  bool first = true;
+  for (const auto& event : perf_event_profiler_->events()) {
+    trace_file << (first ? "" : ",") << "\n{\"name\":\""
+               << EscapeJson(event.tag) << "\",\"ph\":\"X\",\"ts\":"
+               << event.begin_timestamp_us << ",\"dur\":"
+               << event.end_timestamp_us - event.begin_timestamp_us
+               << ",\"pid\":0,\"tid\":0,\"args\":{\"subgraph\":"
+               << event.subgraph_index << ",\"node\":" << event.node_index;
+    for (int i = 0; i < names.size(); ++i) {
+      trace_file << ",\"" << names[i] << "\":" << event.counter_values[i];
+    }
+    const std::string ipc =
+        FormatRatio(event.counter_values, instructions, cycles, 1);
+    if (ipc != "-") trace_file << ",\"IPC\":" << ipc;
+    trace_file << "}}";
+    first = false;
+  }
+  trace_file << "\n]}\n";
 }
 
 void ProfilingListener::WriteOutput(const std::string& header,
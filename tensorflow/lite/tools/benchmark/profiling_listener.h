@@ -17,8 +17,11 @@ limitations under the License.
 #define TENSORFLOW_LITE_TOOLS_BENCHMARK_PROFILING_LISTENER_H_
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "tensorflow/lite/profiling/buffered_profiler.h"
+#include "tensorflow/lite/profiling/perf_event_profiler.h"
 #include "tensorflow/lite/profiling/profile_summarizer.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_model.h"
@@ -27,13 +30,21 @@ namespace tflite {
 namespace benchmark {
 
 // Dumps profiling events if profiling is enabled.
+//
+// If `perf_event_counters` isn't empty, these hardware counters are also read
+// around each operator of the regular runs, and their per-operator averages are
+// dumped along with the profiling info. If `perf_event_trace_file` is set too,
+// the counters of the first `max_num_entries` operator invocations are
+// exported there as a Chrome trace.
 class ProfilingListener : public BenchmarkListener {
  public:
   ProfilingListener(
       Interpreter* interpreter, uint32_t max_num_entries,
       const std::string& csv_file_path = "",
       std::shared_ptr<profiling::ProfileSummaryFormatter> summarizer_formatter =
-          std::make_shared<profiling::ProfileSummaryDefaultFormatter>());
+          std::make_shared<profiling::ProfileSummaryDefaultFormatter>(),
+      const std::vector<std::string>& perf_event_counters = {},
+      const std::string& perf_event_trace_file = "");
 
   void OnBenchmarkStart(const BenchmarkParams& params) override;
 
@@ -51,8 +62,13 @@ class ProfilingListener : public BenchmarkListener {
  private:
   void WriteOutput(const std::string& header, const string& data,
                    std::ostream* stream);
+  std::string GetPerfEventSummary() const;
+  void WritePerfEventTrace() const;
   Interpreter* interpreter_;
   profiling::BufferedProfiler profiler_;
+  // Wraps profiler_ if hardware counters are profiled.
+  std::unique_ptr<profiling::PerfEventProfiler> perf_event_profiler_;
+  std::string perf_event_trace_file_;
 };
 
 }  // namespace benchmark
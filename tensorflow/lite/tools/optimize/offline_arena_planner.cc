@@ -0,0 +1,302 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/optimize/offline_arena_planner.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/lite/context_util.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/tools/optimize/model_utils.h"
+#include "tensorflow/lite/util.h"
+
+namespace tflite {
+namespace optimize {
+namespace {
+
+// Same as ArenaPlanner: tensors which are never deallocated have this as last
+// node.
+constexpr int32_t kNodeNotAssigned = std::numeric_limits<int32_t>::max();
+
+size_t AlignTo(size_t alignment, size_t offset) {
+  return offset % alignment == 0 ? offset
+                                 : offset + (alignment - offset % alignment);
+}
+
+bool InUseTogether(const TensorLifetime& a, const TensorLifetime& b) {
+  return a.first_node <= b.last_node && b.first_node <= a.last_node;
+}
+
+// Returns the lowest offset at which `lifetimes[index]` can be placed without
+// overlapping the buffers with `placed` set that are in use at the same time.
+size_t LowestOffset(const std::vector<TensorLifetime>& lifetimes,
+                    const std::vector<size_t>& offsets,
+                    const std::vector<bool>& placed, size_t alignment,
+                    int index) {
+  std::vector<int> conflicts;
+  for (int i = 0; i < lifetimes.size(); ++i) {
+    if (placed[i] && i != index && lifetimes[i].size > 0 &&
+        InUseTogether(lifetimes[i], lifetimes[index])) {
+      conflicts.push_back(i);
+    }
+  }
+  std::sort(conflicts.begin(), conflicts.end(),
+            [&offsets](int a, int b) { return offsets[a] < offsets[b]; });
+  size_t offset = 0;
+  for (int i : conflicts) {
+    if (offsets[i] >= offset + lifetimes[index].size) break;
+    offset = std::max(offset,
+                      AlignTo(alignment, offsets[i] + lifetimes[i].size));
+  }
+  return offset;
+}
+
+size_t ArenaSize(const std::vector<TensorLifetime>& lifetimes,
+                 const std::vector<size_t>& offsets) {
+  size_t arena_size = 0;
+  for (int i = 0; i < lifetimes.size(); ++i) {
+    if (lifetimes[i].size > 0) {
+      arena_size = std::max(arena_size, offsets[i] + lifetimes[i].size);
+    }
+  }
+  return arena_size;
+}
+
+// Places the buffers in `order` one after the other at the lowest offset,
+// then moves the buffers ending the highest to a lower offset while that
+// shrinks the arena or frees space for other buffers.
+size_t PackInOrder(const std::vector<TensorLifetime>& lifetimes,
+                   size_t alignment, const std::vector<int>& order,
+                   std::vector<size_t>* offsets) {
+  offsets->assign(lifetimes.size(), 0);
+  std::vector<bool> placed(lifetimes.size(), false);
+  for (int i : order) {
+    (*offsets)[i] = LowestOffset(lifetimes, *offsets, placed, alignment, i);
+    placed[i] = true;
+  }
+
+  std::vector<int> by_end(order);
+  for (bool moved = true; moved;) {
+    moved = false;
+    std::sort(by_end.begin(), by_end.end(), [&](int a, int b) {
+      return (*offsets)[a] + lifetimes[a].size >
+             (*offsets)[b] + lifetimes[b].size;
+    });
+    for (int i : by_end) {
+      if (lifetimes[i].size == 0) continue;
+      const size_t offset =
+          LowestOffset(lifetimes, *offsets, placed, alignment, i);
+      if (offset < (*offsets)[i]) {
+        (*offsets)[i] = offset;
+        moved = true;
+      }
+    }
+  }
+  return ArenaSize(lifetimes, *offsets);
+}
+
+}  // namespace
+
+size_t PackTensors(const std::vector<TensorLifetime>& lifetimes,
+                   size_t alignment, std::vector<size_t>* offsets) {
+  // Lifetimes of buffers that are never deallocated end after the last node
+  // using any buffer, which gives a finite length to all of them.
+  int32_t last_used_node = 0;
+  for (const TensorLifetime& lifetime : lifetimes) {
+    last_used_node = std::max(last_used_node, lifetime.first_node);
+    if (lifetime.last_node != kNodeNotAssigned) {
+      last_used_node = std::max(last_used_node, lifetime.last_node);
+    }
+  }
+  auto length = [&](int i) -> double {
+    return std::min(lifetimes[i].last_node, last_used_node + 1) -
+           lifetimes[i].first_node + 1;
+  };
+
+  std::vector<int> by_size(lifetimes.size());
+  std::iota(by_size.begin(), by_size.end(), 0);
+  std::stable_sort(by_size.begin(), by_size.end(), [&](int a, int b) {
+    if (lifetimes[a].size != lifetimes[b].size) {
+      return lifetimes[a].size > lifetimes[b].size;
+    }
+    return lifetimes[a].first_node < lifetimes[b].first_node;
+  });
+  std::vector<int> by_area(by_size);
+  std::stable_sort(by_area.begin(), by_area.end(), [&](int a, int b) {
+    return lifetimes[a].size * length(a) > lifetimes[b].size * length(b);
+  });
+  std::vector<int> by_first_node(by_size);
+  std::stable_sort(by_first_node.begin(), by_first_node.end(),
+                   [&](int a, int b) {
+                     return lifetimes[a].first_node < lifetimes[b].first_node;
+                   });
+
+  size_t best_arena_size = std::numeric_limits<size_t>::max();
+  std::vector<size_t> candidate;
+  for (const std::vector<int>* order : {&by_size, &by_area, &by_first_node}) {
+    const size_t arena_size = PackInOrder(lifetimes, alignment, *order,
+                                          &candidate);
+    if (arena_size < best_arena_size) {
+      best_arena_size = arena_size;
+      *offsets = candidate;
+    }
+  }
+  return best_arena_size;
+}
+
+OfflineArenaPlan ComputeOfflineArenaPlan(const Subgraph& subgraph) {
+  const int num_tensors = subgraph.tensors_size();
+  const std::vector<int>& execution_plan = subgraph.execution_plan();
+  std::vector<int32_t> alloc_node(num_tensors, kNodeNotAssigned);
+  std::vector<int32_t> dealloc_node(num_tensors, kNodeNotAssigned);
+  std::vector<int> refcounts(num_tensors, 0);
+
+  // Mirrors ArenaPlanner::PlanAllocations().
+  auto allocate = [&](int node, int tensor) {
+    if (alloc_node[tensor] == kNodeNotAssigned) alloc_node[tensor] = node;
+  };
+  for (int tensor_index : subgraph.outputs()) {
+    if (tensor_index != kTfLiteOptionalTensor) refcounts[tensor_index]++;
+  }
+  for (int tensor_index : subgraph.variables()) {
+    refcounts[tensor_index]++;
+    allocate(0, tensor_index);
+  }
+  for (int tensor_index : subgraph.inputs()) {
+    if (tensor_index != kTfLiteOptionalTensor) {
+      refcounts[tensor_index]++;
+      allocate(0, tensor_index);
+    }
+  }
+  for (int node_index : execution_plan) {
+    const TfLiteNode& node = subgraph.node_and_registration(node_index)->first;
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index != kTfLiteOptionalTensor) refcounts[tensor_index]++;
+    }
+  }
+  for (int i = 0; i < execution_plan.size(); ++i) {
+    const TfLiteNode& node =
+        subgraph.node_and_registration(execution_plan[i])->first;
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      allocate(i, tensor_index);
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index != kTfLiteOptionalTensor &&
+          --refcounts[tensor_index] == 0 &&
+          alloc_node[tensor_index] != kNodeNotAssigned) {
+        dealloc_node[tensor_index] = i;
+      }
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.temporaries)) {
+      alloc_node[tensor_index] = i;
+      dealloc_node[tensor_index] = i;
+    }
+  }
+
+  std::vector<int> planned_tensors;
+  std::vector<TensorLifetime> lifetimes;
+  for (int i = 0; i < num_tensors; ++i) {
+    const TfLiteTensor* tensor = subgraph.tensor(i);
+    if (tensor->allocation_type == kTfLiteArenaRw &&
+        alloc_node[i] != kNodeNotAssigned) {
+      planned_tensors.push_back(i);
+      lifetimes.push_back({tensor->bytes, alloc_node[i], dealloc_node[i]});
+    }
+  }
+  std::vector<size_t> offsets;
+  const size_t arena_size =
+      PackTensors(lifetimes, kDefaultTensorAlignment, &offsets);
+  OfflineArenaPlan plan;
+  // Offsets are stored as int32, larger arenas are left to ArenaPlanner.
+  if (arena_size > std::numeric_limits<int32_t>::max()) return plan;
+  plan.arena_size = arena_size;
+  plan.offsets.assign(num_tensors, -1);
+  plan.sizes.assign(num_tensors, 0);
+  for (int i = 0; i < planned_tensors.size(); ++i) {
+    plan.offsets[planned_tensors[i]] = offsets[i];
+    plan.sizes[planned_tensors[i]] = lifetimes[i].size;
+  }
+  return plan;
+}
+
+TfLiteStatus AddOfflineArenaPlans(const FlatBufferModel& model,
+                                  const OpResolver& op_resolver,
+                                  std::string* output_model) {
+  ErrorReporter* error_reporter = model.error_reporter();
+  std::unique_ptr<Interpreter> interpreter;
+  if (InterpreterBuilder(model, op_resolver)(&interpreter) != kTfLiteOk ||
+      interpreter->AllocateTensors() != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Failed to allocate the tensors of the model.");
+    return kTfLiteError;
+  }
+  std::vector<OfflineArenaPlan> plans;
+  for (int i = 0; i < interpreter->subgraphs_size(); ++i) {
+    plans.push_back(ComputeOfflineArenaPlan(*interpreter->subgraph(i)));
+  }
+  const std::string metadata = SerializeOfflineArenaPlans(plans);
+
+  auto mutable_model = absl::make_unique<ModelT>();
+  model.GetModel()->UnPackTo(mutable_model.get(), nullptr);
+  int buffer_id = -1;
+  for (const auto& entry : mutable_model->metadata) {
+    if (entry->name == kOfflineArenaPlanMetadataName) {
+      buffer_id = entry->buffer;
+      break;
+    }
+  }
+  if (buffer_id < 0) {
+    buffer_id = mutable_model->buffers.size();
+    mutable_model->buffers.emplace_back(absl::make_unique<BufferT>());
+    auto plan_metadata = absl::make_unique<MetadataT>();
+    plan_metadata->name = kOfflineArenaPlanMetadataName;
+    plan_metadata->buffer = buffer_id;
+    mutable_model->metadata.emplace_back(std::move(plan_metadata));
+  }
+  mutable_model->buffers[buffer_id]->data.assign(metadata.begin(),
+                                                 metadata.end());
+
+  std::unique_ptr<flatbuffers::FlatBufferBuilder> builder =
+      utils::FinishModel(mutable_model.get());
+  *output_model =
+      std::string(reinterpret_cast<const char*>(builder->GetBufferPointer()),
+                  builder->GetSize());
+  return kTfLiteOk;
+}
+
+TfLiteStatus AddOfflineArenaPlans(const std::string& input_file,
+                                  const std::string& output_file) {
+  std::unique_ptr<FlatBufferModel> model =
+      FlatBufferModel::BuildFromFile(input_file.c_str());
+  if (!model) return kTfLiteError;
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates op_resolver;
+  std::string output_model;
+  TF_LITE_ENSURE_STATUS(
+      AddOfflineArenaPlans(*model, op_resolver, &output_model));
+  utils::WriteFile(output_file,
+                   reinterpret_cast<const uint8_t*>(output_model.data()),
+                   output_model.size());
+  return kTfLiteOk;
+}
+
+}  // namespace optimize
+}  // namespace tflite
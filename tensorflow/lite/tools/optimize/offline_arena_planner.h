@@ -0,0 +1,82 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_TOOLS_OPTIMIZE_OFFLINE_ARENA_PLANNER_H_
+#define TENSORFLOW_LITE_TOOLS_OPTIMIZE_OFFLINE_ARENA_PLANNER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/offline_arena_plan.h"
+
+namespace tflite {
+namespace optimize {
+
+// A buffer that must not share memory with another buffer in use during the
+// same nodes, i.e. whose [first_node, last_node] interval intersects.
+struct TensorLifetime {
+  size_t size;
+  int32_t first_node;
+  int32_t last_node;
+};
+
+// Places the buffers of `lifetimes` in an arena so that buffers in use at the
+// same time don't overlap, trying to minimize the size of the arena. Offsets
+// are multiples of `alignment`. Returns the size of the arena.
+//
+// The buffers are first placed at the lowest possible offset in a few greedy
+// orders, then repeatedly moved down to a lower offset while one is free.
+//
+// Note: This is a private API, subject to change.
+size_t PackTensors(const std::vector<TensorLifetime>& lifetimes,
+                   size_t alignment, std::vector<size_t>* offsets);
+
+// Computes the offline plan of the kTfLiteArenaRw tensors of a subgraph whose
+// tensors have been allocated, with the tensor lifetimes ArenaPlanner uses.
+// The plan is empty if the arena doesn't fit the plan format.
+//
+// Note: This is a private API, subject to change.
+OfflineArenaPlan ComputeOfflineArenaPlan(const Subgraph& subgraph);
+
+// Allocates the tensors of `model` with the kernels of `op_resolver`, computes
+// the offline plan of each subgraph and writes the model with the plans stored
+// in its kOfflineArenaPlanMetadataName metadata to `output_model`. Existing
+// plans are replaced.
+//
+// The plans only apply when the tensors have the sizes they had when the
+// plans were computed, so `op_resolver` should provide the kernels used at
+// runtime, and no delegate should be applied when computing them.
+//
+// Note: This is a private API, subject to change.
+TfLiteStatus AddOfflineArenaPlans(const FlatBufferModel& model,
+                                  const OpResolver& op_resolver,
+                                  std::string* output_model);
+
+// Same as above but reads the model from `input_file` and writes it to
+// `output_file`, using the builtin kernels.
+//
+// Note: This is a private API, subject to change.
+TfLiteStatus AddOfflineArenaPlans(const std::string& input_file,
+                                  const std::string& output_file);
+
+}  // namespace optimize
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_OPTIMIZE_OFFLINE_ARENA_PLANNER_H_
@@ -0,0 +1,163 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/optimize/offline_arena_planner.h"
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/offline_arena_plan.h"
+
+namespace tflite {
+namespace optimize {
+namespace {
+
+constexpr int32_t kForever = std::numeric_limits<int32_t>::max();
+
+void ExpectValidPacking(const std::vector<TensorLifetime>& lifetimes,
+                        size_t alignment, const std::vector<size_t>& offsets,
+                        size_t arena_size) {
+  ASSERT_EQ(offsets.size(), lifetimes.size());
+  for (int i = 0; i < lifetimes.size(); ++i) {
+    EXPECT_EQ(offsets[i] % alignment, 0);
+    EXPECT_LE(offsets[i] + lifetimes[i].size, arena_size);
+    for (int j = i + 1; j < lifetimes.size(); ++j) {
+      const bool in_use_together =
+          lifetimes[i].first_node <= lifetimes[j].last_node &&
+          lifetimes[j].first_node <= lifetimes[i].last_node;
+      const bool overlap = offsets[i] < offsets[j] + lifetimes[j].size &&
+                           offsets[j] < offsets[i] + lifetimes[i].size;
+      EXPECT_FALSE(in_use_together && overlap)
+          << "buffers " << i << " and " << j << " overlap";
+    }
+  }
+}
+
+TEST(OfflineArenaPlannerTest, PackEmpty) {
+  std::vector<size_t> offsets;
+  EXPECT_EQ(PackTensors({}, 64, &offsets), 0);
+  EXPECT_TRUE(offsets.empty());
+}
+
+TEST(OfflineArenaPlannerTest, PackReusesMemoryOfDeadBuffers) {
+  // A chain of nodes, each reading the output of the previous one.
+  const std::vector<TensorLifetime> lifetimes = {
+      {128, 0, 1}, {256, 1, 2}, {128, 2, 3}, {256, 3, 4}, {64, 4, kForever}};
+  std::vector<size_t> offsets;
+  const size_t arena_size = PackTensors(lifetimes, 64, &offsets);
+  ExpectValidPacking(lifetimes, 64, offsets, arena_size);
+  EXPECT_EQ(arena_size, 384);
+}
+
+TEST(OfflineArenaPlannerTest, PackAlignsOffsets) {
+  const std::vector<TensorLifetime> lifetimes = {
+      {10, 0, 2}, {10, 1, 2}, {10, 2, 3}};
+  std::vector<size_t> offsets;
+  const size_t arena_size = PackTensors(lifetimes, 64, &offsets);
+  ExpectValidPacking(lifetimes, 64, offsets, arena_size);
+  EXPECT_EQ(arena_size, 2 * 64 + 10);
+}
+
+TEST(OfflineArenaPlannerTest, PackBeatsGreedyBySize) {
+  // Placing the largest buffers first, as ArenaPlanner does, puts the third
+  // buffer above the first two and the last one above it, needing 512 bytes.
+  const std::vector<TensorLifetime> lifetimes = {
+      {256, 4, 5}, {256, 2, 2}, {192, 2, 3}, {64, 3, 4}};
+  std::vector<size_t> offsets;
+  const size_t arena_size = PackTensors(lifetimes, 64, &offsets);
+  ExpectValidPacking(lifetimes, 64, offsets, arena_size);
+  // The bytes in use during node 2.
+  EXPECT_EQ(arena_size, 448);
+}
+
+TEST(OfflineArenaPlannerTest, PlanIsUsedByTheInterpreter) {
+  std::unique_ptr<FlatBufferModel> model = FlatBufferModel::BuildFromFile(
+      "tensorflow/lite/testdata/multi_add.bin");
+  ASSERT_TRUE(model);
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates op_resolver;
+  std::string planned_model_data;
+  ASSERT_EQ(AddOfflineArenaPlans(*model, op_resolver, &planned_model_data),
+            kTfLiteOk);
+
+  std::unique_ptr<FlatBufferModel> planned_model =
+      FlatBufferModel::BuildFromBuffer(planned_model_data.data(),
+                                       planned_model_data.size());
+  ASSERT_TRUE(planned_model);
+  std::map<std::string, std::string> metadata =
+      planned_model->ReadAllMetadata();
+  ASSERT_EQ(metadata.count(kOfflineArenaPlanMetadataName), 1);
+  OfflineArenaPlan plan;
+  ASSERT_TRUE(ParseOfflineArenaPlan(metadata[kOfflineArenaPlanMetadataName],
+                                    /*subgraph_index=*/0, &plan));
+
+  std::unique_ptr<Interpreter> interpreter;
+  ASSERT_EQ(InterpreterBuilder(*planned_model, op_resolver)(&interpreter),
+            kTfLiteOk);
+  ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  ASSERT_EQ(plan.offsets.size(), interpreter->tensors_size());
+
+  // The tensors are where the plan placed them relative to each other.
+  const int first_input = interpreter->inputs()[0];
+  ASSERT_GE(plan.offsets[first_input], 0);
+  for (int i = 0; i < interpreter->tensors_size(); ++i) {
+    if (plan.offsets[i] < 0) continue;
+    EXPECT_EQ(interpreter->tensor(i)->data.raw -
+                  interpreter->tensor(first_input)->data.raw,
+              plan.offsets[i] - plan.offsets[first_input])
+        << "tensor " << i;
+  }
+
+  // Running the model with the plan gives the usual results.
+  for (int i = 0; i < interpreter->inputs().size(); ++i) {
+    TfLiteTensor* input = interpreter->tensor(interpreter->inputs()[i]);
+    for (int j = 0; j < input->bytes / sizeof(float); ++j) {
+      input->data.f[j] = i + 1;
+    }
+  }
+  ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+  // x = a + (b + c) and y = d + (b + c).
+  const TfLiteTensor* x = interpreter->tensor(interpreter->outputs()[0]);
+  const TfLiteTensor* y = interpreter->tensor(interpreter->outputs()[1]);
+  for (int j = 0; j < x->bytes / sizeof(float); ++j) {
+    EXPECT_EQ(x->data.f[j], 6.f);
+    EXPECT_EQ(y->data.f[j], 9.f);
+  }
+
+  // Planning again replaces the plan.
+  std::string replanned_model_data;
+  ASSERT_EQ(AddOfflineArenaPlans(*planned_model, op_resolver,
+                                 &replanned_model_data),
+            kTfLiteOk);
+  std::unique_ptr<FlatBufferModel> replanned_model =
+      FlatBufferModel::BuildFromBuffer(replanned_model_data.data(),
+                                       replanned_model_data.size());
+  ASSERT_TRUE(replanned_model);
+  EXPECT_EQ(replanned_model->GetModel()->metadata()->size(),
+            planned_model->GetModel()->metadata()->size());
+  EXPECT_EQ(replanned_model->ReadAllMetadata(), metadata);
+}
+
+}  // namespace
+}  // namespace optimize
+}  // namespace tflite
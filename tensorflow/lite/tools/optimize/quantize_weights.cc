@@ -162,7 +162,10 @@ bool IsHybridEvaluationOp(const OperatorT* op, const OperatorCodeT* op_code,
     if (options->kernel_type == LSTMKernelType_FULL) {
       eval_hybrid = true;
     }
-  } else if (builtin_op_code == BuiltinOperator_DEPTHWISE_CONV_2D) {
+  } else if (builtin_op_code == BuiltinOperator_DEPTHWISE_CONV_2D ||
+             builtin_op_code == BuiltinOperator_EMBEDDING_LOOKUP) {
+    // With the updated scheme, the tables of EMBEDDING_LOOKUP are quantized
+    // per row, and the looked up rows dequantized by the op.
     eval_hybrid = use_updated_hybrid_scheme;
   }
   return eval_hybrid;
@@ -240,7 +243,8 @@ TfLiteStatus InsertQuantizableInputTensorsFromOperator(
       tensor_map->insert({tensor_idx,
                           {tensor, /*is_per_channel=*/use_updated_hybrid_scheme,
                            /*dim=*/3}});
-    } else if (builtin_code == BuiltinOperator_CONV_2D) {
+    } else if (builtin_code == BuiltinOperator_CONV_2D ||
+               builtin_code == BuiltinOperator_EMBEDDING_LOOKUP) {
       tensor_map->insert({tensor_idx,
                           {tensor, /*is_per_channel=*/use_updated_hybrid_scheme,
                            /*dim=*/0}});
@@ -302,9 +306,10 @@ void UpdateInt8OperatorVersions(ModelT* model, bool use_updated_hybrid_scheme) {
         op_code == BuiltinOperator_UNIDIRECTIONAL_SEQUENCE_LSTM ||
         op_code == BuiltinOperator_UNIDIRECTIONAL_SEQUENCE_RNN) {
       model->operator_codes[i]->version = use_updated_hybrid_scheme ? 3 : 2;
-    } else if (op_code == BuiltinOperator_BIDIRECTIONAL_SEQUENCE_LSTM ||
-               op_code == BuiltinOperator_EMBEDDING_LOOKUP) {
+    } else if (op_code == BuiltinOperator_BIDIRECTIONAL_SEQUENCE_LSTM) {
       model->operator_codes[i]->version = 3;
+    } else if (op_code == BuiltinOperator_EMBEDDING_LOOKUP) {
+      model->operator_codes[i]->version = use_updated_hybrid_scheme ? 4 : 3;
     } else if (op_code == BuiltinOperator_LSTM) {
       model->operator_codes[i]->version = use_updated_hybrid_scheme ? 4 : 3;
     } else if (op_code == BuiltinOperator_CONV_2D) {
@@ -323,15 +328,19 @@ void UpdateInt8OperatorVersions(ModelT* model, bool use_updated_hybrid_scheme) {
 
 // Returns true if the op in consumer_op_infos can pass through quantization.
 bool IsQuantizationPassThroughOps(
-    const ModelT* model, const std::vector<ConsumerOpInfo>& consumer_op_infos) {
+    const ModelT* model, const std::vector<ConsumerOpInfo>& consumer_op_infos,
+    bool use_updated_hybrid_scheme) {
   if (consumer_op_infos.size() != 1) {
     return false;
   }
   const OperatorT* consumer_op = consumer_op_infos.front().op;
   const BuiltinOperator op_code =
       GetBuiltinCode(model->operator_codes[consumer_op->opcode_index].get());
+  // The rows looked up in a table quantized per row don't share its
+  // quantization parameters.
   return op_code == BuiltinOperator_GATHER ||
-         op_code == BuiltinOperator_EMBEDDING_LOOKUP;
+         (op_code == BuiltinOperator_EMBEDDING_LOOKUP &&
+          !use_updated_hybrid_scheme);
 }
 
 // Copies quantization parameters from input to output and returns consumers of
@@ -416,7 +425,8 @@ TfLiteStatus QuantizeWeightsInt8(
       TensorT* tensor = tensor_pair.second.t;
       std::vector<ConsumerOpInfo> consumer_op_infos =
           GetTensorConsumers(model.get(), subgraph, tensor_idx);
-      if (IsQuantizationPassThroughOps(model.get(), consumer_op_infos)) {
+      if (IsQuantizationPassThroughOps(model.get(), consumer_op_infos,
+                                       use_updated_hybrid_scheme)) {
         std::tie(tensor_idx, tensor, consumer_op_infos) =
             PassQuantizationAndGetConsumers(model.get(), subgraph,
                                             consumer_op_infos, custom_op_map);
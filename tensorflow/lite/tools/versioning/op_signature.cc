@@ -182,6 +182,8 @@ OpSignature GetOpSignature(const OperatorCode* op_code, const Operator* op,
           filter_quant->scale()->Length() == num_channels) {
         op_sig.ext_options.conv_2d.is_per_channel_quantized = true;
       }
+      op_sig.ext_options.conv_2d.sparse_weight =
+          (filter_tensor->sparsity() != nullptr);
     } break;
 
     case BuiltinOperator_STRIDED_SLICE: {
@@ -220,6 +222,16 @@ OpSignature GetOpSignature(const OperatorCode* op_code, const Operator* op,
       }
     } break;
 
+    case BuiltinOperator_EMBEDDING_LOOKUP: {
+      const Tensor* value_tensor =
+          subgraph->tensors()->Get(op->inputs()->Get(1));
+      const QuantizationParameters* value_quant = value_tensor->quantization();
+      if (value_quant && value_quant->scale() &&
+          value_quant->scale()->Length() > 1) {
+        op_sig.ext_options.embedding_lookup.is_per_channel_quantized = true;
+      }
+    } break;
+
     default:
       break;
   }
@@ -40,6 +40,7 @@ typedef struct {
   union {
     struct {
       bool is_per_channel_quantized;
+      bool sparse_weight;
     } conv_2d;
     struct {
       bool is_per_channel_quantized;
@@ -66,6 +67,9 @@ typedef struct {
     struct {
       bool is_per_channel_quantized;
     } quantize;
+    struct {
+      bool is_per_channel_quantized;
+    } embedding_lookup;
   } ext_options;
 } OpSignature;
 
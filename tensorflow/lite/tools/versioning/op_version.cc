@@ -54,6 +54,11 @@ int GetInputMaxDims(const OpSignature& op_sig) {
 int GetBuiltinOperatorVersion(const OpSignature& op_sig) {
   switch (op_sig.op) {
     case BuiltinOperator_CONV_2D:
+      // Conv2D with sparse filter is supported at version 6.
+      if (op_sig.ext_options.conv_2d.sparse_weight) {
+        return 6;
+      }
+
       // If the op has signed int16 op_sig.inputs and op_sig.outputs, its
       // version 4.
       if (op_sig.inputs.at(0).type == kTfLiteInt16 &&
@@ -810,6 +815,12 @@ int GetBuiltinOperatorVersion(const OpSignature& op_sig) {
     case BuiltinOperator_WHERE:
       if (op_sig.inputs.at(0).type == kTfLiteBool) return 1;
       return 2;
+    case BuiltinOperator_EMBEDDING_LOOKUP:
+      // Version 4 supports tables quantized per row.
+      if (op_sig.ext_options.embedding_lookup.is_per_channel_quantized) {
+        return 4;
+      }
+      return 1;
     default:
       return 1;
   }
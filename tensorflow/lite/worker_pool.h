@@ -0,0 +1,69 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_WORKER_POOL_H_
+#define TENSORFLOW_LITE_WORKER_POOL_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <functional>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+namespace tflite {
+
+// A fixed-size pool of threads that runs batches of tasks and waits for each
+// batch to complete. The calling thread takes part in running the tasks, so a
+// pool of `num_threads` threads only spawns `num_threads - 1` workers.
+class WorkerPool {
+ public:
+  explicit WorkerPool(int num_threads);
+  ~WorkerPool();
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  int num_threads() const { return num_threads_; }
+
+  // Calls `task(task_index, thread_index)` for every `task_index` in
+  // [0, num_tasks) and blocks until all the calls returned. `thread_index` is
+  // in [0, num_threads()) and identifies the thread running the task, 0 being
+  // the calling thread. Must not be called concurrently or from a task.
+  void Run(int num_tasks, const std::function<void(int, int)>& task);
+
+ private:
+  void WorkerLoop(int thread_index);
+  void RunTasks(int thread_index);
+
+  const int num_threads_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_done_;
+  // Incremented for every batch, so that workers notice new work.
+  uint64_t generation_ = 0;
+  // Number of workers that did not finish the current batch yet.
+  int pending_workers_ = 0;
+  bool stopping_ = false;
+
+  const std::function<void(int, int)>* task_ = nullptr;
+  int num_tasks_ = 0;
+  std::atomic<int> next_task_{0};
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_WORKER_POOL_H_
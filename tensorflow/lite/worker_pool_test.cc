@@ -0,0 +1,55 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/worker_pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace {
+
+TEST(WorkerPoolTest, RunsEveryTaskOnce) {
+  WorkerPool pool(4);
+  EXPECT_EQ(pool.num_threads(), 4);
+  for (int num_tasks : {0, 1, 3, 100}) {
+    std::vector<std::atomic<int>> runs(num_tasks);
+    for (auto& run : runs) run = 0;
+    pool.Run(num_tasks, [&](int task, int thread) {
+      EXPECT_GE(thread, 0);
+      EXPECT_LT(thread, pool.num_threads());
+      ++runs[task];
+    });
+    for (int i = 0; i < num_tasks; ++i) {
+      EXPECT_EQ(runs[i], 1) << "task " << i;
+    }
+  }
+}
+
+TEST(WorkerPoolTest, SingleThreadRunsOnCaller) {
+  WorkerPool pool(0);
+  EXPECT_EQ(pool.num_threads(), 1);
+  int sum = 0;
+  pool.Run(5, [&](int task, int thread) {
+    EXPECT_EQ(thread, 0);
+    sum += task;
+  });
+  EXPECT_EQ(sum, 10);
+}
+
+}  // namespace
+}  // namespace tflite
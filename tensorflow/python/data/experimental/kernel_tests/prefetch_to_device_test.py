@@ -14,6 +14,7 @@
 # ==============================================================================
 """Tests for `tf.data.experimental.prefetch_to_device()`."""
 from absl.testing import parameterized
+import numpy as np
 
 from tensorflow.core.protobuf import config_pb2
 from tensorflow.python.data.experimental.ops import prefetching_ops
@@ -26,6 +27,8 @@ from tensorflow.python.framework import errors
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
 from tensorflow.python.platform import test
 
 
@@ -146,6 +149,35 @@ class PrefetchToDeviceTest(test_base.DatasetTestBase, parameterized.TestCase):
 
     self.assertDatasetProduces(device_dataset, list(range(10)))
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testPrefetchToDeviceGpuPinHostMemory(self):
+    if not test_util.is_gpu_available():
+      self.skipTest("No GPU available")
+
+    host_dataset = dataset_ops.Dataset.range(10).map(
+        lambda x: (x, array_ops.fill([3, 4], math_ops.cast(x, dtypes.float32))))
+    device_dataset = host_dataset.apply(
+        prefetching_ops.prefetch_to_device("/gpu:0", pin_host_memory=True))
+
+    self.assertDatasetProduces(
+        device_dataset, [(i, np.full([3, 4], i, np.float32)) for i in range(10)])
+
+  @combinations.generate(test_base.graph_only_combinations())
+  def testPrefetchToDevicePinHostMemoryIsOptIn(self):
+
+    def num_pinned_prefetches(device, **kwargs):
+      with ops.Graph().as_default() as g:
+        dataset_ops.Dataset.range(10).apply(
+            prefetching_ops.prefetch_to_device(device, **kwargs))
+      return sum(1 for op in g.get_operations()
+                 if op.type == "PrefetchDataset" and
+                 op.get_attr("pin_host_memory"))
+
+    self.assertEqual(0, num_pinned_prefetches("/gpu:0"))
+    self.assertEqual(1, num_pinned_prefetches("/gpu:0", pin_host_memory=True))
+    # Pinning host memory only applies to GPUs.
+    self.assertEqual(0, num_pinned_prefetches("/cpu:1", pin_host_memory=True))
+
   @combinations.generate(test_base.default_test_combinations())
   def testPrefetchToDeviceCorrectPlacement(self):
 
@@ -37,9 +37,10 @@ class SqlDatasetTestBase(test_base.DatasetTestBase):
                         query,
                         output_types,
                         driver_name="sqlite",
-                        num_repeats=1):
+                        num_repeats=1,
+                        **kwargs):
     dataset = readers.SqlDataset(driver_name, self.data_source_name, query,
-                                 output_types).repeat(num_repeats)
+                                 output_types, **kwargs).repeat(num_repeats)
     return dataset
 
   def setUp(self):
@@ -585,6 +586,58 @@ class SqlDatasetTest(SqlDatasetTestBase, parameterized.TestCase):
     with self.assertRaises(errors.OutOfRangeError):
       self.evaluate(get_next())
 
+  # Test that SqlDataset can read the result set in batches of rows.
+  @combinations.generate(test_base.default_test_combinations())
+  def testReadResultSetInBatches(self):
+    dataset = self._createSqlDataset(
+        query="SELECT first_name, col1 FROM people, data "
+        "ORDER BY first_name, col1",
+        output_types=(dtypes.string, dtypes.int32),
+        batch_size=4)
+    self.assertEqual(dataset.element_spec[0].shape.as_list(), [None])
+    self.assertDatasetProduces(
+        dataset,
+        expected_output=[([b"Benjamin"] * 3 + [b"John"], [0, 1, 2, 0]),
+                         ([b"John"] * 2, [1, 2])])
+
+  # Test that SqlDataset can read ranges of rowids in parallel, in a
+  # deterministic order.
+  @combinations.generate(test_base.default_test_combinations())
+  def testReadResultSetInParallelBatches(self):
+    dataset = self._createSqlDataset(
+        query="SELECT col1 FROM data WHERE rowid >= :rowid_begin AND "
+        "rowid < :rowid_end ORDER BY rowid",
+        output_types=(dtypes.int32),
+        batch_size=1,
+        num_parallel_reads=2,
+        rowid_table="data")
+    # The rowids 1 to 3 are split into [1, 3) and [3, 5).
+    self.assertDatasetProduces(dataset, expected_output=[[0], [2], [1]])
+
+  # Test that SqlDataset fails for parallel reads without a rowid table.
+  @combinations.generate(test_base.default_test_combinations())
+  def testReadResultSetInParallelWithoutRowidTable(self):
+    with self.assertRaises(errors.InvalidArgumentError):
+      dataset = self._createSqlDataset(
+          query="SELECT col1 FROM data",
+          output_types=(dtypes.int32),
+          batch_size=1,
+          num_parallel_reads=2)
+      self.evaluate(self.getNext(dataset)())
+
+  # Test that SqlDataset fails for a rowid table if the query doesn't bind
+  # the rowid range.
+  @combinations.generate(test_base.default_test_combinations())
+  def testReadResultSetWithRowidTableWithoutRowidParameters(self):
+    dataset = self._createSqlDataset(
+        query="SELECT col1 FROM data",
+        output_types=(dtypes.int32),
+        batch_size=1,
+        rowid_table="data")
+    get_next = self.getNext(dataset)
+    with self.assertRaises(errors.InvalidArgumentError):
+      self.evaluate(get_next())
+
 
 class SqlDatasetCheckpointTest(SqlDatasetTestBase,
                                checkpoint_test_base.CheckpointTestBase,
@@ -608,6 +661,29 @@ class SqlDatasetCheckpointTest(SqlDatasetTestBase,
     num_outputs = num_repeats * 2
     verify_fn(self, lambda: self._build_dataset(num_repeats), num_outputs)
 
+  def _build_batched_dataset(self, num_repeats):
+    data_source_name = os.path.join(test.get_temp_dir(), "tftest.sqlite")
+    query = ("SELECT first_name, last_name FROM students WHERE rowid >= "
+             ":rowid_begin AND rowid < :rowid_end")
+    output_types = (dtypes.string, dtypes.string)
+    return readers.SqlDataset(
+        "sqlite",
+        data_source_name,
+        query,
+        output_types,
+        batch_size=1,
+        num_parallel_reads=2,
+        rowid_table="students").repeat(num_repeats)
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         checkpoint_test_base.default_test_combinations()))
+  def testBatched(self, verify_fn):
+    num_repeats = 4
+    num_outputs = num_repeats * 2
+    verify_fn(self, lambda: self._build_batched_dataset(num_repeats),
+              num_outputs)
+
 
 if __name__ == "__main__":
   test.main()
@@ -31,7 +31,7 @@ from tensorflow.python.util.tf_export import tf_export
 
 
 @tf_export("data.experimental.prefetch_to_device")
-def prefetch_to_device(device, buffer_size=None):
+def prefetch_to_device(device, buffer_size=None, pin_host_memory=False):
   """A transformation that prefetches dataset values to the given `device`.
 
   NOTE: Although the transformation creates a `tf.data.Dataset`, the
@@ -50,12 +50,23 @@ def prefetch_to_device(device, buffer_size=None):
     device: A string. The name of a device to which elements will be prefetched.
     buffer_size: (Optional.) The number of elements to buffer on `device`.
       Defaults to an automatically chosen value.
+    pin_host_memory: (Optional.) A boolean. If `device` is a GPU and this is
+      `True`, the elements are first copied into pinned host memory, with an
+      automatically tuned buffer, so that their copies to the GPU are direct
+      transfers. This costs an extra host copy of every element. Defaults to
+      `False`.
 
   Returns:
     A `Dataset` transformation function, which can be passed to
     `tf.data.Dataset.apply`.
   """
   def _apply_fn(dataset):
+    spec = framework_device.DeviceSpec().from_string(device)
+    if pin_host_memory and spec.device_type == "GPU":
+      # Stage the elements in pinned host memory ahead of their copy, so that
+      # the copy to the GPU is a direct transfer.
+      dataset = dataset_ops.PrefetchDataset(
+          dataset, buffer_size=dataset_ops.AUTOTUNE, pin_host_memory=True)
     return dataset.apply(
         copy_to_device(target_device=device)).prefetch(buffer_size)
 
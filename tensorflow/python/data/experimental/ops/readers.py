@@ -1159,9 +1159,29 @@ class SqlDatasetV2(dataset_ops.DatasetSource):
   for element in dataset:
     print(element)
   ```
+
+  Large tables are read faster in batches of rows, which are fetched ahead by
+  background threads, here on 4 read-only connections that each read a range
+  of the rowids of the `people` table:
+
+  ```python
+  dataset = tf.data.experimental.SqlDataset(
+      "sqlite", "/foo/bar.sqlite3",
+      "SELECT name, age FROM people "
+      "WHERE rowid >= :rowid_begin AND rowid < :rowid_end",
+      (tf.string, tf.int32), batch_size=1024, num_parallel_reads=4,
+      rowid_table="people")
+  ```
   """
 
-  def __init__(self, driver_name, data_source_name, query, output_types):
+  def __init__(self,
+               driver_name,
+               data_source_name,
+               query,
+               output_types,
+               batch_size=None,
+               num_parallel_reads=None,
+               rowid_table=None):
     """Creates a `SqlDataset`.
 
     Args:
@@ -1172,6 +1192,18 @@ class SqlDatasetV2(dataset_ops.DatasetSource):
       query: A 0-D `tf.string` tensor containing the SQL query to execute.
       output_types: A tuple of `tf.DType` objects representing the types of the
         columns returned by `query`.
+      batch_size: (Optional.) A Python integer. If set, each element is a batch
+        of up to `batch_size` rows, as one vector per column, and the rows are
+        fetched ahead by background threads on read-only connections. Defaults
+        to one row per element, as scalars.
+      num_parallel_reads: (Optional.) A Python integer, the number of
+        connections reading batches in parallel. Requires `batch_size` and
+        `rowid_table`. Their batches are interleaved in a deterministic order.
+        Defaults to 1.
+      rowid_table: (Optional.) A Python string, the name of a table whose
+        rowids are split into one range per connection. Each connection binds
+        its range to the `:rowid_begin` (inclusive) and `:rowid_end`
+        (exclusive) parameters of `query`.
     """
     self._driver_name = ops.convert_to_tensor(
         driver_name, dtype=dtypes.string, name="driver_name")
@@ -1179,11 +1211,21 @@ class SqlDatasetV2(dataset_ops.DatasetSource):
         data_source_name, dtype=dtypes.string, name="data_source_name")
     self._query = ops.convert_to_tensor(
         query, dtype=dtypes.string, name="query")
+    shape = [] if batch_size is None else [None]
     self._element_spec = nest.map_structure(
-        lambda dtype: tensor_spec.TensorSpec([], dtype), output_types)
+        lambda dtype: tensor_spec.TensorSpec(shape, dtype), output_types)
+    # The attrs are only set when used, so that graphs without them still run
+    # on older binaries.
+    kwargs = {}
+    if batch_size is not None:
+      kwargs["batch_size"] = batch_size
+    if num_parallel_reads is not None:
+      kwargs["num_parallel_reads"] = num_parallel_reads
+    if rowid_table is not None:
+      kwargs["rowid_table"] = rowid_table
     variant_tensor = gen_experimental_dataset_ops.sql_dataset(
         self._driver_name, self._data_source_name, self._query,
-        **self._flat_structure)
+        **kwargs, **self._flat_structure)
     super(SqlDatasetV2, self).__init__(variant_tensor)
 
   @property
@@ -1196,8 +1238,16 @@ class SqlDatasetV1(dataset_ops.DatasetV1Adapter):
   """A `Dataset` consisting of the results from a SQL query."""
 
   @functools.wraps(SqlDatasetV2.__init__)
-  def __init__(self, driver_name, data_source_name, query, output_types):
-    wrapped = SqlDatasetV2(driver_name, data_source_name, query, output_types)
+  def __init__(self,
+               driver_name,
+               data_source_name,
+               query,
+               output_types,
+               batch_size=None,
+               num_parallel_reads=None,
+               rowid_table=None):
+    wrapped = SqlDatasetV2(driver_name, data_source_name, query, output_types,
+                           batch_size, num_parallel_reads, rowid_table)
     super(SqlDatasetV1, self).__init__(wrapped)
 
 
@@ -24,6 +24,8 @@ from tensorflow.python.data.kernel_tests import test_base
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.framework import combinations
 from tensorflow.python.framework import errors
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import string_ops
 from tensorflow.python.platform import test
 
 
@@ -55,6 +57,20 @@ class PrefetchTest(test_base.DatasetTestBase, parameterized.TestCase):
         dataset, buffer_size, slack_period=slack_period)
     self.assertDatasetProduces(dataset, expected_output=range(100))
 
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         combinations.combine(buffer_size=[-1, 0, 4])))
+  def testPinHostMemory(self, buffer_size):
+    # Without a GPU, `pin_host_memory` has no effect. With one, the numeric
+    # tensors are copied into pinned host memory, and the strings are not.
+    dataset = dataset_ops.Dataset.range(10).map(
+        lambda x: (x, array_ops.fill([3], string_ops.as_string(x))))
+    dataset = dataset_ops.PrefetchDataset(
+        dataset, buffer_size, pin_host_memory=True)
+    self.assertDatasetProduces(
+        dataset,
+        expected_output=[(i, [str(i).encode()] * 3) for i in range(10)])
+
   @combinations.generate(combinations.combine(tf_api_version=1, mode="graph"))
   def testPrefetchCancellation(self):
 
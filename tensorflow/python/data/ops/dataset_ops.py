@@ -5457,8 +5457,23 @@ class FilterDataset(UnaryUnchangedStructureDataset):
 class PrefetchDataset(UnaryUnchangedStructureDataset):
   """A `Dataset` that asynchronously prefetches its input."""
 
-  def __init__(self, input_dataset, buffer_size, slack_period=None, name=None):
-    """See `Dataset.prefetch()` for details."""
+  def __init__(self,
+               input_dataset,
+               buffer_size,
+               slack_period=None,
+               name=None,
+               pin_host_memory=False):
+    """See `Dataset.prefetch()` for details.
+
+    Args:
+      input_dataset: The input dataset.
+      buffer_size: The maximum number of elements to buffer.
+      slack_period: (Optional.) The period between injecting "slack" into the
+        execution.
+      name: (Optional.) A name for the tf.data operation.
+      pin_host_memory: (Optional.) Whether to copy the prefetched tensors into
+        pinned host memory, so that copying them to a GPU is a direct transfer.
+    """
     self._input_dataset = input_dataset
     if buffer_size is None:
       buffer_size = AUTOTUNE
@@ -5470,6 +5485,8 @@ class PrefetchDataset(UnaryUnchangedStructureDataset):
     kwargs = self._flat_structure
     if name or compat.forward_compatible(2021, 9, 30):
       kwargs["metadata"] = self._metadata.SerializeToString()
+    if pin_host_memory:
+      kwargs["pin_host_memory"] = True
     # pylint: disable=protected-access
     # We colocate the prefetch dataset with its input as this collocation only
     # happens automatically in graph mode.
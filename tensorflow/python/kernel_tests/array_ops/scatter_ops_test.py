@@ -18,7 +18,6 @@ import numpy as np
 
 from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
-from tensorflow.python.framework import errors
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import state_ops
 from tensorflow.python.ops import variables
@@ -335,19 +334,30 @@ class ScatterTest(test.TestCase):
         indices = np.array([2, 0, 6])
         self.evaluate(op(ref, indices, updates))
 
-  @test_util.run_v1_only("ResrouceVariable has deterministic scatter "
-                         "implementation")
+  @test_util.run_v1_only("RefVariable is not supported in TF2")
   @test_util.run_cuda_only
-  def testDeterminismExceptionThrowing(self):
-    v = variables.RefVariable(np.array([1., 2., 3.]))
-    indices = np.array([0, 0, 0])
-    updates = np.array([-3, -4, -5]).astype(np.float32)
+  def testDeterministicScatter(self):
+    indices = np.array([0, 0, 0, 2])
+    updates = np.array([-3, -4, -5, 6]).astype(np.float32)
     with test_util.deterministic_ops():
-      with self.assertRaisesRegex(
-          errors.UnimplementedError,
-          "Determinism is not yet supported in GPU implementation of Scatter "
-          "ops"):
-        self.evaluate(state_ops.scatter_update(v, indices, updates))
+      # Duplicate indices are applied in order, as on the CPU.
+      v = variables.RefVariable(np.array([1., 2., 3.], dtype=np.float32))
+      self.evaluate(v.initializer)
+      self.evaluate(state_ops.scatter_update(v, indices, updates))
+      self.assertAllEqual(self.evaluate(v), [-5., 2., 6.])
+      self.evaluate(state_ops.scatter_sub(v, indices, updates))
+      self.assertAllEqual(self.evaluate(v), [7., 2., 0.])
+
+      values = np.random.normal(size=(100000,)).astype(np.float32)
+      results = []
+      for _ in range(3):
+        v = variables.RefVariable(np.zeros([4], dtype=np.float32))
+        self.evaluate(v.initializer)
+        self.evaluate(
+            state_ops.scatter_add(v, np.zeros([100000], np.int32), values))
+        results.append(self.evaluate(v))
+      for result in results[1:]:
+        self.assertAllEqual(result, results[0])
 
 
 
@@ -23,6 +23,16 @@ from tensorflow.python.ops import gen_array_ops
 from tensorflow.python.platform import test
 
 
+def _unique_by_appearance(x):
+  """Returns the unique elements of `x` by first occurrence, like np.unique."""
+  _, first_indices, inverse, counts = np.unique(
+      x, return_index=True, return_inverse=True, return_counts=True)
+  order = np.argsort(first_indices)
+  rank = np.empty_like(order)
+  rank[order] = np.arange(len(order))
+  return x[first_indices[order]], rank[inverse], counts[order]
+
+
 class UniqueTest(test.TestCase):
 
   def testInt32(self):
@@ -167,6 +177,28 @@ class UniqueTest(test.TestCase):
     self.assertAllEqual(tf_idx, true_idx)
 
 
+  def testLargeOrderedByAppearance(self):
+    # Large inputs are uniquified in parallel.
+    for dtype in [np.int32, np.int64]:
+      for x in [
+          np.random.randint(1 << 16, size=1 << 18).astype(dtype),
+          np.sort(np.random.randint(1 << 16, size=1 << 18)).astype(dtype)
+      ]:
+        true_y, true_idx, _ = _unique_by_appearance(x)
+        y, idx = array_ops.unique(x)
+        tf_y, tf_idx = self.evaluate([y, idx])
+        self.assertAllEqual(tf_y, true_y)
+        self.assertAllEqual(tf_idx, true_idx)
+
+  def testLargeString(self):
+    x = np.array([str(i) for i in np.random.randint(1000, size=1 << 17)])
+    true_y, true_idx, _ = _unique_by_appearance(x)
+    y, idx = array_ops.unique(x)
+    tf_y, tf_idx = self.evaluate([y, idx])
+    self.assertAllEqual(tf_y, [s.encode('ascii') for s in true_y])
+    self.assertAllEqual(tf_idx, true_idx)
+
+
 class UniqueWithCountsTest(test.TestCase):
 
   def testInt32(self):
@@ -314,5 +346,35 @@ class UniqueWithCountsTest(test.TestCase):
     self.assertAllEqual(tf_count, true_count)
 
 
+  def testLargeOrderedByAppearance(self):
+    # Large inputs are uniquified in parallel.
+    for x in [
+        np.random.randint(1 << 16, size=1 << 18),
+        np.sort(np.random.randint(1 << 16, size=1 << 18))
+    ]:
+      true_y, true_idx, true_count = _unique_by_appearance(x)
+      y, idx, count = array_ops.unique_with_counts(x)
+      tf_y, tf_idx, tf_count = self.evaluate([y, idx, count])
+      self.assertAllEqual(tf_y, true_y)
+      self.assertAllEqual(tf_idx, true_idx)
+      self.assertAllEqual(tf_count, true_count)
+
+  def testLargeFloatWithNan(self):
+    x = np.random.randint(100, size=1 << 17).astype(np.float32)
+    x[::1000] = np.nan
+    y, idx, count = array_ops.unique_with_counts(x)
+    tf_y, tf_idx, tf_count = self.evaluate([y, idx, count])
+    # Each NaN is a unique element.
+    nan = np.isnan(x)
+    values, counts = np.unique(x[~nan], return_counts=True)
+    self.assertEqual(len(tf_y), len(values) + np.sum(nan))
+    self.assertAllEqual(tf_y[tf_idx][~nan], x[~nan])
+    self.assertTrue(np.all(np.isnan(tf_y[tf_idx][nan])))
+    tf_nan = np.isnan(tf_y)
+    self.assertAllEqual(tf_count[tf_nan], np.ones(np.sum(nan)))
+    self.assertEqual(
+        dict(zip(tf_y[~tf_nan], tf_count[~tf_nan])), dict(zip(values, counts)))
+
+
 if __name__ == '__main__':
   test.main()
@@ -39,8 +39,10 @@ from tensorflow.python.framework import test_ops
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import control_flow_ops
+from tensorflow.python.ops import gen_lookup_ops
 from tensorflow.python.ops import lookup_ops
 from tensorflow.python.ops import map_fn
+from tensorflow.python.ops import random_ops
 from tensorflow.python.ops import variables
 from tensorflow.python.ops.ragged import ragged_tensor
 from tensorflow.python.platform import test
@@ -1824,6 +1826,76 @@ class DenseHashTableOpTest(test.TestCase):
     self.assertAllEqual([[11, 1], [13, 3], [14, 4], [100, 0], [100, 0],
                          [100, 0], [100, 0], [200, 2]], pairs)
 
+  def testReinsertRemovedKeys(self, is_anonymous):
+    if is_anonymous and not tf2.enabled():
+      self.skipTest(SKIP_ANONYMOUS_IN_TF1_REASON)
+    table = lookup_ops.DenseHashTable(
+        dtypes.int64,
+        dtypes.int64,
+        default_value=-1,
+        empty_key=0,
+        deleted_key=-1,
+        initial_num_buckets=2048,
+        experimental_is_anonymous=is_anonymous)
+    keys = constant_op.constant(np.arange(1, 1001), dtypes.int64)
+    self.evaluate(table.insert(keys, keys))
+    self.evaluate(table.remove(keys[::2]))
+    self.assertAllEqual(500, self.evaluate(table.size()))
+
+    # Updating the remaining keys reuses their bucket rather than a deleted
+    # one found earlier by the probe.
+    self.evaluate(table.insert(keys, 2 * keys))
+    self.assertAllEqual(1000, self.evaluate(table.size()))
+    self.assertAllEqual(2048, len(self.evaluate(table.export()[0])))
+    self.assertAllEqual(2 * np.arange(1, 1001),
+                        self.evaluate(table.lookup(keys)))
+
+  def testImportBucketsInAnyOrder(self, is_anonymous):
+    if is_anonymous and not tf2.enabled():
+      self.skipTest(SKIP_ANONYMOUS_IN_TF1_REASON)
+    table = lookup_ops.DenseHashTable(
+        dtypes.int64,
+        dtypes.int64,
+        default_value=-1,
+        empty_key=100,
+        deleted_key=200,
+        initial_num_buckets=8,
+        experimental_is_anonymous=is_anonymous)
+    # Buckets exported by a table which laid its keys out differently.
+    keys = constant_op.constant([[100], [14], [200], [11], [100], [100],
+                                 [13], [100]], dtypes.int64)
+    values = constant_op.constant([[0], [4], [2], [1], [0], [0], [3], [0]],
+                                  dtypes.int64)
+    self.evaluate(
+        gen_lookup_ops.lookup_table_import_v2(table.resource_handle, keys,
+                                              values))
+    self.assertAllEqual(3, self.evaluate(table.size()))
+    self.assertAllEqual(8, len(self.evaluate(table.export()[0])))
+    output = table.lookup(constant_op.constant([11, 12, 13, 14], dtypes.int64))
+    self.assertAllEqual([1, -1, 3, 4], self.evaluate(output))
+
+  def testExportLayoutOfEarlierReleases(self, is_anonymous):
+    if is_anonymous and not tf2.enabled():
+      self.skipTest(SKIP_ANONYMOUS_IN_TF1_REASON)
+    table = lookup_ops.DenseHashTable(
+        dtypes.int64,
+        dtypes.int64,
+        default_value=-1,
+        empty_key=100,
+        deleted_key=200,
+        initial_num_buckets=8,
+        experimental_is_anonymous=is_anonymous)
+    # The keys all hash to bucket 3, and are placed by quadratic probing as
+    # earlier releases expect when they import the exported buckets.
+    keys = constant_op.constant([3, 11, 19, 27], dtypes.int64)
+    values = constant_op.constant([1, 2, 3, 4], dtypes.int64)
+    self.evaluate(table.insert(keys, values))
+    self.evaluate(table.remove(constant_op.constant([11], dtypes.int64)))
+    exported_keys, exported_values = self.evaluate(table.export())
+    self.assertAllEqual([100, 27, 100, 3, 200, 100, 19, 100],
+                        exported_keys.flatten())
+    self.assertAllEqual([0, 4, 0, 1, 2, 0, 3, 0], exported_values.flatten())
+
   @test_util.run_v1_only("Saver V1 only")
   def testSaveRestore(self, is_anonymous):
     if is_anonymous and not tf2.enabled():
@@ -4233,6 +4305,15 @@ class MutableHashTableBenchmark(test.Benchmark):
       self.run_op_benchmark(sess, insert, burn_iters=10, min_iters=1000)
       assert sess.run(size) >= 1000 * 32
 
+  def benchmark_batch_4096_lookup(self):
+    table = self._create_table()
+    insert = table.insert(list(range(1, 1 << 16)), [1.0] * ((1 << 16) - 1))
+    keys = random_ops.random_uniform([4096], 1, 1 << 17, dtype=dtypes.int64)
+    lookup = table.lookup(keys)
+    with session.Session() as sess:
+      sess.run(insert)
+      self.run_op_benchmark(sess, lookup, burn_iters=10, min_iters=1000)
+
 
 class DenseHashTableBenchmark(MutableHashTableBenchmark):
 
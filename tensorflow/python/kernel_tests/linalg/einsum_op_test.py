@@ -105,6 +105,16 @@ class EinsumOpTest(test.TestCase):
     # Based on https://github.com/google/jax/issues/37#issuecomment-448572187
     self._check('sa,shb->shab', (2, 1), (2, 3, 4))
 
+  def testMoreThanTwoOperands(self):
+    # The operands are contracted pairwise, in a planned order.
+    self._check('ab,bc,cd->ad', (20, 2), (2, 20), (20, 3))
+    self._check('ab,bc,cd->ad', (2, 20), (20, 3), (3, 20))
+    self._check('ij,jk,kl,li->', (2, 3), (3, 4), (4, 5), (5, 2))
+    self._check('a,b,ab->ab', (3,), (4,), (3, 4))
+    self._check('ij,j,jk->ijk', (2, 3), (3,), (3, 4))
+    self._check('aab,bc,c->a', (2, 2, 3), (3, 4), (4,))
+    self._check('...ab,...bc,c->...a', (5, 4, 3), (1, 3, 7), (7,))
+
   def testReducedIndices(self):
     self._check('ba,b->', (3, 2), (3,))
     self._check('ab,ab->', (3, 4), (3, 4))
@@ -163,6 +163,28 @@ class TopKTest(test.TestCase):
       values = -np.sort(-inputs, axis=1)[:, :k]
       self._validateTopK(inputs, k, values, indices)
 
+  def testLongRows(self):
+    # Few long rows are split across threads.
+    b = 2
+    n = 1 << 18
+    inputs = np.random.permutation(
+        np.linspace(0, 100, b * n, dtype=np.float32)).reshape(b, n)
+    for k in [1000, n // 4]:
+      indices = np.argsort(-inputs, axis=1)[:, :k]
+      values = -np.sort(-inputs, axis=1)[:, :k]
+      self._validateTopK(inputs, k, values, indices)
+      self._validateTopK(inputs, k, values, indices, sorted=False)
+
+  def testLongRowsStableSort(self):
+    n = 1 << 17
+    k = 512
+    # Lots of repeated integers taking values in [0, 3]
+    inputs = np.random.permutation(
+        np.linspace(0, 3, n, dtype=np.int32)).reshape(1, n)
+    indices = np.argsort(-inputs, axis=1, kind="mergesort")[:, :k]
+    values = -np.sort(-inputs, axis=1)[:, :k]
+    self._validateTopK(inputs, k, values, indices)
+
   def testTopAll(self):
     inputs = [[0.1, 0.3, 0.2, 0.4], [0.1, 0.3, 0.3, 0.2]]
     self._validateTopK(inputs, 4, [[0.4, 0.3, 0.2, 0.1], [0.3, 0.3, 0.2, 0.1]],
@@ -246,6 +268,22 @@ class TopKBenchmark(test.Benchmark):
                 "Throughput: %0.03g GB/s" % (name, r["wall_time"], throughput))
           sys.stdout.flush()
 
+  def benchmarkTopKLongRows(self):
+    n = 1 << 20
+    for (m, k, sorted_) in itertools.product([1, 4], [1000, 100000],
+                                             [False, True]):
+      name = "m_%d_n_%d_k_%d_sorted_%s" % (m, n, k, sorted_)
+      with ops.Graph().as_default():
+        with ops.device("/cpu:0"):
+          x = random_ops.random_uniform((m, n))
+          v = resource_variable_ops.ResourceVariable(x)
+          op = nn_ops.top_k(v, k, sorted=sorted_)
+        with session.Session() as sess:
+          self.evaluate(v.initializer)
+          r = self.run_op_benchmark(sess, op, min_iters=10, name=name)
+          print("Benchmark: %s \t wall_time: %0.03g s" % (name, r["wall_time"]))
+          sys.stdout.flush()
+
 
 if __name__ == "__main__":
   test.main()
@@ -238,6 +238,36 @@ class SparseTensorDenseMatMulTest(test.TestCase):
     self._testLarge(np.complex64)
     self._testLarge(np.complex128)
 
+  # Tests products large enough to be computed on several threads, with
+  # unordered nonzeros concentrated on a few rows.
+  def testLargeUnordered(self):
+    np.random.seed(127)  # Repeatable results
+    m, k, n = 64, 2000, 64
+    rows = np.concatenate([np.zeros(3000), np.random.randint(0, m, 3000)])
+    cols = np.random.permutation(k * 3)[:6000] % k
+    indices = np.stack([rows, cols], axis=1).astype(np.int64)
+    indices = indices[np.random.permutation(len(indices))]
+    values = np.random.randn(len(indices)).astype(np.float32)
+    y = np.random.randn(k, n).astype(np.float32)
+
+    x = np.zeros((m, k), dtype=np.float32)
+    np.add.at(x, (indices[:, 0], indices[:, 1]), values)
+    sparse_t = sparse_tensor.SparseTensor(indices, values, [m, k])
+    for adjoint_b in [False, True]:
+      y_t = y.T if adjoint_b else y
+      self.assertAllClose(
+          x.dot(y),
+          sparse_ops.sparse_tensor_dense_matmul(
+              sparse_t, y_t, adjoint_b=adjoint_b),
+          rtol=1e-4,
+          atol=1e-4)
+    self.assertAllClose(
+        x.T.dot(y[:m]),
+        sparse_ops.sparse_tensor_dense_matmul(
+            sparse_t, y[:m], adjoint_a=True),
+        rtol=1e-4,
+        atol=1e-4)
+
   # Tests random sized matrices.
   def testFloatRandom(self):
     np.random.seed(127)  # Repeatable results
@@ -45,6 +45,19 @@ class StringToHashBucketOpTest(test.TestCase):
       # Fingerprint64('d') -> 4470636696479570465 -> mod 10 -> 5
       self.assertAllEqual([9, 2, 2, 5], result)
 
+  def testStringToHashBucketsFastLargeInput(self):
+    # Large inputs are hashed in parallel, into the same buckets.
+    strings = ['a', 'b', 'c', 'd'] * 25000
+    output = string_ops.string_to_hash_bucket_fast(
+        constant_op.constant(strings), 10)
+    self.assertAllEqual([9, 2, 2, 5] * 25000, self.evaluate(output))
+
+  def testStringToHashBucketsStrongLargeInput(self):
+    strings = ['a', 'b', 'c'] * 25000
+    output = string_ops.string_to_hash_bucket_strong(
+        constant_op.constant(strings), 10, key=[98765, 132])
+    self.assertAllEqual([4, 2, 8] * 25000, self.evaluate(output))
+
   @test_util.run_deprecated_v1
   def testStringToOneHashBucketLegacyHash(self):
     with self.cached_session():
@@ -316,6 +316,12 @@ def _EinsumGrad(op, grad):
     return _GetGradReduced(grad, output_subs, input_subs, input_shape,
                            reduced_label_set)
 
+  if len(op.inputs) > 2:
+    raise NotImplementedError(
+        "Gradients of Einsum are only supported for 1 or 2 operands; use "
+        "tf.einsum, which contracts more operands pairwise. Got equation: "
+        f"{equation}")
+
   x_subs, y_subs = input_subs.split(",")
   # Add ellipsis for broadcasted dimensions if any operand does not have it.
   # This is because the equation "...ij,jk->ik" may be valid if the 0th input's
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -149,7 +150,7 @@ PYBIND11_MODULE(_pywrap_profiler, m) {
               return py::make_tuple(py::bytes(""), py::bool_(false));
             }
 
-            xspaces.push_back(xspace);
+            xspaces.push_back(std::move(xspace));
             filenames.push_back(filename);
           }
           std::string tool_name = std::string(py_tool_name);
@@ -178,7 +179,7 @@ PYBIND11_MODULE(_pywrap_profiler, m) {
               return py::make_tuple(py::bytes(""), py::bool_(false));
             }
 
-            xspaces.push_back(xspace);
+            xspaces.push_back(std::move(xspace));
           }
 
           // Filenames
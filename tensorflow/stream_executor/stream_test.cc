@@ -199,5 +199,58 @@ TEST_F(StreamTest, FailedSubStreamAfterReturnNotReused) {
   EXPECT_EQ(sub_stream2, sub_stream3);
 }
 
+TEST_F(StreamTest, ReusesTemporaryArena) {
+  std::unique_ptr<StreamExecutor> executor = NewStreamExecutor();
+  Stream stream(executor.get());
+  stream.Init();
+  internal::TemporaryMemoryManager* manager = stream.temporary_memory_manager();
+  manager->SetArenaBudget(1 << 20);
+
+  // The first temporary sizes the arena.
+  auto temporary = stream.AllocateTemporaryArray<float>(100).ValueOrDie();
+  EXPECT_EQ(manager->GetArenaStats().num_overflow_allocations, 1);
+  temporary.reset();
+  temporary = stream.AllocateTemporaryArray<float>(100).ValueOrDie();
+  const void* arena = temporary->device_memory().opaque();
+  EXPECT_EQ(temporary->device_memory().size(), 400);
+  EXPECT_EQ(manager->GetArenaStats().capacity_bytes, 512);
+
+  // Once its temporaries are finalized, the arena is reused.
+  temporary.reset();
+  temporary = stream.AllocateTemporaryArray<float>(100).ValueOrDie();
+  EXPECT_EQ(temporary->device_memory().opaque(), arena);
+
+  // Temporaries that don't fit grow it geometrically.
+  auto overflow = stream.AllocateTemporaryArray<float>(10).ValueOrDie();
+  EXPECT_NE(overflow->device_memory().opaque(), arena);
+  temporary.reset();
+  overflow.reset();
+  temporary = stream.AllocateTemporaryArray<float>(100).ValueOrDie();
+  internal::TemporaryArenaStats stats = manager->GetArenaStats();
+  EXPECT_EQ(stats.capacity_bytes, 1024);
+  EXPECT_EQ(stats.peak_bytes, 768);
+  EXPECT_EQ(stats.num_arena_allocations, 3);
+  EXPECT_EQ(stats.num_overflow_allocations, 2);
+  EXPECT_EQ(stats.num_grows, 2);
+  temporary.reset();
+  EXPECT_TRUE(stream.BlockHostUntilDone().ok());
+}
+
+TEST_F(StreamTest, TemporaryArenaRespectsBudget) {
+  std::unique_ptr<StreamExecutor> executor = NewStreamExecutor();
+  Stream stream(executor.get());
+  stream.Init();
+  internal::TemporaryMemoryManager* manager = stream.temporary_memory_manager();
+  manager->SetArenaBudget(1024);
+  for (int i = 0; i < 2; ++i) {
+    auto temporary = stream.AllocateTemporaryArray<uint8>(2048).ValueOrDie();
+    EXPECT_FALSE(temporary->IsFinalized());
+  }
+  internal::TemporaryArenaStats stats = manager->GetArenaStats();
+  EXPECT_EQ(stats.capacity_bytes, 0);
+  EXPECT_EQ(stats.num_overflow_allocations, 2);
+  EXPECT_TRUE(stream.BlockHostUntilDone().ok());
+}
+
 }  // namespace
 }  // namespace stream_executor
@@ -15,22 +15,55 @@ limitations under the License.
 
 #include "tensorflow/stream_executor/temporary_memory_manager.h"
 
+#include <algorithm>
+
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/stream_executor/platform/logging.h"
 #include "tensorflow/stream_executor/stream.h"
 #include "tensorflow/stream_executor/stream_executor_pimpl.h"
 
 namespace stream_executor {
 namespace internal {
+namespace {
+
+// cuDNN and cuBLAS workspaces rarely need more than this.
+constexpr int64_t kDefaultArenaBudgetMB = 16;
+
+uint64_t ArenaBudgetFromEnv() {
+  int64_t megabytes;
+  SE_CHECK_OK(tensorflow::ReadInt64FromEnvVar(
+      "TF_STREAM_SCRATCH_ARENA_MB", kDefaultArenaBudgetMB, &megabytes));
+  return static_cast<uint64_t>(std::max<int64_t>(megabytes, 0)) << 20;
+}
+
+uint64_t RoundUpToArenaAlignment(uint64_t bytes) {
+  const uint64_t alignment = TemporaryMemoryManager::kArenaAlignment;
+  return (bytes + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+TemporaryMemoryManager::TemporaryMemoryManager(Stream* stream)
+    : generation_(0), arena_budget_(ArenaBudgetFromEnv()), stream_(stream) {}
 
 void TemporaryMemoryManager::ForceDeallocateAll() {
   absl::MutexLock lock(&mutex_);
   VLOG(1) << "force-deallocating " << records_.size() << " remaining records";
   for (auto it = records_.begin(); it != records_.end(); ++it) {
+    if (it->second.in_arena) continue;
     DeviceMemoryBase device_memory = it->first;
     stream_->parent()->Deallocate(&device_memory);
   }
+  records_.clear();
+  for (auto& event_and_arena : retired_arenas_) {
+    stream_->parent()->Deallocate(&event_and_arena.second);
+  }
+  retired_arenas_.clear();
+  if (!arena_.is_null()) stream_->parent()->Deallocate(&arena_);
+  arena_ = DeviceMemory<uint8>();
 }
 
 void TemporaryMemoryManager::MarkFinalized(
@@ -45,11 +78,17 @@ void TemporaryMemoryManager::MarkFinalized(
     }
     return;
   }
+  if (it->second.finalized) return;
   it->second.finalized = true;
+  --num_live_;
+  if (num_live_ == 0) live_bytes_ = 0;
+  // Arena temporaries have nothing to deallocate.
+  if (it->second.in_arena) records_.erase(it);
 }
 
 void TemporaryMemoryManager::DeallocateFinalizedTemporaries() {
   absl::MutexLock lock(&mutex_);
+  DeallocateRetiredArenas();
   int deallocated_count = 0;
   for (auto it = records_.begin(); it != records_.end();) {
     if (it->second.finalized) {
@@ -90,28 +129,121 @@ bool TemporaryMemoryManager::HasAllocated(const DeviceMemoryBase& device_memory,
   return it->second.allocation_generation == generation;
 }
 
+void TemporaryMemoryManager::SetArenaBudget(uint64_t bytes) {
+  absl::MutexLock lock(&mutex_);
+  arena_budget_ = bytes;
+}
+
+TemporaryArenaStats TemporaryMemoryManager::GetArenaStats() const {
+  absl::MutexLock lock(&mutex_);
+  TemporaryArenaStats stats = arena_stats_;
+  stats.capacity_bytes = arena_.size();
+  return stats;
+}
+
+void TemporaryMemoryManager::DeallocateRetiredArenas() {
+  for (auto it = retired_arenas_.begin(); it != retired_arenas_.end();) {
+    if (it->first->PollForStatus() == Event::Status::kPending) {
+      ++it;
+      continue;
+    }
+    stream_->parent()->Deallocate(&it->second);
+    it = retired_arenas_.erase(it);
+  }
+}
+
+DeviceMemoryBase TemporaryMemoryManager::AllocateFromArena(
+    uint64_t byte_size, DeviceMemory<uint8>* retired) {
+  if (num_live_ == 0) {
+    arena_offset_ = 0;
+    // Grow the arena if the temporaries didn't fit in it.
+    const uint64_t capacity = arena_.size();
+    if (peak_live_bytes_ > capacity && capacity < arena_budget_) {
+      const uint64_t new_capacity =
+          std::min(arena_budget_, std::max(peak_live_bytes_, 2 * capacity));
+      DeviceMemory<uint8> arena =
+          stream_->parent()->AllocateArray<uint8>(new_capacity);
+      if (!arena.is_null()) {
+        *retired = arena_;
+        arena_ = arena;
+        peak_live_bytes_ = 0;
+        ++arena_stats_.num_grows;
+        VLOG(1) << absl::StreamFormat(
+            "stream %p grew its temporary arena to %u bytes", stream_,
+            new_capacity);
+      }
+    }
+  }
+  if (arena_.is_null() || arena_offset_ + byte_size > arena_.size()) {
+    return DeviceMemoryBase();
+  }
+  DeviceMemoryBase device_memory =
+      stream_->parent()->GetSubBuffer(&arena_, arena_offset_, byte_size);
+  if (!device_memory.is_null()) arena_offset_ += byte_size;
+  return device_memory;
+}
+
+uint64_t TemporaryMemoryManager::AddRecord(
+    const DeviceMemoryBase& device_memory, uint64_t arena_bytes,
+    bool in_arena) {
+  const uint64_t generation = ++generation_;
+  DCHECK(records_.find(device_memory) == records_.end());
+  records_[device_memory] = {generation,
+                             /*finalized=*/false, in_arena};
+  ++num_live_;
+  live_bytes_ += arena_bytes;
+  peak_live_bytes_ = std::max(peak_live_bytes_, live_bytes_);
+  arena_stats_.peak_bytes = std::max(arena_stats_.peak_bytes, live_bytes_);
+  ++(in_arena ? arena_stats_.num_arena_allocations
+              : arena_stats_.num_overflow_allocations);
+  return generation;
+}
+
 port::StatusOr<std::unique_ptr<TemporaryDeviceMemoryBase>>
 TemporaryMemoryManager::AllocateArrayBase(uint64_t element_count,
                                           uint64_t element_size) {
   uint64_t byte_size = element_count * element_size;
-  DeviceMemoryBase device_memory =
-      stream_->parent()->AllocateArray<uint8>(byte_size);
-  if (device_memory == nullptr) {
-    return port::Status(port::error::RESOURCE_EXHAUSTED,
-                        absl::StrCat("could not allocate temporary memory of ",
-                                     byte_size, " bytes"));
-  }
-
-  uint64_t generation;
+  uint64_t arena_bytes = RoundUpToArenaAlignment(byte_size);
+  DeviceMemoryBase device_memory;
+  DeviceMemory<uint8> retired;
+  uint64_t generation = 0;
 
   // Add the record before instantiating the device memory instance so we can
   // check the allocation invariant at TemporaryDeviceMemory construction time.
+  // Arena temporaries are recorded with the lock that carved them, so that
+  // the arena isn't reused under them.
   {
     absl::MutexLock lock(&mutex_);
-    generation = ++generation_;
-    DCHECK(records_.find(device_memory) == records_.end());
-    records_[device_memory] = {generation,
-                               /*finalized=*/false};
+    DeallocateRetiredArenas();
+    if (byte_size == 0 || arena_bytes > arena_budget_) {
+      arena_bytes = 0;
+    } else {
+      device_memory = AllocateFromArena(arena_bytes, &retired);
+    }
+    if (!device_memory.is_null()) {
+      // Keep the size that was asked for, as callers may check it.
+      device_memory = DeviceMemoryBase(device_memory.opaque(), byte_size);
+      generation = AddRecord(device_memory, arena_bytes, /*in_arena=*/true);
+    }
+  }
+  if (!retired.is_null()) {
+    // The work on the stream may still use the outgrown arena.
+    auto event = absl::make_unique<Event>(stream_->parent());
+    if (event->Init()) stream_->ThenRecordEvent(event.get());
+    absl::MutexLock lock(&mutex_);
+    retired_arenas_.emplace_back(std::move(event), retired);
+  }
+
+  if (generation == 0) {
+    device_memory = stream_->parent()->AllocateArray<uint8>(byte_size);
+    if (device_memory == nullptr) {
+      return port::Status(
+          port::error::RESOURCE_EXHAUSTED,
+          absl::StrCat("could not allocate temporary memory of ", byte_size,
+                       " bytes"));
+    }
+    absl::MutexLock lock(&mutex_);
+    generation = AddRecord(device_memory, arena_bytes, /*in_arena=*/false);
   }
 
   VLOG(1) << absl::StreamFormat(
@@ -17,16 +17,22 @@ limitations under the License.
 // temporary allocations. These allocations defer their deallocation to the next
 // Stream::BlockHostUntilDone call for efficiency purposes (as deallocation
 // itself generally forces synchronization to occur).
+//
+// Most temporaries are carved from a per-stream scratch arena instead, which
+// needs neither allocation nor deallocation once it is large enough.
 
 #ifndef TENSORFLOW_STREAM_EXECUTOR_TEMPORARY_MEMORY_MANAGER_H_
 #define TENSORFLOW_STREAM_EXECUTOR_TEMPORARY_MEMORY_MANAGER_H_
 
 #include <map>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "absl/synchronization/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/stream_executor/device_memory.h"
+#include "tensorflow/stream_executor/event.h"
 #include "tensorflow/stream_executor/lib/status.h"
 #include "tensorflow/stream_executor/lib/statusor.h"
 #include "tensorflow/stream_executor/temporary_device_memory.h"
@@ -47,15 +53,44 @@ struct TemporaryMemoryRecord {
   // we can release the DeviceMemory associated with this record at
   // synchronization time.
   bool finalized;
+
+  // Notes whether the temporary memory was carved from the scratch arena, in
+  // which case there is nothing to release.
+  bool in_arena;
+};
+
+// Statistics of the scratch arena of a TemporaryMemoryManager.
+struct TemporaryArenaStats {
+  // Size of the current arena.
+  uint64_t capacity_bytes = 0;
+  // The most bytes of temporaries that were live at once.
+  uint64_t peak_bytes = 0;
+  // Temporaries carved from the arena, and those that didn't fit in it.
+  int64_t num_arena_allocations = 0;
+  int64_t num_overflow_allocations = 0;
+  // Number of times the arena was replaced by a larger one.
+  int64_t num_grows = 0;
 };
 
 // Manages temporary memories associated with a stream -- keeps records of
 // outstanding temporaries and their state, and can deallocate them
 // appropriately at points in the Stream lifecycle (e.g. BlockHostUntilDone,
 // destruction).
+//
+// Temporaries are carved from the arena in allocation order. As their users
+// are enqueued on the stream before they are finalized, the work that reuses
+// the arena runs after them, so the arena is reused from its start as soon as
+// all of the temporaries are finalized. When temporaries didn't fit, the
+// arena then grows geometrically up to a budget, and the outgrown arena is
+// deallocated once the stream has passed an event recorded after its last
+// use.
 class TemporaryMemoryManager {
  public:
-  explicit TemporaryMemoryManager(Stream* stream) : stream_(stream) {}
+  // The alignment of the temporaries carved from the arena.
+  static constexpr uint64_t kArenaAlignment = 256;
+
+  // The budget of the arena is read from TF_STREAM_SCRATCH_ARENA_MB.
+  explicit TemporaryMemoryManager(Stream* stream);
 
   // Allocates a temporary array that is then managed by this object.
   template <typename T>
@@ -99,6 +134,11 @@ class TemporaryMemoryManager {
   bool HasAllocated(const DeviceMemoryBase& device_memory,
                     uint64_t generation) const;
 
+  // Sets the most bytes the scratch arena may grow to. Zero disables it.
+  void SetArenaBudget(uint64_t bytes);
+
+  TemporaryArenaStats GetArenaStats() const;
+
  private:
   // Allocates an array without type parameterization, so that the
   // implementation can live in the source file. Without this base allocation
@@ -107,6 +147,21 @@ class TemporaryMemoryManager {
   port::StatusOr<std::unique_ptr<TemporaryDeviceMemoryBase>> AllocateArrayBase(
       uint64_t element_count, uint64 element_size);
 
+  // Carves `byte_size` bytes from the arena, or returns null memory if they
+  // don't fit. Returns an outgrown arena to retire in `retired`.
+  DeviceMemoryBase AllocateFromArena(uint64_t byte_size,
+                                     DeviceMemory<uint8>* retired)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Records a live temporary, which takes `arena_bytes` of the arena, and
+  // returns its generation.
+  uint64_t AddRecord(const DeviceMemoryBase& device_memory,
+                     uint64_t arena_bytes, bool in_arena)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Deallocates the outgrown arenas that the stream no longer uses.
+  void DeallocateRetiredArenas() TF_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   // Mutex to guard temporary record state.
   mutable absl::Mutex mutex_;
 
@@ -122,6 +177,26 @@ class TemporaryMemoryManager {
   // device memory address.
   uint64_t generation_ TF_GUARDED_BY(mutex_);
 
+  // The scratch arena, and the offset of its first free byte.
+  DeviceMemory<uint8> arena_ TF_GUARDED_BY(mutex_);
+  uint64_t arena_offset_ TF_GUARDED_BY(mutex_) = 0;
+  uint64_t arena_budget_ TF_GUARDED_BY(mutex_);
+
+  // Number of temporaries that are not finalized, and the bytes they would
+  // take in an arena that had room for all of them.
+  int64_t num_live_ TF_GUARDED_BY(mutex_) = 0;
+  uint64_t live_bytes_ TF_GUARDED_BY(mutex_) = 0;
+
+  // The most bytes that were live at once since the arena last grew.
+  uint64_t peak_live_bytes_ TF_GUARDED_BY(mutex_) = 0;
+
+  // Outgrown arenas, with the events that the stream passes after their last
+  // use.
+  std::vector<std::pair<std::unique_ptr<Event>, DeviceMemory<uint8>>>
+      retired_arenas_ TF_GUARDED_BY(mutex_);
+
+  TemporaryArenaStats arena_stats_ TF_GUARDED_BY(mutex_);
+
   // The stream (parent object) for this temporary memory manager -- allocations
   // are performed through this stream handle.
   Stream* stream_;